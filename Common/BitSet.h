@@ -28,13 +28,25 @@ inline int LeastSignificantSetBit(u32 val)
 	_BitScanForward(&index, val);
 	return (int)index;
 }
-#if PPSSPP_ARCH(AMD64)
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(ARM64)
 inline int LeastSignificantSetBit(u64 val)
 {
 	unsigned long index;
 	_BitScanForward64(&index, val);
 	return (int)index;
 }
+#else
+// No 64-bit scan on 32-bit targets, and without this overload u64 would silently convert to u32.
+inline int LeastSignificantSetBit(u64 val)
+{
+	unsigned long index;
+	if ((u32)val != 0) {
+		_BitScanForward(&index, (u32)val);
+		return (int)index;
+	}
+	_BitScanForward(&index, (u32)(val >> 32));
+	return (int)index + 32;
+}
 #endif
 #else
 inline int CountSetBits(u32 val) { return __builtin_popcount(val); }
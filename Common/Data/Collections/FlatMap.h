@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Sorted-vector map with the subset of the std::map interface we use.  Much more compact
+// and faster to search than std::map, but inserting or erasing in the middle is O(n), so
+// it's best for data that's mostly built in bulk and then queried a lot.
+// Unlike std::map, iterators are invalidated by any insert or erase.
+template <class K, class V>
+class FlatMap {
+public:
+	typedef std::pair<K, V> value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+	typedef typename std::vector<value_type>::reverse_iterator reverse_iterator;
+
+	iterator begin() { return items_.begin(); }
+	iterator end() { return items_.end(); }
+	const_iterator begin() const { return items_.begin(); }
+	const_iterator end() const { return items_.end(); }
+	reverse_iterator rbegin() { return items_.rbegin(); }
+	reverse_iterator rend() { return items_.rend(); }
+
+	size_t size() const { return items_.size(); }
+	bool empty() const { return items_.empty(); }
+	void clear() { items_.clear(); }
+	void reserve(size_t n) { items_.reserve(n); }
+
+	iterator lower_bound(const K &key) {
+		return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type &item, const K &k) {
+			return item.first < k;
+		});
+	}
+	iterator upper_bound(const K &key) {
+		return std::upper_bound(items_.begin(), items_.end(), key, [](const K &k, const value_type &item) {
+			return k < item.first;
+		});
+	}
+	iterator find(const K &key) {
+		iterator it = lower_bound(key);
+		if (it != items_.end() && !(key < it->first))
+			return it;
+		return items_.end();
+	}
+
+	// Like std::map, does not replace an existing value.
+	std::pair<iterator, bool> insert(const value_type &item) {
+		// Appending in order is the common case, make it cheap.
+		if (items_.empty() || items_.back().first < item.first) {
+			items_.push_back(item);
+			return std::make_pair(items_.end() - 1, true);
+		}
+		iterator it = lower_bound(item.first);
+		if (it != items_.end() && !(item.first < it->first))
+			return std::make_pair(it, false);
+		return std::make_pair(items_.insert(it, item), true);
+	}
+
+	iterator erase(iterator it) {
+		return items_.erase(it);
+	}
+
+	// Bulk building: append in any order, then call FinishBulk() before any lookups.
+	// As with insert(), the first value added for a key wins.
+	void AddBulk(const value_type &item) {
+		items_.push_back(item);
+	}
+	void FinishBulk() {
+		std::stable_sort(items_.begin(), items_.end(), [](const value_type &a, const value_type &b) {
+			return a.first < b.first;
+		});
+		items_.erase(std::unique(items_.begin(), items_.end(), [](const value_type &a, const value_type &b) {
+			return !(a.first < b.first) && !(b.first < a.first);
+		}), items_.end());
+	}
+
+private:
+	std::vector<value_type> items_;
+};
@@ -4,6 +4,23 @@
 #include <cstring>
 #include <vector>
 
+#include "ppsspp_config.h"
+#include "Common/Common.h"
+
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #include "ext/xxhash.h"
 #include "Common/CommonFuncs.h"
 #include "Common/Log.h"
@@ -19,99 +36,250 @@ inline bool KeyEquals(const K &a, const K &b) {
 	return !memcmp(&a, &b, sizeof(K));
 }
 
-enum class BucketState : uint8_t {
-	FREE,
-	TAKEN,
-	REMOVED,  // for linear probing to work (and removal during deletion) we need tombstones
+// The maps below are "Swiss table" style: besides the slots, there's one control byte per slot
+// holding either EMPTY, DELETED (a tombstone, so probing can continue past removed items) or
+// the top 7 bits of the hash. A lookup checks a whole group of 16 control bytes with a couple
+// of SIMD instructions, and only compares keys for the few slots whose 7 bits match.
+// That makes misses and long probe chains cheap, so we can run them much fuller than plain
+// linear probing allows.
+namespace HashmapDetail {
+
+enum : uint8_t {
+	CTRL_EMPTY = 0x80,
+	CTRL_DELETED = 0xFE,
+	// Anything 0x00-0x7F is a full slot.
+};
+
+enum : uint32_t {
+	GROUP_SIZE = 16,
+};
+
+// Top bits, since the low bits pick the position.
+inline uint8_t HashTag(uint32_t hash) {
+	return (uint8_t)(hash >> 25);
+}
+
+inline uint32_t CountTrailingZeros64(uint64_t v) {
+#ifdef _MSC_VER
+	unsigned long index;
+	if ((uint32_t)v != 0) {
+		_BitScanForward(&index, (uint32_t)v);
+		return index;
+	}
+	_BitScanForward(&index, (uint32_t)(v >> 32));
+	return index + 32;
+#else
+	return __builtin_ctzll(v);
+#endif
+}
+
+// Set of matching slots within a group, iterate with Lowest() / ClearLowest().
+class GroupMask {
+public:
+#if PPSSPP_ARCH(ARM_NEON) && !defined(_M_SSE)
+	// One bit per nibble, see CtrlGroup::ToMask().
+	static const int SHIFT = 2;
+#else
+	static const int SHIFT = 0;
+#endif
+
+	explicit GroupMask(uint64_t bits) : bits_(bits) {}
+	explicit operator bool() const {
+		return bits_ != 0;
+	}
+	uint32_t Lowest() const {
+		return CountTrailingZeros64(bits_) >> SHIFT;
+	}
+	void ClearLowest() {
+		bits_ &= bits_ - 1;
+	}
+
+private:
+	uint64_t bits_;
+};
+
+class CtrlGroup {
+public:
+#if defined(_M_SSE)
+	explicit CtrlGroup(const uint8_t *ctrl) : ctrl_(_mm_loadu_si128((const __m128i *)ctrl)) {}
+
+	GroupMask Match(uint8_t tag) const {
+		return GroupMask((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8((char)tag))));
+	}
+	// EMPTY and DELETED are the only values with the top bit set.
+	GroupMask MatchEmptyOrDeleted() const {
+		return GroupMask((uint32_t)_mm_movemask_epi8(ctrl_));
+	}
+
+private:
+	__m128i ctrl_;
+#elif PPSSPP_ARCH(ARM_NEON)
+	explicit CtrlGroup(const uint8_t *ctrl) : ctrl_(vld1q_u8(ctrl)) {}
+
+	GroupMask Match(uint8_t tag) const {
+		return ToMask(vceqq_u8(ctrl_, vdupq_n_u8(tag)));
+	}
+	GroupMask MatchEmptyOrDeleted() const {
+		return ToMask(vcltq_s8(vreinterpretq_s8_u8(ctrl_), vdupq_n_s8(0)));
+	}
+
+private:
+	// NEON has no movemask, but narrowing with a shift packs each byte of the compare result
+	// into a nibble of a 64-bit value.  Keep one bit per nibble.
+	static GroupMask ToMask(uint8x16_t cmp) {
+		uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+		return GroupMask(vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL);
+	}
+
+	uint8x16_t ctrl_;
+#else
+	explicit CtrlGroup(const uint8_t *ctrl) {
+		memcpy(ctrl_, ctrl, GROUP_SIZE);
+	}
+
+	GroupMask Match(uint8_t tag) const {
+		uint32_t bits = 0;
+		for (uint32_t i = 0; i < GROUP_SIZE; i++) {
+			if (ctrl_[i] == tag)
+				bits |= 1 << i;
+		}
+		return GroupMask(bits);
+	}
+	GroupMask MatchEmptyOrDeleted() const {
+		uint32_t bits = 0;
+		for (uint32_t i = 0; i < GROUP_SIZE; i++) {
+			if (ctrl_[i] & 0x80)
+				bits |= 1 << i;
+		}
+		return GroupMask(bits);
+	}
+
+private:
+	uint8_t ctrl_[GROUP_SIZE];
+#endif
+
+public:
+	GroupMask MatchEmpty() const {
+		return Match(CTRL_EMPTY);
+	}
 };
 
-// Uses linear probing for cache-friendliness. Not segregating values from keys because
-// we always use very small values, so it's probably better to have them in the same
-// cache-line as the corresponding key.
+// The control bytes and probing, shared by both maps.  The first GROUP_SIZE control bytes are
+// mirrored after the end, so a group can be loaded at any position without wrapping.
+// Probing jumps by 1, 2, 3... groups, which visits every group when the capacity is a power of 2.
+class CtrlBytes {
+public:
+	void Reset(uint32_t capacity) {
+		capacity_ = capacity;
+		ctrl_.assign(capacity + GROUP_SIZE, CTRL_EMPTY);
+	}
+	void Clear() {
+		memset(ctrl_.data(), CTRL_EMPTY, ctrl_.size());
+	}
+
+	bool IsFull(uint32_t p) const {
+		return (ctrl_[p] & 0x80) == 0;
+	}
+	bool IsDeleted(uint32_t p) const {
+		return ctrl_[p] == CTRL_DELETED;
+	}
+	void Set(uint32_t p, uint8_t value) {
+		ctrl_[p] = value;
+		if (p < GROUP_SIZE)
+			ctrl_[capacity_ + p] = value;
+	}
+
+	// Calls matches(slot) for every slot with the hash's tag, until it returns true.
+	// Returns that slot, or -1 if the key isn't present.
+	template <class F>
+	int Find(uint32_t hash, F matches) const {
+		const uint32_t mask = capacity_ - 1;
+		const uint8_t tag = HashTag(hash);
+		uint32_t pos = hash & mask;
+		for (uint32_t step = GROUP_SIZE; step <= capacity_ + GROUP_SIZE; step += GROUP_SIZE) {
+			CtrlGroup group(&ctrl_[pos]);
+			for (GroupMask m = group.Match(tag); m; m.ClearLowest()) {
+				uint32_t p = (pos + m.Lowest()) & mask;
+				if (matches(p))
+					return (int)p;
+			}
+			// An empty slot means the key would've been placed here or earlier.
+			if (group.MatchEmpty())
+				return -1;
+			pos = (pos + step) & mask;
+		}
+		_assert_msg_(false, "Hashmap: Hit full on Find()");
+		return -1;
+	}
+
+	// First EMPTY or DELETED slot in the probe sequence for hash.
+	uint32_t FindInsertSlot(uint32_t hash) const {
+		const uint32_t mask = capacity_ - 1;
+		uint32_t pos = hash & mask;
+		for (uint32_t step = GROUP_SIZE; step <= capacity_ + GROUP_SIZE; step += GROUP_SIZE) {
+			GroupMask m = CtrlGroup(&ctrl_[pos]).MatchEmptyOrDeleted();
+			if (m)
+				return (pos + m.Lowest()) & mask;
+			pos = (pos + step) & mask;
+		}
+		_assert_msg_(false, "Hashmap: Hit full on Insert()");
+		return 0;
+	}
+
+private:
+	std::vector<uint8_t> ctrl_;
+	uint32_t capacity_ = 0;
+};
+
+// Capacities must be powers of 2, and at least a group.
+inline int AdjustCapacity(int capacity) {
+	return capacity < (int)GROUP_SIZE ? (int)GROUP_SIZE : capacity;
+}
+
+}  // namespace HashmapDetail
+
+// Not segregating values from keys because we always use very small values, so it's probably
+// better to have them in the same cache-line as the corresponding key.
 // Enforces that value are pointers to make sure that combined storage makes sense.
 template <class Key, class Value, Value NullValue>
 class DenseHashMap {
 public:
-	DenseHashMap(int initialCapacity) : capacity_(initialCapacity) {
-		map.resize(initialCapacity);
-		state.resize(initialCapacity);
+	DenseHashMap(int initialCapacity) : capacity_(HashmapDetail::AdjustCapacity(initialCapacity)) {
+		map.resize(capacity_);
+		ctrl_.Reset(capacity_);
 	}
 
 	// Returns nullptr if no entry was found.
 	Value Get(const Key &key) {
-		uint32_t mask = capacity_ - 1;
-		uint32_t pos = HashKey(key) & mask;
-		// No? Let's go into search mode. Linear probing.
-		uint32_t p = pos;
-		while (true) {
-			if (state[p] == BucketState::TAKEN && KeyEquals(key, map[p].key))
-				return map[p].value;
-			else if (state[p] == BucketState::FREE)
-				return NullValue;
-			p = (p + 1) & mask;  // If the state is REMOVED, we just keep on walking. 
-			if (p == pos) {
-				_assert_msg_(false, "DenseHashMap: Hit full on Get()");
-			}
-		}
-		return NullValue;
+		int p = Find(key, HashKey(key));
+		return p >= 0 ? map[p].value : NullValue;
 	}
 
 	// Returns false if we already had the key! Which is a bit different.
 	bool Insert(const Key &key, Value value) {
-		// Check load factor, resize if necessary. We never shrink.
-		if (count_ > capacity_ / 2) {
-			Grow(2);
-		}
-		uint32_t mask = capacity_ - 1;
-		uint32_t pos = HashKey(key) & mask;
-		uint32_t p = pos;
-		while (true) {
-			if (state[p] == BucketState::TAKEN) {
-				if (KeyEquals(key, map[p].key)) {
-					// Bad! We already got this one. Let's avoid this case.
-					_assert_msg_(false, "DenseHashMap: Duplicate key inserted");
-					return false;
-				}
-				// continue looking....
-			} else {
-				// Got a place, either removed or FREE.
-				break;
-			}
-			p = (p + 1) & mask;
-			if (p == pos) {
-				// FULL! Error. Should not happen thanks to Grow().
-				_assert_msg_(false, "DenseHashMap: Hit full on Insert()");
-			}
+		uint32_t hash = HashKey(key);
+		if (Find(key, hash) >= 0) {
+			// Bad! We already got this one. Let's avoid this case.
+			_assert_msg_(false, "DenseHashMap: Duplicate key inserted");
+			return false;
 		}
-		if (state[p] == BucketState::REMOVED) {
-			removedCount_--;
+		// Check load factor (tombstones count, they make probes longer), resize if necessary. We never shrink.
+		if (count_ + removedCount_ >= capacity_ - capacity_ / 8) {
+			Grow(count_ >= capacity_ / 2 ? 2 : 1);
 		}
-		state[p] = BucketState::TAKEN;
-		map[p].key = key;
-		map[p].value = value;
-		count_++;
+		InsertNew(hash, key, value);
 		return true;
 	}
 
 	bool Remove(const Key &key) {
-		uint32_t mask = capacity_ - 1;
-		uint32_t pos = HashKey(key) & mask;
-		uint32_t p = pos;
-		while (state[p] != BucketState::FREE) {
-			if (state[p] == BucketState::TAKEN && KeyEquals(key, map[p].key)) {
-				// Got it! Mark it as removed.
-				state[p] = BucketState::REMOVED;
-				removedCount_++;
-				count_--;
-				return true;
-			}
-			p = (p + 1) & mask;
-			if (p == pos) {
-				// FULL! Error. Should not happen.
-				_assert_msg_(false, "DenseHashMap: Hit full on Remove()");
-			}
-		}
-		return false;
+		int p = Find(key, HashKey(key));
+		if (p < 0)
+			return false;
+		// Got it! Mark it as removed.
+		ctrl_.Set(p, HashmapDetail::CTRL_DELETED);
+		removedCount_++;
+		count_--;
+		return true;
 	}
 
 	size_t size() const {
@@ -121,14 +289,14 @@ class DenseHashMap {
 	template<class T>
 	inline void Iterate(T func) const {
 		for (size_t i = 0; i < map.size(); i++) {
-			if (state[i] == BucketState::TAKEN) {
+			if (ctrl_.IsFull((uint32_t)i)) {
 				func(map[i].key, map[i].value);
 			}
 		}
 	}
 
 	void Clear() {
-		memset(state.data(), (int)BucketState::FREE, state.size());
+		ctrl_.Clear();
 		count_ = 0;
 		removedCount_ = 0;
 	}
@@ -145,24 +313,40 @@ class DenseHashMap {
 	}
 
 private:
+	int Find(const Key &key, uint32_t hash) const {
+		return ctrl_.Find(hash, [&](uint32_t p) {
+			return KeyEquals(key, map[p].key);
+		});
+	}
+
+	void InsertNew(uint32_t hash, const Key &key, Value value) {
+		uint32_t p = ctrl_.FindInsertSlot(hash);
+		if (ctrl_.IsDeleted(p)) {
+			removedCount_--;
+		}
+		ctrl_.Set(p, HashmapDetail::HashTag(hash));
+		map[p].key = key;
+		map[p].value = value;
+		count_++;
+	}
+
 	void Grow(int factor) {
 		// We simply move out the existing data, then we re-insert the old.
 		// This is extremely non-atomic and will need synchronization.
 		std::vector<Pair> old = std::move(map);
-		std::vector<BucketState> oldState = std::move(state);
+		HashmapDetail::CtrlBytes oldCtrl = std::move(ctrl_);
 		// Can't assume move will clear, it just may clear.
 		map.clear();
-		state.clear();
 
 		int oldCount = count_;
 		capacity_ *= factor;
 		map.resize(capacity_);
-		state.resize(capacity_);
-		count_ = 0;  // Insert will update it.
+		ctrl_.Reset(capacity_);
+		count_ = 0;  // InsertNew will update it.
 		removedCount_ = 0;
 		for (size_t i = 0; i < old.size(); i++) {
-			if (oldState[i] == BucketState::TAKEN) {
-				Insert(old[i].key, old[i].value);
+			if (oldCtrl.IsFull((uint32_t)i)) {
+				InsertNew(HashKey(old[i].key), old[i].key, old[i].value);
 			}
 		}
 		_assert_msg_(oldCount == count_, "DenseHashMap: count should not change in Grow()");
@@ -172,92 +356,48 @@ class DenseHashMap {
 		Value value;
 	};
 	std::vector<Pair> map;
-	std::vector<BucketState> state;
+	HashmapDetail::CtrlBytes ctrl_;
 	int capacity_;
 	int count_ = 0;
 	int removedCount_ = 0;
 };
 
-// Like the above, uses linear probing for cache-friendliness.
-// Does not perform hashing at all so expects well-distributed keys.
+// Like the above, but does not perform hashing at all so expects well-distributed keys.
 template <class Value, Value NullValue>
 class PrehashMap {
 public:
-	PrehashMap(int initialCapacity) : capacity_(initialCapacity) {
-		map.resize(initialCapacity);
-		state.resize(initialCapacity);
+	PrehashMap(int initialCapacity) : capacity_(HashmapDetail::AdjustCapacity(initialCapacity)) {
+		map.resize(capacity_);
+		ctrl_.Reset(capacity_);
 	}
 
 	// Returns nullptr if no entry was found.
 	Value Get(uint32_t hash) {
-		uint32_t mask = capacity_ - 1;
-		uint32_t pos = hash & mask;
-		// No? Let's go into search mode. Linear probing.
-		uint32_t p = pos;
-		while (true) {
-			if (state[p] == BucketState::TAKEN && hash == map[p].hash)
-				return map[p].value;
-			else if (state[p] == BucketState::FREE)
-				return NullValue;
-			p = (p + 1) & mask;  // If the state is REMOVED, we just keep on walking. 
-			if (p == pos) {
-				_assert_msg_(false, "PrehashMap: Hit full on Get()");
-			}
-		}
-		return NullValue;
+		int p = Find(hash);
+		return p >= 0 ? map[p].value : NullValue;
 	}
 
 	// Returns false if we already had the key! Which is a bit different.
 	bool Insert(uint32_t hash, Value value) {
-		// Check load factor, resize if necessary. We never shrink.
-		if (count_ > capacity_ / 2) {
-			Grow(2);
+		if (Find(hash) >= 0)
+			return false;  // Bad!
+		// Check load factor (tombstones count, they make probes longer), resize if necessary. We never shrink.
+		if (count_ + removedCount_ >= capacity_ - capacity_ / 8) {
+			Grow(count_ >= capacity_ / 2 ? 2 : 1);
 		}
-		uint32_t mask = capacity_ - 1;
-		uint32_t pos = hash & mask;
-		uint32_t p = pos;
-		while (state[p] != BucketState::FREE) {
-			if (state[p] == BucketState::TAKEN) {
-				if (hash == map[p].hash)
-					return false;  // Bad!
-			} else {
-				// Got a place, either removed or FREE.
-				break;
-			}
-			p = (p + 1) & mask;
-			if (p == pos) {
-				// FULL! Error. Should not happen thanks to Grow().
-				_assert_msg_(false, "PrehashMap: Hit full on Insert()");
-			}
-		}
-		if (state[p] == BucketState::REMOVED) {
-			removedCount_--;
-		}
-		state[p] = BucketState::TAKEN;
-		map[p].hash = hash;
-		map[p].value = value;
-		count_++;
+		InsertNew(hash, value);
 		return true;
 	}
 
 	bool Remove(uint32_t hash) {
-		uint32_t mask = capacity_ - 1;
-		uint32_t pos = hash & mask;
-		uint32_t p = pos;
-		while (state[p] != BucketState::FREE) {
-			if (state[p] == BucketState::TAKEN && hash == map[p].hash) {
-				// Got it!
-				state[p] = BucketState::REMOVED;
-				removedCount_++;
-				count_--;
-				return true;
-			}
-			p = (p + 1) & mask;
-			if (p == pos) {
-				_assert_msg_(false, "PrehashMap: Hit full on Remove()");
-			}
-		}
-		return false;
+		int p = Find(hash);
+		if (p < 0)
+			return false;
+		// Got it!
+		ctrl_.Set(p, HashmapDetail::CTRL_DELETED);
+		removedCount_++;
+		count_--;
+		return true;
 	}
 
 	size_t size() {
@@ -267,14 +407,14 @@ class PrehashMap {
 	template<class T>
 	void Iterate(T func) const {
 		for (size_t i = 0; i < map.size(); i++) {
-			if (state[i] == BucketState::TAKEN) {
+			if (ctrl_.IsFull((uint32_t)i)) {
 				func(map[i].hash, map[i].value);
 			}
 		}
 	}
 
 	void Clear() {
-		memset(state.data(), (int)BucketState::FREE, state.size());
+		ctrl_.Clear();
 		count_ = 0;
 		removedCount_ = 0;
 	}
@@ -292,28 +432,45 @@ class PrehashMap {
 	}
 
 private:
+	int Find(uint32_t hash) const {
+		return ctrl_.Find(hash, [&](uint32_t p) {
+			return map[p].hash == hash;
+		});
+	}
+
+	void InsertNew(uint32_t hash, Value value) {
+		uint32_t p = ctrl_.FindInsertSlot(hash);
+		if (ctrl_.IsDeleted(p)) {
+			removedCount_--;
+		}
+		ctrl_.Set(p, HashmapDetail::HashTag(hash));
+		map[p].hash = hash;
+		map[p].value = value;
+		count_++;
+	}
+
 	void Grow(int factor) {
 		// We simply move out the existing data, then we re-insert the old.
 		// This is extremely non-atomic and will need synchronization.
 		std::vector<Pair> old = std::move(map);
-		std::vector<BucketState> oldState = std::move(state);
+		HashmapDetail::CtrlBytes oldCtrl = std::move(ctrl_);
 		// Can't assume move will clear, it just may clear.
 		map.clear();
-		state.clear();
 
 		int oldCount = count_;
 		int oldCapacity = capacity_;
 		capacity_ *= factor;
 		map.resize(capacity_);
-		state.resize(capacity_);
-		count_ = 0;  // Insert will update it.
+		ctrl_.Reset(capacity_);
+		count_ = 0;  // InsertNew will update it.
 		removedCount_ = 0;
 		for (size_t i = 0; i < old.size(); i++) {
-			if (oldState[i] == BucketState::TAKEN) {
-				Insert(old[i].hash, old[i].value);
+			if (oldCtrl.IsFull((uint32_t)i)) {
+				InsertNew(old[i].hash, old[i].value);
 			}
 		}
-		INFO_LOG(G3D, "Grew hashmap capacity from %d to %d", oldCapacity, capacity_);
+		if (oldCapacity != capacity_)
+			INFO_LOG(G3D, "Grew hashmap capacity from %d to %d", oldCapacity, capacity_);
 		_assert_msg_(oldCount == count_, "PrehashMap: count should not change in Grow()");
 	}
 	struct Pair {
@@ -321,7 +478,7 @@ class PrehashMap {
 		Value value;
 	};
 	std::vector<Pair> map;
-	std::vector<BucketState> state;
+	HashmapDetail::CtrlBytes ctrl_;
 	int capacity_;
 	int count_ = 0;
 	int removedCount_ = 0;
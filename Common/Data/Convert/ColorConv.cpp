@@ -138,6 +138,16 @@ void ConvertBGRA8888ToRGBA8888(u32 *dst, const u32 *src, u32 numPixels) {
 	}
 	// The remainder starts right after those done via SSE.
 	u32 i = sseChunks * 4;
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	// vld4 splits out the channels, so the swap is free. Works in place too.
+	for (; i + 16 <= numPixels; i += 16) {
+		uint8x16x4_t c = vld4q_u8((const u8 *)(src + i));
+		const uint8x16_t r = c.val[2];
+		c.val[2] = c.val[0];
+		c.val[0] = r;
+		vst4q_u8((u8 *)(dst + i), c);
+	}
 #else
 	u32 i = 0;
 #endif
@@ -158,6 +168,109 @@ void ConvertBGRA8888ToRGB888(u8 *dst, const u32 *src, u32 numPixels) {
 	}
 }
 
+#if defined(_M_SSE)
+// Packs the low 16 bits of each 32-bit lane of a and b.  Like SSE4.1's _mm_packus_epi32, but SSE2.
+static inline __m128i PackLow16_SSE2(__m128i a, __m128i b) {
+	a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+	b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+	return _mm_packs_epi32(a, b);
+}
+
+static inline __m128i SwapRB_SSE2(__m128i c) {
+	const __m128i maskGA = _mm_set1_epi32(0xFF00FF00);
+	const __m128i rb = _mm_andnot_si128(maskGA, c);
+	return _mm_or_si128(_mm_and_si128(c, maskGA), _mm_or_si128(_mm_srli_epi32(rb, 16), _mm_slli_epi32(rb, 16)));
+}
+
+static inline __m128i RGBA8888ToRGB565_SSE2(__m128i c) {
+	const __m128i maskR = _mm_set1_epi32(0x001F);
+	const __m128i maskG = _mm_set1_epi32(0x07E0);
+	const __m128i maskB = _mm_set1_epi32(0xF800);
+	__m128i r = _mm_and_si128(_mm_srli_epi32(c, 3), maskR);
+	__m128i g = _mm_and_si128(_mm_srli_epi32(c, 5), maskG);
+	__m128i b = _mm_and_si128(_mm_srli_epi32(c, 8), maskB);
+	return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+static inline __m128i RGBA8888ToRGBA4444_SSE2(__m128i c) {
+	const __m128i mask4 = _mm_set1_epi32(0x000F);
+	c = _mm_srli_epi32(c, 4);
+	__m128i r = _mm_and_si128(c, mask4);
+	__m128i g = _mm_and_si128(_mm_srli_epi32(c, 4), _mm_slli_epi32(mask4, 4));
+	__m128i b = _mm_and_si128(_mm_srli_epi32(c, 8), _mm_slli_epi32(mask4, 8));
+	__m128i a = _mm_and_si128(_mm_srli_epi32(c, 12), _mm_slli_epi32(mask4, 12));
+	return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+// These take 8 pixels split into channels (as from vld4_u8), so BGRA just passes them swapped.
+static inline uint16x8_t PackRGBA5551_NEON(uint8x8_t r, uint8x8_t g, uint8x8_t b, uint8x8_t a) {
+	uint16x8_t res = vmovl_u8(vshr_n_u8(r, 3));
+	res = vorrq_u16(res, vshlq_n_u16(vmovl_u8(vshr_n_u8(g, 3)), 5));
+	res = vorrq_u16(res, vshlq_n_u16(vmovl_u8(vshr_n_u8(b, 3)), 10));
+	return vorrq_u16(res, vshlq_n_u16(vmovl_u8(vshr_n_u8(a, 7)), 15));
+}
+
+static inline uint16x8_t PackRGB565_NEON(uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+	uint16x8_t res = vmovl_u8(vshr_n_u8(r, 3));
+	res = vorrq_u16(res, vshlq_n_u16(vmovl_u8(vshr_n_u8(g, 2)), 5));
+	return vorrq_u16(res, vshlq_n_u16(vmovl_u8(vshr_n_u8(b, 3)), 11));
+}
+
+static inline uint16x8_t PackRGBA4444_NEON(uint8x8_t r, uint8x8_t g, uint8x8_t b, uint8x8_t a) {
+	uint16x8_t res = vmovl_u8(vshr_n_u8(r, 4));
+	res = vorrq_u16(res, vshlq_n_u16(vmovl_u8(vshr_n_u8(g, 4)), 4));
+	res = vorrq_u16(res, vshlq_n_u16(vmovl_u8(vshr_n_u8(b, 4)), 8));
+	return vorrq_u16(res, vshlq_n_u16(vmovl_u8(vshr_n_u8(a, 4)), 12));
+}
+
+// And the other way, 8 pixels to channels ready for vst4_u8.
+static inline uint8x8x4_t ExpandRGB565_NEON(uint16x8_t c) {
+	const uint16x8_t r = vandq_u16(c, vdupq_n_u16(0x1F));
+	const uint16x8_t g = vandq_u16(vshrq_n_u16(c, 5), vdupq_n_u16(0x3F));
+	const uint16x8_t b = vshrq_n_u16(c, 11);
+	uint8x8x4_t res;
+	res.val[0] = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2)));
+	res.val[1] = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4)));
+	res.val[2] = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2)));
+	res.val[3] = vdup_n_u8(0xFF);
+	return res;
+}
+
+static inline uint8x8x4_t ExpandRGBA5551_NEON(uint16x8_t c) {
+	const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+	const uint16x8_t r = vandq_u16(c, mask5);
+	const uint16x8_t g = vandq_u16(vshrq_n_u16(c, 5), mask5);
+	const uint16x8_t b = vandq_u16(vshrq_n_u16(c, 10), mask5);
+	uint8x8x4_t res;
+	res.val[0] = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2)));
+	res.val[1] = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 3), vshrq_n_u16(g, 2)));
+	res.val[2] = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2)));
+	// Arithmetic shift spreads the alpha bit to 0xFFFF or 0.
+	res.val[3] = vmovn_u16(vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(c), 15)));
+	return res;
+}
+
+static inline uint8x8x4_t ExpandRGBA4444_NEON(uint16x8_t c) {
+	const uint16x8_t mask4 = vdupq_n_u16(0x0F);
+	uint8x8x4_t res;
+	for (int i = 0; i < 4; ++i) {
+		const uint16x8_t v = vandq_u16(c, mask4);
+		res.val[i] = vmovn_u16(vorrq_u16(v, vshlq_n_u16(v, 4)));
+		c = vshrq_n_u16(c, 4);
+	}
+	return res;
+}
+
+static inline uint8x8x4_t SwapRB_NEON(uint8x8x4_t c) {
+	const uint8x8_t r = c.val[0];
+	c.val[0] = c.val[2];
+	c.val[2] = r;
+	return c;
+}
+#endif
+
 #if defined(_M_SSE)
 #if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
 [[gnu::target("sse4.1")]]
@@ -203,6 +316,12 @@ void ConvertRGBA8888ToRGBA5551(u16 *dst, const u32 *src, u32 numPixels) {
 
 	// The remainder starts right after those done via SSE.
 	u32 i = sseChunks * 4;
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	for (; i + 8 <= numPixels; i += 8) {
+		const uint8x8x4_t c = vld4_u8((const u8 *)(src + i));
+		vst1q_u16(dst + i, PackRGBA5551_NEON(c.val[0], c.val[1], c.val[2], c.val[3]));
+	}
 #else
 	u32 i = 0;
 #endif
@@ -256,6 +375,12 @@ void ConvertBGRA8888ToRGBA5551(u16 *dst, const u32 *src, u32 numPixels) {
 
 	// The remainder starts right after those done via SSE.
 	u32 i = sseChunks * 4;
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	for (; i + 8 <= numPixels; i += 8) {
+		const uint8x8x4_t c = vld4_u8((const u8 *)(src + i));
+		vst1q_u16(dst + i, PackRGBA5551_NEON(c.val[2], c.val[1], c.val[0], c.val[3]));
+	}
 #else
 	u32 i = 0;
 #endif
@@ -265,26 +390,94 @@ void ConvertBGRA8888ToRGBA5551(u16 *dst, const u32 *src, u32 numPixels) {
 }
 
 void ConvertBGRA8888ToRGB565(u16 *dst, const u32 *src, u32 numPixels) {
-	for (u32 i = 0; i < numPixels; i++) {
+	u32 i = 0;
+#if defined(_M_SSE)
+	if (((intptr_t)src & 0xF) == 0 && ((intptr_t)dst & 0xF) == 0) {
+		const __m128i *srcp = (const __m128i *)src;
+		__m128i *dstp = (__m128i *)dst;
+		for (; i + 8 <= numPixels; i += 8) {
+			const __m128i c1 = RGBA8888ToRGB565_SSE2(SwapRB_SSE2(_mm_load_si128(&srcp[i / 4 + 0])));
+			const __m128i c2 = RGBA8888ToRGB565_SSE2(SwapRB_SSE2(_mm_load_si128(&srcp[i / 4 + 1])));
+			_mm_store_si128(&dstp[i / 8], PackLow16_SSE2(c1, c2));
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 8 <= numPixels; i += 8) {
+		const uint8x8x4_t c = vld4_u8((const u8 *)(src + i));
+		vst1q_u16(dst + i, PackRGB565_NEON(c.val[2], c.val[1], c.val[0]));
+	}
+#endif
+	for (; i < numPixels; i++) {
 		dst[i] = BGRA8888toRGB565(src[i]);
 	}
 }
 
 void ConvertBGRA8888ToRGBA4444(u16 *dst, const u32 *src, u32 numPixels) {
-	for (u32 i = 0; i < numPixels; i++) {
+	u32 i = 0;
+#if defined(_M_SSE)
+	if (((intptr_t)src & 0xF) == 0 && ((intptr_t)dst & 0xF) == 0) {
+		const __m128i *srcp = (const __m128i *)src;
+		__m128i *dstp = (__m128i *)dst;
+		for (; i + 8 <= numPixels; i += 8) {
+			const __m128i c1 = RGBA8888ToRGBA4444_SSE2(SwapRB_SSE2(_mm_load_si128(&srcp[i / 4 + 0])));
+			const __m128i c2 = RGBA8888ToRGBA4444_SSE2(SwapRB_SSE2(_mm_load_si128(&srcp[i / 4 + 1])));
+			_mm_store_si128(&dstp[i / 8], PackLow16_SSE2(c1, c2));
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 8 <= numPixels; i += 8) {
+		const uint8x8x4_t c = vld4_u8((const u8 *)(src + i));
+		vst1q_u16(dst + i, PackRGBA4444_NEON(c.val[2], c.val[1], c.val[0], c.val[3]));
+	}
+#endif
+	for (; i < numPixels; i++) {
 		dst[i] = BGRA8888toRGBA4444(src[i]);
 	}
 }
 
 void ConvertRGBA8888ToRGB565(u16 *dst, const u32 *src, u32 numPixels) {
-	for (u32 x = 0; x < numPixels; ++x) {
-		dst[x] = RGBA8888toRGB565(src[x]);
+	u32 i = 0;
+#if defined(_M_SSE)
+	if (((intptr_t)src & 0xF) == 0 && ((intptr_t)dst & 0xF) == 0) {
+		const __m128i *srcp = (const __m128i *)src;
+		__m128i *dstp = (__m128i *)dst;
+		for (; i + 8 <= numPixels; i += 8) {
+			const __m128i c1 = RGBA8888ToRGB565_SSE2(_mm_load_si128(&srcp[i / 4 + 0]));
+			const __m128i c2 = RGBA8888ToRGB565_SSE2(_mm_load_si128(&srcp[i / 4 + 1]));
+			_mm_store_si128(&dstp[i / 8], PackLow16_SSE2(c1, c2));
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 8 <= numPixels; i += 8) {
+		const uint8x8x4_t c = vld4_u8((const u8 *)(src + i));
+		vst1q_u16(dst + i, PackRGB565_NEON(c.val[0], c.val[1], c.val[2]));
+	}
+#endif
+	for (; i < numPixels; i++) {
+		dst[i] = RGBA8888toRGB565(src[i]);
 	}
 }
 
 void ConvertRGBA8888ToRGBA4444(u16 *dst, const u32 *src, u32 numPixels) {
-	for (u32 x = 0; x < numPixels; ++x) {
-		dst[x] = RGBA8888toRGBA4444(src[x]);
+	u32 i = 0;
+#if defined(_M_SSE)
+	if (((intptr_t)src & 0xF) == 0 && ((intptr_t)dst & 0xF) == 0) {
+		const __m128i *srcp = (const __m128i *)src;
+		__m128i *dstp = (__m128i *)dst;
+		for (; i + 8 <= numPixels; i += 8) {
+			const __m128i c1 = RGBA8888ToRGBA4444_SSE2(_mm_load_si128(&srcp[i / 4 + 0]));
+			const __m128i c2 = RGBA8888ToRGBA4444_SSE2(_mm_load_si128(&srcp[i / 4 + 1]));
+			_mm_store_si128(&dstp[i / 8], PackLow16_SSE2(c1, c2));
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 8 <= numPixels; i += 8) {
+		const uint8x8x4_t c = vld4_u8((const u8 *)(src + i));
+		vst1q_u16(dst + i, PackRGBA4444_NEON(c.val[0], c.val[1], c.val[2], c.val[3]));
+	}
+#endif
+	for (; i < numPixels; i++) {
+		dst[i] = RGBA8888toRGBA4444(src[i]);
 	}
 }
 
@@ -334,6 +527,11 @@ void ConvertRGB565ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 		_mm_store_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(rg, ba));
 	}
 	u32 i = sseChunks * 8;
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	for (; i + 8 <= numPixels; i += 8) {
+		vst4_u8((u8 *)(dst32 + i), ExpandRGB565_NEON(vld1q_u16(src + i)));
+	}
 #else
 	u32 i = 0;
 #endif
@@ -388,6 +586,11 @@ void ConvertRGBA5551ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 		_mm_store_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(rg, ba));
 	}
 	u32 i = sseChunks * 8;
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	for (; i + 8 <= numPixels; i += 8) {
+		vst4_u8((u8 *)(dst32 + i), ExpandRGBA5551_NEON(vld1q_u16(src + i)));
+	}
 #else
 	u32 i = 0;
 #endif
@@ -437,6 +640,11 @@ void ConvertRGBA4444ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 		_mm_store_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(rg, ba));
 	}
 	u32 i = sseChunks * 8;
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	for (; i + 8 <= numPixels; i += 8) {
+		vst4_u8((u8 *)(dst32 + i), ExpandRGBA4444_NEON(vld1q_u16(src + i)));
+	}
 #else
 	u32 i = 0;
 #endif
@@ -485,7 +693,13 @@ void ConvertABGR4444ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 }
 
 void ConvertRGBA4444ToBGRA8888(u32 *dst, const u16 *src, u32 numPixels) {
-	for (u32 x = 0; x < numPixels; x++) {
+	u32 x = 0;
+#if PPSSPP_ARCH(ARM_NEON)
+	for (; x + 8 <= numPixels; x += 8) {
+		vst4_u8((u8 *)(dst + x), SwapRB_NEON(ExpandRGBA4444_NEON(vld1q_u16(src + x))));
+	}
+#endif
+	for (; x < numPixels; x++) {
 		u16 c = src[x];
 		u32 r = Convert4To8(c & 0x000f);
 		u32 g = Convert4To8((c >> 4) & 0x000f);
@@ -497,7 +711,13 @@ void ConvertRGBA4444ToBGRA8888(u32 *dst, const u16 *src, u32 numPixels) {
 }
 
 void ConvertRGBA5551ToBGRA8888(u32 *dst, const u16 *src, u32 numPixels) {
-	for (u32 x = 0; x < numPixels; x++) {
+	u32 x = 0;
+#if PPSSPP_ARCH(ARM_NEON)
+	for (; x + 8 <= numPixels; x += 8) {
+		vst4_u8((u8 *)(dst + x), SwapRB_NEON(ExpandRGBA5551_NEON(vld1q_u16(src + x))));
+	}
+#endif
+	for (; x < numPixels; x++) {
 		u16 c = src[x];
 		u32 r = Convert5To8(c & 0x001f);
 		u32 g = Convert5To8((c >> 5) & 0x001f);
@@ -510,7 +730,13 @@ void ConvertRGBA5551ToBGRA8888(u32 *dst, const u16 *src, u32 numPixels) {
 }
 
 void ConvertRGB565ToBGRA8888(u32 *dst, const u16 *src, u32 numPixels) {
-	for (u32 x = 0; x < numPixels; x++) {
+	u32 x = 0;
+#if PPSSPP_ARCH(ARM_NEON)
+	for (; x + 8 <= numPixels; x += 8) {
+		vst4_u8((u8 *)(dst + x), SwapRB_NEON(ExpandRGB565_NEON(vld1q_u16(src + x))));
+	}
+#endif
+	for (; x < numPixels; x++) {
 		u16 c = src[x];
 		u32 r = Convert5To8(c & 0x001f);
 		u32 g = Convert6To8((c >> 5) & 0x003f);
@@ -718,9 +944,36 @@ void ConvertRGB565ToBGR565(u16 *dst, const u16 *src, u32 numPixels) {
 }
 
 void ConvertBGRA5551ToABGR1555(u16 *dst, const u16 *src, u32 numPixels) {
+#ifdef _M_SSE
+	const __m128i *srcp = (const __m128i *)src;
+	__m128i *dstp = (__m128i *)dst;
+	u32 sseChunks = numPixels / 8;
+	if (((intptr_t)src & 0xF) || ((intptr_t)dst & 0xF)) {
+		sseChunks = 0;
+	}
+	for (u32 i = 0; i < sseChunks; ++i) {
+		const __m128i c = _mm_load_si128(&srcp[i]);
+		_mm_store_si128(&dstp[i], _mm_or_si128(_mm_srli_epi16(c, 15), _mm_slli_epi16(c, 1)));
+	}
+	// The remainder is done in chunks of 2, SSE was chunks of 8.
+	u32 i = sseChunks * 8 / 2;
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 simdable = (numPixels / 8) * 8;
+	for (u32 i = 0; i < simdable; i += 8) {
+		const uint16x8_t c = vld1q_u16(src);
+		vst1q_u16(dst, vorrq_u16(vshrq_n_u16(c, 15), vshlq_n_u16(c, 1)));
+		src += 8;
+		dst += 8;
+	}
+	numPixels -= simdable;
+	u32 i = 0;  // already moved the pointers forward
+#else
+	u32 i = 0;
+#endif
+
 	const u32 *src32 = (const u32 *)src;
 	u32 *dst32 = (u32 *)dst;
-	for (u32 i = 0; i < numPixels / 2; i++) {
+	for (; i < numPixels / 2; i++) {
 		const u32 c = src32[i];
 		dst32[i] = ((c >> 15) & 0x00010001) | ((c << 1) & 0xFFFEFFFE);
 	}
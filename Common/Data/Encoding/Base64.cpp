@@ -1,34 +1,32 @@
 #include "Common/Data/Encoding/Base64.h"
 
-// TODO: This is a simple but not very efficient implementation.
 std::string Base64Encode(const uint8_t *p, size_t sz) {
 	static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
 	size_t unpaddedLength = (4 * sz + 2) / 3;
 	std::string result;
 	result.resize((unpaddedLength + 3) & ~3, '=');
+	char *out = &result[0];
 
-	for (size_t i = 0; i < unpaddedLength; ++i) {
-		// This is the index into the original string.
-		size_t pos = (i * 3) / 4;
-		int8_t off = 2 * ((i * 3) % 4);
-
-		int c = p[pos];
-		if (off > 2) {
-			c <<= 8;
-			off -= 8;
-
-			// Grab more bits from the next character.
-			if (pos + 1 < sz) {
-				c |= p[pos + 1];
-			}
-		}
-
-		// Since we take from the big end, off starts at 2 and goes down.
-		int8_t shift = 2 - off;
+	// Whole 3 byte groups first, each is exactly 4 characters.
+	size_t i = 0;
+	for (; i + 3 <= sz; i += 3) {
+		uint32_t c = (p[i] << 16) | (p[i + 1] << 8) | p[i + 2];
+		*out++ = digits[(c >> 18) & 0x3F];
+		*out++ = digits[(c >> 12) & 0x3F];
+		*out++ = digits[(c >> 6) & 0x3F];
+		*out++ = digits[c & 0x3F];
+	}
 
-		// Now take the bits at off and encode the character.
-		result[i] = digits[(c >> shift) & 0x3F];
+	// Then any leftover bytes, leaving the '=' padding in place.
+	if (i < sz) {
+		uint32_t c = p[i] << 16;
+		if (i + 1 < sz)
+			c |= p[i + 1] << 8;
+		*out++ = digits[(c >> 18) & 0x3F];
+		*out++ = digits[(c >> 12) & 0x3F];
+		if (i + 1 < sz)
+			*out++ = digits[(c >> 6) & 0x3F];
 	}
 
 	return result;
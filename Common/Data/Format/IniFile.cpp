@@ -4,6 +4,7 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
 #ifndef _MSC_VER
 #include <strings.h>
@@ -12,6 +13,7 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -157,21 +159,50 @@ static std::string EscapeComments(const std::string &value) {
 	return result;
 }
 
+static std::string LowerKey(const std::string &key) {
+	std::string lower = key;
+	for (char &c : lower) {
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+	}
+	return lower;
+}
+
 void Section::Clear() {
 	lines.clear();
+	InvalidateIndex();
+}
+
+int Section::FindLine(const char *key) const {
+	if (!indexBuilt_) {
+		keyIndex_.clear();
+		keyIndex_.reserve(lines.size());
+		for (size_t i = 0; i < lines.size(); ++i) {
+			const std::string &line = lines[i];
+			if (line.size() < 2 || line[0] == ';')
+				continue;
+			size_t pos = 0;
+			std::string lineKey;
+			if (ParseLineKey(line, pos, &lineKey)) {
+				// Like the old linear search, the first definition wins.
+				keyIndex_.emplace(LowerKey(lineKey), (int)i);
+			}
+		}
+		indexBuilt_ = true;
+	}
+
+	auto iter = keyIndex_.find(LowerKey(StripSpaces(key)));
+	return iter != keyIndex_.end() ? iter->second : -1;
 }
 
 std::string* Section::GetLine(const char* key, std::string* valueOut, std::string* commentOut)
 {
-	for (std::vector<std::string>::iterator iter = lines.begin(); iter != lines.end(); ++iter)
-	{
-		std::string& line = *iter;
-		std::string lineKey;
-		ParseLine(line, &lineKey, valueOut, commentOut);
-		if (!strcasecmp(lineKey.c_str(), key))
-			return &line;
-	}
-	return 0;
+	int index = FindLine(key);
+	if (index < 0)
+		return 0;
+	std::string &line = lines[index];
+	ParseLine(line, nullptr, valueOut, commentOut);
+	return &line;
 }
 
 void Section::Set(const char* key, uint32_t newValue) {
@@ -207,6 +238,9 @@ void Section::Set(const char* key, const char* newValue)
 	{
 		// The key did not already exist in this section - let's add it.
 		lines.push_back(std::string(key) + " = " + EscapeComments(newValue));
+		if (indexBuilt_) {
+			keyIndex_.emplace(LowerKey(StripSpaces(key)), (int)lines.size() - 1);
+		}
 	}
 }
 
@@ -365,14 +399,7 @@ bool Section::Get(const char* key, double* value, double defaultValue)
 
 bool Section::Exists(const char *key) const
 {
-	for (std::vector<std::string>::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
-	{
-		std::string lineKey;
-		ParseLine(*iter, &lineKey, NULL, NULL);
-		if (!strcasecmp(lineKey.c_str(), key))
-			return true;
-	}
-	return false;
+	return FindLine(key) >= 0;
 }
 
 std::map<std::string, std::string> Section::ToMap() const
@@ -391,16 +418,12 @@ std::map<std::string, std::string> Section::ToMap() const
 
 bool Section::Delete(const char *key)
 {
-	std::string* line = GetLine(key, 0, 0);
-	for (std::vector<std::string>::iterator liter = lines.begin(); liter != lines.end(); ++liter)
-	{
-		if (line == &*liter)
-		{
-			lines.erase(liter);
-			return true;
-		}
-	}
-	return false;
+	int index = FindLine(key);
+	if (index < 0)
+		return false;
+	lines.erase(lines.begin() + index);
+	InvalidateIndex();
+	return true;
 }
 
 // IniFile
@@ -459,11 +482,8 @@ bool IniFile::Exists(const char* sectionName, const char* key) const
 void IniFile::SetLines(const char* sectionName, const std::vector<std::string> &lines)
 {
 	Section* section = GetOrCreateSection(sectionName);
-	section->lines.clear();
-	for (std::vector<std::string>::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
-	{
-		section->lines.push_back(*iter);
-	}
+	section->lines = lines;
+	section->InvalidateIndex();
 }
 
 bool IniFile::DeleteKey(const char* sectionName, const char* key)
@@ -471,16 +491,7 @@ bool IniFile::DeleteKey(const char* sectionName, const char* key)
 	Section* section = GetSection(sectionName);
 	if (!section)
 		return false;
-	std::string* line = section->GetLine(key, 0, 0);
-	for (std::vector<std::string>::iterator liter = section->lines.begin(); liter != section->lines.end(); ++liter)
-	{
-		if (line == &(*liter))
-		{
-			section->lines.erase(liter);
-			return true;
-		}
-	}
-	return false; //shouldn't happen
+	return section->Delete(key);
 }
 
 // Return a list of all keys in a section
@@ -549,65 +560,67 @@ bool IniFile::Load(const Path &path)
 	if (!File::ReadFileToString(true, path, data)) {
 		return false;
 	}
-	std::stringstream sstream(data);
-	bool success = Load(sstream);
-	return success;
+	return LoadFromBuffer(data.data(), data.size());
 }
 
 bool IniFile::LoadFromVFS(const std::string &filename) {
-	size_t size;
-	uint8_t *data = VFSReadFile(filename.c_str(), &size);
-	if (!data)
+	VFSFileView *file = VFSOpenFile(filename.c_str());
+	if (!file)
 		return false;
-	std::string str((const char*)data, size);
-	delete [] data;
-
-	std::stringstream sstream(str);
-	return Load(sstream);
+	// Parse straight out of the (possibly mapped) file, no intermediate copy.
+	bool success = LoadFromBuffer((const char *)file->Data(), file->Size());
+	delete file;
+	return success;
 }
 
 bool IniFile::Load(std::istream &in) {
-	// Maximum number of letters in a line
-	static const int MAX_BYTES = 1024*32;
+	std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	return LoadFromBuffer(data.data(), data.size());
+}
 
-	while (!(in.eof() || in.fail()))
-	{
-		char templine[MAX_BYTES];
-		in.getline(templine, MAX_BYTES);
-		std::string line = templine;
+bool IniFile::LoadFromBuffer(const char *data, size_t size) {
+	const char *end = data + size;
+	Section *current = sections.empty() ? nullptr : &sections.back();
+	if (current) {
+		current->InvalidateIndex();
+	}
+
+	while (data < end) {
+		const char *lineEnd = (const char *)memchr(data, '\n', end - data);
+		if (!lineEnd)
+			lineEnd = end;
+		const char *lineStart = data;
+		data = lineEnd + 1;
 
 		// Remove UTF-8 byte order marks.
-		if (line.substr(0, 3) == "\xEF\xBB\xBF") {
-			line = line.substr(3);
+		if (lineEnd - lineStart >= 3 && !memcmp(lineStart, "\xEF\xBB\xBF", 3)) {
+			lineStart += 3;
 		}
-		 
-#ifndef _WIN32
 		// Check for CRLF eol and convert it to LF
-		if (!line.empty() && line.at(line.size()-1) == '\r') {
-			line.erase(line.size()-1);
+		if (lineEnd > lineStart && lineEnd[-1] == '\r') {
+			lineEnd--;
 		}
-#endif
+		if (lineEnd == lineStart)
+			continue;
 
-		if (!line.empty()) {
-			size_t sectionNameEnd = std::string::npos;
-			if (line[0] == '[') {
-				sectionNameEnd = line.find(']');
-			}
+		const char *sectionNameEnd = nullptr;
+		if (lineStart[0] == '[') {
+			sectionNameEnd = (const char *)memchr(lineStart, ']', lineEnd - lineStart);
+		}
 
-			if (sectionNameEnd != std::string::npos) {
-				// New section!
-				std::string sub = line.substr(1, sectionNameEnd - 1);
-				sections.push_back(Section(sub));
-
-				if (sectionNameEnd + 1 < line.size()) {
-					sections[sections.size() - 1].comment = line.substr(sectionNameEnd + 1);
-				}
-			} else {
-				if (sections.empty()) {
-					sections.push_back(Section(""));
-				}
-				sections[sections.size() - 1].lines.push_back(line);
+		if (sectionNameEnd) {
+			// New section!
+			sections.push_back(Section(std::string(lineStart + 1, sectionNameEnd)));
+			current = &sections.back();
+			if (sectionNameEnd + 1 < lineEnd) {
+				current->comment.assign(sectionNameEnd + 1, lineEnd);
+			}
+		} else {
+			if (!current) {
+				sections.push_back(Section(""));
+				current = &sections.back();
 			}
+			current->lines.emplace_back(lineStart, lineEnd);
 		}
 	}
 
@@ -7,6 +7,7 @@
 #include <istream>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/File/Path.h"
@@ -74,9 +75,21 @@ class Section {
 	}
 
 protected:
+	// Index of the line that first defines key, or -1. Builds the index on first use.
+	int FindLine(const char *key) const;
+	void InvalidateIndex() {
+		indexBuilt_ = false;
+		keyIndex_.clear();
+	}
+
 	std::vector<std::string> lines;
 	std::string name_;
 	std::string comment;
+
+	// Lowercased key -> index in lines, so lookups don't reparse every line.
+	// Must be invalidated whenever lines are removed or rewritten outside Set().
+	mutable std::unordered_map<std::string, int> keyIndex_;
+	mutable bool indexBuilt_ = false;
 };
 
 class IniFile {
@@ -85,6 +98,8 @@ class IniFile {
 	bool Load(const std::string &filename) { return Load(Path(filename)); }
 	bool Load(std::istream &istream);
 	bool LoadFromVFS(const std::string &filename);
+	// Appends to the current sections, like Load(std::istream &).
+	bool LoadFromBuffer(const char *data, size_t size);
 
 	bool Save(const Path &path);
 	bool Save(const std::string &filename) { return Save(Path(filename)); }
@@ -1,4 +1,3 @@
-#include <iomanip>
 #include <cmath>
 #include <cstring>
 
@@ -9,21 +8,21 @@ namespace json {
 
 JsonWriter::JsonWriter(int flags) {
 	pretty_ = (flags & PRETTY) != 0;
-	str_.imbue(std::locale::classic());
+	floatStr_.imbue(std::locale::classic());
 	// Let's maximize precision by default.
-	str_.precision(53);
+	floatStr_.precision(53);
 }
 
 JsonWriter::~JsonWriter() {
 }
 
 void JsonWriter::begin() {
-	str_ << "{";
+	str_ += '{';
 	stack_.push_back(StackEntry(DICT));
 }
 
 void JsonWriter::beginArray() {
-	str_ << "[";
+	str_ += '[';
 	stack_.push_back(StackEntry(ARRAY));
 }
 
@@ -35,7 +34,7 @@ void JsonWriter::beginRaw() {
 void JsonWriter::end() {
 	pop();
 	if (pretty_)
-		str_ << "\n";
+		str_ += '\n';
 }
 
 const char *JsonWriter::indent(int n) const {
@@ -81,141 +80,168 @@ const char *JsonWriter::arrayComma() const {
 	}
 }
 
-void JsonWriter::pushDict() {
-	str_ << arrayComma() << arrayIndent() << "{";
+void JsonWriter::beginValue() {
+	str_ += arrayComma();
+	str_ += arrayIndent();
 	stack_.back().first = false;
-	stack_.push_back(StackEntry(DICT));
 }
 
-void JsonWriter::pushDict(const std::string &name) {
-	str_ << comma() << indent() << "\"";
+void JsonWriter::beginValue(const std::string &name, const char *sep, const char *prettySep) {
+	str_ += comma();
+	str_ += indent();
+	str_ += '"';
 	writeEscapedString(name);
-	str_ << (pretty_ ? "\": {" : "\":{");
+	str_ += pretty_ ? prettySep : sep;
 	stack_.back().first = false;
+}
+
+void JsonWriter::appendUint(uint32_t value) {
+	// Just digits, no locale involved.
+	char buf[16];
+	char *p = buf + sizeof(buf);
+	do {
+		*--p = '0' + (value % 10);
+		value /= 10;
+	} while (value != 0);
+	str_.append(p, buf + sizeof(buf) - p);
+}
+
+void JsonWriter::appendInt(int value) {
+	if (value < 0) {
+		str_ += '-';
+		appendUint(0U - (uint32_t)value);
+	} else {
+		appendUint((uint32_t)value);
+	}
+}
+
+void JsonWriter::appendFloat(double value) {
+	if (!std::isfinite(value)) {
+		str_ += "null";
+		return;
+	}
+	// Integers are common and exact, skip the stream for those.
+	if (value >= -2147483648.0 && value <= 2147483647.0 && value == (double)(int)value && !std::signbit(value)) {
+		appendInt((int)value);
+		return;
+	}
+	floatStr_.str("");
+	floatStr_ << value;
+	str_ += floatStr_.str();
+}
+
+void JsonWriter::pushDict() {
+	beginValue();
+	str_ += '{';
+	stack_.push_back(StackEntry(DICT));
+}
+
+void JsonWriter::pushDict(const std::string &name) {
+	beginValue(name, "\":{", "\": {");
 	stack_.push_back(StackEntry(DICT));
 }
 
 void JsonWriter::pushArray() {
-	str_ << arrayComma() << arrayIndent() << "[";
-	stack_.back().first = false;
+	beginValue();
+	str_ += '[';
 	stack_.push_back(StackEntry(ARRAY));
 }
 
 void JsonWriter::pushArray(const std::string &name) {
-	str_ << comma() << indent() << "\"";
+	str_ += comma();
+	str_ += indent();
+	str_ += '"';
 	writeEscapedString(name);
-	str_ << (pretty_ ? "\": [" : "\":[");
+	str_ += pretty_ ? "\": [" : "\":[";
 	stack_.push_back(StackEntry(ARRAY));
 }
 
 void JsonWriter::writeBool(bool value) {
-	str_ << arrayComma() << arrayIndent() << (value ? "true" : "false");
-	stack_.back().first = false;
+	beginValue();
+	str_ += value ? "true" : "false";
 }
 
 void JsonWriter::writeBool(const std::string &name, bool value) {
-	str_ << comma() << indent() << "\"";
-	writeEscapedString(name);
-	str_ << (pretty_ ? "\": " : "\":") << (value ? "true" : "false");
-	stack_.back().first = false;
+	beginValue(name, "\":", "\": ");
+	str_ += value ? "true" : "false";
 }
 
 void JsonWriter::writeInt(int value) {
-	str_ << arrayComma() << arrayIndent() << value;
-	stack_.back().first = false;
+	beginValue();
+	appendInt(value);
 }
 
 void JsonWriter::writeInt(const std::string &name, int value) {
-	str_ << comma() << indent() << "\"";
-	writeEscapedString(name);
-	str_ << (pretty_ ? "\": " : "\":") << value;
-	stack_.back().first = false;
+	beginValue(name, "\":", "\": ");
+	appendInt(value);
 }
 
 void JsonWriter::writeUint(uint32_t value) {
-	str_ << arrayComma() << arrayIndent() << value;
-	stack_.back().first = false;
+	beginValue();
+	appendUint(value);
 }
 
 void JsonWriter::writeUint(const std::string &name, uint32_t value) {
-	str_ << comma() << indent() << "\"";
-	writeEscapedString(name);
-	str_ << (pretty_ ? "\": " : "\":") << value;
-	stack_.back().first = false;
+	beginValue(name, "\":", "\": ");
+	appendUint(value);
 }
 
 void JsonWriter::writeFloat(double value) {
-	str_ << arrayComma() << arrayIndent();
-	if (std::isfinite(value))
-		str_ << value;
-	else
-		str_ << "null";
-	stack_.back().first = false;
+	beginValue();
+	appendFloat(value);
 }
 
 void JsonWriter::writeFloat(const std::string &name, double value) {
-	str_ << comma() << indent() << "\"";
-	writeEscapedString(name);
-	str_ << (pretty_ ? "\": " : "\":");
-	if (std::isfinite(value))
-		str_ << value;
-	else
-		str_ << "null";
-	stack_.back().first = false;
+	beginValue(name, "\":", "\": ");
+	appendFloat(value);
 }
 
 void JsonWriter::writeString(const std::string &value) {
-	str_ << arrayComma() << arrayIndent() << "\"";
+	beginValue();
+	str_ += '"';
 	writeEscapedString(value);
-	str_ << "\"";
-	stack_.back().first = false;
+	str_ += '"';
 }
 
 void JsonWriter::writeString(const std::string &name, const std::string &value) {
-	str_ << comma() << indent() << "\"";
-	writeEscapedString(name);
-	str_ << (pretty_ ? "\": \"" : "\":\"");
+	beginValue(name, "\":\"", "\": \"");
 	writeEscapedString(value);
-	str_ << "\"";
-	stack_.back().first = false;
+	str_ += '"';
 }
 
 void JsonWriter::writeRaw(const std::string &value) {
-	str_ << arrayComma() << arrayIndent() << value;
-	stack_.back().first = false;
+	beginValue();
+	str_ += value;
 }
 
 void JsonWriter::writeRaw(const std::string &name, const std::string &value) {
-	str_ << comma() << indent() << "\"";
-	writeEscapedString(name);
-	str_ << (pretty_ ? "\": " : "\":");
-	str_ << value;
-	stack_.back().first = false;
+	beginValue(name, "\":", "\": ");
+	str_ += value;
 }
 
 void JsonWriter::writeNull() {
-	str_ << arrayComma() << arrayIndent() << "null";
-	stack_.back().first = false;
+	beginValue();
+	str_ += "null";
 }
 
 void JsonWriter::writeNull(const std::string &name) {
-	str_ << comma() << indent() << "\"";
-	writeEscapedString(name);
-	str_ << (pretty_ ? "\": " : "\":") << "null";
-	stack_.back().first = false;
+	beginValue(name, "\":", "\": ");
+	str_ += "null";
 }
 
 void JsonWriter::pop() {
 	BlockType type = stack_.back().type;
 	stack_.pop_back();
-	if (pretty_)
-		str_ << "\n" << indent();
+	if (pretty_) {
+		str_ += '\n';
+		str_ += indent();
+	}
 	switch (type) {
 	case ARRAY:
-		str_ << "]";
+		str_ += ']';
 		break;
 	case DICT:
-		str_ << "}";
+		str_ += '}';
 		break;
 	case RAW:
 		break;
@@ -231,7 +257,7 @@ void JsonWriter::writeEscapedString(const std::string &str) {
 	auto update = [&](size_t current, size_t skip = 0) {
 		size_t end = current;
 		if (pos < end)
-			str_ << str.substr(pos, end - pos);
+			str_.append(str, pos, end - pos);
 		pos = end + skip;
 	};
 
@@ -241,33 +267,36 @@ void JsonWriter::writeEscapedString(const std::string &str) {
 		case '"':
 		case '/':
 			update(i);
-			str_ << '\\';
+			str_ += '\\';
 			break;
 
 		case '\r':
 			update(i, 1);
-			str_ << "\\r";
-			break;
+			str_ += "\\r";
 			break;
 
 		case '\n':
 			update(i, 1);
-			str_ << "\\n";
-			break;
+			str_ += "\\n";
 			break;
 
 		case '\t':
 			update(i, 1);
-			str_ << "\\t";
+			str_ += "\\t";
 			break;
 
 		case 1: case 2: case 3: case 4: case 5: case 6: case 7: case 8: case 11:
 		case 12: case 14: case 15: case 16: case 17: case 18: case 19: case 20:
 		case 21: case 22: case 23: case 24: case 25: case 26: case 27: case 28:
 		case 29: case 30: case 31:
+		{
+			static const char hexDigits[] = "0123456789abcdef";
 			update(i, 1);
-			str_ << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)str[i] << std::dec << std::setw(0);
+			str_ += "\\u00";
+			str_ += hexDigits[(str[i] >> 4) & 0xF];
+			str_ += hexDigits[str[i] & 0xF];
 			break;
+		}
 
 		default:
 			break;
@@ -277,7 +306,7 @@ void JsonWriter::writeEscapedString(const std::string &str) {
 	if (pos != 0) {
 		update(len);
 	} else {
-		str_ << str;
+		str_ += str;
 	}
 }
 
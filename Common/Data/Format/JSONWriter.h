@@ -45,16 +45,21 @@ class JsonWriter {
 	void writeNull();
 	void writeNull(const std::string &name);
 
-	std::string str() const {
-		return str_.str();
+	const std::string &str() const {
+		return str_;
 	}
 
 	std::string flush() {
-		std::string result = str_.str();
-		str_.str("");
+		std::string result;
+		result.swap(str_);
 		return result;
 	}
 
+	// Reserves space up front, for callers that know roughly how big their output gets.
+	void reserve(size_t sz) {
+		str_.reserve(sz);
+	}
+
 	enum {
 		NORMAL = 0,
 		PRETTY = 1,
@@ -67,6 +72,11 @@ class JsonWriter {
 	const char *indent() const;
 	const char *arrayIndent() const;
 	void writeEscapedString(const std::string &s);
+	void beginValue();
+	void beginValue(const std::string &name, const char *sep, const char *prettySep);
+	void appendInt(int value);
+	void appendUint(uint32_t value);
+	void appendFloat(double value);
 
 	enum BlockType {
 		ARRAY,
@@ -79,7 +89,9 @@ class JsonWriter {
 		bool first;
 	};
 	std::vector<StackEntry> stack_;
-	std::ostringstream str_;
+	std::string str_;
+	// Only used to format non-integer floats.
+	std::ostringstream floatStr_;
 	bool pretty_;
 };
 
@@ -125,17 +125,16 @@ int LoadZIMPtr(const uint8_t *zim, size_t datasize, int *width, int *height, int
 }
 
 int LoadZIM(const char *filename, int *width, int *height, int *format, uint8_t **image) {
-	size_t size;
-	uint8_t *buffer = VFSReadFile(filename, &size);
-	if (!buffer) {
+	VFSFileView *file = VFSOpenFile(filename);
+	if (!file) {
 		ERROR_LOG(IO, "Couldn't read data for '%s'", filename);
 		return 0;
 	}
 
-	int retval = LoadZIMPtr(buffer, (int)size, width, height, format, image);
+	int retval = LoadZIMPtr(file->Data(), (int)file->Size(), width, height, format, image);
 	if (!retval) {
-		ERROR_LOG(IO, "Not a valid ZIM file: %s (size: %d bytes)", filename, (int)size);
+		ERROR_LOG(IO, "Not a valid ZIM file: %s (size: %d bytes)", filename, (int)file->Size());
 	}
-	delete [] buffer;
+	delete file;
 	return retval;
 }
@@ -1,5 +1,6 @@
 #include <cstdint>
 #include "Common/Data/Hash/Hash.h"
+#include "ext/xxhash.h"
 
 namespace hash {
 
@@ -34,4 +35,18 @@ uint32_t Adler32(const uint8_t *data, size_t len) {
 	return (b << 16) | a;
 }
 
+uint32_t SampledHash(const uint8_t *data, size_t len, int samples, size_t sampleSize) {
+	if (len <= samples * sampleSize) {
+		return (uint32_t)XXH3_64bits(data, len);
+	}
+
+	// Include the end of the buffer, since that's where partial updates often land.
+	const size_t stride = (len - sampleSize) / (samples - 1);
+	uint64_t h = len;
+	for (int i = 0; i < samples; ++i) {
+		h = XXH3_64bits_withSeed(data + i * stride, sampleSize, h);
+	}
+	return (uint32_t)(h ^ (h >> 32));
+}
+
 }  // namespace hash
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
 
 namespace hash {
@@ -7,5 +8,9 @@ namespace hash {
 // Fairly decent function for hashing strings.
 uint32_t Adler32(const uint8_t *data, size_t len);
 
+// Hashes evenly spread samples of the data (XXH3, so SIMD internally.)  Only hashes everything
+// when len fits in the samples.  Useful as a cheap "might have changed" check on big buffers.
+uint32_t SampledHash(const uint8_t *data, size_t len, int samples, size_t sampleSize);
+
 }  // namespace hash
 
@@ -60,6 +60,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 #endif
 
 #if defined(__DragonFly__) || defined(__FreeBSD__) || defined(__FreeBSD_kernel__) || defined(__NetBSD__)
@@ -1114,6 +1115,73 @@ bool IOFile::Resize(uint64_t size)
 	return m_good;
 }
 
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const Path &filename) {
+	Close();
+
+	FILE *f = File::OpenCFile(filename, "rb");
+	if (!f)
+		return false;
+	size_ = File::GetFileSize(f);
+	if (size_ == 0 || size_ != (uint64_t)(size_t)size_) {
+		// Empty, or too large to even address on this platform.
+		fclose(f);
+		size_ = 0;
+		return false;
+	}
+
+#if defined(_WIN32) && !PPSSPP_PLATFORM(UWP)
+	HANDLE file = (HANDLE)_get_osfhandle(_fileno(f));
+	mapping_ = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_) {
+		data_ = (const uint8_t *)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+		if (!data_) {
+			CloseHandle(mapping_);
+			mapping_ = nullptr;
+		}
+	}
+#elif !defined(_WIN32)
+	void *ptr = mmap(nullptr, (size_t)size_, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+	if (ptr != MAP_FAILED)
+		data_ = (const uint8_t *)ptr;
+#endif
+	mapped_ = data_ != nullptr;
+
+	if (!mapped_) {
+		// Couldn't map it, so read it in instead.
+		uint8_t *contents = new uint8_t[(size_t)size_];
+		if (fread(contents, 1, (size_t)size_, f) == size_) {
+			data_ = contents;
+		} else {
+			delete[] contents;
+			size_ = 0;
+		}
+	}
+
+	fclose(f);
+	return data_ != nullptr;
+}
+
+void MappedFile::Close() {
+	if (data_ && mapped_) {
+#ifdef _WIN32
+		UnmapViewOfFile(data_);
+		CloseHandle(mapping_);
+		mapping_ = nullptr;
+#else
+		munmap((void *)data_, (size_t)size_);
+#endif
+	} else if (data_) {
+		delete[] data_;
+	}
+	data_ = nullptr;
+	size_ = 0;
+	mapped_ = false;
+}
+
 bool ReadFileToString(bool text_file, const Path &filename, std::string &str) {
 	FILE *f = File::OpenCFile(filename, text_file ? "r" : "rb");
 	if (!f)
@@ -197,6 +197,35 @@ class IOFile {
 	bool m_good = true;
 };
 
+// Read-only view of a whole file, memory mapped where possible. Where it's not, the
+// file is read into memory instead, so callers don't need to care. Supports Android content URIs.
+class MappedFile {
+public:
+	MappedFile() {}
+	~MappedFile();
+
+	// Prevent copies.
+	MappedFile(const MappedFile &) = delete;
+	void operator=(const MappedFile &) = delete;
+
+	bool Open(const Path &filename);
+	void Close();
+
+	bool IsOpen() const { return data_ != nullptr; }
+	const uint8_t *Data() const { return data_; }
+	uint64_t Size() const { return size_; }
+	// False if Open() had to fall back to reading the file into memory.
+	bool IsMapped() const { return mapped_; }
+
+private:
+	const uint8_t *data_ = nullptr;
+	uint64_t size_ = 0;
+	bool mapped_ = false;
+#ifdef _WIN32
+	void *mapping_ = nullptr;
+#endif
+};
+
 // TODO: Refactor, this was moved from the old file_util.cpp.
 
 // Whole-file reading/writing
@@ -12,6 +12,37 @@
 #include "Common/File/VFS/AssetReader.h"
 
 #ifdef __ANDROID__
+// Not part of the public libzip API, but we always link our own copy. Returns the offset of the entry's
+// data (past the local header) in the archive, or 0 on failure.
+extern "C" zip_uint64_t _zip_file_get_offset(const zip_t *za, zip_uint64_t idx, zip_error_t *error);
+#endif
+
+VFSFileView *AssetReader::OpenAsset(const char *path) {
+	size_t size = 0;
+	uint8_t *data = ReadAsset(path, &size);
+	if (!data)
+		return nullptr;
+	return new HeapFileView(data, size);
+}
+
+bool MappedFileView::Open(const Path &path) {
+	if (!file_.Open(path))
+		return false;
+	data_ = file_.Data();
+	size_ = (size_t)file_.Size();
+	return true;
+}
+
+#ifdef __ANDROID__
+// Points into ZipAssetReader's mapping of the APK, owns nothing.
+class ZipStoredFileView : public VFSFileView {
+public:
+	ZipStoredFileView(const uint8_t *data, size_t size) {
+		data_ = data;
+		size_ = size;
+	}
+};
+
 uint8_t *ReadFromZip(zip *archive, const char* filename, size_t *size) {
 	// Figure out the file size first.
 	struct zip_stat zstat;
@@ -41,6 +72,10 @@ ZipAssetReader::ZipAssetReader(const char *zip_file, const char *in_zip_path) {
 	if (!zip_file_) {
 		ERROR_LOG(IO, "Failed to open %s as a zip file", zip_file);
 	}
+	// Only worth keeping if it's actually mapped, not read into memory.
+	if (apk_.Open(Path(zip_file)) && !apk_.IsMapped()) {
+		apk_.Close();
+	}
 
 	std::vector<File::FileInfo> info;
 	GetFileListing("assets", &info, 0);
@@ -64,6 +99,33 @@ uint8_t *ZipAssetReader::ReadAsset(const char *path, size_t *size) {
 	return ReadFromZip(zip_file_, temp_path, size);
 }
 
+VFSFileView *ZipAssetReader::OpenAsset(const char *path) {
+	char temp_path[1024];
+	strcpy(temp_path, in_zip_path_);
+	strcat(temp_path, path);
+
+	if (apk_.IsOpen() && zip_file_) {
+		zip_int64_t index = zip_name_locate(zip_file_, temp_path, ZIP_FL_NOCASE | ZIP_FL_UNCHANGED);
+		struct zip_stat zstat;
+		if (index >= 0 && zip_stat_index(zip_file_, (zip_uint64_t)index, ZIP_FL_UNCHANGED, &zstat) == 0) {
+			bool stored = (zstat.valid & ZIP_STAT_COMP_METHOD) && zstat.comp_method == ZIP_CM_STORE;
+			bool encrypted = (zstat.valid & ZIP_STAT_ENCRYPTION_METHOD) && zstat.encryption_method != ZIP_EM_NONE;
+			if (stored && !encrypted) {
+				zip_error_t error;
+				zip_error_init(&error);
+				zip_uint64_t offset = _zip_file_get_offset(zip_file_, (zip_uint64_t)index, &error);
+				zip_error_fini(&error);
+				if (offset != 0 && offset + zstat.size <= apk_.Size()) {
+					return new ZipStoredFileView(apk_.Data() + offset, (size_t)zstat.size);
+				}
+			}
+		}
+	}
+
+	// Compressed, so it has to be inflated into a copy.
+	return AssetReader::OpenAsset(path);
+}
+
 bool ZipAssetReader::GetFileListing(const char *orig_path, std::vector<File::FileInfo> *listing, const char *filter = 0) {
 	char path[1024];
 	strcpy(path, in_zip_path_);
@@ -175,6 +237,16 @@ uint8_t *DirectoryAssetReader::ReadAsset(const char *path, size_t *size) {
 	return File::ReadLocalFile(new_path, size);
 }
 
+VFSFileView *DirectoryAssetReader::OpenAsset(const char *path) {
+	Path new_path = Path(path).StartsWith(path_) ? Path(path) : path_ / path;
+	MappedFileView *view = new MappedFileView();
+	if (view->Open(new_path))
+		return view;
+	delete view;
+	// Mapping refuses empty files, for example.
+	return AssetReader::OpenAsset(path);
+}
+
 bool DirectoryAssetReader::GetFileListing(const char *path, std::vector<File::FileInfo> *listing, const char *filter = nullptr) {
 	Path new_path = Path(path).StartsWith(path_) ? Path(path) : path_ / path;
 
@@ -17,12 +17,34 @@ class AssetReader {
 	virtual ~AssetReader() {}
 	// use delete[]
 	virtual uint8_t *ReadAsset(const char *path, size_t *size) = 0;
+	// Mapped where the reader supports it, by default a copy from ReadAsset. Use delete.
+	virtual VFSFileView *OpenAsset(const char *path);
 	// Filter support is optional but nice to have
 	virtual bool GetFileListing(const char *path, std::vector<File::FileInfo> *listing, const char *filter = 0) = 0;
 	virtual bool GetFileInfo(const char *path, File::FileInfo *info) = 0;
 	virtual std::string toString() const = 0;
 };
 
+// Owns a delete[]-able buffer, like the ones ReadAsset returns.
+class HeapFileView : public VFSFileView {
+public:
+	HeapFileView(uint8_t *data, size_t size) {
+		data_ = data;
+		size_ = size;
+	}
+	~HeapFileView() {
+		delete[] data_;
+	}
+};
+
+class MappedFileView : public VFSFileView {
+public:
+	bool Open(const Path &path);
+
+private:
+	File::MappedFile file_;
+};
+
 #ifdef __ANDROID__
 uint8_t *ReadFromZip(zip *archive, const char* filename, size_t *size);
 class ZipAssetReader : public AssetReader {
@@ -31,6 +53,7 @@ class ZipAssetReader : public AssetReader {
 	~ZipAssetReader();
 	// use delete[]
 	virtual uint8_t *ReadAsset(const char *path, size_t *size);
+	virtual VFSFileView *OpenAsset(const char *path);
 	virtual bool GetFileListing(const char *path, std::vector<File::FileInfo> *listing, const char *filter);
 	virtual bool GetFileInfo(const char *path, File::FileInfo *info);
 	virtual std::string toString() const {
@@ -40,6 +63,8 @@ class ZipAssetReader : public AssetReader {
 private:
 	zip *zip_file_;
 	char in_zip_path_[256];
+	// The whole APK, so that stored (uncompressed) entries can be used in place.
+	File::MappedFile apk_;
 };
 #endif
 
@@ -48,6 +73,7 @@ class DirectoryAssetReader : public AssetReader {
 	explicit DirectoryAssetReader(const Path &path);
 	// use delete[]
 	virtual uint8_t *ReadAsset(const char *path, size_t *size);
+	virtual VFSFileView *OpenAsset(const char *path);
 	virtual bool GetFileListing(const char *path, std::vector<File::FileInfo> *listing, const char *filter);
 	virtual bool GetFileInfo(const char *path, File::FileInfo *info);
 	virtual std::string toString() const {
@@ -67,6 +67,36 @@ uint8_t *VFSReadFile(const char *filename, size_t *size) {
 	return 0;
 }
 
+VFSFileView *VFSOpenFile(const char *filename) {
+	if (IsLocalAbsolutePath(filename)) {
+		MappedFileView *view = new MappedFileView();
+		if (view->Open(Path(filename)))
+			return view;
+		delete view;
+		size_t size = 0;
+		uint8_t *data = File::ReadLocalFile(Path(filename), &size);
+		return data ? new HeapFileView(data, size) : nullptr;
+	}
+
+	int fn_len = (int)strlen(filename);
+	bool fileSystemFound = false;
+	for (int i = 0; i < num_entries; i++) {
+		int prefix_len = (int)strlen(entries[i].prefix);
+		if (prefix_len >= fn_len) continue;
+		if (0 == memcmp(filename, entries[i].prefix, prefix_len)) {
+			fileSystemFound = true;
+			VFSFileView *view = entries[i].reader->OpenAsset(filename + prefix_len);
+			if (view)
+				return view;
+			// Else try the other registered file systems.
+		}
+	}
+	if (!fileSystemFound) {
+		ERROR_LOG(IO, "Missing filesystem for '%s'", filename);
+	}
+	return nullptr;
+}
+
 bool VFSGetFileListing(const char *path, std::vector<File::FileInfo> *listing, const char *filter) {
 	if (IsLocalAbsolutePath(path)) {
 		// Local path, not VFS.
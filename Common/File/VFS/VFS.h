@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "Common/File/DirListing.h"
@@ -13,6 +15,24 @@ class AssetReader;
 void VFSRegister(const char *prefix, AssetReader *reader);
 void VFSShutdown();
 
+// Read-only view of a file. Where the reader can, this points straight into a memory mapping
+// (loose files, or assets stored uncompressed in the APK) rather than a heap copy.
+// Unlike VFSReadFile there's no terminating zero. Release with delete.
+class VFSFileView {
+public:
+	virtual ~VFSFileView() {}
+
+	const uint8_t *Data() const { return data_; }
+	size_t Size() const { return size_; }
+
+protected:
+	const uint8_t *data_ = nullptr;
+	size_t size_ = 0;
+};
+
+// Prefer this over VFSReadFile when the data is only needed briefly and read-only.
+VFSFileView *VFSOpenFile(const char *filename);
+
 // Use delete [] to release the returned memory.
 // Always allocates an extra zero byte at the end, so that it
 // can be used for text like shader sources.
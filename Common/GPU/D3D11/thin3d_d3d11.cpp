@@ -12,6 +12,7 @@
 #include "Common/Data/Convert/SmallDataConvert.h"
 #include "Common/Data/Encoding/Utf8.h"
 #include "Common/Log.h"
+#include "Common/StringUtils.h"
 
 #include <map>
 
@@ -194,8 +195,27 @@ class D3D11DrawContext : public DrawContext {
 		return stepId_;
 	}
 
+	std::string GetGpuProfileString() const override {
+		return profileSummary_;
+	}
+
 private:
+	// Timestamps are written at every render target switch, and read back when the slot comes
+	// around again, PROFILE_FRAMES frames later, so we never wait on the GPU.
+	struct ProfileFrame {
+		ID3D11Query *disjoint = nullptr;
+		std::vector<ID3D11Query *> timestamps;
+		std::vector<std::string> descriptions;
+		bool active = false;
+	};
+	enum {
+		PROFILE_FRAMES = 3,
+		MAX_TIMESTAMP_QUERIES = 128,
+	};
+
 	void ApplyCurrentState();
+	void WriteGpuTimestamp(const std::string &description);
+	void ResolveGpuProfile(ProfileFrame &frame);
 
 	ID3D11DepthStencilState *GetCachedDepthStencilState(D3D11DepthStencilState *state, uint8_t stencilWriteMask, uint8_t stencilCompareMask);
 
@@ -260,6 +280,12 @@ class D3D11DrawContext : public DrawContext {
 	D3D_FEATURE_LEVEL featureLevel_;
 	std::string adapterDesc_;
 	std::vector<std::string> deviceList_;
+
+	// GPU profiling
+	ProfileFrame profileFrames_[PROFILE_FRAMES];
+	int curProfileFrame_ = 0;
+	std::string curPassDescription_;
+	std::string profileSummary_;
 };
 
 D3D11DrawContext::D3D11DrawContext(ID3D11Device *device, ID3D11DeviceContext *deviceContext, ID3D11Device1 *device1, ID3D11DeviceContext1 *deviceContext1, D3D_FEATURE_LEVEL featureLevel, HWND hWnd, std::vector<std::string> deviceList)
@@ -352,6 +378,13 @@ D3D11DrawContext::~D3D11DrawContext() {
 	upBuffer_->Release();
 	packTexture_->Release();
 
+	for (ProfileFrame &frame : profileFrames_) {
+		if (frame.disjoint)
+			frame.disjoint->Release();
+		for (ID3D11Query *query : frame.timestamps)
+			query->Release();
+	}
+
 	// Release references.
 	ID3D11RenderTargetView *view = nullptr;
 	context_->OMSetRenderTargets(1, &view, nullptr);
@@ -425,6 +458,59 @@ void D3D11DrawContext::HandleEvent(Event ev, int width, int height, void *param1
 
 void D3D11DrawContext::EndFrame() {
 	curPipeline_ = nullptr;
+
+	ProfileFrame &frame = profileFrames_[curProfileFrame_];
+	if (frame.active) {
+		WriteGpuTimestamp(curPassDescription_);
+		context_->End(frame.disjoint);
+		curProfileFrame_ = (curProfileFrame_ + 1) % PROFILE_FRAMES;
+	}
+}
+
+void D3D11DrawContext::WriteGpuTimestamp(const std::string &description) {
+	ProfileFrame &frame = profileFrames_[curProfileFrame_];
+	size_t index = frame.descriptions.size();
+	if (description.empty() || index >= MAX_TIMESTAMP_QUERIES)
+		return;
+	if (index >= frame.timestamps.size()) {
+		D3D11_QUERY_DESC desc{ D3D11_QUERY_TIMESTAMP, 0 };
+		ID3D11Query *query = nullptr;
+		if (FAILED(device_->CreateQuery(&desc, &query)))
+			return;
+		frame.timestamps.push_back(query);
+	}
+	context_->End(frame.timestamps[index]);
+	frame.descriptions.push_back(description);
+}
+
+void D3D11DrawContext::ResolveGpuProfile(ProfileFrame &frame) {
+	frame.active = false;
+
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint{};
+	if (context_->GetData(frame.disjoint, &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+		profileSummary_ = "(error getting GPU profile - not ready?)";
+		return;
+	}
+	if (disjoint.Disjoint || disjoint.Frequency == 0) {
+		profileSummary_ = "(GPU timestamps disjoint, skipped)";
+		return;
+	}
+
+	size_t count = frame.descriptions.size();
+	std::vector<UINT64> times(count);
+	for (size_t i = 0; i < count; i++) {
+		if (context_->GetData(frame.timestamps[i], &times[i], sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+			profileSummary_ = "(error getting GPU profile - not ready?)";
+			return;
+		}
+	}
+
+	double msPerTick = 1000.0 / (double)disjoint.Frequency;
+	std::string str = StringFromFormat("Total GPU time: %0.3f ms\n", (double)(times[count - 1] - times[0]) * msPerTick);
+	for (size_t i = 1; i < count; i++) {
+		str += StringFromFormat("%s: %0.3f ms\n", frame.descriptions[i].c_str(), (double)(times[i] - times[i - 1]) * msPerTick);
+	}
+	profileSummary_ = str;
 }
 
 void D3D11DrawContext::SetViewports(int count, Viewport *viewports) {
@@ -1436,6 +1522,23 @@ void D3D11DrawContext::Clear(int mask, uint32_t colorval, float depthVal, int st
 void D3D11DrawContext::BeginFrame() {
 	context_->OMSetRenderTargets(1, &curRenderTargetView_, curDepthStencilView_);
 
+	ProfileFrame &frame = profileFrames_[curProfileFrame_];
+	if (frame.active)
+		ResolveGpuProfile(frame);
+	if (gpuProfilingEnabled_) {
+		if (!frame.disjoint) {
+			D3D11_QUERY_DESC desc{ D3D11_QUERY_TIMESTAMP_DISJOINT, 0 };
+			device_->CreateQuery(&desc, &frame.disjoint);
+		}
+		if (frame.disjoint) {
+			context_->Begin(frame.disjoint);
+			frame.active = true;
+			frame.descriptions.clear();
+			curPassDescription_.clear();
+			WriteGpuTimestamp("Begin");
+		}
+	}
+
 	if (curBlend_ != nullptr) {
 		context_->OMSetBlendState(curBlend_->bs, blendFactor_, 0xFFFFFFFF);
 	}
@@ -1639,6 +1742,12 @@ bool D3D11DrawContext::CopyFramebufferToMemorySync(Framebuffer *src, int channel
 }
 
 void D3D11DrawContext::BindFramebufferAsRenderTarget(Framebuffer *fbo, const RenderPassInfo &rp, const char *tag) {
+	bool profiling = profileFrames_[curProfileFrame_].active;
+	if (profiling) {
+		// Ends the previous pass. Copies between passes get counted towards it.
+		WriteGpuTimestamp(curPassDescription_);
+	}
+
 	// TODO: deviceContext1 can actually discard. Useful on Windows Mobile.
 	if (fbo) {
 		D3D11Framebuffer *fb = (D3D11Framebuffer *)fbo;
@@ -1681,6 +1790,10 @@ void D3D11DrawContext::BindFramebufferAsRenderTarget(Framebuffer *fbo, const Ren
 		context_->ClearDepthStencilView(curDepthStencilView_, mask, rp.clearDepth, rp.clearStencil);
 	}
 
+	if (profiling) {
+		curPassDescription_ = StringFromFormat("RENDER %s (%dx%d%s)", tag ? tag : "", curRTWidth_, curRTHeight_, fbo ? "" : ", backbuffer");
+	}
+
 	stepId_++;
 }
 
@@ -53,8 +53,8 @@ LPD3DBLOB CompileShaderToByteCodeD3D9(const char *code, const char *target, std:
 	return pShaderCode;
 }
 
-bool CompilePixelShaderD3D9(LPDIRECT3DDEVICE9 device, const char *code, LPDIRECT3DPIXELSHADER9 *pShader, std::string *errorMessage) {
-	LPD3DBLOB pShaderCode = CompileShaderToByteCodeD3D9(code, "ps_2_0", errorMessage);
+bool CompilePixelShaderD3D9(LPDIRECT3DDEVICE9 device, const char *code, LPDIRECT3DPIXELSHADER9 *pShader, std::string *errorMessage, bool shaderModel3) {
+	LPD3DBLOB pShaderCode = CompileShaderToByteCodeD3D9(code, shaderModel3 ? "ps_3_0" : "ps_2_0", errorMessage);
 	if (pShaderCode) {
 		// Create pixel shader.
 		device->CreatePixelShader((DWORD*)pShaderCode->GetBufferPointer(), pShader);
@@ -65,8 +65,8 @@ bool CompilePixelShaderD3D9(LPDIRECT3DDEVICE9 device, const char *code, LPDIRECT
 	}
 }
 
-bool CompileVertexShaderD3D9(LPDIRECT3DDEVICE9 device, const char *code, LPDIRECT3DVERTEXSHADER9 *pShader, std::string *errorMessage) {
-	LPD3DBLOB pShaderCode = CompileShaderToByteCodeD3D9(code, "vs_2_0", errorMessage);
+bool CompileVertexShaderD3D9(LPDIRECT3DDEVICE9 device, const char *code, LPDIRECT3DVERTEXSHADER9 *pShader, std::string *errorMessage, bool shaderModel3) {
+	LPD3DBLOB pShaderCode = CompileShaderToByteCodeD3D9(code, shaderModel3 ? "vs_3_0" : "vs_2_0", errorMessage);
 	if (pShaderCode) {
 		// Create vertex shader.
 		device->CreateVertexShader((DWORD*)pShaderCode->GetBufferPointer(), pShader);
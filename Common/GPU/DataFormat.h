@@ -68,6 +68,12 @@ enum class DataFormat : uint8_t {
 	D32F_S8,
 };
 
+enum class ReadbackMode {
+	BLOCK,
+	// The backend may return the result of the same readback from a few frames ago, instead of stalling.
+	OLD_DATA_OK,
+};
+
 size_t DataFormatSizeInBytes(DataFormat fmt);
 bool DataFormatIsDepthStencil(DataFormat fmt);
 inline bool DataFormatIsColor(DataFormat fmt) {
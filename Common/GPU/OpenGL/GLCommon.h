@@ -58,6 +58,26 @@ typedef void (EGLAPIENTRYP PFNGLBLITFRAMEBUFFERNVPROC) (
 #endif
 extern PFNGLBLITFRAMEBUFFERNVPROC glBlitFramebufferNV;
 
+// EXT_disjoint_timer_query, for GPU profiling.
+extern void (GL_APIENTRYP glGenQueriesEXT) (GLsizei n, GLuint *ids);
+extern void (GL_APIENTRYP glDeleteQueriesEXT) (GLsizei n, const GLuint *ids);
+extern void (GL_APIENTRYP glQueryCounterEXT) (GLuint id, GLenum target);
+extern void (GL_APIENTRYP glGetQueryObjectivEXT) (GLuint id, GLenum pname, GLint *params);
+extern void (GL_APIENTRYP glGetQueryObjectui64vEXT) (GLuint id, GLenum pname, uint64_t *params);
+
+#ifndef GL_QUERY_RESULT_EXT
+#define GL_QUERY_RESULT_EXT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE_EXT
+#define GL_QUERY_RESULT_AVAILABLE_EXT 0x8867
+#endif
+#ifndef GL_TIMESTAMP_EXT
+#define GL_TIMESTAMP_EXT 0x8E28
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
 #if PPSSPP_PLATFORM(IOS)
 extern PFNGLDISCARDFRAMEBUFFEREXTPROC glDiscardFramebufferEXT;
 extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOES;
@@ -4,6 +4,7 @@
 #include <set>
 
 #include "Common/StringUtils.h"
+#include "Common/Data/Hash/Hash.h"
 
 #if PPSSPP_API(ANY_GL)
 #include "Common/GPU/OpenGL/GLCommon.h"
@@ -25,6 +26,12 @@ PFNGLDRAWTEXTURENVPROC glDrawTextureNV;
 PFNGLBLITFRAMEBUFFERNVPROC glBlitFramebufferNV;
 PFNGLMAPBUFFERPROC glMapBuffer;
 
+void (GL_APIENTRYP glGenQueriesEXT) (GLsizei n, GLuint *ids);
+void (GL_APIENTRYP glDeleteQueriesEXT) (GLsizei n, const GLuint *ids);
+void (GL_APIENTRYP glQueryCounterEXT) (GLuint id, GLenum target);
+void (GL_APIENTRYP glGetQueryObjectivEXT) (GLuint id, GLenum pname, GLint *params);
+void (GL_APIENTRYP glGetQueryObjectui64vEXT) (GLuint id, GLenum pname, uint64_t *params);
+
 PFNGLDISCARDFRAMEBUFFEREXTPROC glDiscardFramebufferEXT;
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOES;
 PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOES;
@@ -367,9 +374,12 @@ void CheckGLExtensions() {
 	gl_extensions.EXT_draw_instanced = g_set_gl_extensions.count("GL_EXT_draw_instanced") != 0;
 	gl_extensions.ARB_draw_instanced = g_set_gl_extensions.count("GL_ARB_draw_instanced") != 0;
 	gl_extensions.ARB_cull_distance = g_set_gl_extensions.count("GL_ARB_cull_distance") != 0;
+	gl_extensions.ARB_shader_stencil_export = g_set_gl_extensions.count("GL_ARB_shader_stencil_export") != 0;
 	gl_extensions.ARB_depth_clamp = g_set_gl_extensions.count("GL_ARB_depth_clamp") != 0;
 	gl_extensions.ARB_uniform_buffer_object = g_set_gl_extensions.count("GL_ARB_uniform_buffer_object") != 0;
+	gl_extensions.ARB_timer_query = g_set_gl_extensions.count("GL_ARB_timer_query") != 0;
 	gl_extensions.ARB_explicit_attrib_location = g_set_gl_extensions.count("GL_ARB_explicit_attrib_location") != 0;
+	gl_extensions.ARB_get_program_binary = g_set_gl_extensions.count("GL_ARB_get_program_binary") != 0;
 
 	if (gl_extensions.IsGLES) {
 		gl_extensions.EXT_blend_func_extended = g_set_gl_extensions.count("GL_EXT_blend_func_extended") != 0;
@@ -423,9 +433,20 @@ void CheckGLExtensions() {
 		if (gl_extensions.EXT_discard_framebuffer) {
 			glDiscardFramebufferEXT = (PFNGLDISCARDFRAMEBUFFEREXTPROC)eglGetProcAddress("glDiscardFramebufferEXT");
 		}
+
+		gl_extensions.EXT_disjoint_timer_query = g_set_gl_extensions.count("GL_EXT_disjoint_timer_query") != 0;
+		if (gl_extensions.EXT_disjoint_timer_query) {
+			glGenQueriesEXT = (decltype(glGenQueriesEXT))eglGetProcAddress("glGenQueriesEXT");
+			glDeleteQueriesEXT = (decltype(glDeleteQueriesEXT))eglGetProcAddress("glDeleteQueriesEXT");
+			glQueryCounterEXT = (decltype(glQueryCounterEXT))eglGetProcAddress("glQueryCounterEXT");
+			glGetQueryObjectivEXT = (decltype(glGetQueryObjectivEXT))eglGetProcAddress("glGetQueryObjectivEXT");
+			glGetQueryObjectui64vEXT = (decltype(glGetQueryObjectui64vEXT))eglGetProcAddress("glGetQueryObjectui64vEXT");
+			gl_extensions.EXT_disjoint_timer_query = glGenQueriesEXT && glDeleteQueriesEXT && glQueryCounterEXT && glGetQueryObjectivEXT && glGetQueryObjectui64vEXT;
+		}
 #else
 		gl_extensions.OES_vertex_array_object = false;
 		gl_extensions.EXT_discard_framebuffer = false;
+		gl_extensions.EXT_disjoint_timer_query = false;
 #endif
 	} else {
 		gl_extensions.ARB_blend_func_extended = g_set_gl_extensions.count("GL_ARB_blend_func_extended") != 0;
@@ -528,12 +549,13 @@ void CheckGLExtensions() {
 		if (gl_extensions.VersionGEThan(3, 3)) {
 			gl_extensions.ARB_blend_func_extended = true;
 			gl_extensions.ARB_explicit_attrib_location = true;
+			gl_extensions.ARB_timer_query = true;
 		}
 		if (gl_extensions.VersionGEThan(4, 0)) {
 			// ARB_gpu_shader5 = true;
 		}
 		if (gl_extensions.VersionGEThan(4, 1)) {
-			// ARB_get_program_binary = true;
+			gl_extensions.ARB_get_program_binary = true;
 			// ARB_separate_shader_objects = true;
 			// ARB_shader_precision = true;
 			// ARB_viewport_array = true;
@@ -560,6 +582,20 @@ void CheckGLExtensions() {
 		}
 	}
 
+	if (gl_extensions.IsGLES && gl_extensions.GLES3) {
+		gl_extensions.ARB_get_program_binary = true;
+	}
+	if (gl_extensions.ARB_get_program_binary) {
+		// Drivers are allowed to support the API without any actual formats.
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		gl_extensions.ARB_get_program_binary = numFormats > 0;
+	}
+
+	// Binaries are only valid for the exact same driver, so remember which one this is.
+	std::string driverDesc = StringFromFormat("%s|%s|%s", cvendor ? cvendor : "", renderer ? renderer : "", versionStr ? versionStr : "");
+	gl_extensions.driverHash = hash::Adler32((const uint8_t *)driverDesc.data(), driverDesc.size());
+
 	ProcessGPUFeatures();
 
 	int error = glGetError();
@@ -37,6 +37,7 @@ struct GLExtensions {
 	int gpuVendor;
 	char model[128];
 	int modelNumber;
+	uint32_t driverHash;  // Of the vendor, renderer and version strings, to validate program binaries.
 
 	bool IsGLES;
 	bool IsCoreContext;
@@ -68,8 +69,11 @@ struct GLExtensions {
 	bool ARB_draw_instanced;
 	bool ARB_buffer_storage;
 	bool ARB_cull_distance;
+	bool ARB_shader_stencil_export;
 	bool ARB_depth_clamp;
 	bool ARB_uniform_buffer_object;
+	bool ARB_get_program_binary;  // Also set on ES3, where it's core.
+	bool ARB_timer_query;  // Core in GL 3.3.
 
 	// EXT
 	bool EXT_swap_control_tear;
@@ -86,6 +90,7 @@ struct GLExtensions {
 	bool EXT_draw_instanced;
 	bool EXT_buffer_storage;
 	bool EXT_clip_cull_distance;
+	bool EXT_disjoint_timer_query;
 
 	// NV
 	bool NV_copy_image;
@@ -10,6 +10,7 @@
 #include "Common/Log.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 #include "Common/Data/Convert/SmallDataConvert.h"
 
 #include "Core/Reporting.h"
@@ -25,6 +26,55 @@
 #endif
 
 static constexpr int TEXCACHE_NAME_CACHE_SIZE = 16;
+static constexpr int MAX_TIMESTAMP_QUERIES = 128;
+
+// Timestamp queries are core in desktop GL 3.3, but only an extension on GLES.
+static void GenQueries(int count, GLuint *queries) {
+#if !defined(USING_GLES2)
+	glGenQueries(count, queries);
+#elif defined(__ANDROID__)
+	glGenQueriesEXT(count, queries);
+#endif
+}
+
+static void DeleteQueries(int count, const GLuint *queries) {
+#if !defined(USING_GLES2)
+	glDeleteQueries(count, queries);
+#elif defined(__ANDROID__)
+	glDeleteQueriesEXT(count, queries);
+#endif
+}
+
+static void WriteTimestamp(GLuint query) {
+#if !defined(USING_GLES2)
+	glQueryCounter(query, GL_TIMESTAMP);
+#elif defined(__ANDROID__)
+	glQueryCounterEXT(query, GL_TIMESTAMP_EXT);
+#endif
+}
+
+static bool IsTimestampAvailable(GLuint query) {
+	GLint available = 0;
+#if !defined(USING_GLES2)
+	glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+#elif defined(__ANDROID__)
+	glGetQueryObjectivEXT(query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+#endif
+	return available != 0;
+}
+
+// In nanoseconds.
+static uint64_t GetTimestamp(GLuint query) {
+	uint64_t result = 0;
+#if !defined(USING_GLES2)
+	GLuint64 value = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &value);
+	result = value;
+#elif defined(__ANDROID__)
+	glGetQueryObjectui64vEXT(query, GL_QUERY_RESULT_EXT, &result);
+#endif
+	return result;
+}
 
 #if PPSSPP_PLATFORM(IOS)
 extern void bindDefaultFBO();
@@ -194,68 +244,100 @@ void GLQueueRunner::RunInitSteps(const std::vector<GLRInitStep> &steps, bool ski
 			CHECK_GL_ERROR_IF_DEBUG();
 			GLRProgram *program = step.create_program.program;
 			program->program = glCreateProgram();
-			_assert_msg_(step.create_program.num_shaders > 0, "Can't create a program with zero shaders");
-			bool anyFailed = false;
-			for (int j = 0; j < step.create_program.num_shaders; j++) {
-				_dbg_assert_msg_(step.create_program.shaders[j]->shader, "Can't create a program with a null shader");
-				anyFailed = anyFailed || step.create_program.shaders[j]->failed;
-				glAttachShader(program->program, step.create_program.shaders[j]->shader);
+			bool linkedFromBinary = false;
+			if (!program->binary.empty() && gl_extensions.ARB_get_program_binary) {
+				glProgramBinary(program->program, program->binaryFormat, program->binary.data(), (GLsizei)program->binary.size());
+				GLint linkStatus = GL_FALSE;
+				glGetProgramiv(program->program, GL_LINK_STATUS, &linkStatus);
+				if (linkStatus == GL_TRUE) {
+					linkedFromBinary = true;
+				} else {
+					// Stale or rejected by the driver, just link from source as usual.
+					WARN_LOG(G3D, "Program binary rejected by driver, relinking");
+					glDeleteProgram(program->program);
+					program->program = glCreateProgram();
+					program->binary.clear();
+				}
 			}
 
-			for (auto iter : program->semantics_) {
-				glBindAttribLocation(program->program, iter.location, iter.attrib);
-			}
+			if (!linkedFromBinary) {
+				_assert_msg_(step.create_program.num_shaders > 0, "Can't create a program with zero shaders");
+				bool anyFailed = false;
+				for (int j = 0; j < step.create_program.num_shaders; j++) {
+					_dbg_assert_msg_(step.create_program.shaders[j]->shader, "Can't create a program with a null shader");
+					anyFailed = anyFailed || step.create_program.shaders[j]->failed;
+					glAttachShader(program->program, step.create_program.shaders[j]->shader);
+				}
+
+				for (auto iter : program->semantics_) {
+					glBindAttribLocation(program->program, iter.location, iter.attrib);
+				}
 
 #if !defined(USING_GLES2)
-			if (step.create_program.support_dual_source) {
-				_dbg_assert_msg_(gl_extensions.ARB_blend_func_extended, "ARB_blend_func_extended required for dual src");
-				// Dual source alpha
-				glBindFragDataLocationIndexed(program->program, 0, 0, "fragColor0");
-				glBindFragDataLocationIndexed(program->program, 0, 1, "fragColor1");
-			} else if (gl_extensions.VersionGEThan(3, 0, 0)) {
-				glBindFragDataLocation(program->program, 0, "fragColor0");
-			}
+				if (step.create_program.support_dual_source) {
+					_dbg_assert_msg_(gl_extensions.ARB_blend_func_extended, "ARB_blend_func_extended required for dual src");
+					// Dual source alpha
+					glBindFragDataLocationIndexed(program->program, 0, 0, "fragColor0");
+					glBindFragDataLocationIndexed(program->program, 0, 1, "fragColor1");
+				} else if (gl_extensions.VersionGEThan(3, 0, 0)) {
+					glBindFragDataLocation(program->program, 0, "fragColor0");
+				}
 #elif !PPSSPP_PLATFORM(IOS)
-			if (gl_extensions.GLES3 && step.create_program.support_dual_source) {
-				// For GLES2, we use gl_SecondaryFragColorEXT as fragColor1.
-				_dbg_assert_msg_(gl_extensions.EXT_blend_func_extended, "EXT_blend_func_extended required for dual src");
-				glBindFragDataLocationIndexedEXT(program->program, 0, 0, "fragColor0");
-				glBindFragDataLocationIndexedEXT(program->program, 0, 1, "fragColor1");
-			}
+				if (gl_extensions.GLES3 && step.create_program.support_dual_source) {
+					// For GLES2, we use gl_SecondaryFragColorEXT as fragColor1.
+					_dbg_assert_msg_(gl_extensions.EXT_blend_func_extended, "EXT_blend_func_extended required for dual src");
+					glBindFragDataLocationIndexedEXT(program->program, 0, 0, "fragColor0");
+					glBindFragDataLocationIndexedEXT(program->program, 0, 1, "fragColor1");
+				}
 #endif
-			glLinkProgram(program->program);
-
-			GLint linkStatus = GL_FALSE;
-			glGetProgramiv(program->program, GL_LINK_STATUS, &linkStatus);
-			if (linkStatus != GL_TRUE) {
-				std::string infoLog = GetInfoLog(program->program, glGetProgramiv, glGetProgramInfoLog);
-
-				// TODO: Could be other than vs/fs.  Also, we're assuming order here...
-				GLRShader *vs = step.create_program.shaders[0];
-				GLRShader *fs = step.create_program.num_shaders > 1 ? step.create_program.shaders[1] : nullptr;
-				std::string vsDesc = vs->desc + (vs->failed ? " (failed)" : "");
-				std::string fsDesc = fs ? (fs->desc + (fs->failed ? " (failed)" : "")) : "(none)";
-				const char *vsCode = vs->code.c_str();
-				const char *fsCode = fs ? fs->code.c_str() : "(none)";
-				if (!anyFailed)
-					Reporting::ReportMessage("Error in shader program link: info: %s\nfs: %s\n%s\nvs: %s\n%s", infoLog.c_str(), fsDesc.c_str(), fsCode, vsDesc.c_str(), vsCode);
-
-				ERROR_LOG(G3D, "Could not link program:\n %s", infoLog.c_str());
-				ERROR_LOG(G3D, "VS desc:\n%s", vsDesc.c_str());
-				ERROR_LOG(G3D, "FS desc:\n%s", fsDesc.c_str());
-				ERROR_LOG(G3D, "VS:\n%s\n", vsCode);
-				ERROR_LOG(G3D, "FS:\n%s\n", fsCode);
+				if (program->wantBinary && gl_extensions.ARB_get_program_binary) {
+					glProgramParameteri(program->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+				}
+				glLinkProgram(program->program);
+
+				GLint linkStatus = GL_FALSE;
+				glGetProgramiv(program->program, GL_LINK_STATUS, &linkStatus);
+				if (linkStatus != GL_TRUE) {
+					std::string infoLog = GetInfoLog(program->program, glGetProgramiv, glGetProgramInfoLog);
+
+					// TODO: Could be other than vs/fs.  Also, we're assuming order here...
+					GLRShader *vs = step.create_program.shaders[0];
+					GLRShader *fs = step.create_program.num_shaders > 1 ? step.create_program.shaders[1] : nullptr;
+					std::string vsDesc = vs->desc + (vs->failed ? " (failed)" : "");
+					std::string fsDesc = fs ? (fs->desc + (fs->failed ? " (failed)" : "")) : "(none)";
+					const char *vsCode = vs->code.c_str();
+					const char *fsCode = fs ? fs->code.c_str() : "(none)";
+					if (!anyFailed)
+						Reporting::ReportMessage("Error in shader program link: info: %s\nfs: %s\n%s\nvs: %s\n%s", infoLog.c_str(), fsDesc.c_str(), fsCode, vsDesc.c_str(), vsCode);
+
+					ERROR_LOG(G3D, "Could not link program:\n %s", infoLog.c_str());
+					ERROR_LOG(G3D, "VS desc:\n%s", vsDesc.c_str());
+					ERROR_LOG(G3D, "FS desc:\n%s", fsDesc.c_str());
+					ERROR_LOG(G3D, "VS:\n%s\n", vsCode);
+					ERROR_LOG(G3D, "FS:\n%s\n", fsCode);
 
 #ifdef _WIN32
-				OutputDebugStringUTF8(infoLog.c_str());
-				if (vsCode)
-					OutputDebugStringUTF8(LineNumberString(vsCode).c_str());
-				if (fsCode)
-					OutputDebugStringUTF8(LineNumberString(fsCode).c_str());
+					OutputDebugStringUTF8(infoLog.c_str());
+					if (vsCode)
+						OutputDebugStringUTF8(LineNumberString(vsCode).c_str());
+					if (fsCode)
+						OutputDebugStringUTF8(LineNumberString(fsCode).c_str());
 #endif
-				CHECK_GL_ERROR_IF_DEBUG();
-				break;
+					CHECK_GL_ERROR_IF_DEBUG();
+					break;
+				}
+				if (program->wantBinary && gl_extensions.ARB_get_program_binary) {
+					GLint length = 0;
+					glGetProgramiv(program->program, GL_PROGRAM_BINARY_LENGTH, &length);
+					if (length > 0) {
+						program->binary.resize(length);
+						GLsizei written = 0;
+						glGetProgramBinary(program->program, length, &written, &program->binaryFormat, program->binary.data());
+						program->binary.resize(written);
+					}
+				}
 			}
+			program->binaryReady = true;
 
 			glUseProgram(program->program);
 
@@ -609,7 +691,7 @@ void GLQueueRunner::InitCreateFramebuffer(const GLRInitStep &step) {
 	currentReadHandle_ = fbo->handle;
 }
 
-void GLQueueRunner::RunSteps(const std::vector<GLRStep *> &steps, bool skipGLCalls) {
+void GLQueueRunner::RunSteps(const std::vector<GLRStep *> &steps, bool skipGLCalls, GLQueueProfileContext *profile) {
 	if (skipGLCalls) {
 		// Dry run
 		for (size_t i = 0; i < steps.size(); i++) {
@@ -665,6 +747,7 @@ void GLQueueRunner::RunSteps(const std::vector<GLRStep *> &steps, bool skipGLCal
 		switch (step.stepType) {
 		case GLRStepType::RENDER:
 			renderCount++;
+			OptimizeRenderPass(*steps[i]);
 			PerformRenderPass(step, renderCount == 1, renderCount == totalRenderCount);
 			break;
 		case GLRStepType::COPY:
@@ -691,6 +774,11 @@ void GLQueueRunner::RunSteps(const std::vector<GLRStep *> &steps, bool skipGLCal
 			glPopDebugGroup();
 #endif
 
+		if (profile && step.stepType != GLRStepType::RENDER_SKIP && profile->timestampDescriptions.size() < profile->queries.size()) {
+			WriteTimestamp(profile->queries[profile->timestampDescriptions.size()]);
+			profile->timestampDescriptions.push_back(StepToString(step));
+		}
+
 		delete steps[i];
 	}
 	CHECK_GL_ERROR_IF_DEBUG();
@@ -700,6 +788,106 @@ void GLQueueRunner::LogSteps(const std::vector<GLRStep *> &steps) {
 
 }
 
+std::string GLQueueRunner::StepToString(const GLRStep &step) const {
+	char buffer[256];
+	switch (step.stepType) {
+	case GLRStepType::RENDER:
+		if (step.render.framebuffer) {
+			snprintf(buffer, sizeof(buffer), "RENDER %s (draws: %d, %dx%d)", step.tag, step.render.numDraws, step.render.framebuffer->width, step.render.framebuffer->height);
+		} else {
+			snprintf(buffer, sizeof(buffer), "RENDER %s (draws: %d, backbuffer)", step.tag, step.render.numDraws);
+		}
+		break;
+	case GLRStepType::COPY:
+		snprintf(buffer, sizeof(buffer), "COPY '%s' (%dx%d)", step.tag, step.copy.srcRect.w, step.copy.srcRect.h);
+		break;
+	case GLRStepType::BLIT:
+		snprintf(buffer, sizeof(buffer), "BLIT '%s' (%dx%d->%dx%d)", step.tag, step.blit.srcRect.w, step.blit.srcRect.h, step.blit.dstRect.w, step.blit.dstRect.h);
+		break;
+	case GLRStepType::READBACK:
+		snprintf(buffer, sizeof(buffer), "READBACK '%s' (%dx%d)", step.tag, step.readback.srcRect.w, step.readback.srcRect.h);
+		break;
+	case GLRStepType::READBACK_IMAGE:
+		snprintf(buffer, sizeof(buffer), "READBACK_IMAGE '%s' (%dx%d)", step.tag, step.readback_image.srcRect.w, step.readback_image.srcRect.h);
+		break;
+	case GLRStepType::RENDER_SKIP:
+		snprintf(buffer, sizeof(buffer), "(RENDER_SKIP) %s", step.tag);
+		break;
+	default:
+		buffer[0] = 0;
+		break;
+	}
+	return std::string(buffer);
+}
+
+bool GLQueueRunner::SupportsTimestamps() const {
+#if !defined(USING_GLES2)
+	return gl_extensions.ARB_timer_query;
+#elif defined(__ANDROID__)
+	return gl_extensions.EXT_disjoint_timer_query;
+#else
+	return false;
+#endif
+}
+
+bool GLQueueRunner::BeginProfile(GLQueueProfileContext *profile, std::string *summary) {
+	bool resolved = false;
+	size_t numQueries = profile->timestampDescriptions.size();
+	if (numQueries != 0) {
+		bool disjoint = false;
+#if defined(USING_GLES2) && defined(__ANDROID__)
+		// Something like a frequency change happened, the results can't be trusted. Also resets the flag.
+		GLint disjointFlag = 0;
+		glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjointFlag);
+		disjoint = disjointFlag != 0;
+#endif
+		if (disjoint) {
+			*summary = "(GPU timestamps disjoint, skipped)";
+		} else if (!IsTimestampAvailable(profile->queries[numQueries - 1])) {
+			*summary = "(error getting GPU profile - not ready?)";
+		} else {
+			std::string str;
+			char line[1024];
+			uint64_t first = GetTimestamp(profile->queries[0]);
+			uint64_t last = GetTimestamp(profile->queries[numQueries - 1]);
+			snprintf(line, sizeof(line), "Total GPU time: %0.3f ms\n", (double)(last - first) / 1000000.0);
+			str += line;
+			snprintf(line, sizeof(line), "Render CPU time: %0.3f ms\n", (profile->cpuEndTime - profile->cpuStartTime) * 1000.0);
+			str += line;
+			uint64_t prev = first;
+			for (size_t i = 1; i < numQueries; i++) {
+				uint64_t timestamp = GetTimestamp(profile->queries[i]);
+				snprintf(line, sizeof(line), "%s: %0.3f ms\n", profile->timestampDescriptions[i].c_str(), (double)(timestamp - prev) / 1000000.0);
+				str += line;
+				prev = timestamp;
+			}
+			*summary = str;
+		}
+		profile->timestampDescriptions.clear();
+		resolved = true;
+	}
+
+	if (profile->enabled) {
+		if (profile->queries.empty()) {
+			profile->queries.resize(MAX_TIMESTAMP_QUERIES);
+			GenQueries(MAX_TIMESTAMP_QUERIES, profile->queries.data());
+		}
+		WriteTimestamp(profile->queries[0]);
+		profile->timestampDescriptions.push_back("Begin");
+		profile->cpuStartTime = time_now_d();
+		profile->cpuEndTime = profile->cpuStartTime;
+	}
+	return resolved;
+}
+
+void GLQueueRunner::DestroyProfile(GLQueueProfileContext *profile, bool skipGLCalls) {
+	if (!profile->queries.empty() && !skipGLCalls) {
+		DeleteQueries((int)profile->queries.size(), profile->queries.data());
+	}
+	profile->queries.clear();
+	profile->timestampDescriptions.clear();
+}
+
 
 void GLQueueRunner::PerformBlit(const GLRStep &step) {
 	CHECK_GL_ERROR_IF_DEBUG();
@@ -730,6 +918,121 @@ void GLQueueRunner::PerformBlit(const GLRStep &step) {
 	}
 }
 
+static bool IsMergeablePrimitive(GLenum mode) {
+	// Strips and fans can't just be concatenated.
+	return mode == GL_TRIANGLES || mode == GL_LINES || mode == GL_POINTS;
+}
+
+static int IndexTypeSize(GLint indexType) {
+	switch (indexType) {
+	case GL_UNSIGNED_BYTE: return 1;
+	case GL_UNSIGNED_SHORT: return 2;
+	default: return 4;
+	}
+}
+
+static bool SameUniform(const GLRRenderData &a, const GLRRenderData &b) {
+	const char *nameA = a.cmd == GLRRenderCommand::UNIFORMMATRIX ? a.uniformMatrix4.name : a.uniform4.name;
+	const char *nameB = b.cmd == GLRRenderCommand::UNIFORMMATRIX ? b.uniformMatrix4.name : b.uniform4.name;
+	const GLint *locA = a.cmd == GLRRenderCommand::UNIFORMMATRIX ? a.uniformMatrix4.loc : a.uniform4.loc;
+	const GLint *locB = b.cmd == GLRRenderCommand::UNIFORMMATRIX ? b.uniformMatrix4.loc : b.uniform4.loc;
+	return nameA == nameB && locA == locB;
+}
+
+// Compacts the command list before it's replayed. Between two draws only the last write to a
+// uniform matters, so earlier writes are overwritten in place, and back-to-back draws of
+// contiguous ranges with nothing in between are merged into one.
+void GLQueueRunner::OptimizeRenderPass(GLRStep &step) {
+	auto &commands = step.commands;
+
+	// Output positions of the uniform writes since the last draw or program change.
+	size_t pendingUniforms[32];
+	int numPendingUniforms = 0;
+
+	size_t out = 0;
+	for (size_t i = 0; i < commands.size(); i++) {
+		const GLRRenderData &c = commands[i];
+		switch (c.cmd) {
+		case GLRRenderCommand::UNIFORM4F:
+		case GLRRenderCommand::UNIFORM4UI:
+		case GLRRenderCommand::UNIFORM4I:
+		case GLRRenderCommand::UNIFORMMATRIX:
+		{
+			int match = -1;
+			for (int j = 0; j < numPendingUniforms; j++) {
+				if (SameUniform(commands[pendingUniforms[j]], c)) {
+					match = j;
+					break;
+				}
+			}
+			if (match >= 0) {
+				GLRRenderData &prev = commands[pendingUniforms[match]];
+				if (prev.cmd == c.cmd && (c.cmd == GLRRenderCommand::UNIFORMMATRIX || prev.uniform4.count == c.uniform4.count)) {
+					prev = c;
+					stats_.mergedCommands++;
+					continue;
+				}
+				// A different kind of write to the same uniform. Just keep the order from here on.
+				numPendingUniforms = 0;
+			}
+			if (numPendingUniforms < (int)ARRAY_SIZE(pendingUniforms)) {
+				pendingUniforms[numPendingUniforms++] = out;
+			}
+			break;
+		}
+		case GLRRenderCommand::BINDPROGRAM:
+			// Named uniforms resolve against the current program, so don't merge across this.
+			numPendingUniforms = 0;
+			break;
+		case GLRRenderCommand::DRAW:
+			numPendingUniforms = 0;
+			if (out > 0) {
+				GLRRenderData &prev = commands[out - 1];
+				if (prev.cmd == GLRRenderCommand::DRAW && prev.draw.mode == c.draw.mode && IsMergeablePrimitive(c.draw.mode) && prev.draw.first + prev.draw.count == c.draw.first) {
+					prev.draw.count += c.draw.count;
+					stats_.mergedCommands++;
+					continue;
+				}
+			}
+			break;
+		case GLRRenderCommand::DRAW_INDEXED:
+			numPendingUniforms = 0;
+			if (out > 0) {
+				GLRRenderData &prev = commands[out - 1];
+				if (prev.cmd == GLRRenderCommand::DRAW_INDEXED && prev.drawIndexed.mode == c.drawIndexed.mode && IsMergeablePrimitive(c.drawIndexed.mode) &&
+					prev.drawIndexed.instances == 1 && c.drawIndexed.instances == 1 && prev.drawIndexed.indexType == c.drawIndexed.indexType &&
+					(const uint8_t *)prev.drawIndexed.indices + prev.drawIndexed.count * IndexTypeSize(prev.drawIndexed.indexType) == (const uint8_t *)c.drawIndexed.indices) {
+					prev.drawIndexed.count += c.drawIndexed.count;
+					stats_.mergedCommands++;
+					continue;
+				}
+			}
+			break;
+		default:
+			break;
+		}
+
+		if (out != i) {
+			commands[out] = c;
+		}
+		out++;
+	}
+	commands.resize(out);
+}
+
+// Returns true if the uniform value differs from what was last written to this location of the program,
+// and records it.
+static bool UpdateUniformShadow(GLRProgram *program, int loc, GLRRenderCommand cmd, const float *v, int count) {
+	auto iter = program->uniformShadow_.find(loc);
+	if (iter != program->uniformShadow_.end() && iter->second.cmd == cmd && !memcmp(iter->second.v, v, count * sizeof(float))) {
+		return false;
+	}
+	GLRProgram::UniformShadow &shadow = program->uniformShadow_[loc];
+	shadow.cmd = cmd;
+	memcpy(shadow.v, v, count * sizeof(float));
+	return true;
+}
+
 void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last) {
 	CHECK_GL_ERROR_IF_DEBUG();
 
@@ -778,6 +1081,21 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 	bool clipDistance0Enabled = false;
 	GLuint blendEqColor = (GLuint)-1;
 	GLuint blendEqAlpha = (GLuint)-1;
+	GLenum blendFunc[4] = { (GLenum)-1, (GLenum)-1, (GLenum)-1, (GLenum)-1 };
+	float blendColor[4] = { -1.0f, -1.0f, -1.0f, -1.0f };
+	GLenum stencilFunc = (GLenum)-1;
+	int stencilRef = -1;
+	int stencilCompareMask = -1;
+	GLenum stencilOps[3] = { (GLenum)-1, (GLenum)-1, (GLenum)-1 };
+	int stencilWriteMask = -1;
+	GLenum frontFace = (GLenum)-1;
+	GLenum cullFace = (GLenum)-1;
+	// The first viewport and scissor are always set, since state may be left over from other passes.
+	GLRViewport curViewport{ -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f };
+	GLRect2D curScissor{ -1, -1, -1, -1 };
+	// Vertex attribute pointers only need to be set again if layout, buffer or offset changes.
+	const GLRInputLayout *curLayout = nullptr;
+	size_t curVertexOffset = 0;
 
 	GLRTexture *curTex[MAX_GL_TEXTURE_SLOTS]{};
 
@@ -790,18 +1108,26 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 				if (!depthEnabled) {
 					glEnable(GL_DEPTH_TEST);
 					depthEnabled = true;
+					stats_.stateCalls++;
 				}
 				if (c.depth.write != depthMask) {
 					glDepthMask(c.depth.write);
 					depthMask = c.depth.write;
+					stats_.stateCalls++;
+				} else {
+					stats_.filteredCalls++;
 				}
 				if (c.depth.func != depthFunc) {
 					glDepthFunc(c.depth.func);
 					depthFunc = c.depth.func;
+					stats_.stateCalls++;
+				} else {
+					stats_.filteredCalls++;
 				}
 			} else if (!c.depth.enabled && depthEnabled) {
 				glDisable(GL_DEPTH_TEST);
 				depthEnabled = false;
+				stats_.stateCalls++;
 			}
 			break;
 		case GLRRenderCommand::STENCILFUNC:
@@ -809,37 +1135,78 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 				if (!stencilEnabled) {
 					glEnable(GL_STENCIL_TEST);
 					stencilEnabled = true;
+					stats_.stateCalls++;
+				}
+				if (c.stencilFunc.func != stencilFunc || c.stencilFunc.ref != stencilRef || c.stencilFunc.compareMask != stencilCompareMask) {
+					glStencilFunc(c.stencilFunc.func, c.stencilFunc.ref, c.stencilFunc.compareMask);
+					stencilFunc = c.stencilFunc.func;
+					stencilRef = c.stencilFunc.ref;
+					stencilCompareMask = c.stencilFunc.compareMask;
+					stats_.stateCalls++;
+				} else {
+					stats_.filteredCalls++;
 				}
-				glStencilFunc(c.stencilFunc.func, c.stencilFunc.ref, c.stencilFunc.compareMask);
 			} else if (stencilEnabled) {
 				glDisable(GL_STENCIL_TEST);
 				stencilEnabled = false;
+				stats_.stateCalls++;
 			}
 			CHECK_GL_ERROR_IF_DEBUG();
 			break;
 		case GLRRenderCommand::STENCILOP:
-			glStencilOp(c.stencilOp.sFail, c.stencilOp.zFail, c.stencilOp.pass);
-			glStencilMask(c.stencilOp.writeMask);
+			if (c.stencilOp.sFail != stencilOps[0] || c.stencilOp.zFail != stencilOps[1] || c.stencilOp.pass != stencilOps[2]) {
+				glStencilOp(c.stencilOp.sFail, c.stencilOp.zFail, c.stencilOp.pass);
+				stencilOps[0] = c.stencilOp.sFail;
+				stencilOps[1] = c.stencilOp.zFail;
+				stencilOps[2] = c.stencilOp.pass;
+				stats_.stateCalls++;
+			} else {
+				stats_.filteredCalls++;
+			}
+			if (c.stencilOp.writeMask != stencilWriteMask) {
+				glStencilMask(c.stencilOp.writeMask);
+				stencilWriteMask = c.stencilOp.writeMask;
+				stats_.stateCalls++;
+			} else {
+				stats_.filteredCalls++;
+			}
 			break;
 		case GLRRenderCommand::BLEND:
 			if (c.blend.enabled) {
 				if (!blendEnabled) {
 					glEnable(GL_BLEND);
 					blendEnabled = true;
+					stats_.stateCalls++;
 				}
 				if (blendEqColor != c.blend.funcColor || blendEqAlpha != c.blend.funcAlpha) {
 					glBlendEquationSeparate(c.blend.funcColor, c.blend.funcAlpha);
 					blendEqColor = c.blend.funcColor;
 					blendEqAlpha = c.blend.funcAlpha;
+					stats_.stateCalls++;
+				} else {
+					stats_.filteredCalls++;
+				}
+				if (blendFunc[0] != c.blend.srcColor || blendFunc[1] != c.blend.dstColor || blendFunc[2] != c.blend.srcAlpha || blendFunc[3] != c.blend.dstAlpha) {
+					glBlendFuncSeparate(c.blend.srcColor, c.blend.dstColor, c.blend.srcAlpha, c.blend.dstAlpha);
+					blendFunc[0] = c.blend.srcColor;
+					blendFunc[1] = c.blend.dstColor;
+					blendFunc[2] = c.blend.srcAlpha;
+					blendFunc[3] = c.blend.dstAlpha;
+					stats_.stateCalls++;
+				} else {
+					stats_.filteredCalls++;
 				}
-				glBlendFuncSeparate(c.blend.srcColor, c.blend.dstColor, c.blend.srcAlpha, c.blend.dstAlpha);
 			} else if (!c.blend.enabled && blendEnabled) {
 				glDisable(GL_BLEND);
 				blendEnabled = false;
+				stats_.stateCalls++;
 			}
 			if (c.blend.mask != colorMask) {
 				glColorMask(c.blend.mask & 1, (c.blend.mask >> 1) & 1, (c.blend.mask >> 2) & 1, (c.blend.mask >> 3) & 1);
 				colorMask = c.blend.mask;
+				stats_.stateCalls++;
+			} else {
+				stats_.filteredCalls++;
 			}
 			CHECK_GL_ERROR_IF_DEBUG();
 			break;
@@ -849,13 +1216,19 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 				if (!logicEnabled) {
 					glEnable(GL_COLOR_LOGIC_OP);
 					logicEnabled = true;
+					stats_.stateCalls++;
 				}
-				if (logicOp != c.logic.logicOp) {
+				if (logicOp != (int)c.logic.logicOp) {
 					glLogicOp(c.logic.logicOp);
+					logicOp = c.logic.logicOp;
+					stats_.stateCalls++;
+				} else {
+					stats_.filteredCalls++;
 				}
 			} else if (!c.logic.enabled && logicEnabled) {
 				glDisable(GL_COLOR_LOGIC_OP);
 				logicEnabled = false;
+				stats_.stateCalls++;
 			}
 #endif
 			CHECK_GL_ERROR_IF_DEBUG();
@@ -867,6 +1240,7 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 				glDisable(GL_SCISSOR_TEST);
 			} else {
 				glScissor(c.clear.scissorX, c.clear.scissorY, c.clear.scissorW, c.clear.scissorH);
+				curScissor = { c.clear.scissorX, c.clear.scissorY, c.clear.scissorW, c.clear.scissorH };
 			}
 			if (c.clear.colorMask != colorMask) {
 				glColorMask(c.clear.colorMask & 1, (c.clear.colorMask >> 1) & 1, (c.clear.colorMask >> 2) & 1, (c.clear.colorMask >> 3) & 1);
@@ -891,6 +1265,7 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 				glClearStencil(c.clear.clearStencil);
 			}
 			glClear(c.clear.clearMask);
+			stats_.drawCalls++;
 			// Restore the color mask if it was different.
 			if (c.clear.colorMask != colorMask) {
 				glColorMask(colorMask & 1, (colorMask >> 1) & 1, (colorMask >> 2) & 1, (colorMask >> 3) & 1);
@@ -901,7 +1276,13 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 			CHECK_GL_ERROR_IF_DEBUG();
 			break;
 		case GLRRenderCommand::BLENDCOLOR:
-			glBlendColor(c.blendColor.color[0], c.blendColor.color[1], c.blendColor.color[2], c.blendColor.color[3]);
+			if (memcmp(blendColor, c.blendColor.color, sizeof(blendColor)) != 0) {
+				glBlendColor(c.blendColor.color[0], c.blendColor.color[1], c.blendColor.color[2], c.blendColor.color[3]);
+				memcpy(blendColor, c.blendColor.color, sizeof(blendColor));
+				stats_.stateCalls++;
+			} else {
+				stats_.filteredCalls++;
+			}
 			break;
 		case GLRRenderCommand::VIEWPORT:
 		{
@@ -910,16 +1291,28 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 				y = curFBHeight_ - y - c.viewport.vp.h;
 
 			// TODO: Support FP viewports through glViewportArrays
-			glViewport((GLint)c.viewport.vp.x, (GLint)y, (GLsizei)c.viewport.vp.w, (GLsizei)c.viewport.vp.h);
-#if !defined(USING_GLES2)
-			if (gl_extensions.IsGLES) {
-				glDepthRangef(c.viewport.vp.minZ, c.viewport.vp.maxZ);
+			if ((GLint)c.viewport.vp.x != (GLint)curViewport.x || (GLint)y != (GLint)curViewport.y || (GLsizei)c.viewport.vp.w != (GLsizei)curViewport.w || (GLsizei)c.viewport.vp.h != (GLsizei)curViewport.h) {
+				glViewport((GLint)c.viewport.vp.x, (GLint)y, (GLsizei)c.viewport.vp.w, (GLsizei)c.viewport.vp.h);
+				stats_.stateCalls++;
 			} else {
-				glDepthRange(c.viewport.vp.minZ, c.viewport.vp.maxZ);
+				stats_.filteredCalls++;
 			}
+			if (c.viewport.vp.minZ != curViewport.minZ || c.viewport.vp.maxZ != curViewport.maxZ) {
+#if !defined(USING_GLES2)
+				if (gl_extensions.IsGLES) {
+					glDepthRangef(c.viewport.vp.minZ, c.viewport.vp.maxZ);
+				} else {
+					glDepthRange(c.viewport.vp.minZ, c.viewport.vp.maxZ);
+				}
 #else
-			glDepthRangef(c.viewport.vp.minZ, c.viewport.vp.maxZ);
+				glDepthRangef(c.viewport.vp.minZ, c.viewport.vp.maxZ);
 #endif
+				stats_.stateCalls++;
+			} else {
+				stats_.filteredCalls++;
+			}
+			curViewport = c.viewport.vp;
+			curViewport.y = y;
 			CHECK_GL_ERROR_IF_DEBUG();
 			break;
 		}
@@ -928,7 +1321,13 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 			int y = c.scissor.rc.y;
 			if (!curFB_)
 				y = curFBHeight_ - y - c.scissor.rc.h;
-			glScissor(c.scissor.rc.x, y, c.scissor.rc.w, c.scissor.rc.h);
+			if (c.scissor.rc.x != curScissor.x || y != curScissor.y || c.scissor.rc.w != curScissor.w || c.scissor.rc.h != curScissor.h) {
+				glScissor(c.scissor.rc.x, y, c.scissor.rc.w, c.scissor.rc.h);
+				curScissor = { c.scissor.rc.x, y, c.scissor.rc.w, c.scissor.rc.h };
+				stats_.stateCalls++;
+			} else {
+				stats_.filteredCalls++;
+			}
 			CHECK_GL_ERROR_IF_DEBUG();
 			break;
 		}
@@ -938,7 +1337,10 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 			if (c.uniform4.name) {
 				loc = curProgram->GetUniformLoc(c.uniform4.name);
 			}
-			if (loc >= 0) {
+			if (loc >= 0 && curProgram && !UpdateUniformShadow(curProgram, loc, c.cmd, c.uniform4.v, c.uniform4.count)) {
+				stats_.filteredCalls++;
+			} else if (loc >= 0) {
+				stats_.uniformCalls++;
 				switch (c.uniform4.count) {
 				case 1:
 					glUniform1f(loc, c.uniform4.v[0]);
@@ -964,7 +1366,10 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 			if (c.uniform4.name) {
 				loc = curProgram->GetUniformLoc(c.uniform4.name);
 			}
-			if (loc >= 0) {
+			if (loc >= 0 && curProgram && !UpdateUniformShadow(curProgram, loc, c.cmd, c.uniform4.v, c.uniform4.count)) {
+				stats_.filteredCalls++;
+			} else if (loc >= 0) {
+				stats_.uniformCalls++;
 				switch (c.uniform4.count) {
 				case 1:
 					glUniform1uiv(loc, 1, (GLuint *)&c.uniform4.v[0]);
@@ -990,7 +1395,10 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 			if (c.uniform4.name) {
 				loc = curProgram->GetUniformLoc(c.uniform4.name);
 			}
-			if (loc >= 0) {
+			if (loc >= 0 && curProgram && !UpdateUniformShadow(curProgram, loc, c.cmd, c.uniform4.v, c.uniform4.count)) {
+				stats_.filteredCalls++;
+			} else if (loc >= 0) {
+				stats_.uniformCalls++;
 				switch (c.uniform4.count) {
 				case 1:
 					glUniform1iv(loc, 1, (GLint *)&c.uniform4.v[0]);
@@ -1016,8 +1424,11 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 			if (c.uniformMatrix4.name) {
 				loc = curProgram->GetUniformLoc(c.uniformMatrix4.name);
 			}
-			if (loc >= 0) {
+			if (loc >= 0 && curProgram && !UpdateUniformShadow(curProgram, loc, c.cmd, c.uniformMatrix4.m, 16)) {
+				stats_.filteredCalls++;
+			} else if (loc >= 0) {
 				glUniformMatrix4fv(loc, 1, false, c.uniformMatrix4.m);
+				stats_.uniformCalls++;
 			}
 			CHECK_GL_ERROR_IF_DEBUG();
 			break;
@@ -1033,6 +1444,9 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 				if (curTex[slot] != c.texture.texture) {
 					glBindTexture(c.texture.texture->target, c.texture.texture->texture);
 					curTex[slot] = c.texture.texture;
+					stats_.stateCalls++;
+				} else {
+					stats_.filteredCalls++;
 				}
 			} else {
 				glBindTexture(GL_TEXTURE_2D, 0);  // Which target? Well we only use this one anyway...
@@ -1067,6 +1481,7 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 		{
 			if (curProgram != c.program.program) {
 				glUseProgram(c.program.program->program);
+				stats_.stateCalls++;
 				if (c.program.program->use_clip_distance0 != clipDistance0Enabled) {
 					if (c.program.program->use_clip_distance0)
 						glEnable(GL_CLIP_DISTANCE0);
@@ -1075,6 +1490,8 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 					clipDistance0Enabled = c.program.program->use_clip_distance0;
 				}
 				curProgram = c.program.program;
+			} else {
+				stats_.filteredCalls++;
 			}
 			CHECK_GL_ERROR_IF_DEBUG();
 			break;
@@ -1088,6 +1505,11 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 			if (buf != curArrayBuffer) {
 				glBindBuffer(GL_ARRAY_BUFFER, buf);
 				curArrayBuffer = buf;
+				stats_.stateCalls++;
+			} else if (layout == curLayout && c.bindVertexBuffer.offset == curVertexOffset) {
+				// The attribute pointers already point at the same buffer, offset and layout.
+				stats_.filteredCalls++;
+				break;
 			}
 			int enable = layout->semanticsMask_ & ~attrMask;
 			int disable = (~layout->semanticsMask_) & attrMask;
@@ -1104,6 +1526,9 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 				auto &entry = layout->entries[i];
 				glVertexAttribPointer(entry.location, entry.count, entry.type, entry.normalized, entry.stride, (const void *)(c.bindVertexBuffer.offset + entry.offset));
 			}
+			stats_.stateCalls += (int)layout->entries.size();
+			curLayout = layout;
+			curVertexOffset = c.bindVertexBuffer.offset;
 			CHECK_GL_ERROR_IF_DEBUG();
 			break;
 		}
@@ -1133,8 +1558,10 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 			break;
 		case GLRRenderCommand::DRAW:
 			glDrawArrays(c.draw.mode, c.draw.first, c.draw.count);
+			stats_.drawCalls++;
 			break;
 		case GLRRenderCommand::DRAW_INDEXED:
+			stats_.drawCalls++;
 			if (c.drawIndexed.instances == 1) {
 				glDrawElements(c.drawIndexed.mode, c.drawIndexed.count, c.drawIndexed.indexType, c.drawIndexed.indices);
 			} else {
@@ -1237,9 +1664,22 @@ void GLQueueRunner::PerformRenderPass(const GLRStep &step, bool first, bool last
 				if (!cullEnabled) {
 					glEnable(GL_CULL_FACE);
 					cullEnabled = true;
+					stats_.stateCalls++;
+				}
+				if (frontFace != c.raster.frontFace) {
+					glFrontFace(c.raster.frontFace);
+					frontFace = c.raster.frontFace;
+					stats_.stateCalls++;
+				} else {
+					stats_.filteredCalls++;
+				}
+				if (cullFace != c.raster.cullFace) {
+					glCullFace(c.raster.cullFace);
+					cullFace = c.raster.cullFace;
+					stats_.stateCalls++;
+				} else {
+					stats_.filteredCalls++;
 				}
-				glFrontFace(c.raster.frontFace);
-				glCullFace(c.raster.cullFace);
 			} else if (!c.raster.cullEnable && cullEnabled) {
 				glDisable(GL_CULL_FACE);
 				cullEnabled = false;
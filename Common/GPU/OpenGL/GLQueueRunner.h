@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 #include <vector>
 #include <unordered_map>
 
@@ -341,6 +342,27 @@ struct GLRStep {
 	};
 };
 
+// GPU timestamps between steps. Lives in the frame data and is resolved when the frame slot
+// comes around again, so reading results doesn't stall.
+struct GLQueueProfileContext {
+	bool enabled = false;
+	std::vector<GLuint> queries;
+	std::vector<std::string> timestampDescriptions;
+	double cpuStartTime;
+	double cpuEndTime;
+};
+
+// Per-frame counts of what the render passes actually sent to the driver.
+struct GLQueueRunStats {
+	int drawCalls;
+	int stateCalls;
+	int uniformCalls;
+	// Calls that the shadow state found to be redundant and skipped.
+	int filteredCalls;
+	// Commands removed by OptimizeRenderPass (overwritten uniforms, merged draws.)
+	int mergedCommands;
+};
+
 class GLQueueRunner {
 public:
 	GLQueueRunner() {}
@@ -352,9 +374,24 @@ class GLQueueRunner {
 
 	void RunInitSteps(const std::vector<GLRInitStep> &steps, bool skipGLCalls);
 
-	void RunSteps(const std::vector<GLRStep *> &steps, bool skipGLCalls);
+	void RunSteps(const std::vector<GLRStep *> &steps, bool skipGLCalls, GLQueueProfileContext *profile);
 	void LogSteps(const std::vector<GLRStep *> &steps);
 
+	std::string StepToString(const GLRStep &step) const;
+
+	// Returns the counts accumulated since the last call, and resets them. Render thread only.
+	GLQueueRunStats TakeStats() {
+		GLQueueRunStats stats = stats_;
+		stats_ = {};
+		return stats;
+	}
+
+	bool SupportsTimestamps() const;
+	// Resolves the timestamps from the last use of the context into summary (returns false if there
+	// were none), then writes the first timestamp of a new frame if profiling is enabled.
+	bool BeginProfile(GLQueueProfileContext *profile, std::string *summary);
+	void DestroyProfile(GLQueueProfileContext *profile, bool skipGLCalls);
+
 	void CreateDeviceObjects();
 	void DestroyDeviceObjects();
 
@@ -382,6 +419,7 @@ class GLQueueRunner {
 	void InitCreateFramebuffer(const GLRInitStep &step);
 
 	void PerformBindFramebufferAsRenderTarget(const GLRStep &pass);
+	void OptimizeRenderPass(GLRStep &pass);
 	void PerformRenderPass(const GLRStep &pass, bool first, bool last);
 	void PerformCopy(const GLRStep &pass);
 	void PerformBlit(const GLRStep &pass);
@@ -433,6 +471,8 @@ class GLQueueRunner {
 	bool sawOutOfMemory_ = false;
 	bool useDebugGroups_ = false;
 
+	GLQueueRunStats stats_{};
+
 	ErrorCallbackFn errorCallback_ = nullptr;
 	void *errorCallbackUserData_ = nullptr;
 };
@@ -2,7 +2,9 @@
 #include "GLRenderManager.h"
 #include "Common/GPU/OpenGL/GLFeatures.h"
 #include "Common/GPU/thin3d.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Thread/ThreadUtil.h"
+#include "Common/TimeUtil.h"
 
 #include "Common/Log.h"
 #include "Common/MemoryUtil.h"
@@ -13,6 +15,14 @@
 #include "VR/VRRenderer.h"
 #endif
 
+// From GL_EXT_buffer_storage / GL 4.4, not in all GL headers we build against.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
 #if 0 // def _DEBUG
 #define VLOG(...) INFO_LOG(G3D, __VA_ARGS__)
 #else
@@ -145,6 +155,14 @@ void GLRenderManager::ThreadStart(Draw::DrawContext *draw) {
 	// Don't save draw, we don't want any thread safety confusion.
 	bool mapBuffers = draw->GetBugs().Has(Draw::Bugs::ANY_MAP_BUFFER_RANGE_SLOW);
 	bool hasBufferStorage = gl_extensions.ARB_buffer_storage || gl_extensions.EXT_buffer_storage;
+	bool hasFences = gl_extensions.IsGLES ? gl_extensions.GLES3 : gl_extensions.VersionGEThan(3, 2, 0);
+#if PPSSPP_PLATFORM(IOS) || PPSSPP_PLATFORM(ANDROID)
+	// Not on Android for the same task switching reasons as mapping below. iOS doesn't have buffer storage.
+	bool allowPersistent = false;
+#else
+	bool allowPersistent = true;
+#endif
+	pendingFenceFrame_ = -1;
 	if (!gl_extensions.VersionGEThan(3, 0, 0) && gl_extensions.IsGLES && !hasBufferStorage) {
 		// Force disable if it wouldn't work anyway.
 		mapBuffers = false;
@@ -153,7 +171,11 @@ void GLRenderManager::ThreadStart(Draw::DrawContext *draw) {
 	// Notes on buffer mapping:
 	// NVIDIA GTX 9xx / 2017-10 drivers - mapping improves speed, basic unmap seems best.
 	// PowerVR GX6xxx / iOS 10.3 - mapping has little improvement, explicit flush is slower.
-	if (mapBuffers) {
+	if (allowPersistent && hasBufferStorage && hasFences && inflightFrames_ > 1) {
+		// Saves both the big memcpy/subdata at the end of the frame and the map/unmap driver overhead.
+		// We need a frame of latency to fence with, so not with a single inflight frame.
+		bufferStrategy_ = GLBufferStrategy::PERSISTENT;
+	} else if (mapBuffers) {
 		switch (gl_extensions.gpuVendor) {
 		case GPU_VENDOR_NVIDIA:
 			bufferStrategy_ = GLBufferStrategy::FRAME_UNMAP;
@@ -194,7 +216,15 @@ void GLRenderManager::ThreadEnd() {
 		}
 		frameData_[i].steps.clear();
 		frameData_[i].initSteps.clear();
+		if (frameData_[i].fence) {
+			if (!skipGLCalls_) {
+				glDeleteSync(frameData_[i].fence);
+			}
+			frameData_[i].fence = nullptr;
+		}
+		queueRunner_.DestroyProfile(&frameData_[i].profile, skipGLCalls_);
 	}
+	pendingFenceFrame_ = -1;
 	deleter_.Perform(this, skipGLCalls_);
 
 	for (int i = 0; i < (int)steps_.size(); i++) {
@@ -206,8 +236,13 @@ void GLRenderManager::ThreadEnd() {
 
 bool GLRenderManager::ThreadFrame() {
 	std::unique_lock<std::mutex> lock(mutex_);
-	if (!run_)
+	if (!run_) {
+		if (pendingFenceFrame_ != -1) {
+			ReleaseFencedFrame(pendingFenceFrame_);
+			pendingFenceFrame_ = -1;
+		}
 		return false;
+	}
 #ifdef OPENXR
 	VR_BeginFrame(VR_GetEngine());
 #endif
@@ -228,6 +263,11 @@ bool GLRenderManager::ThreadFrame() {
 			}
 			if (!frameData.readyForRun && !run_) {
 				// This means we're out of frames to render and run_ is false, so bail.
+				lock.unlock();
+				if (pendingFenceFrame_ != -1) {
+					ReleaseFencedFrame(pendingFenceFrame_);
+					pendingFenceFrame_ = -1;
+				}
 				return false;
 			}
 			VLOG("PULL: Setting frame[%d].readyForRun = false", threadFrame_);
@@ -280,6 +320,16 @@ void GLRenderManager::StopThread() {
 		// Eat whatever has been queued up for this frame if anything.
 		Wipe();
 
+		// A frame held back for its fence (see Submit) won't get released by the render thread now,
+		// since we hold mutex_. Release it here, the fence gets cleaned up on the render thread later.
+		if (pendingFenceFrame_ != -1) {
+			auto &frameData = frameData_[pendingFenceFrame_];
+			std::unique_lock<std::mutex> lock(frameData.push_mutex);
+			frameData.readyForFence = true;
+			frameData.push_condVar.notify_all();
+			pendingFenceFrame_ = -1;
+		}
+
 		// Wait for any fences to finish and be resignaled, so we don't have sync issues.
 		// Also clean out any queued data, which might refer to things that might not be valid
 		// when we restart...
@@ -457,7 +507,7 @@ void GLRenderManager::CopyImageToMemorySync(GLRTexture *texture, int mipLevel, i
 	queueRunner_.CopyReadbackBuffer(w, h, Draw::DataFormat::R8G8B8A8_UNORM, destFormat, pixelStride, pixels);
 }
 
-void GLRenderManager::BeginFrame() {
+void GLRenderManager::BeginFrame(bool enableProfiling) {
 	VLOG("BeginFrame");
 
 #ifdef _DEBUG
@@ -478,6 +528,9 @@ void GLRenderManager::BeginFrame() {
 		frameData.readyForSubmit = true;
 	}
 
+	// Picked up by the render thread when it starts on this frame.
+	frameData.profile.enabled = enableProfiling && queueRunner_.SupportsTimestamps();
+
 	VLOG("PUSH: Fencing %d", curFrame);
 
 	// glFenceSync(&frameData.fence...)
@@ -525,6 +578,15 @@ void GLRenderManager::BeginSubmitFrame(int frame) {
 	FrameData &frameData = frameData_[frame];
 	if (!frameData.hasBegun) {
 		frameData.hasBegun = true;
+
+		// The last use of this frame slot should be done on the GPU by now, resolve its timestamps.
+		if (!skipGLCalls_ && (frameData.profile.enabled || !frameData.profile.timestampDescriptions.empty())) {
+			std::string summary;
+			if (queueRunner_.BeginProfile(&frameData.profile, &summary)) {
+				std::lock_guard<std::mutex> guard(profileMutex_);
+				profileSummary_ = std::move(summary);
+			}
+		}
 	}
 }
 
@@ -537,6 +599,22 @@ void GLRenderManager::Submit(int frame, bool triggerFence) {
 	// When !triggerFence, we notify after syncing with Vulkan.
 
 	if (triggerFence) {
+		if (bufferStrategy_ == GLBufferStrategy::PERSISTENT && !skipGLCalls_) {
+			// The push buffers stay mapped, so the emu thread must not write this frame's buffers
+			// again until the GPU is done with them. Instead of stalling right away, we hold the
+			// frame back until the next one has been submitted, by then the wait is usually short.
+			if (frameData.fence) {
+				glDeleteSync(frameData.fence);
+			}
+			frameData.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			int prevFrame = pendingFenceFrame_;
+			pendingFenceFrame_ = frame;
+			if (prevFrame != -1) {
+				ReleaseFencedFrame(prevFrame);
+			}
+			return;
+		}
+
 		VLOG("PULL: Frame %d.readyForFence = true", frame);
 
 		std::unique_lock<std::mutex> lock(frameData.push_mutex);
@@ -547,6 +625,30 @@ void GLRenderManager::Submit(int frame, bool triggerFence) {
 	}
 }
 
+// Render thread
+void GLRenderManager::ReleaseFencedFrame(int frame) {
+	FrameData &frameData = frameData_[frame];
+	if (frameData.fence) {
+		if (!skipGLCalls_) {
+			// One second should be way more than enough, if not, something's badly wrong and we'll just continue.
+			GLenum res = glClientWaitSync(frameData.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+			if (res == GL_TIMEOUT_EXPIRED || res == GL_WAIT_FAILED) {
+				WARN_LOG(G3D, "Timed out waiting for frame %d fence", frame);
+			}
+			glDeleteSync(frameData.fence);
+		}
+		frameData.fence = nullptr;
+	}
+
+	VLOG("PULL: Frame %d.readyForFence = true (fenced)", frame);
+
+	std::unique_lock<std::mutex> lock(frameData.push_mutex);
+	_assert_(frameData.readyForSubmit);
+	frameData.readyForFence = true;
+	frameData.readyForSubmit = false;
+	frameData.push_condVar.notify_all();
+}
+
 // Render thread
 void GLRenderManager::EndSubmitFrame(int frame) {
 	FrameData &frameData = frameData_[frame];
@@ -571,6 +673,7 @@ void GLRenderManager::EndSubmitFrame(int frame) {
 
 // Render thread
 void GLRenderManager::Run(int frame) {
+	PROFILE_THIS_SCOPE("glrun");
 	BeginSubmitFrame(frame);
 
 	FrameData &frameData = frameData_[frame];
@@ -589,8 +692,11 @@ void GLRenderManager::Run(int frame) {
 		}
 	}
 
-	queueRunner_.RunSteps(stepsOnThread, skipGLCalls_);
+	GLQueueProfileContext *profile = frameData.profile.timestampDescriptions.empty() ? nullptr : &frameData.profile;
+	queueRunner_.RunSteps(stepsOnThread, skipGLCalls_, profile);
 	stepsOnThread.clear();
+	if (profile)
+		profile->cpuEndTime = time_now_d();
 
 	if (!skipGLCalls_) {
 		for (auto iter : frameData.activePushBuffers) {
@@ -600,6 +706,11 @@ void GLRenderManager::Run(int frame) {
 
 	switch (frameData.type) {
 	case GLRRunType::END:
+		{
+			GLQueueRunStats stats = queueRunner_.TakeStats();
+			std::lock_guard<std::mutex> guard(profileMutex_);
+			lastFrameStats_ = stats;
+		}
 		EndSubmitFrame(frame);
 		break;
 
@@ -615,6 +726,7 @@ void GLRenderManager::Run(int frame) {
 }
 
 void GLRenderManager::FlushSync() {
+	PROFILE_THIS_SCOPE("flushsync");
 	// TODO: Reset curRenderStep_?
 	renderStepOffset_ += (int)steps_.size();
 
@@ -649,8 +761,8 @@ void GLRenderManager::EndSyncFrame(int frame) {
 	FrameData &frameData = frameData_[frame];
 	Submit(frame, false);
 
-	// glFinish is not actually necessary here, and won't be until we start using
-	// glBufferStorage. Then we need to use fences.
+	// glFinish is not actually necessary here. Even with persistently mapped push buffers, writes
+	// after the sync go to later offsets than anything the GPU may still be reading.
 	// glFinish();
 
 	// At this point we can resume filling the command buffers for the current frame since
@@ -878,6 +990,11 @@ void GLPushBuffer::MapDevice(GLBufferStrategy strategy) {
 void GLPushBuffer::UnmapDevice() {
 	_dbg_assert_msg_(OnRenderThread(), "UnmapDevice must run on render thread");
 
+	if ((strategy_ & GLBufferStrategy::MASK_PERSISTENT) != 0) {
+		// Fine to draw from while mapped. Unmapped implicitly when the buffer gets deleted.
+		return;
+	}
+
 	for (auto &info : buffers_) {
 		if (info.deviceMemory) {
 			// TODO: Technically this can return false?
@@ -894,6 +1011,10 @@ void *GLRBuffer::Map(GLBufferStrategy strategy) {
 	if ((strategy & GLBufferStrategy::MASK_FLUSH) != 0) {
 		access |= GL_MAP_FLUSH_EXPLICIT_BIT;
 	}
+	if ((strategy & GLBufferStrategy::MASK_PERSISTENT) != 0) {
+		// Also ends up in the storage flags below, which is required for persistent maps.
+		access |= GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	}
 	if ((strategy & GLBufferStrategy::MASK_INVALIDATE) != 0) {
 		access |= GL_MAP_INVALIDATE_BUFFER_BIT;
 	}
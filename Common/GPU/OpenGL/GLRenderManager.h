@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -122,6 +124,14 @@ class GLRProgram {
 	std::vector<Initializer> initialize_;
 	bool use_clip_distance0 = false;
 
+	// Program binaries (ARB_get_program_binary.) A binary set before creation is tried instead of
+	// linking, and with wantBinary the linked result is read back into it. Once binaryReady is set,
+	// binary/binaryFormat are no longer touched by the render thread and can be saved.
+	std::vector<uint8_t> binary;
+	GLenum binaryFormat = 0;
+	bool wantBinary = false;
+	std::atomic<bool> binaryReady{ false };
+
 	struct UniformInfo {
 		int loc_;
 	};
@@ -142,6 +152,15 @@ class GLRProgram {
 		return loc;
 	}
 	std::unordered_map<std::string, UniformInfo> uniformCache_;
+
+	// Last value written to each uniform location. Uniforms are per-program state, so this stays
+	// valid across program switches and lets GLQueueRunner skip redundant glUniform calls.
+	// Must ONLY be touched from GLQueueRunner!
+	struct UniformShadow {
+		GLRRenderCommand cmd;
+		float v[16];
+	};
+	std::unordered_map<int, UniformShadow> uniformShadow_;
 };
 
 enum class GLBufferStrategy {
@@ -149,6 +168,7 @@ enum class GLBufferStrategy {
 
 	MASK_FLUSH = 0x10,
 	MASK_INVALIDATE = 0x20,
+	MASK_PERSISTENT = 0x40,
 
 	// Map/unmap the buffer each frame.
 	FRAME_UNMAP = 1,
@@ -158,6 +178,9 @@ enum class GLBufferStrategy {
 	FLUSH_UNMAP = MASK_FLUSH,
 	// Map/unmap, invalidate on map, and explicit flush.
 	FLUSH_INVALIDATE_UNMAP = MASK_FLUSH | MASK_INVALIDATE,
+	// Map once, persistent and coherent (requires buffer storage), and never unmap.
+	// The render manager fences each frame before its buffers can be written again.
+	PERSISTENT = MASK_PERSISTENT,
 };
 
 static inline int operator &(const GLBufferStrategy &lhs, const GLBufferStrategy &rhs) {
@@ -194,8 +217,8 @@ class GLRenderManager;
 // Similar to VulkanPushBuffer but is currently less efficient - it collects all the data in
 // RAM then does a big memcpy/buffer upload at the end of the frame. This is at least a lot
 // faster than the hundreds of buffer uploads or memory array buffers we used before.
-// On modern GL we could avoid the copy using glBufferStorage but not sure it's worth the
-// trouble.
+// On modern desktop GL we avoid the copy by keeping the buffers persistently mapped
+// (GLBufferStrategy::PERSISTENT, using glBufferStorage), fenced per frame.
 // We need to manage the lifetime of this together with the other resources so its destructor
 // runs on the render thread.
 class GLPushBuffer {
@@ -371,7 +394,7 @@ class GLRenderManager {
 	bool ThreadFrame();  // Returns false to request exiting the loop.
 
 	// Makes sure that the GPU has caught up enough that we can start writing buffers of this frame again.
-	void BeginFrame();
+	void BeginFrame(bool enableProfiling);
 	// Can run on a different thread!
 	void Finish();
 	void Run(int frame);
@@ -960,10 +983,23 @@ class GLRenderManager {
 		return renderStepOffset_ + (int)steps_.size();
 	}
 
+	std::string GetGpuProfileString() const {
+		std::lock_guard<std::mutex> guard(profileMutex_);
+		return profileSummary_;
+	}
+
+	// GL call counts of the last completed frame.
+	GLQueueRunStats GetLastFrameStats() const {
+		std::lock_guard<std::mutex> guard(profileMutex_);
+		return lastFrameStats_;
+	}
+
 private:
 	void BeginSubmitFrame(int frame);
 	void EndSubmitFrame(int frame);
 	void Submit(int frame, bool triggerFence);
+	// Waits for the frame's fence, then lets the emu thread reuse the frame.
+	void ReleaseFencedFrame(int frame);
 
 	// Bad for performance but sometimes necessary for synchronous CPU readbacks (screenshots and whatnot).
 	void FlushSync();
@@ -989,7 +1025,8 @@ class GLRenderManager {
 		bool skipSwap = false;
 		GLRRunType type = GLRRunType::END;
 
-		// GLuint fence; For future AZDO stuff?
+		// Only used with persistently mapped push buffers, see Submit().
+		GLsync fence = nullptr;
 		std::vector<GLRStep *> steps;
 		std::vector<GLRInitStep> initSteps;
 
@@ -1000,6 +1037,8 @@ class GLRenderManager {
 		GLDeleter deleter;
 		GLDeleter deleter_prev;
 		std::set<GLPushBuffer *> activePushBuffers;
+
+		GLQueueProfileContext profile;
 	};
 
 	FrameData frameData_[MAX_INFLIGHT_FRAMES];
@@ -1019,8 +1058,15 @@ class GLRenderManager {
 	int threadInitFrame_ = 0;
 	GLQueueRunner queueRunner_;
 
+	// Written on the render thread, read by the debug overlay.
+	mutable std::mutex profileMutex_;
+	std::string profileSummary_;
+	GLQueueRunStats lastFrameStats_{};
+
 	// Thread state
 	int threadFrame_ = -1;
+	// With persistent buffers, the last submitted frame is released only once the next one is submitted.
+	int pendingFenceFrame_ = -1;
 
 	bool nextFrame = false;
 	bool firstFrame = true;
@@ -7,7 +7,6 @@
 #include "Common/Log.h"
 
 const char * const vulkan_glsl_preamble_fs =
-"#version 450\n"
 "#extension GL_ARB_separate_shader_objects : enable\n"
 "#extension GL_ARB_shading_language_420pack : enable\n"
 "#extension GL_ARB_conservative_depth : enable\n"
@@ -43,7 +42,6 @@ static const char * const hlsl_d3d9_preamble_fs =
 "#define DISCARD_BELOW(x) clip(x)\n";
 
 static const char * const vulkan_glsl_preamble_vs =
-"#version 450\n"
 "#extension GL_ARB_separate_shader_objects : enable\n"
 "#extension GL_ARB_shading_language_420pack : enable\n"
 "#define mul(x, y) ((x) * (y))\n"
@@ -88,6 +86,11 @@ ShaderWriter & ShaderWriter::F(const char *format, ...) {
 void ShaderWriter::Preamble(const char **gl_extensions, size_t num_gl_extensions) {
 	switch (lang_.shaderLanguage) {
 	case GLSL_VULKAN:
+		C("#version 450\n");
+		// Extra extensions (like stencil export) go before the precision statements in the preamble.
+		for (size_t i = 0; i < num_gl_extensions; i++) {
+			F("%s\n", gl_extensions[i]);
+		}
 		switch (stage_) {
 		case ShaderStage::Vertex:
 			W(vulkan_glsl_preamble_vs);
@@ -209,7 +212,7 @@ void ShaderWriter::BeginVSMain(Slice<InputDef> inputs, Slice<UniformDef> uniform
 	}
 }
 
-void ShaderWriter::BeginFSMain(Slice<UniformDef> uniforms, Slice<VaryingDef> varyings) {
+void ShaderWriter::BeginFSMain(Slice<UniformDef> uniforms, Slice<VaryingDef> varyings, FSFlags flags) {
 	_assert_(this->stage_ == ShaderStage::Fragment);
 	switch (lang_.shaderLanguage) {
 	case HLSL_D3D11:
@@ -223,15 +226,27 @@ void ShaderWriter::BeginFSMain(Slice<UniformDef> uniforms, Slice<VaryingDef> var
 			C("};\n");
 		}
 
+		if (flags & FSFLAG_WRITEDEPTH) {
+			C("struct PS_OUT {\n");
+			C("  vec4 target : SV_Target0;\n");
+			C("  float depth : SV_Depth;\n");
+			C("};\n");
+		}
+
 		// Let's do the varyings as parameters to main, no struct.
-		C("vec4 main(");
+		W((flags & FSFLAG_WRITEDEPTH) ? "PS_OUT main(" : "vec4 main(");
 		for (auto &varying : varyings) {
 			F("  %s %s : %s, ", varying.type, varying.name, semanticNames[varying.semantic]);
 		}
 		// Erase the last comma
 		Rewind(2);
 
-		F(") : SV_Target0 {\n");
+		if (flags & FSFLAG_WRITEDEPTH) {
+			C(") {\n");
+			C("  float gl_FragDepth;\n");
+		} else {
+			C(") : SV_Target0 {\n");
+		}
 		break;
 	case HLSL_D3D9:
 		for (auto &uniform : uniforms) {
@@ -296,10 +311,19 @@ void ShaderWriter::EndVSMain(Slice<VaryingDef> varyings) {
 	C("}\n");
 }
 
-void ShaderWriter::EndFSMain(const char *vec4_color_variable) {
+void ShaderWriter::EndFSMain(const char *vec4_color_variable, FSFlags flags) {
 	_assert_(this->stage_ == ShaderStage::Fragment);
 	switch (lang_.shaderLanguage) {
 	case HLSL_D3D11:
+		if (flags & FSFLAG_WRITEDEPTH) {
+			C("  PS_OUT ps_out;\n");
+			F("  ps_out.target = %s;\n", vec4_color_variable);
+			C("  ps_out.depth = gl_FragDepth;\n");
+			C("  return ps_out;\n");
+		} else {
+			F("  return %s;\n", vec4_color_variable);
+		}
+		break;
 	case HLSL_D3D9:
 		F("  return %s;\n", vec4_color_variable);
 		break;
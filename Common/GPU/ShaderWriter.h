@@ -36,6 +36,12 @@ struct VaryingDef {
 	const char *precision;
 };
 
+enum FSFlags {
+	FSFLAG_NONE = 0,
+	// The shader assigns gl_FragDepth. Not supported for HLSL_D3D9.
+	FSFLAG_WRITEDEPTH = 1,
+};
+
 class ShaderWriter {
 public:
 	ShaderWriter(char *buffer, const ShaderLanguageDesc &lang, ShaderStage stage, const char **gl_extensions, size_t num_gl_extensions) : p_(buffer), lang_(lang), stage_(stage) {
@@ -76,11 +82,11 @@ class ShaderWriter {
 
 	// Simple shaders with no special tricks.
 	void BeginVSMain(Slice<InputDef> inputs, Slice<UniformDef> uniforms, Slice<VaryingDef> varyings);
-	void BeginFSMain(Slice<UniformDef> uniforms, Slice<VaryingDef> varyings);
+	void BeginFSMain(Slice<UniformDef> uniforms, Slice<VaryingDef> varyings, FSFlags flags = FSFLAG_NONE);
 
 	// For simple shaders that output a single color, we can deal with this generically.
 	void EndVSMain(Slice<VaryingDef> varyings);
-	void EndFSMain(const char *vec4_color_variable);
+	void EndFSMain(const char *vec4_color_variable, FSFlags flags = FSFLAG_NONE);
 
 
 	void Rewind(size_t offset) {
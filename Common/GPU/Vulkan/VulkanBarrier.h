@@ -37,7 +37,7 @@ class VulkanBarrier {
 		imageBarrier.subresourceRange.baseArrayLayer = 0;
 		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		imageBarriers_.push_back(imageBarrier);
+		AddImageBarrier(imageBarrier);
 	}
 
 	// Automatically determines access and stage masks from layouts.
@@ -103,12 +103,30 @@ class VulkanBarrier {
 		imageBarrier.subresourceRange.baseArrayLayer = 0;
 		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		imageBarriers_.push_back(imageBarrier);
+		AddImageBarrier(imageBarrier);
 	}
 
 	void Flush(VkCommandBuffer cmd);
 
 private:
+	// If the same image is already being transitioned into the layout this barrier starts from
+	// (typically a render pass's final transition followed by the next step's one), fold the two
+	// into a single transition. Multiple barriers on the same subresource in one call aren't ordered.
+	void AddImageBarrier(const VkImageMemoryBarrier &imageBarrier) {
+		for (auto &prev : imageBarriers_) {
+			if (prev.image == imageBarrier.image && prev.newLayout == imageBarrier.oldLayout &&
+				prev.subresourceRange.baseMipLevel == imageBarrier.subresourceRange.baseMipLevel &&
+				prev.subresourceRange.levelCount == imageBarrier.subresourceRange.levelCount) {
+				prev.srcAccessMask |= imageBarrier.srcAccessMask;
+				prev.dstAccessMask |= imageBarrier.dstAccessMask;
+				prev.newLayout = imageBarrier.newLayout;
+				prev.subresourceRange.aspectMask |= imageBarrier.subresourceRange.aspectMask;
+				return;
+			}
+		}
+		imageBarriers_.push_back(imageBarrier);
+	}
+
 	VkPipelineStageFlags srcStageMask_ = 0;
 	VkPipelineStageFlags dstStageMask_ = 0;
 	std::vector<VkImageMemoryBarrier> imageBarriers_;
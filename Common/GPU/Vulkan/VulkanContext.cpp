@@ -321,6 +321,8 @@ void VulkanContext::UpdateInflightFrames(int n) {
 
 void VulkanContext::WaitUntilQueueIdle() {
 	// Should almost never be used
+	if (transfer_queue_)
+		vkQueueWaitIdle(transfer_queue_);
 	vkQueueWaitIdle(gfx_queue_);
 }
 
@@ -602,6 +604,8 @@ void VulkanContext::ChooseDevice(int physical_device) {
 	deviceFeatures_.enabled.shaderCullDistance = deviceFeatures_.available.shaderCullDistance;
 	// For easy wireframe mode, someday.
 	deviceFeatures_.enabled.fillModeNonSolid = deviceFeatures_.available.fillModeNonSolid;
+	// Only used by the optional bindless texture path.
+	deviceFeatures_.enabled.shaderSampledImageArrayDynamicIndexing = deviceFeatures_.available.shaderSampledImageArrayDynamicIndexing;
 
 	GetDeviceLayerExtensionList(nullptr, device_extension_properties_);
 
@@ -634,20 +638,37 @@ VkResult VulkanContext::CreateDevice() {
 		return VK_ERROR_INITIALIZATION_FAILED;
 	}
 
-	VkDeviceQueueCreateInfo queue_info{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
+	VkDeviceQueueCreateInfo queue_info[2]{};
 	float queue_priorities[1] = {1.0f};
-	queue_info.queueCount = 1;
-	queue_info.pQueuePriorities = queue_priorities;
+	queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queue_info[0].queueCount = 1;
+	queue_info[0].pQueuePriorities = queue_priorities;
 	bool found = false;
 	for (int i = 0; i < (int)queue_count; i++) {
 		if (queueFamilyProperties_[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-			queue_info.queueFamilyIndex = i;
+			queue_info[0].queueFamilyIndex = i;
 			found = true;
 			break;
 		}
 	}
 	_dbg_assert_(found);
 
+	// If there's a transfer-only family (a DMA engine), grab a queue from it so uploads can run alongside rendering.
+	transfer_queue_family_index_ = -1;
+	for (int i = 0; i < (int)queue_count; i++) {
+		VkQueueFlags flags = queueFamilyProperties_[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			transfer_queue_family_index_ = i;
+			break;
+		}
+	}
+	int numQueueInfos = 1;
+	if (transfer_queue_family_index_ != -1) {
+		queue_info[1] = queue_info[0];
+		queue_info[1].queueFamilyIndex = transfer_queue_family_index_;
+		numQueueInfos++;
+	}
+
 	extensionsLookup_.KHR_maintenance1 = EnableDeviceExtension(VK_KHR_MAINTENANCE1_EXTENSION_NAME);
 	extensionsLookup_.KHR_maintenance2 = EnableDeviceExtension(VK_KHR_MAINTENANCE2_EXTENSION_NAME);
 	extensionsLookup_.KHR_maintenance3 = EnableDeviceExtension(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
@@ -667,15 +688,72 @@ VkResult VulkanContext::CreateDevice() {
 		extensionsLookup_.KHR_depth_stencil_resolve = EnableDeviceExtension(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
 	}
 	extensionsLookup_.EXT_shader_stencil_export = EnableDeviceExtension(VK_EXT_SHADER_STENCIL_EXPORT_EXTENSION_NAME);
+	if (extensionsLookup_.KHR_maintenance3 && extensionsLookup_.KHR_get_physical_device_properties2) {
+		extensionsLookup_.EXT_descriptor_indexing = EnableDeviceExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+	}
+	if (extensionsLookup_.KHR_get_physical_device_properties2 && EnableDeviceExtension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+		extensionsLookup_.KHR_pipeline_library = true;
+		extensionsLookup_.EXT_graphics_pipeline_library = EnableDeviceExtension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+	}
+
+	deviceFeatures_.availableDescriptorIndexing = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+	deviceFeatures_.enabledDescriptorIndexing = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+	if (extensionsLookup_.EXT_descriptor_indexing) {
+		VkPhysicalDeviceFeatures2 features2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR };
+		features2.pNext = &deviceFeatures_.availableDescriptorIndexing;
+		vkGetPhysicalDeviceFeatures2KHR(physical_devices_[physical_device_], &features2);
+		deviceFeatures_.availableDescriptorIndexing.pNext = nullptr;
+
+		VkPhysicalDeviceProperties2 props2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProps{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT };
+		props2.pNext = &indexingProps;
+		vkGetPhysicalDeviceProperties2KHR(physical_devices_[physical_device_], &props2);
+		indexingProps.pNext = nullptr;
+		physicalDeviceProperties_[physical_device_].descriptorIndexingProperties = indexingProps;
+
+		// We only need what it takes to keep one big array of textures bound for a whole frame.
+		const VkPhysicalDeviceDescriptorIndexingFeaturesEXT &avail = deviceFeatures_.availableDescriptorIndexing;
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT &enabled = deviceFeatures_.enabledDescriptorIndexing;
+		enabled.descriptorBindingSampledImageUpdateAfterBind = avail.descriptorBindingSampledImageUpdateAfterBind;
+		enabled.descriptorBindingPartiallyBound = avail.descriptorBindingPartiallyBound;
+		enabled.descriptorBindingUpdateUnusedWhilePending = avail.descriptorBindingUpdateUnusedWhilePending;
+	}
+
+	deviceFeatures_.availableGraphicsPipelineLibrary = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
+	deviceFeatures_.enabledGraphicsPipelineLibrary = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
+	physicalDeviceProperties_[physical_device_].graphicsPipelineLibraryProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT };
+	if (extensionsLookup_.EXT_graphics_pipeline_library) {
+		VkPhysicalDeviceFeatures2 features2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR };
+		features2.pNext = &deviceFeatures_.availableGraphicsPipelineLibrary;
+		vkGetPhysicalDeviceFeatures2KHR(physical_devices_[physical_device_], &features2);
+		deviceFeatures_.availableGraphicsPipelineLibrary.pNext = nullptr;
+
+		VkPhysicalDeviceProperties2 props2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+		VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT libraryProps{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT };
+		props2.pNext = &libraryProps;
+		vkGetPhysicalDeviceProperties2KHR(physical_devices_[physical_device_], &props2);
+		libraryProps.pNext = nullptr;
+		physicalDeviceProperties_[physical_device_].graphicsPipelineLibraryProperties = libraryProps;
+
+		deviceFeatures_.enabledGraphicsPipelineLibrary.graphicsPipelineLibrary = deviceFeatures_.availableGraphicsPipelineLibrary.graphicsPipelineLibrary;
+	}
 
 	VkDeviceCreateInfo device_info{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
-	device_info.queueCreateInfoCount = 1;
-	device_info.pQueueCreateInfos = &queue_info;
+	device_info.queueCreateInfoCount = numQueueInfos;
+	device_info.pQueueCreateInfos = queue_info;
 	device_info.enabledLayerCount = (uint32_t)device_layer_names_.size();
 	device_info.ppEnabledLayerNames = device_info.enabledLayerCount ? device_layer_names_.data() : nullptr;
 	device_info.enabledExtensionCount = (uint32_t)device_extensions_enabled_.size();
 	device_info.ppEnabledExtensionNames = device_info.enabledExtensionCount ? device_extensions_enabled_.data() : nullptr;
 	device_info.pEnabledFeatures = &deviceFeatures_.enabled;
+	if (extensionsLookup_.EXT_descriptor_indexing) {
+		deviceFeatures_.enabledDescriptorIndexing.pNext = (void *)device_info.pNext;
+		device_info.pNext = &deviceFeatures_.enabledDescriptorIndexing;
+	}
+	if (extensionsLookup_.EXT_graphics_pipeline_library) {
+		deviceFeatures_.enabledGraphicsPipelineLibrary.pNext = (void *)device_info.pNext;
+		device_info.pNext = &deviceFeatures_.enabledGraphicsPipelineLibrary;
+	}
 
 	VkResult res = vkCreateDevice(physical_devices_[physical_device_], &device_info, nullptr, &device_);
 	if (res != VK_SUCCESS) {
@@ -683,6 +761,10 @@ VkResult VulkanContext::CreateDevice() {
 		ERROR_LOG(G3D, "Unable to create Vulkan device");
 	} else {
 		VulkanLoadDeviceFunctions(device_, extensionsLookup_);
+		if (transfer_queue_family_index_ != -1) {
+			vkGetDeviceQueue(device_, transfer_queue_family_index_, 0, &transfer_queue_);
+			INFO_LOG(G3D, "Using queue family %d for transfers", transfer_queue_family_index_);
+		}
 	}
 	INFO_LOG(G3D, "Device created.\n");
 	VulkanSetAvailable(true);
@@ -1193,6 +1275,7 @@ void VulkanContext::DestroyDevice() {
 
 	vkDestroyDevice(device_, nullptr);
 	device_ = nullptr;
+	transfer_queue_ = VK_NULL_HANDLE;
 }
 
 bool VulkanContext::CreateShaderModule(const std::vector<uint32_t> &spirv, VkShaderModule *shaderModule) {
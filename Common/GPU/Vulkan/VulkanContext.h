@@ -244,10 +244,21 @@ class VulkanContext {
 		return graphics_queue_family_index_;
 	}
 
+	// Only available if the device has a dedicated transfer queue family, otherwise null / -1.
+	VkQueue GetTransferQueue() const {
+		return transfer_queue_;
+	}
+
+	int GetTransferQueueFamilyIndex() const {
+		return transfer_queue_family_index_;
+	}
+
 	struct PhysicalDeviceProps {
 		VkPhysicalDeviceProperties properties;
 		VkPhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProperties;
 		VkPhysicalDeviceExternalMemoryHostPropertiesEXT externalMemoryHostProperties;
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties;
+		VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties;
 	};
 
 	const PhysicalDeviceProps &GetPhysicalDeviceProperties(int i = -1) const {
@@ -276,6 +287,12 @@ class VulkanContext {
 	struct PhysicalDeviceFeatures {
 		VkPhysicalDeviceFeatures available{};
 		VkPhysicalDeviceFeatures enabled{};
+		// Only filled in if EXT_descriptor_indexing is enabled.
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT availableDescriptorIndexing{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT enabledDescriptorIndexing{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+		// Only filled in if EXT_graphics_pipeline_library is enabled.
+		VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT availableGraphicsPipelineLibrary{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
+		VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT enabledGraphicsPipelineLibrary{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
 	};
 
 	const PhysicalDeviceFeatures &GetDeviceFeatures() const { return deviceFeatures_; }
@@ -367,6 +384,7 @@ class VulkanContext {
 	VkInstance instance_ = VK_NULL_HANDLE;
 	VkDevice device_ = VK_NULL_HANDLE;
 	VkQueue gfx_queue_ = VK_NULL_HANDLE;
+	VkQueue transfer_queue_ = VK_NULL_HANDLE;
 	VkSurfaceKHR surface_ = VK_NULL_HANDLE;
 
 	std::string init_error_;
@@ -388,6 +406,7 @@ class VulkanContext {
 	int physical_device_ = -1;
 
 	uint32_t graphics_queue_family_index_ = -1;
+	int transfer_queue_family_index_ = -1;
 	std::vector<PhysicalDeviceProps> physicalDeviceProperties_;
 	std::vector<VkQueueFamilyProperties> queueFamilyProperties_;
 	VkPhysicalDeviceMemoryProperties memory_properties{};
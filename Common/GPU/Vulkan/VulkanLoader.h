@@ -239,6 +239,9 @@ struct VulkanExtensions {
 	bool KHR_depth_stencil_resolve;
 	bool EXT_shader_stencil_export;
 	bool EXT_swapchain_colorspace;
+	bool EXT_descriptor_indexing;  // requires KHR_maintenance3
+	bool KHR_pipeline_library;
+	bool EXT_graphics_pipeline_library;  // requires KHR_pipeline_library
 	// bool EXT_depth_range_unrestricted;  // Allows depth outside [0.0, 1.0] in 32-bit float depth buffers.
 };
 
@@ -77,6 +77,7 @@ void VulkanPushBuffer::NextBuffer(size_t minSize) {
 	if (type_ == PushBufferType::CPU_TO_GPU)
 		Unmap();
 
+	overflows_++;
 	buf_++;
 	if (buf_ >= buffers_.size() || minSize > size_) {
 		// Before creating the buffer, adjust to the new size_ if necessary.
@@ -99,12 +100,12 @@ void VulkanPushBuffer::NextBuffer(size_t minSize) {
 }
 
 void VulkanPushBuffer::Defragment(VulkanContext *vulkan) {
-	if (buffers_.size() <= 1) {
+	if (buffers_.size() <= 1 && size_ >= reserveSize_) {
 		return;
 	}
 
-	// Okay, we have more than one.  Destroy them all and start over with a larger one.
-	size_t newSize = size_ * buffers_.size();
+	// Okay, we have more than one (or a reservation). Destroy them all and start over with a larger one.
+	size_t newSize = std::max(size_ * buffers_.size(), reserveSize_);
 	Destroy(vulkan);
 
 	size_ = newSize;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <vector>
@@ -40,12 +41,17 @@ class VulkanPushBuffer {
 
 	void Destroy(VulkanContext *vulkan);
 
-	void Reset() { offset_ = 0; }
+	void Reset() {
+		UpdatePeak();
+		offset_ = 0;
+	}
 
 	// Needs context in case of defragment.
 	void Begin(VulkanContext *vulkan) {
+		UpdatePeak();
 		buf_ = 0;
 		offset_ = 0;
+		alignWaste_ = 0;
 		// Note: we must defrag because some buffers may be smaller than size_.
 		Defragment(vulkan);
 		if (type_ == PushBufferType::CPU_TO_GPU)
@@ -91,7 +97,7 @@ class VulkanPushBuffer {
 
 	uint32_t PushAligned(const void *data, size_t size, int align, VkBuffer *vkbuf) {
 		_dbg_assert_(writePtr_);
-		offset_ = (offset_ + align - 1) & ~(align - 1);
+		Align(align);
 		size_t off = Allocate(size, vkbuf);
 		memcpy(writePtr_ + off, data, size);
 		return (uint32_t)off;
@@ -111,7 +117,7 @@ class VulkanPushBuffer {
 	}
 	void *PushAligned(size_t size, uint32_t *bindOffset, VkBuffer *vkbuf, int align) {
 		_dbg_assert_(writePtr_);
-		offset_ = (offset_ + align - 1) & ~(align - 1);
+		Align(align);
 		size_t off = Allocate(size, vkbuf);
 		*bindOffset = (uint32_t)off;
 		return writePtr_ + off;
@@ -119,7 +125,34 @@ class VulkanPushBuffer {
 
 	size_t GetTotalSize() const;
 
+	// Makes the next Begin() switch to a single buffer of at least this size, if it's bigger than what we have.
+	// Used to presize from a previously seen peak, so we don't have to get there by adding buffers mid-frame.
+	void Reserve(size_t size) {
+		reserveSize_ = size;
+	}
+	// Largest GetTotalSize() seen at the end of a frame.
+	size_t GetPeakSize() const {
+		return peakSize_;
+	}
+	// Bytes skipped for alignment since the last Begin().
+	size_t GetAlignWaste() const {
+		return alignWaste_;
+	}
+	// Number of times we ran out of space mid-frame and had to add a buffer.
+	int GetOverflowCount() const {
+		return overflows_;
+	}
+
 private:
+	void Align(int align) {
+		size_t aligned = (offset_ + align - 1) & ~(align - 1);
+		alignWaste_ += aligned - offset_;
+		offset_ = aligned;
+	}
+	void UpdatePeak() {
+		peakSize_ = std::max(peakSize_, GetTotalSize());
+	}
+
 	bool AddBuffer();
 	void NextBuffer(size_t minSize);
 	void Defragment(VulkanContext *vulkan);
@@ -134,6 +167,11 @@ class VulkanPushBuffer {
 	uint8_t *writePtr_ = nullptr;
 	VkBufferUsageFlags usage_;
 	const char *name_;
+
+	size_t reserveSize_ = 0;
+	size_t peakSize_ = 0;
+	size_t alignWaste_ = 0;
+	int overflows_ = 0;
 };
 
 // Only appropriate for use in a per-frame pool.
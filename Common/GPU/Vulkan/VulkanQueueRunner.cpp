@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <unordered_map>
 
 #include "Common/GPU/DataFormat.h"
@@ -5,6 +6,8 @@
 #include "Common/GPU/Vulkan/VulkanRenderManager.h"
 #include "Common/Log.h"
 #include "Common/TimeUtil.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 
 using namespace PPSSPP_VK;
 
@@ -48,30 +51,35 @@ void VulkanQueueRunner::CreateDeviceObjects() {
 #endif
 }
 
-void VulkanQueueRunner::ResizeReadbackBuffer(VkDeviceSize requiredSize) {
-	if (readbackBuffer_ && requiredSize <= readbackBufferSize_) {
-		return;
+void CachedReadback::Destroy(VulkanContext *vulkan) {
+	if (memory) {
+		vulkan->Delete().QueueDeleteDeviceMemory(memory);
 	}
-	if (readbackMemory_) {
-		vulkan_->Delete().QueueDeleteDeviceMemory(readbackMemory_);
+	if (buffer) {
+		vulkan->Delete().QueueDeleteBuffer(buffer);
 	}
-	if (readbackBuffer_) {
-		vulkan_->Delete().QueueDeleteBuffer(readbackBuffer_);
+	bufferSize = 0;
+}
+
+void VulkanQueueRunner::ResizeReadbackBuffer(CachedReadback *readback, VkDeviceSize requiredSize) {
+	if (readback->buffer && requiredSize <= readback->bufferSize) {
+		return;
 	}
+	readback->Destroy(vulkan_);
 
-	readbackBufferSize_ = requiredSize;
+	readback->bufferSize = requiredSize;
 
 	VkDevice device = vulkan_->GetDevice();
 
 	VkBufferCreateInfo buf{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-	buf.size = readbackBufferSize_;
+	buf.size = readback->bufferSize;
 	buf.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 
-	VkResult res = vkCreateBuffer(device, &buf, nullptr, &readbackBuffer_);
+	VkResult res = vkCreateBuffer(device, &buf, nullptr, &readback->buffer);
 	_assert_(res == VK_SUCCESS);
 
 	VkMemoryRequirements reqs{};
-	vkGetBufferMemoryRequirements(device, readbackBuffer_, &reqs);
+	vkGetBufferMemoryRequirements(device, readback->buffer, &reqs);
 
 	VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
 	allocInfo.allocationSize = reqs.size;
@@ -92,28 +100,23 @@ void VulkanQueueRunner::ResizeReadbackBuffer(VkDeviceSize requiredSize) {
 		}
 	}
 	_assert_(successTypeReqs != 0);
-	readbackBufferIsCoherent_ = (successTypeReqs & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	readback->isCoherent = (successTypeReqs & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
 
-	res = vkAllocateMemory(device, &allocInfo, nullptr, &readbackMemory_);
+	res = vkAllocateMemory(device, &allocInfo, nullptr, &readback->memory);
 	if (res != VK_SUCCESS) {
-		readbackMemory_ = VK_NULL_HANDLE;
-		vkDestroyBuffer(device, readbackBuffer_, nullptr);
-		readbackBuffer_ = VK_NULL_HANDLE;
+		readback->memory = VK_NULL_HANDLE;
+		vkDestroyBuffer(device, readback->buffer, nullptr);
+		readback->buffer = VK_NULL_HANDLE;
+		readback->bufferSize = 0;
 		return;
 	}
 	uint32_t offset = 0;
-	vkBindBufferMemory(device, readbackBuffer_, readbackMemory_, offset);
+	vkBindBufferMemory(device, readback->buffer, readback->memory, offset);
 }
 
 void VulkanQueueRunner::DestroyDeviceObjects() {
 	INFO_LOG(G3D, "VulkanQueueRunner::DestroyDeviceObjects");
-	if (readbackMemory_) {
-		vulkan_->Delete().QueueDeleteDeviceMemory(readbackMemory_);
-	}
-	if (readbackBuffer_) {
-		vulkan_->Delete().QueueDeleteBuffer(readbackBuffer_);
-	}
-	readbackBufferSize_ = 0;
+	syncReadback_.Destroy(vulkan_);
 
 	renderPasses_.Iterate([&](const RPKey &rpkey, VkRenderPass rp) {
 		_assert_(rp != VK_NULL_HANDLE);
@@ -298,41 +301,82 @@ void VulkanQueueRunner::PreprocessSteps(std::vector<VKRStep *> &steps) {
 		}
 	}
 
+	auto renderHasClear = [](const VKRStep *step) {
+		const auto &r = step->render;
+		return r.colorLoad == VKRRenderPassLoadAction::CLEAR || r.depthLoad == VKRRenderPassLoadAction::CLEAR || r.stencilLoad == VKRRenderPassLoadAction::CLEAR;
+	};
+
+	for (int j = 0; j < (int)steps.size(); j++) {
+		// Drop renderpasses that don't draw, clear or get read from. Each one would otherwise cost a full load/store
+		// of the tiles on mobile GPUs. The backbuffer pass is always kept.
+		// Later steps transition from whatever layout the images are in, so skipping the final transition is fine.
+		VKRStep *step = steps[j];
+		if (step->stepType == VKRStepType::RENDER && step->render.framebuffer &&
+			step->render.numDraws == 0 &&
+			step->render.numReads == 0 &&
+			step->render.colorLoad == VKRRenderPassLoadAction::KEEP &&
+			step->render.depthLoad == VKRRenderPassLoadAction::KEEP &&
+			step->render.stencilLoad == VKRRenderPassLoadAction::KEEP) {
+			step->dependencies.clear();
+			step->stepType = VKRStepType::RENDER_SKIP;
+		}
+	}
+
 	for (int j = 0; j < (int)steps.size() - 1; j++) {
 		// Push down empty "Clear/Store" renderpasses, and merge them with the first "Load/Store" to the same framebuffer.
-		if (steps.size() > 1 && steps[j]->stepType == VKRStepType::RENDER &&
-			steps[j]->render.numDraws == 0 &&
-			steps[j]->render.numReads == 0 &&
-			steps[j]->render.colorLoad == VKRRenderPassLoadAction::CLEAR &&
+		// Partial clears (for example color only) can be pushed down too, as long as it's not the backbuffer,
+		// since the KEEP aspects are kept by the later pass anyway.
+		if (steps[j]->stepType != VKRStepType::RENDER)
+			continue;
+		const bool fullClear = steps[j]->render.colorLoad == VKRRenderPassLoadAction::CLEAR &&
 			steps[j]->render.stencilLoad == VKRRenderPassLoadAction::CLEAR &&
-			steps[j]->render.depthLoad == VKRRenderPassLoadAction::CLEAR) {
+			steps[j]->render.depthLoad == VKRRenderPassLoadAction::CLEAR;
+		if (steps[j]->render.numDraws == 0 &&
+			steps[j]->render.numReads == 0 &&
+			(fullClear || (steps[j]->render.framebuffer && renderHasClear(steps[j])))) {
+			VKRFramebuffer *fb = steps[j]->render.framebuffer;
 
 			// Drop the clear step, and merge it into the next step that touches the same framebuffer.
 			for (int i = j + 1; i < (int)steps.size(); i++) {
 				if (steps[i]->stepType == VKRStepType::RENDER &&
-					steps[i]->render.framebuffer == steps[j]->render.framebuffer) {
-					if (steps[i]->render.colorLoad != VKRRenderPassLoadAction::CLEAR) {
+					steps[i]->render.framebuffer == fb) {
+					if (steps[j]->render.colorLoad == VKRRenderPassLoadAction::CLEAR && steps[i]->render.colorLoad != VKRRenderPassLoadAction::CLEAR) {
 						steps[i]->render.colorLoad = VKRRenderPassLoadAction::CLEAR;
 						steps[i]->render.clearColor = steps[j]->render.clearColor;
 					}
-					if (steps[i]->render.depthLoad != VKRRenderPassLoadAction::CLEAR) {
+					if (steps[j]->render.depthLoad == VKRRenderPassLoadAction::CLEAR && steps[i]->render.depthLoad != VKRRenderPassLoadAction::CLEAR) {
 						steps[i]->render.depthLoad = VKRRenderPassLoadAction::CLEAR;
 						steps[i]->render.clearDepth = steps[j]->render.clearDepth;
 					}
-					if (steps[i]->render.stencilLoad != VKRRenderPassLoadAction::CLEAR) {
+					if (steps[j]->render.stencilLoad == VKRRenderPassLoadAction::CLEAR && steps[i]->render.stencilLoad != VKRRenderPassLoadAction::CLEAR) {
 						steps[i]->render.stencilLoad = VKRRenderPassLoadAction::CLEAR;
 						steps[i]->render.clearStencil = steps[j]->render.clearStencil;
 					}
 					MergeRenderAreaRectInto(&steps[i]->render.renderArea, steps[j]->render.renderArea);
 
 					// Cheaply skip the first step.
+					steps[j]->dependencies.clear();
 					steps[j]->stepType = VKRStepType::RENDER_SKIP;
 					break;
-				} else if (steps[i]->stepType == VKRStepType::COPY &&
-					steps[i]->copy.src == steps[j]->render.framebuffer) {
-					// Can't eliminate the clear if a game copies from it before it's
-					// rendered to. However this should be rare.
-					// TODO: This should never happen when we check numReads now.
+				}
+
+				// Can't move the clear past anything else that reads or writes the framebuffer.
+				// These should be rare now that we check numReads, but copies into it can happen.
+				bool touchesFb = steps[i]->dependencies.contains(fb);
+				switch (steps[i]->stepType) {
+				case VKRStepType::COPY:
+					touchesFb = touchesFb || steps[i]->copy.src == fb || steps[i]->copy.dst == fb;
+					break;
+				case VKRStepType::BLIT:
+					touchesFb = touchesFb || steps[i]->blit.src == fb || steps[i]->blit.dst == fb;
+					break;
+				case VKRStepType::READBACK:
+					touchesFb = touchesFb || steps[i]->readback.src == fb;
+					break;
+				default:
+					break;
+				}
+				if (touchesFb) {
 					break;
 				}
 			}
@@ -354,9 +398,17 @@ void VulkanQueueRunner::PreprocessSteps(std::vector<VKRStep *> &steps) {
 	}
 }
 
-void VulkanQueueRunner::RunSteps(VkCommandBuffer cmd, std::vector<VKRStep *> &steps, QueueProfileContext *profile) {
-	if (profile)
+void VulkanQueueRunner::RunSteps(VkCommandBuffer cmd, std::vector<VKRStep *> &steps, QueueProfileContext *profile, SecondaryCommandPools *secondaryPools) {
+	if (profile) {
 		profile->cpuStartTime = time_now_d();
+		profile->recordThreadTimes.clear();
+		profile->recordThreadPasses.clear();
+	}
+
+	secondaryCmds_.clear();
+	if (parallelRecording_ && secondaryPools) {
+		RecordSecondaryCommandBuffers(steps, secondaryPools, profile);
+	}
 
 	bool emitLabels = vulkan_->Extensions().EXT_debug_utils;
 	for (size_t i = 0; i < steps.size(); i++) {
@@ -370,7 +422,7 @@ void VulkanQueueRunner::RunSteps(VkCommandBuffer cmd, std::vector<VKRStep *> &st
 
 		switch (step.stepType) {
 		case VKRStepType::RENDER:
-			PerformRenderPass(step, cmd);
+			PerformRenderPass(step, cmd, i < secondaryCmds_.size() ? secondaryCmds_[i] : VK_NULL_HANDLE);
 			break;
 		case VKRStepType::COPY:
 			PerformCopy(step, cmd);
@@ -398,6 +450,9 @@ void VulkanQueueRunner::RunSteps(VkCommandBuffer cmd, std::vector<VKRStep *> &st
 		}
 	}
 
+	// The last render pass may have left its final transitions pending.
+	recordBarrier_.Flush(cmd);
+
 	// Deleting all in one go should be easier on the instruction cache than deleting
 	// them as we go - and easier to debug because we can look backwards in the frame.
 	for (size_t i = 0; i < steps.size(); i++) {
@@ -408,6 +463,177 @@ void VulkanQueueRunner::RunSteps(VkCommandBuffer cmd, std::vector<VKRStep *> &st
 		profile->cpuEndTime = time_now_d();
 }
 
+void SecondaryCommandPools::Create(VulkanContext *vulkan) {
+	VkCommandPoolCreateInfo cmd_pool_info = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	cmd_pool_info.queueFamilyIndex = vulkan->GetGraphicsQueueFamilyIndex();
+	cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	for (int i = 0; i < MAX_SLOTS; i++) {
+		VkResult res = vkCreateCommandPool(vulkan->GetDevice(), &cmd_pool_info, nullptr, &pools[i]);
+		_assert_(res == VK_SUCCESS);
+		used[i] = 0;
+	}
+}
+
+void SecondaryCommandPools::Destroy(VulkanContext *vulkan) {
+	for (int i = 0; i < MAX_SLOTS; i++) {
+		if (pools[i] != VK_NULL_HANDLE) {
+			// Frees the command buffers too.
+			vkDestroyCommandPool(vulkan->GetDevice(), pools[i], nullptr);
+			pools[i] = VK_NULL_HANDLE;
+		}
+		buffers[i].clear();
+		used[i] = 0;
+	}
+}
+
+void SecondaryCommandPools::Reset(VulkanContext *vulkan) {
+	for (int i = 0; i < MAX_SLOTS; i++) {
+		// Skip the call for slots that weren't used since the last reset.
+		if (used[i] != 0) {
+			vkResetCommandPool(vulkan->GetDevice(), pools[i], 0);
+			used[i] = 0;
+		}
+	}
+}
+
+VkCommandBuffer SecondaryCommandPools::Allocate(VulkanContext *vulkan, int slot) {
+	if (used[slot] < (int)buffers[slot].size()) {
+		// Reset along with the pool, can just be begun again.
+		return buffers[slot][used[slot]++];
+	}
+
+	VkCommandBufferAllocateInfo cmd_alloc = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	cmd_alloc.commandPool = pools[slot];
+	cmd_alloc.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	cmd_alloc.commandBufferCount = 1;
+	VkCommandBuffer cmd = VK_NULL_HANDLE;
+	VkResult res = vkAllocateCommandBuffers(vulkan->GetDevice(), &cmd_alloc, &cmd);
+	if (res != VK_SUCCESS) {
+		return VK_NULL_HANDLE;
+	}
+	buffers[slot].push_back(cmd);
+	used[slot]++;
+	return cmd;
+}
+
+// Checks that a render pass can be recorded without depending on anything recorded before it
+// in the primary command buffer, and without having to wait for the compile thread (which also uses
+// the thread pool, so we could deadlock if all the workers sit waiting on it).
+static bool CanRecordOnWorker(const VKRStep &step, int minCommands) {
+	if (step.stepType != VKRStepType::RENDER || (int)step.commands.size() < minCommands) {
+		return false;
+	}
+
+	bool pipelineBound = false;
+	for (const auto &c : step.commands) {
+		switch (c.cmd) {
+		case VKRRenderCommand::BIND_PIPELINE:
+			pipelineBound = true;
+			break;
+		case VKRRenderCommand::BIND_GRAPHICS_PIPELINE:
+		{
+			const VKRGraphicsPipeline *pipeline = c.graphics_pipeline.pipeline;
+			if (pipeline->Pending() && !(pipeline->fallback && pipeline->fallback->pipeline != VK_NULL_HANDLE)) {
+				return false;
+			}
+			pipelineBound = true;
+			break;
+		}
+		case VKRRenderCommand::BIND_COMPUTE_PIPELINE:
+			if (c.compute_pipeline.pipeline->Pending()) {
+				return false;
+			}
+			break;
+		case VKRRenderCommand::DRAW:
+		case VKRRenderCommand::DRAW_INDEXED:
+			// Pipeline bindings carry over between passes in the primary, but not into a secondary.
+			if (!pipelineBound) {
+				return false;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
+void VulkanQueueRunner::RecordSecondaryCommandBuffers(const std::vector<VKRStep *> &steps, SecondaryCommandPools *pools, QueueProfileContext *profile) {
+	std::vector<int> candidates;
+	size_t totalCommands = 0;
+	for (int i = 0; i < (int)steps.size(); i++) {
+		if (CanRecordOnWorker(*steps[i], PARALLEL_RECORD_MIN_COMMANDS)) {
+			candidates.push_back(i);
+			totalCommands += steps[i]->commands.size();
+		}
+	}
+
+	int numSlots = std::min((int)SecondaryCommandPools::MAX_SLOTS, g_threadManager.GetNumLooperThreads());
+	numSlots = std::min(numSlots, (int)candidates.size());
+	if (numSlots < 2) {
+		// Not worth the overhead, record everything inline as usual.
+		return;
+	}
+
+	// Split the passes into runs with about the same amount of commands, one per slot.
+	// The passes stay in order, it doesn't really matter but makes it easier to debug.
+	std::vector<int> slotOf(candidates.size());
+	size_t commandsBefore = 0;
+	for (size_t k = 0; k < candidates.size(); k++) {
+		slotOf[k] = std::min(numSlots - 1, (int)(commandsBefore * numSlots / totalCommands));
+		commandsBefore += steps[candidates[k]]->commands.size();
+	}
+
+	secondaryCmds_.resize(steps.size(), VK_NULL_HANDLE);
+	if (profile) {
+		profile->recordThreadTimes.assign(numSlots, 0.0);
+		profile->recordThreadPasses.assign(numSlots, 0);
+	}
+
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		for (int slot = lower; slot < upper; slot++) {
+			double startTime = time_now_d();
+			int passes = 0;
+			for (size_t k = 0; k < candidates.size(); k++) {
+				if (slotOf[k] != slot) {
+					continue;
+				}
+
+				const VKRStep &step = *steps[candidates[k]];
+				VkCommandBuffer cmd = pools->Allocate(vulkan_, slot);
+				if (cmd == VK_NULL_HANDLE) {
+					// Will get recorded inline instead.
+					continue;
+				}
+
+				// All our framebuffers are compatible with the precached framebuffer render pass.
+				VkCommandBufferInheritanceInfo inheritance{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+				inheritance.renderPass = step.render.framebuffer ? framebufferRenderPass_ : backbufferRenderPass_;
+				inheritance.subpass = 0;
+				inheritance.framebuffer = step.render.framebuffer ? step.render.framebuffer->framebuf : backbuffer_;
+
+				VkCommandBufferBeginInfo begin{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+				begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+				begin.pInheritanceInfo = &inheritance;
+				VkResult res = vkBeginCommandBuffer(cmd, &begin);
+				_assert_msg_(res == VK_SUCCESS, "vkBeginCommandBuffer failed! result=%s", VulkanResultToString(res));
+
+				RecordRenderCommands(step, cmd);
+
+				res = vkEndCommandBuffer(cmd);
+				_assert_msg_(res == VK_SUCCESS, "vkEndCommandBuffer failed! result=%s", VulkanResultToString(res));
+				secondaryCmds_[candidates[k]] = cmd;
+				passes++;
+			}
+
+			if (profile) {
+				profile->recordThreadTimes[slot] = time_now_d() - startTime;
+				profile->recordThreadPasses[slot] = passes;
+			}
+		}
+	}, 0, numSlots, 1);
+}
+
 void VulkanQueueRunner::ApplyMGSHack(std::vector<VKRStep *> &steps) {
 	// Really need a sane way to express transforms of steps.
 
@@ -980,33 +1206,27 @@ void TransitionToOptimal(VkCommandBuffer cmd, VkImage colorImage, VkImageLayout
 	}
 }
 
-void TransitionFromOptimal(VkCommandBuffer cmd, VkImage colorImage, VkImageLayout colorLayout, VkImage depthStencilImage, VkImageLayout depthStencilLayout) {
-	VkPipelineStageFlags srcStageMask = 0;
-	VkPipelineStageFlags dstStageMask = 0;
-
-	// If layouts aren't optimal, transition them.
-	VkImageMemoryBarrier barrier[2]{};
-
-	int barrierCount = 0;
+// Records the transitions out of the attachment layouts into recordBarrier, instead of issuing
+// them directly. They'll get flushed together with the transitions of whatever step comes next,
+// so we end up with one barrier between passes instead of two.
+void TransitionFromOptimal(VkImage colorImage, VkImageLayout colorLayout, VkImage depthStencilImage, VkImageLayout depthStencilLayout, VulkanBarrier *recordBarrier) {
 	if (colorLayout != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) {
-		barrier[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier[0].pNext = nullptr;
-		srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		barrier[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		VkAccessFlags dstAccessMask = 0;
+		VkPipelineStageFlags dstStageMask = 0;
 		// And the final transition.
 		// Don't need to transition it if VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL.
 		switch (colorLayout) {
 		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-			barrier[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			dstStageMask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 			break;
 		case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-			barrier[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
 			break;
 		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-			barrier[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
 			break;
 		case VK_IMAGE_LAYOUT_UNDEFINED:
 		case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
@@ -1016,36 +1236,29 @@ void TransitionFromOptimal(VkCommandBuffer cmd, VkImage colorImage, VkImageLayou
 			_dbg_assert_msg_(false, "GetRenderPass: Unexpected final color layout %d", (int)colorLayout);
 			break;
 		}
-		barrier[0].oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		barrier[0].newLayout = colorLayout;
-		barrier[0].image = colorImage;
-		barrier[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier[0].subresourceRange.baseMipLevel = 0;
-		barrier[0].subresourceRange.levelCount = 1;
-		barrier[0].subresourceRange.layerCount = 1;
-		barrier[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrierCount++;
+		recordBarrier->TransitionImage(
+			colorImage, 0, 1, VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, colorLayout,
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, dstAccessMask,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, dstStageMask
+		);
 	}
 
 	if (depthStencilImage && depthStencilLayout != VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-		barrier[barrierCount].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier[barrierCount].pNext = nullptr;
-
-		srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-		barrier[barrierCount].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		VkAccessFlags dstAccessMask = 0;
+		VkPipelineStageFlags dstStageMask = 0;
 		switch (depthStencilLayout) {
 		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-			barrier[barrierCount].dstAccessMask |= VK_ACCESS_SHADER_READ_BIT;
-			dstStageMask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 			break;
 		case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-			barrier[barrierCount].dstAccessMask |= VK_ACCESS_TRANSFER_READ_BIT;
-			dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
 			break;
 		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-			barrier[barrierCount].dstAccessMask |= VK_ACCESS_TRANSFER_READ_BIT;
-			dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
 			break;
 		case VK_IMAGE_LAYOUT_UNDEFINED:
 		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
@@ -1055,23 +1268,16 @@ void TransitionFromOptimal(VkCommandBuffer cmd, VkImage colorImage, VkImageLayou
 			_dbg_assert_msg_(false, "GetRenderPass: Unexpected final depth layout %d", (int)depthStencilLayout);
 			break;
 		}
-		barrier[barrierCount].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-		barrier[barrierCount].newLayout = depthStencilLayout;
-		barrier[barrierCount].image = depthStencilImage;
-		barrier[barrierCount].subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
-		barrier[barrierCount].subresourceRange.baseMipLevel = 0;
-		barrier[barrierCount].subresourceRange.levelCount = 1;
-		barrier[barrierCount].subresourceRange.layerCount = 1;
-		barrier[barrierCount].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier[barrierCount].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrierCount++;
-	}
-	if (barrierCount) {
-		vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, VK_DEPENDENCY_BY_REGION_BIT, 0, nullptr, 0, nullptr, barrierCount, barrier);
+		recordBarrier->TransitionImage(
+			depthStencilImage, 0, 1, VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, depthStencilLayout,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, dstAccessMask,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, dstStageMask
+		);
 	}
 }
 
-void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer cmd) {
+void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer cmd, VkCommandBuffer secondaryCmd) {
 	for (const auto &iter : step.preTransitions) {
 		if (iter.aspect == VK_IMAGE_ASPECT_COLOR_BIT && iter.fb->color.layout != iter.targetLayout) {
 			recordBarrier_.TransitionImageAuto(
@@ -1147,8 +1353,28 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 	// This reads the layout of the color and depth images, and chooses a render pass using them that
 	// will transition to the desired final layout.
 	// NOTE: Flushes recordBarrier_.
-	PerformBindFramebufferAsRenderTarget(step, cmd);
+	PerformBindFramebufferAsRenderTarget(step, cmd, secondaryCmd ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+
+	if (secondaryCmd) {
+		// Already recorded on a worker thread.
+		vkCmdExecuteCommands(cmd, 1, &secondaryCmd);
+	} else {
+		RecordRenderCommands(step, cmd);
+	}
+	vkCmdEndRenderPass(cmd);
 
+	VKRFramebuffer *fb = step.render.framebuffer;
+	if (fb) {
+		// If the desired final layout aren't the optimal layout for rendering, transition.
+		// These are only recorded here, the next step (or the end of RunSteps) flushes them.
+		TransitionFromOptimal(fb->color.image, step.render.finalColorLayout, fb->depth.image, step.render.finalDepthStencilLayout, &recordBarrier_);
+
+		fb->color.layout = step.render.finalColorLayout;
+		fb->depth.layout = step.render.finalDepthStencilLayout;
+	}
+}
+
+void VulkanQueueRunner::RecordRenderCommands(const VKRStep &step, VkCommandBuffer cmd) {
 	int curWidth = step.render.framebuffer ? step.render.framebuffer->width : vulkan_->GetBackbufferWidth();
 	int curHeight = step.render.framebuffer ? step.render.framebuffer->height : vulkan_->GetBackbufferHeight();
 
@@ -1190,6 +1416,10 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 		case VKRRenderCommand::BIND_GRAPHICS_PIPELINE:
 		{
 			VKRGraphicsPipeline *pipeline = c.graphics_pipeline.pipeline;
+			if (pipeline->Pending() && pipeline->fallback && pipeline->fallback->pipeline != VK_NULL_HANDLE) {
+				// Still compiling, draw with the compatible fallback rather than stalling.
+				pipeline = pipeline->fallback;
+			}
 			if (pipeline->Pending()) {
 				// Stall processing, waiting for the compile queue to catch up.
 				std::unique_lock<std::mutex> lock(compileDoneMutex_);
@@ -1288,14 +1518,26 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 			break;
 
 		case VKRRenderCommand::DRAW_INDEXED:
-			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, c.drawIndexed.pipelineLayout, 0, 1, &c.drawIndexed.ds, c.drawIndexed.numUboOffsets, c.drawIndexed.uboOffsets);
+			if (c.drawIndexed.bindlessDs) {
+				const VkDescriptorSet sets[2] = { c.drawIndexed.ds, c.drawIndexed.bindlessDs };
+				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, c.drawIndexed.pipelineLayout, 0, 2, sets, c.drawIndexed.numUboOffsets, c.drawIndexed.uboOffsets);
+				vkCmdPushConstants(cmd, c.drawIndexed.pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t), &c.drawIndexed.bindlessIndex);
+			} else {
+				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, c.drawIndexed.pipelineLayout, 0, 1, &c.drawIndexed.ds, c.drawIndexed.numUboOffsets, c.drawIndexed.uboOffsets);
+			}
 			vkCmdBindIndexBuffer(cmd, c.drawIndexed.ibuffer, c.drawIndexed.ioffset, c.drawIndexed.indexType);
 			vkCmdBindVertexBuffers(cmd, 0, 1, &c.drawIndexed.vbuffer, &c.drawIndexed.voffset);
 			vkCmdDrawIndexed(cmd, c.drawIndexed.count, c.drawIndexed.instances, 0, 0, 0);
 			break;
 
 		case VKRRenderCommand::DRAW:
-			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, c.draw.pipelineLayout, 0, 1, &c.draw.ds, c.draw.numUboOffsets, c.draw.uboOffsets);
+			if (c.draw.bindlessDs) {
+				const VkDescriptorSet sets[2] = { c.draw.ds, c.draw.bindlessDs };
+				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, c.draw.pipelineLayout, 0, 2, sets, c.draw.numUboOffsets, c.draw.uboOffsets);
+				vkCmdPushConstants(cmd, c.draw.pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t), &c.draw.bindlessIndex);
+			} else {
+				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, c.draw.pipelineLayout, 0, 1, &c.draw.ds, c.draw.numUboOffsets, c.draw.uboOffsets);
+			}
 			if (c.draw.vbuffer) {
 				vkCmdBindVertexBuffers(cmd, 0, 1, &c.draw.vbuffer, &c.draw.voffset);
 			}
@@ -1340,18 +1582,9 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 			;
 		}
 	}
-	vkCmdEndRenderPass(cmd);
-
-	if (fb) {
-		// If the desired final layout aren't the optimal layout for rendering, transition.
-		TransitionFromOptimal(cmd, fb->color.image, step.render.finalColorLayout, fb->depth.image, step.render.finalDepthStencilLayout);
-
-		fb->color.layout = step.render.finalColorLayout;
-		fb->depth.layout = step.render.finalDepthStencilLayout;
-	}
 }
 
-void VulkanQueueRunner::PerformBindFramebufferAsRenderTarget(const VKRStep &step, VkCommandBuffer cmd) {
+void VulkanQueueRunner::PerformBindFramebufferAsRenderTarget(const VKRStep &step, VkCommandBuffer cmd, VkSubpassContents contents) {
 	VkRenderPass renderPass;
 	int numClearVals = 0;
 	VkClearValue clearVal[2]{};
@@ -1433,7 +1666,7 @@ void VulkanQueueRunner::PerformBindFramebufferAsRenderTarget(const VKRStep &step
 	rp_begin.renderArea = rc;
 	rp_begin.clearValueCount = numClearVals;
 	rp_begin.pClearValues = numClearVals ? clearVal : nullptr;
-	vkCmdBeginRenderPass(cmd, &rp_begin, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(cmd, &rp_begin, contents);
 }
 
 void VulkanQueueRunner::PerformCopy(const VKRStep &step, VkCommandBuffer cmd) {
@@ -1672,7 +1905,10 @@ void VulkanQueueRunner::SetupTransitionToTransferDst(VKRImage &img, VkImageAspec
 }
 
 void VulkanQueueRunner::PerformReadback(const VKRStep &step, VkCommandBuffer cmd) {
-	ResizeReadbackBuffer(sizeof(uint32_t) * step.readback.srcRect.extent.width * step.readback.srcRect.extent.height);
+	CachedReadback *readback = step.readback.delayed ? step.readback.delayed : &syncReadback_;
+	ResizeReadbackBuffer(readback, sizeof(uint32_t) * step.readback.srcRect.extent.width * step.readback.srcRect.extent.height);
+	if (!readback->buffer)
+		return;  // Allocation failed, nothing to copy into.
 
 	VkBufferImageCopy region{};
 	region.imageOffset = { step.readback.srcRect.offset.x, step.readback.srcRect.offset.y, 0 };
@@ -1708,13 +1944,14 @@ void VulkanQueueRunner::PerformReadback(const VKRStep &step, VkCommandBuffer cmd
 
 		if (srcImage->layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
 			SetupTransitionToTransferSrc(*srcImage, step.readback.aspectMask, &recordBarrier_);
-			recordBarrier_.Flush(cmd);
 		}
+		// Always flush, the render pass that produced the image may have left its transition pending.
+		recordBarrier_.Flush(cmd);
 		image = srcImage->image;
 		copyLayout = srcImage->layout;
 	}
 
-	vkCmdCopyImageToBuffer(cmd, image, copyLayout, readbackBuffer_, 1, &region);
+	vkCmdCopyImageToBuffer(cmd, image, copyLayout, readback->buffer, 1, &region);
 
 	// NOTE: Can't read the buffer using the CPU here - need to sync first.
 
@@ -1739,7 +1976,7 @@ void VulkanQueueRunner::PerformReadbackImage(const VKRStep &step, VkCommandBuffe
 	SetupTransitionToTransferSrc(srcImage, VK_IMAGE_ASPECT_COLOR_BIT, &recordBarrier_);
 	recordBarrier_.Flush(cmd);
 
-	ResizeReadbackBuffer(sizeof(uint32_t) * step.readback_image.srcRect.extent.width * step.readback_image.srcRect.extent.height);
+	ResizeReadbackBuffer(&syncReadback_, sizeof(uint32_t) * step.readback_image.srcRect.extent.width * step.readback_image.srcRect.extent.height);
 
 	VkBufferImageCopy region{};
 	region.imageOffset = { step.readback_image.srcRect.offset.x, step.readback_image.srcRect.offset.y, 0 };
@@ -1750,7 +1987,7 @@ void VulkanQueueRunner::PerformReadbackImage(const VKRStep &step, VkCommandBuffe
 	region.bufferOffset = 0;
 	region.bufferRowLength = step.readback_image.srcRect.extent.width;
 	region.bufferImageHeight = step.readback_image.srcRect.extent.height;
-	vkCmdCopyImageToBuffer(cmd, step.readback_image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer_, 1, &region);
+	vkCmdCopyImageToBuffer(cmd, step.readback_image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, syncReadback_.buffer, 1, &region);
 
 	// Now transfer it back to a texture.
 	TransitionImageLayout2(cmd, step.readback_image.image, 0, 1,
@@ -1763,18 +2000,18 @@ void VulkanQueueRunner::PerformReadbackImage(const VKRStep &step, VkCommandBuffe
 	// Doing that will also act like a heavyweight barrier ensuring that device writes are visible on the host.
 }
 
-void VulkanQueueRunner::CopyReadbackBuffer(int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels) {
-	if (!readbackMemory_)
-		return;  // Something has gone really wrong.
+bool VulkanQueueRunner::CopyReadbackBuffer(CachedReadback *readback, int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels) {
+	if (!readback->memory)
+		return false;  // Something has gone really wrong.
 
 	// Read back to the requested address in ram from buffer.
 	void *mappedData;
 	const size_t srcPixelSize = DataFormatSizeInBytes(srcFormat);
 
-	VkResult res = vkMapMemory(vulkan_->GetDevice(), readbackMemory_, 0, width * height * srcPixelSize, 0, &mappedData);
-	if (!readbackBufferIsCoherent_) {
+	VkResult res = vkMapMemory(vulkan_->GetDevice(), readback->memory, 0, width * height * srcPixelSize, 0, &mappedData);
+	if (!readback->isCoherent) {
 		VkMappedMemoryRange range{};
-		range.memory = readbackMemory_;
+		range.memory = readback->memory;
 		range.offset = 0;
 		range.size = width * height * srcPixelSize;
 		vkInvalidateMappedMemoryRanges(vulkan_->GetDevice(), 1, &range);
@@ -1782,7 +2019,7 @@ void VulkanQueueRunner::CopyReadbackBuffer(int width, int height, Draw::DataForm
 
 	if (res != VK_SUCCESS) {
 		ERROR_LOG(G3D, "CopyReadbackBuffer: vkMapMemory failed! result=%d", (int)res);
-		return;
+		return false;
 	}
 
 	// TODO: Perform these conversions in a compute shader on the GPU.
@@ -1806,5 +2043,6 @@ void VulkanQueueRunner::CopyReadbackBuffer(int width, int height, Draw::DataForm
 		ERROR_LOG(G3D, "CopyReadbackBuffer: Unknown format");
 		_assert_msg_(false, "CopyReadbackBuffer: Unknown src format %d", (int)srcFormat);
 	}
-	vkUnmapMemory(vulkan_->GetDevice(), readbackMemory_);
+	vkUnmapMemory(vulkan_->GetDevice(), readback->memory);
+	return true;
 }
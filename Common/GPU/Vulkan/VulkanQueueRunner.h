@@ -68,6 +68,8 @@ struct VkRenderData {
 			VkDeviceSize voffset;
 			uint32_t count;
 			uint32_t offset;
+			VkDescriptorSet bindlessDs;  // Optional, bound as set 1 with bindlessIndex as a fragment push constant.
+			uint32_t bindlessIndex;
 		} draw;
 		struct {
 			VkPipelineLayout pipelineLayout;
@@ -81,6 +83,8 @@ struct VkRenderData {
 			uint32_t count;
 			int16_t instances;
 			VkIndexType indexType;
+			VkDescriptorSet bindlessDs;
+			uint32_t bindlessIndex;
 		} drawIndexed;
 		struct {
 			uint32_t clearColor;
@@ -139,6 +143,59 @@ struct QueueProfileContext {
 	std::string profileSummary;
 	double cpuStartTime;
 	double cpuEndTime;
+	// CPU time spent by each worker recording render passes into secondary command buffers.
+	std::vector<double> recordThreadTimes;
+	std::vector<int> recordThreadPasses;
+};
+
+// Per-frame command pools for recording render passes on worker threads. Command pools
+// aren't thread safe, so each worker slot gets its own. Reset together with the main pool,
+// once the frame's commands are done executing.
+struct SecondaryCommandPools {
+	enum { MAX_SLOTS = 8 };
+
+	VkCommandPool pools[MAX_SLOTS]{};
+	std::vector<VkCommandBuffer> buffers[MAX_SLOTS];
+	int used[MAX_SLOTS]{};
+
+	void Create(VulkanContext *vulkan);
+	void Destroy(VulkanContext *vulkan);
+	void Reset(VulkanContext *vulkan);
+	// Only call from the thread currently owning the slot.
+	VkCommandBuffer Allocate(VulkanContext *vulkan, int slot);
+};
+
+// A host-visible buffer that image readbacks are copied into, before being read by the CPU.
+struct CachedReadback {
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize bufferSize = 0;
+	bool isCoherent = false;
+	// Set when requested during a frame, so the render manager can expire unused readbacks.
+	bool requested = false;
+
+	void Destroy(VulkanContext *vulkan);
+};
+
+// Identifies a delayed readback, so we can hand back the data from the last time it was requested.
+struct ReadbackKey {
+	const VKRFramebuffer *framebuf;
+	int x;
+	int y;
+	int width;
+	int height;
+
+	bool operator <(const ReadbackKey &other) const {
+		if (framebuf != other.framebuf)
+			return framebuf < other.framebuf;
+		if (x != other.x)
+			return x < other.x;
+		if (y != other.y)
+			return y < other.y;
+		if (width != other.width)
+			return width < other.width;
+		return height < other.height;
+	}
 };
 
 struct VKRStep {
@@ -186,6 +243,8 @@ struct VKRStep {
 			int aspectMask;
 			VKRFramebuffer *src;
 			VkRect2D srcRect;
+			// If set, copy into this instead of the sync readback buffer. Read on the CPU once the frame's fence is passed.
+			CachedReadback *delayed;
 		} readback;
 		struct {
 			VkImage image;
@@ -204,7 +263,8 @@ class VulkanQueueRunner {
 	}
 
 	void PreprocessSteps(std::vector<VKRStep *> &steps);
-	void RunSteps(VkCommandBuffer cmd, std::vector<VKRStep *> &steps, QueueProfileContext *profile);
+	// If secondaryPools is set and parallel recording is enabled, large render passes are recorded on worker threads.
+	void RunSteps(VkCommandBuffer cmd, std::vector<VKRStep *> &steps, QueueProfileContext *profile, SecondaryCommandPools *secondaryPools);
 	void LogSteps(const std::vector<VKRStep *> &steps, bool verbose);
 
 	std::string StepToString(const VKRStep &step) const;
@@ -226,7 +286,11 @@ class VulkanQueueRunner {
 		return (int)depth * 3 + (int)color;
 	}
 
-	void CopyReadbackBuffer(int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels);
+	void CopyReadbackBuffer(int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels) {
+		CopyReadbackBuffer(&syncReadback_, width, height, srcFormat, destFormat, pixelStride, pixels);
+	}
+	// Only call this once the frame that filled the readback has been fenced.
+	bool CopyReadbackBuffer(CachedReadback *readback, int width, int height, Draw::DataFormat srcFormat, Draw::DataFormat destFormat, int pixelStride, uint8_t *pixels);
 
 	struct RPKey {
 		VKRRenderPassLoadAction colorLoadAction;
@@ -258,6 +322,10 @@ class VulkanQueueRunner {
 		hacksEnabled_ = hacks;
 	}
 
+	void EnableParallelRecording(bool enable) {
+		parallelRecording_ = enable;
+	}
+
 	void NotifyCompileDone() {
 		compileDone_.notify_all();
 	}
@@ -270,8 +338,11 @@ class VulkanQueueRunner {
 private:
 	void InitBackbufferRenderPass();
 
-	void PerformBindFramebufferAsRenderTarget(const VKRStep &pass, VkCommandBuffer cmd);
-	void PerformRenderPass(const VKRStep &pass, VkCommandBuffer cmd);
+	void PerformBindFramebufferAsRenderTarget(const VKRStep &pass, VkCommandBuffer cmd, VkSubpassContents contents);
+	void PerformRenderPass(const VKRStep &pass, VkCommandBuffer cmd, VkCommandBuffer secondaryCmd);
+	// The contents of a render pass, between begin and end. Safe to call on worker threads.
+	void RecordRenderCommands(const VKRStep &pass, VkCommandBuffer cmd);
+	void RecordSecondaryCommandBuffers(const std::vector<VKRStep *> &steps, SecondaryCommandPools *pools, QueueProfileContext *profile);
 	void PerformCopy(const VKRStep &pass, VkCommandBuffer cmd);
 	void PerformBlit(const VKRStep &pass, VkCommandBuffer cmd);
 	void PerformReadback(const VKRStep &pass, VkCommandBuffer cmd);
@@ -283,7 +354,7 @@ class VulkanQueueRunner {
 	void LogReadback(const VKRStep &pass);
 	void LogReadbackImage(const VKRStep &pass);
 
-	void ResizeReadbackBuffer(VkDeviceSize requiredSize);
+	void ResizeReadbackBuffer(CachedReadback *readback, VkDeviceSize requiredSize);
 
 	void ApplyMGSHack(std::vector<VKRStep *> &steps);
 	void ApplySonicHack(std::vector<VKRStep *> &steps);
@@ -306,16 +377,19 @@ class VulkanQueueRunner {
 	// TODO: Create these on demand.
 	DenseHashMap<RPKey, VkRenderPass, (VkRenderPass)VK_NULL_HANDLE> renderPasses_;
 
-	// Readback buffer. Currently we only support synchronous readback, so we only really need one.
-	// We size it generously.
-	VkDeviceMemory readbackMemory_ = VK_NULL_HANDLE;
-	VkBuffer readbackBuffer_ = VK_NULL_HANDLE;
-	VkDeviceSize readbackBufferSize_ = 0;
-	bool readbackBufferIsCoherent_ = false;
+	// Readback buffer for synchronous readbacks, we only really need one. Delayed readbacks
+	// instead use per-frame buffers owned by the render manager.
+	CachedReadback syncReadback_{};
 
 	// TODO: Enable based on compat.ini.
 	uint32_t hacksEnabled_ = 0;
 
+	bool parallelRecording_ = false;
+	// Render passes with at least this many commands are worth recording on a worker.
+	static constexpr int PARALLEL_RECORD_MIN_COMMANDS = 256;
+	// Indexed like the steps passed to RunSteps, VK_NULL_HANDLE for passes recorded inline.
+	std::vector<VkCommandBuffer> secondaryCmds_;
+
 	// Compile done notifications.
 	std::mutex compileDoneMutex_;
 	std::condition_variable compileDone_;
@@ -10,6 +10,9 @@
 #include "Common/GPU/Vulkan/VulkanContext.h"
 #include "Common/GPU/Vulkan/VulkanRenderManager.h"
 
+#include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/Thread/ThreadUtil.h"
 
 #if 0 // def _DEBUG
@@ -211,6 +214,13 @@ VulkanRenderManager::VulkanRenderManager(VulkanContext *vulkan) : vulkan_(vulkan
 	res = vkCreateSemaphore(vulkan_->GetDevice(), &semaphoreCreateInfo, nullptr, &renderingCompleteSemaphore_);
 	_dbg_assert_(res == VK_SUCCESS);
 
+	// Linking only pays off if it's actually fast, otherwise we'd just compile twice.
+	usePipelineLibraries_ = vulkan_->Extensions().EXT_graphics_pipeline_library &&
+		vulkan_->GetDeviceFeatures().enabledGraphicsPipelineLibrary.graphicsPipelineLibrary &&
+		vulkan_->GetPhysicalDeviceProperties().graphicsPipelineLibraryProperties.graphicsPipelineLibraryFastLinking;
+	if (usePipelineLibraries_)
+		INFO_LOG(G3D, "Using graphics pipeline libraries");
+
 	inflightFramesAtStart_ = vulkan_->GetInflightFrames();
 	for (int i = 0; i < inflightFramesAtStart_; i++) {
 		VkCommandPoolCreateInfo cmd_pool_info = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
@@ -231,6 +241,20 @@ VulkanRenderManager::VulkanRenderManager(VulkanContext *vulkan) : vulkan_(vulkan
 		cmd_alloc.commandPool = frameData_[i].cmdPoolMain;
 		res = vkAllocateCommandBuffers(vulkan_->GetDevice(), &cmd_alloc, &frameData_[i].mainCmd);
 		_dbg_assert_(res == VK_SUCCESS);
+		frameData_[i].secondaryPools.Create(vulkan_);
+
+		if (vulkan_->GetTransferQueue()) {
+			VkCommandPoolCreateInfo transfer_pool_info = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+			transfer_pool_info.queueFamilyIndex = vulkan_->GetTransferQueueFamilyIndex();
+			transfer_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			res = vkCreateCommandPool(vulkan_->GetDevice(), &transfer_pool_info, nullptr, &frameData_[i].cmdPoolTransfer);
+			_dbg_assert_(res == VK_SUCCESS);
+			cmd_alloc.commandPool = frameData_[i].cmdPoolTransfer;
+			res = vkAllocateCommandBuffers(vulkan_->GetDevice(), &cmd_alloc, &frameData_[i].transferCmd);
+			_dbg_assert_(res == VK_SUCCESS);
+			res = vkCreateSemaphore(vulkan_->GetDevice(), &semaphoreCreateInfo, nullptr, &frameData_[i].transferSemaphore);
+			_dbg_assert_(res == VK_SUCCESS);
+		}
 
 		// Creating the frame fence with true so they can be instantly waited on the first frame
 		frameData_[i].fence = vulkan_->CreateFence(true);
@@ -370,6 +394,11 @@ void VulkanRenderManager::StopThread() {
 				vkEndCommandBuffer(frameData.initCmd);
 				frameData.hasInitCommands = false;
 			}
+			if (frameData.hasTransferCommands) {
+				vkEndCommandBuffer(frameData.transferCmd);
+				frameData.hasTransferCommands = false;
+				frameData.transferAcquires.clear();
+			}
 			frameData.readyForRun = false;
 			for (size_t i = 0; i < frameData.steps.size(); i++) {
 				delete frameData.steps[i];
@@ -420,6 +449,12 @@ VulkanRenderManager::~VulkanRenderManager() {
 
 	DrainCompileQueue();
 	VkDevice device = vulkan_->GetDevice();
+	for (auto &iter : pipelineLibraries_)
+		vkDestroyPipeline(device, iter.second, nullptr);
+	pipelineLibraries_.clear();
+	for (VkPipeline pipeline : retiredPipelines_)
+		vkDestroyPipeline(device, pipeline, nullptr);
+	retiredPipelines_.clear();
 	vkDestroySemaphore(device, acquireSemaphore_, nullptr);
 	vkDestroySemaphore(device, renderingCompleteSemaphore_, nullptr);
 	for (int i = 0; i < inflightFramesAtStart_; i++) {
@@ -427,9 +462,20 @@ VulkanRenderManager::~VulkanRenderManager() {
 		vkFreeCommandBuffers(device, frameData_[i].cmdPoolMain, 1, &frameData_[i].mainCmd);
 		vkDestroyCommandPool(device, frameData_[i].cmdPoolInit, nullptr);
 		vkDestroyCommandPool(device, frameData_[i].cmdPoolMain, nullptr);
+		if (frameData_[i].cmdPoolTransfer) {
+			vkFreeCommandBuffers(device, frameData_[i].cmdPoolTransfer, 1, &frameData_[i].transferCmd);
+			vkDestroyCommandPool(device, frameData_[i].cmdPoolTransfer, nullptr);
+			vkDestroySemaphore(device, frameData_[i].transferSemaphore, nullptr);
+		}
+		frameData_[i].secondaryPools.Destroy(vulkan_);
 		vkDestroyFence(device, frameData_[i].fence, nullptr);
 		vkDestroyFence(device, frameData_[i].readbackFence, nullptr);
 		vkDestroyQueryPool(device, frameData_[i].profile.queryPool, nullptr);
+		for (auto &iter : frameData_[i].readbacks) {
+			iter.second->Destroy(vulkan_);
+			delete iter.second;
+		}
+		frameData_[i].readbacks.clear();
 	}
 	queueRunner_.DestroyDeviceObjects();
 }
@@ -449,18 +495,233 @@ void VulkanRenderManager::CompileThreadFunc() {
 		if (!run_) {
 			break;
 		}
-		for (auto &entry : toCompile) {
-			switch (entry.type) {
-			case CompileQueueEntry::Type::GRAPHICS:
-				entry.graphics->Create(vulkan_);
-				break;
-			case CompileQueueEntry::Type::COMPUTE:
-				entry.compute->Create(vulkan_);
-				break;
+		auto compileRange = [&](int lower, int upper) {
+			for (int i = lower; i < upper; i++) {
+				PROFILE_THIS_SCOPE("pipeline");
+				CompileQueueEntry &entry = toCompile[i];
+				switch (entry.type) {
+				case CompileQueueEntry::Type::GRAPHICS:
+					if (usePipelineLibraries_ && entry.graphics->desc && LinkFromLibraries(entry.graphics)) {
+						entry.linked = true;
+					} else {
+						entry.graphics->Create(vulkan_);
+					}
+					break;
+				case CompileQueueEntry::Type::COMPUTE:
+					entry.compute->Create(vulkan_);
+					break;
+				}
+				// Wake up the queue runner in case it's waiting on this one.
+				queueRunner_.NotifyCompileDone();
 			}
+		};
+		// Pipeline creation is internally synchronized (including the pipeline cache), so a batch
+		// can be spread over the worker pool. Batches grow while the previous one is compiling,
+		// so bursts like loading the pipeline cache at boot end up parallel.
+		if (toCompile.size() > 1 && g_threadManager.GetNumLooperThreads() > 1) {
+			ParallelRangeLoop(&g_threadManager, compileRange, 0, (int)toCompile.size(), 1);
+		} else {
+			compileRange(0, (int)toCompile.size());
 		}
 		queueRunner_.NotifyCompileDone();
+
+		if (usePipelineLibraries_) {
+			// Everything in the batch is usable now, take the time to build the optimized versions.
+			auto optimizeRange = [&](int lower, int upper) {
+				for (int i = lower; i < upper; i++) {
+					PROFILE_THIS_SCOPE("pipelineopt");
+					if (toCompile[i].linked)
+						OptimizeLinkedPipeline(toCompile[i].graphics);
+				}
+			};
+			if (toCompile.size() > 1 && g_threadManager.GetNumLooperThreads() > 1) {
+				ParallelRangeLoop(&g_threadManager, optimizeRange, 0, (int)toCompile.size(), 1);
+			} else {
+				optimizeRange(0, (int)toCompile.size());
+			}
+		}
+	}
+}
+
+template <typename T>
+static void AppendLibraryKey(std::string &key, const T &value) {
+	key.append((const char *)&value, sizeof(value));
+}
+
+static void AppendDynamicStateKey(std::string &key, const VkPipelineDynamicStateCreateInfo *ds) {
+	AppendLibraryKey(key, ds->dynamicStateCount);
+	for (uint32_t i = 0; i < ds->dynamicStateCount; i++)
+		AppendLibraryKey(key, ds->pDynamicStates[i]);
+}
+
+VkPipeline VulkanRenderManager::GetPipelineLibrary(const std::string &key, VkPipelineCache cache, VkGraphicsPipelineCreateInfo &info, VkGraphicsPipelineLibraryFlagsEXT flags) {
+	{
+		std::lock_guard<std::mutex> guard(pipelineLibraryMutex_);
+		auto iter = pipelineLibraries_.find(key);
+		if (iter != pipelineLibraries_.end())
+			return iter->second;
+	}
+
+	VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT };
+	libraryInfo.flags = flags;
+	info.pNext = &libraryInfo;
+	info.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+
+	VkPipeline library = VK_NULL_HANDLE;
+	VkResult result = vkCreateGraphicsPipelines(vulkan_->GetDevice(), cache, 1, &info, nullptr, &library);
+	if (result != VK_SUCCESS) {
+		ERROR_LOG(G3D, "Failed creating pipeline library %08x: %s", flags, VulkanResultToString(result));
+		return VK_NULL_HANDLE;
+	}
+
+	std::lock_guard<std::mutex> guard(pipelineLibraryMutex_);
+	auto inserted = pipelineLibraries_.insert(std::make_pair(key, library));
+	if (!inserted.second) {
+		// Another worker built the same one meanwhile, nothing can be using ours.
+		vkDestroyPipeline(vulkan_->GetDevice(), library, nullptr);
 	}
+	return inserted.first->second;
+}
+
+bool VulkanRenderManager::LinkFromLibraries(VKRGraphicsPipeline *pipeline) {
+	const VKRGraphicsPipelineDesc *desc = pipeline->desc;
+	const VkGraphicsPipelineCreateInfo &pipe = desc->pipe;
+	VkPipeline libraries[4];
+
+	// The first byte of each key tells the parts apart. Dynamic state only matters for the parts that
+	// contain the state, but it's simplest to just key on it everywhere but the vertex input.
+	std::string key;
+	key.push_back('V');
+	AppendLibraryKey(key, desc->inputAssembly.topology);
+	AppendLibraryKey(key, desc->inputAssembly.primitiveRestartEnable);
+	AppendLibraryKey(key, desc->vis.vertexBindingDescriptionCount);
+	for (uint32_t i = 0; i < desc->vis.vertexBindingDescriptionCount; i++)
+		AppendLibraryKey(key, desc->vis.pVertexBindingDescriptions[i]);
+	AppendLibraryKey(key, desc->vis.vertexAttributeDescriptionCount);
+	for (uint32_t i = 0; i < desc->vis.vertexAttributeDescriptionCount; i++)
+		AppendLibraryKey(key, desc->vis.pVertexAttributeDescriptions[i]);
+	VkGraphicsPipelineCreateInfo vertexInput{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	vertexInput.pVertexInputState = pipe.pVertexInputState;
+	vertexInput.pInputAssemblyState = pipe.pInputAssemblyState;
+	libraries[0] = GetPipelineLibrary(key, desc->pipelineCache, vertexInput, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT);
+
+	key.clear();
+	key.push_back('P');
+	AppendLibraryKey(key, desc->shaderStageInfo[0].module);
+	AppendLibraryKey(key, pipe.layout);
+	AppendLibraryKey(key, pipe.renderPass);
+	AppendLibraryKey(key, pipe.subpass);
+	AppendLibraryKey(key, desc->rs.depthClampEnable);
+	AppendLibraryKey(key, desc->rs.rasterizerDiscardEnable);
+	AppendLibraryKey(key, desc->rs.polygonMode);
+	AppendLibraryKey(key, desc->rs.cullMode);
+	AppendLibraryKey(key, desc->rs.frontFace);
+	AppendLibraryKey(key, desc->rs.depthBiasEnable);
+	AppendLibraryKey(key, desc->rs.lineWidth);
+	AppendLibraryKey(key, desc->views.viewportCount);
+	AppendLibraryKey(key, desc->views.scissorCount);
+	AppendDynamicStateKey(key, pipe.pDynamicState);
+	VkGraphicsPipelineCreateInfo preRaster{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	preRaster.stageCount = 1;
+	preRaster.pStages = &desc->shaderStageInfo[0];
+	preRaster.pViewportState = pipe.pViewportState;
+	preRaster.pRasterizationState = pipe.pRasterizationState;
+	preRaster.pDynamicState = pipe.pDynamicState;
+	preRaster.layout = pipe.layout;
+	preRaster.renderPass = pipe.renderPass;
+	preRaster.subpass = pipe.subpass;
+	libraries[1] = GetPipelineLibrary(key, desc->pipelineCache, preRaster, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT);
+
+	key.clear();
+	key.push_back('F');
+	AppendLibraryKey(key, desc->shaderStageInfo[1].module);
+	AppendLibraryKey(key, pipe.layout);
+	AppendLibraryKey(key, pipe.renderPass);
+	AppendLibraryKey(key, pipe.subpass);
+	AppendLibraryKey(key, desc->dss.depthTestEnable);
+	AppendLibraryKey(key, desc->dss.depthWriteEnable);
+	AppendLibraryKey(key, desc->dss.depthCompareOp);
+	AppendLibraryKey(key, desc->dss.depthBoundsTestEnable);
+	AppendLibraryKey(key, desc->dss.stencilTestEnable);
+	AppendLibraryKey(key, desc->dss.front);
+	AppendLibraryKey(key, desc->dss.back);
+	AppendLibraryKey(key, desc->ms.rasterizationSamples);
+	AppendLibraryKey(key, desc->ms.sampleShadingEnable);
+	AppendDynamicStateKey(key, pipe.pDynamicState);
+	VkGraphicsPipelineCreateInfo fragmentShader{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	fragmentShader.stageCount = 1;
+	fragmentShader.pStages = &desc->shaderStageInfo[1];
+	fragmentShader.pDepthStencilState = pipe.pDepthStencilState;
+	fragmentShader.pMultisampleState = pipe.pMultisampleState;
+	fragmentShader.pDynamicState = pipe.pDynamicState;
+	fragmentShader.layout = pipe.layout;
+	fragmentShader.renderPass = pipe.renderPass;
+	fragmentShader.subpass = pipe.subpass;
+	libraries[2] = GetPipelineLibrary(key, desc->pipelineCache, fragmentShader, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT);
+
+	key.clear();
+	key.push_back('O');
+	AppendLibraryKey(key, pipe.renderPass);
+	AppendLibraryKey(key, pipe.subpass);
+	AppendLibraryKey(key, desc->cbs.logicOpEnable);
+	AppendLibraryKey(key, desc->cbs.logicOp);
+	AppendLibraryKey(key, desc->cbs.attachmentCount);
+	for (uint32_t i = 0; i < desc->cbs.attachmentCount; i++)
+		AppendLibraryKey(key, desc->cbs.pAttachments[i]);
+	AppendLibraryKey(key, desc->ms.rasterizationSamples);
+	AppendDynamicStateKey(key, pipe.pDynamicState);
+	VkGraphicsPipelineCreateInfo fragmentOutput{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	fragmentOutput.pColorBlendState = pipe.pColorBlendState;
+	fragmentOutput.pMultisampleState = pipe.pMultisampleState;
+	fragmentOutput.pDynamicState = pipe.pDynamicState;
+	fragmentOutput.renderPass = pipe.renderPass;
+	fragmentOutput.subpass = pipe.subpass;
+	libraries[3] = GetPipelineLibrary(key, desc->pipelineCache, fragmentOutput, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT);
+
+	for (VkPipeline library : libraries) {
+		if (library == VK_NULL_HANDLE)
+			return false;
+	}
+
+	VkPipelineLibraryCreateInfoKHR libraryInfo{ VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR };
+	libraryInfo.libraryCount = ARRAY_SIZE(libraries);
+	libraryInfo.pLibraries = libraries;
+	VkGraphicsPipelineCreateInfo link{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+	link.pNext = &libraryInfo;
+	link.layout = pipe.layout;
+
+	VkPipeline linked;
+	VkResult result = vkCreateGraphicsPipelines(vulkan_->GetDevice(), desc->pipelineCache, 1, &link, nullptr, &linked);
+	if (result != VK_SUCCESS) {
+		ERROR_LOG(G3D, "Failed linking graphics pipeline: %s", VulkanResultToString(result));
+		return false;
+	}
+	pipeline->pipeline = linked;
+	return true;
+}
+
+void VulkanRenderManager::OptimizeLinkedPipeline(VKRGraphicsPipeline *pipeline) {
+	VKRGraphicsPipelineDesc *desc = pipeline->desc;
+	VkPipeline optimized;
+	VkResult result = vkCreateGraphicsPipelines(vulkan_->GetDevice(), desc->pipelineCache, 1, &desc->pipe, nullptr, &optimized);
+	if (result == VK_SUCCESS) {
+		VkPipeline linked = pipeline->pipeline.exchange(optimized);
+		std::lock_guard<std::mutex> guard(pipelineLibraryMutex_);
+		retiredPipelines_.push_back(linked);
+	} else {
+		// The linked one works fine, just keep using it.
+		WARN_LOG(G3D, "Failed creating optimized graphics pipeline: %s", VulkanResultToString(result));
+	}
+
+	delete desc;
+	pipeline->desc = nullptr;
+}
+
+void VulkanRenderManager::ClearPipelineLibraries() {
+	std::lock_guard<std::mutex> guard(pipelineLibraryMutex_);
+	for (auto &iter : pipelineLibraries_)
+		vulkan_->Delete().QueueDeletePipeline(iter.second);
+	pipelineLibraries_.clear();
 }
 
 void VulkanRenderManager::DrainCompileQueue() {
@@ -472,6 +733,7 @@ void VulkanRenderManager::DrainCompileQueue() {
 
 void VulkanRenderManager::ThreadFunc() {
 	SetCurrentThreadName("RenderMan");
+	SetCurrentThreadRole(ThreadRole::RENDER);
 	int threadFrame = threadInitFrame_;
 	bool nextFrame = false;
 	bool firstFrame = true;
@@ -506,7 +768,10 @@ void VulkanRenderManager::ThreadFunc() {
 			INFO_LOG(G3D, "Running first frame (%d)", threadFrame);
 			firstFrame = false;
 		}
-		Run(threadFrame);
+		{
+			PROFILE_THIS_SCOPE("vkrun");
+			Run(threadFrame);
+		}
 		VLOG("PULL: Finished frame %d", threadFrame);
 	}
 
@@ -538,10 +803,30 @@ void VulkanRenderManager::BeginFrame(bool enableProfiling, bool enableLogProfile
 	vkWaitForFences(device, 1, &frameData.fence, true, UINT64_MAX);
 	vkResetFences(device, 1, &frameData.fence);
 
+	if (usePipelineLibraries_) {
+		std::lock_guard<std::mutex> guard(pipelineLibraryMutex_);
+		for (VkPipeline &pipeline : retiredPipelines_)
+			vulkan_->Delete().QueueDeletePipeline(pipeline);
+		retiredPipelines_.clear();
+	}
+
 	// Can't set this until after the fence.
 	frameData.profilingEnabled_ = enableProfiling;
 	frameData.readbackFenceUsed = false;
 
+	// The delayed readbacks from the last use of this frame are now ready. Drop the ones nobody asked for then.
+	for (auto iter = frameData.readbacks.begin(); iter != frameData.readbacks.end(); ) {
+		CachedReadback *readback = iter->second;
+		if (readback->requested) {
+			readback->requested = false;
+			++iter;
+		} else {
+			readback->Destroy(vulkan_);
+			delete readback;
+			iter = frameData.readbacks.erase(iter);
+		}
+	}
+
 	uint64_t queryResults[MAX_TIMESTAMP_QUERIES];
 
 	if (frameData.profilingEnabled_) {
@@ -563,6 +848,10 @@ void VulkanRenderManager::BeginFrame(bool enableProfiling, bool enableLogProfile
 				str << line;
 				snprintf(line, sizeof(line), "Render CPU time: %0.3f ms\n", (frameData.profile.cpuEndTime - frameData.profile.cpuStartTime) * 1000.0);
 				str << line;
+				for (size_t i = 0; i < frameData.profile.recordThreadTimes.size(); i++) {
+					snprintf(line, sizeof(line), "Record thread %d: %0.3f ms (%d passes)\n", (int)i, frameData.profile.recordThreadTimes[i] * 1000.0, frameData.profile.recordThreadPasses[i]);
+					str << line;
+				}
 				for (int i = 0; i < numQueries - 1; i++) {
 					uint64_t diff = (queryResults[i + 1] - queryResults[i]) & timestampDiffMask;
 					double milliseconds = (double)diff * timestampConversionFactor;
@@ -622,6 +911,87 @@ VkCommandBuffer VulkanRenderManager::GetInitCmd() {
 	return frameData_[curFrame].initCmd;
 }
 
+VkCommandBuffer VulkanRenderManager::GetTransferCmd() {
+	int curFrame = vulkan_->GetCurFrame();
+	FrameData &frameData = frameData_[curFrame];
+	if (!frameData.transferCmd) {
+		return VK_NULL_HANDLE;
+	}
+	if (!frameData.hasTransferCommands) {
+		VkCommandBufferBeginInfo begin = {
+			VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			nullptr,
+			VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+		};
+		// The frame fence covers this too, since the graphics submit waited on transferSemaphore.
+		vkResetCommandPool(vulkan_->GetDevice(), frameData.cmdPoolTransfer, 0);
+		VkResult res = vkBeginCommandBuffer(frameData.transferCmd, &begin);
+		if (res != VK_SUCCESS) {
+			return VK_NULL_HANDLE;
+		}
+		frameData.hasTransferCommands = true;
+	}
+	return frameData.transferCmd;
+}
+
+void VulkanRenderManager::ReleaseImageToGraphics(VkImage image, int numMips) {
+	FrameData &frameData = frameData_[vulkan_->GetCurFrame()];
+	_dbg_assert_(frameData.hasTransferCommands);
+
+	VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = numMips;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcQueueFamilyIndex = vulkan_->GetTransferQueueFamilyIndex();
+	barrier.dstQueueFamilyIndex = vulkan_->GetGraphicsQueueFamilyIndex();
+
+	// Release half: dstAccessMask is ignored.
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(frameData.transferCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	// Acquire half, with an identical layout transition. srcAccessMask is ignored.
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	frameData.transferAcquires.push_back(barrier);
+}
+
+bool VulkanRenderManager::SubmitTransfers(int frame) {
+	FrameData &frameData = frameData_[frame];
+	if (!frameData.hasTransferCommands)
+		return false;
+
+	VkResult res = vkEndCommandBuffer(frameData.transferCmd);
+	_assert_msg_(res == VK_SUCCESS, "vkEndCommandBuffer failed (transfer)! result=%s", VulkanResultToString(res));
+
+	VkSubmitInfo submit_info{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &frameData.transferCmd;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores = &frameData.transferSemaphore;
+	res = vkQueueSubmit(vulkan_->GetTransferQueue(), 1, &submit_info, VK_NULL_HANDLE);
+	_assert_msg_(res == VK_SUCCESS, "vkQueueSubmit failed (transfer)! result=%s", VulkanResultToString(res));
+	frameData.hasTransferCommands = false;
+
+	// The acquires go first in the init cmd, which waits for the semaphore.
+	if (!frameData.transferAcquires.empty()) {
+		if (!frameData.hasInitCommands) {
+			VkCommandBufferBeginInfo begin{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkResetCommandPool(vulkan_->GetDevice(), frameData.cmdPoolInit, 0);
+			res = vkBeginCommandBuffer(frameData.initCmd, &begin);
+			_assert_msg_(res == VK_SUCCESS, "vkBeginCommandBuffer failed (init)! result=%s", VulkanResultToString(res));
+			frameData.hasInitCommands = true;
+		}
+		vkCmdPipelineBarrier(frameData.initCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t)frameData.transferAcquires.size(), frameData.transferAcquires.data());
+		frameData.transferAcquires.clear();
+	}
+	return true;
+}
+
 void VulkanRenderManager::EndCurRenderStep() {
 	// Save the accumulated pipeline flags so we can use that to configure the render pass.
 	// We'll often be able to avoid loading/saving the depth/stencil buffer.
@@ -792,6 +1162,7 @@ bool VulkanRenderManager::CopyFramebufferToMemorySync(VKRFramebuffer *src, VkIma
 	step->readback.src = src;
 	step->readback.srcRect.offset = { x, y };
 	step->readback.srcRect.extent = { (uint32_t)w, (uint32_t)h };
+	step->readback.delayed = nullptr;
 	step->dependencies.insert(src);
 	step->tag = tag;
 	steps_.push_back(step);
@@ -838,6 +1209,50 @@ bool VulkanRenderManager::CopyFramebufferToMemorySync(VKRFramebuffer *src, VkIma
 	return true;
 }
 
+bool VulkanRenderManager::CopyFramebufferToMemory(VKRFramebuffer *src, VkImageAspectFlags aspectBits, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride, Draw::ReadbackMode mode, const char *tag) {
+	// We only delay plain color readbacks from our own framebuffers. The rest are rare, just block.
+	if (mode == Draw::ReadbackMode::BLOCK || !src || aspectBits != VK_IMAGE_ASPECT_COLOR_BIT || src->color.format != VK_FORMAT_R8G8B8A8_UNORM) {
+		return CopyFramebufferToMemorySync(src, aspectBits, x, y, w, h, destFormat, pixels, pixelStride, tag);
+	}
+
+	_dbg_assert_(insideFrame_);
+	FrameData &frameData = frameData_[vulkan_->GetCurFrame()];
+
+	CachedReadback *&readback = frameData.readbacks[ReadbackKey{ src, x, y, w, h }];
+	// Anything left in the map after BeginFrame was filled the last time around, and that frame is fenced.
+	bool hasOldData = readback && readback->buffer != VK_NULL_HANDLE;
+	if (!readback) {
+		readback = new CachedReadback();
+	}
+	readback->requested = true;
+
+	for (int i = (int)steps_.size() - 1; i >= 0; i--) {
+		if (steps_[i]->stepType == VKRStepType::RENDER && steps_[i]->render.framebuffer == src) {
+			steps_[i]->render.numReads++;
+			break;
+		}
+	}
+
+	EndCurRenderStep();
+
+	VKRStep *step = new VKRStep{ VKRStepType::READBACK };
+	step->readback.aspectMask = aspectBits;
+	step->readback.src = src;
+	step->readback.srcRect.offset = { x, y };
+	step->readback.srcRect.extent = { (uint32_t)w, (uint32_t)h };
+	step->readback.delayed = readback;
+	step->dependencies.insert(src);
+	step->tag = tag;
+	steps_.push_back(step);
+
+	if (!hasOldData) {
+		// Nothing to hand out yet, so this first one has to stall.
+		FlushSync();
+	}
+
+	return queueRunner_.CopyReadbackBuffer(readback, w, h, Draw::DataFormat::R8G8B8A8_UNORM, destFormat, pixelStride, pixels);
+}
+
 void VulkanRenderManager::CopyImageToMemorySync(VkImage image, int mipLevel, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride, const char *tag) {
 	_dbg_assert_(insideFrame_);
 
@@ -1247,6 +1662,7 @@ void VulkanRenderManager::BeginSubmitFrame(int frame) {
 		}
 
 		vkResetCommandPool(vulkan_->GetDevice(), frameData.cmdPoolMain, 0);
+		frameData.secondaryPools.Reset(vulkan_);
 		VkCommandBufferBeginInfo begin{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
 		begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 		res = vkBeginCommandBuffer(frameData.mainCmd, &begin);
@@ -1261,6 +1677,8 @@ void VulkanRenderManager::BeginSubmitFrame(int frame) {
 
 void VulkanRenderManager::Submit(int frame, bool triggerFrameFence) {
 	FrameData &frameData = frameData_[frame];
+	// Must be before ending initCmd, since the queue ownership acquires are recorded there.
+	bool waitTransfer = SubmitTransfers(frame);
 	if (frameData.hasInitCommands) {
 		if (frameData.profilingEnabled_ && triggerFrameFence) {
 			// Pre-allocated query ID 1.
@@ -1280,6 +1698,13 @@ void VulkanRenderManager::Submit(int frame, bool triggerFrameFence) {
 		if (splitSubmit_) {
 			// Send the init commands off separately. Used this once to confirm that the cause of a device loss was in the init cmdbuf.
 			VkSubmitInfo submit_info{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			VkPipelineStageFlags transferWaitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			if (waitTransfer) {
+				submit_info.waitSemaphoreCount = 1;
+				submit_info.pWaitSemaphores = &frameData.transferSemaphore;
+				submit_info.pWaitDstStageMask = &transferWaitStage;
+				waitTransfer = false;
+			}
 			submit_info.commandBufferCount = (uint32_t)numCmdBufs;
 			submit_info.pCommandBuffers = cmdBufs;
 			res = vkQueueSubmit(vulkan_->GetGraphicsQueue(), 1, &submit_info, VK_NULL_HANDLE);
@@ -1294,12 +1719,20 @@ void VulkanRenderManager::Submit(int frame, bool triggerFrameFence) {
 	cmdBufs[numCmdBufs++] = frameData.mainCmd;
 
 	VkSubmitInfo submit_info{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
-	VkPipelineStageFlags waitStage[1]{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+	VkSemaphore waitSemaphores[2];
+	VkPipelineStageFlags waitStages[2];
+	uint32_t numWaits = 0;
 	if (triggerFrameFence && !frameData.skipSwap) {
-		submit_info.waitSemaphoreCount = 1;
-		submit_info.pWaitSemaphores = &acquireSemaphore_;
-		submit_info.pWaitDstStageMask = waitStage;
+		waitSemaphores[numWaits] = acquireSemaphore_;
+		waitStages[numWaits++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	}
+	if (waitTransfer) {
+		waitSemaphores[numWaits] = frameData.transferSemaphore;
+		waitStages[numWaits++] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 	}
+	submit_info.waitSemaphoreCount = numWaits;
+	submit_info.pWaitSemaphores = numWaits ? waitSemaphores : nullptr;
+	submit_info.pWaitDstStageMask = numWaits ? waitStages : nullptr;
 	submit_info.commandBufferCount = (uint32_t)numCmdBufs;
 	submit_info.pCommandBuffers = cmdBufs;
 	if (triggerFrameFence && !frameData.skipSwap) {
@@ -1367,7 +1800,7 @@ void VulkanRenderManager::Run(int frame) {
 	VkCommandBuffer cmd = frameData.mainCmd;
 	queueRunner_.PreprocessSteps(stepsOnThread);
 	//queueRunner_.LogSteps(stepsOnThread, false);
-	queueRunner_.RunSteps(cmd, stepsOnThread, frameData.profilingEnabled_ ? &frameData.profile : nullptr);
+	queueRunner_.RunSteps(cmd, stepsOnThread, frameData.profilingEnabled_ ? &frameData.profile : nullptr, &frameData.secondaryPools);
 	stepsOnThread.clear();
 
 	switch (frameData.type) {
@@ -1407,6 +1840,7 @@ void VulkanRenderManager::EndSyncFrame(int frame) {
 		VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
 	};
 	vkResetCommandPool(vulkan_->GetDevice(), frameData.cmdPoolMain, 0);
+	frameData.secondaryPools.Reset(vulkan_);
 	VkResult res = vkBeginCommandBuffer(frameData.mainCmd, &begin);
 	_assert_(res == VK_SUCCESS);
 
@@ -1418,6 +1852,7 @@ void VulkanRenderManager::EndSyncFrame(int frame) {
 }
 
 void VulkanRenderManager::FlushSync() {
+	PROFILE_THIS_SCOPE("flushsync");
 	renderStepOffset_ += (int)steps_.size();
 
 	int curFrame = vulkan_->GetCurFrame();
@@ -8,9 +8,12 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <map>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <queue>
+#include <unordered_map>
 
 #include "Common/System/Display.h"
 #include "Common/GPU/Vulkan/VulkanContext.h"
@@ -145,6 +148,9 @@ struct VKRGraphicsPipeline {
 	}
 	VKRGraphicsPipelineDesc *desc = nullptr;  // While non-zero, is pending and pipeline isn't valid.
 	std::atomic<VkPipeline> pipeline;
+	// Optional already compiled pipeline with compatible state and vertex layout. If set, it's bound
+	// instead of stalling while this one is still pending. Must outlive this pipeline.
+	VKRGraphicsPipeline *fallback = nullptr;
 
 	bool Create(VulkanContext *vulkan);
 	bool Pending() const {
@@ -175,6 +181,8 @@ struct CompileQueueEntry {
 	Type type;
 	VKRGraphicsPipeline *graphics = nullptr;
 	VKRComputePipeline *compute = nullptr;
+	// Quickly linked from pipeline libraries, still needs the optimized pipeline.
+	bool linked = false;
 };
 
 class VulkanRenderManager {
@@ -186,6 +194,10 @@ class VulkanRenderManager {
 	void CompileThreadFunc();
 	void DrainCompileQueue();
 
+	// Pipeline libraries are keyed on shader module handles, so this must be called before destroying
+	// the modules of pipelines created through CreateGraphicsPipeline().
+	void ClearPipelineLibraries();
+
 	// Makes sure that the GPU has caught up enough that we can start writing buffers of this frame again.
 	void BeginFrame(bool enableProfiling, bool enableLogProfiler);
 	// Can run on a different thread!
@@ -217,6 +229,9 @@ class VulkanRenderManager {
 	VkImageView BindFramebufferAsTexture(VKRFramebuffer *fb, int binding, VkImageAspectFlags aspectBits, int attachment);
 
 	bool CopyFramebufferToMemorySync(VKRFramebuffer *src, VkImageAspectFlags aspectBits, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride, const char *tag);
+	// With OLD_DATA_OK, hands back the result of the same readback from the last time this frame slot was used
+	// (so, the inflight frame count ago) and queues a new one without stalling. Only the first request blocks.
+	bool CopyFramebufferToMemory(VKRFramebuffer *src, VkImageAspectFlags aspectBits, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride, Draw::ReadbackMode mode, const char *tag);
 	void CopyImageToMemorySync(VkImage image, int mipLevel, int x, int y, int w, int h, Draw::DataFormat destFormat, uint8_t *pixels, int pixelStride, const char *tag);
 
 	void CopyFramebuffer(VKRFramebuffer *src, VkRect2D srcRect, VKRFramebuffer *dst, VkOffset2D dstPos, VkImageAspectFlags aspectMask, const char *tag);
@@ -224,9 +239,11 @@ class VulkanRenderManager {
 
 	// Deferred creation, like in GL. Unlike GL though, the purpose is to allow background creation and avoiding
 	// stalling the emulation thread as much as possible.
-	VKRGraphicsPipeline *CreateGraphicsPipeline(VKRGraphicsPipelineDesc *desc) {
+	// If a fallback is given, it's drawn with while the new pipeline is still compiling.
+	VKRGraphicsPipeline *CreateGraphicsPipeline(VKRGraphicsPipelineDesc *desc, VKRGraphicsPipeline *fallback = nullptr) {
 		VKRGraphicsPipeline *pipeline = new VKRGraphicsPipeline();
 		pipeline->desc = desc;
+		pipeline->fallback = fallback;
 		compileMutex_.lock();
 		compileQueue_.push_back(CompileQueueEntry(pipeline));
 		compileCond_.notify_one();
@@ -363,7 +380,8 @@ class VulkanRenderManager {
 
 	void Clear(uint32_t clearColor, float clearZ, int clearStencil, int clearMask);
 
-	void Draw(VkPipelineLayout layout, VkDescriptorSet descSet, int numUboOffsets, const uint32_t *uboOffsets, VkBuffer vbuffer, int voffset, int count, int offset = 0) {
+	// If bindlessDs is set, it's bound as set 1 and bindlessIndex is pushed as a fragment shader push constant.
+	void Draw(VkPipelineLayout layout, VkDescriptorSet descSet, int numUboOffsets, const uint32_t *uboOffsets, VkBuffer vbuffer, int voffset, int count, int offset = 0, VkDescriptorSet bindlessDs = VK_NULL_HANDLE, uint32_t bindlessIndex = 0) {
 		_dbg_assert_(curRenderStep_ && curRenderStep_->stepType == VKRStepType::RENDER && curStepHasViewport_ && curStepHasScissor_);
 		VkRenderData data{ VKRRenderCommand::DRAW };
 		data.draw.count = count;
@@ -372,6 +390,8 @@ class VulkanRenderManager {
 		data.draw.ds = descSet;
 		data.draw.vbuffer = vbuffer;
 		data.draw.voffset = voffset;
+		data.draw.bindlessDs = bindlessDs;
+		data.draw.bindlessIndex = bindlessIndex;
 		data.draw.numUboOffsets = numUboOffsets;
 		_dbg_assert_(numUboOffsets <= ARRAY_SIZE(data.draw.uboOffsets));
 		for (int i = 0; i < numUboOffsets; i++)
@@ -380,7 +400,7 @@ class VulkanRenderManager {
 		curRenderStep_->render.numDraws++;
 	}
 
-	void DrawIndexed(VkPipelineLayout layout, VkDescriptorSet descSet, int numUboOffsets, const uint32_t *uboOffsets, VkBuffer vbuffer, int voffset, VkBuffer ibuffer, int ioffset, int count, int numInstances, VkIndexType indexType) {
+	void DrawIndexed(VkPipelineLayout layout, VkDescriptorSet descSet, int numUboOffsets, const uint32_t *uboOffsets, VkBuffer vbuffer, int voffset, VkBuffer ibuffer, int ioffset, int count, int numInstances, VkIndexType indexType, VkDescriptorSet bindlessDs = VK_NULL_HANDLE, uint32_t bindlessIndex = 0) {
 		_dbg_assert_(curRenderStep_ && curRenderStep_->stepType == VKRStepType::RENDER && curStepHasViewport_ && curStepHasScissor_);
 		VkRenderData data{ VKRRenderCommand::DRAW_INDEXED };
 		data.drawIndexed.count = count;
@@ -396,12 +416,24 @@ class VulkanRenderManager {
 		for (int i = 0; i < numUboOffsets; i++)
 			data.drawIndexed.uboOffsets[i] = uboOffsets[i];
 		data.drawIndexed.indexType = indexType;
+		data.drawIndexed.bindlessDs = bindlessDs;
+		data.drawIndexed.bindlessIndex = bindlessIndex;
 		curRenderStep_->commands.push_back(data);
 		curRenderStep_->render.numDraws++;
 	}
 
 	VkCommandBuffer GetInitCmd();
 
+	// Command buffer on the dedicated transfer queue, submitted ahead of the frame's graphics work.
+	// Returns VK_NULL_HANDLE if the device has no such queue, use GetInitCmd() then.
+	VkCommandBuffer GetTransferCmd();
+	bool HasTransferQueue() const {
+		return vulkan_->GetTransferQueue() != VK_NULL_HANDLE;
+	}
+	// Call after writing an image (from TRANSFER_DST_OPTIMAL) in the transfer cmd. Hands ownership over to the
+	// graphics queue, where it arrives in SHADER_READ_ONLY_OPTIMAL ready for fragment shader sampling.
+	void ReleaseImageToGraphics(VkImage image, int numMips);
+
 	VkRenderPass GetBackbufferRenderPass() {
 		return queueRunner_.GetBackbufferRenderPass();
 	}
@@ -463,6 +495,7 @@ class VulkanRenderManager {
 	void BeginSubmitFrame(int frame);
 	void EndSubmitFrame(int frame);
 	void Submit(int frame, bool triggerFence);
+	bool SubmitTransfers(int frame);
 
 	// Bad for performance but sometimes necessary for synchronous CPU readbacks (screenshots and whatnot).
 	void FlushSync();
@@ -496,9 +529,21 @@ class VulkanRenderManager {
 		VkCommandPool cmdPoolMain;
 		VkCommandBuffer initCmd;
 		VkCommandBuffer mainCmd;
+		// Only created if there's a transfer queue. The semaphore orders the transfer submit before the graphics one.
+		VkCommandPool cmdPoolTransfer = VK_NULL_HANDLE;
+		VkCommandBuffer transferCmd = VK_NULL_HANDLE;
+		VkSemaphore transferSemaphore = VK_NULL_HANDLE;
+		bool hasTransferCommands = false;
+		// Queue family ownership acquires, recorded into initCmd at submit.
+		std::vector<VkImageMemoryBarrier> transferAcquires;
+		// For render passes recorded on worker threads. Reset along with cmdPoolMain.
+		SecondaryCommandPools secondaryPools;
 		bool hasInitCommands = false;
 		std::vector<VKRStep *> steps;
 
+		// Delayed readbacks, filled by this frame's commands and read the next time the frame's fence has passed.
+		std::map<ReadbackKey, CachedReadback *> readbacks;
+
 		// Swapchain.
 		bool hasBegun = false;
 		uint32_t curSwapchainImage = -1;
@@ -552,6 +597,19 @@ class VulkanRenderManager {
 	std::mutex compileMutex_;
 	std::vector<CompileQueueEntry> compileQueue_;
 
+	// With VK_EXT_graphics_pipeline_library, new pipelines are first linked from cached parts (vertex
+	// input, pre-rasterization, fragment shader, fragment output), which is nearly free. The fully
+	// optimized pipeline is compiled right after, and swapped in when ready.
+	bool LinkFromLibraries(VKRGraphicsPipeline *pipeline);
+	void OptimizeLinkedPipeline(VKRGraphicsPipeline *pipeline);
+	VkPipeline GetPipelineLibrary(const std::string &key, VkPipelineCache cache, VkGraphicsPipelineCreateInfo &info, VkGraphicsPipelineLibraryFlagsEXT flags);
+
+	bool usePipelineLibraries_ = false;
+	std::mutex pipelineLibraryMutex_;
+	std::unordered_map<std::string, VkPipeline> pipelineLibraries_;
+	// Linked pipelines replaced by optimized ones. They may still be in use, so deleted through the frame.
+	std::vector<VkPipeline> retiredPipelines_;
+
 	// Swap chain management
 	struct SwapchainImageData {
 		VkImage image;
@@ -536,6 +536,7 @@ struct DeviceCaps {
 	bool framebufferStencilBlitSupported;
 	bool framebufferFetchSupported;
 	bool texture3DSupported;
+	bool fragmentShaderStencilWriteSupported;
 
 	std::string deviceName;  // The device name to use when creating the thin3d context, to get the same one.
 };
@@ -628,6 +629,10 @@ class DrawContext {
 	virtual bool CopyFramebufferToMemorySync(Framebuffer *src, int channelBits, int x, int y, int w, int h, Draw::DataFormat format, void *pixels, int pixelStride, const char *tag) {
 		return false;
 	}
+	// Backends that can't delay readbacks just block, so this is always safe to call.
+	virtual bool CopyFramebufferToMemory(Framebuffer *src, int channelBits, int x, int y, int w, int h, Draw::DataFormat format, void *pixels, int pixelStride, ReadbackMode mode, const char *tag) {
+		return CopyFramebufferToMemorySync(src, channelBits, x, y, w, h, format, pixels, pixelStride, tag);
+	}
 	virtual DataFormat PreferredFramebufferReadbackFormat(Framebuffer *src) {
 		return DataFormat::R8G8B8A8_UNORM;
 	}
@@ -706,6 +711,13 @@ class DrawContext {
 
 	virtual int GetCurrentStepId() const = 0;
 
+	// Per-pass GPU timestamps, where the backend supports them. Takes effect at the next BeginFrame.
+	void SetGpuProfilingEnabled(bool enabled) {
+		gpuProfilingEnabled_ = enabled;
+	}
+	// Timings of an earlier frame, since results are read back without stalling.
+	virtual std::string GetGpuProfileString() const { return ""; }
+
 protected:
 	ShaderModule *vsPresets_[VS_MAX_PRESET];
 	ShaderModule *fsPresets_[FS_MAX_PRESET];
@@ -714,6 +726,7 @@ class DrawContext {
 
 	int targetWidth_;
 	int targetHeight_;
+	bool gpuProfilingEnabled_ = false;
 
 	Bugs bugs_;
 };
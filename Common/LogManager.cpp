@@ -33,6 +33,7 @@
 #include "Common/TimeUtil.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
 
 // Don't need to savestate this.
 const char *hleCurrentThreadName = nullptr;
@@ -41,6 +42,9 @@ bool *g_bLogEnabledSetting = nullptr;
 
 static const char level_to_char[8] = "-NEWIDV";
 
+// If the writer thread falls this far behind, callers wait for it rather than queueing more.
+static const size_t MAX_PENDING_MESSAGES = 16384;
+
 #if PPSSPP_PLATFORM(UWP) && defined(_DEBUG)
 #define LOG_MSC_OUTPUTDEBUG true
 #else
@@ -158,6 +162,8 @@ LogManager::LogManager(bool *enabledSetting) {
 }
 
 LogManager::~LogManager() {
+	SetAsyncOutput(false);
+
 	for (int i = 0; i < LogTypes::NUMBER_OF_LOGS; ++i) {
 #if !defined(MOBILE_DEVICE) || defined(_DEBUG)
 		RemoveListener(fileLog_);
@@ -262,12 +268,94 @@ void LogManager::Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type, const
 	message.msg[neededBytes] = '\n';
 	va_end(args_copy);
 
+	if (asyncOutput_) {
+		// Errors might be the last thing we get to log, so those go out right away (after anything queued.)
+		if (level > LogTypes::LERROR && QueueAsync(message))
+			return;
+		FlushAsync();
+	}
+	Dispatch(message);
+}
+
+void LogManager::Dispatch(const LogMessage &message) {
 	std::lock_guard<std::mutex> listeners_lock(listeners_lock_);
 	for (auto &iter : listeners_) {
 		iter->Log(message);
 	}
 }
 
+bool LogManager::QueueAsync(LogMessage &message) {
+	std::unique_lock<std::mutex> lock(pendingLock_);
+	// The writer itself must never wait on the queue (a listener might log.)
+	bool onWriter = std::this_thread::get_id() == writerThread_.get_id();
+	while (writerRunning_ && !onWriter && pending_.size() >= MAX_PENDING_MESSAGES) {
+		drainedCond_.wait(lock);
+	}
+	// Might've been turned off while we were checking.
+	if (!writerRunning_)
+		return false;
+
+	pending_.push_back(std::move(message));
+	pendingCond_.notify_one();
+	return true;
+}
+
+void LogManager::FlushAsync() {
+	std::unique_lock<std::mutex> lock(pendingLock_);
+	if (std::this_thread::get_id() == writerThread_.get_id())
+		return;
+	while (writerRunning_ && (!pending_.empty() || writerBusy_)) {
+		drainedCond_.wait(lock);
+	}
+}
+
+void LogManager::SetAsyncOutput(bool async) {
+	std::unique_lock<std::mutex> lock(pendingLock_);
+	if (async == writerRunning_)
+		return;
+
+	if (async) {
+		writerRunning_ = true;
+		writerThread_ = std::thread(&LogManager::WriterThreadFunc, this);
+		asyncOutput_ = true;
+	} else {
+		asyncOutput_ = false;
+		// The writer drains what's left before exiting.
+		writerRunning_ = false;
+		pendingCond_.notify_one();
+		drainedCond_.notify_all();
+		lock.unlock();
+		writerThread_.join();
+	}
+}
+
+void LogManager::WriterThreadFunc() {
+	SetCurrentThreadName("LogWriter");
+
+	std::vector<LogMessage> batch;
+	std::unique_lock<std::mutex> lock(pendingLock_);
+	while (true) {
+		while (writerRunning_ && pending_.empty()) {
+			pendingCond_.wait(lock);
+		}
+		if (pending_.empty())
+			break;
+
+		batch.swap(pending_);
+		writerBusy_ = true;
+		lock.unlock();
+
+		for (const LogMessage &message : batch) {
+			Dispatch(message);
+		}
+		batch.clear();
+
+		lock.lock();
+		writerBusy_ = false;
+		drainedCond_.notify_all();
+	}
+}
+
 bool LogManager::IsEnabled(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type) {
 	LogChannel &log = log_[type];
 	if (level > log.level || !log.enabled)
@@ -19,7 +19,10 @@
 
 #include "ppsspp_config.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <vector>
 #include <cstdarg>
 #include <cstdio>
@@ -125,6 +128,20 @@ class LogManager {
 	std::mutex listeners_lock_;
 	std::vector<LogListener*> listeners_;
 
+	// With async output, callers still format, but listeners are run on writerThread_.
+	std::atomic<bool> asyncOutput_{};
+	std::mutex pendingLock_;
+	std::condition_variable pendingCond_;
+	std::condition_variable drainedCond_;
+	std::vector<LogMessage> pending_;
+	std::thread writerThread_;
+	bool writerRunning_ = false;
+	bool writerBusy_ = false;
+
+	void Dispatch(const LogMessage &message);
+	bool QueueAsync(LogMessage &message);
+	void WriterThreadFunc();
+
 public:
 	void AddListener(LogListener *listener);
 	void RemoveListener(LogListener *listener);
@@ -183,6 +200,12 @@ class LogManager {
 
 	void ChangeFileLog(const char *filename);
 
+	// Moves listener output (file writes, console, etc.) to a background thread, so logging
+	// doesn't block the caller. Errors and notices still flush everything synchronously.
+	void SetAsyncOutput(bool async);
+	// Waits until all queued messages have been handed to listeners.
+	void FlushAsync();
+
 	void SaveConfig(Section *section);
 	void LoadConfig(Section *section, bool debugDefaults);
 };
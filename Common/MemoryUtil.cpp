@@ -43,6 +43,7 @@
 #include <unistd.h>
 #endif
 static int hint_location;
+static bool hugePagesForExecutableMemory = false;
 #ifdef __APPLE__
 #define MEM_PAGE_SIZE (PAGE_SIZE)
 #elif defined(_WIN32)
@@ -188,6 +189,9 @@ void *AllocateExecutableMemory(size_t size) {
 	if (ptr == failed_result) {
 		ptr = nullptr;
 		ERROR_LOG(MEMMAP, "Failed to allocate executable memory (%d) errno=%d", (int)size, errno);
+	} else if (hugePagesForExecutableMemory) {
+		bool advised = AdviseHugePages(ptr, size);
+		INFO_LOG(MEMMAP, "Huge pages for %d bytes of executable memory: %s", (int)size, advised ? "requested" : "not available");
 	}
 
 #if PPSSPP_ARCH(AMD64) && !defined(_WIN32)
@@ -334,6 +338,27 @@ bool ProtectMemoryPages(const void* ptr, size_t size, uint32_t memProtFlags) {
 #endif
 }
 
+bool AdviseHugePages(void *ptr, size_t size) {
+#if PPSSPP_PLATFORM(LINUX) && defined(MADV_HUGEPAGE)
+	const uintptr_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+	uintptr_t start = ((uintptr_t)ptr + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+	uintptr_t end = ((uintptr_t)ptr + size) & ~(HUGE_PAGE_SIZE - 1);
+	if (end <= start)
+		return false;
+	if (madvise((void *)start, end - start, MADV_HUGEPAGE) != 0) {
+		WARN_LOG(MEMMAP, "madvise(MADV_HUGEPAGE) failed for %p: errno=%d", (void *)start, errno);
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+void SetHugePagesForExecutableMemory(bool enable) {
+	hugePagesForExecutableMemory = enable;
+}
+
 int GetMemoryProtectPageSize() {
 #ifdef _WIN32
 	if (sys_info.dwPageSize == 0)
@@ -45,6 +45,12 @@ void FreeAlignedMemory(void* ptr);
 
 int GetMemoryProtectPageSize();
 
+// Asks the OS to back the range with huge pages where it can (transparent huge pages on Linux.)
+// Only whole, aligned huge pages inside the range are affected. Returns false if not supported.
+bool AdviseHugePages(void *ptr, size_t size);
+// Makes AllocateExecutableMemory advise huge pages for new code space.
+void SetHugePagesForExecutableMemory(bool enable);
+
 // A simple buffer that bypasses the libc memory allocator. As a result the buffer is always page-aligned.
 template <typename T>
 class SimpleBuf {
@@ -313,7 +313,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, co
 		"Host: %s\r\n"
 		"User-Agent: %s\r\n"
 		"Accept: %s\r\n"
-		"Connection: close\r\n"
+		"Connection: %s\r\n"
 		"%s"
 		"\r\n";
 
@@ -322,6 +322,7 @@ int Client::SendRequestWithData(const char *method, const RequestParams &req, co
 		host_.c_str(),
 		userAgent_.c_str(),
 		req.acceptMime,
+		keepAlive_ ? "keep-alive" : "close",
 		otherHeaders ? otherHeaders : "");
 	buffer.Append(data);
 	bool flushed = buffer.FlushSocket(sock(), dataTimeout_, progress->cancelled);
@@ -422,7 +423,14 @@ int Client::ReadResponseEntity(net::Buffer *readbuf, const std::vector<std::stri
 		progress->progress = 0.1f;
 	}
 
-	if (!contentLength) {
+	if (keepAlive_ && contentLength && !chunked) {
+		// The server won't close the socket after the entity, so read exactly what it announced.
+		if (!readbuf->ReadUntilSizeWithProgress(sock(), contentLength, dataTimeout_, &progress->progress, &progress->kBps, progress->cancelled))
+			return -1;
+	} else if (!contentLength) {
+		if (keepAlive_) {
+			WARN_LOG(IO, "Keep-alive response without Content-Length, reading until the server closes");
+		}
 		// No way to know how far along we are. Let's just not update the progress counter.
 		if (!readbuf->ReadAllWithProgress(sock(), contentLength, nullptr, &progress->kBps, progress->cancelled))
 			return -1;
@@ -91,10 +91,17 @@ class Client : public net::Connection {
 		userAgent_ = value;
 	}
 
+	// Ask the server to keep the connection open, so it can be reused for further requests.
+	// Entities are then read by Content-Length instead of until the socket closes.
+	void SetKeepAlive(bool keepAlive) {
+		keepAlive_ = keepAlive;
+	}
+
 protected:
 	std::string userAgent_;
 	const char *httpVersion_;
 	double dataTimeout_ = 900.0;
+	bool keepAlive_ = false;
 };
 
 // Not particularly efficient, but hey - it's a background download, that's pretty cool :P
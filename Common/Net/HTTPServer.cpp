@@ -14,6 +14,10 @@
 #else
 
 #include <sys/socket.h>       /*  socket definitions        */
+#if PPSSPP_PLATFORM(LINUX) || PPSSPP_PLATFORM(ANDROID)
+#include <sys/sendfile.h>
+#define HTTP_USE_SENDFILE
+#endif
 #include <sys/types.h>        /*  socket types              */
 #include <sys/wait.h>         /*  for waitpid()             */
 #include <netinet/in.h>       /*  struct sockaddr_in        */
@@ -41,18 +45,45 @@
 #include "Common/File/FileDescriptor.h"
 
 #include "Common/Buffer.h"
+#include "Common/CommonFuncs.h"
 #include "Common/Log.h"
 
+// Enough for several devices streaming plus a few debugger connections.
+static const size_t MAX_CONNECTION_THREADS = 32;
+// How long an idle kept-alive connection is held open waiting for the next request.
+static const double KEEPALIVE_TIMEOUT = 5.0;
 
 void NewThreadExecutor::Run(std::function<void()> func) {
-	threads_.push_back(std::thread(func));
+	JoinFinished();
+	while (workers_.size() >= MAX_CONNECTION_THREADS) {
+		sleep_ms(10);
+		JoinFinished();
+	}
+
+	Worker *worker = new Worker();
+	workers_.push_back(std::unique_ptr<Worker>(worker));
+	worker->thread = std::thread([worker, func] {
+		func();
+		worker->finished = true;
+	});
+}
+
+void NewThreadExecutor::JoinFinished() {
+	for (size_t i = 0; i < workers_.size(); ) {
+		if (workers_[i]->finished) {
+			workers_[i]->thread.join();
+			workers_.erase(workers_.begin() + i);
+		} else {
+			i++;
+		}
+	}
 }
 
 NewThreadExecutor::~NewThreadExecutor() {
 	// If Run was ever called...
-	for (auto &thread : threads_)
-		thread.join();
-	threads_.clear();
+	for (auto &worker : workers_)
+		worker->thread.join();
+	workers_.clear();
 }
 
 namespace http {
@@ -68,6 +99,12 @@ Request::Request(int fd)
 
 	if (header_.ok) {
 		VERBOSE_LOG(IO, "The request carried with it %i bytes", (int)header_.content_length);
+		// We don't read request bodies for the next request, so only body-less requests can keep the connection.
+		std::string connection;
+		if (header_.GetOther("connection", &connection) && header_.content_length <= 0) {
+			std::transform(connection.begin(), connection.end(), connection.begin(), tolower);
+			keepAlive_ = connection.find("keep-alive") != connection.npos;
+		}
 	} else {
 	    Close();
 	}
@@ -107,12 +144,18 @@ void Request::WriteHttpResponseHeader(const char *ver, int status, int64_t size,
 	default: statusStr = "OK"; break;
 	}
 
+	// Without a length, the end of the body is marked by closing the connection.
+	bool isWebsocket = mimeType && strcmp(mimeType, "websocket") == 0;
+	if (size < 0 || isWebsocket) {
+		keepAlive_ = false;
+	}
+
 	net::OutputSink *buffer = Out();
 	buffer->Printf("HTTP/%s %03d %s\r\n", ver, status, statusStr);
 	buffer->Push("Server: PPSSPPServer v0.1\r\n");
-	if (!mimeType || strcmp(mimeType, "websocket") != 0) {
+	if (!isWebsocket) {
 		buffer->Printf("Content-Type: %s\r\n", mimeType ? mimeType : DEFAULT_MIME_TYPE);
-		buffer->Push("Connection: close\r\n");
+		buffer->Push(keepAlive_ ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
 	}
 	if (size >= 0) {
 		buffer->Printf("Content-Length: %llu\r\n", size);
@@ -123,6 +166,50 @@ void Request::WriteHttpResponseHeader(const char *ver, int status, int64_t size,
 	buffer->Push("\r\n");
 }
 
+bool Request::WriteFileRange(FILE *fp, int64_t offset, int64_t length) const {
+	// Anything buffered (like the header) has to go out first.
+	if (!out_->Flush()) {
+		return false;
+	}
+
+#ifdef HTTP_USE_SENDFILE
+	// A 32-bit off_t can't reach past 2GB, fall back to reading for those.
+	if (sizeof(off_t) >= 8 || offset + length <= 0x7FFFFFFF) {
+		int fileFd = fileno(fp);
+		off_t pos = (off_t)offset;
+		int64_t left = length;
+		while (left > 0) {
+			ssize_t sent = sendfile(fd_, fileFd, &pos, (size_t)std::min(left, (int64_t)0x40000000));
+			if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+				if (!fd_util::WaitUntilReady(fd_, KEEPALIVE_TIMEOUT, true))
+					return false;
+				continue;
+			}
+			if (sent <= 0) {
+				return false;
+			}
+			left -= sent;
+		}
+		return true;
+	}
+#endif
+
+	if (fseeko(fp, offset, SEEK_SET) != 0) {
+		return false;
+	}
+
+	const size_t CHUNK_SIZE = 64 * 1024;
+	std::unique_ptr<char[]> buf(new char[CHUNK_SIZE]);
+	for (int64_t pos = 0; pos < length; pos += CHUNK_SIZE) {
+		size_t chunklen = (size_t)std::min(length - pos, (int64_t)CHUNK_SIZE);
+		if (fread(buf.get(), chunklen, 1, fp) != 1)
+			return false;
+		if (!out_->Push(buf.get(), chunklen))
+			return false;
+	}
+	return out_->Flush();
+}
+
 void Request::WritePartial() const {
 	_assert_(fd_);
 	out_->Flush();
@@ -134,6 +221,11 @@ void Request::Write() {
 	Close();
 }
 
+void Request::Detach() {
+	WritePartial();
+	fd_ = 0;
+}
+
 void Request::Close() {
 	if (fd_) {
 		closesocket(fd_);
@@ -313,22 +405,44 @@ bool Server::Run(int port) {
 }
 
 void Server::Stop() {
+	stopping_ = true;
 	closesocket(listener_);
 }
 
 void Server::HandleConnection(int conn_fd) {
-	Request request(conn_fd);
-	if (!request.IsOK()) {
-		WARN_LOG(IO, "Bad request, ignoring.");
-		return;
+	bool first = true;
+	while (true) {
+		Request request(conn_fd);
+		if (!request.IsOK()) {
+			// A kept-alive connection just ends this way when the client closes it.
+			if (first)
+				WARN_LOG(IO, "Bad request, ignoring.");
+			return;
+		}
+		HandleRequest(request);
+		first = false;
+
+		// TODO: Way to mark the content body as read, read it here if never read.
+		// This allows the handler to stream if need be.
+
+		if (!request.KeepAlive()) {
+			request.Write();
+			return;
+		}
+		request.Detach();
+
+		// Wait for the next request, but don't hold up shutdown.
+		double waited = 0.0;
+		bool ready = false;
+		while (!ready && waited < KEEPALIVE_TIMEOUT && !stopping_) {
+			ready = fd_util::WaitUntilReady(conn_fd, 0.25);
+			waited += 0.25;
+		}
+		if (!ready) {
+			closesocket(conn_fd);
+			return;
+		}
 	}
-	HandleRequest(request);
-
-	// TODO: Way to mark the content body as read, read it here if never read.
-	// This allows the handler to stream if need be.
-
-	// TODO: Could handle keep alive here.
-	request.Write();
 }
 
 void Server::HandleRequest(const Request &request) {
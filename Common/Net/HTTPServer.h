@@ -1,19 +1,32 @@
 #pragma once
 
+#include <atomic>
+#include <cstdio>
 #include <functional>
 #include <map>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include "Common/Net/HTTPHeaders.h"
 #include "Common/Net/Resolve.h"
 
+// Runs each connection on its own thread, up to a limit. Finished threads are joined as new ones
+// start, so a long running server doesn't accumulate them.
 class NewThreadExecutor {
 public:
 	~NewThreadExecutor();
+	// Waits for a free slot if the maximum number of threads are busy.
 	void Run(std::function<void()> func);
 
 private:
-	std::vector<std::thread> threads_;
+	void JoinFinished();
+
+	struct Worker {
+		std::thread thread;
+		std::atomic<bool> finished{ false };
+	};
+	std::vector<std::unique_ptr<Worker>> workers_;
 };
 
 namespace net {
@@ -59,13 +72,26 @@ class Request {
 	bool IsOK() const { return fd_ > 0; }
 
 	// If size is negative, no Content-Length: line is written.
+	// The connection is kept alive for another request if the client asked for it and size is known.
 	void WriteHttpResponseHeader(const char *ver, int status, int64_t size = -1, const char *mimeType = nullptr, const char *otherHeaders = nullptr) const;
 
+	// Sends length bytes of fp from offset as (part of) the body, after any pending output.
+	// Uses sendfile where available, so the data doesn't pass through our buffers.
+	bool WriteFileRange(FILE *fp, int64_t offset, int64_t length) const;
+
+	// Whether the connection should stay open after this response.
+	bool KeepAlive() const { return keepAlive_; }
+	// Call if the body didn't match the promised Content-Length, the client can't reuse the connection then.
+	void DisableKeepAlive() const { keepAlive_ = false; }
+	// Flushes output and gives up the socket without closing it, for the next request.
+	void Detach();
+
 private:
 	net::InputSink *in_;
 	net::OutputSink *out_;
 	RequestHeader header_;
 	int fd_;
+	mutable bool keepAlive_ = false;
 };
 
 // Register handlers on this class to serve stuff.
@@ -115,6 +141,7 @@ class Server {
 
 	int listener_;
 	int port_ = 0;
+	std::atomic<bool> stopping_{ false };
 
 	UrlHandlerMap handlers_;
 	UrlHandlerFunc fallback_;
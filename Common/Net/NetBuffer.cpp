@@ -95,6 +95,51 @@ bool Buffer::ReadAllWithProgress(int fd, int knownSize, float *progress, float *
 	return true;
 }
 
+bool Buffer::ReadUntilSizeWithProgress(int fd, size_t totalSize, double timeout, float *progress, float *kBps, bool *cancelled) {
+	static constexpr float CANCEL_INTERVAL = 0.25f;
+	std::vector<char> buf(std::min(totalSize, (size_t)65536) + 1);
+
+	double st = time_now_d();
+	size_t total = 0;
+	while (size() < totalSize) {
+		bool ready = false;
+		double endTimeout = time_now_d() + timeout;
+		while (!ready) {
+			if (cancelled && *cancelled)
+				return false;
+			ready = fd_util::WaitUntilReady(fd, CANCEL_INTERVAL, false);
+			if (!ready && time_now_d() > endTimeout) {
+				ERROR_LOG(IO, "ReadUntilSize timed out");
+				return false;
+			}
+		}
+		int retval = recv(fd, &buf[0], (int)std::min(buf.size(), totalSize - size()), MSG_NOSIGNAL);
+		if (retval == 0) {
+			// The peer closed the connection before sending everything it promised.
+			ERROR_LOG(IO, "Connection closed with %d bytes left to read", (int)(totalSize - size()));
+			return false;
+		} else if (retval < 0) {
+#if PPSSPP_PLATFORM(WINDOWS)
+			if (WSAGetLastError() != WSAEWOULDBLOCK) {
+#else
+			if (errno != EWOULDBLOCK) {
+#endif
+				ERROR_LOG(IO, "Error reading from buffer: %i", retval);
+				return false;
+			}
+			continue;
+		}
+		char *p = Append((size_t)retval);
+		memcpy(p, &buf[0], retval);
+		total += retval;
+		if (progress)
+			*progress = (float)size() / (float)totalSize;
+		if (kBps)
+			*kBps = (float)(total / (time_now_d() - st)) / 1024.0f;
+	}
+	return true;
+}
+
 int Buffer::Read(int fd, size_t sz) {
 	char buf[1024];
 	int retval;
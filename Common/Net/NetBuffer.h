@@ -9,6 +9,9 @@ class Buffer : public ::Buffer {
 	bool FlushSocket(uintptr_t sock, double timeout, bool *cancelled = nullptr);
 
 	bool ReadAllWithProgress(int fd, int knownSize, float *progress, float *kBps, bool *cancelled);
+	// Reads until the buffer holds at least totalSize bytes, without waiting for the socket to close.
+	// Used for persistent connections, where the peer keeps the socket open after the entity.
+	bool ReadUntilSizeWithProgress(int fd, size_t totalSize, double timeout, float *progress, float *kBps, bool *cancelled);
 
 	// < 0: error
 	// >= 0: number of bytes read
@@ -33,6 +33,7 @@ class WebSocketServer {
 
 	void Send(const std::string &str);
 	void Send(const std::vector<uint8_t> &payload);
+	void SendBinary(const void *data, size_t sz);
 
 	// Call with finish = false to start and continue, then finally with finish = true to complete.
 	// Note: Fragmented data cannot be interleaved, per protocol.
@@ -1,7 +1,9 @@
 // Ultra-lightweight category profiler with history.
 
 #include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <string>
 #include <vector>
 #include <cstring>
 
@@ -9,6 +11,8 @@
 
 #include "Common/Render/DrawBuffer.h"
 
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
 #include "Common/TimeUtil.h"
 #include "Common/Profiler/Profiler.h"
 #include "Common/Log.h"
@@ -22,6 +26,7 @@
 #define MAX_THREADS 4     // Can be any number, represents concurrent threads calling the profiler.
 #endif
 #define HISTORY_SIZE 128 // Must be power of 2
+#define TRACE_MAX_EVENTS (1 << 18)  // Per thread and trace, later events are dropped.
 
 #ifndef _DEBUG
 // If the compiler can collapse identical strings, we don't even need the strcmp.
@@ -61,6 +66,38 @@ thread_local int profilerThreadId = -1;
 static int profilerThreadId = 0;
 #endif
 
+struct TraceEvent {
+	const char *name;
+	double start;
+	double end;
+};
+
+// Only the owning thread writes events, the exporter reads up to the published count.
+struct TraceThread {
+	int tid;
+	std::string name;  // Protected by traceThreadsLock.
+	std::atomic<uint32_t> generation;
+	std::atomic<int> count;
+	std::vector<TraceEvent> events;
+	int depth = 0;
+	TraceEvent stack[MAX_DEPTH];
+};
+
+static std::atomic<bool> tracing;
+// Bumped on every start, so threads know to reset their buffers.
+static std::atomic<uint32_t> traceGeneration;
+static double traceStart;
+static std::mutex traceThreadsLock;
+// Never freed, threads may still hold on to them.
+static std::vector<TraceThread *> traceThreads;
+#if MAX_THREADS > 1
+thread_local TraceThread *traceThread = nullptr;
+thread_local std::string traceThreadName;
+#else
+static TraceThread *traceThread = nullptr;
+static std::string traceThreadName;
+#endif
+
 void internal_profiler_init() {
 	memset(&profiler, 0, sizeof(profiler));
 #if MAX_THREADS == 1
@@ -87,8 +124,55 @@ static int internal_profiler_find_thread() {
 		return thread_id;
 	}
 
-	// Just keep reusing the last one.
-	return threadIdAfterLast - 1;
+	// Out of history slots. Sharing one between threads would corrupt the nesting, so these threads
+	// only show up in traces.
+	return -1;
+}
+
+static void internal_profiler_trace_enter(const char *category_name) {
+	uint32_t generation = traceGeneration.load(std::memory_order_acquire);
+	TraceThread *t = traceThread;
+	if (!t) {
+		t = new TraceThread();
+		t->events.resize(TRACE_MAX_EVENTS);
+		t->count = 0;
+		t->generation = generation;
+
+		std::lock_guard<std::mutex> guard(traceThreadsLock);
+		t->tid = (int)traceThreads.size() + 1;
+		t->name = traceThreadName;
+		traceThreads.push_back(t);
+		traceThread = t;
+	} else if (t->generation.load(std::memory_order_relaxed) != generation) {
+		// First event of a new trace on this thread.
+		t->count.store(0, std::memory_order_relaxed);
+		t->depth = 0;
+		t->generation.store(generation, std::memory_order_release);
+	}
+
+	if (t->depth < MAX_DEPTH) {
+		t->stack[t->depth].name = category_name;
+		t->stack[t->depth].start = time_now_d();
+	}
+	t->depth++;
+}
+
+static void internal_profiler_trace_leave() {
+	TraceThread *t = traceThread;
+	// Might have entered before tracing started.
+	if (!t || t->depth == 0)
+		return;
+
+	t->depth--;
+	if (t->depth >= MAX_DEPTH || !tracing || t->generation.load(std::memory_order_relaxed) != traceGeneration)
+		return;
+
+	int n = t->count.load(std::memory_order_relaxed);
+	if (n < TRACE_MAX_EVENTS) {
+		t->events[n] = t->stack[t->depth];
+		t->events[n].end = time_now_d();
+		t->count.store(n + 1, std::memory_order_release);
+	}
 }
 
 int internal_profiler_find_cat(const char *category_name, bool create_missing) {
@@ -130,10 +214,13 @@ static void internal_profiler_resume(int thread_id, int category, double now) {
 }
 
 int internal_profiler_enter(const char *category_name, int *out_thread_id) {
+	if (tracing)
+		internal_profiler_trace_enter(category_name);
+
 	int category = internal_profiler_find_cat(category_name, true);
 	int thread_id = internal_profiler_find_thread();
-	if (category == -1 || !history) {
-		return category;
+	if (category == -1 || thread_id == -1 || !history) {
+		return -1;
 	}
 
 	int &depth = profiler.depth[thread_id];
@@ -157,6 +244,8 @@ int internal_profiler_enter(const char *category_name, int *out_thread_id) {
 }
 
 void internal_profiler_leave(int thread_id, int category) {
+	internal_profiler_trace_leave();
+
 	if (category == -1 || !history) {
 		return;
 	}
@@ -188,6 +277,8 @@ void internal_profiler_leave(int thread_id, int category) {
 
 void internal_profiler_end_frame() {
 	int thread_id = internal_profiler_find_thread();
+	if (thread_id == -1)
+		return;
 	_assert_msg_(profiler.depth[thread_id] == 0, "Can't be inside a profiler scope at end of frame!");
 	profiler.curFrameStart = time_now_d();
 	profiler.historyPos++;
@@ -262,3 +353,58 @@ void Profiler_GetHistory(int category, int thread, float *data, int count) {
 		data[i] = history[MAX_THREADS * x + thread].time_taken[category];
 	}
 }
+
+void Profiler_StartTrace() {
+	traceStart = time_now_d();
+	traceGeneration++;
+	tracing = true;
+}
+
+bool Profiler_IsTracing() {
+	return tracing;
+}
+
+void Profiler_SetThreadName(const char *name) {
+	traceThreadName = name;
+	if (traceThread) {
+		std::lock_guard<std::mutex> guard(traceThreadsLock);
+		traceThread->name = name;
+	}
+}
+
+bool Profiler_StopTrace(const char *filename) {
+	if (!tracing)
+		return false;
+	tracing = false;
+
+	FILE *fp = File::OpenCFile(Path(filename), "w");
+	if (!fp) {
+		ERROR_LOG(SYSTEM, "Failed to open %s to write a trace", filename);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(traceThreadsLock);
+	uint32_t generation = traceGeneration;
+	const char *comma = "";
+	fprintf(fp, "{\"traceEvents\":[\n");
+	for (TraceThread *t : traceThreads) {
+		if (t->generation.load(std::memory_order_acquire) != generation)
+			continue;
+		if (!t->name.empty()) {
+			fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", comma, t->tid, t->name.c_str());
+			comma = ",\n";
+		}
+		int count = t->count.load(std::memory_order_acquire);
+		for (int i = 0; i < count; ++i) {
+			const TraceEvent &e = t->events[i];
+			fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%0.3f,\"dur\":%0.3f}", comma, e.name, t->tid, (e.start - traceStart) * 1000000.0, (e.end - e.start) * 1000000.0);
+			comma = ",\n";
+		}
+		if (count == TRACE_MAX_EVENTS)
+			WARN_LOG(SYSTEM, "Trace buffer for thread %d (%s) filled up, later events were dropped", t->tid, t->name.c_str());
+	}
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+	INFO_LOG(SYSTEM, "Wrote trace to %s", filename);
+	return true;
+}
@@ -22,6 +22,15 @@ void Profiler_GetSlowestThreads(int *data, int count);
 void Profiler_GetSlowestHistory(int category, int *slowestThreads, float *data, int count);
 void Profiler_GetHistory(int category, int thread, float *data, int count);
 
+// Timeline tracing. While active, every profiled scope on every thread is recorded with timestamps,
+// into a buffer owned by that thread.
+void Profiler_StartTrace();
+// Stops tracing and writes the events in Chrome trace format (chrome://tracing, Perfetto, Tracy's importer.)
+bool Profiler_StopTrace(const char *filename);
+bool Profiler_IsTracing();
+// Labels the calling thread in traces.
+void Profiler_SetThreadName(const char *name);
+
 class ProfileThis {
 public:
 	ProfileThis(const char *category) {
@@ -32,7 +41,7 @@ class ProfileThis {
 	}
 private:
 	int cat_;
-	int thread_;
+	int thread_ = -1;
 };
 
 #define PROFILE_INIT() internal_profiler_init();
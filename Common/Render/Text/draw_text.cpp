@@ -1,5 +1,8 @@
 #include "ppsspp_config.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "Common/System/Display.h"
 #include "Common/GPU/thin3d.h"
 #include "Common/Data/Hash/Hash.h"
@@ -80,6 +83,214 @@ void TextDrawer::DrawStringBitmapRect(std::vector<uint8_t> &bitmapData, TextStri
 	DrawStringBitmap(bitmapData, entry, texFormat, toDraw.c_str(), align);
 }
 
+enum {
+	TEXT_ATLAS_WIDTH = 1024,
+	TEXT_ATLAS_MAX_HEIGHT = 1024,
+	// Taller strings (long wrapped text) keep their own texture.
+	TEXT_ATLAS_MAX_STRING_HEIGHT = 128,
+	// Not worth a new page for fewer strings than this.
+	TEXT_ATLAS_MIN_STRINGS = 8,
+	// Gap between strings, so filtering doesn't bleed neighbours in.
+	TEXT_ATLAS_PADDING = 1,
+};
+
+void TextDrawer::CreateEntryTexture(TextStringEntry *entry, std::vector<uint8_t> &bitmapData, Draw::DataFormat texFormat) {
+	using namespace Draw;
+	entry->texture = nullptr;
+	entry->page = nullptr;
+	entry->atlasX = 0;
+	entry->atlasY = 0;
+	entry->bitmapFormat = texFormat;
+	if (bitmapData.empty())
+		return;
+
+	TextureDesc desc{};
+	desc.initData.push_back(&bitmapData[0]);
+	desc.type = TextureType::LINEAR2D;
+	desc.format = texFormat;
+	desc.width = entry->bmWidth;
+	desc.height = entry->bmHeight;
+	desc.depth = 1;
+	desc.mipLevels = 1;
+	desc.generateMips = false;
+	desc.tag = "TextDrawer";
+	entry->texture = draw_->CreateTexture(desc);
+	entry->bitmap = std::move(bitmapData);
+}
+
+void TextDrawer::DrawEntry(DrawBuffer &target, const TextStringEntry &entry, int srcW, int srcH, float x, float y, uint32_t color, int align) {
+	Draw::Texture *texture;
+	float u1, v1, u2, v2;
+	if (entry.page) {
+		texture = entry.page->texture;
+		u1 = entry.atlasX / (float)entry.page->width;
+		v1 = entry.atlasY / (float)entry.page->height;
+		u2 = (entry.atlasX + srcW) / (float)entry.page->width;
+		v2 = (entry.atlasY + srcH) / (float)entry.page->height;
+	} else if (entry.texture) {
+		texture = entry.texture;
+		u1 = 0.0f;
+		v1 = 0.0f;
+		u2 = srcW / (float)entry.bmWidth;
+		v2 = srcH / (float)entry.bmHeight;
+	} else {
+		return;
+	}
+
+	draw_->BindTexture(0, texture);
+
+	float w = srcW * fontScaleX_ * dpiScale_;
+	float h = srcH * fontScaleY_ * dpiScale_;
+	DrawBuffer::DoAlign(align, &x, &y, &w, &h);
+	target.DrawTexRect(x, y, x + w, y + h, u1, v1, u2, v2, color);
+	target.Flush(true);
+}
+
+void TextDrawer::ReleaseEntry(TextStringEntry &entry) {
+	if (entry.texture) {
+		entry.texture->Release();
+		entry.texture = nullptr;
+	}
+	TextAtlasPage *page = entry.page;
+	if (page) {
+		entry.page = nullptr;
+		page->livePixels -= entry.bmWidth * entry.bmHeight;
+		if (--page->liveStrings == 0) {
+			if (page->texture)
+				page->texture->Release();
+			atlasPages_.erase(std::remove(atlasPages_.begin(), atlasPages_.end(), page), atlasPages_.end());
+			delete page;
+		}
+	}
+}
+
+// Fully transparent, but white, so filtering at the edges of strings doesn't darken them.
+static void FillTransparent(uint8_t *dest, size_t pixels, Draw::DataFormat format) {
+	switch (format) {
+	case Draw::DataFormat::R8G8B8A8_UNORM:
+	case Draw::DataFormat::B8G8R8A8_UNORM:
+		for (size_t i = 0; i < pixels; i++)
+			((uint32_t *)dest)[i] = 0x00FFFFFF;
+		break;
+	case Draw::DataFormat::R4G4B4A4_UNORM_PACK16:
+	case Draw::DataFormat::B4G4R4A4_UNORM_PACK16:
+		for (size_t i = 0; i < pixels; i++)
+			((uint16_t *)dest)[i] = 0xFFF0;
+		break;
+	case Draw::DataFormat::A4R4G4B4_UNORM_PACK16:
+		for (size_t i = 0; i < pixels; i++)
+			((uint16_t *)dest)[i] = 0x0FFF;
+		break;
+	default:
+		memset(dest, 0, pixels * DataFormatSizeInBytes(format));
+		break;
+	}
+}
+
+void TextDrawer::UpdateAtlas(StringCache &cache) {
+	using namespace Draw;
+
+	// Pages are never written to after creation, so the only way to reclaim space is to start over.
+	// The affected strings get rasterized again the next time they're drawn.
+	for (size_t i = 0; i < atlasPages_.size(); ) {
+		TextAtlasPage *page = atlasPages_[i];
+		if (page->livePixels * 4 >= page->usedPixels) {
+			i++;
+			continue;
+		}
+		for (auto iter = cache.begin(); iter != cache.end(); ) {
+			if (iter->second->page == page) {
+				// Deletes the page (and removes it from atlasPages_) on the last one.
+				ReleaseEntry(*iter->second);
+				cache.erase(iter++);
+			} else {
+				iter++;
+			}
+		}
+		if (i < atlasPages_.size() && atlasPages_[i] == page)
+			i++;
+	}
+
+	std::vector<TextStringEntry *> loose;
+	DataFormat format = DataFormat::UNDEFINED;
+	for (auto &iter : cache) {
+		TextStringEntry *entry = iter.second.get();
+		if (entry->page || entry->bitmap.empty() || entry->bmWidth > TEXT_ATLAS_WIDTH || entry->bmHeight > TEXT_ATLAS_MAX_STRING_HEIGHT)
+			continue;
+		if (format == DataFormat::UNDEFINED)
+			format = entry->bitmapFormat;
+		if (entry->bitmapFormat == format)
+			loose.push_back(entry);
+	}
+	if (loose.size() < TEXT_ATLAS_MIN_STRINGS)
+		return;
+
+	// Simple shelf packing, tallest first so each shelf wastes little.
+	std::sort(loose.begin(), loose.end(), [](const TextStringEntry *a, const TextStringEntry *b) {
+		return a->bmHeight > b->bmHeight;
+	});
+	int x = 0;
+	int y = 0;
+	int shelfHeight = 0;
+	size_t packed = 0;
+	for (; packed < loose.size(); packed++) {
+		TextStringEntry *entry = loose[packed];
+		if (x + entry->bmWidth > TEXT_ATLAS_WIDTH) {
+			x = 0;
+			y += shelfHeight + TEXT_ATLAS_PADDING;
+			shelfHeight = 0;
+		}
+		if (y + entry->bmHeight > TEXT_ATLAS_MAX_HEIGHT)
+			break;
+		entry->atlasX = x;
+		entry->atlasY = y;
+		x += entry->bmWidth + TEXT_ATLAS_PADDING;
+		shelfHeight = std::max(shelfHeight, entry->bmHeight);
+	}
+	loose.resize(packed);
+	if (loose.size() < TEXT_ATLAS_MIN_STRINGS)
+		return;
+
+	int height = (y + shelfHeight + 3) & ~3;
+	size_t bpp = DataFormatSizeInBytes(format);
+	std::vector<uint8_t> pixels(TEXT_ATLAS_WIDTH * height * bpp);
+	FillTransparent(&pixels[0], TEXT_ATLAS_WIDTH * height, format);
+	int usedPixels = 0;
+	for (TextStringEntry *entry : loose) {
+		size_t rowBytes = entry->bmWidth * bpp;
+		for (int row = 0; row < entry->bmHeight; row++) {
+			memcpy(&pixels[((entry->atlasY + row) * TEXT_ATLAS_WIDTH + entry->atlasX) * bpp], &entry->bitmap[row * rowBytes], rowBytes);
+		}
+		usedPixels += entry->bmWidth * entry->bmHeight;
+	}
+
+	TextureDesc desc{};
+	desc.initData.push_back(&pixels[0]);
+	desc.type = TextureType::LINEAR2D;
+	desc.format = format;
+	desc.width = TEXT_ATLAS_WIDTH;
+	desc.height = height;
+	desc.depth = 1;
+	desc.mipLevels = 1;
+	desc.generateMips = false;
+	desc.tag = "TextAtlas";
+	Texture *texture = draw_->CreateTexture(desc);
+	if (!texture)
+		return;
+
+	TextAtlasPage *page = new TextAtlasPage{ texture, TEXT_ATLAS_WIDTH, height, (int)loose.size(), usedPixels, usedPixels };
+	atlasPages_.push_back(page);
+	for (TextStringEntry *entry : loose) {
+		if (entry->texture) {
+			entry->texture->Release();
+			entry->texture = nullptr;
+		}
+		entry->page = page;
+		entry->bitmap.clear();
+		entry->bitmap.shrink_to_fit();
+	}
+}
+
 TextDrawer *TextDrawer::Create(Draw::DrawContext *draw) {
 	TextDrawer *drawer = nullptr;
 #if defined(__LIBRETRO__)
@@ -3,15 +3,17 @@
 // Uses system fonts to draw text. 
 // Platform support will be added over time, initially just Win32.
 
-// Caches strings in individual textures. Might later combine them into a big one
-// with dynamically allocated space but too much trouble for now.
+// Caches strings in individual textures at first. Strings that stick around get packed
+// together into shared atlas pages, see TextDrawer::UpdateAtlas.
 
 #pragma once
 
 #include "ppsspp_config.h"
 
+#include <map>
 #include <memory>
 #include <cstdint>
+#include <vector>
 
 #include "Common/Data/Text/WrapText.h"
 #include "Common/Render/DrawBuffer.h"
@@ -21,6 +23,15 @@ namespace Draw {
 	class Texture;
 }
 
+struct TextAtlasPage {
+	Draw::Texture *texture;
+	int width;
+	int height;
+	int liveStrings;
+	int livePixels;
+	int usedPixels;
+};
+
 struct TextStringEntry {
 	Draw::Texture *texture;
 	int width;
@@ -28,6 +39,13 @@ struct TextStringEntry {
 	int bmWidth;
 	int bmHeight;
 	int lastUsedFrame;
+
+	// The rasterized bitmap is kept until the string has been packed into an atlas page.
+	std::vector<uint8_t> bitmap;
+	Draw::DataFormat bitmapFormat;
+	TextAtlasPage *page;
+	int atlasX;
+	int atlasY;
 };
 
 struct TextMeasureEntry {
@@ -80,8 +98,19 @@ class TextDrawer {
 		std::string text;
 		uint32_t fontHash;
 	};
+	typedef std::map<CacheKey, std::unique_ptr<TextStringEntry>> StringCache;
+
+	// Shared by the platform implementations. bitmapData is consumed.
+	void CreateEntryTexture(TextStringEntry *entry, std::vector<uint8_t> &bitmapData, Draw::DataFormat texFormat);
+	// Draws the top left srcW x srcH pixels of the string, wherever it lives. Bind nothing beforehand.
+	void DrawEntry(DrawBuffer &target, const TextStringEntry &entry, int srcW, int srcH, float x, float y, uint32_t color, int align);
+	void ReleaseEntry(TextStringEntry &entry);
+	// Call after dropping old strings. Packs loose strings into a new atlas page, and drops the
+	// strings of pages that have become mostly empty so they get packed again more tightly.
+	void UpdateAtlas(StringCache &cache);
 
 	int frameCount_ = 0;
+	std::vector<TextAtlasPage *> atlasPages_;
 	float fontScaleX_ = 1.0f;
 	float fontScaleY_ = 1.0f;
 	float dpiScale_ = 1.0f;
@@ -0,0 +1,483 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#include <cstring>
+
+#include "Common/Log.h"
+#include "Common/MemoryUtil.h"
+#include "Common/RiscVEmitter.h"
+
+namespace RiscVGen {
+
+enum {
+	OPCODE_LOAD = 0x03,
+	OPCODE_MISC_MEM = 0x0F,
+	OPCODE_OP_IMM = 0x13,
+	OPCODE_AUIPC = 0x17,
+	OPCODE_OP_IMM_32 = 0x1B,
+	OPCODE_STORE = 0x23,
+	OPCODE_OP = 0x33,
+	OPCODE_LUI = 0x37,
+	OPCODE_OP_32 = 0x3B,
+	OPCODE_BRANCH = 0x63,
+	OPCODE_JALR = 0x67,
+	OPCODE_JAL = 0x6F,
+	OPCODE_SYSTEM = 0x73,
+};
+
+static inline bool IsGPR(RiscVReg r) {
+	return (u32)r < 32;
+}
+
+static inline bool JTypeInRange(ptrdiff_t offset) {
+	return offset >= -0x100000 && offset < 0x100000;
+}
+
+static inline bool BTypeInRange(ptrdiff_t offset) {
+	return offset >= -0x1000 && offset < 0x1000;
+}
+
+static inline s32 SignExtend12(s64 v) {
+	return (s32)((u32)v << 20) >> 20;
+}
+
+void RiscVEmitter::SetCodePointer(const u8 *ptr, u8 *writePtr) {
+	code_ = ptr;
+	writable_ = writePtr;
+	lastCacheFlushEnd_ = ptr;
+}
+
+const u8 *RiscVEmitter::GetCodePointer() const {
+	return code_;
+}
+
+void RiscVEmitter::ReserveCodeSpace(u32 bytes) {
+	_dbg_assert_msg_((bytes & 3) == 0, "Code space must be reserved in whole instructions");
+	for (u32 i = 0; i < bytes / 4; ++i) {
+		EBREAK();
+	}
+}
+
+const u8 *RiscVEmitter::AlignCode16() {
+	ReserveCodeSpace((-(intptr_t)code_) & 15);
+	return code_;
+}
+
+const u8 *RiscVEmitter::AlignCodePage() {
+	// TODO: Assuming code pages ought to be 4K?
+	ReserveCodeSpace((-(intptr_t)code_) & 4095);
+	return code_;
+}
+
+const u8 *RiscVEmitter::GetCodePtr() const {
+	return code_;
+}
+
+u8 *RiscVEmitter::GetWritableCodePtr() {
+	return writable_;
+}
+
+void RiscVEmitter::FlushIcache() {
+	FlushIcacheSection(lastCacheFlushEnd_, code_);
+	lastCacheFlushEnd_ = code_;
+}
+
+void RiscVEmitter::FlushIcacheSection(const u8 *start, const u8 *end) {
+#if PPSSPP_ARCH(RISCV64)
+	// This also makes other harts see the change, which a plain FENCE.I doesn't.
+	__builtin___clear_cache((char *)start, (char *)end);
+#endif
+}
+
+void RiscVEmitter::Write32(u32 value) {
+	memcpy(writable_, &value, sizeof(value));
+	writable_ += 4;
+	code_ += 4;
+}
+
+void RiscVEmitter::EmitR(u32 opcode, RiscVReg rd, u32 funct3, RiscVReg rs1, RiscVReg rs2, u32 funct7) {
+	_dbg_assert_msg_(IsGPR(rd) && IsGPR(rs1) && IsGPR(rs2), "Bad emitter arguments");
+	Write32((funct7 << 25) | ((u32)rs2 << 20) | ((u32)rs1 << 15) | (funct3 << 12) | ((u32)rd << 7) | opcode);
+}
+
+void RiscVEmitter::EmitI(u32 opcode, RiscVReg rd, u32 funct3, RiscVReg rs1, s32 simm12) {
+	_dbg_assert_msg_(IsGPR(rd) && IsGPR(rs1), "Bad emitter arguments");
+	_dbg_assert_msg_(SignedFits12(simm12), "Immediate %d out of range", simm12);
+	Write32(((u32)simm12 << 20) | ((u32)rs1 << 15) | (funct3 << 12) | ((u32)rd << 7) | opcode);
+}
+
+void RiscVEmitter::EmitS(u32 opcode, u32 funct3, RiscVReg rs1, RiscVReg rs2, s32 simm12) {
+	_dbg_assert_msg_(IsGPR(rs1) && IsGPR(rs2), "Bad emitter arguments");
+	_dbg_assert_msg_(SignedFits12(simm12), "Immediate %d out of range", simm12);
+	u32 imm = (u32)simm12;
+	Write32(((imm >> 5) << 25) | ((u32)rs2 << 20) | ((u32)rs1 << 15) | (funct3 << 12) | ((imm & 0x1F) << 7) | opcode);
+}
+
+void RiscVEmitter::EmitU(u32 opcode, RiscVReg rd, s32 simm32) {
+	_dbg_assert_msg_(IsGPR(rd), "Bad emitter arguments");
+	_dbg_assert_msg_((simm32 & 0xFFF) == 0, "Low bits must be clear for U-type immediates");
+	Write32(((u32)simm32 & 0xFFFFF000) | ((u32)rd << 7) | opcode);
+}
+
+FixupBranch RiscVEmitter::EmitB(u32 funct3, RiscVReg rs1, RiscVReg rs2) {
+	_dbg_assert_msg_(IsGPR(rs1) && IsGPR(rs2), "Bad emitter arguments");
+	FixupBranch b{ code_, FixupBranchType::B };
+	// The offset is filled in by SetJumpTarget().
+	Write32(((u32)rs2 << 20) | ((u32)rs1 << 15) | (funct3 << 12) | OPCODE_BRANCH);
+	return b;
+}
+
+void RiscVEmitter::SetJumpTarget(const FixupBranch &branch) {
+	SetJumpTarget(branch, code_);
+}
+
+void RiscVEmitter::SetJumpTarget(const FixupBranch &branch, const void *dst) {
+	ptrdiff_t offset = (const u8 *)dst - branch.ptr;
+	u8 *writablePtr = (u8 *)branch.ptr + (writable_ - code_);
+	u32 inst;
+	memcpy(&inst, writablePtr, sizeof(inst));
+
+	u32 imm = (u32)offset;
+	switch (branch.type) {
+	case FixupBranchType::B:
+		_assert_msg_(BTypeInRange(offset), "Branch target too far away (%d)", (int)offset);
+		inst |= (((imm >> 12) & 1) << 31) | (((imm >> 5) & 0x3F) << 25) | (((imm >> 1) & 0xF) << 8) | (((imm >> 11) & 1) << 7);
+		break;
+
+	case FixupBranchType::J:
+		_assert_msg_(JTypeInRange(offset), "Jump target too far away (%d)", (int)offset);
+		inst |= (((imm >> 20) & 1) << 31) | (((imm >> 1) & 0x3FF) << 21) | (((imm >> 11) & 1) << 20) | (((imm >> 12) & 0xFF) << 12);
+		break;
+	}
+
+	memcpy(writablePtr, &inst, sizeof(inst));
+}
+
+bool RiscVEmitter::JInRange(const void *func) const {
+	return JTypeInRange((const u8 *)func - code_);
+}
+
+void RiscVEmitter::EBREAK() {
+	Write32(0x00100000 | OPCODE_SYSTEM);
+}
+
+void RiscVEmitter::LUI(RiscVReg rd, s32 simm32) {
+	EmitU(OPCODE_LUI, rd, simm32);
+}
+
+void RiscVEmitter::AUIPC(RiscVReg rd, s32 simm32) {
+	EmitU(OPCODE_AUIPC, rd, simm32);
+}
+
+FixupBranch RiscVEmitter::JAL(RiscVReg rd) {
+	_dbg_assert_msg_(IsGPR(rd), "Bad emitter arguments");
+	FixupBranch b{ code_, FixupBranchType::J };
+	Write32(((u32)rd << 7) | OPCODE_JAL);
+	return b;
+}
+
+void RiscVEmitter::JAL(RiscVReg rd, const void *dst) {
+	SetJumpTarget(JAL(rd), dst);
+}
+
+void RiscVEmitter::JALR(RiscVReg rd, RiscVReg rs1, s32 simm12) {
+	EmitI(OPCODE_JALR, rd, 0, rs1, simm12);
+}
+
+FixupBranch RiscVEmitter::BEQ(RiscVReg rs1, RiscVReg rs2) {
+	return EmitB(0, rs1, rs2);
+}
+
+FixupBranch RiscVEmitter::BNE(RiscVReg rs1, RiscVReg rs2) {
+	return EmitB(1, rs1, rs2);
+}
+
+FixupBranch RiscVEmitter::BLT(RiscVReg rs1, RiscVReg rs2) {
+	return EmitB(4, rs1, rs2);
+}
+
+FixupBranch RiscVEmitter::BGE(RiscVReg rs1, RiscVReg rs2) {
+	return EmitB(5, rs1, rs2);
+}
+
+FixupBranch RiscVEmitter::BLTU(RiscVReg rs1, RiscVReg rs2) {
+	return EmitB(6, rs1, rs2);
+}
+
+FixupBranch RiscVEmitter::BGEU(RiscVReg rs1, RiscVReg rs2) {
+	return EmitB(7, rs1, rs2);
+}
+
+void RiscVEmitter::LB(RiscVReg rd, RiscVReg addr, s32 simm12) {
+	EmitI(OPCODE_LOAD, rd, 0, addr, simm12);
+}
+
+void RiscVEmitter::LH(RiscVReg rd, RiscVReg addr, s32 simm12) {
+	EmitI(OPCODE_LOAD, rd, 1, addr, simm12);
+}
+
+void RiscVEmitter::LW(RiscVReg rd, RiscVReg addr, s32 simm12) {
+	EmitI(OPCODE_LOAD, rd, 2, addr, simm12);
+}
+
+void RiscVEmitter::LD(RiscVReg rd, RiscVReg addr, s32 simm12) {
+	EmitI(OPCODE_LOAD, rd, 3, addr, simm12);
+}
+
+void RiscVEmitter::LBU(RiscVReg rd, RiscVReg addr, s32 simm12) {
+	EmitI(OPCODE_LOAD, rd, 4, addr, simm12);
+}
+
+void RiscVEmitter::LHU(RiscVReg rd, RiscVReg addr, s32 simm12) {
+	EmitI(OPCODE_LOAD, rd, 5, addr, simm12);
+}
+
+void RiscVEmitter::LWU(RiscVReg rd, RiscVReg addr, s32 simm12) {
+	EmitI(OPCODE_LOAD, rd, 6, addr, simm12);
+}
+
+void RiscVEmitter::SB(RiscVReg src, RiscVReg addr, s32 simm12) {
+	EmitS(OPCODE_STORE, 0, addr, src, simm12);
+}
+
+void RiscVEmitter::SH(RiscVReg src, RiscVReg addr, s32 simm12) {
+	EmitS(OPCODE_STORE, 1, addr, src, simm12);
+}
+
+void RiscVEmitter::SW(RiscVReg src, RiscVReg addr, s32 simm12) {
+	EmitS(OPCODE_STORE, 2, addr, src, simm12);
+}
+
+void RiscVEmitter::SD(RiscVReg src, RiscVReg addr, s32 simm12) {
+	EmitS(OPCODE_STORE, 3, addr, src, simm12);
+}
+
+void RiscVEmitter::ADDI(RiscVReg rd, RiscVReg rs1, s32 simm12) {
+	EmitI(OPCODE_OP_IMM, rd, 0, rs1, simm12);
+}
+
+void RiscVEmitter::SLTI(RiscVReg rd, RiscVReg rs1, s32 simm12) {
+	EmitI(OPCODE_OP_IMM, rd, 2, rs1, simm12);
+}
+
+void RiscVEmitter::SLTIU(RiscVReg rd, RiscVReg rs1, s32 simm12) {
+	EmitI(OPCODE_OP_IMM, rd, 3, rs1, simm12);
+}
+
+void RiscVEmitter::XORI(RiscVReg rd, RiscVReg rs1, s32 simm12) {
+	EmitI(OPCODE_OP_IMM, rd, 4, rs1, simm12);
+}
+
+void RiscVEmitter::ORI(RiscVReg rd, RiscVReg rs1, s32 simm12) {
+	EmitI(OPCODE_OP_IMM, rd, 6, rs1, simm12);
+}
+
+void RiscVEmitter::ANDI(RiscVReg rd, RiscVReg rs1, s32 simm12) {
+	EmitI(OPCODE_OP_IMM, rd, 7, rs1, simm12);
+}
+
+void RiscVEmitter::SLLI(RiscVReg rd, RiscVReg rs1, u32 shamt) {
+	_dbg_assert_msg_(shamt < 64, "Bad shift amount");
+	EmitI(OPCODE_OP_IMM, rd, 1, rs1, (s32)shamt);
+}
+
+void RiscVEmitter::SRLI(RiscVReg rd, RiscVReg rs1, u32 shamt) {
+	_dbg_assert_msg_(shamt < 64, "Bad shift amount");
+	EmitI(OPCODE_OP_IMM, rd, 5, rs1, (s32)shamt);
+}
+
+void RiscVEmitter::SRAI(RiscVReg rd, RiscVReg rs1, u32 shamt) {
+	_dbg_assert_msg_(shamt < 64, "Bad shift amount");
+	EmitI(OPCODE_OP_IMM, rd, 5, rs1, (s32)(0x400 | shamt));
+}
+
+void RiscVEmitter::ADD(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 0, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::SUB(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 0, rs1, rs2, 0x20);
+}
+
+void RiscVEmitter::SLL(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 1, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::SLT(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 2, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::SLTU(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 3, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::XOR(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 4, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::SRL(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 5, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::SRA(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 5, rs1, rs2, 0x20);
+}
+
+void RiscVEmitter::OR(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 6, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::AND(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 7, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::ADDIW(RiscVReg rd, RiscVReg rs1, s32 simm12) {
+	EmitI(OPCODE_OP_IMM_32, rd, 0, rs1, simm12);
+}
+
+void RiscVEmitter::SLLIW(RiscVReg rd, RiscVReg rs1, u32 shamt) {
+	_dbg_assert_msg_(shamt < 32, "Bad shift amount");
+	EmitI(OPCODE_OP_IMM_32, rd, 1, rs1, (s32)shamt);
+}
+
+void RiscVEmitter::SRLIW(RiscVReg rd, RiscVReg rs1, u32 shamt) {
+	_dbg_assert_msg_(shamt < 32, "Bad shift amount");
+	EmitI(OPCODE_OP_IMM_32, rd, 5, rs1, (s32)shamt);
+}
+
+void RiscVEmitter::SRAIW(RiscVReg rd, RiscVReg rs1, u32 shamt) {
+	_dbg_assert_msg_(shamt < 32, "Bad shift amount");
+	EmitI(OPCODE_OP_IMM_32, rd, 5, rs1, (s32)(0x400 | shamt));
+}
+
+void RiscVEmitter::ADDW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP_32, rd, 0, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::SUBW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP_32, rd, 0, rs1, rs2, 0x20);
+}
+
+void RiscVEmitter::SLLW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP_32, rd, 1, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::SRLW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP_32, rd, 5, rs1, rs2, 0x00);
+}
+
+void RiscVEmitter::SRAW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP_32, rd, 5, rs1, rs2, 0x20);
+}
+
+void RiscVEmitter::MUL(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 0, rs1, rs2, 0x01);
+}
+
+void RiscVEmitter::MULH(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 1, rs1, rs2, 0x01);
+}
+
+void RiscVEmitter::MULHU(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP, rd, 3, rs1, rs2, 0x01);
+}
+
+void RiscVEmitter::MULW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2) {
+	EmitR(OPCODE_OP_32, rd, 0, rs1, rs2, 0x01);
+}
+
+void RiscVEmitter::FENCE_I() {
+	Write32((1 << 12) | OPCODE_MISC_MEM);
+}
+
+void RiscVEmitter::LI(RiscVReg rd, s64 value) {
+	if (SignedFits12(value)) {
+		ADDI(rd, R_ZERO, (s32)value);
+		return;
+	}
+
+	if ((s64)(s32)value == value) {
+		// ADDIW sign extends from 32 bits, so hi wrapping to 0x80000000 still works out.
+		s32 lo = SignExtend12(value);
+		s32 hi = (s32)((u32)value - (u32)lo);
+		LUI(rd, hi);
+		if (lo != 0)
+			ADDIW(rd, rd, lo);
+		return;
+	}
+
+	// Build the upper bits recursively, skipping any trailing zeros, then shift and add the rest.
+	s32 lo = SignExtend12(value);
+	s64 hi = (s64)((u64)value - (u64)(s64)lo) >> 12;
+	int shift = 12;
+	while ((hi & 1) == 0) {
+		hi >>= 1;
+		shift++;
+	}
+	LI(rd, hi);
+	SLLI(rd, rd, shift);
+	if (lo != 0)
+		ADDI(rd, rd, lo);
+}
+
+void RiscVEmitter::FarJump(RiscVReg rd, RiscVReg scratchreg, const void *dst) {
+	ptrdiff_t offset = (const u8 *)dst - code_;
+	s32 lo = SignExtend12(offset);
+	s32 hi = (s32)((u32)offset - (u32)lo);
+	AUIPC(scratchreg, hi);
+	JALR(rd, scratchreg, lo);
+}
+
+void RiscVEmitter::QuickJ(RiscVReg scratchreg, const void *dst) {
+	ptrdiff_t offset = (const u8 *)dst - code_;
+	if (JTypeInRange(offset)) {
+		JAL(R_ZERO, dst);
+	} else if (offset >= -0x7FFFF000LL && offset < 0x7FFFF000LL) {
+		FarJump(R_ZERO, scratchreg, dst);
+	} else {
+		LI(scratchreg, dst);
+		JALR(R_ZERO, scratchreg, 0);
+	}
+}
+
+void RiscVEmitter::QuickCallFunction(RiscVReg scratchreg, const void *func) {
+	ptrdiff_t offset = (const u8 *)func - code_;
+	if (JTypeInRange(offset)) {
+		JAL(R_RA, func);
+	} else if (offset >= -0x7FFFF000LL && offset < 0x7FFFF000LL) {
+		FarJump(R_RA, scratchreg, func);
+	} else {
+		LI(scratchreg, func);
+		JALR(R_RA, scratchreg, 0);
+	}
+}
+
+void RiscVCodeBlock::PoisonMemory(int offset) {
+	// So we can adjust region to writable space.  Might be zero.
+	ptrdiff_t writable = GetWritableCodePtr() - GetCodePointer();
+
+	u32 *ptr = (u32 *)(region + offset + writable);
+	u32 *maxptr = (u32 *)(region + region_size + writable);
+	// If our memory isn't a multiple of u32 then this won't write the last remaining bytes with anything
+	// Less than optimal, but there would be nothing we could do but throw a runtime warning anyway.
+	// RISC-V: 0x00100073 = EBREAK
+	while (ptr < maxptr)
+		*ptr++ = 0x00100073;
+}
+
+};
@@ -0,0 +1,236 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Common/CodeBlock.h"
+#include "Common/CommonTypes.h"
+
+// Emitter for RV64IM, which every RV64GC board supports.  No compressed instructions, so every
+// op is 4 bytes, which keeps fixups simple.
+
+namespace RiscVGen {
+
+enum RiscVReg {
+	X0 = 0, X1, X2, X3, X4, X5, X6, X7, X8, X9, X10, X11, X12, X13, X14, X15,
+	X16, X17, X18, X19, X20, X21, X22, X23, X24, X25, X26, X27, X28, X29, X30, X31,
+
+	// ABI names.
+	R_ZERO = 0, R_RA = 1, R_SP = 2, R_GP = 3, R_TP = 4,
+	T0 = 5, T1 = 6, T2 = 7,
+	S0 = 8, S1 = 9,
+	A0 = 10, A1 = 11, A2 = 12, A3 = 13, A4 = 14, A5 = 15, A6 = 16, A7 = 17,
+	S2 = 18, S3 = 19, S4 = 20, S5 = 21, S6 = 22, S7 = 23, S8 = 24, S9 = 25, S10 = 26, S11 = 27,
+	T3 = 28, T4 = 29, T5 = 30, T6 = 31,
+
+	INVALID_REG = 0xFFFFFFFF
+};
+
+enum class FixupBranchType {
+	// B-type conditional branch, +/- 4 KiB.
+	B,
+	// JAL, +/- 1 MiB.
+	J,
+};
+
+struct FixupBranch {
+	const u8 *ptr;
+	FixupBranchType type;
+};
+
+class RiscVEmitter {
+public:
+	RiscVEmitter() {}
+	RiscVEmitter(const u8 *codePtr, u8 *writablePtr) {
+		SetCodePointer(codePtr, writablePtr);
+	}
+	virtual ~RiscVEmitter() {}
+
+	void SetCodePointer(const u8 *ptr, u8 *writePtr);
+	const u8 *GetCodePointer() const;
+
+	void ReserveCodeSpace(u32 bytes);
+	const u8 *AlignCode16();
+	const u8 *AlignCodePage();
+	const u8 *GetCodePtr() const;
+	u8 *GetWritableCodePtr();
+	void FlushIcache();
+	void FlushIcacheSection(const u8 *start, const u8 *end);
+
+	void SetJumpTarget(const FixupBranch &branch);
+	// True if a JAL from the current position can reach func.
+	bool JInRange(const void *func) const;
+
+	void EBREAK();
+	void NOP() {
+		ADDI(R_ZERO, R_ZERO, 0);
+	}
+
+	// These take the full value, which must have the low 12 bits clear.
+	void LUI(RiscVReg rd, s32 simm32);
+	void AUIPC(RiscVReg rd, s32 simm32);
+
+	FixupBranch JAL(RiscVReg rd);
+	void JAL(RiscVReg rd, const void *dst);
+	void JALR(RiscVReg rd, RiscVReg rs1, s32 simm12);
+	FixupBranch J() {
+		return JAL(R_ZERO);
+	}
+	void RET() {
+		JALR(R_ZERO, R_RA, 0);
+	}
+
+	FixupBranch BEQ(RiscVReg rs1, RiscVReg rs2);
+	FixupBranch BNE(RiscVReg rs1, RiscVReg rs2);
+	FixupBranch BLT(RiscVReg rs1, RiscVReg rs2);
+	FixupBranch BGE(RiscVReg rs1, RiscVReg rs2);
+	FixupBranch BLTU(RiscVReg rs1, RiscVReg rs2);
+	FixupBranch BGEU(RiscVReg rs1, RiscVReg rs2);
+
+	void LB(RiscVReg rd, RiscVReg addr, s32 simm12);
+	void LH(RiscVReg rd, RiscVReg addr, s32 simm12);
+	void LW(RiscVReg rd, RiscVReg addr, s32 simm12);
+	void LD(RiscVReg rd, RiscVReg addr, s32 simm12);
+	void LBU(RiscVReg rd, RiscVReg addr, s32 simm12);
+	void LHU(RiscVReg rd, RiscVReg addr, s32 simm12);
+	void LWU(RiscVReg rd, RiscVReg addr, s32 simm12);
+	void SB(RiscVReg src, RiscVReg addr, s32 simm12);
+	void SH(RiscVReg src, RiscVReg addr, s32 simm12);
+	void SW(RiscVReg src, RiscVReg addr, s32 simm12);
+	void SD(RiscVReg src, RiscVReg addr, s32 simm12);
+
+	void ADDI(RiscVReg rd, RiscVReg rs1, s32 simm12);
+	void SLTI(RiscVReg rd, RiscVReg rs1, s32 simm12);
+	// Note: the immediate is sign extended, then compared unsigned.
+	void SLTIU(RiscVReg rd, RiscVReg rs1, s32 simm12);
+	void XORI(RiscVReg rd, RiscVReg rs1, s32 simm12);
+	void ORI(RiscVReg rd, RiscVReg rs1, s32 simm12);
+	void ANDI(RiscVReg rd, RiscVReg rs1, s32 simm12);
+	void SLLI(RiscVReg rd, RiscVReg rs1, u32 shamt);
+	void SRLI(RiscVReg rd, RiscVReg rs1, u32 shamt);
+	void SRAI(RiscVReg rd, RiscVReg rs1, u32 shamt);
+
+	void ADD(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SUB(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SLL(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SLT(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SLTU(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void XOR(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SRL(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SRA(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void OR(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void AND(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+
+	// The W variants operate on the low 32 bits and sign extend the result to 64.
+	void ADDIW(RiscVReg rd, RiscVReg rs1, s32 simm12);
+	void SLLIW(RiscVReg rd, RiscVReg rs1, u32 shamt);
+	void SRLIW(RiscVReg rd, RiscVReg rs1, u32 shamt);
+	void SRAIW(RiscVReg rd, RiscVReg rs1, u32 shamt);
+	void ADDW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SUBW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SLLW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SRLW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void SRAW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+
+	// M extension.
+	void MUL(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void MULH(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void MULHU(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	void MULW(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+
+	void FENCE_I();
+
+	// Pseudo-ops.
+	void MV(RiscVReg rd, RiscVReg rs) {
+		ADDI(rd, rs, 0);
+	}
+	void NEG(RiscVReg rd, RiscVReg rs) {
+		SUB(rd, R_ZERO, rs);
+	}
+	void NEGW(RiscVReg rd, RiscVReg rs) {
+		SUBW(rd, R_ZERO, rs);
+	}
+	void NOT(RiscVReg rd, RiscVReg rs) {
+		XORI(rd, rs, -1);
+	}
+	void SEXT_W(RiscVReg rd, RiscVReg rs) {
+		ADDIW(rd, rs, 0);
+	}
+	void ZEXT_W(RiscVReg rd, RiscVReg rs) {
+		SLLI(rd, rs, 32);
+		SRLI(rd, rd, 32);
+	}
+	void SEQZ(RiscVReg rd, RiscVReg rs) {
+		SLTIU(rd, rs, 1);
+	}
+	void SNEZ(RiscVReg rd, RiscVReg rs) {
+		SLTU(rd, R_ZERO, rs);
+	}
+	FixupBranch BEQZ(RiscVReg rs) {
+		return BEQ(rs, R_ZERO);
+	}
+	FixupBranch BNEZ(RiscVReg rs) {
+		return BNE(rs, R_ZERO);
+	}
+
+	// Loads any 64-bit constant, in up to 8 instructions (usually 1-2.)
+	void LI(RiscVReg rd, s64 value);
+	template <class T> void LI(RiscVReg rd, const T *ptr) {
+		LI(rd, (s64)(intptr_t)(const void *)ptr);
+	}
+
+	// Jumps or calls anywhere, using scratchreg if it's not reachable with a plain JAL.
+	void QuickJ(RiscVReg scratchreg, const void *dst);
+	void QuickCallFunction(RiscVReg scratchreg, const void *func);
+	template <typename T> void QuickCallFunction(RiscVReg scratchreg, T func) {
+		QuickCallFunction(scratchreg, (const void *)func);
+	}
+
+	static bool SignedFits12(s64 v) {
+		return v >= -2048 && v <= 2047;
+	}
+
+protected:
+	void Write32(u32 value);
+
+	void EmitR(u32 opcode, RiscVReg rd, u32 funct3, RiscVReg rs1, RiscVReg rs2, u32 funct7);
+	void EmitI(u32 opcode, RiscVReg rd, u32 funct3, RiscVReg rs1, s32 simm12);
+	void EmitS(u32 opcode, u32 funct3, RiscVReg rs1, RiscVReg rs2, s32 simm12);
+	void EmitU(u32 opcode, RiscVReg rd, s32 simm32);
+	FixupBranch EmitB(u32 funct3, RiscVReg rs1, RiscVReg rs2);
+	void SetJumpTarget(const FixupBranch &branch, const void *dst);
+	// Jumps via AUIPC + JALR, for targets within 2 GiB.
+	void FarJump(RiscVReg rd, RiscVReg scratchreg, const void *dst);
+
+private:
+	const u8 *code_ = nullptr;
+	u8 *writable_ = nullptr;
+	const u8 *lastCacheFlushEnd_ = nullptr;
+};
+
+// Everything that needs to generate machine code should inherit from this.
+// You get memory management for free, plus, you can use all the ADDI etc functions without
+// having to prefix them with gen-> or something similar.
+class RiscVCodeBlock : public CodeBlock<RiscVEmitter> {
+private:
+	void PoisonMemory(int offset) override;
+};
+
+};
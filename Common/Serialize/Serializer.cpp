@@ -15,6 +15,7 @@
 // Official SVN repository and contact information can be found at
 // http://code.google.com/p/dolphin-emu/
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <snappy-c.h>
@@ -24,14 +25,141 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/TimeUtil.h"
 
 enum class SerializeCompressType {
 	NONE = 0,
 	SNAPPY = 1,
 	ZSTD = 2,
+	// Independent zstd frames, so they can be compressed and decompressed in parallel.
+	// Layout: u32 chunk size, u32 chunk count, u32 compressed size per chunk, then the frames.
+	ZSTD_CHUNKED = 3,
 };
 
-static constexpr SerializeCompressType SAVE_TYPE = SerializeCompressType::ZSTD;
+static constexpr SerializeCompressType SAVE_TYPE = SerializeCompressType::ZSTD_CHUNKED;
+static const size_t ZSTD_CHUNK_SIZE = 4 * 1024 * 1024;
+
+// Compresses each chunk into its own buffer, so they can be written out without gathering them first.
+static bool CompressZstdChunks(const u8 *src, size_t sz, std::vector<std::vector<u8>> &chunks) {
+	const u32 chunkCount = (u32)((sz + ZSTD_CHUNK_SIZE - 1) / ZSTD_CHUNK_SIZE);
+	chunks.resize(chunkCount);
+	std::vector<u8> failed(chunkCount, 0);
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		ZSTD_CCtx *ctx = ZSTD_createCCtx();
+		for (int i = l; i < h; ++i) {
+			size_t offset = i * ZSTD_CHUNK_SIZE;
+			size_t chunkSize = std::min(ZSTD_CHUNK_SIZE, sz - offset);
+			chunks[i].resize(ZSTD_compressBound(chunkSize));
+			size_t result = 0;
+			if (ctx) {
+				// TODO: If free disk space is low, we could max this out to 22?
+				ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+				ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, 1);
+				ZSTD_CCtx_setPledgedSrcSize(ctx, chunkSize);
+				result = ZSTD_compress2(ctx, &chunks[i][0], chunks[i].size(), src + offset, chunkSize);
+			}
+			if (!ctx || ZSTD_isError(result)) {
+				failed[i] = 1;
+			} else {
+				chunks[i].resize(result);
+			}
+		}
+		ZSTD_freeCCtx(ctx);
+	}, 0, (int)chunkCount, 1);
+
+	for (u32 i = 0; i < chunkCount; ++i) {
+		if (failed[i])
+			return false;
+	}
+	return true;
+}
+
+static size_t ZstdChunksSize(const std::vector<std::vector<u8>> &chunks) {
+	size_t total = (2 + chunks.size()) * sizeof(u32);
+	for (const auto &chunk : chunks)
+		total += chunk.size();
+	return total;
+}
+
+static bool WriteZstdChunks(File::IOFile &pFile, const std::vector<std::vector<u8>> &chunks) {
+	std::vector<u32> table;
+	table.reserve(2 + chunks.size());
+	table.push_back((u32)ZSTD_CHUNK_SIZE);
+	table.push_back((u32)chunks.size());
+	for (const auto &chunk : chunks)
+		table.push_back((u32)chunk.size());
+	if (!pFile.WriteArray(table.data(), table.size()))
+		return false;
+
+	for (const auto &chunk : chunks) {
+		if (!pFile.WriteBytes(chunk.data(), chunk.size()))
+			return false;
+	}
+	return true;
+}
+
+static bool DecompressZstdChunked(const u8 *src, size_t sz, u8 *dest, size_t &destLen) {
+	if (sz < 2 * sizeof(u32))
+		return false;
+
+	const u32 *table = (const u32 *)src;
+	const size_t chunkSize = table[0];
+	const u32 chunkCount = table[1];
+	const size_t tableSize = (2 + (size_t)chunkCount) * sizeof(u32);
+	if (chunkSize == 0 || tableSize > sz || (u64)chunkSize * chunkCount < destLen)
+		return false;
+
+	std::vector<size_t> offsets(chunkCount);
+	size_t pos = tableSize;
+	for (u32 i = 0; i < chunkCount; ++i) {
+		offsets[i] = pos;
+		pos += table[2 + i];
+	}
+	if (pos != sz)
+		return false;
+
+	std::vector<u8> failed(chunkCount, 0);
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		ZSTD_DCtx *ctx = ZSTD_createDCtx();
+		for (int i = l; i < h; ++i) {
+			size_t offset = i * chunkSize;
+			size_t expected = offset < destLen ? std::min(chunkSize, destLen - offset) : 0;
+			size_t result = ctx ? ZSTD_decompressDCtx(ctx, dest + offset, expected, src + offsets[i], table[2 + i]) : 0;
+			if (!ctx || ZSTD_isError(result) || result != expected)
+				failed[i] = 1;
+		}
+		ZSTD_freeDCtx(ctx);
+	}, 0, (int)chunkCount, 1);
+
+	for (u32 i = 0; i < chunkCount; ++i) {
+		if (failed[i])
+			return false;
+	}
+	return true;
+}
+
+bool CChunkFileReader::CompressBuffer(const u8 *src, size_t sz, std::vector<u8> &compressed) {
+	std::vector<std::vector<u8>> chunks;
+	if (!CompressZstdChunks(src, sz, chunks))
+		return false;
+
+	compressed.resize(ZstdChunksSize(chunks));
+	u32 *table = (u32 *)&compressed[0];
+	table[0] = (u32)ZSTD_CHUNK_SIZE;
+	table[1] = (u32)chunks.size();
+	size_t pos = (2 + chunks.size()) * sizeof(u32);
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		table[2 + i] = (u32)chunks[i].size();
+		memcpy(&compressed[pos], chunks[i].data(), chunks[i].size());
+		pos += chunks[i].size();
+	}
+	return true;
+}
+
+bool CChunkFileReader::DecompressBuffer(const std::vector<u8> &compressed, u8 *dest, size_t destLen) {
+	return DecompressZstdChunked(compressed.data(), compressed.size(), dest, destLen);
+}
 
 PointerWrapSection PointerWrap::Section(const char *title, int ver) {
 	return Section(title, ver, ver);
@@ -225,10 +353,27 @@ void PointerWrap::DoMarker(const char *prevName, u32 arbitraryNumber) {
 	}
 }
 
+PointerWrapSection::PointerWrapSection(PointerWrap &p, int ver, const char *title) : p_(p), ver_(ver), title_(title) {
+	if (p_.sectionStats && ver_ > 0) {
+		// The header was already done by now, so count it too.
+		start_ = (size_t)*p_.ptr - sizeof(char[16]) - sizeof(int);
+		startTime_ = time_now_d();
+		statsIndex_ = (int)p_.sectionStats->size();
+		p_.sectionStats->push_back(PointerWrap::SectionStats{ title_, p_.sectionDepth_, 0, 0.0 });
+		p_.sectionDepth_++;
+	}
+}
+
 PointerWrapSection::~PointerWrapSection() {
 	if (ver_ > 0) {
 		p_.DoMarker(title_);
 	}
+	if (statsIndex_ >= 0) {
+		PointerWrap::SectionStats &stats = (*p_.sectionStats)[statsIndex_];
+		stats.size = (size_t)*p_.ptr - start_;
+		stats.seconds = time_now_d() - startTime_;
+		p_.sectionDepth_--;
+	}
 }
 
 CChunkFileReader::Error CChunkFileReader::LoadFileHeader(File::IOFile &pFile, SChunkHeader &header, std::string *title) {
@@ -327,6 +472,8 @@ CChunkFileReader::Error CChunkFileReader::LoadFile(const Path &filename, std::st
 			if (success) {
 				uncomp_size = status;
 			}
+		} else if (SerializeCompressType(header.Compress) == SerializeCompressType::ZSTD_CHUNKED) {
+			success = DecompressZstdChunked(buffer, sz, uncomp_buffer, uncomp_size);
 		} else {
 			ERROR_LOG(SAVESTATE, "ChunkReader: Unexpected compression type %d", header.Compress);
 		}
@@ -372,6 +519,8 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const Path &filename, const s
 	// Make sure we can allocate a buffer to compress before compressing.
 	size_t write_len;
 	SerializeCompressType usedType = SAVE_TYPE;
+	// Chunks go straight to the file from their own buffers, so there's no single compressed buffer.
+	std::vector<std::vector<u8>> chunks;
 	switch (usedType) {
 	case SerializeCompressType::NONE:
 		write_len = 0;
@@ -382,10 +531,25 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const Path &filename, const s
 	case SerializeCompressType::ZSTD:
 		write_len = ZSTD_compressBound(sz);
 		break;
+	case SerializeCompressType::ZSTD_CHUNKED:
+		write_len = 0;
+		break;
 	}
 	u8 *compressed_buffer = write_len == 0 ? nullptr : (u8 *)malloc(write_len);
 	u8 *write_buffer = buffer;
-	if (!compressed_buffer) {
+	if (usedType == SerializeCompressType::ZSTD_CHUNKED) {
+		if (CompressZstdChunks(buffer, sz, chunks)) {
+			// Free the raw state before writing, no need to hold both.
+			free(buffer);
+			write_buffer = nullptr;
+			write_len = ZstdChunksSize(chunks);
+		} else {
+			ERROR_LOG(SAVESTATE, "ChunkReader: Compression failed");
+			chunks.clear();
+			write_len = sz;
+			usedType = SerializeCompressType::NONE;
+		}
+	} else if (!compressed_buffer) {
 		if (write_len != 0)
 			ERROR_LOG(SAVESTATE, "ChunkReader: Unable to allocate compressed buffer");
 		// We'll save uncompressed.  Better than not saving...
@@ -416,6 +580,9 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const Path &filename, const s
 				ZSTD_freeCCtx(ctx);
 			}
 			break;
+		case SerializeCompressType::ZSTD_CHUNKED:
+			_assert_(false);
+			break;
 		}
 
 		if (success) {
@@ -455,7 +622,12 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const Path &filename, const s
 		return ERROR_BAD_FILE;
 	}
 
-	if (!pFile.WriteBytes(write_buffer, write_len)) {
+	bool written;
+	if (usedType == SerializeCompressType::ZSTD_CHUNKED)
+		written = WriteZstdChunks(pFile, chunks);
+	else
+		written = pFile.WriteBytes(write_buffer, write_len);
+	if (!written) {
 		ERROR_LOG(SAVESTATE, "ChunkReader: Failed writing compressed data");
 		free(write_buffer);
 		return ERROR_BAD_FILE;
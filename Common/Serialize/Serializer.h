@@ -52,8 +52,7 @@ class PointerWrap;
 class PointerWrapSection
 {
 public:
-	PointerWrapSection(PointerWrap &p, int ver, const char *title) : p_(p), ver_(ver), title_(title) {
-	}
+	PointerWrapSection(PointerWrap &p, int ver, const char *title);
 	~PointerWrapSection();
 	
 	bool operator == (const int &v) const { return ver_ == v; }
@@ -71,6 +70,10 @@ class PointerWrapSection
 	PointerWrap &p_;
 	int ver_;
 	const char *title_;
+	// Index into the PointerWrap's sectionStats, if it's collecting them.
+	int statsIndex_ = -1;
+	size_t start_ = 0;
+	double startTime_ = 0.0;
 };
 
 // Wrapper class
@@ -90,9 +93,19 @@ class PointerWrap
 		ERROR_FAILURE = 2,
 	};
 
+	struct SectionStats {
+		std::string title;
+		// Sections inside other sections have a higher depth.  Their size and time are included in the outer one.
+		int depth;
+		size_t size;
+		double seconds;
+	};
+
 	u8 **ptr;
 	Mode mode;
 	Error error = ERROR_NONE;
+	// If set, each section appends its size and time here, in the order they start.
+	std::vector<SectionStats> *sectionStats = nullptr;
 
 	PointerWrap(u8 **ptr_, Mode mode_) : ptr(ptr_), mode(mode_) {}
 	PointerWrap(unsigned char **ptr_, int mode_) : ptr((u8**)ptr_), mode((Mode)mode_) {}
@@ -120,7 +133,10 @@ class PointerWrap
 	void DoMarker(const char *prevName, u32 arbitraryNumber = 0x42);
 
 private:
+	friend class PointerWrapSection;
+
 	const char *firstBadSectionTitle_ = nullptr;
+	int sectionDepth_ = 0;
 };
 
 class CChunkFileReader
@@ -236,6 +252,16 @@ class CChunkFileReader
 
 	static Error GetFileTitle(const Path &filename, std::string *title);
 
+	// Compresses and writes a buffer from SavePtr.  Takes ownership of buffer (allocated with malloc.)
+	// Doesn't touch any emulator state, so this can run on another thread.
+	static Error SaveFile(const Path &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz);
+	// Reads and decompresses a state file, for LoadPtr. The caller owns buffer (allocated with new[].)
+	static Error LoadFile(const Path &filename, std::string *gitVersion, u8 *&buffer, size_t &sz, std::string *failureReason);
+
+	// Compression as used for state files, without the file.  For benchmarks.
+	static bool CompressBuffer(const u8 *src, size_t sz, std::vector<u8> &compressed);
+	static bool DecompressBuffer(const std::vector<u8> &compressed, u8 *dest, size_t destLen);
+
 private:
 	struct SChunkHeader
 	{
@@ -252,7 +278,5 @@ class CChunkFileReader
 		REVISION_CURRENT = REVISION_TITLE,
 	};
 
-	static Error LoadFile(const Path &filename, std::string *gitVersion, u8 *&buffer, size_t &sz, std::string *failureReason);
-	static Error SaveFile(const Path &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz);
 	static Error LoadFileHeader(File::IOFile &pFile, SChunkHeader &header, std::string *title);
 };
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 
 #include "Common/Thread/ParallelLoop.h"
@@ -83,11 +84,58 @@ WaitableCounter *ParallelRangeLoopWaitable(ThreadManager *threadMan, const std::
 	}
 }
 
-void ParallelRangeLoop(ThreadManager *threadMan, const std::function<void(int, int)> &loop, int lower, int upper, int minSize) {
+// Chunks per thread for the blocking loop. More chunks balance uneven work better, at the cost of more atomics.
+static const int CHUNKS_PER_THREAD = 4;
+// Same as MAX_CORES_TO_USE in ThreadManager.
+static const int MAX_LOOP_HELPERS = 16;
+
+struct SharedRange {
+	ParallelRangeFunc func;
+	void *userdata;
+	int upper;
+	int chunkSize;
+	// 64-bit so that claiming past the end can't overflow near 2GB.
+	std::atomic<int64_t> next;
+
+	void RunChunks() {
+		int64_t start;
+		while ((start = next.fetch_add(chunkSize)) < upper) {
+			int end = (int)std::min(start + chunkSize, (int64_t)upper);
+			func(userdata, (int)start, end);
+		}
+	}
+};
+
+// Lives on the stack of ParallelRangeLoopFunc, which waits for all of them to be released.
+class LoopHelperTask : public Task {
+public:
+	TaskType Type() const override {
+		return TaskType::CPU_COMPUTE;
+	}
+
+	void Run() override {
+		range_->RunChunks();
+	}
+
+	void Release() override {
+		// Must be the last thing we touch, the caller may return right after.
+		counter_->Count();
+	}
+
+	SharedRange *range_ = nullptr;
+	WaitableCounter *counter_ = nullptr;
+};
+
+void ParallelRangeLoopFunc(ThreadManager *threadMan, ParallelRangeFunc func, void *userdata, int lower, int upper, int minSize) {
 	if (cpu_info.num_cores == 1 || (minSize >= (upper - lower) && upper > lower)) {
 		// "Optimization" for single-core devices, or minSize larger than the range.
 		// No point in adding threading overhead, let's just do it inline (since this is the blocking variant).
-		loop(lower, upper);
+		func(userdata, lower, upper);
+		return;
+	}
+
+	int range = upper - lower;
+	if (range <= 0) {
 		return;
 	}
 
@@ -96,12 +144,31 @@ void ParallelRangeLoop(ThreadManager *threadMan, const std::function<void(int, i
 		minSize = 1;
 	}
 
-	WaitableCounter *counter = ParallelRangeLoopWaitable(threadMan, loop, lower, upper, minSize);
-	// TODO: Optimize using minSize. We'll just compute whether there's a remainer, remove it from the call to ParallelRangeLoopWaitable,
-	// and process the remainder right here. If there's no remainer, we'll steal a whole chunk.
-	if (counter) {
-		counter->WaitAndRelease();
+	int numThreads = std::min(threadMan->GetNumLooperThreads(), MAX_LOOP_HELPERS);
+	// The calling thread takes chunks too, so it counts as one more thread.
+	int64_t wantedChunks = (int64_t)(numThreads + 1) * CHUNKS_PER_THREAD;
+	int chunkSize = std::max((int)((range + wantedChunks - 1) / wantedChunks), minSize);
+	int numChunks = (range + chunkSize - 1) / chunkSize;
+	int numHelpers = std::min(numThreads, numChunks - 1);
+
+	SharedRange shared;
+	shared.func = func;
+	shared.userdata = userdata;
+	shared.upper = upper;
+	shared.chunkSize = chunkSize;
+	shared.next = lower;
+
+	WaitableCounter counter(numHelpers);
+	LoopHelperTask helpers[MAX_LOOP_HELPERS];
+	for (int i = 0; i < numHelpers; i++) {
+		helpers[i].range_ = &shared;
+		helpers[i].counter_ = &counter;
+		threadMan->EnqueueTaskOnThread(i, &helpers[i]);
 	}
+
+	// Work alongside the helpers instead of just waiting. Whoever starts late finds less (or nothing) left.
+	shared.RunChunks();
+	counter.Wait();
 }
 
 // NOTE: Supports a max of 2GB.
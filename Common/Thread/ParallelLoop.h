@@ -38,8 +38,21 @@ struct WaitableCounter : public Waitable {
 // Note that upper bounds are non-inclusive: range is [lower, upper)
 WaitableCounter *ParallelRangeLoopWaitable(ThreadManager *threadMan, const std::function<void(int, int)> &loop, int lower, int upper, int minSize);
 
+typedef void (*ParallelRangeFunc)(void *userdata, int lower, int upper);
+
+// Blocking loop without any allocation: workers and the calling thread claim chunks from a shared counter
+// until the range is exhausted, so uneven work balances itself. Prefer ParallelRangeLoop below.
+// Note that upper bounds are non-inclusive: range is [lower, upper)
+void ParallelRangeLoopFunc(ThreadManager *threadMan, ParallelRangeFunc func, void *userdata, int lower, int upper, int minSize);
+
 // Note that upper bounds are non-inclusive: range is [lower, upper)
-void ParallelRangeLoop(ThreadManager *threadMan, const std::function<void(int, int)> &loop, int lower, int upper, int minSize);
+// Takes any callable (lambda, std::bind, std::function) by reference, so there's no std::function to construct.
+template <typename F>
+inline void ParallelRangeLoop(ThreadManager *threadMan, const F &loop, int lower, int upper, int minSize) {
+	ParallelRangeLoopFunc(threadMan, [](void *userdata, int l, int h) {
+		(*(const F *)userdata)(l, h);
+	}, (void *)&loop, lower, upper, minSize);
+}
 
 // Common utilities for large (!) memory copies.
 // Will only fall back to threads if it seems to make sense.
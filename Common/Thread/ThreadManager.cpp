@@ -8,6 +8,7 @@
 #include <atomic>
 
 #include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Thread/ThreadManager.h"
 
@@ -17,6 +18,8 @@
 //   plus a fixed number more for I/O-limited background tasks.
 // * Parallel compute-limited loops should use as many threads as there are cores.
 //   They should always be scheduled to the first N threads.
+// * Background compute tasks share the extra threads with I/O, but are only picked up
+//   when there's no I/O work waiting.
 // * For some tasks, splitting the input values up linearly between the threads
 //   is not fair. However, we ignore that for now.
 
@@ -29,6 +32,8 @@ struct GlobalThreadContext {
 	std::atomic<int> compute_queue_size;
 	std::deque<Task *> io_queue;
 	std::atomic<int> io_queue_size;
+	std::deque<Task *> background_queue;
+	std::atomic<int> background_queue_size;
 	std::vector<ThreadContext *> threads_;
 
 	std::atomic<int> roundRobin;
@@ -49,6 +54,7 @@ struct ThreadContext {
 ThreadManager::ThreadManager() : global_(new GlobalThreadContext()) {
 	global_->compute_queue_size = 0;
 	global_->io_queue_size = 0;
+	global_->background_queue_size = 0;
 	global_->roundRobin = 0;
 }
 
@@ -64,7 +70,7 @@ void ThreadManager::Teardown() {
 	}
 
 	// Purge any cancellable tasks while the threads shut down.
-	if (global_->compute_queue_size > 0 || global_->io_queue_size > 0) {
+	if (global_->compute_queue_size > 0 || global_->io_queue_size > 0 || global_->background_queue_size > 0) {
 		auto drainQueue = [&](std::deque<Task *> &queue, std::atomic<int> &size) {
 			for (auto it = queue.begin(); it != queue.end(); ++it) {
 				if (TeardownTask(*it, false)) {
@@ -81,6 +87,8 @@ void ThreadManager::Teardown() {
 			continue;
 		while (!drainQueue(global_->io_queue, global_->io_queue_size))
 			continue;
+		while (!drainQueue(global_->background_queue, global_->background_queue_size))
+			continue;
 	}
 
 	for (ThreadContext *&threadCtx : global_->threads_) {
@@ -94,7 +102,7 @@ void ThreadManager::Teardown() {
 	}
 	global_->threads_.clear();
 
-	if (global_->compute_queue_size > 0 || global_->io_queue_size > 0) {
+	if (global_->compute_queue_size > 0 || global_->io_queue_size > 0 || global_->background_queue_size > 0) {
 		WARN_LOG(SYSTEM, "ThreadManager::Teardown() with tasks still enqueued");
 	}
 }
@@ -113,9 +121,12 @@ bool ThreadManager::TeardownTask(Task *task, bool enqueue) {
 		if (task->Type() == TaskType::CPU_COMPUTE) {
 			global_->compute_queue.push_back(task);
 			global_->compute_queue_size++;
-		} else if (task->Type() == TaskType::CPU_COMPUTE) {
+		} else if (task->Type() == TaskType::IO_BLOCKING) {
 			global_->io_queue.push_back(task);
 			global_->io_queue_size++;
+		} else if (task->Type() == TaskType::CPU_BACKGROUND) {
+			global_->background_queue.push_back(task);
+			global_->background_queue_size++;
 		} else {
 			_assert_(false);
 		}
@@ -127,10 +138,13 @@ static void WorkerThreadFunc(GlobalThreadContext *global, ThreadContext *thread)
 	char threadName[16];
 	snprintf(threadName, sizeof(threadName), "PoolWorker %d", thread->index);
 	SetCurrentThreadName(threadName);
+	SetCurrentThreadRole(thread->type == TaskType::CPU_COMPUTE ? ThreadRole::WORKER : ThreadRole::BACKGROUND);
 
 	const bool isCompute = thread->type == TaskType::CPU_COMPUTE;
 	const auto global_queue_size = [isCompute, &global]() -> int {
-		return isCompute ? global->compute_queue_size.load() : global->io_queue_size.load();
+		if (isCompute)
+			return global->compute_queue_size.load();
+		return global->io_queue_size.load() + global->background_queue_size.load();
 	};
 
 	while (!thread->cancelled) {
@@ -140,8 +154,10 @@ static void WorkerThreadFunc(GlobalThreadContext *global, ThreadContext *thread)
 		if (!task && global_queue_size() > 0) {
 			// Grab one from the global queue if there is any.
 			std::unique_lock<std::mutex> lock(global->mutex);
-			auto &queue = isCompute ? global->compute_queue : global->io_queue;
-			auto &queue_size = isCompute ? global->compute_queue_size : global->io_queue_size;
+			// Background work only gets a turn when there's no I/O waiting.
+			const bool useBackground = !isCompute && global->io_queue.empty();
+			auto &queue = isCompute ? global->compute_queue : (useBackground ? global->background_queue : global->io_queue);
+			auto &queue_size = isCompute ? global->compute_queue_size : (useBackground ? global->background_queue_size : global->io_queue_size);
 
 			if (!queue.empty()) {
 				task = queue.front();
@@ -173,7 +189,10 @@ static void WorkerThreadFunc(GlobalThreadContext *global, ThreadContext *thread)
 		// The task itself takes care of notifying anyone waiting on it. Not the
 		// responsibility of the ThreadManager (although it could be!).
 		if (task) {
-			task->Run();
+			{
+				PROFILE_THIS_SCOPE("task");
+				task->Run();
+			}
 			task->Release();
 
 			// Reduce the queue size once complete.
@@ -216,6 +235,8 @@ void ThreadManager::EnqueueTask(Task *task) {
 		maxThread = numComputeThreads_;
 	} else {
 		// Only IO blocking threads (to avoid starving compute threads.)
+		// Background tasks also go here, so they never sit in front of work queued directly
+		// on a compute thread (like the software renderer's bins.)
 		minThread = numComputeThreads_;
 		maxThread = numThreads_;
 	}
@@ -244,6 +265,9 @@ void ThreadManager::EnqueueTask(Task *task) {
 		} else if (task->Type() == TaskType::IO_BLOCKING) {
 			global_->io_queue.push_back(task);
 			global_->io_queue_size++;
+		} else if (task->Type() == TaskType::CPU_BACKGROUND) {
+			global_->background_queue.push_back(task);
+			global_->background_queue_size++;
 		} else {
 			_assert_(false);
 		}
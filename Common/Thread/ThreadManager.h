@@ -8,6 +8,10 @@
 enum class TaskType {
 	CPU_COMPUTE,
 	IO_BLOCKING,
+	// Compute work nobody is waiting on this frame (precompiles, saving, etc.)
+	// Runs on the extra threads, after any IO_BLOCKING work, so it never delays
+	// tasks queued directly on the compute threads.
+	CPU_BACKGROUND,
 };
 
 // Implement this to make something that you can run on the thread manager.
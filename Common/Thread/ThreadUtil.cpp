@@ -16,10 +16,14 @@
 
 #endif
 
+#include <algorithm>
 #include <cstring>
 #include <cstdint>
+#include <cstdio>
+#include <vector>
 
 #include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Data/Encoding/Utf8.h"
 
@@ -34,6 +38,15 @@
 #include <sys/syscall.h>
 #endif
 
+#if PPSSPP_PLATFORM(ANDROID) || PPSSPP_PLATFORM(LINUX)
+#include <sched.h>
+#define THREAD_AFFINITY_SUPPORTED
+#endif
+
+#if PPSSPP_PLATFORM(ANDROID)
+#include <dlfcn.h>
+#endif
+
 #if defined(__DragonFly__) || defined(__FreeBSD__) || defined(__OpenBSD__)
 #include <pthread_np.h>
 #elif defined(__NetBSD__)
@@ -120,6 +133,9 @@ void SetCurrentThreadName(const char* threadName) {
 #ifdef TLS_SUPPORTED
 	curThreadName = threadName;
 #endif
+#ifdef USE_PROFILER
+	Profiler_SetThreadName(threadName);
+#endif
 }
 
 #if PPSSPP_PLATFORM(WINDOWS)
@@ -190,6 +206,208 @@ void AssertCurrentThreadName(const char *threadName) {
 #endif
 }
 
+#ifdef THREAD_AFFINITY_SUPPORTED
+
+struct CoreClusters {
+	bool heterogeneous = false;
+	cpu_set_t big;
+	cpu_set_t little;
+};
+
+static int ReadMaxFreq(int cpu) {
+	char path[128];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+	FILE *f = fopen(path, "r");
+	if (!f)
+		return 0;
+	int freq = 0;
+	if (fscanf(f, "%d", &freq) != 1)
+		freq = 0;
+	fclose(f);
+	return freq;
+}
+
+// Groups cores by max frequency. The fastest cluster is "big", unless it's a single prime core,
+// in which case the next cluster joins it - two latency critical threads shouldn't share one core.
+static CoreClusters DetectCoreClusters() {
+	CoreClusters clusters;
+	CPU_ZERO(&clusters.big);
+	CPU_ZERO(&clusters.little);
+
+	int numCpus = (int)sysconf(_SC_NPROCESSORS_CONF);
+	if (numCpus <= 1 || numCpus > CPU_SETSIZE)
+		return clusters;
+
+	std::vector<int> freqs(numCpus);
+	int fastest = 0;
+	for (int i = 0; i < numCpus; i++) {
+		freqs[i] = ReadMaxFreq(i);
+		if (freqs[i] == 0) {
+			// Offline or no cpufreq, we can't tell what it is.
+			return clusters;
+		}
+		fastest = std::max(fastest, freqs[i]);
+	}
+
+	int bigCount = 0;
+	int nextFastest = 0;
+	for (int i = 0; i < numCpus; i++) {
+		if (freqs[i] == fastest)
+			bigCount++;
+		else
+			nextFastest = std::max(nextFastest, freqs[i]);
+	}
+	if (nextFastest == 0) {
+		// All the same.
+		return clusters;
+	}
+
+	int bigThreshold = bigCount == 1 ? nextFastest : fastest;
+	int littleCount = 0;
+	for (int i = 0; i < numCpus; i++) {
+		if (freqs[i] >= bigThreshold) {
+			CPU_SET(i, &clusters.big);
+		} else {
+			CPU_SET(i, &clusters.little);
+			littleCount++;
+		}
+	}
+
+	// If everything ended up big (a prime core plus one cluster), there's nothing to separate.
+	clusters.heterogeneous = littleCount != 0;
+	if (clusters.heterogeneous) {
+		INFO_LOG(SYSTEM, "Heterogeneous CPU: %d big cores, %d little cores", numCpus - littleCount, littleCount);
+	}
+	return clusters;
+}
+
+static const CoreClusters &GetCoreClusters() {
+	static const CoreClusters clusters = DetectCoreClusters();
+	return clusters;
+}
+
+#endif
+
+#if PPSSPP_PLATFORM(ANDROID)
+
+// From android/performance_hint.h, which we can't use directly with our NDK target.
+typedef struct APerformanceHintManager APerformanceHintManager;
+typedef struct APerformanceHintSession APerformanceHintSession;
+
+static struct {
+	bool loaded = false;
+	APerformanceHintManager *(*getManager)();
+	APerformanceHintSession *(*createSession)(APerformanceHintManager *manager, const int32_t *threadIds, size_t size, int64_t initialTargetWorkDurationNanos);
+	int (*reportActualWorkDuration)(APerformanceHintSession *session, int64_t actualDurationNanos);
+	void (*closeSession)(APerformanceHintSession *session);
+} g_perfHint;
+
+static std::mutex g_perfHintLock;
+static APerformanceHintSession *g_perfHintSession;
+// The latest EMU and RENDER threads, these get restarted with the graphics backend.
+static int32_t g_perfHintThreads[2];
+static bool g_perfHintThreadsChanged;
+
+static bool LoadPerformanceHint() {
+	if (g_perfHint.loaded)
+		return g_perfHint.createSession != nullptr;
+	g_perfHint.loaded = true;
+
+	void *handle = dlopen("libandroid.so", RTLD_LAZY | RTLD_LOCAL);
+	if (!handle)
+		return false;
+	g_perfHint.getManager = (decltype(g_perfHint.getManager))dlsym(handle, "APerformanceHint_getManager");
+	g_perfHint.createSession = (decltype(g_perfHint.createSession))dlsym(handle, "APerformanceHint_createSession");
+	g_perfHint.reportActualWorkDuration = (decltype(g_perfHint.reportActualWorkDuration))dlsym(handle, "APerformanceHint_reportActualWorkDuration");
+	g_perfHint.closeSession = (decltype(g_perfHint.closeSession))dlsym(handle, "APerformanceHint_closeSession");
+	if (!g_perfHint.getManager || !g_perfHint.reportActualWorkDuration || !g_perfHint.closeSession) {
+		g_perfHint.createSession = nullptr;
+	}
+	return g_perfHint.createSession != nullptr;
+}
+
+static void SetPerformanceHintThread(ThreadRole role, int32_t tid) {
+	std::lock_guard<std::mutex> guard(g_perfHintLock);
+	int32_t &slot = g_perfHintThreads[role == ThreadRole::EMU ? 0 : 1];
+	if (slot != tid) {
+		slot = tid;
+		g_perfHintThreadsChanged = true;
+	}
+}
+
+#endif
+
+void SetCurrentThreadRole(ThreadRole role) {
+#ifdef THREAD_AFFINITY_SUPPORTED
+	const CoreClusters &clusters = GetCoreClusters();
+	if (!clusters.heterogeneous)
+		return;
+
+	const cpu_set_t *set = nullptr;
+	switch (role) {
+	case ThreadRole::EMU:
+	case ThreadRole::RENDER:
+		set = &clusters.big;
+		break;
+	case ThreadRole::BACKGROUND:
+		set = &clusters.little;
+		break;
+	case ThreadRole::WORKER:
+		// Parallel loops are waited on by the emu thread, keeping them off the big cores would just stall it.
+		break;
+	}
+
+	if (set && sched_setaffinity(0, sizeof(cpu_set_t), set) != 0) {
+		WARN_LOG(SYSTEM, "Failed to set thread affinity for role %d", (int)role);
+	}
+#endif
+
+#if PPSSPP_PLATFORM(ANDROID)
+	if (role == ThreadRole::EMU || role == ThreadRole::RENDER) {
+		SetPerformanceHintThread(role, (int32_t)GetCurrentThreadIdForDebug());
+	}
+#endif
+}
+
+void ReportFrameWorkDuration(double seconds) {
+#if PPSSPP_PLATFORM(ANDROID)
+	std::lock_guard<std::mutex> guard(g_perfHintLock);
+	if (!g_perfHintThreadsChanged && !g_perfHintSession)
+		return;
+	if (!LoadPerformanceHint())
+		return;
+
+	if (g_perfHintThreadsChanged) {
+		// Threads can't be changed on an existing session before API 34, so just start over.
+		if (g_perfHintSession)
+			g_perfHint.closeSession(g_perfHintSession);
+		g_perfHintSession = nullptr;
+		g_perfHintThreadsChanged = false;
+
+		int32_t tids[2];
+		size_t count = 0;
+		for (int32_t tid : g_perfHintThreads) {
+			if (tid != 0)
+				tids[count++] = tid;
+		}
+
+		APerformanceHintManager *manager = g_perfHint.getManager();
+		if (manager && count != 0) {
+			// We aim for 60 fps.
+			const int64_t targetNanos = 16666666;
+			g_perfHintSession = g_perfHint.createSession(manager, tids, count, targetNanos);
+		}
+		if (!g_perfHintSession) {
+			WARN_LOG(SYSTEM, "Failed to create performance hint session");
+		}
+	}
+
+	if (g_perfHintSession && seconds > 0.0) {
+		g_perfHint.reportActualWorkDuration(g_perfHintSession, (int64_t)(seconds * 1000000000.0));
+	}
+#endif
+}
+
 int GetCurrentThreadIdForDebug() {
 #if __LIBRETRO__
 	// Not sure why gettid() would not be available, but it isn't.
@@ -7,6 +7,25 @@
 void SetCurrentThreadName(const char *threadName);
 void AssertCurrentThreadName(const char *threadName);
 
+// What a thread is used for, so it can be placed on suitable cores.
+enum class ThreadRole {
+	// Latency critical: these decide the frame time.
+	EMU,
+	RENDER,
+	// Runs parallel loops for the above, so should be able to use any core.
+	WORKER,
+	// IO and work nobody is waiting on this frame.
+	BACKGROUND,
+};
+
+// On CPUs with both fast and slow cores (big.LITTLE), restricts the current thread to the cores
+// that suit its role. Does nothing if all cores are the same, or the platform lacks affinity support.
+void SetCurrentThreadRole(ThreadRole role);
+
+// Reports how long the work for the last frame took, so the OS can adjust clocks for the EMU and
+// RENDER threads (Android performance hints, API 33+). Does nothing elsewhere.
+void ReportFrameWorkDuration(double seconds);
+
 // Just gets a cheap thread identifier so that you can see different threads in debug output,
 // exactly what it is is badly specified and not useful for anything.
 int GetCurrentThreadIdForDebug();
@@ -401,6 +401,9 @@ class View {
 	virtual void Measure(const UIContext &dc, MeasureSpec horiz, MeasureSpec vert);
 	virtual void Layout() {}
 	virtual void Draw(UIContext &dc) {}
+	// Called by scroll views on views near the visible area, including the visible ones, so that
+	// expensive content can start loading before it scrolls into sight. area is in layout coordinates.
+	virtual void Prefetch(const Bounds &area) {}
 
 	virtual float GetMeasuredWidth() const { return measuredWidth_; }
 	virtual float GetMeasuredHeight() const { return measuredHeight_; }
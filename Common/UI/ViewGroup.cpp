@@ -166,6 +166,13 @@ void ViewGroup::Draw(UIContext &dc) {
 	}
 }
 
+void ViewGroup::Prefetch(const Bounds &area) {
+	for (View *view : views_) {
+		if (view->GetVisibility() == V_VISIBLE && area.Intersects(view->GetBounds()))
+			view->Prefetch(area);
+	}
+}
+
 std::string ViewGroup::DescribeText() const {
 	std::stringstream ss;
 	bool needNewline = false;
@@ -892,6 +899,10 @@ void ScrollView::Draw(UIContext &dc) {
 	views_[0]->Draw(dc);
 	dc.PopScissor();
 
+	// Let content about a page away in either direction start loading, so it's ready when it scrolls in.
+	Bounds prefetchArea = orientation_ == ORIENT_HORIZONTAL ? bounds_.Expand(bounds_.w, 0.0f) : bounds_.Expand(0.0f, bounds_.h);
+	views_[0]->Prefetch(prefetchArea);
+
 	float childHeight = views_[0]->GetBounds().h;
 	float scrollMax = std::max(0.0f, childHeight - bounds_.h);
 
@@ -41,6 +41,7 @@ class ViewGroup : public View {
 	virtual void DeviceRestored(Draw::DrawContext *draw) override;
 
 	virtual void Draw(UIContext &dc) override;
+	virtual void Prefetch(const Bounds &area) override;
 
 	// These should be unused.
 	virtual float GetContentWidth() const { return 0.0f; }
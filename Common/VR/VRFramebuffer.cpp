@@ -11,6 +11,9 @@
 #include <assert.h>
 #include <GLES3/gl3.h>
 #include <GLES3/gl3ext.h>
+#include <GLES2/gl2ext.h>
+
+static PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC glFramebufferTextureMultiviewOVR = nullptr;
 
 /*
 ================================================================================
@@ -32,13 +35,24 @@ void ovrFramebuffer_Clear(ovrFramebuffer* frameBuffer) {
 	frameBuffer->ColorSwapChainImage = NULL;
 	frameBuffer->DepthBuffers = NULL;
 	frameBuffer->FrameBuffers = NULL;
+	frameBuffer->MultiviewFrameBuffers = NULL;
+}
+
+static bool CheckFramebufferComplete() {
+	GL(GLenum renderFramebufferStatus = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER));
+	if (renderFramebufferStatus != GL_FRAMEBUFFER_COMPLETE) {
+		ALOGE("Incomplete frame buffer object: %d", renderFramebufferStatus);
+		return false;
+	}
+	return true;
 }
 
 bool ovrFramebuffer_Create(
 		XrSession session,
 		ovrFramebuffer* frameBuffer,
 		const int width,
-		const int height) {
+		const int height,
+		bool multiview) {
 
 	frameBuffer->Width = width;
 	frameBuffer->Height = height;
@@ -52,7 +66,7 @@ bool ovrFramebuffer_Create(
 	swapChainCreateInfo.width = width;
 	swapChainCreateInfo.height = height;
 	swapChainCreateInfo.faceCount = 1;
-	swapChainCreateInfo.arraySize = 1;
+	swapChainCreateInfo.arraySize = ovrMaxNumEyes;
 	swapChainCreateInfo.mipCount = 1;
 
 	frameBuffer->ColorSwapChain.Width = swapChainCreateInfo.width;
@@ -78,15 +92,24 @@ bool ovrFramebuffer_Create(
 			&frameBuffer->TextureSwapChainLength,
 			(XrSwapchainImageBaseHeader*)frameBuffer->ColorSwapChainImage));
 
+	if (multiview && !glFramebufferTextureMultiviewOVR) {
+		glFramebufferTextureMultiviewOVR = (PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC)eglGetProcAddress("glFramebufferTextureMultiviewOVR");
+	}
+	multiview = multiview && glFramebufferTextureMultiviewOVR != nullptr;
+
 	frameBuffer->DepthBuffers =
 			(GLuint*)malloc(frameBuffer->TextureSwapChainLength * sizeof(GLuint));
 	frameBuffer->FrameBuffers =
-			(GLuint*)malloc(frameBuffer->TextureSwapChainLength * sizeof(GLuint));
+			(GLuint*)malloc(frameBuffer->TextureSwapChainLength * ovrMaxNumEyes * sizeof(GLuint));
+	if (multiview) {
+		frameBuffer->MultiviewFrameBuffers =
+				(GLuint*)malloc(frameBuffer->TextureSwapChainLength * sizeof(GLuint));
+	}
 
 	for (uint32_t i = 0; i < frameBuffer->TextureSwapChainLength; i++) {
 		// Create the color buffer texture.
 		const GLuint colorTexture = frameBuffer->ColorSwapChainImage[i].image;
-		GLenum colorTextureTarget = GL_TEXTURE_2D;
+		GLenum colorTextureTarget = GL_TEXTURE_2D_ARRAY;
 		GL(glBindTexture(colorTextureTarget, colorTexture));
 		GL(glTexParameteri(colorTextureTarget, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
 		GL(glTexParameteri(colorTextureTarget, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
@@ -94,24 +117,41 @@ bool ovrFramebuffer_Create(
 		GL(glTexParameteri(colorTextureTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
 		GL(glBindTexture(colorTextureTarget, 0));
 
-		// Create depth buffer.
-		GL(glGenRenderbuffers(1, &frameBuffer->DepthBuffers[i]));
-		GL(glBindRenderbuffer(GL_RENDERBUFFER, frameBuffer->DepthBuffers[i]));
-		GL(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height));
-		GL(glBindRenderbuffer(GL_RENDERBUFFER, 0));
-
-		// Create the frame buffer.
-		GL(glGenFramebuffers(1, &frameBuffer->FrameBuffers[i]));
-		GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, frameBuffer->FrameBuffers[i]));
-		GL(glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, frameBuffer->DepthBuffers[i]));
-		GL(glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, frameBuffer->DepthBuffers[i]));
-		GL(glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0));
-		GL(GLenum renderFramebufferStatus = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER));
-		GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
-		if (renderFramebufferStatus != GL_FRAMEBUFFER_COMPLETE) {
-			ALOGE(
-					"Incomplete frame buffer object: %d", renderFramebufferStatus);
-			return false;
+		// Create depth buffer. A texture array too, since multiview can't attach renderbuffers.
+		GL(glGenTextures(1, &frameBuffer->DepthBuffers[i]));
+		GL(glBindTexture(GL_TEXTURE_2D_ARRAY, frameBuffer->DepthBuffers[i]));
+		GL(glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH24_STENCIL8, width, height, ovrMaxNumEyes));
+		GL(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+
+		// Create the frame buffers, one per eye.
+		for (int eye = 0; eye < ovrMaxNumEyes; eye++) {
+			GLuint *fbo = &frameBuffer->FrameBuffers[i * ovrMaxNumEyes + eye];
+			GL(glGenFramebuffers(1, fbo));
+			GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, *fbo));
+			GL(glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, frameBuffer->DepthBuffers[i], 0, eye));
+			GL(glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0, eye));
+			bool complete = CheckFramebufferComplete();
+			GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+			if (!complete) {
+				return false;
+			}
+		}
+
+		if (multiview) {
+			GLuint *fbo = &frameBuffer->MultiviewFrameBuffers[i];
+			GL(glGenFramebuffers(1, fbo));
+			GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, *fbo));
+			GL(glFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, frameBuffer->DepthBuffers[i], 0, 0, ovrMaxNumEyes));
+			GL(glFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0, 0, ovrMaxNumEyes));
+			bool complete = CheckFramebufferComplete();
+			GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+			if (!complete) {
+				// Not fatal, we can still render each eye on its own.
+				GL(glDeleteFramebuffers(i + 1, frameBuffer->MultiviewFrameBuffers));
+				free(frameBuffer->MultiviewFrameBuffers);
+				frameBuffer->MultiviewFrameBuffers = NULL;
+				multiview = false;
+			}
 		}
 	}
 
@@ -119,20 +159,29 @@ bool ovrFramebuffer_Create(
 }
 
 void ovrFramebuffer_Destroy(ovrFramebuffer* frameBuffer) {
-	GL(glDeleteFramebuffers(frameBuffer->TextureSwapChainLength, frameBuffer->FrameBuffers));
-	GL(glDeleteRenderbuffers(frameBuffer->TextureSwapChainLength, frameBuffer->DepthBuffers));
+	GL(glDeleteFramebuffers(frameBuffer->TextureSwapChainLength * ovrMaxNumEyes, frameBuffer->FrameBuffers));
+	if (frameBuffer->MultiviewFrameBuffers) {
+		GL(glDeleteFramebuffers(frameBuffer->TextureSwapChainLength, frameBuffer->MultiviewFrameBuffers));
+	}
+	GL(glDeleteTextures(frameBuffer->TextureSwapChainLength, frameBuffer->DepthBuffers));
 	OXR(xrDestroySwapchain(frameBuffer->ColorSwapChain.Handle));
 	free(frameBuffer->ColorSwapChainImage);
 
 	free(frameBuffer->DepthBuffers);
 	free(frameBuffer->FrameBuffers);
+	free(frameBuffer->MultiviewFrameBuffers);
 
 	ovrFramebuffer_Clear(frameBuffer);
 }
 
-void ovrFramebuffer_SetCurrent(ovrFramebuffer* frameBuffer) {
+void ovrFramebuffer_SetCurrent(ovrFramebuffer* frameBuffer, int eye) {
 	GL(glBindFramebuffer(
-			GL_DRAW_FRAMEBUFFER, frameBuffer->FrameBuffers[frameBuffer->TextureSwapChainIndex]));
+			GL_DRAW_FRAMEBUFFER, frameBuffer->FrameBuffers[frameBuffer->TextureSwapChainIndex * ovrMaxNumEyes + eye]));
+}
+
+void ovrFramebuffer_SetCurrentMultiview(ovrFramebuffer* frameBuffer) {
+	GL(glBindFramebuffer(
+			GL_DRAW_FRAMEBUFFER, frameBuffer->MultiviewFrameBuffers[frameBuffer->TextureSwapChainIndex]));
 }
 
 void ovrFramebuffer_SetNone() {
@@ -181,30 +230,26 @@ ovrRenderer
 */
 
 void ovrRenderer_Clear(ovrRenderer* renderer) {
-	for (int eye = 0; eye < ovrMaxNumEyes; eye++) {
-		ovrFramebuffer_Clear(&renderer->FrameBuffer[eye]);
-	}
+	ovrFramebuffer_Clear(&renderer->FrameBuffer);
 }
 
 void ovrRenderer_Create(
 		XrSession session,
 		ovrRenderer* renderer,
 		int suggestedEyeTextureWidth,
-		int suggestedEyeTextureHeight) {
-	// Create the frame buffers.
-	for (int eye = 0; eye < ovrMaxNumEyes; eye++) {
-		ovrFramebuffer_Create(
-				session,
-				&renderer->FrameBuffer[eye],
-				suggestedEyeTextureWidth,
-				suggestedEyeTextureHeight);
-	}
+		int suggestedEyeTextureHeight,
+		bool multiview) {
+	// Create the frame buffer, holding both eyes.
+	ovrFramebuffer_Create(
+			session,
+			&renderer->FrameBuffer,
+			suggestedEyeTextureWidth,
+			suggestedEyeTextureHeight,
+			multiview);
 }
 
 void ovrRenderer_Destroy(ovrRenderer* renderer) {
-	for (int eye = 0; eye < ovrMaxNumEyes; eye++) {
-		ovrFramebuffer_Destroy(&renderer->FrameBuffer[eye]);
-	}
+	ovrFramebuffer_Destroy(&renderer->FrameBuffer);
 }
 
 /*
@@ -40,6 +40,7 @@ typedef struct {
 	uint32_t Height;
 } ovrSwapChain;
 
+// Both eyes live in one swapchain, as the two layers of a texture array.
 typedef struct {
 	int Width;
 	int Height;
@@ -47,12 +48,16 @@ typedef struct {
 	uint32_t TextureSwapChainIndex;
 	ovrSwapChain ColorSwapChain;
 	XrSwapchainImageOpenGLESKHR* ColorSwapChainImage;
+	// Depth texture arrays, one per swapchain image.
 	unsigned int* DepthBuffers;
+	// One per swapchain image and eye, indexed [image * ovrMaxNumEyes + eye].
 	unsigned int* FrameBuffers;
+	// With GL_OVR_multiview2, one per swapchain image, rendering to both eyes at once. Otherwise NULL.
+	unsigned int* MultiviewFrameBuffers;
 } ovrFramebuffer;
 
 typedef struct {
-	ovrFramebuffer FrameBuffer[ovrMaxNumEyes];
+	ovrFramebuffer FrameBuffer;
 } ovrRenderer;
 
 typedef struct {
@@ -105,14 +110,16 @@ int ovrApp_HandleXrEvents(ovrApp* app);
 void ovrFramebuffer_Acquire(ovrFramebuffer* frameBuffer);
 void ovrFramebuffer_Resolve(ovrFramebuffer* frameBuffer);
 void ovrFramebuffer_Release(ovrFramebuffer* frameBuffer);
-void ovrFramebuffer_SetCurrent(ovrFramebuffer* frameBuffer);
+void ovrFramebuffer_SetCurrent(ovrFramebuffer* frameBuffer, int eye);
+void ovrFramebuffer_SetCurrentMultiview(ovrFramebuffer* frameBuffer);
 void ovrFramebuffer_SetNone();
 
 void ovrRenderer_Create(
 		XrSession session,
 		ovrRenderer* renderer,
 		int suggestedEyeTextureWidth,
-		int suggestedEyeTextureHeight);
+		int suggestedEyeTextureHeight,
+		bool multiview);
 void ovrRenderer_Destroy(ovrRenderer* renderer);
 
 void ovrTrackedController_Clear(ovrTrackedController* controller);
@@ -207,11 +207,15 @@ void VR_InitRenderer( engine_t* engine ) {
 
 	projections = (XrView*)(malloc(ovrMaxNumEyes * sizeof(XrView)));
 
+	const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+	bool multiview = extensions && strstr(extensions, "GL_OVR_multiview2") != nullptr;
+
 	ovrRenderer_Create(
 			engine->appState.Session,
 			&engine->appState.Renderer,
 			engine->appState.ViewConfigurationView[0].recommendedImageRectWidth,
-			engine->appState.ViewConfigurationView[0].recommendedImageRectHeight);
+			engine->appState.ViewConfigurationView[0].recommendedImageRectHeight,
+			multiview);
 	initialized = GL_TRUE;
 }
 
@@ -307,31 +311,39 @@ void VR_BeginFrame( engine_t* engine ) {
 	engine->appState.LayerCount = 0;
 	memset(engine->appState.Layers, 0, sizeof(ovrCompositorLayer_Union) * ovrMaxLayerCount);
 
-	for (int eye = 0; eye < ovrMaxNumEyes; eye++) {
-		ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer[eye];
-		int swapchainIndex = frameBuffer->TextureSwapChainIndex;
-		int glFramebuffer = frameBuffer->FrameBuffers[swapchainIndex];
-
-		ovrFramebuffer_Acquire(frameBuffer);
-		ovrFramebuffer_SetCurrent(frameBuffer);
+	ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer;
+	ovrFramebuffer_Acquire(frameBuffer);
+	if (frameBuffer->MultiviewFrameBuffers) {
+		// One clear covers both eyes.
+		ovrFramebuffer_SetCurrentMultiview(frameBuffer);
 		VR_ClearFrameBuffer(frameBuffer->ColorSwapChain.Width, frameBuffer->ColorSwapChain.Height);
+	} else {
+		for (int eye = 0; eye < ovrMaxNumEyes; eye++) {
+			ovrFramebuffer_SetCurrent(frameBuffer, eye);
+			VR_ClearFrameBuffer(frameBuffer->ColorSwapChain.Width, frameBuffer->ColorSwapChain.Height);
+		}
 	}
 }
 
 void VR_EndFrame( engine_t* engine ) {
 
-	for (int eye = 0; eye < ovrMaxNumEyes; eye++) {
+	ovrFramebuffer* eyeFrameBuffer = &engine->appState.Renderer.FrameBuffer;
+	int clearPasses = eyeFrameBuffer->MultiviewFrameBuffers ? 1 : ovrMaxNumEyes;
+	for (int eye = 0; eye < clearPasses; eye++) {
+		if (eyeFrameBuffer->MultiviewFrameBuffers) {
+			ovrFramebuffer_SetCurrentMultiview(eyeFrameBuffer);
+		} else {
+			ovrFramebuffer_SetCurrent(eyeFrameBuffer, eye);
+		}
 
 		// Clear the alpha channel, other way OpenXR would not transfer the framebuffer fully
 		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
 		glClearColor(0.0, 0.0, 0.0, 1.0);
 		glClear(GL_COLOR_BUFFER_BIT);
 		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-
-		ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer[eye];
-		//TODO:ovrFramebuffer_Resolve(frameBuffer);
-		ovrFramebuffer_Release(frameBuffer);
 	}
+	//TODO:ovrFramebuffer_Resolve(eyeFrameBuffer);
+	ovrFramebuffer_Release(eyeFrameBuffer);
 	ovrFramebuffer_SetNone();
 
 	XrCompositionLayerProjectionView projection_layer_elements[2] = {};
@@ -339,10 +351,9 @@ void VR_EndFrame( engine_t* engine ) {
 		menuYaw = hmdorientation[YAW];
 
 		for (int eye = 0; eye < ovrMaxNumEyes; eye++) {
-			ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer[eye];
-			if (vrMode == VR_MODE_MONO_6DOF) {
-				frameBuffer = &engine->appState.Renderer.FrameBuffer[0];
-			}
+			ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer;
+			// Both eyes show the left eye's layer in mono mode.
+			int layer = vrMode == VR_MODE_MONO_6DOF ? 0 : eye;
 
 			memset(&projection_layer_elements[eye], 0, sizeof(XrCompositionLayerProjectionView));
 			projection_layer_elements[eye].type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW;
@@ -355,7 +366,7 @@ void VR_EndFrame( engine_t* engine ) {
 			projection_layer_elements[eye].subImage.imageRect.offset.y = 0;
 			projection_layer_elements[eye].subImage.imageRect.extent.width = frameBuffer->ColorSwapChain.Width;
 			projection_layer_elements[eye].subImage.imageRect.extent.height = frameBuffer->ColorSwapChain.Height;
-			projection_layer_elements[eye].subImage.imageArrayIndex = 0;
+			projection_layer_elements[eye].subImage.imageArrayIndex = layer;
 		}
 
 		XrCompositionLayerProjection projection_layer = {};
@@ -370,15 +381,15 @@ void VR_EndFrame( engine_t* engine ) {
 	} else if (vrMode == VR_MODE_FLAT_SCREEN) {
 
 		// Build the cylinder layer
-		int width = engine->appState.Renderer.FrameBuffer[0].ColorSwapChain.Width;
-		int height = engine->appState.Renderer.FrameBuffer[0].ColorSwapChain.Height;
+		int width = engine->appState.Renderer.FrameBuffer.ColorSwapChain.Width;
+		int height = engine->appState.Renderer.FrameBuffer.ColorSwapChain.Height;
 		XrCompositionLayerCylinderKHR cylinder_layer = {};
 		cylinder_layer.type = XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR;
 		cylinder_layer.layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
 		cylinder_layer.space = engine->appState.CurrentSpace;
 		cylinder_layer.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
 		memset(&cylinder_layer.subImage, 0, sizeof(XrSwapchainSubImage));
-		cylinder_layer.subImage.swapchain = engine->appState.Renderer.FrameBuffer[0].ColorSwapChain.Handle;
+		cylinder_layer.subImage.swapchain = engine->appState.Renderer.FrameBuffer.ColorSwapChain.Handle;
 		cylinder_layer.subImage.imageRect.offset.x = 0;
 		cylinder_layer.subImage.imageRect.offset.y = 0;
 		cylinder_layer.subImage.imageRect.extent.width = width;
@@ -415,21 +426,30 @@ void VR_EndFrame( engine_t* engine ) {
 	endFrameInfo.layers = layers;
 
 	OXR(xrEndFrame(engine->appState.Session, &endFrameInfo));
-	for (int eye = 0; eye < ovrMaxNumEyes; eye++) {
-		ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer[eye];
-		frameBuffer->TextureSwapChainIndex++;
-		frameBuffer->TextureSwapChainIndex %= frameBuffer->TextureSwapChainLength;
-	}
+	ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer;
+	frameBuffer->TextureSwapChainIndex++;
+	frameBuffer->TextureSwapChainIndex %= frameBuffer->TextureSwapChainLength;
 }
 
 void VR_BindFramebuffer( engine_t* engine, int eye ) {
 	if (!initialized) return;
-	ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer[eye];
+	ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer;
 	int swapchainIndex = frameBuffer->TextureSwapChainIndex;
-	int glFramebuffer = frameBuffer->FrameBuffers[swapchainIndex];
+	int glFramebuffer = frameBuffer->FrameBuffers[swapchainIndex * ovrMaxNumEyes + eye];
 	glBindFramebuffer(GL_FRAMEBUFFER, glFramebuffer);
 }
 
+bool VR_SupportsMultiview( engine_t* engine ) {
+	return initialized && engine->appState.Renderer.FrameBuffer.MultiviewFrameBuffers != NULL;
+}
+
+void VR_BindMultiviewFramebuffer( engine_t* engine ) {
+	if (!VR_SupportsMultiview(engine)) return;
+	ovrFramebuffer* frameBuffer = &engine->appState.Renderer.FrameBuffer;
+	int swapchainIndex = frameBuffer->TextureSwapChainIndex;
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer->MultiviewFrameBuffers[swapchainIndex]);
+}
+
 ovrMatrix4f VR_GetMatrix( VRMatrix matrix ) {
 	ovrMatrix4f output;
 	if (matrix == VR_PROJECTION_MATRIX_HUD) {
@@ -25,4 +25,7 @@ void VR_EndFrame( engine_t* engine );
 void VR_SetMode( VRMode mode );
 
 void VR_BindFramebuffer( engine_t* engine, int eye );
+// Renders both eyes with each draw. Programs drawing to it must declare layout(num_views = 2).
+bool VR_SupportsMultiview( engine_t* engine );
+void VR_BindMultiviewFramebuffer( engine_t* engine );
 ovrMatrix4f VR_GetMatrix( VRMatrix matrix );
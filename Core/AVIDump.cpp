@@ -8,9 +8,14 @@
 #define __STDC_CONSTANT_MACROS 1
 #endif
 
-#include <string>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <thread>
 
 #ifdef USE_FFMPEG
 
@@ -26,6 +31,7 @@ extern "C" {
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/File/FileUtil.h"
 #include "Common/File/Path.h"
+#include "Common/Thread/ThreadUtil.h"
 
 #include "Core/Config.h"
 #include "Core/AVIDump.h"
@@ -61,7 +67,25 @@ static bool s_start_dumping = false;
 static int s_current_width;
 static int s_current_height;
 static int s_file_index = 0;
-static GPUDebugBuffer buf;
+
+struct DumpFrame {
+	GPUDebugBuffer buf;
+	u32 w;
+	u32 h;
+};
+
+// Enough to ride out the encoder falling behind for a moment. When it's full, AddFrame waits
+// rather than dropping frames, so the video stays in sync.
+static const size_t MAX_QUEUED_FRAMES = 8;
+
+static std::thread s_encodeThread;
+static std::mutex s_queueLock;
+// Signaled when a frame is queued or stopping is requested.
+static std::condition_variable s_frameQueued;
+// Signaled when the encoder takes a frame off the queue.
+static std::condition_variable s_frameTaken;
+static std::deque<DumpFrame> s_queue;
+static bool s_stopEncoding = false;
 
 static void InitAVCodec() {
 	static bool first_run = true;
@@ -76,6 +100,18 @@ static void InitAVCodec() {
 }
 
 bool AVIDump::Start(int w, int h)
+{
+	if (s_encodeThread.joinable())
+		Stop();
+	if (!StartFile(w, h))
+		return false;
+
+	s_stopEncoding = false;
+	s_encodeThread = std::thread(&AVIDump::EncodeThread);
+	return true;
+}
+
+bool AVIDump::StartFile(int w, int h)
 {
 	s_width = w;
 	s_height = h;
@@ -189,6 +225,10 @@ static void PreparePacket(AVPacket* pkt) {
 #endif
 
 void AVIDump::AddFrame() {
+	if (!s_encodeThread.joinable())
+		return;
+
+	GPUDebugBuffer buf;
 	u32 w = 0;
 	u32 h = 0;
 	if (g_Config.bDumpVideoOutput) {
@@ -200,11 +240,56 @@ void AVIDump::AddFrame() {
 		w = PSP_CoreParameter().renderWidth;
 		h = PSP_CoreParameter().renderHeight;
 	}
+	if (!buf.GetData())
+		return;
+
+	DumpFrame frame;
+	frame.w = w;
+	frame.h = h;
+	if (buf.IsAllocated()) {
+		frame.buf = std::move(buf);
+	} else {
+		// Points into emulated memory, which will have changed by the time the encoder gets to it.
+		frame.buf.Allocate(buf.GetStride(), buf.GetHeight(), buf.GetFormat(), buf.GetFlipped());
+		memcpy(frame.buf.GetData(), buf.GetData(), buf.GetStride() * buf.GetHeight() * buf.PixelSize());
+	}
+
+	std::unique_lock<std::mutex> guard(s_queueLock);
+	s_frameTaken.wait(guard, [] { return s_queue.size() < MAX_QUEUED_FRAMES; });
+	s_queue.push_back(std::move(frame));
+	s_frameQueued.notify_one();
+}
+
+void AVIDump::EncodeThread() {
+	SetCurrentThreadName("AVIDump");
+
+	while (true) {
+		DumpFrame frame;
+		{
+			std::unique_lock<std::mutex> guard(s_queueLock);
+			s_frameQueued.wait(guard, [] { return !s_queue.empty() || s_stopEncoding; });
+			// When stopping, the queue is drained first so no frames are lost.
+			if (s_queue.empty())
+				break;
+			frame = std::move(s_queue.front());
+			s_queue.pop_front();
+			s_frameTaken.notify_one();
+		}
+		EncodeFrame(frame.buf, frame.w, frame.h);
+	}
+}
+
+void AVIDump::EncodeFrame(const GPUDebugBuffer &buf, u32 w, u32 h) {
 	CheckResolution(w, h);
 	u8 *flipbuffer = nullptr;
 	const u8 *buffer = ConvertBufferToScreenshot(buf, false, flipbuffer, w, h);
 
 #ifdef USE_FFMPEG
+	if (!s_codec_context || !buffer) {
+		// Reopening the file after a resolution change failed.
+		delete[] flipbuffer;
+		return;
+	}
 
 	s_src_frame->data[0] = const_cast<u8*>(buffer);
 	s_src_frame->linesize[0] = w * 3;
@@ -272,13 +357,26 @@ void AVIDump::AddFrame() {
 }
 
 void AVIDump::Stop() {
-#ifdef USE_FFMPEG
+	if (s_encodeThread.joinable()) {
+		{
+			std::lock_guard<std::mutex> guard(s_queueLock);
+			s_stopEncoding = true;
+		}
+		s_frameQueued.notify_one();
+		s_encodeThread.join();
+	}
+
+	StopFile();
+	NOTICE_LOG(G3D, "Stopping frame dump");
+}
 
-	av_write_trailer(s_format_context);
+void AVIDump::StopFile() {
+#ifdef USE_FFMPEG
+	if (s_format_context && s_format_context->pb)
+		av_write_trailer(s_format_context);
 	CloseFile();
 	s_file_index = 0;
 #endif
-	NOTICE_LOG(G3D, "Stopping frame dump");
 }
 
 void AVIDump::CloseFile() {
@@ -323,9 +421,9 @@ void AVIDump::CheckResolution(int width, int height) {
 	if ((width != s_current_width || height != s_current_height) && (width > 0 && height > 0))
 	{
 		int temp_file_index = s_file_index;
-		Stop();
+		StopFile();
 		s_file_index = temp_file_index + 1;
-		Start(width, height);
+		StartFile(width, height);
 		s_current_width = width;
 		s_current_height = height;
 	}
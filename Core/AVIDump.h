@@ -7,14 +7,21 @@
 
 #include "Common/CommonTypes.h"
 
+struct GPUDebugBuffer;
+
 class AVIDump
 {
 private:
+	static bool StartFile(int w, int h);
+	static void StopFile();
 	static bool CreateAVI();
 	static void CloseFile();
 	static void CheckResolution(int width, int height);
+	static void EncodeThread();
+	static void EncodeFrame(const GPUDebugBuffer &buf, u32 w, u32 h);
 
 public:
+	// Frames are grabbed on the calling thread, but converted, encoded and written on a separate thread.
 	static bool Start(int w, int h);
 	static void AddFrame();
 	static void Stop();
@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <cstring>
+#include <memory>
 
 #include "Common/Data/Format/IniFile.h"
 #include "Common/StringUtils.h"
@@ -23,7 +24,17 @@
 #include "Core/Config.h"
 #include "Core/System.h"
 
-void Compatibility::Load(const std::string &gameID) {
+IniFile *Compatibility::LoadBuiltin() {
+	IniFile *compat = new IniFile();
+	// This loads from assets.
+	if (!compat->LoadFromVFS("compat.ini")) {
+		delete compat;
+		return nullptr;
+	}
+	return compat;
+}
+
+void Compatibility::Load(const std::string &gameID, IniFile *builtin) {
 	Clear();
 
 	// Allow ignoring compat settings by name (regardless of game ID.)
@@ -34,11 +45,12 @@ void Compatibility::Load(const std::string &gameID) {
 	if (ignored_.find("ALL") != ignored_.end())
 		return;
 
-	{
-		IniFile compat;
-		// This loads from assets.
-		if (compat.LoadFromVFS("compat.ini")) {
-			CheckSettings(compat, gameID);
+	if (builtin) {
+		CheckSettings(*builtin, gameID);
+	} else {
+		std::unique_ptr<IniFile> compat(LoadBuiltin());
+		if (compat) {
+			CheckSettings(*compat, gameID);
 		}
 	}
 
@@ -96,6 +108,7 @@ void Compatibility::CheckSettings(IniFile &iniFile, const std::string &gameID) {
 	CheckSetting(iniFile, gameID, "MaliDepthStencilBugWorkaround", &flags_.MaliDepthStencilBugWorkaround);
 	CheckSetting(iniFile, gameID, "ZZT3SelectHack", &flags_.ZZT3SelectHack);
 	CheckSetting(iniFile, gameID, "AllowLargeFBTextureOffsets", &flags_.AllowLargeFBTextureOffsets);
+	CheckSetting(iniFile, gameID, "AllowDelayedReadbacks", &flags_.AllowDelayedReadbacks);
 }
 
 void Compatibility::CheckSetting(IniFile &iniFile, const std::string &gameID, const char *option, bool *flag) {
@@ -86,6 +86,7 @@ struct CompatFlags {
 	bool MaliDepthStencilBugWorkaround;
 	bool ZZT3SelectHack;
 	bool AllowLargeFBTextureOffsets;
+	bool AllowDelayedReadbacks;
 };
 
 class IniFile;
@@ -99,7 +100,11 @@ class Compatibility {
 	// Flags enforced read-only through const. Only way to change them is to load assets/compat.ini.
 	const CompatFlags &flags() const { return flags_; }
 
-	void Load(const std::string &gameID);
+	// Parses the compat.ini bundled with the assets. Doesn't depend on the game, so it can run early on another thread.
+	static IniFile *LoadBuiltin();
+
+	// If builtin is null, the bundled compat.ini is loaded here.
+	void Load(const std::string &gameID, IniFile *builtin = nullptr);
 
 private:
 	void Clear();
@@ -515,6 +515,14 @@ static bool DefaultEnableStateUndo() {
 	return true;
 }
 
+static int DefaultRewindMemoryBudget() {
+#ifdef MOBILE_DEVICE
+	// Less on mobile to save memory.
+	return 64;
+#endif
+	return 256;
+}
+
 struct ConfigSectionSettings {
 	const char *section;
 	ConfigSetting *settings;
@@ -536,6 +544,7 @@ static ConfigSetting generalSettings[] = {
 	ConfigSetting("UISound", &g_Config.bUISound, false, true, false),
 
 	ConfigSetting("AutoLoadSaveState", &g_Config.iAutoLoadSaveState, 0, true, true),
+	ConfigSetting("LazyStateLoad", &g_Config.bLazyStateLoad, false, true, true),
 	ReportedConfigSetting("EnableCheats", &g_Config.bEnableCheats, false, true, true),
 	ConfigSetting("CwCheatRefreshRate", &g_Config.iCwCheatRefreshRate, 77, true, true),
 	ConfigSetting("CwCheatScrollPosition", &g_Config.fCwCheatScrollPosition, 0.0f, true, true),
@@ -553,6 +562,8 @@ static ConfigSetting generalSettings[] = {
 	ConfigSetting("StateUndoLastSaveGame", &g_Config.sStateUndoLastSaveGame, "NA", true, false),
 	ConfigSetting("StateUndoLastSaveSlot", &g_Config.iStateUndoLastSaveSlot, -5, true, false), // Start with an "invalid" value
 	ConfigSetting("RewindFlipFrequency", &g_Config.iRewindFlipFrequency, 0, true, true),
+	ConfigSetting("RewindMemoryBudgetMB", &g_Config.iRewindMemoryBudgetMB, &DefaultRewindMemoryBudget, true, true),
+	ConfigSetting("RunAheadFrames", &g_Config.iRunAheadFrames, 0, true, true),
 
 	ConfigSetting("ShowOnScreenMessage", &g_Config.bShowOnScreenMessages, true, true, false),
 	ConfigSetting("ShowRegionOnGameIcon", &g_Config.bShowRegionOnGameIcon, false),
@@ -622,16 +633,26 @@ static bool DefaultSasThread() {
 	return cpu_info.num_cores > 1;
 }
 
+static bool DefaultBackgroundJit() {
+	return cpu_info.num_cores > 2;
+}
+
 static ConfigSetting cpuSettings[] = {
 	ReportedConfigSetting("CPUCore", &g_Config.iCpuCore, &DefaultCpuCore, true, true),
 	ReportedConfigSetting("SeparateSASThread", &g_Config.bSeparateSASThread, &DefaultSasThread, true, true),
+	ReportedConfigSetting("PipelinedSAS", &g_Config.bPipelinedSAS, false, true, true),
 	ReportedConfigSetting("IOTimingMethod", &g_Config.iIOTimingMethod, IOTIMING_FAST, true, true),
 	ConfigSetting("FastMemoryAccess", &g_Config.bFastMemory, true, true, true),
 	ReportedConfigSetting("FunctionReplacements", &g_Config.bFuncReplacements, true, true, true),
 	ConfigSetting("HideSlowWarnings", &g_Config.bHideSlowWarnings, false, true, false),
 	ConfigSetting("HideStateWarnings", &g_Config.bHideStateWarnings, false, true, false),
 	ConfigSetting("PreloadFunctions", &g_Config.bPreloadFunctions, false, true, true),
+	ConfigSetting("JitBlockCache", &g_Config.bJitBlockCache, true, true, true),
+	ConfigSetting("TieredJit", &g_Config.bTieredJit, false, true, true),
+	ConfigSetting("BackgroundJit", &g_Config.bBackgroundJit, &DefaultBackgroundJit, true, true),
 	ConfigSetting("JitDisableFlags", &g_Config.uJitDisableFlags, (uint32_t)0, true, true),
+	ReportedConfigSetting("SkipIdleLoops", &g_Config.bSkipIdleLoops, false, true, true),
+	ConfigSetting("HugePages", &g_Config.bHugePages, false, true, false),
 	ReportedConfigSetting("CPUSpeed", &g_Config.iLockedCPUSpeed, 0, true, true),
 
 	ConfigSetting(false),
@@ -841,6 +862,8 @@ static int FastForwardModeFromString(const std::string &s) {
 		return (int)FastForwardMode::CONTINUOUS;
 	if (!strcasecmp(s.c_str(), "SKIP_FLIP"))
 		return (int)FastForwardMode::SKIP_FLIP;
+	if (!strcasecmp(s.c_str(), "SKIP_DRAW"))
+		return (int)FastForwardMode::SKIP_DRAW;
 	return DefaultFastForwardMode();
 }
 
@@ -850,6 +873,8 @@ std::string FastForwardModeToString(int v) {
 		return "CONTINUOUS";
 	case FastForwardMode::SKIP_FLIP:
 		return "SKIP_FLIP";
+	case FastForwardMode::SKIP_DRAW:
+		return "SKIP_DRAW";
 	}
 	return "CONTINUOUS";
 }
@@ -866,6 +891,7 @@ static ConfigSetting graphicsSettings[] = {
 	ConfigSetting("VulkanDevice", &g_Config.sVulkanDevice, "", true, false),
 #ifdef _WIN32
 	ConfigSetting("D3D11Device", &g_Config.sD3D11Device, "", true, false),
+	ConfigSetting("D3D11ThreadedPresent", &g_Config.bD3D11ThreadedPresent, false, true, false),
 #endif
 	ConfigSetting("CameraDevice", &g_Config.sCameraDevice, "", true, false),
 	ConfigSetting("VendorBugChecksEnabled", &g_Config.bVendorBugChecksEnabled, true, false, false),
@@ -877,6 +903,8 @@ static ConfigSetting graphicsSettings[] = {
 	ReportedConfigSetting("TextureFiltering", &g_Config.iTexFiltering, 1, true, true),
 	ReportedConfigSetting("BufferFiltering", &g_Config.iBufFilter, SCALE_LINEAR, true, true),
 	ReportedConfigSetting("InternalResolution", &g_Config.iInternalResolution, &DefaultInternalResolution, true, true),
+	ConfigSetting("DynamicResolution", &g_Config.bDynamicResolution, false, true, true),
+	ConfigSetting("PostShaderNativeResolution", &g_Config.bPostShaderNativeResolution, false, true, true),
 	ReportedConfigSetting("AndroidHwScale", &g_Config.iAndroidHwScale, &DefaultAndroidHwScale),
 	ReportedConfigSetting("HighQualityDepth", &g_Config.bHighQualityDepth, true, true, true),
 	ReportedConfigSetting("FrameSkip", &g_Config.iFrameSkip, 0, true, true),
@@ -895,6 +923,7 @@ static ConfigSetting graphicsSettings[] = {
 	ConfigSetting("AnisotropyLevel", &g_Config.iAnisotropyLevel, 4, true, true),
 
 	ReportedConfigSetting("VertexDecCache", &g_Config.bVertexCache, false, true, true),
+	ConfigSetting("VertexCacheSizeMB", &g_Config.iVertexCacheSizeMB, 0, true, true),
 	ReportedConfigSetting("TextureBackoffCache", &g_Config.bTextureBackoffCache, false, true, true),
 	ReportedConfigSetting("TextureSecondaryCache", &g_Config.bTextureSecondaryCache, false, true, true),
 	ReportedConfigSetting("VertexDecJit", &g_Config.bVertexDecoderJit, &DefaultCodeGen, false),
@@ -916,22 +945,29 @@ static ConfigSetting graphicsSettings[] = {
 	ReportedConfigSetting("SaveNewTextures", &g_Config.bSaveNewTextures, false, true, true),
 	ConfigSetting("IgnoreTextureFilenames", &g_Config.bIgnoreTextureFilenames, false, true, true),
 	ConfigSetting("ReplaceTexturesAllowLate", &g_Config.bReplaceTexturesAllowLate, true, true, true),
+	ConfigSetting("ReplaceTexturesPreload", &g_Config.bReplaceTexturesPreload, true, true, true),
 
 	ReportedConfigSetting("TexScalingLevel", &g_Config.iTexScalingLevel, 1, true, true),
 	ReportedConfigSetting("TexScalingType", &g_Config.iTexScalingType, 0, true, true),
 	ReportedConfigSetting("TexDeposterize", &g_Config.bTexDeposterize, false, true, true),
 	ReportedConfigSetting("TexHardwareScaling", &g_Config.bTexHardwareScaling, false, true, true),
+	ConfigSetting("TexScalingDiskCache", &g_Config.bTexScalingDiskCache, false, true, true),
+	ConfigSetting("TexScalingBackground", &g_Config.bTexScalingBackground, false, true, true),
+	ReportedConfigSetting("TexComputeDecode", &g_Config.bTexComputeDecode, false, true, true),
 	ConfigSetting("VSyncInterval", &g_Config.bVSync, false, true, true),
+	ConfigSetting("LowLatencyFramePacing", &g_Config.bLowLatencyFramePacing, false, true, true),
 	ReportedConfigSetting("BloomHack", &g_Config.iBloomHack, 0, true, true),
 
 	// Not really a graphics setting...
 	ReportedConfigSetting("SplineBezierQuality", &g_Config.iSplineBezierQuality, 2, true, true),
 	ReportedConfigSetting("HardwareTessellation", &g_Config.bHardwareTessellation, false, true, true),
+	ReportedConfigSetting("HardwareVideoDecoding", &g_Config.bHardwareVideoDecoding, false, true, false),
 	ConfigSetting("TextureShader", &g_Config.sTextureShaderName, "Off", true, true),
 	ConfigSetting("ShaderChainRequires60FPS", &g_Config.bShaderChainRequires60FPS, false, true, true),
 
 	ReportedConfigSetting("MemBlockTransferGPU", &g_Config.bBlockTransferGPU, true, true, true),
 	ReportedConfigSetting("DisableSlowFramebufEffects", &g_Config.bDisableSlowFramebufEffects, false, true, true),
+	ReportedConfigSetting("LazyFramebufferReadback", &g_Config.bLazyFramebufferReadback, false, true, true),
 	ReportedConfigSetting("FragmentTestCache", &g_Config.bFragmentTestCache, true, true, true),
 
 	ConfigSetting("GfxDebugOutput", &g_Config.bGfxDebugOutput, false, false, false),
@@ -942,6 +978,13 @@ static ConfigSetting graphicsSettings[] = {
 	ConfigSetting("RenderDuplicateFrames", &g_Config.bRenderDuplicateFrames, false, true, true),
 
 	ConfigSetting("ShaderCache", &g_Config.bShaderCache, true, false, false),  // Doesn't save. Ini-only.
+	ConfigSetting("ShaderCacheSeedURL", &g_Config.sShaderCacheSeedURL, "", true, false),
+	ConfigSetting("PipelineFallback", &g_Config.bPipelineFallback, false, true, true),
+	ConfigSetting("ParallelCmdRecording", &g_Config.bParallelCmdRecording, false, true, true),
+	ConfigSetting("AsyncTextureUpload", &g_Config.bAsyncTextureUpload, false, true, true),
+	ConfigSetting("BindlessTextures", &g_Config.bBindlessTextures, false, true, true),
+	ConfigSetting("DisplayListStateCache", &g_Config.bDisplayListStateCache, true, true, true),
+	ReportedConfigSetting("SeparateGEThread", &g_Config.bSeparateGEThread, false, true, true),
 	ConfigSetting("GpuLogProfiler", &g_Config.bGpuLogProfiler, false, true, false),
 
 	ConfigSetting(false),
@@ -951,6 +994,8 @@ static ConfigSetting soundSettings[] = {
 	ConfigSetting("Enable", &g_Config.bEnableSound, true, true, true),
 	ConfigSetting("AudioBackend", &g_Config.iAudioBackend, 0, true, true),
 	ConfigSetting("ExtraAudioBuffering", &g_Config.bExtraAudioBuffering, false, true, false),
+	ConfigSetting("LowLatencyAudio", &g_Config.bLowLatencyAudio, false, true, false),
+	ConfigSetting("HighQualityResampling", &g_Config.bHighQualityResampling, false, true, false),
 	ConfigSetting("GlobalVolume", &g_Config.iGlobalVolume, VOLUME_FULL, true, true),
 	ConfigSetting("ReverbVolume", &g_Config.iReverbVolume, VOLUME_FULL, true, true),
 	ConfigSetting("AltSpeedVolume", &g_Config.iAltSpeedVolume, -1, true, true),
@@ -986,6 +1031,7 @@ static const ConfigTouchPos defaultTouchPosHide = { -1.0f, -1.0f, defaultControl
 
 static ConfigSetting controlSettings[] = {
 	ConfigSetting("HapticFeedback", &g_Config.bHapticFeedback, false, true, true),
+	ConfigSetting("LateInputSampling", &g_Config.bLateInputSampling, false, true, true),
 	ConfigSetting("ShowTouchCross", &g_Config.bShowTouchCross, true, true, true),
 	ConfigSetting("ShowTouchCircle", &g_Config.bShowTouchCircle, true, true, true),
 	ConfigSetting("ShowTouchSquare", &g_Config.bShowTouchSquare, true, true, true),
@@ -1453,7 +1499,7 @@ void Config::Load(const char *iniFileName, const char *controllerIniFilename) {
 	}
 
 	// Override ppsspp.ini JIT value to prevent crashing
-	if (DefaultCpuCore() != (int)CPUCore::JIT && g_Config.iCpuCore == (int)CPUCore::JIT) {
+	if (DefaultCpuCore() != (int)CPUCore::JIT && (g_Config.iCpuCore == (int)CPUCore::JIT || g_Config.iCpuCore == (int)CPUCore::JIT_IR)) {
 		jitForcedOff = true;
 		g_Config.iCpuCore = (int)CPUCore::INTERPRETER;
 	}
@@ -119,9 +119,17 @@ struct Config {
 	bool bHideSlowWarnings;
 	bool bHideStateWarnings;
 	bool bPreloadFunctions;
+	bool bJitBlockCache;
+	bool bTieredJit;
+	bool bBackgroundJit;
 	uint32_t uJitDisableFlags;
+	// Fast-forward to the next scheduled event when the game spins in a loop polling memory.
+	bool bSkipIdleLoops;
+	// Ask for huge pages for PSP RAM and the JIT code space, to cut TLB misses.
+	bool bHugePages;
 
 	bool bSeparateSASThread;
+	bool bPipelinedSAS;
 	int iIOTimingMethod;
 	int iLockedCPUSpeed;
 	bool bAutoSaveSymbolMap;
@@ -156,6 +164,7 @@ struct Config {
 	// If not set, will use the "best" device.
 	std::string sVulkanDevice;
 	std::string sD3D11Device;  // Windows only
+	bool bD3D11ThreadedPresent;  // Windows only
 	std::string sCameraDevice;
 	std::string sMicDevice;
 
@@ -176,6 +185,7 @@ struct Config {
 	bool bSustainedPerformanceMode;  // Android: Slows clocks down to avoid overheating/speed fluctuations.
 	bool bIgnoreScreenInsets;  // Android: Center screen disregarding insets if this is enabled.
 	bool bVSync;
+	bool bLowLatencyFramePacing;  // Throttle before emulating a frame instead of before presenting it.
 	int iFrameSkip;
 	int iFrameSkipType;
 	int iFastForwardMode; // See FastForwardMode in ConfigValues.h.
@@ -195,6 +205,7 @@ struct Config {
 	float fUISaturation;
 
 	bool bVertexCache;
+	int iVertexCacheSizeMB;  // Vulkan only, decoded vertex cache budget. 0 = default.
 	bool bTextureBackoffCache;
 	bool bTextureSecondaryCache;
 	bool bVertexDecoderJit;
@@ -202,16 +213,21 @@ struct Config {
 	bool bFullScreenMulti;
 	int iForceFullScreen = -1; // -1 = nope, 0 = force off, 1 = force on (not saved.)
 	int iInternalResolution;  // 0 = Auto (native), 1 = 1x (480x272), 2 = 2x, 3 = 3x, 4 = 4x and so on.
+	bool bDynamicResolution;  // Lowers the internal resolution while running below full speed.
 	int iAnisotropyLevel;  // 0 - 5, powers of 2: 0 = 1x = no aniso
 	int bHighQualityDepth;
 	bool bReplaceTextures;
 	bool bSaveNewTextures;
 	bool bIgnoreTextureFilenames;
 	bool bReplaceTexturesAllowLate;
+	bool bReplaceTexturesPreload;  // Remembers which replacements load together, and starts loading the rest early.
 	int iTexScalingLevel; // 0 = auto, 1 = off, 2 = 2x, ..., 5 = 5x
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
 	bool bTexHardwareScaling;
+	bool bTexScalingDiskCache;  // Keeps upscaled textures on disk so they're only scaled once per game.
+	bool bTexScalingBackground;  // Scales on a worker thread, drawing unscaled until the result is ready.
+	bool bTexComputeDecode;  // Vulkan only, decodes CLUT textures in a compute shader.
 	int iFpsLimit1;
 	int iFpsLimit2;
 	int iAnalogFpsLimit;
@@ -219,12 +235,17 @@ struct Config {
 	int iMaxRecent;
 	int iCurrentStateSlot;
 	int iRewindFlipFrequency;
+	int iRewindMemoryBudgetMB;
+	// Frames to run ahead of input (and roll back) each frame, to hide the game's own input lag. 0 = off.
+	int iRunAheadFrames;
 	bool bUISound;
 	bool bEnableStateUndo;
 	std::string sStateLoadUndoGame;
 	std::string sStateUndoLastSaveGame;
 	int iStateUndoLastSaveSlot;
 	int iAutoLoadSaveState; // 0 = off, 1 = oldest, 2 = newest, >2 = slot number + 3
+	// Start running right after a state load, RAM is filled in as it's touched. Needs exception handler support.
+	bool bLazyStateLoad;
 	bool bEnableCheats;
 	bool bReloadCheats;
 	int iCwCheatRefreshRate;
@@ -233,13 +254,25 @@ struct Config {
 	int iBloomHack; //0 = off, 1 = safe, 2 = balanced, 3 = aggressive
 	bool bBlockTransferGPU;
 	bool bDisableSlowFramebufEffects;
+	// Protect framebuffer VRAM and only download the parts the CPU reads. Needs exception handler support.
+	bool bLazyFramebufferReadback;
 	bool bFragmentTestCache;
 	int iSplineBezierQuality; // 0 = low , 1 = Intermediate , 2 = High
 	bool bHardwareTessellation;
 	bool bShaderCache;  // Hidden ini-only setting, useful for debugging shader compile times.
+	// Hidden ini-only setting. Base URL serving <discID>.vkshadercache files, used to seed an empty shader cache.
+	std::string sShaderCacheSeedURL;
+	bool bPipelineFallback;  // Vulkan only, draws with a similar compiled pipeline while a new one compiles.
+	bool bParallelCmdRecording;  // Vulkan only, records large render passes into secondary command buffers on worker threads.
+	bool bAsyncTextureUpload;  // Vulkan only, uploads replacement textures on a dedicated transfer queue if the device has one.
+	bool bBindlessTextures;  // Vulkan only, binds all of a frame's textures as one descriptor array if VK_EXT_descriptor_indexing is available.
+	bool bDisplayListStateCache;  // Replays pre-decoded runs of state commands instead of interpreting them word by word.
+	bool bSeparateGEThread;  // Runs display lists on their own thread, syncing with the CPU only where needed.
+	bool bHardwareVideoDecoding;  // Hidden ini-only setting, decodes movies through FFmpeg hwaccel when available.
 
 	std::vector<std::string> vPostShaderNames; // Off for chain end (only Off for no shader)
 	std::map<std::string, float> mPostShaderSetting;
+	bool bPostShaderNativeResolution;  // Runs the post shader chain at 480x272, upscaling only at the end.
 	bool bShaderChainRequires60FPS;
 	std::string sTextureShaderName;
 	bool bGfxDebugOutput;
@@ -254,6 +287,8 @@ struct Config {
 	int iReverbVolume;
 	int iAltSpeedVolume;
 	bool bExtraAudioBuffering;  // For bluetooth
+	bool bLowLatencyAudio;  // Shrink the audio buffer while there are no underruns
+	bool bHighQualityResampling;  // Windowed sinc instead of linear interpolation
 	std::string sAudioDevice;
 	bool bAutoAudioDevice;
 
@@ -388,6 +423,8 @@ struct Config {
 	bool bShowTouchPause;
 
 	bool bHapticFeedback;
+	// Refresh the newest ctrl sample from host input when the game reads it, instead of only at vblank.
+	bool bLateInputSampling;
 
 	// We also use the XInput settings as analog settings on other platforms like Android.
 	float fAnalogDeadzone;
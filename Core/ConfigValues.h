@@ -34,6 +34,8 @@ enum class CPUCore {
 	INTERPRETER = 0,
 	JIT = 1,
 	IR_JIT = 2,
+	// IR frontend and passes, translated to native code where there's a backend.
+	JIT_IR = 3,
 };
 
 enum {
@@ -120,6 +122,8 @@ enum class AutoLoadSaveState {
 
 enum class FastForwardMode {
 	CONTINUOUS = 0,
+	// Like SKIP_FLIP, but also skips drawing frames that would never be presented.
+	SKIP_DRAW = 1,
 	SKIP_FLIP = 2,
 };
 
@@ -64,6 +64,7 @@ struct CoreParameter {
 	bool printfEmuLog;  // writes "emulator:" logging to stdout
 	std::string *collectEmuLog = nullptr;
 	bool headLess;   // Try to avoid messageboxes etc
+	bool headLessBenchmark = false;  // Keep replaying GE dumps instead of stopping after one frame.
 
 	// Internal PSP rendering resolution and scale factor.
 	int renderScaleFactor;
@@ -85,6 +86,11 @@ struct CoreParameter {
 	bool freezeNext = false;
 	bool frozen = false;
 
+	// Run-ahead. Speculative frames get rolled back: they don't throttle, output audio, or process savestates.
+	bool runAheadSpeculative = false;
+	// The current frame isn't presented.
+	bool runAheadHidden = false;
+
 	FileLoader *mountIsoLoader = nullptr;
 
 	Compatibility compat;
@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <atomic>
 #include <climits>
 #include <cstdio>
@@ -61,16 +62,21 @@ struct BaseEvent {
 	int type;
 };
 
+// Events from other threads wait in a locked list until MoveEvents().
 typedef LinkedListItem<BaseEvent> Event;
 
-Event *first;
 Event *tsFirst;
 Event *tsLast;
-
-// event pools
-Event *eventPool = 0;
 Event *eventTsPool = 0;
-int allocatedTsEvents = 0;
+
+// The main queue is a binary min-heap.  Ties on time run in the order they were scheduled.
+struct QueuedEvent : public BaseEvent {
+	u64 order;
+};
+
+static std::vector<QueuedEvent> eventQueue;
+static u64 nextEventOrder = 0;
+
 // Optimization to skip MoveEvents when possible.
 std::atomic<u32> hasTsEvents;
 
@@ -131,20 +137,8 @@ u64 GetGlobalTimeUs() {
 	return lastGlobalTimeUs + usSinceLast;
 }
 
-Event* GetNewEvent()
-{
-	if(!eventPool)
-		return new Event;
-
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
-}
-
 Event* GetNewTsEvent()
 {
-	allocatedTsEvents++;
-
 	if(!eventTsPool)
 		return new Event;
 
@@ -153,17 +147,86 @@ Event* GetNewTsEvent()
 	return ev;
 }
 
-void FreeEvent(Event* ev)
-{
-	ev->next = eventPool;
-	eventPool = ev;
-}
-
 void FreeTsEvent(Event* ev)
 {
 	ev->next = eventTsPool;
 	eventTsPool = ev;
-	allocatedTsEvents--;
+}
+
+// For the heap functions, which put the "largest" first.
+static bool EventLater(const QueuedEvent &a, const QueuedEvent &b) {
+	return a.time > b.time || (a.time == b.time && a.order > b.order);
+}
+
+static bool EventEarlier(const QueuedEvent &a, const QueuedEvent &b) {
+	return EventLater(b, a);
+}
+
+static const QueuedEvent *FirstEvent() {
+	return eventQueue.empty() ? nullptr : &eventQueue.front();
+}
+
+// Takes out one event from the middle of the heap, moving the last one into its place.
+static void RemoveEventAt(size_t i) {
+	const size_t last = eventQueue.size() - 1;
+	if (i != last) {
+		eventQueue[i] = eventQueue[last];
+	}
+	eventQueue.pop_back();
+	if (i >= last)
+		return;
+
+	// The replacement might need to go either up or down.
+	while (i > 0 && EventLater(eventQueue[(i - 1) / 2], eventQueue[i])) {
+		std::swap(eventQueue[(i - 1) / 2], eventQueue[i]);
+		i = (i - 1) / 2;
+	}
+	while (true) {
+		size_t earliest = i;
+		const size_t left = i * 2 + 1;
+		const size_t right = left + 1;
+		if (left < last && EventLater(eventQueue[earliest], eventQueue[left]))
+			earliest = left;
+		if (right < last && EventLater(eventQueue[earliest], eventQueue[right]))
+			earliest = right;
+		if (earliest == i)
+			break;
+		std::swap(eventQueue[earliest], eventQueue[i]);
+		i = earliest;
+	}
+}
+
+// Removes every event matching pred, returning the cycles left for the last one that would have run.
+template <typename F>
+static s64 RemoveEventsIf(F pred) {
+	s64 result = 0;
+	QueuedEvent last{};
+	bool found = false;
+	// Going backwards, only the slot we just removed can receive an event we haven't checked yet.
+	for (size_t i = eventQueue.size(); i > 0; ) {
+		const QueuedEvent &ev = eventQueue[i - 1];
+		if (pred(ev)) {
+			if (!found || EventLater(ev, last))
+				last = ev;
+			found = true;
+			const bool wasLast = i == eventQueue.size();
+			RemoveEventAt(i - 1);
+			if (wasLast)
+				--i;
+		} else {
+			--i;
+		}
+	}
+
+	if (found)
+		result = last.time - GetTicks();
+	return result;
+}
+
+static std::vector<QueuedEvent> SortedEvents() {
+	std::vector<QueuedEvent> sorted = eventQueue;
+	std::sort(sorted.begin(), sorted.end(), &EventEarlier);
+	return sorted;
 }
 
 int RegisterEvent(const char *name, TimedCallback callback) {
@@ -209,7 +272,7 @@ void RestoreRegisterEvent(int &event_type, const char *name, TimedCallback callb
 }
 
 void UnregisterAllEvents() {
-	_dbg_assert_msg_(first == nullptr, "Unregistering events with events pending - this isn't good.");
+	_dbg_assert_msg_(eventQueue.empty(), "Unregistering events with events pending - this isn't good.");
 	event_types.clear();
 	usedEventTypes.clear();
 	restoredEventTypes.clear();
@@ -233,13 +296,7 @@ void Shutdown()
 	MoveEvents();
 	ClearPendingEvents();
 	UnregisterAllEvents();
-
-	while(eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
+	eventQueue.shrink_to_fit();
 
 	std::lock_guard<std::mutex> lk(externalEventLock);
 	while(eventTsPool)
@@ -295,30 +352,27 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
+	eventQueue.clear();
+	nextEventOrder = 0;
 }
 
-void AddEventToQueue(Event* ne)
+static void AddEventToQueue(const BaseEvent &ev)
 {
-	Event* prev = NULL;
-	Event** pNext = &first;
-	for(;;)
-	{
-		Event*& next = *pNext;
-		if(!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
+	QueuedEvent ne;
+	ne.time = ev.time;
+	ne.userdata = ev.userdata;
+	ne.type = ev.type;
+	ne.order = nextEventOrder++;
+	eventQueue.push_back(ne);
+	std::push_heap(eventQueue.begin(), eventQueue.end(), &EventLater);
+}
+
+static BaseEvent PopFirstEvent()
+{
+	std::pop_heap(eventQueue.begin(), eventQueue.end(), &EventLater);
+	BaseEvent ev = eventQueue.back();
+	eventQueue.pop_back();
+	return ev;
 }
 
 // This must be run ONLY from within the cpu thread
@@ -326,56 +380,19 @@ void AddEventToQueue(Event* ne)
 // than Advance
 void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = GetTicks() + cyclesIntoFuture;
+	BaseEvent ne;
+	ne.userdata = userdata;
+	ne.type = event_type;
+	ne.time = GetTicks() + cyclesIntoFuture;
 	AddEventToQueue(ne);
 }
 
 // Returns cycles left in timer.
 s64 UnscheduleEvent(int event_type, u64 userdata)
 {
-	s64 result = 0;
-	if (!first)
-		return result;
-	while(first)
-	{
-		if (first->type == event_type && first->userdata == userdata)
-		{
-			result = first->time - GetTicks();
-
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return result;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type && ptr->userdata == userdata)
-		{
-			result = ptr->time - GetTicks();
-
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
-
-	return result;
+	return RemoveEventsIf([=](const QueuedEvent &ev) {
+		return ev.type == event_type && ev.userdata == userdata;
+	});
 }
 
 s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata)
@@ -435,52 +452,18 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback) {
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
+	for (const QueuedEvent &ev : eventQueue) {
+		if (ev.type == event_type)
 			return true;
-		e = e->next;
 	}
 	return false;
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
-		return;
-	while(first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
+	RemoveEventsIf([=](const QueuedEvent &ev) {
+		return ev.type == event_type;
+	});
 }
 
 void RemoveThreadsafeEvent(int event_type)
@@ -537,16 +520,13 @@ void RemoveAllEvents(int event_type)
 //This raise only the events required while the fifo is processing data
 void ProcessFifoWaitEvents()
 {
-	while (first)
+	while (!eventQueue.empty())
 	{
-		if (first->time <= (s64)GetTicks())
+		if (eventQueue.front().time <= (s64)GetTicks())
 		{
-//			LOG(CPU, "[Scheduler] %s		 (%lld, %lld) ",
-//				first->name ? first->name : "?", (u64)GetTicks(), (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
-			FreeEvent(evt);
+			// The callback may schedule more events, so take it off the queue first.
+			BaseEvent evt = PopFirstEvent();
+			event_types[evt.type].callback(evt.userdata, (int)(GetTicks() - evt.time));
 		}
 		else
 		{
@@ -564,20 +544,11 @@ void MoveEvents()
 	while (tsFirst)
 	{
 		Event *next = tsFirst->next;
-		AddEventToQueue(tsFirst);
+		AddEventToQueue(*tsFirst);
+		FreeTsEvent(tsFirst);
 		tsFirst = next;
 	}
 	tsLast = NULL;
-
-	// Move free events to threadsafe pool
-	while(allocatedTsEvents > 0 && eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		ev->next = eventTsPool;
-		eventTsPool = ev;
-		allocatedTsEvents--;
-	}
 }
 
 void ForceCheck()
@@ -604,6 +575,7 @@ void Advance() {
 		MoveEvents();
 	ProcessFifoWaitEvents();
 
+	const QueuedEvent *first = FirstEvent();
 	if (!first) {
 		// This should never happen in PPSSPP.
 		// WARN_LOG_REPORT(TIME, "WARNING - no events in queue. Setting currentMIPS->downcount to 10000");
@@ -624,10 +596,8 @@ void Advance() {
 }
 
 void LogPendingEvents() {
-	Event *ptr = first;
-	while (ptr) {
-		//INFO_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
+	for (const QueuedEvent &ev : SortedEvents()) {
+		DEBUG_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", (long long)globalTimer, (long long)ev.time, ev.type);
 	}
 }
 
@@ -636,6 +606,7 @@ void Idle(int maxIdle) {
 	if (maxIdle != 0 && cyclesDown > maxIdle)
 		cyclesDown = maxIdle;
 
+	const QueuedEvent *first = FirstEvent();
 	if (first && cyclesDown > 0) {
 		int cyclesExecuted = slicelength - currentMIPS->downcount;
 		int cyclesNextEvent = (int) (first->time - globalTimer);
@@ -657,23 +628,20 @@ void Idle(int maxIdle) {
 }
 
 std::string GetScheduledEventsSummary() {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr) {
-		unsigned int t = ptr->type;
+	for (const QueuedEvent &ev : SortedEvents()) {
+		unsigned int t = ev.type;
 		if (t >= event_types.size()) {
 			_dbg_assert_msg_(false, "Invalid event type %d", t);
-			ptr = ptr->next;
 			continue;
 		}
 		const char *name = event_types[t].name;
 		if (!name)
 			name = "[unknown]";
 		char temp[512];
-		sprintf(temp, "%s : %i %08x%08x\n", name, (int)ptr->time, (u32)(ptr->userdata >> 32), (u32)(ptr->userdata));
+		sprintf(temp, "%s : %i %08x%08x\n", name, (int)ev.time, (u32)(ev.userdata >> 32), (u32)(ev.userdata));
 		text += temp;
-		ptr = ptr->next;
 	}
 	return text;
 }
@@ -693,6 +661,35 @@ void Event_DoStateOld(PointerWrap &p, BaseEvent *ev)
 	usedEventTypes.insert(ev->type);
 }
 
+// Uses the same format as DoLinkedList(), since this used to be a sorted list.
+static void DoEventQueue(PointerWrap &p, void (*doEvent)(PointerWrap &, BaseEvent *)) {
+	if (p.mode == PointerWrap::MODE_READ) {
+		ClearPendingEvents();
+		while (true) {
+			u8 shouldExist = 0;
+			Do(p, shouldExist);
+			if (shouldExist != 1) {
+				if (shouldExist != 0) {
+					WARN_LOG(SAVESTATE, "Savestate failure: incorrect item marker %d", shouldExist);
+					p.SetError(p.ERROR_FAILURE);
+				}
+				break;
+			}
+			BaseEvent ev;
+			doEvent(p, &ev);
+			AddEventToQueue(ev);
+		}
+	} else {
+		for (QueuedEvent &ev : SortedEvents()) {
+			u8 shouldExist = 1;
+			Do(p, shouldExist);
+			doEvent(p, &ev);
+		}
+		u8 shouldExist = 0;
+		Do(p, shouldExist);
+	}
+}
+
 void DoState(PointerWrap &p) {
 	std::lock_guard<std::mutex> lk(externalEventLock);
 
@@ -719,10 +716,10 @@ void DoState(PointerWrap &p) {
 	restoredEventTypes.clear();
 
 	if (s >= 3) {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoState>(p, first, (Event **) NULL);
+		DoEventQueue(p, &Event_DoState);
 		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoState>(p, tsFirst, &tsLast);
 	} else {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoStateOld>(p, first, (Event **) NULL);
+		DoEventQueue(p, &Event_DoStateOld);
 		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoStateOld>(p, tsFirst, &tsLast);
 	}
 
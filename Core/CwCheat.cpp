@@ -393,6 +393,11 @@ void CWCheatEngine::ParseCheats() {
 	// TODO: Report errors.
 
 	cheats_ = parser.GetCheats();
+	compiled_.clear();
+	compiled_.resize(cheats_.size());
+	for (size_t i = 0; i < cheats_.size(); ++i) {
+		compiled_[i].resize(cheats_[i].lines.size());
+	}
 }
 
 u32 CWCheatEngine::GetAddress(u32 value) {
@@ -496,6 +501,16 @@ struct CheatOperation {
 	};
 };
 
+// Decoding only depends on the cheat lines, so it's done once per starting line rather than every run.
+struct CompiledCheatOp {
+	CheatOperation op;
+	size_t next;
+	bool valid = false;
+};
+
+CWCheatEngine::~CWCheatEngine() {
+}
+
 CheatOperation CWCheatEngine::InterpretNextCwCheat(const CheatCode &cheat, size_t &i) {
 	const CheatLine &line1 = cheat.lines[i++];
 	const uint32_t &arg = line1.part2;
@@ -801,19 +816,48 @@ CheatOperation CWCheatEngine::InterpretNextOp(const CheatCode &cheat, size_t &i)
 
 void CWCheatEngine::ApplyMemoryOperator(const CheatOperation &op, uint32_t(*oper)(uint32_t, uint32_t)) {
 	if (Memory::IsValidAddress(op.addr)) {
-		InvalidateICache(op.addr, 4);
+		InvalidateICacheForRead(op.addr);
 		if (op.sz == 1)
-			Memory::Write_U8((u8)oper(Memory::Read_U8(op.addr), op.val), op.addr);
+			WriteMemory(op.addr, 1, oper(Memory::Read_U8(op.addr), op.val));
 		else if (op.sz == 2)
-			Memory::Write_U16((u16)oper(Memory::Read_U16(op.addr), op.val),op. addr);
+			WriteMemory(op.addr, 2, oper(Memory::Read_U16(op.addr), op.val));
 		else if (op.sz == 4)
-			Memory::Write_U32((u32)oper(Memory::Read_U32(op.addr), op.val), op.addr);
+			WriteMemory(op.addr, 4, oper(Memory::Read_U32(op.addr), op.val));
 	}
 }
 
+// Most cheats write the same value every time they run. When memory already holds it there's
+// nothing to write, and no jit block to throw away either.
+void CWCheatEngine::WriteMemory(u32 addr, int sz, u32 val) {
+	// An emuhack means the jit has replaced the instruction, so memory doesn't show the real value.
+	bool emuhack = MIPS_IS_EMUHACK(Memory::Read_U32(addr & ~3));
+	if (sz == 1) {
+		if (!emuhack && Memory::Read_U8(addr) == (u8)val)
+			return;
+		InvalidateICache(addr, 4);
+		Memory::Write_U8((u8)val, addr);
+	} else if (sz == 2) {
+		if (!emuhack && Memory::Read_U16(addr) == (u16)val)
+			return;
+		InvalidateICache(addr, 4);
+		Memory::Write_U16((u16)val, addr);
+	} else if (sz == 4) {
+		if (!emuhack && Memory::Read_U32(addr) == val)
+			return;
+		InvalidateICache(addr, 4);
+		Memory::Write_U32(val, addr);
+	}
+}
+
+// Reading only needs the original instructions back where the jit has patched them.
+void CWCheatEngine::InvalidateICacheForRead(u32 addr) {
+	if (Memory::IsValidAddress(addr & ~3) && MIPS_IS_EMUHACK(Memory::Read_U32(addr & ~3)))
+		InvalidateICache(addr, 4);
+}
+
 bool CWCheatEngine::TestIf(const CheatOperation &op, bool(*oper)(int, int)) {
 	if (Memory::IsValidAddress(op.addr)) {
-		InvalidateICache(op.addr, 4);
+		InvalidateICacheForRead(op.addr);
 
 		int memoryValue = 0;
 		if (op.sz == 1)
@@ -830,7 +874,8 @@ bool CWCheatEngine::TestIf(const CheatOperation &op, bool(*oper)(int, int)) {
 
 bool CWCheatEngine::TestIfAddr(const CheatOperation &op, bool(*oper)(int, int)) {
 	if (Memory::IsValidAddress(op.addr)) {
-		InvalidateICache(op.addr, 4);
+		InvalidateICacheForRead(op.addr);
+		InvalidateICacheForRead(op.ifAddrTypes.compareAddr);
 
 		int memoryValue1 = 0;
 		int memoryValue2 = 0;
@@ -861,13 +906,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::Write:
 		if (Memory::IsValidAddress(op.addr)) {
-			InvalidateICache(op.addr, 4);
-			if (op.sz == 1)
-				Memory::Write_U8((u8)op.val, op.addr);
-			else if (op.sz == 2)
-				Memory::Write_U16((u16)op.val, op.addr);
-			else if (op.sz == 4)
-				Memory::Write_U32((u32)op.val, op.addr);
+			WriteMemory(op.addr, op.sz, op.val);
 		}
 		break;
 
@@ -903,18 +942,11 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::MultiWrite:
 		if (Memory::IsValidAddress(op.addr)) {
-			InvalidateICache(op.addr, op.multiWrite.count * op.multiWrite.step + op.sz);
-
 			uint32_t data = op.val;
 			uint32_t addr = op.addr;
 			for (uint32_t a = 0; a < op.multiWrite.count; a++) {
 				if (Memory::IsValidAddress(addr)) {
-					if (op.sz == 1)
-						Memory::Write_U8((u8)data, addr);
-					else if (op.sz == 2)
-						Memory::Write_U16((u16)data, addr);
-					else if (op.sz == 4)
-						Memory::Write_U32((u32)data, addr);
+					WriteMemory(addr, op.sz, data);
 				}
 				addr += op.multiWrite.step;
 				data += op.multiWrite.add;
@@ -1001,7 +1033,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::Assert:
 		if (Memory::IsValidAddress(op.addr)) {
-			InvalidateICache(op.addr, 4);
+			InvalidateICacheForRead(op.addr);
 			if (Memory::Read_U32(op.addr) != op.val) {
 				i = cheat.lines.size();
 			}
@@ -1091,7 +1123,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::CwCheatPointerCommands:
 		{
-			InvalidateICache(op.addr + op.pointerCommands.baseOffset, 4);
+			InvalidateICacheForRead(op.addr + op.pointerCommands.baseOffset);
 			u32 base = Memory::Read_U32(op.addr + op.pointerCommands.baseOffset);
 			u32 val = op.val;
 			int type = op.pointerCommands.type;
@@ -1100,7 +1132,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 				switch (line.part1 >> 28) {
 				case 0x1: // type copy byte
 					{
-						InvalidateICache(op.addr, 4);
+						InvalidateICacheForRead(op.addr);
 						u32 srcAddr = Memory::Read_U32(op.addr) + op.pointerCommands.offset;
 						u32 dstAddr = Memory::Read_U32(op.addr + op.pointerCommands.baseOffset) + (line.part1 & 0x0FFFFFFF);
 						if (Memory::IsValidRange(dstAddr, val) && Memory::IsValidRange(srcAddr, val)) {
@@ -1120,7 +1152,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 						if ((line.part1 >> 28) == 0x3) {
 							walkOffset = -walkOffset;
 						}
-						InvalidateICache(base + walkOffset, 4);
+						InvalidateICacheForRead(base + walkOffset);
 						base = Memory::Read_U32(base + walkOffset);
 						switch (line.part2 >> 28) {
 						case 0x2:
@@ -1129,7 +1161,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 							if ((line.part2 >> 28) == 0x3) {
 								walkOffset = -walkOffset;
 							}
-							InvalidateICache(base + walkOffset, 4);
+							InvalidateICacheForRead(base + walkOffset);
 							base = Memory::Read_U32(base + walkOffset);
 							break;
 
@@ -1153,28 +1185,22 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 			switch (type) {
 			case 0: // 8 bit write
-				InvalidateICache(base + op.pointerCommands.offset, 4);
-				Memory::Write_U8((u8)val, base + op.pointerCommands.offset);
+				WriteMemory(base + op.pointerCommands.offset, 1, val);
 				break;
 			case 1: // 16-bit write
-				InvalidateICache(base + op.pointerCommands.offset, 4);
-				Memory::Write_U16((u16)val, base + op.pointerCommands.offset);
+				WriteMemory(base + op.pointerCommands.offset, 2, val);
 				break;
 			case 2: // 32-bit write
-				InvalidateICache(base + op.pointerCommands.offset, 4);
-				Memory::Write_U32((u32)val, base + op.pointerCommands.offset);
+				WriteMemory(base + op.pointerCommands.offset, 4, val);
 				break;
 			case 3: // 8 bit inverse write
-				InvalidateICache(base - op.pointerCommands.offset, 4);
-				Memory::Write_U8((u8)val, base - op.pointerCommands.offset);
+				WriteMemory(base - op.pointerCommands.offset, 1, val);
 				break;
 			case 4: // 16-bit inverse write
-				InvalidateICache(base - op.pointerCommands.offset, 4);
-				Memory::Write_U16((u16)val, base - op.pointerCommands.offset);
+				WriteMemory(base - op.pointerCommands.offset, 2, val);
 				break;
 			case 5: // 32-bit inverse write
-				InvalidateICache(base - op.pointerCommands.offset, 4);
-				Memory::Write_U32((u32)val, base - op.pointerCommands.offset);
+				WriteMemory(base - op.pointerCommands.offset, 4, val);
 				break;
 			case -1: // Operation already performed, nothing to do
 				break;
@@ -1188,11 +1214,19 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 }
 
 void CWCheatEngine::Run() {
-	for (CheatCode cheat : cheats_) {
-		// InterpretNextOp and ExecuteOp move i.
+	for (size_t c = 0; c < cheats_.size(); ++c) {
+		const CheatCode &cheat = cheats_[c];
+		std::vector<CompiledCheatOp> &compiled = compiled_[c];
+		// InterpretNextOp and ExecuteOp move i. Skips can land anywhere, so ops are cached by starting line.
 		for (size_t i = 0; i < cheat.lines.size(); ) {
-			CheatOperation op = InterpretNextOp(cheat, i);
-			ExecuteOp(op, cheat, i);
+			CompiledCheatOp &entry = compiled[i];
+			if (!entry.valid) {
+				entry.next = i;
+				entry.op = InterpretNextOp(cheat, entry.next);
+				entry.valid = true;
+			}
+			i = entry.next;
+			ExecuteOp(entry.op, cheat, i);
 		}
 	}
 }
@@ -43,10 +43,12 @@ struct CheatFileInfo {
 };
 
 struct CheatOperation;
+struct CompiledCheatOp;
 
 class CWCheatEngine {
 public:
 	CWCheatEngine(const std::string &gameID);
+	~CWCheatEngine();
 	std::vector<CheatFileInfo> FileInfo();
 	void ParseCheats();
 	void CreateCheatFile();
@@ -65,8 +67,12 @@ class CWCheatEngine {
 	void ApplyMemoryOperator(const CheatOperation &op, uint32_t(*oper)(uint32_t, uint32_t));
 	bool TestIf(const CheatOperation &op, bool(*oper)(int a, int b));
 	bool TestIfAddr(const CheatOperation &op, bool(*oper)(int a, int b));
+	void WriteMemory(u32 addr, int sz, u32 val);
+	void InvalidateICacheForRead(u32 addr);
 
 	std::vector<CheatCode> cheats_;
+	// Decoded operations, indexed like cheats_ and then by the line they start at. Filled in lazily.
+	std::vector<std::vector<CompiledCheatOp>> compiled_;
 	std::string gameID_;
 	Path filename_;
 };
@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <cstdio>
+#include <cstring>
 #include <atomic>
 #include <mutex>
 
@@ -41,6 +42,11 @@ static std::mutex memCheckMutex_;
 std::vector<MemCheck> CBreakPoints::memChecks_;
 std::vector<MemCheck *> CBreakPoints::cleanupMemChecks_;
 
+// One bit per page that any MemCheck touches, ignoring the cached/kernel bits.
+static constexpr u32 MEMCHECK_PAGE_SHIFT = 12;
+static constexpr u32 MEMCHECK_PAGE_COUNT = 0x40000000 >> MEMCHECK_PAGE_SHIFT;
+static std::atomic<u32> memCheckPages_[MEMCHECK_PAGE_COUNT / 32];
+
 void MemCheck::Log(u32 addr, bool write, int size, u32 pc, const char *reason) {
 	if (result & BREAK_ACTION_LOG) {
 		const char *type = write ? "Write" : "Read";
@@ -390,6 +396,7 @@ void CBreakPoints::AddMemCheck(u32 start, u32 end, MemCheckCondition cond, Break
 		check.result = result;
 
 		memChecks_.push_back(check);
+		UpdateMemCheckPagesLocked();
 		bool hadAny = anyMemChecks_.exchange(true);
 		if (!hadAny)
 			MemBlockOverrideDetailed();
@@ -400,6 +407,7 @@ void CBreakPoints::AddMemCheck(u32 start, u32 end, MemCheckCondition cond, Break
 	{
 		memChecks_[mc].cond = (MemCheckCondition)(memChecks_[mc].cond | cond);
 		memChecks_[mc].result = (BreakAction)(memChecks_[mc].result | result);
+		UpdateMemCheckPagesLocked();
 		bool hadAny = anyMemChecks_.exchange(true);
 		if (!hadAny)
 			MemBlockOverrideDetailed();
@@ -418,6 +426,7 @@ void CBreakPoints::RemoveMemCheck(u32 start, u32 end)
 	if (mc != INVALID_MEMCHECK)
 	{
 		memChecks_.erase(memChecks_.begin() + mc);
+		UpdateMemCheckPagesLocked();
 		bool hadAny = anyMemChecks_.exchange(!memChecks_.empty());
 		if (hadAny)
 			MemBlockReleaseDetailed();
@@ -448,6 +457,7 @@ void CBreakPoints::ClearAllMemChecks()
 	if (!memChecks_.empty())
 	{
 		memChecks_.clear();
+		UpdateMemCheckPagesLocked();
 		bool hadAny = anyMemChecks_.exchange(false);
 		if (hadAny)
 			MemBlockReleaseDetailed();
@@ -511,9 +521,45 @@ MemCheck *CBreakPoints::GetMemCheckLocked(u32 address, int size) {
 	return 0;
 }
 
+void CBreakPoints::UpdateMemCheckPagesLocked() {
+	static u32 pages[MEMCHECK_PAGE_COUNT / 32];
+	memset(pages, 0, sizeof(pages));
+
+	for (const MemCheck &check : memChecks_) {
+		u32 start = check.start & 0x3FFFFFFF;
+		u32 size = check.end > check.start ? check.end - check.start : 1;
+		u64 count = ((u64)(start & ((1 << MEMCHECK_PAGE_SHIFT) - 1)) + size + (1 << MEMCHECK_PAGE_SHIFT) - 1) >> MEMCHECK_PAGE_SHIFT;
+		if (count > MEMCHECK_PAGE_COUNT)
+			count = MEMCHECK_PAGE_COUNT;
+		for (u32 i = 0; i < (u32)count; ++i) {
+			u32 page = ((start >> MEMCHECK_PAGE_SHIFT) + i) % MEMCHECK_PAGE_COUNT;
+			pages[page >> 5] |= 1 << (page & 31);
+		}
+	}
+
+	for (u32 i = 0; i < MEMCHECK_PAGE_COUNT / 32; ++i)
+		memCheckPages_[i].store(pages[i], std::memory_order_relaxed);
+}
+
+bool CBreakPoints::MayHaveMemCheck(u32 address, u32 size) {
+	if (!anyMemChecks_)
+		return false;
+
+	u32 start = address & 0x3FFFFFFF;
+	u64 count = ((u64)(start & ((1 << MEMCHECK_PAGE_SHIFT) - 1)) + std::max(size, 1U) + (1 << MEMCHECK_PAGE_SHIFT) - 1) >> MEMCHECK_PAGE_SHIFT;
+	if (count > MEMCHECK_PAGE_COUNT)
+		count = MEMCHECK_PAGE_COUNT;
+	for (u32 i = 0; i < (u32)count; ++i) {
+		u32 page = ((start >> MEMCHECK_PAGE_SHIFT) + i) % MEMCHECK_PAGE_COUNT;
+		if (memCheckPages_[page >> 5].load(std::memory_order_relaxed) & (1 << (page & 31)))
+			return true;
+	}
+	return false;
+}
+
 BreakAction CBreakPoints::ExecMemCheck(u32 address, bool write, int size, u32 pc, const char *reason)
 {
-	if (!anyMemChecks_)
+	if (!MayHaveMemCheck(address, size))
 		return BREAK_ACTION_IGNORE;
 	std::unique_lock<std::mutex> guard(memCheckMutex_);
 	auto check = GetMemCheckLocked(address, size);
@@ -528,6 +574,10 @@ BreakAction CBreakPoints::ExecMemCheck(u32 address, bool write, int size, u32 pc
 
 BreakAction CBreakPoints::ExecOpMemCheck(u32 address, u32 pc)
 {
+	// No CPU access is larger than a vector (lv.q/sv.q), so skip decoding the op for far away accesses.
+	if (!MayHaveMemCheck(address, 16))
+		return BREAK_ACTION_IGNORE;
+
 	// Note: currently, we don't check "on changed" for HLE (ExecMemCheck.)
 	// We'd need to more carefully specify memory changes in HLE for that.
 	int size = MIPSAnalyst::OpMemoryAccessSize(pc);
@@ -562,6 +612,8 @@ BreakAction CBreakPoints::ExecOpMemCheck(u32 address, u32 pc)
 
 void CBreakPoints::ExecMemCheckJitBefore(u32 address, bool write, int size, u32 pc)
 {
+	if (!MayHaveMemCheck(address, size))
+		return;
 	std::unique_lock<std::mutex> guard(memCheckMutex_);
 	auto check = GetMemCheckLocked(address, size);
 	if (check) {
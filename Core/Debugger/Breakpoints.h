@@ -115,7 +115,7 @@ struct MemCheck {
 
 // BreakPoints cannot overlap, only one is allowed per address.
 // MemChecks can overlap, as long as their ends are different.
-// WARNING: MemChecks are not used in the interpreter or HLE currently.
+// Accesses are first filtered by page, so only accesses near a MemCheck pay for the full lookup.
 class CBreakPoints
 {
 public:
@@ -168,6 +168,8 @@ class CBreakPoints
 	static const std::vector<BreakPoint> GetBreakpoints();
 
 	static bool HasMemChecks();
+	// Quick filter without locking: false means no MemCheck can overlap this range.
+	static bool MayHaveMemCheck(u32 address, u32 size);
 
 	static void Update(u32 addr = 0);
 
@@ -179,6 +181,7 @@ class CBreakPoints
 	// Finds exactly, not using a range check.
 	static size_t FindMemCheck(u32 start, u32 end);
 	static MemCheck *GetMemCheckLocked(u32 address, int size);
+	static void UpdateMemCheckPagesLocked();
 
 	static std::vector<BreakPoint> breakPoints_;
 	static u32 breakSkipFirstAt_;
@@ -19,6 +19,7 @@
 #include <atomic>
 #include <cstring>
 #include <mutex>
+#include <unordered_map>
 
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
@@ -29,17 +30,45 @@
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/MIPS/MIPS.h"
 #include "Common/StringUtils.h"
+#include "ext/xxhash.h"
+
+// Tags are interned, so slabs and pending notifies only carry a small id.
+// Id 0 is always the empty tag.
+class MemTagTable {
+public:
+	MemTagTable() {
+		Clear();
+	}
+
+	uint32_t Intern(const char *tag, size_t length);
+	std::string Get(uint32_t id);
+	size_t Size();
+	void Clear();
+	// Drops tags not marked in used, returning a mapping from old to new ids.
+	std::vector<uint32_t> Compact(const std::vector<bool> &used);
+
+private:
+	std::mutex lock_;
+	std::vector<std::string> names_;
+	std::unordered_multimap<uint64_t, uint32_t> lookup_;
+};
+
+static constexpr uint32_t MEMTAG_KEEP = 0xFFFFFFFF;
+static constexpr size_t MEMTAG_MAX_LENGTH = 127;
 
 class MemSlabMap {
 public:
 	MemSlabMap();
 	~MemSlabMap();
 
-	bool Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc, bool allocated, const char *tag);
+	// Pass MEMTAG_KEEP as tag to leave the existing tags alone.
+	bool Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc, bool allocated, uint32_t tag);
 	bool Find(MemBlockFlags flags, uint32_t addr, uint32_t size, std::vector<MemBlockInfo> &results);
 	bool FastFindWriteTag(MemBlockFlags flags, uint32_t addr, uint32_t size, std::string &result);
 	void Reset();
 	void DoState(PointerWrap &p);
+	void MarkUsedTags(std::vector<bool> &used) const;
+	void RemapTags(const std::vector<uint32_t> &remap);
 
 private:
 	struct Slab {
@@ -48,7 +77,7 @@ class MemSlabMap {
 		uint64_t ticks = 0;
 		uint32_t pc = 0;
 		bool allocated = false;
-		char tag[128]{};
+		uint32_t tag = 0;
 		Slab *prev = nullptr;
 		Slab *next = nullptr;
 
@@ -79,7 +108,7 @@ struct PendingNotifyMem {
 	uint32_t size;
 	uint64_t ticks;
 	uint32_t pc;
-	char tag[128];
+	uint32_t tag;
 };
 
 static constexpr size_t MAX_PENDING_NOTIFIES = 512;
@@ -94,6 +123,65 @@ static std::atomic<uint32_t> pendingNotifyMinAddr2;
 static std::atomic<uint32_t> pendingNotifyMaxAddr2;
 static std::mutex pendingMutex;
 static int detailedOverride;
+static MemTagTable tagTable;
+// Generated tags (like addresses) can pile up, so unused ones are dropped once there are this many.
+static size_t tagCompactThreshold = 0x4000;
+
+uint32_t MemTagTable::Intern(const char *tag, size_t length) {
+	if (length > MEMTAG_MAX_LENGTH)
+		length = MEMTAG_MAX_LENGTH;
+	if (length == 0)
+		return 0;
+
+	uint64_t hash = XXH3_64bits(tag, length);
+	std::lock_guard<std::mutex> guard(lock_);
+	auto range = lookup_.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		const std::string &name = names_[it->second];
+		if (name.size() == length && memcmp(name.data(), tag, length) == 0)
+			return it->second;
+	}
+
+	uint32_t id = (uint32_t)names_.size();
+	names_.emplace_back(tag, length);
+	lookup_.emplace(hash, id);
+	return id;
+}
+
+std::string MemTagTable::Get(uint32_t id) {
+	std::lock_guard<std::mutex> guard(lock_);
+	return id < names_.size() ? names_[id] : std::string();
+}
+
+size_t MemTagTable::Size() {
+	std::lock_guard<std::mutex> guard(lock_);
+	return names_.size();
+}
+
+std::vector<uint32_t> MemTagTable::Compact(const std::vector<bool> &used) {
+	std::lock_guard<std::mutex> guard(lock_);
+	std::vector<uint32_t> remap(names_.size(), 0);
+	std::vector<std::string> oldNames;
+	oldNames.swap(names_);
+	lookup_.clear();
+
+	names_.push_back("");
+	for (size_t i = 1; i < oldNames.size(); ++i) {
+		if (i >= used.size() || !used[i])
+			continue;
+		remap[i] = (uint32_t)names_.size();
+		lookup_.emplace(XXH3_64bits(oldNames[i].data(), oldNames[i].size()), remap[i]);
+		names_.push_back(std::move(oldNames[i]));
+	}
+	return remap;
+}
+
+void MemTagTable::Clear() {
+	std::lock_guard<std::mutex> guard(lock_);
+	names_.clear();
+	lookup_.clear();
+	names_.push_back("");
+}
 
 MemSlabMap::MemSlabMap() {
 	Reset();
@@ -103,7 +191,7 @@ MemSlabMap::~MemSlabMap() {
 	Clear();
 }
 
-bool MemSlabMap::Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc, bool allocated, const char *tag) {
+bool MemSlabMap::Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc, bool allocated, uint32_t tag) {
 	uint32_t end = addr + size;
 	Slab *slab = FindSlab(addr);
 	Slab *firstMatch = nullptr;
@@ -120,8 +208,8 @@ bool MemSlabMap::Mark(uint32_t addr, uint32_t size, uint64_t ticks, uint32_t pc,
 			slab->ticks = ticks;
 			slab->pc = pc;
 		}
-		if (tag)
-			truncate_cpy(slab->tag, tag);
+		if (tag != MEMTAG_KEEP)
+			slab->tag = tag;
 
 		// Move on to the next one.
 		if (firstMatch == nullptr)
@@ -142,8 +230,8 @@ bool MemSlabMap::Find(MemBlockFlags flags, uint32_t addr, uint32_t size, std::ve
 	Slab *slab = FindSlab(addr);
 	bool found = false;
 	while (slab != nullptr && slab->start < end) {
-		if (slab->pc != 0 || slab->tag[0] != '\0') {
-			results.push_back({ flags, slab->start, slab->end - slab->start, slab->ticks, slab->pc, slab->tag, slab->allocated });
+		if (slab->pc != 0 || slab->tag != 0) {
+			results.push_back({ flags, slab->start, slab->end - slab->start, slab->ticks, slab->pc, tagTable.Get(slab->tag), slab->allocated });
 			found = true;
 		}
 		slab = slab->next;
@@ -155,8 +243,8 @@ bool MemSlabMap::FastFindWriteTag(MemBlockFlags flags, uint32_t addr, uint32_t s
 	uint32_t end = addr + size;
 	Slab *slab = FindSlab(addr);
 	while (slab != nullptr && slab->start < end) {
-		if (slab->pc != 0 || slab->tag[0] != '\0') {
-			result = slab->tag;
+		if (slab->pc != 0 || slab->tag != 0) {
+			result = tagTable.Get(slab->tag);
 			return true;
 		}
 		slab = slab->next;
@@ -226,6 +314,19 @@ void MemSlabMap::DoState(PointerWrap &p) {
 	}
 }
 
+void MemSlabMap::MarkUsedTags(std::vector<bool> &used) const {
+	for (const Slab *slab = first_; slab != nullptr; slab = slab->next) {
+		if (slab->tag < used.size())
+			used[slab->tag] = true;
+	}
+}
+
+void MemSlabMap::RemapTags(const std::vector<uint32_t> &remap) {
+	for (Slab *slab = first_; slab != nullptr; slab = slab->next) {
+		slab->tag = slab->tag < remap.size() ? remap[slab->tag] : 0;
+	}
+}
+
 void MemSlabMap::Slab::DoState(PointerWrap &p) {
 	auto s = p.Section("MemSlabMapSlab", 1, 3);
 	if (!s)
@@ -236,16 +337,22 @@ void MemSlabMap::Slab::DoState(PointerWrap &p) {
 	Do(p, ticks);
 	Do(p, pc);
 	Do(p, allocated);
+	// The state keeps the tag text, ids are only valid for this run.
 	if (s >= 3) {
-		Do(p, tag);
+		char tagText[128]{};
+		if (p.mode != p.MODE_READ)
+			truncate_cpy(tagText, tagTable.Get(tag).c_str());
+		Do(p, tagText);
+		if (p.mode == p.MODE_READ)
+			tag = tagTable.Intern(tagText, strnlen(tagText, sizeof(tagText)));
 	} else if (s >= 2) {
 		char shortTag[32];
 		Do(p, shortTag);
-		memcpy(tag, shortTag, sizeof(shortTag));
+		tag = tagTable.Intern(shortTag, strnlen(shortTag, sizeof(shortTag)));
 	} else {
 		std::string stringTag;
 		Do(p, stringTag);
-		truncate_cpy(tag, stringTag.c_str());
+		tag = tagTable.Intern(stringTag.c_str(), stringTag.size());
 	}
 }
 
@@ -285,7 +392,7 @@ MemSlabMap::Slab *MemSlabMap::Split(Slab *slab, uint32_t size) {
 	next->ticks = slab->ticks;
 	next->pc = slab->pc;
 	next->allocated = slab->allocated;
-	truncate_cpy(next->tag, slab->tag);
+	next->tag = slab->tag;
 	next->prev = slab;
 	next->next = slab->next;
 
@@ -305,7 +412,7 @@ bool MemSlabMap::Same(const Slab *a, const Slab *b) {
 		return false;
 	if (a->pc != b->pc)
 		return false;
-	if (strcmp(a->tag, b->tag))
+	if (a->tag != b->tag)
 		return false;
 	return true;
 }
@@ -371,19 +478,19 @@ void MemSlabMap::FillHeads(Slab *slab) {
 
 void FlushPendingMemInfo() {
 	std::lock_guard<std::mutex> guard(pendingMutex);
-	for (auto info : pendingNotifies) {
+	for (const auto &info : pendingNotifies) {
 		if (info.flags & MemBlockFlags::ALLOC) {
 			allocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
 		} else if (info.flags & MemBlockFlags::FREE) {
 			// Maintain the previous allocation tag for debugging.
-			allocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
-			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
+			allocMap.Mark(info.start, info.size, info.ticks, 0, false, MEMTAG_KEEP);
+			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, MEMTAG_KEEP);
 		}
 		if (info.flags & MemBlockFlags::SUB_ALLOC) {
 			suballocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
 		} else if (info.flags & MemBlockFlags::SUB_FREE) {
 			// Maintain the previous allocation tag for debugging.
-			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, nullptr);
+			suballocMap.Mark(info.start, info.size, info.ticks, 0, false, MEMTAG_KEEP);
 		}
 		if (info.flags & MemBlockFlags::TEXTURE) {
 			textureMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
@@ -397,6 +504,22 @@ void FlushPendingMemInfo() {
 	pendingNotifyMaxAddr1 = 0;
 	pendingNotifyMinAddr2 = 0xFFFFFFFF;
 	pendingNotifyMaxAddr2 = 0;
+
+	// Nothing is pending now, so only the maps hold tag ids.
+	if (tagTable.Size() >= tagCompactThreshold) {
+		std::vector<bool> used(tagTable.Size(), false);
+		allocMap.MarkUsedTags(used);
+		suballocMap.MarkUsedTags(used);
+		writeMap.MarkUsedTags(used);
+		textureMap.MarkUsedTags(used);
+
+		std::vector<uint32_t> remap = tagTable.Compact(used);
+		allocMap.RemapTags(remap);
+		suballocMap.RemapTags(remap);
+		writeMap.RemapTags(remap);
+		textureMap.RemapTags(remap);
+		tagCompactThreshold = std::max((size_t)0x4000, tagTable.Size() * 2);
+	}
 }
 
 void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_t pc, const char *tagStr, size_t strLength) {
@@ -413,14 +536,9 @@ void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_
 		info.ticks = CoreTiming::GetTicks();
 		info.pc = pc;
 
-		size_t copyLength = strLength;
-		if (copyLength >= sizeof(info.tag)) {
-			copyLength = sizeof(info.tag) - 1;
-		}
-		memcpy(info.tag, tagStr, copyLength);
-		info.tag[copyLength] = 0;
-
 		std::lock_guard<std::mutex> guard(pendingMutex);
+		// Interned under the lock, so a flush can't compact the table in between.
+		info.tag = tagTable.Intern(tagStr, strLength);
 		if (start < 0x08000000) {
 			pendingNotifyMinAddr1 = std::min(pendingNotifyMinAddr1.load(), start);
 			pendingNotifyMaxAddr1 = std::max(pendingNotifyMaxAddr1.load(), start + size);
@@ -542,6 +660,7 @@ void MemBlockInfoShutdown() {
 	writeMap.Reset();
 	textureMap.Reset();
 	pendingNotifies.clear();
+	tagTable.Clear();
 }
 
 void MemBlockInfoDoState(PointerWrap &p) {
@@ -0,0 +1,174 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Core/Debugger/SampleProfiler.h"
+#include "Core/Debugger/SymbolMap.h"
+#include "Core/ELF/ParamSFO.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/System.h"
+
+namespace SampleProfiler {
+
+static std::mutex lock;
+static std::condition_variable wakeThread;
+static std::thread sampleThread;
+static bool running = false;
+static int sampleIntervalUs = 1000;
+static std::atomic<int> hostWaitDepth;
+
+// Raw PCs, attributed to functions only when read, since symbols get added as modules load.
+static std::unordered_map<uint32_t, uint64_t> samplesByPC;
+static uint64_t totalSamples = 0;
+static uint64_t hostWaitSamples = 0;
+
+static void SampleLoop() {
+	SetCurrentThreadName("SampleProfiler");
+
+	std::unique_lock<std::mutex> guard(lock);
+	while (running) {
+		wakeThread.wait_for(guard, std::chrono::microseconds(sampleIntervalUs));
+		// Only while the CPU runs, otherwise we'd count wherever it stopped.
+		if (!running || coreState != CORE_RUNNING || !PSP_IsInited())
+			continue;
+
+		totalSamples++;
+		if (hostWaitDepth > 0) {
+			hostWaitSamples++;
+			continue;
+		}
+		// Not synchronized with the emu thread.  The native jits also only store the PC when leaving
+		// linked blocks, so this is a little behind there, but good enough in aggregate.
+		samplesByPC[currentMIPS->pc]++;
+	}
+}
+
+static void ResetLocked() {
+	samplesByPC.clear();
+	totalSamples = 0;
+	hostWaitSamples = 0;
+}
+
+void Start(int intervalUs) {
+	Stop();
+
+	std::lock_guard<std::mutex> guard(lock);
+	ResetLocked();
+	sampleIntervalUs = std::max(intervalUs, 100);
+	running = true;
+	sampleThread = std::thread(&SampleLoop);
+}
+
+void Stop() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!running)
+			return;
+		running = false;
+	}
+	wakeThread.notify_one();
+	sampleThread.join();
+}
+
+void Reset() {
+	std::lock_guard<std::mutex> guard(lock);
+	ResetLocked();
+}
+
+bool IsRunning() {
+	std::lock_guard<std::mutex> guard(lock);
+	return running;
+}
+
+void BeginHostWait() {
+	hostWaitDepth++;
+}
+
+void EndHostWait() {
+	hostWaitDepth--;
+}
+
+std::vector<FunctionSamples> GetFunctionProfile(uint64_t *total, uint64_t *hostWait) {
+	std::unordered_map<uint32_t, uint64_t> pcs;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		pcs = samplesByPC;
+		*total = totalSamples;
+		*hostWait = hostWaitSamples;
+	}
+
+	std::unordered_map<uint32_t, uint64_t> byFunction;
+	for (const auto &it : pcs) {
+		uint32_t funcStart = g_symbolMap ? g_symbolMap->GetFunctionStart(it.first) : SymbolMap::INVALID_ADDRESS;
+		byFunction[funcStart] += it.second;
+	}
+
+	std::vector<FunctionSamples> functions;
+	functions.reserve(byFunction.size());
+	for (const auto &it : byFunction) {
+		FunctionSamples func;
+		func.address = it.first;
+		if (it.first != SymbolMap::INVALID_ADDRESS)
+			func.name = g_symbolMap->GetLabelString(it.first);
+		if (func.name.empty())
+			func.name = it.first == SymbolMap::INVALID_ADDRESS ? "(unknown)" : StringFromFormat("z_un_%08x", it.first);
+		func.samples = it.second;
+		functions.push_back(func);
+	}
+	std::sort(functions.begin(), functions.end(), [](const FunctionSamples &a, const FunctionSamples &b) {
+		return a.samples > b.samples;
+	});
+	return functions;
+}
+
+std::string FormatProfile(int limit) {
+	uint64_t total, hostWait;
+	std::vector<FunctionSamples> functions = GetFunctionProfile(&total, &hostWait);
+	if (total == 0)
+		return "No samples\n";
+
+	std::string result = StringFromFormat("%llu samples, %0.1f%% in frame timing waits\n", (unsigned long long)total, hostWait * 100.0 / total);
+	result += "     %   samples  address   function\n";
+	for (size_t i = 0; i < functions.size() && (int)i < limit; ++i) {
+		const FunctionSamples &func = functions[i];
+		result += StringFromFormat("%6.2f %9llu  %08x  %s\n", func.samples * 100.0 / total, (unsigned long long)func.samples, func.address, func.name.c_str());
+	}
+	return result;
+}
+
+bool SaveProfile(const Path &filename) {
+	return File::WriteStringToFile(true, FormatProfile(std::numeric_limits<int>::max()), filename);
+}
+
+Path DefaultProfilePath() {
+	std::string discID = g_paramSFO.GetDiscID();
+	return GetSysDirectory(DIRECTORY_DUMP) / ((discID.empty() ? "unknown" : discID) + "_profile.txt");
+}
+
+}  // namespace SampleProfiler
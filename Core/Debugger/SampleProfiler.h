@@ -0,0 +1,56 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Common/File/Path.h"
+
+// Statistical profiler for guest code.  A thread samples the current PC at a fixed host time
+// interval, and samples are attributed to functions from the symbol map when read.
+// This is cheap enough to leave on while playing, unlike counting every block.
+namespace SampleProfiler {
+
+struct FunctionSamples {
+	// SymbolMap::INVALID_ADDRESS for code outside any known function.
+	uint32_t address;
+	std::string name;
+	uint64_t samples;
+};
+
+// Clears any previous samples.
+void Start(int intervalUs = 1000);
+void Stop();
+// Clears samples, without stopping.
+void Reset();
+bool IsRunning();
+
+// Frame timing sleeps on the emu thread, which shouldn't count as time in guest code.
+void BeginHostWait();
+void EndHostWait();
+
+// Sorted by samples, most first.  The totals include samples taken during host waits.
+std::vector<FunctionSamples> GetFunctionProfile(uint64_t *totalSamples, uint64_t *hostWaitSamples);
+std::string FormatProfile(int limit);
+bool SaveProfile(const Path &filename);
+// In the dump directory, named after the current game.
+Path DefaultProfilePath();
+
+}  // namespace SampleProfiler
@@ -82,6 +82,8 @@ bool SymbolMap::LoadSymbolMap(const Path &filename) {
 	if (f == Z_NULL)
 		return false;
 
+	bulkLoading_ = true;
+
 	//char temp[256];
 	//fgets(temp,255,f); //.text section layout
 	//fgets(temp,255,f); //  Starting        Virtual
@@ -185,6 +187,7 @@ bool SymbolMap::LoadSymbolMap(const Path &filename) {
 		}
 	}
 	gzclose(f);
+	bulkLoading_ = false;
 	SortSymbols();
 	return started;
 }
@@ -232,6 +235,8 @@ bool SymbolMap::LoadNocashSym(const Path &filename) {
 	if (!f)
 		return false;
 
+	bulkLoading_ = true;
+
 	while (!feof(f)) {
 		char line[256], value[256] = {0};
 		char *p = fgets(line, 256, f);
@@ -281,6 +286,7 @@ bool SymbolMap::LoadNocashSym(const Path &filename) {
 	}
 
 	fclose(f);
+	bulkLoading_ = false;
 	return true;
 }
 
@@ -558,8 +564,7 @@ void SymbolMap::AddFunction(const char* name, u32 address, u32 size, int moduleI
 		// Refresh the active item if it exists.
 		auto active = activeFunctions.find(address);
 		if (active != activeFunctions.end() && active->second.module == moduleIndex) {
-			activeFunctions.erase(active);
-			activeFunctions.insert(std::make_pair(address, existing->second));
+			active->second = functions[symbolKey];
 		}
 	} else {
 		FunctionEntry func;
@@ -569,7 +574,9 @@ void SymbolMap::AddFunction(const char* name, u32 address, u32 size, int moduleI
 		func.module = moduleIndex;
 		functions[symbolKey] = func;
 
-		if (IsModuleActive(moduleIndex)) {
+		if (bulkLoading_) {
+			activeNeedUpdate_ = true;
+		} else if (IsModuleActive(moduleIndex)) {
 			activeFunctions.insert(std::make_pair(address, func));
 		}
 	}
@@ -713,32 +720,39 @@ void SymbolMap::UpdateActiveSymbols() {
 		activeModuleIndexes[it->second.index] = it->second.start;
 	}
 
+	// Modules aren't in address order, so gather everything and sort once.
+	activeFunctions.reserve(functions.size());
 	for (auto it = functions.begin(), end = functions.end(); it != end; ++it) {
 		const auto mod = activeModuleIndexes.find(it->second.module);
 		if (it->second.module == 0) {
-			activeFunctions.insert(std::make_pair(it->second.start, it->second));
+			activeFunctions.AddBulk(std::make_pair(it->second.start, it->second));
 		} else if (mod != activeModuleIndexes.end()) {
-			activeFunctions.insert(std::make_pair(mod->second + it->second.start, it->second));
+			activeFunctions.AddBulk(std::make_pair(mod->second + it->second.start, it->second));
 		}
 	}
+	activeFunctions.FinishBulk();
 
+	activeLabels.reserve(labels.size());
 	for (auto it = labels.begin(), end = labels.end(); it != end; ++it) {
 		const auto mod = activeModuleIndexes.find(it->second.module);
 		if (it->second.module == 0) {
-			activeLabels.insert(std::make_pair(it->second.addr, it->second));
+			activeLabels.AddBulk(std::make_pair(it->second.addr, it->second));
 		} else if (mod != activeModuleIndexes.end()) {
-			activeLabels.insert(std::make_pair(mod->second + it->second.addr, it->second));
+			activeLabels.AddBulk(std::make_pair(mod->second + it->second.addr, it->second));
 		}
 	}
+	activeLabels.FinishBulk();
 
+	activeData.reserve(data.size());
 	for (auto it = data.begin(), end = data.end(); it != end; ++it) {
 		const auto mod = activeModuleIndexes.find(it->second.module);
 		if (it->second.module == 0) {
-			activeData.insert(std::make_pair(it->second.start, it->second));
+			activeData.AddBulk(std::make_pair(it->second.start, it->second));
 		} else if (mod != activeModuleIndexes.end()) {
-			activeData.insert(std::make_pair(mod->second + it->second.start, it->second));
+			activeData.AddBulk(std::make_pair(mod->second + it->second.start, it->second));
 		}
 	}
+	activeData.FinishBulk();
 
 	AssignFunctionIndices();
 	activeNeedUpdate_ = false;
@@ -756,8 +770,7 @@ bool SymbolMap::SetFunctionSize(u32 startAddress, u32 newSize) {
 		auto func = functions.find(symbolKey);
 		if (func != functions.end()) {
 			func->second.size = newSize;
-			activeFunctions.erase(funcInfo);
-			activeFunctions.insert(std::make_pair(startAddress, func->second));
+			funcInfo->second = func->second;
 		}
 	}
 
@@ -828,8 +841,7 @@ void SymbolMap::AddLabel(const char* name, u32 address, int moduleIndex) {
 			// Refresh the active item if it exists.
 			auto active = activeLabels.find(address);
 			if (active != activeLabels.end() && active->second.module == moduleIndex) {
-				activeLabels.erase(active);
-				activeLabels.insert(std::make_pair(address, label));
+				active->second = label;
 			}
 		}
 	} else {
@@ -839,7 +851,9 @@ void SymbolMap::AddLabel(const char* name, u32 address, int moduleIndex) {
 		truncate_cpy(label.name, name);
 
 		labels[symbolKey] = label;
-		if (IsModuleActive(moduleIndex)) {
+		if (bulkLoading_) {
+			activeNeedUpdate_ = true;
+		} else if (IsModuleActive(moduleIndex)) {
 			activeLabels.insert(std::make_pair(address, label));
 		}
 	}
@@ -863,8 +877,7 @@ void SymbolMap::SetLabelName(const char* name, u32 address) {
 			// Refresh the active item if it exists.
 			auto active = activeLabels.find(address);
 			if (active != activeLabels.end() && active->second.module == label->second.module) {
-				activeLabels.erase(active);
-				activeLabels.insert(std::make_pair(address, label->second));
+				active->second = label->second;
 			}
 		}
 	}
@@ -946,8 +959,7 @@ void SymbolMap::AddData(u32 address, u32 size, DataType type, int moduleIndex) {
 		// Refresh the active item if it exists.
 		auto active = activeData.find(address);
 		if (active != activeData.end() && active->second.module == moduleIndex) {
-			activeData.erase(active);
-			activeData.insert(std::make_pair(address, existing->second));
+			active->second = data[symbolKey];
 		}
 	} else {
 		DataEntry entry;
@@ -957,7 +969,9 @@ void SymbolMap::AddData(u32 address, u32 size, DataType type, int moduleIndex) {
 		entry.module = moduleIndex;
 
 		data[symbolKey] = entry;
-		if (IsModuleActive(moduleIndex)) {
+		if (bulkLoading_) {
+			activeNeedUpdate_ = true;
+		} else if (IsModuleActive(moduleIndex)) {
 			activeData.insert(std::make_pair(address, entry));
 		}
 	}
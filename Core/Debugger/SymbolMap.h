@@ -24,6 +24,7 @@
 #include <mutex>
 
 #include "Common/CommonTypes.h"
+#include "Common/Data/Collections/FlatMap.h"
 #include "Common/File/Path.h"
 
 enum SymbolType {
@@ -154,10 +155,13 @@ class SymbolMap {
 	};
 
 	// These are flattened, read-only copies of the actual data in active modules only.
-	std::map<u32, const FunctionEntry> activeFunctions;
-	std::map<u32, const LabelEntry> activeLabels;
-	std::map<u32, const DataEntry> activeData;
+	// Sorted arrays, since they're searched far more often than they change.
+	FlatMap<u32, FunctionEntry> activeFunctions;
+	FlatMap<u32, LabelEntry> activeLabels;
+	FlatMap<u32, DataEntry> activeData;
 	bool activeNeedUpdate_ = false;
+	// While loading a symbol file, skip maintaining the active copies and rebuild once at the end.
+	bool bulkLoading_ = false;
 
 	// This is indexed by the end address of the module.
 	std::map<u32, const ModuleEntry> activeModuleEnds;
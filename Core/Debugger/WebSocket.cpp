@@ -58,9 +58,12 @@
 #include "Core/Debugger/WebSocket/GPUStatsSubscriber.h"
 #include "Core/Debugger/WebSocket/HLESubscriber.h"
 #include "Core/Debugger/WebSocket/InputSubscriber.h"
+#include "Core/Debugger/WebSocket/JitProfileSubscriber.h"
 #include "Core/Debugger/WebSocket/MemoryInfoSubscriber.h"
 #include "Core/Debugger/WebSocket/MemorySubscriber.h"
 #include "Core/Debugger/WebSocket/ReplaySubscriber.h"
+#include "Core/Debugger/WebSocket/SampleProfileSubscriber.h"
+#include "Core/Debugger/WebSocket/SaveStateSubscriber.h"
 #include "Core/Debugger/WebSocket/SteppingSubscriber.h"
 
 typedef DebuggerSubscriber *(*SubscriberInit)(DebuggerEventHandlerMap &map);
@@ -74,9 +77,12 @@ static const std::vector<SubscriberInit> subscribers({
 	&WebSocketGPUStatsInit,
 	&WebSocketHLEInit,
 	&WebSocketInputInit,
+	&WebSocketJitProfileInit,
 	&WebSocketMemoryInfoInit,
 	&WebSocketMemoryInit,
 	&WebSocketReplayInit,
+	&WebSocketSampleProfileInit,
+	&WebSocketSaveStateInit,
 	&WebSocketSteppingInit,
 });
 
@@ -191,14 +191,31 @@ static std::string DescribeFormat(GPUDebugBufferFormat fmt) {
 }
 
 // Note: Calls req.Respond().  Other data can be added afterward.
-static bool StreamBufferToBase64(DebuggerRequest &req, const GPUDebugBuffer &buf) {
-	size_t length = buf.GetStride() * buf.GetHeight();
-
+static JsonWriter &WriteBufferInfo(DebuggerRequest &req, const GPUDebugBuffer &buf) {
 	auto &json = req.Respond();
 	json.writeInt("width", buf.GetStride());
 	json.writeInt("height", buf.GetHeight());
 	json.writeBool("flipped", buf.GetFlipped());
 	json.writeString("format", DescribeFormat(buf.GetFormat()));
+	return json;
+}
+
+// Sends the response, followed by the raw data in a separate binary frame.
+static bool SendBufferBinary(DebuggerRequest &req, const GPUDebugBuffer &buf) {
+	size_t length = buf.GetStride() * buf.GetHeight();
+
+	auto &json = WriteBufferInfo(req, buf);
+	json.writeUint("size", (uint32_t)length);
+	req.Finish();
+	req.ws->SendBinary(buf.GetData(), length);
+	return true;
+}
+
+// Note: Calls req.Respond().  Other data can be added afterward.
+static bool StreamBufferToBase64(DebuggerRequest &req, const GPUDebugBuffer &buf) {
+	size_t length = buf.GetStride() * buf.GetHeight();
+
+	auto &json = WriteBufferInfo(req, buf);
 
 	// Start a value without any actual data yet...
 	json.writeRaw("base64", "");
@@ -234,8 +251,8 @@ static void GenericStreamBuffer(DebuggerRequest &req, std::function<bool(const G
 	std::string type = "uri";
 	if (!req.ParamString("type", &type, DebuggerParamType::OPTIONAL))
 		return;
-	if (type != "uri" && type != "base64")
-		return req.Fail("Parameter 'type' must be either 'uri' or 'base64'");
+	if (type != "uri" && type != "base64" && type != "binary")
+		return req.Fail("Parameter 'type' must be 'uri', 'base64', or 'binary'");
 
 	const GPUDebugBuffer *buf = nullptr;
 	if (!func(buf)) {
@@ -245,6 +262,8 @@ static void GenericStreamBuffer(DebuggerRequest &req, std::function<bool(const G
 
 	if (type == "base64") {
 		StreamBufferToBase64(req, *buf);
+	} else if (type == "binary") {
+		SendBufferBinary(req, *buf);
 	} else if (type == "uri") {
 		StreamBufferToDataURI(req, *buf, includeAlpha, stackWidth);
 	} else {
@@ -255,7 +274,7 @@ static void GenericStreamBuffer(DebuggerRequest &req, std::function<bool(const G
 // Retrieve a screenshot (gpu.buffer.screenshot)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: 'uri', 'base64', or 'binary' (like 'base64', but the data follows as a binary frame.)
 //  - alpha: boolean to include the alpha channel for 'uri' type (not normally useful for screenshots.)
 //
 // Response (same event name) for 'uri' type:
@@ -278,7 +297,7 @@ void WebSocketGPUBufferScreenshot(DebuggerRequest &req) {
 // Retrieve current color render buffer (gpu.buffer.renderColor)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: 'uri', 'base64', or 'binary' (like 'base64', but the data follows as a binary frame.)
 //  - alpha: boolean to include the alpha channel for 'uri' type.
 //
 // Response (same event name) for 'uri' type:
@@ -301,7 +320,7 @@ void WebSocketGPUBufferRenderColor(DebuggerRequest &req) {
 // Retrieve current depth render buffer (gpu.buffer.renderDepth)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: 'uri', 'base64', or 'binary' (like 'base64', but the data follows as a binary frame.)
 //  - alpha: true to use alpha to encode depth, otherwise red for 'uri' type.
 //
 // Response (same event name) for 'uri' type:
@@ -324,7 +343,7 @@ void WebSocketGPUBufferRenderDepth(DebuggerRequest &req) {
 // Retrieve current stencil render buffer (gpu.buffer.renderStencil)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: 'uri', 'base64', or 'binary' (like 'base64', but the data follows as a binary frame.)
 //  - alpha: true to use alpha to encode stencil, otherwise red for 'uri' type.
 //
 // Response (same event name) for 'uri' type:
@@ -347,7 +366,7 @@ void WebSocketGPUBufferRenderStencil(DebuggerRequest &req) {
 // Retrieve current texture (gpu.buffer.texture)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: 'uri', 'base64', or 'binary' (like 'base64', but the data follows as a binary frame.)
 //  - alpha: boolean to include the alpha channel for 'uri' type.
 //  - level: texture mip level, default 0.
 //
@@ -375,7 +394,7 @@ void WebSocketGPUBufferTexture(DebuggerRequest &req) {
 // Retrieve current CLUT (gpu.buffer.clut)
 //
 // Parameters:
-//  - type: either 'uri' or 'base64'.
+//  - type: 'uri', 'base64', or 'binary' (like 'base64', but the data follows as a binary frame.)
 //  - alpha: boolean to include the alpha channel for 'uri' type.
 //  - stackWidth: forced width for 'uri' type (increases height.)
 //
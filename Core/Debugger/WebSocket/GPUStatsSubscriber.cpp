@@ -20,12 +20,19 @@
 #include "Core/Debugger/WebSocket/GPUStatsSubscriber.h"
 #include "Core/HW/Display.h"
 #include "Core/System.h"
+#include "GPU/GPU.h"
+#include "GPU/GPUInterface.h"
+#include "GPU/Debugger/DrawProfile.h"
 
 struct CollectedStats {
 	float vps;
 	float fps;
 	float actual_fps;
 	char statbuf[4096];
+	std::string gpuProfile;
+	GPUCacheStatistics cache;
+	double msTextureHashing;
+	double msTextureDecoding;
 	std::vector<double> frameTimes;
 	std::vector<double> sleepTimes;
 	int frameTimePos;
@@ -50,6 +57,12 @@ struct DebuggerGPUStatsEvent {
 		j.writeFloat("target", 60.0 / 1.001);
 		j.pop();
 		j.writeString("info", s.statbuf);
+		j.writeString("gpuProfile", s.gpuProfile);
+		j.pushDict("caches");
+		s.cache.WriteJson(j);
+		j.writeFloat("textureHashingMs", s.msTextureHashing * 1000.0);
+		j.writeFloat("textureDecodingMs", s.msTextureDecoding * 1000.0);
+		j.pop();
 		j.pushDict("timing");
 		j.pushArray("frames");
 		for (double t : s.frameTimes)
@@ -66,11 +79,44 @@ struct DebuggerGPUStatsEvent {
 	}
 };
 
+struct DebuggerGPUDrawProfileEvent {
+	const std::vector<GPUDrawProfile::DrawCost> &draws;
+	const std::string &ticket;
+
+	operator std::string() {
+		JsonWriter j;
+		j.begin();
+		j.writeString("event", "gpu.stats.profileFrame");
+		if (!ticket.empty())
+			j.writeRaw("ticket", ticket);
+		j.pushArray("draws");
+		for (const auto &draw : draws) {
+			j.pushDict();
+			j.writeUint("address", draw.pc);
+			j.writeUint("op", draw.op);
+			j.writeInt("vertexCount", draw.vertexCount);
+			j.writeUint("framebuf", draw.framebuf);
+			j.writeUint("texaddr", draw.texaddr);
+			j.writeInt("stepId", draw.stepId);
+			j.writeFloat("submitMs", draw.times[(int)GPUDrawProfile::Cost::SUBMIT] * 1000.0);
+			j.writeFloat("vertexDecodeMs", draw.times[(int)GPUDrawProfile::Cost::DECODE] * 1000.0);
+			j.writeFloat("textureMs", draw.times[(int)GPUDrawProfile::Cost::TEXTURE] * 1000.0);
+			j.writeFloat("stateMs", draw.StateTime() * 1000.0);
+			j.writeFloat("totalMs", draw.TotalTime() * 1000.0);
+			j.pop();
+		}
+		j.pop();
+		j.end();
+		return j.str();
+	}
+};
+
 struct WebSocketGPUStatsState : public DebuggerSubscriber {
 	WebSocketGPUStatsState();
 	~WebSocketGPUStatsState() override;
 	void Get(DebuggerRequest &req);
 	void Feed(DebuggerRequest &req);
+	void ProfileFrame(DebuggerRequest &req);
 
 	void Broadcast(net::WebSocketServer *ws) override;
 
@@ -85,12 +131,17 @@ struct WebSocketGPUStatsState : public DebuggerSubscriber {
 	std::string lastTicket_;
 	std::mutex pendingLock_;
 	std::vector<CollectedStats> pendingStats_;
+
+	bool profilePending_ = false;
+	int profileFrameCount_ = 0;
+	std::string profileTicket_;
 };
 
 DebuggerSubscriber *WebSocketGPUStatsInit(DebuggerEventHandlerMap &map) {
 	auto p = new WebSocketGPUStatsState();
 	map["gpu.stats.get"] = std::bind(&WebSocketGPUStatsState::Get, p, std::placeholders::_1);
 	map["gpu.stats.feed"] = std::bind(&WebSocketGPUStatsState::Feed, p, std::placeholders::_1);
+	map["gpu.stats.profileFrame"] = std::bind(&WebSocketGPUStatsState::ProfileFrame, p, std::placeholders::_1);
 
 	return p;
 }
@@ -121,6 +172,11 @@ void WebSocketGPUStatsState::FlipListener() {
 
 	__DisplayGetFPS(&stats.vps, &stats.fps, &stats.actual_fps);
 	__DisplayGetDebugStats(stats.statbuf, sizeof(stats.statbuf));
+	if (gpu)
+		stats.gpuProfile = gpu->GetGpuProfileString();
+	stats.cache = gpuStats.cache;
+	stats.msTextureHashing = gpuStats.msTextureHashing;
+	stats.msTextureDecoding = gpuStats.msTextureDecoding;
 
 	int valid;
 	double *sleepHistory;
@@ -183,8 +239,50 @@ void WebSocketGPUStatsState::Feed(DebuggerRequest &req) {
 	}
 }
 
+// Profile the CPU cost of each draw in the next frame (gpu.stats.profileFrame)
+//
+// No parameters.
+//
+// Response (same event name):
+//  - draws: array of objects, in submission order, each with properties:
+//     - address: number, address of the PRIM command in the display list.
+//     - op: number, the PRIM command.
+//     - vertexCount: number of vertices drawn.
+//     - framebuf: number, address of the render target.
+//     - texaddr: number, address of the texture or 0 if texturing was off.
+//     - stepId: number, host render pass (matches the pass order of gpuProfile in gpu.stats.get.)
+//     - submitMs: time spent processing the PRIM before flushing.
+//     - vertexDecodeMs: time spent decoding vertices.
+//     - textureMs: time spent looking up, hashing and decoding textures.
+//     - stateMs: remaining flush time, mostly shader and pipeline state.
+//     - totalMs: submitMs plus the whole flush.
+//
+// Note: each draw is flushed separately while profiling, so the frame itself is slower than usual.
+// Note: the response is sent once the frame completes.
+void WebSocketGPUStatsState::ProfileFrame(DebuggerRequest &req) {
+	if (!PSP_IsInited())
+		return req.Fail("CPU not started");
+
+	std::lock_guard<std::mutex> guard(pendingLock_);
+	if (profilePending_ || !GPUDrawProfile::Activate())
+		return req.Fail("Frame profile already in progress");
+
+	profilePending_ = true;
+	profileFrameCount_ = GPUDrawProfile::GetLastFrame(nullptr);
+	const JsonNode *value = req.data.get("ticket");
+	profileTicket_ = value ? json_stringify(value) : "";
+}
+
 void WebSocketGPUStatsState::Broadcast(net::WebSocketServer *ws) {
 	std::lock_guard<std::mutex> guard(pendingLock_);
+	if (profilePending_ && GPUDrawProfile::GetLastFrame(nullptr) != profileFrameCount_) {
+		std::vector<GPUDrawProfile::DrawCost> draws;
+		GPUDrawProfile::GetLastFrame(&draws);
+		ws->Send(DebuggerGPUDrawProfileEvent{ draws, profileTicket_ });
+		profilePending_ = false;
+		profileTicket_.clear();
+	}
+
 	if (lastTicket_.empty() && !sendFeed_) {
 		pendingStats_.clear();
 		return;
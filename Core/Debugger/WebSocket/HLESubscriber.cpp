@@ -22,13 +22,28 @@
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/Debugger/WebSocket/HLESubscriber.h"
 #include "Core/Debugger/WebSocket/WebSocketUtils.h"
+#include "Core/HLE/HLE.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/MIPSStackWalk.h"
 #include "Core/HLE/sceKernelThread.h"
 #include "Core/Reporting.h"
+#include "Core/System.h"
+
+struct WebSocketHLEState : public DebuggerSubscriber {
+	~WebSocketHLEState() {
+		if (statsForced_)
+			Core_ForceDebugStats(false);
+	}
+
+	void SyscallStats(DebuggerRequest &req);
+
+protected:
+	bool statsForced_ = false;
+};
 
 DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
+	auto p = new WebSocketHLEState();
 	map["hle.thread.list"] = &WebSocketHLEThreadList;
 	map["hle.thread.wake"] = &WebSocketHLEThreadWake;
 	map["hle.thread.stop"] = &WebSocketHLEThreadStop;
@@ -38,8 +53,9 @@ DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
 	map["hle.func.rename"] = &WebSocketHLEFuncRename;
 	map["hle.module.list"] = &WebSocketHLEModuleList;
 	map["hle.backtrace"] = &WebSocketHLEBacktrace;
+	map["hle.syscall.stats"] = std::bind(&WebSocketHLEState::SyscallStats, p, std::placeholders::_1);
 
-	return nullptr;
+	return p;
 }
 
 // List all current HLE threads (hle.thread.list)
@@ -494,3 +510,46 @@ void WebSocketHLEBacktrace(DebuggerRequest &req) {
 	}
 	json.pop();
 }
+
+// Get host time spent in each HLE function (hle.syscall.stats)
+//
+// Parameters:
+//  - enable: optional boolean, true to start collecting stats, false to stop.
+//  - reset: optional boolean, pass true to clear the stats after this response.
+//
+// Response (same event name):
+//  - functions: array of objects, most time first, each with properties:
+//     - module: string, name of the HLE module.
+//     - name: string, name of the function.
+//     - calls: unsigned integer, number of calls.
+//     - time: number, total host microseconds spent in the function.
+//
+// Note: stats are only collected while enabled here or debug stats are shown, which slows down syscalls.
+void WebSocketHLEState::SyscallStats(DebuggerRequest &req) {
+	bool enable = statsForced_;
+	if (!req.ParamBool("enable", &enable, DebuggerParamType::OPTIONAL))
+		return;
+	bool reset = false;
+	if (!req.ParamBool("reset", &reset, DebuggerParamType::OPTIONAL))
+		return;
+
+	if (statsForced_ != enable) {
+		Core_ForceDebugStats(enable);
+		statsForced_ = enable;
+	}
+
+	JsonWriter &json = req.Respond();
+	json.pushArray("functions");
+	for (const HLEFunctionStats &s : hleGetFunctionStats()) {
+		json.pushDict();
+		json.writeString("module", s.module);
+		json.writeString("name", s.name);
+		json.writeUint("calls", (uint32_t)std::min(s.calls, (u64)0xFFFFFFFF));
+		json.writeFloat("time", s.seconds * 1000000.0);
+		json.pop();
+	}
+	json.pop();
+
+	if (reset)
+		hleResetFunctionStats();
+}
@@ -0,0 +1,204 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Debugger/SymbolMap.h"
+#include "Core/Debugger/WebSocket/JitProfileSubscriber.h"
+#include "Core/Debugger/WebSocket/WebSocketUtils.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "Core/MIPS/MIPSDebugInterface.h"
+
+DebuggerSubscriber *WebSocketJitProfileInit(DebuggerEventHandlerMap &map) {
+	// No need to bind or alloc state, the counts live in the jit.
+	map["jit.profile.start"] = &WebSocketJitProfileStart;
+	map["jit.profile.stop"] = &WebSocketJitProfileStop;
+	map["jit.profile.get"] = &WebSocketJitProfileGet;
+
+	return nullptr;
+}
+
+// The jit may clear or grow its block list while running, so pause like breakpoint updates do.
+template <typename F>
+static void WithCPUPaused(const char *reason, F func) {
+	bool resume = false;
+	if (!Core_IsStepping()) {
+		Core_EnableStepping(true, reason, 0);
+		Core_WaitInactive(200);
+		resume = true;
+	}
+
+	{
+		std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+		func();
+	}
+
+	if (resume)
+		Core_EnableStepping(false);
+}
+
+static void SetProfiling(DebuggerRequest &req, bool enable) {
+	if (!currentDebugMIPS->isAlive()) {
+		return req.Fail("CPU not started");
+	}
+
+	bool supported = false;
+	WithCPUPaused("jit.profile", [&] {
+		if (MIPSComp::jit)
+			supported = MIPSComp::jit->SetBlockProfiling(enable);
+	});
+	if (!supported) {
+		return req.Fail("Current CPU core does not support block profiling, use an IR core");
+	}
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("enabled", enable);
+}
+
+// Start counting entries and cycles per block (jit.profile.start)
+//
+// No parameters.
+//
+// Response (same event name):
+//  - enabled: boolean, always true.
+//
+// Note: only the IR cores support this.  The x64 IR jit interprets all blocks while profiling.
+// Counts are reset when starting, and whenever the jit cache is cleared.
+void WebSocketJitProfileStart(DebuggerRequest &req) {
+	SetProfiling(req, true);
+}
+
+// Stop counting entries and cycles per block (jit.profile.stop)
+//
+// No parameters.
+//
+// Response (same event name):
+//  - enabled: boolean, always false.
+//
+// Note: the counts so far are kept, and can still be retrieved with jit.profile.get.
+void WebSocketJitProfileStop(DebuggerRequest &req) {
+	SetProfiling(req, false);
+}
+
+// Retrieve the hottest blocks and functions (jit.profile.get)
+//
+// Parameters:
+//  - limit: optional number of blocks and functions to return, default 100.
+//
+// Response (same event name):
+//  - enabled: boolean, whether counts are still being collected.
+//  - blocks: array of objects, sorted by cycles, most first:
+//     - address: number, start address of the block.
+//     - size: number of bytes of MIPS code in the block.
+//     - entries: number of times the block was run.
+//     - cycles: estimated CPU cycles spent in the block.
+//     - function: start address of the containing function, or null if unknown.
+//     - name: string name of the containing function, or null if unknown.
+//  - functions: array of objects, sorted by cycles, most first:
+//     - address: number, start address of the function.
+//     - name: string name of the function.
+//     - entries: number of block entries within the function.
+//     - cycles: estimated CPU cycles spent in the function.
+//
+// Note: entries and cycles may be very large, and are sent as floating point.
+void WebSocketJitProfileGet(DebuggerRequest &req) {
+	if (!currentDebugMIPS->isAlive()) {
+		return req.Fail("CPU not started");
+	}
+
+	uint32_t limit = 100;
+	if (!req.ParamU32("limit", &limit, false, DebuggerParamType::OPTIONAL))
+		return;
+
+	bool enabled = false;
+	std::vector<MIPSComp::JitBlockProfile> blocks;
+	WithCPUPaused("jit.profile", [&] {
+		if (MIPSComp::jit) {
+			enabled = MIPSComp::jit->IsBlockProfiling();
+			MIPSComp::jit->GetBlockProfile(blocks);
+		}
+	});
+
+	std::sort(blocks.begin(), blocks.end(), [](const MIPSComp::JitBlockProfile &a, const MIPSComp::JitBlockProfile &b) {
+		return a.cycles > b.cycles;
+	});
+
+	struct FunctionProfile {
+		u32 address;
+		u64 entries;
+		u64 cycles;
+	};
+	std::map<u32, FunctionProfile> byFunction;
+	std::vector<u32> blockFunctions;
+	blockFunctions.reserve(blocks.size());
+	for (const auto &block : blocks) {
+		u32 funcStart = g_symbolMap->GetFunctionStart(block.address);
+		blockFunctions.push_back(funcStart);
+		if (funcStart == SymbolMap::INVALID_ADDRESS)
+			continue;
+
+		FunctionProfile &func = byFunction[funcStart];
+		func.address = funcStart;
+		func.entries += block.entries;
+		func.cycles += block.cycles;
+	}
+
+	std::vector<FunctionProfile> functions;
+	functions.reserve(byFunction.size());
+	for (const auto &it : byFunction)
+		functions.push_back(it.second);
+	std::sort(functions.begin(), functions.end(), [](const FunctionProfile &a, const FunctionProfile &b) {
+		return a.cycles > b.cycles;
+	});
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("enabled", enabled);
+	json.pushArray("blocks");
+	for (size_t i = 0; i < blocks.size() && i < limit; ++i) {
+		const auto &block = blocks[i];
+		json.pushDict();
+		json.writeUint("address", block.address);
+		json.writeUint("size", block.size);
+		json.writeFloat("entries", (double)block.entries);
+		json.writeFloat("cycles", (double)block.cycles);
+		if (blockFunctions[i] != SymbolMap::INVALID_ADDRESS) {
+			json.writeUint("function", blockFunctions[i]);
+			json.writeString("name", g_symbolMap->GetLabelString(blockFunctions[i]));
+		} else {
+			json.writeNull("function");
+			json.writeNull("name");
+		}
+		json.pop();
+	}
+	json.pop();
+
+	json.pushArray("functions");
+	for (size_t i = 0; i < functions.size() && i < limit; ++i) {
+		const auto &func = functions[i];
+		json.pushDict();
+		json.writeUint("address", func.address);
+		json.writeString("name", g_symbolMap->GetLabelString(func.address));
+		json.writeFloat("entries", (double)func.entries);
+		json.writeFloat("cycles", (double)func.cycles);
+		json.pop();
+	}
+	json.pop();
+}
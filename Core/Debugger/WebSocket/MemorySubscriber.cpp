@@ -172,9 +172,11 @@ void WebSocketMemoryReadU32(DebuggerRequest &req) {
 //  - address: unsigned integer address for the start of the memory range.
 //  - size: unsigned integer specifying size of memory range.
 //  - replacements: optional, false to ignore PPSSPP replacements in MIPS code.
+//  - binary: optional, true to send the data as a binary frame right after the response.
 //
 // Response (same event name):
-//  - base64: base64 encode of binary data.
+//  - base64: base64 encode of binary data (omitted with binary.)
+//  - size: number of bytes in the following binary frame (only with binary.)
 void WebSocketMemoryRead(DebuggerRequest &req) {
 	uint32_t addr;
 	if (!req.ParamU32("address", &addr))
@@ -185,6 +187,9 @@ void WebSocketMemoryRead(DebuggerRequest &req) {
 	bool replacements = true;
 	if (!req.ParamBool("replacements", &replacements, DebuggerParamType::OPTIONAL))
 		return;
+	bool binary = false;
+	if (!req.ParamBool("binary", &binary, DebuggerParamType::OPTIONAL))
+		return;
 
 	auto memLock = LockMemoryAndCPU(addr, replacements);
 	if (!currentDebugMIPS->isAlive() || !Memory::IsActive())
@@ -196,6 +201,14 @@ void WebSocketMemoryRead(DebuggerRequest &req) {
 		return req.Fail("Invalid size");
 
 	JsonWriter &json = req.Respond();
+	if (binary) {
+		// Skips encoding entirely, which matters for tools polling memory every frame.
+		json.writeUint("size", size);
+		req.Finish();
+		req.ws->SendBinary(Memory::GetPointerUnchecked(addr), size);
+		return;
+	}
+
 	// Start a value without any actual data yet...
 	json.writeRaw("base64", "");
 	req.Flush();
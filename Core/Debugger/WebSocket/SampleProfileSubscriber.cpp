@@ -0,0 +1,110 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <vector>
+
+#include "Core/Debugger/SampleProfiler.h"
+#include "Core/Debugger/SymbolMap.h"
+#include "Core/Debugger/WebSocket/SampleProfileSubscriber.h"
+#include "Core/Debugger/WebSocket/WebSocketUtils.h"
+
+DebuggerSubscriber *WebSocketSampleProfileInit(DebuggerEventHandlerMap &map) {
+	// No need to bind or alloc state, the samples live in SampleProfiler.
+	map["cpu.profile.start"] = &WebSocketSampleProfileStart;
+	map["cpu.profile.stop"] = &WebSocketSampleProfileStop;
+	map["cpu.profile.get"] = &WebSocketSampleProfileGet;
+
+	return nullptr;
+}
+
+// Start sampling the CPU's PC (cpu.profile.start)
+//
+// Parameters:
+//  - interval: optional number of microseconds between samples, default 1000.
+//
+// Response (same event name):
+//  - enabled: boolean, always true.
+//
+// Note: previous samples are discarded.  Samples are only taken while the CPU is running.
+void WebSocketSampleProfileStart(DebuggerRequest &req) {
+	uint32_t interval = 1000;
+	if (!req.ParamU32("interval", &interval, false, DebuggerParamType::OPTIONAL))
+		return;
+
+	SampleProfiler::Start((int)interval);
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("enabled", true);
+}
+
+// Stop sampling the CPU's PC (cpu.profile.stop)
+//
+// No parameters.
+//
+// Response (same event name):
+//  - enabled: boolean, always false.
+//
+// Note: the samples so far are kept, and can still be retrieved with cpu.profile.get.
+void WebSocketSampleProfileStop(DebuggerRequest &req) {
+	SampleProfiler::Stop();
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("enabled", false);
+}
+
+// Retrieve the functions with the most samples (cpu.profile.get)
+//
+// Parameters:
+//  - limit: optional number of functions to return, default 100.
+//
+// Response (same event name):
+//  - enabled: boolean, whether samples are still being taken.
+//  - samples: total number of samples.
+//  - hostWaitSamples: samples taken while sleeping for frame timing, not in any function.
+//  - functions: array of objects, sorted by samples, most first:
+//     - address: number, start address of the function, or null for code outside known functions.
+//     - name: string name of the function.
+//     - samples: number of samples within the function.
+//
+// Note: sample counts may be very large, and are sent as floating point.
+void WebSocketSampleProfileGet(DebuggerRequest &req) {
+	uint32_t limit = 100;
+	if (!req.ParamU32("limit", &limit, false, DebuggerParamType::OPTIONAL))
+		return;
+
+	uint64_t total = 0;
+	uint64_t hostWait = 0;
+	std::vector<SampleProfiler::FunctionSamples> functions = SampleProfiler::GetFunctionProfile(&total, &hostWait);
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("enabled", SampleProfiler::IsRunning());
+	json.writeFloat("samples", (double)total);
+	json.writeFloat("hostWaitSamples", (double)hostWait);
+	json.pushArray("functions");
+	for (size_t i = 0; i < functions.size() && i < limit; ++i) {
+		const auto &func = functions[i];
+		json.pushDict();
+		if (func.address != SymbolMap::INVALID_ADDRESS)
+			json.writeUint("address", func.address);
+		else
+			json.writeNull("address");
+		json.writeString("name", func.name);
+		json.writeFloat("samples", (double)func.samples);
+		json.pop();
+	}
+	json.pop();
+}
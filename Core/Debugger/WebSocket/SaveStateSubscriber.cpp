@@ -0,0 +1,107 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <atomic>
+#include <memory>
+#include "Core/Debugger/WebSocket/SaveStateSubscriber.h"
+#include "Core/Debugger/WebSocket/WebSocketUtils.h"
+#include "Core/SaveState.h"
+#include "Core/System.h"
+
+struct WebSocketSaveStateState : public DebuggerSubscriber {
+	void Profile(DebuggerRequest &req);
+
+	void Broadcast(net::WebSocketServer *ws) override;
+
+protected:
+	// Set from the emu thread, which might finish after we're gone.
+	std::shared_ptr<std::atomic<bool>> done_;
+	std::string lastTicket_;
+};
+
+DebuggerSubscriber *WebSocketSaveStateInit(DebuggerEventHandlerMap &map) {
+	auto p = new WebSocketSaveStateState();
+	map["savestate.profile"] = std::bind(&WebSocketSaveStateState::Profile, p, std::placeholders::_1);
+
+	return p;
+}
+
+// Profile savestate sections (savestate.profile)
+//
+// Saves a state in memory, measuring each section passed to PointerWrap::Section() in DoState.
+//
+// No parameters.
+//
+// Response (same event name):
+//  - size: total state size in bytes.
+//  - sections: array of objects in save order, each with:
+//     - title: section name.
+//     - depth: nesting level, 0 for top level.  Nested sections are included in their parent.
+//     - size: bytes, including nested sections.
+//     - time: seconds taken to save, including nested sections.
+//
+// Note: the response is sent once the game runs its next frame.
+void WebSocketSaveStateState::Profile(DebuggerRequest &req) {
+	if (!PSP_IsInited())
+		return req.Fail("Game not running");
+	if (done_ && !*done_)
+		return req.Fail("Profile already in progress");
+
+	std::shared_ptr<std::atomic<bool>> done = std::make_shared<std::atomic<bool>>(false);
+	done_ = done;
+	SaveState::Profile([done](SaveState::Status status, const std::string &message, void *) {
+		*done = true;
+	});
+
+	const JsonNode *value = req.data.get("ticket");
+	lastTicket_ = value ? json_stringify(value) : "";
+}
+
+// This handles the asynchronous savestate.profile response.
+void WebSocketSaveStateState::Broadcast(net::WebSocketServer *ws) {
+	if (!done_ || !*done_)
+		return;
+	done_.reset();
+
+	std::vector<PointerWrap::SectionStats> sections = SaveState::GetLastProfile();
+	size_t total = 0;
+	for (const auto &section : sections) {
+		if (section.depth == 0)
+			total += section.size;
+	}
+
+	JsonWriter j;
+	j.begin();
+	j.writeString("event", "savestate.profile");
+	if (!lastTicket_.empty())
+		j.writeRaw("ticket", lastTicket_);
+	j.writeFloat("size", (double)total);
+	j.pushArray("sections");
+	for (const auto &section : sections) {
+		j.pushDict();
+		j.writeString("title", section.title);
+		j.writeInt("depth", section.depth);
+		j.writeFloat("size", (double)section.size);
+		j.writeFloat("time", section.seconds);
+		j.pop();
+	}
+	j.pop();
+	j.end();
+	ws->Send(j.str());
+
+	lastTicket_.clear();
+}
@@ -95,6 +95,37 @@ namespace
 		return result == dataSize;
 	}
 
+	// Writes to a temporary file first and renames it into place, so a crash or full card
+	// mid-write leaves the previous save intact rather than a truncated one.
+	bool WritePSPFileAtomic(const std::string &filename, u8 *data, SceSize dataSize)
+	{
+		std::string tempFilename = filename + ".tmp";
+		if (!WritePSPFile(tempFilename, data, dataSize)) {
+			pspFileSystem.RemoveFile(tempFilename);
+			return false;
+		}
+
+		if (pspFileSystem.RenameFile(tempFilename, filename) == 0)
+			return true;
+		// Windows and Android storage won't rename over an existing file.  If we die between
+		// these two steps, RecoverPSPFile() picks up the complete temp file on the next load.
+		pspFileSystem.RemoveFile(filename);
+		if (pspFileSystem.RenameFile(tempFilename, filename) == 0)
+			return true;
+
+		pspFileSystem.RemoveFile(tempFilename);
+		return false;
+	}
+
+	void RecoverPSPFile(const std::string &filename)
+	{
+		std::string tempFilename = filename + ".tmp";
+		if (!pspFileSystem.GetFileInfo(filename).exists && pspFileSystem.GetFileInfo(tempFilename).exists) {
+			WARN_LOG(SCEUTILITY, "Recovering interrupted savedata write: %s", filename.c_str());
+			pspFileSystem.RenameFile(tempFilename, filename);
+		}
+	}
+
 	bool PSPMatch(std::string text, std::string regexp)
 	{
 		if(text.empty() && regexp.empty())
@@ -514,7 +545,7 @@ int SavedataParam::Save(SceUtilitySavedataParam* param, const std::string &saveD
 		if(offset >= 0)
 			UpdateHash(sfoData, (int)sfoSize, offset, DetermineCryptMode(param));
 	}
-	WritePSPFile(sfopath, sfoData, (SceSize)sfoSize);
+	WritePSPFileAtomic(sfopath, sfoData, (SceSize)sfoSize);
 	delete[] sfoData;
 
 	if(param->dataBuf.IsValid())	// Can launch save without save data in mode 13
@@ -545,7 +576,7 @@ int SavedataParam::Save(SceUtilitySavedataParam* param, const std::string &saveD
 		if (fileName == "") {
 			delete[] cryptedData;
 		} else {
-			if (!WritePSPFile(filePath, data_, saveSize)) {
+			if (!WritePSPFileAtomic(filePath, data_, saveSize)) {
 				ERROR_LOG(SCEUTILITY, "Error writing file %s", filePath.c_str());
 				delete[] cryptedData;
 				return SCE_UTILITY_SAVEDATA_ERROR_SAVE_MS_NOSPACE;
@@ -651,6 +682,8 @@ int SavedataParam::LoadSaveData(SceUtilitySavedataParam *param, const std::strin
 	INFO_LOG(SCEUTILITY, "Loading file with size %u in %s", param->dataBufSize, filePath.c_str());
 	u8 *saveData = nullptr;
 	int saveSize = -1;
+	RecoverPSPFile(filePath);
+	RecoverPSPFile(dirPath + "/" + SFO_FILENAME);
 	if (!ReadPSPFile(filePath, &saveData, saveSize, &readSize)) {
 		ERROR_LOG(SCEUTILITY,"Error reading file %s",filePath.c_str());
 		return SCE_UTILITY_SAVEDATA_ERROR_LOAD_NO_DATA;
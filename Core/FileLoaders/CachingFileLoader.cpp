@@ -93,7 +93,7 @@ size_t CachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flag
 			}
 		}
 
-		StartReadAhead(absolutePos + readSize);
+		StartReadAhead(absolutePos + readSize, UpdateStreams(absolutePos, readSize));
 	}
 
 	return readSize;
@@ -109,6 +109,10 @@ void CachingFileLoader::ShutdownCache() {
 	// TODO: Maybe add some hint that deletion is coming soon?
 	// We can't delete while the thread is running, so have to wait.
 	// This should only happen from the menu.
+	{
+		std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+		aheadBlocks_ = 0;
+	}
 	while (aheadThreadRunning_) {
 		sleep_ms(1);
 	}
@@ -252,33 +256,82 @@ bool CachingFileLoader::MakeCacheSpaceFor(size_t blocks, bool readingAhead) {
 	return true;
 }
 
-void CachingFileLoader::StartReadAhead(s64 pos) {
+size_t CachingFileLoader::UpdateStreams(s64 pos, size_t bytes) {
 	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+
+	// Allow a little slack both ways, streams often reread a sector or skip a padding one.
+	StreamInfo *stream = nullptr;
+	for (StreamInfo &s : streams_) {
+		if (s.nextPos >= 0 && pos >= s.nextPos - BLOCK_SIZE && pos <= s.nextPos + BLOCK_SIZE) {
+			stream = &s;
+			break;
+		}
+	}
+
+	if (stream) {
+		stream->streamed += std::max((s64)0, pos + (s64)bytes - stream->nextPos);
+	} else {
+		// A new stream (or a random read) replaces the one unused the longest.
+		stream = &streams_[0];
+		for (StreamInfo &s : streams_) {
+			if (s.lastUse < stream->lastUse)
+				stream = &s;
+		}
+		stream->streamed = bytes;
+	}
+	stream->nextPos = pos + bytes;
+	stream->lastUse = ++streamCounter_;
+
+	// Stay about twice as far ahead as it has read so far.
+	size_t blocks = (size_t)((stream->streamed * 2) >> BLOCK_SHIFT);
+	return std::max((size_t)BLOCK_READAHEAD, std::min(blocks, (size_t)MAX_BLOCKS_READAHEAD));
+}
+
+void CachingFileLoader::StartReadAhead(s64 pos, size_t blocks) {
+	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+	aheadPos_ = pos;
+	aheadBlocks_ = blocks;
 	if (aheadThreadRunning_) {
-		// Already going.
+		// Already going, it'll pick this up next.
 		return;
 	}
 	if (cacheSize_ + BLOCK_READAHEAD > MAX_BLOCKS_CACHED) {
 		// Not enough space to readahead.
+		aheadBlocks_ = 0;
 		return;
 	}
 
 	aheadThreadRunning_ = true;
 	if (aheadThread_.joinable())
 		aheadThread_.join();
-	aheadThread_ = std::thread([this, pos] {
+	aheadThread_ = std::thread([this] {
 		SetCurrentThreadName("FileLoaderReadAhead");
 
 		std::unique_lock<std::recursive_mutex> guard(blocksMutex_);
-		s64 cacheStartPos = pos >> BLOCK_SHIFT;
-		s64 cacheEndPos = cacheStartPos + BLOCK_READAHEAD - 1;
+		const s64 fileBlocks = (filesize_ + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+		while (aheadBlocks_ != 0) {
+			s64 cacheStartPos = aheadPos_ >> BLOCK_SHIFT;
+			s64 cacheEndPos = std::min(cacheStartPos + (s64)aheadBlocks_, fileBlocks);
+			aheadBlocks_ = 0;
+
+			// Fetch each missing run with a single backend read, which matters most over HTTP.
+			for (s64 i = cacheStartPos; i < cacheEndPos; ) {
+				if (blocks_.find(i) != blocks_.end()) {
+					++i;
+					continue;
+				}
+				s64 run = 1;
+				while (i + run < cacheEndPos && run < MAX_BLOCKS_PER_READ && blocks_.find(i + run) == blocks_.end())
+					++run;
 
-		for (s64 i = cacheStartPos; i <= cacheEndPos; ++i) {
-			auto block = blocks_.find(i);
-			if (block == blocks_.end()) {
 				guard.unlock();
-				SaveIntoCache(i << BLOCK_SHIFT, BLOCK_SIZE * BLOCK_READAHEAD, Flags::NONE, true);
-				break;
+				SaveIntoCache(i << BLOCK_SHIFT, (size_t)(run << BLOCK_SHIFT), Flags::NONE, true);
+				guard.lock();
+				i += run;
+
+				// Give up on this window if a newer one came in, or the cache is full.
+				if (aheadBlocks_ != 0 || cacheSize_ + run > MAX_BLOCKS_CACHED)
+					break;
 			}
 		}
 
@@ -47,7 +47,9 @@ class CachingFileLoader : public ProxiedFileLoader {
 	// Guaranteed to read at least one block into the cache.
 	void SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool readingAhead = false);
 	bool MakeCacheSpaceFor(size_t blocks, bool readingAhead);
-	void StartReadAhead(s64 pos);
+	// Returns how many blocks to read ahead after this read.
+	size_t UpdateStreams(s64 pos, size_t bytes);
+	void StartReadAhead(s64 pos, size_t blocks);
 
 	enum {
 		BLOCK_SIZE = 65536,
@@ -55,6 +57,16 @@ class CachingFileLoader : public ProxiedFileLoader {
 		MAX_BLOCKS_PER_READ = 16,
 		MAX_BLOCKS_CACHED = 4096, // 256 MB
 		BLOCK_READAHEAD = 4,
+		MAX_BLOCKS_READAHEAD = 64, // 4 MB
+		MAX_STREAMS = 4,
+	};
+
+	// Reads that continue where an earlier one ended, such as an FMV or audio stream. Several can
+	// be interleaved, and the longer one keeps going the further ahead we read for it.
+	struct StreamInfo {
+		s64 nextPos = -1;
+		s64 streamed = 0;
+		u64 lastUse = 0;
 	};
 
 	s64 filesize_ = 0;
@@ -76,6 +88,11 @@ class CachingFileLoader : public ProxiedFileLoader {
 
 	std::map<s64, BlockInfo> blocks_;
 	std::recursive_mutex blocksMutex_;
+	StreamInfo streams_[MAX_STREAMS];
+	u64 streamCounter_ = 0;
+	// The latest read-ahead request, picked up by the thread when it's done with the last.
+	s64 aheadPos_ = 0;
+	size_t aheadBlocks_ = 0;
 	bool aheadThreadRunning_ = false;
 	std::thread aheadThread_;
 	std::once_flag preparedFlag_;
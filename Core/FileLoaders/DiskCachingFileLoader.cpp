@@ -33,6 +33,8 @@
 #include "Core/FileLoaders/DiskCachingFileLoader.h"
 #include "Core/System.h"
 
+#include <zstd.h>
+
 #if PPSSPP_PLATFORM(UWP)
 #include <fileapifromapp.h>
 #endif
@@ -176,6 +178,9 @@ void DiskCachingFileLoaderCache::InitCache(const Path &filename) {
 	flags_ = 0;
 	generation_ = 0;
 
+	cctx_ = ZSTD_createCCtx();
+	dctx_ = ZSTD_createDCtx();
+
 	const Path cacheFilePath = MakeCacheFilePath(filename);
 	bool fileLoaded = LoadCacheFile(cacheFilePath);
 
@@ -218,8 +223,18 @@ void DiskCachingFileLoaderCache::ShutdownCache() {
 		CloseFileHandle();
 	}
 
+	if (cctx_)
+		ZSTD_freeCCtx(cctx_);
+	if (dctx_)
+		ZSTD_freeDCtx(dctx_);
+	cctx_ = nullptr;
+	dctx_ = nullptr;
+
 	index_.clear();
 	blockIndexLookup_.clear();
+	slotUsage_.clear();
+	dirtyIndexes_.clear();
+	decodedIndex_ = INVALID_INDEX;
 	cacheSize_ = 0;
 }
 
@@ -247,7 +262,7 @@ size_t DiskCachingFileLoaderCache::ReadFromCache(s64 pos, size_t bytes, void *da
 		}
 
 		size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
-		if (!ReadBlockData(p + readSize, info, offset, toRead)) {
+		if (!ReadBlockData(p + readSize, (u32)i, offset, toRead)) {
 			return readSize;
 		}
 		readSize += toRead;
@@ -284,7 +299,8 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 		}
 	}
 
-	if (!MakeCacheSpaceFor(blocksToRead) || blocksToRead == 0) {
+	// We don't know how well they'll compress yet, so make room for the worst case.
+	if (!MakeCacheSpaceFor(blocksToRead * SECTORS_PER_BLOCK) || blocksToRead == 0) {
 		return 0;
 	}
 
@@ -296,9 +312,7 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 
 		// Check if it was written while we were busy.  Might happen if we thread.
 		if (info.block == INVALID_BLOCK && readBytes != 0) {
-			info.block = AllocateBlock((u32)cacheStartPos);
-			WriteBlockData(info, buf);
-			WriteIndexData((u32)cacheStartPos, info);
+			StoreBlock((u32)cacheStartPos, buf);
 		}
 
 		size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
@@ -314,10 +328,7 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 			auto &info = index_[cacheStartPos + i];
 			// Check if it was written while we were busy.  Might happen if we thread.
 			if (info.block == INVALID_BLOCK && readBytes != 0) {
-				info.block = AllocateBlock((u32)cacheStartPos + (u32)i);
-				WriteBlockData(info, wholeRead + (i * blockSize_));
-				// TODO: Doing each index together would probably be better.
-				WriteIndexData((u32)cacheStartPos + (u32)i, info);
+				StoreBlock((u32)cacheStartPos + (u32)i, wholeRead + (i * blockSize_));
 			}
 
 			size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
@@ -327,24 +338,31 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 		delete[] wholeRead;
 	}
 
-	cacheSize_ += blocksToRead;
 	++generation_;
 
 	if (generation_ == std::numeric_limits<u16>::max()) {
 		RebalanceGenerations();
 	}
 
+	// All the index changes from this read (including evictions) go out together.
+	FlushIndexData();
+
 	return readSize;
 }
 
-bool DiskCachingFileLoaderCache::MakeCacheSpaceFor(size_t blocks) {
-	size_t goal = (size_t)maxBlocks_ - blocks;
+bool DiskCachingFileLoaderCache::MakeCacheSpaceFor(size_t sectors) {
+	size_t goal = (size_t)maxBlocks_ * SECTORS_PER_BLOCK - sectors;
 
 	while (cacheSize_ > goal) {
 		u16 minGeneration = generation_;
 
 		// We increment the iterator inside because we delete things inside.
 		for (size_t i = 0; i < blockIndexLookup_.size(); ++i) {
+			if ((i % SECTORS_PER_BLOCK) == 0 && slotUsage_[i / SECTORS_PER_BLOCK] == 0) {
+				// Skip the whole empty slot.
+				i += SECTORS_PER_BLOCK - 1;
+				continue;
+			}
 			if (blockIndexLookup_[i] == INVALID_INDEX) {
 				continue;
 			}
@@ -358,14 +376,7 @@ bool DiskCachingFileLoaderCache::MakeCacheSpaceFor(size_t blocks) {
 
 			// 0 means it was never used yet or was the first read (e.g. block descriptor.)
 			if (info.generation == oldestGeneration_ || info.generation == 0) {
-				info.block = INVALID_BLOCK;
-				info.generation = 0;
-				info.hits = 0;
-				--cacheSize_;
-
-				// TODO: Doing this in chunks might be a lot better.
-				WriteIndexData(blockIndexLookup_[i], info);
-				blockIndexLookup_[i] = INVALID_INDEX;
+				FreeBlock(blockIndexLookup_[i]);
 
 				// Keep going?
 				if (cacheSize_ <= goal) {
@@ -393,26 +404,109 @@ void DiskCachingFileLoaderCache::RebalanceGenerations() {
 
 		if (info.generation > oldestGeneration_) {
 			info.generation = (info.generation - oldestGeneration_) / 2;
-			// TODO: Doing this all at once would be much better.
-			WriteIndexData((u32)i, info);
+			MarkIndexDirty((u32)i);
 		}
 	}
 
 	oldestGeneration_ = 0;
 }
 
-u32 DiskCachingFileLoaderCache::AllocateBlock(u32 indexPos) {
-	for (size_t i = 0; i < blockIndexLookup_.size(); ++i) {
-		if (blockIndexLookup_[i] == INVALID_INDEX) {
-			blockIndexLookup_[i] = indexPos;
-			return (u32)i;
+u32 DiskCachingFileLoaderCache::AllocateBlock(u32 indexPos, u32 sectors) {
+	const u32 want = (1U << sectors) - 1;
+
+	// Continue from the last slot we allocated in, it's the most likely to have room.
+	for (u32 n = 0; n < maxBlocks_; ++n) {
+		u32 slot = (allocCursor_ + n) % maxBlocks_;
+		u32 used = slotUsage_[slot];
+		if (used == 0xFFFF) {
+			continue;
+		}
+
+		for (u32 first = 0; first + sectors <= SECTORS_PER_BLOCK; ++first) {
+			u32 mask = want << first;
+			if ((used & mask) == 0) {
+				slotUsage_[slot] = (u16)(used | mask);
+				allocCursor_ = slot;
+
+				u32 sector = slot * SECTORS_PER_BLOCK + first;
+				blockIndexLookup_[sector] = indexPos;
+				return sector;
+			}
 		}
 	}
 
-	_dbg_assert_msg_(false, "Not enough free blocks");
 	return INVALID_BLOCK;
 }
 
+void DiskCachingFileLoaderCache::StoreBlock(u32 indexPos, const u8 *src) {
+	const u8 *storeData = src;
+	size_t storeSize = blockSize_;
+	if (cctx_) {
+		compressBuf_.resize(ZSTD_compressBound(blockSize_));
+		size_t compressed = ZSTD_compressCCtx(cctx_, &compressBuf_[0], compressBuf_.size(), src, blockSize_, 1);
+		// Only worth storing compressed if it saves at least one sector.
+		if (!ZSTD_isError(compressed) && SectorsFor(compressed) < SECTORS_PER_BLOCK) {
+			storeData = &compressBuf_[0];
+			storeSize = compressed;
+		}
+	}
+
+	const u32 sectors = SectorsFor(storeSize);
+	u32 sector = AllocateBlock(indexPos, sectors);
+	if (sector == INVALID_BLOCK) {
+		// There's room in total, but it's split into pieces too small.  Clear out a slot.
+		EvictSlot(allocCursor_);
+		sector = AllocateBlock(indexPos, sectors);
+		if (sector == INVALID_BLOCK) {
+			_dbg_assert_msg_(false, "Not enough free blocks");
+			return;
+		}
+	}
+
+	auto &info = index_[indexPos];
+	info.block = sector;
+	info.size = (u32)storeSize;
+	cacheSize_ += sectors;
+	if (decodedIndex_ == indexPos) {
+		decodedIndex_ = INVALID_INDEX;
+	}
+
+	WriteBlockData(info, storeData);
+	MarkIndexDirty(indexPos);
+}
+
+void DiskCachingFileLoaderCache::FreeBlock(u32 indexPos) {
+	auto &info = index_[indexPos];
+	if (info.block == INVALID_BLOCK) {
+		return;
+	}
+
+	const u32 sectors = SectorsFor(info.size);
+	const u32 slot = info.block / SECTORS_PER_BLOCK;
+	const u32 first = info.block % SECTORS_PER_BLOCK;
+	slotUsage_[slot] &= (u16)~(((1U << sectors) - 1) << first);
+	blockIndexLookup_[info.block] = INVALID_INDEX;
+	cacheSize_ -= sectors;
+	if (decodedIndex_ == indexPos) {
+		decodedIndex_ = INVALID_INDEX;
+	}
+
+	info.block = INVALID_BLOCK;
+	info.generation = 0;
+	info.hits = 0;
+	info.size = 0;
+	MarkIndexDirty(indexPos);
+}
+
+void DiskCachingFileLoaderCache::EvictSlot(u32 slot) {
+	for (u32 i = 0; i < SECTORS_PER_BLOCK; ++i) {
+		u32 indexPos = blockIndexLookup_[slot * SECTORS_PER_BLOCK + i];
+		if (indexPos != INVALID_INDEX) {
+			FreeBlock(indexPos);
+		}
+	}
+}
+
 std::string DiskCachingFileLoaderCache::MakeCacheFilename(const Path &path) {
 	static const char *const invalidChars = "?*:/\\^|<>\"'";
 	std::string filename = path.ToString();
@@ -438,37 +532,63 @@ ::Path DiskCachingFileLoaderCache::MakeCacheFilePath(const Path &filename) {
 	return dir / MakeCacheFilename(filename);
 }
 
-s64 DiskCachingFileLoaderCache::GetBlockOffset(u32 block) {
+s64 DiskCachingFileLoaderCache::GetBlockOffset(u32 sector) {
 	// This is where the blocks start.
 	s64 blockOffset = (s64)sizeof(FileHeader) + (s64)indexCount_ * (s64)sizeof(BlockInfo);
 	// Now to the actual block.
-	return blockOffset + (s64)block * (s64)blockSize_;
+	return blockOffset + (s64)sector * (s64)(blockSize_ / SECTORS_PER_BLOCK);
 }
 
-bool DiskCachingFileLoaderCache::ReadBlockData(u8 *dest, BlockInfo &info, size_t offset, size_t size) {
+bool DiskCachingFileLoaderCache::ReadBlockData(u8 *dest, u32 indexPos, size_t offset, size_t size) {
 	if (!f_) {
 		return false;
 	}
 	if (size == 0) {
 		return true;
 	}
+	const BlockInfo &info = index_[indexPos];
 	s64 blockOffset = GetBlockOffset(info.block);
 
+	if (info.size == blockSize_) {
+		return ReadRawData(dest, blockOffset + offset, size);
+	}
+
+	if (decodedIndex_ != indexPos) {
+		compressBuf_.resize(info.size);
+		if (!ReadRawData(&compressBuf_[0], blockOffset, info.size)) {
+			return false;
+		}
+
+		decodedBlock_.resize(blockSize_);
+		size_t result = dctx_ ? ZSTD_decompressDCtx(dctx_, &decodedBlock_[0], blockSize_, &compressBuf_[0], info.size) : 0;
+		if (ZSTD_isError(result) || result != blockSize_) {
+			ERROR_LOG(LOADER, "Unable to decompress disk cache data entry.");
+			CloseFileHandle();
+			return false;
+		}
+		decodedIndex_ = indexPos;
+	}
+
+	memcpy(dest, &decodedBlock_[offset], size);
+	return true;
+}
+
+bool DiskCachingFileLoaderCache::ReadRawData(u8 *dest, s64 pos, size_t size) {
 	// Before we read, make sure the buffers are flushed.
 	// We might be trying to read an area we've recently written.
 	fflush(f_);
 
 	bool failed = false;
 #ifdef __ANDROID__
-	if (lseek64(fd_, blockOffset, SEEK_SET) != blockOffset) {
+	if (lseek64(fd_, pos, SEEK_SET) != pos) {
 		failed = true;
-	} else if (read(fd_, dest + offset, size) != (ssize_t)size) {
+	} else if (read(fd_, dest, size) != (ssize_t)size) {
 		failed = true;
 	}
 #else
-	if (fseeko(f_, blockOffset, SEEK_SET) != 0) {
+	if (fseeko(f_, pos, SEEK_SET) != 0) {
 		failed = true;
-	} else if (fread(dest + offset, size, 1, f_) != 1) {
+	} else if (fread(dest, size, 1, f_) != 1) {
 		failed = true;
 	}
 #endif
@@ -480,7 +600,7 @@ bool DiskCachingFileLoaderCache::ReadBlockData(u8 *dest, BlockInfo &info, size_t
 	return !failed;
 }
 
-void DiskCachingFileLoaderCache::WriteBlockData(BlockInfo &info, u8 *src) {
+void DiskCachingFileLoaderCache::WriteBlockData(BlockInfo &info, const u8 *src) {
 	if (!f_) {
 		return;
 	}
@@ -490,13 +610,13 @@ void DiskCachingFileLoaderCache::WriteBlockData(BlockInfo &info, u8 *src) {
 #ifdef __ANDROID__
 	if (lseek64(fd_, blockOffset, SEEK_SET) != blockOffset) {
 		failed = true;
-	} else if (write(fd_, src, blockSize_) != (ssize_t)blockSize_) {
+	} else if (write(fd_, src, info.size) != (ssize_t)info.size) {
 		failed = true;
 	}
 #else
 	if (fseeko(f_, blockOffset, SEEK_SET) != 0) {
 		failed = true;
-	} else if (fwrite(src, blockSize_, 1, f_) != 1) {
+	} else if (fwrite(src, info.size, 1, f_) != 1) {
 		failed = true;
 	}
 #endif
@@ -507,19 +627,36 @@ void DiskCachingFileLoaderCache::WriteBlockData(BlockInfo &info, u8 *src) {
 	}
 }
 
-void DiskCachingFileLoaderCache::WriteIndexData(u32 indexPos, BlockInfo &info) {
-	if (!f_) {
+void DiskCachingFileLoaderCache::MarkIndexDirty(u32 indexPos) {
+	dirtyIndexes_.push_back(indexPos);
+}
+
+void DiskCachingFileLoaderCache::FlushIndexData() {
+	if (!f_ || dirtyIndexes_.empty()) {
+		dirtyIndexes_.clear();
 		return;
 	}
 
-	u32 offset = (u32)sizeof(FileHeader) + indexPos * (u32)sizeof(BlockInfo);
+	std::sort(dirtyIndexes_.begin(), dirtyIndexes_.end());
+	dirtyIndexes_.erase(std::unique(dirtyIndexes_.begin(), dirtyIndexes_.end()), dirtyIndexes_.end());
 
+	// Write each run of neighboring entries at once.
 	bool failed = false;
-	if (fseek(f_, offset, SEEK_SET) != 0) {
-		failed = true;
-	} else if (fwrite(&info, sizeof(BlockInfo), 1, f_) != 1) {
-		failed = true;
+	for (size_t i = 0; i < dirtyIndexes_.size() && !failed; ) {
+		u32 start = dirtyIndexes_[i];
+		u32 end = start + 1;
+		for (++i; i < dirtyIndexes_.size() && dirtyIndexes_[i] == end; ++i) {
+			++end;
+		}
+
+		u32 offset = (u32)sizeof(FileHeader) + start * (u32)sizeof(BlockInfo);
+		if (fseek(f_, offset, SEEK_SET) != 0) {
+			failed = true;
+		} else if (fwrite(&index_[start], sizeof(BlockInfo), end - start, f_) != end - start) {
+			failed = true;
+		}
 	}
+	dirtyIndexes_.clear();
 
 	if (failed) {
 		ERROR_LOG(LOADER, "Unable to write disk cache index entry.");
@@ -578,8 +715,8 @@ void DiskCachingFileLoaderCache::LoadCacheIndex() {
 
 	indexCount_ = (size_t)((filesize_ + blockSize_ - 1) / blockSize_);
 	index_.resize(indexCount_);
-	blockIndexLookup_.resize(maxBlocks_);
-	memset(&blockIndexLookup_[0], INVALID_INDEX, maxBlocks_ * sizeof(blockIndexLookup_[0]));
+	blockIndexLookup_.assign(maxBlocks_ * SECTORS_PER_BLOCK, INVALID_INDEX);
+	slotUsage_.assign(maxBlocks_, 0);
 
 	if (fread(&index_[0], sizeof(BlockInfo), indexCount_, f_) != indexCount_) {
 		CloseFileHandle();
@@ -592,10 +729,21 @@ void DiskCachingFileLoaderCache::LoadCacheIndex() {
 	cacheSize_ = 0;
 
 	for (size_t i = 0; i < index_.size(); ++i) {
-		if (index_[i].block > maxBlocks_) {
-			index_[i].block = INVALID_BLOCK;
+		auto &info = index_[i];
+		if (info.block != INVALID_BLOCK) {
+			// Drop anything out of bounds or overlapping another block, it can't be trusted.
+			const u32 sectors = info.size == 0 || info.size > blockSize_ ? 0 : SectorsFor(info.size);
+			const u32 slot = info.block / SECTORS_PER_BLOCK;
+			const u32 first = info.block % SECTORS_PER_BLOCK;
+			const u32 mask = ((1U << sectors) - 1) << first;
+			if (sectors == 0 || slot >= maxBlocks_ || first + sectors > SECTORS_PER_BLOCK || (slotUsage_[slot] & mask) != 0) {
+				info = BlockInfo();
+			} else {
+				slotUsage_[slot] |= (u16)mask;
+				cacheSize_ += sectors;
+			}
 		}
-		if (index_[i].block == INVALID_BLOCK) {
+		if (info.block == INVALID_BLOCK) {
 			continue;
 		}
 
@@ -605,7 +753,6 @@ void DiskCachingFileLoaderCache::LoadCacheIndex() {
 		if (index_[i].generation > generation_) {
 			generation_ = index_[i].generation;
 		}
-		++cacheSize_;
 
 		blockIndexLookup_[index_[i].block] = (u32)i;
 	}
@@ -653,8 +800,8 @@ void DiskCachingFileLoaderCache::CreateCacheFile(const Path &path) {
 	indexCount_ = (size_t)((filesize_ + blockSize_ - 1) / blockSize_);
 	index_.clear();
 	index_.resize(indexCount_);
-	blockIndexLookup_.resize(maxBlocks_);
-	memset(&blockIndexLookup_[0], INVALID_INDEX, maxBlocks_ * sizeof(blockIndexLookup_[0]));
+	blockIndexLookup_.assign(maxBlocks_ * SECTORS_PER_BLOCK, INVALID_INDEX);
+	slotUsage_.assign(maxBlocks_, 0);
 
 	if (fwrite(&index_[0], sizeof(BlockInfo), indexCount_, f_) != indexCount_) {
 		CloseFileHandle();
@@ -744,12 +891,7 @@ bool DiskCachingFileLoaderCache::HasData() const {
 		return false;
 	}
 
-	for (size_t i = 0; i < blockIndexLookup_.size(); ++i) {
-		if (blockIndexLookup_[i] != INVALID_INDEX) {
-			return true;
-		}
-	}
-	return false;
+	return cacheSize_ != 0;
 }
 
 u64 DiskCachingFileLoaderCache::FreeDiskSpace() {
@@ -27,6 +27,8 @@
 #include "Core/Loaders.h"
 
 class DiskCachingFileLoaderCache;
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
 
 class DiskCachingFileLoader : public ProxiedFileLoader {
 public:
@@ -89,15 +91,25 @@ class DiskCachingFileLoaderCache {
 private:
 	void InitCache(const Path &path);
 	void ShutdownCache();
-	bool MakeCacheSpaceFor(size_t blocks);
+	bool MakeCacheSpaceFor(size_t sectors);
 	void RebalanceGenerations();
-	u32 AllocateBlock(u32 indexPos);
+	u32 AllocateBlock(u32 indexPos, u32 sectors);
+	void StoreBlock(u32 indexPos, const u8 *src);
+	void FreeBlock(u32 indexPos);
+	void EvictSlot(u32 slot);
+
+	u32 SectorsFor(size_t bytes) const {
+		const u32 sectorSize = blockSize_ / SECTORS_PER_BLOCK;
+		return (u32)((bytes + sectorSize - 1) / sectorSize);
+	}
 
 	struct BlockInfo;
-	bool ReadBlockData(u8 *dest, BlockInfo &info, size_t offset, size_t size);
-	void WriteBlockData(BlockInfo &info, u8 *src);
-	void WriteIndexData(u32 indexPos, BlockInfo &info);
-	s64 GetBlockOffset(u32 block);
+	bool ReadBlockData(u8 *dest, u32 indexPos, size_t offset, size_t size);
+	bool ReadRawData(u8 *dest, s64 pos, size_t size);
+	void WriteBlockData(BlockInfo &info, const u8 *src);
+	void MarkIndexDirty(u32 indexPos);
+	void FlushIndexData();
+	s64 GetBlockOffset(u32 sector);
 
 	Path MakeCacheFilePath(const Path &filename);
 	std::string MakeCacheFilename(const Path &path);
@@ -120,16 +132,19 @@ class DiskCachingFileLoaderCache {
 	// 64 filesize
 	// 32 maxBlocks
 	// 32 flags
-	// index[filesize / blockSize] <-- ~500 KB for 4GB
-	//   32 (fileoffset - headersize) / blockSize -> -1=not present
+	// index[filesize / blockSize] <-- ~750 KB for 4GB
+	//   32 (fileoffset - headersize) / sectorSize -> -1=not present
 	//   16 generation?
 	//   16 hits?
-	// blocks[up to maxBlocks]
-	//   8 * blockSize
+	//   32 stored size (blockSize = uncompressed, otherwise zstd)
+	// slots[maxBlocks]
+	//   8 * blockSize, split into SECTORS_PER_BLOCK sectors.
+	//   A stored block uses consecutive sectors inside a single slot.
 
 	enum {
-		CACHE_VERSION = 3,
+		CACHE_VERSION = 4,
 		DEFAULT_BLOCK_SIZE = 65536,
+		SECTORS_PER_BLOCK = 16,
 		MAX_BLOCKS_PER_READ = 16,
 		MAX_BLOCKS_LOWER_BOUND = 256, // 16 MB
 		MAX_BLOCKS_UPPER_BOUND = 8192, // 512 MB
@@ -144,6 +159,7 @@ class DiskCachingFileLoaderCache {
 	u16 oldestGeneration_;
 	u32 maxBlocks_;
 	u32 flags_;
+	// In sectors.
 	size_t cacheSize_;
 	size_t indexCount_;
 	std::mutex lock_;
@@ -166,13 +182,27 @@ class DiskCachingFileLoaderCache {
 		u32 block;
 		u16 generation;
 		u16 hits;
+		u32 size;
 
-		BlockInfo() : block(-1), generation(0), hits(0) {
+		BlockInfo() : block(-1), generation(0), hits(0), size(0) {
 		}
 	};
 
 	std::vector<BlockInfo> index_;
+	// Index position for each sector that starts a stored block.
 	std::vector<u32> blockIndexLookup_;
+	// Bitmask of used sectors for each slot.
+	std::vector<u16> slotUsage_;
+	u32 allocCursor_ = 0;
+	// Index entries changed since the last FlushIndexData().
+	std::vector<u32> dirtyIndexes_;
+
+	ZSTD_CCtx_s *cctx_ = nullptr;
+	ZSTD_DCtx_s *dctx_ = nullptr;
+	std::vector<u8> compressBuf_;
+	// Last block decompressed, since reads usually cover a block in several pieces.
+	std::vector<u8> decodedBlock_;
+	u32 decodedIndex_ = INVALID_INDEX;
 
 	FILE *f_ = nullptr;
 	int fd_ = 0;
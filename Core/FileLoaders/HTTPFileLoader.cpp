@@ -16,9 +16,11 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <thread>
 
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/Config.h"
 #include "Core/FileLoaders/HTTPFileLoader.h"
 
@@ -151,6 +153,12 @@ int HTTPFileLoader::SendHEAD(const Url &url, std::vector<std::string> &responseH
 
 HTTPFileLoader::~HTTPFileLoader() {
 	Disconnect();
+	std::lock_guard<std::mutex> guard(poolLock_);
+	for (auto &c : pool_) {
+		if (c->connected)
+			c->client.Disconnect();
+	}
+	pool_.clear();
 }
 
 bool HTTPFileLoader::Exists() {
@@ -178,7 +186,6 @@ Path HTTPFileLoader::GetPath() const {
 
 size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags) {
 	Prepare();
-	std::lock_guard<std::mutex> guard(readAtMutex_);
 
 	s64 absoluteEnd = std::min(absolutePos + (s64)bytes, filesize_);
 	if (absolutePos >= filesize_ || bytes == 0) {
@@ -186,76 +193,194 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 		return 0;
 	}
 
-	Connect();
-	if (!connected_) {
-		return 0;
+	// Large reads go out as several range requests on separate connections.
+	// A single connection is often limited far below the link speed by latency.
+	s64 total = absoluteEnd - absolutePos;
+	int parts = (int)std::min((s64)MAX_CONNECTIONS, total / PARALLEL_MIN_BYTES);
+	if (parts <= 1) {
+		return ReadRange(absolutePos, absoluteEnd, (u8 *)data);
 	}
 
-	char requestHeaders[4096];
-	// Note that the Range header is *inclusive*.
-	snprintf(requestHeaders, sizeof(requestHeaders),
-		"Range: bytes=%lld-%lld\r\n", absolutePos, absoluteEnd - 1);
-
-	http::RequestParams req(url_.Resource(), "*/*");
-	int err = client_.SendRequest("GET", req, requestHeaders, &progress_);
-	if (err < 0) {
-		latestError_ = "Invalid response reading data";
-		Disconnect();
-		return 0;
+	s64 partSize = (total + parts - 1) / parts;
+	std::vector<size_t> results(parts);
+	std::vector<std::thread> threads;
+	for (int i = 1; i < parts; ++i) {
+		s64 start = absolutePos + partSize * i;
+		s64 end = std::min(start + partSize, absoluteEnd);
+		u8 *dest = (u8 *)data + (start - absolutePos);
+		threads.push_back(std::thread([this, &results, i, start, end, dest] {
+			SetCurrentThreadName("HTTPRangeRead");
+			results[i] = ReadRange(start, end, dest);
+		}));
+	}
+	results[0] = ReadRange(absolutePos, absolutePos + partSize, (u8 *)data);
+	for (auto &th : threads) {
+		th.join();
 	}
 
-	net::Buffer readbuf;
-	std::vector<std::string> responseHeaders;
-	int code = client_.ReadResponseHeaders(&readbuf, responseHeaders, &progress_);
-	if (code != 206) {
-		ERROR_LOG(LOADER, "HTTP server did not respond with range, received code=%03d", code);
-		latestError_ = "Invalid response reading data";
-		Disconnect();
-		return 0;
+	// Only report the contiguous data from the start.
+	size_t readBytes = 0;
+	for (int i = 0; i < parts; ++i) {
+		s64 start = absolutePos + partSize * i;
+		size_t expected = (size_t)(std::min(start + partSize, absoluteEnd) - start);
+		readBytes += results[i];
+		if (results[i] != expected)
+			break;
 	}
+	return readBytes;
+}
+
+size_t HTTPFileLoader::ReadRange(s64 absolutePos, s64 absoluteEnd, u8 *data) {
+	PooledClient *c = AcquireClient();
+
+	// A reused connection may have been closed by the server while idle, so retry once on a fresh one.
+	// That has to be this client reconnecting: any other idle ones are probably just as stale.
+	for (int attempt = 0; attempt < 2; ++attempt) {
+		bool reused = c->connected;
+		if (!ConnectClient(c)) {
+			ReleaseClient(c, false);
+			return 0;
+		}
+
+		char requestHeaders[4096];
+		// Note that the Range header is *inclusive*.
+		snprintf(requestHeaders, sizeof(requestHeaders),
+			"Range: bytes=%lld-%lld\r\n", absolutePos, absoluteEnd - 1);
+
+		http::RequestParams req(url_.Resource(), "*/*");
+		int err = c->client.SendRequest("GET", req, requestHeaders, &c->progress);
+		if (err < 0) {
+			if (reused && !cancel_) {
+				DisconnectClient(c);
+				continue;
+			}
+			ReleaseClient(c, false);
+			latestError_ = "Invalid response reading data";
+			return 0;
+		}
+
+		net::Buffer readbuf;
+		std::vector<std::string> responseHeaders;
+		int code = c->client.ReadResponseHeaders(&readbuf, responseHeaders, &c->progress);
+		if (code < 0 && reused && !cancel_) {
+			DisconnectClient(c);
+			continue;
+		}
+		if (code != 206) {
+			ERROR_LOG(LOADER, "HTTP server did not respond with range, received code=%03d", code);
+			latestError_ = "Invalid response reading data";
+			ReleaseClient(c, false);
+			return 0;
+		}
 
-	// TODO: Expire cache via ETag, etc.
-	// We don't support multipart/byteranges responses.
-	bool supportedResponse = false;
-	for (std::string header : responseHeaders) {
-		if (startsWithNoCase(header, "Content-Range:")) {
-			// TODO: More correctness.  Whitespace can be missing or different.
-			s64 first = -1, last = -1, total = -1;
+		// TODO: Expire cache via ETag, etc.
+		// We don't support multipart/byteranges responses.
+		bool supportedResponse = false;
+		bool keepConnection = true;
+		for (std::string header : responseHeaders) {
 			std::string lowerHeader = header;
 			std::transform(lowerHeader.begin(), lowerHeader.end(), lowerHeader.begin(), tolower);
-			if (sscanf(lowerHeader.c_str(), "content-range: bytes %lld-%lld/%lld", &first, &last, &total) >= 2) {
-				if (first == absolutePos && last == absoluteEnd - 1) {
-					supportedResponse = true;
+			if (startsWithNoCase(header, "Content-Range:")) {
+				// TODO: More correctness.  Whitespace can be missing or different.
+				s64 first = -1, last = -1, total = -1;
+				if (sscanf(lowerHeader.c_str(), "content-range: bytes %lld-%lld/%lld", &first, &last, &total) >= 2) {
+					if (first == absolutePos && last == absoluteEnd - 1) {
+						supportedResponse = true;
+					} else {
+						ERROR_LOG(LOADER, "Unexpected HTTP range: got %lld-%lld, wanted %lld-%lld.", first, last, absolutePos, absoluteEnd - 1);
+					}
 				} else {
-					ERROR_LOG(LOADER, "Unexpected HTTP range: got %lld-%lld, wanted %lld-%lld.", first, last, absolutePos, absoluteEnd - 1);
+					ERROR_LOG(LOADER, "Unexpected HTTP range response: %s", header.c_str());
 				}
-			} else {
-				ERROR_LOG(LOADER, "Unexpected HTTP range response: %s", header.c_str());
+			} else if (startsWithNoCase(header, "Connection:")) {
+				if (lowerHeader.find("close") != lowerHeader.npos)
+					keepConnection = false;
 			}
 		}
+
+		// TODO: Would be nice to read directly.
+		net::Buffer output;
+		int res = c->client.ReadResponseEntity(&readbuf, responseHeaders, &output, &c->progress);
+		if (res != 0) {
+			ERROR_LOG(LOADER, "Unable to read HTTP response entity: %d", res);
+			// Let's take anything we got anyway.  Not worse than returning nothing?
+			keepConnection = false;
+		}
+
+		ReleaseClient(c, keepConnection && supportedResponse);
+
+		if (!supportedResponse) {
+			ERROR_LOG(LOADER, "HTTP server did not respond with the range we wanted.");
+			latestError_ = "Invalid response reading data";
+			return 0;
+		}
+
+		size_t readBytes = std::min(output.size(), (size_t)(absoluteEnd - absolutePos));
+		output.Take(readBytes, (char *)data);
+		return readBytes;
 	}
 
-	// TODO: Would be nice to read directly.
-	net::Buffer output;
-	int res = client_.ReadResponseEntity(&readbuf, responseHeaders, &output, &progress_);
-	if (res != 0) {
-		ERROR_LOG(LOADER, "Unable to read HTTP response entity: %d", res);
-		// Let's take anything we got anyway.  Not worse than returning nothing?
+	ReleaseClient(c, false);
+	latestError_ = "Invalid response reading data";
+	return 0;
+}
+
+HTTPFileLoader::PooledClient *HTTPFileLoader::AcquireClient() {
+	std::unique_lock<std::mutex> guard(poolLock_);
+	while (true) {
+		// Prefer an idle connection that's already open.
+		PooledClient *idle = nullptr;
+		for (auto &c : pool_) {
+			if (!c->busy && (!idle || c->connected))
+				idle = c.get();
+		}
+		if (!idle && pool_.size() < MAX_CONNECTIONS) {
+			pool_.push_back(std::unique_ptr<PooledClient>(new PooledClient(&cancel_)));
+			idle = pool_.back().get();
+		}
+		if (idle) {
+			idle->busy = true;
+			return idle;
+		}
+		poolCond_.wait(guard);
 	}
+}
 
-	// TODO: Keepalive instead.
-	Disconnect();
+void HTTPFileLoader::ReleaseClient(PooledClient *c, bool keepConnection) {
+	if (!keepConnection)
+		DisconnectClient(c);
 
-	if (!supportedResponse) {
-		ERROR_LOG(LOADER, "HTTP server did not respond with the range we wanted.");
-		latestError_ = "Invalid response reading data";
-		return 0;
+	std::lock_guard<std::mutex> guard(poolLock_);
+	c->busy = false;
+	poolCond_.notify_one();
+}
+
+void HTTPFileLoader::DisconnectClient(PooledClient *c) {
+	if (c->connected) {
+		c->client.Disconnect();
+		c->connected = false;
 	}
+}
 
-	size_t readBytes = output.size();
-	output.Take(readBytes, (char *)data);
-	filepos_ = absolutePos + readBytes;
-	return readBytes;
+bool HTTPFileLoader::ConnectClient(PooledClient *c) {
+	if (c->connected)
+		return true;
+
+	if (!c->resolved) {
+		c->client.SetUserAgent(StringFromFormat("PPSSPP/%s", PPSSPP_GIT_VERSION));
+		c->client.SetKeepAlive(true);
+		c->client.SetDataTimeout(20.0);
+		c->resolved = c->client.Resolve(url_.Host().c_str(), url_.Port());
+		if (!c->resolved) {
+			latestError_ = "Could not connect (name not resolved)";
+			return false;
+		}
+	}
+
+	cancel_ = false;
+	// Latency is important here, so reduce the timeout.
+	c->connected = c->client.Connect(3, 10.0, &cancel_);
+	return c->connected;
 }
 
 void HTTPFileLoader::Connect() {
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -55,9 +57,26 @@ class HTTPFileLoader : public FileLoader {
 	}
 
 private:
+	// A persistent connection used for range requests.  Several can be in flight at once.
+	struct PooledClient {
+		explicit PooledClient(bool *cancel) : progress(cancel) {}
+
+		http::Client client;
+		http::RequestProgress progress;
+		bool resolved = false;
+		bool connected = false;
+		bool busy = false;
+	};
+
 	void Prepare();
 	int SendHEAD(const Url &url, std::vector<std::string> &responseHeaders);
 
+	size_t ReadRange(s64 absolutePos, s64 absoluteEnd, u8 *data);
+	PooledClient *AcquireClient();
+	void ReleaseClient(PooledClient *c, bool keepConnection);
+	bool ConnectClient(PooledClient *c);
+	void DisconnectClient(PooledClient *c);
+
 	void Connect();
 
 	void Disconnect() {
@@ -67,8 +86,12 @@ class HTTPFileLoader : public FileLoader {
 		connected_ = false;
 	}
 
+	// Maximum number of simultaneous range requests to the server.
+	static constexpr int MAX_CONNECTIONS = 3;
+	// Reads at least this large per connection are split across the pool.
+	static constexpr s64 PARALLEL_MIN_BYTES = 256 * 1024;
+
 	s64 filesize_ = 0;
-	s64 filepos_ = 0;
 	Url url_;
 	http::Client client_;
 	http::RequestProgress progress_;
@@ -78,5 +101,8 @@ class HTTPFileLoader : public FileLoader {
 	const char *latestError_ = "";
 
 	std::once_flag preparedFlag_;
-	std::mutex readAtMutex_;
+
+	std::vector<std::unique_ptr<PooledClient>> pool_;
+	std::mutex poolLock_;
+	std::condition_variable poolCond_;
 };
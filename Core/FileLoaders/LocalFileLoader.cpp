@@ -15,7 +15,9 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 #include "ppsspp_config.h"
 
@@ -36,6 +38,7 @@
 #endif
 #else
 #include <fcntl.h>
+#include <sys/mman.h>
 #endif
 
 #ifndef _WIN32
@@ -71,6 +74,7 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 		fd_ = fd;
 		isOpenedByFd_ = true;
 		DetectSizeFd();
+		MapFile();
 		return;
 	}
 #endif
@@ -83,6 +87,7 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 	}
 
 	DetectSizeFd();
+	MapFile();
 
 #else // _WIN32
 
@@ -105,10 +110,49 @@ LocalFileLoader::LocalFileLoader(const Path &filename)
 	}
 	filesize_ = end_offset.QuadPart;
 	SetFilePointerEx(handle_, zero, nullptr, FILE_BEGIN);
+	MapFile();
 #endif // _WIN32
 }
 
+void LocalFileLoader::MapFile() {
+	// Only worth it (and only safe for big ISOs) with a 64-bit address space.
+#if PPSSPP_ARCH(64BIT) && !PPSSPP_PLATFORM(UWP) && !PPSSPP_PLATFORM(SWITCH)
+	if (filesize_ == 0 || filesize_ != (u64)(size_t)filesize_)
+		return;
+#ifndef _WIN32
+	void *ptr = mmap(nullptr, (size_t)filesize_, PROT_READ, MAP_SHARED, fd_, 0);
+	if (ptr == MAP_FAILED) {
+		VERBOSE_LOG(FILESYS, "LocalFileLoader couldn't map '%s', using reads", filename_.c_str());
+		return;
+	}
+	mapped_ = (const u8 *)ptr;
+#else
+	mapping_ = CreateFileMapping(handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping_) {
+		VERBOSE_LOG(FILESYS, "LocalFileLoader couldn't map '%s', using reads", filename_.c_str());
+		return;
+	}
+	mapped_ = (const u8 *)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+	if (!mapped_) {
+		CloseHandle(mapping_);
+		mapping_ = 0;
+	}
+#endif
+#endif
+}
+
 LocalFileLoader::~LocalFileLoader() {
+#ifndef _WIN32
+	if (mapped_) {
+		munmap((void *)mapped_, (size_t)filesize_);
+	}
+#else
+	if (mapped_) {
+		UnmapViewOfFile(mapped_);
+		CloseHandle(mapping_);
+	}
+#endif
+
 #ifndef _WIN32
 	if (fd_ != -1) {
 		close(fd_);
@@ -164,6 +208,15 @@ size_t LocalFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void
 		return 0;
 	}
 
+	if (mapped_) {
+		// Note: if the file is truncated underneath us, this faults rather than returning short.
+		if (absolutePos < 0 || (u64)absolutePos >= filesize_)
+			return 0;
+		size_t avail = (size_t)std::min((u64)(bytes * count), filesize_ - (u64)absolutePos);
+		memcpy(data, mapped_ + absolutePos, avail);
+		return avail / bytes;
+	}
+
 #if PPSSPP_PLATFORM(SWITCH)
 	// Toolchain has no fancy IO API.  We must lock.
 	std::lock_guard<std::mutex> guard(readLock_);
@@ -198,3 +251,9 @@ size_t LocalFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void
 	return result == TRUE ? (size_t)read / bytes : -1;
 #endif
 }
+
+const u8 *LocalFileLoader::GetDirectPointer(s64 absolutePos, size_t bytes) {
+	if (!mapped_ || absolutePos < 0 || (u64)absolutePos + bytes > filesize_)
+		return nullptr;
+	return mapped_ + absolutePos;
+}
@@ -39,8 +39,11 @@ class LocalFileLoader : public FileLoader {
 		return filename_;
 	}
 	virtual size_t ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags = Flags::NONE) override;
+	const u8 *GetDirectPointer(s64 absolutePos, size_t bytes) override;
 
 private:
+	void MapFile();
+
 #ifndef _WIN32
 	void DetectSizeFd();
 	int fd_ = -1;
@@ -48,6 +51,11 @@ class LocalFileLoader : public FileLoader {
 	HANDLE handle_ = 0;
 #endif
 	u64 filesize_ = 0;
+	// On 64-bit, the whole file is mapped when possible and reads are just copies.
+	const u8 *mapped_ = nullptr;
+#ifdef _WIN32
+	HANDLE mapping_ = 0;
+#endif
 	Path filename_;
 	std::mutex readLock_;
 	bool isOpenedByFd_ = false;
@@ -18,15 +18,21 @@
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <vector>
 
 #include "Common/Data/Text/I18n.h"
 #include "Common/File/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/Swap.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/Loaders.h"
 #include "Core/Host.h"
 #include "Core/FileSystems/BlockDevices.h"
 
+#include <zstd.h>
+
 extern "C"
 {
 #include "zlib.h"
@@ -42,8 +48,23 @@ BlockDevice *constructBlockDevice(FileLoader *fileLoader) {
 		return nullptr;
 	char buffer[4]{};
 	size_t size = fileLoader->ReadAt(0, 1, 4, buffer);
-	if (size == 4 && !memcmp(buffer, "CISO", 4))
+	if (size == 4 && (!memcmp(buffer, "CISO", 4) || !memcmp(buffer, "ZISO", 4)))
 		return new CISOFileBlockDevice(fileLoader);
+	if (size == 4 && !memcmp(buffer, "MCom", 4)) {
+		CHDFileBlockDevice *device = new CHDFileBlockDevice(fileLoader);
+		if (device->IsValid())
+			return device;
+		delete device;
+		return nullptr;
+	}
+	if (size == 4 && !memcmp(buffer, "\x28\xB5\x2F\xFD", 4)) {
+		ZstdSeekableBlockDevice *device = new ZstdSeekableBlockDevice(fileLoader);
+		if (device->IsValid())
+			return device;
+		// A plain zstd stream can't be read at random, so there's nothing sensible to fall back to.
+		delete device;
+		return nullptr;
+	}
 	if (size == 4 && !memcmp(buffer, "\x00PBP", 4)) {
 		uint32_t psarOffset = 0;
 		size = fileLoader->ReadAt(0x24, 1, 4, &psarOffset);
@@ -141,9 +162,13 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 {
 	// CISO format is fairly simple, but most tools do not write the header_size.
 
+	// ZSO is the same container with LZ4 compressed frames instead of deflate.
+
 	CISO_H hdr;
 	size_t readSize = fileLoader->ReadAt(0, sizeof(CISO_H), 1, &hdr);
-	if (readSize != 1 || memcmp(hdr.magic, "CISO", 4) != 0) {
+	if (readSize == 1 && memcmp(hdr.magic, "ZISO", 4) == 0) {
+		lz4_ = true;
+	} else if (readSize != 1 || memcmp(hdr.magic, "CISO", 4) != 0) {
 		WARN_LOG(LOADER, "Invalid CSO!");
 	}
 	if (hdr.ver > 1) {
@@ -169,11 +194,24 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 
 	// We might read a bit of alignment too, so be prepared.
 	if (frameSize + (1 << indexShift) < CSO_READ_BUFFER_SIZE)
-		readBuffer = new u8[CSO_READ_BUFFER_SIZE];
+		readBufferSize = CSO_READ_BUFFER_SIZE;
 	else
-		readBuffer = new u8[frameSize + (1 << indexShift)];
-	zlibBuffer = new u8[frameSize + (1 << indexShift)];
-	zlibBufferFrame = numFrames;
+		readBufferSize = frameSize + (1 << indexShift);
+	readBuffer = new u8[readBufferSize];
+	frameCache_ = new u8[(size_t)frameSize * FRAME_CACHE_SIZE];
+	for (int i = 0; i < FRAME_CACHE_SIZE; ++i) {
+		frameCacheFrame_[i] = numFrames;
+		frameCacheLastUse_[i] = 0;
+	}
+
+	if (!lz4_) {
+		zstream_ = new z_stream{};
+	}
+	if (zstream_ && inflateInit2(zstream_, -15) != Z_OK) {
+		ERROR_LOG(LOADER, "Unable to initialize inflate: %s\n", (zstream_->msg) ? zstream_->msg : "?");
+		delete zstream_;
+		zstream_ = nullptr;
+	}
 
 	const u32 indexSize = numFrames + 1;
 	const size_t headerEnd = hdr.ver > 1 ? (size_t)hdr.header_size : sizeof(hdr);
@@ -216,7 +254,125 @@ CISOFileBlockDevice::~CISOFileBlockDevice()
 {
 	delete [] index;
 	delete [] readBuffer;
-	delete [] zlibBuffer;
+	delete [] frameCache_;
+	if (zstream_) {
+		inflateEnd(zstream_);
+		delete zstream_;
+	}
+}
+
+bool CISOFileBlockDevice::IsPlainFrame(u32 frame, u32 compressedSize) const {
+	// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
+	if (ver_ >= 2)
+		return compressedSize >= frameSize;
+	return (index[frame] & 0x80000000) != 0;
+}
+
+const u8 *CISOFileBlockDevice::LookupFrame(u32 frame) {
+	for (int i = 0; i < FRAME_CACHE_SIZE; ++i) {
+		if (frameCacheFrame_[i] == frame) {
+			frameCacheLastUse_[i] = ++frameCacheCounter_;
+			return frameCache_ + (size_t)i * frameSize;
+		}
+	}
+	return nullptr;
+}
+
+// Claims the least recently used slot for frame.  The caller must fill it, or reset
+// frameCacheFrame_ to numFrames if decompression fails.
+int CISOFileBlockDevice::InsertFrame(u32 frame) {
+	int oldest = 0;
+	for (int i = 1; i < FRAME_CACHE_SIZE; ++i) {
+		if (frameCacheLastUse_[i] < frameCacheLastUse_[oldest])
+			oldest = i;
+	}
+	frameCacheFrame_[oldest] = frame;
+	frameCacheLastUse_[oldest] = ++frameCacheCounter_;
+	return oldest;
+}
+
+// Inflates a whole frame, leaving the stream ready for the next one.
+static bool InflateFrame(z_stream *z, u32 frame, const u8 *src, u32 srcSize, u8 *dest, u32 frameSize) {
+	z->avail_in = srcSize;
+	z->next_in = (Bytef *)src;
+	z->avail_out = frameSize;
+	z->next_out = dest;
+
+	int status = inflate(z, Z_FINISH);
+	bool success = true;
+	if (status != Z_STREAM_END) {
+		ERROR_LOG(LOADER, "Inflate frame %d: failed - %s[%d]\n", frame, (z->msg) ? z->msg : "error", status);
+		success = false;
+	} else if (z->total_out != frameSize) {
+		ERROR_LOG(LOADER, "Inflate frame %d: block size error %d != %d\n", frame, (u32)z->total_out, frameSize);
+		success = false;
+	}
+	inflateReset(z);
+	return success;
+}
+
+// Decodes a raw LZ4 block (no frame header) that must fill the whole frame.  Decoding stops
+// as soon as the frame is full, since the input may be followed by index alignment padding.
+static bool DecodeLZ4Frame(u32 frame, const u8 *src, u32 srcSize, u8 *dest, u32 frameSize) {
+	const u8 *ip = src;
+	const u8 *const iend = src + srcSize;
+	u8 *op = dest;
+	u8 *const oend = dest + frameSize;
+
+	auto readLength = [&](size_t &len) {
+		u8 b;
+		do {
+			if (ip >= iend)
+				return false;
+			b = *ip++;
+			len += b;
+		} while (b == 255);
+		return true;
+	};
+
+	while (ip < iend) {
+		const u8 token = *ip++;
+		size_t literals = token >> 4;
+		if (literals == 15 && !readLength(literals))
+			break;
+		if ((size_t)(iend - ip) < literals || (size_t)(oend - op) < literals)
+			break;
+		memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+		// The last sequence is only literals.
+		if (op == oend || ip >= iend)
+			break;
+
+		if (iend - ip < 2)
+			break;
+		const size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dest))
+			break;
+		size_t matchLen = token & 15;
+		if (matchLen == 15 && !readLength(matchLen))
+			break;
+		matchLen += 4;
+		if ((size_t)(oend - op) < matchLen)
+			break;
+
+		const u8 *match = op - offset;
+		if (offset >= matchLen) {
+			memcpy(op, match, matchLen);
+		} else {
+			// Overlapping copies repeat the pattern, so they have to go byte by byte.
+			for (size_t i = 0; i < matchLen; ++i)
+				op[i] = match[i];
+		}
+		op += matchLen;
+	}
+
+	if (op != oend) {
+		ERROR_LOG(LOADER, "LZ4 frame %d: block size error %d != %d\n", frame, (int)(op - dest), frameSize);
+		return false;
+	}
+	return true;
 }
 
 bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
@@ -231,66 +387,60 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 	const u32 idx = index[frameNumber];
 	const u32 indexPos = idx & 0x7FFFFFFF;
 	const u32 nextIndexPos = index[frameNumber + 1] & 0x7FFFFFFF;
-	z_stream z{};
 
 	const u64 compressedReadPos = (u64)indexPos << indexShift;
 	const u64 compressedReadEnd = (u64)nextIndexPos << indexShift;
-	const size_t compressedReadSize = (size_t)(compressedReadEnd - compressedReadPos);
+	const size_t compressedReadSize = (size_t)std::min(compressedReadEnd - compressedReadPos, (u64)readBufferSize);
 	const u32 compressedOffset = (blockNumber & ((1 << blockShift) - 1)) * GetBlockSize();
 
-	bool plain = (idx & 0x80000000) != 0;
-	if (ver_ >= 2) {
-		// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
-		plain = compressedReadSize >= frameSize;
-	}
-	if (plain) {
+	if (IsPlainFrame(frameNumber, (u32)compressedReadSize)) {
 		int readSize = (u32)fileLoader_->ReadAt(compressedReadPos + compressedOffset, 1, GetBlockSize(), outPtr, flags);
 		if (readSize < GetBlockSize())
 			memset(outPtr + readSize, 0, GetBlockSize() - readSize);
-	} else if (zlibBufferFrame == frameNumber) {
+		return true;
+	}
+
+	const u8 *cached = LookupFrame(frameNumber);
+	if (cached) {
 		// We already have it.  Just apply the offset and copy.
-		memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
-	} else {
-		const u32 readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, compressedReadSize, readBuffer, flags);
-
-		z.zalloc = Z_NULL;
-		z.zfree = Z_NULL;
-		z.opaque = Z_NULL;
-		if (inflateInit2(&z, -15) != Z_OK) {
-			ERROR_LOG(LOADER, "GetBlockSize() ERROR: %s\n", (z.msg) ? z.msg : "?");
-			NotifyReadError();
-			return false;
-		}
-		z.avail_in = readSize;
-		z.next_out = frameSize == (u32)GetBlockSize() ? outPtr : zlibBuffer;
-		z.avail_out = frameSize;
-		z.next_in = readBuffer;
+		memcpy(outPtr, cached + compressedOffset, GetBlockSize());
+		return true;
+	}
 
-		int status = inflate(&z, Z_FINISH);
-		if (status != Z_STREAM_END) {
-			ERROR_LOG(LOADER, "block %d: inflate : %s[%d]\n", blockNumber, (z.msg) ? z.msg : "error", status);
-			NotifyReadError();
-			inflateEnd(&z);
-			memset(outPtr, 0, GetBlockSize());
-			return false;
-		}
-		if (z.total_out != frameSize) {
-			ERROR_LOG(LOADER, "block %d: block size error %d != %d\n", blockNumber, (u32)z.total_out, frameSize);
-			NotifyReadError();
-			inflateEnd(&z);
-			memset(outPtr, 0, GetBlockSize());
-			return false;
-		}
-		inflateEnd(&z);
+	if (!lz4_ && !zstream_) {
+		NotifyReadError();
+		memset(outPtr, 0, GetBlockSize());
+		return false;
+	}
 
-		if (frameSize != (u32)GetBlockSize()) {
-			zlibBufferFrame = frameNumber;
-			memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
-		}
+	// Decompress straight from the file if it's mapped, otherwise read it in first.
+	const u8 *compressed = fileLoader_->GetDirectPointer(compressedReadPos, compressedReadSize);
+	u32 readSize = (u32)compressedReadSize;
+	if (!compressed) {
+		readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, compressedReadSize, readBuffer, flags);
+		compressed = readBuffer;
 	}
+	const int slot = InsertFrame(frameNumber);
+	u8 *frameBuffer = frameCache_ + (size_t)slot * frameSize;
+	bool success;
+	if (lz4_)
+		success = DecodeLZ4Frame(frameNumber, compressed, readSize, frameBuffer, frameSize);
+	else
+		success = InflateFrame(zstream_, frameNumber, compressed, readSize, frameBuffer, frameSize);
+	if (!success) {
+		frameCacheFrame_[slot] = numFrames;
+		NotifyReadError();
+		memset(outPtr, 0, GetBlockSize());
+		return false;
+	}
+
+	memcpy(outPtr, frameBuffer + compressedOffset, GetBlockSize());
 	return true;
 }
 
+// Frames are inflated on worker threads once a read spans at least this many bytes per task.
+static const u32 CSO_PARALLEL_MIN_BYTES = 64 * 1024;
+
 bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	if (count == 1) {
 		return ReadBlock(minBlock, outPtr);
@@ -301,86 +451,911 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	}
 
 	const u32 lastBlock = std::min(minBlock + count, numBlocks) - 1;
-	const u32 missingBlocks = (lastBlock + 1 - minBlock) - count;
-	if (lastBlock < minBlock + count) {
+	const u32 missingBlocks = count - (lastBlock + 1 - minBlock);
+	if (missingBlocks != 0) {
 		memset(outPtr + GetBlockSize() * (count - missingBlocks), 0, GetBlockSize() * missingBlocks);
 	}
 
 	const u32 minFrameNumber = minBlock >> blockShift;
 	const u32 lastFrameNumber = lastBlock >> blockShift;
-	const u32 afterLastIndexPos = index[lastFrameNumber + 1] & 0x7FFFFFFF;
-	const u64 totalReadEnd = (u64)afterLastIndexPos << indexShift;
+	const u32 blocksPerFrame = 1 << blockShift;
+	const u32 blockSize = GetBlockSize();
+
+	struct FrameJob {
+		u32 frame;
+		u32 rawOffset;
+		u32 rawSize;
+		u32 blockOffset;
+		u32 blocks;
+		bool plain;
+		// Either a frame we already have, or a cache slot to inflate a partial frame into.
+		const u8 *cached;
+		int slot;
+		u8 *out;
+	};
+	std::vector<FrameJob> jobs;
+	jobs.reserve(std::min(lastFrameNumber - minFrameNumber + 1, (u32)256));
+
+	std::atomic<bool> failed(false);
+	u32 block = minBlock;
+	u32 frame = minFrameNumber;
+	while (frame <= lastFrameNumber) {
+		// Gather as many frames as fit in the read buffer, and fetch them in one go.
+		const u64 chunkReadPos = (u64)(index[frame] & 0x7FFFFFFF) << indexShift;
+		u32 chunkEndFrame = frame + 1;
+		while (chunkEndFrame <= lastFrameNumber && ((u64)(index[chunkEndFrame + 1] & 0x7FFFFFFF) << indexShift) - chunkReadPos <= readBufferSize)
+			++chunkEndFrame;
+		const u64 chunkReadEnd = (u64)(index[chunkEndFrame] & 0x7FFFFFFF) << indexShift;
+		const size_t chunkSize = (size_t)std::min(chunkReadEnd - chunkReadPos, (u64)readBufferSize);
+
+		const u8 *chunkData = fileLoader_->GetDirectPointer(chunkReadPos, chunkSize);
+		if (!chunkData) {
+			const u32 readSize = (u32)fileLoader_->ReadAt(chunkReadPos, 1, chunkSize, readBuffer);
+			if (readSize < chunkSize) {
+				memset(readBuffer + readSize, 0, chunkSize - readSize);
+			}
+			chunkData = readBuffer;
+		}
 
-	z_stream z{};
-	if (inflateInit2(&z, -15) != Z_OK) {
-		ERROR_LOG(LOADER, "Unable to initialize inflate: %s\n", (z.msg) ? z.msg : "?");
+		jobs.clear();
+		for (u32 f = frame; f < chunkEndFrame; ++f) {
+			const u64 frameReadPos = (u64)(index[f] & 0x7FFFFFFF) << indexShift;
+			const u64 frameReadEnd = (u64)(index[f + 1] & 0x7FFFFFFF) << indexShift;
+
+			FrameJob job{};
+			job.frame = f;
+			job.rawOffset = (u32)std::min(frameReadPos - chunkReadPos, (u64)chunkSize);
+			job.rawSize = (u32)std::min(frameReadEnd - frameReadPos, (u64)(chunkSize - job.rawOffset));
+			job.blockOffset = block & (blocksPerFrame - 1);
+			job.blocks = std::min(lastBlock - block + 1, blocksPerFrame - job.blockOffset);
+			job.plain = IsPlainFrame(f, (u32)(frameReadEnd - frameReadPos));
+			job.slot = -1;
+			job.out = outPtr;
+			jobs.push_back(job);
+
+			block += job.blocks;
+			outPtr += job.blocks * blockSize;
+		}
+
+		// Partial frames (only ever the first and last) claim their cache slots first, so that
+		// nothing we look up below gets evicted before the workers read it.
+		for (FrameJob &job : jobs) {
+			if (!job.plain && job.blocks != blocksPerFrame) {
+				job.cached = LookupFrame(job.frame);
+				if (!job.cached)
+					job.slot = InsertFrame(job.frame);
+			}
+		}
+		for (FrameJob &job : jobs) {
+			if (!job.plain && job.blocks == blocksPerFrame)
+				job.cached = LookupFrame(job.frame);
+		}
+
+		auto inflateJobs = [&](int l, int h) {
+			z_stream z{};
+			bool zInit = false;
+			for (int i = l; i < h; ++i) {
+				const FrameJob &job = jobs[i];
+				const u8 *rawBuffer = chunkData + job.rawOffset;
+				if (job.plain) {
+					memcpy(job.out, rawBuffer + job.blockOffset * blockSize, job.blocks * blockSize);
+					continue;
+				}
+				if (job.cached) {
+					memcpy(job.out, job.cached + job.blockOffset * blockSize, job.blocks * blockSize);
+					continue;
+				}
+
+				u8 *dest = job.slot >= 0 ? frameCache_ + (size_t)job.slot * frameSize : job.out;
+				bool success;
+				if (lz4_) {
+					success = DecodeLZ4Frame(job.frame, rawBuffer, job.rawSize, dest, frameSize);
+				} else {
+					if (!zInit) {
+						if (inflateInit2(&z, -15) != Z_OK) {
+							ERROR_LOG(LOADER, "Unable to initialize inflate: %s\n", (z.msg) ? z.msg : "?");
+							failed = true;
+							for (; i < h; ++i)
+								memset(jobs[i].out, 0, jobs[i].blocks * blockSize);
+							return;
+						}
+						zInit = true;
+					}
+					success = InflateFrame(&z, job.frame, rawBuffer, job.rawSize, dest, frameSize);
+				}
+
+				if (!success) {
+					failed = true;
+					memset(job.out, 0, job.blocks * blockSize);
+				} else if (job.slot >= 0) {
+					memcpy(job.out, dest + job.blockOffset * blockSize, job.blocks * blockSize);
+				}
+			}
+			if (zInit)
+				inflateEnd(&z);
+		};
+
+		const int minFramesPerTask = std::max(1, (int)(CSO_PARALLEL_MIN_BYTES / frameSize));
+		ParallelRangeLoop(&g_threadManager, inflateJobs, 0, (int)jobs.size(), minFramesPerTask);
+
+		if (failed) {
+			// Don't keep partial frames that failed to inflate.  We can't tell which, so drop both.
+			for (const FrameJob &job : jobs) {
+				if (job.slot >= 0)
+					frameCacheFrame_[job.slot] = numFrames;
+			}
+		}
+
+		frame = chunkEndFrame;
+	}
+
+	if (failed) {
+		NotifyReadError();
+	}
+	return true;
+}
+
+// Seekable zstd format: ordinary zstd frames followed by a skippable frame holding a table of
+// each frame's compressed and decompressed size, which lets us decompress any frame on its own.
+
+static const u32 ZSTD_SKIPPABLE_SEEK_TABLE_MAGIC = 0x184D2A5E;
+static const u32 ZSTD_SEEKABLE_MAGIC = 0x8F92EAB1;
+static const u32 ZSTD_SEEKABLE_FOOTER_SIZE = 9;
+// Real images use frames of a few hundred KB at most.  Anything beyond this is corrupt.
+static const u32 ZSTD_SEEKABLE_MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+ZstdSeekableBlockDevice::ZstdSeekableBlockDevice(FileLoader *fileLoader)
+	: fileLoader_(fileLoader) {
+	const u64 fileSize = fileLoader->FileSize();
+	u8 footer[ZSTD_SEEKABLE_FOOTER_SIZE];
+	if (fileSize < ZSTD_SEEKABLE_FOOTER_SIZE + 8 || fileLoader->ReadAt(fileSize - sizeof(footer), 1, sizeof(footer), footer) != sizeof(footer)) {
+		ERROR_LOG(LOADER, "Unable to read zstd seek table footer");
+		return;
+	}
+
+	u32_le numFrames, magic;
+	memcpy(&numFrames, footer, 4);
+	memcpy(&magic, footer + 5, 4);
+	if (magic != ZSTD_SEEKABLE_MAGIC) {
+		ERROR_LOG(LOADER, "zstd image has no seek table, only the seekable format can be used as a disc image");
+		return;
+	}
+
+	const bool checksums = (footer[4] & 0x80) != 0;
+	const u32 entrySize = checksums ? 12 : 8;
+	const u64 tableSize = (u64)numFrames * entrySize + ZSTD_SEEKABLE_FOOTER_SIZE;
+	if (numFrames == 0 || tableSize + 8 > fileSize) {
+		ERROR_LOG(LOADER, "Invalid zstd seek table with %d frames", (u32)numFrames);
+		return;
+	}
+
+	const u64 tableStart = fileSize - tableSize - 8;
+	std::vector<u8> table((size_t)(tableSize + 8));
+	if (fileLoader->ReadAt(tableStart, 1, table.size(), &table[0]) != table.size()) {
+		ERROR_LOG(LOADER, "Unable to read zstd seek table");
+		NotifyReadError();
+		return;
+	}
+
+	u32_le skippableMagic, skippableSize;
+	memcpy(&skippableMagic, &table[0], 4);
+	memcpy(&skippableSize, &table[4], 4);
+	if (skippableMagic != ZSTD_SKIPPABLE_SEEK_TABLE_MAGIC || skippableSize != tableSize) {
+		ERROR_LOG(LOADER, "Invalid zstd seek table header");
+		return;
+	}
+
+	compressedPos_.resize(numFrames + 1);
+	decompressedPos_.resize(numFrames + 1);
+	u64 compressedPos = 0;
+	u64 decompressedPos = 0;
+	u32 maxCompressed = 0;
+	u32 maxDecompressed = 0;
+	for (u32 i = 0; i < numFrames; ++i) {
+		u32_le compressedSize, decompressedSize;
+		memcpy(&compressedSize, &table[8 + i * entrySize], 4);
+		memcpy(&decompressedSize, &table[8 + i * entrySize + 4], 4);
+		if (compressedSize > ZSTD_SEEKABLE_MAX_FRAME_SIZE || decompressedSize > ZSTD_SEEKABLE_MAX_FRAME_SIZE) {
+			ERROR_LOG(LOADER, "zstd frame %d too large (%d -> %d bytes)", i, (u32)compressedSize, (u32)decompressedSize);
+			return;
+		}
+		compressedPos_[i] = compressedPos;
+		decompressedPos_[i] = decompressedPos;
+		compressedPos += compressedSize;
+		decompressedPos += decompressedSize;
+		maxCompressed = std::max(maxCompressed, (u32)compressedSize);
+		maxDecompressed = std::max(maxDecompressed, (u32)decompressedSize);
+	}
+	compressedPos_[numFrames] = compressedPos;
+	decompressedPos_[numFrames] = decompressedPos;
+
+	if (compressedPos > tableStart) {
+		ERROR_LOG(LOADER, "Expected zstd image to at least be %lld bytes, but file is %lld bytes. File: '%s'",
+			compressedPos + tableSize + 8, fileSize, fileLoader->GetPath().c_str());
+		NotifyReadError();
+		return;
+	}
+
+	dctx_ = ZSTD_createDCtx();
+	if (!dctx_) {
+		ERROR_LOG(LOADER, "Unable to create zstd decompression context");
+		return;
+	}
+
+	readBuffer_.resize(maxCompressed);
+	frameBuffer_.resize(maxDecompressed);
+	numBlocks_ = (u32)(decompressedPos / GetBlockSize());
+	VERBOSE_LOG(LOADER, "zstd numBlocks=%i numFrames=%i", numBlocks_, (u32)numFrames);
+}
+
+ZstdSeekableBlockDevice::~ZstdSeekableBlockDevice() {
+	if (dctx_)
+		ZSTD_freeDCtx(dctx_);
+}
+
+const u8 *ZstdSeekableBlockDevice::DecompressFrame(u32 frame, bool uncached) {
+	if (frame == frameBufferFrame_)
+		return &frameBuffer_[0];
+
+	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
+	const size_t compressedSize = (size_t)(compressedPos_[frame + 1] - compressedPos_[frame]);
+	const size_t decompressedSize = (size_t)(decompressedPos_[frame + 1] - decompressedPos_[frame]);
+	if (fileLoader_->ReadAt(compressedPos_[frame], 1, compressedSize, &readBuffer_[0], flags) != compressedSize) {
+		ERROR_LOG(LOADER, "zstd frame %d: short read", frame);
+		frameBufferFrame_ = 0xFFFFFFFF;
+		return nullptr;
+	}
+
+	size_t result = ZSTD_decompressDCtx(dctx_, &frameBuffer_[0], decompressedSize, &readBuffer_[0], compressedSize);
+	if (ZSTD_isError(result) || result != decompressedSize) {
+		ERROR_LOG(LOADER, "zstd frame %d: decompression failed - %s", frame, ZSTD_isError(result) ? ZSTD_getErrorName(result) : "size mismatch");
+		frameBufferFrame_ = 0xFFFFFFFF;
+		return nullptr;
+	}
+
+	frameBufferFrame_ = frame;
+	return &frameBuffer_[0];
+}
+
+bool ZstdSeekableBlockDevice::ReadRange(u32 minBlock, int count, u8 *outPtr, bool uncached) {
+	const u64 blockSize = GetBlockSize();
+	const u64 end = std::min((u64)minBlock + count, (u64)numBlocks_) * blockSize;
+	u64 pos = (u64)minBlock * blockSize;
+	if (pos >= end) {
+		memset(outPtr, 0, (size_t)(blockSize * count));
 		return false;
 	}
+	memset(outPtr + (end - pos), 0, (size_t)(blockSize * count - (end - pos)));
+
+	// Frames are sorted by their decompressed offset, so find the one containing pos.
+	u32 frame = (u32)(std::upper_bound(decompressedPos_.begin(), decompressedPos_.end(), pos) - decompressedPos_.begin()) - 1;
+	bool failed = false;
+	while (pos < end) {
+		const u64 frameEnd = std::min(decompressedPos_[frame + 1], end);
+		if (frameEnd > pos) {
+			const size_t size = (size_t)(frameEnd - pos);
+			const u8 *data = DecompressFrame(frame, uncached);
+			if (data) {
+				memcpy(outPtr, data + (pos - decompressedPos_[frame]), size);
+			} else {
+				memset(outPtr, 0, size);
+				failed = true;
+			}
+			outPtr += size;
+			pos = frameEnd;
+		}
+		++frame;
+	}
 
-	u64 readBufferStart = 0;
-	u64 readBufferEnd = 0;
-	u32 block = minBlock;
-	const u32 blocksPerFrame = 1 << blockShift;
-	for (u32 frame = minFrameNumber; frame <= lastFrameNumber; ++frame) {
-		const u32 idx = index[frame];
-		const u32 indexPos = idx & 0x7FFFFFFF;
-		const u32 nextIndexPos = index[frame + 1] & 0x7FFFFFFF;
-
-		const u64 frameReadPos = (u64)indexPos << indexShift;
-		const u64 frameReadEnd = (u64)nextIndexPos << indexShift;
-		const u32 frameReadSize = (u32)(frameReadEnd - frameReadPos);
-		const u32 frameBlockOffset = block & ((1 << blockShift) - 1);
-		const u32 frameBlocks = std::min(lastBlock - block + 1, blocksPerFrame - frameBlockOffset);
-
-		if (frameReadEnd > readBufferEnd) {
-			const s64 maxNeeded = totalReadEnd - frameReadPos;
-			const size_t chunkSize = (size_t)std::min(maxNeeded, (s64)std::max(frameReadSize, CSO_READ_BUFFER_SIZE));
-
-			const u32 readSize = (u32)fileLoader_->ReadAt(frameReadPos, 1, chunkSize, readBuffer);
-			if (readSize < chunkSize) {
-				memset(readBuffer + readSize, 0, chunkSize - readSize);
+	if (failed) {
+		NotifyReadError();
+		return false;
+	}
+	return true;
+}
+
+bool ZstdSeekableBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
+	return ReadRange(blockNumber, 1, outPtr, uncached);
+}
+
+bool ZstdSeekableBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	return ReadRange(minBlock, count, outPtr, false);
+}
+
+// CHD (MAME's "compressed hunks of data"), v5 only.  Hunks are decoded on demand into an LRU
+// cache, and sequential reads kick off a background task that decodes the following hunks.
+
+enum {
+	CHD_COMPRESSION_TYPE_0 = 0,
+	CHD_COMPRESSION_TYPE_1 = 1,
+	CHD_COMPRESSION_TYPE_2 = 2,
+	CHD_COMPRESSION_TYPE_3 = 3,
+	CHD_COMPRESSION_NONE = 4,
+	CHD_COMPRESSION_SELF = 5,
+	CHD_COMPRESSION_PARENT = 6,
+	CHD_COMPRESSION_RLE_SMALL = 7,
+	CHD_COMPRESSION_RLE_LARGE = 8,
+	CHD_COMPRESSION_SELF_0 = 9,
+	CHD_COMPRESSION_SELF_1 = 10,
+	CHD_COMPRESSION_PARENT_SELF = 11,
+	CHD_COMPRESSION_PARENT_0 = 12,
+	CHD_COMPRESSION_PARENT_1 = 13,
+};
+
+static const u32 CHD_V5_HEADER_SIZE = 124;
+static const u32 CHD_CODEC_ZLIB = 0x7A6C6962;  // 'zlib'
+static const u32 CHD_CODEC_ZSTD = 0x7A737464;  // 'zstd'
+static const u32 CHD_MAX_HUNK_BYTES = 1024 * 1024;
+static const u32 CHD_CACHE_BYTES = 4 * 1024 * 1024;
+static const u32 CHD_PREFETCH_BYTES = 256 * 1024;
+
+static u32 ReadBE16(const u8 *p) { return (p[0] << 8) | p[1]; }
+static u32 ReadBE24(const u8 *p) { return (p[0] << 16) | (p[1] << 8) | p[2]; }
+static u32 ReadBE32(const u8 *p) { return ((u32)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+static u64 ReadBE48(const u8 *p) { return ((u64)ReadBE16(p) << 32) | ReadBE32(p + 2); }
+static u64 ReadBE64(const u8 *p) { return ((u64)ReadBE32(p) << 32) | ReadBE32(p + 4); }
+
+static void WriteBE24(u8 *p, u32 v) { p[0] = v >> 16; p[1] = v >> 8; p[2] = v; }
+static void WriteBE48(u8 *p, u64 v) { for (int i = 0; i < 6; ++i) p[i] = (u8)(v >> (40 - i * 8)); }
+static void WriteBE16(u8 *p, u32 v) { p[0] = v >> 8; p[1] = v; }
+
+static u16 CHDCrc16(const u8 *data, size_t size) {
+	u16 crc = 0xFFFF;
+	for (size_t i = 0; i < size; ++i) {
+		crc ^= data[i] << 8;
+		for (int b = 0; b < 8; ++b)
+			crc = (crc & 0x8000) ? (u16)((crc << 1) ^ 0x1021) : (u16)(crc << 1);
+	}
+	return crc;
+}
+
+// MSB first, reads past the end return zeros (check Overflowed() afterward.)
+struct CHDBitReader {
+	CHDBitReader(const u8 *data, size_t size) : data_(data), size_(size) {}
+
+	u32 Peek(int numbits) {
+		while (bits_ < numbits) {
+			u32 b = pos_ < size_ ? data_[pos_] : 0;
+			pos_++;
+			buffer_ |= b << (24 - bits_);
+			bits_ += 8;
+		}
+		return numbits == 0 ? 0 : buffer_ >> (32 - numbits);
+	}
+	void Remove(int numbits) {
+		buffer_ <<= numbits;
+		bits_ -= numbits;
+	}
+	u64 Read(int numbits) {
+		// Peek can only hold 25 bits safely, so split longer reads.
+		u64 result = 0;
+		while (numbits > 0) {
+			int n = std::min(numbits, 16);
+			result = (result << n) | Peek(n);
+			Remove(n);
+			numbits -= n;
+		}
+		return result;
+	}
+	bool Overflowed() const {
+		return pos_ - bits_ / 8 > size_;
+	}
+
+	const u8 *data_;
+	size_t size_;
+	size_t pos_ = 0;
+	u32 buffer_ = 0;
+	int bits_ = 0;
+};
+
+// The small canonical Huffman coder used for the map's compression types (16 codes, 8 bits max.)
+struct CHDMapHuffman {
+	bool ImportTreeRLE(CHDBitReader &br) {
+		int cur = 0;
+		while (cur < 16) {
+			int nodebits = (int)br.Read(4);
+			if (nodebits != 1) {
+				numbits_[cur++] = nodebits;
+				continue;
+			}
+			nodebits = (int)br.Read(4);
+			if (nodebits == 1) {
+				numbits_[cur++] = 1;
+			} else {
+				int repcount = (int)br.Read(4) + 3;
+				if (repcount + cur > 16)
+					return false;
+				while (repcount--)
+					numbits_[cur++] = nodebits;
 			}
+		}
 
-			readBufferStart = frameReadPos;
-			readBufferEnd = frameReadPos + readSize;
+		u32 histo[33]{};
+		for (int i = 0; i < 16; ++i) {
+			if (numbits_[i] > 8)
+				return false;
+			histo[numbits_[i]]++;
 		}
+		u32 curstart = 0;
+		for (int len = 32; len > 0; --len) {
+			u32 nextstart = (curstart + histo[len]) >> 1;
+			if (len != 1 && nextstart * 2 != curstart + histo[len])
+				return false;
+			histo[len] = curstart;
+			curstart = nextstart;
+		}
+
+		memset(lookup_, 0, sizeof(lookup_));
+		for (int i = 0; i < 16; ++i) {
+			if (numbits_[i] == 0)
+				continue;
+			u32 code = histo[numbits_[i]]++;
+			int shift = 8 - numbits_[i];
+			for (u32 j = code << shift; j < ((code + 1) << shift); ++j)
+				lookup_[j] = (u16)((i << 5) | numbits_[i]);
+		}
+		return true;
+	}
+
+	u8 Decode(CHDBitReader &br) {
+		u16 entry = lookup_[br.Peek(8)];
+		br.Remove(entry & 0x1F);
+		return (u8)(entry >> 5);
+	}
+
+	int numbits_[16]{};
+	u16 lookup_[256];
+};
+
+struct CHDDecoder {
+	~CHDDecoder() {
+		if (zInit)
+			inflateEnd(&z);
+		if (dctx)
+			ZSTD_freeDCtx(dctx);
+	}
+
+	z_stream z{};
+	bool zInit = false;
+	ZSTD_DCtx *dctx = nullptr;
+	std::vector<u8> compressed;
+	std::vector<u8> hunk;
+};
+
+class CHDPrefetchTask : public Task {
+public:
+	CHDPrefetchTask(CHDFileBlockDevice *device, u32 firstHunk, u32 count)
+		: device_(device), firstHunk_(firstHunk), count_(count) {}
+
+	TaskType Type() const override {
+		return TaskType::IO_BLOCKING;
+	}
+
+	void Run() override {
+		device_->Prefetch(firstHunk_, count_);
+	}
+
+	void Release() override {
+		// Also called without Run() on teardown.  The device waits for this.
+		device_->PrefetchDone();
+		delete this;
+	}
+
+private:
+	CHDFileBlockDevice *device_;
+	u32 firstHunk_;
+	u32 count_;
+};
 
-		u8 *rawBuffer = &readBuffer[frameReadPos - readBufferStart];
-		const int plain = idx & 0x80000000;
-		if (plain) {
-			memcpy(outPtr, rawBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
+CHDFileBlockDevice::CHDFileBlockDevice(FileLoader *fileLoader)
+	: fileLoader_(fileLoader) {
+	u8 header[CHD_V5_HEADER_SIZE];
+	if (fileLoader->ReadAt(0, 1, sizeof(header), header) != sizeof(header) || memcmp(header, "MComprHD", 8) != 0) {
+		ERROR_LOG(LOADER, "Invalid CHD header");
+		return;
+	}
+	const u32 version = ReadBE32(header + 12);
+	if (version != 5 || ReadBE32(header + 8) != CHD_V5_HEADER_SIZE) {
+		ERROR_LOG(LOADER, "CHD version %d unsupported, recreate it with a current chdman", version);
+		return;
+	}
+
+	for (int i = 0; i < 4; ++i) {
+		compressors_[i] = ReadBE32(header + 16 + i * 4);
+		if (compressors_[i] != 0 && compressors_[i] != CHD_CODEC_ZLIB && compressors_[i] != CHD_CODEC_ZSTD) {
+			const u32 c = compressors_[i];
+			ERROR_LOG(LOADER, "CHD codec '%c%c%c%c' unsupported, recreate it with chdman createdvd -c zstd (or zlib)", (char)(c >> 24), (char)(c >> 16), (char)(c >> 8), (char)c);
+			return;
+		}
+	}
+
+	const u64 logicalBytes = ReadBE64(header + 32);
+	const u32 unitBytes = ReadBE32(header + 60);
+	hunkBytes_ = ReadBE32(header + 56);
+	if (unitBytes != (u32)GetBlockSize()) {
+		ERROR_LOG(LOADER, "CHD unit size %d unsupported, only DVD images (chdman createdvd) can be used", unitBytes);
+		return;
+	}
+	if (hunkBytes_ == 0 || hunkBytes_ > CHD_MAX_HUNK_BYTES || (hunkBytes_ % unitBytes) != 0) {
+		ERROR_LOG(LOADER, "CHD hunk size %d unsupported", hunkBytes_);
+		return;
+	}
+	const u64 hunkCount = (logicalBytes + hunkBytes_ - 1) / hunkBytes_;
+	if (hunkCount == 0 || hunkCount >= 0x7FFFFFFF) {
+		ERROR_LOG(LOADER, "Invalid CHD size %lld", logicalBytes);
+		return;
+	}
+	hunkCount_ = (u32)hunkCount;
+
+	if (!ReadMap(header)) {
+		NotifyReadError();
+		return;
+	}
+
+	decoder_ = new CHDDecoder();
+	decoder_->hunk.resize(hunkBytes_);
+
+	const u32 cacheHunks = std::max(8U, std::min(CHD_CACHE_BYTES / hunkBytes_, 1024U));
+	hunkCache_.resize((size_t)cacheHunks * hunkBytes_);
+	cacheHunk_.resize(cacheHunks, 0xFFFFFFFF);
+	cacheLastUse_.resize(cacheHunks, 0);
+	prefetchHunks_ = std::max(1U, std::min(CHD_PREFETCH_BYTES / hunkBytes_, cacheHunks / 2));
+
+	numBlocks_ = (u32)(logicalBytes / GetBlockSize());
+	VERBOSE_LOG(LOADER, "CHD numBlocks=%i hunkBytes=%i hunks=%i", numBlocks_, hunkBytes_, hunkCount_);
+}
+
+CHDFileBlockDevice::~CHDFileBlockDevice() {
+	prefetchCancel_ = true;
+	std::unique_lock<std::mutex> guard(lock_);
+	while (prefetchRunning_)
+		prefetchCond_.wait(guard);
+	guard.unlock();
+	delete decoder_;
+}
+
+bool CHDFileBlockDevice::ReadMap(const u8 *header) {
+	const u64 mapOffset = ReadBE64(header + 40);
+	map_.resize((size_t)hunkCount_ * 12);
+
+	if (compressors_[0] == 0) {
+		// Uncompressed images just have a table of hunk positions.  Zero means an empty hunk.
+		std::vector<u8> raw((size_t)hunkCount_ * 4);
+		if (fileLoader_->ReadAt(mapOffset, 1, raw.size(), &raw[0]) != raw.size()) {
+			ERROR_LOG(LOADER, "Unable to read CHD map");
+			return false;
+		}
+		for (u32 i = 0; i < hunkCount_; ++i) {
+			u8 *entry = &map_[i * 12];
+			const u64 offset = (u64)ReadBE32(&raw[i * 4]) * hunkBytes_;
+			entry[0] = CHD_COMPRESSION_NONE;
+			WriteBE24(entry + 1, offset != 0 ? hunkBytes_ : 0);
+			WriteBE48(entry + 4, offset);
+			WriteBE16(entry + 10, 0);
+		}
+		return true;
+	}
+
+	u8 mapHeader[16];
+	if (fileLoader_->ReadAt(mapOffset, 1, sizeof(mapHeader), mapHeader) != sizeof(mapHeader)) {
+		ERROR_LOG(LOADER, "Unable to read CHD map header");
+		return false;
+	}
+	const u32 mapBytes = ReadBE32(mapHeader);
+	const u64 firstOffset = ReadBE48(mapHeader + 4);
+	const u16 mapCrc = (u16)ReadBE16(mapHeader + 10);
+	const int lengthBits = mapHeader[12];
+	const int selfBits = mapHeader[13];
+	const int parentBits = mapHeader[14];
+	if (mapBytes > hunkCount_ * 16 + 1024) {
+		ERROR_LOG(LOADER, "CHD map too large (%d bytes)", mapBytes);
+		return false;
+	}
+
+	std::vector<u8> compressed(mapBytes);
+	if (mapBytes == 0 || fileLoader_->ReadAt(mapOffset + sizeof(mapHeader), 1, mapBytes, &compressed[0]) != mapBytes) {
+		ERROR_LOG(LOADER, "Unable to read CHD map");
+		return false;
+	}
+
+	CHDBitReader br(&compressed[0], compressed.size());
+	CHDMapHuffman huffman;
+	if (!huffman.ImportTreeRLE(br)) {
+		ERROR_LOG(LOADER, "Invalid CHD map tree");
+		return false;
+	}
+
+	// First all the compression types, run length encoded.
+	int repcount = 0;
+	u8 lastComp = 0;
+	for (u32 i = 0; i < hunkCount_; ++i) {
+		u8 *entry = &map_[i * 12];
+		if (repcount > 0) {
+			entry[0] = lastComp;
+			repcount--;
+			continue;
+		}
+		u8 val = huffman.Decode(br);
+		if (val == CHD_COMPRESSION_RLE_SMALL) {
+			entry[0] = lastComp;
+			repcount = 2 + huffman.Decode(br);
+		} else if (val == CHD_COMPRESSION_RLE_LARGE) {
+			entry[0] = lastComp;
+			repcount = 2 + 16 + (huffman.Decode(br) << 4);
+			repcount += huffman.Decode(br);
 		} else {
-			z.avail_in = frameReadSize;
-			z.next_out = frameBlocks == blocksPerFrame ? outPtr : zlibBuffer;
-			z.avail_out = frameSize;
-			z.next_in = rawBuffer;
-
-			int status = inflate(&z, Z_FINISH);
-			if (status != Z_STREAM_END) {
-				ERROR_LOG(LOADER, "Inflate frame %d: failed - %s[%d]\n", frame, (z.msg) ? z.msg : "error", status);
-				NotifyReadError();
-				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (z.total_out != frameSize) {
-				ERROR_LOG(LOADER, "Inflate frame %d: block size error %d != %d\n", frame, (u32)z.total_out, frameSize);
-				NotifyReadError();
-				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (frameBlocks != blocksPerFrame) {
-				memcpy(outPtr, zlibBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
-				// In case we end up reusing it in a single read later.
-				zlibBufferFrame = frame;
+			entry[0] = lastComp = val;
+		}
+	}
+
+	// Then the lengths, offsets and crcs of each hunk, resolving the pseudo types.
+	u64 curOffset = firstOffset;
+	u64 lastSelf = 0;
+	u64 lastParent = 0;
+	for (u32 i = 0; i < hunkCount_; ++i) {
+		u8 *entry = &map_[i * 12];
+		u64 offset = curOffset;
+		u32 length = 0;
+		u16 crc = 0;
+		switch (entry[0]) {
+		case CHD_COMPRESSION_TYPE_0:
+		case CHD_COMPRESSION_TYPE_1:
+		case CHD_COMPRESSION_TYPE_2:
+		case CHD_COMPRESSION_TYPE_3:
+			length = (u32)br.Read(lengthBits);
+			curOffset += length;
+			crc = (u16)br.Read(16);
+			break;
+		case CHD_COMPRESSION_NONE:
+			length = hunkBytes_;
+			curOffset += length;
+			crc = (u16)br.Read(16);
+			break;
+		case CHD_COMPRESSION_SELF:
+			lastSelf = offset = br.Read(selfBits);
+			break;
+		case CHD_COMPRESSION_PARENT:
+			lastParent = offset = br.Read(parentBits);
+			break;
+		case CHD_COMPRESSION_SELF_1:
+			lastSelf++;
+			// Fall through
+		case CHD_COMPRESSION_SELF_0:
+			entry[0] = CHD_COMPRESSION_SELF;
+			offset = lastSelf;
+			break;
+		case CHD_COMPRESSION_PARENT_SELF:
+			entry[0] = CHD_COMPRESSION_PARENT;
+			lastParent = offset = ((u64)i * hunkBytes_) / GetBlockSize();
+			break;
+		case CHD_COMPRESSION_PARENT_1:
+			lastParent += hunkBytes_ / GetBlockSize();
+			// Fall through
+		case CHD_COMPRESSION_PARENT_0:
+			entry[0] = CHD_COMPRESSION_PARENT;
+			offset = lastParent;
+			break;
+		default:
+			ERROR_LOG(LOADER, "Invalid CHD map entry %d type %d", i, entry[0]);
+			return false;
+		}
+		WriteBE24(entry + 1, length);
+		WriteBE48(entry + 4, offset);
+		WriteBE16(entry + 10, crc);
+	}
+
+	if (br.Overflowed() || CHDCrc16(&map_[0], map_.size()) != mapCrc) {
+		ERROR_LOG(LOADER, "CHD map is corrupt");
+		return false;
+	}
+	return true;
+}
+
+bool CHDFileBlockDevice::DecodeHunk(u32 hunk, u8 *dest, CHDDecoder &decoder, bool uncached, int depth) {
+	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
+	const u8 *entry = &map_[(size_t)hunk * 12];
+	const u32 length = ReadBE24(entry + 1);
+	const u64 offset = ReadBE48(entry + 4);
+
+	switch (entry[0]) {
+	case CHD_COMPRESSION_TYPE_0:
+	case CHD_COMPRESSION_TYPE_1:
+	case CHD_COMPRESSION_TYPE_2:
+	case CHD_COMPRESSION_TYPE_3:
+	{
+		if (length > hunkBytes_) {
+			ERROR_LOG(LOADER, "CHD hunk %d: compressed size %d too large", hunk, length);
+			return false;
+		}
+		decoder.compressed.resize(hunkBytes_);
+		if (fileLoader_->ReadAt(offset, 1, length, &decoder.compressed[0], flags) != length) {
+			ERROR_LOG(LOADER, "CHD hunk %d: short read", hunk);
+			return false;
+		}
+
+		const u32 codec = compressors_[entry[0]];
+		if (codec == CHD_CODEC_ZLIB) {
+			if (!decoder.zInit) {
+				if (inflateInit2(&decoder.z, -15) != Z_OK) {
+					ERROR_LOG(LOADER, "Unable to initialize inflate: %s\n", (decoder.z.msg) ? decoder.z.msg : "?");
+					return false;
+				}
+				decoder.zInit = true;
+			}
+			inflateReset(&decoder.z);
+			decoder.z.next_in = &decoder.compressed[0];
+			decoder.z.avail_in = length;
+			decoder.z.next_out = dest;
+			decoder.z.avail_out = hunkBytes_;
+			int status = inflate(&decoder.z, Z_SYNC_FLUSH);
+			if ((status != Z_OK && status != Z_STREAM_END) || decoder.z.total_out != hunkBytes_) {
+				ERROR_LOG(LOADER, "CHD hunk %d: inflate failed - %s[%d]", hunk, (decoder.z.msg) ? decoder.z.msg : "error", status);
+				return false;
+			}
+		} else if (codec == CHD_CODEC_ZSTD) {
+			if (!decoder.dctx)
+				decoder.dctx = ZSTD_createDCtx();
+			size_t result = decoder.dctx ? ZSTD_decompressDCtx(decoder.dctx, dest, hunkBytes_, &decoder.compressed[0], length) : 0;
+			if (!decoder.dctx || ZSTD_isError(result) || result != hunkBytes_) {
+				ERROR_LOG(LOADER, "CHD hunk %d: zstd decompression failed - %s", hunk, decoder.dctx && ZSTD_isError(result) ? ZSTD_getErrorName(result) : "size mismatch");
+				return false;
 			}
+		} else {
+			ERROR_LOG(LOADER, "CHD hunk %d: no codec for type %d", hunk, entry[0]);
+			return false;
+		}
+		return true;
+	}
+
+	case CHD_COMPRESSION_NONE:
+		if (length == 0) {
+			memset(dest, 0, hunkBytes_);
+			return true;
+		}
+		if (fileLoader_->ReadAt(offset, 1, hunkBytes_, dest, flags) != hunkBytes_) {
+			ERROR_LOG(LOADER, "CHD hunk %d: short read", hunk);
+			return false;
+		}
+		return true;
+
+	case CHD_COMPRESSION_SELF:
+		// A copy of an earlier hunk.  Those can't chain far, but don't trust the file.
+		if (offset >= hunk || depth >= 8) {
+			ERROR_LOG(LOADER, "CHD hunk %d: invalid self reference to %d", hunk, (int)offset);
+			return false;
+		}
+		return DecodeHunk((u32)offset, dest, decoder, uncached, depth + 1);
+
+	case CHD_COMPRESSION_PARENT:
+	default:
+		ERROR_LOG(LOADER, "CHD hunk %d: parent CHDs are not supported", hunk);
+		return false;
+	}
+}
+
+void CHDFileBlockDevice::InsertHunk(u32 hunk, const u8 *data) {
+	if (cacheSlots_.find(hunk) != cacheSlots_.end())
+		return;
+
+	u32 slot = 0;
+	for (u32 i = 1; i < (u32)cacheHunk_.size(); ++i) {
+		if (cacheLastUse_[i] < cacheLastUse_[slot])
+			slot = i;
+	}
+	if (cacheHunk_[slot] != 0xFFFFFFFF)
+		cacheSlots_.erase(cacheHunk_[slot]);
+
+	cacheHunk_[slot] = hunk;
+	cacheLastUse_[slot] = ++cacheCounter_;
+	cacheSlots_[hunk] = slot;
+	memcpy(&hunkCache_[(size_t)slot * hunkBytes_], data, hunkBytes_);
+}
+
+bool CHDFileBlockDevice::ReadFromHunk(u32 hunk, u32 offset, u32 size, u8 *outPtr, bool uncached) {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = cacheSlots_.find(hunk);
+		if (it != cacheSlots_.end()) {
+			cacheLastUse_[it->second] = ++cacheCounter_;
+			memcpy(outPtr, &hunkCache_[(size_t)it->second * hunkBytes_ + offset], size);
+			return true;
+		}
+	}
+
+	// Decode outside the lock, the prefetcher may be busy with the next hunks.
+	u8 *data = &decoder_->hunk[0];
+	if (!DecodeHunk(hunk, data, *decoder_, uncached, 0))
+		return false;
+	memcpy(outPtr, data + offset, size);
+
+	std::lock_guard<std::mutex> guard(lock_);
+	InsertHunk(hunk, data);
+	return true;
+}
+
+void CHDFileBlockDevice::StartPrefetch(u32 firstHunk) {
+	if (firstHunk >= hunkCount_ || !g_threadManager.IsInitialized())
+		return;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	if (prefetchRunning_)
+		return;
+	// Nothing to do if we already have the next hunk, probably from the last prefetch.
+	if (cacheSlots_.find(firstHunk) != cacheSlots_.end())
+		return;
+	prefetchRunning_ = true;
+	g_threadManager.EnqueueTask(new CHDPrefetchTask(this, firstHunk, std::min(prefetchHunks_, hunkCount_ - firstHunk)));
+}
 
-			inflateReset(&z);
+void CHDFileBlockDevice::Prefetch(u32 firstHunk, u32 count) {
+	CHDDecoder decoder;
+	decoder.hunk.resize(hunkBytes_);
+	for (u32 hunk = firstHunk; hunk < firstHunk + count; ++hunk) {
+		if (prefetchCancel_)
+			break;
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			if (cacheSlots_.find(hunk) != cacheSlots_.end())
+				continue;
 		}
+		if (!DecodeHunk(hunk, &decoder.hunk[0], decoder, false, 0))
+			break;
+		std::lock_guard<std::mutex> guard(lock_);
+		InsertHunk(hunk, &decoder.hunk[0]);
+	}
+}
 
-		block += frameBlocks;
-		outPtr += frameBlocks * GetBlockSize();
+void CHDFileBlockDevice::PrefetchDone() {
+	std::lock_guard<std::mutex> guard(lock_);
+	prefetchRunning_ = false;
+	prefetchCond_.notify_all();
+}
+
+bool CHDFileBlockDevice::ReadRange(u32 minBlock, int count, u8 *outPtr, bool uncached) {
+	const u64 blockSize = GetBlockSize();
+	const u64 end = std::min((u64)minBlock + count, (u64)numBlocks_) * blockSize;
+	u64 pos = (u64)minBlock * blockSize;
+	if (pos >= end) {
+		memset(outPtr, 0, (size_t)(blockSize * count));
+		return false;
+	}
+	memset(outPtr + (end - pos), 0, (size_t)(blockSize * count - (end - pos)));
+
+	const u32 firstHunk = (u32)(pos / hunkBytes_);
+	bool failed = false;
+	while (pos < end) {
+		const u32 hunk = (u32)(pos / hunkBytes_);
+		const u32 offset = (u32)(pos % hunkBytes_);
+		const u32 size = (u32)std::min((u64)(hunkBytes_ - offset), end - pos);
+		if (!ReadFromHunk(hunk, offset, size, outPtr, uncached)) {
+			memset(outPtr, 0, size);
+			failed = true;
+		}
+		outPtr += size;
+		pos += size;
 	}
 
-	inflateEnd(&z);
+	// Streaming (or the ISO reader walking a file) reads forward, so decode ahead.
+	const u32 lastHunk = (u32)((end - 1) / hunkBytes_);
+	if (!uncached && (firstHunk == lastReadHunk_ || firstHunk == lastReadHunk_ + 1))
+		StartPrefetch(lastHunk + 1);
+	lastReadHunk_ = lastHunk;
+
+	if (failed) {
+		NotifyReadError();
+		return false;
+	}
 	return true;
 }
 
+bool CHDFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
+	return ReadRange(blockNumber, 1, outPtr, uncached);
+}
+
+bool CHDFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	return ReadRange(minBlock, count, outPtr, false);
+}
+
 NPDRMDemoBlockDevice::NPDRMDemoBlockDevice(FileLoader *fileLoader)
 	: fileLoader_(fileLoader)
 {
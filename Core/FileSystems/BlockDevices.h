@@ -18,17 +18,25 @@
 #pragma once
 
 // Abstractions around read-only blockdevices, such as PSP UMD discs.
-// CISOFileBlockDevice implements compressed iso images, CISO format.
+// CISOFileBlockDevice implements compressed iso images, CISO format (and ZSO, its LZ4 variant).
+// ZstdSeekableBlockDevice implements zstd images written in the seekable frame format.
+// CHDFileBlockDevice implements MAME's CHD v5 format, as written by chdman createdvd.
 //
 // The ISOFileSystemReader reads from a BlockDevice, so it automatically works
 // with CISO images.
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Core/ELF/PBPReader.h"
 
 class FileLoader;
+struct z_stream_s;
+struct ZSTD_DCtx_s;
 
 class BlockDevice {
 public:
@@ -64,20 +72,112 @@ class CISOFileBlockDevice : public BlockDevice {
 	bool IsDisc() override { return true; }
 
 private:
+	enum {
+		FRAME_CACHE_SIZE = 32,
+	};
+
+	bool IsPlainFrame(u32 frame, u32 compressedSize) const;
+	const u8 *LookupFrame(u32 frame);
+	int InsertFrame(u32 frame);
+
 	FileLoader *fileLoader_;
 	u32 *index;
 	u8 *readBuffer;
-	u8 *zlibBuffer;
-	u32 zlibBufferFrame;
+	u32 readBufferSize;
+	z_stream_s *zstream_ = nullptr;
+	// Recently decompressed frames, least recently used is replaced first.
+	u8 *frameCache_ = nullptr;
+	u32 frameCacheFrame_[FRAME_CACHE_SIZE];
+	u64 frameCacheLastUse_[FRAME_CACHE_SIZE];
+	u64 frameCacheCounter_ = 0;
 	u8 indexShift;
 	u8 blockShift;
 	u32 frameSize;
 	u32 numBlocks;
 	u32 numFrames;
 	int ver_;
+	bool lz4_ = false;
+};
+
+class ZstdSeekableBlockDevice : public BlockDevice {
+public:
+	ZstdSeekableBlockDevice(FileLoader *fileLoader);
+	~ZstdSeekableBlockDevice();
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
+	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	u32 GetNumBlocks() override { return numBlocks_; }
+	bool IsDisc() override { return true; }
+
+	// False if the file has no seek table, in which case it can't be used.
+	bool IsValid() const { return numBlocks_ != 0; }
+
+private:
+	bool ReadRange(u32 minBlock, int count, u8 *outPtr, bool uncached);
+	const u8 *DecompressFrame(u32 frame, bool uncached);
+
+	FileLoader *fileLoader_;
+	ZSTD_DCtx_s *dctx_ = nullptr;
+	// Offsets of each frame, plus one past the end.
+	std::vector<u64> compressedPos_;
+	std::vector<u64> decompressedPos_;
+	std::vector<u8> readBuffer_;
+	std::vector<u8> frameBuffer_;
+	u32 frameBufferFrame_ = 0xFFFFFFFF;
+	u32 numBlocks_ = 0;
 };
 
 
+struct CHDDecoder;
+
+class CHDFileBlockDevice : public BlockDevice {
+public:
+	CHDFileBlockDevice(FileLoader *fileLoader);
+	~CHDFileBlockDevice();
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
+	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	u32 GetNumBlocks() override { return numBlocks_; }
+	bool IsDisc() override { return true; }
+
+	// False if the header or map couldn't be parsed, or it uses codecs we can't decode.
+	bool IsValid() const { return numBlocks_ != 0; }
+
+private:
+	bool ReadMap(const u8 *header);
+	bool ReadRange(u32 minBlock, int count, u8 *outPtr, bool uncached);
+	bool ReadFromHunk(u32 hunk, u32 offset, u32 size, u8 *outPtr, bool uncached);
+	bool DecodeHunk(u32 hunk, u8 *dest, CHDDecoder &decoder, bool uncached, int depth);
+	// Call with lock_ held.
+	void InsertHunk(u32 hunk, const u8 *data);
+
+	void StartPrefetch(u32 firstHunk);
+	void Prefetch(u32 firstHunk, u32 count);
+	void PrefetchDone();
+	friend class CHDPrefetchTask;
+
+	FileLoader *fileLoader_;
+	u32 compressors_[4]{};
+	u32 hunkBytes_ = 0;
+	u32 hunkCount_ = 0;
+	u32 numBlocks_ = 0;
+	// 12 bytes per hunk, same layout as libchdr's expanded map.
+	std::vector<u8> map_;
+	// Only used by the reading thread.
+	CHDDecoder *decoder_ = nullptr;
+	u32 lastReadHunk_ = 0xFFFFFFFF;
+
+	// Decompressed hunks, shared with the prefetch task.
+	std::mutex lock_;
+	std::vector<u8> hunkCache_;
+	std::vector<u32> cacheHunk_;
+	std::vector<u64> cacheLastUse_;
+	std::unordered_map<u32, u32> cacheSlots_;
+	u64 cacheCounter_ = 0;
+	u32 prefetchHunks_ = 0;
+	bool prefetchRunning_ = false;
+	std::atomic<bool> prefetchCancel_{};
+	std::condition_variable prefetchCond_;
+};
+
 class FileBlockDevice : public BlockDevice {
 public:
 	FileBlockDevice(FileLoader *fileLoader);
@@ -37,6 +37,7 @@
 #include "Common/File/DiskFree.h"
 #include "Common/File/VFS/VFS.h"
 #include "Common/SysError.h"
+#include "Common/TimeUtil.h"
 #include "Core/FileSystems/DirectoryFileSystem.h"
 #include "Core/FileSystems/ISOFileSystem.h"
 #include "Core/HLE/sceKernel.h"
@@ -69,6 +70,51 @@
 #include <fcntl.h>
 #endif
 
+// Listings older than this are reloaded, so changes made outside the emulator show up.
+static const double LISTING_CACHE_EXPIRE_SECONDS = 2.0;
+// Dropped all at once when full, these are cheap to reload.
+static const size_t LISTING_CACHE_MAX_DIRS = 64;
+
+static const FileAccess FILEACCESS_MODIFY = (FileAccess)(FILEACCESS_WRITE | FILEACCESS_APPEND | FILEACCESS_CREATE | FILEACCESS_TRUNCATE);
+
+static std::string LowerCase(std::string str) {
+	std::transform(str.begin(), str.end(), str.begin(), [](char c) {
+		return (char)tolower((unsigned char)c);
+	});
+	return str;
+}
+
+// Lowercase, with duplicate and trailing slashes removed, so every spelling of a directory matches.
+static std::string ListingCacheKey(const std::string &path) {
+	std::string key;
+	key.reserve(path.size() + 1);
+	for (size_t i = 0; i < path.size(); ++i) {
+		if (path[i] == '/')
+			continue;
+		if (i == 0 || path[i - 1] == '/')
+			key.push_back('/');
+		key.push_back((char)tolower((unsigned char)path[i]));
+	}
+	return key;
+}
+
+// Splits off the last component of a path.  Fails for the root, which has no parent listing.
+static bool SplitListingPath(const std::string &path, std::string &dirPath, std::string &name) {
+	size_t end = path.find_last_not_of('/');
+	if (end == path.npos)
+		return false;
+
+	size_t slash = path.find_last_of('/', end);
+	if (slash == path.npos) {
+		dirPath.clear();
+		name = path.substr(0, end + 1);
+	} else {
+		dirPath = path.substr(0, slash);
+		name = path.substr(slash + 1, end - slash);
+	}
+	return true;
+}
+
 DirectoryFileSystem::DirectoryFileSystem(IHandleAllocator *_hAlloc, const Path & _basePath, FileSystemFlags _flags) : basePath(_basePath), flags(_flags) {
 	File::CreateFullPath(basePath);
 	hAlloc = _hAlloc;
@@ -112,6 +158,66 @@ Path DirectoryFileSystem::GetLocalPath(std::string internalPath) const {
 	return basePath / internalPath;
 }
 
+const File::FileInfo *DirectoryFileSystem::ListingCacheEntry::Find(const std::string &name) const {
+	auto it = lookup.find(name);
+	if (it == lookup.end())
+		it = lookup.find(LowerCase(name));
+	return it != lookup.end() ? &files[it->second] : nullptr;
+}
+
+const DirectoryFileSystem::ListingCacheEntry &DirectoryFileSystem::GetCachedListing(std::string dirPath) {
+	std::string key = ListingCacheKey(dirPath);
+	double now = time_now_d();
+	auto it = listingCache_.find(key);
+	if (it != listingCache_.end() && now - it->second.loadedTime < LISTING_CACHE_EXPIRE_SECONDS)
+		return it->second;
+
+	if (it == listingCache_.end() && listingCache_.size() >= LISTING_CACHE_MAX_DIRS)
+		listingCache_.clear();
+
+	ListingCacheEntry &listing = listingCache_[key];
+	listing = ListingCacheEntry();
+	listing.loadedTime = now;
+
+	const int getFlags = File::GETFILES_GETHIDDEN | File::GETFILES_GET_NAVIGATION_ENTRIES;
+	listing.exists = File::GetFilesInDir(GetLocalPath(dirPath), &listing.files, nullptr, getFlags);
+#if HOST_IS_CASE_SENSITIVE
+	if (!listing.exists && FixPathCase(basePath, dirPath, FPC_FILE_MUST_EXIST)) {
+		// May have failed due to case sensitivity, try again.
+		listing.files.clear();
+		listing.exists = File::GetFilesInDir(GetLocalPath(dirPath), &listing.files, nullptr, getFlags);
+	}
+#endif
+
+	// Exact names win over case insensitive matches, in case the host has both.
+	for (size_t i = 0; i < listing.files.size(); ++i) {
+		listing.lookup.emplace(listing.files[i].name, i);
+	}
+	for (size_t i = 0; i < listing.files.size(); ++i) {
+		listing.lookup.emplace(LowerCase(listing.files[i].name), i);
+	}
+	return listing;
+}
+
+void DirectoryFileSystem::InvalidateListing(const std::string &path, bool recursive) {
+	std::string key = ListingCacheKey(path);
+	size_t slash = key.find_last_of('/');
+	if (slash != key.npos)
+		listingCache_.erase(key.substr(0, slash));
+
+	if (recursive) {
+		// Also drop the directory itself and anything under it.
+		std::string prefix = key + "/";
+		for (auto it = listingCache_.begin(); it != listingCache_.end(); ) {
+			if (it->first == key || startsWith(it->first, prefix)) {
+				it = listingCache_.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+}
+
 bool DirectoryFileHandle::Open(const Path &basePath, std::string &fileName, FileAccess access, u32 &error) {
 	error = 0;
 
@@ -455,6 +561,7 @@ bool DirectoryFileSystem::MkDir(const std::string &dirname) {
 #else
 	result = File::CreateFullPath(GetLocalPath(dirname));
 #endif
+	InvalidateListing(dirname, true);
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::MKDIR, result, CoreTiming::GetGlobalTimeUs()) != 0;
 }
@@ -465,6 +572,7 @@ bool DirectoryFileSystem::RmDir(const std::string &dirname) {
 #if HOST_IS_CASE_SENSITIVE
 	// Maybe we're lucky?
 	if (File::DeleteDirRecursively(fullName)) {
+		InvalidateListing(dirname, true);
 		MemoryStick_NotifyWrite();
 		return (bool)ReplayApplyDisk(ReplayAction::RMDIR, true, CoreTiming::GetGlobalTimeUs());
 	}
@@ -478,6 +586,7 @@ bool DirectoryFileSystem::RmDir(const std::string &dirname) {
 #endif
 
 	bool result = File::DeleteDirRecursively(fullName);
+	InvalidateListing(dirname, true);
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::RMDIR, result, CoreTiming::GetGlobalTimeUs()) != 0;
 }
@@ -526,6 +635,8 @@ int DirectoryFileSystem::RenameFile(const std::string &from, const std::string &
 
 	// TODO: Better error codes.
 	int result = retValue ? 0 : (int)SCE_KERNEL_ERROR_ERRNO_FILE_ALREADY_EXISTS;
+	InvalidateListing(from, true);
+	InvalidateListing(fullTo, true);
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::FILE_RENAME, result, CoreTiming::GetGlobalTimeUs());
 }
@@ -548,6 +659,7 @@ bool DirectoryFileSystem::RemoveFile(const std::string &filename) {
 	}
 #endif
 
+	InvalidateListing(filename);
 	MemoryStick_NotifyWrite();
 	return ReplayApplyDisk(ReplayAction::FILE_REMOVE, retValue, CoreTiming::GetGlobalTimeUs()) != 0;
 }
@@ -587,6 +699,9 @@ int DirectoryFileSystem::OpenFile(std::string filename, FileAccess access, const
 		entry.access = access;
 
 		entries[newHandle] = entry;
+		if (access & FILEACCESS_MODIFY) {
+			InvalidateListing(filename);
+		}
 
 		return newHandle;
 	}
@@ -597,6 +712,10 @@ void DirectoryFileSystem::CloseFile(u32 handle) {
 	if (iter != entries.end()) {
 		hAlloc->FreeHandle(handle);
 		iter->second.hFile.Close();
+		// Closing may truncate the file.
+		if (iter->second.access & FILEACCESS_MODIFY) {
+			InvalidateListing(iter->second.guestFilename);
+		}
 		entries.erase(iter);
 	} else {
 		//This shouldn't happen...
@@ -648,6 +767,7 @@ size_t DirectoryFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, i
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		size_t bytesWritten = iter->second.hFile.Write(pointer,size);
+		InvalidateListing(iter->second.guestFilename);
 		return bytesWritten;
 	} else {
 		//This shouldn't happen...
@@ -671,6 +791,32 @@ PSPFileInfo DirectoryFileSystem::GetFileInfo(std::string filename) {
 	PSPFileInfo x;
 	x.name = filename;
 
+	std::string dirPath, name;
+	if (SplitListingPath(filename, dirPath, name)) {
+		// Look it up in the parent's listing, which saves a round trip to the host for each stat.
+		const File::FileInfo *info = GetCachedListing(dirPath).Find(name);
+		if (!info)
+			return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
+
+		x.type = info->isDirectory ? FILETYPE_DIRECTORY : FILETYPE_NORMAL;
+		x.exists = true;
+
+		if (x.type != FILETYPE_DIRECTORY) {
+			x.size = info->size;
+			x.access = info->access;
+			time_t atime = info->atime;
+			time_t ctime = info->ctime;
+			time_t mtime = info->mtime;
+
+			localtime_r((time_t*)&atime, &x.atime);
+			localtime_r((time_t*)&ctime, &x.ctime);
+			localtime_r((time_t*)&mtime, &x.mtime);
+		}
+
+		return ReplayApplyDiskFileInfo(x, CoreTiming::GetGlobalTimeUs());
+	}
+
+	// Only the root gets here.
 	Path fullName = GetLocalPath(filename);
 	if (!File::Exists(fullName)) {
 #if HOST_IS_CASE_SENSITIVE
@@ -798,23 +944,12 @@ bool DirectoryFileSystem::ComputeRecursiveDirSizeIfFast(const std::string &path,
 std::vector<PSPFileInfo> DirectoryFileSystem::GetDirListing(std::string path) {
 	std::vector<PSPFileInfo> myVector;
 
-	std::vector<File::FileInfo> files;
-	Path localPath = GetLocalPath(path);
-	const int flags = File::GETFILES_GETHIDDEN | File::GETFILES_GET_NAVIGATION_ENTRIES;
-	if (!File::GetFilesInDir(localPath, &files, nullptr, flags)) {
-		// TODO: Case sensitivity should be checked on a file system basis, right?
-#if HOST_IS_CASE_SENSITIVE
-		if (FixPathCase(basePath, path, FPC_FILE_MUST_EXIST)) {
-			// May have failed due to case sensitivity, try again
-			localPath = GetLocalPath(path);
-			if (!File::GetFilesInDir(localPath, &files, nullptr, 0)) {
-				return ReplayApplyDiskListing(myVector, CoreTiming::GetGlobalTimeUs());
-			}
-		}
-#else
+	// TODO: Case sensitivity should be checked on a file system basis, right?
+	const ListingCacheEntry &listing = GetCachedListing(path);
+	if (!listing.exists) {
 		return ReplayApplyDiskListing(myVector, CoreTiming::GetGlobalTimeUs());
-#endif
 	}
+	const std::vector<File::FileInfo> &files = listing.files;
 
 	bool hideISOFiles = PSP_CoreParameter().compat.flags().HideISOFiles;
 
@@ -891,6 +1026,7 @@ void DirectoryFileSystem::DoState(PointerWrap &p) {
 
 	if (p.mode == p.MODE_READ) {
 		CloseAll();
+		listingCache_.clear();
 		u32 key;
 		OpenFileEntry entry;
 		entry.hFile.fileSystemFlags_ = flags;
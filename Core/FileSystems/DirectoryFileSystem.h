@@ -20,7 +20,10 @@
 // TODO: Remove the Windows-specific code, FILE is fine there too.
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 
+#include "Common/File/DirListing.h"
 #include "Common/File/Path.h"
 #include "Core/FileSystems/FileSystem.h"
 
@@ -94,13 +97,29 @@ class DirectoryFileSystem : public IFileSystem {
 		FileAccess access = FILEACCESS_NONE;
 	};
 
+	// Host listings of recently used directories, so getstat doesn't have to hit the host every time.
+	// Writes through this file system invalidate them, and they expire so outside changes show up.
+	struct ListingCacheEntry {
+		bool exists = false;
+		double loadedTime = 0.0;
+		std::vector<File::FileInfo> files;
+		// Lowercase name -> index in files.
+		std::unordered_map<std::string, size_t> lookup;
+
+		const File::FileInfo *Find(const std::string &name) const;
+	};
+
 	typedef std::map<u32, OpenFileEntry> EntryMap;
 	EntryMap entries;
 	Path basePath;
 	IHandleAllocator *hAlloc;
 	FileSystemFlags flags;
+	std::unordered_map<std::string, ListingCacheEntry> listingCache_;
 
 	Path GetLocalPath(std::string internalPath) const;
+
+	const ListingCacheEntry &GetCachedListing(std::string dirPath);
+	void InvalidateListing(const std::string &path, bool recursive = false);
 };
 
 // VFSFileSystem: Ability to map in Android APK paths as well! Does not support all features, only meant for fonts.
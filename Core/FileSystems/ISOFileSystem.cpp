@@ -20,13 +20,17 @@
 #include <ctype.h>
 #include <algorithm>
 
+#include "ext/xxhash.h"
 #include "Common/CommonTypes.h"
+#include "Common/File/FileUtil.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/StringUtils.h"
 #include "Core/FileSystems/ISOFileSystem.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/MemMap.h"
 #include "Core/Reporting.h"
+#include "Core/System.h"
 
 const int sectorSize = 2048;
 
@@ -155,7 +159,7 @@ ISOFileSystem::ISOFileSystem(IHandleAllocator *_hAlloc, BlockDevice *_blockDevic
 	entireISO.flags = 0;
 	entireISO.parent = NULL;
 
-	treeroot = new TreeEntry();
+	treeroot = NewEntry();
 	treeroot->isDirectory = true;
 	treeroot->startingPosition = 0;
 	treeroot->size = 0;
@@ -170,11 +174,22 @@ ISOFileSystem::ISOFileSystem(IHandleAllocator *_hAlloc, BlockDevice *_blockDevic
 
 	treeroot->startsector = desc.root.firstDataSector;
 	treeroot->dirsize = desc.root.dataLength;
+
+	// The volume descriptor includes the volume id and creation time, good enough to tell discs apart.
+	discHash_ = XXH3_64bits_withSeed(&desc, sizeof(desc), blockDevice->GetNumBlocks());
+	LoadDirectoryCache();
 }
 
 ISOFileSystem::~ISOFileSystem() {
+	if (directoryCacheDirty_ && !directoryReadFailed_) {
+		SaveDirectoryCache();
+	}
 	delete blockDevice;
-	delete treeroot;
+}
+
+ISOFileSystem::TreeEntry *ISOFileSystem::NewEntry() {
+	entryArena_.emplace_back();
+	return &entryArena_.back();
 }
 
 void ISOFileSystem::ReadDirectory(TreeEntry *root) {
@@ -184,6 +199,7 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 			blockDevice->NotifyReadError();
 			ERROR_LOG(FILESYS, "Error reading block for directory '%s' in sector %d - skipping", root->name.c_str(), secnum);
 			root->valid = true;  // Prevents re-reading
+			directoryReadFailed_ = true;
 			return;
 		}
 		lastReadBlock_ = secnum;  // Hm, this could affect timing... but lazy loading is probably more realistic.
@@ -200,6 +216,7 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 			if (offset + IDENTIFIER_OFFSET + dir.identifierLength > 2048) {
 				blockDevice->NotifyReadError();
 				ERROR_LOG(FILESYS, "Directory entry crosses sectors, corrupt iso?");
+				directoryReadFailed_ = true;
 				return;
 			}
 
@@ -208,7 +225,7 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 			bool isFile = (dir.flags & 2) ? false : true;
 			bool relative;
 
-			TreeEntry *entry = new TreeEntry();
+			TreeEntry *entry = NewEntry();
 			if (dir.identifierLength == 1 && (dir.firstIdChar == '\x00' || dir.firstIdChar == '.')) {
 				entry->name = ".";
 				relative = true;
@@ -246,6 +263,19 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 		}
 	}
 	root->valid = true;
+	directoryCacheDirty_ = true;
+	IndexChildren(root);
+}
+
+void ISOFileSystem::IndexChildren(TreeEntry *root) {
+	// Relative entries are still reachable through the tree walk, no need to index them.
+	std::string prefix = EntryFullPath(root);
+	if (!prefix.empty())
+		prefix = prefix.substr(1) + "/";
+	for (TreeEntry *child : root->children) {
+		if (child->name != "." && child->name != "..")
+			pathIndex_.emplace(prefix + child->name, child);
+	}
 }
 
 ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bool catchError) {
@@ -269,6 +299,17 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 	if (pathLength <= pathIndex)
 		return treeroot;
 
+	// Most lookups are for paths we've seen before, or whose directory was already read.
+	std::string key = path.substr(pathIndex);
+	if (key.back() == '/')
+		key.pop_back();
+	auto indexed = pathIndex_.find(key);
+	if (indexed != pathIndex_.end()) {
+		if (!indexed->second->valid)
+			ReadDirectory(indexed->second);
+		return indexed->second;
+	}
+
 	TreeEntry *entry = treeroot;
 	while (true) {
 		if (!entry->valid) {
@@ -301,8 +342,10 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 			if (pathIndex < pathLength && path[pathIndex] == '/')
 				++pathIndex;
 
-			if (pathLength <= pathIndex)
+			if (pathLength <= pathIndex) {
+				pathIndex_.emplace(key, entry);
 				return entry;
+			}
 		} else {
 			if (catchError)
 				ERROR_LOG(FILESYS, "File '%s' not found", path.c_str());
@@ -459,6 +502,20 @@ FileSystemFlags ISOFileSystem::Flags() {
 	return blockDevice->IsDisc() ? FileSystemFlags::UMD : FileSystemFlags::CARD;
 }
 
+void ISOFileSystem::ReadPartialBlock(u32 sector, u8 *dest, int offset, int size) {
+	std::lock_guard<std::mutex> guard(sectorCacheLock_);
+	CachedSector &cached = sectorCache_[sector % SECTOR_CACHE_SIZE];
+	if (cached.sector != sector) {
+		if (blockDevice->ReadBlock(sector, cached.data)) {
+			cached.sector = sector;
+		} else {
+			// Don't keep whatever we got, a retry might succeed.
+			cached.sector = 0xFFFFFFFF;
+		}
+	}
+	memcpy(dest, cached.data + offset, size);
+}
+
 size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
 {
 	int ignored;
@@ -523,7 +580,6 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 		const int lastBlockSize = (size - firstBlockSize) & 2047;
 		const s64 middleSize = size - firstBlockSize - lastBlockSize;
 		u32 secNum = (u32)(positionOnIso / 2048);
-		u8 theSector[2048];
 
 		if ((middleSize & 2047) != 0) {
 			ERROR_LOG(FILESYS, "Remaining size should be aligned");
@@ -531,8 +587,7 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 
 		const u8 *const start = pointer;
 		if (firstBlockSize > 0) {
-			blockDevice->ReadBlock(secNum++, theSector);
-			memcpy(pointer, theSector + firstBlockOffset, firstBlockSize);
+			ReadPartialBlock(secNum++, pointer, firstBlockOffset, firstBlockSize);
 			pointer += firstBlockSize;
 		}
 		if (middleSize > 0) {
@@ -542,8 +597,7 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 			pointer += middleSize;
 		}
 		if (lastBlockSize > 0) {
-			blockDevice->ReadBlock(secNum++, theSector);
-			memcpy(pointer, theSector, lastBlockSize);
+			ReadPartialBlock(secNum++, pointer, 0, lastBlockSize);
 			pointer += lastBlockSize;
 		}
 
@@ -688,10 +742,152 @@ std::string ISOFileSystem::EntryFullPath(TreeEntry *e) {
 	return path;
 }
 
-ISOFileSystem::TreeEntry::~TreeEntry() {
-	for (size_t i = 0; i < children.size(); ++i)
-		delete children[i];
-	children.clear();
+// Directory cache format, native endian:
+// 64 magic
+// 32 version
+// 64 disc hash
+// 8  root directory already read
+// 32 entry count
+// entries[count], in tree order with parents first, root excluded
+//   32 parent (0 = root, otherwise 1 + index of an earlier entry)
+//   32 flags
+//   32 startsector
+//   32 dirsize
+//   8  valid (directory already read)
+//   8  name length
+//   name
+static const char *const DIRCACHE_MAGIC = "ppssppID";
+static const u32 DIRCACHE_VERSION = 1;
+
+Path ISOFileSystem::DirectoryCachePath() const {
+	return GetSysDirectory(DIRECTORY_CACHE) / StringFromFormat("isodir_%016llx.ppdi", (unsigned long long)discHash_);
+}
+
+bool ISOFileSystem::LoadDirectoryCache() {
+	if (treeroot->startsector == 0)
+		return false;
+	Path cachePath = DirectoryCachePath();
+	std::string data;
+	if (!File::Exists(cachePath) || !File::ReadFileToString(false, cachePath, data))
+		return false;
+
+	size_t pos = 0;
+	auto readBytes = [&](void *dest, size_t sz) {
+		if (pos + sz > data.size())
+			return false;
+		memcpy(dest, &data[pos], sz);
+		pos += sz;
+		return true;
+	};
+
+	char magic[8];
+	u32 version = 0;
+	u64 hash = 0;
+	u32 count = 0;
+	u8 rootValid = 0;
+	if (!readBytes(magic, sizeof(magic)) || memcmp(magic, DIRCACHE_MAGIC, sizeof(magic)) != 0)
+		return false;
+	if (!readBytes(&version, sizeof(version)) || version != DIRCACHE_VERSION)
+		return false;
+	if (!readBytes(&hash, sizeof(hash)) || hash != discHash_)
+		return false;
+	if (!readBytes(&rootValid, sizeof(rootValid)) || !readBytes(&count, sizeof(count)))
+		return false;
+
+	std::vector<TreeEntry *> loaded;
+	loaded.reserve(count);
+	for (u32 i = 0; i < count; ++i) {
+		u32 parent, flags, startsector, dirsize;
+		u8 valid, nameLength;
+		if (!readBytes(&parent, 4) || !readBytes(&flags, 4) || !readBytes(&startsector, 4) || !readBytes(&dirsize, 4) || !readBytes(&valid, 1) || !readBytes(&nameLength, 1) || pos + nameLength > data.size() || parent > loaded.size()) {
+			WARN_LOG(FILESYS, "Ignoring corrupt ISO directory cache %s", cachePath.c_str());
+			// Start over from nothing, the entries we made are just unreachable.
+			treeroot->children.clear();
+			return false;
+		}
+
+		TreeEntry *entry = NewEntry();
+		entry->name = data.substr(pos, nameLength);
+		pos += nameLength;
+		entry->flags = flags;
+		entry->isDirectory = (flags & 2) != 0;
+		entry->startsector = startsector;
+		entry->startingPosition = startsector * 2048;
+		entry->dirsize = dirsize;
+		entry->size = dirsize;
+		entry->valid = valid != 0;
+		entry->parent = parent == 0 ? treeroot : loaded[parent - 1];
+		entry->parent->children.push_back(entry);
+		loaded.push_back(entry);
+	}
+
+	treeroot->valid = rootValid != 0;
+	if (treeroot->valid)
+		IndexChildren(treeroot);
+	for (TreeEntry *entry : loaded) {
+		if (entry->isDirectory && entry->valid && entry->name != "." && entry->name != "..")
+			IndexChildren(entry);
+	}
+
+	INFO_LOG(FILESYS, "Loaded %d ISO directory entries from cache", (int)count);
+	return true;
+}
+
+void ISOFileSystem::SaveDirectoryCache() {
+	Path cacheDir = GetSysDirectory(DIRECTORY_CACHE);
+	if (treeroot->startsector == 0 || !File::Exists(cacheDir))
+		return;
+
+	std::string data;
+	auto writeBytes = [&](const void *src, size_t sz) {
+		data.append((const char *)src, sz);
+	};
+
+	u32 version = DIRCACHE_VERSION;
+	u8 rootValid = treeroot->valid ? 1 : 0;
+	writeBytes(DIRCACHE_MAGIC, 8);
+	writeBytes(&version, sizeof(version));
+	writeBytes(&discHash_, sizeof(discHash_));
+	writeBytes(&rootValid, sizeof(rootValid));
+	size_t countPos = data.size();
+	u32 count = 0;
+	writeBytes(&count, sizeof(count));
+
+	// Breadth first, so parents always come before their children.
+	std::vector<std::pair<TreeEntry *, u32>> queue;
+	for (TreeEntry *child : treeroot->children)
+		queue.push_back(std::make_pair(child, 0));
+	for (size_t i = 0; i < queue.size(); ++i) {
+		TreeEntry *entry = queue[i].first;
+		u32 parent = queue[i].second;
+		bool relative = entry->name == "." || entry->name == "..";
+		// Relative entries are saved without children, so they need to be read again.
+		u8 valid = entry->valid && (!entry->isDirectory || !relative) ? 1 : 0;
+		u8 nameLength = (u8)std::min(entry->name.size(), (size_t)255);
+		writeBytes(&parent, 4);
+		writeBytes(&entry->flags, 4);
+		writeBytes(&entry->startsector, 4);
+		writeBytes(&entry->dirsize, 4);
+		writeBytes(&valid, 1);
+		writeBytes(&nameLength, 1);
+		writeBytes(entry->name.data(), nameLength);
+
+		if (!relative) {
+			for (TreeEntry *child : entry->children)
+				queue.push_back(std::make_pair(child, (u32)i + 1));
+		}
+	}
+	count = (u32)queue.size();
+	memcpy(&data[countPos], &count, sizeof(count));
+
+	// Write then rename, so another instance never sees a partial file.
+	Path cachePath = DirectoryCachePath();
+	Path tempPath = cachePath.WithExtraExtension(".tmp");
+	if (File::WriteStringToFile(false, data, tempPath)) {
+		if (File::Exists(cachePath))
+			File::Delete(cachePath);
+		File::Rename(tempPath, cachePath);
+	}
 }
 
 void ISOFileSystem::DoState(PointerWrap &p) {
@@ -17,9 +17,12 @@
 
 #pragma once
 
+#include <deque>
 #include <map>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "FileSystem.h"
 
@@ -58,8 +61,6 @@ class ISOFileSystem : public IFileSystem {
 
 private:
 	struct TreeEntry {
-		~TreeEntry();
-
 		std::string name;
 		u32 flags = 0;
 		u32 startingPosition = 0;
@@ -91,11 +92,39 @@ class ISOFileSystem : public IFileSystem {
 	BlockDevice *blockDevice;
 	u32 lastReadBlock_;
 
+	// Games often read files in small pieces, so partial sector reads are cached.
+	// Direct mapped by sector number.
+	struct CachedSector {
+		u32 sector = 0xFFFFFFFF;
+		u8 data[2048];
+	};
+	enum { SECTOR_CACHE_SIZE = 8 };
+	CachedSector sectorCache_[SECTOR_CACHE_SIZE];
+	std::mutex sectorCacheLock_;
+
+	void ReadPartialBlock(u32 sector, u8 *dest, int offset, int size);
+
 	TreeEntry entireISO;
 
+	// All tree entries live here, so they're freed together and pointers stay stable.
+	std::deque<TreeEntry> entryArena_;
+	// Full path (without the leading slash) of every entry read so far.
+	std::unordered_map<std::string, TreeEntry *> pathIndex_;
+
+	// Identifies the disc for the on-disk directory cache.
+	u64 discHash_ = 0;
+	bool directoryCacheDirty_ = false;
+	bool directoryReadFailed_ = false;
+
+	TreeEntry *NewEntry();
 	void ReadDirectory(TreeEntry *root);
+	void IndexChildren(TreeEntry *root);
 	TreeEntry *GetFromPath(const std::string &path, bool catchError = true);
 	std::string EntryFullPath(TreeEntry *e);
+
+	Path DirectoryCachePath() const;
+	bool LoadDirectoryCache();
+	void SaveDirectoryCache();
 };
 
 // On the "umd0:" device, any file you open is the entire ISO.
@@ -24,6 +24,7 @@
 #include "Common/StringUtils.h"
 #include "Core/FileSystems/MetaFileSystem.h"
 #include "Core/HLE/sceKernelThread.h"
+#include "Core/MemFault.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 
@@ -179,6 +180,38 @@ IFileSystem *MetaFileSystem::GetHandleOwner(u32 handle)
 	return nullptr;
 }
 
+std::recursive_mutex &MetaFileSystem::DeviceLock(IFileSystem *sys) {
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	if (sys->Flags() & FileSystemFlags::UMD)
+		return umdLock_;
+
+	auto &deviceLock = deviceLocks_[sys];
+	if (!deviceLock)
+		deviceLock.reset(new std::recursive_mutex());
+	return *deviceLock;
+}
+
+std::shared_ptr<IFileSystem> MetaFileSystem::LockHandleOwner(u32 handle, std::unique_lock<std::recursive_mutex> &device) {
+	std::shared_ptr<IFileSystem> sys;
+	std::recursive_mutex *deviceLock = nullptr;
+	{
+		std::lock_guard<std::recursive_mutex> guard(lock);
+		for (size_t i = 0; i < fileSystems.size(); i++) {
+			if (fileSystems[i].system->OwnsHandle(handle)) {
+				// Keep a reference, in case it's unmounted while we're using it.
+				sys = fileSystems[i].system;
+				deviceLock = &DeviceLock(sys.get());
+				break;
+			}
+		}
+	}
+
+	// Wait for the device outside lock, so a busy device doesn't hold up the others.
+	if (deviceLock)
+		device = std::unique_lock<std::recursive_mutex>(*deviceLock);
+	return sys;
+}
+
 int MetaFileSystem::MapFilePath(const std::string &_inpath, std::string &outpath, MountPoint **system)
 {
 	int error = SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
@@ -337,6 +370,7 @@ void MetaFileSystem::Shutdown() {
 	std::lock_guard<std::recursive_mutex> guard(lock);
 
 	UnmountAll();
+	deviceLocks_.clear();
 	Reset();
 }
 
@@ -346,10 +380,12 @@ int MetaFileSystem::OpenFile(std::string filename, FileAccess access, const char
 	std::string of;
 	MountPoint *mount;
 	int error = MapFilePath(filename, of, &mount);
-	if (error == 0)
+	if (error == 0) {
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(mount->system.get()));
 		return mount->system->OpenFile(of, access, mount->prefix.c_str());
-	else
+	} else {
 		return error;
+	}
 }
 
 PSPFileInfo MetaFileSystem::GetFileInfo(std::string filename)
@@ -360,6 +396,7 @@ PSPFileInfo MetaFileSystem::GetFileInfo(std::string filename)
 	int error = MapFilePath(filename, of, &system);
 	if (error == 0)
 	{
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(system));
 		return system->GetFileInfo(of);
 	}
 	else
@@ -377,6 +414,7 @@ std::vector<PSPFileInfo> MetaFileSystem::GetDirListing(std::string path)
 	int error = MapFilePath(path, of, &system);
 	if (error == 0)
 	{
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(system));
 		return system->GetDirListing(of);
 	}
 	else
@@ -436,6 +474,7 @@ bool MetaFileSystem::MkDir(const std::string &dirname)
 	int error = MapFilePath(dirname, of, &system);
 	if (error == 0)
 	{
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(system));
 		return system->MkDir(of);
 	}
 	else
@@ -452,6 +491,7 @@ bool MetaFileSystem::RmDir(const std::string &dirname)
 	int error = MapFilePath(dirname, of, &system);
 	if (error == 0)
 	{
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(system));
 		return system->RmDir(of);
 	}
 	else
@@ -486,6 +526,7 @@ int MetaFileSystem::RenameFile(const std::string &from, const std::string &to)
 		if (osystem != rsystem)
 			return SCE_KERNEL_ERROR_XDEV;
 
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(osystem));
 		return osystem->RenameFile(of, rf);
 	}
 	else
@@ -501,6 +542,7 @@ bool MetaFileSystem::RemoveFile(const std::string &filename)
 	IFileSystem *system;
 	int error = MapFilePath(filename, of, &system);
 	if (error == 0) {
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(system));
 		return system->RemoveFile(of);
 	} else {
 		return false;
@@ -511,8 +553,10 @@ int MetaFileSystem::Ioctl(u32 handle, u32 cmd, u32 indataPtr, u32 inlen, u32 out
 {
 	std::lock_guard<std::recursive_mutex> guard(lock);
 	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
+	if (sys) {
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(sys));
 		return sys->Ioctl(handle, cmd, indataPtr, inlen, outdataPtr, outlen, usec);
+	}
 	return SCE_KERNEL_ERROR_ERROR;
 }
 
@@ -520,8 +564,10 @@ PSPDevType MetaFileSystem::DevType(u32 handle)
 {
 	std::lock_guard<std::recursive_mutex> guard(lock);
 	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
+	if (sys) {
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(sys));
 		return sys->DevType(handle);
+	}
 	return PSPDevType::INVALID;
 }
 
@@ -529,14 +575,20 @@ void MetaFileSystem::CloseFile(u32 handle)
 {
 	std::lock_guard<std::recursive_mutex> guard(lock);
 	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
+	if (sys) {
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(sys));
 		sys->CloseFile(handle);
+	}
 }
 
 size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
+	// Only the device is locked while this runs, so other devices can be accessed meanwhile.
+	// The OS doesn't fault on pages a lazy state load hasn't filled yet, it just fails, so fill them first.
+	std::unique_lock<std::recursive_mutex> device;
+	std::shared_ptr<IFileSystem> sys = LockHandleOwner(handle, device);
+	if (sys && size > 0)
+		Memory::MemFault_PrepareHostAccess(pointer, (size_t)size, true);
 	if (sys)
 		return sys->ReadFile(handle, pointer, size);
 	else
@@ -545,8 +597,11 @@ size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
 
 size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
+	// Only the device is locked while this runs, so other devices can be accessed meanwhile.
+	std::unique_lock<std::recursive_mutex> device;
+	std::shared_ptr<IFileSystem> sys = LockHandleOwner(handle, device);
+	if (sys && size > 0)
+		Memory::MemFault_PrepareHostAccess(pointer, (size_t)size, false);
 	if (sys)
 		return sys->WriteFile(handle, pointer, size);
 	else
@@ -555,8 +610,11 @@ size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size)
 
 size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
+	// Only the device is locked while this runs, so other devices can be accessed meanwhile.
+	std::unique_lock<std::recursive_mutex> device;
+	std::shared_ptr<IFileSystem> sys = LockHandleOwner(handle, device);
+	if (sys && size > 0)
+		Memory::MemFault_PrepareHostAccess(pointer, (size_t)size, true);
 	if (sys)
 		return sys->ReadFile(handle, pointer, size, usec);
 	else
@@ -565,8 +623,11 @@ size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec)
 
 size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, int &usec)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
+	// Only the device is locked while this runs, so other devices can be accessed meanwhile.
+	std::unique_lock<std::recursive_mutex> device;
+	std::shared_ptr<IFileSystem> sys = LockHandleOwner(handle, device);
+	if (sys && size > 0)
+		Memory::MemFault_PrepareHostAccess(pointer, (size_t)size, false);
 	if (sys)
 		return sys->WriteFile(handle, pointer, size, usec);
 	else
@@ -577,10 +638,12 @@ size_t MetaFileSystem::SeekFile(u32 handle, s32 position, FileMove type)
 {
 	std::lock_guard<std::recursive_mutex> guard(lock);
 	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
+	if (sys) {
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(sys));
 		return sys->SeekFile(handle,position,type);
-	else
+	} else {
 		return 0;
+	}
 }
 
 int MetaFileSystem::ReadEntireFile(const std::string &filename, std::vector<u8> &data) {
@@ -608,10 +671,12 @@ u64 MetaFileSystem::FreeSpace(const std::string &path)
 	std::string of;
 	IFileSystem *system;
 	int error = MapFilePath(path, of, &system);
-	if (error == 0)
+	if (error == 0) {
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(system));
 		return system->FreeSpace(of);
-	else
+	} else {
 		return 0;
+	}
 }
 
 void MetaFileSystem::DoState(PointerWrap &p)
@@ -643,6 +708,7 @@ void MetaFileSystem::DoState(PointerWrap &p)
 
 	for (u32 i = 0; i < n; ++i) {
 		if (!skipPfat0 || fileSystems[i].prefix != "pfat0:") {
+			std::lock_guard<std::recursive_mutex> device(DeviceLock(fileSystems[i].system.get()));
 			fileSystems[i].system->DoState(p);
 		}
 	}
@@ -669,6 +735,7 @@ int64_t MetaFileSystem::ComputeRecursiveDirectorySize(const std::string &filenam
 	IFileSystem *system;
 	int error = MapFilePath(filename, of, &system);
 	if (error == 0) {
+		std::lock_guard<std::recursive_mutex> device(DeviceLock(system));
 		int64_t size;
 		if (system->ComputeRecursiveDirSizeIfFast(of, &size)) {
 			// Some file systems can optimize this.
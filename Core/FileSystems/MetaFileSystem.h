@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <map>
 #include <string>
 #include <vector>
 #include <mutex>
@@ -45,6 +46,11 @@ class MetaFileSystem : public IHandleAllocator, public IFileSystem {
 	std::string startingDirectory;
 	std::recursive_mutex lock;  // must be recursive
 
+	// Serializes access to a single device, so reads and writes can run without holding lock.
+	// All UMD mounts wrap the same disc, so they share one.
+	std::recursive_mutex umdLock_;
+	std::map<IFileSystem *, std::unique_ptr<std::recursive_mutex>> deviceLocks_;
+
 	void Reset() {
 		// This used to be 6, probably an attempt to replicate PSP handles.
 		// However, that's an artifact of using psplink anyway...
@@ -151,4 +157,8 @@ class MetaFileSystem : public IHandleAllocator, public IFileSystem {
 
 private:
 	int64_t RecursiveSize(const std::string &dirPath);
+
+	std::recursive_mutex &DeviceLock(IFileSystem *sys);
+	// Finds the owner of handle and locks its device, so that lock can be released during long operations.
+	std::shared_ptr<IFileSystem> LockHandleOwner(u32 handle, std::unique_lock<std::recursive_mutex> &device);
 };
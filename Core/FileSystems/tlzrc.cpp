@@ -208,7 +208,7 @@ int lzrc_decompress(void *out, int out_len, void *in, int in_len)
 	int i, bit, byte, last_byte;
 	int match_len, len_bits;
 	int match_dist, dist_bits, limit;
-	u8 *match_src;
+	u8 *match_src, *match_dst;
 	int round = -1;
 
 	rc_init(&rc, out, out_len, in, in_len);
@@ -284,10 +284,22 @@ int lzrc_decompress(void *out, int out_len, void *in, int in_len)
 				printf("match_dist out of range! %08x\n", match_dist);
 				return -1;
 			}
+			match_len += 1;
+			if(match_len>rc.out_len-rc.out_ptr){
+				_dbg_assert_msg_(false, "LZRC: Output overflow!");
+				return -1;
+			}
 			match_src = rc.output+rc.out_ptr-match_dist;
-			for(i=0; i<match_len+1; i++){
-				rc_putbyte(&rc, *match_src++);
+			match_dst = rc.output+rc.out_ptr;
+			if(match_dist>=match_len){
+				memcpy(match_dst, match_src, match_len);
+			}else{
+				/* overlapping, repeats the last match_dist bytes */
+				for(i=0; i<match_len; i++){
+					match_dst[i] = match_src[i];
+				}
 			}
+			rc.out_ptr += match_len;
 			rc_state = 6+((rc.out_ptr+1)&1);
 		}
 		last_byte = rc.output[rc.out_ptr-1];
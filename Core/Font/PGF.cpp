@@ -177,6 +177,9 @@ void PGF::DoState(PointerWrap &p) {
 		Do(p, shadowGlyphs);
 	}
 	Do(p, firstGlyph);
+
+	if (p.mode == p.MODE_READ)
+		decodedGlyphs_.clear();
 }
 
 bool PGF::ReadPtr(const u8 *ptr, size_t dataSize) {
@@ -580,9 +583,7 @@ void PGF::DrawCharacter(const GlyphImage *image, int clipX, int clipY, int clipW
 		return;
 	}
 
-	size_t bitPtr = glyph.ptr * 8;
-	int numberPixels = glyph.w * glyph.h;
-	int pixelIndex = 0;
+	const std::vector<u8> &decodedPixels = DecodeGlyph(glyph);
 
 	int x = image->xPos64 >> 6;
 	int y = image->yPos64 >> 6;
@@ -599,46 +600,11 @@ void PGF::DrawCharacter(const GlyphImage *image, int clipX, int clipY, int clipW
 	if (clipHeight < 0)
 		clipHeight = 8192;
 
-	// Use a buffer so we can apply subpixel rendering.
-	// TODO: Cache this buffer per glyph?  Maybe even transpose it first?
-	std::vector<u8> decodedPixels;
-	decodedPixels.resize(numberPixels);
-
-	while (pixelIndex < numberPixels && bitPtr + 8 < fontDataSize * 8) {
-		// This is some kind of nibble based RLE compression.
-		int nibble = consumeBits(4, fontData, bitPtr);
-
-		int count;
-		int value = 0;
-		if (nibble < 8) {
-			value = consumeBits(4, fontData, bitPtr);
-			count = nibble + 1;
-		} else {
-			count = 16 - nibble;
-		}
-
-		for (int i = 0; i < count && pixelIndex < numberPixels; i++) {
-			if (nibble >= 8) {
-				value = consumeBits(4, fontData, bitPtr);
-			}
-
-			decodedPixels[pixelIndex++] = value | (value << 4);
-		}
-	}
-
 	auto samplePixel = [&](int xx, int yy) -> u8 {
 		if (xx < 0 || yy < 0 || xx >= glyph.w || yy >= glyph.h) {
 			return 0;
 		}
-
-		int index;
-		if ((glyph.flags & FONT_PGF_BMP_OVERLAY) == FONT_PGF_BMP_H_ROWS) {
-			index = yy * glyph.w + xx;
-		} else {
-			index = xx * glyph.h + yy;
-		}
-
-		return decodedPixels[index];
+		return decodedPixels[yy * glyph.w + xx];
 	};
 
 	int renderX1 = std::max(clipX, x) - x;
@@ -673,6 +639,55 @@ void PGF::DrawCharacter(const GlyphImage *image, int clipX, int clipY, int clipW
 	gpu->InvalidateCache(image->bufferPtr, image->bytesPerLine * image->bufHeight, GPU_INVALIDATE_SAFE);
 }
 
+// Games tend to draw the same few characters over and over (every frame, for some), so
+// keep them expanded. Glyphs are small, this is a few hundred KB at most.
+static const size_t MAX_DECODED_GLYPHS = 1024;
+
+const std::vector<u8> &PGF::DecodeGlyph(const Glyph &glyph) const {
+	auto iter = decodedGlyphs_.find(glyph.ptr);
+	if (iter != decodedGlyphs_.end())
+		return iter->second;
+
+	if (decodedGlyphs_.size() >= MAX_DECODED_GLYPHS)
+		decodedGlyphs_.clear();
+
+	size_t bitPtr = glyph.ptr * 8;
+	int numberPixels = glyph.w * glyph.h;
+	int pixelIndex = 0;
+	bool vertical = (glyph.flags & FONT_PGF_BMP_OVERLAY) == FONT_PGF_BMP_V_ROWS;
+
+	std::vector<u8> &decodedPixels = decodedGlyphs_[glyph.ptr];
+	decodedPixels.resize(numberPixels);
+
+	while (pixelIndex < numberPixels && bitPtr + 8 < fontDataSize * 8) {
+		// This is some kind of nibble based RLE compression.
+		int nibble = consumeBits(4, fontData, bitPtr);
+
+		int count;
+		int value = 0;
+		if (nibble < 8) {
+			value = consumeBits(4, fontData, bitPtr);
+			count = nibble + 1;
+		} else {
+			count = 16 - nibble;
+		}
+
+		for (int i = 0; i < count && pixelIndex < numberPixels; i++) {
+			if (nibble >= 8) {
+				value = consumeBits(4, fontData, bitPtr);
+			}
+
+			// Store everything in rows, so drawing doesn't have to care.
+			int index = pixelIndex++;
+			if (vertical)
+				index = (index % glyph.h) * glyph.w + index / glyph.h;
+			decodedPixels[index] = value | (value << 4);
+		}
+	}
+
+	return decodedPixels;
+}
+
 void PGF::SetFontPixel(u32 base, int bpl, int bufWidth, int bufHeight, int x, int y, u8 pixelColor, FontPixelFormat pixelformat) const {
 	if (x < 0 || x >= bufWidth || y < 0 || y >= bufHeight) {
 		return;
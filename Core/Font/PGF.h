@@ -20,6 +20,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -276,6 +277,7 @@ class PGF {
 	bool ReadCharGlyph(const u8 *fontdata, size_t charPtr, Glyph &glyph);
 	bool ReadShadowGlyph(const u8 *fontdata, size_t charPtr, Glyph &glyph);
 	bool GetCharGlyph(int charCode, int glyphType, Glyph &glyph) const;
+	const std::vector<u8> &DecodeGlyph(const Glyph &glyph) const;
 
 	// Unused
 	int GetCharIndex(int charCode, const std::vector<int> &charmapCompressed);
@@ -305,4 +307,8 @@ class PGF {
 	std::vector<Glyph> glyphs;
 	std::vector<Glyph> shadowGlyphs;
 	int firstGlyph;
+
+	// Glyph bitmaps already expanded from the RLE data, row major, keyed by Glyph::ptr.
+	// Not saved, it's rebuilt on demand.
+	mutable std::unordered_map<u32, std::vector<u8>> decodedGlyphs_;
 };
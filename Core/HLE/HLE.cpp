@@ -15,8 +15,10 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdarg>
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -152,6 +154,7 @@ void HLEDoState(PointerWrap &p) {
 }
 
 void HLEShutdown() {
+	hleResetFunctionStats();
 	hleAfterSyscall = HLE_AFTER_NOTHING;
 	latestSyscall = nullptr;
 	latestSyscallPC = 0;
@@ -587,6 +590,29 @@ inline void hleFinishSyscall(const HLEFunction &info)
 	hleAfterSyscallReschedReason = 0;
 }
 
+// Unlike kernelStats, these add up until reset, and are read from the UI and debugger threads.
+static std::mutex hleFunctionStatsLock;
+static std::map<KernelStatsSyscall, HLEFunctionStats> hleFunctionStats;
+
+std::vector<HLEFunctionStats> hleGetFunctionStats() {
+	std::vector<HLEFunctionStats> result;
+	{
+		std::lock_guard<std::mutex> guard(hleFunctionStatsLock);
+		result.reserve(hleFunctionStats.size());
+		for (const auto &it : hleFunctionStats)
+			result.push_back(it.second);
+	}
+	std::sort(result.begin(), result.end(), [](const HLEFunctionStats &a, const HLEFunctionStats &b) {
+		return a.seconds > b.seconds;
+	});
+	return result;
+}
+
+void hleResetFunctionStats() {
+	std::lock_guard<std::mutex> guard(hleFunctionStatsLock);
+	hleFunctionStats.clear();
+}
+
 static void updateSyscallStats(int modulenum, int funcnum, double total)
 {
 	const char *name = moduleDB[modulenum].funcTable[funcnum].name;
@@ -594,6 +620,15 @@ static void updateSyscallStats(int modulenum, int funcnum, double total)
 	if (0 == strcmp(name, "_sceKernelIdle"))
 		return;
 
+	{
+		std::lock_guard<std::mutex> guard(hleFunctionStatsLock);
+		HLEFunctionStats &funcStats = hleFunctionStats[KernelStatsSyscall(modulenum, funcnum)];
+		funcStats.module = moduleDB[modulenum].name;
+		funcStats.name = name;
+		funcStats.calls++;
+		funcStats.seconds += total;
+	}
+
 	if (total > kernelStats.slowestSyscallTime)
 	{
 		kernelStats.slowestSyscallTime = total;
@@ -621,6 +656,14 @@ static void updateSyscallStats(int modulenum, int funcnum, double total)
 			kernelStats.summedSlowestSyscallName = name;
 		}
 	}
+
+	// Time alone hides cheap syscalls that are called constantly, which are the ones worth specializing.
+	int calls = ++kernelStats.summedCallsToSyscalls[statCall];
+	if (calls > kernelStats.mostCalledSyscallCount)
+	{
+		kernelStats.mostCalledSyscallCount = calls;
+		kernelStats.mostCalledSyscallName = name;
+	}
 }
 
 inline void CallSyscallWithFlags(const HLEFunction *info)
@@ -20,6 +20,7 @@
 #include <cstdio>
 #include <cstdarg>
 #include <type_traits>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
@@ -157,6 +158,18 @@ const HLEFunction *GetSyscallFuncPointer(MIPSOpcode op);
 // For jit, takes arg: const HLEFunction *
 void *GetQuickSyscallFunc(MIPSOpcode op);
 
+struct HLEFunctionStats {
+	const char *module;
+	const char *name;
+	u64 calls;
+	// Host time, not counting time stepping in the debugger.
+	double seconds;
+};
+
+// Only collected while debug stats are on (see Core_ForceDebugStats.)  Sorted by most time first.
+std::vector<HLEFunctionStats> hleGetFunctionStats();
+void hleResetFunctionStats();
+
 void hleDoLogInternal(LogTypes::LOG_TYPE t, LogTypes::LOG_LEVELS level, u64 res, const char *file, int line, const char *reportTag, char retmask, const char *reason, const char *formatted_reason);
 
 template <typename T>
@@ -18,6 +18,7 @@
 #include "ppsspp_config.h"
 #include <algorithm>
 #include <map>
+#include <mutex>
 #include <unordered_map>
 
 #include "Common/CommonTypes.h"
@@ -381,58 +382,161 @@ static int Replace_memset_jak() {
 	return 5 + bytes * 6 + 2;  // approximation (hm, inspecting the disasm this should be 5 + 6 * bytes + 2, but this is what works..)
 }
 
+// The string replacements never read past the end of valid memory, even for unterminated
+// strings.  The guest would just read garbage there, so stopping early is as good as anything.
+static u32 GuestStrnlen(u32 ptr, u32 maxLen) {
+	u32 valid = Memory::IsValidAddress(ptr) ? Memory::ValidSize(ptr, maxLen) : 0;
+	if (valid == 0)
+		return 0;
+	const u8 *src = Memory::GetPointer(ptr);
+	const u8 *end = (const u8 *)memchr(src, 0, valid);
+	return end ? (u32)(end - src) : valid;
+}
+
+// Matches newlib, which returns the difference of the first mismatching bytes (as unsigned.)
+static int GuestCompare(u32 aPtr, u32 bPtr, u32 maxLen, bool stopAtNull, u32 *compared) {
+	maxLen = Memory::IsValidAddress(aPtr) ? Memory::ValidSize(aPtr, maxLen) : 0;
+	maxLen = Memory::IsValidAddress(bPtr) ? Memory::ValidSize(bPtr, maxLen) : 0;
+	const u8 *a = Memory::GetPointer(aPtr);
+	const u8 *b = Memory::GetPointer(bPtr);
+	for (u32 i = 0; i < maxLen; ++i) {
+		if (a[i] != b[i] || (stopAtNull && a[i] == 0)) {
+			*compared = i + 1;
+			return (int)a[i] - (int)b[i];
+		}
+	}
+	*compared = maxLen;
+	return 0;
+}
+
 static int Replace_strlen() {
 	u32 srcPtr = PARAM(0);
-	const char *src = (const char *)Memory::GetPointer(srcPtr);
-	u32 len = src ? (u32)strlen(src) : 0UL;
+	u32 len = GuestStrnlen(srcPtr, 0xFFFFFFFF);
+	RETURN(len);
+	return 7 + len * 4;  // approximation
+}
+
+static int Replace_strnlen() {
+	u32 srcPtr = PARAM(0);
+	u32 len = GuestStrnlen(srcPtr, PARAM(1));
 	RETURN(len);
 	return 7 + len * 4;  // approximation
 }
 
 static int Replace_strcpy() {
 	u32 destPtr = PARAM(0);
-	char *dst = (char *)Memory::GetPointer(destPtr);
-	const char *src = (const char *)Memory::GetPointer(PARAM(1));
-	if (dst && src) {
-		strcpy(dst, src);
+	u32 srcPtr = PARAM(1);
+	u32 len = GuestStrnlen(srcPtr, 0xFFFFFFFF);
+	if (Memory::IsValidRange(destPtr, len + 1) && Memory::IsValidRange(srcPtr, len + 1)) {
+		memmove(Memory::GetPointerWriteUnchecked(destPtr), Memory::GetPointerUnchecked(srcPtr), len + 1);
+		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, len + 1, "ReplaceStrcpy");
 	}
 	RETURN(destPtr);
-	return 10;  // approximation
+	return 10 + len;  // approximation
 }
 
 static int Replace_strncpy() {
 	u32 destPtr = PARAM(0);
-	char *dst = (char *)Memory::GetPointer(destPtr);
-	const char *src = (const char *)Memory::GetPointer(PARAM(1));
+	u32 srcPtr = PARAM(1);
 	u32 bytes = PARAM(2);
-	if (dst && src && bytes != 0) {
-		strncpy(dst, src, bytes);
+	u32 len = GuestStrnlen(srcPtr, bytes);
+	if (bytes != 0 && Memory::IsValidRange(destPtr, bytes) && Memory::IsValidRange(srcPtr, len)) {
+		u8 *dst = Memory::GetPointerWriteUnchecked(destPtr);
+		memmove(dst, Memory::GetPointerUnchecked(srcPtr), len);
+		// Like the real thing, pad the rest with zeros.
+		memset(dst + len, 0, bytes - len);
+		NotifyMemInfo(MemBlockFlags::WRITE, destPtr, bytes, "ReplaceStrncpy");
 	}
 	RETURN(destPtr);
-	return 10;  // approximation
+	return 10 + bytes;  // approximation
 }
 
-static int Replace_strcmp() {
-	const char *a = (const char *)Memory::GetPointer(PARAM(0));
-	const char *b = (const char *)Memory::GetPointer(PARAM(1));
-	if (a && b) {
-		RETURN(strcmp(a, b));
-	} else {
-		RETURN(0);
+static int Replace_strcat() {
+	u32 destPtr = PARAM(0);
+	u32 srcPtr = PARAM(1);
+	u32 destLen = GuestStrnlen(destPtr, 0xFFFFFFFF);
+	u32 srcLen = GuestStrnlen(srcPtr, 0xFFFFFFFF);
+	if (Memory::IsValidRange(destPtr, destLen + srcLen + 1) && Memory::IsValidRange(srcPtr, srcLen + 1)) {
+		memmove(Memory::GetPointerWriteUnchecked(destPtr + destLen), Memory::GetPointerUnchecked(srcPtr), srcLen + 1);
+		NotifyMemInfo(MemBlockFlags::WRITE, destPtr + destLen, srcLen + 1, "ReplaceStrcat");
 	}
-	return 10;  // approximation
+	RETURN(destPtr);
+	return 10 + destLen + srcLen;  // approximation
+}
+
+static int Replace_strcmp() {
+	u32 compared;
+	RETURN(GuestCompare(PARAM(0), PARAM(1), 0xFFFFFFFF, true, &compared));
+	return 10 + compared;  // approximation
 }
 
 static int Replace_strncmp() {
-	const char *a = (const char *)Memory::GetPointer(PARAM(0));
-	const char *b = (const char *)Memory::GetPointer(PARAM(1));
-	u32 bytes = PARAM(2);
-	if (a && b && bytes != 0) {
-		RETURN(strncmp(a, b, bytes));
+	u32 compared;
+	RETURN(GuestCompare(PARAM(0), PARAM(1), PARAM(2), true, &compared));
+	return 10 + compared;  // approximation
+}
+
+static int Replace_memcmp() {
+	u32 compared;
+	RETURN(GuestCompare(PARAM(0), PARAM(1), PARAM(2), false, &compared));
+	return 10 + compared;  // approximation
+}
+
+static int Replace_bcmp() {
+	// Only zero or non-zero matters here, but returning the same as memcmp is fine.
+	u32 compared;
+	RETURN(GuestCompare(PARAM(0), PARAM(1), PARAM(2), false, &compared));
+	return 10 + compared;  // approximation
+}
+
+static int Replace_memchr() {
+	u32 srcPtr = PARAM(0);
+	u8 value = PARAM(1);
+	u32 bytes = Memory::IsValidAddress(srcPtr) ? Memory::ValidSize(srcPtr, PARAM(2)) : 0;
+	const u8 *src = Memory::GetPointer(srcPtr);
+	const u8 *found = bytes != 0 ? (const u8 *)memchr(src, value, bytes) : nullptr;
+	RETURN(found ? srcPtr + (u32)(found - src) : 0);
+	return 10 + (found ? (u32)(found - src) : bytes);  // approximation
+}
+
+static int Replace_strchr() {
+	u32 srcPtr = PARAM(0);
+	u8 value = PARAM(1);
+	u32 len = GuestStrnlen(srcPtr, 0xFFFFFFFF);
+	const u8 *src = Memory::GetPointer(srcPtr);
+	u32 result = 0;
+	if (value == 0) {
+		// Searching for the terminator itself is allowed, and returns a pointer to it.
+		if (src && Memory::IsValidAddress(srcPtr + len))
+			result = srcPtr + len;
+	} else if (len != 0) {
+		const u8 *found = (const u8 *)memchr(src, value, len);
+		if (found)
+			result = srcPtr + (u32)(found - src);
+	}
+	RETURN(result);
+	return 10 + len;  // approximation
+}
+
+static int Replace_strrchr() {
+	u32 srcPtr = PARAM(0);
+	u8 value = PARAM(1);
+	u32 len = GuestStrnlen(srcPtr, 0xFFFFFFFF);
+	const u8 *src = Memory::GetPointer(srcPtr);
+	u32 result = 0;
+	if (value == 0) {
+		if (src && Memory::IsValidAddress(srcPtr + len))
+			result = srcPtr + len;
 	} else {
-		RETURN(0);
+		for (u32 i = len; i > 0; --i) {
+			if (src[i - 1] == value) {
+				result = srcPtr + i - 1;
+				break;
+			}
+		}
 	}
-	return 10 + bytes / 4;  // approximation
+	RETURN(result);
+	return 10 + len;  // approximation
 }
 
 static int Replace_fabsf() {
@@ -1383,14 +1487,16 @@ static const ReplacementTableEntry entries[] = {
 	{ "acosf", &Replace_acosf, 0, REPFLAG_DISABLED },
 	*/
 
+	// Host libm can differ in the last bit from newlib here, so these stay off.  sqrtf/floorf/ceilf
+	// have exactly specified results, so they're safe to replace.
 	{ "sinf", &Replace_sinf, 0, REPFLAG_DISABLED },
 	{ "cosf", &Replace_cosf, 0, REPFLAG_DISABLED },
 	{ "tanf", &Replace_tanf, 0, REPFLAG_DISABLED },
 	{ "atanf", &Replace_atanf, 0, REPFLAG_DISABLED },
-	{ "sqrtf", &Replace_sqrtf, 0, REPFLAG_DISABLED },
+	{ "sqrtf", &Replace_sqrtf, 0, 0 },
 	{ "atan2f", &Replace_atan2f, 0, REPFLAG_DISABLED },
-	{ "floorf", &Replace_floorf, 0, REPFLAG_DISABLED },
-	{ "ceilf", &Replace_ceilf, 0, REPFLAG_DISABLED },
+	{ "floorf", &Replace_floorf, 0, 0 },
+	{ "ceilf", &Replace_ceilf, 0, 0 },
 
 	{ "memcpy", &Replace_memcpy, 0, 0 },
 	{ "memcpy_jak", &Replace_memcpy_jak, 0, 0 },
@@ -1399,11 +1505,18 @@ static const ReplacementTableEntry entries[] = {
 	{ "memmove", &Replace_memmove, 0, 0 },
 	{ "memset", &Replace_memset, 0, 0 },
 	{ "memset_jak", &Replace_memset_jak, 0, 0 },
-	{ "strlen", &Replace_strlen, 0, REPFLAG_DISABLED },
-	{ "strcpy", &Replace_strcpy, 0, REPFLAG_DISABLED },
-	{ "strncpy", &Replace_strncpy, 0, REPFLAG_DISABLED },
-	{ "strcmp", &Replace_strcmp, 0, REPFLAG_DISABLED },
-	{ "strncmp", &Replace_strncmp, 0, REPFLAG_DISABLED },
+	{ "strlen", &Replace_strlen, 0, 0 },
+	{ "strnlen", &Replace_strnlen, 0, 0 },
+	{ "strcpy", &Replace_strcpy, 0, 0 },
+	{ "strncpy", &Replace_strncpy, 0, 0 },
+	{ "strcat", &Replace_strcat, 0, 0 },
+	{ "strcmp", &Replace_strcmp, 0, 0 },
+	{ "strncmp", &Replace_strncmp, 0, 0 },
+	{ "strchr", &Replace_strchr, 0, 0 },
+	{ "strrchr", &Replace_strrchr, 0, 0 },
+	{ "memcmp", &Replace_memcmp, 0, 0 },
+	{ "bcmp", &Replace_bcmp, 0, 0 },
+	{ "memchr", &Replace_memchr, 0, 0 },
 	{ "fabsf", &Replace_fabsf, JITFUNC(Replace_fabsf), REPFLAG_ALLOWINLINE | REPFLAG_DISABLED },
 	{ "dl_write_matrix", &Replace_dl_write_matrix, 0, REPFLAG_DISABLED }, // &MIPSComp::Jit::Replace_dl_write_matrix, REPFLAG_DISABLED },
 	{ "dl_write_matrix_2", &Replace_dl_write_matrix, 0, REPFLAG_DISABLED },
@@ -1494,6 +1607,8 @@ static const ReplacementTableEntry entries[] = {
 
 
 static std::map<u32, u32> replacedInstructions;
+// The jit may look up replaced ops while compiling in the background.
+static std::mutex replacedInstructionsLock;
 static std::unordered_map<std::string, std::vector<int> > replacementNameLookup;
 
 void Replacement_Init() {
@@ -1508,6 +1623,7 @@ void Replacement_Init() {
 }
 
 void Replacement_Shutdown() {
+	std::lock_guard<std::mutex> guard(replacedInstructionsLock);
 	replacedInstructions.clear();
 	replacementNameLookup.clear();
 }
@@ -1535,6 +1651,7 @@ const ReplacementTableEntry *GetReplacementFunc(int i) {
 }
 
 static bool WriteReplaceInstruction(u32 address, int index) {
+	std::lock_guard<std::mutex> guard(replacedInstructionsLock);
 	u32 prevInstr = Memory::Read_Instruction(address, false).encoding;
 	if (MIPS_IS_REPLACEMENT(prevInstr)) {
 		int prevIndex = prevInstr & MIPS_EMUHACK_VALUE_MASK;
@@ -1586,6 +1703,7 @@ void WriteReplaceInstructions(u32 address, u64 hash, int size) {
 }
 
 void RestoreReplacedInstruction(u32 address) {
+	std::lock_guard<std::mutex> guard(replacedInstructionsLock);
 	const u32 curInstr = Memory::Read_U32(address);
 	if (MIPS_IS_REPLACEMENT(curInstr)) {
 		Memory::Write_U32(replacedInstructions[address], address);
@@ -1602,6 +1720,7 @@ void RestoreReplacedInstructions(u32 startAddr, u32 endAddr) {
 	// Need to be in order, or we'll hang.
 	if (endAddr < startAddr)
 		std::swap(endAddr, startAddr);
+	std::lock_guard<std::mutex> guard(replacedInstructionsLock);
 	const auto start = replacedInstructions.lower_bound(startAddr);
 	const auto end = replacedInstructions.upper_bound(endAddr);
 	int restored = 0;
@@ -1619,6 +1738,7 @@ void RestoreReplacedInstructions(u32 startAddr, u32 endAddr) {
 
 std::map<u32, u32> SaveAndClearReplacements() {
 	std::map<u32, u32> saved;
+	std::lock_guard<std::mutex> guard(replacedInstructionsLock);
 	for (auto it = replacedInstructions.begin(), end = replacedInstructions.end(); it != end; ++it) {
 		const u32 addr = it->first;
 		const u32 curInstr = Memory::Read_U32(addr);
@@ -1641,6 +1761,7 @@ void RestoreSavedReplacements(const std::map<u32, u32> &saved) {
 bool GetReplacedOpAt(u32 address, u32 *op) {
 	u32 instr = Memory::Read_Opcode_JIT(address).encoding;
 	if (MIPS_IS_REPLACEMENT(instr)) {
+		std::lock_guard<std::mutex> guard(replacedInstructionsLock);
 		auto iter = replacedInstructions.find(address);
 		if (iter != replacedInstructions.end()) {
 			*op = iter->second;
@@ -44,15 +44,12 @@
 #include "Core/HLE/sceAudio.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceKernelThread.h"
+#include "Core/HLE/sceSas.h"
 #include "Core/HW/StereoResampler.h"
 #include "Core/Util/AudioFormat.h"
 
 StereoResampler resampler;
 
-// Should be used to lock anything related to the outAudioQueue.
-// atomic locks are used on the lock. TODO: make this lock-free
-std::atomic_flag atomicLock_;
-
 // We copy samples as they are written into this simple ring buffer.
 // Might try something more efficient later.
 FixedSizeQueue<s16, 32768 * 8> chanSampleQueues[PSP_AUDIO_CHANNEL_MAX + 1];
@@ -235,6 +232,9 @@ u32 __AudioEnqueue(AudioChannel &chan, int chanNum, bool blocking) {
 		return ret;
 	}
 
+	// The samples might be a mix that hasn't reached memory yet.
+	__SasFlushOutput();
+
 	int leftVol = chan.leftVolume;
 	int rightVol = chan.rightVolume;
 
@@ -424,7 +424,8 @@ void __AudioUpdate(bool resetRecording) {
 		memset(mixBuffer, 0, hwBlockSize * 2 * sizeof(s32));
 	}
 
-	if (g_Config.bEnableSound) {
+	// Frames that run ahead get rolled back, and the real ones play their audio.
+	if (g_Config.bEnableSound && !PSP_CoreParameter().runAheadSpeculative) {
 		resampler.PushSamples(mixBuffer, hwBlockSize);
 #ifndef MOBILE_DEVICE
 		if (g_Config.bSaveLoadResetsAVdumping && resetRecording) {
@@ -50,6 +50,11 @@ extern "C" struct hostent *gethostbyname(const char *name);
 #include <netinet/tcp.h>
 #endif
 
+#if !defined(_WIN32) && !PPSSPP_PLATFORM(SWITCH)
+#include <poll.h>
+#define ADHOCSERVER_USE_POLL
+#endif
+
 #include <fcntl.h>
 #include <errno.h>
 //#include <sqlite3.h>
@@ -73,6 +78,9 @@ extern "C" struct hostent *gethostbyname(const char *name);
 // User Count
 uint32_t _db_user_count = 0;
 
+// Logout Count (lets the Server Loop notice that User Nodes may have been freed)
+uint32_t _db_logout_count = 0;
+
 // User Database
 SceNetAdhocctlUserNode * _db_user = NULL;
 
@@ -498,6 +506,8 @@ void enable_keepalive(int fd);
 void change_nodelay_mode(int fd, int flag);
 void change_blocking_mode(int fd, int nonblocking);
 int create_listen_socket(uint16_t port);
+void process_user_packet(SceNetAdhocctlUserNode * user);
+void wait_for_activity(int server, int timeoutMs);
 int server_loop(int server);
 
 void __AdhocServerInit() {
@@ -729,6 +739,9 @@ void logout_user(SceNetAdhocctlUserNode * user)
 	// Fix User Counter
 	_db_user_count--;
 
+	// Fix Logout Counter
+	_db_logout_count++;
+
 	// Update Status Log
 	update_status();
 }
@@ -1876,6 +1889,182 @@ int create_listen_socket(uint16_t port)
 	return -1;
 }
 
+/**
+ * Process one Packet from the RX Buffer of a User
+ * @param user User Node (may be logged out and freed by this)
+ */
+void process_user_packet(SceNetAdhocctlUserNode * user)
+{
+	// Waiting for Login Packet
+	if(get_user_state(user) == USER_STATE_WAITING)
+	{
+		// Valid Opcode
+		if(user->rx[0] == OPCODE_LOGIN)
+		{
+			// Enough Data available
+			if(user->rxpos >= sizeof(SceNetAdhocctlLoginPacketC2S))
+			{
+				// Clone Packet
+				SceNetAdhocctlLoginPacketC2S packet = *(SceNetAdhocctlLoginPacketC2S *)user->rx;
+
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, sizeof(SceNetAdhocctlLoginPacketC2S));
+
+				// Login User (Data)
+				login_user_data(user, &packet);
+			}
+		}
+
+		// Invalid Opcode
+		else
+		{
+			// Notify User
+			WARN_LOG(SCENET, "AdhocServer: Invalid Opcode 0x%02X in Waiting State from %s", user->rx[0], ip2str(*(in_addr*)&user->resolver.ip).c_str());
+
+			// Logout User
+			logout_user(user);
+		}
+	}
+
+	// Logged-In User
+	else if(get_user_state(user) == USER_STATE_LOGGED_IN)
+	{
+		// Ping Packet
+		if(user->rx[0] == OPCODE_PING)
+		{
+			// Delete Packet from RX Buffer
+			clear_user_rxbuf(user, 1);
+		}
+
+		// Group Connect Packet
+		else if(user->rx[0] == OPCODE_CONNECT)
+		{
+			// Enough Data available
+			if(user->rxpos >= sizeof(SceNetAdhocctlConnectPacketC2S))
+			{
+				// Cast Packet
+				SceNetAdhocctlConnectPacketC2S * packet = (SceNetAdhocctlConnectPacketC2S *)user->rx;
+
+				// Clone Group Name
+				SceNetAdhocctlGroupName group = packet->group;
+
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, sizeof(SceNetAdhocctlConnectPacketC2S));
+
+				// Change Game Group
+				connect_user(user, &group);
+			}
+		}
+
+		// Group Disconnect Packet
+		else if(user->rx[0] == OPCODE_DISCONNECT)
+		{
+			// Remove Packet from RX Buffer
+			clear_user_rxbuf(user, 1);
+
+			// Leave Game Group
+			disconnect_user(user);
+		}
+
+		// Network Scan Packet
+		else if(user->rx[0] == OPCODE_SCAN)
+		{
+			// Remove Packet from RX Buffer
+			clear_user_rxbuf(user, 1);
+
+			// Send Network List
+			send_scan_results(user);
+		}
+
+		// Chat Text Packet
+		else if(user->rx[0] == OPCODE_CHAT)
+		{
+			// Enough Data available
+			if(user->rxpos >= sizeof(SceNetAdhocctlChatPacketC2S))
+			{
+				// Cast Packet
+				SceNetAdhocctlChatPacketC2S * packet = (SceNetAdhocctlChatPacketC2S *)user->rx;
+
+				// Clone Buffer for Message
+				char message[64];
+				memset(message, 0, sizeof(message));
+				strncpy(message, packet->message, sizeof(message) - 1);
+
+				// Remove Packet from RX Buffer
+				clear_user_rxbuf(user, sizeof(SceNetAdhocctlChatPacketC2S));
+
+				// Spread Chat Message
+				spread_message(user, message);
+			}
+		}
+
+		// Invalid Opcode
+		else
+		{
+			// Notify User
+			WARN_LOG(SCENET, "AdhocServer: Invalid Opcode 0x%02X in Logged-In State from %s (MAC: %s - IP: %s)", user->rx[0], (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str());
+
+			// Logout User
+			logout_user(user);
+		}
+	}
+}
+
+/**
+ * Wait until the Server Socket or any User Stream has Data, or the Timeout expires
+ * @param server Server Listening Socket
+ * @param timeoutMs Timeout in Milliseconds
+ */
+void wait_for_activity(int server, int timeoutMs)
+{
+#ifdef ADHOCSERVER_USE_POLL
+	// Reused between Calls, so we don't allocate every Wakeup
+	static std::vector<pollfd> fds;
+	fds.clear();
+
+	// Listening Socket (New Logins)
+	fds.push_back({ server, POLLIN, 0 });
+
+	// User Streams (Data or Disconnect)
+	for(SceNetAdhocctlUserNode * user = _db_user; user != NULL; user = user->next)
+		fds.push_back({ user->stream, POLLIN, 0 });
+
+	// Wait for anything to happen
+	poll(fds.data(), (nfds_t)fds.size(), timeoutMs);
+#else
+	// select() can only watch FD_SETSIZE Sockets (64 by default on Windows)
+	fd_set readfds;
+	FD_ZERO(&readfds);
+	FD_SET(server, &readfds);
+	int maxfd = server;
+	int count = 1;
+
+	for(SceNetAdhocctlUserNode * user = _db_user; user != NULL; user = user->next)
+	{
+#ifndef _WIN32
+		// Descriptors beyond FD_SETSIZE can't go into a fd_set at all
+		if(user->stream >= FD_SETSIZE)
+		{
+			count = FD_SETSIZE;
+			break;
+		}
+#endif
+		if(count >= FD_SETSIZE) break;
+		FD_SET(user->stream, &readfds);
+		if(user->stream > maxfd) maxfd = user->stream;
+		count++;
+	}
+
+	// Some Users aren't watched, so fall back to short Sleeps to keep their Latency down
+	if(count >= FD_SETSIZE && timeoutMs > 10) timeoutMs = 10;
+
+	timeval tval;
+	tval.tv_sec = timeoutMs / 1000;
+	tval.tv_usec = (timeoutMs % 1000) * 1000;
+	select(maxfd + 1, &readfds, nullptr, nullptr, &tval);
+#endif
+}
+
 /**
  * Server Main Loop
  * @param server Server Listening Socket
@@ -1893,6 +2082,9 @@ int server_loop(int server)
 	// Handling Loop
 	while (adhocServerRunning) //(_status == 1)
 	{
+		// Data left in a RX Buffer that still needs Processing
+		bool pending = false;
+
 		// Login Block
 		{
 			// Login Result
@@ -1965,127 +2157,34 @@ int server_loop(int server)
 					user->last_recv = time(NULL);
 				}
 
-				// Waiting for Login Packet
-				if(get_user_state(user) == USER_STATE_WAITING)
-				{
-					// Valid Opcode
-					if(user->rx[0] == OPCODE_LOGIN)
-					{
-						// Enough Data available
-						if(user->rxpos >= sizeof(SceNetAdhocctlLoginPacketC2S))
-						{
-							// Clone Packet
-							SceNetAdhocctlLoginPacketC2S packet = *(SceNetAdhocctlLoginPacketC2S *)user->rx;
-
-							// Remove Packet from RX Buffer
-							clear_user_rxbuf(user, sizeof(SceNetAdhocctlLoginPacketC2S));
-
-							// Login User (Data)
-							login_user_data(user, &packet);
-						}
-					}
-
-					// Invalid Opcode
-					else
-					{
-						// Notify User
-						WARN_LOG(SCENET, "AdhocServer: Invalid Opcode 0x%02X in Waiting State from %s", user->rx[0], ip2str(*(in_addr*)&user->resolver.ip).c_str());
-
-						// Logout User
-						logout_user(user);
-					}
-				}
-
-				// Logged-In User
-				else if(get_user_state(user) == USER_STATE_LOGGED_IN)
+				// Handle every complete Packet in the RX Buffer, not just one per wakeup
+				size_t rxpos;
+				do
 				{
-					// Ping Packet
-					if(user->rx[0] == OPCODE_PING)
-					{
-						// Delete Packet from RX Buffer
-						clear_user_rxbuf(user, 1);
-					}
+					// Remember Buffer Fill, so we can stop once a Packet is incomplete
+					rxpos = user->rxpos;
 
-					// Group Connect Packet
-					else if(user->rx[0] == OPCODE_CONNECT)
-					{
-						// Enough Data available
-						if(user->rxpos >= sizeof(SceNetAdhocctlConnectPacketC2S))
-						{
-							// Cast Packet
-							SceNetAdhocctlConnectPacketC2S * packet = (SceNetAdhocctlConnectPacketC2S *)user->rx;
+					// Handlers may logout (and free) this or any other User
+					uint32_t logouts = _db_logout_count;
 
-							// Clone Group Name
-							SceNetAdhocctlGroupName group = packet->group;
+					// Process Packet
+					process_user_packet(user);
 
-							// Remove Packet from RX Buffer
-							clear_user_rxbuf(user, sizeof(SceNetAdhocctlConnectPacketC2S));
-
-							// Change Game Group
-							connect_user(user, &group);
-						}
-					}
-
-					// Group Disconnect Packet
-					else if(user->rx[0] == OPCODE_DISCONNECT)
+					// User Database changed, pick the remaining Data up on the next wakeup
+					if(_db_logout_count != logouts)
 					{
-						// Remove Packet from RX Buffer
-						clear_user_rxbuf(user, 1);
-
-						// Leave Game Group
-						disconnect_user(user);
-					}
-
-					// Network Scan Packet
-					else if(user->rx[0] == OPCODE_SCAN)
-					{
-						// Remove Packet from RX Buffer
-						clear_user_rxbuf(user, 1);
-
-						// Send Network List
-						send_scan_results(user);
-					}
-
-					// Chat Text Packet
-					else if(user->rx[0] == OPCODE_CHAT)
-					{
-						// Enough Data available
-						if(user->rxpos >= sizeof(SceNetAdhocctlChatPacketC2S))
-						{
-							// Cast Packet
-							SceNetAdhocctlChatPacketC2S * packet = (SceNetAdhocctlChatPacketC2S *)user->rx;
-
-							// Clone Buffer for Message
-							char message[64];
-							memset(message, 0, sizeof(message));
-							strncpy(message, packet->message, sizeof(message) - 1);
-
-							// Remove Packet from RX Buffer
-							clear_user_rxbuf(user, sizeof(SceNetAdhocctlChatPacketC2S));
-
-							// Spread Chat Message
-							spread_message(user, message);
-						}
-					}
-
-					// Invalid Opcode
-					else
-					{
-						// Notify User
-						WARN_LOG(SCENET, "AdhocServer: Invalid Opcode 0x%02X in Logged-In State from %s (MAC: %s - IP: %s)", user->rx[0], (char *)user->resolver.name.data, mac2str(&user->resolver.mac).c_str(), ip2str(*(in_addr*)&user->resolver.ip).c_str());
-
-						// Logout User
-						logout_user(user);
+						pending = true;
+						break;
 					}
-				}
+				} while(user->rxpos > 0 && user->rxpos != rxpos);
 			}
 
 			// Move Pointer
 			user = next;
 		}
 
-		// Prevent needless CPU Overload (1ms Sleep)
-		sleep_ms(10);
+		// Sleep until there's something to do, instead of polling every User
+		if(!pending) wait_for_activity(server, SERVER_IDLE_WAIT_MS);
 
 		// Don't do anything if it's paused, otherwise the log will be flooded
 		while (adhocServerRunning && Core_IsStepping() && coreState != CORE_POWERDOWN) sleep_ms(10);
@@ -39,6 +39,9 @@
 // Server User Timeout (in seconds)
 #define SERVER_USER_TIMEOUT 15
 
+// Server Idle Wait (in milliseconds), how long to wait for Data before checking Timeouts and Shutdown again
+#define SERVER_IDLE_WAIT_MS 100
+
 // Server SQLite3 Database
 #define SERVER_DATABASE "database.db"
 
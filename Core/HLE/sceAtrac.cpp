@@ -16,9 +16,13 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <deque>
+#include <vector>
 
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/Thread/Waitable.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
 #include "Core/MIPS/MIPS.h"
@@ -116,6 +120,8 @@ const u32 ATRAC3_MAX_SAMPLES = 0x400;
 const u32 ATRAC3PLUS_MAX_SAMPLES = 0x800;
 
 static const int atracDecodeDelay = 2300;
+// How many frames to keep decoded ahead of the game, when the data is all in dataBuf_.
+static const size_t atracDecodeAheadFrames = 4;
 
 #ifdef USE_FFMPEG
 
@@ -195,6 +201,7 @@ struct Atrac {
 	}
 
 	void ResetData() {
+		DiscardDecodeAhead();
 #ifdef USE_FFMPEG
 		ReleaseFFMPEGContext();
 #endif // USE_FFMPEG
@@ -237,6 +244,12 @@ struct Atrac {
 		if (!s)
 			return;
 
+		// Frames decoded ahead aren't saved, they're simply decoded again after load.
+		if (p.mode == p.MODE_READ)
+			DiscardDecodeAhead();
+		else
+			WaitDecodeAhead();
+
 		Do(p, channels_);
 		Do(p, outputChannels_);
 		if (s >= 5) {
@@ -469,6 +482,7 @@ struct Atrac {
 #endif // USE_FFMPEG
 
 	void ForceSeekToSample(int sample) {
+		DiscardDecodeAhead();
 #ifdef USE_FFMPEG
 		avcodec_flush_buffers(codecCtx_);
 
@@ -485,6 +499,8 @@ struct Atrac {
 
 	void SeekToSample(int sample) {
 #ifdef USE_FFMPEG
+		// If frames were decoded ahead, the decoder is past currentSample_ and needs priming again.
+		const bool decoderAhead = DiscardDecodeAhead();
 		// Discard any pending packet data.
 		packet_->size = 0;
 
@@ -493,7 +509,7 @@ struct Atrac {
 		const u32 unalignedSamples = (offsetSamples + sample) % SamplesPerFrame();
 		int seekFrame = sample + offsetSamples - unalignedSamples;
 
-		if ((sample != currentSample_ || sample == 0) && codecCtx_ != nullptr) {
+		if ((sample != currentSample_ || sample == 0 || decoderAhead) && codecCtx_ != nullptr) {
 			// Prefill the decode buffer with packets before the first sample offset.
 			avcodec_flush_buffers(codecCtx_);
 
@@ -515,6 +531,8 @@ struct Atrac {
 				DecodePacket();
 			}
 		}
+#else
+		DiscardDecodeAhead();
 #endif // USE_FFMPEG
 
 		currentSample_ = sample;
@@ -610,6 +628,59 @@ struct Atrac {
 
 	void CalculateStreamInfo(u32 *readOffset);
 
+	// Frames decoded on a worker in advance, in the same order and from the same data as
+	// _AtracDecodeData would.  Only used while all the frames needed are in dataBuf_.
+	struct DecodedFrame {
+		int sample;
+		u32 samples;
+		std::vector<s16> pcm;
+	};
+
+	void StartDecodeAhead();
+	// Runs on the worker, see StartDecodeAhead().
+	void DecodeAhead();
+
+	void WaitDecodeAhead() {
+		if (aheadWaitable_) {
+			aheadWaitable_->WaitAndRelease();
+			aheadWaitable_ = nullptr;
+		}
+	}
+
+	// True if the decoder has moved past currentSample_.
+	bool DecoderAhead() {
+		WaitDecodeAhead();
+		return !aheadFrames_.empty() || aheadOutOfSync_;
+	}
+
+	// Returns whether the decoder had moved past currentSample_.
+	bool DiscardDecodeAhead() {
+		bool decoderAhead = DecoderAhead();
+		aheadFrames_.clear();
+		aheadOutOfSync_ = false;
+		return decoderAhead;
+	}
+
+	// Outputs the frame at currentSample_ if it was already decoded.
+	bool UseDecodedAhead(u8 *outbuf, u32 outbufPtr, u32 maxSamples, u32 *numSamples) {
+		WaitDecodeAhead();
+		if (aheadFrames_.empty() || aheadFrames_.front().sample != currentSample_) {
+			// SeekToSample() will get the decoder back in sync.
+			return false;
+		}
+
+		const DecodedFrame &frame = aheadFrames_.front();
+		*numSamples = std::min(maxSamples, frame.samples);
+		if (outbuf != nullptr && *numSamples != 0) {
+			u32 outBytes = *numSamples * outputChannels_ * sizeof(s16);
+			memcpy(outbuf, frame.pcm.data(), outBytes);
+			if (outbufPtr != 0)
+				NotifyMemInfo(MemBlockFlags::WRITE, outbufPtr, outBytes, "AtracDecode");
+		}
+		aheadFrames_.pop_front();
+		return true;
+	}
+
 	u32 StreamBufferEnd() const {
 		// The buffer is always aligned to a frame in size, not counting an optional header.
 		// The header will only initially exist after the data is first set.
@@ -633,8 +704,106 @@ struct Atrac {
 
 private:
 	void AnalyzeReset();
+
+	std::deque<DecodedFrame> aheadFrames_;
+	// Limits for the worker, taken when it's started since the game may change them.
+	int aheadNextSample_ = 0;
+	int aheadEndSample_ = 0;
+	u32 aheadEndOffset_ = 0;
+	// The worker fed the decoder a packet it didn't queue a frame for.
+	bool aheadOutOfSync_ = false;
+	// While set, a worker owns the decoder and the fields above.
+	LimitedWaitable *aheadWaitable_ = nullptr;
 };
 
+class AtracDecodeAheadTask : public Task {
+public:
+	AtracDecodeAheadTask(Atrac *atrac, LimitedWaitable *waitable) : atrac_(atrac), waitable_(waitable) {}
+
+	TaskType Type() const override {
+		return TaskType::CPU_COMPUTE;
+	}
+
+	void Run() override {
+		atrac_->DecodeAhead();
+	}
+
+	void Release() override {
+		// Also called without Run() on teardown, so always notify here.
+		waitable_->Notify();
+		delete this;
+	}
+
+private:
+	Atrac *atrac_;
+	LimitedWaitable *waitable_;
+};
+
+void Atrac::StartDecodeAhead() {
+#ifdef USE_FFMPEG
+	if (aheadWaitable_ || aheadOutOfSync_ || failedDecode_ || ignoreDataBuf_ || !dataBuf_ || !codecCtx_ || !swrCtx_)
+		return;
+	if (codecType_ != PSP_MODE_AT_3 && codecType_ != PSP_MODE_AT_3_PLUS)
+		return;
+	// Streamed data gets overwritten by the game, so only when it's all in our copy.
+	if (bufferState_ != ATRAC_STATUS_ALL_DATA_LOADED && bufferState_ != ATRAC_STATUS_HALFWAY_BUFFER)
+		return;
+	// Unaligned samples (after a loop) and the start always seek, which primes the decoder.
+	const u32 offsetSamples = firstSampleOffset_ + FirstOffsetExtra();
+	if (currentSample_ <= 0 || (offsetSamples + currentSample_) % SamplesPerFrame() != 0)
+		return;
+
+	aheadNextSample_ = aheadFrames_.empty() ? currentSample_ : aheadFrames_.back().sample + SamplesPerFrame();
+	aheadEndSample_ = endSample_;
+	if (loopNum_ != 0) {
+		// Past the loop end, we'll seek anyway.
+		int loopEndAdjusted = loopEndSample_ - FirstOffsetExtra() - firstSampleOffset_;
+		aheadEndSample_ = std::min(aheadEndSample_, loopEndAdjusted + 1);
+	}
+	aheadEndOffset_ = first_.size;
+	if (aheadFrames_.size() >= atracDecodeAheadFrames || aheadNextSample_ >= aheadEndSample_)
+		return;
+
+	aheadWaitable_ = new LimitedWaitable();
+	g_threadManager.EnqueueTask(new AtracDecodeAheadTask(this, aheadWaitable_));
+#endif // USE_FFMPEG
+}
+
+void Atrac::DecodeAhead() {
+#ifdef USE_FFMPEG
+	while (aheadFrames_.size() < atracDecodeAheadFrames) {
+		const int sample = aheadNextSample_;
+		const u32 off = FileOffsetBySample(sample);
+		// Only whole frames, a partial one might still get more data.
+		if (sample >= aheadEndSample_ || off + bytesPerFrame_ > aheadEndOffset_)
+			break;
+
+		av_init_packet(packet_);
+		packet_->data = dataBuf_ + off;
+		packet_->size = bytesPerFrame_;
+		packet_->pos = off;
+		if (DecodePacket() != ATDECODE_GOTFRAME) {
+			// Leave it to _AtracDecodeData to decode again and handle at the right time.
+			failedDecode_ = false;
+			aheadOutOfSync_ = true;
+			break;
+		}
+
+		DecodedFrame frame;
+		frame.sample = sample;
+		frame.samples = frame_->nb_samples;
+		frame.pcm.resize(frame.samples * outputChannels_);
+		u8 *out = (u8 *)frame.pcm.data();
+		int avret = swr_convert(swrCtx_, &out, frame.samples, (const u8 **)frame_->extended_data, frame.samples);
+		if (avret < 0) {
+			ERROR_LOG(ME, "swr_convert: Error while converting %d", avret);
+		}
+		aheadFrames_.push_back(std::move(frame));
+		aheadNextSample_ = sample + SamplesPerFrame();
+	}
+#endif // USE_FFMPEG
+}
+
 struct AtracSingleResetBufferInfo {
 	u32_le writePosPtr;
 	u32_le writableBytes;
@@ -743,6 +912,7 @@ static int deleteAtrac(int atracID) {
 }
 
 void Atrac::AnalyzeReset() {
+	DiscardDecodeAhead();
 	// Reset some values.
 	codecType_ = 0;
 	currentSample_ = 0;
@@ -1213,69 +1383,73 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 			}
 
 			if (!atrac->failedDecode_ && (atrac->codecType_ == PSP_MODE_AT_3 || atrac->codecType_ == PSP_MODE_AT_3_PLUS)) {
-				atrac->SeekToSample(atrac->currentSample_);
-
 				AtracDecodeResult res = ATDECODE_FEEDME;
-				while (atrac->FillPacket(-skipSamples)) {
-					uint32_t packetAddr = atrac->CurBufferAddress(-skipSamples);
+				if (skipSamples == 0 && atrac->UseDecodedAhead(outbuf, outbufPtr, maxSamples, &numSamples)) {
+					res = ATDECODE_GOTFRAME;
+				} else {
+					atrac->SeekToSample(atrac->currentSample_);
+
+					while (atrac->FillPacket(-skipSamples)) {
+						uint32_t packetAddr = atrac->CurBufferAddress(-skipSamples);
 #ifdef USE_FFMPEG
-					int packetSize = atrac->packet_->size;
+						int packetSize = atrac->packet_->size;
 #endif // USE_FFMPEG
-					res = atrac->DecodePacket();
-					if (res == ATDECODE_FAILED) {
-						*SamplesNum = 0;
-						*finish = 1;
-						return ATRAC_ERROR_ALL_DATA_DECODED;
-					}
+						res = atrac->DecodePacket();
+						if (res == ATDECODE_FAILED) {
+							*SamplesNum = 0;
+							*finish = 1;
+							return ATRAC_ERROR_ALL_DATA_DECODED;
+						}
 
-					if (res == ATDECODE_GOTFRAME) {
+						if (res == ATDECODE_GOTFRAME) {
 #ifdef USE_FFMPEG
-						// got a frame
-						int skipped = std::min(skipSamples, atrac->frame_->nb_samples);
-						skipSamples -= skipped;
-						numSamples = atrac->frame_->nb_samples - skipped;
+							// got a frame
+							int skipped = std::min(skipSamples, atrac->frame_->nb_samples);
+							skipSamples -= skipped;
+							numSamples = atrac->frame_->nb_samples - skipped;
 
-						// If we're at the end, clamp to samples we want.  It always returns a full chunk.
-						numSamples = std::min(maxSamples, numSamples);
-
-						if (skipped > 0 && numSamples == 0) {
-							// Wait for the next one.
-							res = ATDECODE_FEEDME;
-						}
+							// If we're at the end, clamp to samples we want.  It always returns a full chunk.
+							numSamples = std::min(maxSamples, numSamples);
 
-						if (outbuf != NULL && numSamples != 0) {
-							int inbufOffset = 0;
-							if (skipped != 0) {
-								AVSampleFormat fmt = (AVSampleFormat)atrac->frame_->format;
-								// We want the offset per channel.
-								inbufOffset = av_samples_get_buffer_size(NULL, 1, skipped, fmt, 1);
+							if (skipped > 0 && numSamples == 0) {
+								// Wait for the next one.
+								res = ATDECODE_FEEDME;
 							}
 
-							u8 *out = outbuf;
-							const u8 *inbuf[2] = {
-								atrac->frame_->extended_data[0] + inbufOffset,
-								atrac->frame_->extended_data[1] + inbufOffset,
-							};
-							int avret = swr_convert(atrac->swrCtx_, &out, numSamples, inbuf, numSamples);
-							if (outbufPtr != 0) {
-								u32 outBytes = numSamples * atrac->outputChannels_ * sizeof(s16);
-								if (packetAddr != 0 && MemBlockInfoDetailed()) {
-									const std::string tag = "AtracDecode/" + GetMemWriteTagAt(packetAddr, packetSize);
-									NotifyMemInfo(MemBlockFlags::READ, packetAddr, packetSize, tag.c_str(), tag.size());
-									NotifyMemInfo(MemBlockFlags::WRITE, outbufPtr, outBytes, tag.c_str(), tag.size());
-								} else {
-									NotifyMemInfo(MemBlockFlags::WRITE, outbufPtr, outBytes, "AtracDecode");
+							if (outbuf != NULL && numSamples != 0) {
+								int inbufOffset = 0;
+								if (skipped != 0) {
+									AVSampleFormat fmt = (AVSampleFormat)atrac->frame_->format;
+									// We want the offset per channel.
+									inbufOffset = av_samples_get_buffer_size(NULL, 1, skipped, fmt, 1);
+								}
+
+								u8 *out = outbuf;
+								const u8 *inbuf[2] = {
+									atrac->frame_->extended_data[0] + inbufOffset,
+									atrac->frame_->extended_data[1] + inbufOffset,
+								};
+								int avret = swr_convert(atrac->swrCtx_, &out, numSamples, inbuf, numSamples);
+								if (outbufPtr != 0) {
+									u32 outBytes = numSamples * atrac->outputChannels_ * sizeof(s16);
+									if (packetAddr != 0 && MemBlockInfoDetailed()) {
+										const std::string tag = "AtracDecode/" + GetMemWriteTagAt(packetAddr, packetSize);
+										NotifyMemInfo(MemBlockFlags::READ, packetAddr, packetSize, tag.c_str(), tag.size());
+										NotifyMemInfo(MemBlockFlags::WRITE, outbufPtr, outBytes, tag.c_str(), tag.size());
+									} else {
+										NotifyMemInfo(MemBlockFlags::WRITE, outbufPtr, outBytes, "AtracDecode");
+									}
+								}
+								if (avret < 0) {
+									ERROR_LOG(ME, "swr_convert: Error while converting %d", avret);
 								}
 							}
-							if (avret < 0) {
-								ERROR_LOG(ME, "swr_convert: Error while converting %d", avret);
-							}
-						}
 #endif // USE_FFMPEG
-					}
-					if (res == ATDECODE_GOTFRAME || res == ATDECODE_BADFRAME) {
-						// We only want one frame per call, let's continue the next time.
-						break;
+						}
+						if (res == ATDECODE_GOTFRAME || res == ATDECODE_BADFRAME) {
+							// We only want one frame per call, let's continue the next time.
+							break;
+						}
 					}
 				}
 
@@ -1334,6 +1508,9 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 			// refresh context_
 			_AtracGenerateContext(atrac);
 		}
+		// Get the next frames ready while the game plays this one.
+		if (ret == 0)
+			atrac->StartDecodeAhead();
 	}
 
 	return ret;
@@ -1799,6 +1976,9 @@ static u32 sceAtracResetPlayPosition(int atracID, int sample, int bytesWrittenFi
 static int __AtracUpdateOutputMode(Atrac *atrac, int wanted_channels) {
 	if (atrac->swrCtx_ && atrac->outputChannels_ == wanted_channels)
 		return 0;
+	// Frames already decoded have the old channel count, so decode them again.
+	if (atrac->DecoderAhead())
+		atrac->SeekToSample(atrac->currentSample_);
 	atrac->outputChannels_ = wanted_channels;
 	int64_t wanted_channel_layout = av_get_default_channel_layout(wanted_channels);
 	int64_t dec_channel_layout = av_get_default_channel_layout(atrac->channels_);
@@ -2481,6 +2661,7 @@ static int sceAtracLowLevelDecode(int atracID, u32 sourceAddr, u32 sourceBytesCo
 	int numSamples = (atrac->codecType_ == PSP_MODE_AT_3_PLUS ? ATRAC3PLUS_MAX_SAMPLES : ATRAC3_MAX_SAMPLES);
 
 	if (!atrac->failedDecode_) {
+		atrac->DiscardDecodeAhead();
 		atrac->FillLowLevelPacket(srcp);
 
 		AtracDecodeResult res = atrac->DecodePacket();
@@ -20,6 +20,7 @@
 
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Core/Config.h"
 #include "Core/CoreTiming.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
@@ -142,6 +143,26 @@ static void __CtrlUpdateLatch()
 		ctrlBufRead = (ctrlBufRead + 1) % NUM_CTRL_BUFFERS;
 }
 
+// Refreshes the newest sample with the current host input, as if it had been taken just now.
+// The number of buffers, their timestamps and the latch are untouched, so buffered reads
+// behave the same, but the game sees input up to a frame sooner.
+static void __CtrlRefreshNewestBuffer()
+{
+	// Replays and rollback need input to line up exactly with samples.
+	if (!g_Config.bLateInputSampling || ReplayIsExecuting() || ReplayIsSaving() || ReplayIsRollback())
+		return;
+
+	std::lock_guard<std::mutex> guard(ctrlMutex);
+	u32 buttons = ctrlCurrent.buttons;
+	if (emuRapidFire && (emuRapidFireFrames % 10) < 5)
+		buttons &= CTRL_EMU_RAPIDFIRE_MASK;
+
+	CtrlData &newest = ctrlBufs[(ctrlBuf + NUM_CTRL_BUFFERS - 1) % NUM_CTRL_BUFFERS];
+	newest.buttons = buttons;
+	if (analogEnabled)
+		memcpy(newest.analog, ctrlCurrent.analog, sizeof(newest.analog));
+}
+
 static int __CtrlResetLatch()
 {
 	int oldBufs = ctrlLatchBufs;
@@ -236,6 +257,8 @@ static int __CtrlReadBuffer(u32 ctrlDataPtr, u32 nBufs, bool negative, bool peek
 	if (!peek && __IsInInterrupt())
 		return SCE_KERNEL_ERROR_ILLEGAL_CONTEXT;
 
+	__CtrlRefreshNewestBuffer();
+
 	u32 resetRead = ctrlBufRead;
 
 	u32 availBufs;
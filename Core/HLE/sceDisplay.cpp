@@ -19,6 +19,7 @@
 #include <cmath>
 #include <map>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 // TODO: Move this somewhere else, cleanup.
@@ -41,6 +42,7 @@
 #include "Core/Reporting.h"
 #include "Core/Core.h"
 #include "Core/System.h"
+#include "Core/Debugger/SampleProfiler.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
 #include "Core/HLE/sceDisplay.h"
@@ -112,6 +114,10 @@ static double curFrameTime;
 static double lastFrameTime;
 static double nextFrameTime;
 static int numVBlanksSinceFlip;
+// With low latency frame pacing, the throttle wait is deferred until the next frame starts.
+static double pendingFrameWait;
+// When we started emulating the current frame, for latency stats.
+static double frameEmuStartTime;
 
 const int PSP_DISPLAY_MODE_LCD = 0;
 
@@ -199,6 +205,8 @@ void __DisplayInit() {
 	curFrameTime = 0.0;
 	nextFrameTime = 0.0;
 	lastFrameTime = 0.0;
+	pendingFrameWait = 0.0;
+	frameEmuStartTime = 0.0;
 
 	__KernelRegisterWaitTypeFuncs(WAITTYPE_VBLANK, __DisplayVblankBeginCallback, __DisplayVblankEndCallback);
 }
@@ -252,6 +260,7 @@ void __DisplayDoState(PointerWrap &p) {
 		ScheduleLagSync();
 	}
 
+	gpu->SyncThread();
 	Do(p, gstate);
 
 	// TODO: GPU stuff is really not the responsibility of sceDisplay.
@@ -356,7 +365,7 @@ static int FrameTimingLimit() {
 		return g_Config.iFpsLimit2;
 	if (PSP_CoreParameter().fpsLimit == FPSLimit::ANALOG)
 		return PSP_CoreParameter().analogFpsLimit;
-	if (PSP_CoreParameter().fastForward)
+	if (PSP_CoreParameter().fastForward || PSP_CoreParameter().runAheadSpeculative)
 		return 0;
 	return 60;
 }
@@ -375,6 +384,26 @@ static void DoFrameDropLogging(float scaledTimestep) {
 	}
 }
 
+// Sleeping is coarse and tends to overshoot, so we stop a bit early and yield the rest of the way.
+static void WaitUntilTime(double target) {
+	const double yieldMargin = 0.0015;
+	double now;
+	SampleProfiler::BeginHostWait();
+	while ((now = time_now_d()) < target) {
+		const double left = target - now;
+		if (left > yieldMargin) {
+#ifdef _WIN32
+			sleep_ms(1);
+#else
+			usleep((long)((left - yieldMargin) * 1000000));
+#endif
+		} else {
+			std::this_thread::yield();
+		}
+	}
+	SampleProfiler::EndHostWait();
+}
+
 // Let's collect all the throttling and frameskipping logic here.
 static void DoFrameTiming(bool &throttle, bool &skipFrame, float timestep) {
 	PROFILE_THIS_SCOPE("timing");
@@ -424,23 +453,18 @@ static void DoFrameTiming(bool &throttle, bool &skipFrame, float timestep) {
 			skipFrame = true;
 	}
 
-	// TODO: This is NOT where we should wait, really! We should mark each outgoing frame with the desired
-	// timestamp to push it to display, and sleep in the render thread to achieve that.
-
+	// Waiting here means the frame we just finished sits around until the wait is over, adding a frame
+	// of latency. In low latency mode, we present right away and wait before emulating the next frame
+	// instead (see hleAfterFlip), so input is sampled as late as possible.
 	if (curFrameTime < nextFrameTime && throttle) {
 		// If time gap is huge just jump (somebody fast-forwarded)
 		if (nextFrameTime - curFrameTime > 2*scaledTimestep) {
 			nextFrameTime = curFrameTime;
+		} else if (g_Config.bLowLatencyFramePacing) {
+			pendingFrameWait = nextFrameTime;
 		} else {
 			// Wait until we've caught up.
-			while (time_now_d() < nextFrameTime) {
-#ifdef _WIN32
-				sleep_ms(1); // Sleep for 1ms on this thread
-#else
-				const double left = nextFrameTime - curFrameTime;
-				usleep((long)(left * 1000000));
-#endif
-			}
+			WaitUntilTime(nextFrameTime);
 		}
 		curFrameTime = time_now_d();
 	}
@@ -474,15 +498,7 @@ static void DoFrameIdleTiming() {
 	// Give a little extra wiggle room in case the next vblank does more work.
 	const double goal = lastFrameTime + (numVBlanksSinceFlip - 1) * scaledVblank - 0.001;
 	if (numVBlanksSinceFlip >= 2 && before < goal) {
-		double cur_time;
-		while ((cur_time = time_now_d()) < goal) {
-#ifdef _WIN32
-			sleep_ms(1);
-#else
-			const double left = goal - cur_time;
-			usleep((long)(left * 1000000));
-#endif
-		}
+		WaitUntilTime(goal);
 
 		if (g_Config.bDrawFrameGraph || coreCollectDebugStats) {
 			DisplayNotifySleep(time_now_d() - before);
@@ -528,6 +544,7 @@ void hleEnterVblank(u64 userdata, int cyclesLate) {
 		DEBUG_LOG(SCEDISPLAY, "Setting latched framebuffer %08x (prev: %08x)", latchedFramebuf.topaddr, framebuf.topaddr);
 		framebuf = latchedFramebuf;
 		framebufIsLatched = false;
+		gpu->SyncThread();
 		gpu->SetDisplayFramebuffer(framebuf.topaddr, framebuf.stride, framebuf.fmt);
 		__DisplayFlip(cyclesLate);
 	} else if (!flippedThisFrame) {
@@ -537,6 +554,8 @@ void hleEnterVblank(u64 userdata, int cyclesLate) {
 }
 
 void __DisplayFlip(int cyclesLate) {
+	// Everything queued for this frame has to be drawn before we can present it.
+	gpu->SyncThread();
 	flippedThisFrame = true;
 	// We flip only if the framebuffer was dirty. This eliminates flicker when using
 	// non-buffered rendering. The interaction with frame skipping seems to need
@@ -587,15 +606,20 @@ void __DisplayFlip(int cyclesLate) {
 		float refreshRate = System_GetPropertyFloat(SYSPROP_DISPLAY_REFRESH_RATE);
 		// Avoid skipping on devices that have 58 or 59 FPS, except when alternate speed is set.
 		bool refreshRateNeedsSkip = FrameTimingLimit() != 60 && FrameTimingLimit() > refreshRate;
+		// In SKIP_DRAW, frames that can't be presented aren't drawn either, see below.
+		const bool fastForwardSkipDraw = g_Config.iFastForwardMode == (int)FastForwardMode::SKIP_DRAW && !FrameTimingThrottled();
+		static double lastFastForwardFlip = 0;
 		// Alternative to frameskip fast-forward, where we draw everything.
 		// Useful if skipping a frame breaks graphics or for checking drawing speed.
 		if (fastForwardSkipFlip && (!FrameTimingThrottled() || refreshRateNeedsSkip)) {
-			static double lastFlip = 0;
 			double now = time_now_d();
-			if ((now - lastFlip) < 1.0f / refreshRate) {
+			if (fastForwardSkipDraw && numSkippedFrames != 0) {
+				// Nothing was drawn this frame, so there's nothing new to present.
+				forceNoFlip = true;
+			} else if ((now - lastFastForwardFlip) < 1.0f / refreshRate) {
 				forceNoFlip = true;
 			} else {
-				lastFlip = now;
+				lastFastForwardFlip = now;
 			}
 		}
 
@@ -603,7 +627,7 @@ void __DisplayFlip(int cyclesLate) {
 		const bool fbReallyDirty = gpu->FramebufferReallyDirty();
 		if (fbReallyDirty || noRecentFlip || postEffectRequiresFlip) {
 			// Check first though, might've just quit / been paused.
-			if (!forceNoFlip && Core_NextFrame()) {
+			if (!forceNoFlip && Core_NextFrame() && !PSP_CoreParameter().runAheadHidden) {
 				gpu->CopyDisplayToOutput(fbReallyDirty);
 				if (fbReallyDirty) {
 					DisplayFireActualFlip();
@@ -617,6 +641,19 @@ void __DisplayFlip(int cyclesLate) {
 
 		bool throttle, skipFrame;
 		DoFrameTiming(throttle, skipFrame, (float)numVBlanksSinceFlip * timePerVblank);
+		if (fastForwardSkipDraw) {
+			// Only draw the next frame if it'll likely be due for presenting by the time it's done.
+			// The others still run all CPU and framebuffer tracking, but send no draws to the GPU.
+			static double lastFrameEnd = 0;
+			double now = time_now_d();
+			double frameTime = now - lastFrameEnd;
+			lastFrameEnd = now;
+			skipFrame = now + frameTime < lastFastForwardFlip + 1.0 / refreshRate;
+		}
+		if (frameEmuStartTime != 0.0) {
+			// The frame is presented once we return, so this is how long it took from start to screen.
+			DisplayNotifyFrameLatency(time_now_d() - frameEmuStartTime);
+		}
 
 		int maxFrameskip = 8;
 		int frameSkipNum = DisplayCalculateFrameSkip();
@@ -654,6 +691,17 @@ void __DisplayFlip(int cyclesLate) {
 }
 
 void hleAfterFlip(u64 userdata, int cyclesLate) {
+	if (pendingFrameWait != 0.0) {
+		PROFILE_THIS_SCOPE("timing");
+		double before = time_now_d();
+		WaitUntilTime(pendingFrameWait);
+		pendingFrameWait = 0.0;
+		if (g_Config.bDrawFrameGraph || coreCollectDebugStats) {
+			DisplayNotifySleep(time_now_d() - before);
+		}
+	}
+	frameEmuStartTime = time_now_d();
+
 	gpu->BeginFrame();  // doesn't really matter if begin or end of frame.
 	PPGeNotifyFrame();
 
@@ -694,6 +742,7 @@ void hleLagSync(u64 userdata, int cyclesLate) {
 	double before = time_now_d();
 	// Don't lag too long ever, if they leave it paused.
 	double now = before;
+	SampleProfiler::BeginHostWait();
 	while (now < goal && goal < now + 0.01) {
 		// Tight loop on win32 - intentionally, as timing is otherwise not precise enough.
 #ifndef _WIN32
@@ -702,6 +751,7 @@ void hleLagSync(u64 userdata, int cyclesLate) {
 #endif
 		now = time_now_d();
 	}
+	SampleProfiler::EndHostWait();
 
 	const int emuOver = (int)cyclesToUs(cyclesLate);
 	const int over = (int)((now - goal) * 1000000);
@@ -771,6 +821,7 @@ void __DisplaySetFramebuf(u32 topaddr, int linesize, int pixelFormat, int sync)
 		framebuf = fbstate;
 		// Also update latchedFramebuf for any sceDisplayGetFramebuf() after this.
 		latchedFramebuf = fbstate;
+		gpu->SyncThread();
 		gpu->SetDisplayFramebuffer(framebuf.topaddr, framebuf.stride, framebuf.fmt);
 		// IMMEDIATE means that the buffer is fine. We can just flip immediately.
 		// Doing it in non-buffered though creates problems (black screen) on occasion though
@@ -193,7 +193,8 @@ static void __GeExecuteInterrupt(u64 userdata, int cyclesLate) {
 }
 
 static void __GeCheckCycles(u64 userdata, int cyclesLate) {
-	// Deprecated
+	// Used to be a cycle check, now applies whatever the GE thread left for us.
+	gpu->SyncThread();
 }
 
 void __GeInit() {
@@ -205,7 +206,7 @@ void __GeInit() {
 	geSyncEvent = CoreTiming::RegisterEvent("GeSyncEvent", &__GeExecuteSync);
 	geInterruptEvent = CoreTiming::RegisterEvent("GeInterruptEvent", &__GeExecuteInterrupt);
 
-	// Deprecated
+	// Used by the GE thread, see __GeNotifyThreadDone().
 	geCycleEvent = CoreTiming::RegisterEvent("GeCycleEvent", &__GeCheckCycles);
 
 	listWaitingThreads.clear();
@@ -279,6 +280,11 @@ bool __GeTriggerInterrupt(int listid, u32 pc, u64 atTicks) {
 	return true;
 }
 
+// Called on the GE thread when it finishes with interrupts or sync events waiting to be scheduled.
+void __GeNotifyThreadDone() {
+	CoreTiming::ScheduleEvent_Threadsafe_Immediate(geCycleEvent);
+}
+
 void __GeWaitCurrentThread(GPUSyncType type, SceUID waitId, const char *reason) {
 	WaitType waitType;
 	if (type == GPU_SYNC_DRAW) {
@@ -532,6 +538,7 @@ static int sceGeGetMtx(int type, u32 matrixPtr) {
 	}
 
 	INFO_LOG(SCEGE, "sceGeGetMtx(%d, %08x)", type, matrixPtr);
+	gpu->SyncThread();
 	switch (type) {
 	case GE_MTX_BONE0:
 	case GE_MTX_BONE1:
@@ -565,6 +572,7 @@ static int sceGeGetMtx(int type, u32 matrixPtr) {
 }
 
 static u32 sceGeGetCmd(int cmd) {
+	gpu->SyncThread();
 	if (cmd >= 0 && cmd < (int)ARRAY_SIZE(gstate.cmdmem)) {
 		// Does not mask away the high bits.
 		return hleLogSuccessInfoX(SCEGE, gstate.cmdmem[cmd]);
@@ -478,6 +478,7 @@ void KernelObject::GetQuickInfo(char *ptr, int size)
 
 KernelObjectPool::KernelObjectPool() {
 	memset(occupied, 0, sizeof(bool)*maxCount);
+	memset(types, 0, sizeof(types));
 	nextID = initialNextID;
 }
 
@@ -492,6 +493,7 @@ SceUID KernelObjectPool::Create(KernelObject *obj, int rangeBottom, int rangeTop
 			occupied[i] = true;
 			pool[i] = obj;
 			pool[i]->uid = i + handleOffset;
+			types[i] = obj->GetIDType();
 			return i + handleOffset;
 		}
 	}
@@ -515,6 +517,7 @@ void KernelObjectPool::Clear() {
 			delete pool[i];
 		pool[i] = nullptr;
 		occupied[i] = false;
+		types[i] = 0;
 	}
 	nextID = initialNextID;
 }
@@ -577,6 +580,7 @@ void KernelObjectPool::DoState(PointerWrap &p) {
 				return;
 
 			pool[i]->uid = i + handleOffset;
+			types[i] = pool[i]->GetIDType();
 		} else {
 			type = pool[i]->GetIDType();
 			Do(p, type);
@@ -445,6 +445,7 @@ class KernelObjectPool {
 		u32 error;
 		if (Get<T>(handle, error)) {
 			occupied[handle-handleOffset] = false;
+			types[handle-handleOffset] = 0;
 			delete pool[handle-handleOffset];
 			// Why weren't we zeroing before?
 			pool[handle-handleOffset] = nullptr;
@@ -456,6 +457,14 @@ class KernelObjectPool {
 
 	template <class T>
 	T* Get(SceUID handle, u32 &outError) {
+		// This is hit on almost every syscall.  The cached type covers the range, occupied,
+		// and type checks at once, without calling into the object.
+		const u32 index = (u32)(handle - handleOffset);
+		if (index < (u32)maxCount && types[index] == T::GetStaticIDType()) {
+			outError = SCE_KERNEL_ERROR_OK;
+			return static_cast<T *>(pool[index]);
+		}
+
 		if (handle < handleOffset || handle >= handleOffset+maxCount || !occupied[handle-handleOffset]) {
 			// Tekken 6 spams 0x80020001 gets wrong with no ill effects, also on the real PSP
 			if (handle != 0 && (u32)handle != 0x80020001) {
@@ -490,11 +499,8 @@ class KernelObjectPool {
 	void Iterate(bool func(T *, ArgT), ArgT arg) {
 		int type = T::GetStaticIDType();
 		for (int i = 0; i < maxCount; i++) {
-			if (!occupied[i])
-				continue;
-			T *t = static_cast<T *>(pool[i]);
-			if (t->GetIDType() == type) {
-				if (!func(t, arg))
+			if (types[i] == type) {
+				if (!func(static_cast<T *>(pool[i]), arg))
 					break;
 			}
 		}
@@ -503,10 +509,7 @@ class KernelObjectPool {
 	int ListIDType(int type, SceUID_le *uids, int count) const {
 		int total = 0;
 		for (int i = 0; i < maxCount; i++) {
-			if (!occupied[i]) {
-				continue;
-			}
-			if (pool[i]->GetIDType() == type) {
+			if (types[i] == type) {
 				if (total < count) {
 					*uids++ = pool[i]->GetUID();
 				}
@@ -521,8 +524,7 @@ class KernelObjectPool {
 			ERROR_LOG(SCEKERNEL, "Kernel: Bad object handle %i (%08x)", handle, handle);
 			return false;
 		}
-		KernelObject *t = pool[handle - handleOffset];
-		*type = t->GetIDType();
+		*type = types[handle - handleOffset];
 		return true;
 	}
 
@@ -538,6 +540,8 @@ class KernelObjectPool {
 	};
 	KernelObject *pool[maxCount];
 	bool occupied[maxCount];
+	// GetIDType() of each object in pool, or 0 for an empty slot.
+	int types[maxCount];
 	int nextID;
 };
 
@@ -556,6 +560,9 @@ struct KernelStats {
 		summedMsInSyscalls.clear();
 		summedSlowestSyscallTime = 0;
 		summedSlowestSyscallName = 0;
+		summedCallsToSyscalls.clear();
+		mostCalledSyscallCount = 0;
+		mostCalledSyscallName = 0;
 	}
 
 	double msInSyscalls;
@@ -564,6 +571,9 @@ struct KernelStats {
 	std::map<KernelStatsSyscall, double> summedMsInSyscalls;
 	double summedSlowestSyscallTime;
 	const char *summedSlowestSyscallName;
+	std::map<KernelStatsSyscall, int> summedCallsToSyscalls;
+	int mostCalledSyscallCount;
+	const char *mostCalledSyscallName;
 };
 
 extern KernelStats kernelStats;
@@ -40,6 +40,7 @@
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/ELF/ElfReader.h"
 #include "Core/ELF/PBPReader.h"
 #include "Core/ELF/PrxDecrypter.h"
@@ -68,6 +69,8 @@
 #include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
 
+#include "ext/xxhash.h"
+
 enum {
 	PSP_THREAD_ATTR_KERNEL = 0x00001000,
 	PSP_THREAD_ATTR_USER = 0x80000000,
@@ -916,6 +919,80 @@ static void __SaveDecryptedEbootToStorageMedia(const u8 *decryptedEbootDataPtr,
 	INFO_LOG(SCEMODULE, "Successfully wrote decrypted EBOOT to %s", fullPath.c_str());
 }
 
+// Decrypting (and inflating) the same ~PSP modules on every boot is slow on phones,
+// so the results are kept in the cache directory, keyed by a hash of the encrypted image.
+//
+// Format:
+//   8  magic
+//   32 version
+//   64 hash of the encrypted image
+//   32 size of the encrypted image
+//   32 result of pspDecryptPRX
+//   32 data length
+//   data (decrypted, and decompressed if needed)
+static const char *const MODCACHE_MAGIC = "ppssppDM";
+static const u32 MODCACHE_VERSION = 1;
+
+static Path DecryptedModuleCachePath(u64 hash) {
+	return GetSysDirectory(DIRECTORY_CACHE) / StringFromFormat("prx_%016llx.ppdm", (unsigned long long)hash);
+}
+
+// Returns the pspDecryptPRX result that was cached, or -1 if there's no usable entry.
+static int LoadDecryptedModuleCache(u64 hash, u32 inSize, u8 *out, u32 outSize) {
+	Path cachePath = DecryptedModuleCachePath(hash);
+	std::string data;
+	if (!File::Exists(cachePath) || !File::ReadFileToString(false, cachePath, data))
+		return -1;
+
+	const size_t headerSize = 8 + 4 + 8 + 4 + 4 + 4;
+	if (data.size() < headerSize || memcmp(data.data(), MODCACHE_MAGIC, 8) != 0)
+		return -1;
+	u32 version, cachedInSize, dataLength;
+	s32 ret;
+	u64 cachedHash;
+	memcpy(&version, &data[8], 4);
+	memcpy(&cachedHash, &data[12], 8);
+	memcpy(&cachedInSize, &data[20], 4);
+	memcpy(&ret, &data[24], 4);
+	memcpy(&dataLength, &data[28], 4);
+	if (version != MODCACHE_VERSION || cachedHash != hash || cachedInSize != inSize || ret <= 0)
+		return -1;
+	if (dataLength > outSize || data.size() != headerSize + dataLength) {
+		WARN_LOG(SCEMODULE, "Ignoring corrupt decrypted module cache %s", cachePath.c_str());
+		return -1;
+	}
+
+	memcpy(out, &data[headerSize], dataLength);
+	return ret;
+}
+
+static void SaveDecryptedModuleCache(u64 hash, u32 inSize, int ret, const u8 *decrypted, u32 dataLength) {
+	if (!File::Exists(GetSysDirectory(DIRECTORY_CACHE)))
+		return;
+
+	std::string data;
+	auto writeBytes = [&](const void *src, size_t sz) {
+		data.append((const char *)src, sz);
+	};
+	s32 ret32 = ret;
+	writeBytes(MODCACHE_MAGIC, 8);
+	writeBytes(&MODCACHE_VERSION, 4);
+	writeBytes(&hash, 8);
+	writeBytes(&inSize, 4);
+	writeBytes(&ret32, 4);
+	writeBytes(&dataLength, 4);
+	writeBytes(decrypted, dataLength);
+
+	// Write then rename, so another instance never sees a partial file.
+	Path cachePath = DecryptedModuleCachePath(hash);
+	Path tempPath = cachePath.WithExtraExtension(".tmp");
+	if (File::WriteStringToFile(false, data, tempPath)) {
+		if (File::Exists(cachePath))
+			File::Delete(cachePath);
+		File::Rename(tempPath, cachePath);
+	}
+}
+
 static bool IsHLEVersionedModule(const char *name) {
 	// TODO: Only some of these are currently known to be versioned.
 	// Potentially only sceMpeg_library matters.
@@ -1193,7 +1270,15 @@ static PSPModule *__KernelLoadELFFromPtr(const u8 *ptr, size_t elfSize, u32 load
 		newptr = new u8[maxElfSize];
 		ptr = newptr;
 		magicPtr = (u32_le *)ptr;
-		int ret = pspDecryptPRX(in, (u8*)ptr, head->psp_size);
+		// Modules we don't decrypt (see below) aren't worth caching.
+		const u64 encryptedHash = reportedModule ? 0 : XXH3_64bits(in, head->psp_size);
+		int ret = reportedModule ? -1 : LoadDecryptedModuleCache(encryptedHash, head->psp_size, newptr, maxElfSize);
+		const bool fromCache = ret > 0;
+		if (fromCache) {
+			INFO_LOG(SCEMODULE, "Using cached decrypted module %016llx", (unsigned long long)encryptedHash);
+		} else {
+			ret = pspDecryptPRX(in, (u8*)ptr, head->psp_size);
+		}
 		if (reportedModule) {
 			// This should happen for all "kernel" modules.
 			*error_string = "Missing key";
@@ -1236,7 +1321,7 @@ static PSPModule *__KernelLoadELFFromPtr(const u8 *ptr, size_t elfSize, u32 load
 			module->nm.bss_size = head->bss_size;
 
 			// decompress if required
-			if (isGzip)
+			if (isGzip && !fromCache)
 			{
 				auto temp = new u8[ret];
 				memcpy(temp, ptr, ret);
@@ -1244,6 +1329,11 @@ static PSPModule *__KernelLoadELFFromPtr(const u8 *ptr, size_t elfSize, u32 load
 				delete[] temp;
 			}
 
+			if (!fromCache) {
+				const u32 cacheLength = isGzip ? std::min((u32)head->elf_size, maxElfSize) : std::min((u32)ret, maxElfSize);
+				SaveDecryptedModuleCache(encryptedHash, head->psp_size, ret, ptr, cacheLength);
+			}
+
 			// If we've made it this far, it should be safe to dump.
 			if (g_Config.bDumpDecryptedEboot) {
 				INFO_LOG(SCEMODULE, "Dumping decrypted EBOOT.BIN to file.");
@@ -1825,6 +1915,7 @@ bool __KernelLoadExec(const char *filename, u32 paramPtr, std::string *error_str
 	}
 
 	host->NotifySymbolMapUpdated();
+	MIPSComp::LoadGameBlockCache();
 
 	mipsr4k.pc = module->nm.entry_addr;
 
@@ -1922,7 +2013,7 @@ void __KernelGPUReplay() {
 		Core_Stop();
 	}
 
-	if (PSP_CoreParameter().headLess && !PSP_CoreParameter().startBreak) {
+	if (PSP_CoreParameter().headLess && !PSP_CoreParameter().startBreak && !PSP_CoreParameter().headLessBenchmark) {
 		PSPPointer<u8> topaddr;
 		u32 linesize = 512;
 		__DisplayGetFramebuf(&topaddr, &linesize, nullptr, 0);
@@ -195,8 +195,10 @@ static void __GameModeNotify(u64 userdata, int cyclesLate) {
 			// Send Master data
 			if (masterGameModeArea.dataUpdated) {
 				int sentcount = 0;
+				// One readiness check per update is enough, a would-block send just gets retried next time.
+				bool writable = IsSocketReady(sock->data.pdp.id, false, true) > 0;
 				for (auto& gma : replicaGameModeAreas) {
-					if (!gma.dataSent && IsSocketReady(sock->data.pdp.id, false, true) > 0) {
+					if (!gma.dataSent && writable) {
 						u16_le port = ADHOC_GAMEMODE_PORT;
 						auto it = gameModePeerPorts.find(gma.mac);
 						if (it != gameModePeerPorts.end())
@@ -259,13 +261,18 @@ static void __GameModeNotify(u64 userdata, int cyclesLate) {
 				}
 			}
 
-			// Recv new Replica data when available
-			if (IsSocketReady(sock->data.pdp.id, true, false) > 0) {
+			// Recv new Replica data when available. Drain everything that has arrived, rather than one packet
+			// per update, so replicas don't fall further behind with every extra player.
+			int maxRecvs = std::max((int)replicaGameModeAreas.size(), 1) * 4;
+			while (maxRecvs-- > 0 && IsSocketReady(sock->data.pdp.id, true, false) > 0) {
 				SceNetEtherAddr sendermac;
 				s32_le senderport = ADHOC_GAMEMODE_PORT;
 				s32_le bufsz = gameModeBuffSize;
 				int ret = sceNetAdhocPdpRecv(gameModeSocket, &sendermac, &senderport, gameModeBuffer, &bufsz, 0, ADHOC_F_NONBLOCK);
-				if (ret >= 0 && bufsz > 0) {
+				// Would block, or a packet that doesn't fit (still queued), try again next update.
+				if (ret < 0)
+					break;
+				if (bufsz > 0) {
 					// Shows a warning if the sender/source port is different than what it supposed to be.
 					if (senderport != ADHOC_GAMEMODE_PORT && senderport != gameModePeerPorts[sendermac]) {
 						char name[9] = {};
@@ -1604,9 +1611,8 @@ static int sceNetAdhocPdpSend(int id, const char *mac, u32 port, void *data, int
 							// Schedule Timeout Removal
 							//if (flag) timeout = 0;
 
-							// Apply Send Timeout Settings to Socket
-							if (timeout > 0) 
-								setSockTimeout(pdpsocket.id, SO_SNDTIMEO, timeout);
+							// No Send Timeout on the host socket: it's non-blocking, so SO_SNDTIMEO would be ignored
+							// and only cost a syscall per send. Blocking is simulated by WaitBlockingAdhocSocket.
 
 							if (socket->flags & ADHOC_F_ALERTSEND) {
 								socket->alerted_flags |= ADHOC_F_ALERTSEND;
@@ -1837,9 +1843,7 @@ static int sceNetAdhocPdpRecv(int id, void *addr, void * port, void *buf, void *
 				}
 #endif
 
-				// Apply Receive Timeout Settings to Socket. Let's not wait forever (0 = indefinitely)
-				if (timeout > 0) 
-					setSockTimeout(pdpsocket.id, SO_RCVTIMEO, timeout);
+				// No Receive Timeout on the host socket, it's non-blocking (see sceNetAdhocPdpSend).
 
 				if (socket->flags & ADHOC_F_ALERTRECV) {
 					socket->alerted_flags |= ADHOC_F_ALERTRECV;
@@ -4186,9 +4190,7 @@ static int sceNetAdhocPtpSend(int id, u32 dataAddr, u32 dataSizeAddr, int timeou
 					// Schedule Timeout Removal
 					//if (flag) timeout = 0; // JPCSP seems to always Send PTP as blocking, also a possibility to send to multiple destination?
 					
-					// Apply Send Timeout Settings to Socket
-					if (timeout > 0) 
-						setSockTimeout(ptpsocket.id, SO_SNDTIMEO, timeout);
+					// No Send Timeout on the host socket, it's non-blocking (see sceNetAdhocPdpSend).
 
 					if (socket->flags & ADHOC_F_ALERTSEND) {
 						socket->alerted_flags |= ADHOC_F_ALERTSEND;
@@ -4287,9 +4289,7 @@ static int sceNetAdhocPtpRecv(int id, u32 dataAddr, u32 dataSizeAddr, int timeou
 					// Schedule Timeout Removal
 					//if (flag) timeout = 0;
 
-					// Apply Receive Timeout Settings to Socket. Let's not wait forever (0 = indefinitely)
-					if (timeout > 0)
-						setSockTimeout(ptpsocket.id, SO_RCVTIMEO, timeout);
+					// No Receive Timeout on the host socket, it's non-blocking (see sceNetAdhocPdpSend).
 
 					if (socket->flags & ADHOC_F_ALERTRECV) {
 						socket->alerted_flags |= ADHOC_F_ALERTRECV;
@@ -4420,8 +4420,7 @@ static int sceNetAdhocPtpFlush(int id, int timeout, int nonblock) {
 			if (ptpsocket.state == ADHOC_PTP_STATE_ESTABLISHED) {
 				hleEatMicro(50);
 				// There are two ways to flush, you can either set TCP_NODELAY to 1 or TCP_CORK to 0.
-				// Apply Send Timeout Settings to Socket
-				setSockTimeout(ptpsocket.id, SO_SNDTIMEO, timeout);
+				// No Send Timeout on the host socket, it's non-blocking (see sceNetAdhocPdpSend).
 
 				int error = FlushPtpSocket(ptpsocket.id);
 
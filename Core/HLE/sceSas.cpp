@@ -31,6 +31,7 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 #include "Common/Profiler/Profiler.h"
 #include "Common/Thread/ThreadUtil.h"
@@ -42,7 +43,7 @@
 #include "Core/HLE/FunctionWrappers.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/HW/SasAudio.h"
-#include "Core/MemMap.h"
+#include "Core/MemMapHelpers.h"
 #include "Core/Reporting.h"
 
 #include "Core/HLE/sceSas.h"
@@ -89,6 +90,8 @@ struct SasThreadParams {
 	u32 inAddr;
 	int leftVol;
 	int rightVol;
+	// Mix into sasPipelineOutput (from sasPipelineInput) rather than guest memory.
+	bool pipelined;
 };
 
 static std::thread *sasThread;
@@ -100,6 +103,13 @@ static volatile int sasThreadState = SasThreadState::DISABLED;
 static SasThreadParams sasThreadParams;
 static int sasMixEvent = -1;
 
+// With pipelined mixing, the guest doesn't wait for the mix. Its output is kept here until something
+// could look at it (the next sas call, audio output, or a savestate), and only then written to outAddr.
+static bool sasPipelined;
+static bool sasPipelineOutputPending;
+static std::vector<s16> sasPipelineInput;
+static std::vector<s16> sasPipelineOutput;
+
 int __SasThread() {
 	SetCurrentThreadName("SAS");
 
@@ -107,7 +117,11 @@ int __SasThread() {
 	while (sasThreadState != SasThreadState::DISABLED) {
 		sasWake.wait(guard);
 		if (sasThreadState == SasThreadState::QUEUED) {
-			sas->Mix(sasThreadParams.outAddr, sasThreadParams.inAddr, sasThreadParams.leftVol, sasThreadParams.rightVol);
+			const SasThreadParams &params = sasThreadParams;
+			if (params.pipelined)
+				sas->Mix(sasPipelineOutput.data(), params.inAddr ? sasPipelineInput.data() : nullptr, params.leftVol, params.rightVol);
+			else
+				sas->Mix(params.outAddr, params.inAddr, params.leftVol, params.rightVol);
 
 			std::lock_guard<std::mutex> doneGuard(sasDoneMutex);
 			sasThreadState = SasThreadState::READY;
@@ -118,9 +132,21 @@ int __SasThread() {
 }
 
 static void __SasDrain() {
-	std::unique_lock<std::mutex> guard(sasDoneMutex);
-	while (sasThreadState == SasThreadState::QUEUED)
-		sasDone.wait(guard);
+	{
+		std::unique_lock<std::mutex> guard(sasDoneMutex);
+		while (sasThreadState == SasThreadState::QUEUED)
+			sasDone.wait(guard);
+	}
+
+	if (sasPipelineOutputPending) {
+		sasPipelineOutputPending = false;
+		Memory::Memcpy(sasThreadParams.outAddr, sasPipelineOutput.data(), (u32)(sasPipelineOutput.size() * sizeof(s16)), "SasMix");
+	}
+}
+
+void __SasFlushOutput() {
+	if (sasPipelineOutputPending)
+		__SasDrain();
 }
 
 static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int rightVol = 0) {
@@ -135,12 +161,27 @@ static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int ri
 		__SasDrain();
 	}
 
+	// Any pipelined output still waiting has to land before this one's input is read.
+	if (sasPipelineOutputPending) {
+		__SasDrain();
+	}
+
 	// We're safe to write, since it can't be processing now anymore.
 	// No other thread enqueues.
 	sasThreadParams.outAddr = outAddr;
 	sasThreadParams.inAddr = inAddr;
 	sasThreadParams.leftVol = leftVol;
 	sasThreadParams.rightVol = rightVol;
+	sasThreadParams.pipelined = sasPipelined;
+	if (sasPipelined) {
+		// The guest may overwrite its input buffer before the mix runs, so take a copy now.
+		if (inAddr) {
+			sasPipelineInput.resize(sas->GetGrainSize() * 2);
+			Memory::Memcpy(sasPipelineInput.data(), inAddr, (u32)(sasPipelineInput.size() * sizeof(s16)), "SasMix");
+		}
+		sasPipelineOutput.resize(sas->OutputSamples());
+		sasPipelineOutputPending = true;
+	}
 
 	// And now, notify.
 	sasWakeMutex.lock();
@@ -151,6 +192,7 @@ static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int ri
 
 static void __SasDisableThread() {
 	if (sasThreadState != SasThreadState::DISABLED) {
+		__SasDrain();
 		sasWakeMutex.lock();
 		sasThreadState = SasThreadState::DISABLED;
 		sasWake.notify_one();
@@ -171,7 +213,9 @@ static void sasMixFinish(u64 userdata, int cycleslate) {
 
 	if (error == 0 && verify == 1) {
 		// Wait until it's actually complete before waking the thread.
-		__SasDrain();
+		// Pipelined mixes keep going, they're flushed when something reads them.
+		if (!sasPipelined)
+			__SasDrain();
 
 		__KernelResumeThreadFromWait(threadID, result);
 		__KernelReSchedule("woke from sas mix");
@@ -185,11 +229,14 @@ void __SasInit() {
 
 	sasMixEvent = CoreTiming::RegisterEvent("SasMix", sasMixFinish);
 
+	sasPipelineOutputPending = false;
 	if (g_Config.bSeparateSASThread) {
 		sasThreadState = SasThreadState::READY;
 		sasThread = new std::thread(__SasThread);
+		sasPipelined = g_Config.bPipelinedSAS;
 	} else {
 		sasThreadState = SasThreadState::DISABLED;
+		sasPipelined = false;
 	}
 }
 
@@ -198,7 +245,7 @@ void __SasDoState(PointerWrap &p) {
 	if (!s)
 		return;
 
-	if (sasThreadState == SasThreadState::QUEUED) {
+	if (sasThreadState == SasThreadState::QUEUED || sasPipelineOutputPending) {
 		// Wait for the queue to drain.  Don't want to save the wrong stuff.
 		__SasDrain();
 	}
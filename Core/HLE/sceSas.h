@@ -20,6 +20,8 @@
 void __SasInit();
 void __SasDoState(PointerWrap &p);
 void __SasShutdown();
+// With pipelined mixing, writes the last mix to guest memory if it's still pending. Call before reading audio from it.
+void __SasFlushOutput();
 
 void __SasGetDebugStats(char *stats, size_t bufsize);
 
@@ -22,6 +22,7 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeMap.h"
 #include "Common/Serialize/SerializeSet.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
@@ -48,7 +49,12 @@ void AsyncIOManager::ScheduleOperation(AsyncIOEvent ev) {
 	ScheduleEvent(ev);
 }
 
+// Enough to keep the disc, the memstick, and flash busy at the same time.
+static const int ASYNC_IO_WORKERS = 3;
+
 void AsyncIOManager::Shutdown() {
+	StopWorkers();
+
 	std::lock_guard<std::mutex> guard(resultsLock_);
 	resultsPending_.clear();
 	results_.clear();
@@ -86,7 +92,7 @@ bool AsyncIOManager::ReadResult(u32 handle, AsyncIOResult &result) {
 bool AsyncIOManager::WaitResult(u32 handle, AsyncIOResult &result) {
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
+	while ((HasEvents() || HasInFlight()) && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
 		if (PopResult(handle, result)) {
 			return true;
 		}
@@ -100,7 +106,7 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
+	while ((HasEvents() || HasInFlight()) && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
 		if (ReadResult(handle, result)) {
 			return result.finishTicks;
 		}
@@ -113,7 +119,85 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 	return 0;
 }
 
+void AsyncIOManager::SyncThread(bool force) {
+	IOThreadEventQueue::SyncThread(force);
+
+	std::unique_lock<std::mutex> guard(workLock_);
+	while (workInFlight_ > 0) {
+		workDrain_.wait(guard);
+	}
+}
+
+void AsyncIOManager::StartWorkers() {
+	std::lock_guard<std::mutex> guard(workLock_);
+	if (!workers_.empty())
+		return;
+
+	workersExit_ = false;
+	for (int i = 0; i < ASYNC_IO_WORKERS; ++i) {
+		workers_.push_back(std::thread(&AsyncIOManager::WorkerLoop, this));
+	}
+}
+
+void AsyncIOManager::StopWorkers() {
+	{
+		std::lock_guard<std::mutex> guard(workLock_);
+		workersExit_ = true;
+		workWait_.notify_all();
+	}
+
+	// Workers finish anything already queued before exiting.
+	for (auto &worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+}
+
+void AsyncIOManager::WorkerLoop() {
+	SetCurrentThreadName("IOWorker");
+
+	std::unique_lock<std::mutex> guard(workLock_);
+	while (true) {
+		while (work_.empty() && !workersExit_) {
+			workWait_.wait(guard);
+		}
+		if (work_.empty())
+			break;
+
+		AsyncIOEvent ev = work_.front();
+		work_.pop_front();
+
+		guard.unlock();
+		RunOperation(ev);
+		guard.lock();
+
+		// The result is already posted, so waiters see it before the count drops.
+		if (--workInFlight_ == 0) {
+			workDrain_.notify_all();
+		}
+	}
+}
+
+bool AsyncIOManager::HasInFlight() {
+	std::lock_guard<std::mutex> guard(workLock_);
+	return workInFlight_ > 0;
+}
+
 void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
+	if (!ThreadEnabled()) {
+		RunOperation(ev);
+		return;
+	}
+
+	StartWorkers();
+
+	std::lock_guard<std::mutex> guard(workLock_);
+	work_.push_back(ev);
+	workInFlight_++;
+	workWait_.notify_one();
+}
+
+void AsyncIOManager::RunOperation(const AsyncIOEvent &ev) {
 	switch (ev.type) {
 	case IO_EVENT_READ:
 		Read(ev.handle, ev.buf, ev.bytes, ev.invalidateAddr);
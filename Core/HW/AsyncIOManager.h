@@ -15,9 +15,13 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <set>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include "Core/ThreadEventQueue.h"
 
@@ -76,10 +80,17 @@ struct AsyncIOResult {
 };
 
 typedef ThreadEventQueue<NoBase, AsyncIOEvent, AsyncIOEventType, IO_EVENT_INVALID, IO_EVENT_SYNC, IO_EVENT_FINISH> IOThreadEventQueue;
+
+// The IO thread hands reads and writes to a few worker threads, so several can be in flight.
+// Operations on the same device are still serialized by MetaFileSystem, but a slow memstick
+// write won't hold up a UMD read.  Only one operation per handle is pending at a time.
 class AsyncIOManager : public IOThreadEventQueue {
 public:
 	void DoState(PointerWrap &p);
 
+	// Also waits for operations already handed to workers.
+	void SyncThread(bool force = false);
+
 	bool HasOperation(u32 handle);
 	void ScheduleOperation(AsyncIOEvent ev);
 	void Shutdown();
@@ -95,6 +106,12 @@ class AsyncIOManager : public IOThreadEventQueue {
 	}
 
 private:
+	void StartWorkers();
+	void StopWorkers();
+	void WorkerLoop();
+	void RunOperation(const AsyncIOEvent &ev);
+	bool HasInFlight();
+
 	bool PopResult(u32 handle, AsyncIOResult &result);
 	bool ReadResult(u32 handle, AsyncIOResult &result);
 	void Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr);
@@ -106,4 +123,13 @@ class AsyncIOManager : public IOThreadEventQueue {
 	std::condition_variable resultsWait_;
 	std::set<u32> resultsPending_;
 	std::map<u32, AsyncIOResult> results_;
+
+	std::mutex workLock_;
+	std::condition_variable workWait_;
+	std::condition_variable workDrain_;
+	std::deque<AsyncIOEvent> work_;
+	// Queued or running on a worker.
+	int workInFlight_ = 0;
+	bool workersExit_ = false;
+	std::vector<std::thread> workers_;
 };
@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <map>
+
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeMap.h"
 #include "Core/HW/BufferQueue.h"
@@ -30,7 +32,19 @@ void BufferQueue::DoState(PointerWrap &p) {
 	}
 
 	if (s >= 1) {
-		Do(p, ptsMarks);
+		// Stored as a map for compatibility with older states.
+		std::map<u32, s64> marks;
+		if (p.mode != PointerWrap::MODE_READ) {
+			for (const PtsMark &mark : ptsMarks)
+				marks[mark.offset] = mark.pts;
+		}
+		Do(p, marks);
+		if (p.mode == PointerWrap::MODE_READ) {
+			ptsMarks.clear();
+			ptsMarks.reserve(marks.size());
+			for (const auto &it : marks)
+				ptsMarks.push_back(PtsMark{ it.first, it.second });
+		}
 	} else {
 		ptsMarks.clear();
 	}
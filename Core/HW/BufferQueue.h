@@ -17,9 +17,10 @@
 
 #pragma once
 
-#include <map>
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <vector>
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 
@@ -130,32 +131,50 @@ struct BufferQueue {
 	void DoState(PointerWrap &p);
 
 private:
+	// Sorted by offset.  At most a few dozen packets are queued at once, so a flat array
+	// beats a map here, and this is hit for every demuxed packet.
+	struct PtsMark {
+		u32 offset;
+		s64 pts;
+	};
+	typedef std::vector<PtsMark>::iterator PtsMarkIter;
+
+	PtsMarkIter lowerBoundPts(u32 offset) {
+		return std::lower_bound(ptsMarks.begin(), ptsMarks.end(), offset, [](const PtsMark &mark, u32 offset) {
+			return mark.offset < offset;
+		});
+	}
+
 	void savePts(u64 pts) {
 		if (pts != 0) {
-			ptsMarks[end] = pts;
+			auto it = lowerBoundPts(end);
+			if (it != ptsMarks.end() && it->offset == (u32)end)
+				it->pts = pts;
+			else
+				ptsMarks.insert(it, PtsMark{ (u32)end, (s64)pts });
 		}
 	}
 
-	u64 findPts(std::map<u32, s64>::iterator earliest, std::map<u32, s64>::iterator latest) {
+	u64 findPts(PtsMarkIter earliest, PtsMarkIter latest) {
 		u64 pts = 0;
 		// Take the first one, that is the pts of this packet.
 		if (earliest != latest) {
-			pts = earliest->second;
+			pts = earliest->pts;
 		}
 		ptsMarks.erase(earliest, latest);
 		return pts;
 	}
 
 	u64 findPts(int packetSize) {
-		auto earliest = ptsMarks.lower_bound(start);
-		auto latest = ptsMarks.lower_bound(start + packetSize);
+		auto earliest = lowerBoundPts(start);
+		auto latest = lowerBoundPts(start + packetSize);
 
 		u64 pts = findPts(earliest, latest);
 
 		// If it wraps around, we have to look at the other half too.
 		if (start + packetSize > bufQueueSize) {
 			earliest = ptsMarks.begin();
-			latest = ptsMarks.lower_bound(start + packetSize - bufQueueSize);
+			latest = lowerBoundPts(start + packetSize - bufQueueSize);
 			// This also clears the range, so we always call on wrap.
 			u64 latePts = findPts(earliest, latest);
 			if (pts == 0)
@@ -183,5 +202,5 @@ struct BufferQueue {
 	int filled = 0;
 	int bufQueueSize = 0;
 
-	std::map<u32, s64> ptsMarks;
+	std::vector<PtsMark> ptsMarks;
 };
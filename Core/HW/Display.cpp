@@ -69,6 +69,8 @@ static constexpr int frameTimeHistorySize = (int)ARRAY_SIZE(frameTimeHistory);
 static int frameTimeHistoryPos = 0;
 static int frameTimeHistoryValid = 0;
 static double lastFrameTimeHistory = 0.0;
+// Smoothed, in seconds.
+static double frameLatency = 0.0;
 
 static void CalculateFPS() {
 	double now = time_now_d();
@@ -180,6 +182,13 @@ void DisplayNotifySleep(double t, int pos) {
 	frameSleepHistory[pos] += t;
 }
 
+void DisplayNotifyFrameLatency(double t) {
+	// Ignore pauses and the like, they'd just throw the average off for a long time.
+	if (t < 0.0 || t > 0.25)
+		return;
+	frameLatency = frameLatency == 0.0 ? t : frameLatency * 0.9 + t * 0.1;
+}
+
 void __DisplayGetDebugStats(char *stats, size_t bufsize) {
 	char statbuf[4096];
 	gpu->GetStats(statbuf, sizeof(statbuf));
@@ -187,12 +196,17 @@ void __DisplayGetDebugStats(char *stats, size_t bufsize) {
 	snprintf(stats, bufsize,
 		"Kernel processing time: %0.2f ms\n"
 		"Slowest syscall: %s : %0.2f ms\n"
-		"Most active syscall: %s : %0.2f ms\n%s",
+		"Most active syscall: %s : %0.2f ms\n"
+		"Most called syscall: %s : %d calls\n"
+		"Frame latency: %0.2f ms\n%s",
 		kernelStats.msInSyscalls * 1000.0f,
 		kernelStats.slowestSyscallName ? kernelStats.slowestSyscallName : "(none)",
 		kernelStats.slowestSyscallTime * 1000.0f,
 		kernelStats.summedSlowestSyscallName ? kernelStats.summedSlowestSyscallName : "(none)",
 		kernelStats.summedSlowestSyscallTime * 1000.0f,
+		kernelStats.mostCalledSyscallName ? kernelStats.mostCalledSyscallName : "(none)",
+		kernelStats.mostCalledSyscallCount,
+		frameLatency * 1000.0,
 		statbuf);
 }
 
@@ -299,6 +313,7 @@ void DisplayHWInit() {
 	actualFlips = 0;
 	lastActualFlips = 0;
 	lastNumFlips = 0;
+	frameLatency = 0.0;
 
 	fpsHistoryValid = 0;
 	fpsHistoryPos = 0;
@@ -44,6 +44,8 @@ void __DisplayGetVPS(float *out_vps);
 double *__DisplayGetFrameTimes(int *out_valid, int *out_pos, double **out_sleep);
 int DisplayGetSleepPos();
 void DisplayNotifySleep(double t, int pos = -1);
+// Time from the start of emulating a frame until it was handed off for presentation.
+void DisplayNotifyFrameLatency(double t);
 bool DisplayIsRunningSlow();
 
 void DisplayFireVblankStart();
@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "ppsspp_config.h"
+#include "Common/Common.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
@@ -29,6 +31,18 @@
 
 #include <algorithm>
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif // PPSSPP_ARCH(ARM_NEON)
+
 #ifdef USE_FFMPEG
 
 extern "C" {
@@ -36,9 +50,17 @@ extern "C" {
 #include "libavcodec/avcodec.h"
 #include "libavformat/avformat.h"
 #include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
 #include "libswscale/swscale.h"
 
 }
+
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 18, 100)
+#define USE_FFMPEG_HWACCEL
+extern "C" {
+#include "libavutil/hwcontext.h"
+}
+#endif
 #endif // USE_FFMPEG
 
 #ifdef USE_FFMPEG
@@ -98,7 +120,211 @@ bool InitFFmpeg() {
 
 	return true;
 }
+
+static bool isHardwarePixelFormat(int format) {
+	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get((AVPixelFormat)format);
+	return desc && (desc->flags & AV_PIX_FMT_FLAG_HWACCEL) != 0;
+}
+
+#ifdef USE_FFMPEG_HWACCEL
+static AVPixelFormat getHardwareFormat(AVCodecContext *ctx, const AVPixelFormat *fmts) {
+	// The format of the device we created is stashed in opaque.
+	AVPixelFormat hwFormat = (AVPixelFormat)(intptr_t)ctx->opaque;
+	for (const AVPixelFormat *fmt = fmts; *fmt != AV_PIX_FMT_NONE; ++fmt) {
+		if (*fmt == hwFormat)
+			return *fmt;
+	}
+
+	// The stream isn't supported by the hardware (profile, size...), so decode in software.
+	WARN_LOG(ME, "Hardware video decoding not available for this stream, using software");
+	return avcodec_default_get_format(ctx, fmts);
+}
+
+static bool setupHardwareDecoding(AVCodecContext *ctx, const AVCodec *codec) {
+	// Take the first device type this decoder supports that we can actually open.
+	for (int i = 0; ; ++i) {
+		const AVCodecHWConfig *config = avcodec_get_hw_config(codec, i);
+		if (!config)
+			break;
+		if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) == 0)
+			continue;
+
+		AVBufferRef *deviceCtx = nullptr;
+		if (av_hwdevice_ctx_create(&deviceCtx, config->device_type, nullptr, nullptr, 0) < 0)
+			continue;
+
+		// The codec context keeps its own reference, freed along with it.
+		ctx->hw_device_ctx = deviceCtx;
+		ctx->opaque = (void *)(intptr_t)config->pix_fmt;
+		ctx->get_format = &getHardwareFormat;
+		INFO_LOG(ME, "Using %s for hardware video decoding", av_hwdevice_get_type_name(config->device_type));
+		return true;
+	}
+	return false;
+}
+#endif
+#endif
+
+#ifdef USE_FFMPEG
+// BT.601 limited range YUV -> RGB in 6-bit fixed point, matching the coefficients swscale uses.
+enum {
+	YUV_Y = 75,
+	YUV_VR = 102,
+	YUV_UG = 25,
+	YUV_VG = 52,
+	YUV_UB = 129,
+};
+
+static inline u8 clampYUVComponent(int c) {
+	c = (c + 32) >> 6;
+	return (u8)(c < 0 ? 0 : (c > 255 ? 255 : c));
+}
+
+static inline void writeYUVPixel(u8 *dest, int y, int u, int v, int videoPixelMode) {
+	int yy = (y - 16) * YUV_Y;
+	u -= 128;
+	v -= 128;
+	u8 r = clampYUVComponent(yy + YUV_VR * v);
+	u8 g = clampYUVComponent(yy - YUV_UG * u - YUV_VG * v);
+	u8 b = clampYUVComponent(yy + YUV_UB * u);
+
+	// Alpha is always cleared, like writeVideoLineRGBA() etc. do.
+	switch (videoPixelMode) {
+	case GE_CMODE_32BIT_ABGR8888:
+		dest[0] = r;
+		dest[1] = g;
+		dest[2] = b;
+		dest[3] = 0;
+		break;
+	case GE_CMODE_16BIT_BGR5650:
+		*(u16_le *)dest = ((b & 0xF8) << 8) | ((g & 0xFC) << 3) | (r >> 3);
+		break;
+	case GE_CMODE_16BIT_ABGR5551:
+		*(u16_le *)dest = ((b & 0xF8) << 7) | ((g & 0xF8) << 2) | (r >> 3);
+		break;
+	case GE_CMODE_16BIT_ABGR4444:
+		*(u16_le *)dest = ((b & 0xF0) << 4) | (g & 0xF0) | (r >> 4);
+		break;
+	}
+}
+
+#ifdef _M_SSE
+static inline __m128i convertYUVComponentSSE2(__m128i c) {
+	return _mm_srai_epi16(_mm_adds_epi16(c, _mm_set1_epi16(32)), 6);
+}
+
+static inline __m128i packYUVPixels16SSE2(__m128i r, __m128i g, __m128i b, int videoPixelMode) {
+	switch (videoPixelMode) {
+	case GE_CMODE_16BIT_BGR5650:
+		return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, _mm_set1_epi16(0xF8)), 8), _mm_slli_epi16(_mm_and_si128(g, _mm_set1_epi16(0xFC)), 3)), _mm_srli_epi16(r, 3));
+	case GE_CMODE_16BIT_ABGR5551:
+		return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, _mm_set1_epi16(0xF8)), 7), _mm_slli_epi16(_mm_and_si128(g, _mm_set1_epi16(0xF8)), 2)), _mm_srli_epi16(r, 3));
+	default:
+		return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, _mm_set1_epi16(0xF0)), 4), _mm_and_si128(g, _mm_set1_epi16(0xF0))), _mm_srli_epi16(r, 4));
+	}
+}
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+static inline uint16x8_t packYUVPixels16NEON(uint8x8_t r8, uint8x8_t g8, uint8x8_t b8, int videoPixelMode) {
+	uint16x8_t r = vmovl_u8(r8);
+	uint16x8_t g = vmovl_u8(g8);
+	uint16x8_t b = vmovl_u8(b8);
+	switch (videoPixelMode) {
+	case GE_CMODE_16BIT_BGR5650:
+		return vorrq_u16(vorrq_u16(vshlq_n_u16(vandq_u16(b, vdupq_n_u16(0xF8)), 8), vshlq_n_u16(vandq_u16(g, vdupq_n_u16(0xFC)), 3)), vshrq_n_u16(r, 3));
+	case GE_CMODE_16BIT_ABGR5551:
+		return vorrq_u16(vorrq_u16(vshlq_n_u16(vandq_u16(b, vdupq_n_u16(0xF8)), 7), vshlq_n_u16(vandq_u16(g, vdupq_n_u16(0xF8)), 2)), vshrq_n_u16(r, 3));
+	default:
+		return vorrq_u16(vorrq_u16(vshlq_n_u16(vandq_u16(b, vdupq_n_u16(0xF0)), 4), vandq_u16(g, vdupq_n_u16(0xF0))), vshrq_n_u16(r, 4));
+	}
+}
+#endif
+
+// Converts a line of 4:2:0 YUV straight to a PSP pixel format, without going through swscale.
+static void convertYUV420Line(u8 *dest, const u8 *srcY, const u8 *srcU, const u8 *srcV, int width, int videoPixelMode) {
+	const int bpp = videoPixelMode == GE_CMODE_32BIT_ABGR8888 ? 4 : 2;
+	int x = 0;
+#ifdef _M_SSE
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i offsetY = _mm_set1_epi16(16);
+	const __m128i offsetUV = _mm_set1_epi16(128);
+	for (; x + 16 <= width; x += 16) {
+		const __m128i y8 = _mm_loadu_si128((const __m128i *)(srcY + x));
+		// Each chroma sample covers two pixels.
+		const __m128i u8 = _mm_loadl_epi64((const __m128i *)(srcU + x / 2));
+		const __m128i v8 = _mm_loadl_epi64((const __m128i *)(srcV + x / 2));
+		const __m128i uu = _mm_unpacklo_epi8(u8, u8);
+		const __m128i vv = _mm_unpacklo_epi8(v8, v8);
+
+		__m128i r[2], g[2], b[2];
+		for (int half = 0; half < 2; ++half) {
+			const __m128i y16 = half == 0 ? _mm_unpacklo_epi8(y8, zero) : _mm_unpackhi_epi8(y8, zero);
+			const __m128i u16 = _mm_sub_epi16(half == 0 ? _mm_unpacklo_epi8(uu, zero) : _mm_unpackhi_epi8(uu, zero), offsetUV);
+			const __m128i v16 = _mm_sub_epi16(half == 0 ? _mm_unpacklo_epi8(vv, zero) : _mm_unpackhi_epi8(vv, zero), offsetUV);
+			const __m128i yy = _mm_mullo_epi16(_mm_sub_epi16(y16, offsetY), _mm_set1_epi16(YUV_Y));
+			r[half] = convertYUVComponentSSE2(_mm_adds_epi16(yy, _mm_mullo_epi16(v16, _mm_set1_epi16(YUV_VR))));
+			g[half] = convertYUVComponentSSE2(_mm_subs_epi16(_mm_subs_epi16(yy, _mm_mullo_epi16(u16, _mm_set1_epi16(YUV_UG))), _mm_mullo_epi16(v16, _mm_set1_epi16(YUV_VG))));
+			b[half] = convertYUVComponentSSE2(_mm_adds_epi16(yy, _mm_mullo_epi16(u16, _mm_set1_epi16(YUV_UB))));
+		}
+		const __m128i r8 = _mm_packus_epi16(r[0], r[1]);
+		const __m128i g8 = _mm_packus_epi16(g[0], g[1]);
+		const __m128i b8 = _mm_packus_epi16(b[0], b[1]);
+
+		__m128i *out = (__m128i *)(dest + x * bpp);
+		if (videoPixelMode == GE_CMODE_32BIT_ABGR8888) {
+			const __m128i rgLo = _mm_unpacklo_epi8(r8, g8);
+			const __m128i rgHi = _mm_unpackhi_epi8(r8, g8);
+			const __m128i b0Lo = _mm_unpacklo_epi8(b8, zero);
+			const __m128i b0Hi = _mm_unpackhi_epi8(b8, zero);
+			_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(rgLo, b0Lo));
+			_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rgLo, b0Lo));
+			_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rgHi, b0Hi));
+			_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rgHi, b0Hi));
+		} else {
+			_mm_storeu_si128(out + 0, packYUVPixels16SSE2(_mm_unpacklo_epi8(r8, zero), _mm_unpacklo_epi8(g8, zero), _mm_unpacklo_epi8(b8, zero), videoPixelMode));
+			_mm_storeu_si128(out + 1, packYUVPixels16SSE2(_mm_unpackhi_epi8(r8, zero), _mm_unpackhi_epi8(g8, zero), _mm_unpackhi_epi8(b8, zero), videoPixelMode));
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const int16x8_t offsetY = vdupq_n_s16(16);
+	const int16x8_t offsetUV = vdupq_n_s16(128);
+	for (; x + 16 <= width; x += 16) {
+		const uint8x16_t y8 = vld1q_u8(srcY + x);
+		// Each chroma sample covers two pixels.
+		const uint8x8x2_t uu = vzip_u8(vld1_u8(srcU + x / 2), vld1_u8(srcU + x / 2));
+		const uint8x8x2_t vv = vzip_u8(vld1_u8(srcV + x / 2), vld1_u8(srcV + x / 2));
+
+		uint8x8_t r[2], g[2], b[2];
+		for (int half = 0; half < 2; ++half) {
+			const int16x8_t y16 = vreinterpretq_s16_u16(vmovl_u8(half == 0 ? vget_low_u8(y8) : vget_high_u8(y8)));
+			const int16x8_t u16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uu.val[half])), offsetUV);
+			const int16x8_t v16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vv.val[half])), offsetUV);
+			const int16x8_t yy = vmulq_n_s16(vsubq_s16(y16, offsetY), YUV_Y);
+			r[half] = vqrshrun_n_s16(vqaddq_s16(yy, vmulq_n_s16(v16, YUV_VR)), 6);
+			g[half] = vqrshrun_n_s16(vqsubq_s16(vqsubq_s16(yy, vmulq_n_s16(u16, YUV_UG)), vmulq_n_s16(v16, YUV_VG)), 6);
+			b[half] = vqrshrun_n_s16(vqaddq_s16(yy, vmulq_n_s16(u16, YUV_UB)), 6);
+		}
+
+		if (videoPixelMode == GE_CMODE_32BIT_ABGR8888) {
+			uint8x16x4_t rgba;
+			rgba.val[0] = vcombine_u8(r[0], r[1]);
+			rgba.val[1] = vcombine_u8(g[0], g[1]);
+			rgba.val[2] = vcombine_u8(b[0], b[1]);
+			rgba.val[3] = vdupq_n_u8(0);
+			vst4q_u8(dest + x * bpp, rgba);
+		} else {
+			u16 *out = (u16 *)(dest + x * bpp);
+			vst1q_u16(out + 0, packYUVPixels16NEON(r[0], g[0], b[0], videoPixelMode));
+			vst1q_u16(out + 8, packYUVPixels16NEON(r[1], g[1], b[1], videoPixelMode));
+		}
+	}
 #endif
+	for (; x < width; ++x) {
+		writeYUVPixel(dest + x * bpp, srcY[x], srcU[x / 2], srcV[x / 2], videoPixelMode);
+	}
+}
+#endif // USE_FFMPEG
 
 static int getPixelFormatBytes(int pspFormat)
 {
@@ -123,10 +349,12 @@ MediaEngine::MediaEngine(): m_pdata(0) {
 	m_pCodecCtxs.clear();
 	m_pFrame = 0;
 	m_pFrameRGB = 0;
+	m_pSwFrame = 0;
 	m_pIOContext = 0;
 	m_sws_ctx = 0;
 #endif
 	m_sws_fmt = 0;
+	m_sws_srcFmt = -1;
 	m_buffer = 0;
 
 	m_videoStream = -1;
@@ -368,6 +596,8 @@ void MediaEngine::closeContext()
 		av_frame_free(&m_pFrameRGB);
 	if (m_pFrame)
 		av_frame_free(&m_pFrame);
+	if (m_pSwFrame)
+		av_frame_free(&m_pSwFrame);
 	if (m_pIOContext && m_pIOContext->buffer)
 		av_free(m_pIOContext->buffer);
 	if (m_pIOContext)
@@ -542,6 +772,10 @@ bool MediaEngine::setVideoStream(int streamNum, bool force) {
 #endif
 
 		m_pCodecCtx->flags |= AV_CODEC_FLAG_OUTPUT_CORRUPT | AV_CODEC_FLAG_LOW_DELAY;
+#ifdef USE_FFMPEG_HWACCEL
+		if (g_Config.bHardwareVideoDecoding)
+			setupHardwareDecoding(m_pCodecCtx, pCodec);
+#endif
 
 		AVDictionary *opt = nullptr;
 		// Allow ffmpeg to use any number of threads it wants.  Without this, it doesn't use threads.
@@ -588,6 +822,7 @@ bool MediaEngine::setVideoDim(int width, int height)
 	sws_freeContext(m_sws_ctx);
 	m_sws_ctx = NULL;
 	m_sws_fmt = -1;
+	m_sws_srcFmt = -1;
 
 	if (m_desWidth == 0 || m_desHeight == 0) {
 		// Can't setup SWS yet, so stop for now.
@@ -615,20 +850,26 @@ bool MediaEngine::setVideoDim(int width, int height)
 	return true;
 }
 
-void MediaEngine::updateSwsFormat(int videoPixelMode) {
+void MediaEngine::updateSwsFormat(int videoPixelMode, int srcFormat) {
 #ifdef USE_FFMPEG
 	auto codecIter = m_pCodecCtxs.find(m_videoStream);
 	AVCodecContext *m_pCodecCtx = codecIter == m_pCodecCtxs.end() ? 0 : codecIter->second;
+	if (m_pCodecCtx != 0 && srcFormat < 0)
+		srcFormat = m_pCodecCtx->pix_fmt;
 
 	AVPixelFormat swsDesired = getSwsFormat(videoPixelMode);
-	if (swsDesired != m_sws_fmt && m_pCodecCtx != 0) {
+	if ((swsDesired != m_sws_fmt || srcFormat != m_sws_srcFmt) && m_pCodecCtx != 0) {
 		m_sws_fmt = swsDesired;
+		// Hardware frames get downloaded first, and we don't know their format until then.
+		if (srcFormat < 0 || isHardwarePixelFormat(srcFormat))
+			return;
+		m_sws_srcFmt = srcFormat;
 		m_sws_ctx = sws_getCachedContext
 			(
 				m_sws_ctx,
 				m_pCodecCtx->width,
 				m_pCodecCtx->height,
-				m_pCodecCtx->pix_fmt,
+				(AVPixelFormat)m_sws_srcFmt,
 				m_desWidth,
 				m_desHeight,
 				(AVPixelFormat)m_sws_fmt,
@@ -703,13 +944,45 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 					setVideoDim();
 				}
 				if (m_pFrameRGB && !skipFrame) {
-					updateSwsFormat(videoPixelMode);
-					// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
-					// Update the linesize for the new format too.  We started with the largest size, so it should fit.
-					m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
-
-					sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
-						m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
+					const AVFrame *srcFrame = m_pFrame;
+#ifdef USE_FFMPEG_HWACCEL
+					if (isHardwarePixelFormat(m_pFrame->format)) {
+						// The guest reads the pixels, so they have to come back to RAM anyway.
+						if (!m_pSwFrame)
+							m_pSwFrame = av_frame_alloc();
+						av_frame_unref(m_pSwFrame);
+						if (av_hwframe_transfer_data(m_pSwFrame, m_pFrame, 0) >= 0) {
+							srcFrame = m_pSwFrame;
+						} else {
+							ERROR_LOG(ME, "Failed to download hardware video frame");
+							srcFrame = nullptr;
+						}
+					}
+#endif
+					if (srcFrame) {
+						// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
+						// Update the linesize for the new format too.  We started with the largest size, so it should fit.
+						m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
+
+						bool unscaled = m_desWidth == m_pCodecCtx->width && m_desHeight == m_pCodecCtx->height;
+						if (srcFrame->format == AV_PIX_FMT_YUV420P && unscaled) {
+							// The common case: convert straight to the PSP format, skipping swscale.
+							u8 *dest = m_pFrameRGB->data[0];
+							for (int y = 0; y < m_desHeight; ++y) {
+								const u8 *srcY = srcFrame->data[0] + y * srcFrame->linesize[0];
+								const u8 *srcU = srcFrame->data[1] + (y / 2) * srcFrame->linesize[1];
+								const u8 *srcV = srcFrame->data[2] + (y / 2) * srcFrame->linesize[2];
+								convertYUV420Line(dest, srcY, srcU, srcV, m_desWidth, videoPixelMode);
+								dest += m_pFrameRGB->linesize[0];
+							}
+						} else {
+							updateSwsFormat(videoPixelMode, srcFrame->format);
+							if (m_sws_ctx) {
+								sws_scale(m_sws_ctx, srcFrame->data, srcFrame->linesize, 0,
+									m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
+							}
+						}
+					}
 				}
 
 #if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(55, 58, 100)
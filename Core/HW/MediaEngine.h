@@ -97,7 +97,7 @@ class MediaEngine
 private:
 	bool SetupStreams();
 	bool setVideoDim(int width = 0, int height = 0);
-	void updateSwsFormat(int videoPixelMode);
+	void updateSwsFormat(int videoPixelMode, int srcFormat = -1);
 	int getNextAudioFrame(u8 **buf, int *headerCode1, int *headerCode2);
 
 public:  // TODO: Very little of this below should be public.
@@ -108,11 +108,14 @@ class MediaEngine
 	std::map<int, AVCodecContext *> m_pCodecCtxs;
 	AVFrame *m_pFrame;
 	AVFrame *m_pFrameRGB;
+	// Frames from a hardware decoder are copied here before conversion.
+	AVFrame *m_pSwFrame;
 	AVIOContext *m_pIOContext;
 	SwsContext *m_sws_ctx;
 #endif
 
 	int m_sws_fmt;
+	int m_sws_srcFmt;
 	u8 *m_buffer;
 	int m_videoStream;
 	int m_expectedVideoStreams;
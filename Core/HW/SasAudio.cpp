@@ -17,9 +17,12 @@
 
 #include <algorithm>
 
+#include "ppsspp_config.h"
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/MemMapHelpers.h"
 #include "Core/HLE/sceAtrac.h"
 #include "Core/Config.h"
@@ -27,8 +30,24 @@
 #include "Core/Util/AudioFormat.h"
 #include "SasAudio.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif // PPSSPP_ARCH(ARM_NEON)
+
 // #define AUDIO_TO_FILE
 
+// Below this many playing voices, handing them to other threads costs more than it saves.
+static const int MIN_PARALLEL_VOICES = 8;
+static const int MIN_VOICES_PER_TASK = 4;
+
 static const u8 f[16][2] = {
 	{   0,   0 },
 	{  60,   0 },
@@ -371,10 +390,12 @@ void SasInstance::ClearGrainSize() {
 	delete[] sendBuffer;
 	delete[] sendBufferDownsampled;
 	delete[] sendBufferProcessed;
+	delete[] voiceSamples_;
 	mixBuffer = nullptr;
 	sendBuffer = nullptr;
 	sendBufferDownsampled = nullptr;
 	sendBufferProcessed = nullptr;
+	voiceSamples_ = nullptr;
 }
 
 void SasInstance::SetGrainSize(int newGrainSize) {
@@ -385,11 +406,13 @@ void SasInstance::SetGrainSize(int newGrainSize) {
 	delete[] sendBuffer;
 	delete[] sendBufferDownsampled;
 	delete[] sendBufferProcessed;
+	delete[] voiceSamples_;
 
 	mixBuffer = new s32[grainSize * 2];
 	sendBuffer = new s32[grainSize * 2];
 	sendBufferDownsampled = new s16[grainSize];
 	sendBufferProcessed = new s16[grainSize * 2];
+	voiceSamples_ = new s32[grainSize * PSP_SAS_VOICES_MAX];
 	memset(mixBuffer, 0, sizeof(int) * grainSize * 2);
 	memset(sendBuffer, 0, sizeof(int) * grainSize * 2);
 	memset(sendBufferDownsampled, 0, sizeof(s16) * grainSize);
@@ -471,6 +494,11 @@ bool SasVoice::HaveSamplesEnded() const {
 }
 
 void SasInstance::MixVoice(SasVoice &voice) {
+	int start = RenderVoice(voice, mixTemp_, voiceSamples_);
+	AccumulateVoice(voice, voiceSamples_, start);
+}
+
+int SasInstance::RenderVoice(SasVoice &voice, int16_t *mixTemp, int *samples) {
 	switch (voice.type) {
 	case VOICETYPE_VAG:
 		if (voice.type == VOICETYPE_VAG && !voice.vagAddr)
@@ -496,22 +524,22 @@ void SasInstance::MixVoice(SasVoice &voice) {
 		// TODO: Special case no-resample case (and 2x and 0.5x) for speed, it's not uncommon
 
 		// Two passes: First read, then resample.
-		mixTemp_[0] = voice.resampleHist[0];
-		mixTemp_[1] = voice.resampleHist[1];
+		mixTemp[0] = voice.resampleHist[0];
+		mixTemp[1] = voice.resampleHist[1];
 
 		int voicePitch = voice.pitch;
 		u32 sampleFrac = voice.sampleFrac;
 		int samplesToRead = (sampleFrac + voicePitch * std::max(0, grainSize - delay)) >> PSP_SAS_PITCH_BASE_SHIFT;
-		if (samplesToRead > ARRAY_SIZE(mixTemp_) - 2) {
+		if (samplesToRead > MIX_TEMP_SIZE - 2) {
 			ERROR_LOG(SCESAS, "Too many samples to read (%d)! This shouldn't happen.", samplesToRead);
-			samplesToRead = ARRAY_SIZE(mixTemp_) - 2;
+			samplesToRead = MIX_TEMP_SIZE - 2;
 		}
 		int readPos = 2;
 		if (voice.envelope.NeedsKeyOn()) {
 			readPos = 0;
 			samplesToRead += 2;
 		}
-		voice.ReadSamples(&mixTemp_[readPos], samplesToRead);
+		voice.ReadSamples(&mixTemp[readPos], samplesToRead);
 		int tempPos = readPos + samplesToRead;
 
 		for (int i = 0; i < delay; ++i) {
@@ -522,7 +550,7 @@ void SasInstance::MixVoice(SasVoice &voice) {
 
 		const bool needsInterp = voicePitch != PSP_SAS_PITCH_BASE || (sampleFrac & PSP_SAS_PITCH_MASK) != 0;
 		for (int i = delay; i < grainSize; i++) {
-			const int16_t *s = mixTemp_ + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+			const int16_t *s = mixTemp + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
 
 			// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
 			int sample = s[0];
@@ -540,19 +568,11 @@ void SasInstance::MixVoice(SasVoice &voice) {
 
 			// We just scale by the envelope before we scale by volumes.
 			// Again, we round up by adding (1 << 14) first (*after* multiplying.)
-			sample = ((sample * envelopeValue) + (1 << 14)) >> 15;
-
-			// We mix into this 32-bit temp buffer and clip in a second loop
-			// Ideally, the shift right should be there too but for now I'm concerned about
-			// not overflowing.
-			mixBuffer[i * 2] += (sample * voice.volumeLeft) >> 12;
-			mixBuffer[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
-			sendBuffer[i * 2] += sample * voice.effectLeft >> 12;
-			sendBuffer[i * 2 + 1] += sample * voice.effectRight >> 12;
+			samples[i] = ((sample * envelopeValue) + (1 << 14)) >> 15;
 		}
 
-		voice.resampleHist[0] = mixTemp_[tempPos - 2];
-		voice.resampleHist[1] = mixTemp_[tempPos - 1];
+		voice.resampleHist[0] = mixTemp[tempPos - 2];
+		voice.resampleHist[1] = mixTemp[tempPos - 1];
 
 		voice.sampleFrac = sampleFrac - (tempPos - 2) * PSP_SAS_PITCH_BASE;
 
@@ -563,30 +583,85 @@ void SasInstance::MixVoice(SasVoice &voice) {
 			voice.playing = false;
 			voice.on = false;
 		}
+		return delay;
+	}
+	return grainSize;
+}
+
+void SasInstance::AccumulateVoice(const SasVoice &voice, const int *samples, int start) {
+	const int volumeLeft = voice.volumeLeft;
+	const int volumeRight = voice.volumeRight;
+	const int effectLeft = voice.effectLeft;
+	const int effectRight = voice.effectRight;
+	for (int i = start; i < grainSize; i++) {
+		int sample = samples[i];
+		// We mix into this 32-bit temp buffer and clip in a second loop
+		// Ideally, the shift right should be there too but for now I'm concerned about
+		// not overflowing.
+		mixBuffer[i * 2] += (sample * volumeLeft) >> 12;
+		mixBuffer[i * 2 + 1] += (sample * volumeRight) >> 12;
+		sendBuffer[i * 2] += sample * effectLeft >> 12;
+		sendBuffer[i * 2 + 1] += sample * effectRight >> 12;
 	}
 }
 
 void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol) {
+	s16 *outp = (s16 *)Memory::GetPointer(outAddr);
+	const s16 *inp = inAddr ? (s16*)Memory::GetPointer(inAddr) : 0;
+	Mix(outp, inp, leftVol, rightVol);
+
+	if (outputMode == PSP_SAS_OUTPUTMODE_MIXED) {
+		if (MemBlockInfoDetailed()) {
+			if (inp)
+				NotifyMemInfo(MemBlockFlags::READ, inAddr, grainSize * sizeof(u16) * 2, "SasMix");
+			NotifyMemInfo(MemBlockFlags::WRITE, outAddr, grainSize * sizeof(u16) * 2, "SasMix");
+		}
+	} else {
+		NotifyMemInfo(MemBlockFlags::WRITE, outAddr, grainSize * sizeof(u16) * 4, "SasMix");
+	}
+}
+
+void SasInstance::Mix(s16 *outp, const s16 *inp, int leftVol, int rightVol) {
+	int playingVoices[PSP_SAS_VOICES_MAX];
+	int playingCount = 0;
 	for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
 		SasVoice &voice = voices[v];
 		if (!voice.playing || voice.paused)
 			continue;
-		MixVoice(voice);
+		playingVoices[playingCount++] = v;
+	}
+
+	if (playingCount >= MIN_PARALLEL_VOICES && g_threadManager.GetNumLooperThreads() > 1) {
+		// Voices don't affect each other until they're added up, so render them on all cores into separate buffers.
+		// They're still added in voice order, so the output is the same as mixing them one by one.
+		int starts[PSP_SAS_VOICES_MAX];
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			int16_t mixTemp[MIX_TEMP_SIZE];
+			for (int i = l; i < h; i++) {
+				int v = playingVoices[i];
+				// The atrac code isn't thread safe, these are done below.
+				if (voices[v].type != VOICETYPE_ATRAC3)
+					starts[v] = RenderVoice(voices[v], mixTemp, voiceSamples_ + v * grainSize);
+			}
+		}, 0, playingCount, MIN_VOICES_PER_TASK);
+
+		for (int i = 0; i < playingCount; i++) {
+			int v = playingVoices[i];
+			if (voices[v].type == VOICETYPE_ATRAC3)
+				starts[v] = RenderVoice(voices[v], mixTemp_, voiceSamples_ + v * grainSize);
+			AccumulateVoice(voices[v], voiceSamples_ + v * grainSize, starts[v]);
+		}
+	} else {
+		for (int i = 0; i < playingCount; i++)
+			MixVoice(voices[playingVoices[i]]);
 	}
 
 	// Then mix the send buffer in with the rest.
 
 	// Alright, all voices mixed. Let's convert and clip, and at the same time, wipe mixBuffer for next time. Could also dither.
-	s16 *outp = (s16 *)Memory::GetPointer(outAddr);
-	const s16 *inp = inAddr ? (s16*)Memory::GetPointer(inAddr) : 0;
 	if (outputMode == PSP_SAS_OUTPUTMODE_MIXED) {
 		// Okay, apply effects processing to the Send buffer.
 		WriteMixedOutput(outp, inp, leftVol, rightVol);
-		if (MemBlockInfoDetailed()) {
-			if (inp)
-				NotifyMemInfo(MemBlockFlags::READ, inAddr, grainSize * sizeof(u16) * 2, "SasMix");
-			NotifyMemInfo(MemBlockFlags::WRITE, outAddr, grainSize * sizeof(u16) * 2, "SasMix");
-		}
 	} else {
 		s16 *outpL = outp + grainSize * 0;
 		s16 *outpR = outp + grainSize * 1;
@@ -599,14 +674,45 @@ void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol) {
 			*outpSendL++ = clamp_s16(sendBuffer[i + 0]);
 			*outpSendR++ = clamp_s16(sendBuffer[i + 1]);
 		}
-		NotifyMemInfo(MemBlockFlags::WRITE, outAddr, grainSize * sizeof(u16) * 4, "SasMix");
 	}
 	memset(mixBuffer, 0, grainSize * sizeof(int) * 2);
 	memset(sendBuffer, 0, grainSize * sizeof(int) * 2);
 
 #ifdef AUDIO_TO_FILE
-	fwrite(Memory::GetPointer(outAddr), 1, grainSize * 2 * 2, audioDump);
+	fwrite(outp, 1, grainSize * 2 * 2, audioDump);
+#endif
+}
+
+// Clamps the 32-bit mix down to 16 bits, adding in another 16-bit buffer first if there is one.
+static void ClampMixedOutput(s16 *outp, const int *mix, const s16 *add, int count) {
+	int i = 0;
+#ifdef _M_SSE
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i *)(mix + i));
+		__m128i hi = _mm_loadu_si128((const __m128i *)(mix + i + 4));
+		if (add) {
+			__m128i a = _mm_loadu_si128((const __m128i *)(add + i));
+			// Sign extend by unpacking into the high halves and shifting down.
+			lo = _mm_add_epi32(lo, _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16));
+			hi = _mm_add_epi32(hi, _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16));
+		}
+		// Saturating pack, same as clamp_s16.
+		_mm_storeu_si128((__m128i *)(outp + i), _mm_packs_epi32(lo, hi));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 8 <= count; i += 8) {
+		int32x4_t lo = vld1q_s32(mix + i);
+		int32x4_t hi = vld1q_s32(mix + i + 4);
+		if (add) {
+			int16x8_t a = vld1q_s16(add + i);
+			lo = vaddw_s16(lo, vget_low_s16(a));
+			hi = vaddw_s16(hi, vget_high_s16(a));
+		}
+		vst1q_s16(outp + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+	}
 #endif
+	for (; i < count; i++)
+		outp[i] = clamp_s16(add ? mix[i] + add[i] : mix[i]);
 }
 
 void SasInstance::WriteMixedOutput(s16 *outp, const s16 *inp, int leftVol, int rightVol) {
@@ -634,15 +740,9 @@ void SasInstance::WriteMixedOutput(s16 *outp, const s16 *inp, int leftVol, int r
 	} else {
 		// These are the optimal cases.
 		if (dry && wet) {
-			for (int i = 0; i < grainSize * 2; i += 2) {
-				*outp++ = clamp_s16(mixBuffer[i + 0] + sendBufferProcessed[i + 0]);
-				*outp++ = clamp_s16(mixBuffer[i + 1] + sendBufferProcessed[i + 1]);
-			}
+			ClampMixedOutput(outp, mixBuffer, sendBufferProcessed, grainSize * 2);
 		} else if (dry) {
-			for (int i = 0; i < grainSize * 2; i += 2) {
-				*outp++ = clamp_s16(mixBuffer[i + 0]);
-				*outp++ = clamp_s16(mixBuffer[i + 1]);
-			}
+			ClampMixedOutput(outp, mixBuffer, nullptr, grainSize * 2);
 		} else {
 			// This is another uncommon case, dry must be off but let's keep it for clarity.
 			for (int i = 0; i < grainSize * 2; i += 2) {
@@ -294,7 +294,15 @@ class SasInstance {
 	FILE *audioDump = nullptr;
 
 	void Mix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int rightVol = 0);
+	// Same, but with host buffers. outp needs room for OutputSamples() samples, inp for grainSize * 2.
+	void Mix(s16 *outp, const s16 *inp, int leftVol, int rightVol);
+	int OutputSamples() const { return outputMode == PSP_SAS_OUTPUTMODE_MIXED ? grainSize * 2 : grainSize * 4; }
 	void MixVoice(SasVoice &voice);
+	// Resamples and envelopes a voice into samples, returns the first index written (the rest are before it.)
+	// Only touches the voice, so different voices can run on different threads.
+	int RenderVoice(SasVoice &voice, int16_t *mixTemp, int *samples);
+	// Adds the output of RenderVoice into the mix and send buffers.
+	void AccumulateVoice(const SasVoice &voice, const int *samples, int start);
 
 	// Applies reverb to send buffer, according to waveformEffect.
 	void ApplyWaveformEffect();
@@ -311,5 +319,8 @@ class SasInstance {
 private:
 	SasReverb reverb_;
 	int grainSize = 0;
-	int16_t mixTemp_[PSP_SAS_MAX_GRAIN * 4 + 2 + 8];  // some extra margin for very high pitches.
+	enum { MIX_TEMP_SIZE = PSP_SAS_MAX_GRAIN * 4 + 2 + 8 };  // some extra margin for very high pitches.
+	int16_t mixTemp_[MIX_TEMP_SIZE];
+	// grainSize samples per voice, only used within Mix.
+	int *voiceSamples_ = nullptr;
 };
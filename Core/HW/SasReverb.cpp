@@ -15,14 +15,30 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <iterator>
 
+#include "ppsspp_config.h"
+#include "Common/Common.h"
 #include "Common/Math/math_util.h"
 #include "Core/Config.h"
 #include "Core/HW/SasReverb.h"
 #include "Core/Util/AudioFormat.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif // PPSSPP_ARCH(ARM_NEON)
+
 // This is under the assumption that the reverb used in Sas is the same as the PSX SPU reverb.
 
 // Source: http://problemkaputt.de/psx-spx.htm#spureverbformula
@@ -168,14 +184,60 @@ const char *SasReverb::GetPresetName(int preset) {
 	return presets[preset].name;
 }
 
+int SasReverb::GetNumPresets() {
+	return (int)ARRAY_SIZE(presets);
+}
+
+// Checks that no reflection filter reads a spot an earlier one (in the reference order) writes.
+static bool ReflectionsIndependent(const SasReverbData &d) {
+	if (d.size <= 0)
+		return false;
+	auto wrap = [&](int offset) {
+		return (offset % d.size + d.size) % d.size;
+	};
+	const int writes[4] = { d.mLSAME, d.mRSAME, d.mLDIFF, d.mRDIFF };
+	const int reads[4][2] = {
+		{ d.dLSAME, d.mLSAME - 1 },
+		{ d.dRSAME, d.mRSAME - 1 },
+		{ d.dRDIFF, d.mLDIFF - 1 },
+		{ d.dLDIFF, d.mRDIFF - 1 },
+	};
+	for (int k = 1; k < 4; k++) {
+		for (int j = 0; j < k; j++) {
+			for (int r = 0; r < 2; r++) {
+				if (wrap(reads[k][r]) == wrap(writes[j]))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+// All the offsets the filters read or write at, relative to the current position.
+static void GetTapRange(const SasReverbData &d, int *tapMin, int *tapMax) {
+	const int taps[] = {
+		d.dLSAME, d.dRSAME, d.dLDIFF, d.dRDIFF,
+		d.mLSAME, d.mRSAME, d.mLDIFF, d.mRDIFF,
+		d.mLSAME - 1, d.mRSAME - 1, d.mLDIFF - 1, d.mRDIFF - 1,
+		d.mLCOMB1, d.mRCOMB1, d.mLCOMB2, d.mRCOMB2, d.mLCOMB3, d.mRCOMB3, d.mLCOMB4, d.mRCOMB4,
+		d.mLAPF1, d.mRAPF1, d.mLAPF2, d.mRAPF2,
+		d.mLAPF1 - d.dAPF1, d.mRAPF1 - d.dAPF1, d.mLAPF2 - d.dAPF2, d.mRAPF2 - d.dAPF2,
+	};
+	*tapMin = *std::min_element(std::begin(taps), std::end(taps));
+	*tapMax = *std::max_element(std::begin(taps), std::end(taps));
+}
+
 void SasReverb::SetPreset(int preset) {
 	if (preset < (int)ARRAY_SIZE(presets))
 		preset_ = preset;
 	if (preset_ != -1) {
 		pos_ = BUFSIZE - presets[preset_].size;
 		memset(workspace_, 0, sizeof(int16_t) * BUFSIZE);
+		reflectionsIndependent_ = ReflectionsIndependent(presets[preset_]);
+		GetTapRange(presets[preset_], &tapMin_, &tapMax_);
 	} else {
 		pos_ = 0;
+		reflectionsIndependent_ = false;
 	}
 }
 
@@ -207,7 +269,63 @@ class BufferWrapper {
 	int size_;
 };
 
-void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight) {
+// Same interface, for stretches where the caller knows no index wraps.
+class UnwrappedBuffer {
+public:
+	UnwrappedBuffer(int16_t *buffer, int position) : buf_(buffer), pos_(position) {}
+	int16_t &operator [](int index) {
+		return buf_[pos_ + index];
+	}
+
+	int GetPosition() { return pos_; }
+	void Next() {
+		pos_++;
+	}
+
+private:
+	int16_t *buf_;
+	int pos_;
+};
+
+// The all pass filters and the output, shared by both versions.
+template<typename Buffer>
+static inline void ProcessLateReverb(Buffer &b, const SasReverbData &d, int32_t Lout, int32_t Rout, int16_t *output, uint16_t volLeft, uint16_t volRight, int finalShift) {
+	// ___Late Reverb APF1(All Pass Filter 1, with input from COMB)________________
+	b[d.mLAPF1] = clamp_s16(Lout - (d.vAPF1*b[(d.mLAPF1 - d.dAPF1)] >> 15));
+	Lout = b[(d.mLAPF1 - d.dAPF1)] + (b[d.mLAPF1] * d.vAPF1 >> 15);
+	b[d.mRAPF1] = clamp_s16(Rout - (d.vAPF1*b[(d.mRAPF1 - d.dAPF1)] >> 15));
+	Rout = b[(d.mRAPF1 - d.dAPF1)] + (b[d.mRAPF1] * d.vAPF1 >> 15);
+	// ___Late Reverb APF2(All Pass Filter 2, with input from APF1)________________
+	b[d.mLAPF2] = clamp_s16(Lout - (d.vAPF2*b[(d.mLAPF2 - d.dAPF2)] >> 15));
+	Lout = b[(d.mLAPF2 - d.dAPF2)] + (b[d.mLAPF2] * d.vAPF2 >> 15);
+	b[d.mRAPF2] = clamp_s16(Rout - (d.vAPF2*b[(d.mRAPF2 - d.dAPF2)] >> 15));
+	Rout = b[(d.mRAPF2 - d.dAPF2)] + (b[d.mRAPF2] * d.vAPF2 >> 15);
+	// ___Output to Mixer(Output volume multiplied with input from APF2)___________
+	output[0] = clamp_s16((Lout * volLeft) >> finalShift);
+	output[1] = clamp_s16((Rout * volRight) >> finalShift);
+	output[2] = 0;
+	output[3] = 0;
+}
+
+// One sample (at 22khz) of the reverb, straight from the description.
+template<typename Buffer>
+static inline void ProcessSample(Buffer &b, const SasReverbData &d, int16_t LeftInput, int16_t RightInput, int16_t *output, uint16_t volLeft, uint16_t volRight, int finalShift) {
+	int16_t Lin = LeftInput; //  (d.vLIN * LeftInput) >> 15;
+	int16_t Rin = RightInput; // (d.vRIN * RightInput) >> 15;
+
+	// ____Same Side Reflection(left - to - left and right - to - right)___________________
+	b[d.mLSAME] = clamp_s16(Lin + (b[d.dLSAME] * d.vWALL >> 15) - (b[d.mLSAME - 1]*d.vIIR >> 15) + b[d.mLSAME - 1]); // L - to - L
+	b[d.mRSAME] = clamp_s16(Rin + (b[d.dRSAME] * d.vWALL >> 15) - (b[d.mRSAME - 1]*d.vIIR >> 15) + b[d.mRSAME - 1]); // R - to - R
+	// ___Different Side Reflection(left - to - right and right - to - left)_______________
+	b[d.mLDIFF] = clamp_s16(Lin + (b[d.dRDIFF] * d.vWALL >> 15) - (b[d.mLDIFF - 1]*d.vIIR >> 15) + b[d.mLDIFF - 1]); // R - to - L
+	b[d.mRDIFF] = clamp_s16(Rin + (b[d.dLDIFF] * d.vWALL >> 15) - (b[d.mRDIFF - 1]*d.vIIR >> 15) + b[d.mRDIFF - 1]); // L - to - R
+	// ___Early Echo(Comb Filter, with input from buffer)__________________________
+	int32_t Lout = ((d.vCOMB1*b[d.mLCOMB1] + d.vCOMB2*b[d.mLCOMB2] + d.vCOMB3*b[d.mLCOMB3] + d.vCOMB4*b[d.mLCOMB4]) >> 15);
+	int32_t Rout = ((d.vCOMB1*b[d.mRCOMB1] + d.vCOMB2*b[d.mRCOMB2] + d.vCOMB3*b[d.mRCOMB3] + d.vCOMB4*b[d.mRCOMB4]) >> 15);
+	ProcessLateReverb(b, d, Lout, Rout, output, volLeft, volRight, finalShift);
+}
+
+void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight, bool reference) {
 	// This means replicate the input signal in the processed buffer.
 	// Can also be used to verify that the error is in here...
 	if (preset_ == -1) {
@@ -230,47 +348,22 @@ void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inpu
 		return;
 	}
 
+	if (reference)
+		ProcessPreset(output, input, inputSize, volLeft, volRight, finalShift);
+	else
+		ProcessPresetFast(output, input, inputSize, volLeft, volRight, finalShift);
+}
+
+void SasReverb::ProcessPreset(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight, int finalShift) {
 	const SasReverbData &d = presets[preset_];
 
 	// We put this on the stack instead of in the object to let the compiler optimize better (avoid mem r/w).
 	BufferWrapper<BUFSIZE> b(workspace_, pos_, d.size);
 
 	// This runs at 22khz.
-	// Very unoptimized, straight from the description. Can probably be reformulated into something way more efficient.
-	// Or we could actually template the whole thing with the parameters as template arguments, as the presets are fixed.
 	for (size_t i = 0; i < inputSize; i++) {
 		// Dividing by two here is an incorrect hack. Some multiplication factor is needed to prevent the reverb from getting too loud, though.
-		int16_t LeftInput = input[i * 2] >> 1;
-		int16_t RightInput = input[i * 2 + 1] >> 1;
-
-		int16_t Lin = LeftInput; //  (d.vLIN * LeftInput) >> 15;
-		int16_t Rin = RightInput; // (d.vRIN * RightInput) >> 15;
-
-		// ____Same Side Reflection(left - to - left and right - to - right)___________________
-		b[d.mLSAME] = clamp_s16(Lin + (b[d.dLSAME] * d.vWALL >> 15) - (b[d.mLSAME - 1]*d.vIIR >> 15) + b[d.mLSAME - 1]); // L - to - L
-		b[d.mRSAME] = clamp_s16(Rin + (b[d.dRSAME] * d.vWALL >> 15) - (b[d.mRSAME - 1]*d.vIIR >> 15) + b[d.mRSAME - 1]); // R - to - R
-		// ___Different Side Reflection(left - to - right and right - to - left)_______________
-		b[d.mLDIFF] = clamp_s16(Lin + (b[d.dRDIFF] * d.vWALL >> 15) - (b[d.mLDIFF - 1]*d.vIIR >> 15) + b[d.mLDIFF - 1]); // R - to - L
-		b[d.mRDIFF] = clamp_s16(Rin + (b[d.dLDIFF] * d.vWALL >> 15) - (b[d.mRDIFF - 1]*d.vIIR >> 15) + b[d.mRDIFF - 1]); // L - to - R
-		// ___Early Echo(Comb Filter, with input from buffer)__________________________
-		int32_t Lout = ((d.vCOMB1*b[d.mLCOMB1] + d.vCOMB2*b[d.mLCOMB2] + d.vCOMB3*b[d.mLCOMB3] + d.vCOMB4*b[d.mLCOMB4]) >> 15);
-		int32_t Rout = ((d.vCOMB1*b[d.mRCOMB1] + d.vCOMB2*b[d.mRCOMB2] + d.vCOMB3*b[d.mRCOMB3] + d.vCOMB4*b[d.mRCOMB4]) >> 15);
-		// ___Late Reverb APF1(All Pass Filter 1, with input from COMB)________________
-		b[d.mLAPF1] = clamp_s16(Lout - (d.vAPF1*b[(d.mLAPF1 - d.dAPF1)] >> 15));
-		Lout = b[(d.mLAPF1 - d.dAPF1)] + (b[d.mLAPF1] * d.vAPF1 >> 15);
-		b[d.mRAPF1] = clamp_s16(Rout - (d.vAPF1*b[(d.mRAPF1 - d.dAPF1)] >> 15));
-		Rout = b[(d.mRAPF1 - d.dAPF1)] + (b[d.mRAPF1] * d.vAPF1 >> 15);
-		// ___Late Reverb APF2(All Pass Filter 2, with input from APF1)________________
-		b[d.mLAPF2] = clamp_s16(Lout - (d.vAPF2*b[(d.mLAPF2 - d.dAPF2)] >> 15));
-		Lout = b[(d.mLAPF2 - d.dAPF2)] + (b[d.mLAPF2] * d.vAPF2 >> 15);
-		b[d.mRAPF2] = clamp_s16(Rout - (d.vAPF2*b[(d.mRAPF2 - d.dAPF2)] >> 15));
-		Rout = b[(d.mRAPF2 - d.dAPF2)] + (b[d.mRAPF2] * d.vAPF2 >> 15);
-		// ___Output to Mixer(Output volume multiplied with input from APF2)___________
-		output[i * 4 + 0] = clamp_s16((Lout * volLeft) >> finalShift);
-		output[i * 4 + 1] = clamp_s16((Rout * volRight) >> finalShift);
-		output[i * 4 + 2] = 0;
-		output[i * 4 + 3] = 0;
-
+		ProcessSample(b, d, input[i * 2] >> 1, input[i * 2 + 1] >> 1, &output[i * 4], volLeft, volRight, finalShift);
 		b.Next();
 	}
 
@@ -278,3 +371,115 @@ void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inpu
 	pos_ = b.GetPosition();
 }
 
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+// Same as ProcessSample, but the four reflections run as one vector, and so do both sides
+// of the early echo. The all pass filters feed each other, so those stay scalar. Products and shifts are
+// done the same way in 32 bits, and the saturating packs match clamp_s16, so the output is bit exact.
+template<typename Buffer>
+static inline void ProcessSampleSIMD(Buffer &b, const SasReverbData &d, int16_t Lin, int16_t Rin, int16_t *output, uint16_t volLeft, uint16_t volRight, int finalShift) {
+	// Lanes: L-to-L, R-to-R, R-to-L, L-to-R.
+#ifdef _M_SSE
+	// Lanes hold sign extended 16-bit values, so madd against (coef, 0) is a plain 16x16 multiply.
+	const __m128i vWALL = _mm_set1_epi32((uint16_t)d.vWALL);
+	const __m128i vIIR = _mm_set1_epi32((uint16_t)d.vIIR);
+	const __m128i vCOMB = _mm_setr_epi16(d.vCOMB1, d.vCOMB2, d.vCOMB1, d.vCOMB2, d.vCOMB3, d.vCOMB4, d.vCOMB3, d.vCOMB4);
+
+	__m128i sum = _mm_setr_epi32(Lin, Rin, Lin, Rin);
+	__m128i wall = _mm_setr_epi32(b[d.dLSAME], b[d.dRSAME], b[d.dRDIFF], b[d.dLDIFF]);
+	__m128i prev = _mm_setr_epi32(b[d.mLSAME - 1], b[d.mRSAME - 1], b[d.mLDIFF - 1], b[d.mRDIFF - 1]);
+	sum = _mm_add_epi32(sum, _mm_srai_epi32(_mm_madd_epi16(wall, vWALL), 15));
+	sum = _mm_sub_epi32(sum, _mm_srai_epi32(_mm_madd_epi16(prev, vIIR), 15));
+	sum = _mm_add_epi32(sum, prev);
+	__m128i reflected = _mm_packs_epi32(sum, sum);
+	b[d.mLSAME] = (int16_t)_mm_extract_epi16(reflected, 0);
+	b[d.mRSAME] = (int16_t)_mm_extract_epi16(reflected, 1);
+	b[d.mLDIFF] = (int16_t)_mm_extract_epi16(reflected, 2);
+	b[d.mRDIFF] = (int16_t)_mm_extract_epi16(reflected, 3);
+
+	__m128i comb = _mm_setr_epi16(b[d.mLCOMB1], b[d.mLCOMB2], b[d.mRCOMB1], b[d.mRCOMB2], b[d.mLCOMB3], b[d.mLCOMB4], b[d.mRCOMB3], b[d.mRCOMB4]);
+	// Gives (L12, R12, L34, R34), then fold the top half down.
+	__m128i echo = _mm_madd_epi16(comb, vCOMB);
+	echo = _mm_srai_epi32(_mm_add_epi32(echo, _mm_srli_si128(echo, 8)), 15);
+	int32_t Lout = _mm_cvtsi128_si32(echo);
+	int32_t Rout = _mm_cvtsi128_si32(_mm_srli_si128(echo, 4));
+#else
+	alignas(16) const int32_t in[4] = { Lin, Rin, Lin, Rin };
+	alignas(8) int16_t taps[4] = { b[d.dLSAME], b[d.dRSAME], b[d.dRDIFF], b[d.dLDIFF] };
+	int16x4_t wall = vld1_s16(taps);
+	taps[0] = b[d.mLSAME - 1]; taps[1] = b[d.mRSAME - 1]; taps[2] = b[d.mLDIFF - 1]; taps[3] = b[d.mRDIFF - 1];
+	int16x4_t prev = vld1_s16(taps);
+	int32x4_t sum = vaddq_s32(vld1q_s32(in), vshrq_n_s32(vmull_n_s16(wall, d.vWALL), 15));
+	sum = vsubq_s32(sum, vshrq_n_s32(vmull_n_s16(prev, d.vIIR), 15));
+	sum = vaddw_s16(sum, prev);
+	vst1_s16(taps, vqmovn_s32(sum));
+	b[d.mLSAME] = taps[0];
+	b[d.mRSAME] = taps[1];
+	b[d.mLDIFF] = taps[2];
+	b[d.mRDIFF] = taps[3];
+
+	alignas(8) const int16_t combCoefs[4] = { d.vCOMB1, d.vCOMB2, d.vCOMB3, d.vCOMB4 };
+	const int16x4_t vCOMB = vld1_s16(combCoefs);
+	taps[0] = b[d.mLCOMB1]; taps[1] = b[d.mLCOMB2]; taps[2] = b[d.mLCOMB3]; taps[3] = b[d.mLCOMB4];
+	int32x4_t echoL = vmull_s16(vld1_s16(taps), vCOMB);
+	taps[0] = b[d.mRCOMB1]; taps[1] = b[d.mRCOMB2]; taps[2] = b[d.mRCOMB3]; taps[3] = b[d.mRCOMB4];
+	int32x4_t echoR = vmull_s16(vld1_s16(taps), vCOMB);
+	int32x2_t echo = vpadd_s32(vpadd_s32(vget_low_s32(echoL), vget_high_s32(echoL)), vpadd_s32(vget_low_s32(echoR), vget_high_s32(echoR)));
+	echo = vshr_n_s32(echo, 15);
+	int32_t Lout = vget_lane_s32(echo, 0);
+	int32_t Rout = vget_lane_s32(echo, 1);
+#endif
+	ProcessLateReverb(b, d, Lout, Rout, output, volLeft, volRight, finalShift);
+}
+#endif
+
+template<bool simd, typename Buffer>
+static inline void ProcessSampleFast(Buffer &b, const SasReverbData &d, int16_t Lin, int16_t Rin, int16_t *output, uint16_t volLeft, uint16_t volRight, int finalShift) {
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	if (simd) {
+		ProcessSampleSIMD(b, d, Lin, Rin, output, volLeft, volRight, finalShift);
+		return;
+	}
+#endif
+	ProcessSample(b, d, Lin, Rin, output, volLeft, volRight, finalShift);
+}
+
+// Returns the new position.
+template<bool simd, int bufsize>
+static int ProcessRuns(int16_t *workspace, int pos, const SasReverbData &d, int tapMin, int tapMax, int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight, int finalShift) {
+	const int base = bufsize - d.size;
+	size_t i = 0;
+	while (i < inputSize) {
+		// While no tap is near either end of the ring, the wrapping checks can be skipped.
+		size_t run = 0;
+		if (pos + tapMin >= base && pos + tapMax < bufsize)
+			run = std::min(inputSize - i, (size_t)(bufsize - (pos + tapMax)));
+
+		if (run != 0) {
+			UnwrappedBuffer b(workspace, pos);
+			for (size_t end = i + run; i < end; i++) {
+				// Dividing by two here is an incorrect hack, see ProcessPreset.
+				ProcessSampleFast<simd>(b, d, input[i * 2] >> 1, input[i * 2 + 1] >> 1, &output[i * 4], volLeft, volRight, finalShift);
+				b.Next();
+			}
+			pos = b.GetPosition();
+			if (pos >= bufsize)
+				pos -= d.size;
+		} else {
+			BufferWrapper<bufsize> b(workspace, pos, d.size);
+			ProcessSampleFast<simd>(b, d, input[i * 2] >> 1, input[i * 2 + 1] >> 1, &output[i * 4], volLeft, volRight, finalShift);
+			b.Next();
+			pos = b.GetPosition();
+			i++;
+		}
+	}
+	return pos;
+}
+
+// Same output as ProcessPreset, but skips the ring buffer wrapping where it can, and uses SIMD if the preset allows.
+void SasReverb::ProcessPresetFast(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight, int finalShift) {
+	const SasReverbData &d = presets[preset_];
+	if (reflectionsIndependent_)
+		pos_ = ProcessRuns<true, BUFSIZE>(workspace_, pos_, d, tapMin_, tapMax_, output, input, inputSize, volLeft, volRight, finalShift);
+	else
+		pos_ = ProcessRuns<false, BUFSIZE>(workspace_, pos_, d, tapMin_, tapMax_, output, input, inputSize, volLeft, volRight, finalShift);
+}
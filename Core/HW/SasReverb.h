@@ -29,16 +29,27 @@ class SasReverb {
 
 	static const char *GetPresetName(int preset);
 
+	static int GetNumPresets();
+
 	// Input should be a mixdown of all the channels that have reverb enabled, at 22khz.
 	// Output is written back at 44khz.
-	void ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight);
+	// With reference, this runs the plain unoptimized code instead, for testing. The output is the same either way.
+	void ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight, bool reference = false);
 
 private:
 	enum {
 		BUFSIZE = 0x20000,
 	};
 
+	void ProcessPreset(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight, int finalShift);
+	void ProcessPresetFast(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight, int finalShift);
+
 	int16_t *workspace_;
 	int preset_;
 	int pos_;
+	// True if the four reflection filters of the preset never read what the others write, so SIMD can run them side by side.
+	bool reflectionsIndependent_ = false;
+	// Smallest and largest offset from the position that the preset touches.
+	int tapMin_ = 0;
+	int tapMax_ = 0;
 };
\ No newline at end of file
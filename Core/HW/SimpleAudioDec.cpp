@@ -18,12 +18,15 @@
 #include <algorithm>
 
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/Thread/Waitable.h"
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/HLE/FunctionWrappers.h"
 #include "Core/HW/SimpleAudioDec.h"
 #include "Core/HW/MediaEngine.h"
 #include "Core/HW/BufferQueue.h"
+#include "Core/Util/AudioFormat.h"
 
 #ifdef USE_FFMPEG
 
@@ -226,7 +229,14 @@ bool SimpleAudio::Decode(const uint8_t *inbuf, int inbytes, uint8_t *outbuf, int
 	// get bytes consumed in source
 	srcPos = len;
 
-	if (got_frame) {
+	if (got_frame && frame_->format == AV_SAMPLE_FMT_FLTP && frame_->channels == 2 && frame_->sample_rate == wanted_resample_freq && !swrCtx_) {
+		// Common case for ATRAC3+ and AAC: no resampling or remixing needed, so skip swresample and just interleave.
+		const float *left = (const float *)frame_->extended_data[0];
+		const float *right = (const float *)frame_->extended_data[1];
+		ConvertPlanarF32ToS16Stereo((s16 *)outbuf, left, right, frame_->nb_samples);
+		outSamples = frame_->nb_samples * 2;
+		*outbytes = outSamples * 2;
+	} else if (got_frame) {
 		// Initializing the sample rate convert. We will use it to convert float output into int.
 		int64_t wanted_channel_layout = AV_CH_LAYOUT_STEREO; // we want stereo output layout
 		int64_t dec_channel_layout = frame_->channel_layout; // decoded channel layout
@@ -312,27 +322,108 @@ bool IsValidCodec(int codec){
 
 // sceAu module starts from here
 
+// How many frames to keep decoded ahead of the game, for MP3 streams.
+static const size_t DECODE_AHEAD_FRAMES = 4;
+// Big enough for a 1152 sample stereo frame, even if resampled up.
+static const int DECODE_AHEAD_MAX_BYTES = 0x4000;
+
+class AuDecodeAheadTask : public Task {
+public:
+	AuDecodeAheadTask(AuCtx *ctx, LimitedWaitable *waitable) : ctx_(ctx), waitable_(waitable) {}
+
+	TaskType Type() const override {
+		return TaskType::CPU_COMPUTE;
+	}
+
+	void Run() override {
+		ctx_->DecodeAhead();
+	}
+
+	void Release() override {
+		// Also called without Run() on teardown, so always notify here.
+		waitable_->Notify();
+		delete this;
+	}
+
+private:
+	AuCtx *ctx_;
+	LimitedWaitable *waitable_;
+};
+
 AuCtx::AuCtx() {
 }
 
 AuCtx::~AuCtx() {
+	WaitDecodeAhead();
 	if (decoder) {
 		AudioClose(&decoder);
 		decoder = nullptr;
 	}
 }
 
-size_t AuCtx::FindNextMp3Sync() {
+size_t AuCtx::FindNextMp3Sync(size_t start) {
 	if (audioType != PSP_CODEC_MP3) {
-		return 0;
+		return start;
 	}
 
-	for (size_t i = 0; i < sourcebuff.size() - 2; ++i) {
+	for (size_t i = start; i + 2 < sourcebuff.size(); ++i) {
 		if ((sourcebuff[i] & 0xFF) == 0xFF && (sourcebuff[i + 1] & 0xC0) == 0xC0) {
 			return i;
 		}
 	}
-	return 0;
+	return start;
+}
+
+void AuCtx::StartDecodeAhead() {
+	// Only MP3 frames are small enough to know a whole one is buffered (see AuStreamWorkareaSize.)
+	if (audioType != PSP_CODEC_MP3 || !decoder || aheadWaitable_ || aheadFrames_.size() >= DECODE_AHEAD_FRAMES)
+		return;
+	if (sourcebuff.size() < aheadConsumed_ + AuStreamWorkareaSize())
+		return;
+
+	aheadWaitable_ = new LimitedWaitable();
+	g_threadManager.EnqueueTask(new AuDecodeAheadTask(this, aheadWaitable_));
+}
+
+void AuCtx::WaitDecodeAhead() {
+	if (aheadWaitable_) {
+		aheadWaitable_->WaitAndRelease();
+		aheadWaitable_ = nullptr;
+	}
+}
+
+void AuCtx::DiscardDecodeAhead() {
+	WaitDecodeAhead();
+	aheadFrames_.clear();
+	aheadConsumed_ = 0;
+}
+
+void AuCtx::DecodeAhead() {
+	// Decodes exactly what AuDecode would, in the same order, but only while a whole frame is
+	// buffered.  Otherwise the result could depend on data the game hasn't added yet.
+	const size_t minBytes = AuStreamWorkareaSize();
+	while (aheadFrames_.size() < DECODE_AHEAD_FRAMES) {
+		size_t start = aheadConsumed_;
+		if (sourcebuff.size() < start + minBytes)
+			break;
+		size_t nextSync = FindNextMp3Sync(start);
+		if (sourcebuff.size() - nextSync < minBytes)
+			break;
+
+		DecodedFrame frame;
+		frame.pcm.resize(DECODE_AHEAD_MAX_BYTES);
+		int outbytes = 0;
+		decoder->Decode(&sourcebuff[nextSync], (int)(sourcebuff.size() - nextSync), frame.pcm.data(), &outbytes);
+		frame.pcm.resize(outbytes);
+		frame.outSamples = decoder->GetOutSamples();
+		frame.consumed = (int)(nextSync - start) + decoder->GetSourcePos();
+
+		aheadConsumed_ += frame.consumed;
+		aheadFrames_.push_back(std::move(frame));
+		// Nothing output means the end of the stream to AuDecode, which then drops the rest.
+		if (outbytes == 0 || aheadFrames_.back().consumed <= 0)
+			break;
+	}
 }
 
 // return output pcm size, <0 error
@@ -345,20 +436,37 @@ u32 AuCtx::AuDecode(u32 pcmAddr) {
 		Memory::Write_U32(outptr, pcmAddr);
 
 	// Decode a single frame in sourcebuff and output into PCMBuf.
+	WaitDecodeAhead();
 	if (!sourcebuff.empty()) {
-		// FFmpeg doesn't seem to search for a sync for us, so let's do that.
-		int nextSync = (int)FindNextMp3Sync();
-		decoder->Decode(&sourcebuff[nextSync], (int)sourcebuff.size() - nextSync, outbuf, &outpcmbufsize);
+		int decodedSamples;
+		int srcPos;
+		if (!aheadFrames_.empty()) {
+			// Already decoded on a worker, exactly as below.
+			const DecodedFrame &frame = aheadFrames_.front();
+			outpcmbufsize = (int)frame.pcm.size();
+			if (outpcmbufsize != 0)
+				memcpy(outbuf, frame.pcm.data(), outpcmbufsize);
+			decodedSamples = frame.outSamples;
+			srcPos = frame.consumed;
+			aheadConsumed_ -= frame.consumed;
+			aheadFrames_.pop_front();
+		} else {
+			// FFmpeg doesn't seem to search for a sync for us, so let's do that.
+			int nextSync = (int)FindNextMp3Sync();
+			decoder->Decode(&sourcebuff[nextSync], (int)sourcebuff.size() - nextSync, outbuf, &outpcmbufsize);
+			decodedSamples = decoder->GetOutSamples();
+			srcPos = decoder->GetSourcePos() + nextSync;
+		}
 
 		if (outpcmbufsize == 0) {
 			// Nothing was output, hopefully we're at the end of the stream.
 			AuBufAvailable = 0;
 			sourcebuff.clear();
+			aheadFrames_.clear();
+			aheadConsumed_ = 0;
 		} else {
 			// Update our total decoded samples, but don't count stereo.
-			SumDecodedSamples += decoder->GetOutSamples() / 2;
-			// get consumed source length
-			int srcPos = decoder->GetSourcePos() + nextSync;
+			SumDecodedSamples += decodedSamples / 2;
 			// remove the consumed source
 			if (srcPos > 0)
 				sourcebuff.erase(sourcebuff.begin(), sourcebuff.begin() + srcPos);
@@ -390,6 +498,8 @@ u32 AuCtx::AuDecode(u32 pcmAddr) {
 		NotifyMemInfo(MemBlockFlags::WRITE, outptr, outpcmbufsize, "AuDecode");
 
 	nextOutputHalf ^= 1;
+	// Get the next frames ready while the game plays this one.
+	StartDecodeAhead();
 	return outpcmbufsize;
 }
 
@@ -438,6 +548,8 @@ int AuCtx::AuStreamWorkareaSize() {
 u32 AuCtx::AuNotifyAddStreamData(int size) {
 	int offset = AuStreamWorkareaSize();
 
+	// The worker reads sourcebuff, which may move when it grows.
+	WaitDecodeAhead();
 	if (askedReadSize != 0) {
 		// Old save state, numbers already adjusted.
 		int diffsize = size - askedReadSize;
@@ -497,6 +609,7 @@ u32 AuCtx::AuResetPlayPositionByFrame(int frame) {
 		readPos -= 1;
 	SumDecodedSamples = frame * MaxOutputSample;
 	AuBufAvailable = 0;
+	DiscardDecodeAhead();
 	sourcebuff.clear();
 	return 0;
 }
@@ -505,6 +618,7 @@ u32 AuCtx::AuResetPlayPosition() {
 	readPos = startPos;
 	SumDecodedSamples = 0;
 	AuBufAvailable = 0;
+	DiscardDecodeAhead();
 	sourcebuff.clear();
 	return 0;
 }
@@ -514,6 +628,12 @@ void AuCtx::DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
+	// Frames decoded ahead aren't saved, their data is still in sourcebuff.
+	if (p.mode == p.MODE_READ)
+		DiscardDecodeAhead();
+	else
+		WaitDecodeAhead();
+
 	Do(p, startPos);
 	Do(p, endPos);
 	Do(p, AuBuf);
@@ -18,6 +18,8 @@
 #pragma once
 
 #include <cmath>
+#include <deque>
+#include <vector>
 
 #include "Core/HW/MediaEngine.h"
 #include "Core/HLE/sceAudio.h"
@@ -27,6 +29,8 @@ struct AVCodec;
 struct AVCodecContext;
 struct SwrContext;
 
+class LimitedWaitable;
+
 // Wraps FFMPEG for audio decoding in a nice interface.
 // Decodes packet by packet - does NOT demux.
 
@@ -121,6 +125,7 @@ class AuCtx {
 	void DoState(PointerWrap &p);
 
 	void EatSourceBuff(int amount) {
+		DiscardDecodeAhead();
 		if (amount > (int)sourcebuff.size()) {
 			amount = (int)sourcebuff.size();
 		}
@@ -128,6 +133,11 @@ class AuCtx {
 			sourcebuff.erase(sourcebuff.begin(), sourcebuff.begin() + amount);
 		AuBufAvailable -= amount;
 	}
+
+	// Drops any frames decoded ahead.  Call before touching the decoder directly.
+	void DiscardDecodeAhead();
+	// Runs on a worker thread, see StartDecodeAhead().
+	void DecodeAhead();
 	// Au source information. Written to from for example sceAacInit so public for now.
 	u64 startPos = 0;
 	u64 endPos = 0;
@@ -154,10 +164,25 @@ class AuCtx {
 	int audioType = 0;
 
 private:
-	size_t FindNextMp3Sync();
+	size_t FindNextMp3Sync(size_t start = 0);
+
+	void StartDecodeAhead();
+	void WaitDecodeAhead();
 
 	std::vector<u8> sourcebuff; // source buffer
 
+	// Frames already decoded from the front of sourcebuff, in order.  Not save stated, since
+	// sourcebuff still holds their data and a fresh decoder just decodes them again.
+	struct DecodedFrame {
+		std::vector<u8> pcm;
+		int outSamples;
+		int consumed;  // bytes of sourcebuff, including any skipped to find the sync
+	};
+	std::deque<DecodedFrame> aheadFrames_;
+	size_t aheadConsumed_ = 0;
+	// While set, a worker owns the decoder, sourcebuff and the fields above.
+	LimitedWaitable *aheadWaitable_ = nullptr;
+
 	// buffers informations
 	int AuBufAvailable = 0; // the available buffer of AuBuf to be able to recharge data
 	int readPos; // read position in audio source file
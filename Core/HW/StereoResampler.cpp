@@ -28,11 +28,17 @@
 #define TARGET_BUFSIZE_DEFAULT 1680 // 40 ms
 #define TARGET_BUFSIZE_EXTRA 3360 // 80 ms
 
+// Adaptive (low latency) buffering, only goes as low as this.
+#define TARGET_BUFSIZE_MIN 256 // 6 ms
+#define ADAPTIVE_SHRINK_STEP 32 // samples, after each stable period
+#define ADAPTIVE_STABLE_SECONDS 1.0
+
 #define MAX_FREQ_SHIFT  600.0f  // how far off can we be from 44100 Hz
 #define CONTROL_FACTOR  0.2f // in freq_shift per fifo size offset
 #define CONTROL_AVG     32.0f
 
 #include "ppsspp_config.h"
+#include <cmath>
 #include <cstring>
 #include <atomic>
 
@@ -89,6 +95,7 @@ void StereoResampler::UpdateBufferSize() {
 	if (g_Config.bExtraAudioBuffering) {
 		m_maxBufsize = MAX_BUFSIZE_EXTRA;
 		m_targetBufsize = TARGET_BUFSIZE_EXTRA;
+		adaptiveTargetBufsize_ = 0;
 	} else {
 		m_maxBufsize = MAX_BUFSIZE_DEFAULT;
 		m_targetBufsize = TARGET_BUFSIZE_DEFAULT;
@@ -99,7 +106,44 @@ void StereoResampler::UpdateBufferSize() {
 			if (m_targetBufsize * 2 > MAX_BUFSIZE_DEFAULT)
 				m_maxBufsize = MAX_BUFSIZE_EXTRA;
 		}
+
+		if (g_Config.bLowLatencyAudio) {
+			UpdateAdaptiveBufferSize();
+		} else {
+			adaptiveTargetBufsize_ = 0;
+		}
+	}
+}
+
+// Starts at the fixed target, then slowly shrinks while there are no underruns, and grows
+// quickly again when there are.  The fixed target above is the upper limit.
+void StereoResampler::UpdateAdaptiveBufferSize() {
+	const double now = time_now_d();
+	int underruns = adaptiveUnderruns_.exchange(0);
+	// Underruns while paused, in menus, or fast-forwarding don't say anything about the device.
+	if (now - lastPushTime_ > 0.25 || PSP_CoreParameter().fastForward) {
+		underruns = 0;
+		adaptiveStableTime_ = now;
 	}
+	lastPushTime_ = now;
+
+	const int maxTarget = m_targetBufsize;
+	// We can't go below one output callback plus one push, or we'll run dry between them.
+	const int minTarget = std::min(maxTarget, std::max(TARGET_BUFSIZE_MIN, lastMixSize_.load() + lastPushSize_ + ADAPTIVE_SHRINK_STEP));
+
+	if (adaptiveTargetBufsize_ == 0) {
+		adaptiveTargetBufsize_ = maxTarget;
+		adaptiveStableTime_ = now;
+	} else if (underruns > 0) {
+		adaptiveTargetBufsize_ += std::max(adaptiveTargetBufsize_ / 4, TARGET_BUFSIZE_MIN);
+		adaptiveStableTime_ = now;
+	} else if (now - adaptiveStableTime_ >= ADAPTIVE_STABLE_SECONDS) {
+		adaptiveTargetBufsize_ -= ADAPTIVE_SHRINK_STEP;
+		adaptiveStableTime_ = now;
+	}
+
+	adaptiveTargetBufsize_ = std::max(minTarget, std::min(maxTarget, adaptiveTargetBufsize_));
+	m_targetBufsize = adaptiveTargetBufsize_;
 }
 
 template<bool useShift>
@@ -187,8 +231,9 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 
 	const int INDEX_MASK = (m_maxBufsize * 2 - 1);
 
-	// This is only for debug visualization, not used for anything.
+	// This is only for debug visualization and latency reporting.
 	lastBufSize_ = ((indexW - indexR) & INDEX_MASK) / 2;
+	lastMixSize_ = numSamples;
 
 	// Drift prevention mechanism.
 	float numLeft = (float)(((indexW - indexR) & INDEX_MASK) / 2);
@@ -213,27 +258,33 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 	output_sample_rate_ = (float)(m_input_sample_rate + offset);
 	const u32 ratio = (u32)(65536.0 * output_sample_rate_ / (double)sample_rate);
 	ratio_ = ratio;
-	// TODO: consider a higher-quality resampling algorithm.
 	// TODO: Add a fast path for 1:1.
 	u32 frac = m_frac;
-	for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
-		if (((indexW - indexR) & INDEX_MASK) <= 2) {
-			// Ran out!
-			// int missing = numSamples * 2 - currentSample;
-			// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
-			underrunCount_++;
-			break;
+	if (g_Config.bHighQualityResampling) {
+		if (sincTableRate_ != sample_rate)
+			BuildSincTable(sample_rate);
+		currentSample = MixSinc(samples, numSamples, indexR, indexW, frac, ratio);
+	} else {
+		for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
+			if (((indexW - indexR) & INDEX_MASK) <= 2) {
+				// Ran out!
+				// int missing = numSamples * 2 - currentSample;
+				// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
+				underrunCount_++;
+				adaptiveUnderruns_++;
+				break;
+			}
+			u32 indexR2 = indexR + 2; //next sample
+			s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
+			s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
+			s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
+			s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
+			samples[currentSample] = MixSingleSample(l1, l2, (u16)frac);
+			samples[currentSample + 1] = MixSingleSample(r1, r2, (u16)frac);
+			frac += ratio;
+			indexR += 2 * (frac >> 16);
+			frac &= 0xffff;
 		}
-		u32 indexR2 = indexR + 2; //next sample
-		s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
-		s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
-		s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
-		s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
-		samples[currentSample] = MixSingleSample(l1, l2, (u16)frac);
-		samples[currentSample + 1] = MixSingleSample(r1, r2, (u16)frac);
-		frac += ratio;
-		indexR += 2 * (frac >> 16);
-		frac &= 0xffff;
 	}
 	m_frac = frac;
 
@@ -256,6 +307,113 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 	return currentSample / 2;
 }
 
+void StereoResampler::BuildSincTable(int outputSampleRate) {
+	// When going down in rate, lower the cutoff too to avoid aliasing.  Leave a little room for the rolloff.
+	double cutoff = 0.9 * std::min(1.0, (double)outputSampleRate / (double)m_input_sample_rate);
+	const int center = SINC_TAPS / 2 - 1;
+
+	for (int phase = 0; phase < SINC_PHASES; ++phase) {
+		double coefs[SINC_TAPS];
+		double sum = 0.0;
+		for (int i = 0; i < SINC_TAPS; ++i) {
+			// Distance from the output position, in input frames.
+			double d = (double)(i - center) - (double)phase / SINC_PHASES;
+			double x = M_PI * cutoff * d;
+			double sinc = d == 0.0 ? 1.0 : sin(x) / x;
+			// Blackman window, reaching zero at +/- SINC_TAPS / 2.
+			double w = M_PI * d / (SINC_TAPS / 2);
+			double window = 0.42 + 0.5 * cos(w) + 0.08 * cos(2.0 * w);
+			coefs[i] = sinc * window;
+			sum += coefs[i];
+		}
+
+		// Normalize so that each phase has unity gain, putting any rounding error in the center.
+		int total = 0;
+		for (int i = 0; i < SINC_TAPS; ++i) {
+			sincTable_[phase][i] = (s16)lrint(coefs[i] * 16384.0 / sum);
+			total += sincTable_[phase][i];
+		}
+		sincTable_[phase][center] += 16384 - total;
+	}
+	sincTableRate_ = outputSampleRate;
+}
+
+unsigned int StereoResampler::MixSinc(short *samples, unsigned int numSamples, u32 &indexR, u32 indexW, u32 &frac, u32 ratio) {
+	const u32 INDEX_MASK = m_maxBufsize * 2 - 1;
+	// The taps reach this many frames behind indexR, and one more than that ahead.
+	const u32 before = SINC_TAPS / 2 - 1;
+	const u32 after = SINC_TAPS / 2;
+
+	unsigned int currentSample;
+	for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
+		if (((indexW - indexR) & INDEX_MASK) <= after * 2) {
+			// Ran out!
+			underrunCount_++;
+			adaptiveUnderruns_++;
+			break;
+		}
+
+		const s16 *coefs = sincTable_[frac >> 8];
+		const u32 start = (indexR - before * 2) & INDEX_MASK;
+		int l = 0;
+		int r = 0;
+		if (start + SINC_TAPS * 2 <= (u32)m_maxBufsize * 2) {
+			// Doesn't wrap, which is almost always.
+			const s16 *in = m_buffer + start;
+#ifdef _M_SSE
+			__m128i acc = _mm_setzero_si128();
+			for (int i = 0; i < SINC_TAPS; i += 8) {
+				__m128i c = _mm_loadu_si128((const __m128i *)(coefs + i));
+				__m128i s1 = _mm_loadu_si128((const __m128i *)(in + i * 2));
+				__m128i s2 = _mm_loadu_si128((const __m128i *)(in + i * 2 + 8));
+				// L0 R0 L1 R1 -> L0 L1 R0 R1, and coefficients c0 c1 c0 c1, so madd sums each channel.
+				s1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s1, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+				s2 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s2, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(s1, _mm_unpacklo_epi32(c, c)));
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(s2, _mm_unpackhi_epi32(c, c)));
+			}
+			// Lanes 0 and 2 are left, 1 and 3 are right.
+			acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+			l = _mm_cvtsi128_si32(acc);
+			r = _mm_cvtsi128_si32(_mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 1, 1, 1)));
+#elif PPSSPP_ARCH(ARM_NEON)
+			int32x4_t accL = vdupq_n_s32(0);
+			int32x4_t accR = vdupq_n_s32(0);
+			for (int i = 0; i < SINC_TAPS; i += 8) {
+				int16x8x2_t in2 = vld2q_s16(in + i * 2);
+				int16x8_t c = vld1q_s16(coefs + i);
+				accL = vmlal_s16(accL, vget_low_s16(in2.val[0]), vget_low_s16(c));
+				accL = vmlal_s16(accL, vget_high_s16(in2.val[0]), vget_high_s16(c));
+				accR = vmlal_s16(accR, vget_low_s16(in2.val[1]), vget_low_s16(c));
+				accR = vmlal_s16(accR, vget_high_s16(in2.val[1]), vget_high_s16(c));
+			}
+			int32x2_t sumL = vadd_s32(vget_low_s32(accL), vget_high_s32(accL));
+			int32x2_t sumR = vadd_s32(vget_low_s32(accR), vget_high_s32(accR));
+			l = vget_lane_s32(vpadd_s32(sumL, sumL), 0);
+			r = vget_lane_s32(vpadd_s32(sumR, sumR), 0);
+#else
+			for (int i = 0; i < SINC_TAPS; ++i) {
+				l += in[i * 2] * coefs[i];
+				r += in[i * 2 + 1] * coefs[i];
+			}
+#endif
+		} else {
+			for (int i = 0; i < SINC_TAPS; ++i) {
+				l += m_buffer[(start + i * 2) & INDEX_MASK] * coefs[i];
+				r += m_buffer[(start + i * 2 + 1) & INDEX_MASK] * coefs[i];
+			}
+		}
+
+		samples[currentSample] = clamp_s16((l + (1 << 13)) >> 14);
+		samples[currentSample + 1] = clamp_s16((r + (1 << 13)) >> 14);
+		frac += ratio;
+		indexR += 2 * (frac >> 16);
+		frac &= 0xffff;
+	}
+
+	return currentSample;
+}
+
 // Executes on the emulator thread, pushing sound into the buffer.
 void StereoResampler::PushSamples(const s32 *samples, unsigned int numSamples) {
 	inputSampleCount_ += numSamples;
@@ -272,6 +430,10 @@ void StereoResampler::PushSamples(const s32 *samples, unsigned int numSamples) {
 	if (PSP_CoreParameter().fastForward) {
 		cap = m_targetBufsize * 2;
 	}
+	// The sinc filter still reads a few frames behind the read position, don't overwrite them.
+	if (g_Config.bHighQualityResampling) {
+		cap -= SINC_TAPS * 2;
+	}
 
 	// Check if we have enough free space
 	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
@@ -310,7 +472,8 @@ void StereoResampler::GetAudioDebugStats(char *buf, size_t bufSize) {
 		"Effective input sample rate: %0.2f\n"
 		"Effective output sample rate: %0.2f\n"
 		"Push size: %d\n"
-		"Ratio: %0.6f\n",
+		"Ratio: %0.6f\n"
+		"Latency: %0.1f ms (target: %0.1f ms)\n",
 		lastBufSize_,
 		m_maxBufsize,
 		m_targetBufsize,
@@ -322,7 +485,9 @@ void StereoResampler::GetAudioDebugStats(char *buf, size_t bufSize) {
 		effective_input_sample_rate,
 		effective_output_sample_rate,
 		lastPushSize_,
-		(float)ratio_ / 65536.0f);
+		(float)ratio_ / 65536.0f,
+		GetLatencyMs(),
+		GetTargetLatencyMs());
 	underrunCountTotal_ += underrunCount_;
 	overrunCountTotal_ += overrunCount_;
 	underrunCount_ = 0;
@@ -334,6 +499,14 @@ void StereoResampler::GetAudioDebugStats(char *buf, size_t bufSize) {
 	// }
 }
 
+float StereoResampler::GetLatencyMs() const {
+	return lastBufSize_ * 1000.0f / (float)m_input_sample_rate;
+}
+
+float StereoResampler::GetTargetLatencyMs() const {
+	return m_targetBufsize * 1000.0f / (float)m_input_sample_rate;
+}
+
 void StereoResampler::ResetStatCounters() {
 	underrunCount_ = 0;
 	overrunCount_ = 0;
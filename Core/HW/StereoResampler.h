@@ -46,8 +46,22 @@ class StereoResampler {
 	void GetAudioDebugStats(char *buf, size_t bufSize);
 	void ResetStatCounters();
 
+	// How much audio is buffered right now, and how much we're aiming for.
+	float GetLatencyMs() const;
+	float GetTargetLatencyMs() const;
+
+	// Windowed sinc filter, in frames.  The phases are picked by the top bits of the 16-bit fraction.
+	enum {
+		SINC_TAPS = 16,
+		SINC_PHASES = 256,
+	};
+
 private:
 	void UpdateBufferSize();
+	void UpdateAdaptiveBufferSize();
+
+	void BuildSincTable(int outputSampleRate);
+	unsigned int MixSinc(short *samples, unsigned int numSamples, u32 &indexR, u32 indexW, u32 &frac, u32 ratio);
 
 	int m_maxBufsize;
 	int m_targetBufsize;
@@ -71,6 +85,17 @@ class StereoResampler {
 
 	int droppedSamples_ = 0;
 
+	// Adaptive target for bLowLatencyAudio, 0 when not yet started.
+	int adaptiveTargetBufsize_ = 0;
+	double adaptiveStableTime_ = 0.0;
+	double lastPushTime_ = 0.0;
+	std::atomic<int> adaptiveUnderruns_{};
+	std::atomic<int> lastMixSize_{};
+
+	// Coefficients in 1.14 fixed point, each phase sums to 1.0.  Only touched from Mix().
+	alignas(16) s16 sincTable_[SINC_PHASES][SINC_TAPS];
+	int sincTableRate_ = 0;
+
 	int64_t inputSampleCount_ = 0;
 	int64_t outputSampleCount_ = 0;
 
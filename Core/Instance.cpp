@@ -30,7 +30,10 @@
 #include "Common/CommonWindows.h"
 #endif
 
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
 #include "Common/Log.h"
+#include "Common/StringUtils.h"
 #include "Common/SysError.h"
 
 #include <cstdint>
@@ -115,6 +118,21 @@ int GetInstancePeerCount() {
 	return c;
 }
 
+Path GetInstanceTempPath(const Path &path) {
+	return path.WithExtraExtension(StringFromFormat(".%d.tmp", (int)PPSSPP_ID));
+}
+
+bool CommitInstanceTempFile(const Path &tempPath, const Path &path) {
+	if (File::Rename(tempPath, path))
+		return true;
+	// Windows won't rename over an existing file.
+	File::Delete(path);
+	if (File::Rename(tempPath, path))
+		return true;
+	File::Delete(tempPath);
+	return false;
+}
+
 // Get current number of instance of PPSSPP running.
 // Must be called only once during init.
 void InitInstanceCounter() {
@@ -21,12 +21,19 @@
 
 #include <cstdint>
 
+class Path;
+
 extern uint8_t PPSSPP_ID;
 
 void InitInstanceCounter();
 void ShutdownInstanceCounter();
 int GetInstancePeerCount();
 
+// Cache files can be shared by several instances running at once.  Write them to the temp path
+// first, then commit, so other instances never read a partially written file.
+Path GetInstanceTempPath(const Path &path);
+bool CommitInstanceTempFile(const Path &tempPath, const Path &path);
+
 inline bool IsFirstInstance() {
 	return PPSSPP_ID == 1;
 }
@@ -83,6 +83,12 @@ class FileLoader {
 		return ReadAt(absolutePos, 1, bytes, data, flags);
 	}
 
+	// If the data can be addressed directly (e.g. a memory mapped local file), returns a pointer
+	// that stays valid for the life of the loader.  Otherwise nullptr, so use ReadAt().
+	virtual const u8 *GetDirectPointer(s64 absolutePos, size_t bytes) {
+		return nullptr;
+	}
+
 	// Cancel any operations that might block, if possible.
 	virtual void Cancel() {}
 
@@ -129,6 +135,9 @@ class ProxiedFileLoader : public FileLoader {
 	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override {
 		return backend_->ReadAt(absolutePos, bytes, data, flags);
 	}
+	const u8 *GetDirectPointer(s64 absolutePos, size_t bytes) override {
+		return backend_->GetDirectPointer(absolutePos, bytes);
+	}
 
 protected:
 	FileLoader *backend_;
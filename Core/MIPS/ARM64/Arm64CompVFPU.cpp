@@ -611,6 +611,80 @@ namespace MIPSComp {
 		fpr.ReleaseSpillLocksAndDiscardTemps();
 	}
 
+	bool Arm64Jit::CanUseQuadNEON(VectorSize sz) {
+		// The quad paths don't handle prefixes, they'd need per-lane work anyway.
+		return sz == V_Quad && js.HasNoPrefix() && !jo.Disabled(JitDisable::SIMD);
+	}
+
+	// The quad paths below work on whole columns straight from the context with NEON, instead
+	// of mapping every lane as a single.  Per lane, they do the same operations as the scalar
+	// paths, so the results match exactly.
+	bool Arm64Jit::CompNEONQuadDo3(MIPSOpcode op, const u8 *sregs, const u8 *tregs, const u8 *dregs) {
+		int soffset = fpr.GetQuadOffsetV(sregs);
+		int toffset = fpr.GetQuadOffsetV(tregs);
+		int doffset = fpr.GetQuadOffsetV(dregs);
+		if (soffset < 0 || toffset < 0 || doffset < 0)
+			return false;
+
+		int opnum = ((op >> 26) == 25 ? 8 : 0) | ((op >> 23) & 7);
+		if ((op >> 26) != 24 && (op >> 26) != 25)
+			return false;
+		if (opnum != 0 && opnum != 1 && opnum != 7 && opnum != 8)
+			return false;
+
+		fpr.FlushQuadV(sregs);
+		fpr.FlushQuadV(tregs);
+		fpr.DiscardQuadV(dregs);
+		fp.LDR(128, INDEX_UNSIGNED, Q0, CTXREG, soffset);
+		fp.LDR(128, INDEX_UNSIGNED, Q1, CTXREG, toffset);
+		switch (opnum) {
+		case 0: fp.FADD(32, Q0, Q0, Q1); break;  // vadd
+		case 1: fp.FSUB(32, Q0, Q0, Q1); break;  // vsub
+		case 7: fp.FDIV(32, Q0, Q0, Q1); break;  // vdiv
+		case 8: fp.FMUL(32, Q0, Q0, Q1); break;  // vmul
+		}
+		fp.STR(128, INDEX_UNSIGNED, Q0, CTXREG, doffset);
+		return true;
+	}
+
+	bool Arm64Jit::CompNEONQuadV2Op(MIPSOpcode op, const u8 *sregs, const u8 *dregs) {
+		int soffset = fpr.GetQuadOffsetV(sregs);
+		int doffset = fpr.GetQuadOffsetV(dregs);
+		if (soffset < 0 || doffset < 0)
+			return false;
+
+		int opnum = (op >> 16) & 0x1f;
+		if (opnum > 2)
+			return false;
+
+		fpr.FlushQuadV(sregs);
+		fpr.DiscardQuadV(dregs);
+		fp.LDR(128, INDEX_UNSIGNED, Q0, CTXREG, soffset);
+		switch (opnum) {
+		case 0: break;  // vmov
+		case 1: fp.FABS(32, Q0, Q0); break;  // vabs
+		case 2: fp.FNEG(32, Q0, Q0); break;  // vneg
+		}
+		fp.STR(128, INDEX_UNSIGNED, Q0, CTXREG, doffset);
+		return true;
+	}
+
+	bool Arm64Jit::CompNEONQuadScl(const u8 *sregs, u8 treg, const u8 *dregs) {
+		int soffset = fpr.GetQuadOffsetV(sregs);
+		int doffset = fpr.GetQuadOffsetV(dregs);
+		if (soffset < 0 || doffset < 0)
+			return false;
+
+		// Grab the scale first, it may be one of the lanes we're about to overwrite.
+		fpr.LoadToRegV(S1, treg);
+		fpr.FlushQuadV(sregs);
+		fpr.DiscardQuadV(dregs);
+		fp.LDR(128, INDEX_UNSIGNED, Q0, CTXREG, soffset);
+		fp.FMUL(32, Q0, Q0, Q1, 0);
+		fp.STR(128, INDEX_UNSIGNED, Q0, CTXREG, doffset);
+		return true;
+	}
+
 	void Arm64Jit::Comp_VecDo3(MIPSOpcode op) {
 		CONDITIONAL_DISABLE(VFPU_VEC);
 		if (js.HasUnknownPrefix()) {
@@ -629,6 +703,11 @@ namespace MIPSComp {
 		GetVectorRegsPrefixT(tregs, sz, _VT);
 		GetVectorRegsPrefixD(dregs, sz, _VD);
 
+		if (CanUseQuadNEON(sz) && CompNEONQuadDo3(op, sregs, tregs, dregs)) {
+			fpr.ReleaseSpillLocksAndDiscardTemps();
+			return;
+		}
+
 		MIPSReg tempregs[4];
 		for (int i = 0; i < n; i++) {
 			if (!IsOverlapSafe(dregs[i], i, n, sregs, n, tregs)) {
@@ -803,6 +882,11 @@ namespace MIPSComp {
 		GetVectorRegsPrefixS(sregs, sz, _VS);
 		GetVectorRegsPrefixD(dregs, sz, _VD);
 
+		if (CanUseQuadNEON(sz) && CompNEONQuadV2Op(op, sregs, dregs)) {
+			fpr.ReleaseSpillLocksAndDiscardTemps();
+			return;
+		}
+
 		MIPSReg tempregs[4];
 		for (int i = 0; i < n; ++i) {
 			if (!IsOverlapSafe(dregs[i], i, n, sregs)) {
@@ -1180,6 +1264,11 @@ namespace MIPSComp {
 		GetVectorRegsPrefixT(&treg, V_Single, _VT);
 		GetVectorRegsPrefixD(dregs, sz, _VD);
 
+		if (CanUseQuadNEON(sz) && CompNEONQuadScl(sregs, treg, dregs)) {
+			fpr.ReleaseSpillLocksAndDiscardTemps();
+			return;
+		}
+
 		// Move to S0 early, so we don't have to worry about overlap with scale.
 		fpr.LoadToRegV(S0, treg);
 
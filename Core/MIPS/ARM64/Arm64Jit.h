@@ -234,6 +234,10 @@ class Arm64Jit : public Arm64Gen::ARM64CodeBlock, public JitInterface, public MI
 	void CompShiftImm(MIPSOpcode op, Arm64Gen::ShiftType shiftType, int sa);
 	void CompShiftVar(MIPSOpcode op, Arm64Gen::ShiftType shiftType);
 	void CompVrotShuffle(u8 *dregs, int imm, VectorSize sz, bool negSin);
+	bool CanUseQuadNEON(VectorSize sz);
+	bool CompNEONQuadDo3(MIPSOpcode op, const u8 *sregs, const u8 *tregs, const u8 *dregs);
+	bool CompNEONQuadV2Op(MIPSOpcode op, const u8 *sregs, const u8 *dregs);
+	bool CompNEONQuadScl(const u8 *sregs, u8 treg, const u8 *dregs);
 
 	void ApplyPrefixST(u8 *vregs, u32 prefix, VectorSize sz);
 	void ApplyPrefixD(const u8 *vregs, VectorSize sz);
@@ -483,6 +483,27 @@ int Arm64RegCacheFPU::GetTempR() {
 	return -1;
 }
 
+int Arm64RegCacheFPU::GetQuadOffsetV(const u8 *v) {
+	for (int i = 0; i < 4; i++) {
+		if (v[i] >= 128 || voffset[v[i]] != voffset[v[0]] + i)
+			return -1;
+	}
+	int offset = GetMipsRegOffsetV(v[0]);
+	return (offset & 15) == 0 ? offset : -1;
+}
+
+void Arm64RegCacheFPU::FlushQuadV(const u8 *v) {
+	for (int i = 0; i < 4; i++) {
+		FlushV(v[i]);
+	}
+}
+
+void Arm64RegCacheFPU::DiscardQuadV(const u8 *v) {
+	for (int i = 0; i < 4; i++) {
+		DiscardR(v[i] + 32);
+	}
+}
+
 int Arm64RegCacheFPU::GetMipsRegOffset(MIPSReg r) {
 	// These are offsets within the MIPSState structure. First there are the GPRS, then FPRS, then the "VFPURs", then the VFPU ctrls.
 	if (r < 0 || r > 32 + 128 + NUM_TEMPS) {
@@ -141,6 +141,14 @@ class Arm64RegCacheFPU {
 	void SpillLockV(const u8 *v, VectorSize vsz);
 	void SpillLockV(int vec, VectorSize vsz);
 
+	// For NEON ops on a whole quad in the context.  Returns -1 unless the four regs are
+	// consecutive and 16-byte aligned there, otherwise the offset to use with CTXREG.
+	int GetQuadOffsetV(const u8 *v);
+	// Writes back any cached lanes of the quad, so it can be loaded as a whole.
+	void FlushQuadV(const u8 *v);
+	// Forgets any cached lanes of the quad, since it's about to be overwritten in memory.
+	void DiscardQuadV(const u8 *v);
+
 	void SetEmitter(Arm64Gen::ARM64XEmitter *emitter, Arm64Gen::ARM64FloatEmitter *fp) { emit_ = emitter; fp_ = fp; }
 
 	int GetMipsRegOffset(MIPSReg r);
@@ -54,6 +54,48 @@ using namespace MIPSAnalyst;
 namespace MIPSComp
 {
 
+// Traces only go forward, so the block is still a single range for hashing and invalidation.
+static const u32 MAX_TRACE_SPAN = 0x1000;
+
+bool IRFrontend::CanContinueTrace(u32 targetAddr) {
+	if (!opts.traces || js.numInstructions >= opts.traceMaxInstructions)
+		return false;
+	if (targetAddr <= GetCompilerPC() + 4 || targetAddr - js.blockStart > MAX_TRACE_SPAN)
+		return false;
+	return Memory::IsValidAddress(targetAddr);
+}
+
+// Call after the delay slot (unless likely) and downcount are written, and everything is flushed.
+// Writes a guarded exit for the unlikely path and returns true if compilation continues on the other.
+bool IRFrontend::ContinueBranch(IRComparison cc, u32 notTakenAddr, u32 targetAddr, int lhs, int rhs, bool likely) {
+	// Same prediction as the x86 jit: forward and likely branches are taken.
+	bool predictTaken = likely || targetAddr > GetCompilerPC();
+	if (predictTaken) {
+		if (!CanContinueTrace(targetAddr))
+			return false;
+		ir.Write(ComparisonToExit(cc), ir.AddConstant(notTakenAddr), lhs, rhs);
+		if (likely)
+			CompileDelaySlot();
+		// Account for the increment in the loop.
+		js.compilerPC = targetAddr - 4;
+	} else {
+		if (likely || !CanContinueTrace(notTakenAddr))
+			return false;
+		ir.Write(ComparisonToExit(Invert(cc)), ir.AddConstant(targetAddr), lhs, rhs);
+		// Skip the delay slot, it's already compiled.
+		js.compilerPC += 4;
+	}
+	// In case the delay slot was a break or something.
+	js.compiling = true;
+	return true;
+}
+
+bool IRFrontend::IsIdleBranch(u32 targetAddr) {
+	if (!g_Config.bSkipIdleLoops || targetAddr > GetCompilerPC())
+		return false;
+	return MIPSAnalyst::IsIdleLoop(targetAddr, GetCompilerPC());
+}
+
 void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 	if (js.inDelaySlot) {
 		ERROR_LOG_REPORT(JIT, "Branch in RSRTComp delay slot at %08x in block starting at %08x", GetCompilerPC(), js.blockStart);
@@ -63,6 +105,7 @@ void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 	MIPSGPReg rt = _RT;
 	MIPSGPReg rs = _RS;
 	u32 targetAddr = GetCompilerPC() + offset + 4;
+	bool idleLoop = IsIdleBranch(targetAddr);
 
 	MIPSOpcode delaySlotOp = GetOffsetInstruction(1);
 	js.downcountAmount += MIPSGetInstructionCycleEstimate(delaySlotOp);
@@ -99,12 +142,17 @@ void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 	js.downcountAmount = 0;
 
 	FlushAll();
+	// An idle loop needs its own taken exit, so don't continue past it.
+	if (!idleLoop && ContinueBranch(cc, GetCompilerPC() + 8, targetAddr, lhs, rhs, likely))
+		return;
 	ir.Write(ComparisonToExit(cc), ir.AddConstant(GetCompilerPC() + 8), lhs, rhs);
 	// This makes the block "impure" :(
 	if (likely)
 		CompileDelaySlot();
 
 	FlushAll();
+	if (idleLoop)
+		ir.Write(IROp::IdleLoop);
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -120,6 +168,7 @@ void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink,
 	int offset = TARGET16;
 	MIPSGPReg rs = _RS;
 	u32 targetAddr = GetCompilerPC() + offset + 4;
+	bool idleLoop = IsIdleBranch(targetAddr);
 
 	MIPSOpcode delaySlotOp = GetOffsetInstruction(1);
 	js.downcountAmount += MIPSGetInstructionCycleEstimate(delaySlotOp);
@@ -141,11 +190,15 @@ void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink,
 	js.downcountAmount = 0;
 
 	FlushAll();
+	if (!idleLoop && ContinueBranch(cc, GetCompilerPC() + 8, targetAddr, lhs, 0, likely))
+		return;
 	ir.Write(ComparisonToExit(cc), ir.AddConstant(GetCompilerPC() + 8), lhs);
 	if (likely)
 		CompileDelaySlot();
 	// Taken
 	FlushAll();
+	if (idleLoop)
+		ir.Write(IROp::IdleLoop);
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -208,6 +261,8 @@ void IRFrontend::BranchFPFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 	js.downcountAmount = 0;
 
 	FlushAll();
+	if (ContinueBranch(cc, GetCompilerPC() + 8, targetAddr, IRTEMP_LHS, 0, likely))
+		return;
 	// Not taken
 	ir.Write(ComparisonToExit(cc), ir.AddConstant(GetCompilerPC() + 8), IRTEMP_LHS, 0);
 	// Taken
@@ -266,6 +321,9 @@ void IRFrontend::BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 
 	ir.Write(IROp::AndConst, IRTEMP_LHS, IRTEMP_LHS, ir.AddConstant(1 << imm3));
 	FlushAll();
+	// The branch in a delay slot case is too odd to trace through.
+	if (!delaySlotIsBranch && ContinueBranch(cc, notTakenTarget, targetAddr, IRTEMP_LHS, 0, likely))
+		return;
 	ir.Write(ComparisonToExit(cc), ir.AddConstant(notTakenTarget), IRTEMP_LHS, 0);
 
 	if (likely)
@@ -324,6 +382,15 @@ void IRFrontend::Comp_Jump(MIPSOpcode op) {
 		break;
 	}
 
+	// No exit needed, the downcount just keeps accumulating.
+	if (CanContinueTrace(targetAddr)) {
+		// Account for the increment in the loop.
+		js.compilerPC = targetAddr - 4;
+		// In case the delay slot was a break or something.
+		js.compiling = true;
+		return;
+	}
+
 	int dcAmount = js.downcountAmount;
 	ir.Write(IROp::Downcount, 0, ir.AddConstant(dcAmount));
 	js.downcountAmount = 0;
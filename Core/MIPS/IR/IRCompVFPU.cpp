@@ -1312,9 +1312,19 @@ namespace MIPSComp {
 				}
 				return;
 			} else {
-				// ABc - s consecutive, t not.
-				// Tekken uses this.
-				// logBlocks = 1;
+				// ABc - s consecutive, t not.  Tekken uses this.
+				// Gather each column of T so we can still use dots.
+				int t0 = IRVTEMP_PFX_S;
+				for (int j = 0; j < 4; j++) {
+					for (int i = 0; i < 4; i++) {
+						ir.Write(IROp::FMov, t0 + i, tregs[j * 4 + i]);
+					}
+					for (int i = 0; i < 4; i++) {
+						ir.Write(IROp::Vec4Dot, s0 + i, sregs[i * 4], t0);
+					}
+					ir.Write(IROp::Vec4Mov, dregs[j * 4], s0);
+				}
+				return;
 			}
 		}
 
@@ -1390,20 +1400,21 @@ namespace MIPSComp {
 			}
 			return;
 		} else if (msz == M_4x4 && IsConsecutive4(sregs)) {
-			// Consecutive, which is harder.
-			DISABLE;
+			// Consecutive, so each row of S is a vector and this is just four dots with T.
 			int s0 = IRVTEMP_0;
-			int s1 = IRVTEMP_PFX_S;
-			// Doesn't make complete sense to me why this works.... (because it doesn't.)
-			ir.Write(IROp::Vec4Scale, s0, sregs[0], tregs[0]);
-			for (int i = 1; i < 4; i++) {
-				if (!homogenous || (i != n - 1)) {
-					ir.Write(IROp::Vec4Scale, s1, sregs[i], tregs[i]);
-					ir.Write(IROp::Vec4Add, s0, s0, s1);
-				} else {
-					ir.Write(IROp::Vec4Add, s0, s0, sregs[i]);
+			int t0 = tregs[0];
+			if (homogenous || !IsConsecutive4(tregs)) {
+				t0 = IRVTEMP_PFX_S;
+				for (int i = 0; i < 4; i++) {
+					if (homogenous && i == n - 1)
+						ir.Write(IROp::SetConstF, t0 + i, ir.AddConstantFloat(1.0f));
+					else
+						ir.Write(IROp::FMov, t0 + i, tregs[i]);
 				}
 			}
+			for (int i = 0; i < 4; i++) {
+				ir.Write(IROp::Vec4Dot, s0 + i, sregs[i * 4], t0);
+			}
 			if (IsConsecutive4(dregs)) {
 				ir.Write(IROp::Vec4Mov, dregs[0], s0);
 			} else {
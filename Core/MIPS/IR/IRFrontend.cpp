@@ -221,7 +221,7 @@ MIPSOpcode IRFrontend::GetOffsetInstruction(int offset) {
 	return Memory::Read_Instruction(GetCompilerPC() + 4 * offset);
 }
 
-void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload) {
+void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload, std::vector<int> *passCounts) {
 	js.cancel = false;
 	js.preloading = preload;
 	js.blockStart = em_address;
@@ -255,6 +255,10 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	}
 
 	mipsBytes = js.compilerPC - em_address;
+	if (passCounts) {
+		passCounts->clear();
+		passCounts->push_back((int)ir.GetInstructions().size());
+	}
 
 	IRWriter simplified;
 	IRWriter *code = &ir;
@@ -264,11 +268,12 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 			&OptimizeFPMoves,
 			&PropagateConstants,
 			&PurgeTemps,
+			&EliminateDeadCode,
 			// &ReorderLoadStore,
 			// &MergeLoadStore,
 			// &ThreeOpToTwoOp,
 		};
-		if (IRApplyPasses(passes, ARRAY_SIZE(passes), ir, simplified, opts))
+		if (IRApplyPasses(passes, ARRAY_SIZE(passes), ir, simplified, opts, passCounts))
 			logBlocks = 1;
 		code = &simplified;
 		//if (ir.GetInstructions().size() >= 24)
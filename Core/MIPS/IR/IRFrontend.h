@@ -88,7 +88,8 @@ class IRFrontend : public MIPSFrontendInterface {
 	void DoState(PointerWrap &p);
 	bool CheckRounding(u32 blockAddress);  // returns true if we need a do-over
 
-	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	// If passCounts is set, it gets the instruction count before and after each optimization pass.
+	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload, std::vector<int> *passCounts = nullptr);
 
 	void EatPrefix() override {
 		js.EatPrefix();
@@ -97,6 +98,12 @@ class IRFrontend : public MIPSFrontendInterface {
 	void SetOptions(const IROptions &o) {
 		opts = o;
 	}
+	// Copies the state that affects the generated code, for a second frontend on another thread.
+	void CopyState(const IRFrontend &other) {
+		js.startDefaultPrefix = other.js.startDefaultPrefix;
+		js.hasSetRounding = other.js.hasSetRounding;
+		js.lastSetRounding = other.js.lastSetRounding;
+	}
 
 private:
 	void RestoreRoundingMode(bool force = false);
@@ -115,6 +122,9 @@ class IRFrontend : public MIPSFrontendInterface {
 	void CheckMemoryBreakpoint(int rs, int offset);
 
 	// Utility compilation functions
+	bool CanContinueTrace(u32 targetAddr);
+	bool ContinueBranch(IRComparison cc, u32 notTakenAddr, u32 targetAddr, int lhs, int rhs, bool likely);
+	bool IsIdleBranch(u32 targetAddr);
 	void BranchFPFlag(MIPSOpcode op, IRComparison cc, bool likely);
 	void BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely);
 	void BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink, bool likely);
@@ -160,12 +160,21 @@ static const IRMeta irMeta[] = {
 	{ IROp::SetPC, "SetPC", "_G" },
 	{ IROp::SetPCConst, "SetPC", "_C" },
 	{ IROp::CallReplacement, "CallRepl", "_C" },
+	{ IROp::IdleLoop, "IdleLoop", "" },
 	{ IROp::Breakpoint, "Breakpoint", "", IRFLAG_EXIT },
 	{ IROp::MemoryCheck, "MemoryCheck", "_GC", IRFLAG_EXIT },
 
 	{ IROp::RestoreRoundingMode, "RestoreRoundingMode", "" },
 	{ IROp::ApplyRoundingMode, "ApplyRoundingMode", "" },
 	{ IROp::UpdateRoundingMode, "UpdateRoundingMode", "" },
+
+	{ IROp::DowncountExit, "DowncountExit", "_C" },
+	{ IROp::DowncountExitIfEq, "DowncountExitIfEq", "_C" },
+	{ IROp::DowncountExitIfNeq, "DowncountExitIfNeq", "_C" },
+	{ IROp::SetConstPair, "SetConstPair", "GC" },
+	{ IROp::Load32Pair, "Load32Pair", "GGC" },
+	{ IROp::Store32Pair, "Store32Pair", "GGC", IRFLAG_SRC3 },
+	{ IROp::AddConstLoad32, "AddConstLoad32", "GGC" },
 };
 
 const IRMeta *metaIndex[256];
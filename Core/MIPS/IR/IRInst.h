@@ -212,9 +212,21 @@ enum class IROp : u8 {
 	SetPC,  // hack to make syscall returns work
 	SetPCConst,  // hack to make replacement know PC
 	CallReplacement,
+	IdleLoop,  // Skips ahead to the next event, emitted before looping back.
 	Break,
 	Breakpoint,
 	MemoryCheck,
+
+	// Interpreter-only superinstructions, see IRFuseForInterpreter().  Each one replaces
+	// the op of the first of a pair, and runs both.  The second instruction is left as is.
+	// Never emitted by the frontend, so other backends don't need to handle them.
+	DowncountExit,
+	DowncountExitIfEq,
+	DowncountExitIfNeq,
+	SetConstPair,
+	Load32Pair,
+	Store32Pair,
+	AddConstLoad32,
 };
 
 enum IRComparison {
@@ -238,7 +250,6 @@ enum class Vec4Init {
 	Set_0001,
 };
 
-// Hm, unused
 inline IRComparison Invert(IRComparison comp) {
 	switch (comp) {
 	case IRComparison::Equal: return IRComparison::NotEqual;
@@ -371,6 +382,9 @@ class IRWriter {
 struct IROptions {
 	uint32_t disableFlags;
 	bool unalignedLoadStore;
+	// Follow predicted branches and jumps within a block, with guarded exits for the other paths.
+	bool traces;
+	int traceMaxInstructions;
 };
 
 const IRMeta *GetIRMeta(IROp op);
@@ -79,6 +79,49 @@ u32 RunMemCheck(u32 pc, u32 addr) {
 	return coreState != CORE_RUNNING ? 1 : 0;
 }
 
+static IROp FusedOp(const IRInst &first, const IRInst &second) {
+	switch (first.op) {
+	case IROp::Downcount:
+		switch (second.op) {
+		case IROp::ExitToConst: return IROp::DowncountExit;
+		case IROp::ExitToConstIfEq: return IROp::DowncountExitIfEq;
+		case IROp::ExitToConstIfNeq: return IROp::DowncountExitIfNeq;
+		default: break;
+		}
+		break;
+	case IROp::SetConst:
+		if (second.op == IROp::SetConst)
+			return IROp::SetConstPair;
+		break;
+	case IROp::Load32:
+		if (second.op == IROp::Load32)
+			return IROp::Load32Pair;
+		break;
+	case IROp::Store32:
+		if (second.op == IROp::Store32)
+			return IROp::Store32Pair;
+		break;
+	case IROp::AddConst:
+		if (second.op == IROp::Load32)
+			return IROp::AddConstLoad32;
+		break;
+	default:
+		break;
+	}
+	return IROp::Nop;
+}
+
+void IRFuseForInterpreter(IRInst *inst, int count) {
+	for (int i = 0; i + 1 < count; ++i) {
+		IROp fused = FusedOp(inst[i], inst[i + 1]);
+		if (fused != IROp::Nop) {
+			inst[i].op = fused;
+			// The second one is consumed by the pair, don't start another pair on it.
+			++i;
+		}
+	}
+}
+
 // We cannot use NEON on ARM32 here until we make it a hard dependency. We can, however, on ARM64.
 u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 	const IRInst *end = inst + count;
@@ -217,6 +260,8 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			u32 base = mips->r[inst->src1] + inst->constant;
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_load_ps((const float *)Memory::GetPointerUnchecked(base)));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32(&mips->f[inst->dest], vld1q_f32((const float *)Memory::GetPointerUnchecked(base)));
 #else
 			for (int i = 0; i < 4; i++)
 				mips->f[inst->dest + i] = Memory::ReadUnchecked_Float(base + 4 * i);
@@ -228,6 +273,8 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			u32 base = mips->r[inst->src1] + inst->constant;
 #if defined(_M_SSE)
 			_mm_store_ps((float *)Memory::GetPointerUnchecked(base), _mm_load_ps(&mips->f[inst->dest]));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32((float *)Memory::GetPointerUnchecked(base), vld1q_f32(&mips->f[inst->dest]));
 #else
 			for (int i = 0; i < 4; i++)
 				Memory::WriteUnchecked_Float(mips->f[inst->dest + i], base + 4 * i);
@@ -309,6 +356,8 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_div_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps(&mips->f[inst->src2])));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32(&mips->f[inst->dest], vdivq_f32(vld1q_f32(&mips->f[inst->src1]), vld1q_f32(&mips->f[inst->src2])));
 #else
 			for (int i = 0; i < 4; i++)
 				mips->f[inst->dest + i] = mips->f[inst->src1 + i] / mips->f[inst->src2 + i];
@@ -320,6 +369,8 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_mul_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_set1_ps(mips->f[inst->src2])));
+#elif PPSSPP_ARCH(ARM64_NEON)
+			vst1q_f32(&mips->f[inst->dest], vmulq_n_f32(vld1q_f32(&mips->f[inst->src1]), mips->f[inst->src2]));
 #else
 			for (int i = 0; i < 4; i++)
 				mips->f[inst->dest + i] = mips->f[inst->src1 + i] * mips->f[inst->src2];
@@ -512,10 +563,25 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 		// Not quickly implementable on all platforms, unfortunately.
 		case IROp::Vec4Dot:
 		{
+			// Keep the order of the additions the same as the scalar path, so all backends agree.
+#if defined(_M_SSE)
+			__m128 mul = _mm_mul_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps(&mips->f[inst->src2]));
+			__m128 dot = _mm_add_ss(mul, _mm_shuffle_ps(mul, mul, _MM_SHUFFLE(1, 1, 1, 1)));
+			dot = _mm_add_ss(dot, _mm_shuffle_ps(mul, mul, _MM_SHUFFLE(2, 2, 2, 2)));
+			dot = _mm_add_ss(dot, _mm_shuffle_ps(mul, mul, _MM_SHUFFLE(3, 3, 3, 3)));
+			_mm_store_ss(&mips->f[inst->dest], dot);
+#elif PPSSPP_ARCH(ARM64_NEON)
+			float32x4_t mul = vmulq_f32(vld1q_f32(&mips->f[inst->src1]), vld1q_f32(&mips->f[inst->src2]));
+			float dot = vgetq_lane_f32(mul, 0) + vgetq_lane_f32(mul, 1);
+			dot += vgetq_lane_f32(mul, 2);
+			dot += vgetq_lane_f32(mul, 3);
+			mips->f[inst->dest] = dot;
+#else
 			float dot = mips->f[inst->src1] * mips->f[inst->src2];
 			for (int i = 1; i < 4; i++)
 				dot += mips->f[inst->src1 + i] * mips->f[inst->src2 + i];
 			mips->f[inst->dest] = dot;
+#endif
 			break;
 		}
 
@@ -953,6 +1019,10 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
+		case IROp::IdleLoop:
+			CoreTiming::Idle();
+			break;
+
 		case IROp::Break:
 			Core_Break();
 			return mips->pc + 4;
@@ -993,6 +1063,43 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			// TODO: Implement
 			break;
 
+		// Superinstructions from IRFuseForInterpreter().  These run inst[0] and inst[1].
+		case IROp::DowncountExit:
+			mips->downcount -= inst->constant;
+			return inst[1].constant;
+		case IROp::DowncountExitIfEq:
+			mips->downcount -= inst->constant;
+			if (mips->r[inst[1].src1] == mips->r[inst[1].src2])
+				return inst[1].constant;
+			inst++;
+			break;
+		case IROp::DowncountExitIfNeq:
+			mips->downcount -= inst->constant;
+			if (mips->r[inst[1].src1] != mips->r[inst[1].src2])
+				return inst[1].constant;
+			inst++;
+			break;
+		case IROp::SetConstPair:
+			mips->r[inst->dest] = inst->constant;
+			mips->r[inst[1].dest] = inst[1].constant;
+			inst++;
+			break;
+		case IROp::Load32Pair:
+			mips->r[inst->dest] = Memory::ReadUnchecked_U32(mips->r[inst->src1] + inst->constant);
+			mips->r[inst[1].dest] = Memory::ReadUnchecked_U32(mips->r[inst[1].src1] + inst[1].constant);
+			inst++;
+			break;
+		case IROp::Store32Pair:
+			Memory::WriteUnchecked_U32(mips->r[inst->src3], mips->r[inst->src1] + inst->constant);
+			Memory::WriteUnchecked_U32(mips->r[inst[1].src3], mips->r[inst[1].src1] + inst[1].constant);
+			inst++;
+			break;
+		case IROp::AddConstLoad32:
+			mips->r[inst->dest] = mips->r[inst->src1] + inst->constant;
+			mips->r[inst[1].dest] = Memory::ReadUnchecked_U32(mips->r[inst[1].src1] + inst[1].constant);
+			inst++;
+			break;
+
 		default:
 			// Unimplemented IR op. Bad.
 			Crash();
@@ -21,3 +21,5 @@ inline static u32 ReverseBits32(u32 v) {
 }
 
 u32 IRInterpret(MIPSState *ms, const IRInst *inst, int count);
+// Rewrites common instruction pairs into superinstructions, in place.  Only IRInterpret() understands the result.
+void IRFuseForInterpreter(IRInst *inst, int count);
@@ -15,14 +15,19 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <set>
 
 #include "ext/xxhash.h"
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/Log.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
 
 #include "Core/Config.h"
 #include "Core/Core.h"
@@ -42,7 +47,7 @@
 
 namespace MIPSComp {
 
-IRJit::IRJit(MIPSState *mipsState) : frontend_(mipsState->HasDefaultPrefix()), mips_(mipsState) {
+IRJit::IRJit(MIPSState *mipsState) : frontend_(mipsState->HasDefaultPrefix()), mips_(mipsState), bgFrontend_(mipsState->HasDefaultPrefix()) {
 	// u32 size = 128 * 1024;
 	// blTrampolines_ = kernelMemory.Alloc(size, true, "trampoline");
 	InitIR();
@@ -50,13 +55,19 @@ IRJit::IRJit(MIPSState *mipsState) : frontend_(mipsState->HasDefaultPrefix()), m
 	IROptions opts{};
 	opts.disableFlags = g_Config.uJitDisableFlags;
 	opts.unalignedLoadStore = (opts.disableFlags & (uint32_t)JitDisable::LSU_UNALIGNED) == 0;
+	opts.traces = (opts.disableFlags & (uint32_t)JitDisable::IR_TRACES) == 0;
+	opts.traceMaxInstructions = jo.continueMaxInstructions;
 	frontend_.SetOptions(opts);
+	bgFrontend_.SetOptions(opts);
 }
 
 IRJit::~IRJit() {
+	StopBackgroundCompiles();
 }
 
 void IRJit::DoState(PointerWrap &p) {
+	// The worker copies frontend state when it starts, so don't let it run with the old state.
+	StopBackgroundCompiles();
 	frontend_.DoState(p);
 }
 
@@ -65,18 +76,34 @@ void IRJit::UpdateFCR31() {
 
 void IRJit::ClearCache() {
 	INFO_LOG(JIT, "IRJit: Clearing the cache!");
+	StopBackgroundCompiles();
+	std::lock_guard<std::recursive_mutex> guard(blocksLock_);
 	blocks_.Clear();
+	hasCachedBlocks_ = false;
 }
 
 void IRJit::InvalidateCacheAt(u32 em_address, int length) {
-	blocks_.InvalidateICache(em_address, length);
+	{
+		std::lock_guard<std::recursive_mutex> guard(blocksLock_);
+		blocks_.InvalidateICache(em_address, length);
+	}
+
+	std::lock_guard<std::mutex> guard(bgLock_);
+	if (bgRunning_) {
+		// Whatever the worker is compiling may have read the old code.
+		bgGeneration_++;
+	}
 }
 
 void IRJit::Compile(u32 em_address) {
 	PROFILE_THIS_SCOPE("jitc");
 
-	if (g_Config.bPreloadFunctions) {
+	if (bgHasResults_)
+		InstallBackgroundBlocks();
+
+	if (g_Config.bPreloadFunctions || hasCachedBlocks_) {
 		// Look to see if we've preloaded this block.
+		std::lock_guard<std::recursive_mutex> guard(blocksLock_);
 		int block_num = blocks_.FindPreloadBlock(em_address);
 		if (block_num != -1) {
 			IRBlock *b = blocks_.GetBlock(block_num);
@@ -103,16 +130,22 @@ void IRJit::Compile(u32 em_address) {
 		ClearCache();
 		CompileBlock(em_address, instructions, mipsBytes, false);
 	}
+
+	// Get ahead of where this block goes, so those are just an install.
+	if (g_Config.bBackgroundJit)
+		QueueBlockExits(em_address, mipsBytes, instructions);
 }
 
 bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload) {
-	frontend_.DoJit(em_address, instructions, mipsBytes, preload);
+	std::vector<int> passCounts;
+	frontend_.DoJit(em_address, instructions, mipsBytes, preload, &passCounts);
 	if (instructions.empty()) {
 		_dbg_assert_(preload);
 		// We return true when preloading so it doesn't abort.
 		return preload;
 	}
 
+	std::lock_guard<std::recursive_mutex> guard(blocksLock_);
 	int block_num = blocks_.AllocateBlock(em_address);
 	if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
 		// Out of block numbers.  Caller will handle.
@@ -122,13 +155,22 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 	IRBlock *b = blocks_.GetBlock(block_num);
 	b->SetInstructions(instructions);
 	b->SetOriginalSize(mipsBytes);
+	blocks_.GetCompileLog()->RecordIRBlock(em_address, mipsBytes, passCounts);
+	if (!CompileNativeBlock(b, block_num, preload)) {
+		// Out of native code space.  Caller will handle, it's just like running out of numbers.
+		return false;
+	}
+
 	if (preload) {
 		// Hash, then only update page stats, don't link yet.
 		b->UpdateHash();
 		blocks_.FinalizeBlock(block_num, true);
 	} else {
-		// Overwrites the first instruction, and also updates stats.
+		// Only needed for the disk cache, hash before the emuhack goes in.
 		// TODO: Should we always hash?  Then we can reuse blocks.
+		if (g_Config.bJitBlockCache)
+			b->UpdateHash();
+		// Overwrites the first instruction, and also updates stats.
 		blocks_.FinalizeBlock(block_num);
 	}
 
@@ -138,6 +180,11 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 void IRJit::CompileFunction(u32 start_address, u32 length) {
 	PROFILE_THIS_SCOPE("jitc");
 
+	if (g_Config.bBackgroundJit && g_threadManager.IsInitialized()) {
+		QueueBackgroundCompile(start_address, length);
+		return;
+	}
+
 	// Note: we don't actually write emuhacks yet, so we can validate hashes.
 	// This way, if the game changes the code afterward, we'll catch even without icache invalidation.
 
@@ -227,14 +274,21 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 			if (opcode == MIPS_EMUHACK_OPCODE) {
 				u32 data = inst & 0xFFFFFF;
 				IRBlock *block = blocks_.GetBlock(data);
-				mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+				int startDowncount = mips_->downcount;
+				mips_->pc = IRInterpret(mips_, block->GetInterpretInstructions(), block->GetNumInstructions());
+				if (profiling_) {
+					// The block may be gone if it ran a syscall that cleared the cache.
+					block = blocks_.GetBlock(data);
+					if (block)
+						block->AddProfileSample(startDowncount - mips_->downcount);
+				}
 				if (!Memory::IsValidAddress(mips_->pc)) {
 					Core_ExecException(mips_->pc, mips_->pc, ExecExceptionType::JUMP);
 					break;
 				}
 			} else {
 				// RestoreRoundingMode(true);
-				Compile(mips_->pc);
+				JitAt();
 				// ApplyRoundingMode(true);
 			}
 		}
@@ -243,6 +297,360 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 	// RestoreRoundingMode(true);
 }
 
+#define IR_BLOCK_CACHE_MAGIC 0x43424952
+// Bump whenever IR ops, the frontend, or the passes change what they generate.
+#define IR_BLOCK_CACHE_VERSION 1
+
+struct IRBlockCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t disableFlags;
+	uint32_t instSize;
+	uint32_t numBlocks;
+};
+
+struct IRBlockCacheEntry {
+	uint32_t origAddr;
+	uint32_t origSize;
+	uint64_t hash;
+	uint32_t numInstructions;
+	uint32_t reserved;
+};
+
+void IRJit::LoadBlockCache(const Path &filename) {
+	FILE *f = File::OpenCFile(filename, "rb");
+	if (!f)
+		return;
+
+	IRBlockCacheHeader header;
+	if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != IR_BLOCK_CACHE_MAGIC || header.version != IR_BLOCK_CACHE_VERSION) {
+		fclose(f);
+		return;
+	}
+	// The IR depends on the disable flags, so a cache made with others is useless.
+	if (header.disableFlags != g_Config.uJitDisableFlags || header.instSize != sizeof(IRInst)) {
+		INFO_LOG(JIT, "Ignoring IR block cache made with different settings");
+		fclose(f);
+		return;
+	}
+
+	double st = time_now_d();
+	int loaded = 0;
+	int stale = 0;
+	std::vector<IRInst> instructions;
+	for (uint32_t i = 0; i < header.numBlocks; ++i) {
+		IRBlockCacheEntry entry;
+		if (fread(&entry, sizeof(entry), 1, f) != 1)
+			break;
+		if (entry.numInstructions == 0 || entry.origSize == 0 || entry.numInstructions > 0xFFFF || (entry.origSize & 3) != 0 || (entry.origSize >> 2) > 0xFFFF) {
+			ERROR_LOG(JIT, "Corrupt IR block cache entry, aborting");
+			break;
+		}
+		instructions.resize(entry.numInstructions);
+		if (fread(&instructions[0], sizeof(IRInst), entry.numInstructions, f) != entry.numInstructions)
+			break;
+
+		if (!Memory::IsValidRange(entry.origAddr, entry.origSize) || MIPS_IS_RUNBLOCK(Memory::ReadUnchecked_U32(entry.origAddr))) {
+			stale++;
+			continue;
+		}
+
+		// Check against what's in memory now, before spending a block number on it.
+		IRBlock check(entry.origAddr);
+		check.SetOriginalSize(entry.origSize);
+		check.SetHash(entry.hash);
+		if (!check.HashMatches()) {
+			stale++;
+			continue;
+		}
+
+		if (!InstallPrecompiledBlock(entry.origAddr, entry.origSize, entry.hash, instructions))
+			break;
+		loaded++;
+	}
+	fclose(f);
+
+	hasCachedBlocks_ = hasCachedBlocks_ || loaded != 0;
+	double et = time_now_d();
+	NOTICE_LOG(JIT, "Loaded %d cached IR blocks (%d stale) in %0.2f milliseconds", loaded, stale, (et - st) * 1000.0);
+}
+
+void IRJit::SaveBlockCache(const Path &filename) {
+	std::vector<int> toSave;
+	for (int i = 0; i < blocks_.GetNumBlocks(); ++i) {
+		IRBlock *b = blocks_.GetBlock(i);
+		u32 start, size;
+		b->GetRange(start, size);
+		// Destroyed blocks have no address, and without a hash we can't validate them.
+		if (start != 0 && b->GetHash() != 0)
+			toSave.push_back(i);
+	}
+	if (toSave.empty())
+		return;
+
+	INFO_LOG(JIT, "Saving %d IR blocks to '%s'", (int)toSave.size(), filename.c_str());
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f)
+		return;
+
+	IRBlockCacheHeader header;
+	header.magic = IR_BLOCK_CACHE_MAGIC;
+	header.version = IR_BLOCK_CACHE_VERSION;
+	header.disableFlags = g_Config.uJitDisableFlags;
+	header.instSize = sizeof(IRInst);
+	header.numBlocks = (uint32_t)toSave.size();
+	fwrite(&header, sizeof(header), 1, f);
+
+	for (int i : toSave) {
+		IRBlock *b = blocks_.GetBlock(i);
+		IRBlockCacheEntry entry{};
+		b->GetRange(entry.origAddr, entry.origSize);
+		entry.hash = b->GetHash();
+		entry.numInstructions = b->GetNumInstructions();
+		fwrite(&entry, sizeof(entry), 1, f);
+		fwrite(b->GetInstructions(), sizeof(IRInst), entry.numInstructions, f);
+	}
+	fclose(f);
+}
+
+bool IRJit::InstallPrecompiledBlock(u32 em_address, u32 mipsBytes, u64 hash, const std::vector<IRInst> &instructions) {
+	std::lock_guard<std::recursive_mutex> guard(blocksLock_);
+	int block_num = blocks_.AllocateBlock(em_address);
+	if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0)
+		return false;
+
+	IRBlock *b = blocks_.GetBlock(block_num);
+	b->SetInstructions(instructions);
+	b->SetOriginalSize(mipsBytes);
+	b->SetHash(hash);
+	if (!CompileNativeBlock(b, block_num, true))
+		return false;
+	// Just like preloading, don't write the emuhack until it's actually reached.
+	blocks_.FinalizeBlock(block_num, true);
+	return true;
+}
+
+// Keeps a worker from holding a pool thread forever, it requeues itself after this many.
+static const int BACKGROUND_REQUESTS_PER_TASK = 64;
+// Past this we're just guessing further ahead than the game will get any time soon.
+static const size_t MAX_BACKGROUND_QUEUE = 0x4000;
+
+class IRCompileTask : public Task {
+public:
+	IRCompileTask(IRJit *jit) : jit_(jit) {}
+
+	TaskType Type() const override {
+		return TaskType::CPU_BACKGROUND;
+	}
+
+	void Run() override {
+		jit_->RunBackgroundCompiles();
+	}
+
+private:
+	IRJit *jit_;
+};
+
+void IRJit::QueueBackgroundCompile(u32 start, u32 length) {
+	if (!Memory::IsValidAddress(start) || MIPS_IS_RUNBLOCK(Memory::ReadUnchecked_U32(start)))
+		return;
+
+	std::lock_guard<std::mutex> guard(bgLock_);
+	if (bgQueue_.size() >= MAX_BACKGROUND_QUEUE)
+		return;
+	bgQueue_.push_back({ start, length });
+
+	if (!bgRunning_) {
+		// Safe, the worker isn't running, and we're on the emu thread.
+		bgFrontend_.CopyState(frontend_);
+		bgRunning_ = true;
+		g_threadManager.EnqueueTask(new IRCompileTask(this));
+	}
+}
+
+void IRJit::QueueBlockExits(u32 em_address, u32 mipsBytes, const std::vector<IRInst> &instructions) {
+	if (!g_threadManager.IsInitialized())
+		return;
+
+	for (const IRInst &inst : instructions) {
+		switch (inst.op) {
+		case IROp::ExitToConst:
+		case IROp::ExitToConstIfEq:
+		case IROp::ExitToConstIfNeq:
+		case IROp::ExitToConstIfGtZ:
+		case IROp::ExitToConstIfGeZ:
+		case IROp::ExitToConstIfLtZ:
+		case IROp::ExitToConstIfLeZ:
+		case IROp::ExitToConstIfFpTrue:
+		case IROp::ExitToConstIfFpFalse:
+			QueueBackgroundCompile(inst.constant, 0);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// Likely a jal, so the return will be needed soon.
+	QueueBackgroundCompile(em_address + mipsBytes, 0);
+}
+
+void IRJit::RunBackgroundCompiles() {
+	// Only one worker runs at a time, it owns bgFrontend_ while bgRunning_ is set.
+	std::set<u32> done;
+	std::unique_lock<std::mutex> guard(bgLock_);
+	for (int i = 0; i < BACKGROUND_REQUESTS_PER_TASK && !bgQueue_.empty() && !bgStop_; ++i) {
+		BackgroundRequest req = bgQueue_.front();
+		bgQueue_.pop_front();
+		int generation = bgGeneration_;
+		guard.unlock();
+
+		std::vector<BackgroundResult> results;
+		CompileBackgroundRequest(req, done, results);
+
+		guard.lock();
+		if (generation == bgGeneration_ && !results.empty()) {
+			for (BackgroundResult &result : results)
+				bgResults_.push_back(std::move(result));
+			bgHasResults_ = true;
+		}
+	}
+
+	if (!bgQueue_.empty() && !bgStop_) {
+		g_threadManager.EnqueueTask(new IRCompileTask(this));
+	} else {
+		bgRunning_ = false;
+		bgIdle_.notify_all();
+	}
+}
+
+void IRJit::CompileBackgroundRequest(const BackgroundRequest &req, std::set<u32> &done, std::vector<BackgroundResult> &results) {
+	// Same walk as CompileFunction(), see there.
+	std::vector<u32> pendingAddresses;
+	pendingAddresses.push_back(req.start);
+	while (!pendingAddresses.empty() && !bgStop_) {
+		u32 em_address = pendingAddresses.back();
+		pendingAddresses.pop_back();
+
+		if (!Memory::IsValidAddress(em_address) || done.find(em_address) != done.end())
+			continue;
+		if (MIPS_IS_RUNBLOCK(Memory::ReadUnchecked_U32(em_address)))
+			continue;
+		done.insert(em_address);
+
+		BackgroundResult result;
+		result.em_address = em_address;
+		bgFrontend_.DoJit(em_address, result.instructions, result.mipsBytes, true);
+		if (result.instructions.empty())
+			continue;
+		if (bgFrontend_.CheckRounding(em_address)) {
+			// This one was compiled with the wrong assumptions.  Later ones will be safe, but the
+			// emu thread has to find out on its own when it gets here.
+			continue;
+		}
+
+		IRBlock check(em_address);
+		check.SetOriginalSize(result.mipsBytes);
+		check.UpdateHash();
+		result.hash = check.GetHash();
+
+		for (const IRInst &inst : result.instructions) {
+			u32 exit = 0;
+			switch (inst.op) {
+			case IROp::ExitToConst:
+			case IROp::ExitToConstIfEq:
+			case IROp::ExitToConstIfNeq:
+			case IROp::ExitToConstIfGtZ:
+			case IROp::ExitToConstIfGeZ:
+			case IROp::ExitToConstIfLtZ:
+			case IROp::ExitToConstIfLeZ:
+			case IROp::ExitToConstIfFpTrue:
+			case IROp::ExitToConstIfFpFalse:
+				exit = inst.constant;
+				break;
+
+			default:
+				break;
+			}
+
+			if (exit != 0 && exit >= req.start && exit < req.start + req.length)
+				pendingAddresses.push_back(exit);
+		}
+
+		if (em_address + result.mipsBytes < req.start + req.length)
+			pendingAddresses.push_back(em_address + result.mipsBytes);
+
+		results.push_back(std::move(result));
+	}
+}
+
+void IRJit::InstallBackgroundBlocks() {
+	std::vector<BackgroundResult> results;
+	{
+		std::lock_guard<std::mutex> guard(bgLock_);
+		results.swap(bgResults_);
+		bgHasResults_ = false;
+	}
+
+	int installed = 0;
+	for (const BackgroundResult &result : results) {
+		// We might've gotten there first, or the game may have changed the code since.
+		if (MIPS_IS_RUNBLOCK(Memory::ReadUnchecked_U32(result.em_address)))
+			continue;
+		IRBlock check(result.em_address);
+		check.SetOriginalSize(result.mipsBytes);
+		check.SetHash(result.hash);
+		if (!check.HashMatches())
+			continue;
+
+		// If we're out of numbers, Compile() will find out and clear right after this.
+		if (!InstallPrecompiledBlock(result.em_address, result.mipsBytes, result.hash, result.instructions))
+			break;
+		installed++;
+	}
+
+	if (installed != 0)
+		hasCachedBlocks_ = true;
+}
+
+void IRJit::StopBackgroundCompiles() {
+	std::unique_lock<std::mutex> guard(bgLock_);
+	bgQueue_.clear();
+	bgResults_.clear();
+	bgHasResults_ = false;
+	bgGeneration_++;
+
+	bgStop_ = true;
+	bgIdle_.wait(guard, [&] { return !bgRunning_; });
+	bgStop_ = false;
+}
+
+bool IRJit::SetBlockProfiling(bool enable) {
+	if (enable && !profiling_) {
+		for (int i = 0; i < blocks_.GetNumBlocks(); ++i)
+			blocks_.GetBlock(i)->ResetProfile();
+	}
+	profiling_ = enable;
+	return true;
+}
+
+void IRJit::GetBlockProfile(std::vector<JitBlockProfile> &profile) const {
+	profile.clear();
+	for (int i = 0; i < blocks_.GetNumBlocks(); ++i) {
+		const IRBlock *b = blocks_.GetBlock(i);
+		if (b->GetProfileEntries() == 0)
+			continue;
+		JitBlockProfile entry;
+		b->GetRange(entry.address, entry.size);
+		// Invalidated, so we don't know where it was anymore.
+		if (entry.address == 0)
+			continue;
+		entry.entries = b->GetProfileEntries();
+		entry.cycles = b->GetProfileCycles();
+		profile.push_back(entry);
+	}
+}
+
 bool IRJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
 	// Used in target disassembly viewer.
 	return false;
@@ -267,27 +675,59 @@ void IRBlockCache::Clear() {
 	}
 	blocks_.clear();
 	byPage_.clear();
+	numInvalidations_ = 0;
+	numInvalidationChecks_ = 0;
+	numInvalidatedBlocks_ = 0;
 }
 
 void IRBlockCache::InvalidateICache(u32 address, u32 length) {
 	u32 startPage = AddressToPage(address);
 	u32 endPage = AddressToPage(address + length);
+	numInvalidations_++;
 
 	for (u32 page = startPage; page <= endPage; ++page) {
 		const auto iter = byPage_.find(page);
 		if (iter == byPage_.end())
 			continue;
 
-		const std::vector<int> &blocksInPage = iter->second;
+		// Removing destroyed blocks from their pages as we go, so work on a copy.
+		const std::vector<int> blocksInPage = iter->second;
 		for (int i : blocksInPage) {
+			numInvalidationChecks_++;
 			if (blocks_[i].OverlapsRange(address, length)) {
-				// Not removing from the page, hopefully doesn't build up with small recompiles.
+				u32 startAddr, size;
+				blocks_[i].GetRange(startAddr, size);
+				compileLog_.RecordInvalidation(startAddr);
+				RemoveFromPages(i);
 				blocks_[i].Destroy(i);
+				numInvalidatedBlocks_++;
 			}
 		}
 	}
 }
 
+void IRBlockCache::RemoveFromPages(int i) {
+	u32 startAddr, size;
+	blocks_[i].GetRange(startAddr, size);
+
+	u32 startPage = AddressToPage(startAddr);
+	u32 endPage = AddressToPage(startAddr + size);
+	for (u32 page = startPage; page <= endPage; ++page) {
+		auto iter = byPage_.find(page);
+		if (iter == byPage_.end())
+			continue;
+
+		std::vector<int> &blocksInPage = iter->second;
+		auto found = std::find(blocksInPage.begin(), blocksInPage.end(), i);
+		if (found != blocksInPage.end()) {
+			*found = blocksInPage.back();
+			blocksInPage.pop_back();
+		}
+		if (blocksInPage.empty())
+			byPage_.erase(iter);
+	}
+}
+
 void IRBlockCache::FinalizeBlock(int i, bool preload) {
 	if (!preload) {
 		blocks_[i].Finalize(i);
@@ -412,6 +852,9 @@ void IRBlockCache::ComputeStats(BlockCacheStats &bcStats) const {
 	bcStats.minBloat = minBloat;
 	bcStats.maxBloat = maxBloat;
 	bcStats.avgBloat = totalBloat / (double)blocks_.size();
+	bcStats.numInvalidations = numInvalidations_;
+	bcStats.numInvalidationChecks = numInvalidationChecks_;
+	bcStats.numInvalidatedBlocks = numInvalidatedBlocks_;
 }
 
 int IRBlockCache::GetBlockNumberFromStartAddress(u32 em_address, bool realBlocksOnly) const {
@@ -436,6 +879,17 @@ int IRBlockCache::GetBlockNumberFromStartAddress(u32 em_address, bool realBlocks
 	return best;
 }
 
+void IRBlock::SetInstructions(const std::vector<IRInst> &inst) {
+	instr_ = new IRInst[inst.size()];
+	interpInstr_ = new IRInst[inst.size()];
+	numInstructions_ = (u16)inst.size();
+	if (!inst.empty()) {
+		memcpy(instr_, &inst[0], sizeof(IRInst) * inst.size());
+		memcpy(interpInstr_, &inst[0], sizeof(IRInst) * inst.size());
+		IRFuseForInterpreter(interpInstr_, numInstructions_);
+	}
+}
+
 bool IRBlock::HasOriginalFirstOp() const {
 	return Memory::ReadUnchecked_U32(origAddr_) == origFirstOpcode_.encoding;
 }
@@ -495,6 +949,7 @@ bool IRBlock::OverlapsRange(u32 addr, u32 size) const {
 }
 
 MIPSOpcode IRJit::GetOriginalOp(MIPSOpcode op) {
+	std::lock_guard<std::recursive_mutex> guard(blocksLock_);
 	IRBlock *b = blocks_.GetBlock(op.encoding & 0xFFFFFF);
 	if (b) {
 		return b->GetOriginalFirstOp();
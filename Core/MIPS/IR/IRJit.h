@@ -17,7 +17,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <set>
 #include <unordered_map>
 
 #include "Common/CommonTypes.h"
@@ -38,31 +43,33 @@ namespace MIPSComp {
 // TODO : Use arena allocators. For now let's just malloc.
 class IRBlock {
 public:
-	IRBlock() : instr_(nullptr), numInstructions_(0), origAddr_(0), origSize_(0) {}
-	IRBlock(u32 emAddr) : instr_(nullptr), numInstructions_(0), origAddr_(emAddr), origSize_(0) {}
+	IRBlock() : instr_(nullptr), interpInstr_(nullptr), numInstructions_(0), origAddr_(0), origSize_(0) {}
+	IRBlock(u32 emAddr) : instr_(nullptr), interpInstr_(nullptr), numInstructions_(0), origAddr_(emAddr), origSize_(0) {}
 	IRBlock(IRBlock &&b) {
 		instr_ = b.instr_;
+		interpInstr_ = b.interpInstr_;
 		numInstructions_ = b.numInstructions_;
 		origAddr_ = b.origAddr_;
 		origSize_ = b.origSize_;
 		origFirstOpcode_ = b.origFirstOpcode_;
 		hash_ = b.hash_;
+		targetOffset_ = b.targetOffset_;
+		profileEntries_ = b.profileEntries_;
+		profileCycles_ = b.profileCycles_;
 		b.instr_ = nullptr;
+		b.interpInstr_ = nullptr;
 	}
 
 	~IRBlock() {
 		delete[] instr_;
+		delete[] interpInstr_;
 	}
 
-	void SetInstructions(const std::vector<IRInst> &inst) {
-		instr_ = new IRInst[inst.size()];
-		numInstructions_ = (u16)inst.size();
-		if (!inst.empty()) {
-			memcpy(instr_, &inst[0], sizeof(IRInst) * inst.size());
-		}
-	}
+	void SetInstructions(const std::vector<IRInst> &inst);
 
 	const IRInst *GetInstructions() const { return instr_; }
+	// Same instructions with interpreter-only superinstructions fused in.  Only for IRInterpret().
+	const IRInst *GetInterpretInstructions() const { return interpInstr_; }
 	int GetNumInstructions() const { return numInstructions_; }
 	MIPSOpcode GetOriginalFirstOp() const { return origFirstOpcode_; }
 	bool HasOriginalFirstOp() const;
@@ -77,6 +84,12 @@ class IRBlock {
 	bool HashMatches() const {
 		return origAddr_ && hash_ == CalculateHash();
 	}
+	u64 GetHash() const {
+		return hash_;
+	}
+	void SetHash(u64 hash) {
+		hash_ = hash;
+	}
 	bool OverlapsRange(u32 addr, u32 size) const;
 
 	void GetRange(u32 &start, u32 &size) const {
@@ -84,18 +97,41 @@ class IRBlock {
 		size = origSize_;
 	}
 
+	// Offset into the native backend's code space, or -1 if only interpreted.
+	void SetTargetOffset(int offset) {
+		targetOffset_ = offset;
+	}
+	int GetTargetOffset() const {
+		return targetOffset_;
+	}
+
 	void Finalize(int number);
 	void Destroy(int number);
 
+	void AddProfileSample(int cycles) {
+		profileEntries_++;
+		profileCycles_ += cycles;
+	}
+	void ResetProfile() {
+		profileEntries_ = 0;
+		profileCycles_ = 0;
+	}
+	u64 GetProfileEntries() const { return profileEntries_; }
+	u64 GetProfileCycles() const { return profileCycles_; }
+
 private:
 	u64 CalculateHash() const;
 
 	IRInst *instr_;
+	IRInst *interpInstr_;
 	u16 numInstructions_;
 	u32 origAddr_;
 	u32 origSize_;
 	u64 hash_ = 0;
+	int targetOffset_ = -1;
 	MIPSOpcode origFirstOpcode_ = MIPSOpcode(0x68FFFFFF);
+	u64 profileEntries_ = 0;
+	u64 profileCycles_ = 0;
 };
 
 class IRBlockCache : public JitBlockCacheDebugInterface {
@@ -116,6 +152,13 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 			return nullptr;
 		}
 	}
+	const IRBlock *GetBlock(int i) const {
+		if (i >= 0 && i < (int)blocks_.size()) {
+			return &blocks_[i];
+		} else {
+			return nullptr;
+		}
+	}
 
 	int FindPreloadBlock(u32 em_address);
 
@@ -125,12 +168,19 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 	JitBlockDebugInfo GetBlockDebugInfo(int blockNum) const override;
 	void ComputeStats(BlockCacheStats &bcStats) const override;
 	int GetBlockNumberFromStartAddress(u32 em_address, bool realBlocksOnly = true) const override;
+	JitBlockCompileLog *GetCompileLog() override { return &compileLog_; }
 
 private:
 	u32 AddressToPage(u32 addr) const;
+	void RemoveFromPages(int i);
 
 	std::vector<IRBlock> blocks_;
 	std::unordered_map<u32, std::vector<int>> byPage_;
+
+	u32 numInvalidations_ = 0;
+	u32 numInvalidationChecks_ = 0;
+	u32 numInvalidatedBlocks_ = 0;
+	JitBlockCompileLog compileLog_;
 };
 
 class IRJit : public JitInterface {
@@ -170,16 +220,73 @@ class IRJit : public JitInterface {
 	void LinkBlock(u8 *exitPoint, const u8 *checkedEntry) override;
 	void UnlinkBlock(u8 *checkedEntry, u32 originalAddress) override;
 
-private:
+	void LoadBlockCache(const Path &filename) override;
+	void SaveBlockCache(const Path &filename) override;
+
+	bool SetBlockProfiling(bool enable) override;
+	bool IsBlockProfiling() const override { return profiling_; }
+	void GetBlockProfile(std::vector<JitBlockProfile> &profile) const override;
+
+protected:
 	bool CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	// Called after the IR for a block is generated, before it's finalized.  Native backends
+	// translate the IR here.  Returning false means out of space, and the cache is cleared.
+	virtual bool CompileNativeBlock(IRBlock *block, int block_num, bool preload) {
+		return true;
+	}
+
 	bool ReplaceJalTo(u32 dest);
 
+	// Installs already generated IR as a preload block.  Returns false when out of numbers or space.
+	bool InstallPrecompiledBlock(u32 em_address, u32 mipsBytes, u64 hash, const std::vector<IRInst> &instructions);
+
 	JitOptions jo;
 
 	IRFrontend frontend_;
 	IRBlockCache blocks_;
 
 	MIPSState *mips_;
+	// Set when blocks were loaded from disk, so Compile() looks for them even without preloading.
+	bool hasCachedBlocks_ = false;
+	bool profiling_ = false;
+
+private:
+	friend class IRCompileTask;
+
+	// Background compilation.  The worker only runs a separate frontend over memory, the resulting
+	// IR is installed as preload blocks on the emu thread, so blocks_ is never modified off-thread.
+	struct BackgroundRequest {
+		u32 start;
+		// Exits within [start, start + length) are followed, 0 compiles just one block.
+		u32 length;
+	};
+	struct BackgroundResult {
+		u32 em_address;
+		u32 mipsBytes;
+		u64 hash;
+		std::vector<IRInst> instructions;
+	};
+
+	void QueueBackgroundCompile(u32 start, u32 length);
+	void QueueBlockExits(u32 em_address, u32 mipsBytes, const std::vector<IRInst> &instructions);
+	void RunBackgroundCompiles();
+	void CompileBackgroundRequest(const BackgroundRequest &req, std::set<u32> &done, std::vector<BackgroundResult> &results);
+	void InstallBackgroundBlocks();
+	// Drops anything queued or finished, and waits for the worker to go idle.
+	void StopBackgroundCompiles();
+
+	IRFrontend bgFrontend_;
+	std::mutex bgLock_;
+	std::condition_variable bgIdle_;
+	std::deque<BackgroundRequest> bgQueue_;
+	std::vector<BackgroundResult> bgResults_;
+	bool bgRunning_ = false;
+	// Bumped on invalidation, so anything compiled from the old memory is thrown away.
+	int bgGeneration_ = 0;
+	std::atomic<bool> bgHasResults_{ false };
+	std::atomic<bool> bgStop_{ false };
+	// Only the emu thread modifies blocks_, but the worker reads first ops through GetOriginalOp().
+	std::recursive_mutex blocksLock_;
 
 	// where to write branch-likely trampolines. not used atm
 	// u32 blTrampolines_;
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <bitset>
 #include <cstring>
 #include <utility>
 
@@ -83,9 +84,12 @@ IROp ShiftToShiftImm(IROp op) {
 	}
 }
 
-bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWriter &out, const IROptions &opts) {
+bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWriter &out, const IROptions &opts, std::vector<int> *counts) {
 	if (c == 1) {
-		return passes[0](in, out, opts);
+		bool logBlocks = passes[0](in, out, opts);
+		if (counts)
+			counts->push_back((int)out.GetInstructions().size());
+		return logBlocks;
 	}
 
 	bool logBlocks = false;
@@ -97,6 +101,8 @@ bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWri
 		if (passes[i](*nextIn, *nextOut, opts)) {
 			logBlocks = true;
 		}
+		if (counts)
+			counts->push_back((int)nextOut->GetInstructions().size());
 
 		temp[0] = std::move(temp[1]);
 		nextIn = &temp[0];
@@ -105,6 +111,8 @@ bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWri
 	if (passes[c - 1](*nextIn, out, opts)) {
 		logBlocks = true;
 	}
+	if (counts)
+		counts->push_back((int)out.GetInstructions().size());
 
 	return logBlocks;
 }
@@ -960,6 +968,186 @@ bool PurgeTemps(const IRWriter &in, IRWriter &out, const IROptions &opts) {
 	return logBlocks;
 }
 
+// Liveness is tracked by MIPSState word offset from r[0], so GPR n is n and FPR n is n + 32.
+// This way aliased accesses (like the VFPU ctrl regs or lo/hi) naturally line up.
+typedef std::bitset<256 + 32> IRLiveRegs;
+
+static void AddRegs(IRLiveRegs &regs, char type, int reg) {
+	switch (type) {
+	case 'G': regs.set(reg); break;
+	case 'T': regs.set(IRREG_VFPU_CTRL_BASE + reg); break;
+	case 'F': regs.set(32 + reg); break;
+	case '2': regs.set(32 + reg); regs.set(32 + reg + 1); break;
+	case 'V':
+		for (int i = 0; i < 4; ++i)
+			regs.set(32 + reg + i);
+		break;
+	default: break;
+	}
+}
+
+enum class IRLiveness {
+	// Only reads and writes regs, can be removed if none of the writes are live.
+	PURE,
+	// Has other effects (memory, pc, downcount...) so must be kept.
+	EFFECT,
+	// Exit, or something that can see all the state (like Interpret.)
+	ALL,
+};
+
+static IRLiveness GetRegUsage(const IRInst &inst, IRLiveRegs &reads, IRLiveRegs &writes) {
+	const IRMeta *m = GetIRMeta(inst.op);
+	if (m->flags & IRFLAG_SRC3) {
+		AddRegs(reads, m->types[0], inst.src3);
+	} else {
+		AddRegs(writes, m->types[0], inst.dest);
+		if (m->flags & IRFLAG_SRC3DST)
+			AddRegs(reads, m->types[0], inst.dest);
+	}
+	AddRegs(reads, m->types[1], inst.src1);
+	AddRegs(reads, m->types[2], inst.src2);
+
+	switch (inst.op) {
+	case IROp::Nop:
+		return IRLiveness::PURE;
+
+	case IROp::Vec2Pack32To16:
+	case IROp::Vec2Pack31To16:
+		// The meta says "2V", but it's actually a single dest from a pair.
+		reads.reset();
+		writes.reset();
+		AddRegs(writes, 'F', inst.dest);
+		AddRegs(reads, '2', inst.src1);
+		return IRLiveness::PURE;
+
+	case IROp::Mult:
+	case IROp::MultU:
+	case IROp::Div:
+	case IROp::DivU:
+		writes.set(IRREG_LO);
+		writes.set(IRREG_HI);
+		return IRLiveness::PURE;
+
+	case IROp::Madd:
+	case IROp::MaddU:
+	case IROp::Msub:
+	case IROp::MsubU:
+		reads.set(IRREG_LO);
+		reads.set(IRREG_HI);
+		writes.set(IRREG_LO);
+		writes.set(IRREG_HI);
+		return IRLiveness::PURE;
+
+	case IROp::MtLo: writes.set(IRREG_LO); return IRLiveness::PURE;
+	case IROp::MtHi: writes.set(IRREG_HI); return IRLiveness::PURE;
+	case IROp::MfLo: reads.set(IRREG_LO); return IRLiveness::PURE;
+	case IROp::MfHi: reads.set(IRREG_HI); return IRLiveness::PURE;
+
+	case IROp::FCmp:
+	case IROp::ZeroFpCond:
+		writes.set(IRREG_FPCOND);
+		return IRLiveness::PURE;
+	case IROp::FpCondToReg:
+		reads.set(IRREG_FPCOND);
+		return IRLiveness::PURE;
+	case IROp::FCvtWS:
+		reads.set(IRREG_FCR31);
+		return IRLiveness::PURE;
+
+	case IROp::VfpuCtrlToReg:
+		reads.reset();
+		reads.set(IRREG_VFPU_CTRL_BASE + inst.src1);
+		return IRLiveness::PURE;
+	case IROp::FCmovVfpuCC:
+		// Conditional, so the old value may survive.
+		reads.reset();
+		AddRegs(reads, 'F', inst.src1);
+		AddRegs(reads, 'F', inst.dest);
+		reads.set(IRREG_VFPU_CC);
+		return IRLiveness::PURE;
+	case IROp::FCmpVfpuBit:
+	case IROp::FCmpVfpuAggregate:
+		// Only modifies some bits.
+		reads.set(IRREG_VFPU_CC);
+		writes.set(IRREG_VFPU_CC);
+		return IRLiveness::PURE;
+
+	case IROp::RestoreRoundingMode:
+	case IROp::ApplyRoundingMode:
+	case IROp::UpdateRoundingMode:
+		reads.set(IRREG_FCR31);
+		return IRLiveness::EFFECT;
+
+	case IROp::Downcount:
+	case IROp::IdleLoop:
+	case IROp::SetPC:
+	case IROp::SetPCConst:
+		return IRLiveness::EFFECT;
+
+	case IROp::Interpret:
+	case IROp::CallReplacement:
+	case IROp::Syscall:
+	case IROp::Break:
+	case IROp::Breakpoint:
+	case IROp::MemoryCheck:
+		return IRLiveness::ALL;
+
+	default:
+		break;
+	}
+
+	if (m->flags & IRFLAG_EXIT)
+		return IRLiveness::ALL;
+	if (m->flags & IRFLAG_SRC3)
+		return IRLiveness::EFFECT;
+	// Ops we don't know all the outputs of are kept, to be safe.
+	if (writes.none())
+		return IRLiveness::EFFECT;
+	return IRLiveness::PURE;
+}
+
+static IRLiveRegs LiveAtExit() {
+	IRLiveRegs live;
+	live.set();
+	// Temps never persist between blocks.
+	for (int r = IRTEMP_0; r <= IRTEMP_LR_SHIFT; ++r)
+		live.reset(r);
+	for (int r = IRVTEMP_PFX_S; r < IRVTEMP_0 + 4; ++r)
+		live.reset(32 + r);
+	// The zero reg is never really written.
+	live.reset(MIPS_REG_ZERO);
+	return live;
+}
+
+bool EliminateDeadCode(const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	CONDITIONAL_DISABLE;
+	const std::vector<IRInst> &insts = in.GetInstructions();
+	const IRLiveRegs exitLive = LiveAtExit();
+
+	// Walk backward, keeping track of what's read before being overwritten.
+	std::vector<bool> keep(insts.size(), true);
+	IRLiveRegs live = exitLive;
+	for (int i = (int)insts.size() - 1; i >= 0; --i) {
+		IRLiveRegs reads, writes;
+		IRLiveness usage = GetRegUsage(insts[i], reads, writes);
+		if (usage == IRLiveness::PURE && (writes & live).none()) {
+			keep[i] = false;
+			continue;
+		}
+
+		live &= ~writes;
+		live |= reads;
+		if (usage == IRLiveness::ALL)
+			live |= exitLive;
+	}
+
+	for (size_t i = 0; i < insts.size(); ++i) {
+		if (keep[i])
+			out.Write(insts[i]);
+	}
+	return false;
+}
+
 bool ReduceLoads(const IRWriter &in, IRWriter &out, const IROptions &opts) {
 	CONDITIONAL_DISABLE;
 	// This tells us to skip an AND op that has been optimized out.
@@ -3,12 +3,14 @@
 #include "Core/MIPS/IR/IRInst.h"
 
 typedef bool (*IRPassFunc)(const IRWriter &in, IRWriter &out, const IROptions &opts);
-bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWriter &out, const IROptions &opts);
+// If counts is set, the instruction count after each pass is appended to it.
+bool IRApplyPasses(const IRPassFunc *passes, size_t c, const IRWriter &in, IRWriter &out, const IROptions &opts, std::vector<int> *counts = nullptr);
 
 // Block optimizer passes of varying usefulness.
 bool RemoveLoadStoreLeftRight(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool PropagateConstants(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool PurgeTemps(const IRWriter &in, IRWriter &out, const IROptions &opts);
+bool EliminateDeadCode(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool ReduceLoads(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool ThreeOpToTwoOp(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool OptimizeFPMoves(const IRWriter &in, IRWriter &out, const IROptions &opts);
@@ -114,11 +114,15 @@ void JitBlockCache::Shutdown() {
 // is full and when saving and loading states.
 void JitBlockCache::Clear() {
 	block_map_.clear();
+	byPage_.clear();
 	proxyBlockMap_.clear();
 	for (int i = 0; i < num_blocks_; i++)
 		DestroyBlock(i, DestroyType::CLEAR);
 	links_to_.clear();
 	num_blocks_ = 0;
+	numInvalidations_ = 0;
+	numInvalidationChecks_ = 0;
+	numInvalidatedBlocks_ = 0;
 
 	blockMemRanges_[JITBLOCK_RANGE_SCRATCH] = std::make_pair(0xFFFFFFFF, 0x00000000);
 	blockMemRanges_[JITBLOCK_RANGE_RAMBOTTOM] = std::make_pair(0xFFFFFFFF, 0x00000000);
@@ -210,6 +214,7 @@ void JitBlockCache::AddBlockMap(int block_num) {
 	// Yeah, this'll work fine for PSP too I think.
 	u32 pAddr = b.originalAddress & 0x1FFFFFFF;
 	block_map_[std::make_pair(pAddr + 4 * b.originalSize, pAddr)] = block_num;
+	AddBlockPages(block_num);
 }
 
 void JitBlockCache::RemoveBlockMap(int block_num) {
@@ -218,6 +223,8 @@ void JitBlockCache::RemoveBlockMap(int block_num) {
 		return;
 	}
 
+	RemoveBlockPages(block_num);
+
 	const u32 pAddr = b.originalAddress & 0x1FFFFFFF;
 	auto it = block_map_.find(std::make_pair(pAddr + 4 * b.originalSize, pAddr));
 	if (it != block_map_.end() && it->second == (u32)block_num) {
@@ -233,6 +240,37 @@ void JitBlockCache::RemoveBlockMap(int block_num) {
 	}
 }
 
+void JitBlockCache::AddBlockPages(int block_num) {
+	const JitBlock &b = blocks_[block_num];
+	const u32 pAddr = b.originalAddress & 0x1FFFFFFF;
+	// Include the last byte, but an empty block still needs its start page.
+	const u32 pLast = pAddr + (b.originalSize == 0 ? 0 : 4 * b.originalSize - 1);
+	for (u32 page = pAddr >> PAGE_SHIFT; page <= pLast >> PAGE_SHIFT; ++page) {
+		byPage_[page].push_back(block_num);
+	}
+}
+
+void JitBlockCache::RemoveBlockPages(int block_num) {
+	const JitBlock &b = blocks_[block_num];
+	const u32 pAddr = b.originalAddress & 0x1FFFFFFF;
+	const u32 pLast = pAddr + (b.originalSize == 0 ? 0 : 4 * b.originalSize - 1);
+	for (u32 page = pAddr >> PAGE_SHIFT; page <= pLast >> PAGE_SHIFT; ++page) {
+		auto iter = byPage_.find(page);
+		if (iter == byPage_.end())
+			continue;
+
+		std::vector<int> &blocksInPage = iter->second;
+		auto found = std::find(blocksInPage.begin(), blocksInPage.end(), block_num);
+		if (found != blocksInPage.end()) {
+			// Order doesn't matter.
+			*found = blocksInPage.back();
+			blocksInPage.pop_back();
+		}
+		if (blocksInPage.empty())
+			byPage_.erase(iter);
+	}
+}
+
 static void ExpandRange(std::pair<u32, u32> &range, u32 newStart, u32 newEnd) {
 	range.first = std::min(range.first, newStart);
 	range.second = std::max(range.second, newEnd);
@@ -249,6 +287,7 @@ void JitBlockCache::FinalizeBlock(int block_num, bool block_link) {
 	b.compiledHash = HashJitBlock(b);
 
 	AddBlockMap(block_num);
+	compileLog_.RecordBlock(b.originalAddress, b.originalSize * 4, b.codeSize);
 
 	if (block_link) {
 		for (int i = 0; i < MAX_JIT_BLOCK_EXITS; i++) {
@@ -537,6 +576,8 @@ void JitBlockCache::DestroyBlock(int block_num, DestroyType type) {
 	}
 
 	b->invalid = true;
+	if (type == DestroyType::INVALIDATE && !b->IsPureProxy())
+		compileLog_.RecordInvalidation(b->originalAddress);
 	if (!b->IsPureProxy()) {
 		if (Memory::ReadUnchecked_U32(b->originalAddress) == GetEmuHackOpForBlock(block_num).encoding)
 			Memory::Write_Opcode_JIT(b->originalAddress, b->originalFirstOpcode);
@@ -578,25 +619,33 @@ void JitBlockCache::InvalidateICache(u32 address, const u32 length) {
 		return;
 	}
 
-	// Blocks may start and end in overlapping ways, and destroying one invalidates iterators.
-	// So after destroying one, we start over.
-	do {
-	restart:
-		auto next = block_map_.lower_bound(std::make_pair(pAddr, 0));
-		auto last = block_map_.upper_bound(std::make_pair(pEnd + MAX_BLOCK_INSTRUCTIONS, 0));
-		// Note that if next is end(), last will be end() too (equal.)
-		for (; next != last; ++next) {
-			const u32 blockStart = next->first.second;
-			const u32 blockEnd = next->first.first;
-			if (blockStart < pEnd && blockEnd > pAddr) {
-				DestroyBlock(next->second, DestroyType::INVALIDATE);
-				// Our iterator is now invalid.  Break and search again.
-				// Most of the time there shouldn't be a bunch of matching blocks.
-				goto restart;
-			}
+	numInvalidations_++;
+	if (length == 0)
+		return;
+
+	// Destroying a block can destroy others (proxies), which changes the pages, so collect first.
+	std::vector<int> candidates;
+	for (u32 page = pAddr >> PAGE_SHIFT; page <= (pEnd - 1) >> PAGE_SHIFT; ++page) {
+		auto iter = byPage_.find(page);
+		if (iter != byPage_.end())
+			candidates.insert(candidates.end(), iter->second.begin(), iter->second.end());
+	}
+	// Blocks spanning pages show up more than once.
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	for (int block_num : candidates) {
+		const JitBlock &b = blocks_[block_num];
+		if (b.invalid)
+			continue;
+		numInvalidationChecks_++;
+		const u32 blockStart = b.originalAddress & 0x1FFFFFFF;
+		const u32 blockEnd = blockStart + 4 * b.originalSize;
+		if (blockStart < pEnd && blockEnd > pAddr) {
+			DestroyBlock(block_num, DestroyType::INVALIDATE);
+			numInvalidatedBlocks_++;
 		}
-		// We got here - it wasn't in the map at all (or anymore.)
-	} while (false);
+	}
 }
 
 void JitBlockCache::InvalidateChangedBlocks() {
@@ -662,6 +711,9 @@ void JitBlockCache::ComputeStats(BlockCacheStats &bcStats) const {
 	bcStats.minBloat = (float)minBloat;
 	bcStats.maxBloat = (float)maxBloat;
 	bcStats.avgBloat = (float)(totalBloat / (double)num_blocks_);
+	bcStats.numInvalidations = numInvalidations_;
+	bcStats.numInvalidationChecks = numInvalidationChecks_;
+	bcStats.numInvalidatedBlocks = numInvalidatedBlocks_;
 }
 
 JitBlockDebugInfo JitBlockCache::GetBlockDebugInfo(int blockNum) const {
@@ -685,3 +737,40 @@ JitBlockDebugInfo JitBlockCache::GetBlockDebugInfo(int blockNum) const {
 
 	return debugInfo;
 }
+
+void JitBlockCompileLog::RecordCompileTime(u32 em_address, double seconds) {
+	std::lock_guard<std::mutex> guard(lock_);
+	JitBlockCompileInfo &info = info_[em_address];
+	info.compiles++;
+	info.compileSeconds += seconds;
+}
+
+void JitBlockCompileLog::RecordBlock(u32 em_address, u32 guestSize, u32 nativeSize) {
+	std::lock_guard<std::mutex> guard(lock_);
+	JitBlockCompileInfo &info = info_[em_address];
+	info.guestSize = guestSize;
+	info.nativeSize = nativeSize;
+}
+
+void JitBlockCompileLog::RecordNativeSize(u32 em_address, u32 nativeSize) {
+	std::lock_guard<std::mutex> guard(lock_);
+	info_[em_address].nativeSize = nativeSize;
+}
+
+void JitBlockCompileLog::RecordIRBlock(u32 em_address, u32 guestSize, const std::vector<int> &passCounts) {
+	std::lock_guard<std::mutex> guard(lock_);
+	JitBlockCompileInfo &info = info_[em_address];
+	info.guestSize = guestSize;
+	info.nativeSize = 0;
+	info.irPassCounts = passCounts;
+}
+
+void JitBlockCompileLog::RecordInvalidation(u32 em_address) {
+	std::lock_guard<std::mutex> guard(lock_);
+	info_[em_address].invalidations++;
+}
+
+std::map<u32, JitBlockCompileInfo> JitBlockCompileLog::Get() const {
+	std::lock_guard<std::mutex> guard(lock_);
+	return info_;
+}
@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -44,6 +45,10 @@ struct BlockCacheStats {
 	float maxBloat;
 	u32 maxBloatBlock;
 	std::map<float, u32> bloatMap;
+	// Since the last clear, to judge what icache invalidation costs.
+	u32 numInvalidations;
+	u32 numInvalidationChecks;
+	u32 numInvalidatedBlocks;
 };
 
 enum class DestroyType {
@@ -104,12 +109,44 @@ struct JitBlockDebugInfo {
 	std::vector<std::string> targetDisasm;
 };
 
+// What it cost to compile the code at one start address.  Kept across invalidation and
+// cache clears, so code that keeps getting recompiled stands out.
+struct JitBlockCompileInfo {
+	int compiles = 0;
+	int invalidations = 0;
+	double compileSeconds = 0.0;
+	// The rest are from the latest compile.
+	u32 guestSize = 0;  // In bytes.
+	u32 nativeSize = 0;
+	// IR jits only: the instruction count before optimizing, then after each pass.
+	std::vector<int> irPassCounts;
+};
+
+class JitBlockCompileLog {
+public:
+	void RecordCompileTime(u32 em_address, double seconds);
+	void RecordBlock(u32 em_address, u32 guestSize, u32 nativeSize);
+	void RecordNativeSize(u32 em_address, u32 nativeSize);
+	// Also resets the native size, since the IR may run interpreted until a backend compiles it.
+	void RecordIRBlock(u32 em_address, u32 guestSize, const std::vector<int> &passCounts);
+	void RecordInvalidation(u32 em_address);
+
+	std::map<u32, JitBlockCompileInfo> Get() const;
+
+private:
+	// IR jits compile on background threads too.
+	mutable std::mutex lock_;
+	std::map<u32, JitBlockCompileInfo> info_;
+};
+
 class JitBlockCacheDebugInterface {
 public:
 	virtual int GetNumBlocks() const = 0;
 	virtual int GetBlockNumberFromStartAddress(u32 em_address, bool realBlocksOnly = true) const = 0;
 	virtual JitBlockDebugInfo GetBlockDebugInfo(int blockNum) const = 0;
 	virtual void ComputeStats(BlockCacheStats &bcStats) const = 0;
+	// Nullptr if this cache doesn't track compiles.
+	virtual JitBlockCompileLog *GetCompileLog() { return nullptr; }
 
 	virtual ~JitBlockCacheDebugInterface() {}
 };
@@ -167,6 +204,7 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	static int GetBlockExitSize();
 
 	JitBlockDebugInfo GetBlockDebugInfo(int blockNum) const override;
+	JitBlockCompileLog *GetCompileLog() override { return &compileLog_; }
 
 	enum {
 		MAX_BLOCK_INSTRUCTIONS = 0x4000,
@@ -179,6 +217,8 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 
 	void AddBlockMap(int block_num);
 	void RemoveBlockMap(int block_num);
+	void AddBlockPages(int block_num);
+	void RemoveBlockPages(int block_num);
 
 	MIPSOpcode GetEmuHackOpForBlock(int block_num) const;
 
@@ -189,6 +229,13 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	int num_blocks_;
 	std::unordered_multimap<u32, int> links_to_;
 	std::map<std::pair<u32,u32>, u32> block_map_; // (end_addr, start_addr) -> number
+	// Physical page -> blocks overlapping it, so invalidation doesn't have to search.
+	std::unordered_map<u32, std::vector<int>> byPage_;
+
+	u32 numInvalidations_ = 0;
+	u32 numInvalidationChecks_ = 0;
+	u32 numInvalidatedBlocks_ = 0;
+	JitBlockCompileLog compileLog_;
 
 	enum {
 		JITBLOCK_RANGE_SCRATCH = 0,
@@ -199,7 +246,8 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	std::pair<u32, u32> blockMemRanges_[3];
 
 	enum {
-		MAX_NUM_BLOCKS = 65536*2
+		MAX_NUM_BLOCKS = 65536*2,
+		PAGE_SHIFT = 12,
 	};
 };
 
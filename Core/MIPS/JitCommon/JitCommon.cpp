@@ -22,12 +22,18 @@
 #include "ext/disarm.h"
 #include "ext/udis86/udis86.h"
 
+#include "Common/Data/Format/JSONWriter.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 
 #include "Core/Util/DisArm64.h"
 #include "Core/Config.h"
+#include "Core/System.h"
+#include "Core/ELF/ParamSFO.h"
 
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitState.h"
@@ -39,8 +45,11 @@
 #include "../ARM64/Arm64Jit.h"
 #elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
 #include "../x86/Jit.h"
+#include "../x86/X64IRJit.h"
 #elif PPSSPP_ARCH(MIPS)
 #include "../MIPS/MipsJit.h"
+#elif PPSSPP_ARCH(RISCV64)
+#include "../RiscV/RiscVJit.h"
 #else
 #include "../fake/FakeJit.h"
 #endif
@@ -49,8 +58,19 @@ namespace MIPSComp {
 	JitInterface *jit;
 	std::recursive_mutex jitLock;
 
+	JitCompileStats jitCompileStats;
+
 	void JitAt() {
-		jit->Compile(currentMIPS->pc);
+		const u32 pc = currentMIPS->pc;
+		double start = time_now_d();
+		jit->Compile(pc);
+		double elapsed = time_now_d() - start;
+		jitCompileStats.compiles++;
+		jitCompileStats.seconds += elapsed;
+
+		JitBlockCompileLog *log = jit->GetBlockCacheDebugInterface()->GetCompileLog();
+		if (log)
+			log->RecordCompileTime(pc, elapsed);
 	}
 
 	void DoDummyJitState(PointerWrap &p) {
@@ -67,6 +87,88 @@ namespace MIPSComp {
 		}
 	}
 
+	static Path GameBlockCachePath() {
+		std::string discID = g_paramSFO.GetDiscID();
+		if (discID.empty())
+			return Path();
+		return GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".irblockcache");
+	}
+
+	void LoadGameBlockCache() {
+		if (!g_Config.bJitBlockCache)
+			return;
+		Path filename = GameBlockCachePath();
+		std::lock_guard<std::recursive_mutex> guard(jitLock);
+		if (jit && !filename.empty())
+			jit->LoadBlockCache(filename);
+	}
+
+	void SaveGameBlockCache() {
+		if (!g_Config.bJitBlockCache)
+			return;
+		Path filename = GameBlockCachePath();
+		std::lock_guard<std::recursive_mutex> guard(jitLock);
+		if (jit && !filename.empty())
+			jit->SaveBlockCache(filename);
+	}
+
+	Path ExportGameCompileLog() {
+		std::lock_guard<std::recursive_mutex> guard(jitLock);
+		if (!jit)
+			return Path();
+		JitBlockCacheDebugInterface *blockCache = jit->GetBlockCacheDebugInterface();
+		JitBlockCompileLog *log = blockCache->GetCompileLog();
+		if (!log)
+			return Path();
+
+		json::JsonWriter writer;
+		writer.begin();
+		writer.writeString("game", g_paramSFO.GetDiscID());
+		writer.pushArray("blocks");
+		for (const auto &it : log->Get()) {
+			const JitBlockCompileInfo &info = it.second;
+			writer.pushDict();
+			writer.writeString("address", StringFromFormat("%08x", it.first));
+			writer.writeInt("compiles", info.compiles);
+			writer.writeInt("invalidations", info.invalidations);
+			writer.writeFloat("compileUs", info.compileSeconds * 1000000.0);
+			writer.writeUint("guestSize", info.guestSize);
+			writer.writeUint("nativeSize", info.nativeSize);
+			if (!info.irPassCounts.empty()) {
+				writer.pushArray("irPassCounts");
+				for (int count : info.irPassCounts)
+					writer.writeInt(count);
+				writer.pop();
+			}
+
+			// Disassembly only for blocks that are still live.
+			int blockNum = blockCache->GetBlockNumberFromStartAddress(it.first);
+			if (blockNum >= 0) {
+				JitBlockDebugInfo debugInfo = blockCache->GetBlockDebugInfo(blockNum);
+				auto writeLines = [&](const char *name, const std::vector<std::string> &lines) {
+					if (lines.empty())
+						return;
+					writer.pushArray(name);
+					for (const std::string &line : lines)
+						writer.writeString(line);
+					writer.pop();
+				};
+				writeLines("mips", debugInfo.origDisasm);
+				writeLines("ir", debugInfo.irDisasm);
+				writeLines("target", debugInfo.targetDisasm);
+			}
+			writer.pop();
+		}
+		writer.pop();
+		writer.end();
+
+		std::string discID = g_paramSFO.GetDiscID();
+		Path filename = GetSysDirectory(DIRECTORY_DUMP) / ((discID.empty() ? "unknown" : discID) + "_jitblocks.json");
+		if (!File::WriteStringToFile(true, writer.str(), filename))
+			return Path();
+		return filename;
+	}
+
 	JitInterface *CreateNativeJit(MIPSState *mipsState) {
 #if PPSSPP_ARCH(ARM)
 		return new MIPSComp::ArmJit(mipsState);
@@ -76,11 +178,24 @@ namespace MIPSComp {
 		return new MIPSComp::Jit(mipsState);
 #elif PPSSPP_ARCH(MIPS)
 		return new MIPSComp::MipsJit(mipsState);
+#elif PPSSPP_ARCH(RISCV64)
+		// There's no direct MIPS to RISC-V jit, the IR based one is it.
+		return new MIPSComp::RiscVJit(mipsState);
 #else
 		return new MIPSComp::FakeJit(mipsState);
 #endif
 	}
 
+	JitInterface *CreateNativeIRJit(MIPSState *mipsState) {
+#if PPSSPP_ARCH(AMD64)
+		return new MIPSComp::X64IRJit(mipsState);
+#elif PPSSPP_ARCH(RISCV64)
+		return new MIPSComp::RiscVJit(mipsState);
+#else
+		return new MIPSComp::IRJit(mipsState);
+#endif
+	}
+
 }
 #if PPSSPP_PLATFORM(WINDOWS) && !defined(__LIBRETRO__)
 #define DISASM_ALL 1
@@ -32,6 +32,7 @@ std::vector<std::string> DisassembleX86(const u8 *data, int size);
 struct JitBlock;
 class JitBlockCache;
 class JitBlockCacheDebugInterface;
+class Path;
 class PointerWrap;
 
 #ifdef USING_QT_UI
@@ -41,8 +42,16 @@ class PointerWrap;
 class MIPSState;
 
 namespace MIPSComp {
+	// Compiles the block at the current pc, counting it in jitCompileStats.
 	void JitAt();
 
+	struct JitCompileStats {
+		int compiles;
+		double seconds;
+	};
+	// Only touched from the emu thread.
+	extern JitCompileStats jitCompileStats;
+
 	class MIPSFrontendInterface {
 	public:
 		virtual ~MIPSFrontendInterface() {}
@@ -117,6 +126,14 @@ namespace MIPSComp {
 		virtual int Replace_fabsf() = 0;
 	};
 
+	struct JitBlockProfile {
+		u32 address;
+		u32 size;  // In bytes.
+		u64 entries;
+		// Estimated cycles spent in the block, from downcount.
+		u64 cycles;
+	};
+
 	class JitInterface {
 	public:
 		virtual ~JitInterface() {}
@@ -148,6 +165,16 @@ namespace MIPSComp {
 		// like that.
 		virtual void LinkBlock(u8 *exitPoint, const u8 *entryPoint) = 0;
 		virtual void UnlinkBlock(u8 *checkedEntry, u32 originalAddress) = 0;
+
+		// Persistent block cache, only implemented by jits without absolute pointers in their blocks.
+		virtual void LoadBlockCache(const Path &filename) {}
+		virtual void SaveBlockCache(const Path &filename) {}
+
+		// Opt-in per block profiling.  Returns false if this jit can't count blocks.
+		// May clear the cache, so the CPU must not be running.
+		virtual bool SetBlockProfiling(bool enable) { return false; }
+		virtual bool IsBlockProfiling() const { return false; }
+		virtual void GetBlockProfile(std::vector<JitBlockProfile> &profile) const {}
 	};
 
 	typedef void (MIPSFrontendInterface::*MIPSCompileFunc)(MIPSOpcode opcode);
@@ -158,5 +185,13 @@ namespace MIPSComp {
 
 	void DoDummyJitState(PointerWrap &p);
 
+	// Loads and saves the block cache for the current game, if enabled.
+	void LoadGameBlockCache();
+	void SaveGameBlockCache();
+	// Writes compile stats and disassembly per block to the dump directory.  Empty path on failure.
+	Path ExportGameCompileLog();
+
 	JitInterface *CreateNativeJit(MIPSState *mipsState);
+	// Returns a native backend for the IR if available, otherwise the IR interpreter.
+	JitInterface *CreateNativeIRJit(MIPSState *mipsState);
 }
@@ -216,6 +216,8 @@ void MIPSState::Init() {
 		MIPSComp::jit = MIPSComp::CreateNativeJit(this);
 	} else if (PSP_CoreParameter().cpuCore == CPUCore::IR_JIT) {
 		MIPSComp::jit = new MIPSComp::IRJit(this);
+	} else if (PSP_CoreParameter().cpuCore == CPUCore::JIT_IR) {
+		MIPSComp::jit = MIPSComp::CreateNativeIRJit(this);
 	} else {
 		MIPSComp::jit = nullptr;
 	}
@@ -255,6 +257,16 @@ void MIPSState::UpdateCore(CPUCore desired) {
 		newjit = new MIPSComp::IRJit(this);
 		break;
 
+	case CPUCore::JIT_IR:
+		INFO_LOG(CPU, "Switching to JIT IR");
+		if (oldjit) {
+			std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+			MIPSComp::jit = nullptr;
+			delete oldjit;
+		}
+		newjit = MIPSComp::CreateNativeIRJit(this);
+		break;
+
 	case CPUCore::INTERPRETER:
 		INFO_LOG(CPU, "Switching to interpreter");
 		if (oldjit) {
@@ -274,8 +286,8 @@ void MIPSState::DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
-	// Reset the jit if we're loading.
-	if (p.mode == p.MODE_READ)
+	// Reset the jit if we're loading.  Run-ahead restores every frame, and invalidates what changed itself.
+	if (p.mode == p.MODE_READ && !PSP_CoreParameter().runAheadSpeculative)
 		Reset();
 	// Assume we're not saving state during a CPU core reset, so no lock.
 	if (MIPSComp::jit)
@@ -330,6 +342,7 @@ int MIPSState::RunLoopUntil(u64 globalTicks) {
 	switch (PSP_CoreParameter().cpuCore) {
 	case CPUCore::JIT:
 	case CPUCore::IR_JIT:
+	case CPUCore::JIT_IR:
 		while (inDelaySlot) {
 			// We must get out of the delay slot before going into jit.
 			SingleStep();
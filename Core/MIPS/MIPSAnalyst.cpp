@@ -28,6 +28,8 @@
 #include "Common/File/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/TimeUtil.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/Config.h"
 #include "Core/MemMap.h"
 #include "Core/System.h"
@@ -46,6 +48,8 @@ using namespace MIPSCodeUtils;
 typedef std::vector<MIPSAnalyst::AnalyzedFunction> FunctionsVector;
 static FunctionsVector functions;
 std::recursive_mutex functions_lock;
+// Functions from here on were scanned but haven't been hashed or replaced yet.
+static size_t firstUnfinalizedFunction = 0;
 
 // One function can appear in multiple copies in memory, and they will all have 
 // the same hash and should all be replaced if possible.
@@ -78,6 +82,9 @@ namespace std {
 static std::unordered_set<HashMapFunc> hashMap;
 
 static Path hashmapFileName;
+// The hash maps only ever grow, so they're read from disk once per run rather than on every module load.
+static bool builtinHashMapLoaded = false;
+static Path hashMapLoadedFrom;
 
 #define MIPSTABLE_IMM_MASK 0xFC000000
 
@@ -759,6 +766,7 @@ namespace MIPSAnalyst {
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 		functions.clear();
 		hashToFunction.clear();
+		firstUnfinalizedFunction = 0;
 	}
 
 	void UpdateHashToFunctionMap() {
@@ -883,40 +891,47 @@ namespace MIPSAnalyst {
 		return DetermineRegisterUsage(reg, addr, instrs) == USAGE_CLOBBERED;
 	}
 
-	void HashFunctions() {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-		std::vector<u32> buffer;
+	static void HashFunction(AnalyzedFunction &f, std::vector<u32> &buffer) {
+		if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
+			return;
+		}
 
-		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			AnalyzedFunction &f = *iter;
-			if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
-				continue;
+		// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
+		buffer.resize((f.end - f.start + 4) / 4);
+		size_t pos = 0;
+		for (u32 addr = f.start; addr <= f.end; addr += 4) {
+			u32 validbits = 0xFFFFFFFF;
+			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
+			if (MIPS_IS_EMUHACK(instr)) {
+				f.hasHash = false;
+				return;
 			}
 
-			// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
-			buffer.resize((f.end - f.start + 4) / 4);
-			size_t pos = 0;
-			for (u32 addr = f.start; addr <= f.end; addr += 4) {
-				u32 validbits = 0xFFFFFFFF;
-				MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
-				if (MIPS_IS_EMUHACK(instr)) {
-					f.hasHash = false;
-					goto skip;
-				}
+			MIPSInfo flags = MIPSGetInfo(instr);
+			if (flags & IN_IMM16)
+				validbits &= ~0xFFFF;
+			if (flags & IN_IMM26)
+				validbits &= ~0x03FFFFFF;
+			buffer[pos++] = instr & validbits;
+		}
 
-				MIPSInfo flags = MIPSGetInfo(instr);
-				if (flags & IN_IMM16)
-					validbits &= ~0xFFFF;
-				if (flags & IN_IMM26)
-					validbits &= ~0x03FFFFFF;
-				buffer[pos++] = instr & validbits;
-			}
+		f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
+		f.hasHash = true;
+	}
 
-			f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
-			f.hasHash = true;
-skip:
-			;
+	// Functions are independent and memory isn't changing under us, so this is split across threads.
+	static void HashFunctions(size_t first, size_t last) {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+		if (first >= last) {
+			return;
 		}
+
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			std::vector<u32> buffer;
+			for (int i = l; i < h; i++) {
+				HashFunction(functions[i], buffer);
+			}
+		}, (int)first, (int)last, 256);
 	}
 
 	void PrecompileFunction(u32 startAddr, u32 length) {
@@ -928,7 +943,8 @@ namespace MIPSAnalyst {
 	}
 
 	void PrecompileFunctions() {
-		if (!g_Config.bPreloadFunctions) {
+		// With a background jit, this just queues them up.
+		if (!g_Config.bPreloadFunctions && !g_Config.bBackgroundJit) {
 			return;
 		}
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
@@ -1187,23 +1203,71 @@ namespace MIPSAnalyst {
 		return insertSymbols;
 	}
 
+	static void ReplaceFunctions(size_t first, size_t last) {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+
+		for (size_t i = first; i < last; i++) {
+			WriteReplaceInstructions(functions[i].start, functions[i].hash, functions[i].size);
+		}
+	}
+
+	static void EnsureHashMapsLoaded(const Path &hashMapFilename) {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+		if (!builtinHashMapLoaded) {
+			LoadBuiltinHashMap();
+			builtinHashMapLoaded = true;
+		}
+		if (g_Config.bFuncHashMap && hashMapLoadedFrom != hashMapFilename) {
+			LoadHashMap(hashMapFilename);
+			hashMapLoadedFrom = hashMapFilename;
+		}
+	}
+
+	class PreloadHashMapsTask : public Task {
+	public:
+		PreloadHashMapsTask(const Path &filename) : filename_(filename) {}
+		TaskType Type() const override { return TaskType::IO_BLOCKING; }
+		void Run() override {
+			EnsureHashMapsLoaded(filename_);
+		}
+
+	private:
+		Path filename_;
+	};
+
+	void PreloadHashMaps() {
+		if (!g_Config.bFuncHashMap && !g_Config.bFuncReplacements)
+			return;
+		Path hashMapFilename = GetSysDirectory(DIRECTORY_SYSTEM) / "knownfuncs.ini";
+		g_threadManager.EnqueueTask(new PreloadHashMapsTask(hashMapFilename));
+	}
+
 	void FinalizeScan(bool insertSymbols) {
-		HashFunctions();
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+		// Only the functions scanned since the last module load need hashing and replacing.
+		const size_t first = std::min(firstUnfinalizedFunction, functions.size());
+		const size_t last = functions.size();
+		firstUnfinalizedFunction = last;
+
+		double st = time_now_d();
+		HashFunctions(first, last);
 
 		Path hashMapFilename = GetSysDirectory(DIRECTORY_SYSTEM) / "knownfuncs.ini";
 		if (g_Config.bFuncHashMap || g_Config.bFuncReplacements) {
-			LoadBuiltinHashMap();
+			EnsureHashMapsLoaded(hashMapFilename);
 			if (g_Config.bFuncHashMap) {
-				LoadHashMap(hashMapFilename);
 				StoreHashMap(hashMapFilename);
 			}
 			if (insertSymbols) {
 				ApplyHashMap();
 			}
 			if (g_Config.bFuncReplacements) {
-				ReplaceFunctions();
+				ReplaceFunctions(first, last);
 			}
 		}
+		double et = time_now_d();
+
+		DEBUG_LOG(JIT, "Finalized %d MIPS functions in %0.2f milliseconds", (int)(last - first), (et - st) * 1000.0);
 	}
 
 	void RegisterFunction(u32 startAddr, u32 size, const char *name) {
@@ -1236,7 +1300,8 @@ namespace MIPSAnalyst {
 		fun.name[63] = 0;
 		functions.push_back(fun);
 
-		HashFunctions();
+		std::vector<u32> buffer;
+		HashFunction(functions.back(), buffer);
 	}
 
 	void ForgetFunctions(u32 startAddr, u32 endAddr) {
@@ -1246,6 +1311,14 @@ namespace MIPSAnalyst {
 		// the easy way of saving a hashmap by unloading and loading a game. I added
 		// an alternative way.
 
+		// Keep firstUnfinalizedFunction pointing at the same function after erasing.
+		size_t forgottenFinalized = 0;
+		for (size_t i = 0; i < std::min(firstUnfinalizedFunction, functions.size()); ++i) {
+			if (functions[i].start >= startAddr && functions[i].start <= endAddr)
+				forgottenFinalized++;
+		}
+		firstUnfinalizedFunction -= std::min(forgottenFinalized, firstUnfinalizedFunction);
+
 		// Most of the time, functions from the same module will be contiguous in functions.
 		FunctionsVector::iterator prevMatch = functions.end();
 		size_t originalSize = functions.size();
@@ -1278,10 +1351,7 @@ namespace MIPSAnalyst {
 
 	void ReplaceFunctions() {
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-
-		for (size_t i = 0; i < functions.size(); i++) {
-			WriteReplaceInstructions(functions[i].start, functions[i].hash, functions[i].size);
-		}
+		ReplaceFunctions(0, functions.size());
 	}
 
 	void UpdateHashMap() {
@@ -1427,6 +1497,73 @@ namespace MIPSAnalyst {
 		return vec;
 	}
 
+	static u32 GPRMask(MIPSGPReg reg) {
+		return reg == MIPS_REG_ZERO ? 0 : 1U << reg;
+	}
+
+	static u32 InputGPRMask(MIPSOpcode op, MIPSInfo info) {
+		u32 mask = 0;
+		if (info & IN_RS) mask |= GPRMask(MIPS_GET_RS(op));
+		if (info & IN_RT) mask |= GPRMask(MIPS_GET_RT(op));
+		// A conditional move keeps the old value when not taken, so it reads its output too.
+		if (info & IS_CONDMOVE) mask |= GPRMask(MIPS_GET_RD(op));
+		return mask;
+	}
+
+	static u32 OutputGPRMask(MIPSOpcode op, MIPSInfo info) {
+		u32 mask = 0;
+		if (info & OUT_RD) mask |= GPRMask(MIPS_GET_RD(op));
+		if (info & OUT_RT) mask |= GPRMask(MIPS_GET_RT(op));
+		if (info & OUT_RA) mask |= GPRMask(MIPS_REG_RA);
+		return mask;
+	}
+
+	bool IsIdleLoop(u32 loopStart, u32 branchAddr) {
+		// Keep this to short polling loops, longer ones are unlikely to be idle anyway.
+		const u32 MAX_IDLE_LOOP_BYTES = 16 * 4;
+		if (loopStart > branchAddr || branchAddr - loopStart > MAX_IDLE_LOOP_BYTES)
+			return false;
+		if (!Memory::IsValidRange(loopStart, branchAddr + 8 - loopStart))
+			return false;
+
+		const u64 unsafeFlags = BAD_INSTRUCTION | IS_JUMP | IN_OTHER | OUT_OTHER | OUT_MEM | IS_FPU | IS_VFPU |
+			IN_FPUFLAG | OUT_FPUFLAG | IN_VFPU_CC | OUT_VFPU_CC | IN_LO | IN_HI | OUT_LO | OUT_HI |
+			IN_FS | IN_FT | OUT_FD | OUT_FS | OUT_FT | IN_VS | IN_VT | OUT_VD;
+
+		// First pass: everything must be a plain load or ALU op, and we need what gets written.
+		u32 loopOutputs = 0;
+		for (u32 addr = loopStart; addr <= branchAddr + 4; addr += 4) {
+			MIPSOpcode op = Memory::Read_Instruction(addr, true);
+			// Syscalls and break are the obvious ways out, but they look like plain ops in the tables.
+			const bool isBreak = (op & 0xFC00003F) == 13;
+			if (MIPS_IS_EMUHACK(op.encoding) || isBreak || IsSyscall(op))
+				return false;
+			MIPSInfo info = MIPSGetInfo(op);
+			if (info & unsafeFlags)
+				return false;
+			if (addr == branchAddr) {
+				if (!(info & IS_CONDBRANCH) || (info & OUT_RA) || MIPSCodeUtils::GetBranchTarget(addr) != loopStart)
+					return false;
+			} else if (info & IS_CONDBRANCH) {
+				return false;
+			}
+			loopOutputs |= OutputGPRMask(op, info);
+		}
+
+		// Second pass, in execution order: a register the loop writes must not be read before it is
+		// written, or it carries state (like a counter) from one iteration to the next.
+		// Without that, every iteration computes the same thing until memory is changed by an event.
+		u32 written = 0;
+		for (u32 addr = loopStart; addr <= branchAddr + 4; addr += 4) {
+			MIPSOpcode op = Memory::Read_Instruction(addr, true);
+			MIPSInfo info = MIPSGetInfo(op);
+			if (InputGPRMask(op, info) & loopOutputs & ~written)
+				return false;
+			written |= OutputGPRMask(op, info);
+		}
+		return true;
+	}
+
 	MipsOpcodeInfo GetOpcodeInfo(DebugInterface* cpu, u32 address) {
 		MipsOpcodeInfo info;
 		memset(&info, 0, sizeof(info));
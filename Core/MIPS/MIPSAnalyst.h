@@ -109,6 +109,8 @@ namespace MIPSAnalyst
 	// Returns new insertSymbols value for FinalizeScan().
 	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols);
 	void FinalizeScan(bool insertSymbols);
+	// Starts reading the function hash maps in the background, so the first FinalizeScan() doesn't have to.
+	void PreloadHashMaps();
 	void ForgetFunctions(u32 startAddr, u32 endAddr);
 	void PrecompileFunctions();
 	void PrecompileFunction(u32 startAddr, u32 length);
@@ -133,6 +135,9 @@ namespace MIPSAnalyst
 	bool IsDelaySlotNiceVFPU(MIPSOpcode branchOp, MIPSOpcode op);
 	bool IsDelaySlotNiceFPU(MIPSOpcode branchOp, MIPSOpcode op);
 	bool IsSyscall(MIPSOpcode op);
+	// True for a short loop ending in a branch back to loopStart that only polls memory,
+	// so it can't exit until something else (an interrupt, another thread) changes it.
+	bool IsIdleLoop(u32 loopStart, u32 branchAddr);
 
 	bool OpWouldChangeMemory(u32 pc, u32 addr, u32 size);
 	int OpMemoryAccessSize(u32 pc);
@@ -0,0 +1,440 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(RISCV64)
+
+#include "Core/MemMap.h"
+#include "Core/MIPS/RiscV/RiscVJit.h"
+
+// All host registers in the regcache hold 32-bit values sign extended to 64 bits, which is what
+// LW and all the W ops produce.  Signed and unsigned compares both work on that form, but
+// addresses and unsigned multiplies need an explicit zero extension.
+
+namespace MIPSComp {
+
+using namespace RiscVGen;
+using namespace RiscVJitConstants;
+
+void RiscVJit::CompIR_Arith(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Add:
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		ADDW(gpr.R(inst.dest), gpr.R(inst.src1), gpr.R(inst.src2));
+		break;
+
+	case IROp::Sub:
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		SUBW(gpr.R(inst.dest), gpr.R(inst.src1), gpr.R(inst.src2));
+		break;
+
+	case IROp::AddConst:
+	case IROp::SubConst:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		s32 value = inst.op == IROp::AddConst ? (s32)inst.constant : (s32)(0 - inst.constant);
+		AddConst32(gpr.R(inst.dest), gpr.R(inst.src1), value);
+		break;
+	}
+
+	case IROp::Neg:
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		NEGW(gpr.R(inst.dest), gpr.R(inst.src1));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void RiscVJit::CompIR_Logic(IRInst inst) {
+	switch (inst.op) {
+	case IROp::And:
+	case IROp::Or:
+	case IROp::Xor:
+	{
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		RiscVReg rd = gpr.R(inst.dest);
+		RiscVReg rs = gpr.R(inst.src1);
+		RiscVReg rt = gpr.R(inst.src2);
+		if (inst.op == IROp::And)
+			AND(rd, rs, rt);
+		else if (inst.op == IROp::Or)
+			OR(rd, rs, rt);
+		else
+			XOR(rd, rs, rt);
+		break;
+	}
+
+	case IROp::AndConst:
+	case IROp::OrConst:
+	case IROp::XorConst:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		RiscVReg rd = gpr.R(inst.dest);
+		RiscVReg rs = gpr.R(inst.src1);
+		// Sign extending the constant keeps the result in our 64-bit form.
+		s32 value = (s32)inst.constant;
+		if (SignedFits12(value)) {
+			if (inst.op == IROp::AndConst)
+				ANDI(rd, rs, value);
+			else if (inst.op == IROp::OrConst)
+				ORI(rd, rs, value);
+			else
+				XORI(rd, rs, value);
+		} else {
+			LI(SCRATCH1, value);
+			if (inst.op == IROp::AndConst)
+				AND(rd, rs, SCRATCH1);
+			else if (inst.op == IROp::OrConst)
+				OR(rd, rs, SCRATCH1);
+			else
+				XOR(rd, rs, SCRATCH1);
+		}
+		break;
+	}
+
+	case IROp::Not:
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		NOT(gpr.R(inst.dest), gpr.R(inst.src1));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void RiscVJit::CompIR_Assign(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Mov:
+		if (inst.dest != inst.src1) {
+			gpr.MapDirtyIn(inst.dest, inst.src1);
+			MV(gpr.R(inst.dest), gpr.R(inst.src1));
+		}
+		break;
+
+	case IROp::Ext8to32:
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		SLLI(gpr.R(inst.dest), gpr.R(inst.src1), 56);
+		SRAI(gpr.R(inst.dest), gpr.R(inst.dest), 56);
+		break;
+
+	case IROp::Ext16to32:
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		SLLI(gpr.R(inst.dest), gpr.R(inst.src1), 48);
+		SRAI(gpr.R(inst.dest), gpr.R(inst.dest), 48);
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void RiscVJit::CompIR_Shift(IRInst inst) {
+	switch (inst.op) {
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+	case IROp::RorImm:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		RiscVReg rd = gpr.R(inst.dest);
+		RiscVReg rs = gpr.R(inst.src1);
+		u32 sa = inst.src2 & 31;
+		switch (inst.op) {
+		case IROp::ShlImm: SLLIW(rd, rs, sa); break;
+		case IROp::ShrImm: SRLIW(rd, rs, sa); break;
+		case IROp::SarImm: SRAIW(rd, rs, sa); break;
+		case IROp::RorImm:
+			if (sa == 0) {
+				MV(rd, rs);
+				break;
+			}
+			// No Zbb, so combine both halves.
+			SRLIW(SCRATCH1, rs, sa);
+			SLLIW(SCRATCH2, rs, 32 - sa);
+			OR(rd, SCRATCH1, SCRATCH2);
+			break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::Shl:
+	case IROp::Shr:
+	case IROp::Sar:
+	case IROp::Ror:
+	{
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		RiscVReg rd = gpr.R(inst.dest);
+		RiscVReg rs = gpr.R(inst.src1);
+		RiscVReg rt = gpr.R(inst.src2);
+		// The W shifts use only the low 5 bits of the count, like MIPS.
+		switch (inst.op) {
+		case IROp::Shl: SLLW(rd, rs, rt); break;
+		case IROp::Shr: SRLW(rd, rs, rt); break;
+		case IROp::Sar: SRAW(rd, rs, rt); break;
+		case IROp::Ror:
+			// Shifting left by -count works out to 32 - count, and to zero for a zero count.
+			SRLW(SCRATCH1, rs, rt);
+			NEGW(SCRATCH2, rt);
+			SLLW(SCRATCH2, rs, SCRATCH2);
+			OR(rd, SCRATCH1, SCRATCH2);
+			break;
+		default: break;
+		}
+		break;
+	}
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void RiscVJit::CompIR_Compare(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Slt:
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		SLT(gpr.R(inst.dest), gpr.R(inst.src1), gpr.R(inst.src2));
+		break;
+
+	case IROp::SltU:
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		SLTU(gpr.R(inst.dest), gpr.R(inst.src1), gpr.R(inst.src2));
+		break;
+
+	case IROp::SltConst:
+	case IROp::SltUConst:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		RiscVReg rd = gpr.R(inst.dest);
+		RiscVReg rs = gpr.R(inst.src1);
+		// The immediate is sign extended either way, which matches how we keep values.
+		s32 value = (s32)inst.constant;
+		if (SignedFits12(value)) {
+			if (inst.op == IROp::SltConst)
+				SLTI(rd, rs, value);
+			else
+				SLTIU(rd, rs, value);
+		} else {
+			LI(SCRATCH1, value);
+			if (inst.op == IROp::SltConst)
+				SLT(rd, rs, SCRATCH1);
+			else
+				SLTU(rd, rs, SCRATCH1);
+		}
+		break;
+	}
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void RiscVJit::CompIR_CondAssign(IRInst inst) {
+	switch (inst.op) {
+	case IROp::MovZ:
+	case IROp::MovNZ:
+	{
+		// The dest keeps its value when the condition fails, so it must be loaded.
+		gpr.SpillLock(inst.dest, inst.src1, inst.src2);
+		RiscVReg rs = gpr.MapReg(inst.src1);
+		RiscVReg rt = gpr.MapReg(inst.src2);
+		RiscVReg rd = gpr.MapReg(inst.dest, MAP_DIRTY);
+		FixupBranch skip = inst.op == IROp::MovZ ? BNEZ(rs) : BEQZ(rs);
+		MV(rd, rt);
+		SetJumpTarget(skip);
+		break;
+	}
+
+	case IROp::Max:
+	case IROp::Min:
+	{
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		RiscVReg rs = gpr.R(inst.src1);
+		RiscVReg rt = gpr.R(inst.src2);
+		// Keep rs when it's "better", otherwise take rt.
+		MV(SCRATCH1, rs);
+		FixupBranch keep = inst.op == IROp::Max ? BLT(rt, rs) : BLT(rs, rt);
+		MV(SCRATCH1, rt);
+		SetJumpTarget(keep);
+		MV(gpr.R(inst.dest), SCRATCH1);
+		break;
+	}
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void RiscVJit::CompIR_HiLo(IRInst inst) {
+	switch (inst.op) {
+	case IROp::MtLo:
+		gpr.MapDirtyIn(IRREG_LO, inst.src1);
+		MV(gpr.R(IRREG_LO), gpr.R(inst.src1));
+		break;
+
+	case IROp::MtHi:
+		gpr.MapDirtyIn(IRREG_HI, inst.src1);
+		MV(gpr.R(IRREG_HI), gpr.R(inst.src1));
+		break;
+
+	case IROp::MfLo:
+		gpr.MapDirtyIn(inst.dest, IRREG_LO);
+		MV(gpr.R(inst.dest), gpr.R(IRREG_LO));
+		break;
+
+	case IROp::MfHi:
+		gpr.MapDirtyIn(inst.dest, IRREG_HI);
+		MV(gpr.R(inst.dest), gpr.R(IRREG_HI));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void RiscVJit::CompIR_Mult(IRInst inst) {
+	bool isSigned = inst.op == IROp::Mult || inst.op == IROp::Madd || inst.op == IROp::Msub;
+	bool accumulate = inst.op != IROp::Mult && inst.op != IROp::MultU;
+
+	gpr.MapInIn(inst.src1, inst.src2);
+	// Sign extended inputs give the exact signed 64-bit product.  Unsigned needs zero extension.
+	if (isSigned) {
+		MUL(SCRATCH1, gpr.R(inst.src1), gpr.R(inst.src2));
+	} else {
+		ZEXT_W(SCRATCH1, gpr.R(inst.src1));
+		ZEXT_W(SCRATCH2, gpr.R(inst.src2));
+		MUL(SCRATCH1, SCRATCH1, SCRATCH2);
+	}
+
+	gpr.SpillLock(IRREG_LO, IRREG_HI);
+	RiscVReg lo = gpr.MapReg(IRREG_LO, accumulate ? MAP_DIRTY : MAP_NOINIT);
+	RiscVReg hi = gpr.MapReg(IRREG_HI, accumulate ? MAP_DIRTY : MAP_NOINIT);
+	if (accumulate) {
+		SLLI(SCRATCH2, hi, 32);
+		ZEXT_W(SCRATCH3, lo);
+		OR(SCRATCH2, SCRATCH2, SCRATCH3);
+		if (inst.op == IROp::Madd || inst.op == IROp::MaddU)
+			ADD(SCRATCH1, SCRATCH2, SCRATCH1);
+		else
+			SUB(SCRATCH1, SCRATCH2, SCRATCH1);
+	}
+	SEXT_W(lo, SCRATCH1);
+	SRAI(hi, SCRATCH1, 32);
+}
+
+void RiscVJit::CompIR_FTransfer(IRInst inst) {
+	// FPRs are f[n] == r[32 + n], and these only copy bits.
+	IRReg dest = inst.op == IROp::FMovToGPR ? inst.dest : inst.dest + 32;
+	IRReg src = inst.op == IROp::FMovFromGPR ? inst.src1 : inst.src1 + 32;
+	if (dest != src) {
+		gpr.MapDirtyIn(dest, src);
+		MV(gpr.R(dest), gpr.R(src));
+	}
+}
+
+s32 RiscVJit::PrepareAddress(IRInst inst) {
+	if (inst.src1 == MIPS_REG_ZERO) {
+		u32 addr = inst.constant;
+#ifdef MASKED_PSP_MEMORY
+		addr &= Memory::MEMVIEW32_MASK;
+#endif
+		// Leave the low bits for the load/store offset.
+		s32 lo = (s32)(addr << 20) >> 20;
+		LI(SCRATCH1, (s64)addr - lo);
+		ADD(SCRATCH1, SCRATCH1, MEMBASEREG);
+		return lo;
+	}
+
+	RiscVReg src = gpr.MapReg(inst.src1);
+	// The sum must wrap at 32 bits, so we can't use the load/store offset for the constant.
+	if (inst.constant == 0) {
+		ZEXT_W(SCRATCH1, src);
+	} else {
+		AddConst32(SCRATCH1, src, (s32)inst.constant);
+		ZEXT_W(SCRATCH1, SCRATCH1);
+	}
+#ifdef MASKED_PSP_MEMORY
+	LI(SCRATCH2, Memory::MEMVIEW32_MASK);
+	AND(SCRATCH1, SCRATCH1, SCRATCH2);
+#endif
+	ADD(SCRATCH1, SCRATCH1, MEMBASEREG);
+	return 0;
+}
+
+void RiscVJit::CompIR_Load(IRInst inst) {
+	s32 offset = PrepareAddress(inst);
+	// If dest == src1, it's fine: the address is read before the dest is written.
+	IRReg dest = inst.op == IROp::LoadFloat ? inst.dest + 32 : inst.dest;
+	RiscVReg rd = gpr.MapReg(dest, MAP_NOINIT);
+
+	switch (inst.op) {
+	case IROp::Load8:
+		LBU(rd, SCRATCH1, offset);
+		break;
+	case IROp::Load8Ext:
+		LB(rd, SCRATCH1, offset);
+		break;
+	case IROp::Load16:
+		LHU(rd, SCRATCH1, offset);
+		break;
+	case IROp::Load16Ext:
+		LH(rd, SCRATCH1, offset);
+		break;
+	case IROp::Load32:
+	case IROp::LoadFloat:
+		LW(rd, SCRATCH1, offset);
+		break;
+	default:
+		_assert_msg_(false, "Unexpected load op");
+		break;
+	}
+}
+
+void RiscVJit::CompIR_Store(IRInst inst) {
+	s32 offset = PrepareAddress(inst);
+	IRReg src = inst.op == IROp::StoreFloat ? inst.src3 + 32 : inst.src3;
+	RiscVReg rt = gpr.MapReg(src);
+
+	switch (inst.op) {
+	case IROp::Store8:
+		SB(rt, SCRATCH1, offset);
+		break;
+	case IROp::Store16:
+		SH(rt, SCRATCH1, offset);
+		break;
+	case IROp::Store32:
+	case IROp::StoreFloat:
+		SW(rt, SCRATCH1, offset);
+		break;
+	default:
+		_assert_msg_(false, "Unexpected store op");
+		break;
+	}
+}
+
+}  // namespace MIPSComp
+
+#endif
@@ -0,0 +1,589 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(RISCV64)
+
+#include <cstddef>
+#include <cstring>
+
+#include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
+#include "Core/Config.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/Debugger/SymbolMap.h"
+#include "Core/MemMap.h"
+#include "Core/System.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "Core/MIPS/RiscV/RiscVJit.h"
+
+// Static allocations (see also RiscVRegCache.cpp):
+// T0, T1, T2 - scratch
+// S11 - Base pointer of memory
+// S10 - Pointer to the MIPSState, at r[0]
+
+namespace MIPSComp {
+
+using namespace RiscVGen;
+using namespace RiscVJitConstants;
+
+// Runs a single IR instruction we don't have a native implementation for.
+// Returns 0, or the new PC if the instruction exits (like a breakpoint.)
+static u32 DoIRInstFallback(u64 value) {
+	IRInst inst[2];
+	memcpy(&inst[0], &value, sizeof(IRInst));
+	inst[1].op = IROp::ExitToConst;
+	inst[1].dest = 0;
+	inst[1].src1 = 0;
+	inst[1].src2 = 0;
+	inst[1].constant = 0;
+	return IRInterpret(currentMIPS, inst, 2);
+}
+
+RiscVJit::RiscVJit(MIPSState *mipsState) : IRJit(mipsState) {
+	static_assert(sizeof(IRInst) == 8, "IRInst should be 8 bytes for the fallback");
+	static_assert(MIPSSTATE_OFFSET(downcount) < 2048, "MIPSState vars must be reachable from CTXREG");
+
+	tiered_ = g_Config.bTieredJit;
+	gpr.Init(this);
+	AllocCodeSpace(1024 * 1024 * 16);
+	GenerateFixedCode();
+}
+
+RiscVJit::~RiscVJit() {
+}
+
+void RiscVJit::GenerateFixedCode() {
+	BeginWrite();
+
+	// RA and S0-S11 are callee saved.  Keep the stack 16-byte aligned.
+	static const RiscVReg savedRegs[] = { R_RA, S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11 };
+	const int frameSize = ((int)ARRAY_SIZE(savedRegs) * 8 + 15) & ~15;
+
+	enterDispatcher_ = AlignCode16();
+	ADDI(R_SP, R_SP, -frameSize);
+	for (int i = 0; i < (int)ARRAY_SIZE(savedRegs); ++i)
+		SD(savedRegs[i], R_SP, i * 8);
+	LI(MEMBASEREG, Memory::base);
+	LI(CTXREG, &mips_->r[0]);
+
+	outerLoop_ = GetCodePtr();
+		QuickCallFunction(SCRATCH1, &CoreTiming::Advance);
+		FixupBranch skipToCoreStateCheck = J();  // skip the downcount check
+
+		dispatcherCheckCoreState_ = GetCodePtr();
+		LW(SCRATCH1, CTXREG, MIPSSTATE_OFFSET(downcount));
+		FixupBranch bailCoreState = BLT(SCRATCH1, R_ZERO);
+
+		SetJumpTarget(skipToCoreStateCheck);
+		LI(SCRATCH1, (const void *)&coreState);
+		LW(SCRATCH1, SCRATCH1, 0);
+		FixupBranch badCoreState = BNEZ(SCRATCH1);
+		FixupBranch skipToRealDispatch = J();
+
+		dispatcher_ = GetCodePtr();
+			LW(SCRATCH1, CTXREG, MIPSSTATE_OFFSET(downcount));
+			FixupBranch bail = BLT(SCRATCH1, R_ZERO);
+			SetJumpTarget(skipToRealDispatch);
+
+			dispatcherNoCheck_ = GetCodePtr();
+			LWU(SCRATCH1, CTXREG, MIPSSTATE_OFFSET(pc));
+#ifdef MASKED_PSP_MEMORY
+			LI(SCRATCH2, Memory::MEMVIEW32_MASK);
+			AND(SCRATCH1, SCRATCH1, SCRATCH2);
+#endif
+			ADD(SCRATCH1, SCRATCH1, MEMBASEREG);
+			dispatcherFetch_ = GetCodePtr();
+			LWU(SCRATCH1, SCRATCH1, 0);
+			SRLI(SCRATCH2, SCRATCH1, 24);
+			_assert_msg_(MIPS_JITBLOCK_MASK == 0xFF000000, "Hardcoded assumption of emuhack mask");
+			LI(SCRATCH3, MIPS_EMUHACK_OPCODE >> 24);
+			FixupBranch notfound = BNE(SCRATCH2, SCRATCH3);
+				// Now the low 24 bits of SCRATCH1 are the IR block number.
+				SLLI(SCRATCH1, SCRATCH1, 40);
+				SRLI(SCRATCH1, SCRATCH1, 40);
+				LI(SCRATCH2, &blockOffsetsSize_);
+				LWU(SCRATCH2, SCRATCH2, 0);
+				FixupBranch outOfRange = BGEU(SCRATCH1, SCRATCH2);
+				LI(SCRATCH2, &blockOffsetsPtr_);
+				LD(SCRATCH2, SCRATCH2, 0);
+				SLLI(SCRATCH3, SCRATCH1, 2);
+				ADD(SCRATCH2, SCRATCH2, SCRATCH3);
+				LWU(SCRATCH2, SCRATCH2, 0);
+				FixupBranch noNative = BEQZ(SCRATCH2);
+				LI(SCRATCH3, GetBasePtr());
+				ADD(SCRATCH2, SCRATCH2, SCRATCH3);
+				JALR(R_ZERO, SCRATCH2, 0);
+
+				// Shouldn't normally happen, but we can always interpret the block.
+				SetJumpTarget(outOfRange);
+				SetJumpTarget(noNative);
+				interpretBlock_ = GetCodePtr();
+				MV(A1, SCRATCH1);
+				LI(A0, this);
+				QuickCallFunction(SCRATCH1, &RunBlockInterpreted);
+				SW(A0, CTXREG, MIPSSTATE_OFFSET(pc));
+				QuickJ(SCRATCH1, dispatcher_);
+			SetJumpTarget(notfound);
+
+			// Ok, no block, let's jit.
+			QuickCallFunction(SCRATCH1, &MIPSComp::JitAt);
+			QuickJ(SCRATCH1, dispatcherNoCheck_);
+
+		SetJumpTarget(bail);
+		SetJumpTarget(bailCoreState);
+
+		LI(SCRATCH1, (const void *)&coreState);
+		LW(SCRATCH1, SCRATCH1, 0);
+		FixupBranch keepGoing = BNEZ(SCRATCH1);
+		QuickJ(SCRATCH2, outerLoop_);
+		SetJumpTarget(keepGoing);
+
+	const u8 *quitLoop = GetCodePtr();
+	SetJumpTarget(badCoreState);
+	for (int i = 0; i < (int)ARRAY_SIZE(savedRegs); ++i)
+		LD(savedRegs[i], R_SP, i * 8);
+	ADDI(R_SP, R_SP, frameSize);
+	RET();
+
+	crashHandler_ = GetCodePtr();
+	LI(SCRATCH1, (const void *)&coreState);
+	LI(SCRATCH2, CORE_RUNTIME_ERROR);
+	SW(SCRATCH2, SCRATCH1, 0);
+	QuickJ(SCRATCH1, quitLoop);
+
+	// Let's spare the pre-generated code from unprotect-reprotect.
+	endOfPregeneratedCode_ = AlignCodePage();
+	FlushIcache();
+	EndWrite();
+}
+
+u32 RiscVJit::RunBlockInterpreted(RiscVJit *jit, u32 block_num) {
+	IRBlock *block = jit->blocks_.GetBlock(block_num);
+	if (jit->profiling_) {
+		int startDowncount = jit->mips_->downcount;
+		u32 pc = IRInterpret(jit->mips_, block->GetInterpretInstructions(), block->GetNumInstructions());
+		// The block may be gone if it ran a syscall that cleared the cache.
+		block = jit->blocks_.GetBlock(block_num);
+		if (block)
+			block->AddProfileSample(startDowncount - jit->mips_->downcount);
+		return pc;
+	}
+	if (jit->tiered_) {
+		if (block_num >= jit->blockRunCounts_.size())
+			jit->blockRunCounts_.resize(block_num + 1, 0);
+		// Only try once, if we're out of space it'll wait for the next clear.
+		if (++jit->blockRunCounts_[block_num] == TIERED_PROMOTE_COUNT)
+			jit->CompileTargetBlock(block, block_num);
+	}
+	// Even if promoted, run this time from the IR.  Next time the dispatcher will find it.
+	return IRInterpret(jit->mips_, block->GetInterpretInstructions(), block->GetNumInstructions());
+}
+
+void RiscVJit::RunLoopUntil(u64 globalticks) {
+	PROFILE_THIS_SCOPE("jit");
+	((void (*)())enterDispatcher_)();
+}
+
+void RiscVJit::ClearCache() {
+	IRJit::ClearCache();
+
+	int offset = (int)GetOffset(endOfPregeneratedCode_);
+	ClearCodeSpace(offset);
+	FlushIcacheSection(region + offset, region + region_size);
+	blockOffsets_.clear();
+	blockOffsetsPtr_ = nullptr;
+	blockOffsetsSize_ = 0;
+	blockRunCounts_.clear();
+	tiered_ = g_Config.bTieredJit;
+}
+
+bool RiscVJit::SetBlockProfiling(bool enable) {
+	if (enable != profiling_) {
+		IRJit::SetBlockProfiling(enable);
+		// Native blocks don't count, so switch everything over to (or back from) the interpreter.
+		ClearCache();
+	}
+	return true;
+}
+
+void RiscVJit::SetBlockOffset(int block_num, u32 offset) {
+	if ((size_t)block_num >= blockOffsets_.size()) {
+		blockOffsets_.resize(block_num + 1, 0);
+	}
+	blockOffsets_[block_num] = offset;
+	blockOffsetsPtr_ = blockOffsets_.data();
+	blockOffsetsSize_ = (u32)blockOffsets_.size();
+}
+
+bool RiscVJit::CompileNativeBlock(IRBlock *block, int block_num, bool preload) {
+	// When tiered, blocks start out interpreted and RunBlockInterpreted() promotes hot ones.
+	// Profiling counts in RunBlockInterpreted(), so nothing is native while it's on.
+	if (tiered_ || profiling_)
+		return true;
+	return CompileTargetBlock(block, block_num);
+}
+
+bool RiscVJit::CompileTargetBlock(IRBlock *block, int block_num) {
+	// Every op is 4 bytes.  Most IR ops take 1-4, a flushing exit or the fallback up to ~40.
+	size_t estimate = 0x100 + block->GetNumInstructions() * 160;
+	if (GetSpaceLeft() < 0x10000 || GetSpaceLeft() < estimate) {
+		return false;
+	}
+
+	BeginWrite(estimate);
+	const u8 *start = AlignCode16();
+	compilingBlockNum_ = block_num;
+	gpr.Start();
+
+	const IRInst *instructions = block->GetInstructions();
+	for (int i = 0; i < block->GetNumInstructions(); ++i) {
+		CompileIRInst(instructions[i]);
+		gpr.ReleaseSpillLocks();
+	}
+
+	// Blocks always end with an exit, so if we got here, the block was badly constructed.
+	gpr.FlushAll();
+	QuickJ(SCRATCH1, crashHandler_);
+
+	FlushIcache();
+	EndWrite();
+	compilingBlockNum_ = -1;
+
+	u32 startAddr, size;
+	block->GetRange(startAddr, size);
+	blocks_.GetCompileLog()->RecordNativeSize(startAddr, (u32)(GetCodePtr() - start));
+
+	u32 offset = (u32)GetOffset(start);
+	block->SetTargetOffset(offset);
+	SetBlockOffset(block_num, offset);
+	return true;
+}
+
+void RiscVJit::CompileIRInst(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Nop:
+		break;
+
+	case IROp::SetConst:
+	case IROp::SetConstF:
+	case IROp::Downcount:
+	case IROp::SetPC:
+	case IROp::SetPCConst:
+		CompIR_Basic(inst);
+		break;
+
+	case IROp::Add:
+	case IROp::Sub:
+	case IROp::AddConst:
+	case IROp::SubConst:
+	case IROp::Neg:
+		CompIR_Arith(inst);
+		break;
+
+	case IROp::And:
+	case IROp::Or:
+	case IROp::Xor:
+	case IROp::AndConst:
+	case IROp::OrConst:
+	case IROp::XorConst:
+	case IROp::Not:
+		CompIR_Logic(inst);
+		break;
+
+	case IROp::Mov:
+	case IROp::Ext8to32:
+	case IROp::Ext16to32:
+		CompIR_Assign(inst);
+		break;
+
+	case IROp::Shl:
+	case IROp::Shr:
+	case IROp::Sar:
+	case IROp::Ror:
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+	case IROp::RorImm:
+		CompIR_Shift(inst);
+		break;
+
+	case IROp::Slt:
+	case IROp::SltConst:
+	case IROp::SltU:
+	case IROp::SltUConst:
+		CompIR_Compare(inst);
+		break;
+
+	case IROp::MovZ:
+	case IROp::MovNZ:
+	case IROp::Max:
+	case IROp::Min:
+		CompIR_CondAssign(inst);
+		break;
+
+	case IROp::MtLo:
+	case IROp::MtHi:
+	case IROp::MfLo:
+	case IROp::MfHi:
+		CompIR_HiLo(inst);
+		break;
+
+	case IROp::Mult:
+	case IROp::MultU:
+	case IROp::Madd:
+	case IROp::MaddU:
+	case IROp::Msub:
+	case IROp::MsubU:
+		CompIR_Mult(inst);
+		break;
+
+	case IROp::Load8:
+	case IROp::Load8Ext:
+	case IROp::Load16:
+	case IROp::Load16Ext:
+	case IROp::Load32:
+	case IROp::LoadFloat:
+		CompIR_Load(inst);
+		break;
+
+	case IROp::Store8:
+	case IROp::Store16:
+	case IROp::Store32:
+	case IROp::StoreFloat:
+		CompIR_Store(inst);
+		break;
+
+	case IROp::FMov:
+	case IROp::FMovFromGPR:
+	case IROp::FMovToGPR:
+		CompIR_FTransfer(inst);
+		break;
+
+	case IROp::ExitToConst:
+		WriteExitToConst(inst.constant);
+		break;
+
+	case IROp::ExitToReg:
+		MV(SCRATCH1, gpr.MapReg(inst.src1));
+		WriteExitToScratch1();
+		break;
+
+	case IROp::ExitToPC:
+		gpr.FlushAll();
+		QuickJ(SCRATCH1, dispatcher_);
+		break;
+
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+	case IROp::ExitToConstIfGtZ:
+	case IROp::ExitToConstIfGeZ:
+	case IROp::ExitToConstIfLtZ:
+	case IROp::ExitToConstIfLeZ:
+	case IROp::ExitToConstIfFpTrue:
+	case IROp::ExitToConstIfFpFalse:
+		WriteConditionalExit(inst);
+		break;
+
+	case IROp::ApplyRoundingMode:
+	case IROp::RestoreRoundingMode:
+	case IROp::UpdateRoundingMode:
+		// Not implemented in the IR interpreter either.
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void RiscVJit::CompIR_Generic(IRInst inst) {
+	// All host regs are caller-saved from the regcache's perspective.
+	gpr.FlushAll();
+
+	u64 value;
+	memcpy(&value, &inst, sizeof(inst));
+	LI(A0, (s64)value);
+	QuickCallFunction(SCRATCH1, &DoIRInstFallback);
+
+	// A non-zero result means the instruction wants to exit (breakpoints, etc.)
+	FixupBranch skip = BEQZ(A0);
+	SW(A0, CTXREG, MIPSSTATE_OFFSET(pc));
+	QuickJ(SCRATCH1, dispatcher_);
+	SetJumpTarget(skip);
+}
+
+void RiscVJit::WriteExitToScratch1() {
+	gpr.FlushAll();
+	SW(SCRATCH1, CTXREG, MIPSSTATE_OFFSET(pc));
+	QuickJ(SCRATCH1, dispatcher_);
+}
+
+void RiscVJit::WriteExitToConst(u32 pc) {
+	gpr.FlushAll();
+	LoadConst32(SCRATCH1, pc);
+	SW(SCRATCH1, CTXREG, MIPSSTATE_OFFSET(pc));
+	QuickJ(SCRATCH1, dispatcher_);
+}
+
+void RiscVJit::WriteConditionalExit(IRInst inst) {
+	// We branch past the exit, so this is the condition to NOT exit.
+	FixupBranch skip;
+	switch (inst.op) {
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+		gpr.MapInIn(inst.src1, inst.src2);
+		if (inst.op == IROp::ExitToConstIfEq)
+			skip = BNE(gpr.R(inst.src1), gpr.R(inst.src2));
+		else
+			skip = BEQ(gpr.R(inst.src1), gpr.R(inst.src2));
+		break;
+
+	case IROp::ExitToConstIfGtZ:
+		skip = BGE(R_ZERO, gpr.MapReg(inst.src1));
+		break;
+	case IROp::ExitToConstIfGeZ:
+		skip = BLT(gpr.MapReg(inst.src1), R_ZERO);
+		break;
+	case IROp::ExitToConstIfLtZ:
+		skip = BGE(gpr.MapReg(inst.src1), R_ZERO);
+		break;
+	case IROp::ExitToConstIfLeZ:
+		skip = BLT(R_ZERO, gpr.MapReg(inst.src1));
+		break;
+
+	case IROp::ExitToConstIfFpTrue:
+		skip = BEQZ(gpr.MapReg(IRREG_FPCOND));
+		break;
+	case IROp::ExitToConstIfFpFalse:
+		skip = BNEZ(gpr.MapReg(IRREG_FPCOND));
+		break;
+
+	default:
+		_assert_msg_(false, "Unexpected conditional exit");
+		return;
+	}
+
+	// Flushing only emits stores, so the mapping is still accurate after the exit.
+	RiscVRegCache saved = gpr;
+	WriteExitToConst(inst.constant);
+	gpr = saved;
+	SetJumpTarget(skip);
+}
+
+void RiscVJit::LoadConst32(RiscVReg rd, u32 value) {
+	LI(rd, (s32)value);
+}
+
+void RiscVJit::AddConst32(RiscVReg rd, RiscVReg rs, s32 value) {
+	if (SignedFits12(value)) {
+		ADDIW(rd, rs, value);
+	} else {
+		LI(SCRATCH2, value);
+		ADDW(rd, rs, SCRATCH2);
+	}
+}
+
+void RiscVJit::CompIR_Basic(IRInst inst) {
+	switch (inst.op) {
+	case IROp::SetConst:
+		LoadConst32(gpr.MapReg(inst.dest, MAP_NOINIT), inst.constant);
+		break;
+
+	case IROp::SetConstF:
+		LoadConst32(gpr.MapReg(inst.dest + 32, MAP_NOINIT), inst.constant);
+		break;
+
+	case IROp::Downcount:
+		LW(SCRATCH1, CTXREG, MIPSSTATE_OFFSET(downcount));
+		AddConst32(SCRATCH1, SCRATCH1, -(s32)inst.constant);
+		SW(SCRATCH1, CTXREG, MIPSSTATE_OFFSET(downcount));
+		break;
+
+	case IROp::SetPC:
+		SW(gpr.MapReg(inst.src1), CTXREG, MIPSSTATE_OFFSET(pc));
+		break;
+
+	case IROp::SetPCConst:
+		LoadConst32(SCRATCH1, inst.constant);
+		SW(SCRATCH1, CTXREG, MIPSSTATE_OFFSET(pc));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+bool RiscVJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
+	if (ptr == enterDispatcher_)
+		name = "enterDispatcher";
+	else if (ptr == outerLoop_)
+		name = "outerLoop";
+	else if (ptr == dispatcherCheckCoreState_)
+		name = "dispatcherCheckCoreState";
+	else if (ptr == dispatcher_)
+		name = "dispatcher";
+	else if (ptr == dispatcherNoCheck_)
+		name = "dispatcherNoCheck";
+	else if (ptr == dispatcherFetch_)
+		name = "dispatcherFetch";
+	else if (ptr == interpretBlock_)
+		name = "interpretBlock";
+	else if (ptr == crashHandler_)
+		name = "crashHandler";
+	else if (!IsInSpace(ptr))
+		return false;
+	else if (ptr < endOfPregeneratedCode_)
+		name = "PreGenCode";
+	else {
+		// Find the closest block start before ptr.
+		u32 offset = (u32)GetOffset(ptr);
+		int best = -1;
+		u32 bestOffset = 0;
+		for (int i = 0; i < (int)blockOffsets_.size(); ++i) {
+			if (blockOffsets_[i] != 0 && blockOffsets_[i] <= offset && blockOffsets_[i] >= bestOffset) {
+				best = i;
+				bestOffset = blockOffsets_[i];
+			}
+		}
+
+		IRBlock *block = best == -1 ? nullptr : blocks_.GetBlock(best);
+		if (!block) {
+			name = "UnknownOrDeletedBlock";
+			return true;
+		}
+
+		u32 start, size;
+		block->GetRange(start, size);
+		char temp[1024];
+		const std::string label = g_symbolMap ? g_symbolMap->GetDescription(start) : "";
+		if (!label.empty())
+			snprintf(temp, sizeof(temp), "%08x_%s", start, label.c_str());
+		else
+			snprintf(temp, sizeof(temp), "%08x", start);
+		name = temp;
+	}
+	return true;
+}
+
+}  // namespace MIPSComp
+
+#endif
@@ -0,0 +1,126 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(RISCV64)
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Common/RiscVEmitter.h"
+#include "Core/MIPS/IR/IRJit.h"
+#include "Core/MIPS/RiscV/RiscVRegCache.h"
+
+// CTXREG points at r[0], and everything we access is within a 12-bit offset from there.
+#define MIPSSTATE_OFFSET(x) ((int)(offsetof(MIPSState, x) - offsetof(MIPSState, r[0])))
+
+namespace MIPSComp {
+
+// Runs the IR frontend and passes (the same as IRJit), but translates the resulting IR to RV64
+// instead of interpreting it.  IR ops without a native implementation call into the interpreter,
+// one instruction at a time, so every op is always supported.
+class RiscVJit : public IRJit, public RiscVGen::RiscVCodeBlock {
+public:
+	RiscVJit(MIPSState *mipsState);
+	~RiscVJit();
+
+	void RunLoopUntil(u64 globalticks) override;
+
+	void ClearCache() override;
+
+	bool CodeInRange(const u8 *ptr) const override {
+		return IsInSpace(ptr);
+	}
+	bool IsAtDispatchFetch(const u8 *ptr) const override {
+		return ptr == dispatcherFetch_;
+	}
+	bool DescribeCodePtr(const u8 *ptr, std::string &name) override;
+
+	const u8 *GetDispatcher() const override { return dispatcher_; }
+
+	bool SetBlockProfiling(bool enable) override;
+	const u8 *GetCrashHandler() const override { return crashHandler_; }
+
+protected:
+	bool CompileNativeBlock(IRBlock *block, int block_num, bool preload) override;
+
+private:
+	void GenerateFixedCode();
+	static u32 RunBlockInterpreted(RiscVJit *jit, u32 block_num);
+	bool CompileTargetBlock(IRBlock *block, int block_num);
+	void SetBlockOffset(int block_num, u32 offset);
+
+	void CompileIRInst(IRInst inst);
+	void CompIR_Generic(IRInst inst);
+
+	// Flushes and jumps to the dispatcher, with the new PC already in SCRATCH1.
+	void WriteExitToScratch1();
+	void WriteExitToConst(u32 pc);
+	void WriteConditionalExit(IRInst inst);
+
+	void CompIR_Basic(IRInst inst);
+	void CompIR_Arith(IRInst inst);
+	void CompIR_Logic(IRInst inst);
+	void CompIR_Assign(IRInst inst);
+	void CompIR_Shift(IRInst inst);
+	void CompIR_Compare(IRInst inst);
+	void CompIR_CondAssign(IRInst inst);
+	void CompIR_HiLo(IRInst inst);
+	void CompIR_Mult(IRInst inst);
+	void CompIR_Load(IRInst inst);
+	void CompIR_Store(IRInst inst);
+	// FPRs alias the GPR space at r[32], and these ops only move bits, so the regcache handles them.
+	void CompIR_FTransfer(IRInst inst);
+
+	// Computes the host address of the guest address in SCRATCH1 and returns the offset to use.
+	s32 PrepareAddress(IRInst inst);
+	// Loads a 32-bit IR constant in its sign extended form.
+	void LoadConst32(RiscVGen::RiscVReg rd, u32 value);
+	void AddConst32(RiscVGen::RiscVReg rd, RiscVGen::RiscVReg rs, s32 value);
+
+	RiscVRegCache gpr;
+
+	const u8 *enterDispatcher_ = nullptr;
+	const u8 *outerLoop_ = nullptr;
+	const u8 *dispatcherCheckCoreState_ = nullptr;
+	const u8 *dispatcher_ = nullptr;
+	const u8 *dispatcherNoCheck_ = nullptr;
+	const u8 *dispatcherFetch_ = nullptr;
+	const u8 *crashHandler_ = nullptr;
+	const u8 *interpretBlock_ = nullptr;
+	const u8 *endOfPregeneratedCode_ = nullptr;
+
+	// Native offset per IR block number, 0 if not compiled.  The dispatcher reads through
+	// blockOffsetsPtr_ since the vector may reallocate as it grows.
+	std::vector<u32> blockOffsets_;
+	const u32 *blockOffsetsPtr_ = nullptr;
+	u32 blockOffsetsSize_ = 0;
+
+	int compilingBlockNum_ = -1;
+
+	// Tiered mode: blocks are interpreted until they've run this many times.
+	static const u32 TIERED_PROMOTE_COUNT = 32;
+	bool tiered_ = false;
+	std::vector<u32> blockRunCounts_;
+};
+
+}  // namespace MIPSComp
+
+#endif
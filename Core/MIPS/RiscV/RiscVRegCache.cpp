@@ -0,0 +1,197 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(RISCV64)
+
+#include "Common/CommonTypes.h"
+#include "Common/Log.h"
+#include "Core/MIPS/RiscV/RiscVRegCache.h"
+
+using namespace RiscVGen;
+using namespace RiscVJitConstants;
+
+// T0-T2 are scratch, S10 the context, S11 the memory base.  ZERO, RA, SP, GP, TP are off limits.
+// Since we flush everything before calls, caller-saved registers are fine too.
+static const RiscVReg allocationOrder[] = {
+	S0, S1, S2, S3, S4, S5, S6, S7, S8, S9,
+	T3, T4, T5, T6,
+	A2, A3, A4, A5, A6, A7, A0, A1,
+};
+
+RiscVRegCache::RiscVRegCache() {
+	Start();
+}
+
+void RiscVRegCache::Init(RiscVEmitter *emitter) {
+	emit_ = emitter;
+}
+
+void RiscVRegCache::Start() {
+	for (int i = 0; i < NUM_RISCV_REGS; i++) {
+		hr_[i].irReg = IRREG_INVALID;
+		hr_[i].isDirty = false;
+		hr_[i].lastUse = 0;
+	}
+	for (int i = 0; i < TOTAL_MAPPABLE_IRREGS; i++) {
+		mr_[i].reg = INVALID_REG;
+		mr_[i].spillLock = false;
+	}
+	useCounter_ = 0;
+}
+
+int RiscVRegCache::MemOffset(IRReg r) const {
+	// CTXREG points at r[0], and all IR regs follow it contiguously.
+	return (int)r * 4;
+}
+
+bool RiscVRegCache::IsMapped(IRReg r) const {
+	return mr_[r].reg != INVALID_REG;
+}
+
+RiscVReg RiscVRegCache::R(IRReg r) const {
+	_dbg_assert_msg_(mr_[r].reg != INVALID_REG, "IR reg %d not mapped", r);
+	return mr_[r].reg;
+}
+
+RiscVReg RiscVRegCache::AllocateReg() {
+	for (RiscVReg reg : allocationOrder) {
+		if (hr_[reg].irReg == IRREG_INVALID)
+			return reg;
+	}
+
+	RiscVReg best = FindBestToSpill();
+	if (best != INVALID_REG) {
+		FlushHostReg(best);
+		return best;
+	}
+
+	_assert_msg_(false, "RiscVRegCache: all registers spill locked");
+	return INVALID_REG;
+}
+
+RiscVReg RiscVRegCache::FindBestToSpill() {
+	RiscVReg best = INVALID_REG;
+	u32 bestUse = 0xFFFFFFFF;
+	for (RiscVReg reg : allocationOrder) {
+		IRReg r = hr_[reg].irReg;
+		if (r == IRREG_INVALID || mr_[r].spillLock)
+			continue;
+		// Prefer the least recently used, and clean over dirty when tied.
+		u32 use = hr_[reg].lastUse * 2 + (hr_[reg].isDirty ? 1 : 0);
+		if (use < bestUse) {
+			bestUse = use;
+			best = reg;
+		}
+	}
+	return best;
+}
+
+RiscVReg RiscVRegCache::MapReg(IRReg r, int mapFlags) {
+	RiscVReg reg = mr_[r].reg;
+	if (reg == INVALID_REG) {
+		reg = AllocateReg();
+		if ((mapFlags & MAP_NOINIT) != MAP_NOINIT) {
+			// LW sign extends, which is the form we keep values in.
+			emit_->LW(reg, CTXREG, MemOffset(r));
+		}
+		hr_[reg].irReg = r;
+		hr_[reg].isDirty = false;
+		mr_[r].reg = reg;
+	}
+
+	if (mapFlags & MAP_DIRTY) {
+		_dbg_assert_msg_(r != MIPS_REG_ZERO, "Should not dirty the zero register");
+		hr_[reg].isDirty = true;
+	}
+	hr_[reg].lastUse = ++useCounter_;
+	mr_[r].spillLock = true;
+	return reg;
+}
+
+void RiscVRegCache::MapIn(IRReg rs) {
+	MapReg(rs);
+}
+
+void RiscVRegCache::MapInIn(IRReg rs, IRReg rt) {
+	SpillLock(rs, rt);
+	MapReg(rs);
+	MapReg(rt);
+}
+
+void RiscVRegCache::MapDirtyIn(IRReg rd, IRReg rs) {
+	SpillLock(rd, rs);
+	bool load = rd == rs;
+	MapReg(rs);
+	MapReg(rd, load ? MAP_DIRTY : MAP_NOINIT);
+}
+
+void RiscVRegCache::MapDirtyInIn(IRReg rd, IRReg rs, IRReg rt) {
+	SpillLock(rd, rs, rt);
+	bool load = rd == rs || rd == rt;
+	MapReg(rs);
+	MapReg(rt);
+	MapReg(rd, load ? MAP_DIRTY : MAP_NOINIT);
+}
+
+void RiscVRegCache::SpillLock(IRReg r1, IRReg r2, IRReg r3) {
+	mr_[r1].spillLock = true;
+	if (r2 != IRREG_INVALID)
+		mr_[r2].spillLock = true;
+	if (r3 != IRREG_INVALID)
+		mr_[r3].spillLock = true;
+}
+
+void RiscVRegCache::ReleaseSpillLocks() {
+	for (int i = 0; i < TOTAL_MAPPABLE_IRREGS; i++) {
+		mr_[i].spillLock = false;
+	}
+}
+
+void RiscVRegCache::FlushHostReg(RiscVReg hr) {
+	IRReg r = hr_[hr].irReg;
+	if (r == IRREG_INVALID)
+		return;
+	if (hr_[hr].isDirty) {
+		emit_->SW(hr, CTXREG, MemOffset(r));
+	}
+	hr_[hr].irReg = IRREG_INVALID;
+	hr_[hr].isDirty = false;
+	mr_[r].reg = INVALID_REG;
+}
+
+void RiscVRegCache::FlushR(IRReg r) {
+	if (mr_[r].reg != INVALID_REG)
+		FlushHostReg(mr_[r].reg);
+}
+
+void RiscVRegCache::DiscardR(IRReg r) {
+	RiscVReg hr = mr_[r].reg;
+	if (hr == INVALID_REG)
+		return;
+	hr_[hr].irReg = IRREG_INVALID;
+	hr_[hr].isDirty = false;
+	mr_[r].reg = INVALID_REG;
+}
+
+void RiscVRegCache::FlushAll() {
+	for (RiscVReg reg : allocationOrder) {
+		FlushHostReg(reg);
+	}
+}
+
+#endif
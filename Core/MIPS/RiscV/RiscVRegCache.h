@@ -0,0 +1,110 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+#include "Common/RiscVEmitter.h"
+#include "Core/MIPS/MIPS.h"
+
+// Register cache for the RISC-V IR backend.  Like the x64 one, it treats every IR reg
+// (GPRs, FPRs, VFPU regs, temps) as a 32-bit slot in the MIPSState, and caches them in GPRs.
+// All host registers are considered volatile across calls, so FlushAll() before any call.
+// Cached values are always kept sign extended to 64 bits, as the RV64 W ops produce them.
+
+typedef u8 IRReg;
+
+namespace RiscVJitConstants {
+
+const RiscVGen::RiscVReg MEMBASEREG = RiscVGen::S11;
+// Points at r[0], so a 12-bit offset reaches all IR regs and the rest of the MIPSState we use.
+const RiscVGen::RiscVReg CTXREG = RiscVGen::S10;
+
+// Scratch registers, never allocated.
+const RiscVGen::RiscVReg SCRATCH1 = RiscVGen::T0;
+const RiscVGen::RiscVReg SCRATCH2 = RiscVGen::T1;
+const RiscVGen::RiscVReg SCRATCH3 = RiscVGen::T2;
+
+const IRReg IRREG_INVALID = 255;
+
+enum {
+	TOTAL_MAPPABLE_IRREGS = 256,
+};
+
+// Initing is the default so the flag is reversed.
+enum {
+	MAP_DIRTY = 1,
+	MAP_NOINIT = 2 | MAP_DIRTY,
+};
+
+}  // namespace RiscVJitConstants
+
+class RiscVRegCache {
+public:
+	RiscVRegCache();
+
+	void Init(RiscVGen::RiscVEmitter *emitter);
+	// Resets all mappings, call at the start of each block.
+	void Start();
+
+	// Returns a host register containing the requested IR register.
+	RiscVGen::RiscVReg MapReg(IRReg r, int mapFlags = 0);
+	void MapIn(IRReg rs);
+	void MapInIn(IRReg rs, IRReg rt);
+	void MapDirtyIn(IRReg rd, IRReg rs);
+	void MapDirtyInIn(IRReg rd, IRReg rs, IRReg rt);
+
+	// Protect the host register containing an IR register from spilling.
+	void SpillLock(IRReg r1, IRReg r2 = RiscVJitConstants::IRREG_INVALID, IRReg r3 = RiscVJitConstants::IRREG_INVALID);
+	void ReleaseSpillLocks();
+
+	bool IsMapped(IRReg r) const;
+	RiscVGen::RiscVReg R(IRReg r) const;
+	// Offset of the IR reg from CTXREG.
+	int MemOffset(IRReg r) const;
+
+	// Writes back (if dirty) and unmaps.
+	void FlushR(IRReg r);
+	// Unmaps without writing back.
+	void DiscardR(IRReg r);
+	void FlushAll();
+
+private:
+	RiscVGen::RiscVReg AllocateReg();
+	RiscVGen::RiscVReg FindBestToSpill();
+	void FlushHostReg(RiscVGen::RiscVReg hr);
+
+	struct HostRegState {
+		IRReg irReg;
+		bool isDirty;
+		u32 lastUse;
+	};
+	struct IRRegState {
+		RiscVGen::RiscVReg reg;
+		bool spillLock;
+	};
+
+	enum {
+		NUM_RISCV_REGS = 32,
+	};
+
+	RiscVGen::RiscVEmitter *emit_ = nullptr;
+	u32 useCounter_ = 0;
+
+	HostRegState hr_[NUM_RISCV_REGS];
+	IRRegState mr_[RiscVJitConstants::TOTAL_MAPPABLE_IRREGS];
+};
@@ -23,6 +23,7 @@
 
 #include "Core/Config.h"
 #include "Core/Core.h"
+#include "Core/CoreTiming.h"
 #include "Core/Reporting.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/HLETables.h"
@@ -201,9 +202,12 @@ void Jit::CompBranchExits(CCFlags cc, u32 targetAddr, u32 notTakenAddr, bool del
 	if (andLink)
 		gpr.SetImm(MIPS_REG_RA, GetCompilerPC() + 8);
 
+	// A loop that only polls memory can't exit until an event runs, so we skip ahead to it.
+	bool idleLoop = !andLink && g_Config.bSkipIdleLoops && targetAddr <= GetCompilerPC() && MIPSAnalyst::IsIdleLoop(targetAddr, GetCompilerPC());
+
 	// We may want to try to continue along this branch a little while, to reduce reg flushing.
 	bool predictTakeBranch = PredictTakeBranch(targetAddr, likely);
-	if (CanContinueBranch(predictTakeBranch ? targetAddr : notTakenAddr))
+	if (!idleLoop && CanContinueBranch(predictTakeBranch ? targetAddr : notTakenAddr))
 	{
 		if (predictTakeBranch)
 			cc = FlipCCFlag(cc);
@@ -289,7 +293,17 @@ void Jit::CompBranchExits(CCFlags cc, u32 targetAddr, u32 notTakenAddr, bool del
 
 		// Take the branch
 		CONDITIONAL_LOG_EXIT(targetAddr);
-		WriteExit(targetAddr, js.nextExit++);
+		if (idleLoop) {
+			// Idle needs an up to date downcount.  The not taken exit still needs the full amount.
+			int downcountAmount = js.downcountAmount;
+			WriteDowncount();
+			js.downcountAmount = 0;
+			ABI_CallFunctionC(&CoreTiming::Idle, 0);
+			WriteExit(targetAddr, js.nextExit++);
+			js.downcountAmount = downcountAmount;
+		} else {
+			WriteExit(targetAddr, js.nextExit++);
+		}
 
 		// Not taken
 		SetJumpTarget(ptr);
@@ -21,6 +21,7 @@
 #include "Core/Config.h"
 #include "Core/MemMap.h"
 #include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/x86/Jit.h"
@@ -60,7 +61,7 @@ void Jit::CopyFPReg(X64Reg dst, OpArg src) {
 	}
 }
 
-void Jit::CompFPTriArith(MIPSOpcode op, void (XEmitter::*arith)(X64Reg reg, OpArg), bool orderMatters) {
+void Jit::CompFPTriArith(MIPSOpcode op, void (XEmitter::*arith)(X64Reg reg, OpArg), void (XEmitter::*avxArith)(X64Reg, X64Reg, OpArg), bool orderMatters) {
 	int ft = _FT;
 	int fs = _FS;
 	int fd = _FD;
@@ -72,6 +73,11 @@ void Jit::CompFPTriArith(MIPSOpcode op, void (XEmitter::*arith)(X64Reg reg, OpAr
 	} else if (ft == fd && !orderMatters) {
 		fpr.MapReg(fd, true, true);
 		(this->*arith)(fpr.RX(fd), fpr.R(fs));
+	} else if (cpu_info.bAVX) {
+		// The VEX form doesn't clobber a source, so no copy is needed even if fd is ft.
+		fpr.MapReg(fs, true, false);
+		fpr.MapReg(fd, ft == fd, true);
+		(this->*avxArith)(fpr.RX(fd), fpr.RX(fs), fpr.R(ft));
 	} else if (ft != fd) {
 		// fs can't be fd (handled above.)
 		fpr.MapReg(fd, false, true);
@@ -90,13 +96,13 @@ void Jit::CompFPTriArith(MIPSOpcode op, void (XEmitter::*arith)(X64Reg reg, OpAr
 void Jit::Comp_FPU3op(MIPSOpcode op) {
 	CONDITIONAL_DISABLE(FPU);
 	switch (op & 0x3f) {
-	case 0: CompFPTriArith(op, &XEmitter::ADDSS, false); break; //F(fd) = F(fs) + F(ft); //add
-	case 1: CompFPTriArith(op, &XEmitter::SUBSS, true); break;  //F(fd) = F(fs) - F(ft); //sub
+	case 0: CompFPTriArith(op, &XEmitter::ADDSS, &XEmitter::VADDSS, false); break; //F(fd) = F(fs) + F(ft); //add
+	case 1: CompFPTriArith(op, &XEmitter::SUBSS, &XEmitter::VSUBSS, true); break;  //F(fd) = F(fs) - F(ft); //sub
 	case 2: //F(fd) = F(fs) * F(ft); //mul
 		// XMM1 = !my_isnan(fs) && !my_isnan(ft)
 		MOVSS(XMM1, fpr.R(_FS));
 		CMPORDSS(XMM1, fpr.R(_FT));
-		CompFPTriArith(op, &XEmitter::MULSS, false);
+		CompFPTriArith(op, &XEmitter::MULSS, &XEmitter::VMULSS, false);
 
 		// fd must still be in a reg, save it in XMM0 for now.
 		MOVAPS(XMM0, fpr.R(_FD));
@@ -114,7 +120,7 @@ void Jit::Comp_FPU3op(MIPSOpcode op) {
 		// ANDN is backwards, which is why we saved XMM0 to start.  Now put it back.
 		ANDNPS(fpr.RX(_FD), R(XMM0));
 		break;
-	case 3: CompFPTriArith(op, &XEmitter::DIVSS, true); break;  //F(fd) = F(fs) / F(ft); //div
+	case 3: CompFPTriArith(op, &XEmitter::DIVSS, &XEmitter::VDIVSS, true); break;  //F(fd) = F(fs) / F(ft); //div
 	default:
 		_dbg_assert_msg_(false,"Trying to compile FPU3Op instruction that can't be interpreted");
 		break;
@@ -1050,19 +1050,23 @@ void Jit::Comp_VecDo3(MIPSOpcode op) {
 
 	if (allowSIMD && fpr.TryMapDirtyInInVS(dregs, sz, sregs, sz, tregs, sz)) {
 		void (XEmitter::*opFunc)(X64Reg, OpArg) = nullptr;
+		void (XEmitter::*avxOpFunc)(int, X64Reg, X64Reg, OpArg) = nullptr;
 		bool symmetric = false;
 		switch (op >> 26) {
 		case 24: //VFPU0
 			switch ((op >> 23) & 7) {
 			case 0: // d[i] = s[i] + t[i]; break; //vadd
 				opFunc = &XEmitter::ADDPS;
+				avxOpFunc = &XEmitter::VADDPS;
 				symmetric = true;
 				break;
 			case 1: // d[i] = s[i] - t[i]; break; //vsub
 				opFunc = &XEmitter::SUBPS;
+				avxOpFunc = &XEmitter::VSUBPS;
 				break;
 			case 7: // d[i] = s[i] / t[i]; break; //vdiv
 				opFunc = &XEmitter::DIVPS;
+				avxOpFunc = &XEmitter::VDIVPS;
 				break;
 			}
 			break;
@@ -1071,6 +1075,7 @@ void Jit::Comp_VecDo3(MIPSOpcode op) {
 			{
 			case 0: // d[i] = s[i] * t[i]; break; //vmul
 				opFunc = &XEmitter::MULPS;
+				avxOpFunc = &XEmitter::VMULPS;
 				symmetric = true;
 				break;
 			}
@@ -1112,7 +1117,10 @@ void Jit::Comp_VecDo3(MIPSOpcode op) {
 			break;
 		}
 
-		if (opFunc != nullptr) {
+		if (avxOpFunc != nullptr && cpu_info.bAVX) {
+			// Three operands, so no copies regardless of overlap.
+			(this->*avxOpFunc)(128, fpr.VSX(dregs), fpr.VSX(sregs), fpr.VS(tregs));
+		} else if (opFunc != nullptr) {
 			if (fpr.VSX(dregs) != fpr.VSX(tregs)) {
 				if (fpr.VSX(dregs) != fpr.VSX(sregs)) {
 					MOVAPS(fpr.VSX(dregs), fpr.VS(sregs));
@@ -0,0 +1,470 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(AMD64)
+
+#include "Common/CPUDetect.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/x86/RegCache.h"
+#include "Core/MIPS/x86/X64IRJit.h"
+
+// All host registers in the regcache hold zero-extended 32-bit values, since every 32-bit
+// x64 op clears the upper half.  Addressing relies on this.
+
+namespace MIPSComp {
+
+using namespace Gen;
+using namespace X64JitConstants;
+using namespace X64IRJitConstants;
+
+void X64IRJit::CompIR_Arith(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Add:
+	case IROp::Sub:
+	{
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		X64Reg rd = gpr.R(inst.dest);
+		X64Reg rs = gpr.R(inst.src1);
+		X64Reg rt = gpr.R(inst.src2);
+		if (inst.op == IROp::Add && rd == rt) {
+			ADD(32, R(rd), R(rs));
+		} else if (rd == rt && rd != rs) {
+			MOV(32, R(SCRATCH1), R(rs));
+			SUB(32, R(SCRATCH1), R(rt));
+			MOV(32, R(rd), R(SCRATCH1));
+		} else {
+			if (rd != rs)
+				MOV(32, R(rd), R(rs));
+			if (inst.op == IROp::Add)
+				ADD(32, R(rd), R(rt));
+			else
+				SUB(32, R(rd), R(rt));
+		}
+		break;
+	}
+
+	case IROp::AddConst:
+	case IROp::SubConst:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		X64Reg rd = gpr.R(inst.dest);
+		X64Reg rs = gpr.R(inst.src1);
+		if (rd != rs)
+			MOV(32, R(rd), R(rs));
+		if (inst.op == IROp::AddConst)
+			ADD(32, R(rd), SImmAuto((s32)inst.constant));
+		else
+			SUB(32, R(rd), SImmAuto((s32)inst.constant));
+		break;
+	}
+
+	case IROp::Neg:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		X64Reg rd = gpr.R(inst.dest);
+		if (rd != gpr.R(inst.src1))
+			MOV(32, R(rd), R(gpr.R(inst.src1)));
+		NEG(32, R(rd));
+		break;
+	}
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_Logic(IRInst inst) {
+	switch (inst.op) {
+	case IROp::And:
+	case IROp::Or:
+	case IROp::Xor:
+	{
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		X64Reg rd = gpr.R(inst.dest);
+		X64Reg rs = gpr.R(inst.src1);
+		X64Reg rt = gpr.R(inst.src2);
+		// All of these are commutative, so just pick the side we can use in place.
+		X64Reg other = rt;
+		if (rd == rt) {
+			other = rs;
+		} else if (rd != rs) {
+			MOV(32, R(rd), R(rs));
+		}
+		if (inst.op == IROp::And)
+			AND(32, R(rd), R(other));
+		else if (inst.op == IROp::Or)
+			OR(32, R(rd), R(other));
+		else
+			XOR(32, R(rd), R(other));
+		break;
+	}
+
+	case IROp::AndConst:
+	case IROp::OrConst:
+	case IROp::XorConst:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		X64Reg rd = gpr.R(inst.dest);
+		X64Reg rs = gpr.R(inst.src1);
+		if (rd != rs)
+			MOV(32, R(rd), R(rs));
+		if (inst.op == IROp::AndConst)
+			AND(32, R(rd), SImmAuto((s32)inst.constant));
+		else if (inst.op == IROp::OrConst)
+			OR(32, R(rd), SImmAuto((s32)inst.constant));
+		else
+			XOR(32, R(rd), SImmAuto((s32)inst.constant));
+		break;
+	}
+
+	case IROp::Not:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		X64Reg rd = gpr.R(inst.dest);
+		if (rd != gpr.R(inst.src1))
+			MOV(32, R(rd), R(gpr.R(inst.src1)));
+		NOT(32, R(rd));
+		break;
+	}
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_Assign(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Mov:
+		if (inst.dest != inst.src1) {
+			gpr.MapDirtyIn(inst.dest, inst.src1);
+			MOV(32, R(gpr.R(inst.dest)), R(gpr.R(inst.src1)));
+		}
+		break;
+
+	case IROp::Ext8to32:
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		MOVSX(32, 8, gpr.R(inst.dest), R(gpr.R(inst.src1)));
+		break;
+
+	case IROp::Ext16to32:
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		MOVSX(32, 16, gpr.R(inst.dest), R(gpr.R(inst.src1)));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_Bits(IRInst inst) {
+	switch (inst.op) {
+	case IROp::BSwap16:
+	case IROp::BSwap32:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		X64Reg rd = gpr.R(inst.dest);
+		if (rd != gpr.R(inst.src1))
+			MOV(32, R(rd), R(gpr.R(inst.src1)));
+		BSWAP(32, rd);
+		// Swapping all four and rotating gives us swapped pairs.
+		if (inst.op == IROp::BSwap16)
+			ROR(32, R(rd), Imm8(16));
+		break;
+	}
+
+	case IROp::Clz:
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		if (cpu_info.bLZCNT) {
+			LZCNT(32, gpr.R(inst.dest), R(gpr.R(inst.src1)));
+		} else {
+			// BSR sets ZF and leaves the dest undefined for zero.
+			BSR(32, SCRATCH1, R(gpr.R(inst.src1)));
+			FixupBranch notFound = J_CC(CC_Z);
+			XOR(32, R(SCRATCH1), Imm8(31));
+			FixupBranch done = J();
+			SetJumpTarget(notFound);
+			MOV(32, R(SCRATCH1), Imm32(32));
+			SetJumpTarget(done);
+			MOV(32, R(gpr.R(inst.dest)), R(SCRATCH1));
+		}
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_Shift(IRInst inst) {
+	switch (inst.op) {
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+	case IROp::RorImm:
+	{
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		X64Reg rd = gpr.R(inst.dest);
+		if (rd != gpr.R(inst.src1))
+			MOV(32, R(rd), R(gpr.R(inst.src1)));
+		u8 sa = inst.src2 & 31;
+		switch (inst.op) {
+		case IROp::ShlImm: SHL(32, R(rd), Imm8(sa)); break;
+		case IROp::ShrImm: SHR(32, R(rd), Imm8(sa)); break;
+		case IROp::SarImm: SAR(32, R(rd), Imm8(sa)); break;
+		case IROp::RorImm: ROR(32, R(rd), Imm8(sa)); break;
+		default: break;
+		}
+		break;
+	}
+
+	case IROp::Shl:
+	case IROp::Shr:
+	case IROp::Sar:
+	case IROp::Ror:
+	{
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		X64Reg rd = gpr.R(inst.dest);
+		// The count must be in CL, before we clobber rd (which may be src2.)  x64 masks it to 5 bits.
+		MOV(32, R(SCRATCH3), R(gpr.R(inst.src2)));
+		if (rd != gpr.R(inst.src1))
+			MOV(32, R(rd), R(gpr.R(inst.src1)));
+		switch (inst.op) {
+		case IROp::Shl: SHL(32, R(rd), R(CL)); break;
+		case IROp::Shr: SHR(32, R(rd), R(CL)); break;
+		case IROp::Sar: SAR(32, R(rd), R(CL)); break;
+		case IROp::Ror: ROR(32, R(rd), R(CL)); break;
+		default: break;
+		}
+		break;
+	}
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_Compare(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Slt:
+	case IROp::SltU:
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		XOR(32, R(SCRATCH1), R(SCRATCH1));
+		CMP(32, R(gpr.R(inst.src1)), R(gpr.R(inst.src2)));
+		SETcc(inst.op == IROp::Slt ? CC_L : CC_B, R(SCRATCH1));
+		MOV(32, R(gpr.R(inst.dest)), R(SCRATCH1));
+		break;
+
+	case IROp::SltConst:
+	case IROp::SltUConst:
+		gpr.MapDirtyIn(inst.dest, inst.src1);
+		XOR(32, R(SCRATCH1), R(SCRATCH1));
+		// The immediate is sign extended either way, which is what we want for 32 bits.
+		CMP(32, R(gpr.R(inst.src1)), SImmAuto((s32)inst.constant));
+		SETcc(inst.op == IROp::SltConst ? CC_L : CC_B, R(SCRATCH1));
+		MOV(32, R(gpr.R(inst.dest)), R(SCRATCH1));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_CondAssign(IRInst inst) {
+	switch (inst.op) {
+	case IROp::MovZ:
+	case IROp::MovNZ:
+	{
+		// The dest keeps its value when the condition fails, so it must be loaded.
+		gpr.SpillLock(inst.dest, inst.src1, inst.src2);
+		X64Reg rs = gpr.MapReg(inst.src1);
+		X64Reg rt = gpr.MapReg(inst.src2);
+		X64Reg rd = gpr.MapReg(inst.dest, MAP_DIRTY);
+		TEST(32, R(rs), R(rs));
+		CMOVcc(32, rd, R(rt), inst.op == IROp::MovZ ? CC_Z : CC_NZ);
+		break;
+	}
+
+	case IROp::Max:
+	case IROp::Min:
+	{
+		gpr.MapDirtyInIn(inst.dest, inst.src1, inst.src2);
+		X64Reg rd = gpr.R(inst.dest);
+		X64Reg rs = gpr.R(inst.src1);
+		X64Reg rt = gpr.R(inst.src2);
+		X64Reg other = rt;
+		if (rd == rt) {
+			other = rs;
+		} else if (rd != rs) {
+			MOV(32, R(rd), R(rs));
+		}
+		// Replace rd with the other when it's "better."
+		CMP(32, R(rd), R(other));
+		CMOVcc(32, rd, R(other), inst.op == IROp::Max ? CC_L : CC_G);
+		break;
+	}
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_HiLo(IRInst inst) {
+	switch (inst.op) {
+	case IROp::MtLo:
+		gpr.MapDirtyIn(IRREG_LO, inst.src1);
+		MOV(32, R(gpr.R(IRREG_LO)), R(gpr.R(inst.src1)));
+		break;
+
+	case IROp::MtHi:
+		gpr.MapDirtyIn(IRREG_HI, inst.src1);
+		MOV(32, R(gpr.R(IRREG_HI)), R(gpr.R(inst.src1)));
+		break;
+
+	case IROp::MfLo:
+		gpr.MapDirtyIn(inst.dest, IRREG_LO);
+		MOV(32, R(gpr.R(inst.dest)), R(gpr.R(IRREG_LO)));
+		break;
+
+	case IROp::MfHi:
+		gpr.MapDirtyIn(inst.dest, IRREG_HI);
+		MOV(32, R(gpr.R(inst.dest)), R(gpr.R(IRREG_HI)));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_Mult(IRInst inst) {
+	bool isSigned = inst.op == IROp::Mult || inst.op == IROp::Madd || inst.op == IROp::Msub;
+	bool accumulate = inst.op != IROp::Mult && inst.op != IROp::MultU;
+
+	gpr.MapInIn(inst.src1, inst.src2);
+	// The low 64 bits of a 64-bit multiply are the same signed or unsigned.
+	if (isSigned) {
+		MOVSX(64, 32, RAX, R(gpr.R(inst.src1)));
+		MOVSX(64, 32, RDX, R(gpr.R(inst.src2)));
+	} else {
+		MOV(32, R(EAX), R(gpr.R(inst.src1)));
+		MOV(32, R(EDX), R(gpr.R(inst.src2)));
+	}
+	IMUL(64, RAX, R(RDX));
+
+	gpr.SpillLock(IRREG_LO, IRREG_HI);
+	X64Reg lo = gpr.MapReg(IRREG_LO, accumulate ? MAP_DIRTY : MAP_NOINIT);
+	X64Reg hi = gpr.MapReg(IRREG_HI, accumulate ? MAP_DIRTY : MAP_NOINIT);
+	if (accumulate) {
+		MOV(32, R(RDX), R(hi));
+		SHL(64, R(RDX), Imm8(32));
+		OR(64, R(RDX), R(lo));
+		if (inst.op == IROp::Madd || inst.op == IROp::MaddU) {
+			ADD(64, R(RAX), R(RDX));
+		} else {
+			SUB(64, R(RDX), R(RAX));
+			MOV(64, R(RAX), R(RDX));
+		}
+	}
+	MOV(32, R(lo), R(EAX));
+	SHR(64, R(RAX), Imm8(32));
+	MOV(32, R(hi), R(EAX));
+}
+
+OpArg X64IRJit::PrepareAddress(IRInst inst) {
+	if (inst.src1 == MIPS_REG_ZERO) {
+		u32 addr = inst.constant;
+#ifdef MASKED_PSP_MEMORY
+		addr &= Memory::MEMVIEW32_MASK;
+#endif
+		if (addr < 0x80000000) {
+			return MDisp(MEMBASEREG, (int)addr);
+		}
+		MOV(32, R(SCRATCH1), Imm32(addr));
+		return MComplex(MEMBASEREG, SCRATCH1, SCALE_1, 0);
+	}
+
+	X64Reg src = gpr.MapReg(inst.src1);
+#ifndef MASKED_PSP_MEMORY
+	if (inst.constant == 0) {
+		return MComplex(MEMBASEREG, src, SCALE_1, 0);
+	}
+#endif
+	MOV(32, R(SCRATCH1), R(src));
+	ADD(32, R(SCRATCH1), SImmAuto((s32)inst.constant));
+#ifdef MASKED_PSP_MEMORY
+	AND(32, R(SCRATCH1), Imm32(Memory::MEMVIEW32_MASK));
+#endif
+	return MComplex(MEMBASEREG, SCRATCH1, SCALE_1, 0);
+}
+
+void X64IRJit::CompIR_Load(IRInst inst) {
+	OpArg addr = PrepareAddress(inst);
+	// If dest == src1, it's fine: the address is read before the dest is written.
+	X64Reg rd = gpr.MapReg(inst.dest, MAP_NOINIT);
+
+	switch (inst.op) {
+	case IROp::Load8:
+		MOVZX(32, 8, rd, addr);
+		break;
+	case IROp::Load8Ext:
+		MOVSX(32, 8, rd, addr);
+		break;
+	case IROp::Load16:
+		MOVZX(32, 16, rd, addr);
+		break;
+	case IROp::Load16Ext:
+		MOVSX(32, 16, rd, addr);
+		break;
+	case IROp::Load32:
+		MOV(32, R(rd), addr);
+		break;
+	default:
+		_assert_msg_(false, "Unexpected load op");
+		break;
+	}
+}
+
+void X64IRJit::CompIR_Store(IRInst inst) {
+	OpArg addr = PrepareAddress(inst);
+	X64Reg rt = gpr.MapReg(inst.src3);
+
+	switch (inst.op) {
+	case IROp::Store8:
+		MOV(8, addr, R(rt));
+		break;
+	case IROp::Store16:
+		MOV(16, addr, R(rt));
+		break;
+	case IROp::Store32:
+		MOV(32, addr, R(rt));
+		break;
+	default:
+		_assert_msg_(false, "Unexpected store op");
+		break;
+	}
+}
+
+}  // namespace MIPSComp
+
+#endif
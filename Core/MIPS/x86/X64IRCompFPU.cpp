@@ -0,0 +1,289 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(AMD64)
+
+#include "Core/MIPS/x86/RegCache.h"
+#include "Core/MIPS/x86/X64IRJit.h"
+
+// FPRs are not register cached (yet.)  Each op works on XMM0/XMM1 directly against the
+// MIPSState.  Everything uses unaligned moves so we don't depend on the alignment of MIPSState.
+
+namespace MIPSComp {
+
+using namespace Gen;
+using namespace X64JitConstants;
+using namespace X64IRJitConstants;
+
+alignas(16) static const float vec4InitValues[8][4] = {
+	{ 0.0f, 0.0f, 0.0f, 0.0f },
+	{ 1.0f, 1.0f, 1.0f, 1.0f },
+	{ -1.0f, -1.0f, -1.0f, -1.0f },
+	{ 1.0f, 0.0f, 0.0f, 0.0f },
+	{ 0.0f, 1.0f, 0.0f, 0.0f },
+	{ 0.0f, 0.0f, 1.0f, 0.0f },
+	{ 0.0f, 0.0f, 0.0f, 1.0f },
+};
+
+alignas(16) static const u32 signBits[4] = {
+	0x80000000, 0x80000000, 0x80000000, 0x80000000,
+};
+
+alignas(16) static const u32 noSignMask[4] = {
+	0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF,
+};
+
+OpArg X64IRJit::FPRLoc(IRReg fpr) const {
+	// CTXREG points at f[0].
+	return MDisp(CTXREG, (int)fpr * 4);
+}
+
+void X64IRJit::FlushAliasedFPR(IRReg fpr, int count) {
+	for (int i = 0; i < count; ++i) {
+		int asGPR = fpr + i + 32;
+		if (asGPR < TOTAL_MAPPABLE_IRREGS)
+			gpr.FlushR((IRReg)asGPR);
+	}
+}
+
+void X64IRJit::CompIR_FArith(IRInst inst) {
+	switch (inst.op) {
+	case IROp::FAdd:
+	case IROp::FSub:
+	case IROp::FMul:
+	case IROp::FDiv:
+		FlushAliasedFPR(inst.dest);
+		FlushAliasedFPR(inst.src1);
+		FlushAliasedFPR(inst.src2);
+		MOVSS(XMM0, FPRLoc(inst.src1));
+		switch (inst.op) {
+		case IROp::FAdd: ADDSS(XMM0, FPRLoc(inst.src2)); break;
+		case IROp::FSub: SUBSS(XMM0, FPRLoc(inst.src2)); break;
+		case IROp::FMul: MULSS(XMM0, FPRLoc(inst.src2)); break;
+		case IROp::FDiv: DIVSS(XMM0, FPRLoc(inst.src2)); break;
+		default: break;
+		}
+		MOVSS(FPRLoc(inst.dest), XMM0);
+		break;
+
+	case IROp::FSqrt:
+		FlushAliasedFPR(inst.dest);
+		FlushAliasedFPR(inst.src1);
+		SQRTSS(XMM0, FPRLoc(inst.src1));
+		MOVSS(FPRLoc(inst.dest), XMM0);
+		break;
+
+	case IROp::FNeg:
+	case IROp::FAbs:
+		// Just bit ops, no need for XMM regs.
+		FlushAliasedFPR(inst.dest);
+		FlushAliasedFPR(inst.src1);
+		MOV(32, R(SCRATCH1), FPRLoc(inst.src1));
+		if (inst.op == IROp::FNeg)
+			XOR(32, R(SCRATCH1), Imm32(0x80000000));
+		else
+			AND(32, R(SCRATCH1), Imm32(0x7FFFFFFF));
+		MOV(32, FPRLoc(inst.dest), R(SCRATCH1));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_FAssign(IRInst inst) {
+	switch (inst.op) {
+	case IROp::FMov:
+		if (inst.dest != inst.src1) {
+			FlushAliasedFPR(inst.dest);
+			FlushAliasedFPR(inst.src1);
+			MOV(32, R(SCRATCH1), FPRLoc(inst.src1));
+			MOV(32, FPRLoc(inst.dest), R(SCRATCH1));
+		}
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_FTransfer(IRInst inst) {
+	switch (inst.op) {
+	case IROp::FMovFromGPR:
+		FlushAliasedFPR(inst.dest);
+		MOV(32, FPRLoc(inst.dest), R(gpr.MapReg(inst.src1)));
+		break;
+
+	case IROp::FMovToGPR:
+		FlushAliasedFPR(inst.src1);
+		MOV(32, R(gpr.MapReg(inst.dest, MAP_NOINIT)), FPRLoc(inst.src1));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_FLoadStore(IRInst inst) {
+	switch (inst.op) {
+	case IROp::LoadFloat:
+	{
+		FlushAliasedFPR(inst.dest);
+		OpArg addr = PrepareAddress(inst);
+		MOV(32, R(SCRATCH2), addr);
+		MOV(32, FPRLoc(inst.dest), R(SCRATCH2));
+		break;
+	}
+
+	case IROp::StoreFloat:
+	{
+		FlushAliasedFPR(inst.src3);
+		OpArg addr = PrepareAddress(inst);
+		MOV(32, R(SCRATCH2), FPRLoc(inst.src3));
+		MOV(32, addr, R(SCRATCH2));
+		break;
+	}
+
+	case IROp::LoadVec4:
+	{
+		FlushAliasedFPR(inst.dest, 4);
+		OpArg addr = PrepareAddress(inst);
+		MOVUPS(XMM0, addr);
+		MOVUPS(FPRLoc(inst.dest), XMM0);
+		break;
+	}
+
+	case IROp::StoreVec4:
+	{
+		FlushAliasedFPR(inst.dest, 4);
+		OpArg addr = PrepareAddress(inst);
+		MOVUPS(XMM0, FPRLoc(inst.dest));
+		MOVUPS(addr, XMM0);
+		break;
+	}
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_VecArith(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Vec4Add:
+	case IROp::Vec4Sub:
+	case IROp::Vec4Mul:
+	case IROp::Vec4Div:
+		FlushAliasedFPR(inst.dest, 4);
+		FlushAliasedFPR(inst.src1, 4);
+		FlushAliasedFPR(inst.src2, 4);
+		MOVUPS(XMM0, FPRLoc(inst.src1));
+		MOVUPS(XMM1, FPRLoc(inst.src2));
+		switch (inst.op) {
+		case IROp::Vec4Add: ADDPS(XMM0, R(XMM1)); break;
+		case IROp::Vec4Sub: SUBPS(XMM0, R(XMM1)); break;
+		case IROp::Vec4Mul: MULPS(XMM0, R(XMM1)); break;
+		case IROp::Vec4Div: DIVPS(XMM0, R(XMM1)); break;
+		default: break;
+		}
+		MOVUPS(FPRLoc(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Scale:
+		FlushAliasedFPR(inst.dest, 4);
+		FlushAliasedFPR(inst.src1, 4);
+		FlushAliasedFPR(inst.src2);
+		MOVUPS(XMM0, FPRLoc(inst.src1));
+		MOVSS(XMM1, FPRLoc(inst.src2));
+		SHUFPS(XMM1, R(XMM1), 0);
+		MULPS(XMM0, R(XMM1));
+		MOVUPS(FPRLoc(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Dot:
+		FlushAliasedFPR(inst.dest);
+		FlushAliasedFPR(inst.src1, 4);
+		FlushAliasedFPR(inst.src2, 4);
+		MOVUPS(XMM0, FPRLoc(inst.src1));
+		MOVUPS(XMM1, FPRLoc(inst.src2));
+		MULPS(XMM0, R(XMM1));
+		// Add the lanes in order, like the interpreter.  ADDSS leaves lanes 1-3 alone.
+		for (int lane = 1; lane < 4; ++lane) {
+			MOVAPS(XMM1, R(XMM0));
+			SHUFPS(XMM1, R(XMM1), (u8)(lane * 0x55));
+			ADDSS(XMM0, R(XMM1));
+		}
+		MOVSS(FPRLoc(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Neg:
+	case IROp::Vec4Abs:
+		FlushAliasedFPR(inst.dest, 4);
+		FlushAliasedFPR(inst.src1, 4);
+		MOV(PTRBITS, R(SCRATCH1), ImmPtr(inst.op == IROp::Vec4Neg ? signBits : noSignMask));
+		MOVUPS(XMM0, FPRLoc(inst.src1));
+		if (inst.op == IROp::Vec4Neg)
+			XORPS(XMM0, MatR(SCRATCH1));
+		else
+			ANDPS(XMM0, MatR(SCRATCH1));
+		MOVUPS(FPRLoc(inst.dest), XMM0);
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_VecAssign(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Vec4Init:
+		FlushAliasedFPR(inst.dest, 4);
+		MOV(PTRBITS, R(SCRATCH1), ImmPtr(vec4InitValues[inst.src1 & 7]));
+		MOVAPS(XMM0, MatR(SCRATCH1));
+		MOVUPS(FPRLoc(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Mov:
+		FlushAliasedFPR(inst.dest, 4);
+		FlushAliasedFPR(inst.src1, 4);
+		MOVUPS(XMM0, FPRLoc(inst.src1));
+		MOVUPS(FPRLoc(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Shuffle:
+		// The IR uses the same lane selector encoding as SHUFPS.
+		FlushAliasedFPR(inst.dest, 4);
+		FlushAliasedFPR(inst.src1, 4);
+		MOVUPS(XMM0, FPRLoc(inst.src1));
+		SHUFPS(XMM0, R(XMM0), (u8)inst.src2);
+		MOVUPS(FPRLoc(inst.dest), XMM0);
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+}  // namespace MIPSComp
+
+#endif
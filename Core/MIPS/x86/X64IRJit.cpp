@@ -0,0 +1,604 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(AMD64)
+
+#include <cstring>
+
+#include "Common/ABI.h"
+#include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
+#include "Core/Config.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/Debugger/SymbolMap.h"
+#include "Core/MemMap.h"
+#include "Core/System.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "Core/MIPS/x86/RegCache.h"
+#include "Core/MIPS/x86/X64IRJit.h"
+
+// Static allocations (see also X64IRRegCache.cpp):
+// RAX, RCX, RDX - scratch
+// RBX - Base pointer of memory
+// R14 - Pointer to fpr/gpr regs (at f[0], same as the regular x86 jit)
+
+namespace MIPSComp {
+
+using namespace Gen;
+using namespace X64JitConstants;
+using namespace X64IRJitConstants;
+
+// Runs a single IR instruction we don't have a native implementation for.
+// Returns 0, or the new PC if the instruction exits (like a breakpoint.)
+static u32 DoIRInstFallback(u64 value) {
+	IRInst inst[2];
+	memcpy(&inst[0], &value, sizeof(IRInst));
+	inst[1].op = IROp::ExitToConst;
+	inst[1].dest = 0;
+	inst[1].src1 = 0;
+	inst[1].src2 = 0;
+	inst[1].constant = 0;
+	return IRInterpret(currentMIPS, inst, 2);
+}
+
+X64IRJit::X64IRJit(MIPSState *mipsState) : IRJit(mipsState) {
+	static_assert(sizeof(IRInst) == 8, "IRInst should be 8 bytes for the fallback");
+
+	tiered_ = g_Config.bTieredJit;
+	gpr.Init(this);
+	AllocCodeSpace(1024 * 1024 * 16);
+	GenerateFixedCode();
+}
+
+X64IRJit::~X64IRJit() {
+}
+
+void X64IRJit::GenerateFixedCode() {
+	BeginWrite();
+
+	enterDispatcher_ = AlignCode16();
+	ABI_PushAllCalleeSavedRegsAndAdjustStack();
+	MOV(64, R(MEMBASEREG), ImmPtr(Memory::base));
+	// From the start of the FP reg, a single byte offset can reach all GPR + all FPR (but no VFPUR)
+	MOV(PTRBITS, R(CTXREG), ImmPtr(&mips_->f[0]));
+
+	outerLoop_ = GetCodePtr();
+		ABI_CallFunction(reinterpret_cast<void *>(&CoreTiming::Advance));
+		FixupBranch skipToCoreStateCheck = J();  // skip the downcount check
+
+		dispatcherCheckCoreState_ = GetCodePtr();
+		CMP(32, MIPSSTATE_VAR(downcount), Imm8(0));
+		FixupBranch bailCoreState = J_CC(CC_L, true);
+
+		SetJumpTarget(skipToCoreStateCheck);
+		MOV(PTRBITS, R(RAX), ImmPtr((const void *)&coreState));
+		CMP(32, MatR(RAX), Imm32(0));
+		FixupBranch badCoreState = J_CC(CC_NZ, true);
+		FixupBranch skipToRealDispatch = J();
+
+		dispatcher_ = GetCodePtr();
+			CMP(32, MIPSSTATE_VAR(downcount), Imm8(0));
+			FixupBranch bail = J_CC(CC_L, true);
+			SetJumpTarget(skipToRealDispatch);
+
+			dispatcherNoCheck_ = GetCodePtr();
+			MOV(32, R(EAX), MIPSSTATE_VAR(pc));
+#ifdef MASKED_PSP_MEMORY
+			AND(32, R(EAX), Imm32(Memory::MEMVIEW32_MASK));
+#endif
+			dispatcherFetch_ = GetCodePtr();
+			MOV(32, R(EAX), MComplex(MEMBASEREG, RAX, SCALE_1, 0));
+			MOV(32, R(EDX), R(EAX));
+			_assert_msg_(MIPS_JITBLOCK_MASK == 0xFF000000, "Hardcoded assumption of emuhack mask");
+			SHR(32, R(EDX), Imm8(24));
+			CMP(32, R(EDX), Imm8(MIPS_EMUHACK_OPCODE >> 24));
+			FixupBranch notfound = J_CC(CC_NE);
+				// Now EAX is the IR block number.
+				AND(32, R(EAX), Imm32(MIPS_EMUHACK_VALUE_MASK));
+				MOV(PTRBITS, R(RDX), ImmPtr(&blockOffsetsSize_));
+				CMP(32, R(EAX), MatR(RDX));
+				FixupBranch outOfRange = J_CC(CC_AE);
+				MOV(PTRBITS, R(RDX), ImmPtr(&blockOffsetsPtr_));
+				MOV(PTRBITS, R(RDX), MatR(RDX));
+				MOV(32, R(EDX), MComplex(RDX, RAX, SCALE_4, 0));
+				TEST(32, R(EDX), R(EDX));
+				FixupBranch noNative = J_CC(CC_Z);
+				MOV(PTRBITS, R(RAX), ImmPtr(GetBasePtr()));
+				ADD(PTRBITS, R(RAX), R(RDX));
+				JMPptr(R(RAX));
+
+				// Shouldn't normally happen, but we can always interpret the block.
+				SetJumpTarget(outOfRange);
+				SetJumpTarget(noNative);
+				interpretBlock_ = GetCodePtr();
+				ABI_CallFunctionPA((const void *)&RunBlockInterpreted, this, R(EAX));
+				MOV(32, MIPSSTATE_VAR(pc), R(EAX));
+				JMP(dispatcher_, true);
+			SetJumpTarget(notfound);
+
+			// Ok, no block, let's jit.
+			ABI_CallFunction(&MIPSComp::JitAt);
+			JMP(dispatcherNoCheck_, true);
+
+		SetJumpTarget(bail);
+		SetJumpTarget(bailCoreState);
+
+		MOV(PTRBITS, R(RAX), ImmPtr((const void *)&coreState));
+		CMP(32, MatR(RAX), Imm32(0));
+		J_CC(CC_Z, outerLoop_, true);
+
+	const u8 *quitLoop = GetCodePtr();
+	SetJumpTarget(badCoreState);
+	ABI_PopAllCalleeSavedRegsAndAdjustStack();
+	RET();
+
+	crashHandler_ = GetCodePtr();
+	MOV(PTRBITS, R(RAX), ImmPtr((const void *)&coreState));
+	MOV(32, MatR(RAX), Imm32(CORE_RUNTIME_ERROR));
+	JMP(quitLoop, true);
+
+	// Let's spare the pre-generated code from unprotect-reprotect.
+	endOfPregeneratedCode_ = AlignCodePage();
+	EndWrite();
+}
+
+u32 X64IRJit::RunBlockInterpreted(X64IRJit *jit, u32 block_num) {
+	IRBlock *block = jit->blocks_.GetBlock(block_num);
+	if (jit->profiling_) {
+		int startDowncount = jit->mips_->downcount;
+		u32 pc = IRInterpret(jit->mips_, block->GetInterpretInstructions(), block->GetNumInstructions());
+		// The block may be gone if it ran a syscall that cleared the cache.
+		block = jit->blocks_.GetBlock(block_num);
+		if (block)
+			block->AddProfileSample(startDowncount - jit->mips_->downcount);
+		return pc;
+	}
+	if (jit->tiered_) {
+		if (block_num >= jit->blockRunCounts_.size())
+			jit->blockRunCounts_.resize(block_num + 1, 0);
+		// Only try once, if we're out of space it'll wait for the next clear.
+		if (++jit->blockRunCounts_[block_num] == TIERED_PROMOTE_COUNT)
+			jit->CompileTargetBlock(block, block_num);
+	}
+	// Even if promoted, run this time from the IR.  Next time the dispatcher will find it.
+	return IRInterpret(jit->mips_, block->GetInterpretInstructions(), block->GetNumInstructions());
+}
+
+void X64IRJit::RunLoopUntil(u64 globalticks) {
+	PROFILE_THIS_SCOPE("jit");
+	((void (*)())enterDispatcher_)();
+}
+
+void X64IRJit::ClearCache() {
+	IRJit::ClearCache();
+
+	ClearCodeSpace(GetOffset(endOfPregeneratedCode_));
+	blockOffsets_.clear();
+	blockOffsetsPtr_ = nullptr;
+	blockOffsetsSize_ = 0;
+	blockRunCounts_.clear();
+	tiered_ = g_Config.bTieredJit;
+}
+
+bool X64IRJit::SetBlockProfiling(bool enable) {
+	if (enable != profiling_) {
+		IRJit::SetBlockProfiling(enable);
+		// Native blocks don't count, so switch everything over to (or back from) the interpreter.
+		ClearCache();
+	}
+	return true;
+}
+
+void X64IRJit::SetBlockOffset(int block_num, u32 offset) {
+	if ((size_t)block_num >= blockOffsets_.size()) {
+		blockOffsets_.resize(block_num + 1, 0);
+	}
+	blockOffsets_[block_num] = offset;
+	blockOffsetsPtr_ = blockOffsets_.data();
+	blockOffsetsSize_ = (u32)blockOffsets_.size();
+}
+
+bool X64IRJit::CompileNativeBlock(IRBlock *block, int block_num, bool preload) {
+	// When tiered, blocks start out interpreted and RunBlockInterpreted() promotes hot ones.
+	// Profiling counts in RunBlockInterpreted(), so nothing is native while it's on.
+	if (tiered_ || profiling_)
+		return true;
+	return CompileTargetBlock(block, block_num);
+}
+
+bool X64IRJit::CompileTargetBlock(IRBlock *block, int block_num) {
+	// Most IR ops expand to less than 32 bytes, and the fallback is around 40.
+	size_t estimate = 0x100 + block->GetNumInstructions() * 128;
+	if (GetSpaceLeft() < 0x10000 || GetSpaceLeft() < estimate) {
+		return false;
+	}
+
+	BeginWrite(estimate);
+	const u8 *start = AlignCode16();
+	compilingBlockNum_ = block_num;
+	gpr.Start();
+
+	const IRInst *instructions = block->GetInstructions();
+	for (int i = 0; i < block->GetNumInstructions(); ++i) {
+		CompileIRInst(instructions[i]);
+		gpr.ReleaseSpillLocks();
+	}
+
+	// Blocks always end with an exit, so if we got here, the block was badly constructed.
+	gpr.FlushAll();
+	JMP(crashHandler_, true);
+
+	EndWrite();
+	compilingBlockNum_ = -1;
+
+	u32 startAddr, size;
+	block->GetRange(startAddr, size);
+	blocks_.GetCompileLog()->RecordNativeSize(startAddr, (u32)(GetCodePtr() - start));
+
+	u32 offset = (u32)GetOffset(start);
+	block->SetTargetOffset(offset);
+	SetBlockOffset(block_num, offset);
+	return true;
+}
+
+void X64IRJit::CompileIRInst(IRInst inst) {
+	switch (inst.op) {
+	case IROp::Nop:
+		break;
+
+	case IROp::SetConst:
+	case IROp::SetConstF:
+	case IROp::Downcount:
+	case IROp::SetPC:
+	case IROp::SetPCConst:
+		CompIR_Basic(inst);
+		break;
+
+	case IROp::Add:
+	case IROp::Sub:
+	case IROp::AddConst:
+	case IROp::SubConst:
+	case IROp::Neg:
+		CompIR_Arith(inst);
+		break;
+
+	case IROp::And:
+	case IROp::Or:
+	case IROp::Xor:
+	case IROp::AndConst:
+	case IROp::OrConst:
+	case IROp::XorConst:
+	case IROp::Not:
+		CompIR_Logic(inst);
+		break;
+
+	case IROp::Mov:
+	case IROp::Ext8to32:
+	case IROp::Ext16to32:
+		CompIR_Assign(inst);
+		break;
+
+	case IROp::BSwap16:
+	case IROp::BSwap32:
+	case IROp::Clz:
+		CompIR_Bits(inst);
+		break;
+
+	case IROp::Shl:
+	case IROp::Shr:
+	case IROp::Sar:
+	case IROp::Ror:
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+	case IROp::RorImm:
+		CompIR_Shift(inst);
+		break;
+
+	case IROp::Slt:
+	case IROp::SltConst:
+	case IROp::SltU:
+	case IROp::SltUConst:
+		CompIR_Compare(inst);
+		break;
+
+	case IROp::MovZ:
+	case IROp::MovNZ:
+	case IROp::Max:
+	case IROp::Min:
+		CompIR_CondAssign(inst);
+		break;
+
+	case IROp::MtLo:
+	case IROp::MtHi:
+	case IROp::MfLo:
+	case IROp::MfHi:
+		CompIR_HiLo(inst);
+		break;
+
+	case IROp::Mult:
+	case IROp::MultU:
+	case IROp::Madd:
+	case IROp::MaddU:
+	case IROp::Msub:
+	case IROp::MsubU:
+		CompIR_Mult(inst);
+		break;
+
+	case IROp::Load8:
+	case IROp::Load8Ext:
+	case IROp::Load16:
+	case IROp::Load16Ext:
+	case IROp::Load32:
+		CompIR_Load(inst);
+		break;
+
+	case IROp::Store8:
+	case IROp::Store16:
+	case IROp::Store32:
+		CompIR_Store(inst);
+		break;
+
+	case IROp::LoadFloat:
+	case IROp::StoreFloat:
+	case IROp::LoadVec4:
+	case IROp::StoreVec4:
+		CompIR_FLoadStore(inst);
+		break;
+
+	case IROp::FAdd:
+	case IROp::FSub:
+	case IROp::FMul:
+	case IROp::FDiv:
+	case IROp::FSqrt:
+	case IROp::FNeg:
+	case IROp::FAbs:
+		CompIR_FArith(inst);
+		break;
+
+	case IROp::FMov:
+		CompIR_FAssign(inst);
+		break;
+
+	case IROp::FMovFromGPR:
+	case IROp::FMovToGPR:
+		CompIR_FTransfer(inst);
+		break;
+
+	case IROp::Vec4Add:
+	case IROp::Vec4Sub:
+	case IROp::Vec4Mul:
+	case IROp::Vec4Div:
+	case IROp::Vec4Scale:
+	case IROp::Vec4Dot:
+	case IROp::Vec4Neg:
+	case IROp::Vec4Abs:
+		CompIR_VecArith(inst);
+		break;
+
+	case IROp::Vec4Init:
+	case IROp::Vec4Shuffle:
+	case IROp::Vec4Mov:
+		CompIR_VecAssign(inst);
+		break;
+
+	case IROp::ExitToConst:
+		WriteExitToConst(inst.constant);
+		break;
+
+	case IROp::ExitToReg:
+		MOV(32, R(SCRATCH1), R(gpr.MapReg(inst.src1)));
+		WriteExitToScratch1();
+		break;
+
+	case IROp::ExitToPC:
+		gpr.FlushAll();
+		JMP(dispatcher_, true);
+		break;
+
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+	case IROp::ExitToConstIfGtZ:
+	case IROp::ExitToConstIfGeZ:
+	case IROp::ExitToConstIfLtZ:
+	case IROp::ExitToConstIfLeZ:
+	case IROp::ExitToConstIfFpTrue:
+	case IROp::ExitToConstIfFpFalse:
+		WriteConditionalExit(inst);
+		break;
+
+	case IROp::ApplyRoundingMode:
+	case IROp::RestoreRoundingMode:
+	case IROp::UpdateRoundingMode:
+		// Not implemented in the IR interpreter either.
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+void X64IRJit::CompIR_Generic(IRInst inst) {
+	// All host regs are caller-saved from the regcache's perspective.
+	gpr.FlushAll();
+
+	u64 value;
+	memcpy(&value, &inst, sizeof(inst));
+	MOV(64, R(ABI_PARAM1), Imm64(value));
+	ABI_CallFunction((const void *)&DoIRInstFallback);
+
+	// A non-zero result means the instruction wants to exit (breakpoints, etc.)
+	TEST(32, R(EAX), R(EAX));
+	FixupBranch skip = J_CC(CC_Z);
+	MOV(32, MIPSSTATE_VAR(pc), R(EAX));
+	JMP(dispatcher_, true);
+	SetJumpTarget(skip);
+}
+
+void X64IRJit::WriteExitToScratch1() {
+	gpr.FlushAll();
+	MOV(32, MIPSSTATE_VAR(pc), R(SCRATCH1));
+	JMP(dispatcher_, true);
+}
+
+void X64IRJit::WriteExitToConst(u32 pc) {
+	gpr.FlushAll();
+	MOV(32, MIPSSTATE_VAR(pc), Imm32(pc));
+	JMP(dispatcher_, true);
+}
+
+void X64IRJit::WriteConditionalExit(IRInst inst) {
+	// We branch past the exit, so this is the condition to NOT exit.
+	CCFlags skipCond = CC_E;
+	switch (inst.op) {
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+		gpr.MapInIn(inst.src1, inst.src2);
+		CMP(32, R(gpr.R(inst.src1)), R(gpr.R(inst.src2)));
+		skipCond = inst.op == IROp::ExitToConstIfEq ? CC_NE : CC_E;
+		break;
+
+	case IROp::ExitToConstIfGtZ:
+	case IROp::ExitToConstIfGeZ:
+	case IROp::ExitToConstIfLtZ:
+	case IROp::ExitToConstIfLeZ:
+		CMP(32, R(gpr.MapReg(inst.src1)), Imm8(0));
+		switch (inst.op) {
+		case IROp::ExitToConstIfGtZ: skipCond = CC_LE; break;
+		case IROp::ExitToConstIfGeZ: skipCond = CC_L; break;
+		case IROp::ExitToConstIfLtZ: skipCond = CC_GE; break;
+		case IROp::ExitToConstIfLeZ: skipCond = CC_G; break;
+		default: break;
+		}
+		break;
+
+	case IROp::ExitToConstIfFpTrue:
+	case IROp::ExitToConstIfFpFalse:
+	{
+		X64Reg fpcond = gpr.MapReg(IRREG_FPCOND);
+		TEST(32, R(fpcond), R(fpcond));
+		skipCond = inst.op == IROp::ExitToConstIfFpTrue ? CC_Z : CC_NZ;
+		break;
+	}
+
+	default:
+		_assert_msg_(false, "Unexpected conditional exit");
+		break;
+	}
+
+	FixupBranch skip = J_CC(skipCond, true);
+	// Flushing only emits stores, so the mapping is still accurate after the exit.
+	X64IRRegCache saved = gpr;
+	WriteExitToConst(inst.constant);
+	gpr = saved;
+	SetJumpTarget(skip);
+}
+
+void X64IRJit::CompIR_Basic(IRInst inst) {
+	switch (inst.op) {
+	case IROp::SetConst:
+		if (inst.constant == 0) {
+			X64Reg rd = gpr.MapReg(inst.dest, MAP_NOINIT);
+			XOR(32, R(rd), R(rd));
+		} else {
+			MOV(32, R(gpr.MapReg(inst.dest, MAP_NOINIT)), Imm32(inst.constant));
+		}
+		break;
+
+	case IROp::SetConstF:
+		FlushAliasedFPR(inst.dest);
+		MOV(32, FPRLoc(inst.dest), Imm32(inst.constant));
+		break;
+
+	case IROp::Downcount:
+		SUB(32, MIPSSTATE_VAR(downcount), SImmAuto((s32)inst.constant));
+		break;
+
+	case IROp::SetPC:
+		MOV(32, MIPSSTATE_VAR(pc), R(gpr.MapReg(inst.src1)));
+		break;
+
+	case IROp::SetPCConst:
+		MOV(32, MIPSSTATE_VAR(pc), Imm32(inst.constant));
+		break;
+
+	default:
+		CompIR_Generic(inst);
+		break;
+	}
+}
+
+bool X64IRJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
+	if (ptr == enterDispatcher_)
+		name = "enterDispatcher";
+	else if (ptr == outerLoop_)
+		name = "outerLoop";
+	else if (ptr == dispatcherCheckCoreState_)
+		name = "dispatcherCheckCoreState";
+	else if (ptr == dispatcher_)
+		name = "dispatcher";
+	else if (ptr == dispatcherNoCheck_)
+		name = "dispatcherNoCheck";
+	else if (ptr == dispatcherFetch_)
+		name = "dispatcherFetch";
+	else if (ptr == interpretBlock_)
+		name = "interpretBlock";
+	else if (ptr == crashHandler_)
+		name = "crashHandler";
+	else if (!IsInSpace(ptr))
+		return false;
+	else if (ptr < endOfPregeneratedCode_)
+		name = "PreGenCode";
+	else {
+		// Find the closest block start before ptr.
+		u32 offset = (u32)GetOffset(ptr);
+		int best = -1;
+		u32 bestOffset = 0;
+		for (int i = 0; i < (int)blockOffsets_.size(); ++i) {
+			if (blockOffsets_[i] != 0 && blockOffsets_[i] <= offset && blockOffsets_[i] >= bestOffset) {
+				best = i;
+				bestOffset = blockOffsets_[i];
+			}
+		}
+
+		IRBlock *block = best == -1 ? nullptr : blocks_.GetBlock(best);
+		if (!block) {
+			name = "UnknownOrDeletedBlock";
+			return true;
+		}
+
+		u32 start, size;
+		block->GetRange(start, size);
+		char temp[1024];
+		const std::string label = g_symbolMap ? g_symbolMap->GetDescription(start) : "";
+		if (!label.empty())
+			snprintf(temp, sizeof(temp), "%08x_%s", start, label.c_str());
+		else
+			snprintf(temp, sizeof(temp), "%08x", start);
+		name = temp;
+	}
+	return true;
+}
+
+}  // namespace MIPSComp
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(AMD64)
+
+#include <string>
+#include <vector>
+
+#include "Common/x64Emitter.h"
+#include "Core/MIPS/IR/IRJit.h"
+#include "Core/MIPS/x86/X64IRRegCache.h"
+
+namespace MIPSComp {
+
+// Runs the IR frontend and passes (the same as IRJit), but translates the resulting IR to x64
+// instead of interpreting it.  IR ops without a native implementation call into the interpreter,
+// one instruction at a time, so every op is always supported.
+class X64IRJit : public IRJit, public Gen::XCodeBlock {
+public:
+	X64IRJit(MIPSState *mipsState);
+	~X64IRJit();
+
+	void RunLoopUntil(u64 globalticks) override;
+
+	void ClearCache() override;
+
+	bool CodeInRange(const u8 *ptr) const override {
+		return IsInSpace(ptr);
+	}
+	bool IsAtDispatchFetch(const u8 *ptr) const override {
+		return ptr == dispatcherFetch_;
+	}
+	bool DescribeCodePtr(const u8 *ptr, std::string &name) override;
+
+	const u8 *GetDispatcher() const override { return dispatcher_; }
+
+	bool SetBlockProfiling(bool enable) override;
+	const u8 *GetCrashHandler() const override { return crashHandler_; }
+
+protected:
+	bool CompileNativeBlock(IRBlock *block, int block_num, bool preload) override;
+
+private:
+	void GenerateFixedCode();
+	static u32 RunBlockInterpreted(X64IRJit *jit, u32 block_num);
+	bool CompileTargetBlock(IRBlock *block, int block_num);
+	void SetBlockOffset(int block_num, u32 offset);
+
+	void CompileIRInst(IRInst inst);
+	void CompIR_Generic(IRInst inst);
+
+	// Flushes and jumps to the dispatcher, with the new PC already in SCRATCH1.
+	void WriteExitToScratch1();
+	void WriteExitToConst(u32 pc);
+	void WriteConditionalExit(IRInst inst);
+
+	void CompIR_Basic(IRInst inst);
+	void CompIR_Arith(IRInst inst);
+	void CompIR_Logic(IRInst inst);
+	void CompIR_Assign(IRInst inst);
+	void CompIR_Bits(IRInst inst);
+	void CompIR_Shift(IRInst inst);
+	void CompIR_Compare(IRInst inst);
+	void CompIR_CondAssign(IRInst inst);
+	void CompIR_HiLo(IRInst inst);
+	void CompIR_Mult(IRInst inst);
+	void CompIR_Load(IRInst inst);
+	void CompIR_Store(IRInst inst);
+	void CompIR_FArith(IRInst inst);
+	void CompIR_FAssign(IRInst inst);
+	void CompIR_FTransfer(IRInst inst);
+	void CompIR_FLoadStore(IRInst inst);
+	void CompIR_VecArith(IRInst inst);
+	void CompIR_VecAssign(IRInst inst);
+
+	// Computes the guest address in SCRATCH1 and returns the host memory operand.
+	Gen::OpArg PrepareAddress(IRInst inst);
+	// FPRs alias the GPR space at r[32], make sure a cached copy can't go stale.
+	void FlushAliasedFPR(IRReg fpr, int count = 1);
+	Gen::OpArg FPRLoc(IRReg fpr) const;
+
+	X64IRRegCache gpr;
+
+	const u8 *enterDispatcher_ = nullptr;
+	const u8 *outerLoop_ = nullptr;
+	const u8 *dispatcherCheckCoreState_ = nullptr;
+	const u8 *dispatcher_ = nullptr;
+	const u8 *dispatcherNoCheck_ = nullptr;
+	const u8 *dispatcherFetch_ = nullptr;
+	const u8 *crashHandler_ = nullptr;
+	const u8 *interpretBlock_ = nullptr;
+	const u8 *endOfPregeneratedCode_ = nullptr;
+
+	// Native offset per IR block number, 0 if not compiled.  The dispatcher reads through
+	// blockOffsetsPtr_ since the vector may reallocate as it grows.
+	std::vector<u32> blockOffsets_;
+	const u32 *blockOffsetsPtr_ = nullptr;
+	u32 blockOffsetsSize_ = 0;
+
+	int compilingBlockNum_ = -1;
+
+	// Tiered mode: blocks are interpreted until they've run this many times.
+	static const u32 TIERED_PROMOTE_COUNT = 32;
+	bool tiered_ = false;
+	std::vector<u32> blockRunCounts_;
+};
+
+}  // namespace MIPSComp
+
+#endif
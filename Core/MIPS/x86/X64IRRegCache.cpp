@@ -0,0 +1,198 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(AMD64)
+
+#include <cstring>
+
+#include "Common/CommonTypes.h"
+#include "Common/Log.h"
+#include "Core/MIPS/x86/RegCache.h"
+#include "Core/MIPS/x86/X64IRRegCache.h"
+
+using namespace Gen;
+using namespace X64JitConstants;
+using namespace X64IRJitConstants;
+
+// RAX, RCX, RDX are scratch, RBX is the memory base, R14 the context, RSP is the stack.
+// Since we flush everything before calls, caller-saved registers are fine too.
+static const X64Reg allocationOrder[] = {
+	RSI, RDI, R8, R9, R10, R11, R12, R13, R15, RBP,
+};
+
+X64IRRegCache::X64IRRegCache() {
+	Start();
+}
+
+void X64IRRegCache::Init(XEmitter *emitter) {
+	emit_ = emitter;
+}
+
+void X64IRRegCache::Start() {
+	for (int i = 0; i < NUM_X64_REGS; i++) {
+		hr_[i].irReg = IRREG_INVALID;
+		hr_[i].isDirty = false;
+		hr_[i].lastUse = 0;
+	}
+	for (int i = 0; i < TOTAL_MAPPABLE_IRREGS; i++) {
+		mr_[i].reg = INVALID_REG;
+		mr_[i].spillLock = false;
+	}
+	useCounter_ = 0;
+}
+
+OpArg X64IRRegCache::MemLoc(IRReg r) const {
+	// CTXREG points at f[0], which is r[32].
+	return MDisp(CTXREG, ((int)r - 32) * 4);
+}
+
+bool X64IRRegCache::IsMapped(IRReg r) const {
+	return mr_[r].reg != INVALID_REG;
+}
+
+X64Reg X64IRRegCache::R(IRReg r) const {
+	_dbg_assert_msg_(mr_[r].reg != INVALID_REG, "IR reg %d not mapped", r);
+	return mr_[r].reg;
+}
+
+X64Reg X64IRRegCache::AllocateReg() {
+	for (X64Reg reg : allocationOrder) {
+		if (hr_[reg].irReg == IRREG_INVALID)
+			return reg;
+	}
+
+	X64Reg best = FindBestToSpill();
+	if (best != INVALID_REG) {
+		FlushHostReg(best);
+		return best;
+	}
+
+	_assert_msg_(false, "X64IRRegCache: all registers spill locked");
+	return INVALID_REG;
+}
+
+X64Reg X64IRRegCache::FindBestToSpill() {
+	X64Reg best = INVALID_REG;
+	u32 bestUse = 0xFFFFFFFF;
+	for (X64Reg reg : allocationOrder) {
+		IRReg r = hr_[reg].irReg;
+		if (r == IRREG_INVALID || mr_[r].spillLock)
+			continue;
+		// Prefer the least recently used, and clean over dirty when tied.
+		u32 use = hr_[reg].lastUse * 2 + (hr_[reg].isDirty ? 1 : 0);
+		if (use < bestUse) {
+			bestUse = use;
+			best = reg;
+		}
+	}
+	return best;
+}
+
+X64Reg X64IRRegCache::MapReg(IRReg r, int mapFlags) {
+	X64Reg reg = mr_[r].reg;
+	if (reg == INVALID_REG) {
+		reg = AllocateReg();
+		if ((mapFlags & MAP_NOINIT) != MAP_NOINIT) {
+			emit_->MOV(32, Gen::R(reg), MemLoc(r));
+		}
+		hr_[reg].irReg = r;
+		hr_[reg].isDirty = false;
+		mr_[r].reg = reg;
+	}
+
+	if (mapFlags & MAP_DIRTY) {
+		_dbg_assert_msg_(r != MIPS_REG_ZERO, "Should not dirty the zero register");
+		hr_[reg].isDirty = true;
+	}
+	hr_[reg].lastUse = ++useCounter_;
+	mr_[r].spillLock = true;
+	return reg;
+}
+
+void X64IRRegCache::MapIn(IRReg rs) {
+	MapReg(rs);
+}
+
+void X64IRRegCache::MapInIn(IRReg rs, IRReg rt) {
+	SpillLock(rs, rt);
+	MapReg(rs);
+	MapReg(rt);
+}
+
+void X64IRRegCache::MapDirtyIn(IRReg rd, IRReg rs) {
+	SpillLock(rd, rs);
+	bool load = rd == rs;
+	MapReg(rs);
+	MapReg(rd, load ? MAP_DIRTY : MAP_NOINIT);
+}
+
+void X64IRRegCache::MapDirtyInIn(IRReg rd, IRReg rs, IRReg rt) {
+	SpillLock(rd, rs, rt);
+	bool load = rd == rs || rd == rt;
+	MapReg(rs);
+	MapReg(rt);
+	MapReg(rd, load ? MAP_DIRTY : MAP_NOINIT);
+}
+
+void X64IRRegCache::SpillLock(IRReg r1, IRReg r2, IRReg r3) {
+	mr_[r1].spillLock = true;
+	if (r2 != IRREG_INVALID)
+		mr_[r2].spillLock = true;
+	if (r3 != IRREG_INVALID)
+		mr_[r3].spillLock = true;
+}
+
+void X64IRRegCache::ReleaseSpillLocks() {
+	for (int i = 0; i < TOTAL_MAPPABLE_IRREGS; i++) {
+		mr_[i].spillLock = false;
+	}
+}
+
+void X64IRRegCache::FlushHostReg(X64Reg hr) {
+	IRReg r = hr_[hr].irReg;
+	if (r == IRREG_INVALID)
+		return;
+	if (hr_[hr].isDirty) {
+		emit_->MOV(32, MemLoc(r), Gen::R(hr));
+	}
+	hr_[hr].irReg = IRREG_INVALID;
+	hr_[hr].isDirty = false;
+	mr_[r].reg = INVALID_REG;
+}
+
+void X64IRRegCache::FlushR(IRReg r) {
+	if (mr_[r].reg != INVALID_REG)
+		FlushHostReg(mr_[r].reg);
+}
+
+void X64IRRegCache::DiscardR(IRReg r) {
+	X64Reg hr = mr_[r].reg;
+	if (hr == INVALID_REG)
+		return;
+	hr_[hr].irReg = IRREG_INVALID;
+	hr_[hr].isDirty = false;
+	mr_[r].reg = INVALID_REG;
+}
+
+void X64IRRegCache::FlushAll() {
+	for (X64Reg reg : allocationOrder) {
+		FlushHostReg(reg);
+	}
+}
+
+#endif
@@ -0,0 +1,105 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+#include "Common/x64Emitter.h"
+#include "Core/MIPS/MIPS.h"
+
+// Register cache for the x64 IR backend. Only GPRs (and the GPR-like IR regs, like lo/hi and
+// the VFPU control regs) are cached. FPRs are accessed directly in the MIPSState.
+// All host registers are considered volatile across calls, so FlushAll() before any call.
+
+typedef u8 IRReg;
+
+namespace X64IRJitConstants {
+
+// Scratch registers, never allocated. ECX is kept free for variable shifts, and EDX is
+// clobbered by MUL/DIV.
+const Gen::X64Reg SCRATCH1 = Gen::EAX;
+const Gen::X64Reg SCRATCH2 = Gen::EDX;
+const Gen::X64Reg SCRATCH3 = Gen::ECX;
+
+const IRReg IRREG_INVALID = 255;
+
+enum {
+	TOTAL_MAPPABLE_IRREGS = 256,
+};
+
+// Initing is the default so the flag is reversed.
+enum {
+	MAP_DIRTY = 1,
+	MAP_NOINIT = 2 | MAP_DIRTY,
+};
+
+}  // namespace X64IRJitConstants
+
+class X64IRRegCache {
+public:
+	X64IRRegCache();
+
+	void Init(Gen::XEmitter *emitter);
+	// Resets all mappings, call at the start of each block.
+	void Start();
+
+	// Returns a host register containing the requested IR register.
+	Gen::X64Reg MapReg(IRReg r, int mapFlags = 0);
+	void MapIn(IRReg rs);
+	void MapInIn(IRReg rs, IRReg rt);
+	void MapDirtyIn(IRReg rd, IRReg rs);
+	void MapDirtyInIn(IRReg rd, IRReg rs, IRReg rt);
+
+	// Protect the host register containing an IR register from spilling.
+	void SpillLock(IRReg r1, IRReg r2 = X64IRJitConstants::IRREG_INVALID, IRReg r3 = X64IRJitConstants::IRREG_INVALID);
+	void ReleaseSpillLocks();
+
+	bool IsMapped(IRReg r) const;
+	Gen::X64Reg R(IRReg r) const;
+	Gen::OpArg MemLoc(IRReg r) const;
+
+	// Writes back (if dirty) and unmaps.
+	void FlushR(IRReg r);
+	// Unmaps without writing back.
+	void DiscardR(IRReg r);
+	void FlushAll();
+
+private:
+	Gen::X64Reg AllocateReg();
+	Gen::X64Reg FindBestToSpill();
+	void FlushHostReg(Gen::X64Reg hr);
+
+	struct HostRegState {
+		IRReg irReg;
+		bool isDirty;
+		u32 lastUse;
+	};
+	struct IRRegState {
+		Gen::X64Reg reg;
+		bool spillLock;
+	};
+
+	enum {
+		NUM_X64_REGS = 16,
+	};
+
+	Gen::XEmitter *emit_ = nullptr;
+	u32 useCounter_ = 0;
+
+	HostRegState hr_[NUM_X64_REGS];
+	IRRegState mr_[X64IRJitConstants::TOTAL_MAPPABLE_IRREGS];
+};
@@ -17,9 +17,14 @@
 
 #include "ppsspp_config.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <unordered_set>
 #include <mutex>
+#include <thread>
 
 #include "Common/MachineContext.h"
 
@@ -33,6 +38,8 @@
 #endif
 
 #include "Common/Log.h"
+#include "Common/MemoryUtil.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/MemFault.h"
@@ -47,11 +54,370 @@ MemoryExceptionType g_lastMemoryExceptionType;
 
 std::unordered_set<const uint8_t *> g_ignoredAddresses;
 
+// VRAM pages protected for lazy framebuffer readback, indexed by host page. 4KB is the smallest page size we handle.
+static const int MAX_VRAM_PAGES = VRAM_SIZE / 4096;
+static std::atomic<bool> g_vramPageProtected[MAX_VRAM_PAGES];
+static std::atomic<bool> g_vramPageTouched[MAX_VRAM_PAGES];
+static std::atomic<int> g_vramProtectedCount;
+static int g_vramPageSize;
+
+// RAM pages still waiting for their contents after a lazy state load, indexed by host page.
+enum : uint8_t {
+	LAZY_PAGE_DONE,
+	LAZY_PAGE_PENDING,
+	LAZY_PAGE_COPYING,
+};
+static const int MAX_LAZY_PAGES = RAM_DOUBLE_SIZE / 4096;
+static std::atomic<uint8_t> g_lazyPageState[MAX_LAZY_PAGES];
+static std::atomic<int> g_lazyPendingCount;
+static int g_lazyPageCount;
+static int g_lazyPageSize;
+static const uint8_t *g_lazySource;
+static uint32_t g_lazySize;
+static std::thread g_lazyRestoreThread;
+// Writable views of RAM the pages get filled through, so they only become accessible once complete.
+static RAMViewInfo g_lazyAliases[3];
+static int g_lazyAliasCount;
+
+// RAM pages not yet copied into a copy-on-write snapshot, indexed by host page. Same states as above.
+static std::atomic<uint8_t> g_snapshotPageState[MAX_LAZY_PAGES];
+static std::atomic<int> g_snapshotPendingCount;
+static int g_snapshotPageCount;
+static int g_snapshotPageSize;
+static uint8_t *g_snapshotDest;
+static uint32_t g_snapshotSize;
+
+// Set up when RAM first gets protected (by either of the above), and kept until memory is remapped.
+static RAMViewInfo g_ramViews[16];
+static int g_ramViewCount;
+
+// Whether faults on protected memory can be handled no matter which thread or API touches it.
+static bool CanHandleFaultsAnywhere() {
+#if PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS)
+	// The mach exception port is only set up for the emu thread, a fault anywhere else crashes.
+	return false;
+#else
+	return true;
+#endif
+}
+
+// RAM is also touched by the OS directly. MemFault_PrepareHostAccess() covers file I/O, but not sockets.
+static bool CanProtectRAM() {
+	return CanHandleFaultsAnywhere() && !g_Config.bEnableWlan;
+}
+
+// Every view of VRAM. On 32-bit, some of these collapse into the same host memory.
+static const uint32_t vramMirrors[] = {
+	0x04000000, 0x04200000, 0x04400000, 0x04600000,
+	0x44000000, 0x44200000, 0x44400000, 0x44600000,
+};
+
 void MemFault_Init() {
 	g_numReportedBadAccesses = 0;
 	g_lastCrashAddress = nullptr;
 	g_lastMemoryExceptionType = MemoryExceptionType::NONE;
 	g_ignoredAddresses.clear();
+
+	// The views are fresh, so nothing is protected anymore.
+	for (int i = 0; i < MAX_VRAM_PAGES; i++) {
+		g_vramPageProtected[i] = false;
+		g_vramPageTouched[i] = false;
+	}
+	g_vramProtectedCount = 0;
+
+	int pageSize = GetMemoryProtectPageSize();
+	g_vramPageSize = pageSize >= 4096 && pageSize <= (int)VRAM_SIZE ? pageSize : 0;
+
+	g_ramViewCount = 0;
+	g_lazyPendingCount = 0;
+	g_snapshotPendingCount = 0;
+}
+
+static void SetVRAMPageAccess(int page, bool allowAccess) {
+	const uint8_t *done[ARRAY_SIZE(vramMirrors)]{};
+	for (size_t i = 0; i < ARRAY_SIZE(vramMirrors); i++) {
+		const uint8_t *ptr = GetPointerUnchecked(vramMirrors[i] + page * g_vramPageSize);
+		bool seen = false;
+		for (size_t j = 0; j < i; j++)
+			seen = seen || done[j] == ptr;
+		if (!seen)
+			ProtectMemoryPages(ptr, g_vramPageSize, allowAccess ? (MEM_PROT_READ | MEM_PROT_WRITE) : 0);
+		done[i] = ptr;
+	}
+}
+
+static bool VRAMPageRange(uint32_t address, uint32_t size, int *first, int *last) {
+	if (g_vramPageSize == 0 || size == 0)
+		return false;
+	uint32_t offset = address & (VRAM_SIZE - 1);
+	uint32_t end = std::min(offset + size, (uint32_t)VRAM_SIZE);
+	*first = offset / g_vramPageSize;
+	*last = (end - 1) / g_vramPageSize;
+	return true;
+}
+
+bool MemFault_CanProtectVRAM() {
+#ifdef MACHINE_CONTEXT_SUPPORTED
+	return g_vramPageSize != 0 && CanHandleFaultsAnywhere();
+#else
+	return false;
+#endif
+}
+
+void MemFault_ProtectVRAM(uint32_t address, uint32_t size) {
+	int first, last;
+	if (!MemFault_CanProtectVRAM() || !VRAMPageRange(address, size, &first, &last))
+		return;
+	for (int page = first; page <= last; page++) {
+		if (!g_vramPageProtected[page].exchange(true)) {
+			g_vramProtectedCount++;
+			SetVRAMPageAccess(page, false);
+		}
+	}
+}
+
+void MemFault_UnprotectVRAM(uint32_t address, uint32_t size) {
+	int first, last;
+	if (g_vramProtectedCount == 0 || !VRAMPageRange(address, size, &first, &last))
+		return;
+	for (int page = first; page <= last; page++) {
+		if (g_vramPageProtected[page].exchange(false)) {
+			SetVRAMPageAccess(page, true);
+			g_vramProtectedCount--;
+		}
+	}
+}
+
+bool MemFault_TakeTouchedVRAM(uint32_t *start, uint32_t *end) {
+	if (g_vramPageSize == 0)
+		return false;
+	int first = -1, last = -1;
+	for (int page = 0; page < (int)VRAM_SIZE / g_vramPageSize; page++) {
+		if (g_vramPageTouched[page].exchange(false)) {
+			if (first == -1)
+				first = page;
+			last = page;
+		}
+	}
+	if (first == -1)
+		return false;
+	*start = first * g_vramPageSize;
+	*end = (last + 1) * g_vramPageSize;
+	return true;
+}
+
+static void ReleaseVRAMPage(int page, bool isWrite) {
+	if (g_vramPageProtected[page].exchange(false)) {
+		SetVRAMPageAccess(page, true);
+		g_vramProtectedCount--;
+		// After a write, the memory has something newer than the GPU copy, so don't download over it.
+		g_vramPageTouched[page] = !isWrite;
+	}
+}
+
+// Returns the offset into VRAM, or -1 if hostAddress isn't in any view of it.
+static int64_t VRAMOffsetFromHost(uintptr_t hostAddress) {
+	for (uint32_t mirror : vramMirrors) {
+		uintptr_t viewStart = (uintptr_t)GetPointerUnchecked(mirror);
+		if (hostAddress >= viewStart && hostAddress < viewStart + VRAM_SIZE)
+			return hostAddress - viewStart;
+	}
+	return -1;
+}
+
+// Returns true if this was an access to a page protected for lazy readback. It's then accessible again,
+// so the access can just be retried.
+static bool HandleVRAMFault(uintptr_t hostAddress, bool isWrite) {
+	if (g_vramProtectedCount == 0)
+		return false;
+	int64_t offset = VRAMOffsetFromHost(hostAddress);
+	if (offset < 0)
+		return false;
+	// If another thread beat us to it, the page is already accessible or about to be.
+	ReleaseVRAMPage((int)(offset / g_vramPageSize), isWrite);
+	return true;
+}
+
+static void SetRAMPageProtection(uint32_t start, uint32_t size, uint32_t memProtFlags) {
+	for (int i = 0; i < g_ramViewCount; i++) {
+		const RAMViewInfo &view = g_ramViews[i];
+		uint32_t first = std::max(start, view.offset);
+		uint32_t last = std::min(start + size, view.offset + view.size);
+		if (first < last)
+			ProtectMemoryPages(view.ptr + (first - view.offset), last - first, memProtFlags);
+	}
+}
+
+static uint8_t *LazyAliasPointer(uint32_t offset) {
+	for (int i = 0; i < g_lazyAliasCount; i++) {
+		if (offset >= g_lazyAliases[i].offset && offset < g_lazyAliases[i].offset + g_lazyAliases[i].size)
+			return g_lazyAliases[i].ptr + (offset - g_lazyAliases[i].offset);
+	}
+	return nullptr;
+}
+
+// Makes sure the page has its contents, whoever gets there first copies it in.
+static void RestoreLazyPage(int page) {
+	uint8_t expected = LAZY_PAGE_PENDING;
+	if (g_lazyPageState[page].compare_exchange_strong(expected, LAZY_PAGE_COPYING)) {
+		uint32_t offset = page * g_lazyPageSize;
+		uint32_t size = std::min((uint32_t)g_lazyPageSize, g_lazySize - offset);
+		// The regular views stay protected until the page is complete, so other threads just wait in the handler.
+		memcpy(LazyAliasPointer(offset), g_lazySource + offset, size);
+		SetRAMPageProtection(offset, size, MEM_PROT_READ | MEM_PROT_WRITE);
+		g_lazyPageState[page] = LAZY_PAGE_DONE;
+		g_lazyPendingCount--;
+	} else {
+		while (g_lazyPageState[page] == LAZY_PAGE_COPYING)
+			std::this_thread::yield();
+	}
+}
+
+// Returns the offset into RAM, or -1 if hostAddress isn't in any view of it.
+static int64_t RAMOffsetFromHost(uintptr_t hostAddress) {
+	for (int i = 0; i < g_ramViewCount; i++) {
+		uintptr_t viewStart = (uintptr_t)g_ramViews[i].ptr;
+		if (hostAddress >= viewStart && hostAddress < viewStart + g_ramViews[i].size)
+			return g_ramViews[i].offset + (hostAddress - viewStart);
+	}
+	return -1;
+}
+
+// Makes sure the page is in the snapshot, and writable again. Whoever gets there first copies it out.
+static void CopySnapshotPage(int page) {
+	uint8_t expected = LAZY_PAGE_PENDING;
+	if (g_snapshotPageState[page].compare_exchange_strong(expected, LAZY_PAGE_COPYING)) {
+		uint32_t offset = page * g_snapshotPageSize;
+		uint32_t size = std::min((uint32_t)g_snapshotPageSize, g_snapshotSize - offset);
+		// Still read-only here, so nothing can change it while we copy.
+		memcpy(g_snapshotDest + offset, GetPointerUnchecked(PSP_GetKernelMemoryBase() + offset), size);
+		SetRAMPageProtection(offset, size, MEM_PROT_READ | MEM_PROT_WRITE);
+		g_snapshotPageState[page] = LAZY_PAGE_DONE;
+		g_snapshotPendingCount--;
+	} else {
+		while (g_snapshotPageState[page] == LAZY_PAGE_COPYING)
+			std::this_thread::yield();
+	}
+}
+
+bool MemFault_BeginLazyRestore(const uint8_t *source, uint32_t size) {
+#ifdef MACHINE_CONTEXT_SUPPORTED
+	MemFault_FinishRAMSnapshot();
+	MemFault_FinishLazyRestore();
+	if (!CanProtectRAM())
+		return false;
+	g_lazyPageSize = GetMemoryProtectPageSize();
+	if (g_lazyPageSize < 4096 || (size % g_lazyPageSize) != 0 || size / g_lazyPageSize > MAX_LAZY_PAGES)
+		return false;
+	g_lazyAliasCount = CreateRAMAliases(g_lazyAliases, ARRAY_SIZE(g_lazyAliases));
+	if (g_lazyAliasCount == 0)
+		return false;
+
+	g_ramViewCount = GetRAMViews(g_ramViews, ARRAY_SIZE(g_ramViews));
+	g_lazySource = source;
+	g_lazySize = size;
+	g_lazyPageCount = size / g_lazyPageSize;
+	for (int i = 0; i < g_lazyPageCount; i++)
+		g_lazyPageState[i] = LAZY_PAGE_PENDING;
+	g_lazyPendingCount = g_lazyPageCount;
+	SetRAMPageProtection(0, size, 0);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MemFault_LazyRestoreInBackground(std::unique_ptr<uint8_t[]> buffer) {
+	if (g_lazyPendingCount == 0)
+		return;
+
+	g_lazyRestoreThread = std::thread([](std::unique_ptr<uint8_t[]> buffer) {
+		SetCurrentThreadName("LazyStateLoad");
+		for (int page = 0; page < g_lazyPageCount && g_lazyPendingCount != 0; page++)
+			RestoreLazyPage(page);
+		// Every page is done (nothing can be mid-copy), so the source can go now.
+		g_lazySource = nullptr;
+	}, std::move(buffer));
+}
+
+void MemFault_FinishLazyRestore() {
+	if (g_lazyPendingCount != 0) {
+		// Get the thread to give up quickly, by doing the rest here.
+		for (int page = 0; page < g_lazyPageCount; page++)
+			RestoreLazyPage(page);
+	}
+	if (g_lazyRestoreThread.joinable())
+		g_lazyRestoreThread.join();
+	if (g_lazyAliasCount != 0) {
+		ReleaseRAMAliases(g_lazyAliases, g_lazyAliasCount);
+		g_lazyAliasCount = 0;
+	}
+}
+
+bool MemFault_BeginRAMSnapshot(uint8_t *dest, uint32_t size) {
+#ifdef MACHINE_CONTEXT_SUPPORTED
+	// Only one at a time, and a lazy load would have us copy pages that aren't there yet.
+	MemFault_FinishRAMSnapshot();
+	MemFault_FinishLazyRestore();
+	if (!CanProtectRAM())
+		return false;
+	g_snapshotPageSize = GetMemoryProtectPageSize();
+	if (g_snapshotPageSize < 4096 || (size % g_snapshotPageSize) != 0 || size / g_snapshotPageSize > MAX_LAZY_PAGES)
+		return false;
+
+	g_ramViewCount = GetRAMViews(g_ramViews, ARRAY_SIZE(g_ramViews));
+	g_snapshotDest = dest;
+	g_snapshotSize = size;
+	g_snapshotPageCount = size / g_snapshotPageSize;
+	for (int i = 0; i < g_snapshotPageCount; i++)
+		g_snapshotPageState[i] = LAZY_PAGE_PENDING;
+	g_snapshotPendingCount = g_snapshotPageCount;
+	SetRAMPageProtection(0, size, MEM_PROT_READ);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MemFault_FinishRAMSnapshot() {
+	if (g_snapshotPendingCount == 0)
+		return;
+	for (int page = 0; page < g_snapshotPageCount; page++)
+		CopySnapshotPage(page);
+}
+
+void MemFault_PrepareHostAccess(const void *ptr, size_t size, bool hostWrites) {
+	if (size == 0)
+		return;
+	if (g_vramProtectedCount != 0) {
+		int64_t first = VRAMOffsetFromHost((uintptr_t)ptr);
+		int64_t last = VRAMOffsetFromHost((uintptr_t)ptr + size - 1);
+		// Might span two mirrors, then the range wraps around and just covers all of VRAM.
+		if (first >= 0 && last >= 0) {
+			if (last < first) {
+				first = 0;
+				last = VRAM_SIZE - 1;
+			}
+			for (int64_t page = first / g_vramPageSize; page <= last / g_vramPageSize; page++)
+				ReleaseVRAMPage((int)page, hostWrites);
+		}
+	}
+
+	if (g_lazyPendingCount == 0 && g_snapshotPendingCount == 0)
+		return;
+	int64_t first = RAMOffsetFromHost((uintptr_t)ptr);
+	int64_t last = RAMOffsetFromHost((uintptr_t)ptr + size - 1);
+	if (first == -1 || last == -1)
+		return;
+	if (g_lazyPendingCount != 0) {
+		for (int64_t page = first / g_lazyPageSize; page <= last / g_lazyPageSize && page < g_lazyPageCount; page++)
+			RestoreLazyPage((int)page);
+	}
+	// Reading is fine, snapshot pages are only write protected.
+	if (g_snapshotPendingCount != 0 && hostWrites) {
+		for (int64_t page = first / g_snapshotPageSize; page <= last / g_snapshotPageSize && page < g_snapshotPageCount; page++)
+			CopySnapshotPage((int)page);
+	}
 }
 
 bool MemFault_MayBeResumable() {
@@ -87,10 +453,64 @@ static bool DisassembleNativeAt(const uint8_t *codePtr, int instructionSize, std
 	return false;
 }
 
+static bool AnalyzeIsMemoryWrite(const uint8_t *codePtr, bool *isWrite) {
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
+	LSInstructionInfo info{};
+	if (X86AnalyzeMOV(codePtr, info)) {
+		*isWrite = info.isMemoryWrite;
+		return true;
+	}
+#elif PPSSPP_ARCH(ARM64)
+	uint32_t word;
+	memcpy(&word, codePtr, 4);
+	Arm64LSInstructionInfo info{};
+	if (Arm64AnalyzeLoadStore((uint64_t)codePtr, word, &info)) {
+		*isWrite = info.isMemoryWrite;
+		return true;
+	}
+#elif PPSSPP_ARCH(ARM)
+	uint32_t word;
+	memcpy(&word, codePtr, 4);
+	ArmLSInstructionInfo info{};
+	if (ArmAnalyzeLoadStore((uint32_t)codePtr, word, &info)) {
+		*isWrite = info.isMemoryWrite;
+		return true;
+	}
+#endif
+	return false;
+}
+
 bool HandleFault(uintptr_t hostAddress, void *ctx) {
 	SContext *context = (SContext *)ctx;
 	const uint8_t *codePtr = (uint8_t *)(context->CTX_PC);
 
+	// Same for RAM pages waiting on a lazy state load, or written to during a snapshot.
+	// Nothing else protects RAM, so any fault there is ours. The two are never active at once.
+	if (g_ramViewCount != 0) {
+		int64_t offset = RAMOffsetFromHost(hostAddress);
+		if (offset >= 0 && g_snapshotPendingCount != 0 && offset < g_snapshotSize) {
+			CopySnapshotPage((int)(offset / g_snapshotPageSize));
+			return true;
+		}
+		if (offset >= 0 && offset < (int64_t)g_lazyPageCount * g_lazyPageSize) {
+			RestoreLazyPage((int)(offset / g_lazyPageSize));
+			return true;
+		}
+		// Another thread may have just finished the snapshot, then the page is writable again.
+		if (offset >= 0 && offset < g_snapshotSize)
+			return true;
+	}
+
+	// Pages protected for lazy readback can be hit from any code and any thread, so check before locking.
+	if (g_vramProtectedCount != 0) {
+		// Outside the JIT we can't reliably tell, so assume a write. That just skips the later download.
+		bool isWrite = true;
+		if (MIPSComp::jit && MIPSComp::jit->CodeInRange(codePtr))
+			AnalyzeIsMemoryWrite(codePtr, &isWrite);
+		if (HandleVRAMFault(hostAddress, isWrite))
+			return true;
+	}
+
 	std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
 
 	// We set this later if we think it can be resumed from.
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 
 namespace Memory {
 
@@ -18,4 +20,32 @@ void MemFault_IgnoreLastCrash();
 // just leave it as-is.
 bool HandleFault(uintptr_t hostAddress, void *context);
 
+// Lazy framebuffer readback support. The GPU protects VRAM pages whose contents in memory are stale.
+// The first access to such a page from anywhere faults, which unprotects it again. Reads are remembered
+// so the GPU can download the touched part later, writes just stop the tracking for that page.
+// Addresses can be in any VRAM mirror.
+bool MemFault_CanProtectVRAM();
+void MemFault_ProtectVRAM(uint32_t address, uint32_t size);
+void MemFault_UnprotectVRAM(uint32_t address, uint32_t size);
+// Returns false if nothing was read. Otherwise returns the touched range as offsets into VRAM, and forgets it.
+bool MemFault_TakeTouchedVRAM(uint32_t *start, uint32_t *end);
+
+// Lazy state loading. Protects all of RAM (every mirror), then each page gets copied from source the
+// first time anything touches it. Returns false if this isn't supported, RAM is left alone then.
+// source must stay valid until the restore is finished.
+bool MemFault_BeginLazyRestore(const uint8_t *source, uint32_t size);
+// Fills in the remaining pages on a thread, then frees buffer (which source points into.)
+void MemFault_LazyRestoreInBackground(std::unique_ptr<uint8_t[]> buffer);
+// Fills in any remaining pages now, and waits for the thread. Safe to call anytime.
+void MemFault_FinishLazyRestore();
+// Copy-on-write RAM snapshot, for saving while emulation goes on. Makes all of RAM (every mirror) read-only,
+// and the first write to each page copies its old contents to dest. Returns false if this isn't supported,
+// RAM is left alone then. dest must stay valid until the snapshot is finished.
+bool MemFault_BeginRAMSnapshot(uint8_t *dest, uint32_t size);
+// Copies the pages nobody wrote to yet, after which dest is complete. Can run on any thread, safe to call anytime.
+void MemFault_FinishRAMSnapshot();
+// Host code that passes guest memory to the OS (which just fails instead of faulting) must call this first.
+// Also saves faulting page by page in bulk copies. hostWrites is false if the memory will only be read.
+void MemFault_PrepareHostAccess(const void *ptr, size_t size, bool hostWrites);
+
 }
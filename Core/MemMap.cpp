@@ -113,6 +113,11 @@ static MemoryView views[] =
 };
 
 static const int num_views = sizeof(views) / sizeof(MemoryView);
+// Where in the arena each view got mapped from.
+static size_t viewArenaPositions[num_views];
+
+// On some 32 bit platforms (like Android, iOS, etc.), you can only map < 32 megs at a time.
+static const int MAX_MMAP_SIZE = 31 * 1024 * 1024;
 
 inline static bool CanIgnoreView(const MemoryView &view) {
 #ifdef MASKED_PSP_MEMORY
@@ -155,6 +160,7 @@ static bool Memory_TryBase(u32 flags) {
 		if (view.flags & MV_MIRROR_PREVIOUS) {
 			position = last_position;
 		}
+		viewArenaPositions[i] = position;
 #ifndef MASKED_PSP_MEMORY
 		*view.out_ptr = (u8*)g_arena.CreateView(
 			position, view.size, base + view.virtual_address);
@@ -278,9 +284,62 @@ void MemoryMap_Shutdown(u32 flags) {
 #endif
 }
 
+static bool RAMViewOffset(const MemoryView &view, u32 *offset) {
+	if (view.flags & MV_IS_PRIMARY_RAM)
+		*offset = 0;
+	else if (view.flags & MV_IS_EXTRA1_RAM)
+		*offset = MAX_MMAP_SIZE;
+	else if (view.flags & MV_IS_EXTRA2_RAM)
+		*offset = MAX_MMAP_SIZE * 2;
+	else
+		return false;
+	return true;
+}
+
+int GetRAMViews(RAMViewInfo *out, int maxViews) {
+	int count = 0;
+	for (int i = 0; i < num_views && count < maxViews; i++) {
+		const MemoryView &view = views[i];
+		if (view.size == 0 || !*view.out_ptr || CanIgnoreView(view))
+			continue;
+
+		u32 offset;
+		if (!RAMViewOffset(view, &offset))
+			continue;
+		out[count++] = RAMViewInfo{ *view.out_ptr, offset, view.size };
+	}
+	return count;
+}
+
+int CreateRAMAliases(RAMViewInfo *out, int maxViews) {
+#if PPSSPP_PLATFORM(UWP)
+	// Views here are just committed memory, there's nothing to alias.
+	return 0;
+#else
+	int count = 0;
+	for (int i = 0; i < num_views; i++) {
+		const MemoryView &view = views[i];
+		u32 offset;
+		if (view.size == 0 || !*view.out_ptr || (view.flags & MV_MIRROR_PREVIOUS) || !RAMViewOffset(view, &offset))
+			continue;
+
+		u8 *ptr = count < maxViews ? (u8 *)g_arena.CreateView(viewArenaPositions[i], view.size, nullptr) : nullptr;
+		if (!ptr) {
+			ReleaseRAMAliases(out, count);
+			return 0;
+		}
+		out[count++] = RAMViewInfo{ ptr, offset, view.size };
+	}
+	return count;
+#endif
+}
+
+void ReleaseRAMAliases(const RAMViewInfo *aliases, int count) {
+	for (int i = 0; i < count; i++)
+		g_arena.ReleaseView(aliases[i].ptr, aliases[i].size);
+}
+
 bool Init() {
-	// On some 32 bit platforms (like Android, iOS, etc.), you can only map < 32 megs at a time.
-	const static int MAX_MMAP_SIZE = 31 * 1024 * 1024;
 	_dbg_assert_msg_(g_MemorySize <= MAX_MMAP_SIZE * 3, "ACK - too much memory for three mmap views.");
 	for (size_t i = 0; i < ARRAY_SIZE(views); i++) {
 		if (views[i].flags & MV_IS_PRIMARY_RAM)
@@ -291,6 +350,9 @@ bool Init() {
 			views[i].size = std::min(std::max((int)g_MemorySize - MAX_MMAP_SIZE * 2, 0), MAX_MMAP_SIZE);
 	}
 
+	// The jit is created after this, so its code space picks this up too.
+	SetHugePagesForExecutableMemory(g_Config.bHugePages);
+
 	int flags = 0;
 	if (!MemoryMap_Setup(flags)) {
 		return false;
@@ -299,6 +361,20 @@ bool Init() {
 	INFO_LOG(MEMMAP, "Memory system initialized. Base at %p (RAM at @ %p, uncached @ %p)",
 		base, m_pPhysicalRAM, m_pUncachedRAM);
 
+	if (g_Config.bHugePages) {
+		// The advice is per mapping, so mirrors need it too. The scratchpad is too small to matter.
+		int advised = 0;
+		int total = 0;
+		for (int i = 0; i < num_views; i++) {
+			if (*views[i].out_ptr == nullptr || views[i].size < 0x00200000)
+				continue;
+			total++;
+			if (AdviseHugePages(*views[i].out_ptr, views[i].size))
+				advised++;
+		}
+		INFO_LOG(MEMMAP, "Huge pages requested for %d of %d memory views", advised, total);
+	}
+
 	MemFault_Init();
 	return true;
 }
@@ -339,11 +415,15 @@ static void DoMemoryVoid(PointerWrap &p, uint32_t start, uint32_t size) {
 	storage += size;
 }
 
-void DoState(PointerWrap &p) {
+void DoState(PointerWrap &p, bool includeRAM, bool lazyRAM, bool snapshotRAM) {
 	auto s = p.Section("Memory", 1, 3);
 	if (!s)
 		return;
 
+	// RAM is about to be overwritten (maybe remapped), so a pending snapshot needs its pages first.
+	if (p.mode == PointerWrap::MODE_READ)
+		MemFault_FinishRAMSnapshot();
+
 	if (s < 2) {
 		if (!g_RemasterMode)
 			g_MemorySize = RAM_NORMAL_SIZE;
@@ -371,16 +451,30 @@ void DoState(PointerWrap &p) {
 		}
 	}
 
-	DoMemoryVoid(p, PSP_GetKernelMemoryBase(), g_MemorySize);
-	p.DoMarker("RAM");
+	if (includeRAM) {
+		if (lazyRAM && p.mode == PointerWrap::MODE_READ && MemFault_BeginLazyRestore(*p.ptr, g_MemorySize)) {
+			// The pages are copied from the state buffer when they're first touched.
+			*p.ptr += g_MemorySize;
+		} else if (snapshotRAM && p.mode == PointerWrap::MODE_WRITE && MemFault_BeginRAMSnapshot(*p.ptr, g_MemorySize)) {
+			// The pages are copied into the state buffer before they're next written, or when it's finished.
+			*p.ptr += g_MemorySize;
+		} else {
+			DoMemoryVoid(p, PSP_GetKernelMemoryBase(), g_MemorySize);
+		}
+		p.DoMarker("RAM");
 
-	DoMemoryVoid(p, PSP_GetVidMemBase(), VRAM_SIZE);
-	p.DoMarker("VRAM");
+		DoMemoryVoid(p, PSP_GetVidMemBase(), VRAM_SIZE);
+		p.DoMarker("VRAM");
+	}
 	DoArray(p, m_pPhysicalScratchPad, SCRATCHPAD_SIZE);
 	p.DoMarker("ScratchPad");
 }
 
 void Shutdown() {
+	// Can't leave pages protected (or a thread filling them) when the views go away.
+	MemFault_FinishRAMSnapshot();
+	MemFault_FinishLazyRestore();
+
 	std::lock_guard<std::recursive_mutex> guard(g_shutdownLock);
 	u32 flags = 0;
 	MemoryMap_Shutdown(flags);
@@ -480,6 +574,7 @@ void Write_Opcode_JIT(const u32 _Address, const Opcode& _Value)
 void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength, const char *tag) {
 	if (IsValidRange(_Address, _iLength)) {
 		uint8_t *ptr = GetPointerWriteUnchecked(_Address);
+		MemFault_PrepareHostAccess(ptr, _iLength, true);
 		memset(ptr, _iValue, _iLength);
 	} else {
 		for (size_t i = 0; i < _iLength; i++)
@@ -108,10 +108,27 @@ struct MemoryView
 bool MemoryMap_Setup(u32 flags);
 void MemoryMap_Shutdown(u32 flags);
 
+struct RAMViewInfo
+{
+	u8 *ptr;
+	u32 offset;  // Into RAM, where this view starts.
+	u32 size;
+};
+
+// Fills in every host mapping of RAM, mirrors included, and returns how many there are (at most maxViews.)
+int GetRAMViews(RAMViewInfo *out, int maxViews);
+// Maps an extra view of each RAM region, separate from the above so it can stay writable while they're protected.
+// Returns how many were created, or 0 if that's not possible.
+int CreateRAMAliases(RAMViewInfo *out, int maxViews);
+void ReleaseRAMAliases(const RAMViewInfo *aliases, int count);
+
 // Init and Shutdown
 bool Init();
 void Shutdown();
-void DoState(PointerWrap &p);
+// Without includeRAM, RAM and VRAM contents are skipped (rewind tracks them separately.)
+// With lazyRAM, a load leaves RAM to be filled in on first access (see MemFault_BeginLazyRestore.)
+// With snapshotRAM, a save only starts a copy-on-write snapshot into the buffer. Finish it with MemFault_FinishRAMSnapshot.
+void DoState(PointerWrap &p, bool includeRAM = true, bool lazyRAM = false, bool snapshotRAM = false);
 void Clear();
 // False when shutdown has already been called.
 bool IsActive();
@@ -21,6 +21,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/MemFault.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
 
@@ -65,6 +66,9 @@ inline void Memcpy(const u32 to_address, const u32 from_address, const u32 len,
 	if (!from)
 		return;
 
+	// Rather than faulting page by page on lazily read back VRAM.
+	MemFault_PrepareHostAccess(from, len, false);
+	MemFault_PrepareHostAccess(to, len, true);
 	memcpy(to, from, len);
 
 	if (MemBlockInfoDetailed(len)) {
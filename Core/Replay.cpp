@@ -24,6 +24,8 @@
 
 #include <cstring>
 #include <ctime>
+#include <deque>
+#include <mutex>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -40,6 +42,7 @@ enum class ReplayState {
 	IDLE,
 	EXECUTE,
 	SAVE,
+	ROLLBACK,
 };
 
 // Overall structure of file format:
@@ -136,6 +139,27 @@ static uint8_t lastAnalog[2][2]{};
 static size_t replayDiskPos = 0;
 static bool diskFailed = false;
 
+// Input for frames from rollbackBase on.  Used is what the frame actually ran with, confirmed is what it should've been.
+struct RollbackFrame {
+	uint32_t usedButtons = 0;
+	uint8_t usedAnalog[2][2]{};
+	bool used = false;
+	uint32_t buttons = 0;
+	uint8_t analog[2][2]{};
+	bool confirmed = false;
+};
+
+// Confirmations may come from another thread (e.g. the network), everything else is on the emu thread.
+static std::mutex rollbackLock;
+static std::deque<RollbackFrame> rollbackFrames;
+static uint32_t rollbackBase = 0;
+static uint32_t rollbackFrame = 0;
+static uint32_t rollbackConfirmed = 0;
+static int64_t rollbackMispredicted = -1;
+// The latest confirmed input, which is the guess for any frames after it.
+static uint32_t rollbackPredictButtons = 0;
+static uint8_t rollbackPredictAnalog[2][2]{};
+
 bool ReplayExecuteBlob(int version, const std::vector<uint8_t> &data) {
 	if (version < REPLAY_VERSION_MIN || version > REPLAY_VERSION_CURRENT) {
 		ERROR_LOG(SYSTEM, "Bad replay data version: %d", version);
@@ -335,6 +359,15 @@ void ReplayAbort() {
 
 	replayDiskPos = 0;
 	diskFailed = false;
+
+	std::lock_guard<std::mutex> guard(rollbackLock);
+	rollbackFrames.clear();
+	rollbackBase = 0;
+	rollbackFrame = 0;
+	rollbackConfirmed = 0;
+	rollbackMispredicted = -1;
+	rollbackPredictButtons = 0;
+	memset(rollbackPredictAnalog, 0, sizeof(rollbackPredictAnalog));
 }
 
 bool ReplayIsExecuting() {
@@ -345,6 +378,97 @@ bool ReplayIsSaving() {
 	return replayState == ReplayState::SAVE;
 }
 
+void ReplayBeginRollback() {
+	ReplayAbort();
+	replayState = ReplayState::ROLLBACK;
+}
+
+bool ReplayIsRollback() {
+	return replayState == ReplayState::ROLLBACK;
+}
+
+static RollbackFrame &RollbackFrameAt(uint32_t frame) {
+	_dbg_assert_(frame >= rollbackBase);
+	size_t index = frame - rollbackBase;
+	if (index >= rollbackFrames.size())
+		rollbackFrames.resize(index + 1);
+	return rollbackFrames[index];
+}
+
+void ReplayConfirmInput(uint32_t buttons, const uint8_t analog[2][2]) {
+	std::lock_guard<std::mutex> guard(rollbackLock);
+	if (replayState != ReplayState::ROLLBACK)
+		return;
+
+	uint32_t frame = rollbackConfirmed++;
+	RollbackFrame &entry = RollbackFrameAt(frame);
+	entry.buttons = buttons;
+	memcpy(entry.analog, analog, sizeof(entry.analog));
+	entry.confirmed = true;
+	rollbackPredictButtons = buttons;
+	memcpy(rollbackPredictAnalog, analog, sizeof(rollbackPredictAnalog));
+
+	bool wrong = entry.used && (entry.usedButtons != buttons || memcmp(entry.usedAnalog, analog, sizeof(entry.usedAnalog)) != 0);
+	if (wrong && (rollbackMispredicted < 0 || frame < rollbackMispredicted))
+		rollbackMispredicted = frame;
+}
+
+uint32_t ReplayRollbackFrame() {
+	return rollbackFrame;
+}
+
+uint32_t ReplayRollbackConfirmedFrames() {
+	std::lock_guard<std::mutex> guard(rollbackLock);
+	return rollbackConfirmed;
+}
+
+bool ReplayRollbackMispredicted(uint32_t *frame) {
+	std::lock_guard<std::mutex> guard(rollbackLock);
+	if (rollbackMispredicted < 0)
+		return false;
+	*frame = (uint32_t)rollbackMispredicted;
+	return true;
+}
+
+void ReplayRollbackEndFrame() {
+	rollbackFrame++;
+}
+
+void ReplayRollbackRewind(uint32_t frame) {
+	std::lock_guard<std::mutex> guard(rollbackLock);
+	_dbg_assert_(frame >= rollbackBase && frame <= rollbackFrame);
+	for (uint32_t f = frame; f < rollbackFrame; ++f)
+		RollbackFrameAt(f).used = false;
+	rollbackFrame = frame;
+	rollbackMispredicted = -1;
+}
+
+void ReplayRollbackDiscardBefore(uint32_t frame) {
+	std::lock_guard<std::mutex> guard(rollbackLock);
+	for (; rollbackBase < frame; ++rollbackBase) {
+		if (!rollbackFrames.empty())
+			rollbackFrames.pop_front();
+	}
+}
+
+static void ReplayRollbackCtrl(uint32_t &buttons, uint8_t analog[2][2]) {
+	std::lock_guard<std::mutex> guard(rollbackLock);
+	RollbackFrame &entry = RollbackFrameAt(rollbackFrame);
+	if (entry.confirmed) {
+		buttons = entry.buttons;
+		memcpy(analog, entry.analog, sizeof(entry.analog));
+	} else {
+		// Predict that the input hasn't changed since the last we know of.
+		buttons = rollbackPredictButtons;
+		memcpy(analog, rollbackPredictAnalog, sizeof(rollbackPredictAnalog));
+	}
+
+	// The latch might run more than once a frame, but it'll see the same input.
+	entry.usedButtons = buttons;
+	memcpy(entry.usedAnalog, analog, sizeof(entry.usedAnalog));
+	entry.used = true;
+}
+
 static void ReplaySaveCtrl(uint32_t &buttons, uint8_t analog[2][2], uint64_t t) {
 	if (lastButtons != buttons) {
 		replayItems.push_back(ReplayItemHeader(ReplayAction::BUTTONS, t, buttons));
@@ -398,6 +522,10 @@ void ReplayApplyCtrl(uint32_t &buttons, uint8_t analog[2][2], uint64_t t) {
 		ReplaySaveCtrl(buttons, analog, t);
 		break;
 
+	case ReplayState::ROLLBACK:
+		ReplayRollbackCtrl(buttons, analog);
+		break;
+
 	case ReplayState::IDLE:
 	default:
 		break;
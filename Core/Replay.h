@@ -72,6 +72,25 @@ void ReplayAbort();
 bool ReplayIsExecuting();
 bool ReplayIsSaving();
 
+// Rollback: input for a frame may only be confirmed after it has run (e.g. when it comes from a remote peer.)
+// Until then the last confirmed input is used, and the run loop runs frames again from a snapshot if that was wrong.
+// Replaces any execute or record operation, and local input is ignored.
+void ReplayBeginRollback();
+bool ReplayIsRollback();
+// Confirms input for the next frame in order.  Can be called from any thread.
+void ReplayConfirmInput(uint32_t buttons, const uint8_t analog[2][2]);
+// The frame that runs next, counted from ReplayBeginRollback().
+uint32_t ReplayRollbackFrame();
+// Number of frames with confirmed input, i.e. the first frame whose input might still change.
+uint32_t ReplayRollbackConfirmedFrames();
+// Returns the earliest frame that ran with the wrong input, if any.
+bool ReplayRollbackMispredicted(uint32_t *frame);
+void ReplayRollbackEndFrame();
+// After loading a snapshot from the start of frame, so frames from there on run again.
+void ReplayRollbackRewind(uint32_t frame);
+// The run loop won't go back before frame anymore.
+void ReplayRollbackDiscardBefore(uint32_t frame);
+
 void ReplayApplyCtrl(uint32_t &buttons, uint8_t analog[2][2], uint64_t t);
 uint32_t ReplayApplyDisk(ReplayAction action, uint32_t result, uint64_t t);
 uint64_t ReplayApplyDisk64(ReplayAction action, uint64_t result, uint64_t t);
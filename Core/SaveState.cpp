@@ -16,11 +16,14 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <deque>
+#include <functional>
 #include <vector>
 #include <thread>
 #include <mutex>
 
 #include "Common/Data/Text/I18n.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Data/Text/Parsers.h"
 
@@ -44,11 +47,15 @@
 #include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceUtility.h"
+#include "Core/MemFault.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "HW/MemoryStick.h"
 #include "GPU/GPUState.h"
+#include "ext/xxhash.h"
+
+#include <zstd.h>
 
 #ifndef MOBILE_DEVICE
 #include "Core/AVIDump.h"
@@ -63,6 +70,13 @@ namespace SaveState
 	struct SaveStart
 	{
 		void DoState(PointerWrap &p);
+
+		// If set, RAM and VRAM are left out of the state, and this is called instead (with emuhacks cleared.)
+		std::function<void(PointerWrap &p)> memoryHandler;
+		// On load, leave RAM to be filled in on first access. The loaded buffer must be kept around.
+		bool lazyRAM = false;
+		// On save, only start a copy-on-write snapshot of RAM. The buffer must be kept around until it's finished.
+		bool snapshotRAM = false;
 	};
 
 	enum OperationType
@@ -72,6 +86,7 @@ namespace SaveState
 		SAVESTATE_VERIFY,
 		SAVESTATE_REWIND,
 		SAVESTATE_SAVE_SCREENSHOT,
+		SAVESTATE_PROFILE,
 	};
 
 	struct Operation
@@ -89,171 +104,451 @@ namespace SaveState
 		void *cbUserData;
 	};
 
-	CChunkFileReader::Error SaveToRam(std::vector<u8> &data) {
-		SaveStart state;
+	CChunkFileReader::Error SaveToRam(std::vector<u8> &data, SaveStart &state) {
 		size_t sz = CChunkFileReader::MeasurePtr(state);
 		if (data.size() < sz)
 			data.resize(sz);
 		return CChunkFileReader::SavePtr(&data[0], state, sz);
 	}
 
-	CChunkFileReader::Error LoadFromRam(std::vector<u8> &data, std::string *errorString) {
+	CChunkFileReader::Error SaveToRam(std::vector<u8> &data) {
 		SaveStart state;
+		return SaveToRam(data, state);
+	}
+
+	CChunkFileReader::Error LoadFromRam(std::vector<u8> &data, std::string *errorString, SaveStart &state) {
 		return CChunkFileReader::LoadPtr(&data[0], state, errorString);
 	}
 
+	CChunkFileReader::Error LoadFromRam(std::vector<u8> &data, std::string *errorString) {
+		SaveStart state;
+		return LoadFromRam(data, errorString, state);
+	}
+
+	// In-memory snapshots keep RAM and VRAM apart from the rest of the state, split into pages.
+	// Hashing the pages finds the ones that changed, so only those need copying.
+	static const u32 MEMORY_PAGE_SIZE = 8192;
+
+	static u32 RamPageCount()
+	{
+		return Memory::g_MemorySize / MEMORY_PAGE_SIZE;
+	}
+
+	static u32 PageCount()
+	{
+		return RamPageCount() + Memory::VRAM_SIZE / MEMORY_PAGE_SIZE;
+	}
+
+	static u8 *PagePointer(u32 index)
+	{
+		if (index < RamPageCount())
+			return Memory::GetPointerWriteUnchecked(PSP_GetKernelMemoryBase() + index * MEMORY_PAGE_SIZE);
+		return Memory::GetPointerWriteUnchecked(PSP_GetVidMemBase() + (index - RamPageCount()) * MEMORY_PAGE_SIZE);
+	}
+
+	static void HashPages(std::vector<u64> &hashes)
+	{
+		hashes.resize(PageCount());
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			for (int i = l; i < h; ++i) {
+				hashes[i] = XXH3_64bits(PagePointer(i), MEMORY_PAGE_SIZE);
+			}
+		}, 0, (int)hashes.size(), 128);
+	}
+
+	// Rewind snapshots keep RAM and VRAM apart from the rest of the state, split into pages.
+	// Each save hashes every page, and only copies those that changed since the previous snapshot.
+	// Snapshots are then compressed in the background, and the oldest dropped to stay within a memory budget.
 	struct StateRingbuffer
 	{
-		StateRingbuffer(int size) : first_(0), next_(0), size_(size), base_(-1)
+		~StateRingbuffer()
 		{
-			states_.resize(size);
-			baseMapping_.resize(size);
+			if (compressThread_.joinable())
+				compressThread_.join();
+			ZSTD_freeCCtx(cctx_);
+			ZSTD_freeDCtx(dctx_);
 		}
 
 		CChunkFileReader::Error Save()
 		{
 			std::lock_guard<std::mutex> guard(lock_);
+			WaitCompress();
+			// Hashing would fault in the pages of a lazy load one at a time otherwise.
+			Memory::MemFault_FinishLazyRestore();
+
+			Snapshot snapshot;
+			SaveStart state;
+			state.memoryHandler = [&](PointerWrap &p) {
+				if (p.mode == PointerWrap::MODE_WRITE)
+					CapturePages(snapshot);
+			};
 
-			int n = next_++ % size_;
-			if ((next_ % size_) == first_)
-				++first_;
-
-			static std::vector<u8> buffer;
-			std::vector<u8> *compressBuffer = &buffer;
-			CChunkFileReader::Error err;
-
-			if (base_ == -1 || ++baseUsage_ > BASE_USAGE_INTERVAL)
-			{
-				base_ = (base_ + 1) % ARRAY_SIZE(bases_);
-				baseUsage_ = 0;
-				err = SaveToRam(bases_[base_]);
-				// Let's not bother savestating twice.
-				compressBuffer = &bases_[base_];
+			CChunkFileReader::Error err = SaveToRam(snapshot.state, state);
+			if (err == CChunkFileReader::ERROR_NONE) {
+				snapshot.stateSize = snapshot.state.size();
+				snapshots_.push_back(std::move(snapshot));
+				ScheduleCompress(&snapshots_.back());
 			}
-			else
-				err = SaveToRam(buffer);
-
-			if (err == CChunkFileReader::ERROR_NONE)
-				ScheduleCompress(&states_[n], compressBuffer, &bases_[base_]);
-			else
-				states_[n].clear();
-			baseMapping_[n] = base_;
 			return err;
 		}
 
 		CChunkFileReader::Error Restore(std::string *errorString)
 		{
 			std::lock_guard<std::mutex> guard(lock_);
+			WaitCompress();
 
 			// No valid states left.
 			if (Empty())
 				return CChunkFileReader::ERROR_BAD_FILE;
 
-			int n = (--next_ + size_) % size_;
-			if (states_[n].empty())
-				return CChunkFileReader::ERROR_BAD_FILE;
-
+			Snapshot &target = snapshots_.back();
 			static std::vector<u8> buffer;
-			LockedDecompress(buffer, states_[n], bases_[baseMapping_[n]]);
-			return LoadFromRam(buffer, errorString);
+			CChunkFileReader::Error err = CChunkFileReader::ERROR_BROKEN_STATE;
+			if (Unpack(target.state, target.stateCompressed, buffer, target.stateSize)) {
+				SaveStart state;
+				state.memoryHandler = [&](PointerWrap &p) {
+					if (p.mode == PointerWrap::MODE_READ)
+						RestorePages();
+				};
+				err = LoadFromRam(buffer, errorString, state);
+			}
+
+			// Either way, this one is used up.
+			bytesUsed_ -= target.bytes;
+			snapshots_.pop_back();
+			return err;
+		}
+
+		void Clear()
+		{
+			// This lock is mainly for shutdown.
+			std::lock_guard<std::mutex> guard(lock_);
+			WaitCompress();
+			snapshots_.clear();
+			bytesUsed_ = 0;
+		}
+
+		bool Empty() const
+		{
+			return snapshots_.empty();
 		}
 
-		void ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base)
+	private:
+		struct MemoryPage
+		{
+			u32 index;
+			bool compressed;
+			std::vector<u8> data;
+		};
+
+		struct Snapshot
+		{
+			// Everything except RAM and VRAM.
+			std::vector<u8> state;
+			size_t stateSize = 0;
+			bool stateCompressed = false;
+			// Of every page, at the time of the snapshot.
+			std::vector<u64> hashes;
+			// Only those that changed since the previous snapshot.  The oldest snapshot has them all.
+			std::vector<MemoryPage> pages;
+			// Counted against the budget once compressed.
+			size_t bytes = 0;
+		};
+
+		void CapturePages(Snapshot &snapshot)
+		{
+			HashPages(snapshot.hashes);
+
+			const std::vector<u64> *prevHashes = snapshots_.empty() ? nullptr : &snapshots_.back().hashes;
+			if (prevHashes && prevHashes->size() != snapshot.hashes.size())
+				prevHashes = nullptr;
+
+			for (u32 i = 0; i < (u32)snapshot.hashes.size(); ++i) {
+				if (prevHashes && (*prevHashes)[i] == snapshot.hashes[i])
+					continue;
+				const u8 *src = PagePointer(i);
+				snapshot.pages.push_back(MemoryPage{ i, false, std::vector<u8>(src, src + MEMORY_PAGE_SIZE) });
+			}
+		}
+
+		void RestorePages()
+		{
+			const Snapshot &target = snapshots_.back();
+			std::vector<u64> current;
+			HashPages(current);
+
+			// Pages that still match don't need to be touched.
+			size_t count = std::min(current.size(), target.hashes.size());
+			std::vector<bool> needed(count, false);
+			size_t remaining = 0;
+			for (size_t i = 0; i < count; ++i) {
+				if (current[i] != target.hashes[i]) {
+					needed[i] = true;
+					remaining++;
+				}
+			}
+
+			// The newest copy at or before the target is the one it had.
+			for (auto it = snapshots_.rbegin(); it != snapshots_.rend() && remaining != 0; ++it) {
+				for (const MemoryPage &page : it->pages) {
+					if (page.index < count && needed[page.index]) {
+						UnpackPage(page);
+						needed[page.index] = false;
+						remaining--;
+					}
+				}
+			}
+
+			if (remaining != 0)
+				ERROR_LOG(SAVESTATE, "Rewind: %d memory pages could not be restored", (int)remaining);
+		}
+
+		// Must be called with lock_ held.  Until then, the compress thread owns snapshots_.
+		void WaitCompress()
 		{
 			if (compressThread_.joinable())
 				compressThread_.join();
+		}
+
+		void ScheduleCompress(Snapshot *snapshot)
+		{
 			compressThread_ = std::thread([=]{
 				SetCurrentThreadName("SaveStateCompress");
-				Compress(*result, *state, *base);
+				Compress(*snapshot);
+				Trim();
 			});
 		}
 
-		void Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base)
+		bool Pack(std::vector<u8> &data)
 		{
-			std::lock_guard<std::mutex> guard(lock_);
-			// Bail if we were cleared before locking.
-			if (first_ == 0 && next_ == 0)
+			if (!cctx_)
+				cctx_ = ZSTD_createCCtx();
+
+			compressBuffer_.resize(ZSTD_compressBound(data.size()));
+			size_t result = ZSTD_compressCCtx(cctx_, &compressBuffer_[0], compressBuffer_.size(), &data[0], data.size(), 1);
+			// Keep it as is if it doesn't shrink.
+			if (ZSTD_isError(result) || result >= data.size())
+				return false;
+
+			data.assign(compressBuffer_.begin(), compressBuffer_.begin() + result);
+			return true;
+		}
+
+		bool Unpack(const std::vector<u8> &data, bool compressed, std::vector<u8> &result, size_t size)
+		{
+			if (!compressed) {
+				result = data;
+				return true;
+			}
+			if (!dctx_)
+				dctx_ = ZSTD_createDCtx();
+
+			result.resize(size);
+			size_t decompressed = ZSTD_decompressDCtx(dctx_, &result[0], size, &data[0], data.size());
+			return !ZSTD_isError(decompressed) && decompressed == size;
+		}
+
+		void UnpackPage(const MemoryPage &page)
+		{
+			u8 *dest = PagePointer(page.index);
+			if (!page.compressed) {
+				memcpy(dest, page.data.data(), MEMORY_PAGE_SIZE);
 				return;
+			}
+			if (!dctx_)
+				dctx_ = ZSTD_createDCtx();
 
-			result.clear();
-			for (size_t i = 0; i < state.size(); i += BLOCK_SIZE)
-			{
-				int blockSize = std::min(BLOCK_SIZE, (int)(state.size() - i));
-				if (i + blockSize > base.size() || memcmp(&state[i], &base[i], blockSize) != 0)
-				{
-					result.push_back(1);
-					result.insert(result.end(), state.begin() + i, state.begin() +i + blockSize);
-				}
-				else
-					result.push_back(0);
+			size_t decompressed = ZSTD_decompressDCtx(dctx_, dest, MEMORY_PAGE_SIZE, page.data.data(), page.data.size());
+			if (ZSTD_isError(decompressed) || decompressed != MEMORY_PAGE_SIZE)
+				ERROR_LOG(SAVESTATE, "Rewind: failed to decompress memory page %d", (int)page.index);
+		}
+
+		void Compress(Snapshot &snapshot)
+		{
+			snapshot.stateCompressed = Pack(snapshot.state);
+			snapshot.state.shrink_to_fit();
+			for (MemoryPage &page : snapshot.pages) {
+				page.compressed = Pack(page.data);
+				page.data.shrink_to_fit();
 			}
+
+			snapshot.bytes = sizeof(Snapshot) + snapshot.state.size() + snapshot.hashes.size() * sizeof(u64);
+			for (const MemoryPage &page : snapshot.pages) {
+				snapshot.bytes += sizeof(MemoryPage) + page.data.size();
+			}
+			bytesUsed_ += snapshot.bytes;
 		}
 
-		void LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base)
+		void Trim()
 		{
-			result.clear();
-			result.reserve(base.size());
-			auto basePos = base.begin();
-			for (size_t i = 0; i < compressed.size(); )
-			{
-				if (compressed[i] == 0)
-				{
-					++i;
-					int blockSize = std::min(BLOCK_SIZE, (int)(base.size() - result.size()));
-					result.insert(result.end(), basePos, basePos + blockSize);
-					basePos += blockSize;
+			size_t budget = (size_t)std::max(g_Config.iRewindMemoryBudgetMB, 1) * 1024 * 1024;
+			// Always keep the newest, even if it's over budget by itself.
+			while (bytesUsed_ > budget && snapshots_.size() > 1) {
+				DropOldest();
+			}
+		}
+
+		void DropOldest()
+		{
+			Snapshot &oldest = snapshots_.front();
+			if (snapshots_.size() > 1) {
+				// The next one becomes the oldest, so it takes over any pages it lacks.
+				Snapshot &next = snapshots_[1];
+				std::vector<bool> hasPage(PageCount(), false);
+				for (const MemoryPage &page : next.pages) {
+					if (page.index < hasPage.size())
+						hasPage[page.index] = true;
 				}
-				else
-				{
-					++i;
-					int blockSize = std::min(BLOCK_SIZE, (int)(compressed.size() - i));
-					result.insert(result.end(), compressed.begin() + i, compressed.begin() + i + blockSize);
-					i += blockSize;
-					basePos += blockSize;
+				for (MemoryPage &page : oldest.pages) {
+					if (page.index < hasPage.size() && !hasPage[page.index]) {
+						size_t pageBytes = sizeof(MemoryPage) + page.data.size();
+						oldest.bytes -= pageBytes;
+						next.bytes += pageBytes;
+						next.pages.push_back(std::move(page));
+					}
 				}
 			}
+			bytesUsed_ -= oldest.bytes;
+			snapshots_.pop_front();
 		}
 
-		void Clear()
+		std::deque<Snapshot> snapshots_;
+		size_t bytesUsed_ = 0;
+		std::mutex lock_;
+		std::thread compressThread_;
+
+		// Only used by the compress thread.
+		ZSTD_CCtx *cctx_ = nullptr;
+		std::vector<u8> compressBuffer_;
+		// Only used by Restore.
+		ZSTD_DCtx *dctx_ = nullptr;
+	};
+
+	// Run-ahead restores the same snapshot every frame, so it keeps one full copy of memory and updates it in place.
+	// Saving and restoring both only copy the pages whose hashes differ, and nothing is compressed.
+	struct RunAheadSnapshot
+	{
+		CChunkFileReader::Error Save()
 		{
-			if (compressThread_.joinable())
-				compressThread_.join();
+			Memory::MemFault_FinishLazyRestore();
 
-			// This lock is mainly for shutdown.
-			std::lock_guard<std::mutex> guard(lock_);
-			first_ = 0;
-			next_ = 0;
+			SaveStart state;
+			state.memoryHandler = [&](PointerWrap &p) {
+				if (p.mode == PointerWrap::MODE_WRITE)
+					CapturePages();
+			};
+			valid_ = false;
+			CChunkFileReader::Error err = SaveToRam(state_, state);
+			valid_ = err == CChunkFileReader::ERROR_NONE;
+			return err;
 		}
 
-		bool Empty() const
+		CChunkFileReader::Error Restore(std::string *errorString)
 		{
-			return next_ == first_;
+			if (!valid_)
+				return CChunkFileReader::ERROR_BAD_FILE;
+
+			SaveStart state;
+			state.memoryHandler = [&](PointerWrap &p) {
+				if (p.mode == PointerWrap::MODE_READ)
+					RestorePages();
+			};
+			return LoadFromRam(state_, errorString, state);
 		}
 
-		static const int BLOCK_SIZE;
-		// TODO: Instead, based on size of compressed state?
-		static const int BASE_USAGE_INTERVAL;
+		void Clear()
+		{
+			valid_ = false;
+			std::vector<u8>().swap(state_);
+			std::vector<u8>().swap(pages_);
+			std::vector<u64>().swap(hashes_);
+			std::vector<u64>().swap(current_);
+		}
 
-		typedef std::vector<u8> StateBuffer;
+	private:
+		// Called with emuhacks cleared.
+		void CapturePages()
+		{
+			u32 count = PageCount();
+			if (hashes_.size() != count) {
+				// Memory size changed (or first use), so everything gets copied.
+				hashes_.clear();
+				pages_.resize((size_t)count * MEMORY_PAGE_SIZE);
+			}
 
-		int first_;
-		int next_;
-		int size_;
+			HashPages(current_);
+			ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+				for (int i = l; i < h; ++i) {
+					if (i < (int)hashes_.size() && hashes_[i] == current_[i])
+						continue;
+					memcpy(&pages_[(size_t)i * MEMORY_PAGE_SIZE], PagePointer(i), MEMORY_PAGE_SIZE);
+				}
+			}, 0, (int)count, 128);
+			hashes_.swap(current_);
+		}
 
-		std::vector<StateBuffer> states_;
-		StateBuffer bases_[2];
-		std::vector<int> baseMapping_;
-		std::mutex lock_;
-		std::thread compressThread_;
+		void RestorePages()
+		{
+			// The snapshot was hashed without emuhacks, so clear them here too or every code page would differ.
+			std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+			std::vector<u32> savedBlocks;
+			if (MIPSComp::jit)
+				savedBlocks = MIPSComp::jit->SaveAndClearEmuHackOps();
 
-		int base_;
-		int baseUsage_;
+			HashPages(current_);
+			if (current_.size() != hashes_.size()) {
+				ERROR_LOG(SAVESTATE, "Run-ahead: memory size changed, can't restore");
+			} else {
+				std::vector<u32> changed;
+				for (u32 i = 0; i < (u32)current_.size(); ++i) {
+					if (current_[i] != hashes_[i])
+						changed.push_back(i);
+				}
+				ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+					for (int i = l; i < h; ++i) {
+						memcpy(PagePointer(changed[i]), &pages_[(size_t)changed[i] * MEMORY_PAGE_SIZE], MEMORY_PAGE_SIZE);
+					}
+				}, 0, (int)changed.size(), 16);
+
+				// Blocks compiled from what was there in the meantime are stale now (the emuhacks of removed blocks aren't restored.)
+				if (MIPSComp::jit) {
+					for (u32 index : changed) {
+						if (index < RamPageCount())
+							MIPSComp::jit->InvalidateCacheAt(PSP_GetKernelMemoryBase() + index * MEMORY_PAGE_SIZE, MEMORY_PAGE_SIZE);
+					}
+				}
+			}
+
+			if (MIPSComp::jit)
+				MIPSComp::jit->RestoreSavedEmuHackOps(savedBlocks);
+		}
+
+		bool valid_ = false;
+		// Everything except RAM and VRAM.
+		std::vector<u8> state_;
+		// A copy of all of RAM and VRAM, as of the snapshot.
+		std::vector<u8> pages_;
+		std::vector<u64> hashes_;
+		// Scratch, kept to avoid reallocating every frame.
+		std::vector<u64> current_;
 	};
 
 	static bool needsProcess = false;
 	static bool needsRestart = false;
 	static std::vector<Operation> pending;
 	static std::mutex mutex;
+
+	// Compressing and writing a state file takes a while, so it's done on a thread after a quick copy.
+	// Callbacks still run on the emu thread, from Process(), once the file has been written.
+	struct FinishedSave
+	{
+		Operation op;
+		Status status;
+		std::string message;
+	};
+	static std::thread saveThread;
+	// Protected by mutex.
+	static std::vector<FinishedSave> finishedSaves;
 	static int screenshotFailures = 0;
 	static bool hasLoadedState = false;
 	static const int STALE_STATE_USES = 2;
@@ -265,14 +560,12 @@ namespace SaveState
 	static std::string saveStateInitialGitVersion = "";
 
 	// TODO: Should this be configurable?
-	static const int REWIND_NUM_STATES = 20;
 	static const int SCREENSHOT_FAILURE_RETRIES = 15;
-	static StateRingbuffer rewindStates(REWIND_NUM_STATES);
+	static StateRingbuffer rewindStates;
+	static RunAheadSnapshot runAheadState;
 	// TODO: Any reason for this to be configurable?
 	const static float rewindMaxWallFrequency = 1.0f;
 	static double rewindLastTime = 0.0f;
-	const int StateRingbuffer::BLOCK_SIZE = 8192;
-	const int StateRingbuffer::BASE_USAGE_INTERVAL = 15;
 
 	void SaveStart::DoState(PointerWrap &p)
 	{
@@ -301,6 +594,12 @@ namespace SaveState
 		// Gotta do CoreTiming first since we'll restore into it.
 		CoreTiming::DoState(p);
 
+		auto doMemory = [&] {
+			Memory::DoState(p, !memoryHandler, lazyRAM, snapshotRAM);
+			if (memoryHandler)
+				memoryHandler(p);
+		};
+
 		// Memory is a bit tricky when jit is enabled, since there's emuhacks in it.
 		auto savedReplacements = SaveAndClearReplacements();
 		if (MIPSComp::jit && p.mode == p.MODE_WRITE) {
@@ -308,13 +607,13 @@ namespace SaveState
 			if (MIPSComp::jit) {
 				std::vector<u32> savedBlocks;
 				savedBlocks = MIPSComp::jit->SaveAndClearEmuHackOps();
-				Memory::DoState(p);
+				doMemory();
 				MIPSComp::jit->RestoreSavedEmuHackOps(savedBlocks);
 			} else {
-				Memory::DoState(p);
+				doMemory();
 			}
 		} else {
-			Memory::DoState(p);
+			doMemory();
 		}
 		RestoreSavedReplacements(savedReplacements);
 
@@ -373,6 +672,120 @@ namespace SaveState
 		return !rewindStates.Empty();
 	}
 
+	CChunkFileReader::Error SaveRunAhead()
+	{
+		return runAheadState.Save();
+	}
+
+	CChunkFileReader::Error RestoreRunAhead(std::string *errorString)
+	{
+		return runAheadState.Restore(errorString);
+	}
+
+	void ClearRunAhead()
+	{
+		runAheadState.Clear();
+	}
+
+	static std::mutex profileLock;
+	static std::vector<PointerWrap::SectionStats> lastProfile;
+
+	// Does a full save in memory, collecting the size and time of each section.
+	static bool ProfileSections(std::vector<PointerWrap::SectionStats> &sections, size_t *size)
+	{
+		Memory::MemFault_FinishLazyRestore();
+
+		SaveStart state;
+		size_t sz = CChunkFileReader::MeasurePtr(state);
+		std::vector<u8> data(sz);
+		u8 *ptr = &data[0];
+		PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+		p.sectionStats = &sections;
+		state.DoState(p);
+		if (size)
+			*size = sz;
+		return p.error != PointerWrap::ERROR_FAILURE;
+	}
+
+	void Profile(Callback callback, void *cbUserData)
+	{
+		Enqueue(Operation(SAVESTATE_PROFILE, Path(), -1, callback, cbUserData));
+	}
+
+	std::vector<PointerWrap::SectionStats> GetLastProfile()
+	{
+		std::lock_guard<std::mutex> guard(profileLock);
+		return lastProfile;
+	}
+
+	bool Benchmark(int iterations, BenchmarkResult *result, std::string *errorString)
+	{
+		*result = BenchmarkResult();
+		if (!ProfileSections(result->sections, &result->stateSize)) {
+			*errorString = "Failed to save state";
+			return false;
+		}
+
+		std::vector<u8> data;
+		std::vector<u8> compressed;
+		std::vector<u8> decompressed(result->stateSize);
+		for (int i = 0; i < iterations; ++i) {
+			double start = time_now_d();
+			if (SaveToRam(data) != CChunkFileReader::ERROR_NONE) {
+				*errorString = "Failed to save state";
+				return false;
+			}
+			double saved = time_now_d();
+			if (LoadFromRam(data, errorString) != CChunkFileReader::ERROR_NONE)
+				return false;
+			double loaded = time_now_d();
+			if (!CChunkFileReader::CompressBuffer(&data[0], result->stateSize, compressed)) {
+				*errorString = "Failed to compress state";
+				return false;
+			}
+			double compressedTime = time_now_d();
+			if (!CChunkFileReader::DecompressBuffer(compressed, &decompressed[0], result->stateSize)) {
+				*errorString = "Failed to decompress state";
+				return false;
+			}
+			double decompressedTime = time_now_d();
+
+			result->save += saved - start;
+			result->load += loaded - saved;
+			result->compress += compressedTime - loaded;
+			result->decompress += decompressedTime - compressedTime;
+		}
+		result->compressedSize = compressed.size();
+
+		// The first run-ahead save copies everything, so do that before timing.
+		CoreParameter &param = PSP_CoreParameter();
+		if (SaveRunAhead() != CChunkFileReader::ERROR_NONE) {
+			*errorString = "Failed to save run-ahead state";
+			return false;
+		}
+		param.runAheadSpeculative = true;
+		for (int i = 0; i < iterations; ++i) {
+			double start = time_now_d();
+			SaveRunAhead();
+			double saved = time_now_d();
+			RestoreRunAhead(errorString);
+			result->incrementalSave += saved - start;
+			result->incrementalLoad += time_now_d() - saved;
+		}
+		param.runAheadSpeculative = false;
+		ClearRunAhead();
+
+		if (iterations > 0) {
+			result->save /= iterations;
+			result->load /= iterations;
+			result->compress /= iterations;
+			result->decompress /= iterations;
+			result->incrementalSave /= iterations;
+			result->incrementalLoad /= iterations;
+		}
+		return true;
+	}
+
 	// Slot utilities
 
 	std::string AppendSlotTitle(const std::string &filename, const std::string &title) {
@@ -739,6 +1152,86 @@ namespace SaveState
 		return copy;
 	}
 
+	static CChunkFileReader::Error StartBackgroundSave(const Operation &op, const std::string &title, SaveStart &state, const std::string &successMessage, const std::string &failureMessage)
+	{
+		size_t sz = CChunkFileReader::MeasurePtr(state);
+		u8 *buffer = (u8 *)malloc(sz);
+		if (!buffer)
+			return CChunkFileReader::ERROR_BAD_ALLOC;
+
+		// One at a time, so they finish in order. Also, there's only one RAM snapshot at a time.
+		if (saveThread.joinable())
+			saveThread.join();
+
+		// RAM isn't copied here, it's frozen until the thread (or the first write to each page) copies it.
+		state.snapshotRAM = true;
+		CChunkFileReader::Error err = CChunkFileReader::SavePtr(buffer, state, sz);
+		state.snapshotRAM = false;
+		if (err != CChunkFileReader::ERROR_NONE) {
+			Memory::MemFault_FinishRAMSnapshot();
+			free(buffer);
+			return err;
+		}
+
+		saveThread = std::thread([=] {
+			SetCurrentThreadName("SaveStateWrite");
+			Memory::MemFault_FinishRAMSnapshot();
+			// SaveFile takes ownership of buffer.
+			CChunkFileReader::Error result = CChunkFileReader::SaveFile(op.filename, title, PPSSPP_GIT_VERSION, buffer, sz);
+			if (result != CChunkFileReader::ERROR_NONE)
+				ERROR_LOG(SAVESTATE, "Save state failure writing %s", op.filename.c_str());
+
+			std::lock_guard<std::mutex> guard(mutex);
+			bool success = result == CChunkFileReader::ERROR_NONE;
+			finishedSaves.push_back(FinishedSave{ op, success ? Status::SUCCESS : Status::FAILURE, success ? successMessage : failureMessage });
+			// Make sure Process() runs to deliver the callback.
+			needsProcess = true;
+			Core_UpdateSingleStep();
+		});
+		return CChunkFileReader::ERROR_NONE;
+	}
+
+	static CChunkFileReader::Error LoadLazily(const Path &filename, SaveStart &state, std::string *errorString)
+	{
+		*errorString = "LoadStateWrongVersion";
+
+		u8 *ptr = nullptr;
+		size_t sz;
+		// Use the state's latest version as a guess for saveStateInitialGitVersion.
+		CChunkFileReader::Error err = CChunkFileReader::LoadFile(filename, &saveStateInitialGitVersion, ptr, sz, errorString);
+		if (err != CChunkFileReader::ERROR_NONE)
+			return err;
+		std::unique_ptr<u8[]> buffer(ptr);
+
+		errorString->clear();
+		state.lazyRAM = true;
+		err = CChunkFileReader::LoadPtr(ptr, state, errorString);
+		state.lazyRAM = false;
+		if (err == CChunkFileReader::ERROR_NONE) {
+			// RAM pages still point into the buffer, the restore thread frees it when it's done.
+			Memory::MemFault_LazyRestoreInBackground(std::move(buffer));
+		} else {
+			Memory::MemFault_FinishLazyRestore();
+		}
+		return err;
+	}
+
+	static void FinishBackgroundSaves(bool wait)
+	{
+		if (wait && saveThread.joinable())
+			saveThread.join();
+
+		std::vector<FinishedSave> finished;
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			finished.swap(finishedSaves);
+		}
+		for (const FinishedSave &save : finished) {
+			if (save.op.callback)
+				save.op.callback(save.status, save.message, save.op.cbUserData);
+		}
+	}
+
 	bool HandleLoadFailure()
 	{
 		// Okay, first, let's give the rewind state a shot - maybe we can at least not reset entirely.
@@ -832,6 +1325,10 @@ namespace SaveState
 
 	void Process()
 	{
+		// Frames run ahead get rolled back, so anything done now would be lost or land in the wrong timeline.
+		if (PSP_CoreParameter().runAheadSpeculative)
+			return;
+
 		if (g_Config.iRewindFlipFrequency != 0 && gpuStats.numFlips != 0)
 			CheckRewindState();
 
@@ -839,6 +1336,8 @@ namespace SaveState
 			return;
 		needsProcess = false;
 
+		FinishBackgroundSaves(false);
+
 		if (!__KernelIsRunning())
 		{
 			ERROR_LOG(SAVESTATE, "Savestate failure: Unable to load without kernel, this should never happen.");
@@ -867,13 +1366,24 @@ namespace SaveState
 
 			std::string slot_prefix = op.slot >= 0 ? StringFromFormat("(%d) ", op.slot + 1) : "";
 			std::string errorString;
+			// Set when the callback runs later, after a background write.
+			bool callbackDeferred = false;
+
+			// Anything left from a lazy load is better copied in one go than page by page.
+			Memory::MemFault_FinishLazyRestore();
 
 			switch (op.type)
 			{
 			case SAVESTATE_LOAD:
+				// A save of this same file might still be writing (or waiting to be renamed.)
+				FinishBackgroundSaves(true);
 				INFO_LOG(SAVESTATE, "Loading state from '%s'", op.filename.c_str());
-				// Use the state's latest version as a guess for saveStateInitialGitVersion.
-				result = CChunkFileReader::Load(op.filename, &saveStateInitialGitVersion, state, &errorString);
+				if (g_Config.bLazyStateLoad) {
+					result = LoadLazily(op.filename, state, &errorString);
+				} else {
+					// Use the state's latest version as a guess for saveStateInitialGitVersion.
+					result = CChunkFileReader::Load(op.filename, &saveStateInitialGitVersion, state, &errorString);
+				}
 				if (result == CChunkFileReader::ERROR_NONE) {
 					callbackMessage = op.slot != LOAD_UNDO_SLOT ? sc->T("Loaded State") : sc->T("State load undone");
 					callbackResult = TriggerLoadWarnings(callbackMessage);
@@ -914,9 +1424,9 @@ namespace SaveState
 					std::size_t lslash = title.find_last_of("/");
 					title = title.substr(lslash + 1);
 				}
-				result = CChunkFileReader::Save(op.filename, title, PPSSPP_GIT_VERSION, state);
+				result = StartBackgroundSave(op, title, state, slot_prefix + sc->T("Saved State"), i18nSaveFailure);
 				if (result == CChunkFileReader::ERROR_NONE) {
-					callbackMessage = slot_prefix + sc->T("Saved State");
+					callbackDeferred = true;
 					callbackResult = Status::SUCCESS;
 #ifndef MOBILE_DEVICE
 					if (g_Config.bSaveLoadResetsAVdumping) {
@@ -979,8 +1489,15 @@ namespace SaveState
 			case SAVESTATE_SAVE_SCREENSHOT:
 			{
 				int maxRes = g_Config.iInternalResolution > 2 ? 2 : -1;
-				tempResult = TakeGameScreenshot(op.filename, ScreenshotFormat::JPG, SCREENSHOT_DISPLAY, nullptr, nullptr, maxRes);
+				// The JPEG is encoded and written in the background, the callback is delivered once it's on disk.
+				tempResult = TakeGameScreenshotAsync(op.filename, ScreenshotFormat::JPG, SCREENSHOT_DISPLAY, maxRes, [op](bool written) {
+					std::lock_guard<std::mutex> guard(mutex);
+					finishedSaves.push_back(FinishedSave{ op, written ? Status::SUCCESS : Status::FAILURE, "" });
+					needsProcess = true;
+					Core_UpdateSingleStep();
+				});
 				callbackResult = tempResult ? Status::SUCCESS : Status::FAILURE;
+				callbackDeferred = tempResult;
 				if (!tempResult) {
 					ERROR_LOG(SAVESTATE, "Failed to take a screenshot for the savestate! %s", op.filename.c_str());
 					if (screenshotFailures++ < SCREENSHOT_FAILURE_RETRIES) {
@@ -992,13 +1509,22 @@ namespace SaveState
 				}
 				break;
 			}
+			case SAVESTATE_PROFILE:
+			{
+				std::vector<PointerWrap::SectionStats> sections;
+				tempResult = ProfileSections(sections, nullptr);
+				callbackResult = tempResult ? Status::SUCCESS : Status::FAILURE;
+				std::lock_guard<std::mutex> guard(profileLock);
+				lastProfile = std::move(sections);
+				break;
+			}
 			default:
 				ERROR_LOG(SAVESTATE, "Savestate failure: unknown operation type %d", op.type);
 				callbackResult = Status::FAILURE;
 				break;
 			}
 
-			if (op.callback)
+			if (op.callback && !callbackDeferred)
 				op.callback(callbackResult, callbackMessage, op.cbUserData);
 		}
 		if (operations.size()) {
@@ -1045,7 +1571,11 @@ namespace SaveState
 
 	void Shutdown()
 	{
+		// Don't lose a state that's still being written.
+		FinishBackgroundSaves(true);
+
 		std::lock_guard<std::mutex> guard(mutex);
 		rewindStates.Clear();
+		runAheadState.Clear();
 	}
 }
@@ -79,6 +79,35 @@ namespace SaveState
 	CChunkFileReader::Error SaveToRam(std::vector<u8> &state);
 	CChunkFileReader::Error LoadFromRam(std::vector<u8> &state, std::string *errorString);
 
+	// Run-ahead keeps a single snapshot that's saved and restored every frame, so both only copy changed memory.
+	// Restore must be called while PSP_CoreParameter().runAheadSpeculative is set, so the jit and GPU caches are kept.
+	CChunkFileReader::Error SaveRunAhead();
+	CChunkFileReader::Error RestoreRunAhead(std::string *errorString);
+	void ClearRunAhead();
+
+	// Collects the size and save time of each DoState section (async.)  For finding what makes states big or slow.
+	// Warning: callback will be called on a different thread.
+	void Profile(Callback callback = Callback(), void *cbUserData = 0);
+	// Result of the last Profile() that finished.  Sections are listed in order, nested ones after their parent.
+	std::vector<PointerWrap::SectionStats> GetLastProfile();
+
+	struct BenchmarkResult {
+		size_t stateSize = 0;
+		size_t compressedSize = 0;
+		// Average seconds per iteration.
+		double save = 0.0;
+		double load = 0.0;
+		double compress = 0.0;
+		double decompress = 0.0;
+		// Run-ahead's snapshot, saved and restored without changes in between.
+		double incrementalSave = 0.0;
+		double incrementalLoad = 0.0;
+		std::vector<PointerWrap::SectionStats> sections;
+	};
+
+	// Saves and loads the current state in memory repeatedly, timing each step.  For headless --bench-savestate.
+	bool Benchmark(int iterations, BenchmarkResult *result, std::string *errorString);
+
 	// For testing / automated tests.  Runs a save state verification pass (async.)
 	// Warning: callback will be called on a different thread.
 	void Verify(Callback callback = Callback(), void *cbUserData = 0);
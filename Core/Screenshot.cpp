@@ -18,6 +18,7 @@
 #include "ppsspp_config.h"
 
 #include <algorithm>
+#include <vector>
 #include <png.h>
 #include "ext/jpge/jpge.h"
 
@@ -26,6 +27,7 @@
 #include "Common/File/Path.h"
 #include "Common/Log.h"
 #include "Common/System/Display.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/Config.h"
 #include "Core/Screenshot.h"
 #include "Core/Core.h"
@@ -328,15 +330,14 @@ static GPUDebugBuffer ApplyRotation(const GPUDebugBuffer &buf, DisplayRotation r
 	return rotated;
 }
 
-bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, int *width, int *height, int maxRes) {
+static bool CaptureScreenshot(ScreenshotType type, int maxRes, GPUDebugBuffer &buf, u32 &w, u32 &h) {
 	if (!gpuDebug) {
 		ERROR_LOG(SYSTEM, "Can't take screenshots when GPU not running");
 		return false;
 	}
-	GPUDebugBuffer buf;
 	bool success = false;
-	u32 w = (u32)-1;
-	u32 h = (u32)-1;
+	w = (u32)-1;
+	h = (u32)-1;
 
 	if (type == SCREENSHOT_DISPLAY || type == SCREENSHOT_RENDER) {
 		success = gpuDebug->GetCurrentFramebuffer(buf, type == SCREENSHOT_RENDER ? GPU_DBG_FRAMEBUF_RENDER : GPU_DBG_FRAMEBUF_DISPLAY, maxRes);
@@ -356,8 +357,16 @@ bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotTy
 
 	if (!success) {
 		ERROR_LOG(G3D, "Failed to obtain screenshot data.");
-		return false;
 	}
+	return success;
+}
+
+bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, int *width, int *height, int maxRes) {
+	GPUDebugBuffer buf;
+	u32 w, h;
+	bool success = CaptureScreenshot(type, maxRes, buf, w, h);
+	if (!success)
+		return false;
 
 	u8 *flipbuffer = nullptr;
 	if (success) {
@@ -380,6 +389,54 @@ bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotTy
 	return success;
 }
 
+class ScreenshotSaveTask : public Task {
+public:
+	ScreenshotSaveTask(const Path &filename, ScreenshotFormat fmt, std::vector<u8> &&pixels, int w, int h, ScreenshotCallback callback)
+		: filename_(filename), fmt_(fmt), pixels_(std::move(pixels)), w_(w), h_(h), callback_(callback) {}
+
+	TaskType Type() const override {
+		return TaskType::IO_BLOCKING;
+	}
+
+	void Run() override {
+		bool success = Save888RGBScreenshot(filename_, fmt_, pixels_.data(), w_, h_);
+		if (!success) {
+			ERROR_LOG(IO, "Failed to write screenshot.");
+		}
+		if (callback_)
+			callback_(success);
+	}
+
+private:
+	Path filename_;
+	ScreenshotFormat fmt_;
+	std::vector<u8> pixels_;
+	int w_;
+	int h_;
+	ScreenshotCallback callback_;
+};
+
+bool TakeGameScreenshotAsync(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, int maxRes, ScreenshotCallback callback) {
+	GPUDebugBuffer buf;
+	u32 w, h;
+	if (!CaptureScreenshot(type, maxRes, buf, w, h))
+		return false;
+
+	// Only the conversion has to happen now, the buffer may point into memory the GPU is about to reuse.
+	u8 *flipbuffer = nullptr;
+	const u8 *buffer = ConvertBufferToScreenshot(buf, false, flipbuffer, w, h);
+	if (!buffer) {
+		delete[] flipbuffer;
+		ERROR_LOG(IO, "Failed to convert screenshot.");
+		return false;
+	}
+	std::vector<u8> pixels(buffer, buffer + w * h * 3);
+	delete[] flipbuffer;
+
+	g_threadManager.EnqueueTask(new ScreenshotSaveTask(filename, fmt, std::move(pixels), w, h, callback));
+	return true;
+}
+
 bool Save888RGBScreenshot(const Path &filename, ScreenshotFormat fmt, const u8 *bufferRGB888, int w, int h) {
 	if (fmt == ScreenshotFormat::PNG) {
 		png_image png;
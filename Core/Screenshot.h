@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "Common/File/Path.h"
 
 struct GPUDebugBuffer;
@@ -39,5 +41,9 @@ const u8 *ConvertBufferToScreenshot(const GPUDebugBuffer &buf, bool alpha, u8 *&
 
 // Can only be used while in game.
 bool TakeGameScreenshot(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, int *width = nullptr, int *height = nullptr, int maxRes = -1);
+// Grabs the image right away, but encodes and writes it on a background thread. callback, if any,
+// is called from that thread once the file is written. Returns false if nothing could be captured.
+typedef std::function<void(bool success)> ScreenshotCallback;
+bool TakeGameScreenshotAsync(const Path &filename, ScreenshotFormat fmt, ScreenshotType type, int maxRes, ScreenshotCallback callback);
 bool Save888RGBScreenshot(const Path &filename, ScreenshotFormat fmt, const u8 *bufferRGB888, int w, int h);
 bool Save8888RGBAScreenshot(const Path &filename, const u8 *bufferRGBA8888, int w, int h);
@@ -35,8 +35,10 @@
 #include "Common/System/System.h"
 #include "Common/File/Path.h"
 #include "Common/Math/math_util.h"
+#include "Common/Thread/Promise.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Data/Encoding/Utf8.h"
+#include "Common/Data/Format/IniFile.h"
 
 #include "Common/File/FileUtil.h"
 #include "Common/TimeUtil.h"
@@ -46,6 +48,7 @@
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/Host.h"
 #include "Core/System.h"
@@ -63,6 +66,7 @@
 #include "Core/FileSystems/MetaFileSystem.h"
 #include "Core/Loaders.h"
 #include "Core/PSPLoaders.h"
+#include "Core/Replay.h"
 #include "Core/ELF/ParamSFO.h"
 #include "Core/SaveState.h"
 #include "Common/LogManager.h"
@@ -221,6 +225,10 @@ bool CPU_Init(std::string *errorString) {
 	coreState = CORE_POWERUP;
 	currentMIPS = &mipsr4k;
 
+	// These don't depend on the game, so get them going while we open and identify it.
+	Promise<IniFile *> *builtinCompat = Promise<IniFile *>::Spawn(&g_threadManager, &Compatibility::LoadBuiltin, TaskType::IO_BLOCKING);
+	MIPSAnalyst::PreloadHashMaps();
+
 	g_symbolMap = new SymbolMap();
 
 	// Default memory settings
@@ -235,11 +243,17 @@ bool CPU_Init(std::string *errorString) {
 	loadedFile = ResolveFileLoaderTarget(ConstructFileLoader(filename));
 #if PPSSPP_ARCH(AMD64)
 	if (g_Config.bCacheFullIsoInRam) {
-		loadedFile = new RamCachingFileLoader(loadedFile);
+		// A mapped file is already served from the OS page cache, a second copy wouldn't help.
+		if (loadedFile->GetDirectPointer(0, 1)) {
+			INFO_LOG(LOADER, "Not caching ISO in RAM, it's memory mapped");
+		} else {
+			loadedFile = new RamCachingFileLoader(loadedFile);
+		}
 	}
 #endif
 
 	IdentifiedFileType type = Identify_File(loadedFile, errorString);
+	PSP_TraceStartup("Game identified");
 
 	// TODO: Put this somewhere better?
 	if (!g_CoreParameter.mountIso.empty()) {
@@ -287,7 +301,9 @@ bool CPU_Init(std::string *errorString) {
 	// Here we have read the PARAM.SFO, let's see if we need any compatibility overrides.
 	// Homebrew usually has an empty discID, and even if they do have a disc id, it's not
 	// likely to collide with any commercial ones.
-	g_CoreParameter.compat.Load(g_paramSFO.GetDiscID());
+	g_CoreParameter.compat.Load(g_paramSFO.GetDiscID(), builtinCompat->BlockUntilReady());
+	delete builtinCompat;
+	PSP_TraceStartup("Compat flags loaded");
 
 	InitVFPUSinCos();
 
@@ -309,6 +325,7 @@ bool CPU_Init(std::string *errorString) {
 
 	// Init all the HLE modules
 	HLEInit();
+	PSP_TraceStartup("HLE initialized");
 
 	// TODO: Check Game INI here for settings, patches and cheats, and modify coreParameter accordingly
 
@@ -337,6 +354,9 @@ PSP_LoadingLock::~PSP_LoadingLock() {
 }
 
 void CPU_Shutdown() {
+	// Pages waiting on a lazy state load or a snapshot need the handler.
+	Memory::MemFault_FinishRAMSnapshot();
+	Memory::MemFault_FinishLazyRestore();
 	UninstallExceptionHandler();
 
 	// Since we load on a background thread, wait for startup to complete.
@@ -347,6 +367,7 @@ void CPU_Shutdown() {
 		host->SaveSymbolMap();
 	}
 
+	MIPSComp::SaveGameBlockCache();
 	Replacement_Shutdown();
 
 	CoreTiming::Shutdown();
@@ -428,6 +449,7 @@ bool PSP_InitStart(const CoreParameter &coreParam, std::string *error_string) {
 	g_CoreParameter.errorString = "";
 	pspIsIniting = true;
 	PSP_SetLoading("Loading game...");
+	PSP_TraceStartup("Boot started");
 
 	if (!CPU_Init(&g_CoreParameter.errorString)) {
 		*error_string = g_CoreParameter.errorString;
@@ -479,11 +501,27 @@ bool PSP_InitUpdate(std::string *error_string) {
 	pspIsInited = GPU_IsReady();
 	pspIsIniting = !pspIsInited;
 	if (pspIsInited) {
+		PSP_TraceStartup("GPU ready");
 		Core_NotifyLifecycle(CoreLifecycle::START_COMPLETE);
 	}
 	return pspIsInited;
 }
 
+void PSP_TraceStartup(const char *event) {
+	static std::mutex traceLock;
+	static double firstTime = 0.0;
+	static double lastTime = 0.0;
+
+	std::lock_guard<std::mutex> guard(traceLock);
+	double now = time_now_d();
+	if (firstTime == 0.0) {
+		firstTime = now;
+		lastTime = now;
+	}
+	INFO_LOG(BOOT, "Startup: %s at %0.1f ms (+%0.1f ms)", event, (now - firstTime) * 1000.0, (now - lastTime) * 1000.0);
+	lastTime = now;
+}
+
 bool PSP_Init(const CoreParameter &coreParam, std::string *error_string) {
 	if (!PSP_InitStart(coreParam, error_string))
 		return false;
@@ -540,18 +578,20 @@ void PSP_Shutdown() {
 void PSP_BeginHostFrame() {
 	// Reapply the graphics state of the PSP
 	if (gpu) {
+		gpu->SyncThread();
 		gpu->BeginHostFrame();
 	}
 }
 
 void PSP_EndHostFrame() {
 	if (gpu) {
+		gpu->SyncThread();
 		gpu->EndHostFrame();
 	}
 	SaveState::Cleanup();
 }
 
-void PSP_RunLoopWhileState() {
+static void RunUntilNextFrame() {
 	// We just run the CPU until we get to vblank. This will quickly sync up pretty nicely.
 	// The actual number of cycles doesn't matter so much here as we will break due to CORE_NEXTFRAME, most of the time hopefully...
 	int blockTicks = usToCycles(1000000 / 10);
@@ -566,6 +606,181 @@ void PSP_RunLoopWhileState() {
 	}
 }
 
+static bool CanRunAhead() {
+	const CoreParameter &param = PSP_CoreParameter();
+	// Replays record and apply input per frame, so they'd see the extra frames.
+	return g_Config.iRunAheadFrames > 0 && coreState == CORE_RUNNING && !param.frozen && !param.freezeNext && !ReplayIsExecuting() && !ReplayIsSaving() && !ReplayIsRollback();
+}
+
+// Runs the real frame without showing it, then a few more with the same input, showing the last one.
+// Those are rolled back afterward, so the game appears to react to input that many frames sooner.
+static void RunAhead(int frames) {
+	CoreParameter &param = PSP_CoreParameter();
+	param.runAheadHidden = true;
+	RunUntilNextFrame();
+	param.runAheadHidden = false;
+	if (coreState != CORE_NEXTFRAME)
+		return;
+	if (SaveState::SaveRunAhead() != CChunkFileReader::ERROR_NONE) {
+		ERROR_LOG(SAVESTATE, "Run-ahead: failed to save state");
+		gpu->CopyDisplayToOutput(true);
+		return;
+	}
+
+	param.runAheadSpeculative = true;
+	for (int i = 0; i < frames && coreState != CORE_STEPPING; ++i) {
+		coreState = CORE_RUNNING;
+		param.runAheadHidden = i < frames - 1;
+		RunUntilNextFrame();
+		if (coreState != CORE_NEXTFRAME)
+			break;
+	}
+	param.runAheadHidden = false;
+	bool presented = coreState == CORE_NEXTFRAME;
+	bool stepping = coreState == CORE_STEPPING;
+
+	std::string errorString;
+	if (SaveState::RestoreRunAhead(&errorString) != CChunkFileReader::ERROR_NONE)
+		ERROR_LOG(SAVESTATE, "Run-ahead: failed to restore state: %s", errorString.c_str());
+	param.runAheadSpeculative = false;
+
+	if (stepping) {
+		// Paused or hit a breakpoint, so stop at the real frame instead.
+		coreState = CORE_STEPPING;
+		return;
+	}
+	if (!presented) {
+		// Hit an error or exit ahead of time. The real frames will get there soon enough.
+		Core_ResetException();
+		gpu->CopyDisplayToOutput(true);
+	}
+	coreState = CORE_NEXTFRAME;
+}
+
+// Rollback never gets more than this many frames past the last snapshot, which bounds the cost of running them again.
+static const uint32_t MAX_ROLLBACK_FRAMES = 8;
+
+static bool rollbackActive = false;
+static RollbackStats rollbackStats;
+static bool rollbackHasSnapshot = false;
+static uint32_t rollbackSnapshotFrame = 0;
+// Snapshots have to be at frame boundaries, so none are taken while resuming a frame (e.g. after a breakpoint.)
+static bool rollbackMidFrame = false;
+
+const RollbackStats &PSP_GetRollbackStats() {
+	return rollbackStats;
+}
+
+// Moves the snapshot up to the current frame, if all the input before it is confirmed.
+static void UpdateRollbackSnapshot() {
+	uint32_t frame = ReplayRollbackFrame();
+	if (rollbackHasSnapshot && (frame <= rollbackSnapshotFrame || frame > ReplayRollbackConfirmedFrames()))
+		return;
+
+	if (SaveState::SaveRunAhead() != CChunkFileReader::ERROR_NONE) {
+		ERROR_LOG(SAVESTATE, "Rollback: failed to save state");
+		return;
+	}
+	rollbackHasSnapshot = true;
+	rollbackSnapshotFrame = frame;
+	ReplayRollbackDiscardBefore(frame);
+	rollbackStats.snapshots++;
+}
+
+// Loads the snapshot and runs back up to the current frame (hidden), this time with the confirmed input.
+static bool Resimulate() {
+	CoreParameter &param = PSP_CoreParameter();
+	uint32_t target = ReplayRollbackFrame();
+	double start = time_now_d();
+
+	param.runAheadSpeculative = true;
+	std::string errorString;
+	if (SaveState::RestoreRunAhead(&errorString) != CChunkFileReader::ERROR_NONE) {
+		ERROR_LOG(SAVESTATE, "Rollback: failed to restore state: %s", errorString.c_str());
+		param.runAheadSpeculative = false;
+		// Nothing to be done, just keep going with the wrong input.
+		ReplayRollbackRewind(target);
+		return true;
+	}
+	ReplayRollbackRewind(rollbackSnapshotFrame);
+	rollbackStats.rollbacks++;
+
+	// Audio for these frames was already played, so they stay speculative.
+	param.runAheadHidden = true;
+	coreState = CORE_NEXTFRAME;
+	while (ReplayRollbackFrame() < target && coreState == CORE_NEXTFRAME) {
+		UpdateRollbackSnapshot();
+		coreState = CORE_RUNNING;
+		RunUntilNextFrame();
+		if (coreState == CORE_NEXTFRAME) {
+			ReplayRollbackEndFrame();
+			rollbackStats.framesResimulated++;
+		}
+	}
+	param.runAheadHidden = false;
+	param.runAheadSpeculative = false;
+	rollbackStats.resimulateSeconds += time_now_d() - start;
+
+	if (coreState != CORE_NEXTFRAME) {
+		rollbackMidFrame = coreState == CORE_STEPPING;
+		return false;
+	}
+	coreState = CORE_RUNNING;
+	return true;
+}
+
+static void RunRollbackFrame() {
+	if (!rollbackMidFrame) {
+		uint32_t mispredicted;
+		if (ReplayRollbackMispredicted(&mispredicted) && rollbackHasSnapshot && !Resimulate())
+			return;
+
+		UpdateRollbackSnapshot();
+		if (rollbackHasSnapshot && ReplayRollbackFrame() - rollbackSnapshotFrame >= MAX_ROLLBACK_FRAMES) {
+			// Too far ahead of the input, wait for it to catch up.
+			rollbackStats.stalls++;
+			gpu->CopyDisplayToOutput(true);
+			coreState = CORE_NEXTFRAME;
+			return;
+		}
+	}
+
+	RunUntilNextFrame();
+	rollbackMidFrame = coreState != CORE_NEXTFRAME;
+	if (coreState == CORE_NEXTFRAME)
+		ReplayRollbackEndFrame();
+}
+
+void PSP_RunLoopWhileState() {
+	if (ReplayIsRollback() != rollbackActive) {
+		rollbackActive = ReplayIsRollback();
+		rollbackStats = RollbackStats();
+		rollbackHasSnapshot = false;
+		rollbackSnapshotFrame = 0;
+		rollbackMidFrame = false;
+		if (!rollbackActive)
+			SaveState::ClearRunAhead();
+	}
+	if (rollbackActive && (coreState == CORE_RUNNING || coreState == CORE_STEPPING)) {
+		RunRollbackFrame();
+		return;
+	}
+
+	static bool usedRunAhead = false;
+	if (CanRunAhead()) {
+		usedRunAhead = true;
+		RunAhead(g_Config.iRunAheadFrames);
+		return;
+	}
+	if (usedRunAhead && g_Config.iRunAheadFrames == 0) {
+		// Free the copy of memory.
+		SaveState::ClearRunAhead();
+		usedRunAhead = false;
+	}
+
+	RunUntilNextFrame();
+}
+
 void PSP_RunLoopUntil(u64 globalticks) {
 	SaveState::Process();
 	if (coreState == CORE_POWERDOWN || coreState == CORE_BOOT_ERROR || coreState == CORE_RUNTIME_ERROR) {
@@ -78,12 +78,26 @@ bool PSP_IsInited();
 bool PSP_IsQuitting();
 void PSP_Shutdown();
 
+// Logs named startup milestones with the time since the first one, to see where cold start time goes.
+void PSP_TraceStartup(const char *event);
+
 void PSP_BeginHostFrame();
 void PSP_EndHostFrame();
 void PSP_RunLoopWhileState();
 void PSP_RunLoopUntil(u64 globalticks);
 void PSP_RunLoopFor(int cycles);
 
+// Measurements of rollback (see ReplayBeginRollback()), reset when it starts.
+struct RollbackStats {
+	int rollbacks = 0;
+	int framesResimulated = 0;
+	double resimulateSeconds = 0.0;
+	int snapshots = 0;
+	// Frames skipped waiting for input.
+	int stalls = 0;
+};
+const RollbackStats &PSP_GetRollbackStats();
+
 void PSP_SetLoading(const std::string &reason);
 std::string PSP_GetLoading();
 
@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <atomic>
 #include <cstring>
+#include <deque>
 #include <memory>
 #include <png.h>
 
@@ -29,6 +30,7 @@
 #include "Common/Data/Format/ZIMLoad.h"
 #include "Common/Data/Text/I18n.h"
 #include "Common/Data/Text/Parsers.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
 #include "Common/Thread/ParallelLoop.h"
@@ -44,11 +46,51 @@
 #include "GPU/Common/TextureDecoder.h"
 
 static const std::string INI_FILENAME = "textures.ini";
+static const std::string PACK_FILENAME = "textures.pack";
 static const std::string NEW_TEXTURE_DIR = "new/";
 static const int VERSION = 1;
+static const u32 PACK_VERSION = 1;
 static const int MAX_MIP_LEVELS = 12;  // 12 should be plenty, 8 is the max mip levels supported by the PSP.
 
-TextureReplacer::TextureReplacer() {
+// New replacements seen less than this apart are recorded as one preload group.
+static const double PRELOAD_GROUP_GAP = 0.5;
+// Don't reload a group that was already preloaded this recently, it's likely still resident.
+static const double PRELOAD_RETRIGGER_TIME = 60.0;
+static const size_t MAX_PRELOAD_GROUP_SIZE = 256;
+static const size_t MAX_PRELOAD_GROUPS = 4096;
+// Decoded textures waiting to be saved are dropped beyond this, and retried when next decoded.
+static const size_t MAX_PENDING_SAVE_BYTES = 64 * 1024 * 1024;
+
+static_assert(sizeof(ReplacementPackHeader) == 16, "Pack header layout is part of the format");
+static_assert(sizeof(ReplacementPackEntry) == 32, "Pack entry layout is part of the format");
+
+// Calls tryKey with the exact key, then with a few more aliases with zeroed portions, until it returns true.
+template <typename F>
+static bool LookupWildcardKeys(u64 cachekey, u32 hash, bool ignoreAddress, F tryKey) {
+	if (tryKey(cachekey, hash))
+		return true;
+
+	// Only clut hash (very dangerous in theory, in practice not more than missing "just" data hash)
+	if (tryKey(cachekey & 0xFFFFFFFFULL, 0))
+		return true;
+
+	// No data hash.
+	if (!ignoreAddress && tryKey(cachekey, 0))
+		return true;
+
+	// No address.
+	if (tryKey(cachekey & 0xFFFFFFFFULL, hash))
+		return true;
+
+	// Address, but not clut hash (in case of garbage clut data.)
+	if (!ignoreAddress && tryKey(cachekey & ~0xFFFFFFFFULL, hash))
+		return true;
+
+	// Anything with this data hash (a little dangerous.)
+	return tryKey(0, hash);
+}
+
+TextureReplacer::TextureReplacer() : saveQueue_(std::make_shared<TextureSaveQueue>()) {
 	none_.alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
 }
 
@@ -83,6 +125,243 @@ void TextureReplacer::NotifyConfigChanged() {
 	if (enabled_) {
 		enabled_ = LoadIni();
 	}
+
+	// Always reopen, it may have been rebuilt.
+	ClosePack();
+	if (enabled_ && g_Config.bReplaceTextures) {
+		LoadPack();
+	}
+
+	LoadPreloadLog();
+}
+
+void TextureReplacer::LoadPreloadLog() {
+	preloadGroups_.clear();
+	preloadGroupTriggered_.clear();
+	preloadGroupIndex_.clear();
+	recordingGroup_.clear();
+	preloadLogFilename_.clear();
+	if (!enabled_ || !g_Config.bReplaceTextures || !g_Config.bReplaceTexturesPreload || gameID_.empty())
+		return;
+
+	const Path preloadDir = GetSysDirectory(DIRECTORY_APP_CACHE) / "texpreload";
+	preloadLogFilename_ = preloadDir / (gameID_ + ".txt");
+	if (!File::Exists(preloadDir))
+		File::CreateFullPath(preloadDir);
+
+	// Format: one group per line, each texture as cachekeyhash:WxH.
+	std::string log;
+	if (!File::ReadFileToString(true, preloadLogFilename_, log))
+		return;
+
+	std::vector<std::string> lines;
+	SplitString(log, '\n', lines);
+	for (const std::string &line : lines) {
+		std::vector<std::string> items;
+		SplitString(line, ' ', items);
+
+		std::vector<PreloadEntry> group;
+		for (const std::string &item : items) {
+			unsigned long long cachekey;
+			PreloadEntry entry;
+			if (sscanf(item.c_str(), "%16llx%8x:%dx%d", &cachekey, &entry.hash, &entry.w, &entry.h) != 4)
+				continue;
+			entry.cachekey = cachekey;
+			if (preloadGroupIndex_.count(ReplacementCacheKey(entry.cachekey, entry.hash)))
+				continue;
+			preloadGroupIndex_[ReplacementCacheKey(entry.cachekey, entry.hash)] = (int)preloadGroups_.size();
+			group.push_back(entry);
+		}
+
+		if (group.size() >= 2 && preloadGroups_.size() < MAX_PRELOAD_GROUPS) {
+			preloadGroups_.push_back(group);
+			preloadGroupTriggered_.push_back(-PRELOAD_RETRIGGER_TIME);
+		} else {
+			for (const PreloadEntry &entry : group)
+				preloadGroupIndex_.erase(ReplacementCacheKey(entry.cachekey, entry.hash));
+		}
+	}
+
+	INFO_LOG(G3D, "Loaded %d texture replacement preload groups", (int)preloadGroups_.size());
+}
+
+void TextureReplacer::RecordPreload(u64 cachekey, u32 hash, int w, int h) {
+	if (preloadLogFilename_.empty())
+		return;
+
+	double now = time_now_d();
+	if (now - recordingLastSeen_ > PRELOAD_GROUP_GAP || recordingGroup_.size() >= MAX_PRELOAD_GROUP_SIZE)
+		FinishPreloadGroup();
+	recordingLastSeen_ = now;
+
+	// Already part of a group, which will have preloaded it if it was ever going to.
+	if (preloadGroupIndex_.count(ReplacementCacheKey(cachekey, hash)))
+		return;
+	recordingGroup_.push_back({ cachekey, hash, w, h });
+}
+
+void TextureReplacer::FinishPreloadGroup() {
+	// A lone texture has nothing to preload.
+	if (recordingGroup_.size() < 2 || preloadGroups_.size() >= MAX_PRELOAD_GROUPS) {
+		recordingGroup_.clear();
+		return;
+	}
+
+	std::string line;
+	for (const PreloadEntry &entry : recordingGroup_) {
+		preloadGroupIndex_[ReplacementCacheKey(entry.cachekey, entry.hash)] = (int)preloadGroups_.size();
+		line += StringFromFormat("%016llx%08x:%dx%d ", (unsigned long long)entry.cachekey, entry.hash, entry.w, entry.h);
+	}
+	line.back() = '\n';
+
+	// Appending keeps the log intact if we never get to exit cleanly.
+	FILE *f = File::OpenCFile(preloadLogFilename_, "a");
+	if (f) {
+		fwrite(line.data(), 1, line.size(), f);
+		fclose(f);
+	}
+
+	preloadGroups_.push_back(std::move(recordingGroup_));
+	// These were all just loaded.
+	preloadGroupTriggered_.push_back(recordingLastSeen_);
+	recordingGroup_.clear();
+}
+
+void TextureReplacer::TriggerPreload(const ReplacementCacheKey &key) {
+	auto group = preloadGroupIndex_.find(key);
+	if (group == preloadGroupIndex_.end())
+		return;
+
+	double now = time_now_d();
+	double &triggered = preloadGroupTriggered_[group->second];
+	if (now - triggered < PRELOAD_RETRIGGER_TIME)
+		return;
+	triggered = now;
+
+	// Only the lookups happen here, the file reads and decoding go to the thread manager.
+	for (const PreloadEntry &entry : preloadGroups_[group->second]) {
+		ReplacementCacheKey entryKey(entry.cachekey, entry.hash);
+		auto it = cache_.find(entryKey);
+		ReplacedTexture *tex;
+		if (it != cache_.end()) {
+			tex = &it->second;
+		} else {
+			tex = &cache_[entryKey];
+			tex->alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
+			PopulateReplacement(tex, entry.cachekey, entry.hash, entry.w, entry.h);
+		}
+		tex->Preload();
+	}
+}
+
+void TextureReplacer::LoadPack() {
+	const Path packFilename = basePath_ / PACK_FILENAME;
+	if (!File::Exists(packFilename) || !pack_.Open(packFilename))
+		return;
+
+	const uint8_t *data = pack_.Data();
+	const uint64_t size = pack_.Size();
+	const ReplacementPackHeader *header = (const ReplacementPackHeader *)data;
+	bool valid = size >= sizeof(ReplacementPackHeader) && memcmp(header->magic, "PPTP", 4) == 0 && header->version == PACK_VERSION;
+	valid = valid && (size - sizeof(ReplacementPackHeader)) / sizeof(ReplacementPackEntry) >= header->numEntries;
+
+	const ReplacementPackEntry *index = (const ReplacementPackEntry *)(data + sizeof(ReplacementPackHeader));
+	for (u32 i = 0; valid && i < header->numEntries; ++i) {
+		const ReplacementPackEntry &entry = index[i];
+		uint64_t bytes = (uint64_t)entry.w * entry.h * 4;
+		valid = entry.offset <= size && bytes <= size - entry.offset;
+		valid = valid && (entry.w == 0 || (Draw::DataFormat)entry.fmt == Draw::DataFormat::R8G8B8A8_UNORM);
+	}
+
+	if (!valid) {
+		ERROR_LOG(G3D, "Ignoring invalid or outdated texture pack: %s", packFilename.ToVisualString().c_str());
+		pack_.Close();
+		return;
+	}
+
+	packIndex_ = index;
+	packEntries_ = header->numEntries;
+	INFO_LOG(G3D, "Loaded texture pack with %d textures", (int)packEntries_);
+}
+
+void TextureReplacer::ClosePack() {
+	if (!pack_.IsOpen())
+		return;
+
+	// Anything populated from the pack points into the mapping.
+	for (auto it = cache_.begin(); it != cache_.end(); ) {
+		if (!it->second.levels_.empty() && it->second.levels_[0].packData) {
+			it = cache_.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	packIndex_ = nullptr;
+	packEntries_ = 0;
+	pack_.Close();
+}
+
+const ReplacementPackEntry *TextureReplacer::FindPackEntry(u64 cachekey, u32 hash, int level) const {
+	auto less = [](const ReplacementPackEntry &a, const ReplacementPackEntry &b) {
+		if (a.cachekey != b.cachekey)
+			return a.cachekey < b.cachekey;
+		if (a.hash != b.hash)
+			return a.hash < b.hash;
+		return a.level < b.level;
+	};
+
+	ReplacementPackEntry key{};
+	key.cachekey = cachekey;
+	key.hash = hash;
+	key.level = (u16)level;
+	const ReplacementPackEntry *end = packIndex_ + packEntries_;
+	const ReplacementPackEntry *it = std::lower_bound(packIndex_, end, key, less);
+	if (it != end && it->cachekey == cachekey && it->hash == hash && it->level == level)
+		return it;
+	return nullptr;
+}
+
+bool TextureReplacer::PopulateFromPack(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h, int newW, int newH) {
+	const ReplacementPackEntry *base = nullptr;
+	LookupWildcardKeys(cachekey, hash, ignoreAddress_, [&](u64 keyCachekey, u32 keyHash) {
+		base = FindPackEntry(keyCachekey, keyHash, 0);
+		return base != nullptr;
+	});
+	if (!base)
+		return false;
+
+	// An empty entry means textures.ini explicitly ignores this texture.
+	for (int i = 0; i < MAX_MIP_LEVELS && base->w != 0; ++i) {
+		const ReplacementPackEntry *entry = i == 0 ? base : FindPackEntry(base->cachekey, base->hash, i);
+		if (!entry || entry->w == 0)
+			break;
+
+		ReplacedTextureLevel level;
+		level.fmt = (Draw::DataFormat)entry->fmt;
+		level.packData = pack_.Data() + entry->offset;
+		level.packW = entry->w;
+		level.packH = entry->h;
+
+		// We pad files that have been hashrange'd so they are the same texture size.
+		level.w = (level.packW * w) / newW;
+		level.h = (level.packH * h) / newH;
+		// Load() copies rows of packW into a level.w wide buffer, so the padding can't be negative.
+		// That happens if the ini's hashrange is larger than the texture.
+		if (level.packW > level.w || level.packH > level.h) {
+			WARN_LOG(G3D, "Replacement in pack larger than texture: size=%dx%d, padded=%dx%d (level %d)", level.packW, level.packH, level.w, level.h, i);
+			break;
+		}
+
+		if (i != 0 && (level.w != (result->levels_[0].w >> i) || level.h != (result->levels_[0].h >> i))) {
+			WARN_LOG(G3D, "Replacement mipmap invalid: size=%dx%d, expected=%dx%d (level %d, pack)", level.w, level.h, result->levels_[0].w >> i, result->levels_[0].h >> i, i);
+			break;
+		}
+		result->levels_.push_back(level);
+	}
+
+	result->alphaStatus_ = (ReplacedTextureAlpha)base->alpha;
+	return true;
 }
 
 bool TextureReplacer::LoadIni() {
@@ -382,6 +661,7 @@ ReplacedTexture &TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 	ReplacementCacheKey replacementKey(cachekey, hash);
 	auto it = cache_.find(replacementKey);
 	if (it != cache_.end()) {
+		TriggerPreload(replacementKey);
 		return it->second;
 	}
 
@@ -389,6 +669,11 @@ ReplacedTexture &TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 	ReplacedTexture &result = cache_[replacementKey];
 	result.alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
 	PopulateReplacement(&result, cachekey, hash, w, h);
+	if (result.Valid()) {
+		RecordPreload(cachekey, hash, w, h);
+		// Note: cache_ is node based, so result stays valid when this adds entries.
+		TriggerPreload(replacementKey);
+	}
 	return result;
 }
 
@@ -401,6 +686,10 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 		cachekey = cachekey & 0xFFFFFFFFULL;
 	}
 
+	if (packIndex_ && PopulateFromPack(result, cachekey, hash, w, h, newW, newH)) {
+		return;
+	}
+
 	for (int i = 0; i < MAX_MIP_LEVELS; ++i) {
 		const std::string hashfile = LookupHashFile(cachekey, hash, i);
 		const Path filename = basePath_ / hashfile;
@@ -511,31 +800,63 @@ static bool WriteTextureToPNG(png_imagep image, const Path &filename, int conver
 	}
 }
 
+// Textures waiting to be saved. Shared with the save task, which may outlive the replacer.
+struct TextureSaveQueue {
+	struct Item {
+		SimpleBuf<u32> data;
+
+		int w = 0;
+		int h = 0;
+		int pitch = 0;  // bytes
+
+		Path basePath;
+		std::string hashfile;
+		u32 replacedInfoHash = 0;
+		u64 dataHash = 0;
+
+		bool skipIfExists = false;
+	};
+
+	std::mutex lock;
+	std::deque<std::unique_ptr<Item>> pending;
+	size_t pendingBytes = 0;
+	bool running = false;
+	// Content hash -> a file already saved with exactly that content.
+	std::unordered_map<u64, Path> saved;
+};
+
 class TextureSaveTask : public Task {
 public:
-	// Could probably just use a vector.
-	SimpleBuf<u32> data;
-
-	int w = 0;
-	int h = 0;
-	int pitch = 0;  // bytes
-
-	Path basePath;
-	std::string hashfile;
-	u32 replacedInfoHash;
+	TextureSaveTask(std::shared_ptr<TextureSaveQueue> queue) : queue_(queue) {}
 
-	bool skipIfExists = false;
-
-	TextureSaveTask(SimpleBuf<u32> _data) : data(std::move(_data)) {}
-
-	TaskType Type() const override { return TaskType::CPU_COMPUTE; }  // Also I/O blocking but dominated by compute
+	TaskType Type() const override { return TaskType::CPU_BACKGROUND; }  // Also I/O blocking but dominated by compute
 	void Run() override {
-		const Path filename = basePath / hashfile;
-		const Path saveFilename = basePath / NEW_TEXTURE_DIR / hashfile;
+		// Drain everything queued up, rather than spinning up a task per texture.
+		while (true) {
+			std::unique_ptr<TextureSaveQueue::Item> item;
+			{
+				std::lock_guard<std::mutex> guard(queue_->lock);
+				if (queue_->pending.empty()) {
+					queue_->running = false;
+					return;
+				}
+				item = std::move(queue_->pending.front());
+				queue_->pending.pop_front();
+				queue_->pendingBytes -= item->h * item->pitch;
+			}
+			Save(*item);
+		}
+	}
+
+private:
+	void Save(TextureSaveQueue::Item &item) {
+		const std::string &hashfile = item.hashfile;
+		const Path filename = item.basePath / hashfile;
+		const Path saveFilename = item.basePath / NEW_TEXTURE_DIR / hashfile;
 
 		// Should we skip writing if the newly saved data already exists?
 		// We do this on the thread due to slow IO.
-		if (skipIfExists && File::Exists(saveFilename))
+		if (item.skipIfExists && File::Exists(saveFilename))
 			return;
 
 		// And we always skip if the replace file already exists.
@@ -550,26 +871,43 @@ class TextureSaveTask : public Task {
 #endif
 		if (slash != hashfile.npos) {
 			// Create any directory structure as needed.
-			const Path saveDirectory = basePath / NEW_TEXTURE_DIR / hashfile.substr(0, slash);
+			const Path saveDirectory = item.basePath / NEW_TEXTURE_DIR / hashfile.substr(0, slash);
 			if (!File::Exists(saveDirectory)) {
 				File::CreateFullPath(saveDirectory);
 				File::CreateEmptyFile(saveDirectory / ".nomedia");
 			}
 		}
 
+		// Games often upload the same image under many hashes. Copying the PNG is much cheaper than encoding it again.
+		Path existing;
+		{
+			std::lock_guard<std::mutex> guard(queue_->lock);
+			auto it = queue_->saved.find(item.dataHash);
+			if (it != queue_->saved.end())
+				existing = it->second;
+		}
+		if (!existing.empty() && existing != saveFilename && File::Exists(existing) && File::Copy(existing, saveFilename)) {
+			NOTICE_LOG(G3D, "Saving texture for replacement: %08x / %dx%d (duplicate of %s)", item.replacedInfoHash, item.w, item.h, existing.GetFilename().c_str());
+			return;
+		}
+
 		png_image png{};
 		png.version = PNG_IMAGE_VERSION;
 		png.format = PNG_FORMAT_RGBA;
-		png.width = w;
-		png.height = h;
-		bool success = WriteTextureToPNG(&png, saveFilename, 0, data.data(), pitch, nullptr);
+		png.width = item.w;
+		png.height = item.h;
+		bool success = WriteTextureToPNG(&png, saveFilename, 0, item.data.data(), item.pitch, nullptr);
 		png_image_free(&png);
 		if (png.warning_or_error >= 2) {
 			ERROR_LOG(COMMON, "Saving screenshot to PNG produced errors.");
 		} else if (success) {
-			NOTICE_LOG(G3D, "Saving texture for replacement: %08x / %dx%d", replacedInfoHash, w, h);
+			NOTICE_LOG(G3D, "Saving texture for replacement: %08x / %dx%d", item.replacedInfoHash, item.w, item.h);
+			std::lock_guard<std::mutex> guard(queue_->lock);
+			queue_->saved[item.dataHash] = saveFilename;
 		}
 	}
+
+	std::shared_ptr<TextureSaveQueue> queue_;
 };
 
 bool TextureReplacer::WillSave(const ReplacedTextureDecodeInfo &replacedInfo) {
@@ -633,26 +971,44 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 		h = lookupH * replacedInfo.scaleFactor;
 	}
 
-	SimpleBuf<u32> saveBuf;
+	const size_t saveBytes = (size_t)w * h * sizeof(u32);
+	{
+		// If saving can't keep up, drop this one rather than piling up memory. It's not in
+		// savedCache_, so it'll be saved when it's decoded again.
+		std::lock_guard<std::mutex> guard(saveQueue_->lock);
+		if (saveQueue_->pendingBytes + saveBytes > MAX_PENDING_SAVE_BYTES)
+			return;
+	}
+
+	std::unique_ptr<TextureSaveQueue::Item> item(new TextureSaveQueue::Item());
 
 	// Copy data to a buffer so we can send it to the thread. Might as well compact-away the pitch
 	// while we're at it.
-	saveBuf.resize(w * h);
+	item->data.resize(w * h);
 	for (int y = 0; y < h; y++) {
-		memcpy((u8 *)saveBuf.data() + y * w * 4, (const u8 *)data + y * pitch, w * sizeof(u32));
+		memcpy((u8 *)item->data.data() + y * w * 4, (const u8 *)data + y * pitch, w * sizeof(u32));
+	}
+	item->w = w;
+	item->h = h;
+	item->pitch = w * 4;
+	item->basePath = basePath_;
+	item->hashfile = hashfile;
+	item->replacedInfoHash = replacedInfo.hash;
+	item->dataHash = XXH3_64bits(item->data.data(), saveBytes) ^ ((u64)w << 32) ^ h;
+	item->skipIfExists = skipIfExists;
+
+	bool startTask = false;
+	{
+		std::lock_guard<std::mutex> guard(saveQueue_->lock);
+		saveQueue_->pending.push_back(std::move(item));
+		saveQueue_->pendingBytes += saveBytes;
+		startTask = !saveQueue_->running;
+		saveQueue_->running = true;
+	}
+	if (startTask) {
+		// We don't care about waiting for the task. It'll be fine.
+		g_threadManager.EnqueueTask(new TextureSaveTask(saveQueue_));
 	}
-	pitch = w * 4;
-
-	TextureSaveTask *task = new TextureSaveTask(std::move(saveBuf));
-	// Should probably do a proper move constructor but this'll work.
-	task->w = w;
-	task->h = h;
-	task->pitch = pitch;
-	task->basePath = basePath_;
-	task->hashfile = hashfile;
-	task->replacedInfoHash = replacedInfo.hash;
-	task->skipIfExists = skipIfExists;
-	g_threadManager.EnqueueTask(task);  // We don't care about waiting for the task. It'll be fine.
 
 	// Remember that we've saved this for next time.
 	// Should be OK that the actual disk write may not be finished yet.
@@ -680,47 +1036,14 @@ void TextureReplacer::Decimate(ReplacerDecimateMode mode) {
 
 template <typename Key, typename Value>
 static typename std::unordered_map<Key, Value>::const_iterator LookupWildcard(const std::unordered_map<Key, Value> &map, Key &key, u64 cachekey, u32 hash, bool ignoreAddress) {
-	auto alias = map.find(key);
-	if (alias != map.end())
-		return alias;
-
-	// Also check for a few more aliases with zeroed portions:
-	// Only clut hash (very dangerous in theory, in practice not more than missing "just" data hash)
-	key.cachekey = cachekey & 0xFFFFFFFFULL;
-	key.hash = 0;
-	alias = map.find(key);
-	if (alias != map.end())
-		return alias;
-
-	if (!ignoreAddress) {
-		// No data hash.
-		key.cachekey = cachekey;
-		key.hash = 0;
+	auto alias = map.end();
+	LookupWildcardKeys(cachekey, hash, ignoreAddress, [&](u64 keyCachekey, u32 keyHash) {
+		key.cachekey = keyCachekey;
+		key.hash = keyHash;
 		alias = map.find(key);
-		if (alias != map.end())
-			return alias;
-	}
-
-	// No address.
-	key.cachekey = cachekey & 0xFFFFFFFFULL;
-	key.hash = hash;
-	alias = map.find(key);
-	if (alias != map.end())
-		return alias;
-
-	if (!ignoreAddress) {
-		// Address, but not clut hash (in case of garbage clut data.)
-		key.cachekey = cachekey & ~0xFFFFFFFFULL;
-		key.hash = hash;
-		alias = map.find(key);
-		if (alias != map.end())
-			return alias;
-	}
-
-	// Anything with this data hash (a little dangerous.)
-	key.cachekey = 0;
-	key.hash = hash;
-	return map.find(key);
+		return alias != map.end();
+	});
+	return alias;
 }
 
 bool TextureReplacer::FindFiltering(u64 cachekey, u32 hash, TextureFiltering *forceFiltering) {
@@ -810,8 +1133,15 @@ class ReplacedTextureTask : public Task {
 
 bool ReplacedTexture::IsReady(double budget) {
 	lastUsed_ = time_now_d();
-	if (threadWaitable_ && !threadWaitable_->WaitFor(budget)) {
-		return false;
+	// Packed textures are read straight from the mapping, nothing to prepare.
+	if (!levels_.empty() && levels_[0].packData)
+		return true;
+	if (threadWaitable_) {
+		// Without late loading, a preload that's still running has to finish now.
+		if (!g_Config.bReplaceTexturesAllowLate)
+			threadWaitable_->Wait();
+		else if (!threadWaitable_->WaitFor(budget))
+			return false;
 	}
 
 	// Loaded already, or not yet on a thread?
@@ -822,10 +1152,7 @@ bool ReplacedTexture::IsReady(double budget) {
 		return false;
 
 	if (g_Config.bReplaceTexturesAllowLate) {
-		if (threadWaitable_)
-			delete threadWaitable_;
-		threadWaitable_ = new LimitedWaitable();
-		g_threadManager.EnqueueTask(new ReplacedTextureTask(*this, threadWaitable_));
+		StartPrepareTask();
 
 		if (threadWaitable_->WaitFor(budget)) {
 			// If we finished all the levels, we're done.
@@ -840,6 +1167,23 @@ bool ReplacedTexture::IsReady(double budget) {
 	return false;
 }
 
+void ReplacedTexture::Preload() {
+	lastUsed_ = time_now_d();
+	if (!Valid() || levels_[0].packData || !levelData_.empty())
+		return;
+	// Already on its way.
+	if (threadWaitable_ && !threadWaitable_->WaitFor(0.0))
+		return;
+	StartPrepareTask();
+}
+
+void ReplacedTexture::StartPrepareTask() {
+	if (threadWaitable_)
+		delete threadWaitable_;
+	threadWaitable_ = new LimitedWaitable();
+	g_threadManager.EnqueueTask(new ReplacedTextureTask(*this, threadWaitable_));
+}
+
 void ReplacedTexture::Prepare() {
 	std::unique_lock<std::mutex> lock(mutex_);
 	if (cancelPrepare_)
@@ -975,10 +1319,33 @@ bool ReplacedTexture::Load(int level, void *out, int rowPitch) {
 	_assert_msg_((size_t)level < levels_.size(), "Invalid miplevel");
 	_assert_msg_(out != nullptr && rowPitch > 0, "Invalid out/pitch");
 
+	const ReplacedTextureLevel &info = levels_[level];
+	const int MIN_LINES_PER_THREAD = 4;
+
+	if (info.packData) {
+		if (rowPitch == info.w * 4 && info.packW == info.w && info.packH == info.h) {
+			ParallelMemcpy(&g_threadManager, out, info.packData, info.w * 4 * info.h);
+			return true;
+		}
+
+		// Clear the hashrange padding, like the zero-initialized buffer does for files.
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			for (int y = l; y < h; ++y) {
+				uint8_t *dst = (uint8_t *)out + rowPitch * y;
+				int copyW = 0;
+				if (y < info.packH) {
+					copyW = info.packW;
+					memcpy(dst, info.packData + info.packW * 4 * y, copyW * 4);
+				}
+				memset(dst + copyW * 4, 0, (info.w - copyW) * 4);
+			}
+		}, 0, info.h, MIN_LINES_PER_THREAD);
+		return true;
+	}
+
 	if (levelData_.empty())
 		return false;
 
-	const ReplacedTextureLevel &info = levels_[level];
 	const std::vector<uint8_t> &data = levelData_[level];
 
 	if (data.empty())
@@ -988,7 +1355,6 @@ bool ReplacedTexture::Load(int level, void *out, int rowPitch) {
 	if (rowPitch == info.w * 4) {
 		ParallelMemcpy(&g_threadManager, out, &data[0], info.w * 4 * info.h);
 	} else {
-		const int MIN_LINES_PER_THREAD = 4;
 		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
 			for (int y = l; y < h; ++y) {
 				memcpy((uint8_t *)out + rowPitch * y, &data[0] + info.w * 4 * y, info.w * 4);
@@ -1052,3 +1418,131 @@ bool TextureReplacer::GenerateIni(const std::string &gameID, Path &generatedFile
 	}
 	return File::Exists(generatedFilename);
 }
+
+bool TextureReplacer::BuildPack(const std::string &gameID, Path &packFilename) {
+	if (gameID.empty())
+		return false;
+
+	// Use a separate replacer, so the ini is parsed exactly like it would be for replacing.
+	TextureReplacer replacer;
+	replacer.gameID_ = gameID;
+	replacer.basePath_ = GetSysDirectory(DIRECTORY_TEXTURES) / gameID;
+	if (!File::IsDirectory(replacer.basePath_) || !replacer.LoadIni())
+		return false;
+
+	struct PackSource {
+		u64 cachekey;
+		u32 hash;
+		int level;
+		std::string hashfile;  // Empty if ignored.
+	};
+	std::vector<PackSource> sources;
+
+	// The ini goes first, so it wins over a hash named file with the same key.
+	for (const auto &alias : replacer.aliases_) {
+		sources.push_back({ alias.first.cachekey, alias.first.hash, (int)alias.first.level, alias.second });
+	}
+
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(replacer.basePath_, &files, "png");
+	for (const auto &file : files) {
+		unsigned long long cachekey;
+		u32 hash;
+		int level = 0;
+		if (sscanf(file.name.c_str(), "%16llx%8x_%d", &cachekey, &hash, &level) < 2)
+			continue;
+		// Skip anything that only looks a bit like a hash name.
+		if (replacer.HashName(cachekey, hash, level) + ".png" != file.name)
+			continue;
+		sources.push_back({ cachekey, hash, level, file.name });
+	}
+
+	std::stable_sort(sources.begin(), sources.end(), [](const PackSource &a, const PackSource &b) {
+		if (a.cachekey != b.cachekey)
+			return a.cachekey < b.cachekey;
+		if (a.hash != b.hash)
+			return a.hash < b.hash;
+		return a.level < b.level;
+	});
+	sources.erase(std::unique(sources.begin(), sources.end(), [](const PackSource &a, const PackSource &b) {
+		return a.cachekey == b.cachekey && a.hash == b.hash && a.level == b.level;
+	}), sources.end());
+
+	packFilename = replacer.basePath_ / PACK_FILENAME;
+	const Path tempFilename = replacer.basePath_ / (PACK_FILENAME + ".tmp");
+	File::IOFile out(tempFilename, "wb");
+	if (!out.IsOpen()) {
+		ERROR_LOG(G3D, "Unable to create texture pack: %s", tempFilename.ToVisualString().c_str());
+		return false;
+	}
+
+	// The index is written last, once the offsets are known. Unused slots (bad files) stay as slack.
+	std::vector<ReplacementPackEntry> index;
+	index.reserve(sources.size());
+	uint64_t offset = sizeof(ReplacementPackHeader) + sources.size() * sizeof(ReplacementPackEntry);
+	out.Seek(offset, SEEK_SET);
+
+	for (const PackSource &source : sources) {
+		ReplacementPackEntry entry{};
+		entry.cachekey = source.cachekey;
+		entry.hash = source.hash;
+		entry.level = (u16)source.level;
+		entry.fmt = (u8)Draw::DataFormat::R8G8B8A8_UNORM;
+		entry.alpha = (u8)ReplacedTextureAlpha::UNKNOWN;
+
+		if (!source.hashfile.empty()) {
+			ReplacedTexture tex;
+			ReplacedTextureLevel level;
+			level.fmt = Draw::DataFormat::R8G8B8A8_UNORM;
+			level.file = replacer.basePath_ / source.hashfile;
+			if (!File::Exists(level.file) || !replacer.PopulateLevel(level))
+				continue;
+
+			tex.levels_.push_back(level);
+			tex.levelData_.resize(1);
+			tex.alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
+			tex.PrepareData(0);
+			const std::vector<uint8_t> &pixels = tex.levelData_[0];
+			if (pixels.empty())
+				continue;
+
+			// Keep the pixels aligned for the copies out of the mapping.
+			offset = (offset + 15) & ~15ULL;
+			out.Seek(offset, SEEK_SET);
+			if (!out.WriteBytes(pixels.data(), pixels.size()))
+				break;
+
+			entry.alpha = (u8)tex.alphaStatus_;
+			entry.w = level.w;
+			entry.h = level.h;
+			entry.offset = offset;
+			offset += pixels.size();
+		}
+
+		index.push_back(entry);
+	}
+
+	ReplacementPackHeader header{};
+	memcpy(header.magic, "PPTP", 4);
+	header.version = PACK_VERSION;
+	header.numEntries = (u32)index.size();
+	out.Seek(0, SEEK_SET);
+	out.WriteArray(&header, 1);
+	out.WriteArray(index.data(), index.size());
+
+	bool success = out.IsGood();
+	out.Close();
+	if (success) {
+		// Rename() doesn't replace existing files everywhere.
+		File::Delete(packFilename);
+		success = File::Rename(tempFilename, packFilename);
+	}
+	if (!success) {
+		ERROR_LOG(G3D, "Failed to write texture pack: %s", packFilename.ToVisualString().c_str());
+		File::Delete(tempFilename);
+		return false;
+	}
+
+	NOTICE_LOG(G3D, "Built texture pack with %d textures: %s", (int)index.size(), packFilename.ToVisualString().c_str());
+	return true;
+}
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -25,6 +26,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
 #include "Common/File/Path.h"
+#include "Common/File/FileUtil.h"
 #include "Common/GPU/DataFormat.h"
 
 #include "GPU/Common/TextureDecoder.h"
@@ -54,6 +56,34 @@ struct ReplacedTextureLevel {
 	int h;
 	Draw::DataFormat fmt;  // NOTE: Right now, the only supported format is Draw::DataFormat::R8G8B8A8_UNORM.
 	Path file;
+
+	// If loaded from textures.pack, points at the pixels in the mapped pack and file is empty.
+	// The pixels may be smaller than w x h when hashranges pad the texture.
+	const uint8_t *packData = nullptr;
+	int packW = 0;
+	int packH = 0;
+};
+
+// textures.pack holds the replacements of textures.ini and the hash-named files in one file, already
+// decoded, so lookups are a binary search over an index and uploads copy straight out of the mapping.
+// Built from the loose files by TextureReplacer::BuildPack().
+struct ReplacementPackHeader {
+	char magic[4];  // "PPTP"
+	u32 version;
+	u32 numEntries;
+	u32 reserved;
+	// Followed by numEntries ReplacementPackEntry, sorted by cachekey, hash, level.
+};
+
+struct ReplacementPackEntry {
+	u64 cachekey;
+	u32 hash;
+	u16 level;
+	u8 fmt;    // Draw::DataFormat, only R8G8B8A8_UNORM for now.
+	u8 alpha;  // ReplacedTextureAlpha
+	u32 w;     // Zero for textures explicitly ignored in textures.ini.
+	u32 h;
+	u64 offset;  // From the start of the file.
 };
 
 struct ReplacementCacheKey {
@@ -146,10 +176,13 @@ struct ReplacedTexture {
 	}
 
 	bool IsReady(double budget);
+	// Starts loading on a thread if not loaded or loading already, without waiting.
+	void Preload();
 
 	bool Load(int level, void *out, int rowPitch);
 
 protected:
+	void StartPrepareTask();
 	void Prepare();
 	void PrepareData(int level);
 	void PurgeIfOlder(double t);
@@ -176,6 +209,8 @@ struct ReplacedTextureDecodeInfo {
 	Draw::DataFormat fmt;
 };
 
+struct TextureSaveQueue;
+
 enum class ReplacerDecimateMode {
 	NEW_FRAME,
 	FORCE_PRESSURE,
@@ -212,6 +247,8 @@ class TextureReplacer {
 
 	static bool GenerateIni(const std::string &gameID, Path &generatedFilename);
 	static bool IniExists(const std::string &gameID);
+	// Converts the game's textures.ini and replacement files into textures.pack.
+	static bool BuildPack(const std::string &gameID, Path &packFilename);
 
 protected:
 	bool LoadIni();
@@ -225,6 +262,14 @@ class TextureReplacer {
 	std::string HashName(u64 cachekey, u32 hash, int level);
 	void PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h);
 	bool PopulateLevel(ReplacedTextureLevel &level);
+	void LoadPreloadLog();
+	void RecordPreload(u64 cachekey, u32 hash, int w, int h);
+	void FinishPreloadGroup();
+	void TriggerPreload(const ReplacementCacheKey &key);
+	void LoadPack();
+	void ClosePack();
+	const ReplacementPackEntry *FindPackEntry(u64 cachekey, u32 hash, int level) const;
+	bool PopulateFromPack(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h, int newW, int newH);
 
 	bool enabled_ = false;
 	bool allowVideo_ = false;
@@ -242,7 +287,26 @@ class TextureReplacer {
 	std::unordered_map<ReplacementAliasKey, std::string> aliases_;
 	std::unordered_map<ReplacementCacheKey, TextureFiltering> filtering_;
 
+	struct PreloadEntry {
+		u64 cachekey;
+		u32 hash;
+		int w;
+		int h;
+	};
+	// Replacements that were first seen together, loaded all at once when any of them is seen again.
+	std::vector<std::vector<PreloadEntry>> preloadGroups_;
+	std::vector<double> preloadGroupTriggered_;
+	std::unordered_map<ReplacementCacheKey, int> preloadGroupIndex_;
+	std::vector<PreloadEntry> recordingGroup_;
+	double recordingLastSeen_ = 0.0;
+	Path preloadLogFilename_;
+
+	File::MappedFile pack_;
+	const ReplacementPackEntry *packIndex_ = nullptr;
+	u32 packEntries_ = 0;
+
 	ReplacedTexture none_;
 	std::unordered_map<ReplacementCacheKey, ReplacedTexture> cache_;
 	std::unordered_map<ReplacementCacheKey, std::pair<ReplacedTextureLevel, double>> savedCache_;
+	std::shared_ptr<TextureSaveQueue> saveQueue_;
 };
@@ -15,6 +15,9 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <cmath>
+
 #include "ppsspp_config.h"
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
@@ -151,3 +154,51 @@ void ConvertS16ToF32(float *out, const s16 *in, size_t size) {
 		out[i] = in[i] * (1.0f / 32767.0f);
 	}
 }
+
+void ConvertPlanarF32ToS16Stereo(s16 *out, const float *left, const float *right, size_t samples) {
+	// Clamping before converting keeps large positive values from wrapping to INT_MIN.
+#ifdef _M_SSE
+	const __m128 scale = _mm_set_ps1(32768.0f);
+	const __m128 minVal = _mm_set_ps1(-32768.0f);
+	const __m128 maxVal = _mm_set_ps1(32767.0f);
+	while (samples >= 8) {
+		__m128 l1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(left + 0), scale), minVal), maxVal);
+		__m128 l2 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(left + 4), scale), minVal), maxVal);
+		__m128 r1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(right + 0), scale), minVal), maxVal);
+		__m128 r2 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(right + 4), scale), minVal), maxVal);
+		// Uses the current rounding mode, which is round to nearest like lrintf.
+		__m128i l = _mm_packs_epi32(_mm_cvtps_epi32(l1), _mm_cvtps_epi32(l2));
+		__m128i r = _mm_packs_epi32(_mm_cvtps_epi32(r1), _mm_cvtps_epi32(r2));
+		_mm_storeu_si128((__m128i *)out + 0, _mm_unpacklo_epi16(l, r));
+		_mm_storeu_si128((__m128i *)out + 1, _mm_unpackhi_epi16(l, r));
+		left += 8;
+		right += 8;
+		out += 16;
+		samples -= 8;
+	}
+#elif PPSSPP_ARCH(ARM64)
+	// ARMv7 NEON can only truncate, so this is 64-bit only.
+	const float32x4_t minVal = vdupq_n_f32(-32768.0f);
+	const float32x4_t maxVal = vdupq_n_f32(32767.0f);
+	while (samples >= 8) {
+		float32x4_t l1 = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(left + 0), 32768.0f), minVal), maxVal);
+		float32x4_t l2 = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(left + 4), 32768.0f), minVal), maxVal);
+		float32x4_t r1 = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(right + 0), 32768.0f), minVal), maxVal);
+		float32x4_t r2 = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(right + 4), 32768.0f), minVal), maxVal);
+		int16x8x2_t lr;
+		lr.val[0] = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(l1)), vqmovn_s32(vcvtnq_s32_f32(l2)));
+		lr.val[1] = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(r1)), vqmovn_s32(vcvtnq_s32_f32(r2)));
+		vst2q_s16(out, lr);
+		left += 8;
+		right += 8;
+		out += 16;
+		samples -= 8;
+	}
+#endif
+	for (size_t i = 0; i < samples; i++) {
+		float l = std::min(std::max(left[i] * 32768.0f, -32768.0f), 32767.0f);
+		float r = std::min(std::max(right[i] * 32768.0f, -32768.0f), 32767.0f);
+		out[i * 2 + 0] = (s16)lrintf(l);
+		out[i * 2 + 1] = (s16)lrintf(r);
+	}
+}
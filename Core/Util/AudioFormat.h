@@ -67,3 +67,6 @@ static inline s16 ApplySampleVolume20Bit(s16 sample, int vol20) {
 
 void AdjustVolumeBlock(s16 *out, s16 *in, size_t size, int leftVol, int rightVol);
 void ConvertS16ToF32(float *ou, const s16 *in, size_t size);
+// Interleaves planar float channels into stereo s16, rounding and clamping like swresample does.
+// For mono, pass the same channel as left and right.
+void ConvertPlanarF32ToS16Stereo(s16 *out, const float *left, const float *right, size_t samples);
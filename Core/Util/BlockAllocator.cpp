@@ -25,7 +25,8 @@
 #include "Core/Util/BlockAllocator.h"
 #include "Core/Reporting.h"
 
-// Slow freaking thing but works (eventually) :)
+// Blocks form a linked list in address order, which is also what gets saved. blocksByStart_ and
+// freeBlocks_ index the same blocks, so lookups are O(log n) and allocation only visits free blocks.
 
 BlockAllocator::BlockAllocator(int grain) : bottom_(NULL), top_(NULL), grain_(grain)
 {
@@ -43,6 +44,7 @@ void BlockAllocator::Init(u32 rangeStart, u32 rangeSize, bool suballoc) {
 	//Initial block, covering everything
 	top_ = new Block(rangeStart_, rangeSize_, false, NULL, NULL);
 	bottom_ = top_;
+	IndexBlock(top_);
 	suballoc_ = suballoc;
 }
 
@@ -55,6 +57,8 @@ void BlockAllocator::Shutdown()
 		bottom_ = next;
 	}
 	top_ = NULL;
+	blocksByStart_.clear();
+	freeBlocks_.clear();
 }
 
 u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop, const char *tag)
@@ -77,9 +81,9 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 	if (!fromTop)
 	{
 		//Allocate from bottom of mem
-		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+		for (auto it = freeBlocks_.begin(); it != freeBlocks_.end(); ++it)
 		{
-			Block &b = *bp;
+			Block &b = *it->second;
 			u32 offset = b.start % grain;
 			if (offset != 0)
 				offset = grain - offset;
@@ -90,8 +94,7 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 				{
 					if (offset >= grain_)
 						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
+					SetTaken(&b, tag);
 					return b.start;
 				}
 				else
@@ -99,8 +102,7 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 					InsertFreeAfter(&b, b.size - needed);
 					if (offset >= grain_)
 						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
+					SetTaken(&b, tag);
 					return b.start;
 				}
 			}
@@ -109,9 +111,9 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 	else
 	{
 		// Allocate from top of mem.
-		for (Block *bp = top_; bp != NULL; bp = bp->prev)
+		for (auto it = freeBlocks_.rbegin(); it != freeBlocks_.rend(); ++it)
 		{
-			Block &b = *bp;
+			Block &b = *it->second;
 			u32 offset = (b.start + b.size - size) % grain;
 			u32 needed = offset + size;
 			if (b.taken == false && b.size >= needed)
@@ -120,8 +122,7 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 				{
 					if (offset >= grain_)
 						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
+					SetTaken(&b, tag);
 					return b.start;
 				}
 				else
@@ -129,8 +130,7 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 					InsertFreeBefore(&b, b.size - needed);
 					if (offset >= grain_)
 						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
+					SetTaken(&b, tag);
 					return b.start;
 				}
 			}
@@ -195,8 +195,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 			{
 				if (b.size != alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
-				b.SetAllocated(tag, suballoc_);
+				SetTaken(&b, tag);
 				CheckBlocks();
 				return position;
 			}
@@ -205,8 +204,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 				InsertFreeBefore(&b, alignedPosition - b.start);
 				if (b.size > alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
-				b.SetAllocated(tag, suballoc_);
+				SetTaken(&b, tag);
 
 				return position;
 			}
@@ -232,6 +230,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (prev != NULL && prev->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(fromBlock);
 		prev->size += fromBlock->size;
 		if (fromBlock->next == NULL)
 			top_ = prev;
@@ -252,6 +251,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (next != NULL && next->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(next);
 		fromBlock->size += next->size;
 		fromBlock->next = next->next;
 		delete next;
@@ -271,6 +271,7 @@ bool BlockAllocator::Free(u32 position)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
 		b->taken = false;
+		freeBlocks_[b->start] = b;
 		MergeFreeBlocks(b);
 		return true;
 	}
@@ -288,6 +289,7 @@ bool BlockAllocator::FreeExact(u32 position)
 	{
 		NotifyMemInfo(suballoc_ ? MemBlockFlags::SUB_FREE : MemBlockFlags::FREE, b->start, b->size, "");
 		b->taken = false;
+		freeBlocks_[b->start] = b;
 		MergeFreeBlocks(b);
 		return true;
 	}
@@ -307,8 +309,11 @@ BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 	else
 		inserted->prev->next = inserted;
 
+	UnindexBlock(b);
 	b->start += size;
 	b->size -= size;
+	IndexBlock(b);
+	IndexBlock(inserted);
 	return inserted;
 }
 
@@ -322,9 +327,35 @@ BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 		inserted->next->prev = inserted;
 
 	b->size -= size;
+	IndexBlock(inserted);
 	return inserted;
 }
 
+void BlockAllocator::IndexBlock(Block *b) {
+	blocksByStart_[b->start] = b;
+	if (!b->taken)
+		freeBlocks_[b->start] = b;
+}
+
+void BlockAllocator::UnindexBlock(Block *b) {
+	blocksByStart_.erase(b->start);
+	if (!b->taken)
+		freeBlocks_.erase(b->start);
+}
+
+void BlockAllocator::SetTaken(Block *b, const char *tag) {
+	freeBlocks_.erase(b->start);
+	b->taken = true;
+	b->SetAllocated(tag, suballoc_);
+}
+
+void BlockAllocator::RebuildIndex() {
+	blocksByStart_.clear();
+	freeBlocks_.clear();
+	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+		IndexBlock(bp);
+}
+
 void BlockAllocator::CheckBlocks() const
 {
 	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
@@ -347,29 +378,26 @@ const char *BlockAllocator::GetBlockTag(u32 addr) const {
 
 inline BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
 {
-	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
+	// The last block starting at or before addr is the only candidate.
+	auto it = blocksByStart_.upper_bound(addr);
+	if (it == blocksByStart_.begin())
+		return NULL;
+	--it;
+	Block *bp = it->second;
+	if (bp->start + bp->size > addr)
+		return bp;
 	return NULL;
 }
 
 const BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr) const
 {
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		const Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
+	auto it = blocksByStart_.upper_bound(addr);
+	if (it == blocksByStart_.begin())
+		return NULL;
+	--it;
+	const Block *bp = it->second;
+	if (bp->start + bp->size > addr)
+		return bp;
 	return NULL;
 }
 
@@ -405,14 +433,10 @@ void BlockAllocator::ListBlocks() const
 u32 BlockAllocator::GetLargestFreeBlockSize() const
 {
 	u32 maxFreeBlock = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	for (const auto &it : freeBlocks_)
 	{
-		const Block &b = *bp;
-		if (!b.taken)
-		{
-			if (b.size > maxFreeBlock)
-				maxFreeBlock = b.size;
-		}
+		if (it.second->size > maxFreeBlock)
+			maxFreeBlock = it.second->size;
 	}
 	if (maxFreeBlock & (grain_ - 1))
 		WARN_LOG_REPORT(HLE, "GetLargestFreeBlockSize: free size %08x does not align to grain %08x.", maxFreeBlock, grain_);
@@ -422,13 +446,9 @@ u32 BlockAllocator::GetLargestFreeBlockSize() const
 u32 BlockAllocator::GetTotalFreeBytes() const
 {
 	u32 sum = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	for (const auto &it : freeBlocks_)
 	{
-		const Block &b = *bp;
-		if (!b.taken)
-		{
-			sum += b.size;
-		}
+		sum += it.second->size;
 	}
 	if (sum & (grain_ - 1))
 		WARN_LOG_REPORT(HLE, "GetTotalFreeBytes: free size %08x does not align to grain %08x.", sum, grain_);
@@ -459,6 +479,7 @@ void BlockAllocator::DoState(PointerWrap &p)
 			top_->next->DoState(p);
 			top_ = top_->next;
 		}
+		RebuildIndex();
 	}
 	else
 	{
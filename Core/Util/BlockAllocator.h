@@ -19,6 +19,8 @@
 
 class PointerWrap;
 
+#include <map>
+
 #include "Common/CommonTypes.h"
 
 class BlockAllocator
@@ -74,6 +76,9 @@ class BlockAllocator
 
 	Block *bottom_;
 	Block *top_;
+	// Indexes into the block list by start address, so lookups and first-fit searches don't walk every block.
+	std::map<u32, Block *> blocksByStart_;
+	std::map<u32, Block *> freeBlocks_;
 	u32 rangeStart_;
 	u32 rangeSize_;
 
@@ -85,4 +90,8 @@ class BlockAllocator
 	const Block *GetBlockFromAddress(u32 addr) const;
 	Block *InsertFreeBefore(Block *b, u32 size);
 	Block *InsertFreeAfter(Block *b, u32 size);
+	void IndexBlock(Block *b);
+	void UnindexBlock(Block *b);
+	void SetTaken(Block *b, const char *tag);
+	void RebuildIndex();
 };
@@ -18,8 +18,10 @@
 #include "ppsspp_config.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstring>
+#include <mutex>
 #include <string>
 #include <set>
 #include <sstream>
@@ -38,6 +40,7 @@
 #include "Common/Log.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Core/Config.h"
 #include "Core/Loaders.h"
 #include "Core/ELF/ParamSFO.h"
@@ -463,7 +466,7 @@ std::string GameManager::GetISOGameID(FileLoader *loader) const {
 	return sfo.GetValueString("DISC_ID");
 }
 
-bool GameManager::ExtractFile(struct zip *z, int file_index, const Path &outFilename, size_t *bytesCopied, size_t allBytes) {
+bool GameManager::ExtractFile(struct zip *z, int file_index, const Path &outFilename, std::atomic<size_t> *bytesCopied, size_t allBytes) {
 	struct zip_stat zstat;
 	zip_stat_index(z, file_index, 0, &zstat);
 	size_t size = zstat.size;
@@ -506,8 +509,8 @@ bool GameManager::ExtractFile(struct zip *z, int file_index, const Path &outFile
 			}
 			pos += readSize;
 
-			*bytesCopied += readSize;
-			installProgress_ = (float)*bytesCopied / (float)allBytes;
+			size_t copied = bytesCopied->fetch_add(readSize) + readSize;
+			installProgress_ = (float)copied / (float)allBytes;
 		}
 		zip_fclose(zf);
 		fclose(f);
@@ -521,7 +524,7 @@ bool GameManager::ExtractFile(struct zip *z, int file_index, const Path &outFile
 
 bool GameManager::InstallMemstickGame(struct zip *z, const Path &zipfile, const Path &dest, const ZipFileInfo &info, bool allowRoot, bool deleteAfter) {
 	size_t allBytes = 0;
-	size_t bytesCopied = 0;
+	std::atomic<size_t> bytesCopied(0);
 
 	auto sy = GetI18NCategory("System");
 
@@ -570,8 +573,12 @@ bool GameManager::InstallMemstickGame(struct zip *z, const Path &zipfile, const
 		}
 	}
 
-	// Now, loop through again in a second pass, writing files.
-	std::vector<Path> createdFiles;
+	// Now, loop through again in a second pass, collecting the files to write.
+	struct ExtractEntry {
+		int index;
+		Path outFilename;
+	};
+	std::vector<ExtractEntry> entries;
 	for (int i = 0; i < info.numFiles; i++) {
 		const char *fn = zip_get_name(z, i, 0);
 		// Note that we do NOT write files that are not in a directory, to avoid random
@@ -584,14 +591,50 @@ bool GameManager::InstallMemstickGame(struct zip *z, const Path &zipfile, const
 			if (isDir)
 				continue;
 
-			if (!ExtractFile(z, i, outFilename, &bytesCopied, allBytes)) {
-				goto bail;
-			} else {
-				createdFiles.push_back(outFilename);
+			entries.push_back({ i, outFilename });
+		}
+	}
+
+	{
+		// Entries are independent, so decompress them in parallel. A libzip handle can't be shared
+		// between threads though, so each chunk borrows its own from this pool (opening more as needed.)
+		std::mutex zipPoolLock;
+		std::vector<struct zip *> zipPool{ z };
+		std::atomic<bool> failed(false);
+
+		ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+			struct zip *wz = nullptr;
+			{
+				std::lock_guard<std::mutex> guard(zipPoolLock);
+				if (!zipPool.empty()) {
+					wz = zipPool.back();
+					zipPool.pop_back();
+				}
 			}
+			if (!wz)
+				wz = ZipOpenPath(zipfile);
+			if (!wz) {
+				failed = true;
+				return;
+			}
+
+			for (int i = lower; i < upper && !failed; i++) {
+				if (!ExtractFile(wz, entries[i].index, entries[i].outFilename, &bytesCopied, allBytes))
+					failed = true;
+			}
+
+			std::lock_guard<std::mutex> guard(zipPoolLock);
+			zipPool.push_back(wz);
+		}, 0, (int)entries.size(), 16);
+
+		for (struct zip *pz : zipPool) {
+			if (pz != z)
+				zip_close(pz);
 		}
+		if (failed)
+			goto bail;
 	}
-	INFO_LOG(HLE, "Extracted %d files from zip (%d bytes / %d).", info.numFiles, (int)bytesCopied, (int)allBytes);
+	INFO_LOG(HLE, "Extracted %d files from zip (%d bytes / %d).", (int)entries.size(), (int)bytesCopied, (int)allBytes);
 
 	zip_close(z);
 	z = nullptr;
@@ -607,8 +650,9 @@ bool GameManager::InstallMemstickGame(struct zip *z, const Path &zipfile, const
 	// We end up here if disk is full or couldn't write to storage for some other reason.
 	zip_close(z);
 	// We don't delete the original in this case. Try to delete the files we created so far.
-	for (size_t i = 0; i < createdFiles.size(); i++) {
-		File::Delete(createdFiles[i]);
+	for (const ExtractEntry &entry : entries) {
+		if (File::Exists(entry.outFilename))
+			File::Delete(entry.outFilename);
 	}
 	for (auto const &iter : createdDirs) {
 		File::DeleteDir(iter);
@@ -634,7 +678,7 @@ bool GameManager::InstallZippedISO(struct zip *z, int isoFileIndex, const Path &
 	}
 
 	Path outputISOFilename = Path(g_Config.currentDirectory) / fn.substr(nameOffset);
-	size_t bytesCopied = 0;
+	std::atomic<size_t> bytesCopied(0);
 	if (ExtractFile(z, isoFileIndex, outputISOFilename, &bytesCopied, allBytes)) {
 		INFO_LOG(IO, "Successfully extracted ISO file to '%s'", outputISOFilename.c_str());
 	}
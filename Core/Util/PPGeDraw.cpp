@@ -119,11 +119,15 @@ struct PPGeTextDrawerCacheKey {
 			return align < other.align;
 		if (wrapWidth != other.wrapWidth)
 			return wrapWidth < other.wrapWidth;
+		if (scale != other.scale)
+			return scale < other.scale;
 		return text < other.text;
 	}
 	std::string text;
 	int align;
 	float wrapWidth;
+	// The image is rendered at this scale, so the same text at another size is a different image.
+	float scale;
 };
 struct PPGeTextDrawerImage {
 	TextStringEntry entry;
@@ -249,12 +253,11 @@ void __PPGeInit() {
 	}
 
 	if (loadedZIM) {
-		size_t atlas_data_size;
 		if (!g_ppge_atlas.IsMetadataLoaded()) {
-			uint8_t *atlas_data = VFSReadFile("ppge_atlas.meta", &atlas_data_size);
+			VFSFileView *atlas_data = VFSOpenFile("ppge_atlas.meta");
 			if (atlas_data)
-				g_ppge_atlas.Load(atlas_data, atlas_data_size);
-			delete[] atlas_data;
+				g_ppge_atlas.Load(atlas_data->Data(), atlas_data->Size());
+			delete atlas_data;
 		}
 	}
 
@@ -345,7 +348,7 @@ void __PPGeDoState(PointerWrap &p)
 			textDrawerImages.clear();
 			for (uint32_t i = 0; i < sz; ++i) {
 				// We only care about the pointers, so we can free them.  We'll decimate right away.
-				PPGeTextDrawerCacheKey key{ StringFromFormat("__savestate__%d", i), -1, -1 };
+				PPGeTextDrawerCacheKey key{ StringFromFormat("__savestate__%d", i), -1, -1, 1.0f };
 				textDrawerImages[key] = PPGeTextDrawerImage{};
 				Do(p, textDrawerImages[key].ptr);
 			}
@@ -856,7 +859,7 @@ static PPGeTextDrawerImage PPGeGetTextImage(const char *text, const PPGeStyle &s
 		tdalign |= FLAG_WRAP_TEXT;
 	}
 
-	PPGeTextDrawerCacheKey key{ text, tdalign, maxWidth / style.scale };
+	PPGeTextDrawerCacheKey key{ text, tdalign, maxWidth / style.scale, style.scale };
 	PPGeTextDrawerImage im{};
 
 	auto cacheItem = textDrawerImages.find(key);
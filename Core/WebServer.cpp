@@ -180,12 +180,9 @@ static void DiscHandler(const http::Request &request, const Path &filename) {
 		}
 
 		FILE *fp = File::OpenCFile(filename, "rb");
-		if (!fp || fseek(fp, begin, SEEK_SET) != 0) {
+		if (!fp) {
 			request.WriteHttpResponseHeader("1.0", 500, -1, "text/plain");
 			request.Out()->Push("File access failed.");
-			if (fp) {
-				fclose(fp);
-			}
 			return;
 		}
 
@@ -194,17 +191,11 @@ static void DiscHandler(const http::Request &request, const Path &filename) {
 		sprintf(contentRange, "Content-Range: bytes %lld-%lld/%lld\r\n", begin, last, sz);
 		request.WriteHttpResponseHeader("1.0", 206, len, "application/octet-stream", contentRange);
 
-		const size_t CHUNK_SIZE = 16 * 1024;
-		char *buf = new char[CHUNK_SIZE];
-		for (s64 pos = 0; pos < len; pos += CHUNK_SIZE) {
-			s64 chunklen = std::min(len - pos, (s64)CHUNK_SIZE);
-			if (fread(buf, chunklen, 1, fp) != 1)
-				break;
-			request.Out()->Push(buf, chunklen);
+		if (!request.WriteFileRange(fp, begin, len)) {
+			// The client got less than we promised, so it can't reuse this connection.
+			request.DisableKeepAlive();
 		}
 		fclose(fp);
-		delete[] buf;
-		request.Out()->Flush();
 	} else {
 		request.WriteHttpResponseHeader("1.0", 418, -1, "text/plain");
 		request.Out()->Push("This server only supports range requests.");
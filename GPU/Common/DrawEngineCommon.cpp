@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <cstring>
 
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/Profiler/Profiler.h"
@@ -23,9 +24,21 @@
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
+#include "GPU/Debugger/DrawProfile.h"
 #include "GPU/ge_constants.h"
 #include "GPU/GPUState.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 #define QUAD_INDICES_MAX 65536
 
 enum {
@@ -94,6 +107,7 @@ int DrawEngineCommon::ComputeNumVertsToDecode() const {
 }
 
 void DrawEngineCommon::DecodeVerts(u8 *dest) {
+	GPUDrawProfile::Scope profile(GPUDrawProfile::Cost::DECODE);
 	const UVScale origUV = gstate_c.uv;
 	for (; decodeCounter_ < numDrawCalls; decodeCounter_++) {
 		gstate_c.uv = drawCalls[decodeCounter_].uvScale;
@@ -130,7 +144,7 @@ std::string DrawEngineCommon::DebugGetVertexLoaderString(std::string id, DebugSh
 struct Plane {
 	float x, y, z, w;
 	void Set(float _x, float _y, float _z, float _w) { x = _x; y = _y; z = _z; w = _w; }
-	float Test(float f[3]) const { return x * f[0] + y * f[1] + z * f[2] + w; }
+	float Test(const float f[3]) const { return x * f[0] + y * f[1] + z * f[2] + w; }
 };
 
 static void PlanesFromMatrix(float mtx[16], Plane planes[6]) {
@@ -188,76 +202,180 @@ u32 DrawEngineCommon::NormalizeVertices(u8 *outPtr, u8 *bufPtr, const u8 *inPtr,
 	return DrawEngineCommon::NormalizeVertices(outPtr, bufPtr, inPtr, dec, lowerBound, upperBound, vertType);
 }
 
-// This code has plenty of potential for optimization.
-//
+void DrawEngineCommon::UpdateBoundingBoxPlanes() {
+	// Comparing the matrices is much cheaper than the two multiplies, and games tend to
+	// test many boxes in a row under the same transform.
+	if (bboxPlanesValid_ &&
+		memcmp(bboxWorld_, gstate.worldMatrix, sizeof(bboxWorld_)) == 0 &&
+		memcmp(bboxView_, gstate.viewMatrix, sizeof(bboxView_)) == 0 &&
+		memcmp(bboxProj_, gstate.projMatrix, sizeof(bboxProj_)) == 0) {
+		return;
+	}
+	memcpy(bboxWorld_, gstate.worldMatrix, sizeof(bboxWorld_));
+	memcpy(bboxView_, gstate.viewMatrix, sizeof(bboxView_));
+	memcpy(bboxProj_, gstate.projMatrix, sizeof(bboxProj_));
+
+	Plane planes[6];
+
+	float world[16];
+	float view[16];
+	float worldview[16];
+	float worldviewproj[16];
+	ConvertMatrix4x3To4x4(world, gstate.worldMatrix);
+	ConvertMatrix4x3To4x4(view, gstate.viewMatrix);
+	Matrix4ByMatrix4(worldview, world, view);
+	Matrix4ByMatrix4(worldviewproj, worldview, gstate.projMatrix);
+	PlanesFromMatrix(worldviewproj, planes);
+
+	for (int i = 0; i < 8; i++) {
+		// The two padding planes accept every point.
+		bboxPlanes_.x[i] = i < 6 ? planes[i].x : 0.0f;
+		bboxPlanes_.y[i] = i < 6 ? planes[i].y : 0.0f;
+		bboxPlanes_.z[i] = i < 6 ? planes[i].z : 0.0f;
+		bboxPlanes_.w[i] = i < 6 ? planes[i].w : 1.0f;
+	}
+
+	bboxPlanesValid_ = true;
+	bboxPlanesGen_++;
+}
+
+// Returns false if all the points are outside any single plane. A point counts as inside
+// unless its distance is negative, so NaNs are inside, same as the scalar test always did.
+static bool TestPointsAgainstPlanes(const float *verts, int vertexCount, const float *px, const float *py, const float *pz, const float *pw) {
+#if defined(_M_SSE)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 px0 = _mm_load_ps(px), px1 = _mm_load_ps(px + 4);
+	const __m128 py0 = _mm_load_ps(py), py1 = _mm_load_ps(py + 4);
+	const __m128 pz0 = _mm_load_ps(pz), pz1 = _mm_load_ps(pz + 4);
+	const __m128 pw0 = _mm_load_ps(pw), pw1 = _mm_load_ps(pw + 4);
+	__m128 inside0 = zero;
+	__m128 inside1 = zero;
+	for (int i = 0; i < vertexCount; i++) {
+		const __m128 vx = _mm_set1_ps(verts[i * 3]);
+		const __m128 vy = _mm_set1_ps(verts[i * 3 + 1]);
+		const __m128 vz = _mm_set1_ps(verts[i * 3 + 2]);
+		__m128 d0 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px0, vx), _mm_mul_ps(py0, vy)), _mm_mul_ps(pz0, vz)), pw0);
+		__m128 d1 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px1, vx), _mm_mul_ps(py1, vy)), _mm_mul_ps(pz1, vz)), pw1);
+		inside0 = _mm_or_ps(inside0, _mm_cmpnlt_ps(d0, zero));
+		inside1 = _mm_or_ps(inside1, _mm_cmpnlt_ps(d1, zero));
+		// Once every plane has a point inside, the rest can't change the answer.
+		if ((_mm_movemask_ps(_mm_and_ps(inside0, inside1)) & 0xF) == 0xF)
+			return true;
+	}
+	return false;
+#elif PPSSPP_ARCH(ARM_NEON)
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t px0 = vld1q_f32(px), px1 = vld1q_f32(px + 4);
+	const float32x4_t py0 = vld1q_f32(py), py1 = vld1q_f32(py + 4);
+	const float32x4_t pz0 = vld1q_f32(pz), pz1 = vld1q_f32(pz + 4);
+	const float32x4_t pw0 = vld1q_f32(pw), pw1 = vld1q_f32(pw + 4);
+	uint32x4_t inside0 = vdupq_n_u32(0);
+	uint32x4_t inside1 = vdupq_n_u32(0);
+	for (int i = 0; i < vertexCount; i++) {
+		const float32x4_t vx = vdupq_n_f32(verts[i * 3]);
+		const float32x4_t vy = vdupq_n_f32(verts[i * 3 + 1]);
+		const float32x4_t vz = vdupq_n_f32(verts[i * 3 + 2]);
+		float32x4_t d0 = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(px0, vx), vmulq_f32(py0, vy)), vmulq_f32(pz0, vz)), pw0);
+		float32x4_t d1 = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(px1, vx), vmulq_f32(py1, vy)), vmulq_f32(pz1, vz)), pw1);
+		inside0 = vorrq_u32(inside0, vmvnq_u32(vcltq_f32(d0, zero)));
+		inside1 = vorrq_u32(inside1, vmvnq_u32(vcltq_f32(d1, zero)));
+		uint32x4_t all = vandq_u32(inside0, inside1);
+		uint32x2_t half = vand_u32(vget_low_u32(all), vget_high_u32(all));
+		if ((vget_lane_u32(half, 0) & vget_lane_u32(half, 1)) != 0)
+			return true;
+	}
+	return false;
+#else
+	bool inside[6]{};
+	int insideCount = 0;
+	for (int i = 0; i < vertexCount; i++) {
+		const float *v = verts + i * 3;
+		for (int plane = 0; plane < 6; plane++) {
+			if (inside[plane])
+				continue;
+			float value = px[plane] * v[0] + py[plane] * v[1] + pz[plane] * v[2] + pw[plane];
+			if (!(value < 0)) {
+				inside[plane] = true;
+				insideCount++;
+			}
+		}
+		if (insideCount == 6)
+			return true;
+	}
+	return false;
+#endif
+}
+
 // It does the simplest and safest test possible: If all points of a bbox is outside a single of
 // our clipping planes, we reject the box. Tighter bounds would be desirable but would take more calculations.
 bool DrawEngineCommon::TestBoundingBox(const void* control_points, int vertexCount, u32 vertType, int *bytesRead) {
 	SimpleVertex *corners = (SimpleVertex *)(decoded + 65536 * 12);
 	float *verts = (float *)(decoded + 65536 * 18);
 
+	UpdateBoundingBoxPlanes();
+	const BBoxPlanes &p = bboxPlanes_;
+
 	// Try to skip NormalizeVertices if it's pure positions. No need to bother with a vertex decoder
 	// and a large vertex format.
 	if ((vertType & 0xFFFFFF) == GE_VTYPE_POS_FLOAT) {
 		verts = (float *)control_points;
 		*bytesRead = 3 * sizeof(float) * vertexCount;
+		return TestPointsAgainstPlanes(verts, vertexCount, p.x, p.y, p.z, p.w);
 	} else if ((vertType & 0xFFFFFF) == GE_VTYPE_POS_8BIT) {
 		const s8 *vtx = (const s8 *)control_points;
 		for (int i = 0; i < vertexCount * 3; i++) {
 			verts[i] = vtx[i] * (1.0f / 128.0f);
 		}
 		*bytesRead = 3 * sizeof(s8) * vertexCount;
+		return TestPointsAgainstPlanes(verts, vertexCount, p.x, p.y, p.z, p.w);
 	} else if ((vertType & 0xFFFFFF) == GE_VTYPE_POS_16BIT) {
 		const s16 *vtx = (const s16*)control_points;
 		for (int i = 0; i < vertexCount * 3; i++) {
 			verts[i] = vtx[i] * (1.0f / 32768.0f);
 		}
 		*bytesRead = 3 * sizeof(s16) * vertexCount;
-	} else {
-		// Simplify away bones and morph before proceeding
-		u8 *temp_buffer = decoded + 65536 * 24;
-		int vertexSize = 0;
-		NormalizeVertices((u8 *)corners, temp_buffer, (const u8 *)control_points, 0, vertexCount, vertType, &vertexSize);
-		for (int i = 0; i < vertexCount; i++) {
-			verts[i * 3] = corners[i].pos.x;
-			verts[i * 3 + 1] = corners[i].pos.y;
-			verts[i * 3 + 2] = corners[i].pos.z;
-		}
-		*bytesRead = vertexSize * vertexCount;
+		return TestPointsAgainstPlanes(verts, vertexCount, p.x, p.y, p.z, p.w);
 	}
 
-	Plane planes[6];
-
-	float world[16];
-	float view[16];
-	float worldview[16];
-	float worldviewproj[16];
-	ConvertMatrix4x3To4x4(world, gstate.worldMatrix);
-	ConvertMatrix4x3To4x4(view, gstate.viewMatrix);
-	Matrix4ByMatrix4(worldview, world, view);
-	Matrix4ByMatrix4(worldviewproj, worldview, gstate.projMatrix);
-	PlanesFromMatrix(worldviewproj, planes);
-	for (int plane = 0; plane < 6; plane++) {
-		int inside = 0;
-		int out = 0;
-		for (int i = 0; i < vertexCount; i++) {
-			// Here we can test against the frustum planes!
-			float value = planes[plane].Test(verts + i * 3);
-			if (value < 0)
-				out++;
-			else
-				inside++;
-		}
-
-		if (inside == 0) {
-			// All out
-			return false;
+	// Anything else needs the full vertex decoder, which costs far more than hashing the input.
+	// Without bones or morphing the positions only depend on the input bytes, so we can keep them.
+	const bool cacheable = vertexCount <= BBOX_CACHE_MAX_VERTS && (vertType & (GE_VTYPE_WEIGHT_MASK | GE_VTYPE_MORPHCOUNT_MASK)) == 0;
+	BBoxCacheEntry &entry = bboxCache_[((uintptr_t)control_points >> 4) & (BBOX_CACHE_SIZE - 1)];
+	if (cacheable && entry.ptr == control_points && entry.vertType == (vertType & 0xFFFFFF) && entry.vertexCount == vertexCount) {
+		u64 hash = XXH3_64bits(control_points, entry.bytesRead);
+		if (hash == entry.hash) {
+			*bytesRead = entry.bytesRead;
+			if (entry.planesGen != bboxPlanesGen_) {
+				entry.result = TestPointsAgainstPlanes(entry.pos, vertexCount, p.x, p.y, p.z, p.w);
+				entry.planesGen = bboxPlanesGen_;
+			}
+			return entry.result;
 		}
+	}
 
-		// Any out. For testing that the planes are in the right locations.
-		// if (out != 0) return false;
+	// Simplify away bones and morph before proceeding
+	u8 *temp_buffer = decoded + 65536 * 24;
+	int vertexSize = 0;
+	NormalizeVertices((u8 *)corners, temp_buffer, (const u8 *)control_points, 0, vertexCount, vertType, &vertexSize);
+	for (int i = 0; i < vertexCount; i++) {
+		verts[i * 3] = corners[i].pos.x;
+		verts[i * 3 + 1] = corners[i].pos.y;
+		verts[i * 3 + 2] = corners[i].pos.z;
 	}
-	return true;
+	*bytesRead = vertexSize * vertexCount;
+
+	bool result = TestPointsAgainstPlanes(verts, vertexCount, p.x, p.y, p.z, p.w);
+	if (cacheable) {
+		entry.ptr = control_points;
+		entry.vertType = vertType & 0xFFFFFF;
+		entry.vertexCount = vertexCount;
+		entry.bytesRead = *bytesRead;
+		entry.hash = XXH3_64bits(control_points, entry.bytesRead);
+		entry.planesGen = bboxPlanesGen_;
+		entry.result = result;
+		memcpy(entry.pos, verts, vertexCount * 3 * sizeof(float));
+	}
+	return result;
 }
 
 // TODO: This probably is not the best interface.
@@ -52,7 +52,7 @@ inline uint32_t GetVertTypeID(uint32_t vertType, int uvGenMode) {
 }
 
 struct SimpleVertex;
-namespace Spline { struct Weight2D; }
+namespace Spline { struct Weight; struct Weight2D; }
 
 class TessellationDataTransfer {
 public:
@@ -185,6 +185,40 @@ class DrawEngineCommon {
 	int decodedVerts_ = 0;
 	GEPrimitiveType prevPrim_ = GE_PRIM_INVALID;
 
+	// Bounding box test state. The frustum planes are stored transposed and padded to 8 so
+	// they can be tested four at a time, and are only rebuilt when the matrices change.
+	struct BBoxPlanes {
+		alignas(16) float x[8];
+		alignas(16) float y[8];
+		alignas(16) float z[8];
+		alignas(16) float w[8];
+	};
+	enum {
+		BBOX_CACHE_SIZE = 32,
+		BBOX_CACHE_MAX_VERTS = 64,
+	};
+	struct BBoxCacheEntry {
+		const void *ptr;
+		u32 vertType;
+		int vertexCount;
+		int bytesRead;
+		u64 hash;
+		u32 planesGen;
+		bool result;
+		float pos[BBOX_CACHE_MAX_VERTS * 3];
+	};
+
+	void UpdateBoundingBoxPlanes();
+
+	BBoxPlanes bboxPlanes_{};
+	float bboxWorld_[12]{};
+	float bboxView_[12]{};
+	float bboxProj_[16]{};
+	bool bboxPlanesValid_ = false;
+	u32 bboxPlanesGen_ = 0;
+	// Decoded positions (and the last result) for bboxes that needed the full vertex decoder.
+	BBoxCacheEntry bboxCache_[BBOX_CACHE_SIZE]{};
+
 	// Shader blending state
 	bool fboTexNeedsBind_ = false;
 	bool fboTexBound_ = false;
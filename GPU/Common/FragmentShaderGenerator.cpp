@@ -146,7 +146,12 @@ bool GenerateFragmentShader(const FShaderID &id, char *buffer, const ShaderLangu
 		}
 
 		WRITE(p, "layout (std140, set = 0, binding = 3) uniform baseUBO {\n%s};\n", ub_baseStr);
-		if (doTexture) {
+		if (doTexture && !texture3D && gstate_c.Supports(GPU_USE_BINDLESS_TEXTURES)) {
+			// All of the frame's 2D textures live in one array in set 1, the draw passes its slot.
+			WRITE(p, "layout (set = 1, binding = 0) uniform sampler2D texArray[%d];\n", BINDLESS_TEXTURE_SLOTS);
+			WRITE(p, "layout (push_constant) uniform BindlessTex { int texIndex; } bindless;\n");
+			WRITE(p, "#define tex texArray[bindless.texIndex]\n");
+		} else if (doTexture) {
 			WRITE(p, "layout (binding = 0) uniform %s tex;\n", texture3D ? "sampler3D" : "sampler2D");
 		}
 
@@ -27,12 +27,15 @@
 #include "Common/Math/math_util.h"
 #include "Common/System/Display.h"
 #include "Common/CommonTypes.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/Core.h"
 #include "Core/CoreParameter.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/HW/Display.h"
 #include "Core/Host.h"
+#include "Core/MemFault.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
 #include "GPU/Common/DrawEngineCommon.h"
@@ -49,9 +52,15 @@
 FramebufferManagerCommon::FramebufferManagerCommon(Draw::DrawContext *draw)
 	: draw_(draw), displayFormat_(GE_FORMAT_565) {
 	presentation_ = new PresentationCommon(draw);
+	presentation_->SetTempFramebufferFunc([this](int w, int h, int slot) {
+		return GetTempFBO(TempFBO::POSTSHADER, w, h, slot);
+	});
 }
 
 FramebufferManagerCommon::~FramebufferManagerCommon() {
+	if (lazyReadbackActive_) {
+		Memory::MemFault_UnprotectVRAM(PSP_GetVidMemBase(), Memory::VRAM_SIZE);
+	}
 	DeviceLost();
 
 	DecimateFBOs();
@@ -77,6 +86,8 @@ FramebufferManagerCommon::~FramebufferManagerCommon() {
 	}
 	trackedDepthBuffers_.clear();
 
+	ClearFBOPool();
+
 	delete presentation_;
 }
 
@@ -104,7 +115,53 @@ bool FramebufferManagerCommon::UpdateSize() {
 
 void FramebufferManagerCommon::BeginFrame() {
 	DecimateFBOs();
+	UpdateLazyReadback();
+	UpdateDynamicResolution();
 	currentRenderVfb_ = nullptr;
+	framebufWriteSeq_++;
+}
+
+// Instead of downloading framebuffers eagerly, protect their VRAM and only download the parts the CPU
+// actually reads. The first read of a page still sees the old contents, the ones after see the download.
+void FramebufferManagerCommon::UpdateLazyReadback() {
+	bool enabled = g_Config.bLazyFramebufferReadback && useBufferedRendering_ && Memory::MemFault_CanProtectVRAM();
+	if (!enabled) {
+		if (lazyReadbackActive_) {
+			Memory::MemFault_UnprotectVRAM(PSP_GetVidMemBase(), Memory::VRAM_SIZE);
+			lazyReadbackActive_ = false;
+		}
+		return;
+	}
+	lazyReadbackActive_ = true;
+
+	u32 touchedStart, touchedEnd;
+	if (Memory::MemFault_TakeTouchedVRAM(&touchedStart, &touchedEnd)) {
+		for (VirtualFramebuffer *vfb : vfbs_) {
+			if (!vfb->fbo || vfb->memoryUpdated || !Memory::IsVRAMAddress(vfb->fb_address) || vfb->fb_stride == 0)
+				continue;
+			const u32 bpp = vfb->format == GE_FORMAT_8888 ? 4 : 2;
+			const u32 byteStride = vfb->fb_stride * bpp;
+			const u32 fbStart = vfb->fb_address & (Memory::VRAM_SIZE - 1);
+			const u32 fbEnd = fbStart + ColorBufferByteSize(vfb);
+			if (touchedEnd <= fbStart || touchedStart >= fbEnd)
+				continue;
+
+			// Only the lines that were touched.
+			int y1 = (std::max(touchedStart, fbStart) - fbStart) / byteStride;
+			int y2 = std::min((int)((std::min(touchedEnd, fbEnd) - fbStart + byteStride - 1) / byteStride), (int)vfb->height);
+			if (y2 > y1) {
+				FlushBeforeCopy();
+				ReadFramebufferToMemory(vfb, 0, y1, vfb->width, y2 - y1);
+			}
+		}
+	}
+
+	for (VirtualFramebuffer *vfb : vfbs_) {
+		if (vfb->last_frame_render >= lazyReadbackFlip_ && !vfb->memoryUpdated && Memory::IsVRAMAddress(vfb->fb_address)) {
+			Memory::MemFault_ProtectVRAM(vfb->fb_address, ColorBufferByteSize(vfb));
+		}
+	}
+	lazyReadbackFlip_ = gpuStats.numFlips;
 }
 
 void FramebufferManagerCommon::SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) {
@@ -422,6 +479,7 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 
 	// None found? Create one.
 	if (!vfb) {
+		gpuStats.cache.framebuffersCreated++;
 		vfb = new VirtualFramebuffer{};
 		vfb->fbo = nullptr;
 		vfb->fb_address = params.fb_address;
@@ -468,6 +526,7 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 		frameLastFramebufUsed_ = gpuStats.numFlips;
 		vfbs_.push_back(vfb);
 		currentRenderVfb_ = vfb;
+		framebufWriteSeq_++;
 
 		if (useBufferedRendering_ && !g_Config.bDisableSlowFramebufEffects) {
 			gpu->PerformMemoryUpload(params.fb_address, byteSize);
@@ -514,6 +573,7 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 
 		VirtualFramebuffer *prev = currentRenderVfb_;
 		currentRenderVfb_ = vfb;
+		framebufWriteSeq_++;
 		NotifyRenderFramebufferSwitched(prev, vfb, params.isClearingDepth);
 	} else {
 		vfb->last_frame_render = gpuStats.numFlips;
@@ -533,10 +593,13 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 }
 
 void FramebufferManagerCommon::DestroyFramebuf(VirtualFramebuffer *v) {
+	framebufWriteSeq_++;
 	// Notify the texture cache of both the color and depth buffers.
 	textureCache_->NotifyFramebuffer(v, NOTIFY_FB_DESTROYED);
 	if (v->fbo) {
-		v->fbo->Release();
+		// Download temp buffers are the only ones created without depth.
+		bool z_stencil = std::find(bvfbs_.begin(), bvfbs_.end(), v) == bvfbs_.end();
+		RecycleFramebuffer(v->fbo, z_stencil);
 		v->fbo = nullptr;
 	}
 
@@ -562,6 +625,7 @@ void FramebufferManagerCommon::DestroyFramebuf(VirtualFramebuffer *v) {
 
 void FramebufferManagerCommon::BlitFramebufferDepth(VirtualFramebuffer *src, VirtualFramebuffer *dst) {
 	_dbg_assert_(src && dst);
+	framebufWriteSeq_++;
 
 	// Check that the depth address is even the same before actually blitting.
 	bool matchingDepthBuffer = src->z_address == dst->z_address && src->z_stride != 0 && dst->z_stride != 0;
@@ -580,6 +644,16 @@ void FramebufferManagerCommon::BlitFramebufferDepth(VirtualFramebuffer *src, Vir
 
 	gpuStats.numDepthCopies++;
 
+	// Copies and blits can't scale depth, and some backends can only copy whole depth buffers.
+	// When the depth needs to change size or there's no way to copy it, redraw it with a shader instead.
+	const Draw::DeviceCaps &caps = draw_->GetDeviceCaps();
+	bool sameSize = src->fbo->Width() == dst->fbo->Width() && src->fbo->Height() == dst->fbo->Height();
+	bool canCopy = caps.framebufferDepthCopySupported || caps.framebufferDepthBlitSupported;
+	if ((!sameSize || !canCopy) && CopyFramebufferDepthWithShader(src, dst)) {
+		dst->last_frame_depth_updated = gpuStats.numFlips;
+		return;
+	}
+
 	int w = std::min(src->renderWidth, dst->renderWidth);
 	int h = std::min(src->renderHeight, dst->renderHeight);
 
@@ -597,6 +671,93 @@ void FramebufferManagerCommon::BlitFramebufferDepth(VirtualFramebuffer *src, Vir
 	dst->last_frame_depth_updated = gpuStats.numFlips;
 }
 
+bool FramebufferManagerCommon::CopyFramebufferDepthWithShader(VirtualFramebuffer *src, VirtualFramebuffer *dst) {
+	const ShaderLanguageDesc &shaderLanguageDesc = draw_->GetShaderLanguageDesc();
+	ShaderLanguage lang = shaderLanguageDesc.shaderLanguage;
+	if (depthCopyFailed_ || !gstate_c.Supports(GPU_SUPPORTS_DEPTH_TEXTURE))
+		return false;
+	if (lang != HLSL_D3D11 && lang != GLSL_VULKAN && lang != GLSL_3xx)
+		return false;
+
+	if (!depthCopyPipeline_) {
+		if (!reinterpretVS_) {
+			char *vsCode = new char[4000];
+			GenerateReinterpretVertexShader(vsCode, shaderLanguageDesc);
+			reinterpretVS_ = draw_->CreateShaderModule(ShaderStage::Vertex, lang, (const uint8_t *)vsCode, strlen(vsCode), "reinterpret_vs");
+			delete[] vsCode;
+		}
+
+		char *fsCode = new char[4000];
+		Draw::ShaderModule *depthCopyFS = nullptr;
+		if (reinterpretVS_ && GenerateDepthCopyFragmentShader(fsCode, shaderLanguageDesc)) {
+			depthCopyFS = draw_->CreateShaderModule(ShaderStage::Fragment, lang, (const uint8_t *)fsCode, strlen(fsCode), "depth_copy_fs");
+		}
+		delete[] fsCode;
+		if (!depthCopyFS) {
+			depthCopyFailed_ = true;
+			return false;
+		}
+
+		using namespace Draw;
+		// Depth test has to be on for depth writes to happen, ALWAYS makes it a straight copy.
+		DepthStencilState *depth = draw_->CreateDepthStencilState({ true, true, Comparison::ALWAYS });
+		BlendState *blendstateOff = draw_->CreateBlendState({ false, 0x0 });
+		RasterState *rasterNoCull = draw_->CreateRasterState({});
+
+		PipelineDesc pipelineDesc{ Primitive::TRIANGLE_LIST, { reinterpretVS_, depthCopyFS }, nullptr, depth, blendstateOff, rasterNoCull, nullptr };
+		depthCopyPipeline_ = draw_->CreateGraphicsPipeline(pipelineDesc);
+
+		depth->Release();
+		blendstateOff->Release();
+		rasterNoCull->Release();
+		depthCopyFS->Release();
+
+		if (!depthCopyPipeline_) {
+			depthCopyFailed_ = true;
+			return false;
+		}
+	}
+
+	if (!depthCopySampler_) {
+		// Depth mustn't be filtered.
+		Draw::SamplerStateDesc samplerDesc{};
+		samplerDesc.magFilter = Draw::TextureFilter::NEAREST;
+		samplerDesc.minFilter = Draw::TextureFilter::NEAREST;
+		depthCopySampler_ = draw_->CreateSamplerState(samplerDesc);
+	}
+
+	if (!reinterpretVBuf_) {
+		reinterpretVBuf_ = draw_->CreateBuffer(12 * 3, Draw::BufferUsageFlag::DYNAMIC | Draw::BufferUsageFlag::VERTEXDATA);
+	}
+
+	// The source texture covers this much of PSP space. Stretch it over the same area of dst, in dst's scale.
+	float srcPspWidth = src->fbo->Width() / src->renderScaleFactor;
+	float srcPspHeight = src->fbo->Height() / src->renderScaleFactor;
+
+	draw_->InvalidateCachedState();
+	draw_->BindFramebufferAsRenderTarget(dst->fbo, { Draw::RPAction::KEEP, Draw::RPAction::KEEP, Draw::RPAction::KEEP }, "BlitFramebufferDepth_Shader");
+	draw_->BindPipeline(depthCopyPipeline_);
+	draw_->BindFramebufferAsTexture(src->fbo, 0, Draw::FB_DEPTH_BIT, 0);
+	draw_->BindSamplerStates(0, 1, &depthCopySampler_);
+	draw_->SetScissorRect(0, 0, dst->fbo->Width(), dst->fbo->Height());
+	Draw::Viewport vp = Draw::Viewport{ 0.0f, 0.0f, srcPspWidth * dst->renderScaleFactor, srcPspHeight * dst->renderScaleFactor, 0.0f, 1.0f };
+	draw_->SetViewports(1, &vp);
+	// Vertex buffer not used - vertices generated in shader.
+	draw_->BindVertexBuffers(0, 1, &reinterpretVBuf_, nullptr);
+	draw_->Draw(3, 0);
+	draw_->InvalidateCachedState();
+
+	// Unbind.
+	draw_->BindTexture(0, nullptr);
+
+	shaderManager_->DirtyLastShader();
+	textureCache_->ForgetLastTexture();
+	gstate_c.Dirty(DIRTY_BLEND_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_RASTER_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE | DIRTY_TEXTURE_IMAGE | DIRTY_TEXTURE_PARAMS);
+
+	RebindFramebuffer("After BlitFramebufferDepth_Shader");
+	return true;
+}
+
 TrackedDepthBuffer *FramebufferManagerCommon::GetOrCreateTrackedDepthBuffer(VirtualFramebuffer *vfb) {
 	for (auto tracked : trackedDepthBuffers_) {
 		// Disable tracking if color of the new vfb is clashing with tracked depth.
@@ -686,6 +847,7 @@ void FramebufferManagerCommon::ReinterpretFramebuffer(VirtualFramebuffer *vfb, G
 	if (!useBufferedRendering_ || !vfb->fbo) {
 		return;
 	}
+	framebufWriteSeq_++;
 
 	_assert_(newFormat != oldFormat);
 	// The caller is responsible for updating the format.
@@ -858,7 +1020,7 @@ void FramebufferManagerCommon::NotifyRenderFramebufferSwitched(VirtualFramebuffe
 		if (vfb->fbo) {
 			// This should only happen very briefly when toggling useBufferedRendering_.
 			textureCache_->NotifyFramebuffer(vfb, NOTIFY_FB_DESTROYED);
-			vfb->fbo->Release();
+			RecycleFramebuffer(vfb->fbo, true);
 			vfb->fbo = nullptr;
 		}
 
@@ -949,6 +1111,7 @@ void FramebufferManagerCommon::UpdateFromMemory(u32 addr, int size, bool safe) {
 }
 
 void FramebufferManagerCommon::DrawPixels(VirtualFramebuffer *vfb, int dstX, int dstY, const u8 *srcPixels, GEBufferFormat srcPixelFormat, int srcStride, int width, int height) {
+	framebufWriteSeq_++;
 	textureCache_->ForgetLastTexture();
 	shaderManager_->DirtyLastShader();  // On GL, important that this is BEFORE drawing
 	float u0 = 0.0f, u1 = 1.0f;
@@ -1318,8 +1481,9 @@ void FramebufferManagerCommon::CopyDisplayToOutput(bool reallyDirty) {
 void FramebufferManagerCommon::DecimateFBOs() {
 	currentRenderVfb_ = nullptr;
 
+	// These were replaced during a resize last frame, so they're no longer in use.
 	for (auto iter : fbosToDelete_) {
-		iter->Release();
+		RecycleFramebuffer(iter, true);
 	}
 	fbosToDelete_.clear();
 
@@ -1348,7 +1512,8 @@ void FramebufferManagerCommon::DecimateFBOs() {
 	for (auto it = tempFBOs_.begin(); it != tempFBOs_.end(); ) {
 		int age = frameLastFramebufUsed_ - it->second.last_frame_used;
 		if (age > FBO_OLD_AGE) {
-			it->second.fbo->Release();
+			// Lets another temp use of the same size pick it up, rather than allocating.
+			RecycleFramebuffer(it->second.fbo, (it->first >> 48) == (u64)TempFBO::STENCIL);
 			it = tempFBOs_.erase(it);
 		} else {
 			++it;
@@ -1375,6 +1540,54 @@ void FramebufferManagerCommon::DecimateFBOs() {
 			it++;
 		}
 	}
+
+	DecimateFBOPool();
+}
+
+Draw::Framebuffer *FramebufferManagerCommon::AllocFramebuffer(int w, int h, bool z_stencil, const char *tag) {
+	// Only reuse framebuffers freed in an earlier frame, in case the old one is still sampled from in this one.
+	for (size_t i = 0; i < fboPool_.size(); ++i) {
+		const PooledFBO &entry = fboPool_[i];
+		if (entry.z_stencil == z_stencil && entry.fbo->Width() == w && entry.fbo->Height() == h && entry.frame_freed < gpuStats.numFlips) {
+			Draw::Framebuffer *fbo = entry.fbo;
+			fboPool_.erase(fboPool_.begin() + i);
+			gpuStats.cache.framebufferPoolHits++;
+			return fbo;
+		}
+	}
+
+	gpuStats.cache.framebufferAllocs++;
+	return draw_->CreateFramebuffer({ w, h, 1, 1, z_stencil, tag });
+}
+
+void FramebufferManagerCommon::RecycleFramebuffer(Draw::Framebuffer *fbo, bool z_stencil) {
+	if (!fbo)
+		return;
+	if (fboPool_.size() >= FBO_POOL_MAX) {
+		// Oldest first, so drop from the front.
+		fboPool_.front().fbo->Release();
+		fboPool_.erase(fboPool_.begin());
+	}
+	fboPool_.push_back({ fbo, z_stencil, gpuStats.numFlips });
+}
+
+void FramebufferManagerCommon::DecimateFBOPool() {
+	size_t keep = 0;
+	for (size_t i = 0; i < fboPool_.size(); ++i) {
+		if (fboPool_[i].frame_freed + FBO_POOL_AGE < gpuStats.numFlips) {
+			fboPool_[i].fbo->Release();
+		} else {
+			fboPool_[keep++] = fboPool_[i];
+		}
+	}
+	fboPool_.resize(keep);
+}
+
+void FramebufferManagerCommon::ClearFBOPool() {
+	for (auto &entry : fboPool_) {
+		entry.fbo->Release();
+	}
+	fboPool_.clear();
 }
 
 // Requires width/height to be set already.
@@ -1434,7 +1647,7 @@ void FramebufferManagerCommon::ResizeFramebufFBO(VirtualFramebuffer *vfb, int w,
 
 	if (!useBufferedRendering_) {
 		if (vfb->fbo) {
-			vfb->fbo->Release();
+			RecycleFramebuffer(vfb->fbo, true);
 			vfb->fbo = nullptr;
 		}
 		return;
@@ -1444,10 +1657,13 @@ void FramebufferManagerCommon::ResizeFramebufFBO(VirtualFramebuffer *vfb, int w,
 		return;
 	}
 
+	if (old.fbo)
+		gpuStats.cache.framebuffersResized++;
+
 	shaderManager_->DirtyLastShader();
 	char tag[128];
 	size_t len = snprintf(tag, sizeof(tag), "FB_%08x_%08x_%dx%d_%s", vfb->fb_address, vfb->z_address, w, h, GeBufferFormatToString(vfb->format));
-	vfb->fbo = draw_->CreateFramebuffer({ vfb->renderWidth, vfb->renderHeight, 1, 1, true, tag });
+	vfb->fbo = AllocFramebuffer(vfb->renderWidth, vfb->renderHeight, true, tag);
 	if (Memory::IsVRAMAddress(vfb->fb_address) && vfb->fb_stride != 0) {
 		NotifyMemInfo(MemBlockFlags::ALLOC, vfb->fb_address, ColorBufferByteSize(vfb), tag, len);
 	}
@@ -1472,6 +1688,7 @@ void FramebufferManagerCommon::ResizeFramebufFBO(VirtualFramebuffer *vfb, int w,
 		draw_->BindFramebufferAsRenderTarget(vfb->fbo, { Draw::RPAction::CLEAR, Draw::RPAction::CLEAR, Draw::RPAction::CLEAR }, "ResizeFramebufFBO");
 	}
 	currentRenderVfb_ = vfb;
+	framebufWriteSeq_++;
 
 	if (!vfb->fbo) {
 		ERROR_LOG(FRAMEBUF, "Error creating FBO during resize! %dx%d", vfb->renderWidth, vfb->renderHeight);
@@ -1599,13 +1816,18 @@ bool FramebufferManagerCommon::NotifyFramebufferCopy(u32 src, u32 dst, int size,
 }
 
 // Can't be const, in case it has to create a vfb unfortunately.
-void FramebufferManagerCommon::FindTransferFramebuffers(VirtualFramebuffer *&dstBuffer, VirtualFramebuffer *&srcBuffer, u32 dstBasePtr, int dstStride, int &dstX, int &dstY, u32 srcBasePtr, int srcStride, int &srcX, int &srcY, int &srcWidth, int &srcHeight, int &dstWidth, int &dstHeight, int bpp) {
+void FramebufferManagerCommon::FindTransferFramebuffers(VirtualFramebuffer *&dstBuffer, VirtualFramebuffer *&srcBuffer, u32 dstBasePtr, int dstStride, int &dstX, int &dstY, u32 srcBasePtr, int srcStride, int &srcX, int &srcY, int &srcWidth, int &srcHeight, int &dstWidth, int &dstHeight, int bpp, bool &clipped) {
 	u32 dstYOffset = -1;
 	u32 dstXOffset = -1;
 	u32 srcYOffset = -1;
 	u32 srcXOffset = -1;
 	int width = srcWidth;
 	int height = srcHeight;
+	bool dstClipped = false;
+	bool srcClipped = false;
+	// Transfers that start inside a framebuffer with the same stride but run past its bottom can still
+	// keep the overlapping lines on the GPU. Only try this when block transfers are handled on the GPU.
+	const bool allowClip = g_Config.bBlockTransferGPU;
 
 	dstBasePtr &= 0x3FFFFFFF;
 	srcBasePtr &= 0x3FFFFFFF;
@@ -1630,7 +1852,13 @@ void FramebufferManagerCommon::FindTransferFramebuffers(VirtualFramebuffer *&dst
 			// Some games use mismatching bitdepths.  But make sure the stride matches.
 			// If it doesn't, generally this means we detected the framebuffer with too large a height.
 			// Use bufferHeight in case of buffers that resize up and down often per frame (Valkyrie Profile.)
-			bool match = yOffset < dstYOffset && (int)yOffset <= (int)vfb->bufferHeight - dstHeight;
+			// A full match always wins over a clipped one, whatever the offsets.
+			bool match = (yOffset < dstYOffset || dstClipped) && (int)yOffset <= (int)vfb->bufferHeight - dstHeight;
+			bool clip = false;
+			if (!match && allowClip && (dstBuffer == nullptr || dstClipped) && yOffset < dstYOffset && (int)yOffset < (int)vfb->bufferHeight && vfb_byteStride == byteStride) {
+				match = true;
+				clip = true;
+			}
 			if (match && vfb_byteStride != byteStride) {
 				// Grand Knights History copies with a mismatching stride but a full line at a time.
 				// Makes it hard to detect the wrong transfers in e.g. God of War.
@@ -1647,6 +1875,7 @@ void FramebufferManagerCommon::FindTransferFramebuffers(VirtualFramebuffer *&dst
 					dstHeight = 1;
 				}
 			} else if (match) {
+				// If clipped, the height gets cut down after the loop, it's still needed for full matches.
 				dstWidth = width;
 				dstHeight = height;
 			}
@@ -1654,13 +1883,19 @@ void FramebufferManagerCommon::FindTransferFramebuffers(VirtualFramebuffer *&dst
 				dstYOffset = yOffset;
 				dstXOffset = dstStride == 0 ? 0 : (byteOffset / bpp) % dstStride;
 				dstBuffer = vfb;
+				dstClipped = clip;
 			}
 		}
 		if (vfb_address <= srcBasePtr && srcBasePtr < vfb_address + vfb_size) {
 			const u32 byteOffset = srcBasePtr - vfb_address;
 			const u32 byteStride = srcStride * bpp;
 			const u32 yOffset = byteOffset / byteStride;
-			bool match = yOffset < srcYOffset && (int)yOffset <= (int)vfb->bufferHeight - srcHeight;
+			bool match = (yOffset < srcYOffset || srcClipped) && (int)yOffset <= (int)vfb->bufferHeight - srcHeight;
+			bool clip = false;
+			if (!match && allowClip && (srcBuffer == nullptr || srcClipped) && yOffset < srcYOffset && (int)yOffset < (int)vfb->bufferHeight && vfb_byteStride == byteStride) {
+				match = true;
+				clip = true;
+			}
 			if (match && vfb_byteStride != byteStride) {
 				if (width != srcStride || (byteStride * height != vfb_byteStride && byteStride * height != vfb_byteWidth)) {
 					match = false;
@@ -1676,10 +1911,16 @@ void FramebufferManagerCommon::FindTransferFramebuffers(VirtualFramebuffer *&dst
 				srcYOffset = yOffset;
 				srcXOffset = srcStride == 0 ? 0 : (byteOffset / bpp) % srcStride;
 				srcBuffer = vfb;
+				srcClipped = clip;
 			}
 		}
 	}
 
+	if (dstBuffer && dstClipped)
+		dstHeight = (int)dstBuffer->bufferHeight - (int)dstYOffset;
+	if (srcBuffer && srcClipped)
+		srcHeight = (int)srcBuffer->bufferHeight - (int)srcYOffset;
+
 	if (srcBuffer && !dstBuffer) {
 		if (PSP_CoreParameter().compat.flags().BlockTransferAllowCreateFB ||
 			(PSP_CoreParameter().compat.flags().IntraVRAMBlockTransferAllowCreateFB &&
@@ -1704,6 +1945,8 @@ void FramebufferManagerCommon::FindTransferFramebuffers(VirtualFramebuffer *&dst
 	if (dstBuffer)
 		dstBuffer->last_frame_used = gpuStats.numFlips;
 
+	clipped = (dstBuffer && dstClipped) || (srcBuffer && srcClipped);
+
 	if (dstYOffset != (u32)-1) {
 		dstY += dstYOffset;
 		dstX += dstXOffset;
@@ -1720,6 +1963,7 @@ VirtualFramebuffer *FramebufferManagerCommon::CreateRAMFramebuffer(uint32_t fbAd
 	// A target for the destination is missing - so just create one!
 	// Make sure this one would be found by the algorithm above so we wouldn't
 	// create a new one each frame.
+	gpuStats.cache.framebuffersCreated++;
 	VirtualFramebuffer *vfb = new VirtualFramebuffer{};
 	vfb->fbo = nullptr;
 	vfb->fb_address = fbAddress;  // NOTE - not necessarily in VRAM!
@@ -1743,7 +1987,7 @@ VirtualFramebuffer *FramebufferManagerCommon::CreateRAMFramebuffer(uint32_t fbAd
 	char name[64];
 	snprintf(name, sizeof(name), "%08x_color_RAM", vfb->fb_address);
 	textureCache_->NotifyFramebuffer(vfb, NOTIFY_FB_CREATED);
-	vfb->fbo = draw_->CreateFramebuffer({ vfb->renderWidth, vfb->renderHeight, 1, 1, true, name });
+	vfb->fbo = AllocFramebuffer(vfb->renderWidth, vfb->renderHeight, true, name);
 	vfbs_.push_back(vfb);
 
 	u32 byteSize = ColorBufferByteSize(vfb);
@@ -1775,6 +2019,7 @@ VirtualFramebuffer *FramebufferManagerCommon::FindDownloadTempBuffer(VirtualFram
 
 	// Create a new fbo if none was found for the size
 	if (!nvfb) {
+		gpuStats.cache.framebuffersCreated++;
 		nvfb = new VirtualFramebuffer{};
 		nvfb->fbo = nullptr;
 		nvfb->fb_address = vfb->fb_address;
@@ -1795,7 +2040,7 @@ VirtualFramebuffer *FramebufferManagerCommon::FindDownloadTempBuffer(VirtualFram
 
 		char name[64];
 		snprintf(name, sizeof(name), "download_temp");
-		nvfb->fbo = draw_->CreateFramebuffer({ nvfb->bufferWidth, nvfb->bufferHeight, 1, 1, false, name });
+		nvfb->fbo = AllocFramebuffer(nvfb->bufferWidth, nvfb->bufferHeight, false, name);
 		if (!nvfb->fbo) {
 			ERROR_LOG(FRAMEBUF, "Error creating FBO! %d x %d", nvfb->renderWidth, nvfb->renderHeight);
 			return nullptr;
@@ -1916,10 +2161,14 @@ bool FramebufferManagerCommon::NotifyBlockTransferBefore(u32 dstBasePtr, int dst
 	int dstWidth = width;
 	int dstHeight = height;
 
+	bool clipped = false;
 	// This looks at the compat flags BlockTransferAllowCreateFB*.
-	FindTransferFramebuffers(dstBuffer, srcBuffer, dstBasePtr, dstStride, dstX, dstY, srcBasePtr, srcStride, srcX, srcY, srcWidth, srcHeight, dstWidth, dstHeight, bpp);
+	FindTransferFramebuffers(dstBuffer, srcBuffer, dstBasePtr, dstStride, dstX, dstY, srcBasePtr, srcStride, srcX, srcY, srcWidth, srcHeight, dstWidth, dstHeight, bpp, clipped);
 
 	if (dstBuffer && srcBuffer) {
+		// If either side was clipped, only blit the lines both framebuffers cover. The memory copy
+		// then still runs for the whole transfer, so the lines outside the framebuffers stay right.
+		const int blitHeight = clipped ? std::min(srcHeight, dstHeight) : dstHeight;
 		if (srcBuffer == dstBuffer) {
 			if (srcX != dstX || srcY != dstY) {
 				WARN_LOG_N_TIMES(dstsrc, 100, G3D, "Intra-buffer block transfer %dx%d %dbpp from %08x (x:%d y:%d stride:%d) -> %08x (x:%d y:%d stride:%d)",
@@ -1928,13 +2177,13 @@ bool FramebufferManagerCommon::NotifyBlockTransferBefore(u32 dstBasePtr, int dst
 					dstBasePtr, dstX, dstY, dstStride);
 				FlushBeforeCopy();
 				// Some backends can handle blitting within a framebuffer. Others will just have to deal with it or ignore it, apparently.
-				BlitFramebuffer(dstBuffer, dstX, dstY, srcBuffer, srcX, srcY, dstWidth, dstHeight, bpp, "Blit_IntraBufferBlockTransfer");
+				BlitFramebuffer(dstBuffer, dstX, dstY, srcBuffer, srcX, srcY, dstWidth, blitHeight, bpp, "Blit_IntraBufferBlockTransfer");
 				RebindFramebuffer("rebind after intra block transfer");
 				SetColorUpdated(dstBuffer, skipDrawReason);
-				return true;  // Skip the memory copy.
+				return !clipped;  // Skip the memory copy, unless part of it is outside.
 			} else {
 				// Ignore, nothing to do.  Tales of Phantasia X does this by accident.
-				return true;  // Skip the memory copy.
+				return !clipped;  // Skip the memory copy.
 			}
 		} else {
 			WARN_LOG_N_TIMES(dstnotsrc, 100, G3D, "Inter-buffer block transfer %dx%d %dbpp from %08x (x:%d y:%d stride:%d) -> %08x (x:%d y:%d stride:%d)",
@@ -1943,10 +2192,10 @@ bool FramebufferManagerCommon::NotifyBlockTransferBefore(u32 dstBasePtr, int dst
 				dstBasePtr, dstX, dstY, dstStride);
 			// Straightforward blit between two framebuffers.
 			FlushBeforeCopy();
-			BlitFramebuffer(dstBuffer, dstX, dstY, srcBuffer, srcX, srcY, dstWidth, dstHeight, bpp, "Blit_InterBufferBlockTransfer");
+			BlitFramebuffer(dstBuffer, dstX, dstY, srcBuffer, srcX, srcY, dstWidth, blitHeight, bpp, "Blit_InterBufferBlockTransfer");
 			RebindFramebuffer("RebindFramebuffer - Inter-buffer block transfer");
 			SetColorUpdated(dstBuffer, skipDrawReason);
-			return true;  // No need to actually do the memory copy behind, probably.
+			return !clipped;  // No need to actually do the memory copy behind, probably.
 		}
 		return false;
 	} else if (dstBuffer) {
@@ -1998,7 +2247,8 @@ void FramebufferManagerCommon::NotifyBlockTransferAfter(u32 dstBasePtr, int dstS
 		int srcHeight = height;
 		int dstWidth = width;
 		int dstHeight = height;
-		FindTransferFramebuffers(dstBuffer, srcBuffer, dstBasePtr, dstStride, dstX, dstY, srcBasePtr, srcStride, srcX, srcY, srcWidth, srcHeight, dstWidth, dstHeight, bpp);
+		bool clipped = false;
+		FindTransferFramebuffers(dstBuffer, srcBuffer, dstBasePtr, dstStride, dstX, dstY, srcBasePtr, srcStride, srcX, srcY, srcWidth, srcHeight, dstWidth, dstHeight, bpp, clipped);
 
 		// A few games use this INSTEAD of actually drawing the video image to the screen, they just blast it to
 		// the backbuffer. Detect this and have the framebuffermanager draw the pixels.
@@ -2030,6 +2280,75 @@ void FramebufferManagerCommon::NotifyBlockTransferAfter(u32 dstBasePtr, int dstS
 	}
 }
 
+void FramebufferManagerCommon::UpdateDynamicResolution() {
+	static const double CHECK_INTERVAL = 0.5;
+	static const double SLOW_TIME_TO_LOWER = 2.0;
+	static const double MAX_RAISE_DELAY = 120.0;
+
+	bool enabled = g_Config.bDynamicResolution && useBufferedRendering_ && PSP_CoreParameter().fpsLimit == FPSLimit::NORMAL;
+	if (!enabled) {
+		if (dynamicScale_ != 0) {
+			dynamicScale_ = 0;
+			dynamicResRaiseDelay_ = 10.0;
+			presentation_->SetMaxRenderScale(0);
+			gpu->Resized();
+		}
+		return;
+	}
+
+	double now = time_now_d();
+	if (now < dynamicResNextCheck_)
+		return;
+	dynamicResNextCheck_ = now + CHECK_INTERVAL;
+
+	float vps;
+	__DisplayGetVPS(&vps);
+	// Some games run at 30 or 20 FPS, but the vblank rate stays at 60 at full speed.
+	bool slow = vps < 57.0f;
+	int scale = (int)renderScaleFactor_;
+
+	int newScale = dynamicScale_;
+	if (slow) {
+		dynamicResFastSince_ = 0.0;
+		if (dynamicResSlowSince_ == 0.0)
+			dynamicResSlowSince_ = now;
+		if (now - dynamicResSlowSince_ >= SLOW_TIME_TO_LOWER && scale > 1) {
+			newScale = scale - 1;
+			dynamicResSlowSince_ = 0.0;
+			// If the last raise didn't hold, wait longer before trying again.
+			if (dynamicResLastRaise_ != 0.0 && now - dynamicResLastRaise_ < dynamicResRaiseDelay_)
+				dynamicResRaiseDelay_ = std::min(dynamicResRaiseDelay_ * 2.0, MAX_RAISE_DELAY);
+		}
+	} else {
+		dynamicResSlowSince_ = 0.0;
+		if (dynamicResFastSince_ == 0.0)
+			dynamicResFastSince_ = now;
+		if (dynamicScale_ != 0 && now - dynamicResFastSince_ >= dynamicResRaiseDelay_) {
+			newScale = scale + 1;
+			dynamicResFastSince_ = 0.0;
+			dynamicResLastRaise_ = now;
+		}
+	}
+
+	if (newScale == dynamicScale_)
+		return;
+
+	INFO_LOG(FRAMEBUF, "Dynamic resolution: render scale %d -> %d", scale, newScale);
+	dynamicScale_ = newScale;
+	presentation_->SetMaxRenderScale(dynamicScale_);
+	// Goes through the same path as changing the setting.
+	gpu->Resized();
+
+	int w, h, unlimitedScale;
+	presentation_->SetMaxRenderScale(0);
+	presentation_->CalculateRenderResolution(&w, &h, &unlimitedScale, nullptr, nullptr);
+	if (dynamicScale_ >= unlimitedScale) {
+		// Back at the configured resolution.
+		dynamicScale_ = 0;
+	}
+	presentation_->SetMaxRenderScale(dynamicScale_);
+}
+
 void FramebufferManagerCommon::SetSafeSize(u16 w, u16 h) {
 	VirtualFramebuffer *vfb = currentRenderVfb_;
 	if (vfb) {
@@ -2083,15 +2402,19 @@ void FramebufferManagerCommon::DestroyAllFBOs() {
 		tempFB.second.fbo->Release();
 	}
 	tempFBOs_.clear();
+	framebufWriteSeq_++;
 
 	for (auto iter : fbosToDelete_) {
 		iter->Release();
 	}
 	fbosToDelete_.clear();
+
+	// Sizes usually change after this, and it's also used on device loss.
+	ClearFBOPool();
 }
 
-Draw::Framebuffer *FramebufferManagerCommon::GetTempFBO(TempFBO reason, u16 w, u16 h) {
-	u64 key = ((u64)reason << 48) | ((u32)w << 16) | h;
+Draw::Framebuffer *FramebufferManagerCommon::GetTempFBO(TempFBO reason, u16 w, u16 h, u8 slot) {
+	u64 key = ((u64)reason << 48) | ((u64)slot << 32) | ((u32)w << 16) | h;
 	auto it = tempFBOs_.find(key);
 	if (it != tempFBOs_.end()) {
 		it->second.last_frame_used = gpuStats.numFlips;
@@ -2101,7 +2424,7 @@ Draw::Framebuffer *FramebufferManagerCommon::GetTempFBO(TempFBO reason, u16 w, u
 	bool z_stencil = reason == TempFBO::STENCIL;
 	char name[128];
 	snprintf(name, sizeof(name), "temp_fbo_%dx%d%s", w, h, z_stencil ? "_depth" : "");
-	Draw::Framebuffer *fbo = draw_->CreateFramebuffer({ w, h, 1, 1, z_stencil, name });
+	Draw::Framebuffer *fbo = AllocFramebuffer(w, h, z_stencil, name);
 	if (!fbo) {
 		return nullptr;
 	}
@@ -2204,6 +2527,7 @@ bool FramebufferManagerCommon::GetFramebuffer(u32 fb_address, int fb_stride, GEB
 	buffer.Allocate(w, h, GE_FORMAT_8888, flipY);
 	bool retval = draw_->CopyFramebufferToMemorySync(bound, Draw::FB_COLOR_BIT, 0, 0, w, h, Draw::DataFormat::R8G8B8A8_UNORM, buffer.GetData(), w, "GetFramebuffer");
 	gpuStats.numReadbacks++;
+	gpuStats.cache.framebufferDownloads++;
 	// After a readback we'll have flushed and started over, need to dirty a bunch of things to be safe.
 	gstate_c.Dirty(DIRTY_TEXTURE_IMAGE | DIRTY_TEXTURE_PARAMS);
 	// We may have blitted to a temp FBO.
@@ -2300,7 +2624,7 @@ bool FramebufferManagerCommon::GetOutputFramebuffer(GPUDebugBuffer &buffer) {
 // (Except using the GPU might cause problems because of various implementations'
 // dithering behavior and games that expect exact colors like Danganronpa, so we
 // can't entirely be rid of the CPU path.) -- unknown
-void FramebufferManagerCommon::PackFramebufferSync_(VirtualFramebuffer *vfb, int x, int y, int w, int h) {
+void FramebufferManagerCommon::PackFramebufferSync_(VirtualFramebuffer *vfb, int x, int y, int w, int h, Draw::ReadbackMode mode) {
 	if (!vfb->fbo) {
 		ERROR_LOG_REPORT_ONCE(vfbfbozero, SCEGE, "PackFramebufferSync_: vfb->fbo == 0");
 		return;
@@ -2331,7 +2655,9 @@ void FramebufferManagerCommon::PackFramebufferSync_(VirtualFramebuffer *vfb, int
 	DEBUG_LOG(G3D, "Reading framebuffer to mem, fb_address = %08x, ptr=%p", fb_address, destPtr);
 
 	if (destPtr) {
-		draw_->CopyFramebufferToMemorySync(vfb->fbo, Draw::FB_COLOR_BIT, x, y, w, h, destFormat, destPtr, vfb->fb_stride, "PackFramebufferSync_");
+		// This may be protected for lazy readback, and we're about to make it up to date anyway.
+		Memory::MemFault_UnprotectVRAM(fb_address + dstByteOffset, dstSize);
+		draw_->CopyFramebufferToMemory(vfb->fbo, Draw::FB_COLOR_BIT, x, y, w, h, destFormat, destPtr, vfb->fb_stride, mode, "PackFramebufferSync_");
 		char tag[128];
 		size_t len = snprintf(tag, sizeof(tag), "FramebufferPack/%08x_%08x_%dx%d_%s", vfb->fb_address, vfb->z_address, w, h, GeBufferFormatToString(vfb->format));
 		NotifyMemInfo(MemBlockFlags::WRITE, fb_address + dstByteOffset, dstSize, tag, len);
@@ -2340,6 +2666,13 @@ void FramebufferManagerCommon::PackFramebufferSync_(VirtualFramebuffer *vfb, int
 	}
 
 	gpuStats.numReadbacks++;
+	gpuStats.cache.framebufferDownloads++;
+}
+
+// Some games are fine seeing framebuffer contents that are a frame or two old (the backend decides
+// exactly how old), and the stall of a synchronous readback is very costly.
+static Draw::ReadbackMode GameReadbackMode() {
+	return PSP_CoreParameter().compat.flags().AllowDelayedReadbacks ? Draw::ReadbackMode::OLD_DATA_OK : Draw::ReadbackMode::BLOCK;
 }
 
 void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb, int x, int y, int w, int h) {
@@ -2380,12 +2713,12 @@ void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb,
 
 		if (vfb->renderWidth == vfb->width && vfb->renderHeight == vfb->height) {
 			// No need to blit
-			PackFramebufferSync_(vfb, x, y, w, h);
+			PackFramebufferSync_(vfb, x, y, w, h, GameReadbackMode());
 		} else {
 			VirtualFramebuffer *nvfb = FindDownloadTempBuffer(vfb);
 			if (nvfb) {
 				BlitFramebuffer(nvfb, x, y, vfb, x, y, w, h, 0, "Blit_ReadFramebufferToMemory");
-				PackFramebufferSync_(nvfb, x, y, w, h);
+				PackFramebufferSync_(nvfb, x, y, w, h, GameReadbackMode());
 			}
 		}
 
@@ -2434,7 +2767,7 @@ void FramebufferManagerCommon::DownloadFramebufferForClut(u32 fb_address, u32 lo
 			VirtualFramebuffer *nvfb = FindDownloadTempBuffer(vfb);
 			if (nvfb) {
 				BlitFramebuffer(nvfb, x, y, vfb, x, y, w, h, 0, "Blit_DownloadFramebufferForClut");
-				PackFramebufferSync_(nvfb, x, y, w, h);
+				PackFramebufferSync_(nvfb, x, y, w, h, GameReadbackMode());
 			}
 
 			textureCache_->ForgetLastTexture();
@@ -2490,10 +2823,15 @@ void FramebufferManagerCommon::DeviceLost() {
 	DoRelease(reinterpretVBuf_);
 	DoRelease(reinterpretSampler_);
 	DoRelease(reinterpretVS_);
+	DoRelease(depthCopyPipeline_);
+	DoRelease(depthCopySampler_);
+	depthCopyFailed_ = false;
 	DoRelease(stencilUploadFs_);
 	DoRelease(stencilUploadVs_);
 	DoRelease(stencilUploadSampler_);
 	DoRelease(stencilUploadPipeline_);
+	DoRelease(stencilUploadExportFs_);
+	DoRelease(stencilUploadExportPipeline_);
 	DoRelease(draw2DPipelineLinear_);
 	DoRelease(draw2DSamplerNearest_);
 	DoRelease(draw2DSamplerLinear_);
@@ -2562,6 +2900,7 @@ void FramebufferManagerCommon::DrawActiveTexture(float x, float y, float w, floa
 }
 
 void FramebufferManagerCommon::BlitFramebuffer(VirtualFramebuffer *dst, int dstX, int dstY, VirtualFramebuffer *src, int srcX, int srcY, int w, int h, int bpp, const char *tag) {
+	framebufWriteSeq_++;
 	if (!dst->fbo || !src->fbo || !useBufferedRendering_) {
 		// This can happen if they recently switched from non-buffered.
 		if (useBufferedRendering_) {
@@ -2628,6 +2967,8 @@ void FramebufferManagerCommon::BlitFramebuffer(VirtualFramebuffer *dst, int dstX
 		return;
 	}
 
+	gpuStats.cache.framebufferBlits++;
+
 	if (useCopy) {
 		// glBlitFramebuffer can clip, but glCopyImageSubData is more restricted.
 		// In case the src goes outside, we just skip the optimization in that case.
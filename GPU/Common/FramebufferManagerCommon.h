@@ -185,6 +185,8 @@ enum class TempFBO {
 	REINTERPRET,
 	// Used to copy stencil data, means we need a stencil backing.
 	STENCIL,
+	// Intermediate targets for the post shader chain.
+	POSTSHADER,
 };
 
 inline Draw::DataFormat GEFormatToThin3D(int geFormat) {
@@ -301,6 +303,11 @@ class FramebufferManagerCommon {
 	VirtualFramebuffer *GetCurrentRenderVFB() const {
 		return currentRenderVfb_;
 	}
+	// Changes whenever a framebuffer other than the current render target may have been written to.
+	// Results derived from a framebuffer that isn't the current render target stay valid while this is unchanged.
+	u32 FramebufferWriteSeq() const {
+		return framebufWriteSeq_;
+	}
 	// TODO: Break out into some form of FBO manager
 	VirtualFramebuffer *GetVFBAt(u32 addr);
 	VirtualFramebuffer *GetDisplayVFB() {
@@ -335,7 +342,11 @@ class FramebufferManagerCommon {
 	virtual void DeviceLost();
 	virtual void DeviceRestore(Draw::DrawContext *draw);
 
-	Draw::Framebuffer *GetTempFBO(TempFBO reason, u16 w, u16 h);
+	Draw::Framebuffer *GetTempFBO(TempFBO reason, u16 w, u16 h, u8 slot = 0);
+	// Like draw_->CreateFramebuffer(), but reuses a recently freed framebuffer of the same size when possible.
+	Draw::Framebuffer *AllocFramebuffer(int w, int h, bool z_stencil, const char *tag);
+	// Hands a framebuffer back to the pool instead of releasing it. Contents are not preserved.
+	void RecycleFramebuffer(Draw::Framebuffer *fbo, bool z_stencil);
 
 	// Debug features
 	virtual bool GetFramebuffer(u32 fb_address, int fb_stride, GEBufferFormat format, GPUDebugBuffer &buffer, int maxRes);
@@ -349,7 +360,7 @@ class FramebufferManagerCommon {
 	void ReinterpretFramebuffer(VirtualFramebuffer *vfb, GEBufferFormat oldFormat, GEBufferFormat newFormat);
 
 protected:
-	virtual void PackFramebufferSync_(VirtualFramebuffer *vfb, int x, int y, int w, int h);
+	virtual void PackFramebufferSync_(VirtualFramebuffer *vfb, int x, int y, int w, int h, Draw::ReadbackMode mode);
 	void SetViewport2D(int x, int y, int w, int h);
 	Draw::Texture *MakePixelTexture(const u8 *srcPixels, GEBufferFormat srcPixelFormat, int srcStride, int width, int height);
 	void DrawActiveTexture(float x, float y, float w, float h, float destW, float destH, float u0, float v0, float u1, float v1, int uvRotation, int flags);
@@ -360,6 +371,7 @@ class FramebufferManagerCommon {
 
 	void FlushBeforeCopy();
 	virtual void DecimateFBOs();  // keeping it virtual to let D3D do a little extra
+	void UpdateLazyReadback();
 
 	// Used by ReadFramebufferToMemory and later framebuffer block copies
 	virtual void BlitFramebuffer(VirtualFramebuffer *dst, int dstX, int dstY, VirtualFramebuffer *src, int srcX, int srcY, int w, int h, int bpp, const char *tag);
@@ -378,13 +390,17 @@ class FramebufferManagerCommon {
 	void NotifyRenderFramebufferSwitched(VirtualFramebuffer *prevVfb, VirtualFramebuffer *vfb, bool isClearingDepth);
 
 	void BlitFramebufferDepth(VirtualFramebuffer *src, VirtualFramebuffer *dst);
+	void UpdateDynamicResolution();
+	bool CopyFramebufferDepthWithShader(VirtualFramebuffer *src, VirtualFramebuffer *dst);
 
 	void ResizeFramebufFBO(VirtualFramebuffer *vfb, int w, int h, bool force = false, bool skipCopy = false);
 	void ShowScreenResolution();
 
 	bool ShouldDownloadFramebuffer(const VirtualFramebuffer *vfb) const;
 	void DownloadFramebufferOnSwitch(VirtualFramebuffer *vfb);
-	void FindTransferFramebuffers(VirtualFramebuffer *&dstBuffer, VirtualFramebuffer *&srcBuffer, u32 dstBasePtr, int dstStride, int &dstX, int &dstY, u32 srcBasePtr, int srcStride, int &srcX, int &srcY, int &srcWidth, int &srcHeight, int &dstWidth, int &dstHeight, int bpp);
+	// If clipped is set, one of the matches only partially overlaps the transfer and its size was cut down to the framebuffer.
+	// The rest of the transfer should still go through memory.
+	void FindTransferFramebuffers(VirtualFramebuffer *&dstBuffer, VirtualFramebuffer *&srcBuffer, u32 dstBasePtr, int dstStride, int &dstX, int &dstY, u32 srcBasePtr, int srcStride, int &srcX, int &srcY, int &srcWidth, int &srcHeight, int &dstWidth, int &dstHeight, int bpp, bool &clipped);
 	VirtualFramebuffer *FindDownloadTempBuffer(VirtualFramebuffer *vfb);
 	virtual void UpdateDownloadTempBuffer(VirtualFramebuffer *nvfb) {}
 
@@ -422,6 +438,7 @@ class FramebufferManagerCommon {
 	int frameLastFramebufUsed_ = 0;
 
 	VirtualFramebuffer *currentRenderVfb_ = nullptr;
+	u32 framebufWriteSeq_ = 0;
 
 	// The range of PSP memory that may contain FBOs.  So we can skip iterating.
 	u32 framebufRangeEnd_ = 0;
@@ -437,6 +454,10 @@ class FramebufferManagerCommon {
 
 	bool gameUsesSequentialCopies_ = false;
 
+	// Lazy readback: VRAM of framebuffers rendered since this flip is protected in the next BeginFrame.
+	bool lazyReadbackActive_ = false;
+	int lazyReadbackFlip_ = 0;
+
 	// Sampled in BeginFrame/UpdateSize for safety.
 	float renderWidth_ = 0.0f;
 	float renderHeight_ = 0.0f;
@@ -456,10 +477,23 @@ class FramebufferManagerCommon {
 
 	std::vector<Draw::Framebuffer *> fbosToDelete_;
 
+	// Freed framebuffers, kept for a little while so games that recreate render targets every scene
+	// (or resize them back and forth) don't keep going back to the driver for new ones.
+	struct PooledFBO {
+		Draw::Framebuffer *fbo;
+		bool z_stencil;
+		int frame_freed;
+	};
+	std::vector<PooledFBO> fboPool_;
+	void DecimateFBOPool();
+	void ClearFBOPool();
+
 	// Aggressively delete unused FBOs to save gpu memory.
 	enum {
 		FBO_OLD_AGE = 5,
 		FBO_OLD_USAGE_FLAG = 15,
+		FBO_POOL_AGE = 30,
+		FBO_POOL_MAX = 12,
 	};
 
 	// Thin3D stuff for reinterpreting image data between the various 16-bit formats.
@@ -470,11 +504,27 @@ class FramebufferManagerCommon {
 	Draw::SamplerState *reinterpretSampler_ = nullptr;
 	Draw::Buffer *reinterpretVBuf_ = nullptr;
 
+	// Dynamic resolution (bDynamicResolution): the render scale is stepped down while the game runs slow,
+	// and probed back up after a while at full speed, waiting longer each time a probe fails.
+	int dynamicScale_ = 0;  // 0 = not limited.
+	double dynamicResNextCheck_ = 0.0;
+	double dynamicResSlowSince_ = 0.0;
+	double dynamicResFastSince_ = 0.0;
+	double dynamicResLastRaise_ = 0.0;
+	double dynamicResRaiseDelay_ = 10.0;
+
+	// Depth copies between framebuffers that can't be done with a copy or blit, like between render scales.
+	Draw::Pipeline *depthCopyPipeline_ = nullptr;
+	Draw::SamplerState *depthCopySampler_ = nullptr;
+	bool depthCopyFailed_ = false;
+
 	// Common implementation of stencil buffer upload. Also not 100% optimal, but not perforamnce
 	// critical either.
 	Draw::Pipeline *stencilUploadPipeline_ = nullptr;
 	Draw::ShaderModule *stencilUploadVs_ = nullptr;
 	Draw::ShaderModule *stencilUploadFs_ = nullptr;
+	Draw::Pipeline *stencilUploadExportPipeline_ = nullptr;
+	Draw::ShaderModule *stencilUploadExportFs_ = nullptr;
 	Draw::SamplerState *stencilUploadSampler_ = nullptr;
 
 	// Draw2D pipelines
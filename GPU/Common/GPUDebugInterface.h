@@ -164,6 +164,11 @@ struct GPUDebugBuffer {
 
 	u32 PixelSize() const;
 
+	// False if the data points into memory owned by someone else, like VRAM.
+	bool IsAllocated() const {
+		return alloc_;
+	}
+
 private:
 	bool alloc_ = false;
 	u8 *data_ = nullptr;
@@ -1357,6 +1357,72 @@ void ConvertBlendState(GenericBlendState &blendState, bool allowFramebufferRead,
 	blendState.setEquation(colorEq, alphaEq);
 }
 
+// Everything ConvertMaskState and ConvertBlendState read. Games tend to alternate between a handful
+// of blend setups, so a few entries are enough to skip most conversions.
+struct BlendConversionKey {
+	u32 blend;
+	u32 blendfixa;
+	u32 blendfixb;
+	u32 pmskc;
+	u32 pmska;
+	u32 stenciltest;
+	u32 stencilop;
+	u32 featureFlags;
+	u32 bits;
+
+	bool operator ==(const BlendConversionKey &other) const {
+		return memcmp(this, &other, sizeof(*this)) == 0;
+	}
+};
+
+struct BlendConversionEntry {
+	BlendConversionKey key;
+	GenericMaskState maskState;
+	GenericBlendState blendState;
+	bool valid;
+};
+
+static BlendConversionEntry blendConversionCache[8];
+static int blendConversionNext;
+
+void ConvertMaskAndBlendState(GenericMaskState &maskState, GenericBlendState &blendState, bool allowFramebufferRead) {
+	BlendConversionKey key;
+	key.blend = gstate.blend;
+	key.blendfixa = gstate.blendfixa;
+	key.blendfixb = gstate.blendfixb;
+	key.pmskc = gstate.pmskc;
+	key.pmska = gstate.pmska;
+	key.stenciltest = gstate.stenciltest;
+	key.stencilop = gstate.stencilop;
+	key.featureFlags = gstate_c.featureFlags;
+	key.bits = (gstate.alphaBlendEnable & 1) | ((gstate.clearmode & 1) << 1) | ((gstate.stencilTestEnable & 1) << 2);
+	key.bits |= ((gstate.logicOpEnable & 1) << 3) | ((gstate.lop & 0xF) << 4);
+	key.bits |= (gstate_c.blueToAlpha ? 1 : 0) << 8;
+	key.bits |= (allowFramebufferRead ? 1 : 0) << 9;
+	key.bits |= (PSP_CoreParameter().compat.flags().ShaderColorBitmask ? 1 : 0) << 10;
+	key.bits |= (g_Config.iRenderingMode == FB_NON_BUFFERED_MODE ? 1 : 0) << 11;
+	key.bits |= ((u32)gstate_c.renderMode & 0xF) << 12;
+	key.bits |= ((u32)gstate_c.framebufFormat & 0xF) << 16;
+
+	for (const BlendConversionEntry &entry : blendConversionCache) {
+		if (entry.valid && entry.key == key) {
+			maskState = entry.maskState;
+			blendState = entry.blendState;
+			return;
+		}
+	}
+
+	ConvertMaskState(maskState, allowFramebufferRead);
+	ConvertBlendState(blendState, allowFramebufferRead, maskState.applyFramebufferRead);
+
+	BlendConversionEntry &entry = blendConversionCache[blendConversionNext];
+	blendConversionNext = (blendConversionNext + 1) % ARRAY_SIZE(blendConversionCache);
+	entry.key = key;
+	entry.maskState = maskState;
+	entry.blendState = blendState;
+	entry.valid = true;
+}
+
 static void ConvertStencilFunc5551(GenericStencilFuncState &state) {
 	// Flaws:
 	// - INVERT should convert 1, 5, 0xFF to 0.  Currently it won't always.
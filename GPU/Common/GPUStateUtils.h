@@ -178,6 +178,8 @@ struct GenericMaskState {
 };
 
 void ConvertMaskState(GenericMaskState &maskState, bool allowFramebufferRead);
+// ConvertMaskState followed by ConvertBlendState, remembering the last few results keyed on the state they read.
+void ConvertMaskAndBlendState(GenericMaskState &maskState, GenericBlendState &blendState, bool allowFramebufferRead);
 bool IsColorWriteMaskComplex(bool allowFramebufferRead);
 
 struct GenericStencilFuncState {
@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstring>
 
 #include "ppsspp_config.h"
@@ -62,12 +63,158 @@ void IndexGenerator::AddPrim(int prim, int vertexCount, bool clockwise) {
 	}
 }
 
+// Patterns for GeneratePattern(). Each covers 24 indices, which is both a whole number of
+// triangles and lines and three SIMD registers. The increments are added per repetition.
+alignas(16) static const u16 pattern_sequential[24] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
+};
+
+alignas(16) static const u16 pattern_list_counter_clockwise[24] = {
+	0, 2, 1, 3, 5, 4, 6, 8, 7, 9, 11, 10,
+	12, 14, 13, 15, 17, 16, 18, 20, 19, 21, 23, 22,
+};
+
+alignas(16) static const u16 increment_24[24] = {
+	24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24,
+	24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24,
+};
+
+alignas(16) static const u16 pattern_line_strip[24] = {
+	0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+	6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12,
+};
+
+alignas(16) static const u16 increment_12[24] = {
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+};
+
+alignas(16) static const u16 pattern_fan_clockwise[24] = {
+	0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5,
+	0, 5, 6, 0, 6, 7, 0, 7, 8, 0, 8, 9,
+};
+
+alignas(16) static const u16 pattern_fan_counter_clockwise[24] = {
+	0, 2, 1, 0, 3, 2, 0, 4, 3, 0, 5, 4,
+	0, 6, 5, 0, 7, 6, 0, 8, 7, 0, 9, 8,
+};
+
+// The center vertex of a fan stays put.
+alignas(16) static const u16 increment_fan[24] = {
+	0, 8, 8, 0, 8, 8, 0, 8, 8, 0, 8, 8,
+	0, 8, 8, 0, 8, 8, 0, 8, 8, 0, 8, 8,
+};
+
+// Writes numInds indices of base + pattern, adding increment after every 24.
+// Like AddStrip, the SIMD paths may write up to 23 indices past the end. That's fine since we
+// append to a buffer, and whatever comes next overwrites them.
+static void GeneratePattern(u16 *dst, int numInds, int base, const u16 *pattern, const u16 *increment) {
+	if (numInds <= 0)
+		return;
+	int numChunks = (numInds + 23) / 24;
+#ifdef _M_SSE
+	__m128i ibase8 = _mm_set1_epi16(base);
+	const __m128i *patterns = (const __m128i *)pattern;
+	const __m128i *increments = (const __m128i *)increment;
+	__m128i values0 = _mm_add_epi16(ibase8, _mm_load_si128(patterns));
+	__m128i values1 = _mm_add_epi16(ibase8, _mm_load_si128(patterns + 1));
+	__m128i values2 = _mm_add_epi16(ibase8, _mm_load_si128(patterns + 2));
+	__m128i inc0 = _mm_load_si128(increments);
+	__m128i inc1 = _mm_load_si128(increments + 1);
+	__m128i inc2 = _mm_load_si128(increments + 2);
+	__m128i *out = (__m128i *)dst;
+	for (int i = 0; i < numChunks; i++) {
+		_mm_storeu_si128(out, values0);
+		_mm_storeu_si128(out + 1, values1);
+		_mm_storeu_si128(out + 2, values2);
+		values0 = _mm_add_epi16(values0, inc0);
+		values1 = _mm_add_epi16(values1, inc1);
+		values2 = _mm_add_epi16(values2, inc2);
+		out += 3;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint16x8_t ibase8 = vdupq_n_u16(base);
+	uint16x8_t values0 = vaddq_u16(ibase8, vld1q_u16(pattern));
+	uint16x8_t values1 = vaddq_u16(ibase8, vld1q_u16(pattern + 8));
+	uint16x8_t values2 = vaddq_u16(ibase8, vld1q_u16(pattern + 16));
+	uint16x8_t inc0 = vld1q_u16(increment);
+	uint16x8_t inc1 = vld1q_u16(increment + 8);
+	uint16x8_t inc2 = vld1q_u16(increment + 16);
+	for (int i = 0; i < numChunks; i++) {
+		vst1q_u16(dst, values0);
+		vst1q_u16(dst + 8, values1);
+		vst1q_u16(dst + 16, values2);
+		values0 = vaddq_u16(values0, inc0);
+		values1 = vaddq_u16(values1, inc1);
+		values2 = vaddq_u16(values2, inc2);
+		dst += 3 * 8;
+	}
+#else
+	for (int i = 0; i < numChunks; i++) {
+		int count = std::min(numInds - i * 24, 24);
+		for (int j = 0; j < count; j++)
+			*dst++ = base + pattern[j] + i * increment[j];
+	}
+#endif
+}
+
+// Plain offset translation of already indexed input, used by most of the Translate* functions.
+template <class ITypeLE>
+static inline void TranslateIndices(u16 *outInds, const ITypeLE *inds, int numInds, int indexOffset) {
+	for (int i = 0; i < numInds; i++)
+		outInds[i] = indexOffset + inds[i];
+}
+
+template <>
+inline void TranslateIndices<u8>(u16 *outInds, const u8 *inds, int numInds, int indexOffset) {
+	int i = 0;
+#ifdef _M_SSE
+	__m128i offset = _mm_set1_epi16(indexOffset);
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= numInds; i += 16) {
+		__m128i in = _mm_loadu_si128((const __m128i *)(inds + i));
+		_mm_storeu_si128((__m128i *)(outInds + i), _mm_add_epi16(_mm_unpacklo_epi8(in, zero), offset));
+		_mm_storeu_si128((__m128i *)(outInds + i + 8), _mm_add_epi16(_mm_unpackhi_epi8(in, zero), offset));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint16x8_t offset = vdupq_n_u16(indexOffset);
+	for (; i + 16 <= numInds; i += 16) {
+		uint8x16_t in = vld1q_u8(inds + i);
+		vst1q_u16(outInds + i, vaddq_u16(vmovl_u8(vget_low_u8(in)), offset));
+		vst1q_u16(outInds + i + 8, vaddq_u16(vmovl_u8(vget_high_u8(in)), offset));
+	}
+#endif
+	for (; i < numInds; i++)
+		outInds[i] = indexOffset + inds[i];
+}
+
+#if COMMON_LITTLE_ENDIAN
+template <>
+inline void TranslateIndices<u16_le>(u16 *outInds, const u16_le *inds, int numInds, int indexOffset) {
+	// u16_le is just a u16 here.
+	const u16 *in = (const u16 *)inds;
+	int i = 0;
+#ifdef _M_SSE
+	__m128i offset = _mm_set1_epi16(indexOffset);
+	for (; i + 8 <= numInds; i += 8) {
+		__m128i values = _mm_loadu_si128((const __m128i *)(in + i));
+		_mm_storeu_si128((__m128i *)(outInds + i), _mm_add_epi16(values, offset));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint16x8_t offset = vdupq_n_u16(indexOffset);
+	for (; i + 8 <= numInds; i += 8) {
+		vst1q_u16(outInds + i, vaddq_u16(vld1q_u16(in + i), offset));
+	}
+#endif
+	for (; i < numInds; i++)
+		outInds[i] = indexOffset + in[i];
+}
+#endif
+
 void IndexGenerator::AddPoints(int numVerts) {
-	u16 *outInds = inds_;
-	const int startIndex = index_;
-	for (int i = 0; i < numVerts; i++)
-		*outInds++ = startIndex + i;
-	inds_ = outInds;
+	GeneratePattern(inds_, numVerts, index_, pattern_sequential, increment_24);
+	inds_ += numVerts;
 	// ignore overflow verts
 	index_ += numVerts;
 	count_ += numVerts;
@@ -76,16 +223,10 @@ void IndexGenerator::AddPoints(int numVerts) {
 }
 
 void IndexGenerator::AddList(int numVerts, bool clockwise) {
-	u16 *outInds = inds_;
-	const int startIndex = index_;
-	const int v1 = clockwise ? 1 : 2;
-	const int v2 = clockwise ? 2 : 1;
-	for (int i = 0; i < numVerts; i += 3) {
-		*outInds++ = startIndex + i;
-		*outInds++ = startIndex + i + v1;
-		*outInds++ = startIndex + i + v2;
-	}
-	inds_ = outInds;
+	// Whole triangles only, like the loop this replaced (which rounded up.)
+	const int numInds = (numVerts + 2) / 3 * 3;
+	GeneratePattern(inds_, numInds, index_, clockwise ? pattern_sequential : pattern_list_counter_clockwise, increment_24);
+	inds_ += numInds;
 	// ignore overflow verts
 	index_ += numVerts;
 	count_ += numVerts;
@@ -206,18 +347,12 @@ void IndexGenerator::AddStrip(int numVerts, bool clockwise) {
 
 void IndexGenerator::AddFan(int numVerts, bool clockwise) {
 	const int numTris = numVerts - 2;
-	u16 *outInds = inds_;
-	const int startIndex = index_;
-	const int v1 = clockwise ? 1 : 2;
-	const int v2 = clockwise ? 2 : 1;
-	for (int i = 0; i < numTris; i++) {
-		*outInds++ = startIndex;
-		*outInds++ = startIndex + i + v1;
-		*outInds++ = startIndex + i + v2;
+	if (numTris > 0) {
+		GeneratePattern(inds_, numTris * 3, index_, clockwise ? pattern_fan_clockwise : pattern_fan_counter_clockwise, increment_fan);
+		inds_ += numTris * 3;
+		count_ += numTris * 3;
 	}
-	inds_ = outInds;
 	index_ += numVerts;
-	count_ += numTris * 3;
 	prim_ = GE_PRIM_TRIANGLES;
 	seenPrims_ |= 1 << GE_PRIM_TRIANGLE_FAN;
 	if (!clockwise) {
@@ -228,13 +363,10 @@ void IndexGenerator::AddFan(int numVerts, bool clockwise) {
 
 //Lines
 void IndexGenerator::AddLineList(int numVerts) {
-	u16 *outInds = inds_;
-	const int startIndex = index_;
-	for (int i = 0; i < numVerts; i += 2) {
-		*outInds++ = startIndex + i;
-		*outInds++ = startIndex + i + 1;
-	}
-	inds_ = outInds;
+	// Whole lines only, like the loop this replaced (which rounded up.)
+	const int numInds = (numVerts + 1) & ~1;
+	GeneratePattern(inds_, numInds, index_, pattern_sequential, increment_24);
+	inds_ += numInds;
 	index_ += numVerts;
 	count_ += numVerts;
 	prim_ = GE_PRIM_LINES;
@@ -243,29 +375,21 @@ void IndexGenerator::AddLineList(int numVerts) {
 
 void IndexGenerator::AddLineStrip(int numVerts) {
 	const int numLines = numVerts - 1;
-	u16 *outInds = inds_;
-	const int startIndex = index_;
-	for (int i = 0; i < numLines; i++) {
-		*outInds++ = startIndex + i;
-		*outInds++ = startIndex + i + 1;
+	if (numLines > 0) {
+		GeneratePattern(inds_, numLines * 2, index_, pattern_line_strip, increment_12);
+		inds_ += numLines * 2;
+		count_ += numLines * 2;
 	}
-	inds_ = outInds;
 	index_ += numVerts;
-	count_ += numLines * 2;
 	prim_ = GE_PRIM_LINES;
 	seenPrims_ |= 1 << GE_PRIM_LINE_STRIP;
 }
 
 void IndexGenerator::AddRectangles(int numVerts) {
-	u16 *outInds = inds_;
-	const int startIndex = index_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
 	numVerts = numVerts & ~1;
-	for (int i = 0; i < numVerts; i += 2) {
-		*outInds++ = startIndex + i;
-		*outInds++ = startIndex + i + 1;
-	}
-	inds_ = outInds;
+	GeneratePattern(inds_, numVerts, index_, pattern_sequential, increment_24);
+	inds_ += numVerts;
 	index_ += numVerts;
 	count_ += numVerts;
 	prim_ = GE_PRIM_RECTANGLES;
@@ -275,10 +399,8 @@ void IndexGenerator::AddRectangles(int numVerts) {
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
-	for (int i = 0; i < numInds; i++)
-		*outInds++ = indexOffset + inds[i];
-	inds_ = outInds;
+	TranslateIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_POINTS;
 	seenPrims_ |= (1 << GE_PRIM_POINTS) | flag;
@@ -287,13 +409,9 @@ void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int index
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslateLineList(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i + 1];
-	}
-	inds_ = outInds;
+	TranslateIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_LINES;
 	seenPrims_ |= (1 << GE_PRIM_LINES) | flag;
@@ -323,6 +441,11 @@ void IndexGenerator::TranslateList(int numInds, const ITypeLE *inds, int indexOf
 		memcpy(inds_, inds, numInds * sizeof(ITypeLE));
 		inds_ += numInds;
 		count_ += numInds;
+	} else if (clockwise) {
+		numInds = (numInds / 3) * 3;  // Round to whole triangles
+		TranslateIndices(inds_, inds, numInds, indexOffset);
+		inds_ += numInds;
+		count_ += numInds;
 	} else {
 		u16 *outInds = inds_;
 		int numTris = numInds / 3;  // Round to whole triangles
@@ -381,14 +504,10 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 template <class ITypeLE, int flag>
 inline void IndexGenerator::TranslateRectangles(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i+1];
-	}
-	inds_ = outInds;
+	TranslateIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_RECTANGLES;
 	seenPrims_ |= (1 << GE_PRIM_RECTANGLES) | flag;
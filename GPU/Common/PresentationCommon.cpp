@@ -23,7 +23,10 @@
 
 #include "Common/System/Display.h"
 #include "Common/System/System.h"
+#include "Common/File/FileUtil.h"
 #include "Common/File/VFS/VFS.h"
+#include "Common/StringUtils.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Common/Log.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
@@ -34,6 +37,10 @@
 #include "GPU/Common/PostShader.h"
 #include "GPU/Common/PresentationCommon.h"
 #include "Common/GPU/ShaderTranslation.h"
+#include "ext/xxhash.h"
+
+// Bump when TranslateShader's output changes, to ignore old translations on disk.
+static const int POSTSHADER_CACHE_VERSION = 1;
 
 struct Vertex {
 	float x, y, z;
@@ -226,6 +233,8 @@ bool PresentationCommon::UpdatePostShader() {
 	if (shaderInfo.empty())
 		return false;
 
+	PrepareTranslatedPostShaders(shaderInfo);
+
 	bool usePreviousFrame = false;
 	bool usePreviousAtOutputResolution = false;
 	for (size_t i = 0; i < shaderInfo.size(); ++i) {
@@ -303,9 +312,16 @@ bool PresentationCommon::BuildPostShader(const ShaderInfo *shaderInfo, const Sha
 		int nextWidth = renderWidth_;
 		int nextHeight = renderHeight_;
 
-		// When chaining, we use the previous resolution as a base, rather than the render resolution.
-		if (!postShaderFramebuffers_.empty())
-			draw_->GetFramebufferDimensions(postShaderFramebuffers_.back(), &nextWidth, &nextHeight);
+		if (!postShaderTargets_.empty()) {
+			// When chaining, we use the previous resolution as a base, rather than the render resolution.
+			nextWidth = postShaderTargets_.back().w;
+			nextHeight = postShaderTargets_.back().h;
+		} else if (g_Config.bPostShaderNativeResolution) {
+			// Run the chain at PSP resolution, the final blit (or last pass) does the upscale.
+			const bool isPortrait = g_Config.IsPortrait();
+			nextWidth = std::min(nextWidth, isPortrait ? 272 : 480);
+			nextHeight = std::min(nextHeight, isPortrait ? 480 : 272);
+		}
 
 		if (next && next->isUpscalingFilter) {
 			// Force 1x for this shader, so the next can upscale.
@@ -337,28 +353,52 @@ bool PresentationCommon::BuildPostShader(const ShaderInfo *shaderInfo, const Sha
 }
 
 bool PresentationCommon::AllocateFramebuffer(int w, int h) {
-	using namespace Draw;
+	// Each pass reads the previous one's output, so only that one must not be the same target.
+	int slot = 0;
+	if (!postShaderTargets_.empty()) {
+		const PostShaderTarget &last = postShaderTargets_.back();
+		if (last.w == w && last.h == h)
+			slot = last.slot ^ 1;
+	}
 
-	// First, let's try to find a framebuffer of the right size that is NOT the most recent.
-	Framebuffer *last = postShaderFramebuffers_.empty() ? nullptr : postShaderFramebuffers_.back();
-	for (const auto &prev : postShaderFBOUsage_) {
-		if (prev.w == w && prev.h == h && prev.fbo != last) {
-			// Great, this one's perfect.  Ref it for when we release.
-			prev.fbo->AddRef();
-			postShaderFramebuffers_.push_back(prev.fbo);
-			return true;
-		}
+	// Create it now, so we fail (and fall back to no post shader) early rather than during present.
+	if (!GetTempFramebuffer(w, h, slot))
+		return false;
+
+	postShaderTargets_.push_back({ w, h, slot });
+	return true;
+}
+
+Draw::Framebuffer *PresentationCommon::GetTempFramebuffer(int w, int h, int slot) {
+	if (tempFramebufferFunc_)
+		return tempFramebufferFunc_(w, h, slot);
+
+	u64 key = ((u64)slot << 32) | ((u32)w << 16) | h;
+	auto it = localTempFramebuffers_.find(key);
+	if (it != localTempFramebuffers_.end()) {
+		it->second.lastFrame = presentFrame_;
+		return it->second.fbo;
 	}
 
 	// No depth/stencil for post processing
 	Draw::Framebuffer *fbo = draw_->CreateFramebuffer({ w, h, 1, 1, false, "presentation" });
-	if (!fbo) {
-		return false;
-	}
+	if (!fbo)
+		return nullptr;
+	localTempFramebuffers_[key] = { fbo, presentFrame_ };
+	return fbo;
+}
 
-	postShaderFBOUsage_.push_back({ fbo, w, h });
-	postShaderFramebuffers_.push_back(fbo);
-	return true;
+void PresentationCommon::DecimateTempFramebuffers() {
+	// Keep them a little while, resizing and changing settings often come in bursts.
+	static const int TEMP_FRAMEBUFFER_OLD_AGE = 60;
+	for (auto it = localTempFramebuffers_.begin(); it != localTempFramebuffers_.end(); ) {
+		if (presentFrame_ - it->second.lastFrame > TEMP_FRAMEBUFFER_OLD_AGE) {
+			it->second.fbo->Release();
+			it = localTempFramebuffers_.erase(it);
+		} else {
+			++it;
+		}
+	}
 }
 
 void PresentationCommon::ShowPostShaderError(const std::string &errorString) {
@@ -487,6 +527,11 @@ void PresentationCommon::DestroyDeviceObjects() {
 
 	restorePostShader_ = usePostShader_;
 	DestroyPostShader();
+
+	for (auto &it : localTempFramebuffers_) {
+		it.second.fbo->Release();
+	}
+	localTempFramebuffers_.clear();
 }
 
 void PresentationCommon::DestroyPostShader() {
@@ -494,17 +539,72 @@ void PresentationCommon::DestroyPostShader() {
 
 	DoReleaseVector(postShaderModules_);
 	DoReleaseVector(postShaderPipelines_);
-	DoReleaseVector(postShaderFramebuffers_);
 	DoReleaseVector(previousFramebuffers_);
+	// The intermediates themselves stay pooled, a rebuilt chain will likely want the same sizes.
+	postShaderTargets_.clear();
 	postShaderInfo_.clear();
-	postShaderFBOUsage_.clear();
+}
+
+bool PresentationCommon::TranslatePostShaderCached(ShaderStage stage, ShaderLanguage lang, const std::string &src, std::string *translated, std::string *errorString) {
+	const ShaderLanguageDesc &desc = draw_->GetShaderLanguageDesc();
+	uint64_t hash = XXH3_64bits(src.data(), src.size());
+	std::string key = StringFromFormat("%016llx_%d_%d_%d_%d_v%d", (unsigned long long)hash, (int)lang, (int)lang_, (int)stage, desc.glslVersionNumber, POSTSHADER_CACHE_VERSION);
+
+	{
+		std::lock_guard<std::mutex> guard(translatedPostShadersLock_);
+		auto it = translatedPostShaders_.find(key);
+		if (it != translatedPostShaders_.end()) {
+			*translated = it->second;
+			return true;
+		}
+	}
+
+	Path cacheDir = GetSysDirectory(DIRECTORY_APP_CACHE) / "postshaders";
+	Path cacheFile = cacheDir / (key + ".txt");
+	if (!File::ReadFileToString(true, cacheFile, *translated) || translated->empty()) {
+		if (!TranslateShader(translated, lang_, desc, nullptr, src, lang, stage, errorString))
+			return false;
+		File::CreateFullPath(cacheDir);
+		File::WriteStringToFile(true, *translated, cacheFile);
+	}
+
+	std::lock_guard<std::mutex> guard(translatedPostShadersLock_);
+	translatedPostShaders_[key] = *translated;
+	return true;
+}
+
+// Translates all the shaders of a chain up front, in parallel, so BuildPostShader finds them ready.
+void PresentationCommon::PrepareTranslatedPostShaders(const std::vector<const ShaderInfo *> &shaderInfo) {
+	if (lang_ == GLSL_1xx)
+		return;
+
+	struct Job {
+		ShaderStage stage;
+		std::string src;
+	};
+	std::vector<Job> jobs;
+	for (const ShaderInfo *info : shaderInfo) {
+		jobs.push_back({ ShaderStage::Vertex, ReadShaderSrc(info->vertexShaderFile) });
+		jobs.push_back({ ShaderStage::Fragment, ReadShaderSrc(info->fragmentShaderFile) });
+	}
+
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		for (int i = l; i < h; ++i) {
+			if (jobs[i].src.empty())
+				continue;
+			// Errors are reported again when the chain is built.
+			std::string translated;
+			std::string errorString;
+			TranslatePostShaderCached(jobs[i].stage, GLSL_1xx, jobs[i].src, &translated, &errorString);
+		}
+	}, 0, (int)jobs.size(), 1);
 }
 
 Draw::ShaderModule *PresentationCommon::CompileShaderModule(ShaderStage stage, ShaderLanguage lang, const std::string &src, std::string *errorString) {
 	std::string translated = src;
 	if (lang != lang_) {
 		// Gonna have to upconvert the shader.
-		if (!TranslateShader(&translated, lang_, draw_->GetShaderLanguageDesc(), nullptr, src, lang, stage, errorString)) {
+		if (!TranslatePostShaderCached(stage, lang, src, &translated, errorString)) {
 			ERROR_LOG(FRAMEBUF, "Failed to translate post-shader. Error string: '%s'\nSource code:\n%s\n", errorString->c_str(), src.c_str());
 			return nullptr;
 		}
@@ -557,9 +657,25 @@ void PresentationCommon::CopyToOutput(OutputFlags flags, int uvRotation, float u
 	// GLES can have the shader fail later, shader->failed / shader->error.
 	// This should auto-disable usePostShader_ and call ShowPostShaderError().
 
+	presentFrame_++;
+	DecimateTempFramebuffers();
+
 	bool useNearest = flags & OutputFlags::NEAREST;
-	const bool usePostShader = usePostShader_ && !(flags & OutputFlags::RB_SWIZZLE);
-	const bool isFinalAtOutputResolution = usePostShader && postShaderFramebuffers_.size() < postShaderPipelines_.size();
+	bool usePostShader = usePostShader_ && !(flags & OutputFlags::RB_SWIZZLE);
+
+	Draw::Framebuffer *postShaderFramebuffers[16];
+	size_t postShaderTargetCount = usePostShader ? postShaderTargets_.size() : 0;
+	if (postShaderTargetCount > ARRAY_SIZE(postShaderFramebuffers))
+		usePostShader = false;
+	for (size_t i = 0; usePostShader && i < postShaderTargetCount; ++i) {
+		const PostShaderTarget &target = postShaderTargets_[i];
+		postShaderFramebuffers[i] = GetTempFramebuffer(target.w, target.h, target.slot);
+		// Could've been lost to memory pressure since the chain was built, just skip the chain this frame.
+		if (!postShaderFramebuffers[i])
+			usePostShader = false;
+	}
+
+	const bool isFinalAtOutputResolution = usePostShader && postShaderTargets_.size() < postShaderPipelines_.size();
 	Draw::Framebuffer *postShaderOutput = nullptr;
 	int lastWidth = srcWidth_;
 	int lastHeight = srcHeight_;
@@ -704,11 +820,11 @@ void PresentationCommon::CopyToOutput(OutputFlags flags, int uvRotation, float u
 		verts[7] = {  1, -1, 0, 1, post_v1, 0xFFFFFFFF }; // TR
 		draw_->UpdateBuffer(vdata_, (const uint8_t *)verts, 0, sizeof(verts), Draw::UPDATE_DISCARD);
 
-		for (size_t i = 0; i < postShaderFramebuffers_.size(); ++i) {
+		for (size_t i = 0; i < postShaderTargetCount; ++i) {
 			Draw::Pipeline *postShaderPipeline = postShaderPipelines_[i];
 			const ShaderInfo *shaderInfo = &postShaderInfo_[i];
-			Draw::Framebuffer *postShaderFramebuffer = postShaderFramebuffers_[i];
-			if (!isFinalAtOutputResolution && i == postShaderFramebuffers_.size() - 1 && !previousFramebuffers_.empty()) {
+			Draw::Framebuffer *postShaderFramebuffer = postShaderFramebuffers[i];
+			if (!isFinalAtOutputResolution && i == postShaderTargetCount - 1 && !previousFramebuffers_.empty()) {
 				// This is the last pass and we're going direct to the backbuffer after this.
 				// Redirect output to a separate framebuffer to keep the previous frame.
 				previousIndex_++;
@@ -828,6 +944,8 @@ void PresentationCommon::CalculateRenderResolution(int *width, int *height, int
 		if (firstSSAAFilterLevel >= 2)
 			zoom *= firstSSAAFilterLevel;
 	}
+	if (maxRenderScale_ > 0 && zoom > maxRenderScale_)
+		zoom = maxRenderScale_;
 	if (zoom <= 1 || firstIsUpscalingFilter)
 		zoom = 1;
 
@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
 #include "Common/Common.h"
 #include "Common/GPU/Shader.h"
 
@@ -94,6 +98,13 @@ class PresentationCommon {
 
 	bool UpdatePostShader();
 
+	// Post shader intermediates are taken from here when set, to share the owner's pool of temporary
+	// framebuffers. Otherwise, PresentationCommon keeps its own. Slots tell apart targets of the same size.
+	typedef std::function<Draw::Framebuffer *(int w, int h, int slot)> TempFramebufferFunc;
+	void SetTempFramebufferFunc(TempFramebufferFunc func) {
+		tempFramebufferFunc_ = func;
+	}
+
 	void DeviceLost();
 	void DeviceRestore(Draw::DrawContext *draw);
 
@@ -103,6 +114,10 @@ class PresentationCommon {
 	void CopyToOutput(OutputFlags flags, int uvRotation, float u0, float v0, float u1, float v1);
 
 	void CalculateRenderResolution(int *width, int *height, int *scaleFactor, bool *upscaling, bool *ssaa);
+	// Caps the render scale CalculateRenderResolution picks, 0 for no limit.
+	void SetMaxRenderScale(int scale) {
+		maxRenderScale_ = scale;
+	}
 
 protected:
 	void CreateDeviceObjects();
@@ -112,9 +127,13 @@ class PresentationCommon {
 	void ShowPostShaderError(const std::string &errorString);
 
 	Draw::ShaderModule *CompileShaderModule(ShaderStage stage, ShaderLanguage lang, const std::string &src, std::string *errorString);
+	bool TranslatePostShaderCached(ShaderStage stage, ShaderLanguage lang, const std::string &src, std::string *translated, std::string *errorString);
+	void PrepareTranslatedPostShaders(const std::vector<const ShaderInfo *> &shaderInfo);
 	Draw::Pipeline *CreatePipeline(std::vector<Draw::ShaderModule *> shaders, bool postShader, const UniformBufferDesc *uniformDesc);
 	bool BuildPostShader(const ShaderInfo *shaderInfo, const ShaderInfo *next);
 	bool AllocateFramebuffer(int w, int h);
+	Draw::Framebuffer *GetTempFramebuffer(int w, int h, int slot);
+	void DecimateTempFramebuffers();
 
 	void BindSource(int binding);
 
@@ -130,8 +149,17 @@ class PresentationCommon {
 	Draw::Buffer *idata_ = nullptr;
 
 	std::vector<Draw::ShaderModule *> postShaderModules_;
+	// Post shaders translated this session, also kept on disk. Keyed by source hash and target.
+	std::unordered_map<std::string, std::string> translatedPostShaders_;
+	std::mutex translatedPostShadersLock_;
 	std::vector<Draw::Pipeline *> postShaderPipelines_;
-	std::vector<Draw::Framebuffer *> postShaderFramebuffers_;
+	struct PostShaderTarget {
+		int w;
+		int h;
+		int slot;
+	};
+	// Only the sizes are kept, the framebuffers are looked up in the pool each frame.
+	std::vector<PostShaderTarget> postShaderTargets_;
 	std::vector<ShaderInfo> postShaderInfo_;
 	std::vector<Draw::Framebuffer *> previousFramebuffers_;
 	int previousIndex_ = 0;
@@ -146,16 +174,18 @@ class PresentationCommon {
 	int pixelWidth_ = 0;
 	int pixelHeight_ = 0;
 	int renderWidth_ = 0;
+	int maxRenderScale_ = 0;
 	int renderHeight_ = 0;
 
 	bool usePostShader_ = false;
 	bool restorePostShader_ = false;
 	ShaderLanguage lang_;
 
-	struct PrevFBO {
+	TempFramebufferFunc tempFramebufferFunc_;
+	struct LocalTempFramebuffer {
 		Draw::Framebuffer *fbo;
-		int w;
-		int h;
+		int lastFrame;
 	};
-	std::vector<PrevFBO> postShaderFBOUsage_;
+	std::unordered_map<u64, LocalTempFramebuffer> localTempFramebuffers_;
+	int presentFrame_ = 0;
 };
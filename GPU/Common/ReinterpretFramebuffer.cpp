@@ -69,6 +69,28 @@ bool GenerateReinterpretFragmentShader(char *buffer, GEBufferFormat from, GEBuff
 	return true;
 }
 
+// Copies depth from the bound texture, so depth can be moved between framebuffers of different sizes and scales.
+bool GenerateDepthCopyFragmentShader(char *buffer, const ShaderLanguageDesc &lang) {
+	if (!lang.bitwiseOps || lang.shaderLanguage == HLSL_D3D9) {
+		return false;
+	}
+
+	ShaderWriter writer(buffer, lang, ShaderStage::Fragment, nullptr, 0);
+
+	writer.HighPrecisionFloat();
+
+	writer.DeclareSampler2D("samp", 0);
+	writer.DeclareTexture2D("tex", 0);
+
+	writer.BeginFSMain(Slice<UniformDef>::empty(), varyings, FSFLAG_WRITEDEPTH);
+
+	writer.C("  gl_FragDepth = ").SampleTexture2D("tex", "samp", "v_texcoord.xy").C(".x;\n");
+	writer.C("  vec4 outColor = vec4(0.0, 0.0, 0.0, 0.0);\n");
+
+	writer.EndFSMain("outColor", FSFLAG_WRITEDEPTH);
+	return true;
+}
+
 bool GenerateReinterpretVertexShader(char *buffer, const ShaderLanguageDesc &lang) {
 	if (!lang.bitwiseOps) {
 		return false;
@@ -6,6 +6,9 @@
 
 bool GenerateReinterpretFragmentShader(char *buffer, GEBufferFormat from, GEBufferFormat to, const ShaderLanguageDesc &lang);
 
+// Samples a depth texture and writes it to depth, color writes should be masked off.
+bool GenerateDepthCopyFragmentShader(char *buffer, const ShaderLanguageDesc &lang);
+
 // Just a single one. Can probably be shared with a lot of similar use cases.
 // Generates the coordinates for a fullscreen triangle.
 bool GenerateReinterpretVertexShader(char *buffer, const ShaderLanguageDesc &lang);
@@ -108,6 +108,8 @@ enum : uint64_t {
 	DIRTY_VIEWPORTSCISSOR_STATE = 1ULL << 46,
 	DIRTY_VERTEXSHADER_STATE = 1ULL << 47,
 	DIRTY_FRAGMENTSHADER_STATE = 1ULL << 48,
+	// Only the texture-dependent bits of the fragment shader ID may have changed, see UpdateFragmentShaderID.
+	DIRTY_FRAGMENTSHADER_TEXTURE = 1ULL << 49,
 
 	DIRTY_ALL = 0xFFFFFFFFFFFFFFFF
 };
@@ -155,5 +157,10 @@ enum {
 	ATTR_COUNT,
 };
 
+// Size of the texture array used by GPU_USE_BINDLESS_TEXTURES (Vulkan only).
+enum {
+	BINDLESS_TEXTURE_SLOTS = 1024,
+};
+
 struct TBuiltInResource;
 void init_resources(TBuiltInResource &Resources);
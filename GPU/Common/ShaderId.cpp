@@ -245,6 +245,34 @@ std::string FragmentShaderDesc(const FShaderID &id) {
 	return desc.str();
 }
 
+// The bits that depend on the bound texture, which changes far more often than the rest.
+// Only valid when texturing is enabled and we're not in clear mode.
+static void ComputeFragmentShaderTextureBits(FShaderID *id) {
+	bool doTextureAlpha = gstate.isTextureAlphaUsed();
+	// All texfuncs except replace are the same for RGB as for RGBA with full alpha.
+	// Note that checking this means that we must dirty the fragment shader ID whenever textureFullAlpha changes.
+	if (gstate_c.textureFullAlpha && gstate.getTextureFunction() != GE_TEXFUNC_REPLACE)
+		doTextureAlpha = false;
+
+	id->SetBit(FS_BIT_TEXALPHA, doTextureAlpha);  // rgb or rgba
+	if (gstate_c.needShaderTexClamp) {
+		bool textureAtOffset = gstate_c.curTextureXOffset != 0 || gstate_c.curTextureYOffset != 0;
+		// 4 bits total.
+		id->SetBit(FS_BIT_SHADER_TEX_CLAMP);
+		id->SetBit(FS_BIT_CLAMP_S, gstate.isTexCoordClampedS());
+		id->SetBit(FS_BIT_CLAMP_T, gstate.isTexCoordClampedT());
+		id->SetBit(FS_BIT_TEXTURE_AT_OFFSET, textureAtOffset);
+	} else {
+		id->SetBit(FS_BIT_SHADER_TEX_CLAMP, false);
+		id->SetBit(FS_BIT_CLAMP_S, false);
+		id->SetBit(FS_BIT_CLAMP_T, false);
+		id->SetBit(FS_BIT_TEXTURE_AT_OFFSET, false);
+	}
+	id->SetBit(FS_BIT_BGRA_TEXTURE, gstate_c.bgraTexture);
+	id->SetBit(FS_BIT_SHADER_DEPAL, gstate_c.useShaderDepal);
+	id->SetBit(FS_BIT_3D_TEXTURE, gstate_c.curTextureIs3D);
+}
+
 // Here we must take all the bits of the gstate that determine what the fragment shader will
 // look like, and concatenate them together into an ID.
 void ComputeFragmentShaderID(FShaderID *id_out, const Draw::Bugs &bugs) {
@@ -260,9 +288,7 @@ void ComputeFragmentShaderID(FShaderID *id_out, const Draw::Bugs &bugs) {
 		bool enableColorTest = gstate.isColorTestEnabled() && !IsColorTestTriviallyTrue();
 		bool enableColorDoubling = gstate.isColorDoublingEnabled() && gstate.isTextureMapEnabled();
 		bool doTextureProjection = (gstate.getUVGenMode() == GE_TEXMAP_TEXTURE_MATRIX && MatrixNeedsProjection(gstate.tgenMatrix));
-		bool doTextureAlpha = gstate.isTextureAlphaUsed();
 		bool doFlatShading = gstate.getShadeMode() == GE_SHADE_FLAT;
-		bool useShaderDepal = gstate_c.useShaderDepal;
 		bool colorWriteMask = IsColorWriteMaskComplex(gstate_c.allowFramebufferRead);
 		bool colorToDepth = gstate_c.renderMode == FramebufferRenderMode::FB_MODE_COLOR_TO_DEPTH;
 
@@ -274,26 +300,10 @@ void ComputeFragmentShaderID(FShaderID *id_out, const Draw::Bugs &bugs) {
 		}
 		ReplaceAlphaType stencilToAlpha = ReplaceAlphaWithStencil(replaceBlend);
 
-		// All texfuncs except replace are the same for RGB as for RGBA with full alpha.
-		// Note that checking this means that we must dirty the fragment shader ID whenever textureFullAlpha changes.
-		if (gstate_c.textureFullAlpha && gstate.getTextureFunction() != GE_TEXFUNC_REPLACE)
-			doTextureAlpha = false;
-
 		if (gstate.isTextureMapEnabled()) {
 			id.SetBit(FS_BIT_DO_TEXTURE);
 			id.SetBits(FS_BIT_TEXFUNC, 3, gstate.getTextureFunction());
-			id.SetBit(FS_BIT_TEXALPHA, doTextureAlpha & 1); // rgb or rgba
-			if (gstate_c.needShaderTexClamp) {
-				bool textureAtOffset = gstate_c.curTextureXOffset != 0 || gstate_c.curTextureYOffset != 0;
-				// 4 bits total.
-				id.SetBit(FS_BIT_SHADER_TEX_CLAMP);
-				id.SetBit(FS_BIT_CLAMP_S, gstate.isTexCoordClampedS());
-				id.SetBit(FS_BIT_CLAMP_T, gstate.isTexCoordClampedT());
-				id.SetBit(FS_BIT_TEXTURE_AT_OFFSET, textureAtOffset);
-			}
-			id.SetBit(FS_BIT_BGRA_TEXTURE, gstate_c.bgraTexture);
-			id.SetBit(FS_BIT_SHADER_DEPAL, useShaderDepal);
-			id.SetBit(FS_BIT_3D_TEXTURE, gstate_c.curTextureIs3D);
+			ComputeFragmentShaderTextureBits(&id);
 		}
 
 		id.SetBit(FS_BIT_COLOR_TO_DEPTH, colorToDepth);
@@ -359,3 +369,19 @@ void ComputeFragmentShaderID(FShaderID *id_out, const Draw::Bugs &bugs) {
 
 	*id_out = id;
 }
+
+void UpdateFragmentShaderID(FShaderID *id_out, const FShaderID &lastID, const Draw::Bugs &bugs) {
+	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
+		gstate_c.Clean(DIRTY_FRAGMENTSHADER_STATE | DIRTY_FRAGMENTSHADER_TEXTURE);
+		ComputeFragmentShaderID(id_out, bugs);
+	} else if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_TEXTURE)) {
+		gstate_c.Clean(DIRTY_FRAGMENTSHADER_TEXTURE);
+		FShaderID id = lastID;
+		// Clear mode and texture enable only change along with DIRTY_FRAGMENTSHADER_STATE.
+		if (!id.Bit(FS_BIT_CLEARMODE) && id.Bit(FS_BIT_DO_TEXTURE))
+			ComputeFragmentShaderTextureBits(&id);
+		*id_out = id;
+	} else {
+		*id_out = lastID;
+	}
+}
@@ -233,4 +233,7 @@ void ComputeVertexShaderID(VShaderID *id, uint32_t vertexType, bool useHWTransfo
 std::string VertexShaderDesc(const VShaderID &id);
 
 void ComputeFragmentShaderID(FShaderID *id, const Draw::Bugs &bugs);
+// Produces the current fragment shader ID from lastID and the dirty flags (which it cleans.)
+// When only DIRTY_FRAGMENTSHADER_TEXTURE is set, just the texture bits are recomputed.
+void UpdateFragmentShaderID(FShaderID *id, const FShaderID &lastID, const Draw::Bugs &bugs);
 std::string FragmentShaderDesc(const FShaderID &id);
@@ -122,6 +122,161 @@ static bool IsReallyAClear(const TransformedVertex *transformed, int numVerts, f
 	return true;
 }
 
+// Through mode with the common decoded formats: no provoking vertex games, just copy with the uv scale.
+// Avoids the per-component format switches in VertexReader, which dominate for sprite heavy games.
+static bool CanDecodeThroughFast(const DecVtxFormat &fmt) {
+	if (fmt.posfmt != DEC_FLOAT_3 && fmt.posfmt != DEC_S16_3)
+		return false;
+	if (fmt.uvfmt != DEC_NONE && fmt.uvfmt != DEC_FLOAT_2)
+		return false;
+	return fmt.c0fmt == DEC_NONE || fmt.c0fmt == DEC_U8_4;
+}
+
+static void DecodeThroughFast(TransformedVertex *transformed, const u8 *decoded, const DecVtxFormat &fmt, int count, float uscale, float vscale) {
+	const u32 defaultColor = gstate.getMaterialAmbientRGBA();
+	const bool floatPos = fmt.posfmt == DEC_FLOAT_3;
+	const bool hasUV = fmt.uvfmt != DEC_NONE;
+	const bool hasColor = fmt.c0fmt != DEC_NONE;
+
+	for (int index = 0; index < count; index++) {
+		const u8 *data = decoded + index * fmt.stride;
+		TransformedVertex &vert = transformed[index];
+		if (floatPos) {
+			const float *f = (const float *)(data + fmt.posoff);
+			vert.x = f[0];
+			vert.y = f[1];
+			// Integer value passed in a float. Clamped to 0, 65535.
+			const float z = (int)f[2] * (1.0f / 65535.0f);
+			vert.z = z > 1.0f ? 1.0f : (z < 0.0f ? 0.0f : z);
+		} else {
+			const s16 *s = (const s16 *)(data + fmt.posoff);
+			vert.x = s[0];
+			vert.y = s[1];
+			vert.z = ((const u16 *)s)[2] * (1.0f / 65535.0f);
+		}
+		vert.pos_w = 1.0f;
+
+		if (hasColor) {
+			memcpy(&vert.color0_32, data + fmt.c0off, 4);
+		} else {
+			vert.color0_32 = defaultColor;
+		}
+
+		if (hasUV) {
+			const float *uv = (const float *)(data + fmt.uvoff);
+			vert.u = uv[0] * uscale;
+			vert.v = uv[1] * vscale;
+		} else {
+			vert.u = 0.0f;
+			vert.v = 0.0f;
+		}
+		vert.uv_w = 1.0f;
+	}
+}
+
+// Takes world space positions in transformed[].pos and applies view and projection in one go,
+// also producing the fog coefficient. Done four vertices at a time in SoA form where we have SIMD.
+static void ProjectWorldPositions(TransformedVertex *transformed, int count, const float viewMatrix[12], const float projMatrix[16], float fogEnd, float fogSlope) {
+	// Fold the 4x3 view matrix into the projection, column-major like the rest.
+	float m[16];
+	for (int c = 0; c < 4; c++) {
+		for (int r = 0; r < 4; r++) {
+			float sum = c == 3 ? projMatrix[12 + r] : 0.0f;
+			for (int k = 0; k < 3; k++)
+				sum += viewMatrix[c * 3 + k] * projMatrix[k * 4 + r];
+			m[c * 4 + r] = sum;
+		}
+	}
+	// Only the view space Z is needed for fog.
+	const float fogRow[4] = { viewMatrix[2], viewMatrix[5], viewMatrix[8], viewMatrix[11] };
+
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128 fogEnd4 = _mm_set1_ps(fogEnd);
+	const __m128 fogSlope4 = _mm_set1_ps(fogSlope);
+	auto dot4 = [](__m128 x, __m128 y, __m128 z, const float *row, int stride) {
+		__m128 sum = _mm_mul_ps(x, _mm_set1_ps(row[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(y, _mm_set1_ps(row[stride])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(z, _mm_set1_ps(row[stride * 2])));
+		return _mm_add_ps(sum, _mm_set1_ps(row[stride * 3]));
+	};
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(transformed[i + 0].pos);
+		__m128 y = _mm_loadu_ps(transformed[i + 1].pos);
+		__m128 z = _mm_loadu_ps(transformed[i + 2].pos);
+		__m128 w = _mm_loadu_ps(transformed[i + 3].pos);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		__m128 outX = dot4(x, y, z, m + 0, 4);
+		__m128 outY = dot4(x, y, z, m + 1, 4);
+		__m128 outZ = dot4(x, y, z, m + 2, 4);
+		__m128 outW = dot4(x, y, z, m + 3, 4);
+		__m128 fog = _mm_mul_ps(_mm_add_ps(dot4(x, y, z, fogRow, 1), fogEnd4), fogSlope4);
+
+		_MM_TRANSPOSE4_PS(outX, outY, outZ, outW);
+		_mm_storeu_ps(transformed[i + 0].pos, outX);
+		_mm_storeu_ps(transformed[i + 1].pos, outY);
+		_mm_storeu_ps(transformed[i + 2].pos, outZ);
+		_mm_storeu_ps(transformed[i + 3].pos, outW);
+
+		float fogs[4];
+		_mm_storeu_ps(fogs, fog);
+		for (int j = 0; j < 4; j++)
+			transformed[i + j].fog = fogs[j];
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const float32x4_t fogEnd4 = vdupq_n_f32(fogEnd);
+	const float32x4_t fogSlope4 = vdupq_n_f32(fogSlope);
+	auto dot4 = [](float32x4_t x, float32x4_t y, float32x4_t z, const float *row, int stride) {
+		float32x4_t sum = vmulq_n_f32(x, row[0]);
+		sum = vaddq_f32(sum, vmulq_n_f32(y, row[stride]));
+		sum = vaddq_f32(sum, vmulq_n_f32(z, row[stride * 2]));
+		return vaddq_f32(sum, vdupq_n_f32(row[stride * 3]));
+	};
+	auto transpose4 = [](float32x4_t &a, float32x4_t &b, float32x4_t &c, float32x4_t &d) {
+		float32x4x2_t ac = vzipq_f32(a, c);
+		float32x4x2_t bd = vzipq_f32(b, d);
+		float32x4x2_t lo = vzipq_f32(ac.val[0], bd.val[0]);
+		float32x4x2_t hi = vzipq_f32(ac.val[1], bd.val[1]);
+		a = lo.val[0];
+		b = lo.val[1];
+		c = hi.val[0];
+		d = hi.val[1];
+	};
+	for (; i + 4 <= count; i += 4) {
+		float32x4_t x = vld1q_f32(transformed[i + 0].pos);
+		float32x4_t y = vld1q_f32(transformed[i + 1].pos);
+		float32x4_t z = vld1q_f32(transformed[i + 2].pos);
+		float32x4_t w = vld1q_f32(transformed[i + 3].pos);
+		transpose4(x, y, z, w);
+
+		float32x4_t outX = dot4(x, y, z, m + 0, 4);
+		float32x4_t outY = dot4(x, y, z, m + 1, 4);
+		float32x4_t outZ = dot4(x, y, z, m + 2, 4);
+		float32x4_t outW = dot4(x, y, z, m + 3, 4);
+		float32x4_t fog = vmulq_f32(vaddq_f32(dot4(x, y, z, fogRow, 1), fogEnd4), fogSlope4);
+
+		transpose4(outX, outY, outZ, outW);
+		vst1q_f32(transformed[i + 0].pos, outX);
+		vst1q_f32(transformed[i + 1].pos, outY);
+		vst1q_f32(transformed[i + 2].pos, outZ);
+		vst1q_f32(transformed[i + 3].pos, outW);
+
+		transformed[i + 0].fog = vgetq_lane_f32(fog, 0);
+		transformed[i + 1].fog = vgetq_lane_f32(fog, 1);
+		transformed[i + 2].fog = vgetq_lane_f32(fog, 2);
+		transformed[i + 3].fog = vgetq_lane_f32(fog, 3);
+	}
+#endif
+	for (; i < count; i++) {
+		float *pos = transformed[i].pos;
+		const float x = pos[0], y = pos[1], z = pos[2];
+		for (int r = 0; r < 4; r++)
+			pos[r] = x * m[r] + y * m[4 + r] + z * m[8 + r] + m[12 + r];
+		transformed[i].fog = (x * fogRow[0] + y * fogRow[1] + z * fogRow[2] + fogRow[3] + fogEnd) * fogSlope;
+	}
+}
+
 static int ColorIndexOffset(int prim, GEShadeMode shadeMode, bool clearMode) {
 	if (shadeMode != GE_SHADE_FLAT || clearMode) {
 		return 0;
@@ -206,7 +361,9 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 	}
 
 	VertexReader reader(decoded, decVtxFormat, vertType);
-	if (throughmode) {
+	if (throughmode && provokeIndOffset == 0 && CanDecodeThroughFast(decVtxFormat)) {
+		DecodeThroughFast(transformed, decoded, decVtxFormat, maxIndex, uscale, vscale);
+	} else if (throughmode) {
 		for (int index = 0; index < maxIndex; index++) {
 			// Do not touch the coordinates or the colors. No lighting.
 			reader.Goto(index);
@@ -242,15 +399,18 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 			// The w of uv is also never used (hardcoded to 1.0.)
 		}
 	} else {
+		const bool lightingEnabled = gstate.isLightingEnabled();
+		const bool normalsReversed = gstate.areNormalsReversed();
+		const GETexMapMode uvGenMode = gstate.getUVGenMode();
+
 		// Okay, need to actually perform the full transform.
+		// This loop stops at world space, view and projection are applied to the whole batch after.
 		for (int index = 0; index < maxIndex; index++) {
 			reader.Goto(index);
 
-			float v[3] = {0, 0, 0};
 			Vec4f c0 = Vec4f(1, 1, 1, 1);
 			Vec4f c1 = Vec4f(0, 0, 0, 0);
 			float uv[3] = {0, 0, 1};
-			float fogCoef = 1.0f;
 
 			float out[3];
 			float pos[3];
@@ -276,7 +436,7 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 			if (!skinningEnabled) {
 				Vec3ByMatrix43(out, pos, gstate.worldMatrix);
 				if (reader.hasNormal()) {
-					if (gstate.areNormalsReversed()) {
+					if (normalsReversed) {
 						normal = -normal;
 					}
 					Norm3ByMatrix43(worldnormal.AsArray(), normal.AsArray(), gstate.worldMatrix);
@@ -308,7 +468,7 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 				Vec3ByMatrix43(out, psum.AsArray(), gstate.worldMatrix);
 				if (reader.hasNormal()) {
 					normal = nsum;
-					if (gstate.areNormalsReversed()) {
+					if (normalsReversed) {
 						normal = -normal;
 					}
 					Norm3ByMatrix43(worldnormal.AsArray(), normal.AsArray(), gstate.worldMatrix);
@@ -317,7 +477,7 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 			}
 
 			// Perform lighting here if enabled.
-			if (gstate.isLightingEnabled()) {
+			if (lightingEnabled) {
 				float litColor0[4];
 				float litColor1[4];
 				lighter.Light(litColor0, litColor1, unlitColor.AsArray(), out, worldnormal);
@@ -347,7 +507,7 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 			}
 
 			// Perform texture coordinate generation after the transform and lighting - one style of UV depends on lights.
-			switch (gstate.getUVGenMode()) {
+			switch (uvGenMode) {
 			case GE_TEXMAP_TEXTURE_COORDS:	// UV mapping
 			case GE_TEXMAP_UNKNOWN: // Seen in Riviera.  Unsure of meaning, but this works.
 				// We always prescale in the vertex decoder now.
@@ -419,26 +579,23 @@ void SoftwareTransform::Decode(int prim, u32 vertType, const DecVtxFormat &decVt
 
 			default:
 				// Illegal
-				ERROR_LOG_REPORT(G3D, "Impossible UV gen mode? %d", gstate.getUVGenMode());
+				ERROR_LOG_REPORT(G3D, "Impossible UV gen mode? %d", uvGenMode);
 				break;
 			}
 
 			uv[0] = uv[0] * widthFactor;
 			uv[1] = uv[1] * heightFactor;
 
-			// Transform the coord by the view matrix.
-			Vec3ByMatrix43(v, out, gstate.viewMatrix);
-			fogCoef = (v[2] + fog_end) * fog_slope;
-
-			// TODO: Write to a flexible buffer, we don't always need all four components.
-			Vec3ByMatrix44(transformed[index].pos, v, projMatrix_.m);
-			transformed[index].fog = fogCoef;
+			// World space for now, see ProjectWorldPositions below.
+			memcpy(transformed[index].pos, out, 3 * sizeof(float));
 			memcpy(&transformed[index].uv, uv, 3 * sizeof(float));
 			transformed[index].color0_32 = c0.ToRGBA();
 			transformed[index].color1_32 = c1.ToRGBA();
-
-			// Vertex depth rounding is done in the shader, to simulate the 16-bit depth buffer.
 		}
+
+		// TODO: Write to a flexible buffer, we don't always need all four components.
+		ProjectWorldPositions(transformed, maxIndex, gstate.viewMatrix, projMatrix_.m, fog_end, fog_slope);
+		// Vertex depth rounding is done in the shader, to simulate the 16-bit depth buffer.
 	}
 
 	// Here's the best opportunity to try to detect rectangles used to clear the screen, and
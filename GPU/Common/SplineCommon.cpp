@@ -21,12 +21,16 @@
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/ge_constants.h"
 #include "GPU/GPUState.h"  // only needed for UVScale stuff
 
+// Below this, threading overhead costs more than it saves.
+#define TESS_MIN_VERTS_PER_TASK 1024
+
 class SimpleBufferManager {
 private:
 	u8 *buf_;
@@ -338,11 +342,28 @@ class SubdivisionSurface {
 public:
 	template <bool sampleNrm, bool sampleCol, bool sampleTex, bool useSSE4, bool patchFacing>
 	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights) {
+		// Each row along U writes its own set of vertices, so rows can go in parallel.
+		const int rows = surface.GetNumRowsU();
+		const int vertsPerRow = surface.num_patches_v * (surface.tess_v + 1);
+		const int minRows = std::max(1, TESS_MIN_VERTS_PER_TASK / vertsPerRow);
+		ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+			TessellateRows<sampleNrm, sampleCol, sampleTex, useSSE4, patchFacing>(output, surface, points, weights, lower, upper);
+		}, 0, rows, minRows);
+
+		surface.BuildIndex(output.indices, output.count);
+	}
+
+	template <bool sampleNrm, bool sampleCol, bool sampleTex, bool useSSE4, bool patchFacing>
+	static void TessellateRows(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, int lower, int upper) {
 		const float inv_u = 1.0f / (float)surface.tess_u;
 		const float inv_v = 1.0f / (float)surface.tess_v;
 
-		for (int patch_u = 0; patch_u < surface.num_patches_u; ++patch_u) {
-			const int start_u = surface.GetTessStart(patch_u);
+		for (int row = lower; row < upper; ++row) {
+			int patch_u, tile_u;
+			surface.GetRowU(row, patch_u, tile_u);
+			const int index_u = surface.GetIndexU(patch_u, tile_u);
+			const Weight &wu = weights.u[index_u];
+
 			for (int patch_v = 0; patch_v < surface.num_patches_v; ++patch_v) {
 				const int start_v = surface.GetTessStart(patch_v);
 
@@ -354,56 +375,49 @@ class SubdivisionSurface {
 				Tessellator<Vec2f> tess_tex(points.tex, idx_v);
 				Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
 
-				for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
-					const int index_u = surface.GetIndexU(patch_u, tile_u);
-					const Weight &wu = weights.u[index_u];
-
-					// Pre-tessellate U lines
-					tess_pos.SampleU(wu.basis);
-					if (sampleCol)
-						tess_col.SampleU(wu.basis);
-					if (sampleTex)
-						tess_tex.SampleU(wu.basis);
-					if (sampleNrm)
-						tess_nrm.SampleU(wu.deriv);
-
-					for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
-						const int index_v = surface.GetIndexV(patch_v, tile_v);
-						const Weight &wv = weights.v[index_v];
-
-						SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
-
-						// Tessellate
-						vert.pos = tess_pos.SampleV(wv.basis);
-						if (sampleCol) {
-							vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
-						} else {
-							vert.color_32 = points.defcolor;
-						}
-						if (sampleTex) {
-							tess_tex.SampleV(wv.basis).Write(vert.uv);
-						} else {
-							// Generate texcoord
-							vert.uv[0] = patch_u + tile_u * inv_u;
-							vert.uv[1] = patch_v + tile_v * inv_v;
-						}
-						if (sampleNrm) {
-							const Vec3f derivU = tess_nrm.SampleV(wv.basis);
-							const Vec3f derivV = tess_pos.SampleV(wv.deriv);
-
-							vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
-							if (patchFacing)
-								vert.nrm *= -1.0f;
-						} else {
-							vert.nrm.SetZero();
-							vert.nrm.z = 1.0f;
-						}
+				// Pre-tessellate U lines
+				tess_pos.SampleU(wu.basis);
+				if (sampleCol)
+					tess_col.SampleU(wu.basis);
+				if (sampleTex)
+					tess_tex.SampleU(wu.basis);
+				if (sampleNrm)
+					tess_nrm.SampleU(wu.deriv);
+
+				for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
+					const int index_v = surface.GetIndexV(patch_v, tile_v);
+					const Weight &wv = weights.v[index_v];
+
+					SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
+
+					// Tessellate
+					vert.pos = tess_pos.SampleV(wv.basis);
+					if (sampleCol) {
+						vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
+					} else {
+						vert.color_32 = points.defcolor;
+					}
+					if (sampleTex) {
+						tess_tex.SampleV(wv.basis).Write(vert.uv);
+					} else {
+						// Generate texcoord
+						vert.uv[0] = patch_u + tile_u * inv_u;
+						vert.uv[1] = patch_v + tile_v * inv_v;
+					}
+					if (sampleNrm) {
+						const Vec3f derivU = tess_nrm.SampleV(wv.basis);
+						const Vec3f derivV = tess_pos.SampleV(wv.deriv);
+
+						vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
+						if (patchFacing)
+							vert.nrm *= -1.0f;
+					} else {
+						vert.nrm.SetZero();
+						vert.nrm.z = 1.0f;
 					}
 				}
 			}
 		}
-
-		surface.BuildIndex(output.indices, output.count);
 	}
 
 	using TessFunc = void(*)(OutputBuffers &, const Surface &, const ControlPoints &, const Weight2D &);
@@ -104,6 +104,13 @@ struct BezierSurface : public SurfaceInfo {
 	int GetIndexU(int patch_u, int tile_u) const { return tile_u; }
 	int GetIndexV(int patch_v, int tile_v) const { return tile_v; }
 
+	// Rows along U across all patches, each tessellated independently.
+	int GetNumRowsU() const { return num_patches_u * (tess_u + 1); }
+	void GetRowU(int row, int &patch_u, int &tile_u) const {
+		patch_u = row / (tess_u + 1);
+		tile_u = row % (tess_u + 1);
+	}
+
 	int GetIndex(int index_u, int index_v, int patch_u, int patch_v) const {
 		int patch_index = patch_v * num_patches_u + patch_u;
 		return index_v * (tess_u + 1) + index_u + num_verts_per_patch * patch_index;
@@ -142,6 +149,13 @@ struct SplineSurface : public SurfaceInfo {
 	int GetIndexU(int patch_u, int tile_u) const { return patch_u * tess_u + tile_u; }
 	int GetIndexV(int patch_v, int tile_v) const { return patch_v * tess_v + tile_v; }
 
+	// Neighboring patches share an edge, which only the first one outputs.
+	int GetNumRowsU() const { return num_vertices_u; }
+	void GetRowU(int row, int &patch_u, int &tile_u) const {
+		patch_u = row == 0 ? 0 : (row - 1) / tess_u;
+		tile_u = row - patch_u * tess_u;
+	}
+
 	int GetIndex(int index_u, int index_v, int patch_u, int patch_v) const {
 		return index_v * num_vertices_u + index_u;
 	}
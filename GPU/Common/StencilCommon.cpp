@@ -79,8 +79,10 @@ static const VaryingDef varyings[1] = {
 	{ "vec2", "v_texcoord", Draw::SEM_TEXCOORD0, 0, "highp" },
 };
 
-void GenerateStencilFs(char *buffer, const ShaderLanguageDesc &lang, const Draw::Bugs &bugs) {
-	ShaderWriter writer(buffer, lang, ShaderStage::Fragment, nullptr, 0);
+void GenerateStencilFs(char *buffer, const ShaderLanguageDesc &lang, const Draw::Bugs &bugs, bool useExport) {
+	// With stencil export, the shader writes the value directly and everything is uploaded in a single pass.
+	const char *stencilExportExt = "#extension GL_ARB_shader_stencil_export : require";
+	ShaderWriter writer(buffer, lang, ShaderStage::Fragment, useExport ? &stencilExportExt : nullptr, useExport ? 1 : 0);
 	writer.HighPrecisionFloat();
 
 	writer.DeclareSampler2D("samp", 0);
@@ -92,13 +94,18 @@ void GenerateStencilFs(char *buffer, const ShaderLanguageDesc &lang, const Draw:
 
 	writer.C("float roundAndScaleTo255f(in float x) { return floor(x * 255.99); }\n");
 
-	writer.BeginFSMain(uniforms, varyings);
+	writer.BeginFSMain(useExport ? Slice<UniformDef>::empty() : uniforms, varyings);
 
 	writer.C("  vec4 index = ").SampleTexture2D("tex", "samp", "v_texcoord.xy").C(";\n");
 	writer.C("  vec4 outColor = index.aaaa;\n");  // Only care about a.
-	writer.C("  float shifted = roundAndScaleTo255f(index.a) / roundAndScaleTo255f(stencilValue);\n");
-	// Bitwise operations on floats, ugh.
-	writer.C("  if (mod(floor(shifted), 2.0) < 0.99) DISCARD;\n");
+	if (useExport) {
+		// Alpha already holds the stencil value scaled to 0-255 in all formats (4444 expands nibbles to 0x11 steps.)
+		writer.C("  gl_FragStencilRefARB = int(roundAndScaleTo255f(index.a));\n");
+	} else {
+		writer.C("  float shifted = roundAndScaleTo255f(index.a) / roundAndScaleTo255f(stencilValue);\n");
+		// Bitwise operations on floats, ugh.
+		writer.C("  if (mod(floor(shifted), 2.0) < 0.99) DISCARD;\n");
+	}
 
 	if (bugs.Has(Draw::Bugs::NO_DEPTH_CANNOT_DISCARD_STENCIL)) {
 		writer.C("  gl_FragDepth = gl_FragCoord.z;\n");
@@ -203,7 +210,7 @@ bool FramebufferManagerCommon::PerformStencilUpload(u32 addr, int size, StencilU
 
 		char *fsCode = new char[4000];
 		char *vsCode = new char[4000];
-		GenerateStencilFs(fsCode, shaderLanguageDesc, draw_->GetBugs());
+		GenerateStencilFs(fsCode, shaderLanguageDesc, draw_->GetBugs(), false);
 		GenerateStencilVs(vsCode, shaderLanguageDesc);
 
 		stencilUploadFs_ = draw_->CreateShaderModule(ShaderStage::Fragment, shaderLanguageDesc.shaderLanguage, (const uint8_t *)fsCode, strlen(fsCode), "stencil_fs");
@@ -211,6 +218,12 @@ bool FramebufferManagerCommon::PerformStencilUpload(u32 addr, int size, StencilU
 
 		_assert_(stencilUploadFs_ && stencilUploadVs_);
 
+		if (draw_->GetDeviceCaps().fragmentShaderStencilWriteSupported) {
+			GenerateStencilFs(fsCode, shaderLanguageDesc, draw_->GetBugs(), true);
+			stencilUploadExportFs_ = draw_->CreateShaderModule(ShaderStage::Fragment, shaderLanguageDesc.shaderLanguage, (const uint8_t *)fsCode, strlen(fsCode), "stencil_export_fs");
+			// If this fails, we just fall back to the multi-pass upload.
+		}
+
 		InputLayoutDesc desc = {
 			{
 				{ 8, false },
@@ -239,6 +252,15 @@ bool FramebufferManagerCommon::PerformStencilUpload(u32 addr, int size, StencilU
 		stencilUploadPipeline_ = draw_->CreateGraphicsPipeline(stencilWriteDesc);
 		_assert_(stencilUploadPipeline_);
 
+		if (stencilUploadExportFs_) {
+			PipelineDesc stencilExportDesc{
+				Primitive::TRIANGLE_LIST,
+				{ stencilUploadVs_, stencilUploadExportFs_ },
+				inputLayout, stencilWrite, blendOff, rasterNoCull, &stencilUBDesc,
+			};
+			stencilUploadExportPipeline_ = draw_->CreateGraphicsPipeline(stencilExportDesc);
+		}
+
 		delete[] fsCode;
 		delete[] vsCode;
 
@@ -294,26 +316,36 @@ bool FramebufferManagerCommon::PerformStencilUpload(u32 addr, int size, StencilU
 
 	// We must bind the program after starting the render pass, and set the color mask after clearing.
 	draw_->SetScissorRect(0, 0, w, h);
-	draw_->BindPipeline(stencilUploadPipeline_);
 
-	for (int i = 1; i < values; i += i) {
-		if (!(usedBits & i)) {
-			// It's already zero, let's skip it.
-			continue;
-		}
+	if (stencilUploadExportPipeline_) {
+		// The shader exports the full stencil value, so one draw is enough. The reference value is ignored.
+		draw_->BindPipeline(stencilUploadExportPipeline_);
+		draw_->SetStencilParams(0xFF, 0xFF, 0xFF);
 		StencilUB ub{};
-		if (dstBuffer->format == GE_FORMAT_4444) {
-			draw_->SetStencilParams(0xFF, (i << 4) | i, 0xFF);
-			ub.stencilValue = i * (16.0f / 255.0f);
-		} else if (dstBuffer->format == GE_FORMAT_5551) {
-			draw_->SetStencilParams(0xFF, 0xFF, 0xFF);
-			ub.stencilValue = i * (128.0f / 255.0f);
-		} else {
-			draw_->SetStencilParams(0xFF, i, 0xFF);
-			ub.stencilValue = i * (1.0f / 255.0f);
-		}
 		draw_->UpdateDynamicUniformBuffer(&ub, sizeof(ub));
 		draw_->DrawUP(positions, 3);
+	} else {
+		draw_->BindPipeline(stencilUploadPipeline_);
+
+		for (int i = 1; i < values; i += i) {
+			if (!(usedBits & i)) {
+				// It's already zero, let's skip it.
+				continue;
+			}
+			StencilUB ub{};
+			if (dstBuffer->format == GE_FORMAT_4444) {
+				draw_->SetStencilParams(0xFF, (i << 4) | i, 0xFF);
+				ub.stencilValue = i * (16.0f / 255.0f);
+			} else if (dstBuffer->format == GE_FORMAT_5551) {
+				draw_->SetStencilParams(0xFF, 0xFF, 0xFF);
+				ub.stencilValue = i * (128.0f / 255.0f);
+			} else {
+				draw_->SetStencilParams(0xFF, i, 0xFF);
+				ub.stencilValue = i * (1.0f / 255.0f);
+			}
+			draw_->UpdateDynamicUniformBuffer(&ub, sizeof(ub));
+			draw_->DrawUP(positions, 3);
+		}
 	}
 
 	if (useBlit) {
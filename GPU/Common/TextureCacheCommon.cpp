@@ -18,16 +18,20 @@
 #include "ppsspp_config.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
+#include "Common/Data/Hash/Hash.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Common/Math/math_util.h"
 #include "Core/Config.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
@@ -36,6 +40,7 @@
 #include "GPU/Common/ShaderId.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Debugger/Debugger.h"
+#include "GPU/Debugger/DrawProfile.h"
 #include "GPU/GPUCommon.h"
 #include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
@@ -55,9 +60,11 @@
 // Videos should be updated every few frames, so we forget quickly.
 #define VIDEO_DECIMATE_AGE 4
 
-// If a texture hasn't been seen for this many frames, get rid of it.
-#define TEXTURE_KILL_AGE 200
-#define TEXTURE_KILL_AGE_LOWMEM 60
+// Once the cache estimate is above the budget, we evict the least valuable textures until we're
+// back under the target.  Evicting a bit more than needed avoids churning every interval.
+#define TEXCACHE_BUDGET (128 * 1024 * 1024)
+#define TEXCACHE_BUDGET_LOWMEM (40 * 1024 * 1024)
+#define TEXCACHE_BUDGET_TARGET_PERCENT 85
 // Not used in lowmem mode.
 #define TEXTURE_SECOND_KILL_AGE 100
 // Used when there are multiple CLUT variants of a texture.
@@ -71,6 +78,13 @@
 #define TEXCACHE_MIN_PRESSURE 16 * 1024 * 1024  // Total in VRAM
 #define TEXCACHE_SECOND_MIN_PRESSURE 4 * 1024 * 1024
 
+// Textures at least this large are mostly checked by hashing samples (4 KB total.)
+#define SAMPLED_HASH_MIN_BYTES (64 * 1024)
+#define SAMPLED_HASH_SAMPLES 64
+#define SAMPLED_HASH_SAMPLE_BYTES 64
+// Sampled checks allowed in a row before we do a full hash anyway.
+#define SAMPLED_HASH_CHECKS 7
+
 // Just for reference
 
 // PSP Color formats:
@@ -360,6 +374,7 @@ void TextureCacheCommon::UpdateMaxSeenV(TexCacheEntry *entry, bool throughMode)
 }
 
 TexCacheEntry *TextureCacheCommon::SetTexture() {
+	GPUDrawProfile::Scope profile(GPUDrawProfile::Cost::TEXTURE);
 	u8 level = 0;
 	if (IsFakeMipmapChange()) {
 		level = std::max(0, gstate.getTexLevelOffset16() / 16);
@@ -407,7 +422,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 	gstate_c.SetNeedShaderTexclamp(false);
 	gstate_c.skipDrawReason &= ~SKIPDRAW_BAD_FB_TEXTURE;
 	if (gstate_c.bgraTexture != isBgraBackend_) {
-		gstate_c.Dirty(DIRTY_FRAGMENTSHADER_STATE);
+		gstate_c.Dirty(DIRTY_FRAGMENTSHADER_TEXTURE);
 	}
 	gstate_c.bgraTexture = isBgraBackend_;
 
@@ -415,7 +430,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 		entry = entryIter->second.get();
 		// Validate the texture still matches the cache entry.
 		bool match = entry->Matches(dim, format, maxLevel);
-		const char *reason = "different params";
+		TextureChangeReason reason = TextureChangeReason::PARAMS;
 
 		// Check for FBO changes.
 		if (entry->status & TexCacheEntry::STATUS_FRAMEBUFFER_OVERLAP) {
@@ -469,17 +484,18 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 
 			if (minihash != entry->minihash) {
 				match = false;
-				reason = "minihash";
+				reason = TextureChangeReason::MINIHASH;
 			} else if (entry->GetHashStatus() == TexCacheEntry::STATUS_RELIABLE) {
 				rehash = false;
 			}
 		}
 
 		if (match && (entry->status & TexCacheEntry::STATUS_TO_SCALE) && standardScaleFactor_ != 1 && texelsScaledThisFrame_ < TEXCACHE_MAX_TEXELS_SCALED) {
-			if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
+			// If it's still being scaled in the background, keep drawing the unscaled one.
+			if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0 && !upscaled_.IsPending({ entry->CacheKey(), entry->fullhash })) {
 				// INFO_LOG(G3D, "Reloading texture to do the scaling we skipped..");
 				match = false;
-				reason = "scaling";
+				reason = TextureChangeReason::SCALING;
 			}
 		}
 
@@ -490,7 +506,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 			ReplacedTexture &replaced = FindReplacement(entry, w0, h0, d0);
 			if (replaced.Valid()) {
 				match = false;
-				reason = "replacing";
+				reason = TextureChangeReason::REPLACING;
 			}
 		}
 
@@ -512,6 +528,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 			// Might need a rebuild if the hash fails, but that will be set later.
 			nextNeedsRebuild_ = false;
 			VERBOSE_LOG(G3D, "Texture at %08x found in cache, applying", texaddr);
+			gpuStats.cache.textureHits++;
 			return entry; //Done!
 		} else {
 			// Wasn't a match, we will rebuild.
@@ -551,6 +568,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 
 	if (!entry) {
 		VERBOSE_LOG(G3D, "No texture in cache for %08x, decoding...", texaddr);
+		gpuStats.cache.textureMisses++;
 		entry = new TexCacheEntry{};
 		cache_[cachekey].reset(entry);
 
@@ -707,7 +725,28 @@ int TextureCacheCommon::GetBestCandidateIndex(const std::vector<AttachCandidate>
 	return bestIndex;
 }
 
-// Removes old textures.
+u32 TextureCacheCommon::TextureBudget() const {
+	return lowMemoryMode_ ? TEXCACHE_BUDGET_LOWMEM : TEXCACHE_BUDGET;
+}
+
+// Higher means a better candidate for eviction.  Old and large textures go first, but textures that
+// were expensive to produce (scaled or replaced) are kept longer than ones we can just decode again.
+float TextureCacheCommon::EvictionScore(const TexCacheEntry *entry) const {
+	float age = (float)(gpuStats.numFlips - entry->lastFrame);
+	float bytes = (float)EstimateTexMemoryUsage(entry);
+	float cost = 1.0f;
+	if (entry->status & TexCacheEntry::STATUS_IS_SCALED) {
+		// Also covers replacements, which have to be loaded again from disk.
+		cost *= 4.0f * standardScaleFactor_ * standardScaleFactor_;
+	}
+	if ((entry->status & TexCacheEntry::STATUS_MASK) == TexCacheEntry::STATUS_RELIABLE) {
+		// We'd need to hash it again before trusting it.
+		cost *= 1.5f;
+	}
+	return age * bytes / cost;
+}
+
+// Removes textures when over budget, least valuable first.
 void TextureCacheCommon::Decimate(bool forcePressure) {
 	if (--decimationCounter_ <= 0) {
 		decimationCounter_ = TEXCACHE_DECIMATION_INTERVAL;
@@ -719,19 +758,50 @@ void TextureCacheCommon::Decimate(bool forcePressure) {
 		const u32 had = cacheSizeEstimate_;
 
 		ForgetLastTexture();
-		int killAgeBase = lowMemoryMode_ ? TEXTURE_KILL_AGE_LOWMEM : TEXTURE_KILL_AGE;
+		// CLUT variants are cheap to recreate and pile up fast, so they still go by age.
 		for (TexCache::iterator iter = cache_.begin(); iter != cache_.end(); ) {
 			bool hasClut = (iter->second->status & TexCacheEntry::STATUS_CLUT_VARIANTS) != 0;
-			int killAge = hasClut ? TEXTURE_KILL_AGE_CLUT : killAgeBase;
-			if (iter->second->lastFrame + killAge < gpuStats.numFlips) {
+			if (hasClut && iter->second->lastFrame + TEXTURE_KILL_AGE_CLUT < gpuStats.numFlips) {
+				gpuStats.cache.textureBytesEvicted += EstimateTexMemoryUsage(iter->second.get());
 				DeleteTexture(iter++);
+				gpuStats.cache.texturesDecimated++;
 			} else {
 				++iter;
 			}
 		}
 
+		const u32 budget = TextureBudget();
+		if (forcePressure || cacheSizeEstimate_ > budget) {
+			const u32 target = forcePressure ? std::min(cacheSizeEstimate_ / 2, budget) : (u32)((u64)budget * TEXCACHE_BUDGET_TARGET_PERCENT / 100);
+
+			struct Candidate {
+				float score;
+				u64 cachekey;
+			};
+			std::vector<Candidate> candidates;
+			candidates.reserve(cache_.size());
+			for (const auto &iter : cache_) {
+				// Never evict anything used this frame, it may still be bound.
+				if (iter.second->lastFrame < gpuStats.numFlips)
+					candidates.push_back({ EvictionScore(iter.second.get()), iter.first });
+			}
+			std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+				return a.score > b.score;
+			});
+
+			for (const Candidate &candidate : candidates) {
+				if (cacheSizeEstimate_ <= target)
+					break;
+				auto iter = cache_.find(candidate.cachekey);
+				gpuStats.cache.textureBytesEvicted += EstimateTexMemoryUsage(iter->second.get());
+				DeleteTexture(iter);
+				gpuStats.cache.texturesDecimated++;
+			}
+		}
+
 		VERBOSE_LOG(G3D, "Decimated texture cache, saved %d estimated bytes - now %d bytes", had - cacheSizeEstimate_, cacheSizeEstimate_);
 	}
+	gpuStats.cache.textureCacheBytes = cacheSizeEstimate_;
 
 	// If enabled, we also need to clear the secondary cache.
 	if (g_Config.bTextureSecondaryCache && (forcePressure || secondCacheSizeEstimate_ >= TEXCACHE_SECOND_MIN_PRESSURE)) {
@@ -743,6 +813,7 @@ void TextureCacheCommon::Decimate(bool forcePressure) {
 				ReleaseTexture(iter->second.get(), true);
 				secondCacheSizeEstimate_ -= EstimateTexMemoryUsage(iter->second.get());
 				secondCache_.erase(iter++);
+				gpuStats.cache.texturesDecimated++;
 			} else {
 				++iter;
 			}
@@ -778,11 +849,12 @@ bool TextureCacheCommon::IsVideo(u32 texaddr) const {
 	return false;
 }
 
-void TextureCacheCommon::HandleTextureChange(TexCacheEntry *const entry, const char *reason, bool initialMatch, bool doDelete) {
+void TextureCacheCommon::HandleTextureChange(TexCacheEntry *const entry, TextureChangeReason reason, bool initialMatch, bool doDelete) {
 	cacheSizeEstimate_ -= EstimateTexMemoryUsage(entry);
 	entry->numInvalidated++;
 	gpuStats.numTextureInvalidations++;
-	DEBUG_LOG(G3D, "Texture different or overwritten, reloading at %08x: %s", entry->addr, reason);
+	gpuStats.cache.textureChanges[(int)reason]++;
+	DEBUG_LOG(G3D, "Texture different or overwritten, reloading at %08x: %s", entry->addr, TextureChangeReasonToString(reason));
 	if (doDelete) {
 		InvalidateLastTexture();
 		ReleaseTexture(entry, true);
@@ -1050,9 +1122,9 @@ void TextureCacheCommon::SetTextureFramebuffer(const AttachCandidate &candidate)
 		gstate_c.curTextureWidth = framebuffer->bufferWidth;
 		gstate_c.curTextureHeight = framebuffer->bufferHeight;
 		if (gstate_c.bgraTexture) {
-			gstate_c.Dirty(DIRTY_FRAGMENTSHADER_STATE);
+			gstate_c.Dirty(DIRTY_FRAGMENTSHADER_TEXTURE);
 		} else if ((gstate_c.curTextureXOffset == 0) != (fbInfo.xOffset == 0) || (gstate_c.curTextureYOffset == 0) != (fbInfo.yOffset == 0)) {
-			gstate_c.Dirty(DIRTY_FRAGMENTSHADER_STATE);
+			gstate_c.Dirty(DIRTY_FRAGMENTSHADER_TEXTURE);
 		}
 		gstate_c.bgraTexture = false;
 		gstate_c.curTextureXOffset = fbInfo.xOffset;
@@ -1084,6 +1156,85 @@ void TextureCacheCommon::SetTextureFramebuffer(const AttachCandidate &candidate)
 	nextNeedsRebuild_ = false;
 }
 
+// The area of the source framebuffer a depal pass converts, matching what the shader appliers crop to.
+static void GetDepalArea(const VirtualFramebuffer *framebuffer, int *u1, int *v1, int *u2, int *v2) {
+	const KnownVertexBounds &bounds = gstate_c.vertBounds;
+	if (bounds.minV < bounds.maxV) {
+		*u1 = bounds.minU + gstate_c.curTextureXOffset;
+		*v1 = bounds.minV + gstate_c.curTextureYOffset;
+		*u2 = bounds.maxU + gstate_c.curTextureXOffset;
+		*v2 = bounds.maxV + gstate_c.curTextureYOffset;
+	} else {
+		*u1 = 0;
+		*v1 = 0;
+		*u2 = framebuffer->bufferWidth;
+		*v2 = framebuffer->bufferHeight;
+	}
+}
+
+bool TextureCacheCommon::CanReuseDepalResult(VirtualFramebuffer *framebuffer, bool depth) const {
+	// Draws to the current render target don't change the write sequence, so we can't tell
+	// if a result from it (or its depth buffer) is stale.
+	VirtualFramebuffer *renderTarget = framebufferManager_->GetCurrentRenderVFB();
+	if (framebuffer == renderTarget) {
+		return false;
+	}
+	if (depth && renderTarget && renderTarget->z_address == framebuffer->z_address) {
+		return false;
+	}
+	return true;
+}
+
+const TextureCacheCommon::DepalResult *TextureCacheCommon::FindDepalResult(VirtualFramebuffer *framebuffer, bool depth) {
+	if (!CanReuseDepalResult(framebuffer, depth)) {
+		return nullptr;
+	}
+
+	const u32 writeSeq = framebufferManager_->FramebufferWriteSeq();
+	const u32 clutMode = gstate.clutformat & 0xFFFFFF;
+	const GEBufferFormat format = depth ? GE_FORMAT_DEPTH16 : framebuffer->drawnFormat;
+	int u1, v1, u2, v2;
+	GetDepalArea(framebuffer, &u1, &v1, &u2, &v2);
+
+	for (DepalResult &result : depalResults_) {
+		if (!result.fbo || result.vfb != framebuffer || result.writeSeq != writeSeq || result.depth != depth || result.format != format)
+			continue;
+		if (result.clutHash != clutHash_ || result.clutMode != clutMode)
+			continue;
+		if (u1 < result.u1 || v1 < result.v1 || u2 > result.u2 || v2 > result.v2)
+			continue;
+		result.lastUse = ++depalResultUse_;
+		if (gstate_c.vertBounds.minV < gstate_c.vertBounds.maxV) {
+			// Like after a cropped pass, we need to recheck the texture for the next draw.
+			gstate_c.Dirty(DIRTY_TEXTURE_PARAMS);
+		}
+		return &result;
+	}
+	return nullptr;
+}
+
+TextureCacheCommon::DepalResult *TextureCacheCommon::GetDepalTarget(VirtualFramebuffer *framebuffer, bool depth) {
+	// Replace the least recently used result, each one has its own temp framebuffer.
+	int slot = 0;
+	for (int i = 1; i < MAX_DEPAL_RESULTS; i++) {
+		if (depalResults_[i].lastUse < depalResults_[slot].lastUse)
+			slot = i;
+	}
+
+	DepalResult &result = depalResults_[slot];
+	result.fbo = framebufferManager_->GetTempFBO(TempFBO::DEPAL, framebuffer->renderWidth, framebuffer->renderHeight, (u8)slot);
+	result.vfb = CanReuseDepalResult(framebuffer, depth) ? framebuffer : nullptr;
+	result.writeSeq = framebufferManager_->FramebufferWriteSeq();
+	result.clutHash = clutHash_;
+	result.clutMode = gstate.clutformat & 0xFFFFFF;
+	result.format = depth ? GE_FORMAT_DEPTH16 : framebuffer->drawnFormat;
+	result.depth = depth;
+	result.fullAlpha = false;
+	GetDepalArea(framebuffer, &result.u1, &result.v1, &result.u2, &result.v2);
+	result.lastUse = ++depalResultUse_;
+	return &result;
+}
+
 // Only looks for framebuffers.
 bool TextureCacheCommon::SetOffsetTexture(u32 yOffset) {
 	if (!framebufferManager_->UseBufferedRendering()) {
@@ -1133,6 +1284,14 @@ void TextureCacheCommon::NotifyConfigChanged() {
 
 	standardScaleFactor_ = scaleFactor;
 
+	Path upscaledPath;
+	if (g_Config.bTexScalingDiskCache && scaleFactor > 1 && !g_Config.bTexHardwareScaling) {
+		// Results depend on the scaler settings and the backend's color order, so keep them apart.
+		std::string variant = StringFromFormat("%s_%d_%d%s", g_paramSFO.GetDiscID().c_str(), g_Config.iGPUBackend, g_Config.iTexScalingType, g_Config.bTexDeposterize ? "_deposterize" : "");
+		upscaledPath = GetSysDirectory(DIRECTORY_APP_CACHE) / "upscaled" / variant;
+	}
+	upscaled_.NotifyConfigChanged(upscaledPath, g_Config.bTexScalingBackground && scaleFactor > 1 && !g_Config.bTexHardwareScaling);
+
 	replacer_.NotifyConfigChanged();
 }
 
@@ -1272,7 +1431,7 @@ bool TextureCacheCommon::GetCurrentClutBuffer(GPUDebugBuffer &buffer) {
 }
 
 // Host memory usage, not PSP memory usage.
-u32 TextureCacheCommon::EstimateTexMemoryUsage(const TexCacheEntry *entry) {
+u32 TextureCacheCommon::EstimateTexMemoryUsage(const TexCacheEntry *entry) const {
 	const u16 dim = entry->dim;
 	// TODO: This does not take into account the HD remaster's larger textures.
 	const u8 dimW = ((dim >> 0) & 0xf);
@@ -1385,6 +1544,31 @@ static inline void ConvertFormatToRGBA8888(GEPaletteFormat format, u32 *dst, con
 	ConvertFormatToRGBA8888(GETextureFormat(format), dst, src, numPixels);
 }
 
+// Large levels are decoded in row ranges on the worker threads.  The alpha checks AND into a
+// mask, so each range keeps its own and they're combined at the end.
+static const int MIN_PARALLEL_DECODE_PIXELS = 256 * 128;
+
+template <typename F>
+static void DecodeRows(int w, int h, u32 *alphaSum, F decodeRow) {
+	if (w * h < MIN_PARALLEL_DECODE_PIXELS || g_threadManager.GetNumLooperThreads() <= 1) {
+		for (int y = 0; y < h; ++y) {
+			decodeRow(y, alphaSum);
+		}
+		return;
+	}
+
+	std::atomic<u32> combined(*alphaSum);
+	const int minRows = std::max(8, MIN_PARALLEL_DECODE_PIXELS / 4 / w);
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		u32 rangeAlphaSum = 0xFFFFFFFF;
+		for (int y = lower; y < upper; ++y) {
+			decodeRow(y, &rangeAlphaSum);
+		}
+		combined &= rangeAlphaSum;
+	}, 0, h, minRows);
+	*alphaSum = combined;
+}
+
 template <typename DXTBlock, int n>
 static CheckAlphaResult DecodeDXTBlocks(uint8_t *out, int outPitch, uint32_t texaddr, const uint8_t *texptr,
 	int w, int h, int bufw, bool reverseColors) {
@@ -1403,13 +1587,15 @@ static CheckAlphaResult DecodeDXTBlocks(uint8_t *out, int outPitch, uint32_t tex
 	}
 
 	u32 alphaSum = 1;
-	for (int y = 0; y < h; y += 4) {
-		u32 blockIndex = (y / 4) * (bufw / 4);
+	// Each "row" here is a row of blocks, so four pixel rows.
+	DecodeRows(minw * 4, (h + 3) / 4, &alphaSum, [&](int blockRow, u32 *rowAlphaSum) {
+		int y = blockRow * 4;
+		u32 blockIndex = blockRow * (bufw / 4);
 		int blockHeight = std::min(h - y, 4);
 		for (int x = 0; x < minw; x += 4) {
 			switch (n) {
 			case 1:
-				DecodeDXT1Block(dst + outPitch32 * y + x, (const DXT1Block *)src + blockIndex, outPitch32, blockHeight, &alphaSum);
+				DecodeDXT1Block(dst + outPitch32 * y + x, (const DXT1Block *)src + blockIndex, outPitch32, blockHeight, rowAlphaSum);
 				break;
 			case 3:
 				DecodeDXT3Block(dst + outPitch32 * y + x, (const DXT3Block *)src + blockIndex, outPitch32, blockHeight);
@@ -1420,7 +1606,7 @@ static CheckAlphaResult DecodeDXTBlocks(uint8_t *out, int outPitch, uint32_t tex
 			}
 			blockIndex++;
 		}
-	}
+	});
 
 	if (reverseColors) {
 		ReverseColors(out, out, GE_TFMT_8888, outPitch32 * h);
@@ -1500,13 +1686,13 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 				// We don't bother with fullalpha here (clutAlphaLinear_)
 				// Here, reverseColors means the CLUT is already reversed.
 				if (reverseColors) {
-					for (int y = 0; y < h; ++y) {
+					DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
 						DeIndexTexture4Optimal((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
-					}
+					});
 				} else {
-					for (int y = 0; y < h; ++y) {
+					DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
 						DeIndexTexture4OptimalRev((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
-					}
+					});
 				}
 			} else {
 				const u16 *clut = GetCurrentClut<u16>() + clutSharingOffset;
@@ -1514,15 +1700,15 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 					// We simply expand the CLUT to 32-bit, then we deindex as usual. Probably the fastest way.
 					ConvertFormatToRGBA8888(clutformat, expandClut_, clut, 16);
 					fullAlphaMask = 0xFF000000;
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4<u32>((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, expandClut_, &alphaSum);
-					}
+					DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+						DeIndexTexture4Clut32((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, expandClut_, rowAlphaSum);
+					});
 				} else {
 					// If we're reversing colors, the CLUT was already reversed.
 					fullAlphaMask = ClutFormatToFullAlpha(clutformat, reverseColors);
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4<u16>((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut, &alphaSum);
-					}
+					DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+						DeIndexTexture4Clut16((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut, rowAlphaSum);
+					});
 				}
 			}
 
@@ -1537,9 +1723,9 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 		{
 			const u32 *clut = GetCurrentClut<u32>() + clutSharingOffset;
 			fullAlphaMask = 0xFF000000;
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture4<u32>((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut, &alphaSum);
-			}
+			DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+				DeIndexTexture4Clut32((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut, rowAlphaSum);
+			});
 		}
 		break;
 
@@ -1567,20 +1753,20 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 			fullAlphaMask = TfmtRawToFullAlpha(format);
 			if (expandTo32bit) {
 				// This is OK even if reverseColors is on, because it expands to the 8888 format which is the same in reverse mode.
-				for (int y = 0; y < h; ++y) {
-					CheckMask16((const u16 *)(texptr + bufw * sizeof(u16) * y), w, &alphaSum);
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CheckMask16((const u16 *)(texptr + bufw * sizeof(u16) * y), w, rowAlphaSum);
 					ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)texptr + bufw * y, w);
-				}
+				});
 			} else if (reverseColors) {
 				// Just check the input's alpha to reuse code. TODO: make a specialized ReverseColors that checks as we go.
-				for (int y = 0; y < h; ++y) {
-					CheckMask16((const u16 *)(texptr + bufw * sizeof(u16) * y), w, &alphaSum);
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CheckMask16((const u16 *)(texptr + bufw * sizeof(u16) * y), w, rowAlphaSum);
 					ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u16) * y, format, w);
-				}
+				});
 			} else {
-				for (int y = 0; y < h; ++y) {
-					CopyAndSumMask16((u16 *)(out + outPitch * y), (u16 *)(texptr + bufw * sizeof(u16) * y), w, &alphaSum);
-				}
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CopyAndSumMask16((u16 *)(out + outPitch * y), (u16 *)(texptr + bufw * sizeof(u16) * y), w, rowAlphaSum);
+				});
 			}
 		} /* else if (h >= 8 && bufw <= w && !expandTo32bit) {
 			// TODO: Handle alpha mask. This will require special versions of UnswizzleFromMem to keep the optimization.
@@ -1599,20 +1785,20 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 			if (expandTo32bit) {
 				// This is OK even if reverseColors is on, because it expands to the 8888 format which is the same in reverse mode.
 				// Just check the swizzled input's alpha to reuse code. TODO: make a specialized ConvertFormatToRGBA8888 that checks as we go.
-				for (int y = 0; y < h; ++y) {
-					CheckMask16((const u16 *)(unswizzled + bufw * sizeof(u16) * y), w, &alphaSum);
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CheckMask16((const u16 *)(unswizzled + bufw * sizeof(u16) * y), w, rowAlphaSum);
 					ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)unswizzled + bufw * y, w);
-				}
+				});
 			} else if (reverseColors) {
 				// Just check the swizzled input's alpha to reuse code. TODO: make a specialized ReverseColors that checks as we go.
-				for (int y = 0; y < h; ++y) {
-					CheckMask16((const u16 *)(unswizzled + bufw * sizeof(u16) * y), w, &alphaSum);
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CheckMask16((const u16 *)(unswizzled + bufw * sizeof(u16) * y), w, rowAlphaSum);
 					ReverseColors(out + outPitch * y, unswizzled + bufw * sizeof(u16) * y, format, w);
-				}
+				});
 			} else {
-				for (int y = 0; y < h; ++y) {
-					CopyAndSumMask16((u16 *)(out + outPitch * y), (const u16 *)(unswizzled + bufw * sizeof(u16) * y), w, &alphaSum);
-				}
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CopyAndSumMask16((u16 *)(out + outPitch * y), (const u16 *)(unswizzled + bufw * sizeof(u16) * y), w, rowAlphaSum);
+				});
 			}
 		}
 		if (format == GE_TFMT_5650) {
@@ -1624,14 +1810,14 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 		if (!swizzled) {
 			fullAlphaMask = TfmtRawToFullAlpha(format);
 			if (reverseColors) {
-				for (int y = 0; y < h; ++y) {
-					CheckMask32((const u32 *)(texptr + bufw * sizeof(u32) * y), w, &alphaSum);
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CheckMask32((const u32 *)(texptr + bufw * sizeof(u32) * y), w, rowAlphaSum);
 					ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u32) * y, format, w);
-				}
+				});
 			} else {
-				for (int y = 0; y < h; ++y) {
-					CopyAndSumMask32((u32 *)(out + outPitch * y), (const u32 *)(texptr + bufw * sizeof(u32) * y), w, &alphaSum);
-				}
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CopyAndSumMask32((u32 *)(out + outPitch * y), (const u32 *)(texptr + bufw * sizeof(u32) * y), w, rowAlphaSum);
+				});
 			}
 		} /* else if (h >= 8 && bufw <= w) {
 			// TODO: Handle alpha mask
@@ -1646,14 +1832,14 @@ CheckAlphaResult TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, G
 
 			fullAlphaMask = TfmtRawToFullAlpha(format);
 			if (reverseColors) {
-				for (int y = 0; y < h; ++y) {
-					CheckMask32((const u32 *)(unswizzled + bufw * sizeof(u32) * y), w, &alphaSum);
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CheckMask32((const u32 *)(unswizzled + bufw * sizeof(u32) * y), w, rowAlphaSum);
 					ReverseColors(out + outPitch * y, unswizzled + bufw * sizeof(u32) * y, format, w);
-				}
+				});
 			} else {
-				for (int y = 0; y < h; ++y) {
-					CopyAndSumMask32((u32 *)(out + outPitch * y), (const u32 *)(unswizzled + bufw * sizeof(u32) * y), w, &alphaSum);
-				}
+				DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+					CopyAndSumMask32((u32 *)(out + outPitch * y), (const u32 *)(unswizzled + bufw * sizeof(u32) * y), w, rowAlphaSum);
+				});
 			}
 		}
 		break;
@@ -1709,21 +1895,21 @@ CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int l
 	{
 		switch (bytesPerIndex) {
 		case 1:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut16, &alphaSum);
-			}
+			DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+				DeIndexTexture((u16 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut16, rowAlphaSum);
+			});
 			break;
 
 		case 2:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut16, &alphaSum);
-			}
+			DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+				DeIndexTexture((u16 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut16, rowAlphaSum);
+			});
 			break;
 
 		case 4:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut16, &alphaSum);
-			}
+			DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+				DeIndexTexture((u16 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut16, rowAlphaSum);
+			});
 			break;
 		}
 	}
@@ -1734,21 +1920,21 @@ CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int l
 
 		switch (bytesPerIndex) {
 		case 1:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut32, &alphaSum);
-			}
+			DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+				DeIndexTexture((u32 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut32, rowAlphaSum);
+			});
 			break;
 
 		case 2:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut32, &alphaSum);
-			}
+			DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+				DeIndexTexture((u32 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut32, rowAlphaSum);
+			});
 			break;
 
 		case 4:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut32, &alphaSum);
-			}
+			DecodeRows(w, h, &alphaSum, [&](int y, u32 *rowAlphaSum) {
+				DeIndexTexture((u32 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut32, rowAlphaSum);
+			});
 			break;
 		}
 	}
@@ -1767,12 +1953,15 @@ CheckAlphaResult TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int l
 }
 
 void TextureCacheCommon::ApplyTexture() {
+	GPUDrawProfile::Scope profile(GPUDrawProfile::Cost::TEXTURE);
 	TexCacheEntry *entry = nextTexture_;
 	if (!entry) {
 		// Maybe we bound a framebuffer?
 		InvalidateLastTexture();
 		if (nextFramebufferTexture_) {
 			bool depth = Memory::IsDepthTexVRAMAddress(gstate.getTextureAddress(0));
+			if (IsClutFormat(gstate.getTextureFormat()) && !g_Config.bDisableSlowFramebufEffects)
+				gpuStats.cache.depalOps++;
 			// ApplyTextureFrameBuffer is responsible for setting SetTextureFullAlpha.
 			ApplyTextureFramebuffer(nextFramebufferTexture_, gstate.getTextureFormat(), depth ? NOTIFY_FB_DEPTH : NOTIFY_FB_COLOR);
 			nextFramebufferTexture_ = nullptr;
@@ -1813,7 +2002,7 @@ void TextureCacheCommon::ApplyTexture() {
 		// Okay, this matched and didn't change - but let's check the hash.  Maybe it will change.
 		bool doDelete = true;
 		if (!CheckFullHash(entry, doDelete)) {
-			HandleTextureChange(entry, "hash fail", true, doDelete);
+			HandleTextureChange(entry, TextureChangeReason::HASH_FAIL, true, doDelete);
 			nextNeedsRebuild_ = true;
 		} else if (nextTexture_ != nullptr) {
 			// The secondary cache may choose an entry from its storage by setting nextTexture_.
@@ -1827,7 +2016,9 @@ void TextureCacheCommon::ApplyTexture() {
 	// Okay, now actually rebuild the texture if needed.
 	if (nextNeedsRebuild_) {
 		_assert_(!entry->texturePtr);
+		double buildStart = time_now_d();
 		BuildTexture(entry);
+		gpuStats.msTextureDecoding += time_now_d() - buildStart;
 		InvalidateLastTexture();
 	}
 
@@ -1854,6 +2045,7 @@ void TextureCacheCommon::Clear(bool delete_them) {
 		secondCacheSizeEstimate_ = 0;
 	}
 	videos_.clear();
+	upscaled_.Clear();
 }
 
 void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
@@ -1877,7 +2069,23 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	u32 fullhash;
 	{
 		PROFILE_THIS_SCOPE("texhash");
+		double hashStart = time_now_d();
+		const u32 sizeInRAM = (textureBitsPerPixel[entry->format] * entry->bufw * h) / 8;
+		const bool sampled = CanUseSampledHash(entry, sizeInRAM);
+		const u32 sampledhash = sampled ? SampledTexHash(entry, sizeInRAM) : 0;
+		if (sampled && entry->sampledChecksLeft != 0 && sampledhash == entry->sampledhash) {
+			// Probably unchanged, skip the full hash this time.
+			entry->sampledChecksLeft--;
+			gpuStats.numTexturesSampleHashed++;
+			gpuStats.msTextureHashing += time_now_d() - hashStart;
+			return true;
+		}
+
 		fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
+		gpuStats.numTexturesHashed++;
+		entry->sampledhash = sampledhash;
+		entry->sampledChecksLeft = sampled && fullhash == entry->fullhash ? SAMPLED_HASH_CHECKS : 0;
+		gpuStats.msTextureHashing += time_now_d() - hashStart;
 	}
 
 	if (fullhash == entry->fullhash) {
@@ -1946,6 +2154,19 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	return false;
 }
 
+bool TextureCacheCommon::CanUseSampledHash(const TexCacheEntry *entry, u32 sizeInRAM) {
+	// Small textures are cheap enough to hash fully, and frequently changing ones would fail anyway.
+	if (sizeInRAM < SAMPLED_HASH_MIN_BYTES || (entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) != 0)
+		return false;
+	// The replacer has its own hash, and the samples need to be in valid memory.
+	return !replacer_.Enabled() && Memory::IsValidRange(entry->addr, sizeInRAM);
+}
+
+u32 TextureCacheCommon::SampledTexHash(const TexCacheEntry *entry, u32 sizeInRAM) const {
+	gpuStats.numTextureDataBytesHashed += SAMPLED_HASH_SAMPLES * SAMPLED_HASH_SAMPLE_BYTES;
+	return hash::SampledHash(Memory::GetPointerUnchecked(entry->addr), sizeInRAM, SAMPLED_HASH_SAMPLES, SAMPLED_HASH_SAMPLE_BYTES);
+}
+
 void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type) {
 	// They could invalidate inside the texture, let's just give a bit of leeway.
 	// TODO: Keep track of the largest texture size in bytes, and use that instead of this
@@ -1986,6 +2207,8 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 
 		// Quick check for overlap. Yes the check is right.
 		if (addr < texEnd && addr_end > texAddr) {
+			// Samples could easily miss a partial write, so the next check must hash everything.
+			entry->sampledChecksLeft = 0;
 			if (entry->GetHashStatus() == TexCacheEntry::STATUS_RELIABLE) {
 				entry->SetHashStatus(TexCacheEntry::STATUS_HASHING);
 			}
@@ -2042,6 +2265,7 @@ std::string AttachCandidate::ToString() {
 
 bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEntry *entry) {
 	gpuStats.numTexturesDecoded++;
+	gpuStats.cache.textureBytesDecoded += (textureBitsPerPixel[entry->format] * entry->bufw * gstate.getTextureHeight(0)) / 8;
 
 	// For the estimate, we assume cluts always point to 8888 for simplicity.
 	cacheSizeEstimate_ += EstimateTexMemoryUsage(entry);
@@ -2150,6 +2374,23 @@ bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEnt
 		plan.scaleFactor = 1;
 	}
 
+	if (plan.scaleFactor > 1 && !plan.hardwareScaling && upscaled_.BackgroundEnabled() && !IsVideo(entry->addr) && !IsFakeMipmapChange()) {
+		UpscaledTextureKey key{ entry->CacheKey(), entry->fullhash };
+		if (!upscaled_.IsReady(key, plan.scaleFactor)) {
+			// Draw it unscaled for now, and pick up the result in a later frame via STATUS_TO_SCALE.
+			if (!upscaled_.IsPending(key)) {
+				GETextureFormat tfmt = (GETextureFormat)entry->format;
+				u32 texaddr = gstate.getTextureAddress(0);
+				int bufw = GetTextureBufw(0, texaddr, tfmt);
+				tmpTexBufRearrange_.resize(std::max(bufw, plan.w) * plan.h);
+				DecodeTextureLevel((u8 *)tmpTexBufRearrange_.data(), plan.w * 4, tfmt, gstate.getClutPaletteFormat(), texaddr, 0, bufw, plan.reverseColors, true);
+				upscaled_.ScaleInBackground(key, tmpTexBufRearrange_.data(), plan.w, plan.h, plan.scaleFactor);
+			}
+			entry->status |= TexCacheEntry::STATUS_TO_SCALE;
+			plan.scaleFactor = 1;
+		}
+	}
+
 	if (plan.scaleFactor != 1) {
 		if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED && plan.slowScaler) {
 			entry->status |= TexCacheEntry::STATUS_TO_SCALE;
@@ -2196,6 +2437,21 @@ bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEnt
 	return true;
 }
 
+void TextureCacheCommon::ScaleTextureLevel(TexCacheEntry &entry, int srcLevel, u32 *out, u32 *src, int &w, int &h, int scaleFactor) {
+	// Only the base level is cached, the rest are generated or small anyway.
+	if (srcLevel != 0 || !upscaled_.Enabled()) {
+		scaler_.ScaleAlways(out, src, w, h, scaleFactor);
+		return;
+	}
+
+	UpscaledTextureKey key{ entry.CacheKey(), entry.fullhash };
+	if (upscaled_.Lookup(key, out, w, h, scaleFactor))
+		return;
+
+	scaler_.ScaleAlways(out, src, w, h, scaleFactor);
+	upscaled_.Save(key, out, w, h, scaleFactor);
+}
+
 void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, int stride, ReplacedTexture &replaced, int srcLevel, int scaleFactor, Draw::DataFormat dstFmt, bool reverseColors) {
 	int w = gstate.getTextureWidth(srcLevel);
 	int h = gstate.getTextureHeight(srcLevel);
@@ -2230,7 +2486,7 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, i
 
 		if (scaleFactor > 1) {
 			// Note that this updates w and h!
-			scaler_.ScaleAlways((u32 *)data, pixelData, w, h, scaleFactor);
+			ScaleTextureLevel(entry, srcLevel, (u32 *)data, pixelData, w, h, scaleFactor);
 			pixelData = (u32 *)data;
 
 			decPitch = w * 4;
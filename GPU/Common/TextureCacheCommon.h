@@ -25,6 +25,7 @@
 #include "Common/MemoryUtil.h"
 #include "Core/TextureReplacer.h"
 #include "Core/System.h"
+#include "GPU/GPU.h"
 #include "GPU/Common/GPUDebugInterface.h"
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/Common/TextureScalerCommon.h"
@@ -52,6 +53,7 @@ class TextureReplacer;
 
 namespace Draw {
 class DrawContext;
+class Framebuffer;
 }
 
 // Used by D3D11 and Vulkan, could be used by modern GL
@@ -165,6 +167,10 @@ struct TexCacheEntry {
 	u32 framesUntilNextFullHash;
 	u32 fullhash;
 	u32 cluthash;
+	// For large textures, most checks only hash samples.  A full hash happens when the samples
+	// change, when a write overlaps the texture, or when the checks left run out.
+	u32 sampledhash;
+	u8 sampledChecksLeft;
 	u16 maxSeenV;
 
 	TexStatus GetHashStatus() {
@@ -237,6 +243,8 @@ struct BuildTexturePlan {
 	// Inputs
 	bool hardwareScaling = false;
 	bool slowScaler = true;
+	// Must match what the backend passes to LoadTextureLevel(), for background scaling.
+	bool reverseColors = false;
 
 	// Set if the PSP software specified an unusual mip chain,
 	// such as the same size throughout, or anything else that doesn't divide by
@@ -322,10 +330,12 @@ class TextureCacheCommon {
 	virtual void ReleaseTexture(TexCacheEntry *entry, bool delete_them) = 0;
 	void DeleteTexture(TexCache::iterator it);
 	void Decimate(bool forcePressure = false);
+	u32 TextureBudget() const;
+	float EvictionScore(const TexCacheEntry *entry) const;
 
 	virtual void ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer, GETextureFormat texFormat, FramebufferNotificationChannel channel) = 0;
 
-	void HandleTextureChange(TexCacheEntry *const entry, const char *reason, bool initialMatch, bool doDelete);
+	void HandleTextureChange(TexCacheEntry *const entry, TextureChangeReason reason, bool initialMatch, bool doDelete);
 	virtual void BuildTexture(TexCacheEntry *const entry) = 0;
 	virtual void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) = 0;
 	bool CheckFullHash(TexCacheEntry *entry, bool &doDelete);
@@ -337,13 +347,15 @@ class TextureCacheCommon {
 
 	// Return value is mapData normally, but could be another buffer allocated with AllocateAlignedMemory.
 	void LoadTextureLevel(TexCacheEntry &entry, uint8_t *mapData, int mapRowPitch, ReplacedTexture &replaced, int srcLevel, int scaleFactor, Draw::DataFormat dstFmt, bool reverseColors);
+	// Like scaler_.ScaleAlways(), but goes through the upscaled texture cache when enabled. Updates w and h.
+	void ScaleTextureLevel(TexCacheEntry &entry, int srcLevel, u32 *out, u32 *src, int &w, int &h, int scaleFactor);
 
 	template <typename T>
 	inline const T *GetCurrentClut() {
 		return (const T *)clutBuf_;
 	}
 
-	u32 EstimateTexMemoryUsage(const TexCacheEntry *entry);
+	u32 EstimateTexMemoryUsage(const TexCacheEntry *entry) const;
 
 	SamplerCacheKey GetSamplingParams(int maxLevel, const TexCacheEntry *entry);
 	SamplerCacheKey GetFramebufferSamplingParams(u16 bufferWidth, u16 bufferHeight);
@@ -356,6 +368,26 @@ class TextureCacheCommon {
 
 	void SetTextureFramebuffer(const AttachCandidate &candidate);
 
+	// Depal passes (framebuffer textures read through the CLUT) render into temp framebuffers.
+	// The results are reused while the source hasn't been written to and the CLUT is the same.
+	struct DepalResult {
+		VirtualFramebuffer *vfb;
+		Draw::Framebuffer *fbo;
+		u32 writeSeq;
+		u32 clutHash;
+		u32 clutMode;
+		GEBufferFormat format;
+		bool depth;
+		bool fullAlpha;
+		// Converted area of the source, in PSP pixels.
+		int u1, v1, u2, v2;
+		int lastUse;
+	};
+	const DepalResult *FindDepalResult(VirtualFramebuffer *framebuffer, bool depth);
+	// Returns the temp framebuffer to run a depal pass into. The caller fills in fullAlpha.
+	DepalResult *GetDepalTarget(VirtualFramebuffer *framebuffer, bool depth);
+	bool CanReuseDepalResult(VirtualFramebuffer *framebuffer, bool depth) const;
+
 	void DecimateVideos();
 	bool IsVideo(u32 texaddr) const;
 
@@ -380,6 +412,9 @@ class TextureCacheCommon {
 		}
 	}
 
+	bool CanUseSampledHash(const TexCacheEntry *entry, u32 sizeInRAM);
+	u32 SampledTexHash(const TexCacheEntry *entry, u32 sizeInRAM) const;
+
 	static inline u32 MiniHash(const u32 *ptr) {
 		return ptr[0];
 	}
@@ -387,6 +422,7 @@ class TextureCacheCommon {
 	Draw::DrawContext *draw_;
 	TextureReplacer replacer_;
 	TextureScalerCommon scaler_;
+	UpscaledTextureCache upscaled_;
 	FramebufferManagerCommon *framebufferManager_;
 
 	bool clearCacheNextFrame_ = false;
@@ -420,6 +456,10 @@ class TextureCacheCommon {
 
 	u32 clutHash_ = 0;
 
+	enum { MAX_DEPAL_RESULTS = 4 };
+	DepalResult depalResults_[MAX_DEPAL_RESULTS]{};
+	int depalResultUse_ = 0;
+
 	// Raw is where we keep the original bytes.  Converted is where we swap colors if necessary.
 	u32 *clutBufRaw_;
 	u32 *clutBufConverted_;
@@ -437,7 +477,7 @@ class TextureCacheCommon {
 	int standardScaleFactor_;
 	int shaderScaleFactor_ = 0;
 
-	const char *nextChangeReason_;
+	TextureChangeReason nextChangeReason_;
 	bool nextNeedsRehash_;
 	bool nextNeedsChange_;
 	bool nextNeedsRebuild_;
@@ -655,15 +655,15 @@ void DecodeDXT5Block(u32 *dst, const DXT5Block *src, int pitch, int height) {
 
 #ifdef _M_SSE
 inline u32 SSEReduce32And(__m128i value) {
-	// TODO: Should use a shuffle instead of slri, probably.
-	value = _mm_and_si128(value, _mm_srli_si128(value, 64));
-	value = _mm_and_si128(value, _mm_srli_si128(value, 32));
+	// TODO: Should use a shuffle instead of slri, probably.  Note the shift is in bytes.
+	value = _mm_and_si128(value, _mm_srli_si128(value, 8));
+	value = _mm_and_si128(value, _mm_srli_si128(value, 4));
 	return _mm_cvtsi128_si32(value);
 }
 inline u32 SSEReduce16And(__m128i value) {
-	// TODO: Should use a shuffle instead of slri, probably.
-	value = _mm_and_si128(value, _mm_srli_si128(value, 64));
-	value = _mm_and_si128(value, _mm_srli_si128(value, 32));
+	// TODO: Should use a shuffle instead of slri, probably.  Note the shift is in bytes.
+	value = _mm_and_si128(value, _mm_srli_si128(value, 8));
+	value = _mm_and_si128(value, _mm_srli_si128(value, 4));
 	u32 mask = _mm_cvtsi128_si32(value);
 	return mask & (mask >> 16);
 }
@@ -824,3 +824,197 @@ void CheckMask32(const u32 *src, int width, u32 *outMask) {
 	}
 	*outMask &= (u32)mask;
 }
+
+// CLUT4 only has 16 entries, so each byte of the palette fits in one 16 byte shuffle table.
+// We look up 16 texels at a time, once per byte of the color, and interleave the results.
+#ifdef _M_SSE
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("ssse3")]]
+#endif
+static int DeIndexTexture4Clut16SSSE3(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	alignas(16) u8 planes[2][16];
+	for (int i = 0; i < 16; ++i) {
+		planes[0][i] = clut[i] & 0xFF;
+		planes[1][i] = clut[i] >> 8;
+	}
+	const __m128i lowTable = _mm_load_si128((const __m128i *)planes[0]);
+	const __m128i highTable = _mm_load_si128((const __m128i *)planes[1]);
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+	__m128i wideMask = _mm_set1_epi32(0xFFFFFFFF);
+	int i = 0;
+	for (; i + 16 <= length; i += 16) {
+		const __m128i packed = _mm_loadl_epi64((const __m128i *)(indexed + i / 2));
+		// The low nibble is the first texel of each byte.
+		const __m128i lowNibbles = _mm_and_si128(packed, nibbleMask);
+		const __m128i highNibbles = _mm_and_si128(_mm_srli_epi16(packed, 4), nibbleMask);
+		const __m128i indices = _mm_unpacklo_epi8(lowNibbles, highNibbles);
+
+		const __m128i low = _mm_shuffle_epi8(lowTable, indices);
+		const __m128i high = _mm_shuffle_epi8(highTable, indices);
+		const __m128i colors0 = _mm_unpacklo_epi8(low, high);
+		const __m128i colors1 = _mm_unpackhi_epi8(low, high);
+		_mm_storeu_si128((__m128i *)(dest + i), colors0);
+		_mm_storeu_si128((__m128i *)(dest + i + 8), colors1);
+		wideMask = _mm_and_si128(wideMask, _mm_and_si128(colors0, colors1));
+	}
+
+	*outAlphaSum &= SSEReduce16And(wideMask);
+	return i;
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("ssse3")]]
+#endif
+static int DeIndexTexture4Clut32SSSE3(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	alignas(16) u8 planes[4][16];
+	for (int i = 0; i < 16; ++i) {
+		for (int b = 0; b < 4; ++b) {
+			planes[b][i] = (clut[i] >> (b * 8)) & 0xFF;
+		}
+	}
+	const __m128i table0 = _mm_load_si128((const __m128i *)planes[0]);
+	const __m128i table1 = _mm_load_si128((const __m128i *)planes[1]);
+	const __m128i table2 = _mm_load_si128((const __m128i *)planes[2]);
+	const __m128i table3 = _mm_load_si128((const __m128i *)planes[3]);
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+	__m128i wideMask = _mm_set1_epi32(0xFFFFFFFF);
+	int i = 0;
+	for (; i + 16 <= length; i += 16) {
+		const __m128i packed = _mm_loadl_epi64((const __m128i *)(indexed + i / 2));
+		const __m128i lowNibbles = _mm_and_si128(packed, nibbleMask);
+		const __m128i highNibbles = _mm_and_si128(_mm_srli_epi16(packed, 4), nibbleMask);
+		const __m128i indices = _mm_unpacklo_epi8(lowNibbles, highNibbles);
+
+		const __m128i b0 = _mm_shuffle_epi8(table0, indices);
+		const __m128i b1 = _mm_shuffle_epi8(table1, indices);
+		const __m128i b2 = _mm_shuffle_epi8(table2, indices);
+		const __m128i b3 = _mm_shuffle_epi8(table3, indices);
+		const __m128i b01Low = _mm_unpacklo_epi8(b0, b1);
+		const __m128i b01High = _mm_unpackhi_epi8(b0, b1);
+		const __m128i b23Low = _mm_unpacklo_epi8(b2, b3);
+		const __m128i b23High = _mm_unpackhi_epi8(b2, b3);
+
+		const __m128i colors0 = _mm_unpacklo_epi16(b01Low, b23Low);
+		const __m128i colors1 = _mm_unpackhi_epi16(b01Low, b23Low);
+		const __m128i colors2 = _mm_unpacklo_epi16(b01High, b23High);
+		const __m128i colors3 = _mm_unpackhi_epi16(b01High, b23High);
+		_mm_storeu_si128((__m128i *)(dest + i + 0), colors0);
+		_mm_storeu_si128((__m128i *)(dest + i + 4), colors1);
+		_mm_storeu_si128((__m128i *)(dest + i + 8), colors2);
+		_mm_storeu_si128((__m128i *)(dest + i + 12), colors3);
+		wideMask = _mm_and_si128(wideMask, _mm_and_si128(_mm_and_si128(colors0, colors1), _mm_and_si128(colors2, colors3)));
+	}
+
+	*outAlphaSum &= SSEReduce32And(wideMask);
+	return i;
+}
+
+#elif PPSSPP_ARCH(ARM64) && PPSSPP_ARCH(ARM_NEON)
+
+static inline u32 NEONReduce8And(uint8x16_t value) {
+	uint64x2_t value64 = vreinterpretq_u64_u8(value);
+	u64 mask = vgetq_lane_u64(value64, 0) & vgetq_lane_u64(value64, 1);
+	mask &= mask >> 32;
+	mask &= mask >> 16;
+	mask &= mask >> 8;
+	return (u32)(mask & 0xFF);
+}
+
+static int DeIndexTexture4Clut16NEON(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	alignas(16) u8 planes[2][16];
+	for (int i = 0; i < 16; ++i) {
+		planes[0][i] = clut[i] & 0xFF;
+		planes[1][i] = clut[i] >> 8;
+	}
+	const uint8x16_t lowTable = vld1q_u8(planes[0]);
+	const uint8x16_t highTable = vld1q_u8(planes[1]);
+
+	uint8x16_t lowMask = vdupq_n_u8(0xFF);
+	uint8x16_t highMask = vdupq_n_u8(0xFF);
+	int i = 0;
+	for (; i + 16 <= length; i += 16) {
+		const uint8x8_t packed = vld1_u8(indexed + i / 2);
+		// The low nibble is the first texel of each byte.
+		const uint8x8x2_t nibbles = vzip_u8(vand_u8(packed, vdup_n_u8(0x0F)), vshr_n_u8(packed, 4));
+		const uint8x16_t indices = vcombine_u8(nibbles.val[0], nibbles.val[1]);
+
+		uint8x16x2_t colors;
+		colors.val[0] = vqtbl1q_u8(lowTable, indices);
+		colors.val[1] = vqtbl1q_u8(highTable, indices);
+		vst2q_u8((u8 *)(dest + i), colors);
+		lowMask = vandq_u8(lowMask, colors.val[0]);
+		highMask = vandq_u8(highMask, colors.val[1]);
+	}
+
+	*outAlphaSum &= NEONReduce8And(lowMask) | (NEONReduce8And(highMask) << 8);
+	return i;
+}
+
+static int DeIndexTexture4Clut32NEON(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	alignas(16) u8 planes[4][16];
+	for (int i = 0; i < 16; ++i) {
+		for (int b = 0; b < 4; ++b) {
+			planes[b][i] = (clut[i] >> (b * 8)) & 0xFF;
+		}
+	}
+	uint8x16_t tables[4];
+	uint8x16_t masks[4];
+	for (int b = 0; b < 4; ++b) {
+		tables[b] = vld1q_u8(planes[b]);
+		masks[b] = vdupq_n_u8(0xFF);
+	}
+
+	int i = 0;
+	for (; i + 16 <= length; i += 16) {
+		const uint8x8_t packed = vld1_u8(indexed + i / 2);
+		const uint8x8x2_t nibbles = vzip_u8(vand_u8(packed, vdup_n_u8(0x0F)), vshr_n_u8(packed, 4));
+		const uint8x16_t indices = vcombine_u8(nibbles.val[0], nibbles.val[1]);
+
+		uint8x16x4_t colors;
+		for (int b = 0; b < 4; ++b) {
+			colors.val[b] = vqtbl1q_u8(tables[b], indices);
+			masks[b] = vandq_u8(masks[b], colors.val[b]);
+		}
+		vst4q_u8((u8 *)(dest + i), colors);
+	}
+
+	u32 mask = 0;
+	for (int b = 0; b < 4; ++b) {
+		mask |= NEONReduce8And(masks[b]) << (b * 8);
+	}
+	*outAlphaSum &= mask;
+	return i;
+}
+
+#endif
+
+void DeIndexTexture4Clut16(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	int done = 0;
+	if (gstate.isClutIndexSimple()) {
+#ifdef _M_SSE
+		if (cpu_info.bSSSE3)
+			done = DeIndexTexture4Clut16SSSE3(dest, indexed, length, clut, outAlphaSum);
+#elif PPSSPP_ARCH(ARM64) && PPSSPP_ARCH(ARM_NEON)
+		done = DeIndexTexture4Clut16NEON(dest, indexed, length, clut, outAlphaSum);
+#endif
+	}
+	if (done < length)
+		DeIndexTexture4<u16>(dest + done, indexed + done / 2, length - done, clut, outAlphaSum);
+}
+
+void DeIndexTexture4Clut32(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	int done = 0;
+	if (gstate.isClutIndexSimple()) {
+#ifdef _M_SSE
+		if (cpu_info.bSSSE3)
+			done = DeIndexTexture4Clut32SSSE3(dest, indexed, length, clut, outAlphaSum);
+#elif PPSSPP_ARCH(ARM64) && PPSSPP_ARCH(ARM_NEON)
+		done = DeIndexTexture4Clut32NEON(dest, indexed, length, clut, outAlphaSum);
+#endif
+	}
+	if (done < length)
+		DeIndexTexture4<u32>(dest + done, indexed + done / 2, length - done, clut, outAlphaSum);
+}
@@ -185,6 +185,11 @@ inline void DeIndexTexture4(/*WRITEONLY*/ ClutT *dest, const u8 *indexed, int le
 	*outAlphaSum &= (u32)alphaSum;
 }
 
+// Same results as DeIndexTexture4, but looks up 16 texels at a time with byte shuffles when the
+// CPU can (SSSE3 or ARM64.)  The alpha check is done on the same registers.
+void DeIndexTexture4Clut16(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum);
+void DeIndexTexture4Clut32(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum);
+
 template <typename ClutT>
 inline void DeIndexTexture4Optimal(ClutT *dest, const u8 *indexed, int length, ClutT color) {
 	for (int i = 0; i < length; i += 2) {
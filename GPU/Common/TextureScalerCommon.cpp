@@ -23,12 +23,17 @@
 #include "GPU/Common/TextureScalerCommon.h"
 
 #include "Core/Config.h"
+#include "Core/Instance.h"
 #include "Common/Common.h"
 #include "Common/Log.h"
 #include "Common/CommonFuncs.h"
 #include "Common/Thread/ParallelLoop.h"
 #include "Core/ThreadPools.h"
 #include "Common/CPUDetect.h"
+#include "Common/StringUtils.h"
+#include "Common/File/DirListing.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "ext/xbrz/xbrz.h"
 
 #if defined(_M_SSE)
@@ -656,3 +661,273 @@ void TextureScalerCommon::DePosterize(u32* source, u32* dest, int width, int hei
 	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, dest, bufTmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
 	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, bufTmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
 }
+
+// Files are raw 8888 pixels after this header, in the native byte order of the writer.
+struct UpscaledTextureHeader {
+	u32 magic;
+	u32 version;
+	u32 width;
+	u32 height;
+};
+
+static const u32 UPSCALED_TEXTURE_MAGIC = 0x58455455;  // "UTEX"
+static const u32 UPSCALED_TEXTURE_VERSION = 1;
+
+UpscaledTextureCache::~UpscaledTextureCache() {
+	StopThread();
+}
+
+void UpscaledTextureCache::NotifyConfigChanged(const Path &diskPath, bool background) {
+	StopThread();
+
+	std::lock_guard<std::mutex> guard(lock_);
+	jobs_.clear();
+	pending_.clear();
+	results_.clear();
+	resultOrder_.clear();
+	resultBytes_ = 0;
+	onDisk_.clear();
+
+	diskPath_ = diskPath;
+	background_ = background;
+	sharedWithPeers_ = GetInstancePeerCount() > 1;
+
+	if (!diskPath_.empty()) {
+		std::vector<File::FileInfo> files;
+		File::GetFilesInDir(diskPath_, &files, "utex");
+		for (const auto &file : files)
+			onDisk_.insert(file.name);
+	}
+
+	if (Enabled())
+		StartThread();
+}
+
+void UpscaledTextureCache::Clear() {
+	std::lock_guard<std::mutex> guard(lock_);
+	// The write jobs are still worth finishing.
+	for (auto it = jobs_.begin(); it != jobs_.end(); ) {
+		if (it->scale) {
+			pending_.erase(it->key);
+			it = jobs_.erase(it);
+		} else {
+			++it;
+		}
+	}
+	results_.clear();
+	resultOrder_.clear();
+	resultBytes_ = 0;
+}
+
+std::string UpscaledTextureCache::Filename(const UpscaledTextureKey &key, int factor) const {
+	return StringFromFormat("%016llx%08x_%dx.utex", (unsigned long long)key.cachekey, key.fullhash, factor);
+}
+
+bool UpscaledTextureCache::IsReady(const UpscaledTextureKey &key, int factor) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto it = results_.find(key);
+	if (it != results_.end() && it->second.factor == factor)
+		return true;
+	return !diskPath_.empty() && IsOnDisk(Filename(key, factor));
+}
+
+bool UpscaledTextureCache::IsPending(const UpscaledTextureKey &key) {
+	std::lock_guard<std::mutex> guard(lock_);
+	return pending_.count(key) != 0;
+}
+
+bool UpscaledTextureCache::Lookup(const UpscaledTextureKey &key, u32 *out, int &width, int &height, int factor) {
+	std::string filename;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = results_.find(key);
+		if (it != results_.end()) {
+			Result &result = it->second;
+			bool match = result.factor == factor && result.width == width * factor && result.height == height * factor;
+			if (match) {
+				memcpy(out, result.pixels.data(), result.pixels.size() * sizeof(u32));
+				width = result.width;
+				height = result.height;
+			}
+			// Either way, it's not going to be asked for again.
+			resultBytes_ -= result.pixels.size() * sizeof(u32);
+			results_.erase(it);
+			resultOrder_.erase(std::remove_if(resultOrder_.begin(), resultOrder_.end(), [&](const UpscaledTextureKey &k) {
+				return !(k < key) && !(key < k);
+			}), resultOrder_.end());
+			if (match)
+				return true;
+		}
+
+		if (diskPath_.empty())
+			return false;
+		filename = Filename(key, factor);
+		if (!IsOnDisk(filename))
+			return false;
+	}
+
+	// The pixels go straight into the destination, so there's nothing to gain from mapping the file.
+	if (!ReadFromDisk(filename, out, width * factor, height * factor)) {
+		std::lock_guard<std::mutex> guard(lock_);
+		onDisk_.erase(filename);
+		return false;
+	}
+	width *= factor;
+	height *= factor;
+	return true;
+}
+
+void UpscaledTextureCache::ScaleInBackground(const UpscaledTextureKey &key, const u32 *src, int width, int height, int factor) {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (!background_ || pending_.count(key))
+		return;
+
+	Job job;
+	job.key = key;
+	job.pixels.assign(src, src + width * height);
+	job.width = width;
+	job.height = height;
+	job.factor = factor;
+	job.scale = true;
+	jobs_.push_back(std::move(job));
+	pending_.insert(key);
+	wake_.notify_one();
+}
+
+void UpscaledTextureCache::Save(const UpscaledTextureKey &key, const u32 *data, int width, int height, int factor) {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (diskPath_.empty())
+		return;
+	std::string filename = Filename(key, factor);
+	if (onDisk_.count(filename))
+		return;
+
+	Job job;
+	job.key = key;
+	job.pixels.assign(data, data + width * height);
+	job.width = width;
+	job.height = height;
+	job.factor = factor;
+	job.scale = false;
+	jobs_.push_back(std::move(job));
+	// Claim it now, so the same texture isn't queued twice.
+	onDisk_.insert(filename);
+	wake_.notify_one();
+}
+
+void UpscaledTextureCache::StartThread() {
+	_assert_(thread_ == nullptr);
+	quit_ = false;
+	if (!diskPath_.empty())
+		File::CreateFullPath(diskPath_);
+	thread_ = new std::thread([this] { ThreadFunc(); });
+}
+
+void UpscaledTextureCache::StopThread() {
+	if (!thread_)
+		return;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		quit_ = true;
+		wake_.notify_one();
+	}
+	thread_->join();
+	delete thread_;
+	thread_ = nullptr;
+}
+
+void UpscaledTextureCache::ThreadFunc() {
+	SetCurrentThreadName("TexScaler");
+
+	std::unique_lock<std::mutex> guard(lock_);
+	while (true) {
+		wake_.wait(guard, [this] { return quit_ || !jobs_.empty(); });
+		if (quit_)
+			break;
+
+		Job job = std::move(jobs_.front());
+		jobs_.pop_front();
+		guard.unlock();
+
+		Result result;
+		if (job.scale) {
+			result.width = job.width;
+			result.height = job.height;
+			result.factor = job.factor;
+			result.pixels.resize(job.width * job.height * job.factor * job.factor);
+			scaler_.ScaleAlways(result.pixels.data(), job.pixels.data(), result.width, result.height, job.factor);
+			if (!diskPath_.empty())
+				WriteToDisk(Filename(job.key, job.factor), result.pixels.data(), result.width, result.height);
+		} else {
+			WriteToDisk(Filename(job.key, job.factor), job.pixels.data(), job.width, job.height);
+		}
+
+		guard.lock();
+		if (!job.scale)
+			continue;
+		if (!diskPath_.empty())
+			onDisk_.insert(Filename(job.key, job.factor));
+		// Clear() may have dropped it while we were working.
+		if (!pending_.erase(job.key))
+			continue;
+
+		resultBytes_ += result.pixels.size() * sizeof(u32);
+		results_[job.key] = std::move(result);
+		resultOrder_.push_back(job.key);
+		while (resultBytes_ > MAX_RESULT_BYTES && resultOrder_.size() > 1) {
+			auto it = results_.find(resultOrder_.front());
+			if (it != results_.end()) {
+				resultBytes_ -= it->second.pixels.size() * sizeof(u32);
+				results_.erase(it);
+			}
+			resultOrder_.pop_front();
+		}
+	}
+}
+
+bool UpscaledTextureCache::ReadFromDisk(const std::string &filename, u32 *out, int width, int height) {
+	FILE *f = File::OpenCFile(diskPath_ / filename, "rb");
+	if (!f)
+		return false;
+
+	UpscaledTextureHeader header{};
+	bool success = fread(&header, sizeof(header), 1, f) == 1;
+	success = success && header.magic == UPSCALED_TEXTURE_MAGIC && header.version == UPSCALED_TEXTURE_VERSION;
+	success = success && header.width == (u32)width && header.height == (u32)height;
+	success = success && fread(out, sizeof(u32) * width, height, f) == (size_t)height;
+	fclose(f);
+
+	if (!success)
+		WARN_LOG(G3D, "Discarding bad upscaled texture cache file %s", filename.c_str());
+	return success;
+}
+
+void UpscaledTextureCache::WriteToDisk(const std::string &filename, const u32 *data, int width, int height) {
+	Path tempPath = GetInstanceTempPath(diskPath_ / filename);
+	FILE *f = File::OpenCFile(tempPath, "wb");
+	if (!f)
+		return;
+
+	UpscaledTextureHeader header{ UPSCALED_TEXTURE_MAGIC, UPSCALED_TEXTURE_VERSION, (u32)width, (u32)height };
+	bool success = fwrite(&header, sizeof(header), 1, f) == 1;
+	success = success && fwrite(data, sizeof(u32) * width, height, f) == (size_t)height;
+	fclose(f);
+
+	if (!success) {
+		// Likely out of space, don't leave a truncated file behind.
+		File::Delete(tempPath);
+	} else {
+		CommitInstanceTempFile(tempPath, diskPath_ / filename);
+	}
+}
+
+bool UpscaledTextureCache::IsOnDisk(const std::string &filename) {
+	if (onDisk_.count(filename))
+		return true;
+	// Another instance may have scaled it since we listed the directory.
+	if (sharedWithPeers_ && File::Exists(diskPath_ / filename)) {
+		onDisk_.insert(filename);
+		return true;
+	}
+	return false;
+}
@@ -17,8 +17,18 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
+#include "Common/File/Path.h"
 
 static const int MIN_TEXSCALE_LINES_PER_THREAD = 4;
 
@@ -52,3 +62,89 @@ class TextureScalerCommon {
 	// of course, scaling factor 5 is totally silly anyway
 	SimpleBuf<u32> bufDeposter, bufOutput, bufTmp1, bufTmp2, bufTmp3;
 };
+
+// Identifies the upscaled base level of a texture cache entry.
+struct UpscaledTextureKey {
+	u64 cachekey;
+	u32 fullhash;
+
+	bool operator <(const UpscaledTextureKey &other) const {
+		if (cachekey != other.cachekey)
+			return cachekey < other.cachekey;
+		return fullhash < other.fullhash;
+	}
+};
+
+// Keeps upscaled textures so they don't need to be scaled again: on disk across sessions, and in
+// memory for textures scaled on the worker thread until the texture cache picks them up.
+// The scaler settings are part of the disk path, see TextureCacheCommon::NotifyConfigChanged().
+class UpscaledTextureCache {
+public:
+	~UpscaledTextureCache();
+
+	// An empty diskPath disables the disk cache.
+	void NotifyConfigChanged(const Path &diskPath, bool background);
+	// Forgets queued jobs and results that weren't picked up yet. The disk cache stays.
+	void Clear();
+
+	bool Enabled() const { return !diskPath_.empty() || background_; }
+	bool BackgroundEnabled() const { return background_; }
+
+	// On success, fills out with the texture scaled by factor, and updates width and height.
+	bool Lookup(const UpscaledTextureKey &key, u32 *out, int &width, int &height, int factor);
+	// Whether Lookup() would likely succeed, without reading anything.
+	bool IsReady(const UpscaledTextureKey &key, int factor);
+	bool IsPending(const UpscaledTextureKey &key);
+
+	// Copies the unscaled 8888 pixels and scales them on the worker thread.
+	void ScaleInBackground(const UpscaledTextureKey &key, const u32 *src, int width, int height, int factor);
+	// Queues an already scaled texture to be written to the disk cache.
+	void Save(const UpscaledTextureKey &key, const u32 *data, int width, int height, int factor);
+
+private:
+	struct Job {
+		UpscaledTextureKey key;
+		std::vector<u32> pixels;
+		int width;
+		int height;
+		int factor;
+		bool scale;
+	};
+	struct Result {
+		std::vector<u32> pixels;
+		int width;
+		int height;
+		int factor;
+	};
+
+	void StartThread();
+	void StopThread();
+	void ThreadFunc();
+	std::string Filename(const UpscaledTextureKey &key, int factor) const;
+	bool ReadFromDisk(const std::string &filename, u32 *out, int width, int height);
+	void WriteToDisk(const std::string &filename, const u32 *data, int width, int height);
+	// Call with lock_ held.
+	bool IsOnDisk(const std::string &filename);
+
+	// Finished background results are dropped oldest first past this.
+	enum { MAX_RESULT_BYTES = 64 * 1024 * 1024 };
+
+	Path diskPath_;
+	bool background_ = false;
+	bool sharedWithPeers_ = false;
+
+	// Only used on the worker thread, it has its own scratch buffers.
+	TextureScalerCommon scaler_;
+
+	std::thread *thread_ = nullptr;
+	std::mutex lock_;
+	std::condition_variable wake_;
+	bool quit_ = false;
+	std::deque<Job> jobs_;
+	std::set<UpscaledTextureKey> pending_;
+	std::map<UpscaledTextureKey, Result> results_;
+	std::deque<UpscaledTextureKey> resultOrder_;
+	size_t resultBytes_ = 0;
+	// Filenames in diskPath_, so misses don't hit the filesystem.
+	std::set<std::string> onDisk_;
+};
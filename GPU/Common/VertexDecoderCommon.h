@@ -696,6 +696,9 @@ class VertexDecoderJitCache : public VERTEXDECODER_JIT_BACKEND {
 	void Jit_AnyS8Morph(int srcoff, int dstoff);
 	void Jit_AnyS16Morph(int srcoff, int dstoff);
 	void Jit_AnyFloatMorph(int srcoff, int dstoff);
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	void Jit_SkinMatrixAVX(Gen::X64Reg weightBase, int weightOff);
+#endif
 
 	const VertexDecoder *dec_;
 #if PPSSPP_ARCH(ARM64)
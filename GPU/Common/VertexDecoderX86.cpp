@@ -28,7 +28,9 @@
 
 // We start out by converting the active matrices into 4x4 which are easier to multiply with
 // using SSE / NEON and store them here.
-alignas(16) static float bones[16 * 8];
+alignas(32) static float bones[16 * 8];
+// Converted weights, for the AVX skinning path to broadcast from.
+alignas(16) static float skinWeights[8];
 
 using namespace Gen;
 
@@ -507,6 +509,15 @@ void VertexDecoderJitCache::Jit_WeightsU8Skin() {
 			MULPS(XMM9, MatR(tempReg1));
 	}
 
+	if (cpu_info.bAVX) {
+		MOV(PTRBITS, R(tempReg1), ImmPtr(&skinWeights));
+		MOVAPS(MatR(tempReg1), XMM8);
+		if (dec_->nweights > 4)
+			MOVAPS(MDisp(tempReg1, 16), XMM9);
+		Jit_SkinMatrixAVX(tempReg1, 0);
+		return;
+	}
+
 	auto weightToAllLanes = [this](X64Reg dst, int lane) {
 		X64Reg src = lane < 4 ? XMM8 : XMM9;
 		if (dst != INVALID_REG && dst != src) {
@@ -621,6 +632,15 @@ void VertexDecoderJitCache::Jit_WeightsU16Skin() {
 			MULPS(XMM9, MatR(tempReg1));
 	}
 
+	if (cpu_info.bAVX) {
+		MOV(PTRBITS, R(tempReg1), ImmPtr(&skinWeights));
+		MOVAPS(MatR(tempReg1), XMM8);
+		if (dec_->nweights > 4)
+			MOVAPS(MDisp(tempReg1, 16), XMM9);
+		Jit_SkinMatrixAVX(tempReg1, 0);
+		return;
+	}
+
 	auto weightToAllLanes = [this](X64Reg dst, int lane) {
 		X64Reg src = lane < 4 ? XMM8 : XMM9;
 		if (dst != INVALID_REG && dst != src) {
@@ -692,6 +712,10 @@ void VertexDecoderJitCache::Jit_WeightsU16Skin() {
 
 void VertexDecoderJitCache::Jit_WeightsFloatSkin() {
 	MOV(PTRBITS, R(tempReg2), ImmPtr(&bones));
+	if (cpu_info.bAVX) {
+		Jit_SkinMatrixAVX(srcReg, dec_->weightoff);
+		return;
+	}
 	for (int j = 0; j < dec_->nweights; j++) {
 		MOVSS(XMM1, MDisp(srcReg, dec_->weightoff + j * 4));
 		SHUFPS(XMM1, R(XMM1), _MM_SHUFFLE(0, 0, 0, 0));
@@ -722,6 +746,28 @@ void VertexDecoderJitCache::Jit_WeightsFloatSkin() {
 	}
 }
 
+// Blends the bone matrices (tempReg2 = bones) into XMM4-XMM7 like the SSE paths, but two columns
+// at a time in 256-bit registers.  Same adds and muls in the same order, so the result is identical.
+void VertexDecoderJitCache::Jit_SkinMatrixAVX(X64Reg weightBase, int weightOff) {
+	for (int j = 0; j < dec_->nweights; j++) {
+		VBROADCASTSS(256, XMM1, MDisp(weightBase, weightOff + j * 4));
+		if (j == 0) {
+			VMULPS(256, XMM4, XMM1, MDisp(tempReg2, 0));
+			VMULPS(256, XMM6, XMM1, MDisp(tempReg2, 32));
+		} else {
+			VMULPS(256, XMM2, XMM1, MDisp(tempReg2, 0));
+			VMULPS(256, XMM3, XMM1, MDisp(tempReg2, 32));
+			VADDPS(256, XMM4, XMM4, R(XMM2));
+			VADDPS(256, XMM6, XMM6, R(XMM3));
+		}
+		ADD(PTRBITS, R(tempReg2), Imm8(4 * 16));
+	}
+	// Split out the odd columns, and get out of 256-bit mode before any more SSE code.
+	VEXTRACTF128(R(XMM5), XMM4, 1);
+	VEXTRACTF128(R(XMM7), XMM6, 1);
+	VZEROUPPER();
+}
+
 void VertexDecoderJitCache::Jit_TcU8ToFloat() {
 	Jit_AnyU8ToFloat(dec_->tcoff, 16);
 	MOVQ_xmm(MDisp(dstReg, dec_->decFmt.uvoff), XMM3);
@@ -189,7 +189,7 @@ bool GenerateVertexShader(const VShaderID &id, char *buffer, const ShaderLanguag
 			*errorString = "Invalid flags - tess requires normal.";
 			return false;
 		}
-		if (compat.shaderLanguage == HLSL_D3D9 || compat.texelFetch == nullptr) {
+		if (compat.shaderLanguage != HLSL_D3D9 && compat.texelFetch == nullptr) {
 			*errorString = "Tess not supported on this shader language version";
 			return false;
 		}
@@ -626,7 +626,16 @@ bool GenerateVertexShader(const VShaderID &id, char *buffer, const ShaderLanguag
 			WRITE(p, "StructuredBuffer<TessWeight> tess_weights_u : register(t1);\n");
 			WRITE(p, "StructuredBuffer<TessWeight> tess_weights_v : register(t2);\n");
 		} else if (compat.shaderLanguage == HLSL_D3D9) {
-
+			// No texelFetch in SM3, so we sample point-filtered float textures at texel centers.
+			WRITE(p, "sampler2D u_tess_points : register(s0);\n");
+			WRITE(p, "sampler2D u_tess_weights_u : register(s1);\n");
+			WRITE(p, "sampler2D u_tess_weights_v : register(s2);\n");
+			WRITE(p, "vec4 u_tess_params : register(c%i);\n", CONST_VS_TESS_PARAMS);  // x = spline count, yz = 1 / points size
+			WRITE(p, "vec4 u_tess_weight_params : register(c%i);\n", CONST_VS_TESS_WEIGHT_PARAMS);  // x = 1 / weights_u width, y = 1 / weights_v width
+
+			WRITE(p, "vec4 tess_fetch(sampler2D tex, vec2 texel, vec2 invSize) {\n");
+			WRITE(p, "  return tex2Dlod(tex, vec4((texel + 0.5) * invSize, 0.0, 0.0));\n");
+			WRITE(p, "}\n");
 		}
 
 		const char *init[3] = { "0.0, 0.0", "0.0, 0.0, 0.0", "0.0, 0.0, 0.0, 0.0" };
@@ -694,6 +703,23 @@ bool GenerateVertexShader(const VShaderID &id, char *buffer, const ShaderLanguag
 			WRITE(p, "  vec4 basis_v = tess_weights_v[weight_idx.y].basis;\n");
 			WRITE(p, "  mat4 basis = outerProduct(basis_u, basis_v);\n");
 
+		} else if (compat.shaderLanguage == HLSL_D3D9) {
+			WRITE(p, "  vec2 index;\n");
+			for (int i = 0; i < 4; i++) {
+				for (int j = 0; j < 4; j++) {
+					WRITE(p, "  index = vec2(%i + point_pos.x, %i + point_pos.y);\n", j, i);
+					WRITE(p, "  _pos[%i] = tess_fetch(u_tess_points, index, u_tess_params.yz).xyz;\n", i * 4 + j);
+					if (doTexture && hasTexcoordTess)
+						WRITE(p, "  _tex[%i] = tess_fetch(u_tess_points, index + vec2(u_tess_params.x, 0.0), u_tess_params.yz).xy;\n", i * 4 + j);
+					if (hasColorTess)
+						WRITE(p, "  _col[%i] = tess_fetch(u_tess_points, index + vec2(u_tess_params.x * 2.0, 0.0), u_tess_params.yz).rgba;\n", i * 4 + j);
+				}
+			}
+
+			// Basis polynomials as weight coefficients
+			WRITE(p, "  vec4 basis_u = tess_fetch(u_tess_weights_u, vec2(weight_idx.x * 2, 0), vec2(u_tess_weight_params.x, 1.0));\n");
+			WRITE(p, "  vec4 basis_v = tess_fetch(u_tess_weights_v, vec2(weight_idx.y * 2, 0), vec2(u_tess_weight_params.y, 1.0));\n");
+			WRITE(p, "  mat4 basis = outerProduct(basis_u, basis_v);\n");
 		} else {
 			WRITE(p, "  int index_u, index_v;\n");
 			for (int i = 0; i < 4; i++) {
@@ -731,6 +757,9 @@ bool GenerateVertexShader(const VShaderID &id, char *buffer, const ShaderLanguag
 				// Derivatives as weight coefficients
 				WRITE(p, "  vec4 deriv_u = tess_weights_u[weight_idx.x].deriv;\n");
 				WRITE(p, "  vec4 deriv_v = tess_weights_v[weight_idx.y].deriv;\n");
+			} else if (compat.shaderLanguage == HLSL_D3D9) {
+				WRITE(p, "  vec4 deriv_u = tess_fetch(u_tess_weights_u, vec2(weight_idx.x * 2 + 1, 0), vec2(u_tess_weight_params.x, 1.0));\n");
+				WRITE(p, "  vec4 deriv_v = tess_fetch(u_tess_weights_v, vec2(weight_idx.y * 2 + 1, 0), vec2(u_tess_weight_params.y, 1.0));\n");
 			} else {
 				// Derivatives as weight coefficients
 				WRITE(p, "  vec4 deriv_u = %s(u_tess_weights_u, %s, 0);\n", compat.texelFetch, "ivec2(weight_idx.x * 2 + 1, 0)");
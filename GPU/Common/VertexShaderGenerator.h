@@ -61,4 +61,6 @@ enum {
 	CONST_VS_CULLRANGEMIN = 80,
 	CONST_VS_CULLRANGEMAX = 81,
 	CONST_VS_ROTATION = 82,
+	CONST_VS_TESS_PARAMS = 83,
+	CONST_VS_TESS_WEIGHT_PARAMS = 84,
 };
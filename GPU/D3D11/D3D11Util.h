@@ -46,6 +46,12 @@ class PushBufferD3D11 {
 		nextMapDiscard_ = true;
 	}
 
+	// Whether size more bytes fit before the buffer wraps.
+	bool HasSpace(size_t size, int align = 16) const {
+		size_t pos = (pos_ + align - 1) & ~(size_t)(align - 1);
+		return !nextMapDiscard_ && pos + size <= size_;
+	}
+
 	uint8_t *BeginPush(ID3D11DeviceContext *context, UINT *offset, size_t size, int align = 16) {
 		D3D11_MAPPED_SUBRESOURCE map;
 		pos_ = (pos_ + align - 1) & ~(align - 1);
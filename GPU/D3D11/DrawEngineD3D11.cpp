@@ -771,10 +771,14 @@ void TessellationDataTransferD3D11::SendDataToShader(const SimpleVertex *const *
 		device_->CreateBuffer(&desc, nullptr, &buf[1]);
 		device_->CreateShaderResourceView(buf[1], nullptr, &view[1]);
 		context_->VSSetShaderResources(1, 1, &view[1]);
+		prevWeightsU = nullptr;
+	}
+	if (prevWeightsU != weights.u) {
+		prevWeightsU = weights.u;
+		context_->Map(buf[1], 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
+		memcpy(map.pData, weights.u, weights.size_u * sizeof(Weight));
+		context_->Unmap(buf[1], 0);
 	}
-	context_->Map(buf[1], 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
-	memcpy(map.pData, weights.u, weights.size_u * sizeof(Weight));
-	context_->Unmap(buf[1], 0);
 
 	// Weights V
 	if (prevSizeWV < weights.size_v) {
@@ -787,8 +791,12 @@ void TessellationDataTransferD3D11::SendDataToShader(const SimpleVertex *const *
 		device_->CreateBuffer(&desc, nullptr, &buf[2]);
 		device_->CreateShaderResourceView(buf[2], nullptr, &view[2]);
 		context_->VSSetShaderResources(2, 1, &view[2]);
+		prevWeightsV = nullptr;
+	}
+	if (prevWeightsV != weights.v) {
+		prevWeightsV = weights.v;
+		context_->Map(buf[2], 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
+		memcpy(map.pData, weights.v, weights.size_v * sizeof(Weight));
+		context_->Unmap(buf[2], 0);
 	}
-	context_->Map(buf[2], 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
-	memcpy(map.pData, weights.v, weights.size_v * sizeof(Weight));
-	context_->Unmap(buf[2], 0);
 }
@@ -106,6 +106,8 @@ class TessellationDataTransferD3D11 : public TessellationDataTransfer {
 	D3D11_BUFFER_DESC desc{};
 	int prevSize = 0;
 	int prevSizeWU = 0, prevSizeWV = 0;
+	// Weights come from a cache that lives as long as the draw engine, so the pointer identifies the contents.
+	const Spline::Weight *prevWeightsU = nullptr, *prevWeightsV = nullptr;
 public:
 	TessellationDataTransferD3D11(ID3D11DeviceContext *context, ID3D11Device *device);
 	~TessellationDataTransferD3D11();
@@ -326,7 +326,7 @@ void GPU_D3D11::DoState(PointerWrap &p) {
 
 	// TODO: Some of these things may not be necessary.
 	// None of these are necessary when saving.
-	if (p.mode == p.MODE_READ && !PSP_CoreParameter().frozen) {
+	if (p.mode == p.MODE_READ && !PSP_CoreParameter().frozen && !PSP_CoreParameter().runAheadSpeculative) {
 		textureCache_->Clear(true);
 		depalShaderCache_->Clear();
 		drawEngine_.ClearTrackedVertexArrays();
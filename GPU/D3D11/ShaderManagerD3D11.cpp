@@ -38,6 +38,14 @@
 #include "GPU/D3D11/ShaderManagerD3D11.h"
 #include "GPU/D3D11/D3D11Util.h"
 
+// Constant buffer offsets and sizes are in units of 16 constants (256 bytes).
+static const UINT CONSTANT_ALIGN = 256;
+static const size_t UNIFORM_PUSH_SIZE = 4 * 1024 * 1024;
+
+static UINT AlignedConstants(size_t size) {
+	return (UINT)((size + CONSTANT_ALIGN - 1) & ~(size_t)(CONSTANT_ALIGN - 1)) / 16;
+}
+
 D3D11FragmentShader::D3D11FragmentShader(ID3D11Device *device, D3D_FEATURE_LEVEL featureLevel, FShaderID id, const char *code, bool useHWTransform)
 	: device_(device), useHWTransform_(useHWTransform), id_(id) {
 	source_ = code;
@@ -99,18 +107,33 @@ ShaderManagerD3D11::ShaderManagerD3D11(Draw::DrawContext *draw, ID3D11Device *de
 	static_assert(sizeof(ub_lights) <= 512, "ub_lights grew too big");
 	static_assert(sizeof(ub_bones) <= 384, "ub_bones grew too big");
 
-	D3D11_BUFFER_DESC desc{sizeof(ub_base), D3D11_USAGE_DYNAMIC, D3D11_BIND_CONSTANT_BUFFER, D3D11_CPU_ACCESS_WRITE };
-	ASSERT_SUCCESS(device_->CreateBuffer(&desc, nullptr, &push_base));
-	desc.ByteWidth = sizeof(ub_lights);
-	ASSERT_SUCCESS(device_->CreateBuffer(&desc, nullptr, &push_lights));
-	desc.ByteWidth = sizeof(ub_bones);
-	ASSERT_SUCCESS(device_->CreateBuffer(&desc, nullptr, &push_bones));
+	context1_ = (ID3D11DeviceContext1 *)draw->GetNativeObject(Draw::NativeObject::CONTEXT_EX);
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+	if (context1_ && SUCCEEDED(device_->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))) {
+		if (options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer) {
+			pushUniforms_ = new PushBufferD3D11(device_, UNIFORM_PUSH_SIZE, D3D11_BIND_CONSTANT_BUFFER);
+			pushUniforms_->Reset();
+		}
+	}
+
+	if (!pushUniforms_) {
+		D3D11_BUFFER_DESC desc{sizeof(ub_base), D3D11_USAGE_DYNAMIC, D3D11_BIND_CONSTANT_BUFFER, D3D11_CPU_ACCESS_WRITE };
+		ASSERT_SUCCESS(device_->CreateBuffer(&desc, nullptr, &push_base));
+		desc.ByteWidth = sizeof(ub_lights);
+		ASSERT_SUCCESS(device_->CreateBuffer(&desc, nullptr, &push_lights));
+		desc.ByteWidth = sizeof(ub_bones);
+		ASSERT_SUCCESS(device_->CreateBuffer(&desc, nullptr, &push_bones));
+	}
 }
 
 ShaderManagerD3D11::~ShaderManagerD3D11() {
-	push_base->Release();
-	push_lights->Release();
-	push_bones->Release();
+	if (pushUniforms_) {
+		delete pushUniforms_;
+	} else {
+		push_base->Release();
+		push_lights->Release();
+		push_bones->Release();
+	}
 	ClearShaders();
 	delete[] codeBuffer_;
 }
@@ -145,7 +168,34 @@ void ShaderManagerD3D11::DirtyLastShader() {
 
 uint64_t ShaderManagerD3D11::UpdateUniforms(bool useBufferedRendering) {
 	uint64_t dirty = gstate_c.GetDirtyUniforms();
-	if (dirty != 0) {
+	if (pushUniforms_) {
+		if (dirty & DIRTY_BASE_UNIFORMS)
+			BaseUpdateUniforms(&ub_base, dirty, true, useBufferedRendering);
+		if (dirty & DIRTY_LIGHT_UNIFORMS)
+			LightUpdateUniforms(&ub_lights, dirty);
+		if (dirty & DIRTY_BONE_UNIFORMS)
+			BoneUpdateUniforms(&ub_bones, dirty);
+
+		// Wrapping discards the ring, so the blocks we'd otherwise keep pointing at have to be pushed again.
+		uint64_t toPush = dirty & (DIRTY_BASE_UNIFORMS | DIRTY_LIGHT_UNIFORMS | DIRTY_BONE_UNIFORMS);
+		size_t worstCase = (AlignedConstants(sizeof(ub_base)) + AlignedConstants(sizeof(ub_lights)) + AlignedConstants(sizeof(ub_bones))) * 16;
+		if (!pushUniforms_->HasSpace(worstCase, CONSTANT_ALIGN)) {
+			pushUniforms_->Reset();
+			toPush = DIRTY_BASE_UNIFORMS | DIRTY_LIGHT_UNIFORMS | DIRTY_BONE_UNIFORMS;
+		}
+		if (toPush & DIRTY_BASE_UNIFORMS) {
+			memcpy(pushUniforms_->BeginPush(context_, &baseOffset_, sizeof(ub_base), CONSTANT_ALIGN), &ub_base, sizeof(ub_base));
+			pushUniforms_->EndPush(context_);
+		}
+		if (toPush & DIRTY_LIGHT_UNIFORMS) {
+			memcpy(pushUniforms_->BeginPush(context_, &lightOffset_, sizeof(ub_lights), CONSTANT_ALIGN), &ub_lights, sizeof(ub_lights));
+			pushUniforms_->EndPush(context_);
+		}
+		if (toPush & DIRTY_BONE_UNIFORMS) {
+			memcpy(pushUniforms_->BeginPush(context_, &boneOffset_, sizeof(ub_bones), CONSTANT_ALIGN), &ub_bones, sizeof(ub_bones));
+			pushUniforms_->EndPush(context_);
+		}
+	} else if (dirty != 0) {
 		D3D11_MAPPED_SUBRESOURCE map;
 		if (dirty & DIRTY_BASE_UNIFORMS) {
 			BaseUpdateUniforms(&ub_base, dirty, true, useBufferedRendering);
@@ -171,6 +221,16 @@ uint64_t ShaderManagerD3D11::UpdateUniforms(bool useBufferedRendering) {
 }
 
 void ShaderManagerD3D11::BindUniforms() {
+	if (pushUniforms_) {
+		ID3D11Buffer *buf = pushUniforms_->Buf();
+		ID3D11Buffer *vs_cbs[3] = { buf, buf, buf };
+		UINT firstConstant[3] = { baseOffset_ / 16, lightOffset_ / 16, boneOffset_ / 16 };
+		UINT numConstants[3] = { AlignedConstants(sizeof(ub_base)), AlignedConstants(sizeof(ub_lights)), AlignedConstants(sizeof(ub_bones)) };
+		context1_->VSSetConstantBuffers1(0, 3, vs_cbs, firstConstant, numConstants);
+		context1_->PSSetConstantBuffers1(0, 1, vs_cbs, firstConstant, numConstants);
+		return;
+	}
+
 	ID3D11Buffer *vs_cbs[3] = { push_base, push_lights, push_bones };
 	ID3D11Buffer *ps_cbs[1] = { push_base };
 	context_->VSSetConstantBuffers(0, 3, vs_cbs);
@@ -188,12 +248,7 @@ void ShaderManagerD3D11::GetShaders(int prim, u32 vertType, D3D11VertexShader **
 		VSID = lastVSID_;
 	}
 
-	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
-		gstate_c.Clean(DIRTY_FRAGMENTSHADER_STATE);
-		ComputeFragmentShaderID(&FSID, draw_->GetBugs());
-	} else {
-		FSID = lastFSID_;
-	}
+	UpdateFragmentShaderID(&FSID, lastFSID_, draw_->GetBugs());
 
 	// Just update uniforms if this is the same shader as last time.
 	if (lastVShader_ != nullptr && lastFShader_ != nullptr && VSID == lastVSID_ && FSID == lastFSID_) {
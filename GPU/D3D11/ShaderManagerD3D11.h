@@ -20,6 +20,7 @@
 #include <map>
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 
 #include "Common/CommonTypes.h"
 #include "GPU/Common/ShaderCommon.h"
@@ -78,7 +79,7 @@ class D3D11VertexShader {
 	VShaderID id_;
 };
 
-class D3D11PushBuffer;
+class PushBufferD3D11;
 
 class ShaderManagerD3D11 : public ShaderManagerCommon {
 public:
@@ -98,6 +99,8 @@ class ShaderManagerD3D11 : public ShaderManagerCommon {
 	uint64_t UpdateUniforms(bool useBufferedRendering);
 	void BindUniforms();
 
+	bool UsesUniformRing() const { return pushUniforms_ != nullptr; }
+
 	// TODO: Avoid copying these buffers if same as last draw, can still point to it assuming we're still in the same pushbuffer.
 	// Applies dirty changes and copies the buffer.
 	bool IsBaseDirty() { return true; }
@@ -109,6 +112,7 @@ class ShaderManagerD3D11 : public ShaderManagerCommon {
 
 	ID3D11Device *device_;
 	ID3D11DeviceContext *context_;
+	ID3D11DeviceContext1 *context1_ = nullptr;
 	D3D_FEATURE_LEVEL featureLevel_;
 
 	typedef std::map<FShaderID, D3D11FragmentShader *> FSCache;
@@ -124,10 +128,16 @@ class ShaderManagerD3D11 : public ShaderManagerCommon {
 	UB_VS_Lights ub_lights;
 	UB_VS_Bones ub_bones;
 
-	// Not actual pushbuffers, requires D3D11.1, let's try to live without that first.
-	ID3D11Buffer *push_base;
-	ID3D11Buffer *push_lights;
-	ID3D11Buffer *push_bones;
+	// Used when D3D11.1 constant buffer offsets aren't available.
+	ID3D11Buffer *push_base = nullptr;
+	ID3D11Buffer *push_lights = nullptr;
+	ID3D11Buffer *push_bones = nullptr;
+
+	// With D3D11.1, uniforms are instead pushed into a ring and bound by offset.
+	PushBufferD3D11 *pushUniforms_ = nullptr;
+	UINT baseOffset_ = 0;
+	UINT lightOffset_ = 0;
+	UINT boneOffset_ = 0;
 
 	D3D11FragmentShader *lastFShader_ = nullptr;
 	D3D11VertexShader *lastVShader_ = nullptr;
@@ -386,12 +386,18 @@ void TextureCacheD3D11::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer,
 		pshader = depalShaderCache_->GetDepalettizePixelShader(clutMode, depth ? GE_FORMAT_DEPTH16 : framebuffer->drawnFormat);
 	}
 
-	if (pshader) {
+	const DepalResult *cachedDepal = pshader ? FindDepalResult(framebuffer, depth) : nullptr;
+	if (cachedDepal) {
+		// Already converted with this CLUT, and the framebuffer hasn't changed since.
+		draw_->BindFramebufferAsTexture(cachedDepal->fbo, 0, Draw::FB_COLOR_BIT, 0);
+		gstate_c.SetTextureFullAlpha(cachedDepal->fullAlpha);
+	} else if (pshader) {
 		bool expand32 = !gstate_c.Supports(GPU_SUPPORTS_16BIT_FORMATS);
 		const GEPaletteFormat clutFormat = gstate.getClutPaletteFormat();
 		ID3D11ShaderResourceView *clutTexture = depalShaderCache_->GetClutTexture(clutFormat, clutHash_, clutBuf_, expand32);
 
-		Draw::Framebuffer *depalFBO = framebufferManagerD3D11_->GetTempFBO(TempFBO::DEPAL, framebuffer->renderWidth, framebuffer->renderHeight);
+		DepalResult *depalResult = GetDepalTarget(framebuffer, depth);
+		Draw::Framebuffer *depalFBO = depalResult->fbo;
 		shaderManager_->DirtyLastShader();
 
 		// Not sure why or if we need this here - we're not about to actually draw using draw_, just use its framebuffer binds.
@@ -434,6 +440,7 @@ void TextureCacheD3D11::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer,
 
 		CheckAlphaResult alphaStatus = CheckAlpha(clutBuf_, GetClutDestFormatD3D11(clutFormat), clutTotalColors);
 		gstate_c.SetTextureFullAlpha(alphaStatus == CHECKALPHA_FULL);
+		depalResult->fullAlpha = alphaStatus == CHECKALPHA_FULL;
 	} else {
 		gstate_c.SetTextureFullAlpha(gstate.getTextureFormat() == GE_TFMT_5650);
 		framebufferManager_->RebindFramebuffer("RebindFramebuffer - ApplyTextureFramebuffer");
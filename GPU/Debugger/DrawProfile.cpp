@@ -0,0 +1,150 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <mutex>
+#include <unordered_map>
+
+#include "Common/Log.h"
+#include "Common/TimeUtil.h"
+#include "GPU/Debugger/DrawProfile.h"
+
+namespace GPUDrawProfile {
+
+static bool active = false;
+static bool nextFrame = false;
+// Only touched on the GPU thread.
+static std::vector<DrawCost> currentDraws;
+static bool inDraw = false;
+static double submitStart = 0.0;
+
+static std::mutex lastLock;
+static std::vector<DrawCost> lastDraws;
+static std::unordered_map<u32, DrawCost> lastByPC;
+static int framesProfiled = 0;
+
+bool Activate() {
+	if (nextFrame)
+		return false;
+	nextFrame = true;
+	return true;
+}
+
+bool IsActive() {
+	return active;
+}
+
+bool IsActivePending() {
+	return nextFrame || active;
+}
+
+static void FinishFrame() {
+	std::unordered_map<u32, DrawCost> byPC;
+	for (const DrawCost &draw : currentDraws) {
+		auto it = byPC.find(draw.pc);
+		if (it == byPC.end()) {
+			byPC[draw.pc] = draw;
+			continue;
+		}
+		DrawCost &sum = it->second;
+		sum.vertexCount += draw.vertexCount;
+		for (int i = 0; i < (int)Cost::COUNT; ++i)
+			sum.times[i] += draw.times[i];
+	}
+
+	NOTICE_LOG(G3D, "Profiled %d draws", (int)currentDraws.size());
+
+	std::lock_guard<std::mutex> guard(lastLock);
+	lastDraws = std::move(currentDraws);
+	lastByPC = std::move(byPC);
+	currentDraws.clear();
+	framesProfiled++;
+}
+
+void NotifyFrame() {
+	if (active) {
+		active = false;
+		inDraw = false;
+		FinishFrame();
+	}
+	if (nextFrame) {
+		nextFrame = false;
+		active = true;
+		currentDraws.clear();
+	}
+}
+
+void BeginDraw(u32 pc, u32 op, int vertexCount, u32 framebuf, u32 texaddr) {
+	if (!active)
+		return;
+
+	DrawCost draw{};
+	draw.pc = pc;
+	draw.op = op;
+	draw.vertexCount = vertexCount;
+	draw.framebuf = framebuf;
+	draw.texaddr = texaddr;
+	draw.stepId = -1;
+	currentDraws.push_back(draw);
+
+	inDraw = true;
+	submitStart = time_now_d();
+}
+
+void EndSubmit() {
+	if (inDraw)
+		AddTime(Cost::SUBMIT, time_now_d() - submitStart);
+}
+
+void EndDraw(int stepId) {
+	if (!inDraw)
+		return;
+	currentDraws.back().stepId = stepId;
+	inDraw = false;
+}
+
+void AddTime(Cost cost, double seconds) {
+	if (inDraw)
+		currentDraws.back().times[(int)cost] += seconds;
+}
+
+int GetLastFrame(std::vector<DrawCost> *draws) {
+	std::lock_guard<std::mutex> guard(lastLock);
+	if (draws)
+		*draws = lastDraws;
+	return framesProfiled;
+}
+
+bool GetDrawAt(u32 pc, DrawCost *cost) {
+	std::lock_guard<std::mutex> guard(lastLock);
+	auto it = lastByPC.find(pc);
+	if (it == lastByPC.end())
+		return false;
+	*cost = it->second;
+	return true;
+}
+
+Scope::Scope(Cost cost) : cost_(cost) {
+	if (inDraw)
+		start_ = time_now_d();
+}
+
+Scope::~Scope() {
+	if (start_ != 0.0)
+		AddTime(cost_, time_now_d() - start_);
+}
+
+}
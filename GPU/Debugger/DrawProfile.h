@@ -0,0 +1,87 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Per-draw CPU cost of a single frame, for finding out which draws make a scene slow.
+// While a frame is profiled, every PRIM is flushed on its own so that its costs can be separated.
+namespace GPUDrawProfile {
+
+enum class Cost {
+	// Execute_Prim up to and including handing the vertices to the draw engine.
+	SUBMIT,
+	// The draw engine flush, including the vertex and texture work below.
+	FLUSH,
+	DECODE,
+	// Texture lookup, hashing and decoding.
+	TEXTURE,
+	COUNT,
+};
+
+struct DrawCost {
+	u32 pc;
+	u32 op;
+	int vertexCount;
+	u32 framebuf;
+	// 0 if texturing was off.
+	u32 texaddr;
+	// Host render pass, to line up draws with per-pass GPU timings.
+	int stepId;
+	// In seconds.
+	double times[(int)Cost::COUNT];
+
+	// Flush time not spent decoding vertices or textures (shaders, pipeline state, etc.)
+	double StateTime() const {
+		return times[(int)Cost::FLUSH] - times[(int)Cost::DECODE] - times[(int)Cost::TEXTURE];
+	}
+	double TotalTime() const {
+		return times[(int)Cost::SUBMIT] + times[(int)Cost::FLUSH];
+	}
+};
+
+// Profiles the next frame.  Returns false if one is already pending.
+bool Activate();
+bool IsActive();
+bool IsActivePending();
+
+void NotifyFrame();
+void BeginDraw(u32 pc, u32 op, int vertexCount, u32 framebuf, u32 texaddr);
+void EndSubmit();
+void EndDraw(int stepId);
+void AddTime(Cost cost, double seconds);
+
+// Returns how many frames have been profiled, so callers can tell when a new one is ready.
+int GetLastFrame(std::vector<DrawCost> *draws);
+// Sum of the draws at pc in the last profiled frame.
+bool GetDrawAt(u32 pc, DrawCost *cost);
+
+// Adds the time spent in a scope to the current draw, while profiling.
+class Scope {
+public:
+	Scope(Cost cost);
+	~Scope();
+
+private:
+	Cost cost_;
+	double start_ = 0.0;
+};
+
+}
@@ -104,7 +104,7 @@ DrawEngineDX9::DrawEngineDX9(Draw::DrawContext *draw) : draw_(draw), vai_(256),
 
 	InitDeviceObjects();
 
-	tessDataTransferDX9 = new TessellationDataTransferDX9();
+	tessDataTransferDX9 = new TessellationDataTransferDX9(device_);
 	tessDataTransfer = tessDataTransferDX9;
 
 	device_->CreateVertexDeclaration(TransformedVertexElements, &transformedVertexDecl_);
@@ -133,6 +133,9 @@ void DrawEngineDX9::InitDeviceObjects() {
 
 void DrawEngineDX9::DestroyDeviceObjects() {
 	ClearTrackedVertexArrays();
+	if (tessDataTransferDX9) {
+		tessDataTransferDX9->Release();
+	}
 }
 
 struct DeclTypeInfo {
@@ -661,8 +664,115 @@ void DrawEngineDX9::DoFlush() {
 	GPUDebug::NotifyDraw();
 }
 
+bool DrawEngineDX9::SupportsHWTessellation() const {
+	// The control points and weights are read with vertex texture fetch, which needs vs_3_0 and float textures.
+	D3DCAPS9 caps;
+	if (FAILED(device_->GetDeviceCaps(&caps)))
+		return false;
+	if (caps.VertexShaderVersion < D3DVS_VERSION(3, 0) || caps.PixelShaderVersion < D3DPS_VERSION(3, 0))
+		return false;
+
+	LPDIRECT3D9 d3d = nullptr;
+	D3DDEVICE_CREATION_PARAMETERS params;
+	if (FAILED(device_->GetDirect3D(&d3d)))
+		return false;
+	bool supported = false;
+	if (SUCCEEDED(device_->GetCreationParameters(&params))) {
+		HRESULT hr = d3d->CheckDeviceFormat(params.AdapterOrdinal, params.DeviceType, D3DFMT_X8R8G8B8, D3DUSAGE_QUERY_VERTEXTEXTURE, D3DRTYPE_TEXTURE, D3DFMT_A32B32G32R32F);
+		supported = SUCCEEDED(hr);
+	}
+	d3d->Release();
+	return supported;
+}
+
+bool DrawEngineDX9::UpdateUseHWTessellation(bool enable) {
+	return enable && SupportsHWTessellation();
+}
+
+void TessellationDataTransferDX9::Release() {
+	for (int i = 0; i < 3; i++) {
+		if (tex_[i]) {
+			tex_[i]->Release();
+			tex_[i] = nullptr;
+		}
+		texWidth_[i] = 0;
+		texHeight_[i] = 0;
+	}
+	prevWeightsU_ = nullptr;
+	prevWeightsV_ = nullptr;
+}
+
+bool TessellationDataTransferDX9::PrepareTexture(int i, int width, int height) {
+	if (tex_[i] && texWidth_[i] >= width && texHeight_[i] >= height)
+		return true;
+
+	if (tex_[i]) {
+		tex_[i]->Release();
+		tex_[i] = nullptr;
+	}
+	width = std::max(width, texWidth_[i]);
+	height = std::max(height, texHeight_[i]);
+	HRESULT hr = device_->CreateTexture(width, height, 1, D3DUSAGE_DYNAMIC, D3DFMT_A32B32G32R32F, D3DPOOL_DEFAULT, &tex_[i], nullptr);
+	if (FAILED(hr)) {
+		ERROR_LOG(G3D, "Failed to create tessellation texture %d (%dx%d): %08x", i, width, height, (uint32_t)hr);
+		texWidth_[i] = 0;
+		texHeight_[i] = 0;
+		return false;
+	}
+	texWidth_[i] = width;
+	texHeight_[i] = height;
+	// A fresh texture has no weights in it yet.
+	if (i == 1)
+		prevWeightsU_ = nullptr;
+	else if (i == 2)
+		prevWeightsV_ = nullptr;
+	return true;
+}
+
 void TessellationDataTransferDX9::SendDataToShader(const SimpleVertex *const *points, int size_u, int size_v, u32 vertType, const Spline::Weight2D &weights) {
-	// TODO
+	using Spline::Weight;
+
+	// Control points laid out like GLES: positions, then texcoords, then colors, each size_u texels wide.
+	if (!PrepareTexture(0, size_u * 3, size_v))
+		return;
+	D3DLOCKED_RECT rect;
+	if (SUCCEEDED(tex_[0]->LockRect(0, &rect, nullptr, D3DLOCK_DISCARD))) {
+		for (int v = 0; v < size_v; v++) {
+			float *row = (float *)((u8 *)rect.pBits + v * rect.Pitch);
+			// CopyControlPoints writes contiguous points, so go one row of control points at a time.
+			CopyControlPoints(row, row + size_u * 4, row + size_u * 8, 4, 4, 4, points + v * size_u, size_u, vertType);
+		}
+		tex_[0]->UnlockRect(0);
+	}
+
+	// Weights, basis and derivative interleaved, so two texels each.
+	if (!PrepareTexture(1, weights.size_u * 2, 1) || !PrepareTexture(2, weights.size_v * 2, 1))
+		return;
+	if (prevWeightsU_ != weights.u && SUCCEEDED(tex_[1]->LockRect(0, &rect, nullptr, D3DLOCK_DISCARD))) {
+		memcpy(rect.pBits, weights.u, weights.size_u * sizeof(Weight));
+		tex_[1]->UnlockRect(0);
+		prevWeightsU_ = weights.u;
+	}
+	if (prevWeightsV_ != weights.v && SUCCEEDED(tex_[2]->LockRect(0, &rect, nullptr, D3DLOCK_DISCARD))) {
+		memcpy(rect.pBits, weights.v, weights.size_v * sizeof(Weight));
+		tex_[2]->UnlockRect(0);
+		prevWeightsV_ = weights.v;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		DWORD sampler = D3DVERTEXTEXTURESAMPLER0 + i;
+		device_->SetTexture(sampler, tex_[i]);
+		device_->SetSamplerState(sampler, D3DSAMP_MINFILTER, D3DTEXF_POINT);
+		device_->SetSamplerState(sampler, D3DSAMP_MAGFILTER, D3DTEXF_POINT);
+		device_->SetSamplerState(sampler, D3DSAMP_MIPFILTER, D3DTEXF_NONE);
+		device_->SetSamplerState(sampler, D3DSAMP_ADDRESSU, D3DTADDRESS_CLAMP);
+		device_->SetSamplerState(sampler, D3DSAMP_ADDRESSV, D3DTADDRESS_CLAMP);
+	}
+
+	const float tessParams[4] = { (float)size_u, 1.0f / texWidth_[0], 1.0f / texHeight_[0], 0.0f };
+	const float weightParams[4] = { 1.0f / texWidth_[1], 1.0f / texWidth_[2], 0.0f, 0.0f };
+	device_->SetVertexShaderConstantF(CONST_VS_TESS_PARAMS, tessParams, 1);
+	device_->SetVertexShaderConstantF(CONST_VS_TESS_WEIGHT_PARAMS, weightParams, 1);
 }
 
 }  // namespace
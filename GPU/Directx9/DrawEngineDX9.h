@@ -98,9 +98,24 @@ class VertexArrayInfoDX9 {
 
 class TessellationDataTransferDX9 : public TessellationDataTransfer {
 public:
-	TessellationDataTransferDX9() {}
-	~TessellationDataTransferDX9() {}
+	TessellationDataTransferDX9(LPDIRECT3DDEVICE9 device) : device_(device) {}
+	~TessellationDataTransferDX9() {
+		Release();
+	}
+	// Send spline/bezier's control points and weights to vertex shader through float textures (vertex texture fetch.)
 	void SendDataToShader(const SimpleVertex *const *points, int size_u, int size_v, u32 vertType, const Spline::Weight2D &weights) override;
+	void Release();
+
+private:
+	bool PrepareTexture(int i, int width, int height);
+
+	LPDIRECT3DDEVICE9 device_;
+	LPDIRECT3DTEXTURE9 tex_[3]{};
+	int texWidth_[3]{};
+	int texHeight_[3]{};
+	// Weights come from a cache that lives as long as the draw engine, so the pointer identifies the contents.
+	const Spline::Weight *prevWeightsU_ = nullptr;
+	const Spline::Weight *prevWeightsV_ = nullptr;
 };
 
 // Handles transform, lighting and drawing.
@@ -140,9 +155,10 @@ class DrawEngineDX9 : public DrawEngineCommon {
 
 	void DispatchFlush() override { Flush(); }
 
+	bool SupportsHWTessellation() const;
+
 protected:
-	// Not currently supported.
-	bool UpdateUseHWTessellation(bool enable) override { return false; }
+	bool UpdateUseHWTessellation(bool enable) override;
 	void DecimateTrackedVertexArrays();
 
 private:
@@ -20,6 +20,7 @@
 #include "Common/GPU/thin3d.h"
 #include "Common/Math/lin/matrix4x4.h"
 #include "Core/MemMap.h"
+#include "Core/MemFault.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/System.h"
@@ -145,7 +146,7 @@ namespace DX9 {
 		}
 	}
 
-	void FramebufferManagerDX9::PackFramebufferSync_(VirtualFramebuffer *vfb, int x, int y, int w, int h) {
+	void FramebufferManagerDX9::PackFramebufferSync_(VirtualFramebuffer *vfb, int x, int y, int w, int h, Draw::ReadbackMode mode) {
 		if (!vfb->fbo) {
 			ERROR_LOG_REPORT_ONCE(vfbfbozero, SCEGE, "PackFramebufferDirectx9_: vfb->fbo == 0");
 			return;
@@ -174,6 +175,7 @@ namespace DX9 {
 				if (SUCCEEDED(hr)) {
 					// TODO: Handle the other formats?  We don't currently create them, I think.
 					const int dstByteOffset = (y * vfb->fb_stride + x) * dstBpp;
+					Memory::MemFault_UnprotectVRAM(fb_address + dstByteOffset, (h * vfb->fb_stride + w - 1) * dstBpp);
 					// Pixel size always 4 here because we always request BGRA8888.
 					ConvertFromBGRA8888(Memory::GetPointerWrite(fb_address + dstByteOffset), (u8 *)locked.pBits, vfb->fb_stride, locked.Pitch / 4, w, h, vfb->format);
 					offscreen->UnlockRect();
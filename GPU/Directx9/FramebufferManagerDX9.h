@@ -59,7 +59,7 @@ class FramebufferManagerDX9 : public FramebufferManagerCommon {
 	void DecimateFBOs() override;
 
 private:
-	void PackFramebufferSync_(VirtualFramebuffer *vfb, int x, int y, int w, int h) override;
+	void PackFramebufferSync_(VirtualFramebuffer *vfb, int x, int y, int w, int h, Draw::ReadbackMode mode) override;
 	void PackDepthbuffer(VirtualFramebuffer *vfb, int x, int y, int w, int h);
 	bool GetRenderTargetFramebuffer(LPDIRECT3DSURFACE9 renderTarget, LPDIRECT3DSURFACE9 offscreen, int w, int h, GPUDebugBuffer &buffer);
 
@@ -96,10 +96,12 @@ GPU_DX9::GPU_DX9(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	textureCache_->NotifyConfigChanged();
 
 	if (g_Config.bHardwareTessellation) {
-		// Disable hardware tessellation bacause DX9 is still unsupported.
-		ERROR_LOG(G3D, "Hardware Tessellation is unsupported, falling back to software tessellation");
-		auto gr = GetI18NCategory("Graphics");
-		host->NotifyUserMessage(gr->T("Turn off Hardware Tessellation - unsupported"), 2.5f, 0xFF3030FF);
+		// Disable hardware tessellation if device is unsupported.
+		if (!drawEngine_.SupportsHWTessellation()) {
+			ERROR_LOG(G3D, "Hardware Tessellation is unsupported, falling back to software tessellation");
+			auto gr = GetI18NCategory("Graphics");
+			host->NotifyUserMessage(gr->T("Turn off Hardware Tessellation - unsupported"), 2.5f, 0xFF3030FF);
+		}
 	}
 }
 
@@ -369,7 +371,7 @@ void GPU_DX9::DoState(PointerWrap &p) {
 
 	// TODO: Some of these things may not be necessary.
 	// None of these are necessary when saving.
-	if (p.mode == p.MODE_READ && !PSP_CoreParameter().frozen) {
+	if (p.mode == p.MODE_READ && !PSP_CoreParameter().frozen && !PSP_CoreParameter().runAheadSpeculative) {
 		textureCache_->Clear(true);
 		depalShaderCache_.Clear();
 		drawEngine_.ClearTrackedVertexArrays();
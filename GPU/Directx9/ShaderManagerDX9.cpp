@@ -51,7 +51,7 @@ using namespace Lin;
 
 namespace DX9 {
 
-PSShader::PSShader(LPDIRECT3DDEVICE9 device, FShaderID id, const char *code) : id_(id) {
+PSShader::PSShader(LPDIRECT3DDEVICE9 device, FShaderID id, const char *code, bool shaderModel3) : id_(id) {
 	source_ = code;
 #ifdef SHADERLOG
 	OutputDebugString(ConvertUTF8ToWString(code).c_str());
@@ -59,7 +59,7 @@ PSShader::PSShader(LPDIRECT3DDEVICE9 device, FShaderID id, const char *code) : i
 	bool success;
 	std::string errorMessage;
 
-	success = CompilePixelShaderD3D9(device, code, &shader, &errorMessage);
+	success = CompilePixelShaderD3D9(device, code, &shader, &errorMessage, shaderModel3);
 
 	if (!errorMessage.empty()) {
 		if (success) {
@@ -103,13 +103,14 @@ std::string PSShader::GetShaderString(DebugShaderStringType type) const {
 
 VSShader::VSShader(LPDIRECT3DDEVICE9 device, VShaderID id, const char *code, bool useHWTransform) : useHWTransform_(useHWTransform), id_(id) {
 	source_ = code;
+	shaderModel3_ = useHWTransform && (id.Bit(VS_BIT_BEZIER) || id.Bit(VS_BIT_SPLINE));
 #ifdef SHADERLOG
 	OutputDebugString(ConvertUTF8ToWString(code).c_str());
 #endif
 	bool success;
 	std::string errorMessage;
 
-	success = CompileVertexShaderD3D9(device, code, &shader, &errorMessage);
+	success = CompileVertexShaderD3D9(device, code, &shader, &errorMessage, shaderModel3_);
 	if (!errorMessage.empty()) {
 		if (success) {
 			ERROR_LOG(G3D, "Warnings in shader compilation!");
@@ -519,10 +520,14 @@ void ShaderManagerDX9::Clear() {
 	for (auto iter = fsCache_.begin(); iter != fsCache_.end(); ++iter)	{
 		delete iter->second;
 	}
+	for (auto iter = fsCacheSM3_.begin(); iter != fsCacheSM3_.end(); ++iter)	{
+		delete iter->second;
+	}
 	for (auto iter = vsCache_.begin(); iter != vsCache_.end(); ++iter)	{
 		delete iter->second;
 	}
 	fsCache_.clear();
+	fsCacheSM3_.clear();
 	vsCache_.clear();
 	DirtyShader();
 }
@@ -560,12 +565,7 @@ VSShader *ShaderManagerDX9::ApplyShader(bool useHWTransform, bool useHWTessellat
 	}
 
 	FShaderID FSID;
-	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
-		gstate_c.Clean(DIRTY_FRAGMENTSHADER_STATE);
-		ComputeFragmentShaderID(&FSID, draw_->GetBugs());
-	} else {
-		FSID = lastFSID_;
-	}
+	UpdateFragmentShaderID(&FSID, lastFSID_, draw_->GetBugs());
 
 	// Just update uniforms if this is the same shader as last time.
 	if (lastVShader_ != nullptr && lastPShader_ != nullptr && VSID == lastVSID_ && FSID == lastFSID_) {
@@ -623,17 +623,19 @@ VSShader *ShaderManagerDX9::ApplyShader(bool useHWTransform, bool useHWTessellat
 	}
 	lastVSID_ = VSID;
 
-	FSCache::iterator fsIter = fsCache_.find(FSID);
+	// The same fragment shader source, but D3D9 won't mix shader models within a draw.
+	FSCache &fsCache = vs->UseShaderModel3() ? fsCacheSM3_ : fsCache_;
+	FSCache::iterator fsIter = fsCache.find(FSID);
 	PSShader *fs;
-	if (fsIter == fsCache_.end())	{
+	if (fsIter == fsCache.end())	{
 		// Fragment shader not in cache. Let's compile it.
 		std::string errorString;
 		uint64_t uniformMask;
 		bool success = GenerateFragmentShader(FSID, codeBuffer_, draw_->GetShaderLanguageDesc(), draw_->GetBugs(), &uniformMask, &errorString);
 		// We're supposed to handle all possible cases.
 		_assert_(success);
-		fs = new PSShader(device_, FSID, codeBuffer_);
-		fsCache_[FSID] = fs;
+		fs = new PSShader(device_, FSID, codeBuffer_, vs->UseShaderModel3());
+		fsCache[FSID] = fs;
 	} else {
 		fs = fsIter->second;
 	}
@@ -36,7 +36,7 @@ class VSShader;
 
 class PSShader {
 public:
-	PSShader(LPDIRECT3DDEVICE9 device, FShaderID id, const char *code);
+	PSShader(LPDIRECT3DDEVICE9 device, FShaderID id, const char *code, bool shaderModel3);
 	~PSShader();
 
 	const std::string &source() const { return source_; }
@@ -62,6 +62,8 @@ class VSShader {
 
 	bool Failed() const { return failed_; }
 	bool UseHWTransform() const { return useHWTransform_; }
+	// Hardware tessellation needs vertex texture fetch, so those are vs_3_0 and need ps_3_0 partners.
+	bool UseShaderModel3() const { return shaderModel3_; }
 
 	std::string GetShaderString(DebugShaderStringType type) const;
 
@@ -71,6 +73,7 @@ class VSShader {
 	std::string source_;
 	bool failed_ = false;
 	bool useHWTransform_;
+	bool shaderModel3_;
 	VShaderID id_;
 };
 
@@ -122,6 +125,7 @@ class ShaderManagerDX9 : public ShaderManagerCommon {
 
 	typedef std::map<FShaderID, PSShader *> FSCache;
 	FSCache fsCache_;
+	FSCache fsCacheSM3_;
 
 	typedef std::map<VShaderID, VSShader *> VSCache;
 	VSCache vsCache_;
@@ -355,11 +355,17 @@ void TextureCacheDX9::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer, G
 		pshader = depalShaderCache_->GetDepalettizePixelShader(clutMode, framebuffer->drawnFormat);
 	}
 
-	if (pshader) {
+	const DepalResult *cachedDepal = pshader ? FindDepalResult(framebuffer, false) : nullptr;
+	if (cachedDepal) {
+		// Already converted with this CLUT, and the framebuffer hasn't changed since.
+		draw_->BindFramebufferAsTexture(cachedDepal->fbo, 0, Draw::FB_COLOR_BIT, 0);
+		gstate_c.SetTextureFullAlpha(cachedDepal->fullAlpha);
+	} else if (pshader) {
 		const GEPaletteFormat clutFormat = gstate.getClutPaletteFormat();
 		LPDIRECT3DTEXTURE9 clutTexture = depalShaderCache_->GetClutTexture(clutFormat, clutHash_, clutBuf_);
 
-		Draw::Framebuffer *depalFBO = framebufferManagerDX9_->GetTempFBO(TempFBO::DEPAL, framebuffer->renderWidth, framebuffer->renderHeight);
+		DepalResult *depalResult = GetDepalTarget(framebuffer, false);
+		Draw::Framebuffer *depalFBO = depalResult->fbo;
 		draw_->BindFramebufferAsRenderTarget(depalFBO, { Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE }, "Depal");
 		shaderManager_->DirtyLastShader();
 
@@ -391,6 +397,7 @@ void TextureCacheDX9::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer, G
 
 		CheckAlphaResult alphaStatus = CheckAlpha(clutBuf_, getClutDestFormat(clutFormat), clutTotalColors);
 		gstate_c.SetTextureFullAlpha(alphaStatus == CHECKALPHA_FULL);
+		depalResult->fullAlpha = alphaStatus == CHECKALPHA_FULL;
 	} else {
 		framebufferManagerDX9_->BindFramebufferAsColorTexture(0, framebuffer, BINDFBCOLOR_MAY_COPY_WITH_UV | BINDFBCOLOR_APPLY_TEX_OFFSET);
 
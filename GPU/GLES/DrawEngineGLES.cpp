@@ -523,9 +523,13 @@ void TessellationDataTransferGLES::SendDataToShader(const SimpleVertex *const *p
 			data_tex[1] = renderManager_->CreateTexture(GL_TEXTURE_2D, weights.size_u * 2, 1, 1, 1);
 		renderManager_->TextureImage(data_tex[1], 0, weights.size_u * 2, 1, 1, Draw::DataFormat::R32G32B32A32_FLOAT, nullptr, GLRAllocType::NONE, false);
 		renderManager_->FinalizeTexture(data_tex[1], 0, false);
+		prevWeightsU = nullptr;
 	}
 	renderManager_->BindTexture(TEX_SLOT_SPLINE_WEIGHTS_U, data_tex[1]);
-	renderManager_->TextureSubImage(data_tex[1], 0, 0, 0, weights.size_u * 2, 1, Draw::DataFormat::R32G32B32A32_FLOAT, (u8 *)weights.u, GLRAllocType::NONE);
+	if (prevWeightsU != weights.u) {
+		prevWeightsU = weights.u;
+		renderManager_->TextureSubImage(data_tex[1], 0, 0, 0, weights.size_u * 2, 1, Draw::DataFormat::R32G32B32A32_FLOAT, (u8 *)weights.u, GLRAllocType::NONE);
+	}
 
 	// Weight V
 	if (prevSizeWV < weights.size_v) {
@@ -534,9 +538,13 @@ void TessellationDataTransferGLES::SendDataToShader(const SimpleVertex *const *p
 			data_tex[2] = renderManager_->CreateTexture(GL_TEXTURE_2D, weights.size_v * 2, 1, 1, 1);
 		renderManager_->TextureImage(data_tex[2], 0, weights.size_v * 2, 1, 1, Draw::DataFormat::R32G32B32A32_FLOAT, nullptr, GLRAllocType::NONE, false);
 		renderManager_->FinalizeTexture(data_tex[2], 0, false);
+		prevWeightsV = nullptr;
 	}
 	renderManager_->BindTexture(TEX_SLOT_SPLINE_WEIGHTS_V, data_tex[2]);
-	renderManager_->TextureSubImage(data_tex[2], 0, 0, 0, weights.size_v * 2, 1, Draw::DataFormat::R32G32B32A32_FLOAT, (u8 *)weights.v, GLRAllocType::NONE);
+	if (prevWeightsV != weights.v) {
+		prevWeightsV = weights.v;
+		renderManager_->TextureSubImage(data_tex[2], 0, 0, 0, weights.size_v * 2, 1, Draw::DataFormat::R32G32B32A32_FLOAT, (u8 *)weights.v, GLRAllocType::NONE);
+	}
 }
 
 void TessellationDataTransferGLES::EndFrame() {
@@ -547,4 +555,5 @@ void TessellationDataTransferGLES::EndFrame() {
 		}
 	}
 	prevSizeU = prevSizeV = prevSizeWU = prevSizeWV = 0;
+	prevWeightsU = prevWeightsV = nullptr;
 }
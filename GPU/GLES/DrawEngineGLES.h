@@ -45,6 +45,8 @@ class TessellationDataTransferGLES : public TessellationDataTransfer {
 	GLRTexture *data_tex[3]{};
 	int prevSizeU = 0, prevSizeV = 0;
 	int prevSizeWU = 0, prevSizeWV = 0;
+	// Weights come from a cache that lives as long as the draw engine, so the pointer identifies the contents.
+	const Spline::Weight *prevWeightsU = nullptr, *prevWeightsV = nullptr;
 	GLRenderManager *renderManager_;
 public:
 	TessellationDataTransferGLES(GLRenderManager *renderManager)
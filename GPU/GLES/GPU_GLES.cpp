@@ -436,11 +436,19 @@ void GPU_GLES::GetStats(char *buffer, size_t bufsize) {
 	bufsize -= offset;
 	if ((int)bufsize < 0)
 		return;
+	GLRenderManager *render = (GLRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
+	GLQueueRunStats glStats = render->GetLastFrameStats();
 	snprintf(buffer, bufsize,
-		"Vertex, Fragment, Programs loaded: %d, %d, %d\n",
+		"Vertex, Fragment, Programs loaded: %d, %d, %d\n"
+		"GL calls: %d draw, %d state, %d uniform (%d filtered, %d commands merged)\n",
 		shaderManagerGL_->GetNumVertexShaders(),
 		shaderManagerGL_->GetNumFragmentShaders(),
-		shaderManagerGL_->GetNumPrograms()
+		shaderManagerGL_->GetNumPrograms(),
+		glStats.drawCalls,
+		glStats.stateCalls,
+		glStats.uniformCalls,
+		glStats.filteredCalls,
+		glStats.mergedCommands
 	);
 }
 
@@ -463,7 +471,7 @@ void GPU_GLES::DoState(PointerWrap &p) {
 	// TODO: Some of these things may not be necessary.
 	// None of these are necessary when saving.
 	// In Freeze-Frame mode, we don't want to do any of this.
-	if (p.mode == p.MODE_READ && !PSP_CoreParameter().frozen) {
+	if (p.mode == p.MODE_READ && !PSP_CoreParameter().frozen && !PSP_CoreParameter().runAheadSpeculative) {
 		textureCache_->Clear(true);
 		depalShaderCache_.Clear();
 		drawEngine_.ClearTrackedVertexArrays();
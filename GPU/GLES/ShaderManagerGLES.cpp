@@ -40,6 +40,7 @@
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/Host.h"
+#include "Core/Instance.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 #include "GPU/Math3D.h"
@@ -191,6 +192,8 @@ LinkedShader::LinkedShader(GLRenderManager *render, VShaderID VSID, Shader *vs,
 	bool useDualSource = (gstate_c.featureFlags & GPU_SUPPORTS_DUALSOURCE_BLEND) != 0;
 	bool useClip0 = VSID.Bit(VS_BIT_VERTEX_RANGE_CULLING) && gstate_c.Supports(GPU_SUPPORTS_CLIP_DISTANCE);
 	program = render->CreateProgram(shaders, semantics, queries, initialize, useDualSource, useClip0);
+	// Safe to set here, the program isn't actually created until the init steps run.
+	program->wantBinary = gl_extensions.ARB_get_program_binary && g_Config.bShaderCache;
 
 	// The rest, use the "dirty" mechanism.
 	dirtyUniforms = DIRTY_ALL_UNIFORMS;
@@ -722,12 +725,7 @@ LinkedShader *ShaderManagerGLES::ApplyFragmentShader(VShaderID VSID, Shader *vs,
 	}
 
 	FShaderID FSID;
-	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
-		gstate_c.Clean(DIRTY_FRAGMENTSHADER_STATE);
-		ComputeFragmentShaderID(&FSID, draw_->GetBugs());
-	} else {
-		FSID = lastFSID_;
-	}
+	UpdateFragmentShaderID(&FSID, lastFSID_, draw_->GetBugs());
 
 	if (lastVShaderSame_ && FSID == lastFSID_) {
 		lastShader_->UpdateUniforms(vertType, VSID, useBufferedRendering);
@@ -843,25 +841,35 @@ std::string ShaderManagerGLES::DebugGetShaderString(std::string id, DebugShaderT
 //
 // We simply store the IDs of the shaders used during gameplay. On next startup of
 // the same game, we simply compile all the shaders from the start, so we don't have to
-// compile them on the fly later. Ideally we would store the actual compiled shaders
-// rather than just their IDs, but OpenGL does not support this, except for a few obscure
-// vendor-specific extensions.
+// compile them on the fly later. Where program binaries are supported (ARB_get_program_binary,
+// or ES3), the linked programs are stored too, after the IDs. They're only used if the
+// driver is exactly the same, and the driver may still reject them, in which case we just
+// link from source as before.
 //
 // If things like GPU supported features have changed since the last time, we discard the cache
 // as sometimes these features might have an effect on the ID bits.
 
 #define CACHE_HEADER_MAGIC 0x83277592
-#define CACHE_VERSION 15
+#define CACHE_VERSION 16
 struct CacheHeader {
 	uint32_t magic;
 	uint32_t version;
 	uint32_t featureFlags;
-	uint32_t reserved;
+	uint32_t driverHash;
 	int numVertexShaders;
 	int numFragmentShaders;
 	int numLinkedPrograms;
 };
 
+// Follows each linked program ID pair, size 0 if there's no binary.
+struct CacheBinaryHeader {
+	uint32_t format;
+	uint32_t size;
+};
+
+// Sanity limit for a single program binary.
+static const uint32_t MAX_CACHED_PROGRAM_BINARY_SIZE = 4 * 1024 * 1024;
+
 void ShaderManagerGLES::Load(const Path &filename) {
 	File::IOFile f(filename, "rb");
 	u64 sz = f.GetSize();
@@ -888,8 +896,9 @@ void ShaderManagerGLES::Load(const Path &filename) {
 	u64 expectedSize = sizeof(header);
 	expectedSize += header.numVertexShaders * sizeof(VShaderID);
 	expectedSize += header.numFragmentShaders * sizeof(FShaderID);
-	expectedSize += header.numLinkedPrograms * (sizeof(VShaderID) + sizeof(FShaderID));
-	if (sz != expectedSize) {
+	expectedSize += header.numLinkedPrograms * (sizeof(VShaderID) + sizeof(FShaderID) + sizeof(CacheBinaryHeader));
+	// Binaries are variable size, checked as we go.
+	if (sz < expectedSize) {
 		ERROR_LOG(G3D, "Shader cache file is wrong size: %lld instead of %lld", sz, expectedSize);
 		return;
 	}
@@ -907,16 +916,40 @@ void ShaderManagerGLES::Load(const Path &filename) {
 		return;
 	}
 
+	// Binaries from a different driver are useless, still skip through them to get the IDs.
+	bool useBinaries = gl_extensions.ARB_get_program_binary && header.driverHash == gl_extensions.driverHash;
 	for (int i = 0; i < header.numLinkedPrograms; i++) {
 		VShaderID vsid;
 		FShaderID fsid;
+		CacheBinaryHeader binaryHeader;
 		if (!f.ReadArray(&vsid, 1)) {
 			return;
 		}
 		if (!f.ReadArray(&fsid, 1)) {
 			return;
 		}
+		if (!f.ReadArray(&binaryHeader, 1)) {
+			return;
+		}
+		ProgramBinary binary;
+		if (binaryHeader.size > MAX_CACHED_PROGRAM_BINARY_SIZE) {
+			ERROR_LOG(G3D, "Corrupt program binary size in shader cache, aborting.");
+			diskCachePending_.Clear();
+			return;
+		}
+		if (useBinaries && binaryHeader.size != 0) {
+			binary.format = binaryHeader.format;
+			binary.data.resize(binaryHeader.size);
+			if (!f.ReadBytes(binary.data.data(), binaryHeader.size)) {
+				diskCachePending_.Clear();
+				return;
+			}
+		} else if (binaryHeader.size != 0 && !f.Seek(binaryHeader.size, SEEK_CUR)) {
+			diskCachePending_.Clear();
+			return;
+		}
 		diskCachePending_.link.push_back(std::make_pair(vsid, fsid));
+		diskCachePending_.binaries.push_back(std::move(binary));
 	}
 
 	// Actual compilation happens in ContinuePrecompile(), called by GPU_GLES's IsReady.
@@ -992,6 +1025,12 @@ bool ShaderManagerGLES::ContinuePrecompile(float sliceTime) {
 		Shader *fs = fsCache_.Get(fsid);
 		if (vs && fs) {
 			LinkedShader *ls = new LinkedShader(render_, vsid, vs, fsid, fs, vs->UseHWTransform(), true);
+			ProgramBinary &binary = pending.binaries[i];
+			if (!binary.data.empty()) {
+				// Like wantBinary, picked up when the program is created on the render thread.
+				ls->program->binaryFormat = binary.format;
+				ls->program->binary = std::move(binary.data);
+			}
 			LinkedShaderCacheEntry entry(vs, fs, ls);
 			linkedShaderCache_.push_back(entry);
 		}
@@ -1018,7 +1057,8 @@ void ShaderManagerGLES::Save(const Path &filename) {
 		return;
 	}
 	INFO_LOG(G3D, "Saving the shader cache to '%s'", filename.c_str());
-	FILE *f = File::OpenCFile(filename, "wb");
+	Path tempPath = GetInstanceTempPath(filename);
+	FILE *f = File::OpenCFile(tempPath, "wb");
 	if (!f) {
 		// Can't save, give up for now.
 		diskCacheDirty_ = false;
@@ -1027,7 +1067,7 @@ void ShaderManagerGLES::Save(const Path &filename) {
 	CacheHeader header;
 	header.magic = CACHE_HEADER_MAGIC;
 	header.version = CACHE_VERSION;
-	header.reserved = 0;
+	header.driverHash = gl_extensions.driverHash;
 	header.featureFlags = gstate_c.featureFlags;
 	header.numVertexShaders = GetNumVertexShaders();
 	header.numFragmentShaders = GetNumFragmentShaders();
@@ -1051,7 +1091,19 @@ void ShaderManagerGLES::Save(const Path &filename) {
 		});
 		fwrite(&vsid, 1, sizeof(vsid), f);
 		fwrite(&fsid, 1, sizeof(fsid), f);
+
+		// If it hasn't been created yet (or failed), we just won't have a binary for it next time.
+		CacheBinaryHeader binaryHeader{};
+		GLRProgram *program = iter.ls->program;
+		if (program->binaryReady && program->binary.size() <= MAX_CACHED_PROGRAM_BINARY_SIZE) {
+			binaryHeader.format = program->binaryFormat;
+			binaryHeader.size = (uint32_t)program->binary.size();
+		}
+		fwrite(&binaryHeader, 1, sizeof(binaryHeader), f);
+		if (binaryHeader.size != 0)
+			fwrite(program->binary.data(), 1, binaryHeader.size, f);
 	}
 	fclose(f);
+	CommitInstanceTempFile(tempPath, filename);
 	diskCacheDirty_ = false;
 }
@@ -211,10 +211,16 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 	VSCache vsCache_;
 
 	bool diskCacheDirty_ = false;
+	struct ProgramBinary {
+		uint32_t format = 0;
+		std::vector<uint8_t> data;
+	};
+
 	struct {
 		std::vector<VShaderID> vert;
 		std::vector<FShaderID> frag;
 		std::vector<std::pair<VShaderID, FShaderID>> link;
+		std::vector<ProgramBinary> binaries;  // Parallel to link, may be empty entries.
 
 		size_t vertPos = 0;
 		size_t fragPos = 0;
@@ -225,6 +231,7 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 			vert.clear();
 			frag.clear();
 			link.clear();
+			binaries.clear();
 			vertPos = 0;
 			fragPos = 0;
 			linkPos = 0;
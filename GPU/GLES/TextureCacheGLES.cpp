@@ -381,12 +381,18 @@ void TextureCacheGLES::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer,
 		depalShader = depalShaderCache_->GetDepalettizeShader(clutMode, depth ? GE_FORMAT_DEPTH16 : framebuffer->drawnFormat);
 		gstate_c.SetUseShaderDepal(false);
 	}
-	if (depalShader) {
+	const DepalResult *cachedDepal = depalShader ? FindDepalResult(framebuffer, depth) : nullptr;
+	if (cachedDepal) {
+		// Already converted with this CLUT, and the framebuffer hasn't changed since.
+		draw_->BindFramebufferAsTexture(cachedDepal->fbo, 0, Draw::FB_COLOR_BIT, 0);
+		gstate_c.SetTextureFullAlpha(cachedDepal->fullAlpha);
+	} else if (depalShader) {
 		shaderManager_->DirtyLastShader();
 
 		const GEPaletteFormat clutFormat = gstate.getClutPaletteFormat();
 		GLRTexture *clutTexture = depalShaderCache_->GetClutTexture(clutFormat, clutHash_, clutBuf_);
-		Draw::Framebuffer *depalFBO = framebufferManagerGL_->GetTempFBO(TempFBO::DEPAL, framebuffer->renderWidth, framebuffer->renderHeight);
+		DepalResult *depalResult = GetDepalTarget(framebuffer, depth);
+		Draw::Framebuffer *depalFBO = depalResult->fbo;
 		draw_->BindFramebufferAsRenderTarget(depalFBO, { Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE }, "Depal");
 
 		render_->SetScissor(GLRect2D{ 0, 0, (int)framebuffer->renderWidth, (int)framebuffer->renderHeight });
@@ -409,6 +415,7 @@ void TextureCacheGLES::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer,
 
 		CheckAlphaResult alphaStatus = CheckAlpha((const uint8_t *)clutBuf_, getClutDestFormat(clutFormat), clutTotalColors);
 		gstate_c.SetTextureFullAlpha(alphaStatus == CHECKALPHA_FULL);
+		depalResult->fullAlpha = alphaStatus == CHECKALPHA_FULL;
 	} else {
 		framebufferManagerGL_->BindFramebufferAsColorTexture(0, framebuffer, BINDFBCOLOR_MAY_COPY_WITH_UV | BINDFBCOLOR_APPLY_TEX_OFFSET);
 
@@ -427,6 +434,7 @@ void TextureCacheGLES::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer,
 
 void TextureCacheGLES::BuildTexture(TexCacheEntry *const entry) {
 	BuildTexturePlan plan;
+	plan.reverseColors = true;
 	if (!PrepareBuildTexture(plan, entry)) {
 		// We're screwed?
 		return;
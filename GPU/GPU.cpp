@@ -19,6 +19,7 @@
 
 #include "Common/TimeUtil.h"
 #include "Common/GraphicsContext.h"
+#include "Common/Data/Format/JSONWriter.h"
 #include "Core/Core.h"
 
 #include "GPU/GPU.h"
@@ -120,8 +121,67 @@ void GPU_Shutdown() {
 		while (!gpu->IsReady()) {
 			sleep_ms(10);
 		}
+		// The backend goes away first, so nothing may still be running on the GE thread.
+		gpu->SyncThread();
 	}
 	delete gpu;
 	gpu = nullptr;
 	gpuDebug = nullptr;
 }
+
+const char *TextureChangeReasonToString(TextureChangeReason reason) {
+	switch (reason) {
+	case TextureChangeReason::PARAMS: return "params";
+	case TextureChangeReason::MINIHASH: return "minihash";
+	case TextureChangeReason::SCALING: return "scaling";
+	case TextureChangeReason::REPLACING: return "replacing";
+	case TextureChangeReason::HASH_FAIL: return "hashFail";
+	default: return "unknown";
+	}
+}
+
+void GPUCacheStatistics::Add(const GPUCacheStatistics &other) {
+	textureHits += other.textureHits;
+	textureMisses += other.textureMisses;
+	for (int i = 0; i < (int)TextureChangeReason::COUNT; i++)
+		textureChanges[i] += other.textureChanges[i];
+	textureBytesDecoded += other.textureBytesDecoded;
+	texturesDecimated += other.texturesDecimated;
+	textureBytesEvicted += other.textureBytesEvicted;
+	// This is a level, not a counter.
+	textureCacheBytes = other.textureCacheBytes;
+	framebuffersCreated += other.framebuffersCreated;
+	framebuffersResized += other.framebuffersResized;
+	framebufferAllocs += other.framebufferAllocs;
+	framebufferPoolHits += other.framebufferPoolHits;
+	framebufferBlits += other.framebufferBlits;
+	framebufferDownloads += other.framebufferDownloads;
+	depalOps += other.depalOps;
+}
+
+void GPUCacheStatistics::WriteJson(json::JsonWriter &writer) const {
+	writer.pushDict("textureCache");
+	writer.writeInt("hits", textureHits);
+	writer.writeInt("misses", textureMisses);
+	writer.pushDict("changes");
+	for (int i = 0; i < (int)TextureChangeReason::COUNT; i++)
+		writer.writeInt(TextureChangeReasonToString((TextureChangeReason)i), textureChanges[i]);
+	writer.pop();
+	writer.writeInt("bytesDecoded", textureBytesDecoded);
+	writer.writeInt("decimated", texturesDecimated);
+	writer.writeInt("bytesEvicted", textureBytesEvicted);
+	writer.writeInt("cacheBytes", textureCacheBytes);
+	int lookups = textureHits + textureMisses;
+	writer.writeFloat("hitRate", lookups > 0 ? (double)textureHits / lookups : 0.0);
+	writer.pop();
+
+	writer.pushDict("framebuffers");
+	writer.writeInt("created", framebuffersCreated);
+	writer.writeInt("resized", framebuffersResized);
+	writer.writeInt("allocs", framebufferAllocs);
+	writer.writeInt("poolHits", framebufferPoolHits);
+	writer.writeInt("blits", framebufferBlits);
+	writer.writeInt("downloads", framebufferDownloads);
+	writer.writeInt("depal", depalOps);
+	writer.pop();
+}
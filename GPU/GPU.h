@@ -24,6 +24,10 @@ class GPUInterface;
 class GPUDebugInterface;
 class GraphicsContext;
 
+namespace json {
+class JsonWriter;
+}
+
 enum FramebufferRenderMode {
 	FB_MODE_NORMAL = 0,
 	FB_MODE_COLOR_TO_DEPTH = 1,
@@ -55,6 +59,40 @@ inline unsigned int toFloat24(float f) {
 	return i >> 8;
 }
 
+// Why a cached texture had to be rebuilt.
+enum class TextureChangeReason {
+	PARAMS,
+	MINIHASH,
+	SCALING,
+	REPLACING,
+	HASH_FAIL,
+	COUNT,
+};
+
+const char *TextureChangeReasonToString(TextureChangeReason reason);
+
+// Per frame texture cache and framebuffer manager activity, for finding per-game hot spots.
+struct GPUCacheStatistics {
+	int textureHits;
+	int textureMisses;
+	int textureChanges[(int)TextureChangeReason::COUNT];
+	int textureBytesDecoded;
+	int texturesDecimated;
+	// Estimated host bytes, not PSP bytes.
+	int textureBytesEvicted;
+	int textureCacheBytes;
+	int framebuffersCreated;
+	int framebuffersResized;
+	int framebufferAllocs;
+	int framebufferPoolHits;
+	int framebufferBlits;
+	int framebufferDownloads;
+	int depalOps;
+
+	void Add(const GPUCacheStatistics &other);
+	void WriteJson(json::JsonWriter &writer) const;
+};
+
 struct GPUStatistics {
 	void Reset() {
 		// Never add a vtable :)
@@ -71,6 +109,7 @@ struct GPUStatistics {
 		numTextureInvalidations = 0;
 		numTextureInvalidationsByFramebuffer = 0;
 		numTexturesHashed = 0;
+		numTexturesSampleHashed = 0;
 		numTextureSwitches = 0;
 		numTextureDataBytesHashed = 0;
 		numShaderSwitches = 0;
@@ -82,9 +121,12 @@ struct GPUStatistics {
 		numClears = 0;
 		numDepthCopies = 0;
 		msProcessingDisplayLists = 0;
+		msTextureHashing = 0;
+		msTextureDecoding = 0;
 		vertexGPUCycles = 0;
 		otherGPUCycles = 0;
 		memset(gpuCommandsAtCallLevel, 0, sizeof(gpuCommandsAtCallLevel));
+		memset(&cache, 0, sizeof(cache));
 	}
 
 	// Per frame statistics
@@ -98,6 +140,7 @@ struct GPUStatistics {
 	int numTextureInvalidations;
 	int numTextureInvalidationsByFramebuffer;
 	int numTexturesHashed;
+	int numTexturesSampleHashed;
 	int numTextureDataBytesHashed;
 	int numTextureSwitches;
 	int numShaderSwitches;
@@ -108,9 +151,12 @@ struct GPUStatistics {
 	int numClears;
 	int numDepthCopies;
 	double msProcessingDisplayLists;
+	double msTextureHashing;
+	double msTextureDecoding;
 	int vertexGPUCycles;
 	int otherGPUCycles;
 	int gpuCommandsAtCallLevel[4];
+	GPUCacheStatistics cache;
 
 	// Flip count. Doesn't really belong here.
 	int numFlips;
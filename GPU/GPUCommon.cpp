@@ -16,6 +16,7 @@
 #include <mutex>
 
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ThreadUtil.h"
 
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/GraphicsContext.h"
@@ -47,8 +48,12 @@
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/TextureCacheCommon.h"
 #include "GPU/Debugger/Debugger.h"
+#include "GPU/Debugger/DrawProfile.h"
 #include "GPU/Debugger/Record.h"
 
+// Set on the GE thread, see ProcessDLQueue().
+static thread_local bool isGEThread = false;
+
 const CommonCommandTableEntry commonCommandTable[] = {
 	// From Common. No flushing but definitely need execute.
 	{ GE_CMD_OFFSETADDR, FLAG_EXECUTE, 0, &GPUCommon::Execute_OffsetAddr },
@@ -430,6 +435,7 @@ GPUCommon::GPUCommon(GraphicsContext *gfxCtx, Draw::DrawContext *draw) :
 }
 
 GPUCommon::~GPUCommon() {
+	StopGEThread();
 	// Probably not necessary.
 	PPGeSetDrawContext(nullptr);
 }
@@ -460,6 +466,10 @@ void GPUCommon::BeginHostFrame() {
 	gstate_c.Dirty(DIRTY_ALL);
 }
 
+std::string GPUCommon::GetGpuProfileString() {
+	return draw_ ? draw_->GetGpuProfileString() : "";
+}
+
 void GPUCommon::EndHostFrame() {
 
 }
@@ -574,6 +584,7 @@ void GPUCommon::PopDLQueue() {
 }
 
 bool GPUCommon::BusyDrawing() {
+	SyncThread();
 	u32 state = DrawSync(1);
 	if (state == PSP_GE_LIST_DRAWING || state == PSP_GE_LIST_STALLING) {
 		if (currentList && currentList->state != PSP_GE_DL_STATE_PAUSED) {
@@ -592,6 +603,7 @@ void GPUCommon::DumpNextFrame() {
 }
 
 u32 GPUCommon::DrawSync(int mode) {
+	SyncThread();
 	if (mode < 0 || mode > 1)
 		return SCE_KERNEL_ERROR_INVALID_MODE;
 
@@ -640,6 +652,7 @@ void GPUCommon::CheckDrawSync() {
 }
 
 int GPUCommon::ListSync(int listid, int mode) {
+	SyncThread();
 	if (listid < 0 || listid >= DisplayListMaxCount)
 		return SCE_KERNEL_ERROR_INVALID_ID;
 
@@ -684,6 +697,7 @@ int GPUCommon::ListSync(int listid, int mode) {
 }
 
 int GPUCommon::GetStack(int index, u32 stackPtr) {
+	SyncThread();
 	if (!currentList) {
 		// Seems like it doesn't return an error code?
 		return 0;
@@ -709,6 +723,7 @@ int GPUCommon::GetStack(int index, u32 stackPtr) {
 }
 
 u32 GPUCommon::EnqueueList(u32 listpc, u32 stall, int subIntrBase, PSPPointer<PspGeListArgs> args, bool head) {
+	SyncThread();
 	// TODO Check the stack values in missing arg and ajust the stack depth
 
 	// Check alignment
@@ -823,6 +838,7 @@ u32 GPUCommon::EnqueueList(u32 listpc, u32 stall, int subIntrBase, PSPPointer<Ps
 }
 
 u32 GPUCommon::DequeueList(int listid) {
+	SyncThread();
 	if (listid < 0 || listid >= DisplayListMaxCount || dls[listid].state == PSP_GE_DL_STATE_NONE)
 		return SCE_KERNEL_ERROR_INVALID_ID;
 
@@ -846,6 +862,7 @@ u32 GPUCommon::DequeueList(int listid) {
 }
 
 u32 GPUCommon::UpdateStall(int listid, u32 newstall) {
+	SyncThread();
 	if (listid < 0 || listid >= DisplayListMaxCount || dls[listid].state == PSP_GE_DL_STATE_NONE)
 		return SCE_KERNEL_ERROR_INVALID_ID;
 	auto &dl = dls[listid];
@@ -860,6 +877,7 @@ u32 GPUCommon::UpdateStall(int listid, u32 newstall) {
 }
 
 u32 GPUCommon::Continue() {
+	SyncThread();
 	if (!currentList)
 		return 0;
 
@@ -900,6 +918,7 @@ u32 GPUCommon::Continue() {
 }
 
 u32 GPUCommon::Break(int mode) {
+	SyncThread();
 	if (mode < 0 || mode > 1)
 		return SCE_KERNEL_ERROR_INVALID_MODE;
 
@@ -1064,8 +1083,21 @@ bool GPUCommon::InterpretList(DisplayList &list) {
 void GPUCommon::FastRunLoop(DisplayList &list) {
 	PROFILE_THIS_SCOPE("gpuloop");
 	const CommandInfo *cmdInfo = cmdInfo_;
+	const bool useStateRunCache = g_Config.bDisplayListStateCache;
+	// Runs of state commands can only start at the list start or after something executed.
+	bool runStart = useStateRunCache;
 	int dc = downcount;
-	for (; dc > 0; --dc) {
+	while (dc > 0) {
+		if (runStart) {
+			runStart = false;
+			int consumed = RunCachedStateRun(list.pc, dc);
+			if (consumed != 0) {
+				list.pc += consumed * 4;
+				dc -= consumed;
+				continue;
+			}
+		}
+
 		// We know that display list PCs have the upper nibble == 0 - no need to mask the pointer
 		const u32 op = *(const u32_le *)(Memory::base + list.pc);
 		const u32 cmd = op >> 24;
@@ -1076,6 +1108,7 @@ void GPUCommon::FastRunLoop(DisplayList &list) {
 				downcount = dc;
 				(this->*info.func)(op, diff);
 				dc = downcount;
+				runStart = useStateRunCache;
 			}
 		} else {
 			uint64_t flags = info.flags;
@@ -1089,6 +1122,7 @@ void GPUCommon::FastRunLoop(DisplayList &list) {
 				downcount = dc;
 				(this->*info.func)(op, diff);
 				dc = downcount;
+				runStart = useStateRunCache;
 			} else {
 				uint64_t dirty = flags >> 8;
 				if (dirty)
@@ -1096,10 +1130,98 @@ void GPUCommon::FastRunLoop(DisplayList &list) {
 			}
 		}
 		list.pc += 4;
+		dc--;
 	}
 	downcount = 0;
 }
 
+// Returns the number of words applied from the cache, or 0 if the caller should interpret normally.
+int GPUCommon::RunCachedStateRun(u32 pc, int maxWords) {
+	if (stateRunCache_.empty())
+		stateRunCache_.resize(STATE_RUN_CACHE_SIZE);
+
+	StateRunCacheEntry &entry = stateRunCache_[(pc >> 2) & (STATE_RUN_CACHE_SIZE - 1)];
+	const u32_le *src = (const u32_le *)(Memory::base + pc);
+	bool rebuild = true;
+	if (entry.addr == pc) {
+		if (entry.skip || entry.words.empty())
+			return 0;
+		if ((int)entry.words.size() > maxWords) {
+			// Probably stalled partway, let the interpreter take it.
+			return 0;
+		}
+		if (memcmp(src, entry.words.data(), entry.words.size() * sizeof(u32)) == 0) {
+			entry.misses = 0;
+			rebuild = false;
+		} else if (++entry.misses >= STATE_RUN_MAX_MISSES) {
+			// This list keeps getting rewritten, stop caching it.
+			entry.skip = true;
+			entry.words.clear();
+			entry.regOps.clear();
+			return 0;
+		}
+	} else {
+		entry.addr = pc;
+		entry.misses = 0;
+		entry.skip = false;
+	}
+
+	const CommandInfo *cmdInfo = cmdInfo_;
+	if (rebuild) {
+		int limit = std::min(maxWords, (int)STATE_RUN_MAX_WORDS);
+		int count = 0;
+		while (count < limit && (cmdInfo[src[count] >> 24].flags & (FLAG_EXECUTE | FLAG_EXECUTEONCHANGE)) == 0)
+			count++;
+
+		entry.words.clear();
+		entry.regOps.clear();
+		if (count < STATE_RUN_MIN_WORDS) {
+			// Too short to be worth it, an empty run remembers that.
+			return 0;
+		}
+
+		entry.words.assign(src, src + count);
+		s16 slots[256];
+		memset(slots, -1, sizeof(slots));
+		for (u32 op : entry.words) {
+			u32 cmd = op >> 24;
+			if (slots[cmd] < 0) {
+				slots[cmd] = (s16)entry.regOps.size();
+				entry.regOps.push_back(op);
+			} else {
+				entry.regOps[slots[cmd]] = op;
+			}
+		}
+	}
+
+	// Only the final value of each register matters, so a single flush beforehand is enough.
+	if (drawEngineCommon_->GetNumDrawCalls()) {
+		for (u32 op : entry.regOps) {
+			u32 cmd = op >> 24;
+			if ((cmdInfo[cmd].flags & FLAG_FLUSHBEFOREONCHANGE) && gstate.cmdmem[cmd] != op) {
+				drawEngineCommon_->DispatchFlush();
+				break;
+			}
+		}
+	}
+
+	uint64_t dirty = 0;
+	for (u32 op : entry.regOps) {
+		u32 cmd = op >> 24;
+		if (gstate.cmdmem[cmd] != op) {
+			gstate.cmdmem[cmd] = op;
+			dirty |= cmdInfo[cmd].flags >> 8;
+		}
+	}
+	if (dirty)
+		gstate_c.Dirty(dirty);
+	return (int)entry.words.size();
+}
+
+void GPUCommon::ClearStateRunCache() {
+	stateRunCache_.clear();
+}
+
 void GPUCommon::BeginFrame() {
 	immCount_ = 0;
 	if (dumpNextFrame_) {
@@ -1110,6 +1232,7 @@ void GPUCommon::BeginFrame() {
 		dumpThisFrame_ = false;
 	}
 	GPURecord::NotifyFrame();
+	GPUDrawProfile::NotifyFrame();
 }
 
 void GPUCommon::SlowRunLoop(DisplayList &list)
@@ -1217,10 +1340,30 @@ int GPUCommon::GetNextListIndex() {
 	}
 }
 
+// Lists normally run right here, inside the sceGe call that started them. In dual core mode
+// (SeparateGEThread) they run on the GE thread instead, and the emu thread only waits for
+// them at sync points, which are all the GPUCommon entry points that call SyncThread():
+//   - list management and sync (sceGeListSync, sceGeDrawSync, enqueue, stall updates, interrupts),
+//   - memory copies, sets, downloads, uploads and invalidations (block transfers, framebuffer reads),
+//   - savestates, vblank / flip and host frame boundaries.
+// The CPU may observe list memory or VRAM mid-frame in between, just like on the real GE.
 void GPUCommon::ProcessDLQueue() {
 	startingTicks = CoreTiming::GetTicks();
 	cyclesExecuted = 0;
 
+	if (UseGEThread()) {
+		// Every caller has synced already, so the thread is idle and we own all GE state here.
+		std::lock_guard<std::mutex> guard(geThreadLock_);
+		geThreadState_ = GEThreadState::QUEUED;
+		geThreadWake_.notify_one();
+		return;
+	}
+
+	RunDLQueue();
+}
+
+void GPUCommon::RunDLQueue() {
+
 	// Seems to be correct behaviour to process the list anyway?
 	if (startingTicks < busyTicks) {
 		DEBUG_LOG(G3D, "Can't execute a list yet, still busy for %lld ticks", busyTicks - startingTicks);
@@ -1245,10 +1388,102 @@ void GPUCommon::ProcessDLQueue() {
 
 	drawCompleteTicks = startingTicks + cyclesExecuted;
 	busyTicks = std::max(busyTicks, drawCompleteTicks);
-	__GeTriggerSync(GPU_SYNC_DRAW, 1, drawCompleteTicks);
+	TriggerGeSync(GPU_SYNC_DRAW, 1, drawCompleteTicks);
 	// Since the event is in CoreTiming, we're in sync.  Just set 0 now.
 }
 
+bool GPUCommon::UseGEThread() {
+	// The debugger and frame dumps step through lists synchronously.
+	if (!g_Config.bSeparateGEThread || GPUDebug::IsActive() || GPURecord::IsActive())
+		return false;
+
+	if (!geThread_) {
+		geThreadState_ = GEThreadState::READY;
+		geThread_ = new std::thread(&GPUCommon::GEThreadFunc, this);
+	}
+	return true;
+}
+
+void GPUCommon::GEThreadFunc() {
+	SetCurrentThreadName("GE");
+	isGEThread = true;
+
+	std::unique_lock<std::mutex> guard(geThreadLock_);
+	while (true) {
+		geThreadWake_.wait(guard, [this] { return geThreadState_ != GEThreadState::READY; });
+		if (geThreadState_ == GEThreadState::QUIT)
+			break;
+
+		guard.unlock();
+		RunDLQueue();
+		bool hasEvents = !geThreadEvents_.empty();
+		guard.lock();
+
+		geThreadState_ = GEThreadState::READY;
+		geThreadDone_.notify_all();
+		// Make sure the results get applied even if the CPU doesn't hit a sync point soon.
+		if (hasEvents)
+			__GeNotifyThreadDone();
+	}
+}
+
+void GPUCommon::StopGEThread() {
+	if (!geThread_)
+		return;
+
+	SyncThread();
+	{
+		std::lock_guard<std::mutex> guard(geThreadLock_);
+		geThreadState_ = GEThreadState::QUIT;
+		geThreadWake_.notify_one();
+	}
+	geThread_->join();
+	delete geThread_;
+	geThread_ = nullptr;
+	geThreadState_ = GEThreadState::READY;
+}
+
+void GPUCommon::SyncThread() {
+	// Nothing to wait for on the GE thread itself, or in single core mode.
+	if (isGEThread)
+		return;
+
+	if (geThreadState_ == GEThreadState::QUEUED) {
+		PROFILE_THIS_SCOPE("gesync");
+		std::unique_lock<std::mutex> guard(geThreadLock_);
+		geThreadDone_.wait(guard, [this] { return geThreadState_ != GEThreadState::QUEUED; });
+	}
+
+	if (!geThreadEvents_.empty()) {
+		std::vector<GEThreadEvent> events;
+		std::swap(events, geThreadEvents_);
+		for (const GEThreadEvent &ev : events) {
+			if (ev.interrupt)
+				__GeTriggerInterrupt(ev.id, ev.pc, ev.atTicks);
+			else
+				__GeTriggerSync(ev.type, ev.id, ev.atTicks);
+		}
+	}
+}
+
+void GPUCommon::TriggerGeSync(GPUSyncType type, int id, u64 atTicks) {
+	if (isGEThread) {
+		// CoreTiming isn't thread safe, the emu thread schedules this in SyncThread().
+		geThreadEvents_.push_back({ false, type, id, 0, atTicks });
+		return;
+	}
+	__GeTriggerSync(type, id, atTicks);
+}
+
+bool GPUCommon::TriggerGeInterrupt(int listid, u32 pc, u64 atTicks) {
+	if (isGEThread) {
+		// Same as __GeTriggerInterrupt(), which can't fail.
+		geThreadEvents_.push_back({ true, GPU_SYNC_LIST, listid, pc, atTicks });
+		return true;
+	}
+	return __GeTriggerInterrupt(listid, pc, atTicks);
+}
+
 void GPUCommon::PreExecuteOp(u32 op, u32 diff) {
 	// Nothing to do
 }
@@ -1504,7 +1739,7 @@ void GPUCommon::Execute_End(u32 op, u32 diff) {
 			}
 			// TODO: Technically, jump/call/ret should generate an interrupt, but before the pc change maybe?
 			if (currentList->interruptsEnabled && trigger) {
-				if (__GeTriggerInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
+				if (TriggerGeInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
 					currentList->pendingInterrupt = true;
 					UpdateState(GPUSTATE_INTERRUPT);
 				}
@@ -1516,7 +1751,7 @@ void GPUCommon::Execute_End(u32 op, u32 diff) {
 		case PSP_GE_SIGNAL_HANDLER_PAUSE:
 			currentList->state = PSP_GE_DL_STATE_PAUSED;
 			if (currentList->interruptsEnabled) {
-				if (__GeTriggerInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
+				if (TriggerGeInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
 					currentList->pendingInterrupt = true;
 					UpdateState(GPUSTATE_INTERRUPT);
 				}
@@ -1539,13 +1774,13 @@ void GPUCommon::Execute_End(u32 op, u32 diff) {
 				currentList->started = false;
 			}
 
-			if (currentList->interruptsEnabled && __GeTriggerInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
+			if (currentList->interruptsEnabled && TriggerGeInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
 				currentList->pendingInterrupt = true;
 			} else {
 				currentList->state = PSP_GE_DL_STATE_COMPLETED;
 				currentList->waitTicks = startingTicks + cyclesExecuted;
 				busyTicks = std::max(busyTicks, currentList->waitTicks);
-				__GeTriggerSync(GPU_SYNC_LIST, currentList->id, currentList->waitTicks);
+				TriggerGeSync(GPU_SYNC_LIST, currentList->id, currentList->waitTicks);
 			}
 			break;
 		}
@@ -1707,6 +1942,13 @@ void GPUCommon::Execute_Prim(u32 op, u32 diff) {
 	// cull mode
 	int cullMode = gstate.getCullMode();
 
+	const bool profileDraw = GPUDrawProfile::IsActive();
+	if (profileDraw) {
+		// Anything still pending isn't part of this draw.
+		drawEngineCommon_->DispatchFlush();
+		GPUDrawProfile::BeginDraw(currentList->pc, op, count, gstate.getFrameBufAddress(), gstate.isTextureMapEnabled() ? gstate.getTextureAddress(0) : 0);
+	}
+
 	uint32_t vertTypeID = GetVertTypeID(vertexType, gstate.getUVGenMode());
 	drawEngineCommon_->SubmitPrim(verts, inds, prim, count, vertTypeID, cullMode, &bytesRead);
 	// After drawing, we advance the vertexAddr (when non indexed) or indexAddr (when indexed).
@@ -1715,6 +1957,16 @@ void GPUCommon::Execute_Prim(u32 op, u32 diff) {
 	AdvanceVerts(vertexType, count, bytesRead);
 	int totalVertCount = count;
 
+	if (profileDraw) {
+		GPUDrawProfile::EndSubmit();
+		{
+			// Flushing each draw on its own costs more overall, but lets us measure it.
+			GPUDrawProfile::Scope scope(GPUDrawProfile::Cost::FLUSH);
+			drawEngineCommon_->DispatchFlush();
+		}
+		GPUDrawProfile::EndDraw(draw_ ? draw_->GetCurrentStepId() : -1);
+	}
+
 	// PRIMs are often followed by more PRIMs. Save some work and submit them immediately.
 	const u32_le *src = (const u32_le *)Memory::GetPointerUnchecked(currentList->pc + 4);
 	const u32_le *stall = currentList->stall ? (const u32_le *)Memory::GetPointerUnchecked(currentList->stall) : 0;
@@ -1729,7 +1981,7 @@ void GPUCommon::Execute_Prim(u32 op, u32 diff) {
 	if (!g_Config.bSoftwareSkinning)
 		vtypeCheckMask = 0xFFFFFFFF;
 
-	if (debugRecording_)
+	if (debugRecording_ || profileDraw)
 		goto bail;
 
 	while (src != stall) {
@@ -2063,6 +2315,15 @@ void GPUCommon::Execute_BlockTransferStart(u32 op, u32 diff) {
 	DoBlockTransfer(gstate_c.skipDrawReason);
 }
 
+// Through mode draws don't use the world, view, projection or texgen matrices at all, and
+// vertex type changes flush, so everything queued matches gstate.isModeThrough(). That lets
+// 2D sprites keep being batched when games reload matrices between them.
+void GPUCommon::FlushForMatrixChange() {
+	if (!gstate.isModeThrough()) {
+		Flush();
+	}
+}
+
 void GPUCommon::Execute_WorldMtxNum(u32 op, u32 diff) {
 	// This is almost always followed by GE_CMD_WORLDMATRIXDATA.
 	const u32_le *src = (const u32_le *)Memory::GetPointerUnchecked(currentList->pc + 4);
@@ -2081,7 +2342,7 @@ void GPUCommon::Execute_WorldMtxNum(u32 op, u32 diff) {
 		while ((src[i] >> 24) == GE_CMD_WORLDMATRIXDATA) {
 			const u32 newVal = src[i] << 8;
 			if (dst[i] != newVal) {
-				Flush();
+				FlushForMatrixChange();
 				dst[i] = newVal;
 				gstate_c.Dirty(DIRTY_WORLDMATRIX);
 			}
@@ -2104,7 +2365,7 @@ void GPUCommon::Execute_WorldMtxData(u32 op, u32 diff) {
 	int num = gstate.worldmtxnum & 0xF;
 	u32 newVal = op << 8;
 	if (num < 12 && newVal != ((const u32 *)gstate.worldMatrix)[num]) {
-		Flush();
+		FlushForMatrixChange();
 		((u32 *)gstate.worldMatrix)[num] = newVal;
 		gstate_c.Dirty(DIRTY_WORLDMATRIX);
 	}
@@ -2128,7 +2389,7 @@ void GPUCommon::Execute_ViewMtxNum(u32 op, u32 diff) {
 		while ((src[i] >> 24) == GE_CMD_VIEWMATRIXDATA) {
 			const u32 newVal = src[i] << 8;
 			if (dst[i] != newVal) {
-				Flush();
+				FlushForMatrixChange();
 				dst[i] = newVal;
 				gstate_c.Dirty(DIRTY_VIEWMATRIX);
 			}
@@ -2151,7 +2412,7 @@ void GPUCommon::Execute_ViewMtxData(u32 op, u32 diff) {
 	int num = gstate.viewmtxnum & 0xF;
 	u32 newVal = op << 8;
 	if (num < 12 && newVal != ((const u32 *)gstate.viewMatrix)[num]) {
-		Flush();
+		FlushForMatrixChange();
 		((u32 *)gstate.viewMatrix)[num] = newVal;
 		gstate_c.Dirty(DIRTY_VIEWMATRIX);
 	}
@@ -2175,7 +2436,7 @@ void GPUCommon::Execute_ProjMtxNum(u32 op, u32 diff) {
 		while ((src[i] >> 24) == GE_CMD_PROJMATRIXDATA) {
 			const u32 newVal = src[i] << 8;
 			if (dst[i] != newVal) {
-				Flush();
+				FlushForMatrixChange();
 				dst[i] = newVal;
 				gstate_c.Dirty(DIRTY_PROJMATRIX);
 			}
@@ -2198,7 +2459,7 @@ void GPUCommon::Execute_ProjMtxData(u32 op, u32 diff) {
 	int num = gstate.projmtxnum & 0x1F;    // NOTE: Changed from 0xF to catch overflows
 	u32 newVal = op << 8;
 	if (num < 0x10 && newVal != ((const u32 *)gstate.projMatrix)[num]) {
-		Flush();
+		FlushForMatrixChange();
 		((u32 *)gstate.projMatrix)[num] = newVal;
 		gstate_c.Dirty(DIRTY_PROJMATRIX);
 	}
@@ -2223,7 +2484,7 @@ void GPUCommon::Execute_TgenMtxNum(u32 op, u32 diff) {
 		while ((src[i] >> 24) == GE_CMD_TGENMATRIXDATA) {
 			const u32 newVal = src[i] << 8;
 			if (dst[i] != newVal) {
-				Flush();
+				FlushForMatrixChange();
 				dst[i] = newVal;
 				gstate_c.Dirty(DIRTY_TEXMATRIX);
 			}
@@ -2246,7 +2507,7 @@ void GPUCommon::Execute_TgenMtxData(u32 op, u32 diff) {
 	int num = gstate.texmtxnum & 0xF;
 	u32 newVal = op << 8;
 	if (num < 12 && newVal != ((const u32 *)gstate.tgenMatrix)[num]) {
-		Flush();
+		FlushForMatrixChange();
 		((u32 *)gstate.tgenMatrix)[num] = newVal;
 		gstate_c.Dirty(DIRTY_TEXMATRIX | DIRTY_FRAGMENTSHADER_STATE);  // We check the matrix to see if we need projection
 	}
@@ -2517,6 +2778,7 @@ struct DisplayList_v2 {
 };
 
 void GPUCommon::DoState(PointerWrap &p) {
+	SyncThread();
 	auto s = p.Section("GPUCommon", 1, 4);
 	if (!s)
 		return;
@@ -2592,9 +2854,11 @@ void GPUCommon::DoState(PointerWrap &p) {
 }
 
 void GPUCommon::InterruptStart(int listid) {
+	SyncThread();
 	interruptRunning = true;
 }
 void GPUCommon::InterruptEnd(int listid) {
+	SyncThread();
 	interruptRunning = false;
 	isbreak = false;
 
@@ -2623,6 +2887,7 @@ void GPUCommon::InterruptEnd(int listid) {
 
 // TODO: Maybe cleaner to keep this in GE and trigger the clear directly?
 void GPUCommon::SyncEnd(GPUSyncType waitType, int listid, bool wokeThreads) {
+	SyncThread();
 	if (waitType == GPU_SYNC_DRAW && wokeThreads)
 	{
 		for (int i = 0; i < DisplayListMaxCount; ++i) {
@@ -2845,6 +3110,7 @@ void GPUCommon::DoBlockTransfer(u32 skipDrawReason) {
 }
 
 bool GPUCommon::PerformMemoryCopy(u32 dest, u32 src, int size) {
+	SyncThread();
 	// Track stray copies of a framebuffer in RAM. MotoGP does this.
 	if (framebufferManager_->MayIntersectFramebuffer(src) || framebufferManager_->MayIntersectFramebuffer(dest)) {
 		if (!framebufferManager_->NotifyFramebufferCopy(src, dest, size, false, gstate_c.skipDrawReason)) {
@@ -2874,6 +3140,7 @@ bool GPUCommon::PerformMemoryCopy(u32 dest, u32 src, int size) {
 }
 
 bool GPUCommon::PerformMemorySet(u32 dest, u8 v, int size) {
+	SyncThread();
 	// This may indicate a memset, usually to 0, of a framebuffer.
 	if (framebufferManager_->MayIntersectFramebuffer(dest)) {
 		Memory::Memset(dest, v, size, "GPUMemset");
@@ -2891,6 +3158,7 @@ bool GPUCommon::PerformMemorySet(u32 dest, u8 v, int size) {
 }
 
 bool GPUCommon::PerformMemoryDownload(u32 dest, int size) {
+	SyncThread();
 	// Cheat a bit to force a download of the framebuffer.
 	// VRAM + 0x00400000 is simply a VRAM mirror.
 	if (Memory::IsVRAMAddress(dest)) {
@@ -2900,6 +3168,7 @@ bool GPUCommon::PerformMemoryDownload(u32 dest, int size) {
 }
 
 bool GPUCommon::PerformMemoryUpload(u32 dest, int size) {
+	SyncThread();
 	// Cheat a bit to force an upload of the framebuffer.
 	// VRAM + 0x00400000 is simply a VRAM mirror.
 	if (Memory::IsVRAMAddress(dest)) {
@@ -2910,11 +3179,25 @@ bool GPUCommon::PerformMemoryUpload(u32 dest, int size) {
 }
 
 void GPUCommon::InvalidateCache(u32 addr, int size, GPUInvalidationType type) {
+	SyncThread();
 	if (size > 0)
 		textureCache_->Invalidate(addr, size, type);
 	else
 		textureCache_->InvalidateAll(type);
 
+	if (size > 0) {
+		// Cached state runs are validated on use anyway, but don't keep dead ones around.
+		u32 end = addr + size;
+		for (StateRunCacheEntry &entry : stateRunCache_) {
+			u32 runEnd = entry.addr + (u32)entry.words.size() * 4;
+			if (entry.addr < end && runEnd > addr) {
+				entry.addr = 0;
+			}
+		}
+	} else {
+		ClearStateRunCache();
+	}
+
 	if (type != GPU_INVALIDATE_ALL && framebufferManager_->MayIntersectFramebuffer(addr)) {
 		// Vempire invalidates (with writeback) after drawing, but before blitting.
 		if (type == GPU_INVALIDATE_SAFE) {
@@ -2924,6 +3207,7 @@ void GPUCommon::InvalidateCache(u32 addr, int size, GPUInvalidationType type) {
 }
 
 void GPUCommon::NotifyVideoUpload(u32 addr, int size, int width, int format) {
+	SyncThread();
 	if (Memory::IsVRAMAddress(addr)) {
 		framebufferManager_->NotifyVideoUpload(addr, size, width, (GEBufferFormat)format);
 	}
@@ -2932,6 +3216,7 @@ void GPUCommon::NotifyVideoUpload(u32 addr, int size, int width, int format) {
 }
 
 bool GPUCommon::PerformStencilUpload(u32 dest, int size) {
+	SyncThread();
 	if (framebufferManager_->MayIntersectFramebuffer(dest)) {
 		framebufferManager_->PerformStencilUpload(dest, size);
 		return true;
@@ -3040,7 +3325,8 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		"Commands per call level: %i %i %i %i\n"
 		"Vertices: %d cached: %d uncached: %d\n"
 		"FBOs active: %d (evaluations: %d)\n"
-		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB\n"
+		"Textures: %d, dec: %d (%0.2f ms), invalidated: %d, hashed: %d kB\n"
+		"Texture hashes: %d full, %d sampled (%0.2f ms)\n"
 		"Readbacks: %d, uploads: %d, depth copies: %d\n"
 		"GPU cycles executed: %d (%f per vertex)\n",
 		gpuStats.msProcessingDisplayLists * 1000.0f,
@@ -3057,8 +3343,12 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numFramebufferEvaluations,
 		(int)textureCache_->NumLoadedTextures(),
 		gpuStats.numTexturesDecoded,
+		gpuStats.msTextureDecoding * 1000.0f,
 		gpuStats.numTextureInvalidations,
 		gpuStats.numTextureDataBytesHashed / 1024,
+		gpuStats.numTexturesHashed,
+		gpuStats.numTexturesSampleHashed,
+		gpuStats.msTextureHashing * 1000.0f,
 		gpuStats.numReadbacks,
 		gpuStats.numUploads,
 		gpuStats.numDepthCopies,
@@ -7,9 +7,11 @@
 #include "GPU/GPUState.h"
 #include "GPU/Common/GPUDebugInterface.h"
 
-#if defined(__ANDROID__)
 #include <atomic>
-#endif
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class FramebufferManagerCommon;
 class TextureCacheCommon;
@@ -103,6 +105,7 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 
 	bool InterpretList(DisplayList &list) override;
 	void ProcessDLQueue();
+	void SyncThread() override;
 	u32  UpdateStall(int listid, u32 newstall) override;
 	u32  EnqueueList(u32 listpc, u32 stall, int subIntrBase, PSPPointer<PspGeListArgs> args, bool head) override;
 	u32  DequeueList(int listid) override;
@@ -173,6 +176,7 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 
 	// Note: Not virtual!
 	void Flush();
+	void FlushForMatrixChange();
 	void DispatchFlush() override;
 
 #ifdef USE_CRT_DBG
@@ -199,6 +203,7 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	bool GetOutputFramebuffer(GPUDebugBuffer &buffer) override;
 
 	std::vector<std::string> DebugGetShaderIDs(DebugShaderType shader) override { return std::vector<std::string>(); };
+	std::string GetGpuProfileString() override;
 	std::string DebugGetShaderString(std::string id, DebugShaderType shader, DebugShaderStringType stringType) override {
 		return "N/A";
 	}
@@ -224,6 +229,7 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	void UpdateUVScaleOffset();
 
 	DisplayList* getList(int listid) override {
+		SyncThread();
 		return &dls[listid];
 	}
 
@@ -277,7 +283,13 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	void BeginFrame() override;
 	void UpdateVsyncInterval(bool force);
 
+	void RunDLQueue();
+	void TriggerGeSync(GPUSyncType type, int id, u64 atTicks);
+	bool TriggerGeInterrupt(int listid, u32 pc, u64 atTicks);
+
 	virtual void FastRunLoop(DisplayList &list);
+	int RunCachedStateRun(u32 pc, int maxWords);
+	void ClearStateRunCache();
 
 	void SlowRunLoop(DisplayList &list);
 	void UpdatePC(u32 currentPC, u32 newPC);
@@ -360,12 +372,57 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	std::string reportingPrimaryInfo_;
 	std::string reportingFullInfo_;
 
+	// A run of consecutive state commands (nothing with FLAG_EXECUTE*) starting at addr,
+	// reduced to the final value of each register it touches. The words are kept so the
+	// run can be validated against memory, since the CPU can rewrite lists without telling us.
+	struct StateRunCacheEntry {
+		u32 addr = 0;
+		u8 misses = 0;
+		bool skip = false;
+		std::vector<u32> words;
+		std::vector<u32> regOps;
+	};
+	// Direct mapped by list address.
+	enum {
+		STATE_RUN_CACHE_SIZE = 1024,
+		STATE_RUN_MIN_WORDS = 8,
+		STATE_RUN_MAX_WORDS = 1024,
+		STATE_RUN_MAX_MISSES = 4,
+	};
+	std::vector<StateRunCacheEntry> stateRunCache_;
+
 private:
+	bool UseGEThread();
+	void GEThreadFunc();
+	void StopGEThread();
+
 	void FlushImm();
 	// Debug stats.
 	double timeSteppingStarted_;
 	double timeSpentStepping_;
 	int lastVsync_ = -1;
+
+	// With SeparateGEThread, ProcessDLQueue() hands the queue to this thread and returns.
+	// The emu thread keeps running until the next sync point (see SyncThread), while
+	// HLE side effects like interrupts and sync events are collected here and applied there.
+	enum class GEThreadState {
+		READY,
+		QUEUED,
+		QUIT,
+	};
+	struct GEThreadEvent {
+		bool interrupt;
+		GPUSyncType type;
+		int id;
+		u32 pc;
+		u64 atTicks;
+	};
+	std::thread *geThread_ = nullptr;
+	std::atomic<GEThreadState> geThreadState_{ GEThreadState::READY };
+	std::mutex geThreadLock_;
+	std::condition_variable geThreadWake_;
+	std::condition_variable geThreadDone_;
+	std::vector<GEThreadEvent> geThreadEvents_;
 };
 
 struct CommonCommandTableEntry {
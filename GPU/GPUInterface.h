@@ -190,6 +190,9 @@ class GPUInterface {
 	virtual u32  Continue() = 0;
 	virtual u32  Break(int mode) = 0;
 	virtual int  GetStack(int index, u32 stackPtr) = 0;
+	// Waits for lists running on the GE thread (if any) and applies their results.
+	// Must be called on the emu thread before touching GE state or memory the GE may write.
+	virtual void SyncThread() = 0;
 
 	virtual void InterruptStart(int listid) = 0;
 	virtual void InterruptEnd(int listid) = 0;
@@ -206,6 +209,8 @@ class GPUInterface {
 
 	// Tells the GPU to update the gpuStats structure.
 	virtual void GetStats(char *buffer, size_t bufsize) = 0;
+	// Per-pass GPU timings from the backend, empty if it can't measure them.
+	virtual std::string GetGpuProfileString() = 0;
 
 	// Invalidate any cached content sourced from the specified range.
 	// If size = -1, invalidate everything.
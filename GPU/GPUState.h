@@ -479,7 +479,8 @@ enum {
 	GPU_SUPPORTS_32BIT_INT_FSHADER = FLAG_BIT(15),
 	GPU_SUPPORTS_DEPTH_TEXTURE = FLAG_BIT(16),
 	GPU_SUPPORTS_ACCURATE_DEPTH = FLAG_BIT(17),
-	// Free bits: 18-19
+	GPU_USE_BINDLESS_TEXTURES = FLAG_BIT(18),
+	// Free bits: 19
 	GPU_SUPPORTS_ANY_FRAMEBUFFER_FETCH = FLAG_BIT(20),
 	GPU_SCALE_DEPTH_FROM_24BIT_TO_16BIT = FLAG_BIT(21),
 	GPU_ROUND_FRAGMENT_DEPTH_TO_16BIT = FLAG_BIT(22),
@@ -526,19 +527,20 @@ struct GPUStateCache {
 	void SetUseShaderDepal(bool depal) {
 		if (depal != useShaderDepal) {
 			useShaderDepal = depal;
-			Dirty(DIRTY_FRAGMENTSHADER_STATE);
+			Dirty(DIRTY_FRAGMENTSHADER_TEXTURE);
 		}
 	}
 	void SetTextureFullAlpha(bool fullAlpha) {
 		if (fullAlpha != textureFullAlpha) {
 			textureFullAlpha = fullAlpha;
+			// Not just a texture bit: alpha test and color/alpha write decisions depend on this too.
 			Dirty(DIRTY_FRAGMENTSHADER_STATE);
 		}
 	}
 	void SetNeedShaderTexclamp(bool need) {
 		if (need != needShaderTexClamp) {
 			needShaderTexClamp = need;
-			Dirty(DIRTY_FRAGMENTSHADER_STATE);
+			Dirty(DIRTY_FRAGMENTSHADER_TEXTURE);
 			if (need)
 				Dirty(DIRTY_TEXCLAMP);
 		}
@@ -552,7 +554,7 @@ struct GPUStateCache {
 	void SetTextureIs3D(bool is3D) {
 		if (is3D != curTextureIs3D) {
 			curTextureIs3D = is3D;
-			Dirty(DIRTY_FRAGMENTSHADER_STATE | (is3D ? DIRTY_MIPBIAS : 0));
+			Dirty(DIRTY_FRAGMENTSHADER_TEXTURE | (is3D ? DIRTY_MIPBIAS : 0));
 		}
 	}
 	void SetFramebufferRenderMode(FramebufferRenderMode mode) {
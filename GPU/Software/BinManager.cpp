@@ -94,8 +94,8 @@ static inline void DrawBinItem(const BinItem &item, const RasterizerState &state
 
 class DrawBinItemsTask : public Task {
 public:
-	DrawBinItemsTask(BinWaitable *notify, BinManager::BinItemQueue &items, std::atomic<bool> &status, const BinManager::BinStateQueue &states)
-		: notify_(notify), items_(items), status_(status), states_(states) {
+	DrawBinItemsTask(BinWaitable *notify, BinManager *manager, int index)
+		: notify_(notify), manager_(manager), index_(index) {
 	}
 
 	TaskType Type() const override {
@@ -103,10 +103,11 @@ class DrawBinItemsTask : public Task {
 	}
 
 	void Run() override {
-		ProcessItems();
-		status_ = false;
+		ProcessItems(index_);
+		manager_->taskStatus_[index_] = false;
 		// In case of any atomic issues, do another pass.
-		ProcessItems();
+		ProcessItems(index_);
+		StealItems();
 		notify_->Drain();
 	}
 
@@ -115,18 +116,52 @@ class DrawBinItemsTask : public Task {
 	}
 
 private:
-	void ProcessItems() {
-		while (!items_.Empty()) {
-			const BinItem &item = items_.PeekNext();
-			DrawBinItem(item, states_[item.stateIndex]);
-			items_.SkipNext();
+	// Returns true if anything was drawn.  Items within a queue must draw in order, so only one
+	// task may draw from a queue at a time.  Whoever holds it re-checks after letting go, so an
+	// item pushed while another task had the queue can't get stranded.
+	bool ProcessItems(int i) {
+		BinManager::BinItemQueue &items = manager_->taskQueues_[i];
+		std::atomic<bool> &busy = manager_->taskBusy_[i];
+		const BinManager::BinStateQueue &states = manager_->states_;
+
+		bool drew = false;
+		while (!items.Empty() && !busy.exchange(true)) {
+			double st;
+			if (coreCollectDebugStats)
+				st = time_now_d();
+			while (!items.Empty()) {
+				const BinItem &item = items.PeekNext();
+				DrawBinItem(item, states[item.stateIndex]);
+				items.SkipNext();
+			}
+			if (coreCollectDebugStats)
+				manager_->taskMicros_[i] += (int64_t)((time_now_d() - st) * 1000000.0);
+			busy = false;
+			drew = true;
 		}
+		return drew;
+	}
+
+	// Once our own queue is empty, help out with any queue whose task hasn't gotten to it yet.
+	// This happens when that task's thread is busy with other work.
+	void StealItems() {
+		const int count = manager_->numTaskQueues_;
+		bool found;
+		do {
+			found = false;
+			for (int n = 1; n < count; ++n) {
+				int i = (index_ + n) % count;
+				if (ProcessItems(i)) {
+					manager_->steals_++;
+					found = true;
+				}
+			}
+		} while (found);
 	}
 
 	BinWaitable *notify_;
-	BinManager::BinItemQueue &items_;
-	std::atomic<bool> &status_;
-	const BinManager::BinStateQueue &states_;
+	BinManager *manager_;
+	int index_;
 };
 
 constexpr int BinManager::MAX_POSSIBLE_TASKS;
@@ -140,12 +175,17 @@ BinManager::BinManager() {
 	waitable_ = new BinWaitable();
 	for (auto &s : taskStatus_)
 		s = false;
-
-	int maxInitTasks = std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
-	for (int i = 0; i < maxInitTasks; ++i) {
+	for (auto &b : taskBusy_)
+		b = false;
+	for (auto &t : taskMicros_)
+		t = 0;
+	steals_ = 0;
+
+	numTaskQueues_ = std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
+	for (int i = 0; i < numTaskQueues_; ++i) {
 		taskQueues_[i].Setup();
 		for (DrawBinItemsTask *&task : taskLists_[i].tasks)
-			task = new DrawBinItemsTask(waitable_, taskQueues_[i], taskStatus_[i], states_);
+			task = new DrawBinItemsTask(waitable_, this, i);
 	}
 	states_.Setup();
 	cluts_.Setup();
@@ -372,25 +412,11 @@ void BinManager::Drain() {
 		int w2 = (queueRange_.x2 - queueRange_.x1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 		int h2 = (queueRange_.y2 - queueRange_.y1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 
-		// Always bin the entire possible range, but focus on the drawn area.
-		ScreenCoords tl(0, 0, 0);
-		ScreenCoords br(1024 * SCREEN_SCALE_FACTOR, 1024 * SCREEN_SCALE_FACTOR, 0);
-
 		taskRanges_.clear();
 		if (h2 >= 18 && w2 >= h2 * 4) {
-			int bin_w = std::max(4, (w2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, queueRange_.x1 + bin_w - 1, br.y - 1 });
-			for (int x = queueRange_.x1 + bin_w; x <= queueRange_.x2; x += bin_w) {
-				int x2 = x + bin_w > queueRange_.x2 ? br.x : x + bin_w;
-				taskRanges_.push_back(BinCoords{ x, tl.y, x2 - 1, br.y - 1 });
-			}
+			SplitTaskRanges(true, w2);
 		} else if (h2 >= 18 && w2 >= 18) {
-			int bin_h = std::max(4, (h2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, br.x - 1, queueRange_.y1 + bin_h - 1 });
-			for (int y = queueRange_.y1 + bin_h; y <= queueRange_.y2; y += bin_h) {
-				int y2 = y + bin_h > queueRange_.y2 ? br.y : y + bin_h;
-				taskRanges_.push_back(BinCoords{ tl.x, y, br.x - 1, y2 - 1 });
-			}
+			SplitTaskRanges(false, h2);
 		}
 
 		tasksSplit_ = true;
@@ -442,6 +468,66 @@ void BinManager::Drain() {
 	}
 }
 
+// Splits the drawn area into up to maxTasks_ strips along one axis.  The cuts go where they'll
+// balance the queued primitive area between tasks, rather than just the screen area.
+void BinManager::SplitTaskRanges(bool alongX, int units) {
+	constexpr int UNIT_SIZE = SCREEN_SCALE_FACTOR * 2;
+	// Don't make any strip thinner than this many units.
+	constexpr int MIN_UNITS = 4;
+	const int origin = alongX ? queueRange_.x1 : queueRange_.y1;
+
+	// Accumulate the queued area per unit along the axis, as deltas to reduce large prims fast.
+	densityScratch_.assign(units + 1, 0);
+	for (size_t i = 0; i < queue_.Size(); ++i) {
+		const BinCoords &range = queue_.Peek(i).range;
+		int start = ((alongX ? range.x1 : range.y1) - origin) / UNIT_SIZE;
+		int end = ((alongX ? range.x2 : range.y2) - origin) / UNIT_SIZE;
+		int cross = ((alongX ? range.y2 - range.y1 : range.x2 - range.x1) + UNIT_SIZE) / UNIT_SIZE;
+		start = std::max(start, 0);
+		end = std::min(end, units - 1);
+		if (end < start)
+			continue;
+		densityScratch_[start] += cross;
+		densityScratch_[end + 1] -= cross;
+	}
+
+	// Count every unit at least once, so that with nothing queued this is an even split.
+	int64_t total = 0;
+	int sum = 0;
+	for (int u = 0; u < units; ++u) {
+		sum += densityScratch_[u];
+		densityScratch_[u] = sum + 1;
+		total += sum + 1;
+	}
+
+	// Always bin the entire possible range, but focus on the drawn area.
+	const int limit = 1024 * SCREEN_SCALE_FACTOR;
+	int last = 0;
+	int lastUnit = 0;
+	int64_t acc = 0;
+	for (int u = 0; u < units && (int)taskRanges_.size() < maxTasks_ - 1; ++u) {
+		acc += densityScratch_[u];
+		int64_t target = total * (int64_t)(taskRanges_.size() + 1) / maxTasks_;
+		if (acc < target || u + 1 - lastUnit < MIN_UNITS || units - (u + 1) < MIN_UNITS)
+			continue;
+
+		int cut = origin + (u + 1) * UNIT_SIZE;
+		if (alongX)
+			taskRanges_.push_back(BinCoords{ last, 0, cut - 1, limit - 1 });
+		else
+			taskRanges_.push_back(BinCoords{ 0, last, limit - 1, cut - 1 });
+		last = cut;
+		lastUnit = u + 1;
+	}
+
+	if (taskRanges_.empty())
+		return;
+	if (alongX)
+		taskRanges_.push_back(BinCoords{ last, 0, limit - 1, limit - 1 });
+	else
+		taskRanges_.push_back(BinCoords{ 0, last, limit - 1, limit - 1 });
+}
+
 void BinManager::Flush(const char *reason) {
 	double st;
 	if (coreCollectDebugStats)
@@ -536,17 +622,34 @@ void BinManager::GetStats(char *buffer, size_t bufsize) {
 		recentTotal += it.second;
 	}
 
+	// Time spent drawing each bin this frame, to show how evenly the work was split.
+	double binSlowest = 0.0;
+	double binFastest = 0.0;
+	double binTotal = 0.0;
+	int binsUsed = 0;
+	for (int i = 0; i < numTaskQueues_; ++i) {
+		double t = (double)taskMicros_[i] / 1000000.0;
+		if (t <= 0.0)
+			continue;
+		binSlowest = std::max(binSlowest, t);
+		binFastest = binsUsed == 0 ? t : std::min(binFastest, t);
+		binTotal += t;
+		binsUsed++;
+	}
+
 	snprintf(buffer, bufsize,
 		"Slowest individual flush: %s (%0.4f)\n"
 		"Slowest frame flush: %s (%0.4f)\n"
 		"Slowest recent flush: %s (%0.4f)\n"
 		"Total flush time: %0.4f (%05.2f%%, last 2: %05.2f%%)\n"
-		"Thread enqueues: %d, count %d",
+		"Thread enqueues: %d, count %d, steals %d\n"
+		"Bin draw time: slowest %0.4f, fastest %0.4f, avg %0.4f",
 		slowestFlushReason_, slowestFlushTime_,
 		slowestTotalReason, slowestTotalTime,
 		slowestRecentReason, slowestRecentTime,
 		allTotal, allTotal * (6000.0 / 1.001), recentTotal * (3000.0 / 1.001),
-		enqueues_, mostThreads_);
+		enqueues_, mostThreads_, (int)steals_,
+		binSlowest, binFastest, binsUsed == 0 ? 0.0 : binTotal / binsUsed);
 }
 
 void BinManager::ResetStats() {
@@ -556,6 +659,9 @@ void BinManager::ResetStats() {
 	slowestFlushTime_ = 0.0;
 	enqueues_ = 0;
 	mostThreads_ = 0;
+	steals_ = 0;
+	for (auto &t : taskMicros_)
+		t = 0;
 }
 
 inline BinCoords BinCoords::Intersect(const BinCoords &range) const {
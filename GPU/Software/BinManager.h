@@ -246,9 +246,14 @@ class BinManager {
 	int maxTasks_ = 1;
 	bool tasksSplit_ = false;
 	std::vector<BinCoords> taskRanges_;
+	std::vector<int> densityScratch_;
+	int numTaskQueues_ = 0;
 	BinItemQueue taskQueues_[MAX_POSSIBLE_TASKS];
 	BinTaskList taskLists_[MAX_POSSIBLE_TASKS];
+	// Set while a task for this queue is enqueued or running.
 	std::atomic<bool> taskStatus_[MAX_POSSIBLE_TASKS];
+	// Set while some task (maybe not the queue's own) is drawing from the queue.
+	std::atomic<bool> taskBusy_[MAX_POSSIBLE_TASKS];
 	BinWaitable *waitable_ = nullptr;
 
 	BinDirtyRange pendingWrites_[2]{};
@@ -261,6 +266,8 @@ class BinManager {
 	int lastFlipstats_ = 0;
 	int enqueues_ = 0;
 	int mostThreads_ = 0;
+	std::atomic<int> steals_;
+	std::atomic<int64_t> taskMicros_[MAX_POSSIBLE_TASKS];
 
 	bool HasTextureWrite(const Rasterizer::RasterizerState &state);
 	BinCoords Scissor(BinCoords range);
@@ -268,6 +275,7 @@ class BinManager {
 	BinCoords Range(const VertexData &v0, const VertexData &v1);
 	BinCoords Range(const VertexData &v0);
 	void Expand(const BinCoords &range);
+	void SplitTaskRanges(bool alongX, int units);
 
 	friend class DrawBinItemsTask;
 };
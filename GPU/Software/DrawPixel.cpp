@@ -506,6 +506,22 @@ SingleFunc GetSingleFunc(const PixelFuncID &id) {
 	return jitCache->GenericSingle(id);
 }
 
+void GetCompiledSingleIDs(std::vector<PixelFuncID> &ids) {
+	jitCache->GetCompiledIDs(ids);
+}
+
+void QueuePrecompileSingle(const std::vector<PixelFuncID> &ids) {
+	jitCache->QueuePrecompile(ids);
+}
+
+void PrecompileSingle(const PixelFuncID &id) {
+	jitCache->Precompile(id);
+}
+
+void CancelPrecompileSingle() {
+	jitCache->CancelPrecompile();
+}
+
 SingleFunc PixelJitCache::GenericSingle(const PixelFuncID &id) {
 	if (id.clearMode) {
 		switch (id.fbFormat) {
@@ -575,8 +591,16 @@ SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id) {
 		return it->second;
 	}
 
+	// Don't stall on this if it'll be compiled in the background soon anyway.
+	if (precompileQueue_.count(id) != 0)
+		return nullptr;
+
+	return CompileAndCache(id);
+}
+
+SingleFunc PixelJitCache::CompileAndCache(const PixelFuncID &id) {
 	// x64 is typically 200-500 bytes, but let's be safe.
-	if (GetSpaceLeft() < 65536) {
+	if (GetSpaceLeft() < MIN_SPACE_LEFT) {
 		Clear();
 	}
 
@@ -591,6 +615,39 @@ SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id) {
 	return nullptr;
 }
 
+void PixelJitCache::GetCompiledIDs(std::vector<PixelFuncID> &ids) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+	ids.reserve(ids.size() + cache_.size());
+	for (const auto &it : cache_)
+		ids.push_back(it.first);
+}
+
+void PixelJitCache::QueuePrecompile(const std::vector<PixelFuncID> &ids) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+	for (const PixelFuncID &id : ids) {
+		if (cache_.find(id) == cache_.end())
+			precompileQueue_.insert(id);
+	}
+}
+
+void PixelJitCache::Precompile(const PixelFuncID &id) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+	// If it's not queued anymore, it was either cancelled or already compiled.
+	if (precompileQueue_.erase(id) == 0 || cache_.find(id) != cache_.end())
+		return;
+	// Clearing would pull funcs out from under queued and running draws, leave the rest to compile on demand.
+	if (GetSpaceLeft() < MIN_SPACE_LEFT) {
+		precompileQueue_.clear();
+		return;
+	}
+	CompileAndCache(id);
+}
+
+void PixelJitCache::CancelPrecompile() {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+	precompileQueue_.clear();
+}
+
 void ComputePixelBlendState(PixelBlendState &state, const PixelFuncID &id) {
 	switch (id.AlphaBlendEq()) {
 	case GE_BLENDMODE_MUL_AND_ADD:
@@ -22,6 +22,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include "GPU/Math3D.h"
 #include "GPU/Software/FuncId.h"
 #include "GPU/Software/RasterizerRegCache.h"
@@ -38,6 +39,13 @@ namespace Rasterizer {
 typedef void (SOFTRAST_CALL *SingleFunc)(int x, int y, int z, int fog, Vec4IntArg color_in, const PixelFuncID &pixelID);
 SingleFunc GetSingleFunc(const PixelFuncID &id);
 
+// For the on-disk list of IDs, so a game's functions can be compiled ahead of time.
+void GetCompiledSingleIDs(std::vector<PixelFuncID> &ids);
+// Queued IDs use the generic func (rather than stalling) until Precompile() gets to them.
+void QueuePrecompileSingle(const std::vector<PixelFuncID> &ids);
+void PrecompileSingle(const PixelFuncID &id);
+void CancelPrecompileSingle();
+
 void Init();
 void Shutdown();
 
@@ -61,9 +69,19 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	SingleFunc GenericSingle(const PixelFuncID &id);
 	void Clear() override;
 
+	void GetCompiledIDs(std::vector<PixelFuncID> &ids);
+	void QueuePrecompile(const std::vector<PixelFuncID> &ids);
+	void Precompile(const PixelFuncID &id);
+	void CancelPrecompile();
+
 	std::string DescribeCodePtr(const u8 *ptr) override;
 
 private:
+	// Below this, the code space gets cleared before compiling.  x64 funcs are typically 200-500 bytes.
+	static const int MIN_SPACE_LEFT = 65536;
+
+	// Must hold jitCacheLock.
+	SingleFunc CompileAndCache(const PixelFuncID &id);
 	SingleFunc CompileSingle(const PixelFuncID &id);
 
 	RegCache::Reg GetPixelID();
@@ -101,6 +119,7 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 
 	std::unordered_map<PixelFuncID, SingleFunc> cache_;
 	std::unordered_map<PixelFuncID, const u8 *> addresses_;
+	std::unordered_set<PixelFuncID> precompileQueue_;
 
 	const u8 *constBlendHalf_11_4s_ = nullptr;
 	const u8 *constBlendInvert_11_4s_ = nullptr;
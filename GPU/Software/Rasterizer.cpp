@@ -41,6 +41,7 @@
 #if defined(_M_SSE)
 #include <emmintrin.h>
 #include <smmintrin.h>
+#include <immintrin.h>
 #endif
 
 namespace Rasterizer {
@@ -86,6 +87,57 @@ static inline Vec2<float> Interpolate(const Vec2<float> &c0, const Vec2<float> &
 #endif
 }
 
+#if defined(_M_SSE) && !PPSSPP_ARCH(X86)
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx")]]
+#endif
+static inline __m256 DupToAVX(__m128 v) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(v), v, 1);
+}
+
+// Same math as Interpolate() for each pixel of a quad, but two pixels per 256-bit op.
+// The ops run in the same order per lane, so the results are identical.
+template <typename T>
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx")]]
+#endif
+static void InterpolateQuadAVX(const T &c0, const T &c1, const T &c2, const Vec4<int> &w0, const Vec4<int> &w1, const Vec4<int> &w2, const Vec4<float> &wsum_recip, T out[4]) {
+	const __m256 c0f = DupToAVX(_mm_cvtepi32_ps(c0.ivec));
+	const __m256 c1f = DupToAVX(_mm_cvtepi32_ps(c1.ivec));
+	const __m256 c2f = DupToAVX(_mm_cvtepi32_ps(c2.ivec));
+	const __m256 w0f = DupToAVX(_mm_cvtepi32_ps(w0.ivec));
+	const __m256 w1f = DupToAVX(_mm_cvtepi32_ps(w1.ivec));
+	const __m256 w2f = DupToAVX(_mm_cvtepi32_ps(w2.ivec));
+	const __m256 wsum = DupToAVX(wsum_recip.vec);
+
+	for (int pair = 0; pair < 2; ++pair) {
+		// Spread pixel pair * 2 to the low half and pair * 2 + 1 to the high half.
+		const __m256i sel = _mm256_setr_epi32(pair * 2, pair * 2, pair * 2, pair * 2, pair * 2 + 1, pair * 2 + 1, pair * 2 + 1, pair * 2 + 1);
+		__m256 v = _mm256_mul_ps(c0f, _mm256_permutevar_ps(w0f, sel));
+		v = _mm256_add_ps(v, _mm256_mul_ps(c1f, _mm256_permutevar_ps(w1f, sel)));
+		v = _mm256_add_ps(v, _mm256_mul_ps(c2f, _mm256_permutevar_ps(w2f, sel)));
+		v = _mm256_mul_ps(v, _mm256_permutevar_ps(wsum, sel));
+		const __m256i result = _mm256_cvtps_epi32(v);
+		out[pair * 2].ivec = _mm256_castsi256_si128(result);
+		out[pair * 2 + 1].ivec = _mm256_extractf128_si256(result, 1);
+	}
+}
+#endif
+
+template <typename T>
+static inline void InterpolateQuad(bool useAVX, const T &c0, const T &c1, const T &c2, const Vec4<int> &w0, const Vec4<int> &w1, const Vec4<int> &w2, const Vec4<float> &wsum_recip, const Vec4<int> &mask, T out[4]) {
+#if defined(_M_SSE) && !PPSSPP_ARCH(X86)
+	if (useAVX) {
+		InterpolateQuadAVX(c0, c1, c2, w0, w1, w2, wsum_recip, out);
+		return;
+	}
+#endif
+	for (int i = 0; i < 4; ++i) {
+		if (mask[i] >= 0)
+			out[i] = Interpolate(c0, c1, c2, w0[i], w1[i], w2[i], wsum_recip[i]);
+	}
+}
+
 static inline Vec4<float> Interpolate(const float &c0, const float &c1, const float &c2, const Vec4<float> &w0, const Vec4<float> &w1, const Vec4<float> &w2, const Vec4<float> &wsum_recip) {
 #if defined(_M_SSE) && !PPSSPP_ARCH(X86)
 	__m128 v = _mm_mul_ps(w0.vec, _mm_set1_ps(c0));
@@ -709,6 +761,7 @@ void DrawTriangleSlice(
 	const bool flatColor0 = flatColorAll || (v0.color0 == v1.color0 && v0.color0 == v2.color0);
 	const bool flatColor1 = flatColorAll || (v0.color1 == v1.color1 && v0.color1 == v2.color1);
 	const bool noFog = clearMode || !pixelID.applyFog || (v0.fogdepth >= 1.0f && v1.fogdepth >= 1.0f && v2.fogdepth >= 1.0f);
+	const bool useAVX = useSSE4 && cpu_info.bAVX;
 
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED) || defined(SOFTGPU_MEMORY_TAGGING_BASIC)
 	uint32_t bpp = pixelID.FBFormat() == GE_FORMAT_8888 ? 4 : 2;
@@ -757,10 +810,7 @@ void DrawTriangleSlice(
 				// Color interpolation is not perspective corrected on the PSP.
 				Vec4<int> prim_color[4];
 				if (!flatColor0) {
-					for (int i = 0; i < 4; ++i) {
-						if (mask[i] >= 0)
-							prim_color[i] = Interpolate(v0.color0, v1.color0, v2.color0, w0[i], w1[i], w2[i], wsum_recip[i]);
-					}
+					InterpolateQuad(useAVX, v0.color0, v1.color0, v2.color0, w0, w1, w2, wsum_recip, mask, prim_color);
 				} else {
 					for (int i = 0; i < 4; ++i) {
 						prim_color[i] = v2.color0;
@@ -768,10 +818,7 @@ void DrawTriangleSlice(
 				}
 				Vec3<int> sec_color[4];
 				if (!flatColor1) {
-					for (int i = 0; i < 4; ++i) {
-						if (mask[i] >= 0)
-							sec_color[i] = Interpolate(v0.color1, v1.color1, v2.color1, w0[i], w1[i], w2[i], wsum_recip[i]);
-					}
+					InterpolateQuad(useAVX, v0.color1, v1.color1, v2.color1, w0, w1, w2, wsum_recip, mask, sec_color);
 				} else {
 					for (int i = 0; i < 4; ++i) {
 						sec_color[i] = v2.color1;
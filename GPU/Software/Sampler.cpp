@@ -93,6 +93,28 @@ FetchFunc GetFetchFunc(SamplerID id) {
 	return &SampleFetch;
 }
 
+void GetCompiledIDs(std::vector<SamplerID> &ids) {
+	jitCache->GetCompiledIDs(ids);
+}
+
+void QueuePrecompile(const std::vector<SamplerID> &ids) {
+	jitCache->QueuePrecompile(ids);
+}
+
+void Precompile(const SamplerID &id) {
+	jitCache->Precompile(id);
+}
+
+void CancelPrecompile() {
+	jitCache->CancelPrecompile();
+}
+
+static inline SamplerID PrecompileKey(SamplerID id) {
+	id.linear = false;
+	id.fetch = false;
+	return id;
+}
+
 // 256k should be enough.
 SamplerJitCache::SamplerJitCache() : Rasterizer::CodeBlock(1024 * 64 * 4) {
 }
@@ -145,6 +167,10 @@ NearestFunc SamplerJitCache::GetNearest(const SamplerID &id) {
 	if (it != cache_.end())
 		return (NearestFunc)it->second;
 
+	// Don't stall on this if it'll be compiled in the background soon anyway.
+	if (precompileQueue_.count(PrecompileKey(id)) != 0)
+		return nullptr;
+
 	Compile(id);
 
 	// Okay, should be there now.
@@ -161,6 +187,10 @@ LinearFunc SamplerJitCache::GetLinear(const SamplerID &id) {
 	if (it != cache_.end())
 		return (LinearFunc)it->second;
 
+	// Don't stall on this if it'll be compiled in the background soon anyway.
+	if (precompileQueue_.count(PrecompileKey(id)) != 0)
+		return nullptr;
+
 	Compile(id);
 
 	// Okay, should be there now.
@@ -177,6 +207,10 @@ FetchFunc SamplerJitCache::GetFetch(const SamplerID &id) {
 	if (it != cache_.end())
 		return (FetchFunc)it->second;
 
+	// Don't stall on this if it'll be compiled in the background soon anyway.
+	if (precompileQueue_.count(PrecompileKey(id)) != 0)
+		return nullptr;
+
 	Compile(id);
 
 	// Okay, should be there now.
@@ -186,9 +220,46 @@ FetchFunc SamplerJitCache::GetFetch(const SamplerID &id) {
 	return nullptr;
 }
 
+void SamplerJitCache::GetCompiledIDs(std::vector<SamplerID> &ids) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+	for (const auto &it : cache_) {
+		// Each ID has three funcs cached, just report the one.
+		if (!it.first.linear && !it.first.fetch)
+			ids.push_back(it.first);
+	}
+}
+
+void SamplerJitCache::QueuePrecompile(const std::vector<SamplerID> &ids) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+	for (const SamplerID &id : ids) {
+		SamplerID key = PrecompileKey(id);
+		if (cache_.find(key) == cache_.end())
+			precompileQueue_.insert(key);
+	}
+}
+
+void SamplerJitCache::Precompile(const SamplerID &id) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+	SamplerID key = PrecompileKey(id);
+	// If it's not queued anymore, it was either cancelled or already compiled.
+	if (precompileQueue_.erase(key) == 0 || cache_.find(key) != cache_.end())
+		return;
+	// Clearing would pull funcs out from under queued and running draws, leave the rest to compile on demand.
+	if (GetSpaceLeft() < MIN_SPACE_LEFT) {
+		precompileQueue_.clear();
+		return;
+	}
+	Compile(key);
+}
+
+void SamplerJitCache::CancelPrecompile() {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+	precompileQueue_.clear();
+}
+
 void SamplerJitCache::Compile(const SamplerID &id) {
 	// This should be sufficient.
-	if (GetSpaceLeft() < 16384) {
+	if (GetSpaceLeft() < MIN_SPACE_LEFT) {
 		Clear();
 	}
 
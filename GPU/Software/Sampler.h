@@ -20,6 +20,8 @@
 #include "ppsspp_config.h"
 
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "GPU/Math3D.h"
 #include "GPU/Software/FuncId.h"
 #include "GPU/Software/RasterizerRegCache.h"
@@ -42,6 +44,13 @@ NearestFunc GetNearestFunc(SamplerID id);
 typedef Rasterizer::Vec4IntResult (SOFTRAST_CALL *LinearFunc)(float s, float t, int x, int y, Rasterizer::Vec4IntArg prim_color, const u8 *const *tptr, const int *bufw, int level, int levelFrac, const SamplerID &samplerID);
 LinearFunc GetLinearFunc(SamplerID id);
 
+// For the on-disk list of IDs, so a game's functions can be compiled ahead of time.
+void GetCompiledIDs(std::vector<SamplerID> &ids);
+// Queued IDs use the generic funcs (rather than stalling) until Precompile() gets to them.
+void QueuePrecompile(const std::vector<SamplerID> &ids);
+void Precompile(const SamplerID &id);
+void CancelPrecompile();
+
 void Init();
 void Shutdown();
 
@@ -57,9 +66,17 @@ class SamplerJitCache : public Rasterizer::CodeBlock {
 	FetchFunc GetFetch(const SamplerID &id);
 	void Clear() override;
 
+	void GetCompiledIDs(std::vector<SamplerID> &ids);
+	void QueuePrecompile(const std::vector<SamplerID> &ids);
+	void Precompile(const SamplerID &id);
+	void CancelPrecompile();
+
 	std::string DescribeCodePtr(const u8 *ptr) override;
 
 private:
+	// Below this, the code space gets cleared before compiling.
+	static const int MIN_SPACE_LEFT = 16384;
+
 	void Compile(const SamplerID &id);
 	FetchFunc CompileFetch(const SamplerID &id);
 	NearestFunc CompileNearest(const SamplerID &id);
@@ -122,6 +139,8 @@ class SamplerJitCache : public Rasterizer::CodeBlock {
 
 	std::unordered_map<SamplerID, NearestFunc> cache_;
 	std::unordered_map<SamplerID, const u8 *> addresses_;
+	// These are stored with linear and fetch off, since Compile() does all three together.
+	std::unordered_set<SamplerID> precompileQueue_;
 };
 
 #if defined(__clang__) || defined(__GNUC__)
@@ -15,8 +15,14 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <set>
+#include "Common/File/FileUtil.h"
 #include "Common/System/Display.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
 #include "Common/GPU/OpenGL/GLFeatures.h"
 
 #include "GPU/GPUState.h"
@@ -27,6 +33,8 @@
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/Core.h"
+#include "Core/ELF/ParamSFO.h"
+#include "Core/System.h"
 #include "Core/Debugger/MemBlockInfo.h"
 #include "Core/MemMap.h"
 #include "Core/HLE/sceKernelInterrupt.h"
@@ -56,6 +64,75 @@ u32 clut[4096];
 FormatBuffer fb;
 FormatBuffer depthbuf;
 
+// Compiles the pixel and sampler funcs from the disk cache, off the emulation thread.
+class SoftJitPrecompileTask : public Task {
+public:
+	SoftJitPrecompileTask(std::vector<PixelFuncID> &&pixelIDs, std::vector<SamplerID> &&samplerIDs)
+		: pixelIDs_(std::move(pixelIDs)), samplerIDs_(std::move(samplerIDs)) {
+	}
+
+	TaskType Type() const override {
+		return TaskType::CPU_BACKGROUND;
+	}
+
+	void Run() override {
+		double start = time_now_d();
+		size_t count = 0;
+		for (const PixelFuncID &id : pixelIDs_) {
+			if (cancelled_)
+				break;
+			Rasterizer::PrecompileSingle(id);
+			count++;
+		}
+		for (const SamplerID &id : samplerIDs_) {
+			if (cancelled_)
+				break;
+			Sampler::Precompile(id);
+			count++;
+		}
+		NOTICE_LOG(G3D, "Precompile: Compiled %d software renderer funcs in %0.1f milliseconds", (int)count, (time_now_d() - start) * 1000.0);
+	}
+
+	void Cancel() override {
+		cancelled_ = true;
+	}
+
+	void Release() override {
+		// Owned by SoftGPU, which waits for this.  Also called without Run() on teardown.
+		std::lock_guard<std::mutex> guard(lock_);
+		done_ = true;
+		cond_.notify_all();
+	}
+
+	void Wait() {
+		std::unique_lock<std::mutex> guard(lock_);
+		while (!done_)
+			cond_.wait(guard);
+	}
+
+private:
+	std::vector<PixelFuncID> pixelIDs_;
+	std::vector<SamplerID> samplerIDs_;
+	std::atomic<bool> cancelled_{};
+	std::mutex lock_;
+	std::condition_variable cond_;
+	bool done_ = false;
+};
+
+struct SoftJitCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numPixelIDs;
+	uint32_t numSamplerIDs;
+};
+
+static const uint32_t SOFT_JIT_CACHE_MAGIC = 0x54494A53;  // SJIT
+// Bump this when the PixelFuncID or SamplerID key layout changes.
+static const uint32_t SOFT_JIT_CACHE_VERSION = 1;
+// Roughly what fits in the jit code spaces, precompiling more than that would just get dropped.
+static const size_t MAX_SAVED_PIXEL_IDS = 384;
+static const size_t MAX_SAVED_SAMPLER_IDS = 64;
+
 struct CommandInfo {
 	uint64_t flags;
 	SoftGPU::CmdFunc func;
@@ -438,6 +515,13 @@ SoftGPU::SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	// Push the initial CLUT buffer in case it's all zero (we push only on change.)
 	drawEngine_->transformUnit.NotifyClutUpdate(clut);
 
+	std::string discID = g_paramSFO.GetDiscID();
+	if (discID.size() && g_Config.bShaderCache && g_Config.bSoftwareRenderingJit) {
+		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+		jitCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".softjitcache");
+		LoadJitCache(jitCachePath_);
+	}
+
 	// No need to flush for simple parameter changes.
 	flushOnParams_ = false;
 
@@ -472,6 +556,15 @@ SoftGPU::~SoftGPU() {
 		fbTex = nullptr;
 	}
 
+	if (precompileTask_) {
+		precompileTask_->Cancel();
+		precompileTask_->Wait();
+		delete precompileTask_;
+		precompileTask_ = nullptr;
+	}
+	if (jitCachePath_.Valid())
+		SaveJitCache(jitCachePath_);
+
 	delete presentation_;
 	delete drawEngine_;
 
@@ -479,6 +572,101 @@ SoftGPU::~SoftGPU() {
 	Rasterizer::Shutdown();
 }
 
+void SoftGPU::LoadJitCache(const Path &filename) {
+	FILE *f = File::OpenCFile(filename, "rb");
+	if (!f)
+		return;
+
+	SoftJitCacheHeader header{};
+	bool valid = fread(&header, sizeof(header), 1, f) == 1;
+	valid = valid && header.magic == SOFT_JIT_CACHE_MAGIC && header.version == SOFT_JIT_CACHE_VERSION;
+	// Sanity check, there shouldn't ever be this many.
+	valid = valid && header.numPixelIDs < 0x10000 && header.numSamplerIDs < 0x10000;
+	if (valid) {
+		loadedPixelKeys_.resize(header.numPixelIDs);
+		loadedSamplerKeys_.resize(header.numSamplerIDs);
+		valid = fread(loadedPixelKeys_.data(), sizeof(uint64_t), header.numPixelIDs, f) == header.numPixelIDs;
+		valid = valid && fread(loadedSamplerKeys_.data(), sizeof(uint32_t), header.numSamplerIDs, f) == header.numSamplerIDs;
+	}
+	fclose(f);
+
+	if (!valid) {
+		WARN_LOG(G3D, "Ignoring invalid software renderer jit cache '%s'", filename.c_str());
+		loadedPixelKeys_.clear();
+		loadedSamplerKeys_.clear();
+		return;
+	}
+
+	std::vector<PixelFuncID> pixelIDs;
+	pixelIDs.resize(loadedPixelKeys_.size());
+	for (size_t i = 0; i < loadedPixelKeys_.size(); ++i)
+		pixelIDs[i].fullKey = loadedPixelKeys_[i];
+	std::vector<SamplerID> samplerIDs;
+	samplerIDs.resize(loadedSamplerKeys_.size());
+	for (size_t i = 0; i < loadedSamplerKeys_.size(); ++i)
+		samplerIDs[i].fullKey = loadedSamplerKeys_[i];
+
+	Rasterizer::QueuePrecompileSingle(pixelIDs);
+	Sampler::QueuePrecompile(samplerIDs);
+
+	INFO_LOG(G3D, "Precompiling %d pixel and %d sampler funcs from '%s'", (int)pixelIDs.size(), (int)samplerIDs.size(), filename.c_str());
+	precompileTask_ = new SoftJitPrecompileTask(std::move(pixelIDs), std::move(samplerIDs));
+	g_threadManager.EnqueueTask(precompileTask_);
+}
+
+// Adds keys until the set reaches max.
+template <typename K, typename C>
+static void AddJitCacheKeys(std::set<K> &keys, const C &from, size_t max) {
+	for (auto it = from.begin(); it != from.end() && keys.size() < max; ++it)
+		keys.insert(*it);
+}
+
+void SoftGPU::SaveJitCache(const Path &filename) {
+	// What got compiled this time comes first.  Then keep what we loaded, in case the precompile got
+	// cancelled or the cache was cleared, but only up to about what fits in the code space at once.
+	std::vector<PixelFuncID> pixelIDs;
+	Rasterizer::GetCompiledSingleIDs(pixelIDs);
+	std::vector<uint64_t> compiledPixelKeys;
+	for (const PixelFuncID &id : pixelIDs)
+		compiledPixelKeys.push_back(id.fullKey);
+	std::vector<SamplerID> samplerIDs;
+	Sampler::GetCompiledIDs(samplerIDs);
+	std::vector<uint32_t> compiledSamplerKeys;
+	for (const SamplerID &id : samplerIDs)
+		compiledSamplerKeys.push_back(id.fullKey);
+
+	std::set<uint64_t> pixelKeys;
+	AddJitCacheKeys(pixelKeys, compiledPixelKeys, MAX_SAVED_PIXEL_IDS);
+	AddJitCacheKeys(pixelKeys, loadedPixelKeys_, MAX_SAVED_PIXEL_IDS);
+	std::set<uint32_t> samplerKeys;
+	AddJitCacheKeys(samplerKeys, compiledSamplerKeys, MAX_SAVED_SAMPLER_IDS);
+	AddJitCacheKeys(samplerKeys, loadedSamplerKeys_, MAX_SAVED_SAMPLER_IDS);
+
+	// Nothing new, no need to write.
+	std::set<uint64_t> loadedPixelSet(loadedPixelKeys_.begin(), loadedPixelKeys_.end());
+	std::set<uint32_t> loadedSamplerSet(loadedSamplerKeys_.begin(), loadedSamplerKeys_.end());
+	if (pixelKeys == loadedPixelSet && samplerKeys == loadedSamplerSet)
+		return;
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f)
+		return;
+
+	SoftJitCacheHeader header;
+	header.magic = SOFT_JIT_CACHE_MAGIC;
+	header.version = SOFT_JIT_CACHE_VERSION;
+	header.numPixelIDs = (uint32_t)pixelKeys.size();
+	header.numSamplerIDs = (uint32_t)samplerKeys.size();
+	fwrite(&header, sizeof(header), 1, f);
+	for (uint64_t key : pixelKeys)
+		fwrite(&key, sizeof(key), 1, f);
+	for (uint32_t key : samplerKeys)
+		fwrite(&key, sizeof(key), 1, f);
+	fclose(f);
+
+	INFO_LOG(G3D, "Saved %d pixel and %d sampler funcs to '%s'", (int)pixelKeys.size(), (int)samplerKeys.size(), filename.c_str());
+}
+
 void SoftGPU::SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) {
 	// Seems like this can point into RAM, but should be VRAM if not in RAM.
 	displayFramebuf_ = (framebuf & 0xFF000000) == 0 ? 0x44000000 | framebuf : framebuf;
@@ -1118,7 +1306,8 @@ void SoftGPU::GetStats(char *buffer, size_t bufsize) {
 
 void SoftGPU::InvalidateCache(u32 addr, int size, GPUInvalidationType type)
 {
-	// Nothing to invalidate.
+	// Nothing to invalidate, but this is still a sync point.
+	SyncThread();
 }
 
 void SoftGPU::NotifyVideoUpload(u32 addr, int size, int width, int format)
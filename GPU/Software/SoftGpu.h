@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cstdint>
+#include "Common/File/Path.h"
 #include "GPU/GPUCommon.h"
 #include "GPU/Common/GPUDebugInterface.h"
 #include "Common/GPU/thin3d.h"
@@ -122,6 +123,8 @@ enum class SoftGPUVRAMDirty : uint8_t {
 
 ENUM_CLASS_BITOPS(SoftGPUVRAMDirty);
 
+class SoftJitPrecompileTask;
+
 class SoftGPU : public GPUCommon {
 public:
 	SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *draw);
@@ -198,6 +201,9 @@ class SoftGPU : public GPUCommon {
 	bool ClearDirty(uint32_t addr, uint32_t stride, uint32_t height, GEBufferFormat fmt, SoftGPUVRAMDirty value);
 	bool ClearDirty(uint32_t addr, uint32_t bytes, SoftGPUVRAMDirty value);
 
+	void LoadJitCache(const Path &filename);
+	void SaveJitCache(const Path &filename);
+
 	uint8_t vramDirty_[2048];
 	uint32_t lastDirtyAddr_ = 0;
 	uint32_t lastDirtySize_ = 0;
@@ -213,6 +219,12 @@ class SoftGPU : public GPUCommon {
 
 	Draw::Texture *fbTex = nullptr;
 	std::vector<u32> fbTexBuffer_;
+
+	// List of pixel and sampler func IDs this game has used.
+	Path jitCachePath_;
+	std::vector<uint64_t> loadedPixelKeys_;
+	std::vector<uint32_t> loadedSamplerKeys_;
+	SoftJitPrecompileTask *precompileTask_ = nullptr;
 };
 
 // TODO: These shouldn't be global.
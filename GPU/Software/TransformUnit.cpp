@@ -23,6 +23,8 @@
 #include "Common/Math/math_util.h"
 #include "Common/MemoryUtil.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Core/Config.h"
 #include "GPU/GPUState.h"
 #include "GPU/Common/DrawEngineCommon.h"
@@ -513,20 +515,47 @@ void TransformUnit::SubmitPrimitive(const void* vertices, const void* indices, G
 	bool skipCull = !gstate.isCullEnabled() || gstate.isModeClear();
 	const CullType cullType = skipCull ? CullType::OFF : (gstate.getCullMode() ? CullType::CCW : CullType::CW);
 
+	// For larger draws, transform each decoded vertex once up front, split across threads.
+	// Primitives are still assembled, clipped, and binned in submission order below.
+	// Indices can span a lot more vertices than the draw uses though, then it's cheaper to transform as we go.
+	const int decodedCount = index_upper_bound - index_lower_bound + 1;
+	const bool sparseIndices = decodedCount > vertex_count * 2;
+	const bool pretransform = std::min(vertex_count, decodedCount) >= PARALLEL_TRANSFORM_MIN_VERTS && !sparseIndices && g_threadManager.GetNumLooperThreads() > 1;
+	if (pretransform) {
+		PROFILE_THIS_SCOPE("transform_verts");
+		if ((int)transformed_.size() < decodedCount) {
+			transformed_.resize(decodedCount);
+			transformedOutside_.resize(decodedCount);
+		}
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			VertexReader batchReader(decoded_, vtxfmt, vertex_type);
+			for (int i = l; i < h; ++i) {
+				bool outside = false;
+				batchReader.Goto(i);
+				transformed_[i] = ReadVertex(batchReader, transformState, outside);
+				transformedOutside_[i] = outside ? 1 : 0;
+			}
+		}, 0, decodedCount, 64);
+	}
+
 	bool outside_range_flag = false;
+	auto readVertex = [&](int vtx) {
+		const int index = indices ? ConvertIndex(vtx) - index_lower_bound : vtx;
+		if (pretransform) {
+			if (transformedOutside_[index])
+				outside_range_flag = true;
+			return transformed_[index];
+		}
+		vreader.Goto(index);
+		return ReadVertex(vreader, transformState, outside_range_flag);
+	};
 	switch (prim_type) {
 	case GE_PRIM_POINTS:
 	case GE_PRIM_LINES:
 	case GE_PRIM_TRIANGLES:
 		{
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[data_index++] = ReadVertex(vreader, transformState, outside_range_flag);
+				data[data_index++] = readVertex(vtx);
 				if (data_index < vtcs_per_prim) {
 					// Keep reading.  Note: an incomplete prim will stay read for GE_PRIM_KEEP_PREVIOUS.
 					continue;
@@ -571,13 +600,7 @@ void TransformUnit::SubmitPrimitive(const void* vertices, const void* indices, G
 
 	case GE_PRIM_RECTANGLES:
 		for (int vtx = 0; vtx < vertex_count; ++vtx) {
-			if (indices) {
-				vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-			} else {
-				vreader.Goto(vtx);
-			}
-
-			data[data_index++] = ReadVertex(vreader, transformState, outside_range_flag);
+			data[data_index++] = readVertex(vtx);
 			if (outside_range_flag) {
 				outside_range_flag = false;
 				// Note: this is the post increment index.  If odd, we set the first vert.
@@ -617,13 +640,7 @@ void TransformUnit::SubmitPrimitive(const void* vertices, const void* indices, G
 			// If data_index is 1 or 2, etc., it means we're continuing a line strip.
 			int skip_count = data_index == 0 ? 1 : 0;
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[(data_index++) & 1] = ReadVertex(vreader, transformState, outside_range_flag);
+				data[(data_index++) & 1] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -650,13 +667,7 @@ void TransformUnit::SubmitPrimitive(const void* vertices, const void* indices, G
 			// This is for Darkstalkers (and should speed up many 2D games).
 			if (data_index == 0 && vertex_count == 4 && cullType == CullType::OFF) {
 				for (int vtx = 0; vtx < 4; ++vtx) {
-					if (indices) {
-						vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-					}
-					else {
-						vreader.Goto(vtx);
-					}
-					data[vtx] = ReadVertex(vreader, transformState, outside_range_flag);
+					data[vtx] = readVertex(vtx);
 				}
 
 				// If a strip is effectively a rectangle, draw it as such!
@@ -669,14 +680,8 @@ void TransformUnit::SubmitPrimitive(const void* vertices, const void* indices, G
 
 			outside_range_flag = false;
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
 				int provoking_index = (data_index++) % 3;
-				data[provoking_index] = ReadVertex(vreader, transformState, outside_range_flag);
+				data[provoking_index] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -712,12 +717,7 @@ void TransformUnit::SubmitPrimitive(const void* vertices, const void* indices, G
 
 			// Only read the central vertex if we're not continuing.
 			if (data_index == 0) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(0) - index_lower_bound);
-				} else {
-					vreader.Goto(0);
-				}
-				data[0] = ReadVertex(vreader, transformState, outside_range_flag);
+				data[0] = readVertex(0);
 				data_index++;
 				start_vtx = 1;
 
@@ -728,12 +728,7 @@ void TransformUnit::SubmitPrimitive(const void* vertices, const void* indices, G
 
 			if (data_index == 1 && vertex_count == 4 && cullType == CullType::OFF) {
 				for (int vtx = start_vtx; vtx < vertex_count; ++vtx) {
-					if (indices) {
-						vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-					} else {
-						vreader.Goto(vtx);
-					}
-					data[vtx] = ReadVertex(vreader, transformState, outside_range_flag);
+					data[vtx] = readVertex(vtx);
 				}
 
 				int tl = -1, br = -1;
@@ -745,14 +740,8 @@ void TransformUnit::SubmitPrimitive(const void* vertices, const void* indices, G
 
 			outside_range_flag = false;
 			for (int vtx = start_vtx; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
 				int provoking_index = 2 - ((data_index++) % 2);
-				data[provoking_index] = ReadVertex(vreader, transformState, outside_range_flag);
+				data[provoking_index] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
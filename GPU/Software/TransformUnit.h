@@ -134,8 +134,13 @@ class TransformUnit {
 private:
 	VertexData ReadVertex(VertexReader &vreader, const TransformState &lstate, bool &outside_range_flag);
 
+	// Draws with at least this many decoded verts transform them on multiple threads.
+	static constexpr int PARALLEL_TRANSFORM_MIN_VERTS = 256;
+
 	u8 *decoded_ = nullptr;
 	BinManager *binner_ = nullptr;
+	std::vector<VertexData> transformed_;
+	std::vector<u8> transformedOutside_;
 };
 
 class SoftwareDrawEngine : public DrawEngineCommon {
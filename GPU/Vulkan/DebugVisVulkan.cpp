@@ -47,9 +47,7 @@ void DrawGPUProfilerVis(UIContext *ui, GPUInterface *gpu) {
 
 	ui->Begin();
 
-	GPU_Vulkan *gpuVulkan = static_cast<GPU_Vulkan *>(gpu);
-
-	std::string text = gpuVulkan->GetGpuProfileString();
+	std::string text = gpu->GetGpuProfileString();
 
 	ui->SetFontScale(0.4f, 0.4f);
 	ui->DrawTextShadow(text.c_str(), x, y, 0xFFFFFFFF, FLAG_DYNAMIC_ASCII);
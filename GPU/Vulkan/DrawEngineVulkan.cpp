@@ -18,6 +18,8 @@
 #include <algorithm>
 
 #include "Common/Data/Convert/SmallDataConvert.h"
+#include "Common/File/FileUtil.h"
+#include "Common/StringUtils.h"
 #include "Common/Profiler/Profiler.h"
 #include "Common/GPU/Vulkan/VulkanRenderManager.h"
 
@@ -52,10 +54,20 @@
 
 using namespace PPSSPP_VK;
 
+// Default size of the vertex cache buffer, VertexCacheSizeMB can raise or lower it.
 enum {
 	VERTEX_CACHE_SIZE = 8192 * 1024
 };
 
+static size_t VertexCacheBudget() {
+	if (g_Config.iVertexCacheSizeMB <= 0)
+		return VERTEX_CACHE_SIZE;
+	return (size_t)std::min(g_Config.iVertexCacheSizeMB, 256) * 1024 * 1024;
+}
+
+// Upper limit for presizing push buffers from a previous run's peak.
+static const size_t MAX_PUSH_RESERVE = 64 * 1024 * 1024;
+
 #define VERTEXCACHE_DECIMATION_INTERVAL 17
 #define DESCRIPTORSET_DECIMATION_INTERVAL 1  // Temporarily cut to 1. Handle reuse breaks this when textures get deleted.
 
@@ -77,6 +89,23 @@ enum {
 	TRANSFORMED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * sizeof(TransformedVertex)
 };
 
+static bool SupportsBindlessTextures(VulkanContext *vulkan) {
+	if (!vulkan->Extensions().EXT_descriptor_indexing)
+		return false;
+	const auto &features = vulkan->GetDeviceFeatures();
+	const auto &indexing = features.enabledDescriptorIndexing;
+	if (!features.enabled.shaderSampledImageArrayDynamicIndexing || !indexing.descriptorBindingSampledImageUpdateAfterBind)
+		return false;
+	if (!indexing.descriptorBindingPartiallyBound || !indexing.descriptorBindingUpdateUnusedWhilePending)
+		return false;
+	// Combined image samplers count against both limits.
+	const auto &limits = vulkan->GetPhysicalDeviceProperties().descriptorIndexingProperties;
+	return limits.maxPerStageDescriptorUpdateAfterBindSampledImages >= BINDLESS_TEXTURE_SLOTS &&
+		limits.maxPerStageDescriptorUpdateAfterBindSamplers >= BINDLESS_TEXTURE_SLOTS &&
+		limits.maxDescriptorSetUpdateAfterBindSampledImages >= BINDLESS_TEXTURE_SLOTS &&
+		limits.maxDescriptorSetUpdateAfterBindSamplers >= BINDLESS_TEXTURE_SLOTS;
+}
+
 DrawEngineVulkan::DrawEngineVulkan(Draw::DrawContext *draw)
 	: draw_(draw), vai_(1024) {
 	decOptions_.expandAllWeightsToFloat = false;
@@ -142,6 +171,28 @@ void DrawEngineVulkan::InitDeviceObjects() {
 	VkResult res = vkCreateDescriptorSetLayout(device, &dsl, nullptr, &descriptorSetLayout_);
 	_dbg_assert_(VK_SUCCESS == res);
 
+	bindless_ = g_Config.bBindlessTextures && SupportsBindlessTextures(vulkan);
+	if (bindless_) {
+		// One big array of combined image samplers, written as new textures show up during the frame.
+		VkDescriptorSetLayoutBinding bindlessBinding{};
+		bindlessBinding.binding = 0;
+		bindlessBinding.descriptorCount = BINDLESS_TEXTURE_SLOTS;
+		bindlessBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindlessBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		VkDescriptorBindingFlagsEXT bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flagsInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT };
+		flagsInfo.bindingCount = 1;
+		flagsInfo.pBindingFlags = &bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo bindlessDsl{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+		bindlessDsl.pNext = &flagsInfo;
+		bindlessDsl.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		bindlessDsl.bindingCount = 1;
+		bindlessDsl.pBindings = &bindlessBinding;
+		res = vkCreateDescriptorSetLayout(device, &bindlessDsl, nullptr, &bindlessSetLayout_);
+		_dbg_assert_(VK_SUCCESS == res);
+	}
+
 	static constexpr int DEFAULT_DESC_POOL_SIZE = 512;
 	std::vector<VkDescriptorPoolSize> dpTypes;
 	dpTypes.resize(3);
@@ -160,21 +211,41 @@ void DrawEngineVulkan::InitDeviceObjects() {
 
 	// We are going to use one-shot descriptors in the initial implementation. Might look into caching them
 	// if creating and updating them turns out to be expensive.
+	// A new bindless set is only needed when one fills up, so a couple per frame is plenty.
+	std::vector<VkDescriptorPoolSize> bindlessTypes(1);
+	bindlessTypes[0].descriptorCount = BINDLESS_TEXTURE_SLOTS * 2;
+	bindlessTypes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	VkDescriptorPoolCreateInfo bindlessDp{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	bindlessDp.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	bindlessDp.maxSets = 2;
+
 	for (int i = 0; i < VulkanContext::MAX_INFLIGHT_FRAMES; i++) {
 		frame_[i].descPool.Create(vulkan, dp, dpTypes);
+		if (bindless_)
+			frame_[i].bindlessPool.Create(vulkan, bindlessDp, bindlessTypes);
 
 		// Note that pushUBO is also used for tessellation data (search for SetPushBuffer), and to upload
 		// the null texture. This should be cleaned up...
 		frame_[i].pushUBO = new VulkanPushBuffer(vulkan, "pushUBO", 8 * 1024 * 1024, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, PushBufferType::CPU_TO_GPU);
 		frame_[i].pushVertex = new VulkanPushBuffer(vulkan, "pushVertex", 2 * 1024 * 1024, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, PushBufferType::CPU_TO_GPU);
 		frame_[i].pushIndex = new VulkanPushBuffer(vulkan, "pushIndex", 1 * 1024 * 1024, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, PushBufferType::CPU_TO_GPU);
+		frame_[i].pushUBO->Reserve(pushUBOReserve_);
+		frame_[i].pushVertex->Reserve(pushVertexReserve_);
+		frame_[i].pushIndex->Reserve(pushIndexReserve_);
+		// Only ever read by the transfer queue, so it never needs a queue family ownership transfer.
+		if (vulkan->GetTransferQueue())
+			frame_[i].pushTransfer = new VulkanPushBuffer(vulkan, "pushTransfer", 4 * 1024 * 1024, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, PushBufferType::CPU_TO_GPU);
 	}
 
+	// With bindless textures, all pipelines share a layout with the texture array as set 1,
+	// and the fragment shader gets its slot in the array as a push constant.
+	VkDescriptorSetLayout setLayouts[2] = { descriptorSetLayout_, bindlessSetLayout_ };
+	VkPushConstantRange bindlessPush{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t) };
 	VkPipelineLayoutCreateInfo pl{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
-	pl.pPushConstantRanges = nullptr;
-	pl.pushConstantRangeCount = 0;
-	pl.setLayoutCount = 1;
-	pl.pSetLayouts = &descriptorSetLayout_;
+	pl.pPushConstantRanges = bindless_ ? &bindlessPush : nullptr;
+	pl.pushConstantRangeCount = bindless_ ? 1 : 0;
+	pl.setLayoutCount = bindless_ ? 2 : 1;
+	pl.pSetLayouts = setLayouts;
 	pl.flags = 0;
 	res = vkCreatePipelineLayout(device, &pl, nullptr, &pipelineLayout_);
 	_dbg_assert_(VK_SUCCESS == res);
@@ -192,7 +263,7 @@ void DrawEngineVulkan::InitDeviceObjects() {
 	res = vkCreateSampler(device, &samp, nullptr, &nullSampler_);
 	_dbg_assert_(VK_SUCCESS == res);
 
-	vertexCache_ = new VulkanPushBuffer(vulkan, "pushVertexCache", VERTEX_CACHE_SIZE, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, PushBufferType::CPU_TO_GPU);
+	vertexCache_ = new VulkanPushBuffer(vulkan, "pushVertexCache", VertexCacheBudget(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, PushBufferType::CPU_TO_GPU);
 
 	tessDataTransferVulkan = new TessellationDataTransferVulkan(vulkan);
 	tessDataTransfer = tessDataTransferVulkan;
@@ -223,6 +294,11 @@ void DrawEngineVulkan::FrameData::Destroy(VulkanContext *vulkan) {
 		delete pushIndex;
 		pushIndex = nullptr;
 	}
+	if (pushTransfer) {
+		pushTransfer->Destroy(vulkan);
+		delete pushTransfer;
+		pushTransfer = nullptr;
+	}
 }
 
 void DrawEngineVulkan::DestroyDeviceObjects() {
@@ -234,6 +310,8 @@ void DrawEngineVulkan::DestroyDeviceObjects() {
 
 	for (int i = 0; i < VulkanContext::MAX_INFLIGHT_FRAMES; i++) {
 		frame_[i].Destroy(vulkan);
+		if (bindless_)
+			frame_[i].bindlessPool.Destroy();
 	}
 	if (samplerSecondary_ != VK_NULL_HANDLE)
 		vulkan->Delete().QueueDeleteSampler(samplerSecondary_);
@@ -243,6 +321,10 @@ void DrawEngineVulkan::DestroyDeviceObjects() {
 		vulkan->Delete().QueueDeletePipelineLayout(pipelineLayout_);
 	if (descriptorSetLayout_ != VK_NULL_HANDLE)
 		vulkan->Delete().QueueDeleteDescriptorSetLayout(descriptorSetLayout_);
+	if (bindlessSetLayout_ != VK_NULL_HANDLE) {
+		vulkan->Delete().QueueDeleteDescriptorSetLayout(bindlessSetLayout_);
+		bindlessSetLayout_ = VK_NULL_HANDLE;
+	}
 	if (vertexCache_) {
 		vertexCache_->Destroy(vulkan);
 		delete vertexCache_;
@@ -281,11 +363,15 @@ void DrawEngineVulkan::BeginFrame() {
 	frame->pushUBO->Reset();
 	frame->pushVertex->Reset();
 	frame->pushIndex->Reset();
+	if (frame->pushTransfer)
+		frame->pushTransfer->Reset();
 
 	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
 	frame->pushUBO->Begin(vulkan);
 	frame->pushVertex->Begin(vulkan);
 	frame->pushIndex->Begin(vulkan);
+	if (frame->pushTransfer)
+		frame->pushTransfer->Begin(vulkan);
 
 	// TODO: How can we make this nicer...
 	tessDataTransferVulkan->SetPushBuffer(frame->pushUBO);
@@ -293,14 +379,22 @@ void DrawEngineVulkan::BeginFrame() {
 	DirtyAllUBOs();
 
 	// Wipe the vertex cache if it's grown too large.
-	if (vertexCache_->GetTotalSize() > VERTEX_CACHE_SIZE) {
+	const size_t vertexCacheBudget = VertexCacheBudget();
+	if (vertexCache_->GetTotalSize() > vertexCacheBudget) {
 		vertexCache_->Destroy(vulkan);
 		delete vertexCache_;  // orphans the buffers, they'll get deleted once no longer used by an in-flight frame.
-		vertexCache_ = new VulkanPushBuffer(vulkan, "vertexCacheR", VERTEX_CACHE_SIZE, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, PushBufferType::CPU_TO_GPU);
+		vertexCache_ = new VulkanPushBuffer(vulkan, "vertexCacheR", vertexCacheBudget, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, PushBufferType::CPU_TO_GPU);
+		// Only the decoded data is lost. Keep the hashes and history, so that whatever is still
+		// in use gets re-uploaded on its next draw (in order of use, so the working set survives)
+		// without going through VAI_NEW again. Stale entries are still aged out below.
 		vai_.Iterate([&](uint32_t hash, VertexArrayInfoVulkan *vai) {
-			delete vai;
+			vai->vb = VK_NULL_HANDLE;
+			vai->ib = VK_NULL_HANDLE;
+			vai->vbOffset = 0;
+			vai->ibOffset = 0;
+			if (vai->status == VertexArrayInfoVulkan::VAI_RELIABLE)
+				vai->status = VertexArrayInfoVulkan::VAI_HASHING;
 		});
-		vai_.Clear();
 	}
 
 	vertexCache_->BeginNoReset();
@@ -309,6 +403,9 @@ void DrawEngineVulkan::BeginFrame() {
 		frame->descPool.Reset();
 		descDecimationCounter_ = DESCRIPTORSET_DECIMATION_INTERVAL;
 	}
+	// Textures may be deleted after this frame slot was last used, so always start over.
+	if (bindless_)
+		frame->bindlessPool.Reset();
 
 	if (--decimationCounter_ <= 0) {
 		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
@@ -339,12 +436,67 @@ void DrawEngineVulkan::EndFrame() {
 	stats_.pushUBOSpaceUsed = (int)frame->pushUBO->GetOffset();
 	stats_.pushVertexSpaceUsed = (int)frame->pushVertex->GetOffset();
 	stats_.pushIndexSpaceUsed = (int)frame->pushIndex->GetOffset();
+	stats_.pushUBOAlignWaste = (int)frame->pushUBO->GetAlignWaste();
+	stats_.pushUBOPeak = std::max(stats_.pushUBOPeak, (int)frame->pushUBO->GetPeakSize());
+	stats_.pushVertexPeak = std::max(stats_.pushVertexPeak, (int)frame->pushVertex->GetPeakSize());
+	stats_.pushIndexPeak = std::max(stats_.pushIndexPeak, (int)frame->pushIndex->GetPeakSize());
+	stats_.pushOverflows = 0;
+	for (int i = 0; i < VulkanContext::MAX_INFLIGHT_FRAMES; i++) {
+		if (frame_[i].pushUBO)
+			stats_.pushOverflows += frame_[i].pushUBO->GetOverflowCount() + frame_[i].pushVertex->GetOverflowCount() + frame_[i].pushIndex->GetOverflowCount();
+	}
 	frame->pushUBO->End();
 	frame->pushVertex->End();
 	frame->pushIndex->End();
+	if (frame->pushTransfer)
+		frame->pushTransfer->End();
 	vertexCache_->End();
 }
 
+void DrawEngineVulkan::LoadPushBufferSizes(const Path &filename) {
+	std::string data;
+	if (!File::ReadFileToString(true, filename, data))
+		return;
+
+	// Format: one "name bytes" pair per line. Anything unknown is ignored.
+	std::vector<std::string> lines;
+	SplitString(data, '\n', lines);
+	for (const std::string &line : lines) {
+		char name[16];
+		unsigned int size;
+		if (sscanf(line.c_str(), "%15s %u", name, &size) != 2)
+			continue;
+		// Leave some headroom, and don't let a broken file eat all memory.
+		size_t reserve = std::min((size_t)size + size / 4, MAX_PUSH_RESERVE);
+		if (!strcmp(name, "ubo")) {
+			pushUBOReserve_ = reserve;
+			stats_.pushUBOPeak = size;
+		} else if (!strcmp(name, "vertex")) {
+			pushVertexReserve_ = reserve;
+			stats_.pushVertexPeak = size;
+		} else if (!strcmp(name, "index")) {
+			pushIndexReserve_ = reserve;
+			stats_.pushIndexPeak = size;
+		}
+	}
+
+	for (int i = 0; i < VulkanContext::MAX_INFLIGHT_FRAMES; i++) {
+		if (!frame_[i].pushUBO)
+			continue;
+		frame_[i].pushUBO->Reserve(pushUBOReserve_);
+		frame_[i].pushVertex->Reserve(pushVertexReserve_);
+		frame_[i].pushIndex->Reserve(pushIndexReserve_);
+	}
+	INFO_LOG(G3D, "Presizing push buffers: UBO %d, vertex %d, index %d", (int)pushUBOReserve_, (int)pushVertexReserve_, (int)pushIndexReserve_);
+}
+
+void DrawEngineVulkan::SavePushBufferSizes(const Path &filename) {
+	if (stats_.pushUBOPeak == 0 && stats_.pushVertexPeak == 0 && stats_.pushIndexPeak == 0)
+		return;
+	std::string data = StringFromFormat("ubo %d\nvertex %d\nindex %d\n", stats_.pushUBOPeak, stats_.pushVertexPeak, stats_.pushIndexPeak);
+	File::WriteStringToFile(true, data, filename);
+}
+
 void DrawEngineVulkan::DecodeVertsToPushBuffer(VulkanPushBuffer *push, uint32_t *bindOffset, VkBuffer *vkbuf) {
 	u8 *dest = decoded;
 
@@ -356,6 +508,46 @@ void DrawEngineVulkan::DecodeVertsToPushBuffer(VulkanPushBuffer *push, uint32_t
 	DecodeVerts(dest);
 }
 
+uint32_t DrawEngineVulkan::GetBindlessTextureSlot(VkImageView imageView, VkSampler sampler, VkDescriptorSet *bindlessSet) {
+	BindlessTextureKey key;
+	key.imageView_ = imageView;
+	key.sampler_ = sampler;
+
+	FrameData &frame = GetCurFrame();
+	uint32_t slot = frame.bindlessSlots.Get(key);
+	if (slot != 0xFFFFFFFF) {
+		*bindlessSet = frame.bindlessSet;
+		return slot;
+	}
+
+	if (frame.bindlessSet == VK_NULL_HANDLE || frame.bindlessUsed >= BINDLESS_TEXTURE_SLOTS) {
+		// Start a fresh array. Draws already queued keep pointing at the old set, which stays alive until the pool is reset.
+		frame.bindlessSlots.Clear();
+		frame.bindlessUsed = 0;
+		frame.bindlessSet = frame.bindlessPool.Allocate(1, &bindlessSetLayout_);
+		_assert_msg_(frame.bindlessSet != VK_NULL_HANDLE, "Ran out of bindless descriptor sets");
+	}
+
+	slot = frame.bindlessUsed++;
+	VkDescriptorImageInfo tex{};
+	tex.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	tex.imageView = imageView;
+	tex.sampler = sampler;
+	VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.dstSet = frame.bindlessSet;
+	write.dstBinding = 0;
+	write.dstArrayElement = slot;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &tex;
+	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
+	vkUpdateDescriptorSets(vulkan->GetDevice(), 1, &write, 0, nullptr);
+
+	frame.bindlessSlots.Insert(key, slot);
+	*bindlessSet = frame.bindlessSet;
+	return slot;
+}
+
 VkDescriptorSet DrawEngineVulkan::GetOrCreateDescriptorSet(VkImageView imageView, VkSampler sampler, VkBuffer base, VkBuffer light, VkBuffer bone, bool tess) {
 	_dbg_assert_(base != VK_NULL_HANDLE);
 	_dbg_assert_(light != VK_NULL_HANDLE);
@@ -760,7 +952,7 @@ void DrawEngineVulkan::DoFlush() {
 				sampler = nullSampler_;
 		}
 
-		if (!lastPipeline_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE) || prim != lastPrim_) {
+		if (!lastPipeline_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE | DIRTY_FRAGMENTSHADER_TEXTURE) || prim != lastPrim_) {
 			if (prim != lastPrim_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE)) {
 				ConvertStateToVulkanKey(*framebufferManager_, shaderManager_, prim, pipelineKey_, dynState_);
 			}
@@ -811,7 +1003,12 @@ void DrawEngineVulkan::DoFlush() {
 		dirtyUniforms_ |= shaderManager_->UpdateUniforms(framebufferManager_->UseBufferedRendering());
 		UpdateUBOs(frame);
 
-		VkDescriptorSet ds = GetOrCreateDescriptorSet(imageView, sampler, baseBuf, lightBuf, boneBuf, tess);
+		// With bindless textures, the texture goes in the frame's array instead, so set 0 is shared by many more draws.
+		VkDescriptorSet bindlessDs = VK_NULL_HANDLE;
+		uint32_t bindlessIndex = 0;
+		if (bindless_ && !gstate_c.curTextureIs3D)
+			bindlessIndex = GetBindlessTextureSlot(imageView, sampler, &bindlessDs);
+		VkDescriptorSet ds = GetOrCreateDescriptorSet(bindlessDs ? VK_NULL_HANDLE : imageView, bindlessDs ? VK_NULL_HANDLE : sampler, baseBuf, lightBuf, boneBuf, tess);
 
 		const uint32_t dynamicUBOOffsets[3] = {
 			baseUBOOffset, lightUBOOffset, boneUBOOffset,
@@ -821,9 +1018,9 @@ void DrawEngineVulkan::DoFlush() {
 			if (!ibuf) {
 				ibOffset = (uint32_t)frame->pushIndex->Push(decIndex, sizeof(uint16_t) * indexGen.VertexCount(), &ibuf);
 			}
-			renderManager->DrawIndexed(pipelineLayout_, ds, ARRAY_SIZE(dynamicUBOOffsets), dynamicUBOOffsets, vbuf, vbOffset, ibuf, ibOffset, vertexCount, 1, VK_INDEX_TYPE_UINT16);
+			renderManager->DrawIndexed(pipelineLayout_, ds, ARRAY_SIZE(dynamicUBOOffsets), dynamicUBOOffsets, vbuf, vbOffset, ibuf, ibOffset, vertexCount, 1, VK_INDEX_TYPE_UINT16, bindlessDs, bindlessIndex);
 		} else {
-			renderManager->Draw(pipelineLayout_, ds, ARRAY_SIZE(dynamicUBOOffsets), dynamicUBOOffsets, vbuf, vbOffset, vertexCount);
+			renderManager->Draw(pipelineLayout_, ds, ARRAY_SIZE(dynamicUBOOffsets), dynamicUBOOffsets, vbuf, vbOffset, vertexCount, 0, bindlessDs, bindlessIndex);
 		}
 	} else {
 		PROFILE_THIS_SCOPE("soft");
@@ -897,7 +1094,7 @@ void DrawEngineVulkan::DoFlush() {
 				if (sampler == VK_NULL_HANDLE)
 					sampler = nullSampler_;
 			}
-			if (!lastPipeline_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE) || prim != lastPrim_) {
+			if (!lastPipeline_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE | DIRTY_FRAGMENTSHADER_TEXTURE) || prim != lastPrim_) {
 				shaderManager_->GetShaders(prim, lastVType_, &vshader, &fshader, false, false, decOptions_.expandAllWeightsToFloat);  // usehwtransform
 				_dbg_assert_msg_(!vshader->UseHWTransform(), "Bad vshader");
 				if (prim != lastPrim_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE)) {
@@ -947,7 +1144,11 @@ void DrawEngineVulkan::DoFlush() {
 			// Even if the first draw is through-mode, make sure we at least have one copy of these uniforms buffered
 			UpdateUBOs(frame);
 
-			VkDescriptorSet ds = GetOrCreateDescriptorSet(imageView, sampler, baseBuf, lightBuf, boneBuf, tess);
+			VkDescriptorSet bindlessDs = VK_NULL_HANDLE;
+			uint32_t bindlessIndex = 0;
+			if (bindless_ && !gstate_c.curTextureIs3D)
+				bindlessIndex = GetBindlessTextureSlot(imageView, sampler, &bindlessDs);
+			VkDescriptorSet ds = GetOrCreateDescriptorSet(bindlessDs ? VK_NULL_HANDLE : imageView, bindlessDs ? VK_NULL_HANDLE : sampler, baseBuf, lightBuf, boneBuf, tess);
 			const uint32_t dynamicUBOOffsets[3] = {
 				baseUBOOffset, lightUBOOffset, boneUBOOffset,
 			};
@@ -958,11 +1159,11 @@ void DrawEngineVulkan::DoFlush() {
 				VkBuffer vbuf, ibuf;
 				vbOffset = (uint32_t)frame->pushVertex->Push(result.drawBuffer, maxIndex * sizeof(TransformedVertex), &vbuf);
 				ibOffset = (uint32_t)frame->pushIndex->Push(inds, sizeof(short) * result.drawNumTrans, &ibuf);
-				renderManager->DrawIndexed(pipelineLayout_, ds, ARRAY_SIZE(dynamicUBOOffsets), dynamicUBOOffsets, vbuf, vbOffset, ibuf, ibOffset, result.drawNumTrans, 1, VK_INDEX_TYPE_UINT16);
+				renderManager->DrawIndexed(pipelineLayout_, ds, ARRAY_SIZE(dynamicUBOOffsets), dynamicUBOOffsets, vbuf, vbOffset, ibuf, ibOffset, result.drawNumTrans, 1, VK_INDEX_TYPE_UINT16, bindlessDs, bindlessIndex);
 			} else {
 				VkBuffer vbuf;
 				vbOffset = (uint32_t)frame->pushVertex->Push(result.drawBuffer, result.drawNumTrans * sizeof(TransformedVertex), &vbuf);
-				renderManager->Draw(pipelineLayout_, ds, ARRAY_SIZE(dynamicUBOOffsets), dynamicUBOOffsets, vbuf, vbOffset, result.drawNumTrans);
+				renderManager->Draw(pipelineLayout_, ds, ARRAY_SIZE(dynamicUBOOffsets), dynamicUBOOffsets, vbuf, vbOffset, result.drawNumTrans, 0, bindlessDs, bindlessIndex);
 			}
 		} else if (result.action == SW_CLEAR) {
 			// Note: we won't get here if the clear is alpha but not color, or color but not alpha.
@@ -1048,12 +1249,18 @@ void TessellationDataTransferVulkan::SendDataToShader(const SimpleVertex *const
 	using Spline::Weight;
 
 	// Weights U
-	data = (uint8_t *)push_->PushAligned(weights.size_u * sizeof(Weight), (uint32_t *)&bufInfo_[1].offset, &bufInfo_[1].buffer, ssboAlignment);
-	memcpy(data, weights.u, weights.size_u * sizeof(Weight));
-	bufInfo_[1].range = weights.size_u * sizeof(Weight);
+	if (prevWeightsU_ != weights.u) {
+		prevWeightsU_ = weights.u;
+		data = (uint8_t *)push_->PushAligned(weights.size_u * sizeof(Weight), (uint32_t *)&bufInfo_[1].offset, &bufInfo_[1].buffer, ssboAlignment);
+		memcpy(data, weights.u, weights.size_u * sizeof(Weight));
+		bufInfo_[1].range = weights.size_u * sizeof(Weight);
+	}
 
 	// Weights V
-	data = (uint8_t *)push_->PushAligned(weights.size_v * sizeof(Weight), (uint32_t *)&bufInfo_[2].offset, &bufInfo_[2].buffer, ssboAlignment);
-	memcpy(data, weights.v, weights.size_v * sizeof(Weight));
-	bufInfo_[2].range = weights.size_v * sizeof(Weight);
+	if (prevWeightsV_ != weights.v) {
+		prevWeightsV_ = weights.v;
+		data = (uint8_t *)push_->PushAligned(weights.size_v * sizeof(Weight), (uint32_t *)&bufInfo_[2].offset, &bufInfo_[2].buffer, ssboAlignment);
+		memcpy(data, weights.v, weights.size_v * sizeof(Weight));
+		bufInfo_[2].range = weights.size_v * sizeof(Weight);
+	}
 }
@@ -32,6 +32,7 @@
 // won't get any bone data, etc.
 
 #include "Common/Data/Collections/Hashmaps.h"
+#include "Common/File/Path.h"
 #include "Common/GPU/Vulkan/VulkanMemory.h"
 
 #include "GPU/Vulkan/VulkanUtil.h"
@@ -60,6 +61,14 @@ struct DrawEngineVulkanStats {
 	int pushUBOSpaceUsed;
 	int pushVertexSpaceUsed;
 	int pushIndexSpaceUsed;
+	// Highest usage of any frame so far this session, or loaded from the last run.
+	int pushUBOPeak;
+	int pushVertexPeak;
+	int pushIndexPeak;
+	// Bytes of pushUBO lost to UBO alignment this frame.
+	int pushUBOAlignWaste;
+	// Times a push buffer had to add a buffer mid-frame.
+	int pushOverflows;
 };
 
 enum {
@@ -111,7 +120,11 @@ class TessellationDataTransferVulkan : public TessellationDataTransfer  {
 public:
 	TessellationDataTransferVulkan(VulkanContext *vulkan) : vulkan_(vulkan) {}
 
-	void SetPushBuffer(VulkanPushBuffer *push) { push_ = push; }
+	void SetPushBuffer(VulkanPushBuffer *push) {
+		push_ = push;
+		prevWeightsU_ = nullptr;
+		prevWeightsV_ = nullptr;
+	}
 	// Send spline/bezier's control points and weights to vertex shader through structured shader buffer.
 	void SendDataToShader(const SimpleVertex *const *points, int size_u, int size_v, u32 vertType, const Spline::Weight2D &weights) override;
 	const VkDescriptorBufferInfo *GetBufferInfo() { return bufInfo_; }
@@ -119,6 +132,9 @@ class TessellationDataTransferVulkan : public TessellationDataTransfer  {
 	VulkanContext *vulkan_;
 	VulkanPushBuffer *push_;  // Updated each frame.
 	VkDescriptorBufferInfo bufInfo_[3]{};
+	// Weights already pushed into push_ this frame. They come from a persistent cache, so the pointer is the key.
+	const Spline::Weight *prevWeightsU_ = nullptr;
+	const Spline::Weight *prevWeightsV_ = nullptr;
 };
 
 // Handles transform, lighting and drawing.
@@ -165,6 +181,15 @@ class DrawEngineVulkan : public DrawEngineCommon {
 		return pipelineLayout_;
 	}
 
+	// Per-game record of peak push buffer usage, used to presize them on the next run.
+	void LoadPushBufferSizes(const Path &filename);
+	void SavePushBufferSizes(const Path &filename);
+
+	// Decided at device init from the config and the device's descriptor indexing support.
+	bool UsesBindlessTextures() const {
+		return bindless_;
+	}
+
 	void BeginFrame();
 	void EndFrame();
 
@@ -178,6 +203,11 @@ class DrawEngineVulkan : public DrawEngineCommon {
 		return GetCurFrame().pushUBO;
 	}
 
+	// Staging memory for uploads on the transfer queue. Null if the device doesn't have one.
+	VulkanPushBuffer *GetPushBufferForTransfer() {
+		return GetCurFrame().pushTransfer;
+	}
+
 	const DrawEngineVulkanStats &GetStats() const {
 		return stats_;
 	}
@@ -206,6 +236,7 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	FrameData &GetCurFrame();
 
 	VkDescriptorSet GetOrCreateDescriptorSet(VkImageView imageView, VkSampler sampler, VkBuffer base, VkBuffer light, VkBuffer bone, bool tess);
+	uint32_t GetBindlessTextureSlot(VkImageView imageView, VkSampler sampler, VkDescriptorSet *bindlessSet);
 
 	Draw::DrawContext *draw_;
 
@@ -213,6 +244,9 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	VkDescriptorSetLayout descriptorSetLayout_;
 	VkPipelineLayout pipelineLayout_;
 	VulkanPipeline *lastPipeline_;
+	// Optional set 1, an array of all 2D textures used in the frame (see GPU_USE_BINDLESS_TEXTURES.)
+	VkDescriptorSetLayout bindlessSetLayout_ = VK_NULL_HANDLE;
+	bool bindless_ = false;
 	VkDescriptorSet lastDs_ = VK_NULL_HANDLE;
 
 	// Secondary texture for shader blending
@@ -234,9 +268,19 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	};
 
 	// We alternate between these.
+	struct BindlessTextureKey {
+		VkImageView imageView_;
+		VkSampler sampler_;
+	};
+
 	struct FrameData {
-		FrameData() : descSets(512), descPool("DrawEngine", true) {
+		FrameData() : descSets(512), descPool("DrawEngine", true), bindlessSlots(256), bindlessPool("DrawEngineBindless", true) {
 			descPool.Setup([this] { descSets.Clear(); });
+			bindlessPool.Setup([this] {
+				bindlessSlots.Clear();
+				bindlessSet = VK_NULL_HANDLE;
+				bindlessUsed = 0;
+			});
 		}
 
 		VulkanDescSetPool descPool;
@@ -244,10 +288,17 @@ class DrawEngineVulkan : public DrawEngineCommon {
 		VulkanPushBuffer *pushUBO = nullptr;
 		VulkanPushBuffer *pushVertex = nullptr;
 		VulkanPushBuffer *pushIndex = nullptr;
+		VulkanPushBuffer *pushTransfer = nullptr;
 
 		// We do rolling allocation and reset instead of caching across frames. That we might do later.
 		DenseHashMap<DescriptorSetKey, VkDescriptorSet, (VkDescriptorSet)VK_NULL_HANDLE> descSets;
 
+		// Only used with bindless textures. Slots are handed out in order and never freed within a frame.
+		DenseHashMap<BindlessTextureKey, uint32_t, 0xFFFFFFFF> bindlessSlots;
+		VulkanDescSetPool bindlessPool;
+		VkDescriptorSet bindlessSet = VK_NULL_HANDLE;
+		uint32_t bindlessUsed = 0;
+
 		void Destroy(VulkanContext *vulkan);
 	};
 
@@ -273,6 +324,10 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	VkSampler nullSampler_ = VK_NULL_HANDLE;
 
 	DrawEngineVulkanStats stats_{};
+	// Sizes loaded by LoadPushBufferSizes, reapplied if the device is recreated.
+	size_t pushUBOReserve_ = 0;
+	size_t pushVertexReserve_ = 0;
+	size_t pushIndexReserve_ = 0;
 
 	VulkanPipelineRasterStateKey pipelineKey_{};
 	VulkanDynamicState dynState_{};
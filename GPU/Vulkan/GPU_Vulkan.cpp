@@ -20,14 +20,18 @@
 
 #include "Common/Profiler/Profiler.h"
 
+#include "Common/Buffer.h"
 #include "Common/Log.h"
 #include "Common/File/FileUtil.h"
+#include "Common/Net/HTTPClient.h"
+#include "Common/Net/URL.h"
 #include "Common/GraphicsContext.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/TimeUtil.h"
 
 #include "Core/Config.h"
 #include "Core/Debugger/Breakpoints.h"
+#include "Core/Instance.h"
 #include "Core/MemMapHelpers.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
@@ -105,9 +109,12 @@ GPU_Vulkan::GPU_Vulkan(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	if (discID.size()) {
 		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
 		shaderCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".vkshadercache");
+		pushSizesPath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".vkpushsizes");
+		drawEngine_.LoadPushBufferSizes(pushSizesPath_);
 		shaderCacheLoaded_ = false;
 
-		std::thread th([&] {
+		std::thread th([this, discID] {
+			SeedCache(shaderCachePath_, discID);
 			LoadCache(shaderCachePath_);
 			shaderCacheLoaded_ = true;
 		});
@@ -125,6 +132,50 @@ void GPU_Vulkan::CancelReady() {
 	pipelineManager_->CancelCache();
 }
 
+// The cache file only holds shader IDs and pipeline keys, no driver data (see PipelineManagerVulkan::SaveCache),
+// so a file saved on one device works as-is on another.  That lets a fleet of devices share one set of caches:
+// if we don't have one yet, try to fetch it, and LoadCache() then precompiles everything in it.
+// Files from a different cache version are rejected and deleted by LoadCache(), just like local ones.
+void GPU_Vulkan::SeedCache(const Path &filename, const std::string &discID) {
+	if (!g_Config.bShaderCache || g_Config.sShaderCacheSeedURL.empty() || File::Exists(filename))
+		return;
+
+	std::string baseURL = g_Config.sShaderCacheSeedURL;
+	if (baseURL.back() != '/')
+		baseURL += '/';
+	Url url(baseURL + discID + ".vkshadercache");
+	if (!url.Valid() || url.Protocol() != "http") {
+		WARN_LOG(G3D, "Invalid shader cache seed URL (only http is supported): %s", url.ToString().c_str());
+		return;
+	}
+
+	http::Client client;
+	// This delays game start, so don't wait long if the server is down.
+	if (!client.Resolve(url.Host().c_str(), url.Port()) || !client.Connect(1, 5.0)) {
+		WARN_LOG(G3D, "Could not connect to shader cache server %s", url.Host().c_str());
+		return;
+	}
+	client.SetDataTimeout(20.0);
+
+	Buffer result;
+	http::RequestProgress progress;
+	int code = client.GET(http::RequestParams(url.Resource(), "*/*"), &result, &progress);
+	client.Disconnect();
+	if (code != 200 || result.empty()) {
+		INFO_LOG(G3D, "No shared shader cache for %s (HTTP %d)", discID.c_str(), code);
+		return;
+	}
+
+	// Only put it in place once it's complete, in case another instance is looking for it.
+	Path tempPath = GetInstanceTempPath(filename);
+	size_t size = result.size();
+	if (result.FlushToFile(tempPath) && CommitInstanceTempFile(tempPath, filename)) {
+		INFO_LOG(G3D, "Seeded shader cache for %s from server (%d bytes)", discID.c_str(), (int)size);
+	} else {
+		WARN_LOG(G3D, "Failed to write downloaded shader cache to %s", filename.c_str());
+	}
+}
+
 void GPU_Vulkan::LoadCache(const Path &filename) {
 	if (!g_Config.bShaderCache) {
 		INFO_LOG(G3D, "Shader cache disabled. Not loading.");
@@ -167,18 +218,23 @@ void GPU_Vulkan::SaveCache(const Path &filename) {
 		return;
 	}
 
-	FILE *f = File::OpenCFile(filename, "wb");
+	Path tempPath = GetInstanceTempPath(filename);
+	FILE *f = File::OpenCFile(tempPath, "wb");
 	if (!f)
 		return;
 	shaderManagerVulkan_->SaveCache(f);
 	// WARNING: See comment in LoadCache if you are tempted to flip the second parameter to true.
 	pipelineManager_->SaveCache(f, false, shaderManagerVulkan_, draw_);
-	INFO_LOG(G3D, "Saved Vulkan pipeline cache");
 	fclose(f);
+	if (CommitInstanceTempFile(tempPath, filename))
+		INFO_LOG(G3D, "Saved Vulkan pipeline cache");
+	lastShaderCacheSaveFlip_ = gpuStats.numFlips;
 }
 
 GPU_Vulkan::~GPU_Vulkan() {
 	SaveCache(shaderCachePath_);
+	if (pushSizesPath_.Valid())
+		drawEngine_.SavePushBufferSizes(pushSizesPath_);
 	// Note: We save the cache in DeviceLost
 	DestroyDeviceObjects();
 	framebufferManagerVulkan_->DestroyAllFBOs();
@@ -270,6 +326,9 @@ void GPU_Vulkan::CheckGPUFeatures() {
 	if (enabledFeatures.samplerAnisotropy) {
 		features |= GPU_SUPPORTS_ANISOTROPY;
 	}
+	if (drawEngine_.UsesBindlessTextures()) {
+		features |= GPU_USE_BINDLESS_TEXTURES;
+	}
 
 	// These are VULKAN_4444_FORMAT and friends.
 	uint32_t fmt4444 = draw_->GetDataFormatSupport(Draw::DataFormat::B4G4R4A4_UNORM_PACK16);
@@ -319,6 +378,12 @@ void GPU_Vulkan::BeginHostFrame() {
 
 	textureCacheVulkan_->StartFrame();
 
+	// When other instances are running (likely the same game, for ad hoc testing), save now and then
+	// so that they can start from what we've compiled so far.
+	if (shaderCachePath_.Valid() && shaderCacheLoaded_ && gpuStats.numFlips - lastShaderCacheSaveFlip_ >= 4096 && GetInstancePeerCount() > 1) {
+		SaveCache(shaderCachePath_);
+	}
+
 	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
 	int curFrame = vulkan->GetCurFrame();
 	FrameData &frame = frameData_[curFrame];
@@ -517,6 +582,7 @@ void GPU_Vulkan::InitDeviceObjects() {
 	if (hacks) {
 		rm->GetQueueRunner()->EnableHacks(hacks);
 	}
+	rm->GetQueueRunner()->EnableParallelRecording(g_Config.bParallelCmdRecording);
 }
 
 void GPU_Vulkan::DestroyDeviceObjects() {
@@ -533,8 +599,11 @@ void GPU_Vulkan::DestroyDeviceObjects() {
 	// Need to turn off hacks when shutting down the GPU. Don't want them running in the menu.
 	if (draw_) {
 		VulkanRenderManager *rm = (VulkanRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
-		if (rm)
+		if (rm) {
 			rm->GetQueueRunner()->EnableHacks(0);
+			// Our shader modules are going away.
+			rm->ClearPipelineLibraries();
+		}
 	}
 }
 
@@ -549,6 +618,10 @@ void GPU_Vulkan::DeviceLost() {
 	DestroyDeviceObjects();
 	vulkan2D_.DeviceLost();
 	drawEngine_.DeviceLost();
+	if (draw_) {
+		VulkanRenderManager *rm = (VulkanRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
+		rm->ClearPipelineLibraries();
+	}
 	pipelineManager_->DeviceLost();
 	textureCacheVulkan_->DeviceLost();
 	depalShaderCache_.DeviceLost();
@@ -586,6 +659,7 @@ void GPU_Vulkan::GetStats(char *buffer, size_t bufsize) {
 	snprintf(buffer, bufsize,
 		"Vertex, Fragment, Pipelines loaded: %i, %i, %i\n"
 		"Pushbuffer space used: UBO %d, Vtx %d, Idx %d\n"
+		"Pushbuffer peak: UBO %d, Vtx %d, Idx %d (UBO align waste %d, overflows %d)\n"
 		"%s\n",
 		shaderManagerVulkan_->GetNumVertexShaders(),
 		shaderManagerVulkan_->GetNumFragmentShaders(),
@@ -593,6 +667,11 @@ void GPU_Vulkan::GetStats(char *buffer, size_t bufsize) {
 		drawStats.pushUBOSpaceUsed,
 		drawStats.pushVertexSpaceUsed,
 		drawStats.pushIndexSpaceUsed,
+		drawStats.pushUBOPeak,
+		drawStats.pushVertexPeak,
+		drawStats.pushIndexPeak,
+		drawStats.pushUBOAlignWaste,
+		drawStats.pushOverflows,
 		texStats
 	);
 }
@@ -611,7 +690,7 @@ void GPU_Vulkan::DoState(PointerWrap &p) {
 	// TODO: Some of these things may not be necessary.
 	// None of these are necessary when saving.
 	// In Freeze-Frame mode, we don't want to do any of this.
-	if (p.mode == p.MODE_READ && !PSP_CoreParameter().frozen) {
+	if (p.mode == p.MODE_READ && !PSP_CoreParameter().frozen && !PSP_CoreParameter().runAheadSpeculative) {
 		textureCache_->Clear(true);
 		depalShaderCache_.Clear();
 
@@ -652,8 +731,3 @@ std::string GPU_Vulkan::DebugGetShaderString(std::string id, DebugShaderType typ
 		return std::string();
 	}
 }
-
-std::string GPU_Vulkan::GetGpuProfileString() {
-	VulkanRenderManager *rm = (VulkanRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
-	return rm->GetGpuProfileString();
-}
@@ -68,8 +68,6 @@ class GPU_Vulkan : public GPUCommon {
 		return textureCacheVulkan_;
 	}
 
-	std::string GetGpuProfileString();
-
 protected:
 	void FinishDeferred() override;
 
@@ -86,6 +84,7 @@ class GPU_Vulkan : public GPUCommon {
 	void InitDeviceObjects();
 	void DestroyDeviceObjects();
 
+	void SeedCache(const Path &filename, const std::string &discID);
 	void LoadCache(const Path &filename);
 	void SaveCache(const Path &filename);
 
@@ -110,5 +109,7 @@ class GPU_Vulkan : public GPUCommon {
 	FrameData frameData_[VulkanContext::MAX_INFLIGHT_FRAMES]{};
 
 	Path shaderCachePath_;
+	Path pushSizesPath_;
 	bool shaderCacheLoaded_ = false;
+	int lastShaderCacheSaveFlip_ = 0;
 };
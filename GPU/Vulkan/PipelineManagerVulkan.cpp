@@ -15,6 +15,7 @@
 #include "Common/GPU/thin3d.h"
 #include "Common/GPU/Vulkan/VulkanRenderManager.h"
 #include "Common/GPU/Vulkan/VulkanQueueRunner.h"
+#include "Core/Config.h"
 
 using namespace PPSSPP_VK;
 
@@ -174,7 +175,7 @@ static std::string CutFromMain(std::string str) {
 
 static VulkanPipeline *CreateVulkanPipeline(VulkanRenderManager *renderManager, VkPipelineCache pipelineCache,
 		VkPipelineLayout layout, VkRenderPass renderPass, const VulkanPipelineRasterStateKey &key,
-		const DecVtxFormat *decFmt, VulkanVertexShader *vs, VulkanFragmentShader *fs, bool useHwTransform) {
+		const DecVtxFormat *decFmt, VulkanVertexShader *vs, VulkanFragmentShader *fs, bool useHwTransform, VKRGraphicsPipeline *fallback) {
 	VKRGraphicsPipelineDesc *desc = new VKRGraphicsPipelineDesc();
 	desc->pipelineCache = pipelineCache;
 
@@ -339,7 +340,7 @@ static VulkanPipeline *CreateVulkanPipeline(VulkanRenderManager *renderManager,
 	pipe.renderPass = renderPass;
 	pipe.subpass = 0;
 
-	VKRGraphicsPipeline *pipeline = renderManager->CreateGraphicsPipeline(desc);
+	VKRGraphicsPipeline *pipeline = renderManager->CreateGraphicsPipeline(desc, fallback);
 
 	VulkanPipeline *vulkanPipeline = new VulkanPipeline();
 	vulkanPipeline->pipeline = pipeline;
@@ -375,9 +376,10 @@ VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VulkanRenderManager *
 	if (iter)
 		return iter;
 
+	VKRGraphicsPipeline *fallback = g_Config.bPipelineFallback ? FindFallbackPipeline(key) : nullptr;
 	VulkanPipeline *pipeline = CreateVulkanPipeline(
 		renderManager, pipelineCache_, layout, renderPass,
-		rasterKey, decFmt, vs, fs, useHwTransform);
+		rasterKey, decFmt, vs, fs, useHwTransform, fallback);
 	pipelines_.Insert(key, pipeline);
 
 	// Don't return placeholder null pipelines.
@@ -388,6 +390,23 @@ VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VulkanRenderManager *
 	}
 }
 
+VKRGraphicsPipeline *PipelineManagerVulkan::FindFallbackPipeline(const VulkanPipelineKey &key) {
+	// The fixed function state, render pass and vertex input must match for the fallback to be
+	// usable at all. Requiring the same vertex shader also guarantees that its outputs satisfy the
+	// fallback's fragment shader, so only the fragment shading (texturing, tests, etc) may differ.
+	VKRGraphicsPipeline *fallback = nullptr;
+	pipelines_.Iterate([&](const VulkanPipelineKey &other, VulkanPipeline *value) {
+		if (fallback || !value->pipeline || value->pipeline->pipeline == VK_NULL_HANDLE)
+			return;
+		if (other.renderPass != key.renderPass || other.vShader != key.vShader || other.vtxFmtId != key.vtxFmtId || other.useHWTransform != key.useHWTransform)
+			return;
+		if (memcmp(&other.raster, &key.raster, sizeof(key.raster)) != 0)
+			return;
+		fallback = value->pipeline;
+	});
+	return fallback;
+}
+
 std::vector<std::string> PipelineManagerVulkan::DebugGetObjectIDs(DebugShaderType type) {
 	std::vector<std::string> ids;
 	switch (type) {
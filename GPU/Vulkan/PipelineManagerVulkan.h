@@ -86,6 +86,9 @@ class PipelineManagerVulkan {
 	void CancelCache();
 
 private:
+	// Returns an already compiled pipeline that can stand in for key while it's compiling, if any.
+	VKRGraphicsPipeline *FindFallbackPipeline(const VulkanPipelineKey &key);
+
 	DenseHashMap<VulkanPipelineKey, VulkanPipeline *, nullptr> pipelines_;
 	VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
 	VulkanContext *vulkan_;
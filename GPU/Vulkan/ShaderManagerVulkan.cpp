@@ -223,12 +223,7 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertType, VulkanVertexShader
 	}
 
 	FShaderID FSID;
-	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
-		gstate_c.Clean(DIRTY_FRAGMENTSHADER_STATE);
-		ComputeFragmentShaderID(&FSID, draw_->GetBugs());
-	} else {
-		FSID = lastFSID_;
-	}
+	UpdateFragmentShaderID(&FSID, lastFSID_, draw_->GetBugs());
 
 	_dbg_assert_(FSID.Bit(FS_BIT_LMODE) == VSID.Bit(VS_BIT_LMODE));
 	_dbg_assert_(FSID.Bit(FS_BIT_DO_TEXTURE) == VSID.Bit(VS_BIT_DO_TEXTURE));
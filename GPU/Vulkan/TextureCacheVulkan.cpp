@@ -107,6 +107,76 @@ void main() {
 
 )";
 
+// Decodes CLUT4/CLUT8 textures straight from the raw PSP memory, unswizzling and looking up the
+// CLUT as it goes.  The CLUT is the raw PSP palette too, converted here.
+const char *decodeShader = R"(
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+uniform layout(binding = 0, rgba8) writeonly image2D img;
+
+layout(std430, binding = 1) buffer Buf {
+	uint data[];
+} buf;
+
+layout(std430, binding = 2) buffer Clut {
+	uint data[];
+} clut;
+
+// flags: 1 = swizzled, 2-4 = CLUT format (GEPaletteFormat), 8 = 8-bit indices.
+layout(push_constant) uniform Params {
+	int width;
+	int height;
+	int bufw;
+	int flags;
+} params;
+
+uint readByte(uint offset) {
+	return (buf.data[offset >> 2] >> ((offset & 3) * 8)) & 0xFF;
+}
+
+uint readIndex(uvec2 p) {
+	bool is8 = (params.flags & 8) != 0;
+	uint rowBytes = is8 ? uint(params.bufw) : uint(params.bufw) / 2;
+	uint byteX = is8 ? p.x : p.x / 2;
+	uint offset;
+	if ((params.flags & 1) != 0) {
+		// Swizzled textures are stored in 16 byte x 8 row blocks, one after another.
+		uint block = (p.y / 8) * (rowBytes / 16) + byteX / 16;
+		offset = block * 128 + (p.y & 7) * 16 + (byteX & 15);
+	} else {
+		offset = p.y * rowBytes + byteX;
+	}
+	uint index = readByte(offset);
+	if (!is8)
+		index = (p.x & 1) != 0 ? index >> 4 : index & 0xF;
+	return index;
+}
+
+vec4 lookupColor(uint index) {
+	uint fmt = (uint(params.flags) >> 1) & 3;
+	if (fmt == 3)
+		return unpackUnorm4x8(clut.data[index]);
+	uint c = (clut.data[index >> 1] >> ((index & 1) * 16)) & 0xFFFF;
+	if (fmt == 0) {
+		return vec4(float(c & 0x1F) / 31.0, float((c >> 5) & 0x3F) / 63.0, float((c >> 11) & 0x1F) / 31.0, 1.0);
+	} else if (fmt == 1) {
+		return vec4(float(c & 0x1F) / 31.0, float((c >> 5) & 0x1F) / 31.0, float((c >> 10) & 0x1F) / 31.0, float(c >> 15));
+	}
+	return vec4(float(c & 0xF) / 15.0, float((c >> 4) & 0xF) / 15.0, float((c >> 8) & 0xF) / 15.0, float(c >> 12) / 15.0);
+}
+
+void main() {
+	uvec2 xy = gl_GlobalInvocationID.xy;
+	if (xy.x >= params.width || xy.y >= params.height)
+		return;
+	imageStore(img, ivec2(xy), lookupColor(readIndex(xy)));
+}
+
+)";
+
 SamplerCache::~SamplerCache() {
 	DeviceLost();
 }
@@ -216,6 +286,9 @@ void TextureCacheVulkan::DeviceLost() {
 
 	if (uploadCS_ != VK_NULL_HANDLE)
 		vulkan->Delete().QueueDeleteShaderModule(uploadCS_);
+	if (decodeCS_ != VK_NULL_HANDLE)
+		vulkan->Delete().QueueDeleteShaderModule(decodeCS_);
+	decodeCS_ = VK_NULL_HANDLE;
 
 	computeShaderManager_.DeviceLost();
 
@@ -242,6 +315,7 @@ void TextureCacheVulkan::DeviceRestore(Draw::DrawContext *draw) {
 	_assert_(res == VK_SUCCESS);
 
 	CompileScalingShader();
+	CompileDecodeShader();
 
 	computeShaderManager_.DeviceRestore(vulkan);
 }
@@ -249,6 +323,7 @@ void TextureCacheVulkan::DeviceRestore(Draw::DrawContext *draw) {
 void TextureCacheVulkan::NotifyConfigChanged() {
 	TextureCacheCommon::NotifyConfigChanged();
 	CompileScalingShader();
+	CompileDecodeShader();
 }
 
 static std::string ReadShaderSrc(const Path &filename) {
@@ -294,6 +369,96 @@ void TextureCacheVulkan::CompileScalingShader() {
 	shaderScaleFactor_ = shaderInfo->scaleFactor;
 }
 
+void TextureCacheVulkan::CompileDecodeShader() {
+	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
+
+	if (!g_Config.bTexComputeDecode) {
+		if (decodeCS_ != VK_NULL_HANDLE)
+			vulkan->Delete().QueueDeleteShaderModule(decodeCS_);
+		decodeCS_ = VK_NULL_HANDLE;
+		return;
+	} else if (decodeCS_ != VK_NULL_HANDLE) {
+		return;
+	}
+
+	std::string error;
+	decodeCS_ = CompileShaderModule(vulkan, VK_SHADER_STAGE_COMPUTE_BIT, decodeShader, &error);
+	_dbg_assert_msg_(decodeCS_ != VK_NULL_HANDLE, "failed to compile decode shader");
+	if (decodeCS_ == VK_NULL_HANDLE) {
+		ERROR_LOG(G3D, "Texture decode shader failed to compile, using CPU decoding: %s", error.c_str());
+	}
+}
+
+bool TextureCacheVulkan::CanDecodeWithCompute(const BuildTexturePlan &plan, const TexCacheEntry *entry) {
+	if (decodeCS_ == VK_NULL_HANDLE || plan.depth != 1 || plan.scaleFactor != 1 || plan.replaced->Valid())
+		return false;
+	// The replacer wants the decoded pixels on the CPU.
+	if (replacer_.Enabled())
+		return false;
+	if (entry->format != GE_TFMT_CLUT4 && entry->format != GE_TFMT_CLUT8)
+		return false;
+	// Index transforms and per-level CLUTs aren't handled by the shader.
+	if (!gstate.isClutIndexSimple() || (plan.levelsToLoad > 1 && !gstate.isClutSharedForMipmaps()))
+		return false;
+
+	for (int i = 0; i < plan.levelsToLoad; ++i) {
+		u32 texaddr = gstate.getTextureAddress(i == 0 ? plan.baseLevelSrc : i);
+		// Mirrors can flip the swizzle, let the CPU path deal with those.
+		if ((texaddr & 0x00600000) != 0 && Memory::IsVRAMAddress(texaddr))
+			return false;
+	}
+	return true;
+}
+
+void TextureCacheVulkan::DecodeLevelWithCompute(VkCommandBuffer cmd, TexCacheEntry *entry, int dstLevel, int srcLevel) {
+	VulkanContext *vulkan = (VulkanContext *)draw_->GetNativeObject(Draw::NativeObject::CONTEXT);
+	VulkanPushBuffer *push = drawEngine_->GetPushBufferForTextureData();
+	const VkPhysicalDeviceLimits &limits = vulkan->GetPhysicalDeviceProperties().properties.limits;
+	const int alignment = std::max(16, (int)limits.minStorageBufferOffsetAlignment);
+
+	const GETextureFormat format = (GETextureFormat)entry->format;
+	const GEPaletteFormat clutFormat = gstate.getClutPaletteFormat();
+	const u32 texaddr = gstate.getTextureAddress(srcLevel);
+	const int w = gstate.getTextureWidth(srcLevel);
+	const int h = gstate.getTextureHeight(srcLevel);
+	const int bufw = GetTextureBufw(srcLevel, texaddr, format);
+	const bool swizzled = gstate.isTextureSwizzled();
+
+	// Swizzled data is always in whole blocks of 8 rows.
+	const u32 rowBytes = (textureBitsPerPixel[format] * bufw) / 8;
+	const u32 srcSize = rowBytes * (swizzled ? ((h + 7) & ~7) : h);
+	const u32 validSize = Memory::IsValidAddress(texaddr) ? Memory::ValidSize(texaddr, srcSize) : 0;
+
+	uint32_t srcOffset;
+	VkBuffer srcBuf;
+	u8 *srcData = (u8 *)push->PushAligned(srcSize, &srcOffset, &srcBuf, alignment);
+	Memory::MemcpyUnchecked(srcData, texaddr, validSize);
+	if (validSize < srcSize)
+		memset(srcData + validSize, 0, srcSize - validSize);
+
+	VkBuffer clutBuf;
+	uint32_t clutOffset = push->PushAligned(clutBufRaw_, 1024, alignment, &clutBuf);
+
+	VkImageView view = entry->vkTex->CreateViewForMip(dstLevel);
+	VkDescriptorSet descSet = computeShaderManager_.GetDescriptorSet(view, srcBuf, srcOffset, srcSize, clutBuf, clutOffset, 1024);
+	int flags = (swizzled ? 1 : 0) | ((int)clutFormat << 1) | (format == GE_TFMT_CLUT8 ? 8 : 0);
+	struct Params { int width; int height; int bufw; int flags; } params{ w, h, bufw, flags };
+	VK_PROFILE_BEGIN(vulkan, cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, "Compute Decode: %dx%d", w, h);
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, computeShaderManager_.GetPipeline(decodeCS_));
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, computeShaderManager_.GetPipelineLayout(), 0, 1, &descSet, 0, nullptr);
+	vkCmdPushConstants(cmd, computeShaderManager_.GetPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+	vkCmdDispatch(cmd, (w + 7) / 8, (h + 7) / 8, 1);
+	VK_PROFILE_END(vulkan, cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	vulkan->Delete().QueueDeleteImageView(view);
+
+	if (dstLevel == 0) {
+		// We never see the pixels, so go by the CLUT entries the texture can reach.
+		const int colors = format == GE_TFMT_CLUT4 ? 16 : 256;
+		entry->SetAlphaStatus(CheckAlpha(clutBufRaw_, getClutDestFormatVulkan(clutFormat), colors), 0);
+	}
+	gpuStats.numTexturesDecoded++;
+}
+
 void TextureCacheVulkan::ReleaseTexture(TexCacheEntry *entry, bool delete_them) {
 	delete entry->vkTex;
 	entry->vkTex = nullptr;
@@ -449,12 +614,19 @@ void TextureCacheVulkan::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer
 			gstate_c.SetUseShaderDepal(false);
 		}
 	}
-	if (depalShader) {
+	const DepalResult *cachedDepal = depalShader ? FindDepalResult(framebuffer, depth) : nullptr;
+	if (cachedDepal) {
+		// Already converted with this CLUT, and the framebuffer hasn't changed since.
+		draw_->BindFramebufferAsTexture(cachedDepal->fbo, 0, Draw::FB_COLOR_BIT, 0);
+		imageView_ = (VkImageView)draw_->GetNativeObject(Draw::NativeObject::BOUND_TEXTURE0_IMAGEVIEW);
+		gstate_c.SetTextureFullAlpha(cachedDepal->fullAlpha);
+	} else if (depalShader) {
 		depalShaderCache_->SetPushBuffer(drawEngine_->GetPushBufferForTextureData());
 		const GEPaletteFormat clutFormat = gstate.getClutPaletteFormat();
 		VulkanTexture *clutTexture = depalShaderCache_->GetClutTexture(clutFormat, clutHash_, clutBuf_, expand32);
 
-		Draw::Framebuffer *depalFBO = framebufferManager_->GetTempFBO(TempFBO::DEPAL, framebuffer->renderWidth, framebuffer->renderHeight);
+		DepalResult *depalResult = GetDepalTarget(framebuffer, depth);
+		Draw::Framebuffer *depalFBO = depalResult->fbo;
 		draw_->BindFramebufferAsRenderTarget(depalFBO, { Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE, Draw::RPAction::DONT_CARE }, "Depal");
 
 		Vulkan2D::Vertex verts[4] = {
@@ -540,6 +712,7 @@ void TextureCacheVulkan::ApplyTextureFramebuffer(VirtualFramebuffer *framebuffer
 
 		CheckAlphaResult alphaStatus = CheckAlpha(clutBuf_, getClutDestFormatVulkan(clutFormat), clutTotalColors);
 		gstate_c.SetTextureFullAlpha(alphaStatus == CHECKALPHA_FULL);
+		depalResult->fullAlpha = alphaStatus == CHECKALPHA_FULL;
 
 		framebufferManager_->RebindFramebuffer("RebindFramebuffer - ApplyTextureFramebuffer");
 		draw_->BindFramebufferAsTexture(depalFBO, 0, Draw::FB_COLOR_BIT, 0);
@@ -613,6 +786,12 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		plan.levelsToCreate = maxPossibleMipLevels;
 	}
 
+	// The compute decoder always writes 8888.
+	bool computeDecode = CanDecodeWithCompute(plan, entry);
+	if (computeDecode) {
+		dstFmt = VULKAN_8888_FORMAT;
+	}
+
 	// Any texture scaling is gonna move away from the original 16-bit format, if any.
 	VkFormat actualFmt = plan.scaleFactor > 1 ? VULKAN_8888_FORMAT : dstFmt;
 	if (plan.replaced->Valid()) {
@@ -645,16 +824,24 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		}
 	}
 
-	if (computeUpload) {
+	if (computeUpload || computeDecode) {
 		usage |= VK_IMAGE_USAGE_STORAGE_BIT;
 		imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 	}
 
+	// Replacements are plain copies of every level, so they can go through the transfer queue and overlap with rendering.
+	VulkanRenderManager *renderManager = (VulkanRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
+	VkCommandBuffer cmdTransfer = VK_NULL_HANDLE;
+	if (g_Config.bAsyncTextureUpload && plan.replaced->Valid() && plan.depth == 1 && plan.levelsToLoad == plan.levelsToCreate && !computeUpload && !computeDecode && drawEngine_->GetPushBufferForTransfer()) {
+		cmdTransfer = renderManager->GetTransferCmd();
+	}
+	VkCommandBuffer cmdCreate = cmdTransfer ? cmdTransfer : cmdInit;
+
 	char texName[128]{};
 	snprintf(texName, sizeof(texName), "tex_%08x_%s", entry->addr, GeTextureFormatToString((GETextureFormat)entry->format, gstate.getClutPaletteFormat()));
 	image->SetTag(texName);
 
-	bool allocSuccess = image->CreateDirect(cmdInit, plan.w * plan.scaleFactor, plan.h * plan.scaleFactor, plan.depth, plan.levelsToCreate, actualFmt, imageLayout, usage, mapping);
+	bool allocSuccess = image->CreateDirect(cmdCreate, plan.w * plan.scaleFactor, plan.h * plan.scaleFactor, plan.depth, plan.levelsToCreate, actualFmt, imageLayout, usage, mapping);
 	if (!allocSuccess && !lowMemoryMode_) {
 		WARN_LOG_REPORT(G3D, "Texture cache ran out of GPU memory; switching to low memory mode");
 		lowMemoryMode_ = true;
@@ -672,8 +859,10 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 
 		plan.scaleFactor = 1;
 		actualFmt = dstFmt;
+		// The fallback image isn't a storage image.
+		computeDecode = false;
 
-		allocSuccess = image->CreateDirect(cmdInit, plan.w * plan.scaleFactor, plan.h * plan.scaleFactor, plan.depth, plan.levelsToCreate, actualFmt, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, mapping);
+		allocSuccess = image->CreateDirect(cmdCreate, plan.w * plan.scaleFactor, plan.h * plan.scaleFactor, plan.depth, plan.levelsToCreate, actualFmt, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, mapping);
 	}
 
 	if (!allocSuccess) {
@@ -745,18 +934,21 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		bool dataScaled = true;
 		if (plan.replaced->Valid()) {
 			// Directly load the replaced image.
-			data = drawEngine_->GetPushBufferForTextureData()->PushAligned(size, &bufferOffset, &texBuf, pushAlignment);
+			VulkanPushBuffer *push = cmdTransfer ? drawEngine_->GetPushBufferForTransfer() : drawEngine_->GetPushBufferForTextureData();
+			data = push->PushAligned(size, &bufferOffset, &texBuf, pushAlignment);
 			double replaceStart = time_now_d();
 			plan.replaced->Load(i, data, stride);  // if it fails, it'll just be garbage data... OK for now.
 			replacementTimeThisFrame_ += time_now_d() - replaceStart;
 			VK_PROFILE_BEGIN(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT,
 				"Copy Upload (replaced): %dx%d", mipWidth, mipHeight);
-			entry->vkTex->UploadMip(cmdInit, i, mipWidth, mipHeight, 0, texBuf, bufferOffset, stride / bpp);
+			entry->vkTex->UploadMip(cmdCreate, i, mipWidth, mipHeight, 0, texBuf, bufferOffset, stride / bpp);
 			VK_PROFILE_END(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT);
 		} else {
 			if (plan.depth != 1) {
 				loadLevel(size, i, stride, plan.scaleFactor);
 				entry->vkTex->UploadMip(cmdInit, 0, mipWidth, mipHeight, i, texBuf, bufferOffset, stride / bpp);
+			} else if (computeDecode) {
+				DecodeLevelWithCompute(cmdInit, entry, i, i == 0 ? plan.baseLevelSrc : i);
 			} else if (computeUpload) {
 				int srcBpp = dstFmt == VULKAN_8888_FORMAT ? 4 : 2;
 				int srcStride = mipUnscaledWidth * srcBpp;
@@ -793,20 +985,25 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 		}
 	}
 
-	VkImageLayout layout = computeUpload ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	VkPipelineStageFlags prevStage = computeUpload ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT;
+	VkImageLayout layout = computeUpload || computeDecode ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	VkPipelineStageFlags prevStage = computeUpload || computeDecode ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT;
 
 	// Generate any additional mipmap levels.
 	// This will transition the whole stack to GENERAL if it wasn't already.
 	if (plan.levelsToLoad < plan.levelsToCreate) {
 		VK_PROFILE_BEGIN(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT, "Mipgen up to level %d", plan.levelsToCreate);
-		entry->vkTex->GenerateMips(cmdInit, plan.levelsToLoad, computeUpload);
+		entry->vkTex->GenerateMips(cmdInit, plan.levelsToLoad, computeUpload || computeDecode);
 		layout = VK_IMAGE_LAYOUT_GENERAL;
 		prevStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 		VK_PROFILE_END(vulkan, cmdInit, VK_PIPELINE_STAGE_TRANSFER_BIT);
 	}
 
-	entry->vkTex->EndCreate(cmdInit, false, prevStage, layout);
+	if (cmdTransfer) {
+		// Arrives on the graphics queue in SHADER_READ_ONLY_OPTIMAL, like EndCreate would do.
+		renderManager->ReleaseImageToGraphics(entry->vkTex->GetImage(), entry->vkTex->GetNumMips());
+	} else {
+		entry->vkTex->EndCreate(cmdInit, false, prevStage, layout);
+	}
 	VK_PROFILE_END(vulkan, cmdInit, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
 	// Signal that we support depth textures so use it as one.
@@ -893,7 +1090,7 @@ void TextureCacheVulkan::LoadTextureLevel(TexCacheEntry &entry, uint8_t *writePt
 		u32 fmt = dstFmt;
 		// CPU scaling reads from the destination buffer so we want cached RAM.
 		uint8_t *rearrange = (uint8_t *)AllocateAlignedMemory(w * scaleFactor * h * scaleFactor * 4, 16);
-		scaler_.ScaleAlways((u32 *)rearrange, pixelData, w, h, scaleFactor);
+		ScaleTextureLevel(entry, level, (u32 *)rearrange, pixelData, w, h, scaleFactor);
 		pixelData = (u32 *)writePtr;
 
 		// We always end up at 8888.  Other parts assume this.
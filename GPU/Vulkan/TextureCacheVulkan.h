@@ -113,6 +113,9 @@ class TextureCacheVulkan : public TextureCacheCommon {
 	void BuildTexture(TexCacheEntry *const entry) override;
 
 	void CompileScalingShader();
+	void CompileDecodeShader();
+	bool CanDecodeWithCompute(const BuildTexturePlan &plan, const TexCacheEntry *entry);
+	void DecodeLevelWithCompute(VkCommandBuffer cmd, TexCacheEntry *entry, int dstLevel, int srcLevel);
 
 	VulkanDeviceAllocator *allocator_ = nullptr;
 	VulkanPushBuffer *push_ = nullptr;
@@ -128,6 +131,7 @@ class TextureCacheVulkan : public TextureCacheCommon {
 
 	std::string textureShader_;
 	VkShaderModule uploadCS_ = VK_NULL_HANDLE;
+	VkShaderModule decodeCS_ = VK_NULL_HANDLE;
 
 	// Bound state to emulate an API similar to the others
 	VkImageView imageView_ = VK_NULL_HANDLE;
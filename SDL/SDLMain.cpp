@@ -479,6 +479,7 @@ static std::atomic<int> emuThreadState((int)EmuThreadState::DISABLED);
 
 static void EmuThreadFunc(GraphicsContext *graphicsContext) {
 	SetCurrentThreadName("Emu");
+	SetCurrentThreadRole(ThreadRole::EMU);
 
 	// There's no real requirement that NativeInit happen on this thread.
 	// We just call the update/render loop here.
@@ -333,8 +333,13 @@ void BackgroundAudio::SetGame(const Path &path) {
 	bgGamePath_ = path;
 }
 
+// Called from the host audio callback, which must never block.
 int BackgroundAudio::Play() {
-	std::lock_guard<std::mutex> lock(mutex_);
+	std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+	if (!lock.owns_lock()) {
+		// The UI thread is changing things, just play a bit more next time.
+		return 0;
+	}
 
 	// Immediately stop the sound if it is turned off while playing.
 	if (!g_Config.bEnableSound) {
@@ -405,10 +410,12 @@ void BackgroundAudio::Update() {
 	// If there's a game, and some time has passed since the selected game
 	// last changed... (to prevent crazy amount of reads when skipping through a list)
 	if (sndLoadPending_ && (time_now_d() - gameLastChanged_ > 0.5)) {
-		std::lock_guard<std::mutex> lock(mutex_);
 		// Already loaded somehow?  Or no game info cache?
-		if (at3Reader_ || !g_gameInfoCache)
-			return;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (at3Reader_ || !g_gameInfoCache)
+				return;
+		}
 
 		// Grab some audio from the current game and play it.
 		std::shared_ptr<GameInfo> gameInfo = g_gameInfoCache->GetInfo(nullptr, bgGamePath_, GAMEINFO_WANTSND);
@@ -417,9 +424,16 @@ void BackgroundAudio::Update() {
 			return;
 		}
 
+		// Set up the reader outside the lock, so the audio callback isn't stuck waiting on it.
+		AT3PlusReader *reader = nullptr;
 		const std::string &data = gameInfo->sndFileData;
 		if (!data.empty()) {
-			at3Reader_ = new AT3PlusReader(data);
+			reader = new AT3PlusReader(data);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (reader) {
+			at3Reader_ = reader;
 			lastPlaybackTime_ = 0.0;
 		}
 		sndLoadPending_ = false;
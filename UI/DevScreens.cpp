@@ -54,7 +54,9 @@
 #include "Core/ConfigValues.h"
 #include "Core/System.h"
 #include "Core/Reporting.h"
+#include "Core/SaveState.h"
 #include "Core/CoreParameter.h"
+#include "Core/Debugger/SampleProfiler.h"
 #include "Core/MIPS/MIPSTables.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
@@ -66,6 +68,7 @@
 #include "UI/MainScreen.h"
 #include "UI/ControlMappingScreen.h"
 #include "UI/GameSettingsScreen.h"
+#include "UI/OnScreenDisplay.h"
 
 
 #ifdef _WIN32
@@ -100,9 +103,12 @@ void DevMenu::CreatePopupContents(UI::ViewGroup *parent) {
 	items->Add(new Choice(sy->T("Developer Tools")))->OnClick.Handle(this, &DevMenu::OnDeveloperTools);
 	items->Add(new Choice(dev->T("Jit Compare")))->OnClick.Handle(this, &DevMenu::OnJitCompare);
 	items->Add(new Choice(dev->T("Shader Viewer")))->OnClick.Handle(this, &DevMenu::OnShaderView);
+	items->Add(new Choice(dev->T("Savestate Profile")))->OnClick.Handle(this, &DevMenu::OnSaveStateProfile);
 	if (g_Config.iGPUBackend == (int)GPUBackend::VULKAN) {
 		// TODO: Make a new allocator visualizer for VMA.
 		// items->Add(new CheckBox(&g_Config.bShowAllocatorDebug, dev->T("Allocator Viewer")));
+	}
+	if (g_Config.iGPUBackend != (int)GPUBackend::DIRECT3D9) {
 		items->Add(new CheckBox(&g_Config.bShowGpuProfile, dev->T("GPU Profile")));
 	}
 	items->Add(new Choice(dev->T("Toggle Freeze")))->OnClick.Handle(this, &DevMenu::OnFreezeFrame);
@@ -110,7 +116,9 @@ void DevMenu::CreatePopupContents(UI::ViewGroup *parent) {
 	items->Add(new Choice(dev->T("Toggle Audio Debug")))->OnClick.Handle(this, &DevMenu::OnToggleAudioDebug);
 #ifdef USE_PROFILER
 	items->Add(new CheckBox(&g_Config.bShowFrameProfiler, dev->T("Frame Profiler"), ""));
+	items->Add(new Choice(dev->T("Toggle Timeline Trace")))->OnClick.Handle(this, &DevMenu::OnToggleTrace);
 #endif
+	items->Add(new Choice(dev->T("Toggle CPU Sampling Profiler")))->OnClick.Handle(this, &DevMenu::OnToggleSampleProfiler);
 	items->Add(new CheckBox(&g_Config.bDrawFrameGraph, dev->T("Draw Frametimes Graph")));
 	items->Add(new Choice(dev->T("Reset limited logging")))->OnClick.Handle(this, &DevMenu::OnResetLimitedLogging);
 
@@ -123,6 +131,39 @@ void DevMenu::CreatePopupContents(UI::ViewGroup *parent) {
 	}
 }
 
+UI::EventReturn DevMenu::OnToggleTrace(UI::EventParams &e) {
+#ifdef USE_PROFILER
+	if (!Profiler_IsTracing()) {
+		Profiler_StartTrace();
+		osm.Show("Timeline trace started", 1.0f);
+	} else {
+		Path filename = GetSysDirectory(DIRECTORY_DUMP) / "trace.json";
+		if (Profiler_StopTrace(filename.c_str())) {
+			osm.Show("Timeline trace saved to " + filename.ToVisualString(), 3.0f);
+		} else {
+			osm.Show("Failed to save timeline trace", 3.0f);
+		}
+	}
+#endif
+	return UI::EVENT_DONE;
+}
+
+UI::EventReturn DevMenu::OnToggleSampleProfiler(UI::EventParams &e) {
+	if (!SampleProfiler::IsRunning()) {
+		SampleProfiler::Start();
+		osm.Show("CPU sampling profiler started", 1.0f);
+	} else {
+		SampleProfiler::Stop();
+		Path filename = SampleProfiler::DefaultProfilePath();
+		if (SampleProfiler::SaveProfile(filename)) {
+			osm.Show("CPU profile saved to " + filename.ToVisualString(), 3.0f);
+		} else {
+			osm.Show("Failed to save CPU profile", 3.0f);
+		}
+	}
+	return UI::EVENT_DONE;
+}
+
 UI::EventReturn DevMenu::OnToggleAudioDebug(UI::EventParams &e) {
 	g_Config.bShowAudioDebug = !g_Config.bShowAudioDebug;
 	return UI::EVENT_DONE;
@@ -164,6 +205,13 @@ UI::EventReturn DevMenu::OnShaderView(UI::EventParams &e) {
 	return UI::EVENT_DONE;
 }
 
+UI::EventReturn DevMenu::OnSaveStateProfile(UI::EventParams &e) {
+	UpdateUIState(UISTATE_PAUSEMENU);
+	if (PSP_IsInited())
+		screenManager()->push(new SaveStateProfileScreen());
+	return UI::EVENT_DONE;
+}
+
 UI::EventReturn DevMenu::OnFreezeFrame(UI::EventParams &e) {
 	if (PSP_CoreParameter().frozen) {
 		PSP_CoreParameter().frozen = false;
@@ -380,6 +428,7 @@ static const JitDisableFlag jitDisableFlags[] = {
 	{ MIPSComp::JitDisable::LSU_UNALIGNED, "LSU_UNALIGNED" },
 	{ MIPSComp::JitDisable::LSU_FPU, "LSU_FPU" },
 	{ MIPSComp::JitDisable::LSU_VFPU, "LSU_VFPU" },
+	{ MIPSComp::JitDisable::IR_TRACES, "IR_TRACES" },
 	{ MIPSComp::JitDisable::SIMD, "SIMD" },
 	{ MIPSComp::JitDisable::BLOCKLINK, "Block Linking" },
 	{ MIPSComp::JitDisable::POINTERIFY, "Pointerify" },
@@ -901,6 +950,7 @@ void JitCompareScreen::CreateViews() {
 	leftColumn->Add(new Choice(dev->T("FPU")))->OnClick.Handle(this, &JitCompareScreen::OnRandomFPUBlock);
 	leftColumn->Add(new Choice(dev->T("VFPU")))->OnClick.Handle(this, &JitCompareScreen::OnRandomVFPUBlock);
 	leftColumn->Add(new Choice(dev->T("Stats")))->OnClick.Handle(this, &JitCompareScreen::OnShowStats);
+	leftColumn->Add(new Choice(dev->T("Export compile log")))->OnClick.Handle(this, &JitCompareScreen::OnExportCompileLog);
 	leftColumn->Add(new Choice(di->T("Back")))->OnClick.Handle<UIScreen>(this, &UIScreen::OnBack);
 	blockName_ = leftColumn->Add(new TextView(dev->T("No block")));
 	blockAddr_ = leftColumn->Add(new TextEdit("", dev->T("Block address"), "", new LayoutParams(FILL_PARENT, WRAP_CONTENT)));
@@ -995,6 +1045,7 @@ UI::EventReturn JitCompareScreen::OnShowStats(UI::EventParams &e) {
 	NOTICE_LOG(JIT, "Average Bloat: %0.2f%%", 100 * bcStats.avgBloat);
 	NOTICE_LOG(JIT, "Min Bloat: %0.2f%%  (%08x)", 100 * bcStats.minBloat, bcStats.minBloatBlock);
 	NOTICE_LOG(JIT, "Max Bloat: %0.2f%%  (%08x)", 100 * bcStats.maxBloat, bcStats.maxBloatBlock);
+	NOTICE_LOG(JIT, "Invalidations: %u, blocks checked: %u, destroyed: %u", bcStats.numInvalidations, bcStats.numInvalidationChecks, bcStats.numInvalidatedBlocks);
 
 	int ctr = 0, sz = (int)bcStats.bloatMap.size();
 	for (auto iter : bcStats.bloatMap) {
@@ -1008,6 +1059,15 @@ UI::EventReturn JitCompareScreen::OnShowStats(UI::EventParams &e) {
 	return UI::EVENT_DONE;
 }
 
+UI::EventReturn JitCompareScreen::OnExportCompileLog(UI::EventParams &e) {
+	Path filename = MIPSComp::ExportGameCompileLog();
+	if (!filename.empty()) {
+		osm.Show("JIT compile log saved to " + filename.ToVisualString(), 3.0f);
+	} else {
+		osm.Show("Failed to save JIT compile log", 3.0f);
+	}
+	return UI::EVENT_DONE;
+}
 
 UI::EventReturn JitCompareScreen::OnSelectBlock(UI::EventParams &e) {
 	auto dev = GetI18NCategory("Developer");
@@ -1184,6 +1244,62 @@ UI::EventReturn ShaderListScreen::OnShaderClick(UI::EventParams &e) {
 	return EVENT_DONE;
 }
 
+SaveStateProfileScreen::SaveStateProfileScreen() {
+	UI::EventParams e{};
+	OnRefresh(e);
+}
+
+void SaveStateProfileScreen::CreateViews() {
+	using namespace UI;
+
+	auto di = GetI18NCategory("Dialog");
+	auto dev = GetI18NCategory("Developer");
+
+	LinearLayout *layout = new LinearLayout(ORIENT_VERTICAL);
+	root_ = layout;
+
+	ScrollView *scroll = new ScrollView(ORIENT_VERTICAL, new LinearLayoutParams(1.0));
+	scroll->SetTag("DevSaveStateProfile");
+	LinearLayout *list = new LinearLayoutList(ORIENT_VERTICAL, new LayoutParams(FILL_PARENT, WRAP_CONTENT));
+	list->Add(new ItemHeader(dev->T("Savestate Profile")));
+
+	std::vector<PointerWrap::SectionStats> sections;
+	if (shown_)
+		sections = SaveState::GetLastProfile();
+	if (sections.empty()) {
+		list->Add(new TextView(dev->T("Waiting for the game to run...")));
+	}
+	for (const auto &section : sections) {
+		std::string title = std::string(section.depth * 2, ' ') + section.title;
+		list->Add(new InfoItem(title, StringFromFormat("%0.1f KB, %0.3f ms", section.size / 1024.0, section.seconds * 1000.0)));
+	}
+	scroll->Add(list);
+	layout->Add(scroll);
+
+	LinearLayout *buttons = new LinearLayout(ORIENT_HORIZONTAL, new LinearLayoutParams(FILL_PARENT, WRAP_CONTENT));
+	buttons->Add(new Button(dev->T("Refresh")))->OnClick.Handle(this, &SaveStateProfileScreen::OnRefresh);
+	buttons->Add(new Button(di->T("Back")))->OnClick.Handle<UIScreen>(this, &UIScreen::OnBack);
+	layout->Add(buttons);
+}
+
+void SaveStateProfileScreen::update() {
+	UIDialogScreenWithBackground::update();
+	if (!shown_ && done_ && *done_) {
+		shown_ = true;
+		RecreateViews();
+	}
+}
+
+UI::EventReturn SaveStateProfileScreen::OnRefresh(UI::EventParams &e) {
+	std::shared_ptr<std::atomic<bool>> done = std::make_shared<std::atomic<bool>>(false);
+	done_ = done;
+	shown_ = false;
+	SaveState::Profile([done](SaveState::Status status, const std::string &message, void *) {
+		*done = true;
+	});
+	return UI::EVENT_DONE;
+}
+
 void ShaderViewScreen::CreateViews() {
 	using namespace UI;
 
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -40,10 +41,13 @@ class DevMenu : public PopupScreen {
 	UI::EventReturn OnLogConfig(UI::EventParams &e);
 	UI::EventReturn OnJitCompare(UI::EventParams &e);
 	UI::EventReturn OnShaderView(UI::EventParams &e);
+	UI::EventReturn OnSaveStateProfile(UI::EventParams &e);
 	UI::EventReturn OnFreezeFrame(UI::EventParams &e);
 	UI::EventReturn OnDumpFrame(UI::EventParams &e);
 	UI::EventReturn OnDeveloperTools(UI::EventParams &e);
 	UI::EventReturn OnToggleAudioDebug(UI::EventParams &e);
+	UI::EventReturn OnToggleTrace(UI::EventParams &e);
+	UI::EventReturn OnToggleSampleProfiler(UI::EventParams &e);
 	UI::EventReturn OnResetLimitedLogging(UI::EventParams &e);
 };
 
@@ -145,6 +149,7 @@ class JitCompareScreen : public UIDialogScreenWithBackground {
 	UI::EventReturn OnBlockAddress(UI::EventParams &e);
 	UI::EventReturn OnAddressChange(UI::EventParams &e);
 	UI::EventReturn OnShowStats(UI::EventParams &e);
+	UI::EventReturn OnExportCompileLog(UI::EventParams &e);
 
 	int currentBlock_;
 
@@ -180,6 +185,22 @@ class ShaderViewScreen : public UIDialogScreenWithBackground {
 	DebugShaderType type_;
 };
 
+// Size and save time of each DoState section, to find which modules make states big.
+class SaveStateProfileScreen : public UIDialogScreenWithBackground {
+public:
+	SaveStateProfileScreen();
+
+	void CreateViews() override;
+	void update() override;
+
+private:
+	UI::EventReturn OnRefresh(UI::EventParams &e);
+
+	// Shared with the callback, which runs on the emu thread and might outlive the screen.
+	std::shared_ptr<std::atomic<bool>> done_;
+	bool shown_ = false;
+};
+
 class FrameDumpTestScreen : public UIDialogScreenWithBackground {
 public:
 	FrameDumpTestScreen();
@@ -343,6 +343,7 @@ void EmuScreen::bootComplete() {
 	host->UpdateDisassembly();
 
 	NOTICE_LOG(BOOT, "Loading %s...", PSP_CoreParameter().fileToStart.c_str());
+	PSP_TraceStartup("Boot complete");
 	autoLoad();
 
 	auto sc = GetI18NCategory("Screen");
@@ -1138,6 +1139,7 @@ static const char *CPUCoreAsString(int core) {
 	case 0: return "Interpreter";
 	case 1: return "JIT";
 	case 2: return "IR Interpreter";
+	case 3: return "JIT using IR";
 	default: return "N/A";
 	}
 }
@@ -1322,6 +1324,8 @@ static void DrawFrameTimes(UIContext *ctx, const Bounds &bounds) {
 void EmuScreen::preRender() {
 	using namespace Draw;
 	DrawContext *draw = screenManager()->getDrawContext();
+	// The websocket stats feed also reports GPU timings.
+	draw->SetGpuProfilingEnabled(g_Config.bShowGpuProfile || coreCollectDebugStats);
 	draw->BeginFrame();
 	// Here we do NOT bind the backbuffer or clear the screen, unless non-buffered.
 	// The emuscreen is different than the others - we really want to allow the game to render to framebuffers
@@ -1404,6 +1408,10 @@ void EmuScreen::render() {
 	case CORE_NEXTFRAME:
 		// Reached the end of the frame, all good. Set back to running for the next frame
 		coreState = CORE_RUNNING;
+		if (!firstFrameTraced_) {
+			PSP_TraceStartup("First game frame");
+			firstFrameTraced_ = true;
+		}
 		break;
 	case CORE_STEPPING:
 	case CORE_RUNTIME_ERROR:
@@ -1516,7 +1524,7 @@ void EmuScreen::renderUI() {
 		DrawAllocatorVis(ctx, gpu);
 	}
 
-	if (g_Config.iGPUBackend == (int)GPUBackend::VULKAN && g_Config.bShowGpuProfile) {
+	if (g_Config.bShowGpuProfile) {
 		DrawGPUProfilerVis(ctx, gpu);
 	}
 
@@ -75,6 +75,7 @@ class EmuScreen : public UIScreen {
 	UI::Event OnDevMenu;
 	UI::Event OnChatMenu;
 	bool bootPending_ = true;
+	bool firstFrameTraced_ = false;
 	Path gamePath_;
 
 	// Something invalid was loaded, don't try to emulate
@@ -43,6 +43,12 @@
 
 GameInfoCache *g_gameInfoCache;
 
+// Cancelable work that hasn't been asked for in this long when it's about to start is skipped.
+static const double GAMEINFO_CANCEL_UNSEEN_SECONDS = 0.5;
+// Infos nobody has asked for in this long are dropped, along with their textures.
+static const double GAMEINFO_TRIM_UNUSED_SECONDS = 60.0;
+static const double GAMEINFO_TRIM_INTERVAL_SECONDS = 5.0;
+
 GameInfo::GameInfo() : fileType(IdentifiedFileType::UNKNOWN) {
 	pending = true;
 }
@@ -327,6 +333,199 @@ static bool ReadVFSToString(const char *filename, std::string *contents, std::mu
 	return data != nullptr;
 }
 
+// Remembers PARAM.SFO and ICON0 of game files between runs, so the game list doesn't have to
+// open and parse hundreds of ISOs on startup. Entries are revalidated against the file's size
+// and modification time every time they're used, which costs a stat instead of a disc read.
+//
+// File format, all little endian:
+//   8  magic
+//   32 version
+//   32 count
+// entries[count]
+//   32 path length, path
+//   64 file size
+//   64 file mtime
+//   32 file type
+//   32 PARAM.SFO length, PARAM.SFO
+//   32 icon length, icon
+static const char *const GAMEINFO_DISKCACHE_MAGIC = "ppssppGI";
+static const u32 GAMEINFO_DISKCACHE_VERSION = 1;
+// Only entries used this session are kept beyond this, so removed games eventually drop out.
+static const size_t GAMEINFO_DISKCACHE_MAX_ENTRIES = 2048;
+// Save from the worker every so often while scanning, in case we're killed rather than shut down.
+static const int GAMEINFO_DISKCACHE_SAVE_INTERVAL = 64;
+
+class GameInfoDiskCache {
+public:
+	struct Entry {
+		uint64_t size = 0;
+		uint64_t mtime = 0;
+		IdentifiedFileType fileType = IdentifiedFileType::UNKNOWN;
+		std::string paramSFO;
+		std::string icon;
+		bool used = false;
+	};
+
+	bool Lookup(const Path &path, const File::FileInfo &fileInfo, Entry *result);
+	void Store(const Path &path, const File::FileInfo &fileInfo, IdentifiedFileType fileType, const std::string &paramSFO, const std::string &icon);
+	void Save();
+
+private:
+	void LoadIfNeeded();
+	static Path CachePath() {
+		return GetSysDirectory(DIRECTORY_CACHE) / "gameinfo.ppgi";
+	}
+
+	std::mutex lock_;
+	std::map<std::string, Entry> entries_;
+	bool loaded_ = false;
+	int unsaved_ = 0;
+};
+
+static GameInfoDiskCache g_gameInfoDiskCache;
+
+void GameInfoDiskCache::LoadIfNeeded() {
+	if (loaded_)
+		return;
+	loaded_ = true;
+
+	Path cachePath = CachePath();
+	std::string data;
+	if (!File::Exists(cachePath) || !File::ReadFileToString(false, cachePath, data))
+		return;
+
+	size_t pos = 0;
+	auto readBytes = [&](void *dest, size_t sz) {
+		if (pos + sz > data.size())
+			return false;
+		memcpy(dest, &data[pos], sz);
+		pos += sz;
+		return true;
+	};
+	auto readString = [&](std::string *str) {
+		u32 len = 0;
+		if (!readBytes(&len, sizeof(len)) || pos + len > data.size())
+			return false;
+		str->assign(data, pos, len);
+		pos += len;
+		return true;
+	};
+
+	char magic[8];
+	u32 version = 0;
+	u32 count = 0;
+	if (!readBytes(magic, sizeof(magic)) || memcmp(magic, GAMEINFO_DISKCACHE_MAGIC, sizeof(magic)) != 0)
+		return;
+	if (!readBytes(&version, sizeof(version)) || version != GAMEINFO_DISKCACHE_VERSION)
+		return;
+	if (!readBytes(&count, sizeof(count)))
+		return;
+
+	for (u32 i = 0; i < count; ++i) {
+		std::string path;
+		Entry entry;
+		u32 fileType;
+		if (!readString(&path) || !readBytes(&entry.size, 8) || !readBytes(&entry.mtime, 8) || !readBytes(&fileType, 4) || !readString(&entry.paramSFO) || !readString(&entry.icon)) {
+			WARN_LOG(LOADER, "Ignoring corrupt game info cache %s", cachePath.c_str());
+			entries_.clear();
+			return;
+		}
+		entry.fileType = (IdentifiedFileType)fileType;
+		entries_[path] = std::move(entry);
+	}
+
+	INFO_LOG(LOADER, "Loaded %d game info entries from cache", (int)count);
+}
+
+bool GameInfoDiskCache::Lookup(const Path &path, const File::FileInfo &fileInfo, Entry *result) {
+	std::lock_guard<std::mutex> guard(lock_);
+	LoadIfNeeded();
+
+	auto iter = entries_.find(path.ToString());
+	if (iter == entries_.end())
+		return false;
+	if (iter->second.size != fileInfo.size || iter->second.mtime != fileInfo.mtime) {
+		// The file changed, it'll be stored again once it's been read.
+		entries_.erase(iter);
+		unsaved_++;
+		return false;
+	}
+
+	iter->second.used = true;
+	*result = iter->second;
+	return true;
+}
+
+void GameInfoDiskCache::Store(const Path &path, const File::FileInfo &fileInfo, IdentifiedFileType fileType, const std::string &paramSFO, const std::string &icon) {
+	bool save;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		LoadIfNeeded();
+
+		Entry &entry = entries_[path.ToString()];
+		entry.size = fileInfo.size;
+		entry.mtime = fileInfo.mtime;
+		entry.fileType = fileType;
+		entry.paramSFO = paramSFO;
+		entry.icon = icon;
+		entry.used = true;
+		save = ++unsaved_ >= GAMEINFO_DISKCACHE_SAVE_INTERVAL;
+	}
+
+	if (save)
+		Save();
+}
+
+void GameInfoDiskCache::Save() {
+	std::lock_guard<std::mutex> guard(lock_);
+	Path cacheDir = GetSysDirectory(DIRECTORY_CACHE);
+	if (unsaved_ == 0 || !File::Exists(cacheDir))
+		return;
+	unsaved_ = 0;
+
+	bool onlyUsed = entries_.size() > GAMEINFO_DISKCACHE_MAX_ENTRIES;
+	std::string data;
+	auto writeBytes = [&](const void *src, size_t sz) {
+		data.append((const char *)src, sz);
+	};
+	auto writeString = [&](const std::string &str) {
+		u32 len = (u32)str.size();
+		writeBytes(&len, sizeof(len));
+		writeBytes(str.data(), len);
+	};
+
+	u32 version = GAMEINFO_DISKCACHE_VERSION;
+	writeBytes(GAMEINFO_DISKCACHE_MAGIC, 8);
+	writeBytes(&version, sizeof(version));
+	size_t countPos = data.size();
+	u32 count = 0;
+	writeBytes(&count, sizeof(count));
+
+	for (auto &iter : entries_) {
+		const Entry &entry = iter.second;
+		if (onlyUsed && !entry.used)
+			continue;
+		u32 fileType = (u32)entry.fileType;
+		writeString(iter.first);
+		writeBytes(&entry.size, 8);
+		writeBytes(&entry.mtime, 8);
+		writeBytes(&fileType, 4);
+		writeString(entry.paramSFO);
+		writeString(entry.icon);
+		count++;
+	}
+	memcpy(&data[countPos], &count, sizeof(count));
+
+	// Write then rename, so another instance never sees a partial file.
+	Path cachePath = CachePath();
+	Path tempPath = cachePath.WithExtraExtension(".tmp");
+	if (File::WriteStringToFile(false, data, tempPath)) {
+		if (File::Exists(cachePath))
+			File::Delete(cachePath);
+		File::Rename(tempPath, cachePath);
+	}
+}
+
 
 class GameInfoWorkItem : public Task {
 public:
@@ -346,12 +545,25 @@ class GameInfoWorkItem : public Task {
 	}
 
 	void Run() override {
+		// Whoever asked for this has moved on (e.g. scrolled past it), so don't spend IO on it.
+		if (info_->cancelable && time_now_d() - info_->lastAccessedTime > GAMEINFO_CANCEL_UNSEEN_SECONDS) {
+			info_->cancelled = true;
+			return;
+		}
+
 		// An early-return will result in the destructor running, where we can set
 		// flags like working and pending.
 		if (!info_->LoadFromPath(gamePath_)) {
 			return;
 		}
 
+		// Plain game files can be filled in from the disk cache, unless we need more than it has.
+		File::FileInfo fileInfo;
+		bool cacheable = (info_->wantFlags & (GAMEINFO_WANTBG | GAMEINFO_WANTSND)) == 0 && File::GetFileInfo(gamePath_, &fileInfo) && !fileInfo.isDirectory;
+		if (cacheable && LoadFromDiskCache(fileInfo)) {
+			return;
+		}
+
 		// In case of a remote file, check if it actually exists before locking.
 		if (!info_->GetFileLoader()->Exists()) {
 			return;
@@ -388,6 +600,7 @@ class GameInfoWorkItem : public Task {
 					std::lock_guard<std::mutex> lock(info_->lock);
 					info_->paramSFO.ReadSFO(sfoData);
 					info_->ParseParamSFO();
+					cacheSFO_.assign((const char *)sfoData.data(), sfoData.size());
 
 					// Assuming PSP_PBP_DIRECTORY without ID or with disc_total < 1 in GAME dir must be homebrew
 					if ((info_->id.empty() || !info_->disc_total)
@@ -403,6 +616,7 @@ class GameInfoWorkItem : public Task {
 				if (pbp.GetSubFileSize(PBP_ICON0_PNG) > 0) {
 					std::lock_guard<std::mutex> lock(info_->lock);
 					pbp.GetSubFileAsString(PBP_ICON0_PNG, &info_->icon.data);
+					cacheIcon_ = true;
 				} else {
 					Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.jpg");
 					Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.png");
@@ -576,6 +790,7 @@ class GameInfoWorkItem : public Task {
 					std::lock_guard<std::mutex> lock(info_->lock);
 					info_->paramSFO.ReadSFO((const u8 *)paramSFOcontents.data(), paramSFOcontents.size());
 					info_->ParseParamSFO();
+					cacheSFO_ = paramSFOcontents;
 
 					if (info_->wantFlags & GAMEINFO_WANTBG) {
 						ReadFileToString(&umd, "/PSP_GAME/PIC0.PNG", &info_->pic0.data, nullptr);
@@ -590,7 +805,9 @@ class GameInfoWorkItem : public Task {
 				}
 
 				// Fall back to unknown icon if ISO is broken/is a homebrew ISO, override is allowed though
-				if (!ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
+				if (ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
+					cacheIcon_ = true;
+				} else {
 					Path screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.jpg");
 					Path screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) / (info_->id + "_00000.png");
 					// Try using png/jpg screenshots first
@@ -637,6 +854,42 @@ class GameInfoWorkItem : public Task {
 				break;
 		}
 
+		// Fallback icons (screenshots, unknown.png) can change independently of the file, so skip those.
+		if (cacheable && cacheIcon_ && !cacheSFO_.empty()) {
+			std::string icon;
+			{
+				std::lock_guard<std::mutex> lock(info_->lock);
+				icon = info_->icon.data;
+			}
+			g_gameInfoDiskCache.Store(gamePath_, fileInfo, info_->fileType, cacheSFO_, icon);
+		}
+
+		FinishInfo();
+
+		// INFO_LOG(SYSTEM, "Completed writing info for %s", info_->GetTitle().c_str());
+	}
+
+private:
+	bool LoadFromDiskCache(const File::FileInfo &fileInfo) {
+		GameInfoDiskCache::Entry entry;
+		if (!g_gameInfoDiskCache.Lookup(gamePath_, fileInfo, &entry))
+			return false;
+
+		info_->working = true;
+		{
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->fileType = entry.fileType;
+			info_->paramSFO.ReadSFO((const u8 *)entry.paramSFO.data(), entry.paramSFO.size());
+			info_->ParseParamSFO();
+			info_->icon.data = std::move(entry.icon);
+		}
+		info_->icon.dataLoaded = true;
+
+		FinishInfo();
+		return true;
+	}
+
+	void FinishInfo() {
 		info_->hasConfig = g_Config.hasGameConfig(info_->id);
 
 		if (info_->wantFlags & GAMEINFO_WANTSIZE) {
@@ -645,13 +898,13 @@ class GameInfoWorkItem : public Task {
 			info_->saveDataSize = info_->GetSaveDataSizeInBytes();
 			info_->installDataSize = info_->GetInstallDataSizeInBytes();
 		}
-
-		// INFO_LOG(SYSTEM, "Completed writing info for %s", info_->GetTitle().c_str());
 	}
 
-private:
 	Path gamePath_;
 	std::shared_ptr<GameInfo> info_;
+	// What to put in the disk cache, if this file turns out to have its own PARAM.SFO and icon.
+	std::string cacheSFO_;
+	bool cacheIcon_ = false;
 	DISALLOW_COPY_AND_ASSIGN(GameInfoWorkItem);
 };
 
@@ -668,12 +921,14 @@ void GameInfoCache::Init() {}
 
 void GameInfoCache::Shutdown() {
 	CancelAll();
+	g_gameInfoDiskCache.Save();
 }
 
 void GameInfoCache::Clear() {
 	CancelAll();
 
 	info_.clear();
+	g_gameInfoDiskCache.Save();
 }
 
 void GameInfoCache::CancelAll() {
@@ -723,6 +978,14 @@ void GameInfoCache::WaitUntilDone(std::shared_ptr<GameInfo> &info) {
 std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const Path &gamePath, int wantFlags) {
 	std::shared_ptr<GameInfo> info;
 
+	double now = time_now_d();
+	if (now - lastTrimTime_ > GAMEINFO_TRIM_INTERVAL_SECONDS) {
+		TrimUnused(now);
+	}
+
+	bool cancelable = (wantFlags & GAMEINFO_CANCELABLE) != 0;
+	wantFlags &= ~GAMEINFO_CANCELABLE;
+
 	std::string pathStr = gamePath.ToString();
 
 	auto iter = info_.find(pathStr);
@@ -731,7 +994,11 @@ std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const
 	}
 
 	// If wantFlags don't match, we need to start over.  We'll just queue the work item again.
-	if (info && (info->wantFlags & wantFlags) == wantFlags) {
+	// Same if the work was cancelled, once the worker is done with it.
+	if (info && (info->wantFlags & wantFlags) == wantFlags && !(info->cancelled && !info->pending)) {
+		if (!cancelable) {
+			info->cancelable = false;
+		}
 		if (draw && info->icon.dataLoaded && !info->icon.texture) {
 			SetupTexture(info, draw, info->icon);
 		}
@@ -741,7 +1008,7 @@ std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const
 		if (draw && info->pic1.dataLoaded && !info->pic1.texture) {
 			SetupTexture(info, draw, info->pic1);
 		}
-		info->lastAccessedTime = time_now_d();
+		info->lastAccessedTime = now;
 		return info;
 	}
 
@@ -760,6 +1027,9 @@ std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const
 		std::lock_guard<std::mutex> lock(info->lock);
 		info->wantFlags |= wantFlags;
 		info->pending = true;
+		info->cancelled = false;
+		info->cancelable = cancelable;
+		info->lastAccessedTime = now;
 	}
 
 	GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info);
@@ -771,6 +1041,20 @@ std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const
 	return info;
 }
 
+// Keeps memory in line with what's been on screen lately, rather than with the size of the library.
+void GameInfoCache::TrimUnused(double now) {
+	lastTrimTime_ = now;
+	for (auto iter = info_.begin(); iter != info_.end();) {
+		const std::shared_ptr<GameInfo> &info = iter->second;
+		// If anyone else holds it (including a queued work item), it's still in use.
+		if (info.use_count() == 1 && !info->pending && now - info->lastAccessedTime > GAMEINFO_TRIM_UNUSED_SECONDS) {
+			iter = info_.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
 void GameInfoCache::SetupTexture(std::shared_ptr<GameInfo> &info, Draw::DrawContext *thin3d, GameInfoTex &tex) {
 	using namespace Draw;
 	if (tex.data.size()) {
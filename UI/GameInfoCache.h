@@ -56,6 +56,9 @@ enum GameInfoWantFlags {
 	GAMEINFO_WANTSIZE = 0x02,
 	GAMEINFO_WANTSND = 0x04,
 	GAMEINFO_WANTBGDATA = 0x08, // Use with WANTBG.
+	// Not data: lets the work be skipped if nobody asks again before it starts, e.g. a list item
+	// that has already scrolled away. Keep calling GetInfo while you still want it.
+	GAMEINFO_CANCELABLE = 0x10,
 };
 
 class FileLoader;
@@ -139,7 +142,7 @@ class GameInfo {
 
 	int wantFlags = 0;
 
-	double lastAccessedTime = 0.0;
+	std::atomic<double> lastAccessedTime{};
 
 	u64 gameSize = 0;
 	u64 saveDataSize = 0;
@@ -147,6 +150,10 @@ class GameInfo {
 
 	std::atomic<bool> pending{};
 	std::atomic<bool> working{};
+	// Set when queued with GAMEINFO_CANCELABLE, cleared by any other request.
+	std::atomic<bool> cancelable{};
+	// The work was skipped because nobody wanted it anymore, so it needs to be queued again.
+	std::atomic<bool> cancelled{};
 
 	Event readyEvent;
 
@@ -185,10 +192,12 @@ class GameInfoCache {
 	void Init();
 	void Shutdown();
 	void SetupTexture(std::shared_ptr<GameInfo> &info, Draw::DrawContext *draw, GameInfoTex &tex);
+	void TrimUnused(double now);
 
 	// Maps ISO path to info. Need to use shared_ptr as we can return these pointers - 
 	// and if they get destructed while being in use, that's bad.
 	std::map<std::string, std::shared_ptr<GameInfo> > info_;
+	double lastTrimTime_ = 0.0;
 };
 
 // This one can be global, no good reason not to.
@@ -431,6 +431,10 @@ void GameSettingsScreen::CreateViews() {
 	resolutionChoice_->SetEnabledFunc([] {
 		return !g_Config.bSoftwareRendering && g_Config.iRenderingMode != FB_NON_BUFFERED_MODE;
 	});
+	CheckBox *dynamicResolution = graphicsSettings->Add(new CheckBox(&g_Config.bDynamicResolution, gr->T("Lower resolution when running slow")));
+	dynamicResolution->SetEnabledFunc([] {
+		return !g_Config.bSoftwareRendering && g_Config.iRenderingMode != FB_NON_BUFFERED_MODE && g_Config.iInternalResolution != 1;
+	});
 
 #if PPSSPP_PLATFORM(ANDROID)
 	int deviceType = System_GetPropertyInt(SYSPROP_DEVICE_TYPE);
@@ -453,6 +457,12 @@ void GameSettingsScreen::CreateViews() {
 	});
 #endif
 
+	CheckBox *lowLatencyPacing = graphicsSettings->Add(new CheckBox(&g_Config.bLowLatencyFramePacing, gr->T("Low latency frame pacing")));
+	lowLatencyPacing->OnClick.Add([=](EventParams &e) {
+		settingInfo_->Show(gr->T("LowLatencyFramePacing Tip", "Waits before running each frame rather than before showing it, reducing input lag"), e.v);
+		return UI::EVENT_CONTINUE;
+	});
+
 	CheckBox *frameDuplication = graphicsSettings->Add(new CheckBox(&g_Config.bRenderDuplicateFrames, gr->T("Render duplicate frames to 60hz")));
 	frameDuplication->OnClick.Add([=](EventParams &e) {
 		settingInfo_->Show(gr->T("RenderDuplicateFrames Tip", "Can make framerate smoother in games that run at lower framerates"), e.v);
@@ -676,6 +686,11 @@ void GameSettingsScreen::CreateViews() {
 		audioSettings->Add(new CheckBox(&g_Config.bAutoAudioDevice, a->T("Use new audio devices automatically")));
 	}
 
+	CheckBox *lowLatency = audioSettings->Add(new CheckBox(&g_Config.bLowLatencyAudio, a->T("Low latency audio", "Low latency audio (may crackle)")));
+	lowLatency->SetEnabledPtr(&g_Config.bEnableSound);
+	CheckBox *hqResampling = audioSettings->Add(new CheckBox(&g_Config.bHighQualityResampling, a->T("High quality resampling")));
+	hqResampling->SetEnabledPtr(&g_Config.bEnableSound);
+
 #if PPSSPP_PLATFORM(ANDROID)
 	CheckBox *extraAudio = audioSettings->Add(new CheckBox(&g_Config.bExtraAudioBuffering, a->T("AudioBufferingForBluetooth", "Bluetooth-friendly buffer (slower)")));
 	extraAudio->SetEnabledPtr(&g_Config.bEnableSound);
@@ -700,6 +715,7 @@ void GameSettingsScreen::CreateViews() {
 	controlsSettings->Add(new ItemHeader(ms->T("Controls")));
 	controlsSettings->Add(new Choice(co->T("Control Mapping")))->OnClick.Handle(this, &GameSettingsScreen::OnControlMapping);
 	controlsSettings->Add(new Choice(co->T("Calibrate Analog Stick")))->OnClick.Handle(this, &GameSettingsScreen::OnCalibrateAnalogs);
+	controlsSettings->Add(new CheckBox(&g_Config.bLateInputSampling, co->T("Late input sampling (lower latency)")));
 
 #if defined(USING_WIN_UI)
 	controlsSettings->Add(new CheckBox(&g_Config.bSystemControls, co->T("Enable standard shortcut keys")));
@@ -1023,6 +1039,12 @@ void GameSettingsScreen::CreateViews() {
 	lockedMhz->SetZeroLabel(sy->T("Auto"));
 	PopupSliderChoice *rewindFreq = systemSettings->Add(new PopupSliderChoice(&g_Config.iRewindFlipFrequency, 0, 1800, sy->T("Rewind Snapshot Frequency", "Rewind Snapshot Frequency (mem hog)"), screenManager(), sy->T("frames, 0:off")));
 	rewindFreq->SetZeroLabel(sy->T("Off"));
+	PopupSliderChoice *rewindBudget = systemSettings->Add(new PopupSliderChoice(&g_Config.iRewindMemoryBudgetMB, 16, 2048, sy->T("Rewind Memory Budget"), 16, screenManager(), "MB"));
+	rewindBudget->SetEnabledFunc([] {
+		return g_Config.iRewindFlipFrequency != 0;
+	});
+	PopupSliderChoice *runAhead = systemSettings->Add(new PopupSliderChoice(&g_Config.iRunAheadFrames, 0, 4, sy->T("Run-ahead", "Run-ahead (less input lag, costly)"), screenManager(), sy->T("frames, 0:off")));
+	runAhead->SetZeroLabel(sy->T("Off"));
 
 	systemSettings->Add(new ItemHeader(sy->T("General")));
 
@@ -1043,6 +1065,7 @@ void GameSettingsScreen::CreateViews() {
 	systemSettings->Add(new CheckBox(&g_Config.bEnableStateUndo, sy->T("Savestate slot backups")));
 	static const char *autoLoadSaveStateChoices[] = { "Off", "Oldest Save", "Newest Save", "Slot 1", "Slot 2", "Slot 3", "Slot 4", "Slot 5" };
 	systemSettings->Add(new PopupMultiChoice(&g_Config.iAutoLoadSaveState, sy->T("Auto Load Savestate"), autoLoadSaveStateChoices, 0, ARRAY_SIZE(autoLoadSaveStateChoices), sy->GetName(), screenManager()));
+	systemSettings->Add(new CheckBox(&g_Config.bLazyStateLoad, sy->T("Lazy Savestate Loading", "Fast savestate loading (fill memory on demand)")));
 	if (System_GetPropertyBool(SYSPROP_HAS_KEYBOARD))
 		systemSettings->Add(new CheckBox(&g_Config.bBypassOSKWithKeyboard, sy->T("Use system native keyboard")));
 
@@ -1794,7 +1817,7 @@ void DeveloperToolsScreen::CreateViews() {
 	// iOS can now use JIT on all modes, apparently.
 	// The bool may come in handy for future non-jit platforms though (UWP XB1?)
 
-	static const char *cpuCores[] = {"Interpreter", "Dynarec (JIT)", "IR Interpreter"};
+	static const char *cpuCores[] = {"Interpreter", "Dynarec (JIT)", "IR Interpreter", "JIT using IR"};
 	PopupMultiChoice *core = list->Add(new PopupMultiChoice(&g_Config.iCpuCore, gr->T("CPU Core"), cpuCores, 0, ARRAY_SIZE(cpuCores), sy->GetName(), screenManager()));
 	core->OnChoice.Handle(this, &DeveloperToolsScreen::OnJitAffectingSetting);
 	if (!canUseJit) {
@@ -1864,6 +1887,12 @@ void DeveloperToolsScreen::CreateViews() {
 		}
 		return true;
 	});
+
+	Choice *buildTexturePack = list->Add(new Choice(dev->T("Build textures.pack for current game")));
+	buildTexturePack->OnClick.Handle(this, &DeveloperToolsScreen::OnBuildTexturePack);
+	buildTexturePack->SetEnabledFunc([] {
+		return PSP_IsInited();
+	});
 }
 
 void DeveloperToolsScreen::onFinish(DialogResult result) {
@@ -1935,6 +1964,17 @@ UI::EventReturn DeveloperToolsScreen::OnOpenTexturesIniFile(UI::EventParams &e)
 	return UI::EVENT_DONE;
 }
 
+UI::EventReturn DeveloperToolsScreen::OnBuildTexturePack(UI::EventParams &e) {
+	auto dev = GetI18NCategory("Developer");
+	Path packFilename;
+	if (TextureReplacer::BuildPack(g_paramSFO.GetDiscID(), packFilename)) {
+		System_Toast((packFilename.ToVisualString() + ": " + dev->T("Texture pack built")).c_str());
+	} else {
+		System_Toast(dev->T("Failed to build texture pack"));
+	}
+	return UI::EVENT_DONE;
+}
+
 UI::EventReturn DeveloperToolsScreen::OnLogConfig(UI::EventParams &e) {
 	screenManager()->push(new LogConfigScreen());
 	return UI::EVENT_DONE;
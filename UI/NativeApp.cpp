@@ -83,6 +83,7 @@
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/Core.h"
+#include "Core/Debugger/SampleProfiler.h"
 #include "Core/FileLoaders/DiskCachingFileLoader.h"
 #include "Core/Host.h"
 #include "Core/KeyMap.h"
@@ -455,6 +456,7 @@ static void ClearFailedGPUBackends() {
 }
 
 void NativeInit(int argc, const char *argv[], const char *savegame_dir, const char *external_dir, const char *cache_dir) {
+	PSP_TraceStartup("NativeInit");
 	net::Init();  // This needs to happen before we load the config. So on Windows we also run it in Main. It's fine to call multiple times.
 
 	ShaderTranslationInit();
@@ -606,6 +608,7 @@ void NativeInit(int argc, const char *argv[], const char *savegame_dir, const ch
 	// Note that if we don't have storage permission here, loading the config will
 	// fail and it will be set to the default. Later, we load again when we get permission.
 	g_Config.Load();
+	PSP_TraceStartup("Config loaded");
 #endif
 
 	LogManager *logman = LogManager::GetInstance();
@@ -759,6 +762,7 @@ void NativeInit(int argc, const char *argv[], const char *savegame_dir, const ch
 	logger = new PrintfLogger();
 	logman->AddListener(logger);
 #endif
+	logman->SetAsyncOutput(true);
 
 	if (System_GetPropertyBool(SYSPROP_SUPPORTS_PERMISSIONS)) {
 		if (System_GetPermissionStatus(SYSTEM_PERMISSION_STORAGE) != PERMISSION_STATUS_GRANTED) {
@@ -766,7 +770,7 @@ void NativeInit(int argc, const char *argv[], const char *savegame_dir, const ch
 		}
 	}
 
-	if (System_GetPropertyBool(SYSPROP_CAN_JIT) == false && g_Config.iCpuCore == (int)CPUCore::JIT) {
+	if (System_GetPropertyBool(SYSPROP_CAN_JIT) == false && (g_Config.iCpuCore == (int)CPUCore::JIT || g_Config.iCpuCore == (int)CPUCore::JIT_IR)) {
 		// Just gonna force it to the IR interpreter on startup.
 		// We don't hide the option, but we make sure it's off on bootup. In case someone wants
 		// to experiment in future iOS versions or something...
@@ -791,11 +795,10 @@ void NativeInit(int argc, const char *argv[], const char *savegame_dir, const ch
 		g_Config.sFont = des->T("Font", "Roboto");
 	}
 #elif defined(USING_QT_UI)
-	size_t fontSize = 0;
-	uint8_t *fontData = VFSReadFile("Roboto-Condensed.ttf", &fontSize);
+	VFSFileView *fontData = VFSOpenFile("Roboto-Condensed.ttf");
 	if (fontData) {
-		int fontID = QFontDatabase::addApplicationFontFromData(QByteArray((const char *)fontData, fontSize));
-		delete [] fontData;
+		int fontID = QFontDatabase::addApplicationFontFromData(QByteArray((const char *)fontData->Data(), (int)fontData->Size()));
+		delete fontData;
 
 		QStringList fontsFound = QFontDatabase::applicationFontFamilies(fontID);
 		if (fontsFound.size() >= 1) {
@@ -929,6 +932,7 @@ bool NativeInitGraphics(GraphicsContext *graphicsContext) {
 	}
 
 	INFO_LOG(SYSTEM, "NativeInitGraphics completed");
+	PSP_TraceStartup("Graphics initialized");
 	return true;
 }
 
@@ -1046,12 +1050,14 @@ void TakeScreenshot() {
 		i++;
 	}
 
-	bool success = TakeGameScreenshot(filename, g_Config.bScreenshotsAsPNG ? ScreenshotFormat::PNG : ScreenshotFormat::JPG, SCREENSHOT_OUTPUT);
-	if (success) {
-		osm.Show(filename.ToVisualString());
-	} else {
-		auto err = GetI18NCategory("Error");
-		osm.Show(err->T("Could not save screenshot file"));
+	auto err = GetI18NCategory("Error");
+	std::string failureMessage = err->T("Could not save screenshot file");
+	// Encoding can take a while at high resolutions, no need to hold up the frame for it.
+	bool success = TakeGameScreenshotAsync(filename, g_Config.bScreenshotsAsPNG ? ScreenshotFormat::PNG : ScreenshotFormat::JPG, SCREENSHOT_OUTPUT, -1, [=](bool written) {
+		osm.Show(written ? filename.ToVisualString() : failureMessage);
+	});
+	if (!success) {
+		osm.Show(failureMessage);
 	}
 }
 
@@ -1476,6 +1482,7 @@ void NativeShutdown() {
 	}
 
 	ShutdownWebServer();
+	SampleProfiler::Stop();
 
 	System_SendMessage("finish", "");
 
@@ -16,7 +16,12 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
+
 
 #include "Common/Render/DrawBuffer.h"
 #include "Common/UI/View.h"
@@ -26,6 +31,8 @@
 #include "Common/GPU/thin3d.h"
 
 #include "Common/Data/Text/I18n.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/StringUtils.h"
 #include "Common/System/System.h"
 
@@ -48,6 +55,67 @@
 #include "UI/OnScreenDisplay.h"
 #include "UI/GameInfoCache.h"
 
+// Decoded images, shared between views so that reopening the pause screen doesn't decode every slot again.
+struct ImageThumbnail {
+	std::atomic<bool> done{};
+	bool success = false;
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> pixels;
+	uint64_t mtime = 0;
+	uint64_t size = 0;
+};
+
+class ImageThumbnailTask : public Task {
+public:
+	ImageThumbnailTask(const Path &filename, std::shared_ptr<ImageThumbnail> thumbnail) : filename_(filename), thumbnail_(thumbnail) {}
+
+	TaskType Type() const override {
+		return TaskType::IO_BLOCKING;
+	}
+
+	void Run() override {
+		thumbnail_->success = DecodeImageFile(filename_, &thumbnail_->width, &thumbnail_->height, &thumbnail_->pixels);
+		thumbnail_->done = true;
+	}
+
+private:
+	Path filename_;
+	std::shared_ptr<ImageThumbnail> thumbnail_;
+};
+
+static std::mutex thumbnailLock;
+static std::map<Path, std::shared_ptr<ImageThumbnail>> thumbnails;
+static const size_t MAX_THUMBNAILS = 32;
+
+static std::shared_ptr<ImageThumbnail> GetImageThumbnail(const Path &filename) {
+	File::FileInfo info;
+	if (!File::GetFileInfo(filename, &info) || info.isDirectory)
+		return nullptr;
+
+	std::lock_guard<std::mutex> guard(thumbnailLock);
+	auto iter = thumbnails.find(filename);
+	if (iter != thumbnails.end() && iter->second->mtime == info.mtime && iter->second->size == info.size)
+		return iter->second;
+
+	if (thumbnails.size() >= MAX_THUMBNAILS) {
+		// Drop whatever no view is waiting on.
+		for (auto it = thumbnails.begin(); it != thumbnails.end(); ) {
+			if (it->second.use_count() == 1 && it->second->done)
+				it = thumbnails.erase(it);
+			else
+				++it;
+		}
+	}
+
+	std::shared_ptr<ImageThumbnail> thumbnail = std::make_shared<ImageThumbnail>();
+	thumbnail->mtime = info.mtime;
+	thumbnail->size = info.size;
+	thumbnails[filename] = thumbnail;
+	g_threadManager.EnqueueTask(new ImageThumbnailTask(filename, thumbnail));
+	return thumbnail;
+}
+
 AsyncImageFileView::AsyncImageFileView(const Path &filename, UI::ImageSizeMode sizeMode, UI::LayoutParams *layoutParams)
 	: UI::Clickable(layoutParams), canFocus_(true), filename_(filename), color_(0xFFFFFFFF), sizeMode_(sizeMode), textureFailed_(false), fixedSizeW_(0.0f), fixedSizeH_(0.0f) {}
 
@@ -107,6 +175,7 @@ void AsyncImageFileView::SetFilename(const Path &filename) {
 		textureFailed_ = false;
 		filename_ = filename;
 		texture_.reset(nullptr);
+		thumbnail_.reset();
 	}
 }
 
@@ -123,9 +192,20 @@ void AsyncImageFileView::DeviceRestored(Draw::DrawContext *draw) {
 void AsyncImageFileView::Draw(UIContext &dc) {
 	using namespace Draw;
 	if (!texture_ && !textureFailed_ && !filename_.empty()) {
-		texture_ = CreateTextureFromFile(dc.GetDrawContext(), filename_.c_str(), DETECT, true);
-		if (!texture_.get())
-			textureFailed_ = true;
+		if (!thumbnail_) {
+			thumbnail_ = GetImageThumbnail(filename_);
+			if (!thumbnail_)
+				textureFailed_ = true;
+		}
+		if (thumbnail_ && thumbnail_->done) {
+			if (thumbnail_->success) {
+				texture_.reset(new ManagedTexture(dc.GetDrawContext()));
+				if (!texture_->LoadFromPixels(thumbnail_->pixels.data(), thumbnail_->width, thumbnail_->height, true, filename_.ToString()))
+					texture_.reset(nullptr);
+			}
+			textureFailed_ = !texture_;
+			thumbnail_.reset();
+		}
 	}
 
 	if (HasFocus()) {
@@ -61,8 +61,10 @@ class GamePauseScreen : public UIDialogScreenWithGameBackground {
 	Path gamePath_;
 };
 
+struct ImageThumbnail;
+
 // AsyncImageFileView loads a texture from a file, and reloads it as necessary.
-// TODO: Actually make async, doh.
+// Files are decoded on a background thread, and kept around decoded for a while.
 class AsyncImageFileView : public UI::Clickable {
 public:
 	AsyncImageFileView(const Path &filename, UI::ImageSizeMode sizeMode, UI::LayoutParams *layoutParams = 0);
@@ -93,6 +95,7 @@ class AsyncImageFileView : public UI::Clickable {
 	UI::ImageSizeMode sizeMode_;
 
 	std::unique_ptr<ManagedTexture> texture_;
+	std::shared_ptr<ImageThumbnail> thumbnail_;
 	bool textureFailed_;
 	float fixedSizeW_;
 	float fixedSizeH_;
@@ -22,6 +22,7 @@
 #include "Common/UI/Context.h"
 #include "Common/UI/View.h"
 #include "Common/Profiler/Profiler.h"
+#include "Core/HLE/HLE.h"
 
 #ifdef USE_PROFILER
 static const uint32_t nice_colors[] = {
@@ -47,6 +48,28 @@ static const uint32_t nice_colors[] = {
 };
 #endif
 
+#ifdef USE_PROFILER
+// Only has data while debug stats are collected, otherwise syscalls aren't timed.
+static void DrawHLEFunctionStats(UIContext &ui) {
+	std::vector<HLEFunctionStats> stats = hleGetFunctionStats();
+	if (stats.empty())
+		return;
+
+	const size_t maxRows = 10;
+	const float rowH = 24.0f;
+	float x = ui.GetBounds().x + 10.0f;
+	float y = ui.GetBounds().y + 10.0f;
+	ui.DrawTextShadow("HLE host time (total ms, calls, avg us)", x, y, 0xFFFFFFFF);
+	for (size_t i = 0; i < stats.size() && i < maxRows; ++i) {
+		const HLEFunctionStats &s = stats[i];
+		char line[256];
+		snprintf(line, sizeof(line), "%s::%s  %0.2f  %" PRIu64 "  %0.1f", s.module, s.name, s.seconds * 1000.0, s.calls, s.seconds * 1000000.0 / (double)s.calls);
+		y += rowH;
+		ui.DrawTextShadow(line, x, y, 0xFFC0C0C0);
+	}
+}
+#endif
+
 enum ProfileCatStatus {
 	PROFILE_CAT_VISIBLE = 0,
 	PROFILE_CAT_IGNORE = 1,
@@ -201,5 +224,7 @@ void DrawProfile(UIContext &ui) {
 	}
 
 	lastMaxVal = lastMaxVal * 0.95f + maxVal * 0.05f;
+
+	DrawHLEFunctionStats(ui);
 #endif
 }
@@ -146,23 +146,75 @@ bool ManagedTexture::LoadFromFileData(const uint8_t *data, size_t dataSize, Imag
 	return texture_ != nullptr;
 }
 
+bool ManagedTexture::LoadFromPixels(const uint8_t *pixels, int width, int height, bool generateMips, const std::string &filename) {
+	using namespace Draw;
+	generateMips_ = generateMips;
+	filename_ = filename;
+
+	if (texture_) {
+		texture_->Release();
+		texture_ = nullptr;
+	}
+	if (width <= 0 || height <= 0)
+		return false;
+
+	int potentialLevels = std::min(log2i(width), log2i(height));
+	TextureDesc desc{};
+	desc.type = TextureType::LINEAR2D;
+	desc.format = DataFormat::R8G8B8A8_UNORM;
+	desc.width = width;
+	desc.height = height;
+	desc.depth = 1;
+	desc.mipLevels = generateMips ? potentialLevels : 1;
+	desc.generateMips = generateMips && potentialLevels > 1;
+	desc.tag = filename_.c_str();
+	desc.initData.push_back(pixels);
+	texture_ = draw_->CreateTexture(desc);
+	return texture_ != nullptr;
+}
+
+bool DecodeImageFile(const Path &filename, int *width, int *height, std::vector<uint8_t> *pixels) {
+	VFSFileView *file = VFSOpenFile(filename.c_str());
+	if (!file)
+		return false;
+
+	int levelWidth[16]{}, levelHeight[16]{};
+	uint8_t *image[16]{};
+	int num_levels = 0;
+	int zim_flags = 0;
+	Draw::DataFormat fmt;
+	bool success = LoadTextureLevels(file->Data(), file->Size(), DETECT, levelWidth, levelHeight, &num_levels, &fmt, image, &zim_flags);
+	delete file;
+
+	success = success && image[0] && levelWidth[0] > 0 && levelHeight[0] > 0;
+	if (success) {
+		*width = levelWidth[0];
+		*height = levelHeight[0];
+		pixels->assign(image[0], image[0] + levelWidth[0] * levelHeight[0] * 4);
+	}
+	for (int i = 0; i < 16; i++) {
+		if (image[i])
+			free(image[i]);
+	}
+	return success;
+}
+
 bool ManagedTexture::LoadFromFile(const std::string &filename, ImageFileType type, bool generateMips) {
 	generateMips_ = generateMips;
-	size_t fileSize;
-	uint8_t *buffer = VFSReadFile(filename.c_str(), &fileSize);
-	if (!buffer) {
+	VFSFileView *file = VFSOpenFile(filename.c_str());
+	if (!file) {
 		filename_ = "";
 		ERROR_LOG(IO, "Failed to read file '%s'", filename.c_str());
 		return false;
 	}
-	bool retval = LoadFromFileData(buffer, fileSize, type, generateMips, filename.c_str());
+	bool retval = LoadFromFileData(file->Data(), file->Size(), type, generateMips, filename.c_str());
 	if (retval) {
 		filename_ = filename;
 	} else {
 		filename_ = "";
 		ERROR_LOG(IO, "Failed to load texture '%s'", filename.c_str());
 	}
-	delete[] buffer;
+	delete file;
 	return retval;
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "Common/GPU/thin3d.h"
 #include "Common/UI/View.h"
@@ -25,6 +26,8 @@ class ManagedTexture {
 
 	bool LoadFromFile(const std::string &filename, ImageFileType type = ImageFileType::DETECT, bool generateMips = false);
 	bool LoadFromFileData(const uint8_t *data, size_t dataSize, ImageFileType type, bool generateMips, const char *name);
+	// Uploads already decoded RGBA8888 pixels. filename is used to reload after a device loss.
+	bool LoadFromPixels(const uint8_t *pixels, int width, int height, bool generateMips, const std::string &filename);
 	Draw::Texture *GetTexture();  // For immediate use, don't store.
 	int Width() const { return texture_->Width(); }
 	int Height() const { return texture_->Height(); }
@@ -40,6 +43,9 @@ class ManagedTexture {
 	bool loadPending_ = false;
 };
 
+// Decodes the first level of an image file to RGBA8888, without touching the GPU. Safe on any thread.
+bool DecodeImageFile(const Path &filename, int *width, int *height, std::vector<uint8_t> *pixels);
+
 std::unique_ptr<ManagedTexture> CreateTextureFromFile(Draw::DrawContext *draw, const char *filename, ImageFileType fileType, bool generateMips);
 std::unique_ptr<ManagedTexture> CreateTextureFromFileData(Draw::DrawContext *draw, const uint8_t *data, int size, ImageFileType fileType, bool generateMips, const char *name);
 
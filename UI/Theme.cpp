@@ -162,9 +162,8 @@ static UI::Style MakeStyle(uint32_t fg, uint32_t bg) {
 }
 
 static void LoadAtlasMetadata(Atlas &metadata, const char *filename, bool required) {
-	size_t atlas_data_size = 0;
-	const uint8_t *atlas_data = VFSReadFile(filename, &atlas_data_size);
-	bool load_success = atlas_data != nullptr && metadata.Load(atlas_data, atlas_data_size);
+	VFSFileView *atlas_data = VFSOpenFile(filename);
+	bool load_success = atlas_data != nullptr && metadata.Load(atlas_data->Data(), atlas_data->Size());
 	if (!load_success) {
 		if (required)
 			ERROR_LOG(G3D, "Failed to load %s - graphics will be broken", filename);
@@ -172,7 +171,7 @@ static void LoadAtlasMetadata(Atlas &metadata, const char *filename, bool requir
 			WARN_LOG(G3D, "Failed to load %s", filename);
 		// Stumble along with broken visuals instead of dying...
 	}
-	delete[] atlas_data;
+	delete atlas_data;
 }
 
 void UpdateTheme(UIContext *ctx) {
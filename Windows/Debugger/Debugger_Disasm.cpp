@@ -173,6 +173,10 @@ CDisasm::CDisasm(HINSTANCE _hInstance, HWND _hParent, DebugInterface *_cpu) : Di
 	moduleList->loadModules();
 	bottomTabs->AddTab(moduleList->GetHandle(),L"Modules");
 
+	profileList = new CtrlProfileList(GetDlgItem(m_hDlg,IDC_PROFILELIST));
+	profileList->loadProfile();
+	bottomTabs->AddTab(profileList->GetHandle(),L"Profile");
+
 	bottomTabs->SetShowTabTitles(g_Config.bShowBottomTabTitles);
 	bottomTabs->ShowTab(memHandle);
 	
@@ -194,6 +198,7 @@ CDisasm::~CDisasm()
 	delete threadList;
 	delete stackTraceView;
 	delete moduleList;
+	delete profileList;
 }
 
 void CDisasm::stepInto()
@@ -373,6 +378,9 @@ BOOL CDisasm::DlgProc(UINT message, WPARAM wParam, LPARAM lParam)
 		case IDC_MODULELIST:
 			SetWindowLongPtr(m_hDlg, DWLP_MSGRESULT, moduleList->HandleNotify(lParam));
 			return TRUE;
+		case IDC_PROFILELIST:
+			SetWindowLongPtr(m_hDlg, DWLP_MSGRESULT, profileList->HandleNotify(lParam));
+			return TRUE;
 		case IDC_DEBUG_BOTTOMTABS:
 			bottomTabs->HandleNotify(lParam);
 			break;
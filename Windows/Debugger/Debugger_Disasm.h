@@ -27,6 +27,7 @@ class CDisasm : public Dialog
 	CtrlThreadList* threadList;
 	CtrlStackTraceView* stackTraceView;
 	CtrlModuleList* moduleList;
+	CtrlProfileList* profileList;
 	TabControl* leftTabs;
 	TabControl* bottomTabs;
 	std::vector<BreakPoint> displayedBreakPoints_;
@@ -16,6 +16,7 @@ enum { TL_NAME, TL_PROGRAMCOUNTER, TL_ENTRYPOINT, TL_PRIORITY, TL_STATE, TL_WAIT
 enum { BPL_ENABLED, BPL_TYPE, BPL_OFFSET, BPL_SIZELABEL, BPL_OPCODE, BPL_CONDITION, BPL_HITS, BPL_COLUMNCOUNT };
 enum { SF_ENTRY, SF_ENTRYNAME, SF_CURPC, SF_CUROPCODE, SF_CURSP, SF_FRAMESIZE, SF_COLUMNCOUNT };
 enum { ML_NAME, ML_ADDRESS, ML_SIZE, ML_ACTIVE, ML_COLUMNCOUNT };
+enum { PL_NAME, PL_ADDRESS, PL_SAMPLES, PL_PERCENT, PL_COLUMNCOUNT };
 
 GenericListViewColumn threadColumns[TL_COLUMNCOUNT] = {
 	{ L"Name",			0.20f },
@@ -68,6 +69,17 @@ GenericListViewDef moduleListDef = {
 	moduleListColumns,	ARRAY_SIZE(moduleListColumns),	NULL,	false
 };
 
+GenericListViewColumn profileListColumns[PL_COLUMNCOUNT] = {
+	{ L"Function",		0.40f },
+	{ L"Address",		0.20f },
+	{ L"Samples",		0.20f },
+	{ L"%",				0.20f },
+};
+
+GenericListViewDef profileListDef = {
+	profileListColumns,	ARRAY_SIZE(profileListColumns),	NULL,	false
+};
+
 //
 // CtrlThreadList
 //
@@ -796,3 +808,148 @@ void CtrlModuleList::loadModules()
 	}
 	Update();
 }
+
+//
+// CtrlProfileList
+//
+
+enum {
+	PROFILE_TIMER = 1,
+	PROFILE_TIMER_INTERVAL_MS = 1000,
+};
+
+enum {
+	ID_PROFILE_START = 1,
+	ID_PROFILE_STOP,
+	ID_PROFILE_RESET,
+	ID_PROFILE_SAVE,
+};
+
+CtrlProfileList::CtrlProfileList(HWND hwnd)
+	: GenericListControl(hwnd,profileListDef)
+{
+	SetTimer(GetHandle(),PROFILE_TIMER,PROFILE_TIMER_INTERVAL_MS,nullptr);
+	Update();
+}
+
+CtrlProfileList::~CtrlProfileList()
+{
+	KillTimer(GetHandle(),PROFILE_TIMER);
+}
+
+bool CtrlProfileList::WindowMessage(UINT msg, WPARAM wParam, LPARAM lParam, LRESULT& returnValue)
+{
+	switch(msg)
+	{
+	case WM_TIMER:
+		if (wParam == PROFILE_TIMER)
+		{
+			// Only refresh while collecting, so the list doesn't jump around while being read.
+			if (SampleProfiler::IsRunning() && IsWindowVisible(GetHandle()))
+				loadProfile();
+			returnValue = 0;
+			return true;
+		}
+		break;
+	case WM_KEYDOWN:
+		if (wParam == VK_TAB)
+		{
+			returnValue = 0;
+			SendMessage(GetParent(GetHandle()),WM_DEB_TABPRESSED,0,0);
+			return true;
+		}
+		break;
+	case WM_GETDLGCODE:
+		if (lParam && ((MSG*)lParam)->message == WM_KEYDOWN)
+		{
+			if (wParam == VK_TAB || wParam == VK_RETURN)
+			{
+				returnValue = DLGC_WANTMESSAGE;
+				return true;
+			}
+		}
+		break;
+	}
+
+	return false;
+}
+
+void CtrlProfileList::GetColumnText(wchar_t* dest, int row, int col)
+{
+	if (row < 0 || row >= (int)functions.size()) {
+		return;
+	}
+
+	const SampleProfiler::FunctionSamples &func = functions[row];
+	switch (col)
+	{
+	case PL_NAME:
+		wcscpy(dest,ConvertUTF8ToWString(func.name).c_str());
+		break;
+	case PL_ADDRESS:
+		if (func.address == SymbolMap::INVALID_ADDRESS)
+			wcscpy(dest,L"-");
+		else
+			wsprintf(dest,L"%08X",func.address);
+		break;
+	case PL_SAMPLES:
+		swprintf(dest,64,L"%llu",(unsigned long long)func.samples);
+		break;
+	case PL_PERCENT:
+		swprintf(dest,64,L"%.2f",totalSamples == 0 ? 0.0 : (double)func.samples * 100.0 / (double)totalSamples);
+		break;
+	}
+}
+
+void CtrlProfileList::OnDoubleClick(int itemIndex, int column)
+{
+	if (itemIndex < 0 || itemIndex >= (int)functions.size() || functions[itemIndex].address == SymbolMap::INVALID_ADDRESS)
+		return;
+	SendMessage(GetParent(GetHandle()),WM_DEB_GOTOWPARAM,functions[itemIndex].address,0);
+}
+
+void CtrlProfileList::OnRightClick(int itemIndex, int column, const POINT& point)
+{
+	bool running = SampleProfiler::IsRunning();
+	HMENU menu = CreatePopupMenu();
+	AppendMenu(menu,MF_STRING | (running ? MF_GRAYED : 0),ID_PROFILE_START,L"Start profiling");
+	AppendMenu(menu,MF_STRING | (running ? 0 : MF_GRAYED),ID_PROFILE_STOP,L"Stop profiling");
+	AppendMenu(menu,MF_STRING,ID_PROFILE_RESET,L"Reset");
+	AppendMenu(menu,MF_SEPARATOR,0,nullptr);
+	AppendMenu(menu,MF_STRING,ID_PROFILE_SAVE,L"Save profile...");
+
+	POINT pos = point;
+	ClientToScreen(GetHandle(),&pos);
+	int result = TrackPopupMenuEx(menu,TPM_RIGHTBUTTON | TPM_RETURNCMD,pos.x,pos.y,GetHandle(),0);
+	DestroyMenu(menu);
+
+	switch (result)
+	{
+	case ID_PROFILE_START:
+		SampleProfiler::Start();
+		break;
+	case ID_PROFILE_STOP:
+		SampleProfiler::Stop();
+		break;
+	case ID_PROFILE_RESET:
+		SampleProfiler::Reset();
+		break;
+	case ID_PROFILE_SAVE:
+		{
+			Path filename = SampleProfiler::DefaultProfilePath();
+			if (!SampleProfiler::SaveProfile(filename))
+				MessageBox(GetHandle(),L"Could not save the profile.",L"Error",MB_OK);
+			else
+				MessageBox(GetHandle(),ConvertUTF8ToWString("Saved to " + filename.ToVisualString()).c_str(),L"Profile",MB_OK);
+		}
+		break;
+	}
+	loadProfile();
+}
+
+void CtrlProfileList::loadProfile()
+{
+	uint64_t hostWait = 0;
+	functions = SampleProfiler::GetFunctionProfile(&totalSamples,&hostWait);
+	Update();
+}
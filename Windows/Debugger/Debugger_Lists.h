@@ -5,6 +5,7 @@
 #include "../../Core/Debugger/Breakpoints.h"
 #include "../../Core/Debugger/SymbolMap.h"
 #include "../../Core/MIPS/MIPSStackWalk.h"
+#include "../../Core/Debugger/SampleProfiler.h"
 #include "Windows/W32Util/Misc.h"
 
 class CtrlThreadList: public GenericListControl
@@ -84,4 +85,21 @@ class CtrlModuleList: public GenericListControl
 private:
 	std::vector<LoadedModuleInfo> modules;
 	DebugInterface* cpu;
-};
\ No newline at end of file
+};
+
+class CtrlProfileList: public GenericListControl
+{
+public:
+	CtrlProfileList(HWND hwnd);
+	~CtrlProfileList();
+	void loadProfile();
+protected:
+	virtual bool WindowMessage(UINT msg, WPARAM wParam, LPARAM lParam, LRESULT& returnValue);
+	virtual void GetColumnText(wchar_t* dest, int row, int col);
+	virtual int GetRowCount() { return (int)functions.size(); };
+	virtual void OnDoubleClick(int itemIndex, int column);
+	virtual void OnRightClick(int itemIndex, int column, const POINT& point);
+private:
+	std::vector<SampleProfiler::FunctionSamples> functions;
+	uint64_t totalSamples = 0;
+};
@@ -8,6 +8,7 @@
 #include "Windows/main.h"
 #include "Core/Config.h"
 #include "GPU/Debugger/Breakpoints.h"
+#include "GPU/Debugger/DrawProfile.h"
 #include "GPU/GPUState.h"
 
 LPCTSTR CtrlDisplayListView::windowClass = _T("CtrlDisplayListView");
@@ -238,6 +239,21 @@ void CtrlDisplayListView::onPaint(WPARAM wParam, LPARAM lParam)
 		SelectObject(hdc,stall ? boldfont : font);
 		TextOutA(hdc,pixelPositions.opcodeStart,rowY1+2,opcode,(int)strlen(opcode));
 		SelectObject(hdc,font);
+
+		GPUDrawProfile::DrawCost cost;
+		if ((op.op >> 24) == GE_CMD_PRIM && GPUDrawProfile::GetDrawAt(op.pc, &cost))
+		{
+			SIZE opcodeSize;
+			GetTextExtentPoint32A(hdc,opcode,(int)strlen(opcode),&opcodeSize);
+
+			char costText[256];
+			snprintf(costText,sizeof(costText),"%.3f ms (decode %.3f, tex %.3f, state %.3f)",
+				cost.TotalTime() * 1000.0, cost.times[(int)GPUDrawProfile::Cost::DECODE] * 1000.0,
+				cost.times[(int)GPUDrawProfile::Cost::TEXTURE] * 1000.0, cost.StateTime() * 1000.0);
+			SetTextColor(hdc,address >= selectRangeStart && address < selectRangeEnd && hasFocus ? textColor : 0x808080);
+			TextOutA(hdc,pixelPositions.opcodeStart+opcodeSize.cx+rowHeight,rowY1+2,costText,(int)strlen(costText));
+			SetTextColor(hdc,textColor);
+		}
 	}
 
 	SelectObject(hdc,oldFont);
@@ -44,6 +44,7 @@
 #include "GPU/GPUState.h"
 #include "GPU/Debugger/Breakpoints.h"
 #include "GPU/Debugger/Debugger.h"
+#include "GPU/Debugger/DrawProfile.h"
 #include "GPU/Debugger/Record.h"
 #include "GPU/Debugger/Stepping.h"
 #include <windowsx.h>
@@ -887,6 +888,11 @@ BOOL CGEDebugger::DlgProc(UINT message, WPARAM wParam, LPARAM lParam) {
 			GPURecord::Activate();
 			break;
 
+		case IDC_GEDBG_PROFILEFRAME:
+			// Costs show up next to each PRIM in the display list once the frame is done.
+			GPUDrawProfile::Activate();
+			break;
+
 		case IDC_GEDBG_FLUSH:
 			if (GPUDebug::IsActive() && gpuDebug != nullptr) {
 				if (!autoFlush_)
@@ -2,9 +2,11 @@
 
 #include "Common/CommonWindows.h"
 #include <d3d11.h>
+#include <d3d10.h>
 #include <WinError.h>
 
 #include "Common/Log.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Common/System/Display.h"
 #include "Common/Data/Encoding/Utf8.h"
 #include "Common/Data/Text/I18n.h"
@@ -41,10 +43,63 @@ D3D11Context::~D3D11Context() {
 }
 
 void D3D11Context::SwapBuffers() {
-	swapChain_->Present(swapInterval_, 0);
+	if (threadedPresent_ && swapChainTex_) {
+		// Only one frame can be queued on the present thread, it's normally long done by now.
+		WaitForPresent();
+		context_->CopyResource(swapChainTex_, bbRenderTargetTex_);
+		{
+			std::lock_guard<std::mutex> guard(presentMutex_);
+			presentInterval_ = swapInterval_;
+			presentPending_ = true;
+		}
+		presentCond_.notify_one();
+	} else {
+		swapChain_->Present(swapInterval_, 0);
+	}
 	draw_->HandleEvent(Draw::Event::PRESENTED, 0, 0, nullptr, nullptr);
 }
 
+void D3D11Context::StartPresentThread() {
+	presentThreadRunning_ = true;
+	presentPending_ = false;
+	presentThread_ = std::thread(&D3D11Context::PresentThreadFunc, this);
+}
+
+void D3D11Context::StopPresentThread() {
+	if (!presentThread_.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> guard(presentMutex_);
+		presentThreadRunning_ = false;
+	}
+	presentCond_.notify_one();
+	presentThread_.join();
+}
+
+void D3D11Context::PresentThreadFunc() {
+	SetCurrentThreadName("D3D11Present");
+	std::unique_lock<std::mutex> guard(presentMutex_);
+	while (true) {
+		presentCond_.wait(guard, [&] { return presentPending_ || !presentThreadRunning_; });
+		if (!presentPending_)
+			break;
+		int interval = presentInterval_;
+		guard.unlock();
+		// The context is multithread protected, so this serializes against the emu thread.
+		swapChain_->Present(interval, 0);
+		guard.lock();
+		presentPending_ = false;
+		presentCond_.notify_all();
+	}
+}
+
+void D3D11Context::WaitForPresent() {
+	if (!presentThread_.joinable())
+		return;
+	std::unique_lock<std::mutex> guard(presentMutex_);
+	presentCond_.wait(guard, [&] { return !presentPending_; });
+}
+
 void D3D11Context::SwapInterval(int interval) {
 	swapInterval_ = interval;
 }
@@ -169,6 +224,18 @@ bool D3D11Context::Init(HINSTANCE hInst, HWND wnd, std::string *error_message) {
 		context1_ = nullptr;
 	}
 
+	if (g_Config.bD3D11ThreadedPresent) {
+		// Present will be called from another thread, so the immediate context needs to be locked.
+		ID3D10Multithread *multithread = nullptr;
+		if (SUCCEEDED(context_->QueryInterface(__uuidof(ID3D10Multithread), (void **)&multithread))) {
+			multithread->SetMultithreadProtected(TRUE);
+			multithread->Release();
+			threadedPresent_ = true;
+		} else {
+			WARN_LOG(G3D, "Multithread protection not available, presenting on the emu thread");
+		}
+	}
+
 #ifdef _DEBUG
 	if (SUCCEEDED(device_->QueryInterface(__uuidof(ID3D11Debug), (void**)&d3dDebug_))) {
 		if (SUCCEEDED(d3dDebug_->QueryInterface(__uuidof(ID3D11InfoQueue), (void**)&d3dInfoQueue_))) {
@@ -224,11 +291,18 @@ bool D3D11Context::Init(HINSTANCE hInst, HWND wnd, std::string *error_message) {
 	dxgiFactory->Release();
 
 	GotBackbuffer();
+	if (threadedPresent_)
+		StartPresentThread();
 	return true;
 }
 
 void D3D11Context::LostBackbuffer() {
+	WaitForPresent();
 	draw_->HandleEvent(Draw::Event::LOST_BACKBUFFER, width, height, nullptr);
+	if (swapChainTex_) {
+		swapChainTex_->Release();
+		swapChainTex_ = nullptr;
+	}
 	bbRenderTargetTex_->Release();
 	bbRenderTargetTex_ = nullptr;
 	bbRenderTargetView_->Release();
@@ -247,6 +321,20 @@ void D3D11Context::GotBackbuffer() {
 	width = bbDesc.Width;
 	height = bbDesc.Height;
 
+	if (threadedPresent_) {
+		// Render into a texture of our own, so the next frame can start while the present thread still holds the swapchain buffer.
+		D3D11_TEXTURE2D_DESC texDesc = bbDesc;
+		texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+		texDesc.MiscFlags = 0;
+		ID3D11Texture2D *tex = nullptr;
+		if (SUCCEEDED(device_->CreateTexture2D(&texDesc, nullptr, &tex))) {
+			swapChainTex_ = bbRenderTargetTex_;
+			bbRenderTargetTex_ = tex;
+		} else {
+			WARN_LOG(G3D, "Failed to create backbuffer texture for threaded present");
+		}
+	}
+
 	hr = device_->CreateRenderTargetView(bbRenderTargetTex_, nullptr, &bbRenderTargetView_);
 	if (FAILED(hr))
 		return;
@@ -264,6 +352,7 @@ void D3D11Context::Resize() {
 
 void D3D11Context::Shutdown() {
 	LostBackbuffer();
+	StopPresentThread();
 
 	delete draw_;
 	draw_ = nullptr;
@@ -19,6 +19,10 @@
 
 #include "ppsspp_config.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "Common/CommonWindows.h"
 #include "Windows/GPU/WindowsGraphicsContext.h"
 #include <d3d11.h>
@@ -45,6 +49,11 @@ class D3D11Context : public WindowsGraphicsContext {
 	void LostBackbuffer();
 	void GotBackbuffer();
 
+	void StartPresentThread();
+	void StopPresentThread();
+	void PresentThreadFunc();
+	void WaitForPresent();
+
 	Draw::DrawContext *draw_ = nullptr;
 	IDXGISwapChain *swapChain_ = nullptr;
 	ID3D11Device *device_ = nullptr;
@@ -68,4 +77,15 @@ class D3D11Context : public WindowsGraphicsContext {
 	int width;
 	int height;
 	int swapInterval_ = 0;
+
+	// With threaded present, we render into our own backbuffer texture, copy it into swapChainTex_
+	// on SwapBuffers and let presentThread_ call Present, so the emu thread doesn't wait on it.
+	bool threadedPresent_ = false;
+	ID3D11Texture2D *swapChainTex_ = nullptr;
+	std::thread presentThread_;
+	std::mutex presentMutex_;
+	std::condition_variable presentCond_;
+	bool presentPending_ = false;
+	bool presentThreadRunning_ = false;
+	int presentInterval_ = 0;
 };
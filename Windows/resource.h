@@ -326,6 +326,8 @@
 #define IDC_GEDBG_FLUSHAUTO              40213
 #define IDI_BREAKPOINT_SMALL             40214
 #define IDC_GEDBG_SETPRIMFILTER          40215
+#define IDC_PROFILELIST                  40216
+#define IDC_GEDBG_PROFILEFRAME           40217
 
 // Dummy option to let the buffered rendering hotkey cycle through all the options.
 #define ID_OPTIONS_BUFFEREDRENDERINGDUMMY 40500
@@ -338,7 +340,7 @@
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        256
-#define _APS_NEXT_COMMAND_VALUE         40216
+#define _APS_NEXT_COMMAND_VALUE         40218
 #define _APS_NEXT_CONTROL_VALUE         1202
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
@@ -319,6 +319,7 @@ static void EmuThreadFunc() {
 	gJvm->AttachCurrentThread(&env, nullptr);
 
 	SetCurrentThreadName("Emu");
+	SetCurrentThreadRole(ThreadRole::EMU);
 	INFO_LOG(SYSTEM, "Entering emu thread");
 
 	// Wait for render loop to get started.
@@ -1093,7 +1094,9 @@ void LockedNativeUpdateRender() {
 }
 
 void UpdateRunLoopAndroid(JNIEnv *env) {
+	double startTime = time_now_d();
 	LockedNativeUpdateRender();
+	ReportFrameWorkDuration(time_now_d() - startTime);
 
 	std::lock_guard<std::mutex> guard(frameCommandLock);
 	if (!nativeActivity) {
@@ -1110,6 +1113,7 @@ extern "C" void Java_org_ppsspp_ppsspp_NativeRenderer_displayRender(JNIEnv *env,
 	if (!hasSetThreadName) {
 		hasSetThreadName = true;
 		SetCurrentThreadName("AndroidRender");
+		SetCurrentThreadRole(ThreadRole::RENDER);
 	}
 
 	if (useCPUThread) {
@@ -1531,6 +1535,7 @@ extern "C" bool JNICALL Java_org_ppsspp_ppsspp_NativeActivity_runEGLRenderLoop(J
 		if (!hasSetThreadName) {
 			hasSetThreadName = true;
 			SetCurrentThreadName("AndroidRender");
+			SetCurrentThreadRole(ThreadRole::RENDER);
 		}
 	}
 
@@ -32,6 +32,20 @@
 
 #include "AES.h"
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KIRK_AESNI
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AESNI_TARGET
+#define AESNI_BSWAP32(x) _byteswap_ulong(x)
+#else
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+#define AESNI_BSWAP32(x) __builtin_bswap32(x)
+#endif
+#endif
+
 #undef FULL_UNROLL
 
 
@@ -1279,6 +1293,127 @@ rijndael_encrypt(rijndael_ctx *ctx, const u8 *src, u8 *dst)
 	rijndaelEncrypt(ctx->ek, ctx->Nr, src, dst);
 }
 
+#ifdef KIRK_AESNI
+/*
+ * AES-NI paths.  The key schedules are the usual big endian words, so they're
+ * byte swapped into round keys.  dk is already the "equivalent inverse cipher"
+ * schedule (reversed, with InvMixColumns applied), which is what AESDEC wants.
+ */
+static int aesni_supported = -1;
+
+static int aesni_available(void)
+{
+	if (aesni_supported < 0) {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		aesni_supported = (info[2] >> 25) & 1;
+#else
+		__builtin_cpu_init();
+		aesni_supported = __builtin_cpu_supports("aes") ? 1 : 0;
+#endif
+	}
+	return aesni_supported;
+}
+
+AESNI_TARGET static void aesni_load_keys(const u32 *rk, int Nr, __m128i *keys)
+{
+	int i;
+	for (i = 0; i <= Nr; i++, rk += 4)
+		keys[i] = _mm_set_epi32((int)AESNI_BSWAP32(rk[3]), (int)AESNI_BSWAP32(rk[2]), (int)AESNI_BSWAP32(rk[1]), (int)AESNI_BSWAP32(rk[0]));
+}
+
+AESNI_TARGET static __m128i aesni_encrypt_block(const __m128i *keys, int Nr, __m128i block)
+{
+	int i;
+	block = _mm_xor_si128(block, keys[0]);
+	for (i = 1; i < Nr; i++)
+		block = _mm_aesenc_si128(block, keys[i]);
+	return _mm_aesenclast_si128(block, keys[Nr]);
+}
+
+AESNI_TARGET static __m128i aesni_decrypt_block(const __m128i *keys, int Nr, __m128i block)
+{
+	int i;
+	block = _mm_xor_si128(block, keys[0]);
+	for (i = 1; i < Nr; i++)
+		block = _mm_aesdec_si128(block, keys[i]);
+	return _mm_aesdeclast_si128(block, keys[Nr]);
+}
+
+AESNI_TARGET static void aesni_encrypt(const u32 *ek, int Nr, const u8 *src, u8 *dst)
+{
+	__m128i keys[AES_MAXROUNDS + 1];
+	aesni_load_keys(ek, Nr, keys);
+	_mm_storeu_si128((__m128i *)dst, aesni_encrypt_block(keys, Nr, _mm_loadu_si128((const __m128i *)src)));
+}
+
+AESNI_TARGET static void aesni_decrypt(const u32 *dk, int Nr, const u8 *src, u8 *dst)
+{
+	__m128i keys[AES_MAXROUNDS + 1];
+	aesni_load_keys(dk, Nr, keys);
+	_mm_storeu_si128((__m128i *)dst, aesni_decrypt_block(keys, Nr, _mm_loadu_si128((const __m128i *)src)));
+}
+
+AESNI_TARGET static void aesni_cbc_encrypt(const u32 *ek, int Nr, const u8 *src, u8 *dst, int blocks)
+{
+	__m128i keys[AES_MAXROUNDS + 1];
+	__m128i prev = _mm_setzero_si128();
+	int i;
+	aesni_load_keys(ek, Nr, keys);
+	for (i = 0; i < blocks; i++) {
+		prev = aesni_encrypt_block(keys, Nr, _mm_xor_si128(_mm_loadu_si128((const __m128i *)src), prev));
+		_mm_storeu_si128((__m128i *)dst, prev);
+		src += 16;
+		dst += 16;
+	}
+}
+
+AESNI_TARGET static void aesni_cbc_decrypt(const u32 *dk, int Nr, const u8 *src, u8 *dst, int blocks)
+{
+	__m128i keys[AES_MAXROUNDS + 1];
+	__m128i prev = _mm_setzero_si128();
+	int i, r;
+	aesni_load_keys(dk, Nr, keys);
+
+	/* Unlike encryption, blocks are independent, so keep four in flight. */
+	for (i = 0; i + 4 <= blocks; i += 4) {
+		__m128i c0 = _mm_loadu_si128((const __m128i *)src + 0);
+		__m128i c1 = _mm_loadu_si128((const __m128i *)src + 1);
+		__m128i c2 = _mm_loadu_si128((const __m128i *)src + 2);
+		__m128i c3 = _mm_loadu_si128((const __m128i *)src + 3);
+		__m128i b0 = _mm_xor_si128(c0, keys[0]);
+		__m128i b1 = _mm_xor_si128(c1, keys[0]);
+		__m128i b2 = _mm_xor_si128(c2, keys[0]);
+		__m128i b3 = _mm_xor_si128(c3, keys[0]);
+		for (r = 1; r < Nr; r++) {
+			b0 = _mm_aesdec_si128(b0, keys[r]);
+			b1 = _mm_aesdec_si128(b1, keys[r]);
+			b2 = _mm_aesdec_si128(b2, keys[r]);
+			b3 = _mm_aesdec_si128(b3, keys[r]);
+		}
+		b0 = _mm_aesdeclast_si128(b0, keys[Nr]);
+		b1 = _mm_aesdeclast_si128(b1, keys[Nr]);
+		b2 = _mm_aesdeclast_si128(b2, keys[Nr]);
+		b3 = _mm_aesdeclast_si128(b3, keys[Nr]);
+		_mm_storeu_si128((__m128i *)dst + 0, _mm_xor_si128(b0, prev));
+		_mm_storeu_si128((__m128i *)dst + 1, _mm_xor_si128(b1, c0));
+		_mm_storeu_si128((__m128i *)dst + 2, _mm_xor_si128(b2, c1));
+		_mm_storeu_si128((__m128i *)dst + 3, _mm_xor_si128(b3, c2));
+		prev = c3;
+		src += 64;
+		dst += 64;
+	}
+	for (; i < blocks; i++) {
+		__m128i c = _mm_loadu_si128((const __m128i *)src);
+		_mm_storeu_si128((__m128i *)dst, _mm_xor_si128(aesni_decrypt_block(keys, Nr, c), prev));
+		prev = c;
+		src += 16;
+		dst += 16;
+	}
+}
+#endif
+
 int AES_set_key(AES_ctx *ctx, const u8 *key, int bits)
 {
 	return rijndael_set_key((rijndael_ctx *)ctx, key, bits);
@@ -1286,11 +1421,23 @@ int AES_set_key(AES_ctx *ctx, const u8 *key, int bits)
 
 void AES_decrypt(AES_ctx *ctx, const u8 *src, u8 *dst)
 {
+#ifdef KIRK_AESNI
+	if (aesni_available()) {
+		aesni_decrypt(ctx->dk, ctx->Nr, src, dst);
+		return;
+	}
+#endif
 	rijndaelDecrypt(ctx->dk, ctx->Nr, src, dst);
 }
 
 void AES_encrypt(AES_ctx *ctx, const u8 *src, u8 *dst)
 {
+#ifdef KIRK_AESNI
+	if (aesni_available()) {
+		aesni_encrypt(ctx->ek, ctx->Nr, src, dst);
+		return;
+	}
+#endif
 	rijndaelEncrypt(ctx->ek, ctx->Nr, src, dst);
 }
 
@@ -1309,6 +1456,12 @@ void AES_cbc_encrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size)
 	u8 block_buff[16];
 	
 	int i;
+#ifdef KIRK_AESNI
+	if (aesni_available()) {
+		aesni_cbc_encrypt(ctx->ek, ctx->Nr, src, dst, size > 0 ? (size + 15) / 16 : 0);
+		return;
+	}
+#endif
 	for(i = 0; i < size; i+=16)
 	{
 		//step 1: copy block to dst
@@ -1330,6 +1483,14 @@ void AES_cbc_decrypt(AES_ctx *ctx, const u8 *src, u8 *dst, int size)
 	u8 block_buff[16];
 	u8 block_buff_previous[16];
 	int i;
+
+#ifdef KIRK_AESNI
+	if (aesni_available()) {
+		/* Like below, the first block is always decrypted. */
+		aesni_cbc_decrypt(ctx->dk, ctx->Nr, src, dst, size > 16 ? (size + 15) / 16 : 1);
+		return;
+	}
+#endif
 	
 	memcpy(block_buff, src, 16);
 	memcpy(block_buff_previous, src, 16);
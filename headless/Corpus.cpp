@@ -0,0 +1,164 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+#include "Common/Data/Format/JSONReader.h"
+#include "Common/Data/Format/JSONWriter.h"
+#include "Common/File/FileUtil.h"
+#include "Common/StringUtils.h"
+#include "headless/Corpus.h"
+
+bool LoadCorpusManifest(const Path &filename, std::vector<CorpusEntry> *entries, std::string *error) {
+	std::string data;
+	if (!File::ReadFileToString(true, filename, data)) {
+		*error = "Could not read " + filename.ToVisualString();
+		return false;
+	}
+
+	std::vector<std::string> lines;
+	SplitString(data, '\n', lines);
+	for (size_t i = 0; i < lines.size(); ++i) {
+		std::string line = StripSpaces(lines[i]);
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::vector<std::string> fields;
+		SplitString(line, '\t', fields);
+		if (fields.size() != 5) {
+			*error = StringFromFormat("Line %d: expected 5 tab separated fields, got %d", (int)i + 1, (int)fields.size());
+			return false;
+		}
+
+		CorpusEntry entry;
+		entry.name = fields[0];
+		entry.game = Path(fields[1]);
+		entry.state = Path(fields[2]);
+		if (fields[3] != "-")
+			entry.replay = Path(fields[3]);
+		entry.frames = atoi(fields[4].c_str());
+		if (entry.frames <= 0) {
+			*error = StringFromFormat("Line %d: invalid frame count", (int)i + 1);
+			return false;
+		}
+		entries->push_back(entry);
+	}
+
+	if (entries->empty()) {
+		*error = "No entries in " + filename.ToVisualString();
+		return false;
+	}
+	return true;
+}
+
+bool SaveCorpusResults(const Path &filename, const std::vector<CorpusResult> &results) {
+	json::JsonWriter writer(json::JsonWriter::PRETTY);
+	writer.begin();
+	writer.pushArray("results");
+	for (const CorpusResult &result : results) {
+		writer.pushDict();
+		writer.writeString("name", result.name);
+		writer.writeBool("ran", result.ran);
+		writer.writeInt("frames", result.frames);
+		writer.writeFloat("hostSeconds", result.hostSeconds);
+		writer.writeFloat("frameMsMean", result.frameMsMean);
+		writer.writeFloat("frameMsP90", result.frameMsP90);
+		writer.writeFloat("jitCompileMs", result.jitCompileMs);
+		// JSON numbers can't hold all 64 bits.
+		writer.writeString("framebufferHash", StringFromFormat("%016llx", (unsigned long long)result.framebufferHash));
+		writer.pop();
+	}
+	writer.pop();
+	writer.end();
+
+	return File::WriteStringToFile(true, writer.str(), filename);
+}
+
+bool LoadCorpusResults(const Path &filename, std::vector<CorpusResult> *results) {
+	using namespace json;
+	JsonReader reader(filename.ToString());
+	if (!reader.ok() || !reader.root())
+		return false;
+
+	const JsonNode *list = reader.root().getArray("results");
+	if (!list)
+		return false;
+	for (const JsonNode *node : list->value) {
+		JsonGet item = node->value;
+		CorpusResult result;
+		result.name = item.getString("name", "");
+		result.ran = item.getBool("ran", false);
+		result.frames = item.getInt("frames", 0);
+		result.hostSeconds = item.getFloat("hostSeconds", 0.0);
+		result.frameMsMean = item.getFloat("frameMsMean", 0.0);
+		result.frameMsP90 = item.getFloat("frameMsP90", 0.0);
+		result.jitCompileMs = item.getFloat("jitCompileMs", 0.0);
+		result.framebufferHash = strtoull(item.getString("framebufferHash", "0"), nullptr, 16);
+		results->push_back(result);
+	}
+	return true;
+}
+
+int CompareCorpusResults(const std::vector<CorpusResult> &baseline, const std::vector<CorpusResult> &results, double tolerance) {
+	std::map<std::string, const CorpusResult *> byName;
+	for (const CorpusResult &result : baseline)
+		byName[result.name] = &result;
+
+	int regressions = 0;
+	for (const CorpusResult &result : results) {
+		auto it = byName.find(result.name);
+		if (it == byName.end()) {
+			printf("%s: not in baseline\n", result.name.c_str());
+			continue;
+		}
+
+		const CorpusResult &base = *it->second;
+		if (!result.ran) {
+			// Only count it if it used to work.
+			printf("%s: failed to run\n", result.name.c_str());
+			if (base.ran)
+				regressions++;
+			continue;
+		}
+		if (!base.ran) {
+			printf("%s: runs now, no baseline to compare\n", result.name.c_str());
+			continue;
+		}
+
+		bool regressed = false;
+		if (result.framebufferHash != base.framebufferHash) {
+			printf("%s: framebuffer changed (%016llx, was %016llx)\n", result.name.c_str(), (unsigned long long)result.framebufferHash, (unsigned long long)base.framebufferHash);
+			regressed = true;
+		}
+
+		double change = base.frameMsMean > 0.0 ? result.frameMsMean / base.frameMsMean - 1.0 : 0.0;
+		if (change > tolerance) {
+			printf("%s: %0.1f%% slower (%0.3f ms per frame, was %0.3f ms)\n", result.name.c_str(), change * 100.0, result.frameMsMean, base.frameMsMean);
+			regressed = true;
+		} else {
+			printf("%s: %+0.1f%% frame time\n", result.name.c_str(), change * 100.0);
+		}
+
+		if (regressed)
+			regressions++;
+	}
+
+	return regressions;
+}
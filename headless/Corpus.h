@@ -0,0 +1,57 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/File/Path.h"
+
+// A reproducible game segment: load a savestate, then play back recorded input for some frames.
+struct CorpusEntry {
+	std::string name;
+	Path game;
+	Path state;
+	// Optional, empty to run without input.
+	Path replay;
+	int frames = 0;
+};
+
+// One line per entry with tab separated fields: name, game, state, replay (or -), frames.
+// Blank lines and lines starting with # are skipped.
+bool LoadCorpusManifest(const Path &filename, std::vector<CorpusEntry> *entries, std::string *error);
+
+struct CorpusResult {
+	// Entry name, CPU core, and GPU backend, like "name/jit/gles".
+	std::string name;
+	bool ran = false;
+	int frames = 0;
+	double hostSeconds = 0.0;
+	double frameMsMean = 0.0;
+	double frameMsP90 = 0.0;
+	double jitCompileMs = 0.0;
+	// Of the displayed framebuffer after the last frame.
+	u64 framebufferHash = 0;
+};
+
+bool SaveCorpusResults(const Path &filename, const std::vector<CorpusResult> &results);
+bool LoadCorpusResults(const Path &filename, std::vector<CorpusResult> *results);
+// Prints each difference, and returns how many results regressed: failed to run, changed output,
+// or got slower by more than tolerance (0.1 = 10%.)
+int CompareCorpusResults(const std::vector<CorpusResult> &baseline, const std::vector<CorpusResult> &results, double tolerance);
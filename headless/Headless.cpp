@@ -3,9 +3,13 @@
 // To build on non-windows systems, just run CMake in the SDL directory, it will build both a normal ppsspp and the headless version.
 
 #include "ppsspp_config.h"
+#include "ext/xxhash.h"
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
+#include <algorithm>
 #include <limits>
+#include <vector>
 #if PPSSPP_PLATFORM(ANDROID)
 #include <jni.h>
 #endif
@@ -17,14 +21,21 @@
 #include "Common/CommonWindows.h"
 #if PPSSPP_PLATFORM(WINDOWS)
 #include <timeapi.h>
+#include <psapi.h>
 #else
 #include <csignal>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #endif
 #include "Common/CPUDetect.h"
+#include "Common/Data/Format/JSONWriter.h"
 #include "Common/File/VFS/VFS.h"
 #include "Common/File/VFS/AssetReader.h"
 #include "Common/File/FileUtil.h"
 #include "Common/GraphicsContext.h"
+#include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Common/Thread/ThreadManager.h"
 #include "Core/Config.h"
@@ -35,12 +46,19 @@
 #include "Core/WebServer.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
+#include "Core/Replay.h"
 #include "Core/SaveState.h"
+#include "Core/HLE/sceCtrl.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "GPU/GPU.h"
+#include "GPU/GPUInterface.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/Common/GPUDebugInterface.h"
 #include "Log.h"
 #include "LogManager.h"
 
 #include "Compare.h"
+#include "Corpus.h"
 #include "StubHost.h"
 #if defined(_WIN32)
 #include "WindowsHeadlessHost.h"
@@ -136,8 +154,26 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -v, --verbose         show the full passed/failed result\n");
 	fprintf(stderr, "  -i                    use the interpreter\n");
 	fprintf(stderr, "  --ir                  use ir interpreter\n");
+	fprintf(stderr, "  --irjit               use ir with the native backend\n");
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
+#if !PPSSPP_PLATFORM(WINDOWS)
+	fprintf(stderr, "  --workers=N           split the tests across N processes run in parallel\n");
+#endif
+	fprintf(stderr, "  --rollback=FRAMES     confirm input FRAMES late and report rollback cost\n");
+	fprintf(stderr, "  --bench-savestate=FRAMES  run FRAMES frames, then time savestates and exit\n");
+	fprintf(stderr, "  --bench-iterations=N  savestate benchmark iterations (default 10)\n");
+	fprintf(stderr, "  --bench=FRAMES        run FRAMES frames unthrottled and report frame time stats as JSON\n");
+	fprintf(stderr, "                        for a .ppdmp, replays the dump FRAMES times\n");
+	fprintf(stderr, "  --bench-warmup=FRAMES frames to run before measuring (default 0)\n");
+	fprintf(stderr, "  --bench-output=FILE   write the JSON report to FILE instead of stdout\n");
+	fprintf(stderr, "  --bench-sound         mix audio while benchmarking\n");
+	fprintf(stderr, "  --corpus=MANIFEST     run each savestate + replay in MANIFEST and report timing and framebuffer hashes\n");
+	fprintf(stderr, "  --corpus-cpu=LIST     comma separated cores to run: interpreter, jit, ir, irjit (default: current)\n");
+	fprintf(stderr, "  --corpus-gpu=LIST     comma separated backends to run, as in --graphics= (default: current)\n");
+	fprintf(stderr, "  --corpus-output=FILE  write the results as JSON to FILE, e.g. to use as a baseline\n");
+	fprintf(stderr, "  --corpus-baseline=FILE  fail if results differ from or are slower than FILE\n");
+	fprintf(stderr, "  --corpus-tolerance=PERCENT  allowed frame time increase over the baseline (default 10)\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
@@ -157,7 +193,307 @@ static HeadlessHost *getHost(GPUCore gpuCore) {
 	}
 }
 
-bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout)
+static const struct {
+	const char *name;
+	GPUCore core;
+} gpuCoreNames[] = {
+	{ "gles", GPUCORE_GLES },
+	{ "software", GPUCORE_SOFTWARE },
+	// There used to be a separate "null" rendering core - just use software.
+	{ "null", GPUCORE_SOFTWARE },
+	{ "directx9", GPUCORE_DIRECTX9 },
+	{ "directx11", GPUCORE_DIRECTX11 },
+	{ "vulkan", GPUCORE_VULKAN },
+};
+
+static const struct {
+	const char *name;
+	CPUCore core;
+} cpuCoreNames[] = {
+	{ "interpreter", CPUCore::INTERPRETER },
+	{ "jit", CPUCore::JIT },
+	{ "ir", CPUCore::IR_JIT },
+	{ "irjit", CPUCore::JIT_IR },
+};
+
+static bool ParseGPUCore(const std::string &name, GPUCore *core) {
+	for (const auto &entry : gpuCoreNames) {
+		if (!strcasecmp(name.c_str(), entry.name)) {
+			*core = entry.core;
+			return true;
+		}
+	}
+	return false;
+}
+
+static const char *GPUCoreName(GPUCore core) {
+	for (const auto &entry : gpuCoreNames) {
+		if (entry.core == core)
+			return entry.name;
+	}
+	return "unknown";
+}
+
+static bool ParseCPUCore(const std::string &name, CPUCore *core) {
+	for (const auto &entry : cpuCoreNames) {
+		if (!strcasecmp(name.c_str(), entry.name)) {
+			*core = entry.core;
+			return true;
+		}
+	}
+	return false;
+}
+
+static const char *CPUCoreName(CPUCore core) {
+	for (const auto &entry : cpuCoreNames) {
+		if (entry.core == core)
+			return entry.name;
+	}
+	return "unknown";
+}
+
+// Feeds input as if it arrived delay frames late, changing often enough that most of it is mispredicted.
+static void ConfirmRollbackInput(uint32_t delay) {
+	static const uint8_t centered[2][2] = { { 128, 128 }, { 128, 128 } };
+	while (ReplayRollbackConfirmedFrames() + delay < ReplayRollbackFrame()) {
+		uint32_t frame = ReplayRollbackConfirmedFrames();
+		uint32_t buttons = (frame / 30) & 1 ? CTRL_CROSS : 0;
+		ReplayConfirmInput(buttons, centered);
+	}
+}
+
+static void PrintRollbackStats() {
+	const RollbackStats &stats = PSP_GetRollbackStats();
+	double perFrame = stats.framesResimulated == 0 ? 0.0 : stats.resimulateSeconds * 1000.0 / stats.framesResimulated;
+	double perRollback = stats.rollbacks == 0 ? 0.0 : stats.resimulateSeconds * 1000.0 / stats.rollbacks;
+	fprintf(stderr, "Rollback: %d frames, %d rollbacks, %d frames resimulated, %d snapshots, %d stalls\n", (int)ReplayRollbackFrame(), stats.rollbacks, stats.framesResimulated, stats.snapshots, stats.stalls);
+	fprintf(stderr, "Rollback: %0.3f ms per rollback, %0.3f ms per resimulated frame\n", perRollback, perFrame);
+}
+
+static double PeakMemoryMB() {
+#if PPSSPP_PLATFORM(WINDOWS)
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+	return 0.0;
+#else
+	struct rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0.0;
+#if PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS)
+	// Bytes here, kilobytes elsewhere.
+	return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+	return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+static bool BenchmarkSaveState(int iterations) {
+	SaveState::BenchmarkResult result;
+	std::string errorString;
+	if (!SaveState::Benchmark(iterations, &result, &errorString)) {
+		fprintf(stderr, "Savestate benchmark failed: %s\n", errorString.c_str());
+		return false;
+	}
+
+	double sizeMB = result.stateSize / (1024.0 * 1024.0);
+	auto print = [&](const char *name, double seconds) {
+		fprintf(stderr, "  %-18s %8.3f ms  %8.1f MB/s\n", name, seconds * 1000.0, seconds > 0.0 ? sizeMB / seconds : 0.0);
+	};
+	fprintf(stderr, "Savestate: %0.2f MB, %0.2f MB compressed, %d iterations\n", sizeMB, result.compressedSize / (1024.0 * 1024.0), iterations);
+	print("SaveToRam", result.save);
+	print("LoadFromRam", result.load);
+	print("Compress", result.compress);
+	print("Decompress", result.decompress);
+	print("Incremental save", result.incrementalSave);
+	print("Incremental load", result.incrementalLoad);
+	fprintf(stderr, "Peak memory: %0.1f MB\n", PeakMemoryMB());
+
+	fprintf(stderr, "Sections:\n");
+	for (const auto &section : result.sections) {
+		fprintf(stderr, "  %*s%-*s %10lld  %8.3f ms\n", section.depth * 2, "", 24 - section.depth * 2, section.title.c_str(), (long long)section.size, section.seconds * 1000.0);
+	}
+	return true;
+}
+
+struct PerfBenchOptions {
+	int frames = 0;
+	int warmup = 0;
+	const char *output = nullptr;
+};
+
+// Collects per frame timings and totals for --bench.
+class PerfBenchmark {
+public:
+	PerfBenchmark(const PerfBenchOptions &options) : options_(options) {}
+
+	bool Enabled() const {
+		return options_.frames > 0;
+	}
+
+	// Call once per emulated frame. Returns true when all frames have been measured.
+	bool Frame() {
+		double now = time_now_d();
+		if (frame_ < options_.warmup) {
+			frame_++;
+			if (frame_ == options_.warmup)
+				Start(now);
+			ResetFrameStats();
+			return false;
+		}
+		if (frame_ == 0)
+			Start(now);
+
+		frameTimes_.push_back(now - lastFrameTime_);
+		gpuTimes_.push_back(gpuStats.msProcessingDisplayLists);
+		texturesDecoded_ += gpuStats.numTexturesDecoded;
+		texturesHashed_ += gpuStats.numTexturesHashed;
+		textureInvalidations_ += gpuStats.numTextureInvalidations;
+		textureHashingTime_ += gpuStats.msTextureHashing;
+		textureDecodingTime_ += gpuStats.msTextureDecoding;
+		drawCalls_ += gpuStats.numDrawCalls;
+		cacheStats_.Add(gpuStats.cache);
+		lastFrameTime_ = now;
+		frame_++;
+
+		ResetFrameStats();
+		return (int)frameTimes_.size() >= options_.frames;
+	}
+
+	bool Report(const std::string &testName) {
+		double hostSeconds = lastFrameTime_ - startTime_;
+		double emuSeconds = (CoreTiming::GetGlobalTimeUs() - startEmuUs_) / 1000000.0;
+		const MIPSComp::JitCompileStats &jitStats = MIPSComp::jitCompileStats;
+
+		json::JsonWriter writer(json::JsonWriter::PRETTY);
+		writer.begin();
+		writer.writeString("test", testName);
+		writer.writeInt("frames", (int)frameTimes_.size());
+		writer.writeInt("warmupFrames", options_.warmup);
+		writer.writeFloat("hostSeconds", hostSeconds);
+		writer.writeFloat("emulatedSeconds", emuSeconds);
+		writer.writeFloat("speed", hostSeconds > 0.0 ? emuSeconds / hostSeconds : 0.0);
+		writer.writeFloat("fps", hostSeconds > 0.0 ? frameTimes_.size() / hostSeconds : 0.0);
+		WriteTimes(writer, "frameMs", frameTimes_);
+		WriteTimes(writer, "gpuMs", gpuTimes_);
+		writer.pushDict("jit");
+		writer.writeInt("compiles", jitStats.compiles - startJitCompiles_);
+		writer.writeFloat("compileMs", (jitStats.seconds - startJitSeconds_) * 1000.0);
+		writer.pop();
+		writer.pushDict("textures");
+		writer.writeInt("decoded", texturesDecoded_);
+		writer.writeInt("hashed", texturesHashed_);
+		writer.writeInt("invalidations", textureInvalidations_);
+		writer.writeFloat("hashingMs", textureHashingTime_ * 1000.0);
+		writer.writeFloat("decodingMs", textureDecodingTime_ * 1000.0);
+		writer.pop();
+		writer.pushDict("shadersCreated");
+		writer.writeInt("vertex", CountShaders(SHADER_TYPE_VERTEX) - startVertexShaders_);
+		writer.writeInt("fragment", CountShaders(SHADER_TYPE_FRAGMENT) - startFragmentShaders_);
+		writer.writeInt("pipelines", CountShaders(SHADER_TYPE_PIPELINE) - startPipelines_);
+		writer.pop();
+		writer.writeInt("drawCalls", drawCalls_);
+		double gpuSeconds = 0.0;
+		for (double t : gpuTimes_)
+			gpuSeconds += t;
+		writer.writeFloat("gpuUsPerDrawCall", drawCalls_ > 0 ? gpuSeconds * 1000000.0 / drawCalls_ : 0.0);
+		writer.pushDict("caches");
+		cacheStats_.WriteJson(writer);
+		writer.pop();
+		writer.end();
+
+		std::string json = writer.str();
+		if (!options_.output) {
+			printf("%s\n", json.c_str());
+			return true;
+		}
+		if (!File::WriteStringToFile(true, json, Path(std::string(options_.output)))) {
+			fprintf(stderr, "Failed to write benchmark results to %s\n", options_.output);
+			return false;
+		}
+		return true;
+	}
+
+	void Fill(CorpusResult *result) const {
+		std::vector<double> times = frameTimes_;
+		std::sort(times.begin(), times.end());
+		double sum = 0.0;
+		for (double t : times)
+			sum += t;
+
+		result->frames = (int)times.size();
+		result->hostSeconds = lastFrameTime_ - startTime_;
+		result->frameMsMean = times.empty() ? 0.0 : sum * 1000.0 / times.size();
+		result->frameMsP90 = times.empty() ? 0.0 : times[std::min(times.size() - 1, (size_t)(0.9 * times.size()))] * 1000.0;
+		result->jitCompileMs = (MIPSComp::jitCompileStats.seconds - startJitSeconds_) * 1000.0;
+	}
+
+private:
+	void Start(double now) {
+		startTime_ = now;
+		lastFrameTime_ = now;
+		startEmuUs_ = CoreTiming::GetGlobalTimeUs();
+		startJitCompiles_ = MIPSComp::jitCompileStats.compiles;
+		startJitSeconds_ = MIPSComp::jitCompileStats.seconds;
+		startVertexShaders_ = CountShaders(SHADER_TYPE_VERTEX);
+		startFragmentShaders_ = CountShaders(SHADER_TYPE_FRAGMENT);
+		startPipelines_ = CountShaders(SHADER_TYPE_PIPELINE);
+	}
+
+	// Caches only grow while running, so the difference is what was created.
+	static int CountShaders(DebugShaderType type) {
+		return gpu ? (int)gpu->DebugGetShaderIDs(type).size() : 0;
+	}
+
+	static void ResetFrameStats() {
+		// Stats are only collected with debug stats on, which the benchmark forces.
+		Core_UpdateDebugStats(true);
+	}
+
+	static void WriteTimes(json::JsonWriter &writer, const char *name, std::vector<double> times) {
+		std::sort(times.begin(), times.end());
+		auto percentile = [&](double p) {
+			if (times.empty())
+				return 0.0;
+			size_t index = std::min(times.size() - 1, (size_t)(p * times.size()));
+			return times[index] * 1000.0;
+		};
+		double sum = 0.0;
+		for (double t : times)
+			sum += t;
+
+		writer.pushDict(name);
+		writer.writeFloat("mean", times.empty() ? 0.0 : sum * 1000.0 / times.size());
+		writer.writeFloat("p50", percentile(0.50));
+		writer.writeFloat("p90", percentile(0.90));
+		writer.writeFloat("p99", percentile(0.99));
+		writer.writeFloat("max", times.empty() ? 0.0 : times.back() * 1000.0);
+		writer.pop();
+	}
+
+	PerfBenchOptions options_;
+	int frame_ = 0;
+	double startTime_ = 0.0;
+	double lastFrameTime_ = 0.0;
+	int64_t startEmuUs_ = 0;
+	int startJitCompiles_ = 0;
+	double startJitSeconds_ = 0.0;
+	std::vector<double> frameTimes_;
+	std::vector<double> gpuTimes_;
+	int texturesDecoded_ = 0;
+	int texturesHashed_ = 0;
+	int textureInvalidations_ = 0;
+	double textureHashingTime_ = 0.0;
+	double textureDecodingTime_ = 0.0;
+	int startVertexShaders_ = 0;
+	int startFragmentShaders_ = 0;
+	int startPipelines_ = 0;
+	int drawCalls_ = 0;
+	GPUCacheStatistics cacheStats_{};
+};
+
+bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout, int rollbackDelay, int benchFrames, int benchIterations, const PerfBenchOptions &perfOptions)
 {
 	// Kinda ugly, trying to guesstimate the test name from filename...
 	currentTestName = GetTestName(coreParameter.fileToStart);
@@ -195,22 +531,45 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	double deadline;
 	deadline = time_now_d() + timeout;
 
+	PerfBenchmark perfBench(perfOptions);
+	if (perfBench.Enabled())
+		Core_ForceDebugStats(true);
 	Core_UpdateDebugStats(g_Config.bShowDebugStats || g_Config.bLogFrameDrops);
 
 	PSP_BeginHostFrame();
 	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
 		coreParameter.graphicsContext->GetDrawContext()->BeginFrame();
 
+	if (rollbackDelay > 0)
+		ReplayBeginRollback();
+
+	int frames = 0;
 	coreState = coreParameter.startBreak ? CORE_STEPPING : CORE_RUNNING;
 	while (coreState == CORE_RUNNING || coreState == CORE_STEPPING)
 	{
-		int blockTicks = (int)usToCycles(1000000 / 10);
-		PSP_RunLoopFor(blockTicks);
+		if (rollbackDelay > 0) {
+			// This goes through rollback, and runs a whole frame.
+			PSP_RunLoopWhileState();
+		} else {
+			int blockTicks = (int)usToCycles(1000000 / 10);
+			PSP_RunLoopFor(blockTicks);
+		}
 
 		// If we were rendering, this might be a nice time to do something about it.
 		if (coreState == CORE_NEXTFRAME) {
 			coreState = CORE_RUNNING;
 			headlessHost->SwapBuffers();
+			if (rollbackDelay > 0)
+				ConfirmRollbackInput(rollbackDelay);
+
+			if (benchFrames > 0 && ++frames == benchFrames) {
+				passed = BenchmarkSaveState(benchIterations);
+				Core_Stop();
+			}
+			if (perfBench.Enabled() && perfBench.Frame()) {
+				passed = perfBench.Report(currentTestName);
+				Core_Stop();
+			}
 		}
 		if (coreState == CORE_STEPPING && !coreParameter.startBreak) {
 			break;
@@ -231,6 +590,14 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
 		coreParameter.graphicsContext->GetDrawContext()->EndFrame();
 
+	if (perfBench.Enabled())
+		Core_ForceDebugStats(false);
+
+	if (rollbackDelay > 0) {
+		PrintRollbackStats();
+		ReplayAbort();
+	}
+
 	PSP_Shutdown();
 
 	headlessHost->FlushDebugOutput();
@@ -243,6 +610,290 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	return passed;
 }
 
+struct CorpusOptions {
+	const char *manifest = nullptr;
+	const char *output = nullptr;
+	const char *baseline = nullptr;
+	double tolerance = 0.1;
+	std::vector<CPUCore> cpuCores;
+	std::vector<GPUCore> gpuCores;
+};
+
+static u64 HashDisplayFramebuffer() {
+	GPUDebugBuffer buffer;
+	if (!gpuDebug || !gpuDebug->GetCurrentFramebuffer(buffer, GPU_DBG_FRAMEBUF_DISPLAY))
+		return 0;
+
+	// Only the visible part, the rest of the stride isn't meaningful.
+	const std::vector<u32> pixels = TranslateDebugBufferToCompare(&buffer, 512, 272);
+	std::vector<u32> visible;
+	visible.reserve(480 * 272);
+	for (u32 y = 0; y < 272; ++y)
+		visible.insert(visible.end(), pixels.begin() + y * 512, pixels.begin() + y * 512 + 480);
+	return XXH3_64bits(visible.data(), visible.size() * sizeof(u32));
+}
+
+static bool RunCorpusEntry(HeadlessHost *headlessHost, CoreParameter &coreParameter, const CorpusEntry &entry, double timeout, CorpusResult *result) {
+	coreParameter.fileToStart = entry.game;
+
+	std::string error_string;
+	if (!PSP_InitStart(coreParameter, &error_string)) {
+		fprintf(stderr, "%s: failed to start: %s\n", result->name.c_str(), error_string.c_str());
+		return false;
+	}
+	host->BootDone();
+	while (!PSP_InitUpdate(&error_string))
+		sleep_ms(1);
+	if (!PSP_IsInited()) {
+		fprintf(stderr, "%s: startup failed: %s\n", result->name.c_str(), error_string.c_str());
+		return false;
+	}
+
+	// The load happens in the run loop, and the replay has to start right after it.
+	bool stateLoaded = false;
+	bool stateFailed = false;
+	SaveState::Load(entry.state, -1, [&](SaveState::Status status, const std::string &message, void *) {
+		if (status == SaveState::Status::FAILURE) {
+			fprintf(stderr, "%s: failed to load state: %s\n", result->name.c_str(), message.c_str());
+			stateFailed = true;
+		} else if (!entry.replay.empty() && !ReplayExecuteFile(entry.replay)) {
+			fprintf(stderr, "%s: failed to load replay %s\n", result->name.c_str(), entry.replay.c_str());
+			stateFailed = true;
+		} else {
+			stateLoaded = true;
+		}
+	});
+
+	PerfBenchOptions perfOptions;
+	perfOptions.frames = entry.frames;
+	PerfBenchmark perfBench(perfOptions);
+	Core_ForceDebugStats(true);
+	Core_UpdateDebugStats(true);
+
+	PSP_BeginHostFrame();
+	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
+		coreParameter.graphicsContext->GetDrawContext()->BeginFrame();
+
+	bool passed = false;
+	double deadline = time_now_d() + timeout;
+	coreState = CORE_RUNNING;
+	while (coreState == CORE_RUNNING) {
+		PSP_RunLoopFor((int)usToCycles(1000000 / 10));
+
+		if (coreState == CORE_NEXTFRAME) {
+			coreState = CORE_RUNNING;
+			headlessHost->SwapBuffers();
+			if (stateFailed) {
+				Core_Stop();
+			} else if (stateLoaded && perfBench.Frame()) {
+				perfBench.Fill(result);
+				result->framebufferHash = HashDisplayFramebuffer();
+				passed = true;
+				Core_Stop();
+			}
+		}
+		if (coreState == CORE_RUNNING && time_now_d() > deadline) {
+			fprintf(stderr, "%s: timeout\n", result->name.c_str());
+			Core_Stop();
+		}
+	}
+	PSP_EndHostFrame();
+
+	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
+		coreParameter.graphicsContext->GetDrawContext()->EndFrame();
+
+	Core_ForceDebugStats(false);
+	ReplayAbort();
+	PSP_Shutdown();
+	headlessHost->FlushDebugOutput();
+
+	return passed;
+}
+
+static bool SwitchGraphicsCore(HeadlessHost *&headlessHost, CoreParameter &coreParameter, GPUCore gpuCore) {
+	host->ShutdownGraphics();
+	delete host;
+
+	headlessHost = getHost(gpuCore);
+	headlessHost->SetGraphicsCore(gpuCore);
+	host = headlessHost;
+
+	std::string error_string;
+	GraphicsContext *graphicsContext = nullptr;
+	bool glWorking = host->InitGraphics(&error_string, &graphicsContext);
+	coreParameter.gpuCore = glWorking ? gpuCore : GPUCORE_SOFTWARE;
+	coreParameter.graphicsContext = graphicsContext;
+	return coreParameter.gpuCore == gpuCore;
+}
+
+// Runs every corpus entry on each requested CPU core and GPU backend.
+// Returns false if anything failed to run, or regressed against the baseline.
+static bool RunCorpus(HeadlessHost *&headlessHost, CoreParameter &coreParameter, const CorpusOptions &options, double timeout) {
+	std::vector<CorpusEntry> entries;
+	std::string error;
+	if (!LoadCorpusManifest(Path(std::string(options.manifest)), &entries, &error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		return false;
+	}
+
+	std::vector<CPUCore> cpuCores = options.cpuCores;
+	if (cpuCores.empty())
+		cpuCores.push_back(coreParameter.cpuCore);
+	std::vector<GPUCore> gpuCores = options.gpuCores;
+	if (gpuCores.empty())
+		gpuCores.push_back(coreParameter.gpuCore);
+
+	std::vector<CorpusResult> results;
+	bool allRan = true;
+	for (GPUCore gpuCore : gpuCores) {
+		bool gpuWorking = gpuCore == coreParameter.gpuCore || SwitchGraphicsCore(headlessHost, coreParameter, gpuCore);
+		if (!gpuWorking)
+			fprintf(stderr, "Could not initialize %s graphics\n", GPUCoreName(gpuCore));
+
+		for (CPUCore cpuCore : cpuCores) {
+			coreParameter.cpuCore = cpuCore;
+			for (const CorpusEntry &entry : entries) {
+				CorpusResult result;
+				result.name = entry.name + "/" + CPUCoreName(cpuCore) + "/" + GPUCoreName(gpuCore);
+				result.ran = gpuWorking && RunCorpusEntry(headlessHost, coreParameter, entry, timeout, &result);
+				if (result.ran)
+					fprintf(stderr, "%s: %0.3f ms per frame (p90 %0.3f ms), framebuffer %016llx\n", result.name.c_str(), result.frameMsMean, result.frameMsP90, (unsigned long long)result.framebufferHash);
+				else
+					allRan = false;
+				results.push_back(result);
+			}
+		}
+	}
+
+	if (options.output && !SaveCorpusResults(Path(std::string(options.output)), results)) {
+		fprintf(stderr, "Failed to write corpus results to %s\n", options.output);
+		allRan = false;
+	}
+
+	if (!options.baseline)
+		return allRan;
+
+	std::vector<CorpusResult> baseline;
+	if (!LoadCorpusResults(Path(std::string(options.baseline)), &baseline)) {
+		fprintf(stderr, "Could not read corpus baseline %s\n", options.baseline);
+		return false;
+	}
+	int regressions = CompareCorpusResults(baseline, results, options.tolerance);
+	printf("%d of %d corpus results regressed.\n", regressions, (int)results.size());
+	return allRan && regressions == 0;
+}
+
+static void PrintTestSummary(const std::vector<std::string> &passedTests, const std::vector<std::string> &failedTests) {
+	printf("%d tests passed, %d tests failed.\n", (int)passedTests.size(), (int)failedTests.size());
+	if (!failedTests.empty()) {
+		printf("Failed tests:\n");
+		for (size_t i = 0; i < failedTests.size(); ++i) {
+			printf("  %s\n", failedTests[i].c_str());
+		}
+	}
+}
+
+#if !PPSSPP_PLATFORM(WINDOWS)
+// The emulator core lives in globals, so only one can run per process.  To still use all cores,
+// we fork workers before any threads or graphics exist, and each runs every Nth test in the
+// list.  Each one still pays startup only once for all its tests.
+// Returns true in a worker, which should run the (now reduced) testFilenames and report each
+// result to resultFd.  In the parent, waits for all workers and collects their results.
+static bool ForkTestWorkers(int count, std::vector<std::string> &testFilenames, int *resultFd, std::vector<std::string> &passedTests, std::vector<std::string> &failedTests, bool *workerFailed) {
+	std::vector<pid_t> pids;
+	std::vector<int> fds;
+	for (int i = 0; i < count; ++i) {
+		int pipeFds[2];
+		if (pipe(pipeFds) != 0) {
+			perror("Unable to create worker pipe");
+			break;
+		}
+
+		fflush(stdout);
+		fflush(stderr);
+		pid_t pid = fork();
+		if (pid == 0) {
+			close(pipeFds[0]);
+			for (int fd : fds)
+				close(fd);
+			*resultFd = pipeFds[1];
+
+			std::vector<std::string> ours;
+			for (size_t j = i; j < testFilenames.size(); j += count)
+				ours.push_back(testFilenames[j]);
+			testFilenames = ours;
+			// Keeps the output of different workers from mixing within a line.
+			setvbuf(stdout, nullptr, _IOLBF, 0);
+			return true;
+		}
+
+		close(pipeFds[1]);
+		if (pid < 0) {
+			perror("Unable to start worker");
+			close(pipeFds[0]);
+			break;
+		}
+		pids.push_back(pid);
+		fds.push_back(pipeFds[0]);
+	}
+
+	// If we couldn't start them all, the tests of the missing ones count as failed.
+	for (size_t i = pids.size(); i < (size_t)count; ++i) {
+		for (size_t j = i; j < testFilenames.size(); j += count)
+			failedTests.push_back(GetTestName(Path(testFilenames[j])));
+	}
+
+	// Each result is a line, P or F and the test name.  Poll so no worker blocks on a full pipe.
+	std::vector<std::string> pending(fds.size());
+	std::vector<pollfd> polls;
+	for (int fd : fds)
+		polls.push_back({ fd, POLLIN, 0 });
+	size_t open = fds.size();
+	while (open > 0) {
+		if (poll(polls.data(), (nfds_t)polls.size(), -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("Unable to wait for workers");
+			break;
+		}
+		for (size_t i = 0; i < polls.size(); ++i) {
+			if (polls[i].fd < 0 || polls[i].revents == 0)
+				continue;
+			char buf[4096];
+			ssize_t len = read(polls[i].fd, buf, sizeof(buf));
+			if (len <= 0) {
+				close(polls[i].fd);
+				polls[i].fd = -1;
+				open--;
+				continue;
+			}
+			pending[i].append(buf, len);
+			size_t end;
+			while ((end = pending[i].find('\n')) != pending[i].npos) {
+				std::string line = pending[i].substr(0, end);
+				pending[i].erase(0, end + 1);
+				if (line.size() > 2 && line[0] == 'P')
+					passedTests.push_back(line.substr(2));
+				else if (line.size() > 2 && line[0] == 'F')
+					failedTests.push_back(line.substr(2));
+			}
+		}
+	}
+
+	*workerFailed = pids.size() < (size_t)count;
+	for (size_t i = 0; i < pids.size(); ++i) {
+		int status = 0;
+		while (waitpid(pids[i], &status, 0) < 0 && errno == EINTR)
+			continue;
+		if (WIFSIGNALED(status)) {
+			fprintf(stderr, "Worker %d crashed (signal %d), some tests may not have reported.\n", (int)i, WTERMSIG(status));
+			*workerFailed = true;
+		}
+	}
+	return false;
+}
+#endif
+
 int main(int argc, const char* argv[])
 {
 	PROFILE_INIT();
@@ -266,6 +917,13 @@ int main(int argc, const char* argv[])
 	GPUCore gpuCore = GPUCORE_SOFTWARE;
 	CPUCore cpuCore = CPUCore::JIT;
 	int debuggerPort = -1;
+	int rollbackDelay = 0;
+	int benchFrames = 0;
+	int benchIterations = 10;
+	PerfBenchOptions perfOptions;
+	bool benchSound = false;
+	CorpusOptions corpusOptions;
+	int workers = 1;
 
 	std::vector<std::string> testFilenames;
 	const char *mountIso = nullptr;
@@ -295,6 +953,8 @@ int main(int argc, const char* argv[])
 			cpuCore = CPUCore::JIT;
 		else if (!strcmp(argv[i], "--ir"))
 			cpuCore = CPUCore::IR_JIT;
+		else if (!strcmp(argv[i], "--irjit"))
+			cpuCore = CPUCore::JIT_IR;
 		else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--compare"))
 			autoCompare = true;
 		else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
@@ -302,18 +962,7 @@ int main(int argc, const char* argv[])
 		else if (!strncmp(argv[i], "--graphics=", strlen("--graphics=")) && strlen(argv[i]) > strlen("--graphics="))
 		{
 			const char *gpuName = argv[i] + strlen("--graphics=");
-			if (!strcasecmp(gpuName, "gles"))
-				gpuCore = GPUCORE_GLES;
-			// There used to be a separate "null" rendering core - just use software.
-			else if (!strcasecmp(gpuName, "software") || !strcasecmp(gpuName, "null"))
-				gpuCore = GPUCORE_SOFTWARE;
-			else if (!strcasecmp(gpuName, "directx9"))
-				gpuCore = GPUCORE_DIRECTX9;
-			else if (!strcasecmp(gpuName, "directx11"))
-				gpuCore = GPUCORE_DIRECTX11;
-			else if (!strcasecmp(gpuName, "vulkan"))
-				gpuCore = GPUCORE_VULKAN;
-			else
+			if (!ParseGPUCore(gpuName, &gpuCore))
 				return printUsage(argv[0], "Unknown gpu backend specified after --graphics=. Allowed: software, directx9, directx11, vulkan, gles, null.");
 		}
 		// Default to GLES if no value selected.
@@ -329,6 +978,52 @@ int main(int argc, const char* argv[])
 			timeout = (float)strtod(argv[i] + strlen("--timeout="), NULL);
 		else if (!strncmp(argv[i], "--debugger=", strlen("--debugger=")) && strlen(argv[i]) > strlen("--debugger="))
 			debuggerPort = (int)strtoul(argv[i] + strlen("--debugger="), NULL, 10);
+		else if (!strncmp(argv[i], "--rollback=", strlen("--rollback=")) && strlen(argv[i]) > strlen("--rollback="))
+			rollbackDelay = (int)strtoul(argv[i] + strlen("--rollback="), NULL, 10);
+		else if (!strncmp(argv[i], "--bench-savestate=", strlen("--bench-savestate=")) && strlen(argv[i]) > strlen("--bench-savestate="))
+			benchFrames = (int)strtoul(argv[i] + strlen("--bench-savestate="), NULL, 10);
+		else if (!strncmp(argv[i], "--bench-iterations=", strlen("--bench-iterations=")) && strlen(argv[i]) > strlen("--bench-iterations="))
+			benchIterations = (int)strtoul(argv[i] + strlen("--bench-iterations="), NULL, 10);
+		else if (!strncmp(argv[i], "--bench=", strlen("--bench=")) && strlen(argv[i]) > strlen("--bench="))
+			perfOptions.frames = (int)strtoul(argv[i] + strlen("--bench="), NULL, 10);
+		else if (!strncmp(argv[i], "--bench-warmup=", strlen("--bench-warmup=")) && strlen(argv[i]) > strlen("--bench-warmup="))
+			perfOptions.warmup = (int)strtoul(argv[i] + strlen("--bench-warmup="), NULL, 10);
+		else if (!strncmp(argv[i], "--bench-output=", strlen("--bench-output=")) && strlen(argv[i]) > strlen("--bench-output="))
+			perfOptions.output = argv[i] + strlen("--bench-output=");
+		else if (!strcmp(argv[i], "--bench-sound"))
+			benchSound = true;
+		else if (!strncmp(argv[i], "--corpus=", strlen("--corpus=")) && strlen(argv[i]) > strlen("--corpus="))
+			corpusOptions.manifest = argv[i] + strlen("--corpus=");
+		else if (!strncmp(argv[i], "--corpus-output=", strlen("--corpus-output=")) && strlen(argv[i]) > strlen("--corpus-output="))
+			corpusOptions.output = argv[i] + strlen("--corpus-output=");
+		else if (!strncmp(argv[i], "--corpus-baseline=", strlen("--corpus-baseline=")) && strlen(argv[i]) > strlen("--corpus-baseline="))
+			corpusOptions.baseline = argv[i] + strlen("--corpus-baseline=");
+		else if (!strncmp(argv[i], "--corpus-tolerance=", strlen("--corpus-tolerance=")) && strlen(argv[i]) > strlen("--corpus-tolerance="))
+			corpusOptions.tolerance = strtod(argv[i] + strlen("--corpus-tolerance="), NULL) / 100.0;
+		else if (!strncmp(argv[i], "--corpus-cpu=", strlen("--corpus-cpu=")) && strlen(argv[i]) > strlen("--corpus-cpu="))
+		{
+			std::vector<std::string> names;
+			SplitString(argv[i] + strlen("--corpus-cpu="), ',', names);
+			for (const std::string &name : names) {
+				CPUCore core;
+				if (!ParseCPUCore(name, &core))
+					return printUsage(argv[0], "Unknown cpu core specified after --corpus-cpu=. Allowed: interpreter, jit, ir, irjit.");
+				corpusOptions.cpuCores.push_back(core);
+			}
+		}
+		else if (!strncmp(argv[i], "--corpus-gpu=", strlen("--corpus-gpu=")) && strlen(argv[i]) > strlen("--corpus-gpu="))
+		{
+			std::vector<std::string> names;
+			SplitString(argv[i] + strlen("--corpus-gpu="), ',', names);
+			for (const std::string &name : names) {
+				GPUCore core;
+				if (!ParseGPUCore(name, &core))
+					return printUsage(argv[0], "Unknown gpu backend specified after --corpus-gpu=. Allowed: software, directx9, directx11, vulkan, gles, null.");
+				corpusOptions.gpuCores.push_back(core);
+			}
+		}
+		else if (!strncmp(argv[i], "--workers=", strlen("--workers=")) && strlen(argv[i]) > strlen("--workers="))
+			workers = (int)strtoul(argv[i] + strlen("--workers="), NULL, 10);
 		else if (!strcmp(argv[i], "--teamcity"))
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
@@ -350,9 +1045,27 @@ int main(int argc, const char* argv[])
 			testFilenames.push_back(temp);
 	}
 
-	if (testFilenames.empty())
+	if (testFilenames.empty() && !corpusOptions.manifest)
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
 
+	std::vector<std::string> failedTests;
+	std::vector<std::string> passedTests;
+	int resultFd = -1;
+#if !PPSSPP_PLATFORM(WINDOWS)
+	// Workers only make sense for a plain list of tests, the other modes are single runs.
+	workers = std::min(workers, (int)testFilenames.size());
+	if (workers > 1 && !corpusOptions.manifest && debuggerPort <= 0) {
+		bool workerFailed = false;
+		if (!ForkTestWorkers(workers, testFilenames, &resultFd, passedTests, failedTests, &workerFailed)) {
+			if (autoCompare)
+				PrintTestSummary(passedTests, failedTests);
+			if ((!failedTests.empty() || workerFailed) && !teamCityMode)
+				return 1;
+			return 0;
+		}
+	}
+#endif
+
 	LogManager::Init(&g_Config.bEnableLogging);
 	LogManager *logman = LogManager::GetInstance();
 
@@ -392,8 +1105,10 @@ int main(int argc, const char* argv[])
 	coreParameter.pixelWidth = 480;
 	coreParameter.pixelHeight = 272;
 	coreParameter.fastForward = true;
+	coreParameter.headLessBenchmark = perfOptions.frames > 0;
 
-	g_Config.bEnableSound = false;
+	// There's no audio output, but enabling this still runs the mixer so it's part of a benchmark.
+	g_Config.bEnableSound = benchSound;
 	g_Config.bFirstRun = false;
 	g_Config.bIgnoreBadMemAccess = true;
 	// Never report from tests.
@@ -477,14 +1192,16 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(Path(stateToLoad), -1);
 
-	std::vector<std::string> failedTests;
-	std::vector<std::string> passedTests;
+	bool corpusPassed = true;
+	if (corpusOptions.manifest)
+		corpusPassed = RunCorpus(headlessHost, coreParameter, corpusOptions, timeout);
+
 	for (size_t i = 0; i < testFilenames.size(); ++i)
 	{
 		coreParameter.fileToStart = Path(testFilenames[i]);
 		if (autoCompare)
 			printf("%s:\n", coreParameter.fileToStart.c_str());
-		bool passed = RunAutoTest(headlessHost, coreParameter, autoCompare, verbose, timeout);
+		bool passed = RunAutoTest(headlessHost, coreParameter, autoCompare, verbose, timeout, rollbackDelay, benchFrames, benchIterations, perfOptions);
 		if (autoCompare)
 		{
 			std::string testName = GetTestName(coreParameter.fileToStart);
@@ -495,21 +1212,26 @@ int main(int argc, const char* argv[])
 			}
 			else
 				failedTests.push_back(testName);
-		}
-	}
 
-	if (autoCompare)
-	{
-		printf("%d tests passed, %d tests failed.\n", (int)passedTests.size(), (int)failedTests.size());
-		if (!failedTests.empty())
-		{
-			printf("Failed tests:\n");
-			for (size_t i = 0; i < failedTests.size(); ++i) {
-				printf("  %s\n", failedTests[i].c_str());
+#if !PPSSPP_PLATFORM(WINDOWS)
+			if (resultFd >= 0) {
+				std::string line = std::string(passed ? "P " : "F ") + testName + "\n";
+				if (write(resultFd, line.data(), line.size()) != (ssize_t)line.size())
+					perror("Unable to report test result");
 			}
+#endif
 		}
 	}
 
+	// In a worker, the parent prints the summary for everyone.
+	bool isWorker = resultFd >= 0;
+#if !PPSSPP_PLATFORM(WINDOWS)
+	if (isWorker)
+		close(resultFd);
+#endif
+	if (autoCompare && !isWorker)
+		PrintTestSummary(passedTests, failedTests);
+
 	if (debuggerPort > 0) {
 		ShutdownWebServer();
 	}
@@ -527,7 +1249,7 @@ int main(int argc, const char* argv[])
 	timeEndPeriod(1);
 #endif
 
-	if (!failedTests.empty() && !teamCityMode)
+	if ((!failedTests.empty() || !corpusPassed) && !teamCityMode)
 		return 1;
 	return 0;
 }
@@ -6,6 +6,7 @@
 #include <vector>
 #include <cstdlib>
 #include <mutex>
+#include <condition_variable>
 
 #include "Common/CPUDetect.h"
 #include "Common/Log.h"
@@ -531,7 +532,7 @@ template <typename T> class RetroOption
    {"f", "f"}                \
 }
 
-static RetroOption<CPUCore> ppsspp_cpu_core("ppsspp_cpu_core", "CPU Core", { { "JIT", CPUCore::JIT }, { "IR JIT", CPUCore::IR_JIT }, { "Interpreter", CPUCore::INTERPRETER } });
+static RetroOption<CPUCore> ppsspp_cpu_core("ppsspp_cpu_core", "CPU Core", { { "JIT", CPUCore::JIT }, { "IR JIT", CPUCore::IR_JIT }, { "JIT using IR", CPUCore::JIT_IR }, { "Interpreter", CPUCore::INTERPRETER } });
 static RetroOption<int> ppsspp_locked_cpu_speed("ppsspp_locked_cpu_speed", "Locked CPU Speed", { { "off", 0 }, { "222MHz", 222 }, { "266MHz", 266 }, { "333MHz", 333 } });
 static RetroOption<int> ppsspp_language("ppsspp_language", "Language", { { "Automatic", -1 }, { "English", PSP_SYSTEMPARAM_LANGUAGE_ENGLISH }, { "Japanese", PSP_SYSTEMPARAM_LANGUAGE_JAPANESE }, { "French", PSP_SYSTEMPARAM_LANGUAGE_FRENCH }, { "Spanish", PSP_SYSTEMPARAM_LANGUAGE_SPANISH }, { "German", PSP_SYSTEMPARAM_LANGUAGE_GERMAN }, { "Italian", PSP_SYSTEMPARAM_LANGUAGE_ITALIAN }, { "Dutch", PSP_SYSTEMPARAM_LANGUAGE_DUTCH }, { "Portuguese", PSP_SYSTEMPARAM_LANGUAGE_PORTUGUESE }, { "Russian", PSP_SYSTEMPARAM_LANGUAGE_RUSSIAN }, { "Korean", PSP_SYSTEMPARAM_LANGUAGE_KOREAN }, { "Chinese Traditional", PSP_SYSTEMPARAM_LANGUAGE_CHINESE_TRADITIONAL }, { "Chinese Simplified", PSP_SYSTEMPARAM_LANGUAGE_CHINESE_SIMPLIFIED } });
 static RetroOption<int> ppsspp_rendering_mode("ppsspp_rendering_mode", "Rendering Mode", { { "Buffered", FB_BUFFERED_MODE }, { "Skip Buffer Effects", FB_NON_BUFFERED_MODE } });
@@ -1062,6 +1063,17 @@ namespace Libretro
    std::atomic<EmuThreadState> emuThreadState(EmuThreadState::DISABLED);
 
    static std::thread emuThread;
+   // Signalled on every state change, so neither side has to poll.
+   static std::mutex emuThreadLock;
+   static std::condition_variable emuThreadCond;
+
+   static void SetEmuThreadState(EmuThreadState state)
+   {
+      std::lock_guard<std::mutex> guard(emuThreadLock);
+      emuThreadState = state;
+      emuThreadCond.notify_all();
+   }
+
    static void EmuFrame()
    {
       ctx->SetRenderTarget();
@@ -1094,11 +1106,14 @@ namespace Libretro
                EmuFrame();
                break;
             case EmuThreadState::PAUSE_REQUESTED:
-               emuThreadState = EmuThreadState::PAUSED;
+               SetEmuThreadState(EmuThreadState::PAUSED);
                /* fallthrough */
             case EmuThreadState::PAUSED:
-               sleep_ms(1);
+            {
+               std::unique_lock<std::mutex> guard(emuThreadLock);
+               emuThreadCond.wait(guard, [] { return emuThreadState != EmuThreadState::PAUSED; });
                break;
+            }
             default:
             case EmuThreadState::QUIT_REQUESTED:
                emuThreadState = EmuThreadState::STOPPED;
@@ -1111,7 +1126,7 @@ namespace Libretro
    void EmuThreadStart()
    {
       bool wasPaused = emuThreadState == EmuThreadState::PAUSED;
-      emuThreadState = EmuThreadState::START_REQUESTED;
+      SetEmuThreadState(EmuThreadState::START_REQUESTED);
 
       if (!wasPaused)
       {
@@ -1125,7 +1140,7 @@ namespace Libretro
       if (emuThreadState != EmuThreadState::RUNNING)
          return;
 
-      emuThreadState = EmuThreadState::QUIT_REQUESTED;
+      SetEmuThreadState(EmuThreadState::QUIT_REQUESTED);
 
       // Need to keep eating frames to allow the EmuThread to exit correctly.
       while (ctx->ThreadFrame())
@@ -1141,13 +1156,13 @@ namespace Libretro
       if (emuThreadState != EmuThreadState::RUNNING)
          return;
 
-      emuThreadState = EmuThreadState::PAUSE_REQUESTED;
+      SetEmuThreadState(EmuThreadState::PAUSE_REQUESTED);
 
       ctx->ThreadFrame(); // Eat 1 frame
       AudioBufferFlush();
 
-      while (emuThreadState != EmuThreadState::PAUSED)
-         sleep_ms(1);
+      std::unique_lock<std::mutex> guard(emuThreadLock);
+      emuThreadCond.wait(guard, [] { return emuThreadState == EmuThreadState::PAUSED; });
    }
 
 } // namespace Libretro
@@ -1279,6 +1294,16 @@ static void retro_input(void)
    __CtrlSetAnalogXY(CTRL_STICK_RIGHT, x_right, y_right);
 }
 
+static void FinishFrame(bool videoEnabled, bool audioEnabled)
+{
+   if (audioEnabled)
+      AudioUploadSamples();
+   else
+      AudioBufferFlush();
+   if (videoEnabled)
+      ctx->SwapBuffers();
+}
+
 void retro_run(void)
 {
    if (PSP_IsIniting())
@@ -1299,14 +1324,21 @@ void retro_run(void)
 
    retro_input();
 
+   // During run-ahead the frontend runs hidden frames with video and/or audio disabled.
+   // Those are thrown away, so skip presenting them (and the wait for the frontend image.)
+   int avEnable = 3;
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &avEnable))
+      avEnable = 3;
+   bool videoEnabled = (avEnable & 1) != 0;
+   bool audioEnabled = (avEnable & 2) != 0;
+
    if (useEmuThread)
    {
       if(   emuThreadState == EmuThreadState::PAUSED ||
             emuThreadState == EmuThreadState::PAUSE_REQUESTED)
       {
          VsyncSwapIntervalDetect();
-         AudioUploadSamples();
-         ctx->SwapBuffers();
+         FinishFrame(videoEnabled, audioEnabled);
          return;
       }
 
@@ -1316,7 +1348,7 @@ void retro_run(void)
       if (!ctx->ThreadFrame())
       {
          VsyncSwapIntervalDetect();
-         AudioUploadSamples();
+         FinishFrame(false, audioEnabled);
          return;
       }
    }
@@ -1324,8 +1356,7 @@ void retro_run(void)
       EmuFrame();
 
    VsyncSwapIntervalDetect();
-   AudioUploadSamples();
-   ctx->SwapBuffers();
+   FinishFrame(videoEnabled, audioEnabled);
 }
 
 unsigned retro_get_region(void) { return RETRO_REGION_NTSC; }
@@ -1372,11 +1403,9 @@ bool retro_serialize(void *data, size_t size)
    auto err = CChunkFileReader::SavePtr((u8 *)data, state, measured);
    retVal = err == CChunkFileReader::ERROR_NONE;
 
+   // The emu thread is woken directly, and the next ThreadFrame() blocks until it has work.
    if (useEmuThread)
-   {
       EmuThreadStart();
-      sleep_ms(4);
-   }
 
    AudioBufferFlush();
 
@@ -1396,10 +1425,7 @@ bool retro_unserialize(const void *data, size_t size)
       == CChunkFileReader::ERROR_NONE;
 
    if (useEmuThread)
-   {
       EmuThreadStart();
-      sleep_ms(4);
-   }
 
    AudioBufferFlush();
 
@@ -0,0 +1,481 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+// Microbenchmarks for hot inner loops. These aren't tests - the numbers depend on the machine,
+// so compare runs on the same device. Usage: PPSSPPBenchmark [name filter]
+
+#include "ppsspp_config.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#if PPSSPP_PLATFORM(ANDROID)
+#include <jni.h>
+#endif
+
+#include "Common/Data/Collections/Hashmaps.h"
+#include "Common/Data/Convert/ColorConv.h"
+#include "Common/Data/Hash/Hash.h"
+#include "Common/System/System.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/CPUDetect.h"
+#include "Common/MemoryUtil.h"
+#include "Common/TimeUtil.h"
+#include "Core/Config.h"
+#include "Core/ConfigValues.h"
+#include "Core/HW/SasAudio.h"
+#include "Core/HW/StereoResampler.h"
+#include "Core/MemMap.h"
+#include "GPU/Common/IndexGenerator.h"
+#include "GPU/Common/TextureDecoder.h"
+#include "GPU/Common/VertexDecoderCommon.h"
+#include "GPU/GPUState.h"
+#include "ext/xxhash.h"
+
+std::string System_GetProperty(SystemProperty prop) { return ""; }
+std::vector<std::string> System_GetPropertyStringVec(SystemProperty prop) { return std::vector<std::string>(); }
+int System_GetPropertyInt(SystemProperty prop) {
+	return -1;
+}
+float System_GetPropertyFloat(SystemProperty prop) {
+	return -1;
+}
+bool System_GetPropertyBool(SystemProperty prop) {
+	switch (prop) {
+	case SYSPROP_CAN_JIT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+#if PPSSPP_PLATFORM(ANDROID)
+JNIEnv *getEnv() {
+	return nullptr;
+}
+
+jclass findClass(const char *name) {
+	return nullptr;
+}
+
+bool audioRecording_Available() { return false; }
+bool audioRecording_State() { return false; }
+#endif
+
+static const char *benchFilter = nullptr;
+// Keeps results alive so the compiler can't drop the work.
+static volatile uint32_t benchSink;
+
+static uint64_t ReadCycleCounter() {
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// Runs func, which processes elements items, until enough time has passed, then prints the cost per item.
+// Cycles are TSC reference cycles, and only available on x86.
+template <typename F>
+static void Bench(const char *name, int elements, F func) {
+	if (benchFilter && !strstr(name, benchFilter))
+		return;
+
+	// Warm up caches and any lazily compiled code.
+	func();
+
+	int rounds = 0;
+	double elapsed;
+	uint64_t startCycles = ReadCycleCounter();
+	double start = time_now_d();
+	do {
+		func();
+		rounds++;
+	} while ((elapsed = time_now_d() - start) < 0.25);
+	uint64_t cycles = ReadCycleCounter() - startCycles;
+
+	double total = (double)rounds * elements;
+	printf("%-36s %9.3f ns/elem", name, elapsed * 1000000000.0 / total);
+	if (cycles != 0)
+		printf(" %9.3f cycles/elem", cycles / total);
+	printf("\n");
+}
+
+template <typename T>
+class AlignedBuffer {
+public:
+	explicit AlignedBuffer(size_t count) : count_(count) {
+		data_ = (T *)AllocateAlignedMemory(count * sizeof(T), 16);
+		for (size_t i = 0; i < count * sizeof(T); ++i)
+			((u8 *)data_)[i] = (u8)(i * 0x9D + (i >> 7));
+	}
+	~AlignedBuffer() {
+		FreeAlignedMemory(data_);
+	}
+	T *data() { return data_; }
+	size_t size() const { return count_; }
+
+private:
+	T *data_;
+	size_t count_;
+};
+
+static void BenchTextureDecoder() {
+	const int w = 512, h = 512;
+	AlignedBuffer<u8> swizzled(w * h * 4);
+	AlignedBuffer<u32> unswizzled(w * h);
+
+	// Pitch is in bytes, blocks are 16 bytes by 8 rows.
+	Bench("UnswizzleTex16 8888", w * h, [&] {
+		DoUnswizzleTex16(swizzled.data(), unswizzled.data(), w * 4 / 16, h / 8, w * 4);
+	});
+	Bench("UnswizzleTex16 4444", w * h, [&] {
+		DoUnswizzleTex16(swizzled.data(), unswizzled.data(), w * 2 / 16, h / 8, w * 2);
+	});
+
+	AlignedBuffer<u8> indexed(w * h);
+	AlignedBuffer<u16> clut16(256);
+	AlignedBuffer<u32> clut32(256);
+	AlignedBuffer<u16> dest16(w * h);
+	AlignedBuffer<u32> dest32(w * h);
+	u32 alphaSum = 0;
+	Bench("DeIndexTexture4Clut16", w * h, [&] {
+		DeIndexTexture4Clut16(dest16.data(), indexed.data(), w * h, clut16.data(), &alphaSum);
+	});
+	Bench("DeIndexTexture4Clut32", w * h, [&] {
+		DeIndexTexture4Clut32(dest32.data(), indexed.data(), w * h, clut32.data(), &alphaSum);
+	});
+	Bench("DeIndexTexture CLUT8 -> 16", w * h, [&] {
+		DeIndexTexture(dest16.data(), indexed.data(), w * h, clut16.data(), &alphaSum);
+	});
+	Bench("DeIndexTexture CLUT8 -> 32", w * h, [&] {
+		DeIndexTexture(dest32.data(), indexed.data(), w * h, clut32.data(), &alphaSum);
+	});
+	benchSink = alphaSum;
+}
+
+static void BenchVertexDecoder() {
+	static const struct {
+		const char *name;
+		u32 vtype;
+	} types[] = {
+		{ "through 16-bit pos, 16-bit tc", GE_VTYPE_POS_16BIT | GE_VTYPE_TC_16BIT | GE_VTYPE_THROUGH },
+		{ "float pos, 8888 col", GE_VTYPE_POS_FLOAT | GE_VTYPE_COL_8888 },
+		{ "float pos, float nrm, float tc", GE_VTYPE_POS_FLOAT | GE_VTYPE_NRM_FLOAT | GE_VTYPE_TC_FLOAT },
+		{ "8-bit pos, 8-bit nrm, 8-bit tc", GE_VTYPE_POS_8BIT | GE_VTYPE_NRM_8BIT | GE_VTYPE_TC_8BIT },
+		{ "16-bit pos, 16-bit nrm, 16-bit tc", GE_VTYPE_POS_16BIT | GE_VTYPE_NRM_16BIT | GE_VTYPE_TC_16BIT },
+		{ "skinned 4 weights, float pos", GE_VTYPE_POS_FLOAT | GE_VTYPE_WEIGHT_8BIT | (3 << GE_VTYPE_WEIGHTCOUNT_SHIFT) },
+	};
+
+	// Required for the jit to be used.
+	g_Config.bVertexDecoderJit = true;
+	g_Config.iCpuCore = (int)CPUCore::JIT;
+	gstate_c.uv.uScale = 1.0f;
+	gstate_c.uv.vScale = 1.0f;
+
+	const int count = 4096;
+	AlignedBuffer<u8> src(count * 64);
+	AlignedBuffer<u8> dst(count * 128);
+	VertexDecoderJitCache jitCache;
+	VertexDecoderOptions options{};
+	char name[128];
+	for (const auto &type : types) {
+		for (int useJit = 0; useJit < 2; ++useJit) {
+			VertexDecoder dec;
+			dec.SetVertexType(type.vtype, options, useJit ? &jitCache : nullptr);
+			snprintf(name, sizeof(name), "VertexDecoder %s %s", useJit ? "jit" : "interp", type.name);
+			Bench(name, count, [&] {
+				dec.DecodeVerts(dst.data(), src.data(), 0, count - 1);
+			});
+		}
+	}
+}
+
+static void BenchSas() {
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	if (!Memory::Init())
+		return;
+
+	// A looping VAG: the first block marks the loop start, the last block jumps back to it.
+	const u32 vagAddr = PSP_GetUserMemoryBase();
+	const u32 vagBlocks = 256;
+	u8 *vag = Memory::GetPointerWriteUnchecked(vagAddr);
+	for (u32 i = 0; i < vagBlocks * 16; ++i)
+		vag[i] = (u8)(i * 0x9D);
+	for (u32 b = 0; b < vagBlocks; ++b) {
+		vag[b * 16 + 0] = (u8)(((b % 5) << 4) | (b % 12));
+		vag[b * 16 + 1] = b == 0 ? 6 : (b == vagBlocks - 1 ? 3 : 0);
+	}
+
+	const int grainSize = 256;
+	std::vector<s16> out(grainSize * 4);
+	char name[64];
+	for (int numVoices : { 1, 8, 32 }) {
+		SasInstance *sas = new SasInstance();
+		sas->SetGrainSize(grainSize);
+		for (int v = 0; v < numVoices; ++v) {
+			SasVoice &voice = sas->voices[v];
+			voice.type = VOICETYPE_VAG;
+			voice.vagAddr = vagAddr;
+			voice.vagSize = vagBlocks * 16;
+			voice.loop = true;
+			// Vary the pitch, so both the resampling and the fast paths get some use.
+			voice.pitch = v % 3 == 0 ? PSP_SAS_PITCH_BASE : PSP_SAS_PITCH_BASE - 0x100 * (v % 7);
+			voice.envelope.attackRate = 0x7FFFFFFF;
+			voice.KeyOn();
+		}
+		snprintf(name, sizeof(name), "SasInstance::Mix %d voices", numVoices);
+		Bench(name, grainSize, [&] {
+			sas->Mix(out.data(), nullptr, 0, 0);
+		});
+		delete sas;
+	}
+
+	Memory::Shutdown();
+}
+
+static void BenchResampler() {
+	const int frames = 512;
+	std::vector<s32> in(frames * 2);
+	for (size_t i = 0; i < in.size(); ++i)
+		in[i] = (s32)((i * 2654435761U) >> 16) - 32768;
+	std::vector<short> out(frames * 2);
+
+	StereoResampler resampler;
+	// Output at a different rate than the input, so it has to actually resample.
+	Bench("StereoResampler::Mix 48000hz", frames, [&] {
+		resampler.PushSamples(in.data(), frames);
+		resampler.Mix(out.data(), frames, false, 48000);
+	});
+}
+
+static void BenchHashes() {
+	const int size = 512 * 1024;
+	AlignedBuffer<u8> data(size);
+	Bench("XXH3_64bits (per byte)", size, [&] {
+		benchSink = (u32)XXH3_64bits(data.data(), size);
+	});
+	Bench("XXH32 (per byte)", size, [&] {
+		benchSink = XXH32(data.data(), size, 0xBACD7814);
+	});
+	Bench("StableQuickTexHash (per byte)", size, [&] {
+		benchSink = StableQuickTexHash(data.data(), size);
+	});
+	Bench("SampledHash 64x256 (per sample)", 64, [&] {
+		benchSink = hash::SampledHash(data.data(), size, 64, 256);
+	});
+}
+
+// Key shapes mimic the hot maps: vertex decoder ids are vertType values where only a few format
+// fields vary, pipeline keys are larger structs with a lot of shared bits.
+struct BenchPipelineKey {
+	uint64_t raster;
+	uint32_t vShader;
+	uint32_t fShader;
+};
+
+static void BenchHashmaps() {
+	std::vector<u32> vertTypes;
+	for (u32 i = 0; i < 48; ++i) {
+		// tc, col, nrm, pos formats, weights and through mode, like GE_VTYPE_*.
+		vertTypes.push_back((i & 3) | ((i % 7) << 2) | (((i >> 2) & 3) << 5) | ((i % 3 + 1) << 7) | ((i & 8) << 20));
+	}
+	std::vector<BenchPipelineKey> pipelines;
+	for (u32 i = 0; i < 400; ++i) {
+		BenchPipelineKey key{};
+		key.raster = 0x0000C0DE00000000ULL | ((u64)(i % 13) << 8) | (i % 5);
+		key.vShader = 0x1000 + (i % 37);
+		key.fShader = 0x2000 + i;
+		pipelines.push_back(key);
+	}
+
+	// Lookups in the order a frame would do them: mostly repeats of a few keys.
+	const int lookups = 4096;
+	std::vector<int> order(lookups);
+	for (int i = 0; i < lookups; ++i)
+		order[i] = ((i * 7) ^ (i >> 3)) % 400;
+
+	// Only presence matters, any non-null pointer will do.
+	void *present = &vertTypes;
+	DenseHashMap<u32, void *, nullptr> decoderMap(64);
+	std::unordered_map<u32, void *> decoderStdMap;
+	for (u32 t : vertTypes) {
+		decoderMap.Insert(t, present);
+		decoderStdMap[t] = present;
+	}
+	Bench("DenseHashMap vertType hit", lookups, [&] {
+		uint32_t found = 0;
+		for (int i = 0; i < lookups; ++i)
+			found += decoderMap.Get(vertTypes[order[i] % vertTypes.size()]) != nullptr;
+		benchSink = found;
+	});
+	Bench("unordered_map vertType hit", lookups, [&] {
+		uint32_t found = 0;
+		for (int i = 0; i < lookups; ++i)
+			found += decoderStdMap.find(vertTypes[order[i] % vertTypes.size()]) != decoderStdMap.end();
+		benchSink = found;
+	});
+
+	DenseHashMap<BenchPipelineKey, void *, nullptr> pipelineMap(256);
+	for (size_t i = 0; i < pipelines.size(); i += 2)
+		pipelineMap.Insert(pipelines[i], present);
+	Bench("DenseHashMap pipeline 50% hit", lookups, [&] {
+		uint32_t found = 0;
+		for (int i = 0; i < lookups; ++i)
+			found += pipelineMap.Get(pipelines[order[i]]) != nullptr;
+		benchSink = found;
+	});
+
+	// Vertex cache style: prehashed keys, with churn.
+	PrehashMap<void *, nullptr> vaiMap(256);
+	std::vector<u32> hashes(1024);
+	for (size_t i = 0; i < hashes.size(); ++i)
+		hashes[i] = (u32)XXH3_64bits(&i, sizeof(i));
+	Bench("PrehashMap insert/get/remove", (int)hashes.size(), [&] {
+		uint32_t found = 0;
+		for (u32 h : hashes)
+			vaiMap.Insert(h, present);
+		for (u32 h : hashes)
+			found += vaiMap.Get(h) != nullptr;
+		for (u32 h : hashes)
+			vaiMap.Remove(h);
+		vaiMap.Maintain();
+		benchSink = found;
+	});
+}
+
+static void BenchIndexGenerator() {
+	const int count = 3000;
+	std::vector<u16> indices(count * 6 + 64);
+	std::vector<u16_le> in16(count);
+	for (int i = 0; i < count; ++i)
+		in16[i] = (u16)((i * 37) & 0xFFF);
+
+	IndexGenerator gen;
+	gen.Setup(indices.data());
+	static const struct {
+		const char *name;
+		int prim;
+	} prims[] = {
+		{ "IndexGenerator list", GE_PRIM_TRIANGLES },
+		{ "IndexGenerator strip", GE_PRIM_TRIANGLE_STRIP },
+		{ "IndexGenerator fan", GE_PRIM_TRIANGLE_FAN },
+		{ "IndexGenerator rectangles", GE_PRIM_RECTANGLES },
+	};
+	char name[64];
+	for (const auto &prim : prims) {
+		Bench(prim.name, count, [&] {
+			gen.Reset();
+			gen.AddPrim(prim.prim, count, false);
+		});
+		snprintf(name, sizeof(name), "%s indexed16", prim.name);
+		Bench(name, count, [&] {
+			gen.Reset();
+			gen.TranslatePrim(prim.prim, count, in16.data(), 0, false);
+		});
+	}
+}
+
+static void BenchColorConv() {
+	const int count = 512 * 272;
+	AlignedBuffer<u32> src32(count);
+	AlignedBuffer<u16> src16(count);
+	AlignedBuffer<u32> dst32(count);
+	AlignedBuffer<u16> dst16(count);
+
+	Bench("ConvertBGRA8888ToRGBA8888", count, [&] {
+		ConvertBGRA8888ToRGBA8888(dst32.data(), src32.data(), count);
+	});
+	Bench("ConvertRGBA8888ToRGBA5551", count, [&] {
+		ConvertRGBA8888ToRGBA5551(dst16.data(), src32.data(), count);
+	});
+	Bench("ConvertRGBA8888ToRGB565", count, [&] {
+		ConvertRGBA8888ToRGB565(dst16.data(), src32.data(), count);
+	});
+	Bench("ConvertRGBA8888ToRGBA4444", count, [&] {
+		ConvertRGBA8888ToRGBA4444(dst16.data(), src32.data(), count);
+	});
+	Bench("ConvertRGB565ToRGBA8888", count, [&] {
+		ConvertRGB565ToRGBA8888(dst32.data(), src16.data(), count);
+	});
+	Bench("ConvertRGBA5551ToRGBA8888", count, [&] {
+		ConvertRGBA5551ToRGBA8888(dst32.data(), src16.data(), count);
+	});
+	Bench("ConvertRGBA4444ToRGBA8888", count, [&] {
+		ConvertRGBA4444ToRGBA8888(dst32.data(), src16.data(), count);
+	});
+	Bench("ConvertBGRA8888ToRGBA5551", count, [&] {
+		ConvertBGRA8888ToRGBA5551(dst16.data(), src32.data(), count);
+	});
+	Bench("ConvertBGRA8888ToRGB565", count, [&] {
+		ConvertBGRA8888ToRGB565(dst16.data(), src32.data(), count);
+	});
+	Bench("ConvertBGRA8888ToRGBA4444", count, [&] {
+		ConvertBGRA8888ToRGBA4444(dst16.data(), src32.data(), count);
+	});
+	Bench("ConvertRGB565ToBGRA8888", count, [&] {
+		ConvertRGB565ToBGRA8888(dst32.data(), src16.data(), count);
+	});
+	Bench("ConvertRGBA5551ToBGRA8888", count, [&] {
+		ConvertRGBA5551ToBGRA8888(dst32.data(), src16.data(), count);
+	});
+	Bench("ConvertRGBA4444ToBGRA8888", count, [&] {
+		ConvertRGBA4444ToBGRA8888(dst32.data(), src16.data(), count);
+	});
+	Bench("ConvertRGBA4444ToABGR4444", count, [&] {
+		ConvertRGBA4444ToABGR4444(dst16.data(), src16.data(), count);
+	});
+	Bench("ConvertRGBA5551ToABGR1555", count, [&] {
+		ConvertRGBA5551ToABGR1555(dst16.data(), src16.data(), count);
+	});
+	Bench("ConvertRGB565ToBGR565", count, [&] {
+		ConvertRGB565ToBGR565(dst16.data(), src16.data(), count);
+	});
+	Bench("ConvertBGRA5551ToABGR1555", count, [&] {
+		ConvertBGRA5551ToABGR1555(dst16.data(), src16.data(), count);
+	});
+}
+
+int main(int argc, const char *argv[]) {
+	if (argc >= 2)
+		benchFilter = argv[1];
+
+	g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+
+	printf("%s\n", cpu_info.Summarize().c_str());
+	BenchTextureDecoder();
+	BenchVertexDecoder();
+	BenchSas();
+	BenchResampler();
+	BenchHashes();
+	BenchHashmaps();
+	BenchIndexGenerator();
+	BenchColorConv();
+	return 0;
+}
@@ -17,7 +17,10 @@
 
 #include <cstdio>
 #include <cstring>
+#include <memory>
+#include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/IR/IRPassSimplify.h"
 
 struct IRVerification {
@@ -166,6 +169,62 @@ static const IRVerification tests[] = {
 		},
 		{ &PropagateConstants },
 	},
+	{
+		"DeadOverwrite",
+		{
+			{ IROp::Add, { MIPS_REG_A0 }, MIPS_REG_A1, MIPS_REG_A2 },
+			{ IROp::Add, { MIPS_REG_A0 }, MIPS_REG_A1, MIPS_REG_A3 },
+		},
+		{
+			{ IROp::Add, { MIPS_REG_A0 }, MIPS_REG_A1, MIPS_REG_A3 },
+		},
+		{ &EliminateDeadCode },
+	},
+	{
+		"LiveAtConditionalExit",
+		{
+			{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 1 },
+			{ IROp::ExitToConstIfEq, { 0 }, MIPS_REG_A1, MIPS_REG_A2, 0x08800000 },
+			{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 2 },
+		},
+		{
+			{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 1 },
+			{ IROp::ExitToConstIfEq, { 0 }, MIPS_REG_A1, MIPS_REG_A2, 0x08800000 },
+			{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 2 },
+		},
+		{ &EliminateDeadCode },
+	},
+	{
+		"DeadVFPUTemp",
+		{
+			{ IROp::Vec4Init, { IRVTEMP_0 }, (u8)Vec4Init::AllONE },
+			{ IROp::Vec4Mov, { IRVTEMP_0 }, 32 },
+			{ IROp::StoreVec4, { IRVTEMP_0 }, MIPS_REG_A0, 0, 0 },
+			{ IROp::Vec4Neg, { IRVTEMP_0 }, 32 },
+		},
+		{
+			{ IROp::Vec4Mov, { IRVTEMP_0 }, 32 },
+			{ IROp::StoreVec4, { IRVTEMP_0 }, MIPS_REG_A0, 0, 0 },
+		},
+		{ &EliminateDeadCode },
+	},
+	{
+		"DeadMultLoHi",
+		{
+			{ IROp::Mult, { 0 }, MIPS_REG_A0, MIPS_REG_A1 },
+			{ IROp::MfLo, { MIPS_REG_V0 } },
+			{ IROp::Mult, { 0 }, MIPS_REG_A2, MIPS_REG_A3 },
+			{ IROp::MtLo, { 0 }, MIPS_REG_T0 },
+			{ IROp::MtHi, { 0 }, MIPS_REG_T1 },
+		},
+		{
+			{ IROp::Mult, { 0 }, MIPS_REG_A0, MIPS_REG_A1 },
+			{ IROp::MfLo, { MIPS_REG_V0 } },
+			{ IROp::MtLo, { 0 }, MIPS_REG_T0 },
+			{ IROp::MtHi, { 0 }, MIPS_REG_T1 },
+		},
+		{ &EliminateDeadCode },
+	},
 };
 
 bool TestIRPassSimplify() {
@@ -178,3 +237,68 @@ bool TestIRPassSimplify() {
 
 	return true;
 }
+
+// Runs a block before and after fusing, and checks both produce the same state.
+static bool VerifyFuse(const char *name, std::vector<IRInst> insts, int expectedFused, u32 expectedPC) {
+	std::unique_ptr<MIPSState> plain(new MIPSState());
+	std::unique_ptr<MIPSState> fused(new MIPSState());
+	for (int i = 0; i < 32; ++i) {
+		plain->r[i] = i == 0 ? 0 : 0x100 * i;
+		fused->r[i] = plain->r[i];
+	}
+	plain->downcount = 1000;
+	fused->downcount = 1000;
+
+	std::vector<IRInst> fusedInsts = insts;
+	IRFuseForInterpreter(fusedInsts.data(), (int)fusedInsts.size());
+	int numFused = 0;
+	for (size_t i = 0; i < insts.size(); ++i) {
+		if (fusedInsts[i].op != insts[i].op)
+			numFused++;
+	}
+	if (numFused != expectedFused) {
+		printf("%s FAILED: fused %d pairs, expected %d\n", name, numFused, expectedFused);
+		return false;
+	}
+
+	u32 plainPC = IRInterpret(plain.get(), insts.data(), (int)insts.size());
+	u32 fusedPC = IRInterpret(fused.get(), fusedInsts.data(), (int)fusedInsts.size());
+	if (plainPC != expectedPC || fusedPC != expectedPC) {
+		printf("%s FAILED: exited to %08x / %08x, expected %08x\n", name, plainPC, fusedPC, expectedPC);
+		return false;
+	}
+	if (memcmp(plain->r, fused->r, sizeof(plain->r)) != 0 || plain->downcount != fused->downcount) {
+		printf("%s FAILED: fused state differs\n", name);
+		return false;
+	}
+	return true;
+}
+
+bool TestIRFuse() {
+	InitIR();
+
+	bool ok = true;
+	ok = ok && VerifyFuse("FuseBranchTaken", {
+		{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 1 },
+		{ IROp::SetConst, { MIPS_REG_A1 }, 0, 0, 2 },
+		{ IROp::Downcount, { 0 }, 0, 0, 5 },
+		{ IROp::ExitToConstIfNeq, { 0 }, MIPS_REG_A0, MIPS_REG_A1, 0x08800010 },
+		{ IROp::ExitToConst, { 0 }, 0, 0, 0x08800020 },
+	}, 2, 0x08800010);
+	ok = ok && VerifyFuse("FuseBranchNotTaken", {
+		{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 1 },
+		{ IROp::Add, { MIPS_REG_A1 }, MIPS_REG_A0, MIPS_REG_ZERO },
+		{ IROp::Downcount, { 0 }, 0, 0, 5 },
+		{ IROp::ExitToConstIfNeq, { 0 }, MIPS_REG_A0, MIPS_REG_A1, 0x08800010 },
+		{ IROp::Downcount, { 0 }, 0, 0, 3 },
+		{ IROp::ExitToConst, { 0 }, 0, 0, 0x08800020 },
+	}, 2, 0x08800020);
+	// A pair is only fused once, the third SetConst stays as is.
+	ok = ok && VerifyFuse("FuseOddRun", {
+		{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 1 },
+		{ IROp::SetConst, { MIPS_REG_A1 }, 0, 0, 2 },
+		{ IROp::SetConst, { MIPS_REG_A2 }, 0, 0, 3 },
+		{ IROp::ExitToConst, { 0 }, 0, 0, 0x08800020 },
+	}, 1, 0x08800020);
+	return ok;
+}
@@ -0,0 +1,162 @@
+#include "ppsspp_config.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "Common/RiscVEmitter.h"
+
+#include "UnitTest.h"
+
+// There's no RISC-V disassembler to check against, so these compare raw encodings (from an assembler.)
+// Nothing gets executed, so this runs on any host.
+
+static const u8 *prevStart = nullptr;
+
+static bool CheckLast(RiscVGen::RiscVEmitter &emit, u32 expected) {
+	EXPECT_EQ_INT((int)(emit.GetCodePointer() - prevStart), 4);
+	u32 instr;
+	memcpy(&instr, prevStart, 4);
+	EXPECT_EQ_HEX(instr, expected);
+	prevStart = emit.GetCodePointer();
+	return true;
+}
+
+static bool CheckAt(const u8 *ptr, u32 expected) {
+	u32 instr;
+	memcpy(&instr, ptr, 4);
+	EXPECT_EQ_HEX(instr, expected);
+	return true;
+}
+
+// Just enough of RV64 to run what LI() emits.
+static bool EvalLI(const u8 *start, const u8 *end, RiscVGen::RiscVReg rd, s64 *result) {
+	s64 value = 0;
+	for (const u8 *p = start; p < end; p += 4) {
+		u32 instr;
+		memcpy(&instr, p, 4);
+		u32 opcode = instr & 0x7F;
+		u32 funct3 = (instr >> 12) & 7;
+		s32 imm12 = (s32)instr >> 20;
+		if ((int)((instr >> 7) & 0x1F) != rd)
+			return false;
+		bool fromRd = (int)((instr >> 15) & 0x1F) == rd;
+
+		if (opcode == 0x37) {
+			value = (s64)(s32)(instr & 0xFFFFF000);
+		} else if (opcode == 0x13 && funct3 == 0) {
+			value = (fromRd ? value : 0) + imm12;
+		} else if (opcode == 0x13 && funct3 == 1 && fromRd) {
+			value = (s64)((u64)value << (imm12 & 0x3F));
+		} else if (opcode == 0x1B && funct3 == 0 && fromRd) {
+			value = (s64)(s32)(u32)(value + imm12);
+		} else {
+			return false;
+		}
+	}
+	*result = value;
+	return true;
+}
+
+bool TestRiscVEmitter() {
+	using namespace RiscVGen;
+
+	static u32 code[2048];
+	RiscVEmitter emitter((const u8 *)code, (u8 *)code);
+	prevStart = emitter.GetCodePointer();
+
+	emitter.ADDI(A0, A1, -1);
+	RET(CheckLast(emitter, 0xfff58513));
+	emitter.LUI(T0, 0x12345000);
+	RET(CheckLast(emitter, 0x123452b7));
+	emitter.AUIPC(S0, -4096);
+	RET(CheckLast(emitter, 0xfffff417));
+	emitter.JALR(R_RA, A5, 16);
+	RET(CheckLast(emitter, 0x010780e7));
+
+	emitter.LD(A0, R_SP, -8);
+	RET(CheckLast(emitter, 0xff813503));
+	emitter.LBU(T6, S11, 2047);
+	RET(CheckLast(emitter, 0x7ffdcf83));
+	emitter.SD(R_RA, R_SP, 8);
+	RET(CheckLast(emitter, 0x00113423));
+	emitter.SW(A2, A3, -2048);
+	RET(CheckLast(emitter, 0x80c6a023));
+
+	emitter.SEQZ(A0, A0);
+	RET(CheckLast(emitter, 0x00153513));
+	emitter.SRAI(T0, T1, 63);
+	RET(CheckLast(emitter, 0x43f35293));
+	emitter.SLLI(A0, A0, 32);
+	RET(CheckLast(emitter, 0x02051513));
+	emitter.NEG(A0, A1);
+	RET(CheckLast(emitter, 0x40b00533));
+	emitter.SRA(S1, S2, S3);
+	RET(CheckLast(emitter, 0x413954b3));
+
+	emitter.ADDIW(A0, A0, -1);
+	RET(CheckLast(emitter, 0xfff5051b));
+	emitter.SRAIW(A1, A2, 31);
+	RET(CheckLast(emitter, 0x41f6559b));
+	emitter.SUBW(A3, A4, A5);
+	RET(CheckLast(emitter, 0x40f706bb));
+
+	emitter.MUL(A0, A1, A2);
+	RET(CheckLast(emitter, 0x02c58533));
+	emitter.MULHU(T0, T1, T2);
+	RET(CheckLast(emitter, 0x027332b3));
+	emitter.MULW(S2, S3, S4);
+	RET(CheckLast(emitter, 0x0349893b));
+
+	emitter.FENCE_I();
+	RET(CheckLast(emitter, 0x0000100f));
+	emitter.EBREAK();
+	RET(CheckLast(emitter, 0x00100073));
+
+	// Branches get their offsets filled in afterward.
+	const u8 *branchPtr = emitter.GetCodePointer();
+	FixupBranch beq = emitter.BEQ(A0, A1);
+	emitter.NOP();
+	emitter.SetJumpTarget(beq);
+	RET(CheckAt(branchPtr, 0x00b50463));
+
+	branchPtr = emitter.GetCodePointer();
+	FixupBranch bgeu = emitter.BGEU(A2, A3);
+	emitter.ReserveCodeSpace(4088);
+	emitter.SetJumpTarget(bgeu);
+	RET(CheckAt(branchPtr, 0x7ed67ee3));
+
+	// Jumps to anywhere within reach, in both directions.
+	const u8 *target = emitter.GetCodePointer();
+	emitter.NOP();
+	branchPtr = emitter.GetCodePointer();
+	emitter.JAL(R_ZERO, target);
+	RET(CheckAt(branchPtr, 0xffdff06f));
+	branchPtr = emitter.GetCodePointer();
+	emitter.JAL(R_RA, branchPtr + 2048);
+	RET(CheckAt(branchPtr, 0x001000ef));
+	prevStart = emitter.GetCodePointer();
+
+	// LI picks different sequences depending on the value, check that they all end up right.
+	static const s64 values[] = {
+		0, 1, -1, 2047, -2048, 2048, 0x12345678, 0x7FFFFFFF, -0x80000000LL, 0x80000000LL,
+		0xFFFFFFFFLL, 0x7FFFF800, 0x100000000LL, 0x123456789ABCDEF0LL, (s64)0x8000000000000000ULL,
+		(s64)0xFFFFFFFF80000000ULL, 0x7FFFFFFFFFFFFFFFLL,
+	};
+	for (s64 value : values) {
+		const u8 *start = emitter.GetCodePointer();
+		emitter.LI(A0, value);
+		s64 result = 0;
+		EXPECT_TRUE(EvalLI(start, emitter.GetCodePointer(), A0, &result));
+		EXPECT_TRUE(result == value);
+		EXPECT_TRUE(emitter.GetCodePointer() - start <= 8 * 4);
+	}
+	// Small values are a single instruction.
+	const u8 *start = emitter.GetCodePointer();
+	emitter.LI(A0, -2048);
+	EXPECT_EQ_INT((int)(emitter.GetCodePointer() - start), 4);
+	start = emitter.GetCodePointer();
+	emitter.LI(A0, 0x12345678);
+	EXPECT_EQ_INT((int)(emitter.GetCodePointer() - start), 8);
+
+	return true;
+}
@@ -90,7 +90,8 @@ bool GenerateVShader(VShaderID id, char *buffer, ShaderLanguage lang, Draw::Bugs
 	}
 }
 
-bool TestCompileShader(const char *buffer, ShaderLanguage lang, ShaderStage stage, std::string *errorMessage) {
+// shaderModel3 only matters for D3D9, where hardware tessellation shaders need vertex texture fetch.
+bool TestCompileShader(const char *buffer, ShaderLanguage lang, ShaderStage stage, std::string *errorMessage, bool shaderModel3 = false) {
 	std::vector<uint32_t> spirv;
 	switch (lang) {
 #if PPSSPP_PLATFORM(WINDOWS)
@@ -101,7 +102,8 @@ bool TestCompileShader(const char *buffer, ShaderLanguage lang, ShaderStage stag
 	}
 	case ShaderLanguage::HLSL_D3D9:
 	{
-		LPD3DBLOB blob = CompileShaderToByteCodeD3D9(buffer, stage == ShaderStage::Vertex ? "vs_2_0" : "ps_2_0", errorMessage);
+		const char *target = stage == ShaderStage::Vertex ? (shaderModel3 ? "vs_3_0" : "vs_2_0") : (shaderModel3 ? "ps_3_0" : "ps_2_0");
+		LPD3DBLOB blob = CompileShaderToByteCodeD3D9(buffer, target, errorMessage);
 		if (blob) {
 			blob->Release();
 			return true;
@@ -220,6 +222,15 @@ bool TestReinterpretShaders() {
 				}
 			}
 		}
+
+		if (!GenerateDepthCopyFragmentShader(buffer, desc)) {
+			printf("Failed!\n%s\n", buffer);
+			failed = true;
+		} else if (!TestCompileShader(buffer, languages[k], ShaderStage::Fragment, &errorMessage)) {
+			printf("Error compiling depth copy shader:\n\n%s\n\n%s\n", LineNumberString(buffer).c_str(), errorMessage.c_str());
+			failed = true;
+			return false;
+		}
 	}
 
 	delete[] buffer;
@@ -249,7 +260,7 @@ bool TestStencilShaders() {
 		std::string errorMessage;
 
 		// Generate all despite failures - it's only 6.
-		GenerateStencilFs(buffer, desc, bugs);
+		GenerateStencilFs(buffer, desc, bugs, false);
 		if (!TestCompileShader(buffer, languages[k], ShaderStage::Fragment, &errorMessage)) {
 			printf("Error compiling stencil shader:\n\n%s\n\n%s\n", LineNumberString(buffer).c_str(), errorMessage.c_str());
 			failed = true;
@@ -258,6 +269,17 @@ bool TestStencilShaders() {
 			printf("===\n%s\n===\n", buffer);
 		}
 
+		if (languages[k] == ShaderLanguage::GLSL_VULKAN) {
+			GenerateStencilFs(buffer, desc, bugs, true);
+			if (!TestCompileShader(buffer, languages[k], ShaderStage::Fragment, &errorMessage)) {
+				printf("Error compiling stencil export shader:\n\n%s\n\n%s\n", LineNumberString(buffer).c_str(), errorMessage.c_str());
+				failed = true;
+				return false;
+			} else {
+				printf("===\n%s\n===\n", buffer);
+			}
+		}
+
 		GenerateStencilVs(buffer, desc);
 		if (!TestCompileShader(buffer, languages[k], ShaderStage::Vertex, &errorMessage)) {
 			printf("Error compiling stencil shader:\n\n%s\n\n%s\n", LineNumberString(buffer).c_str(), errorMessage.c_str());
@@ -326,12 +348,15 @@ bool TestVertexShaders() {
 			}
 		}
 
+		// Matches ShaderManagerDX9, which builds tessellation shaders against shader model 3.
+		bool shaderModel3 = id.Bit(VS_BIT_USE_HW_TRANSFORM) && (id.Bit(VS_BIT_BEZIER) || id.Bit(VS_BIT_SPLINE));
+
 		// Now that we have the strings ready for easy comparison (buffer,4 in the watch window),
 		// let's try to compile them.
 		for (int j = 0; j < numLanguages; j++) {
 			if (generateSuccess[j]) {
 				std::string errorMessage;
-				if (!TestCompileShader(buffer[j], languages[j], ShaderStage::Vertex, &errorMessage)) {
+				if (!TestCompileShader(buffer[j], languages[j], ShaderStage::Vertex, &errorMessage, shaderModel3)) {
 					printf("Error compiling vertex shader %d:\n\n%s\n\n%s\n", (int)j, LineNumberString(buffer[j]).c_str(), errorMessage.c_str());
 					return false;
 				}
@@ -85,9 +85,10 @@ class IncrementTask : public Task {
 };
 
 void ThreadFunc() {
+	static const TaskType types[] = { TaskType::CPU_COMPUTE, TaskType::IO_BLOCKING, TaskType::CPU_BACKGROUND };
 	for (int i = 0; i < ITERATIONS; i++) {
 		auto threadWaitable = new LimitedWaitable();
-		g_threadMan->EnqueueTask(new IncrementTask((i & 1) ? TaskType::CPU_COMPUTE : TaskType::IO_BLOCKING, threadWaitable));
+		g_threadMan->EnqueueTask(new IncrementTask(types[i % 3], threadWaitable));
 		threadWaitable->WaitAndRelease();
 	}
 	g_barrier.Arrive();
@@ -156,6 +156,12 @@ class VertexDecoderTestHarness {
 		AddFloat(y);
 		AddFloat(z);
 	}
+	void AddFloat(float_le x, float_le y, float_le z, float_le w) {
+		AddFloat(x);
+		AddFloat(y);
+		AddFloat(z);
+		AddFloat(w);
+	}
 
 	u8 Get8() {
 		return dst_[dstPos_++];
@@ -633,6 +639,60 @@ static bool TestVertexFloatSkin() {
 	return !dec.HasFailed();
 }
 
+static void SetupEightBones() {
+	g_Config.bSoftwareSkinning = true;
+	for (int i = 0; i < 8 * 12; ++i) {
+		gstate.boneMatrix[i] = 0.0f;
+	}
+	// Each bone scales x differently and translates x, so every weight matters.
+	for (int j = 0; j < 8; ++j) {
+		gstate.boneMatrix[j * 12 + 0] = (float)(j + 1);
+		gstate.boneMatrix[j * 12 + 4] = 2.0f;
+		gstate.boneMatrix[j * 12 + 8] = -1.0f;
+		gstate.boneMatrix[j * 12 + 9] = (float)j;
+	}
+}
+
+static bool TestVertex8SkinEight() {
+	VertexDecoderTestHarness dec;
+
+	SetupEightBones();
+	int vtype = GE_VTYPE_POS_FLOAT | GE_VTYPE_NRM_FLOAT | GE_VTYPE_WEIGHT_8BIT | (7 << GE_VTYPE_WEIGHTCOUNT_SHIFT);
+
+	dec.Add8(16, 16, 16, 16);
+	dec.Add8(16, 16, 16, 16);
+	dec.AddFloat(1.0f, 0.0f, -1.0f);
+	dec.AddFloat(1.0f, 0.0f, -1.0f);
+
+	for (int jit = 0; jit <= 1; ++jit) {
+		dec.Execute(vtype, 0, jit == 1);
+		dec.AssertFloat("TestVertex8SkinEight-Nrm", 4.5f, 0.0f, 1.0f);
+		dec.AssertFloat("TestVertex8SkinEight-Pos", 8.0f, 0.0f, 1.0f);
+	}
+
+	return !dec.HasFailed();
+}
+
+static bool TestVertexFloatSkinEight() {
+	VertexDecoderTestHarness dec;
+
+	SetupEightBones();
+	int vtype = GE_VTYPE_POS_FLOAT | GE_VTYPE_NRM_FLOAT | GE_VTYPE_WEIGHT_FLOAT | (7 << GE_VTYPE_WEIGHTCOUNT_SHIFT);
+
+	dec.AddFloat(0.125f, 0.125f, 0.125f, 0.125f);
+	dec.AddFloat(0.125f, 0.125f, 0.125f, 0.125f);
+	dec.AddFloat(1.0f, 0.0f, -1.0f);
+	dec.AddFloat(1.0f, 0.0f, -1.0f);
+
+	for (int jit = 0; jit <= 1; ++jit) {
+		dec.Execute(vtype, 0, jit == 1);
+		dec.AssertFloat("TestVertexFloatSkinEight-Nrm", 4.5f, 0.0f, 1.0f);
+		dec.AssertFloat("TestVertexFloatSkinEight-Pos", 8.0f, 0.0f, 1.0f);
+	}
+
+	return !dec.HasFailed();
+}
+
 // TODO: Morph (col, pos, nrm), weights (no skin), morph + weights?
 
 typedef bool (*VertexTestFunc)();
@@ -654,6 +714,8 @@ static VertexTestFunc vertdecTestFuncs[] = {
 	&TestVertex8Skin,
 	&TestVertex16Skin,
 	&TestVertexFloatSkin,
+	&TestVertex8SkinEight,
+	&TestVertexFloatSkinEight,
 };
 
 bool TestVertexJit() {
@@ -679,6 +741,19 @@ bool TestVertexJit() {
 	printf("Result: %f, %f, %f\n", x, y, z);
 	printf("Jit was %fx faster than steps.\n\n", yesJit / noJit);
 
+	VertexDecoderTestHarness skinDec;
+	SetupEightBones();
+	for (int i = 0; i < 100; ++i) {
+		skinDec.AddFloat(0.125f, 0.125f, 0.125f, 0.125f);
+		skinDec.AddFloat(0.125f, 0.125f, 0.125f, 0.125f);
+		skinDec.AddFloat(1.0f, 0.0f, -1.0f);
+		skinDec.AddFloat(1.0f, 0.0f, -1.0f);
+	}
+	int skinVtype = GE_VTYPE_POS_FLOAT | GE_VTYPE_NRM_FLOAT | GE_VTYPE_WEIGHT_FLOAT | (7 << GE_VTYPE_WEIGHTCOUNT_SHIFT);
+	double yesJitSkin = skinDec.ExecuteTimed(skinVtype, 100, true);
+	double noJitSkin = skinDec.ExecuteTimed(skinVtype, 100, false);
+	printf("Skinning jit (8 weights) was %fx faster than steps.\n\n", yesJitSkin / noJitSkin);
+
 	bool pass = true;
 	for (size_t i = 0; i < ARRAY_SIZE(vertdecTestFuncs); ++i) {
 		if (!vertdecTestFuncs[i]()) {
@@ -40,6 +40,9 @@
 #include <jni.h>
 #endif
 
+#include "Common/Data/Encoding/Base64.h"
+#include "Common/Data/Format/IniFile.h"
+#include "Common/Data/Format/JSONWriter.h"
 #include "Common/Data/Text/Parsers.h"
 #include "Common/Data/Text/WrapText.h"
 #include "Common/Data/Encoding/Utf8.h"
@@ -47,6 +50,8 @@
 #include "Common/Input/InputState.h"
 #include "Common/Math/math_util.h"
 #include "Common/Render/DrawBuffer.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
 
@@ -54,10 +59,17 @@
 #include "Common/BitScan.h"
 #include "Common/CPUDetect.h"
 #include "Common/Log.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/CoreTiming.h"
 #include "Core/FileSystems/ISOFileSystem.h"
+#include "Core/HLE/ThreadQueueList.h"
+#include "Core/HW/BufferQueue.h"
+#include "Core/HW/SasReverb.h"
 #include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "GPU/Common/IndexGenerator.h"
 #include "GPU/Common/TextureDecoder.h"
 
 #include "android/jni/AndroidContentURI.h"
@@ -308,6 +320,41 @@ bool TestParsers() {
 	return true;
 }
 
+bool TestBase64() {
+	const uint8_t *text = (const uint8_t *)"PPSSPP!";
+	EXPECT_EQ_STR(Base64Encode(text, 0), std::string(""));
+	EXPECT_EQ_STR(Base64Encode(text, 1), std::string("UA=="));
+	EXPECT_EQ_STR(Base64Encode(text, 2), std::string("UFA="));
+	EXPECT_EQ_STR(Base64Encode(text, 3), std::string("UFBT"));
+	EXPECT_EQ_STR(Base64Encode(text, 7), std::string("UFBTU1BQIQ=="));
+
+	std::vector<uint8_t> data;
+	for (int i = 0; i < 256; ++i) {
+		data.push_back((uint8_t)(i * 37 + 11));
+		std::string encoded = Base64Encode(data.data(), data.size());
+		EXPECT_TRUE(Base64Decode(encoded.c_str(), encoded.size()) == data);
+	}
+	return true;
+}
+
+bool TestJsonWriter() {
+	json::JsonWriter writer;
+	writer.begin();
+	writer.writeInt("int", -2147483647 - 1);
+	writer.writeUint("uint", 4294967295U);
+	writer.writeFloat("float", 0.5);
+	writer.writeFloat("whole", 100.0);
+	writer.writeFloat("nan", NAN);
+	writer.writeString("str", "a\"b/\n\x01");
+	writer.pushArray("arr");
+	writer.writeBool(true);
+	writer.writeNull();
+	writer.pop();
+	writer.end();
+	EXPECT_EQ_STR(writer.str(), std::string("{\"int\":-2147483648,\"uint\":4294967295,\"float\":0.5,\"whole\":100,\"nan\":null,\"str\":\"a\\\"b\\/\\n\\u0001\",\"arr\":[true,null]}"));
+	return true;
+}
+
 bool TestVFPUSinCos() {
 	float sine, cosine;
 	InitVFPUSinCos();
@@ -507,6 +554,181 @@ bool TestQuickTexHash() {
 	return true;
 }
 
+bool TestCLUT4Decode() {
+	// The vector paths only kick in with the simple index mode.
+	u32 oldClutFormat = gstate.clutformat;
+	gstate.clutformat = 0xC500FF00;
+
+	static const int WIDTH = 512;
+	static const int ROWS = 64;
+	std::vector<u8> indexed(WIDTH * ROWS / 2);
+	for (size_t i = 0; i < indexed.size(); ++i) {
+		indexed[i] = (u8)((i * 37) ^ (i >> 3));
+	}
+	u16 clut16[16];
+	u32 clut32[16];
+	for (int i = 0; i < 16; ++i) {
+		clut16[i] = (u16)(0xF000 | (i * 0x111));
+		clut32[i] = 0xFF000000 | (i * 0x10101);
+	}
+
+	// Odd lengths exercise the scalar tail.
+	static const int lengths[] = { 1, 16, 30, 48, WIDTH };
+	std::vector<u16> ref16(WIDTH + 1), out16(WIDTH + 1);
+	std::vector<u32> ref32(WIDTH + 1), out32(WIDTH + 1);
+	for (int length : lengths) {
+		u32 refMask = 0xFFFFFFFF, outMask = 0xFFFFFFFF;
+		DeIndexTexture4<u16>(ref16.data(), indexed.data(), length, clut16, &refMask);
+		DeIndexTexture4Clut16(out16.data(), indexed.data(), length, clut16, &outMask);
+		EXPECT_EQ_HEX(outMask & 0xFFFF, refMask & 0xFFFF);
+		for (int i = 0; i < length; ++i) {
+			EXPECT_EQ_HEX(out16[i], ref16[i]);
+		}
+
+		refMask = 0xFFFFFFFF;
+		outMask = 0xFFFFFFFF;
+		DeIndexTexture4<u32>(ref32.data(), indexed.data(), length, clut32, &refMask);
+		DeIndexTexture4Clut32(out32.data(), indexed.data(), length, clut32, &outMask);
+		EXPECT_EQ_HEX(outMask, refMask);
+		for (int i = 0; i < length; ++i) {
+			EXPECT_EQ_HEX(out32[i], ref32[i]);
+		}
+	}
+
+	// A non-full alpha entry must show up in the mask.
+	clut16[3] &= 0x0FFF;
+	u32 mask = 0xFFFFFFFF;
+	u8 allThrees[8] = { 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33 };
+	DeIndexTexture4Clut16(out16.data(), allThrees, 16, clut16, &mask);
+	EXPECT_EQ_HEX(mask & 0xF000, 0);
+
+	// Not a pass/fail, but handy to see the speedup.
+	auto timeDecode = [&](bool vector) {
+		int total = 0;
+		u32 alphaSum = 0xFFFFFFFF;
+		double st = time_now_d();
+		do {
+			for (int y = 0; y < ROWS; ++y) {
+				const u8 *src = indexed.data() + y * WIDTH / 2;
+				if (vector)
+					DeIndexTexture4Clut32(out32.data(), src, WIDTH, clut32, &alphaSum);
+				else
+					DeIndexTexture4<u32>(out32.data(), src, WIDTH, clut32, &alphaSum);
+			}
+			++total;
+		} while (time_now_d() - st < 0.25);
+		return total / (time_now_d() - st);
+	};
+	double scalar = timeDecode(false);
+	double vector = timeDecode(true);
+	printf("CLUT4 decode: %f scalar, %f vector (%2.2fx)\n", scalar, vector, vector / scalar);
+
+	gstate.clutformat = oldClutFormat;
+	return true;
+}
+
+// Reference triangle/line list for a primitive, as the scalar generator produced it.
+static std::vector<u16> ReferenceIndices(int prim, int count, const u16 *in, int base, bool clockwise) {
+	std::vector<u16> out;
+	auto idx = [&](int i) { return (u16)(base + (in ? in[i] : i)); };
+	const int v1 = clockwise ? 1 : 2;
+	const int v2 = clockwise ? 2 : 1;
+	switch (prim) {
+	case GE_PRIM_POINTS:
+		for (int i = 0; i < count; i++)
+			out.push_back(idx(i));
+		break;
+	case GE_PRIM_LINES:
+	case GE_PRIM_RECTANGLES:
+		for (int i = 0; i + 1 < count; i += 2) {
+			out.push_back(idx(i));
+			out.push_back(idx(i + 1));
+		}
+		break;
+	case GE_PRIM_LINE_STRIP:
+		for (int i = 0; i + 1 < count; i++) {
+			out.push_back(idx(i));
+			out.push_back(idx(i + 1));
+		}
+		break;
+	case GE_PRIM_TRIANGLES:
+		for (int i = 0; i + 2 < count; i += 3) {
+			out.push_back(idx(i));
+			out.push_back(idx(i + v1));
+			out.push_back(idx(i + v2));
+		}
+		break;
+	case GE_PRIM_TRIANGLE_STRIP:
+	{
+		int wind = v1;
+		for (int i = 0; i + 2 < count; i++) {
+			out.push_back(idx(i));
+			out.push_back(idx(i + wind));
+			wind ^= 3;
+			out.push_back(idx(i + wind));
+		}
+		break;
+	}
+	case GE_PRIM_TRIANGLE_FAN:
+		for (int i = 0; i + 2 < count; i++) {
+			out.push_back(idx(0));
+			out.push_back(idx(i + v1));
+			out.push_back(idx(i + v2));
+		}
+		break;
+	}
+	return out;
+}
+
+bool TestIndexGenerator() {
+	// Lots of slack, the SIMD paths are allowed to write past the end.
+	std::vector<u16> buffer(4096);
+	std::vector<u8> in8(256);
+	std::vector<u16_le> in16(256);
+	std::vector<u16> in(256);
+	for (int i = 0; i < 256; i++) {
+		in[i] = (u16)((i * 37) & 0xFF);
+		in8[i] = (u8)in[i];
+		in16[i] = in[i];
+	}
+
+	IndexGenerator gen;
+	gen.Setup(buffer.data());
+	static const int counts[] = { 3, 4, 5, 8, 24, 25, 26, 27, 50, 99, 201 };
+	for (int prim = GE_PRIM_POINTS; prim <= GE_PRIM_RECTANGLES; prim++) {
+		for (int count : counts) {
+			for (int clockwise = 0; clockwise < 2; clockwise++) {
+				gen.Reset();
+				gen.Advance(7);
+				gen.AddPrim(prim, count, clockwise != 0);
+				std::vector<u16> expected = ReferenceIndices(prim, count, nullptr, 7, clockwise != 0);
+				for (size_t i = 0; i < expected.size(); i++) {
+					EXPECT_EQ_INT(buffer[i], expected[i]);
+				}
+
+				gen.Reset();
+				gen.Advance(3);
+				gen.TranslatePrim(prim, count, in8.data(), 0, clockwise != 0);
+				expected = ReferenceIndices(prim, count, in.data(), 3, clockwise != 0);
+				EXPECT_EQ_INT(gen.VertexCount(), (int)expected.size());
+				for (size_t i = 0; i < expected.size(); i++) {
+					EXPECT_EQ_INT(buffer[i], expected[i]);
+				}
+
+				gen.Reset();
+				gen.Advance(5);
+				gen.TranslatePrim(prim, count, in16.data(), 2, clockwise != 0);
+				expected = ReferenceIndices(prim, count, in.data(), 3, clockwise != 0);
+				EXPECT_EQ_INT(gen.VertexCount(), (int)expected.size());
+				for (size_t i = 0; i < expected.size(); i++) {
+					EXPECT_EQ_INT(buffer[i], expected[i]);
+				}
+			}
+		}
+	}
+	return true;
+}
+
 bool TestCLZ() {
 	static const uint32_t input[] = {
 		0xFFFFFFFF,
@@ -744,6 +966,250 @@ static bool TestWrapText() {
 }
 
 typedef bool (*TestFunc)();
+struct SerializerTestData {
+	int a = 0;
+	std::string b;
+	std::vector<u32> c;
+
+	void DoState(PointerWrap &p) {
+		auto s = p.Section("Outer", 1);
+		if (!s)
+			return;
+		Do(p, a);
+
+		auto inner = p.Section("Inner", 1, 2);
+		if (!inner)
+			return;
+		Do(p, b);
+		Do(p, c);
+	}
+};
+
+static bool TestSerializer() {
+	SerializerTestData data;
+	data.a = 42;
+	data.b = "hello";
+	data.c.resize(1000, 0x12345678);
+
+	std::vector<PointerWrap::SectionStats> sections;
+	u8 *ptr = nullptr;
+	PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+	measure.sectionStats = &sections;
+	data.DoState(measure);
+	size_t sz = (size_t)ptr;
+
+	EXPECT_EQ_INT(sections.size(), 2);
+	EXPECT_TRUE(sections[0].title == "Outer");
+	EXPECT_EQ_INT(sections[0].depth, 0);
+	EXPECT_EQ_INT(sections[0].size, sz);
+	EXPECT_TRUE(sections[1].title == "Inner");
+	EXPECT_EQ_INT(sections[1].depth, 1);
+	EXPECT_TRUE(sections[1].size > data.c.size() * sizeof(u32));
+	EXPECT_TRUE(sections[1].size < sections[0].size);
+
+	std::vector<u8> buffer(sz);
+	EXPECT_TRUE(CChunkFileReader::SavePtr(&buffer[0], data, sz) == CChunkFileReader::ERROR_NONE);
+
+	std::vector<u8> compressed;
+	EXPECT_TRUE(CChunkFileReader::CompressBuffer(&buffer[0], sz, compressed));
+	EXPECT_TRUE(compressed.size() < sz);
+	std::vector<u8> decompressed(sz);
+	EXPECT_TRUE(CChunkFileReader::DecompressBuffer(compressed, &decompressed[0], sz));
+	EXPECT_TRUE(decompressed == buffer);
+
+	SerializerTestData loaded;
+	std::string errorString;
+	EXPECT_TRUE(CChunkFileReader::LoadPtr(&decompressed[0], loaded, &errorString) == CChunkFileReader::ERROR_NONE);
+	EXPECT_EQ_INT(loaded.a, 42);
+	EXPECT_EQ_STR(loaded.b, data.b);
+	EXPECT_TRUE(loaded.c == data.c);
+	return true;
+}
+
+static bool TestSasReverb() {
+	g_Config.iReverbVolume = 10;
+
+	std::vector<int16_t> input(256 * 2);
+	std::vector<int16_t> expected(256 * 4);
+	std::vector<int16_t> output(256 * 4);
+	for (int preset = 0; preset < SasReverb::GetNumPresets(); preset++) {
+		if (!SasReverb::GetPresetName(preset))
+			continue;
+
+		SasReverb reference;
+		SasReverb optimized;
+		reference.SetPreset(preset);
+		optimized.SetPreset(preset);
+
+		// Enough grains to go around each ring buffer several times, with loud noise to hit the clamps.
+		uint32_t seed = 1234 + preset;
+		for (int grain = 0; grain < 400; grain++) {
+			for (int16_t &sample : input) {
+				seed = seed * 1103515245 + 12345;
+				sample = (int16_t)(seed >> 16);
+			}
+			reference.ProcessReverb(&expected[0], &input[0], input.size() / 2, 0x8000, 0x6000, true);
+			optimized.ProcessReverb(&output[0], &input[0], input.size() / 2, 0x8000, 0x6000);
+			if (output != expected) {
+				printf("Reverb preset %s differs in grain %d\n", SasReverb::GetPresetName(preset), grain);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool TestBufferQueue() {
+	// Odd packet sizes so that pushes and pops wrap around the queue at varying offsets.
+	BufferQueue queue(1000);
+	u8 packet[300];
+	u8 out[300];
+	for (int i = 0; i < 40; i++) {
+		int size = 100 + (i * 37) % 180;
+		memset(packet, i, size);
+		EXPECT_TRUE(queue.push(packet, size, 1000 + i));
+
+		s64 pts = 0;
+		EXPECT_EQ_INT(queue.pop_front(out, size, &pts), size);
+		EXPECT_EQ_INT((int)pts, 1000 + i);
+		EXPECT_EQ_INT(out[0], i);
+		EXPECT_EQ_INT(out[size - 1], i);
+	}
+
+	// Two packets queued, popped together: we get the first pts, and both marks are consumed.
+	memset(packet, 0, sizeof(packet));
+	EXPECT_TRUE(queue.push(packet, 200, 50));
+	EXPECT_TRUE(queue.push(packet, 200, 60));
+	EXPECT_TRUE(queue.push(packet, 200));
+	s64 pts = 0;
+	EXPECT_EQ_INT(queue.pop_front(nullptr, 400, &pts), 400);
+	EXPECT_EQ_INT((int)pts, 50);
+	EXPECT_EQ_INT(queue.pop_front(nullptr, 200, &pts), 200);
+	EXPECT_EQ_INT((int)pts, 0);
+	EXPECT_EQ_INT(queue.getQueueSize(), 0);
+	return true;
+}
+
+static std::vector<u64> coreTimingFired;
+
+static void CoreTimingTestCallback(u64 userdata, int cyclesLate) {
+	coreTimingFired.push_back(userdata);
+}
+
+static bool TestCoreTiming() {
+	MIPSState *prevMIPS = currentMIPS;
+	currentMIPS = &mipsr4k;
+	CoreTiming::Init();
+	int eventType = CoreTiming::RegisterEvent("TestEvent", &CoreTimingTestCallback);
+
+	auto runAll = [&]() {
+		coreTimingFired.clear();
+		while (CoreTiming::IsScheduled(eventType)) {
+			CoreTiming::Idle();
+			CoreTiming::Advance();
+		}
+	};
+
+	// Events at the same time must fire in the order they were scheduled.
+	CoreTiming::ScheduleEvent(300, eventType, 1);
+	CoreTiming::ScheduleEvent(100, eventType, 2);
+	CoreTiming::ScheduleEvent(300, eventType, 3);
+	CoreTiming::ScheduleEvent(200, eventType, 4);
+	CoreTiming::ScheduleEvent(100, eventType, 5);
+	CoreTiming::ScheduleEvent(250, eventType, 6);
+	EXPECT_EQ_INT(CoreTiming::UnscheduleEvent(eventType, 6), 250);
+	EXPECT_EQ_INT(CoreTiming::UnscheduleEvent(eventType, 6), 0);
+	runAll();
+	EXPECT_EQ_INT(coreTimingFired.size(), 5);
+	const u64 expected[] = { 2, 5, 4, 1, 3 };
+	for (int i = 0; i < 5; ++i) {
+		EXPECT_EQ_INT(coreTimingFired[i], expected[i]);
+	}
+
+	// Not a pass/fail, but handy to see how it scales with lots of timers.
+	double st = time_now_d();
+	int total = 0;
+	do {
+		for (int i = 0; i < 1000; ++i) {
+			CoreTiming::ScheduleEvent(((i * 7919) % 1000) * 100 + 1, eventType, i);
+		}
+		for (int i = 0; i < 1000; i += 2) {
+			CoreTiming::UnscheduleEvent(eventType, i);
+		}
+		runAll();
+		EXPECT_EQ_INT(coreTimingFired.size(), 500);
+		++total;
+	} while (time_now_d() - st < 0.25);
+	printf("CoreTiming: %f rounds of 1000 events per second\n", total / (time_now_d() - st));
+
+	CoreTiming::Shutdown();
+	currentMIPS = prevMIPS;
+	return true;
+}
+
+static bool TestThreadQueueList() {
+	ThreadQueueList queue;
+	const u32 priorities[] = { 100, 16, 127, 64, 16, 1, 63 };
+	for (u32 prio : priorities)
+		queue.prepare(prio);
+
+	EXPECT_EQ_INT(queue.peek_first(), 0);
+	queue.push_back(100, 1);
+	queue.push_back(16, 2);
+	queue.push_back(127, 3);
+	queue.push_back(64, 4);
+	queue.push_front(16, 5);
+	queue.push_back(63, 6);
+	queue.push_back(16, 7);
+
+	EXPECT_EQ_INT(queue.peek_first(), 5);
+	// Nothing better than 16 is ready.
+	EXPECT_EQ_INT(queue.pop_first_better(16), 0);
+	queue.rotate(16);
+	queue.remove(16, 7);
+	EXPECT_EQ_INT(queue.pop_first_better(17), 2);
+	EXPECT_FALSE(queue.empty(16));
+	EXPECT_EQ_INT(queue.pop_first(), 5);
+	EXPECT_TRUE(queue.empty(16));
+
+	queue.push_back(1, 8);
+	queue.remove(1, 8);
+	const SceUID expected[] = { 6, 4, 1, 3 };
+	for (SceUID id : expected)
+		EXPECT_EQ_INT(queue.pop_first(), id);
+	EXPECT_EQ_INT(queue.peek_first(), 0);
+	return true;
+}
+
+static bool TestIniFile() {
+	const char *data = "\xEF\xBB\xBF# comment\r\n[Graphics]\r\nRenderingMode = 1\nFrameSkip=2 # trailing\nframeskip = 3\n; Hidden = 4\n[Empty] # note\n";
+	IniFile ini;
+	EXPECT_TRUE(ini.LoadFromBuffer(data, strlen(data)));
+
+	Section *graphics = ini.GetOrCreateSection("graphics");
+	int value = 0;
+	EXPECT_TRUE(graphics->Get("renderingmode", &value, -1));
+	EXPECT_EQ_INT(value, 1);
+	// The first definition of a key wins.
+	EXPECT_TRUE(graphics->Get("FrameSkip", &value, -1));
+	EXPECT_EQ_INT(value, 2);
+	EXPECT_FALSE(graphics->Exists("Hidden"));
+
+	graphics->Set("NewKey", 5);
+	EXPECT_TRUE(graphics->Get("newkey", &value, -1));
+	EXPECT_EQ_INT(value, 5);
+	EXPECT_TRUE(graphics->Delete("FRAMESKIP"));
+	EXPECT_TRUE(graphics->Get("FrameSkip", &value, -1));
+	EXPECT_EQ_INT(value, 3);
+	EXPECT_TRUE(graphics->Get("NewKey", &value, -1));
+	EXPECT_EQ_INT(value, 5);
+
+	EXPECT_TRUE(ini.HasSection("Empty"));
+	std::string name = ini.GetOrCreateSection("empty")->name();
+	EXPECT_EQ_STR(name, std::string("Empty"));
+	return true;
+}
+
 struct TestItem {
 	const char *name;
 	TestFunc func;
@@ -754,9 +1220,11 @@ struct TestItem {
 bool TestArmEmitter();
 bool TestArm64Emitter();
 bool TestX64Emitter();
+bool TestRiscVEmitter();
 bool TestShaderGenerators();
 bool TestSoftwareGPUJit();
 bool TestIRPassSimplify();
+bool TestIRFuse();
 bool TestThreadManager();
 
 TestItem availableTests[] = {
@@ -769,17 +1237,23 @@ TestItem availableTests[] = {
 #if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
 	TEST_ITEM(X64Emitter),
 #endif
+	TEST_ITEM(RiscVEmitter),
 	TEST_ITEM(VertexJit),
 	TEST_ITEM(Asin),
 	TEST_ITEM(SinCos),
 	TEST_ITEM(VFPUSinCos),
 	TEST_ITEM(MathUtil),
 	TEST_ITEM(Parsers),
+	TEST_ITEM(Base64),
+	TEST_ITEM(JsonWriter),
 	TEST_ITEM(IRPassSimplify),
+	TEST_ITEM(IRFuse),
 	TEST_ITEM(Jit),
 	TEST_ITEM(MatrixTranspose),
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
+	TEST_ITEM(CLUT4Decode),
+	TEST_ITEM(IndexGenerator),
 	TEST_ITEM(CLZ),
 	TEST_ITEM(MemMap),
 	TEST_ITEM(ShaderGenerators),
@@ -788,6 +1262,12 @@ TestItem availableTests[] = {
 	TEST_ITEM(AndroidContentURI),
 	TEST_ITEM(ThreadManager),
 	TEST_ITEM(WrapText),
+	TEST_ITEM(Serializer),
+	TEST_ITEM(SasReverb),
+	TEST_ITEM(BufferQueue),
+	TEST_ITEM(CoreTiming),
+	TEST_ITEM(ThreadQueueList),
+	TEST_ITEM(IniFile),
 };
 
 int main(int argc, const char *argv[]) {